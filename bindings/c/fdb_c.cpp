@@ -276,6 +276,78 @@ fdb_error_t fdb_future_get_keyvalue_array_impl(
 		*out_more = rrr.more; );
 }
 
+extern "C" DLLEXPORT
+fdb_error_t fdb_future_get_keyvalue_array_packed(
+	FDBFuture* f, uint8_t* buffer, int buffer_length,
+	int* out_count, fdb_bool_t* out_more, int* out_length )
+{
+	CATCH_AND_RETURN(
+		Standalone<RangeResultRef> rrr = TSAV(Standalone<RangeResultRef>, f)->get();
+		int count = 0;
+		int length = 0;
+		for (; count < rrr.size(); ++count) {
+			const KeyValueRef& kv = rrr[count];
+			const int pairLength = 2 * sizeof(int) + kv.key.size() + kv.value.size();
+			if (pairLength > buffer_length - length) {
+				break;
+			}
+			const int keyLength = kv.key.size();
+			const int valueLength = kv.value.size();
+			memcpy(buffer + length, &keyLength, sizeof(int));
+			memcpy(buffer + length + sizeof(int), &valueLength, sizeof(int));
+			length += 2 * sizeof(int);
+			memcpy(buffer + length, kv.key.begin(), keyLength);
+			length += keyLength;
+			memcpy(buffer + length, kv.value.begin(), valueLength);
+			length += valueLength;
+		}
+		*out_count = count;
+		*out_more = rrr.more || count < rrr.size();
+		*out_length = length; );
+}
+
+extern "C" DLLEXPORT
+fdb_error_t fdb_future_get_keyvalue_array_batch(
+	FDBFuture* f, int index, FDBKeyValue const** out_kv,
+	int* out_count, fdb_bool_t* out_more )
+{
+	CATCH_AND_RETURN(
+		Standalone<VectorRef<RangeResultRef>> results = TSAV(Standalone<VectorRef<RangeResultRef>>, f)->get();
+		if (index < 0 || index >= results.size()) {
+			return error_code_client_invalid_operation;
+		}
+		*out_kv = (FDBKeyValue*)results[index].begin();
+		*out_count = results[index].size();
+		*out_more = results[index].more; );
+}
+
+static_assert(sizeof(FDBChangeFeedMutation) == sizeof(ChangeFeedMutationRef),
+              "ChangeFeedMutationRef is returned to the C API as FDBChangeFeedMutation");
+
+extern "C" DLLEXPORT
+fdb_error_t fdb_future_get_change_feed_mutations(
+	FDBFuture* f, FDBChangeFeedMutation const** out_mutations, int* out_count )
+{
+	CATCH_AND_RETURN(
+		Standalone<VectorRef<ChangeFeedMutationRef>> mutations = TSAV(Standalone<VectorRef<ChangeFeedMutationRef>>, f)->get();
+		*out_mutations = (FDBChangeFeedMutation*)mutations.begin();
+		*out_count = mutations.size(); );
+}
+
+extern "C" DLLEXPORT
+fdb_error_t fdb_future_get_range_aggregate( FDBFuture* f, FDBRangeAggregate* out_aggregate )
+{
+	CATCH_AND_RETURN(
+		RangeAggregate aggregate = TSAV(RangeAggregate, f)->get();
+		out_aggregate->count = aggregate.count;
+		out_aggregate->bytes = aggregate.bytes;
+		out_aggregate->sum = aggregate.sum;
+		out_aggregate->first_key = aggregate.firstKey.present() ? aggregate.firstKey.get().begin() : nullptr;
+		out_aggregate->first_key_length = aggregate.firstKey.present() ? aggregate.firstKey.get().size() : 0;
+		out_aggregate->last_key = aggregate.lastKey.present() ? aggregate.lastKey.get().begin() : nullptr;
+		out_aggregate->last_key_length = aggregate.lastKey.present() ? aggregate.lastKey.get().size() : 0; );
+}
+
 fdb_error_t fdb_future_get_keyvalue_array_v13(
 	FDBFuture* f, FDBKeyValue const** out_kv, int* out_count)
 {
@@ -394,6 +466,17 @@ extern "C" DLLEXPORT FDBFuture* fdb_database_reboot_worker(FDBDatabase* db, uint
 	return (FDBFuture*)(DB(db)->rebootWorker(StringRef(address, address_length), check, duration).extractPtr());
 }
 
+extern "C" DLLEXPORT FDBFuture* fdb_database_read_change_feed(FDBDatabase* db, uint8_t const* begin_key_name,
+                                                              int begin_key_name_length, uint8_t const* end_key_name,
+                                                              int end_key_name_length, int64_t begin_version,
+                                                              int64_t end_version) {
+	return (FDBFuture*)(DB(db)
+	                        ->readChangeFeed(KeyRangeRef(StringRef(begin_key_name, begin_key_name_length),
+	                                                     StringRef(end_key_name, end_key_name_length)),
+	                                         begin_version, end_version)
+	                        .extractPtr());
+}
+
 extern "C" DLLEXPORT
 void fdb_transaction_destroy( FDBTransaction* tr ) {
 	try {
@@ -675,6 +758,34 @@ FDBFuture* fdb_transaction_get_range_split_points( FDBTransaction* tr, uint8_t c
 	return (FDBFuture*)(TXN(tr)->getRangeSplitPoints(range, chunk_size).extractPtr());
 }
 
+extern "C" DLLEXPORT
+FDBFuture* fdb_transaction_get_range_aggregate( FDBTransaction* tr, uint8_t const* begin_key_name,
+                                                int begin_key_name_length, uint8_t const* end_key_name,
+                                                int end_key_name_length, fdb_bool_t snapshot ) {
+	KeyRangeRef range(KeyRef(begin_key_name, begin_key_name_length), KeyRef(end_key_name, end_key_name_length));
+	return (FDBFuture*)(TXN(tr)->getRangeAggregate(range, snapshot).extractPtr());
+}
+
+extern "C" DLLEXPORT
+FDBFuture* fdb_transaction_get_multi( FDBTransaction* tr, FDBKey const* keys, int key_count, fdb_bool_t snapshot ) {
+	VectorRef<KeyRef> keyRefs((KeyRef*)keys, key_count);
+	return (FDBFuture*)(TXN(tr)->getMulti(keyRefs, snapshot).extractPtr());
+}
+
+extern "C" DLLEXPORT
+FDBFuture* fdb_transaction_get_batch( FDBTransaction* tr, FDBKey const* keys, int key_count,
+                                      FDBKey const* range_begin_keys, FDBKey const* range_end_keys,
+                                      int const* range_limits, int range_count, fdb_bool_t snapshot ) {
+	VectorRef<KeyRef> keyRefs((KeyRef*)keys, key_count);
+	Standalone<VectorRef<KeyRangeRef>> ranges;
+	for (int i = 0; i < range_count; i++) {
+		ranges.push_back(ranges.arena(), KeyRangeRef(KeyRef(range_begin_keys[i].key, range_begin_keys[i].key_length),
+		                                             KeyRef(range_end_keys[i].key, range_end_keys[i].key_length)));
+	}
+	std::vector<int> limits(range_limits, range_limits + range_count);
+	return (FDBFuture*)(TXN(tr)->getBatch(keyRefs, ranges, limits, snapshot).extractPtr());
+}
+
 #include "fdb_c_function_pointers.g.h"
 
 #define FDB_API_CHANGED(func, ver) if (header_version < ver) fdb_api_ptr_##func = (void*)&(func##_v##ver##_PREV); else if (fdb_api_ptr_##func == (void*)&fdb_api_ptr_unimpl) fdb_api_ptr_##func = (void*)&(func##_impl);
@@ -115,6 +115,28 @@ extern "C" {
         int value_length;
     } FDBKeyValue;
 #endif
+#if FDB_API_VERSION >= 700
+    /* A mutation of a change feed: a set of param1 to param2 if type is 0, or a clear of [param1, param2) if it is 1 */
+    typedef struct changefeedmutation {
+        int64_t version;
+        int type;
+        const uint8_t* param1;
+        int param1_length;
+        const uint8_t* param2;
+        int param2_length;
+    } FDBChangeFeedMutation;
+
+    /* The aggregates of the key-value pairs in a range.  The keys are only set if count is positive. */
+    typedef struct rangeaggregate {
+        int64_t count;
+        int64_t bytes;
+        int64_t sum;
+        const uint8_t* first_key;
+        int first_key_length;
+        const uint8_t* last_key;
+        int last_key_length;
+    } FDBRangeAggregate;
+#endif
 #pragma pack(pop)
 
     DLLEXPORT void fdb_future_cancel( FDBFuture* f );
@@ -157,6 +179,25 @@ extern "C" {
     DLLEXPORT WARN_UNUSED_RESULT fdb_error_t
     fdb_future_get_keyvalue_array( FDBFuture* f, FDBKeyValue const** out_kv,
                                    int* out_count, fdb_bool_t* out_more );
+#endif
+#if FDB_API_VERSION >= 700
+    /* Copies the key-value pairs of a range read into the caller's buffer, as a key length and a value length (each
+       an int in native byte order) followed by the key and value bytes for each pair.  Only whole pairs are copied,
+       and *out_more is set if any did not fit. */
+    DLLEXPORT WARN_UNUSED_RESULT fdb_error_t
+    fdb_future_get_keyvalue_array_packed( FDBFuture* f, uint8_t* buffer, int buffer_length,
+                                          int* out_count, fdb_bool_t* out_more, int* out_length );
+
+    DLLEXPORT WARN_UNUSED_RESULT fdb_error_t
+    fdb_future_get_keyvalue_array_batch( FDBFuture* f, int index, FDBKeyValue const** out_kv,
+                                         int* out_count, fdb_bool_t* out_more );
+
+    DLLEXPORT WARN_UNUSED_RESULT fdb_error_t
+    fdb_future_get_change_feed_mutations( FDBFuture* f, FDBChangeFeedMutation const** out_mutations,
+                                          int* out_count );
+
+    DLLEXPORT WARN_UNUSED_RESULT fdb_error_t
+    fdb_future_get_range_aggregate( FDBFuture* f, FDBRangeAggregate* out_aggregate );
 #endif
     DLLEXPORT WARN_UNUSED_RESULT fdb_error_t
     fdb_future_get_key_array( FDBFuture* f, FDBKey const** out_key_array,
@@ -182,6 +223,17 @@ extern "C" {
     fdb_database_reboot_worker( FDBDatabase* db, uint8_t const* address,
                                 int address_length, fdb_bool_t check, int duration);
 
+#if FDB_API_VERSION >= 700
+    /* Waits for the next mutations committed to [begin_key, end_key) at versions in [begin_version, end_version), and
+       returns them in version order, read with fdb_future_get_change_feed_mutations.  The feed continues from one past
+       the version of the last mutation returned, and no mutations means it has reached end_version. */
+    DLLEXPORT WARN_UNUSED_RESULT FDBFuture*
+    fdb_database_read_change_feed( FDBDatabase* db, uint8_t const* begin_key_name,
+                                   int begin_key_name_length, uint8_t const* end_key_name,
+                                   int end_key_name_length, int64_t begin_version,
+                                   int64_t end_version );
+#endif
+
     DLLEXPORT void fdb_transaction_destroy( FDBTransaction* tr);
 
     DLLEXPORT void fdb_transaction_cancel( FDBTransaction* tr);
@@ -289,6 +341,27 @@ extern "C" {
     fdb_transaction_get_range_split_points( FDBTransaction* tr, uint8_t const* begin_key_name,
         int begin_key_name_length, uint8_t const* end_key_name, int end_key_name_length, int64_t chunk_size);
 
+    /* Reads several keys at once.  The future's result, read with fdb_future_get_keyvalue_array, holds the keys that
+       are present with their values, in the order they were given. */
+    DLLEXPORT WARN_UNUSED_RESULT FDBFuture*
+    fdb_transaction_get_multi( FDBTransaction* tr, FDBKey const* keys, int key_count, fdb_bool_t snapshot );
+
+    /* Reads several keys and several ranges at once, starting all of the reads together.  The future holds one result
+       for each key, holding the key and its value if it is present, followed by one for each range, holding its first
+       range_limits[i] key-value pairs (or all of them if that is not positive).  Each result is read with
+       fdb_future_get_keyvalue_array_batch. */
+    DLLEXPORT WARN_UNUSED_RESULT FDBFuture*
+    fdb_transaction_get_batch( FDBTransaction* tr, FDBKey const* keys, int key_count,
+                               FDBKey const* range_begin_keys, FDBKey const* range_end_keys,
+                               int const* range_limits, int range_count, fdb_bool_t snapshot );
+
+    /* Counts the key-value pairs of a range, and totals their sizes and their values as little-endian integers, on
+       the storage servers, so that the range itself is not transferred.  Read with fdb_future_get_range_aggregate. */
+    DLLEXPORT WARN_UNUSED_RESULT FDBFuture*
+    fdb_transaction_get_range_aggregate( FDBTransaction* tr, uint8_t const* begin_key_name,
+                                         int begin_key_name_length, uint8_t const* end_key_name,
+                                         int end_key_name_length, fdb_bool_t snapshot );
+
     #define FDB_KEYSEL_LAST_LESS_THAN(k, l) k, l, 0, 0
     #define FDB_KEYSEL_LAST_LESS_OR_EQUAL(k, l) k, l, 1, 0
     #define FDB_KEYSEL_FIRST_GREATER_THAN(k, l) k, l, 1, 1
@@ -101,8 +101,7 @@ int commit_transaction(FDBTransaction* transaction) {
 	return FDB_SUCCESS;
 }
 
-void update_op_lat_stats(struct timespec* start, struct timespec* end, int op, mako_stats_t* stats,
-                         lat_block_t* block[], int* elem_size, bool* is_memory_allocated) {
+void update_op_lat_stats(struct timespec* start, struct timespec* end, int op, mako_stats_t* stats) {
 	uint64_t latencyus;
 
 	latencyus = (((uint64_t)end->tv_sec * 1000000000 + end->tv_nsec) -
@@ -116,19 +115,7 @@ void update_op_lat_stats(struct timespec* start, struct timespec* end, int op, m
 	if (latencyus > stats->latency_us_max[op]) {
 		stats->latency_us_max[op] = latencyus;
 	}
-	if (!is_memory_allocated[op]) return;
-	if (elem_size[op] < stats->latency_samples[op]) {
-		elem_size[op] = elem_size[op] + LAT_BLOCK_SIZE;
-		lat_block_t* temp_block = (lat_block_t*)malloc(sizeof(lat_block_t));
-		if (temp_block == NULL) {
-			is_memory_allocated[op] = false;
-			return;
-		}
-		temp_block->next_block = NULL;
-		block[op]->next_block = (lat_block_t*)temp_block;
-		block[op] = temp_block;
-	}
-	block[op]->data[(stats->latency_samples[op] - 1) % LAT_BLOCK_SIZE] = latencyus;
+	stats->latency_hist[op][lat_hist_bucket(latencyus)]++;
 }
 
 /* FDB network thread */
@@ -173,7 +160,7 @@ failExit:
 
 /* populate database */
 int populate(FDBTransaction* transaction, mako_args_t* args, int worker_id, int thread_id, int thread_tps,
-             mako_stats_t* stats, lat_block_t* block[], int* elem_size, bool* is_memory_allocated) {
+             mako_stats_t* stats) {
 	int i;
 	struct timespec timer_start, timer_end;
 	struct timespec timer_prev, timer_now; /* for throttling */
@@ -264,10 +251,8 @@ int populate(FDBTransaction* transaction, mako_args_t* args, int worker_id, int
 			/* xact latency stats */
 			if (stats->xacts % args->sampling == 0) {
 				clock_gettime(CLOCK_MONOTONIC, &timer_per_xact_end);
-				update_op_lat_stats(&timer_start_commit, &timer_per_xact_end, OP_COMMIT, stats, block, elem_size,
-				                    is_memory_allocated);
-				update_op_lat_stats(&timer_per_xact_start, &timer_per_xact_end, OP_TRANSACTION, stats, block, elem_size,
-				                    is_memory_allocated);
+				update_op_lat_stats(&timer_start_commit, &timer_per_xact_end, OP_COMMIT, stats);
+				update_op_lat_stats(&timer_per_xact_start, &timer_per_xact_end, OP_TRANSACTION, stats);
 			}
 
 			stats->ops[OP_COMMIT]++;
@@ -288,10 +273,8 @@ int populate(FDBTransaction* transaction, mako_args_t* args, int worker_id, int
 	/* xact latency stats */
 	if (stats->xacts % args->sampling == 0) {
 		clock_gettime(CLOCK_MONOTONIC, &timer_per_xact_end);
-		update_op_lat_stats(&timer_start_commit, &timer_per_xact_end, OP_COMMIT, stats, block, elem_size,
-		                    is_memory_allocated);
-		update_op_lat_stats(&timer_per_xact_start, &timer_per_xact_end, OP_TRANSACTION, stats, block, elem_size,
-		                    is_memory_allocated);
+		update_op_lat_stats(&timer_start_commit, &timer_per_xact_end, OP_COMMIT, stats);
+		update_op_lat_stats(&timer_per_xact_start, &timer_per_xact_end, OP_TRANSACTION, stats);
 	}
 
 	clock_gettime(CLOCK_MONOTONIC, &timer_end);
@@ -428,8 +411,10 @@ int run_op_clearrange(FDBTransaction* transaction, char* keystr, char* keystr2)
 }
 
 /* run one transaction */
+/* intended_start is when an open-loop schedule wanted the transaction to start, and its latency is measured from
+ * there so that time spent waiting behind earlier transactions is counted. It is NULL in closed loop. */
 int run_one_transaction(FDBTransaction* transaction, mako_args_t* args, mako_stats_t* stats, char* keystr,
-                        char* keystr2, char* valstr, lat_block_t* block[], int* elem_size, bool* is_memory_allocated) {
+                        char* keystr2, char* valstr, struct timespec* intended_start) {
 	int i;
 	int count;
 	int rc;
@@ -448,7 +433,11 @@ int run_one_transaction(FDBTransaction* transaction, mako_args_t* args, mako_sta
   fdb_transaction_reset(transaction);
 #endif
 
-	clock_gettime(CLOCK_MONOTONIC, &timer_per_xact_start);
+	if (intended_start) {
+		timer_per_xact_start = *intended_start;
+	} else {
+		clock_gettime(CLOCK_MONOTONIC, &timer_per_xact_start);
+	}
 
 retryTxn:
 	for (i = 0; i < MAX_OP; i++) {
@@ -539,10 +528,8 @@ retryTxn:
 							stats->ops[OP_TRANSACTION]++;
 							if (stats->xacts % args->sampling == 0) {
 								clock_gettime(CLOCK_MONOTONIC, &timer_per_xact_end);
-								update_op_lat_stats(&timer_start_commit, &timer_per_xact_end, OP_COMMIT, stats, block,
-								                    elem_size, is_memory_allocated);
-								update_op_lat_stats(&timer_per_xact_start, &timer_per_xact_end, OP_TRANSACTION, stats,
-								                    block, elem_size, is_memory_allocated);
+								update_op_lat_stats(&timer_start_commit, &timer_per_xact_end, OP_COMMIT, stats);
+								update_op_lat_stats(&timer_per_xact_start, &timer_per_xact_end, OP_TRANSACTION, stats);
 							}
 						} else {
 							/* error */
@@ -598,10 +585,8 @@ retryTxn:
 						stats->ops[OP_TRANSACTION]++;
 						if (stats->xacts % args->sampling == 0) {
 							clock_gettime(CLOCK_MONOTONIC, &timer_per_xact_end);
-							update_op_lat_stats(&timer_start_commit, &timer_per_xact_end, OP_COMMIT, stats, block,
-							                    elem_size, is_memory_allocated);
-							update_op_lat_stats(&timer_per_xact_start, &timer_per_xact_end, OP_TRANSACTION, stats,
-							                    block, elem_size, is_memory_allocated);
+							update_op_lat_stats(&timer_start_commit, &timer_per_xact_end, OP_COMMIT, stats);
+							update_op_lat_stats(&timer_per_xact_start, &timer_per_xact_end, OP_TRANSACTION, stats);
 						}
 					} else {
 						/* error */
@@ -630,7 +615,7 @@ retryTxn:
 					clock_gettime(CLOCK_MONOTONIC, &timer_end);
 					if (rc == FDB_SUCCESS) {
 						/* per op latency, record successful transactions */
-						update_op_lat_stats(&timer_start, &timer_end, i, stats, block, elem_size, is_memory_allocated);
+						update_op_lat_stats(&timer_start, &timer_end, i, stats);
 					}
 				}
 
@@ -666,8 +651,7 @@ retryTxn:
 			stats->ops[OP_COMMIT]++;
 			if (stats->xacts % args->sampling == 0) {
 				clock_gettime(CLOCK_MONOTONIC, &timer_per_xact_end);
-				update_op_lat_stats(&timer_start_commit, &timer_per_xact_end, OP_COMMIT, stats, block, elem_size,
-				                    is_memory_allocated);
+				update_op_lat_stats(&timer_start_commit, &timer_per_xact_end, OP_COMMIT, stats);
 			}
 		} else {
 			/* error */
@@ -688,8 +672,7 @@ retryTxn:
 	stats->ops[OP_TRANSACTION]++;
 	if (stats->xacts % args->sampling == 0) {
 		clock_gettime(CLOCK_MONOTONIC, &timer_per_xact_end);
-		update_op_lat_stats(&timer_per_xact_start, &timer_per_xact_end, OP_TRANSACTION, stats, block, elem_size,
-		                    is_memory_allocated);
+		update_op_lat_stats(&timer_per_xact_start, &timer_per_xact_end, OP_TRANSACTION, stats);
 	}
 
 	stats->xacts++;
@@ -699,13 +682,48 @@ retryTxn:
 	return 0;
 }
 
+/* advance an open-loop schedule by one arrival at rate per second and sleep until it is due.
+ * A thread that has fallen behind starts right away and the schedule doesn't wait for it, so the
+ * time spent catching up shows in the latency measured from intended.
+ * Returns 0 without scheduling anything when rate is not positive. */
+int wait_for_arrival(int arrival, double rate, uint64_t* intended_ns, struct timespec* intended) {
+	struct timespec timer_now;
+	uint64_t now_ns;
+	double interval;
+
+	clock_gettime(CLOCK_MONOTONIC, &timer_now);
+	now_ns = (uint64_t)timer_now.tv_sec * 1000000000 + timer_now.tv_nsec;
+	if (rate <= 0) {
+		*intended_ns = now_ns;
+		usleep(1000);
+		return 0;
+	}
+
+	if (arrival == ARRIVAL_POISSON) {
+		/* exponentially distributed gaps make the arrivals a Poisson process */
+		interval = -log(1.0 - rand() / (1.0 + RAND_MAX)) / rate;
+	} else {
+		interval = 1.0 / rate;
+	}
+	*intended_ns += (uint64_t)(interval * 1000000000);
+	intended->tv_sec = *intended_ns / 1000000000;
+	intended->tv_nsec = *intended_ns % 1000000000;
+
+	if (*intended_ns > now_ns) {
+		usleep((*intended_ns - now_ns) / 1000);
+	}
+	return 1;
+}
+
 int run_workload(FDBTransaction* transaction, mako_args_t* args, int thread_tps, volatile double* throttle_factor,
-                 int thread_iters, volatile int* signal, mako_stats_t* stats, int dotrace, int dotagging, lat_block_t* block[],
-                 int* elem_size, bool* is_memory_allocated) {
+                 int thread_iters, volatile int* signal, mako_stats_t* stats, int dotrace, int dotagging) {
 	int xacts = 0;
 	int64_t total_xacts = 0;
 	int rc = 0;
 	struct timespec timer_prev, timer_now;
+	struct timespec timer_intended; /* open loop */
+	uint64_t intended_ns;
+	int openloop = (args->arrival != ARRIVAL_CLOSED);
 	char* keystr;
 	char* keystr2;
 	char* valstr;
@@ -743,11 +761,22 @@ int run_workload(FDBTransaction* transaction, mako_args_t* args, int thread_tps,
 	}
 
 	clock_gettime(CLOCK_MONOTONIC_COARSE, &timer_prev);
+	clock_gettime(CLOCK_MONOTONIC, &timer_intended);
+	intended_ns = (uint64_t)timer_intended.tv_sec * 1000000000 + timer_intended.tv_nsec;
 
 	/* main transaction loop */
 	while (1) {
 
-		if (((thread_tps > 0) && (xacts >= current_tps)) /* throttle on */ || dotrace /* transaction tracing on */) {
+		if (openloop) {
+			if (!wait_for_arrival(args->arrival, (double)thread_tps * *throttle_factor, &intended_ns,
+			                      &timer_intended)) {
+				if (*signal == SIGNAL_RED) break;
+				continue;
+			}
+		}
+
+		if ((!openloop && (thread_tps > 0) && (xacts >= current_tps)) /* throttle on */ ||
+		    dotrace /* transaction tracing on */) {
 
 			clock_gettime(CLOCK_MONOTONIC_COARSE, &timer_now);
 			if ((timer_now.tv_sec > timer_prev.tv_sec + 1) ||
@@ -785,7 +814,7 @@ int run_workload(FDBTransaction* transaction, mako_args_t* args, int thread_tps,
 
 
 			} else {
-				if (thread_tps > 0) {
+				if (!openloop && thread_tps > 0) {
 					/* 1 second not passed, throttle */
 					usleep(1000);
 					continue;
@@ -804,8 +833,7 @@ int run_workload(FDBTransaction* transaction, mako_args_t* args, int thread_tps,
 			}
 		}
 
-		rc = run_one_transaction(transaction, args, stats, keystr, keystr2, valstr, block, elem_size,
-		                         is_memory_allocated);
+		rc = run_one_transaction(transaction, args, stats, keystr, keystr2, valstr, openloop ? &timer_intended : NULL);
 		if (rc) {
 			/* FIXME: run_one_transaction should return something meaningful */
 			fprintf(annoyme, "ERROR: run_one_transaction failed (%d)\n", rc);
@@ -836,53 +864,39 @@ int run_workload(FDBTransaction* transaction, mako_args_t* args, int thread_tps,
 	return rc;
 }
 
-void get_stats_file_name(char filename[], int worker_id, int thread_id, int op) {
-	char str1[256];
-	sprintf(str1, "/%d_%d_", worker_id + 1, thread_id + 1);
-	strcat(filename, str1);
+/* name of an operation in reports and histogram files */
+const char* get_op_name(int op) {
 	switch (op) {
 	case OP_GETREADVERSION:
-		strcat(filename, "GRV");
-		break;
+		return "GRV";
 	case OP_GET:
-		strcat(filename, "GET");
-		break;
+		return "GET";
 	case OP_GETRANGE:
-		strcat(filename, "GETRANGE");
-		break;
+		return "GETRANGE";
 	case OP_SGET:
-		strcat(filename, "SGET");
-		break;
+		return "SGET";
 	case OP_SGETRANGE:
-		strcat(filename, "SGETRANGE");
-		break;
+		return "SGETRANGE";
 	case OP_UPDATE:
-		strcat(filename, "UPDATE");
-		break;
+		return "UPDATE";
 	case OP_INSERT:
-		strcat(filename, "INSERT");
-		break;
+		return "INSERT";
 	case OP_INSERTRANGE:
-		strcat(filename, "INSERTRANGE");
-		break;
+		return "INSERTRANGE";
 	case OP_CLEAR:
-		strcat(filename, "CLEAR");
-		break;
+		return "CLEAR";
 	case OP_SETCLEAR:
-		strcat(filename, "SETCLEAR");
-		break;
+		return "SETCLEAR";
 	case OP_CLEARRANGE:
-		strcat(filename, "CLEARRANGE");
-		break;
+		return "CLEARRANGE";
 	case OP_SETCLEARRANGE:
-		strcat(filename, "SETCLRRANGE");
-		break;
+		return "SETCLRRANGE";
 	case OP_COMMIT:
-		strcat(filename, "COMMIT");
-		break;
+		return "COMMIT";
 	case OP_TRANSACTION:
-		strcat(filename, "TRANSACTION");
-		break;
+		return "TRANSACTION";
+	default:
+		return "UNKNOWN";
 	}
 }
 
@@ -898,7 +912,6 @@ void* worker_thread(void* thread_args) {
 	int thread_tps = 0;
 	int thread_iters = 0;
 	int op;
-	int i, size;
 	int dotrace = (worker_id == 0 && thread_id == 0 && args->txntrace) ? args->txntrace : 0;
 	int dotagging = args->txntagging;
 	volatile int* signal = &((thread_args_t*)thread_args)->process->shm->signal;
@@ -908,14 +921,6 @@ void* worker_thread(void* thread_args) {
 	mako_stats_t* stats = (void*)((thread_args_t*)thread_args)->process->shm + sizeof(mako_shmhdr_t) /* skip header */
 	                      + (sizeof(mako_stats_t) * (worker_id * args->num_threads + thread_id));
 
-	lat_block_t* block[MAX_OP];
-	for (int i = 0; i < MAX_OP; i++) {
-		block[i] = ((thread_args_t*)thread_args)->block[i];
-	}
-	int* elem_size = &((thread_args_t*)thread_args)->elem_size[0];
-	pid_t* parent_id = &((thread_args_t*)thread_args)->process->parent_id;
-	bool* is_memory_allocated = &((thread_args_t*)thread_args)->is_memory_allocated[0];
-
 	/* init latency */
 	for (op = 0; op < MAX_OP; op++) {
 		stats->latency_us_min[op] = 0xFFFFFFFFFFFFFFFF; /* uint64_t */
@@ -956,8 +961,7 @@ void* worker_thread(void* thread_args) {
 
 	/* build/popualte */
 	else if (args->mode == MODE_BUILD) {
-		rc =
-		    populate(transaction, args, worker_id, thread_id, thread_tps, stats, block, elem_size, is_memory_allocated);
+		rc = populate(transaction, args, worker_id, thread_id, thread_tps, stats);
 		if (rc < 0) {
 			fprintf(stderr, "ERROR: populate failed\n");
 		}
@@ -966,56 +970,18 @@ void* worker_thread(void* thread_args) {
 	/* run the workload */
 	else if (args->mode == MODE_RUN) {
 		rc = run_workload(transaction, args, thread_tps, throttle_factor, thread_iters,
-				  signal, stats, dotrace, dotagging, block, elem_size, is_memory_allocated);
+				  signal, stats, dotrace, dotagging);
 		if (rc < 0) {
 			fprintf(stderr, "ERROR: run_workload failed\n");
 		}
 	}
 
 	if (args->mode == MODE_BUILD || args->mode == MODE_RUN) {
-		char str2[1000];
-		sprintf(str2, "%s%d", TEMP_DATA_STORE, *parent_id);
-		rc = mkdir(str2, S_IRWXU | S_IRWXG | S_IROTH | S_IXOTH);
-		for (op = 0; op < MAX_OP; op++) {
-			if (args->txnspec.ops[op][OP_COUNT] > 0 || op == OP_COMMIT || op == OP_TRANSACTION) {
-				FILE* fp;
-				char file_name[NAME_MAX] = { '\0' };
-				strcat(file_name, str2);
-				get_stats_file_name(file_name, worker_id, thread_id, op);
-				fp = fopen(file_name, "w");
-				lat_block_t* temp_block = ((thread_args_t*)thread_args)->block[op];
-				if (is_memory_allocated[op]) {
-					size = stats->latency_samples[op] / LAT_BLOCK_SIZE;
-					for (i = 0; i < size && temp_block != NULL; i++) {
-						fwrite(&temp_block->data, sizeof(uint64_t) * LAT_BLOCK_SIZE, 1, fp);
-						temp_block = temp_block->next_block;
-					}
-					size = stats->latency_samples[op] % LAT_BLOCK_SIZE;
-					if (size != 0) fwrite(&temp_block->data, sizeof(uint64_t) * size, 1, fp);
-				} else {
-					while (temp_block) {
-						fwrite(&temp_block->data, sizeof(uint64_t) * LAT_BLOCK_SIZE, 1, fp);
-						temp_block = temp_block->next_block;
-					}
-				}
-				fclose(fp);
-			}
-		}
 		__sync_fetch_and_add(stopcount, 1);
 	}
 
 	/* fall through */
 failExit:
-	for (op = 0; op < MAX_OP; op++) {
-		lat_block_t* curr = ((thread_args_t*)thread_args)->block[op];
-		lat_block_t* prev = NULL;
-		size = elem_size[op] / LAT_BLOCK_SIZE;
-		while (size--) {
-			prev = curr;
-			curr = curr->next_block;
-			free(prev);
-		}
-	}
 	fdb_transaction_destroy(transaction);
 	pthread_exit(0);
 }
@@ -1148,19 +1114,6 @@ int worker_process_main(mako_args_t* args, int worker_id, mako_shmhdr_t* shm, pi
 
 	for (i = 0; i < args->num_threads; i++) {
 		thread_args[i].thread_id = i;
-		for (int op = 0; op < MAX_OP; op++) {
-			if (args->txnspec.ops[op][OP_COUNT] > 0 || op == OP_TRANSACTION || op == OP_COMMIT) {
-				thread_args[i].block[op] = (lat_block_t*)malloc(sizeof(lat_block_t));
-				if (thread_args[i].block[op] == NULL) {
-					thread_args[i].is_memory_allocated[op] = false;
-					thread_args[i].elem_size[op] = 0;
-				} else {
-					thread_args[i].is_memory_allocated[op] = true;
-					thread_args[i].block[op]->next_block = NULL;
-					thread_args[i].elem_size[op] = LAT_BLOCK_SIZE;
-				}
-			}
-		}
 		thread_args[i].process = &process;
 		rc = pthread_create(&worker_threads[i], NULL, worker_thread, (void*)&thread_args[i]);
 		if (rc != 0) {
@@ -1237,6 +1190,10 @@ int init_args(mako_args_t* args) {
 	args->txntrace = 0;
 	args->txntagging = 0;
 	memset(args->txntagging_prefix, 0, TAGPREFIXLENGTH_MAX);
+	args->arrival = ARRIVAL_CLOSED;
+	args->histogram_file[0] = '\0';
+	args->report_files = NULL;
+	args->num_report_files = 0;
 	for (i = 0; i < MAX_OP; i++) {
 		args->txnspec.ops[i][OP_COUNT] = 0;
 	}
@@ -1386,8 +1343,13 @@ void usage() {
 	printf("%-24s %s\n", "    --tpsmin=TPS", "Specify the target min TPS");
 	printf("%-24s %s\n", "    --tpsinterval=SEC", "Specify the TPS change interval (Default: 10 seconds)");
 	printf("%-24s %s\n", "    --tpschange=<sin|square|pulse>", "Specify the TPS change type (Default: sin)");
+	printf("%-24s %s\n", "    --arrival=<closed|fixed|poisson>",
+	       "Start transactions as earlier ones finish (Default: closed), or at the target TPS with fixed or");
+	printf("%-24s %s\n", "", "exponentially distributed gaps, measuring latency from the intended start");
 	printf("%-24s %s\n", "    --sampling=RATE", "Specify the sampling rate for latency stats");
-	printf("%-24s %s\n", "-m, --mode=MODE", "Specify the mode (build, run, clean)");
+	printf("%-24s %s\n", "    --histogram=FILE", "Save the latency histograms to FILE for merging with --mode report");
+	printf("%-24s %s\n", "-m, --mode=MODE", "Specify the mode (build, run, clean, report)");
+	printf("%-24s %s\n", "", "report merges the histogram files given after the options and prints their latencies");
 	printf("%-24s %s\n", "-z, --zipf", "Use zipfian distribution instead of uniform distribution");
 	printf("%-24s %s\n", "    --commitget", "Commit GETs");
 	printf("%-24s %s\n", "    --trace", "Enable tracing");
@@ -1425,6 +1387,8 @@ int parse_args(int argc, char* argv[], mako_args_t* args) {
 			                                    { "tpsinterval", required_argument, NULL, ARG_TPSINTERVAL },
 			                                    { "tpschange", required_argument, NULL, ARG_TPSCHANGE },
 			                                    { "sampling", required_argument, NULL, ARG_SAMPLING },
+			                                    { "arrival", required_argument, NULL, ARG_ARRIVAL },
+			                                    { "histogram", required_argument, NULL, ARG_HISTOGRAM },
 			                                    { "verbose", required_argument, NULL, 'v' },
 			                                    { "mode", required_argument, NULL, 'm' },
 			                                    { "knobs", required_argument, NULL, ARG_KNOBS },
@@ -1490,6 +1454,8 @@ int parse_args(int argc, char* argv[], mako_args_t* args) {
 				args->mode = MODE_BUILD;
 			} else if (strcmp(optarg, "run") == 0) {
 				args->mode = MODE_RUN;
+			} else if (strcmp(optarg, "report") == 0) {
+				args->mode = MODE_REPORT;
 			}
 			break;
 		case ARG_KEYLEN:
@@ -1523,6 +1489,25 @@ int parse_args(int argc, char* argv[], mako_args_t* args) {
 		case ARG_SAMPLING:
 			args->sampling = atoi(optarg);
 			break;
+		case ARG_ARRIVAL:
+			if (strcmp(optarg, "closed") == 0)
+				args->arrival = ARRIVAL_CLOSED;
+			else if (strcmp(optarg, "fixed") == 0)
+				args->arrival = ARRIVAL_FIXED;
+			else if (strcmp(optarg, "poisson") == 0)
+				args->arrival = ARRIVAL_POISSON;
+			else {
+				fprintf(stderr, "--arrival must be closed, fixed or poisson\n");
+				return -1;
+			}
+			break;
+		case ARG_HISTOGRAM:
+			if (strlen(optarg) >= PATH_MAX) {
+				fprintf(stderr, "Error: --histogram path is too long\n");
+				return -1;
+			}
+			strcpy(args->histogram_file, optarg);
+			break;
 		case ARG_VERSION:
 			fprintf(stderr, "Version: %d\n", FDB_API_VERSION);
 			exit(0);
@@ -1597,6 +1582,10 @@ int parse_args(int argc, char* argv[], mako_args_t* args) {
 		args->tpsmin = args->tpsmax;
 	}
 
+	/* histogram files to merge */
+	args->report_files = argv + optind;
+	args->num_report_files = argc - optind;
+
 	if (args->verbose >= VERBOSE_DEFAULT) {
 		printme = stdout;
 	} else {
@@ -1621,6 +1610,17 @@ int validate_args(mako_args_t* args) {
 		fprintf(stderr, "ERROR: --mode has to be set\n");
 		return -1;
 	}
+	if (args->mode == MODE_REPORT) {
+		if (args->num_report_files == 0) {
+			fprintf(stderr, "ERROR: report mode needs the histogram files to merge\n");
+			return -1;
+		}
+		return 0;
+	}
+	if (args->num_report_files > 0) {
+		fprintf(stderr, "ERROR: unexpected argument %s\n", args->report_files[0]);
+		return -1;
+	}
 	if (args->rows <= 0) {
 		fprintf(stderr, "ERROR: --rows must be a positive integer\n");
 		return -1;
@@ -1649,6 +1649,11 @@ int validate_args(mako_args_t* args) {
 			fprintf(stderr, "ERROR: Must specify either seconds or iteration\n");
 			return -1;
 		}
+		if ((args->arrival != ARRIVAL_CLOSED) && (args->tpsmax <= 0)) {
+			fprintf(stderr, "ERROR: --arrival %s needs a target --tps\n",
+			        (args->arrival == ARRIVAL_FIXED) ? "fixed" : "poisson");
+			return -1;
+		}
 		if(args->txntagging < 0) {
             fprintf(stderr, "ERROR: --txntagging must be a non-negative integer\n");
             return -1;
@@ -1806,9 +1811,194 @@ void print_stats_header(mako_args_t* args, bool show_commit, bool is_first_heade
 	printf("\n");
 }
 
-void print_report(mako_args_t* args, mako_stats_t* stats, struct timespec* timer_now, struct timespec* timer_start,
-                  pid_t* pid_main) {
-	int i, j, k, op, index;
+/* print latency stats, with percentiles from the merged histograms when they are available */
+void print_latency_report(mako_args_t* args, uint64_t* lat_samples, uint64_t* lat_min, uint64_t* lat_total,
+                          uint64_t* lat_max, uint64_t (*lat_hist)[LAT_HIST_BUCKETS]) {
+	int i, op;
+	const char* pct_titles[] = { "Median", "95.0 pctile", "99.0 pctile", "99.9 pctile", "99.99 pctile" };
+	const double pcts[] = { 0.5, 0.95, 0.99, 0.999, 0.9999 };
+
+	printf("%s", "Latency (us)");
+	print_stats_header(args, true, false, true);
+
+	/* Total Samples */
+	printf("%-" STR(STATS_TITLE_WIDTH) "s ", "Samples");
+	for (op = 0; op < MAX_OP; op++) {
+		if (args->txnspec.ops[op][OP_COUNT] > 0 || op == OP_TRANSACTION || op == OP_COMMIT) {
+			if (lat_total[op]) {
+				printf("%" STR(STATS_FIELD_WIDTH) "lld ", lat_samples[op]);
+			} else {
+				printf("%" STR(STATS_FIELD_WIDTH) "s ", "N/A");
+			}
+		}
+	}
+	printf("\n");
+
+	/* Min Latency */
+	printf("%-" STR(STATS_TITLE_WIDTH) "s ", "Min");
+	for (op = 0; op < MAX_OP; op++) {
+		if (args->txnspec.ops[op][OP_COUNT] > 0 || op == OP_TRANSACTION || op == OP_COMMIT) {
+			if (lat_min[op] == -1) {
+				printf("%" STR(STATS_FIELD_WIDTH) "s ", "N/A");
+			} else {
+				printf("%" STR(STATS_FIELD_WIDTH) "lld ", lat_min[op]);
+			}
+		}
+	}
+	printf("\n");
+
+	/* Avg Latency */
+	printf("%-" STR(STATS_TITLE_WIDTH) "s ", "Avg");
+	for (op = 0; op < MAX_OP; op++) {
+		if (args->txnspec.ops[op][OP_COUNT] > 0 || op == OP_TRANSACTION || op == OP_COMMIT) {
+			if (lat_total[op]) {
+				printf("%" STR(STATS_FIELD_WIDTH) "lld ", lat_total[op] / lat_samples[op]);
+			} else {
+				printf("%" STR(STATS_FIELD_WIDTH) "s ", "N/A");
+			}
+		}
+	}
+	printf("\n");
+
+	/* Max Latency */
+	printf("%-" STR(STATS_TITLE_WIDTH) "s ", "Max");
+	for (op = 0; op < MAX_OP; op++) {
+		if (args->txnspec.ops[op][OP_COUNT] > 0 || op == OP_TRANSACTION || op == OP_COMMIT) {
+			if (lat_max[op] == 0) {
+				printf("%" STR(STATS_FIELD_WIDTH) "s ", "N/A");
+			} else {
+				printf("%" STR(STATS_FIELD_WIDTH) "lld ", lat_max[op]);
+			}
+		}
+	}
+	printf("\n");
+
+	for (i = 0; i < sizeof(pcts) / sizeof(pcts[0]); i++) {
+		printf("%-" STR(STATS_TITLE_WIDTH) "s ", pct_titles[i]);
+		for (op = 0; op < MAX_OP; op++) {
+			if (args->txnspec.ops[op][OP_COUNT] > 0 || op == OP_TRANSACTION || op == OP_COMMIT) {
+				if (lat_hist && lat_samples[op]) {
+					printf("%" STR(STATS_FIELD_WIDTH) "lld ", lat_hist_percentile(lat_hist[op], pcts[i]));
+				} else {
+					printf("%" STR(STATS_FIELD_WIDTH) "s ", "N/A");
+				}
+			}
+		}
+		printf("\n");
+	}
+}
+
+/* histogram files hold one line per operation with samples:
+ *   <op name> <samples> <total us> <min us> <max us> <bucket>:<count>...
+ * with only non-empty buckets listed, so that runs on several hosts can be merged with --mode report */
+#define HISTOGRAM_FILE_HEADER "mako_latency_histogram"
+
+int write_histogram_file(const char* path, uint64_t* lat_samples, uint64_t* lat_min, uint64_t* lat_total,
+                         uint64_t* lat_max, uint64_t (*lat_hist)[LAT_HIST_BUCKETS]) {
+	int op, k;
+	FILE* fp = fopen(path, "w");
+	if (!fp) {
+		fprintf(stderr, "ERROR: cannot open histogram file %s\n", path);
+		return -1;
+	}
+	fprintf(fp, "%s %d %d\n", HISTOGRAM_FILE_HEADER, LAT_HIST_SUB_BUCKET_BITS, LAT_HIST_BUCKETS);
+	for (op = 0; op < MAX_OP; op++) {
+		if (lat_samples[op] == 0) continue;
+		fprintf(fp, "%s %llu %llu %llu %llu", get_op_name(op), (unsigned long long)lat_samples[op],
+		        (unsigned long long)lat_total[op], (unsigned long long)lat_min[op], (unsigned long long)lat_max[op]);
+		for (k = 0; k < LAT_HIST_BUCKETS; k++) {
+			if (lat_hist[op][k]) fprintf(fp, " %d:%llu", k, (unsigned long long)lat_hist[op][k]);
+		}
+		fprintf(fp, "\n");
+	}
+	fclose(fp);
+	return 0;
+}
+
+/* add the histograms in path to the ones given */
+int read_histogram_file(const char* path, uint64_t* lat_samples, uint64_t* lat_min, uint64_t* lat_total,
+                        uint64_t* lat_max, uint64_t (*lat_hist)[LAT_HIST_BUCKETS]) {
+	char header[64];
+	char name[64];
+	int bits, buckets, op, k, c;
+	unsigned long long samples, total, min, max, count;
+	FILE* fp = fopen(path, "r");
+	if (!fp) {
+		fprintf(stderr, "ERROR: cannot open histogram file %s\n", path);
+		return -1;
+	}
+	if (fscanf(fp, "%63s %d %d", header, &bits, &buckets) != 3 || strcmp(header, HISTOGRAM_FILE_HEADER) != 0 ||
+	    bits != LAT_HIST_SUB_BUCKET_BITS || buckets != LAT_HIST_BUCKETS) {
+		fprintf(stderr, "ERROR: %s is not a histogram file of this version of mako\n", path);
+		fclose(fp);
+		return -1;
+	}
+	while (fscanf(fp, "%63s %llu %llu %llu %llu", name, &samples, &total, &min, &max) == 5) {
+		for (op = 0; op < MAX_OP; op++) {
+			if (strcmp(name, get_op_name(op)) == 0) break;
+		}
+		if (op == MAX_OP) {
+			fprintf(stderr, "ERROR: unknown operation %s in %s\n", name, path);
+			fclose(fp);
+			return -1;
+		}
+		lat_samples[op] += samples;
+		lat_total[op] += total;
+		if (min < lat_min[op]) lat_min[op] = min;
+		if (max > lat_max[op]) lat_max[op] = max;
+		while ((c = fgetc(fp)) == ' ') {
+			if (fscanf(fp, "%d:%llu", &k, &count) != 2 || k < 0 || k >= LAT_HIST_BUCKETS) {
+				fprintf(stderr, "ERROR: malformed histogram for %s in %s\n", name, path);
+				fclose(fp);
+				return -1;
+			}
+			lat_hist[op][k] += count;
+		}
+	}
+	fclose(fp);
+	return 0;
+}
+
+/* merge histogram files saved by earlier runs, e.g. from workers on several hosts, and print their latencies */
+int report_main(mako_args_t* args) {
+	int i, op;
+	uint64_t lat_min[MAX_OP];
+	uint64_t lat_total[MAX_OP] = { 0 };
+	uint64_t lat_samples[MAX_OP] = { 0 };
+	uint64_t lat_max[MAX_OP] = { 0 };
+	uint64_t(*lat_hist)[LAT_HIST_BUCKETS] = calloc(MAX_OP, sizeof(*lat_hist));
+
+	if (!lat_hist) {
+		fprintf(stderr, "ERROR: cannot allocate histograms\n");
+		return -1;
+	}
+	for (op = 0; op < MAX_OP; op++) {
+		lat_min[op] = 0xFFFFFFFFFFFFFFFF; /* uint64_t */
+	}
+	for (i = 0; i < args->num_report_files; i++) {
+		if (read_histogram_file(args->report_files[i], lat_samples, lat_min, lat_total, lat_max, lat_hist) < 0) {
+			free(lat_hist);
+			return -1;
+		}
+	}
+
+	/* report the operations that were run */
+	for (op = 0; op < MAX_OP; op++) {
+		if (op != OP_COMMIT && op != OP_TRANSACTION) {
+			args->txnspec.ops[op][OP_COUNT] = (lat_samples[op] > 0);
+		}
+	}
+	printf("Merged %d histogram files\n\n", args->num_report_files);
+	print_latency_report(args, lat_samples, lat_min, lat_total, lat_max, lat_hist);
+	if (args->histogram_file[0] != '\0') {
+		write_histogram_file(args->histogram_file, lat_samples, lat_min, lat_total, lat_max, lat_hist);
+	}
+	free(lat_hist);
+	return 0;
+}
+
+void print_report(mako_args_t* args, mako_stats_t* stats, struct timespec* timer_now, struct timespec* timer_start) {
+	int i, j, k, op;
 	uint64_t totalxacts = 0;
 	uint64_t conflicts = 0;
 	uint64_t totalerrors = 0;
@@ -1818,6 +2008,7 @@ void print_report(mako_args_t* args, mako_stats_t* stats, struct timespec* timer
 	uint64_t lat_total[MAX_OP] = { 0 };
 	uint64_t lat_samples[MAX_OP] = { 0 };
 	uint64_t lat_max[MAX_OP] = { 0 };
+	uint64_t(*lat_hist)[LAT_HIST_BUCKETS] = calloc(MAX_OP, sizeof(*lat_hist));
 
 	uint64_t durationns =
 	    (timer_now->tv_sec - timer_start->tv_sec) * 1000000000 + (timer_now->tv_nsec - timer_start->tv_nsec);
@@ -1847,6 +2038,11 @@ void print_report(mako_args_t* args, mako_stats_t* stats, struct timespec* timer
 					if (stats[idx].latency_us_max[op] > lat_max[op]) {
 						lat_max[op] = stats[idx].latency_us_max[op];
 					}
+					if (lat_hist) {
+						for (k = 0; k < LAT_HIST_BUCKETS; k++) {
+							lat_hist[op][k] += stats[idx].latency_hist[op][k];
+						}
+					}
 				} /* if count > 0 */
 			}
 		}
@@ -1906,176 +2102,18 @@ void print_report(mako_args_t* args, mako_stats_t* stats, struct timespec* timer
 	}
 	printf("\n\n");
 
-	printf("%s", "Latency (us)");
-	print_stats_header(args, true, false, true);
+	print_latency_report(args, lat_samples, lat_min, lat_total, lat_max, lat_hist);
 
-	/* Total Samples */
-	printf("%-" STR(STATS_TITLE_WIDTH) "s ", "Samples");
-	for (op = 0; op < MAX_OP; op++) {
-		if (args->txnspec.ops[op][OP_COUNT] > 0 || op == OP_TRANSACTION || op == OP_COMMIT) {
-			if (lat_total[op]) {
-				printf("%" STR(STATS_FIELD_WIDTH) "lld ", lat_samples[op]);
-			} else {
-				printf("%" STR(STATS_FIELD_WIDTH) "s ", "N/A");
-			}
-		}
-	}
-	printf("\n");
-
-	/* Min Latency */
-	printf("%-" STR(STATS_TITLE_WIDTH) "s ", "Min");
-	for (op = 0; op < MAX_OP; op++) {
-		if (args->txnspec.ops[op][OP_COUNT] > 0 || op == OP_TRANSACTION || op == OP_COMMIT) {
-			if (lat_min[op] == -1) {
-				printf("%" STR(STATS_FIELD_WIDTH) "s ", "N/A");
-			} else {
-				printf("%" STR(STATS_FIELD_WIDTH) "lld ", lat_min[op]);
-			}
-		}
-	}
-	printf("\n");
-
-	/* Avg Latency */
-	printf("%-" STR(STATS_TITLE_WIDTH) "s ", "Avg");
-	for (op = 0; op < MAX_OP; op++) {
-		if (args->txnspec.ops[op][OP_COUNT] > 0 || op == OP_TRANSACTION || op == OP_COMMIT) {
-			if (lat_total[op]) {
-				printf("%" STR(STATS_FIELD_WIDTH) "lld ", lat_total[op] / lat_samples[op]);
-			} else {
-				printf("%" STR(STATS_FIELD_WIDTH) "s ", "N/A");
-			}
-		}
-	}
-	printf("\n");
-
-	/* Max Latency */
-	printf("%-" STR(STATS_TITLE_WIDTH) "s ", "Max");
-	for (op = 0; op < MAX_OP; op++) {
-		if (args->txnspec.ops[op][OP_COUNT] > 0 || op == OP_TRANSACTION || op == OP_COMMIT) {
-			if (lat_max[op] == 0) {
-				printf("%" STR(STATS_FIELD_WIDTH) "s ", "N/A");
-			} else {
-				printf("%" STR(STATS_FIELD_WIDTH) "lld ", lat_max[op]);
-			}
-		}
-	}
-	printf("\n");
-
-	uint64_t* dataPoints[MAX_OP];
-	uint64_t median;
-	int point_99_9pct, point_99pct, point_95pct;
-
-	/* Median Latency */
-	printf("%-" STR(STATS_TITLE_WIDTH) "s ", "Median");
-	int num_points[MAX_OP] = { 0 };
-	for (op = 0; op < MAX_OP; op++) {
-		if (args->txnspec.ops[op][OP_COUNT] > 0 || op == OP_TRANSACTION || op == OP_COMMIT) {
-			if (lat_total[op]) {
-				dataPoints[op] = (uint64_t*)malloc(sizeof(uint64_t) * lat_samples[op]);
-				if (dataPoints[op] == NULL) {
-					printf("%" STR(STATS_FIELD_WIDTH) "s ", "N/A");
-					continue;
-				}
-				k = 0;
-				for (i = 0; i < args->num_processes; i++) {
-					for (j = 0; j < args->num_threads; j++) {
-						char file_name[NAME_MAX] = { '\0' };
-						sprintf(file_name, "%s%d", TEMP_DATA_STORE, *pid_main);
-						get_stats_file_name(file_name, i, j, op);
-						FILE* f = fopen(file_name, "r");
-						fseek(f, 0, SEEK_END);
-						int numPoints = ftell(f) / sizeof(uint64_t);
-						fseek(f, 0, 0);
-						index = 0;
-						while (index < numPoints) {
-							fread(&dataPoints[op][k++], sizeof(uint64_t), 1, f);
-							++index;
-						}
-						fclose(f);
-					}
-				}
-				num_points[op] = k;
-				quick_sort(dataPoints[op], num_points[op]);
-				if (num_points[op] & 1) {
-					median = dataPoints[op][num_points[op] / 2];
-				} else {
-					median = (dataPoints[op][num_points[op] / 2] + dataPoints[op][num_points[op] / 2 - 1]) >> 1;
-				}
-				printf("%" STR(STATS_FIELD_WIDTH) "lld ", median);
-			} else {
-				printf("%" STR(STATS_FIELD_WIDTH) "s ", "N/A");
-			}
-		}
-	}
-	printf("\n");
-
-	/* 95%ile Latency */
-	printf("%-" STR(STATS_TITLE_WIDTH) "s ", "95.0 pctile");
-	for (op = 0; op < MAX_OP; op++) {
-		if (args->txnspec.ops[op][OP_COUNT] > 0 || op == OP_TRANSACTION || op == OP_COMMIT) {
-			if (dataPoints[op] == NULL) {
-				printf("%" STR(STATS_FIELD_WIDTH) "s ", "N/A");
-				continue;
-			}
-			if (lat_total[op]) {
-				point_95pct = ((float)(num_points[op]) * 0.95) - 1;
-				printf("%" STR(STATS_FIELD_WIDTH) "lld ", dataPoints[op][point_95pct]);
-			} else {
-				printf("%" STR(STATS_FIELD_WIDTH) "s ", "N/A");
-			}
-		}
-	}
-	printf("\n");
-
-	/* 99%ile Latency */
-	printf("%-" STR(STATS_TITLE_WIDTH) "s ", "99.0 pctile");
-	for (op = 0; op < MAX_OP; op++) {
-		if (args->txnspec.ops[op][OP_COUNT] > 0 || op == OP_TRANSACTION || op == OP_COMMIT) {
-			if (dataPoints[op] == NULL) {
-				printf("%" STR(STATS_FIELD_WIDTH) "s ", "N/A");
-				continue;
-			}
-			if (lat_total[op]) {
-				point_99pct = ((float)(num_points[op]) * 0.99) - 1;
-				printf("%" STR(STATS_FIELD_WIDTH) "lld ", dataPoints[op][point_99pct]);
-			} else {
-				printf("%" STR(STATS_FIELD_WIDTH) "s ", "N/A");
-			}
-		}
-	}
-	printf("\n");
-
-	/* 99.9%ile Latency */
-	printf("%-" STR(STATS_TITLE_WIDTH) "s ", "99.9 pctile");
-	for (op = 0; op < MAX_OP; op++) {
-		if (args->txnspec.ops[op][OP_COUNT] > 0 || op == OP_TRANSACTION || op == OP_COMMIT) {
-			if (dataPoints[op] == NULL) {
-				printf("%" STR(STATS_FIELD_WIDTH) "s ", "N/A");
-				continue;
-			}
-			if (lat_total[op]) {
-				point_99_9pct = ((float)(num_points[op]) * 0.999) - 1;
-				printf("%" STR(STATS_FIELD_WIDTH) "lld ", dataPoints[op][point_99_9pct]);
-			} else {
-				printf("%" STR(STATS_FIELD_WIDTH) "s ", "N/A");
-			}
-		}
-	}
-	printf("\n");
-
-	char command_remove[NAME_MAX] = { '\0' };
-	sprintf(command_remove, "rm -rf %s%d", TEMP_DATA_STORE, *pid_main);
-	system(command_remove);
-
-	for (op = 0; op < MAX_OP; op++) {
-		if (args->txnspec.ops[op][OP_COUNT] > 0 || op == OP_TRANSACTION) {
-			if (lat_total[op]) free(dataPoints[op]);
+	if (lat_hist) {
+		if (args->histogram_file[0] != '\0') {
+			write_histogram_file(args->histogram_file, lat_samples, lat_min, lat_total, lat_max, lat_hist);
 		}
+		free(lat_hist);
 	}
 }
 
 int stats_process_main(mako_args_t* args, mako_stats_t* stats, volatile double* throttle_factor, volatile int* signal,
-                       volatile int* stopcount, pid_t* pid_main) {
+                       volatile int* stopcount) {
 	struct timespec timer_start, timer_prev, timer_now;
 	double sin_factor;
 
@@ -2138,7 +2176,7 @@ int stats_process_main(mako_args_t* args, mako_stats_t* stats, volatile double*
 		while (*stopcount < args->num_threads * args->num_processes) {
 			usleep(10000); /* 10ms */
 		}
-		print_report(args, stats, &timer_now, &timer_start, pid_main);
+		print_report(args, stats, &timer_now, &timer_start);
 	}
 
 	return 0;
@@ -2174,6 +2212,11 @@ int main(int argc, char* argv[]) {
 	rc = validate_args(&args);
 	if (rc < 0) return -1;
 
+	if (args.mode == MODE_REPORT) {
+		/* no cluster needed, just the saved histograms */
+		return report_main(&args) < 0 ? -1 : 0;
+	}
+
 	if (args.mode == MODE_CLEAN) {
 		/* cleanup will be done from a single thread */
 		args.num_processes = 1;
@@ -2270,7 +2313,7 @@ int main(int argc, char* argv[]) {
 			/* no stats needed for clean mode */
 			exit(0);
 		}
-		stats_process_main(&args, stats, &shm->throttle_factor, &shm->signal, &shm->stopcount, &pid_main);
+		stats_process_main(&args, stats, &shm->throttle_factor, &shm->signal, &shm->stopcount);
 		exit(0);
 	}
 
@@ -10,6 +10,7 @@
 #include <pthread.h>
 #include <sys/types.h>
 #include <stdbool.h>
+#include "utils.h"
 #if defined(__linux__)
 #include <linux/limits.h>
 #elif defined(__APPLE__)
@@ -27,14 +28,13 @@
 #define MODE_CLEAN 0
 #define MODE_BUILD 1
 #define MODE_RUN 2
+#define MODE_REPORT 3
 
 #define FDB_SUCCESS 0
 #define FDB_ERROR_RETRY -1
 #define FDB_ERROR_ABORT -2
 #define FDB_ERROR_CONFLICT -3
 
-#define LAT_BLOCK_SIZE 511 /* size of each block to get detailed latency for each operation */
-
 /* transaction specification */
 enum Operations {
 	OP_GETREADVERSION,
@@ -78,16 +78,20 @@ enum Arguments {
 	ARG_TXNTRACE,
 	ARG_TXNTAGGING,
 	ARG_TXNTAGGINGPREFIX,
-	ARG_STREAMING_MODE
+	ARG_STREAMING_MODE,
+	ARG_ARRIVAL,
+	ARG_HISTOGRAM
 };
 
 enum TPSChangeTypes { TPS_SIN, TPS_SQUARE, TPS_PULSE };
 
+/* closed loop runs each transaction as soon as the previous one finishes,
+ * the others schedule transactions at the target TPS whether or not earlier ones have finished */
+enum ArrivalTypes { ARRIVAL_CLOSED, ARRIVAL_FIXED, ARRIVAL_POISSON };
+
 #define KEYPREFIX "mako"
 #define KEYPREFIXLEN 4
 
-#define TEMP_DATA_STORE "/tmp/makoTemp"
-
 /* we set mako_txnspec_t and mako_args_t only once in the master process,
  * and won't be touched by child processes.
  */
@@ -131,6 +135,10 @@ typedef struct {
 	int txntagging;
 	char txntagging_prefix[TAGPREFIXLENGTH_MAX];
 	FDBStreamingMode streaming_mode;
+	int arrival;
+	char histogram_file[PATH_MAX]; /* where to save the latency histograms for merging with other runs */
+	char** report_files; /* histogram files to merge in report mode */
+	int num_report_files;
 } mako_args_t;
 
 /* shared memory */
@@ -145,12 +153,6 @@ typedef struct {
 	int stopcount;
 } mako_shmhdr_t;
 
-/* memory block allocated to each operation when collecting detailed latency */
-typedef struct {
-	uint64_t data[LAT_BLOCK_SIZE];
-	void* next_block;
-} lat_block_t;
-
 typedef struct {
 	uint64_t xacts;
 	uint64_t conflicts;
@@ -160,6 +162,7 @@ typedef struct {
 	uint64_t latency_us_total[MAX_OP];
 	uint64_t latency_us_min[MAX_OP];
 	uint64_t latency_us_max[MAX_OP];
+	uint64_t latency_hist[MAX_OP][LAT_HIST_BUCKETS];
 } mako_stats_t;
 
 /* per-process information */
@@ -174,10 +177,6 @@ typedef struct {
 /* args for threads */
 typedef struct {
 	int thread_id;
-	int elem_size[MAX_OP]; /* stores the multiple of LAT_BLOCK_SIZE to check the memory allocation of each operation */
-	bool is_memory_allocated[MAX_OP]; /* flag specified for each operation, whether the memory was allocated to that
-	                                     specific operation */
-	lat_block_t* block[MAX_OP];
 	process_info_t* process;
 } thread_args_t;
 
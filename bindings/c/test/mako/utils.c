@@ -132,3 +132,43 @@ int compare(const void* a, const void* b) {
 void quick_sort(uint64_t* arr, int n) {
 	qsort(arr, n, sizeof(uint64_t), compare);
 }
+
+/* return the bucket counting value */
+int lat_hist_bucket(uint64_t value) {
+	int msb, shift;
+	if (value < LAT_HIST_SUB_BUCKETS) return (int)value;
+	if (value >> LAT_HIST_MAX_BITS) return LAT_HIST_BUCKETS - 1;
+	msb = 63 - __builtin_clzll(value);
+	shift = msb - LAT_HIST_SUB_BUCKET_BITS + 1;
+	/* value >> shift is in [LAT_HIST_SUB_BUCKETS/2, LAT_HIST_SUB_BUCKETS) */
+	return LAT_HIST_SUB_BUCKETS + (shift - 1) * (LAT_HIST_SUB_BUCKETS / 2) +
+	       (int)(value >> shift) - LAT_HIST_SUB_BUCKETS / 2;
+}
+
+/* return the largest value counted in bucket */
+uint64_t lat_hist_bucket_value(int bucket) {
+	int shift;
+	uint64_t sub;
+	if (bucket < LAT_HIST_SUB_BUCKETS) return (uint64_t)bucket;
+	shift = (bucket - LAT_HIST_SUB_BUCKETS) / (LAT_HIST_SUB_BUCKETS / 2) + 1;
+	sub = (bucket - LAT_HIST_SUB_BUCKETS) % (LAT_HIST_SUB_BUCKETS / 2) + LAT_HIST_SUB_BUCKETS / 2;
+	return ((sub + 1) << shift) - 1;
+}
+
+/* return the value below which the fraction pct of the samples in the histogram fall, or 0 if it is empty */
+uint64_t lat_hist_percentile(const uint64_t* counts, double pct) {
+	int i;
+	uint64_t total = 0;
+	uint64_t rank, seen = 0;
+	for (i = 0; i < LAT_HIST_BUCKETS; i++) {
+		total += counts[i];
+	}
+	if (total == 0) return 0;
+	rank = (uint64_t)ceil(pct * total);
+	if (rank < 1) rank = 1;
+	for (i = 0; i < LAT_HIST_BUCKETS; i++) {
+		seen += counts[i];
+		if (seen >= rank) return lat_hist_bucket_value(i);
+	}
+	return lat_hist_bucket_value(LAT_HIST_BUCKETS - 1);
+}
@@ -57,6 +57,25 @@ void bucket_data(uint64_t arr[], int n, uint64_t exp);
 uint64_t get_max(uint64_t arr[], int n);
 #endif
 
+/* latency histogram, in the style of HdrHistogram: values below LAT_HIST_SUB_BUCKETS are counted exactly, and
+ * larger ones in buckets whose width is a power of two and at most 1/(LAT_HIST_SUB_BUCKETS/2) of their value, so
+ * percentiles are within about 3% at any scale. Histograms merge by adding their counts.
+ */
+#define LAT_HIST_SUB_BUCKET_BITS 6
+#define LAT_HIST_SUB_BUCKETS (1 << LAT_HIST_SUB_BUCKET_BITS)
+#define LAT_HIST_MAX_BITS 40 /* larger values are counted in the last bucket */
+#define LAT_HIST_BUCKETS                                                                                               \
+	(LAT_HIST_SUB_BUCKETS + (LAT_HIST_MAX_BITS - LAT_HIST_SUB_BUCKET_BITS) * (LAT_HIST_SUB_BUCKETS / 2))
+
+/* return the bucket counting value */
+int lat_hist_bucket(uint64_t value);
+
+/* return the largest value counted in bucket */
+uint64_t lat_hist_bucket_value(int bucket);
+
+/* return the value below which the fraction pct of the samples in the histogram fall, or 0 if it is empty */
+uint64_t lat_hist_percentile(const uint64_t* counts, double pct);
+
 // The main function is to sort arr[] of size n using Quick Sort
 void quick_sort(uint64_t arr[], int n);
 int compare(const void* a, const void* b);
@@ -92,12 +92,49 @@ void Future::cancel() {
   return fdb_future_get_keyvalue_array(future_, out_kv, out_count, out_more);
 }
 
+[[nodiscard]] fdb_error_t KeyValueArrayFuture::get_packed(uint8_t* buffer,
+                                                          int buffer_length,
+                                                          int* out_count,
+                                                          fdb_bool_t* out_more,
+                                                          int* out_length) {
+  return fdb_future_get_keyvalue_array_packed(future_, buffer, buffer_length,
+                                              out_count, out_more, out_length);
+}
+
+// KeyValueArrayBatchFuture
+
+[[nodiscard]] fdb_error_t KeyValueArrayBatchFuture::get(
+    int index, const FDBKeyValue** out_kv, int* out_count,
+    fdb_bool_t* out_more) {
+  return fdb_future_get_keyvalue_array_batch(future_, index, out_kv, out_count,
+                                             out_more);
+}
+
+// RangeAggregateFuture
+
+[[nodiscard]] fdb_error_t RangeAggregateFuture::get(
+    FDBRangeAggregate* out_aggregate) {
+  return fdb_future_get_range_aggregate(future_, out_aggregate);
+}
+
+[[nodiscard]] fdb_error_t ChangeFeedFuture::get(
+    const FDBChangeFeedMutation** out_mutations, int* out_count) {
+  return fdb_future_get_change_feed_mutations(future_, out_mutations, out_count);
+}
+
 // Database
 Int64Future Database::reboot_worker(FDBDatabase* db, const uint8_t* address, int address_length, fdb_bool_t check,
                                    int duration) {
 	return Int64Future(fdb_database_reboot_worker(db, address, address_length, check, duration));
 }
 
+ChangeFeedFuture Database::read_change_feed(FDBDatabase* db, std::string_view begin_key, std::string_view end_key,
+                                            int64_t begin_version, int64_t end_version) {
+	return ChangeFeedFuture(fdb_database_read_change_feed(db, (const uint8_t*)begin_key.data(), begin_key.size(),
+	                                                      (const uint8_t*)end_key.data(), end_key.size(), begin_version,
+	                                                      end_version));
+}
+
 // Transaction
 
 Transaction::Transaction(FDBDatabase* db) {
@@ -183,6 +220,46 @@ KeyValueArrayFuture Transaction::get_range(const uint8_t* begin_key_name,
                                                        snapshot, reverse));
 }
 
+KeyValueArrayFuture Transaction::get_multi(const std::vector<std::string>& keys,
+                                           fdb_bool_t snapshot) {
+  std::vector<FDBKey> fdb_keys;
+  for (const auto& key : keys) {
+    fdb_keys.push_back({ (const uint8_t*)key.data(), (int)key.size() });
+  }
+  return KeyValueArrayFuture(fdb_transaction_get_multi(tr_, fdb_keys.data(),
+                                                       fdb_keys.size(),
+                                                       snapshot));
+}
+
+KeyValueArrayBatchFuture Transaction::get_batch(
+    const std::vector<std::string>& keys,
+    const std::vector<std::tuple<std::string, std::string, int>>& ranges,
+    fdb_bool_t snapshot) {
+  std::vector<FDBKey> fdb_keys;
+  for (const auto& key : keys) {
+    fdb_keys.push_back({ (const uint8_t*)key.data(), (int)key.size() });
+  }
+  std::vector<FDBKey> begin_keys;
+  std::vector<FDBKey> end_keys;
+  std::vector<int> limits;
+  for (const auto& [begin, end, limit] : ranges) {
+    begin_keys.push_back({ (const uint8_t*)begin.data(), (int)begin.size() });
+    end_keys.push_back({ (const uint8_t*)end.data(), (int)end.size() });
+    limits.push_back(limit);
+  }
+  return KeyValueArrayBatchFuture(fdb_transaction_get_batch(
+      tr_, fdb_keys.data(), fdb_keys.size(), begin_keys.data(),
+      end_keys.data(), limits.data(), limits.size(), snapshot));
+}
+
+RangeAggregateFuture Transaction::get_range_aggregate(std::string_view begin_key,
+                                                      std::string_view end_key,
+                                                      fdb_bool_t snapshot) {
+  return RangeAggregateFuture(fdb_transaction_get_range_aggregate(
+      tr_, (const uint8_t*)begin_key.data(), begin_key.size(),
+      (const uint8_t*)end_key.data(), end_key.size(), snapshot));
+}
+
 EmptyFuture Transaction::watch(std::string_view key) {
   return EmptyFuture(fdb_transaction_watch(tr_, (const uint8_t*)key.data(), key.size()));
 }
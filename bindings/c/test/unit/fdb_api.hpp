@@ -44,6 +44,8 @@
 
 #include <string>
 #include <string_view>
+#include <tuple>
+#include <vector>
 
 namespace fdb {
 
@@ -135,11 +137,45 @@ class KeyValueArrayFuture : public Future {
   fdb_error_t get(const FDBKeyValue** out_kv, int* out_count,
                   fdb_bool_t* out_more);
 
+  // Calls fdb_future_get_keyvalue_array_packed.
+  fdb_error_t get_packed(uint8_t* buffer, int buffer_length, int* out_count,
+                         fdb_bool_t* out_more, int* out_length);
+
  private:
   friend class Transaction;
   KeyValueArrayFuture(FDBFuture* f) : Future(f) {}
 };
 
+class KeyValueArrayBatchFuture : public Future {
+ public:
+  // Calls fdb_future_get_keyvalue_array_batch for the result at index.
+  fdb_error_t get(int index, const FDBKeyValue** out_kv, int* out_count,
+                  fdb_bool_t* out_more);
+
+ private:
+  friend class Transaction;
+  KeyValueArrayBatchFuture(FDBFuture* f) : Future(f) {}
+};
+
+class RangeAggregateFuture : public Future {
+ public:
+  // Calls fdb_future_get_range_aggregate.
+  fdb_error_t get(FDBRangeAggregate* out_aggregate);
+
+ private:
+  friend class Transaction;
+  RangeAggregateFuture(FDBFuture* f) : Future(f) {}
+};
+
+class ChangeFeedFuture : public Future {
+ public:
+  // Calls fdb_future_get_change_feed_mutations.
+  fdb_error_t get(const FDBChangeFeedMutation** out_mutations, int* out_count);
+
+ private:
+  friend class Database;
+  ChangeFeedFuture(FDBFuture* f) : Future(f) {}
+};
 
 class EmptyFuture : public Future {
  private:
@@ -152,6 +188,8 @@ class Database final {
 public:
 	static Int64Future reboot_worker(FDBDatabase* db, const uint8_t* address, int address_length, fdb_bool_t check,
 	                                int duration);
+	static ChangeFeedFuture read_change_feed(FDBDatabase* db, std::string_view begin_key, std::string_view end_key,
+	                                         int64_t begin_version, int64_t end_version);
 };
 
 // Wrapper around FDBTransaction, providing the same set of calls as the C API.
@@ -208,6 +246,23 @@ class Transaction final {
                                 FDBStreamingMode mode, int iteration,
                                 fdb_bool_t snapshot, fdb_bool_t reverse);
 
+  // Returns a future which will be set to an FDBKeyValue array holding the
+  // given keys that are present, in order.
+  KeyValueArrayFuture get_multi(const std::vector<std::string>& keys,
+                                fdb_bool_t snapshot);
+
+  // Wrapper around fdb_transaction_get_batch. Each range is given as its
+  // begin key, end key and limit.
+  KeyValueArrayBatchFuture get_batch(
+      const std::vector<std::string>& keys,
+      const std::vector<std::tuple<std::string, std::string, int>>& ranges,
+      fdb_bool_t snapshot);
+
+  // Wrapper around fdb_transaction_get_range_aggregate.
+  RangeAggregateFuture get_range_aggregate(std::string_view begin_key,
+                                           std::string_view end_key,
+                                           fdb_bool_t snapshot);
+
   // Wrapper around fdb_transaction_watch. Returns a future representing an
   // empty value.
   EmptyFuture watch(std::string_view key);
@@ -474,6 +474,205 @@ TEST_CASE("fdb_future_get_keyvalue_array") {
   }
 }
 
+TEST_CASE("fdb_future_get_keyvalue_array_packed") {
+  std::map<std::string, std::string> data =
+      create_data({ { "a", "1" }, { "b", "2" }, { "c", "3" }, { "d", "4" } });
+  insert_data(db, data);
+
+  fdb::Transaction tr(db);
+  while (1) {
+    fdb::KeyValueArrayFuture f1 = tr.get_range(
+        FDB_KEYSEL_FIRST_GREATER_OR_EQUAL(
+          (const uint8_t *)key("a").c_str(),
+          key("a").size()
+        ),
+        FDB_KEYSEL_FIRST_GREATER_THAN(
+          (const uint8_t *)key("d").c_str(),
+          key("d").size()
+        ), /* limit */ 0, /* target_bytes */ 0,
+        /* FDBStreamingMode */ FDB_STREAMING_MODE_WANT_ALL, /* iteration */ 0,
+        /* snapshot */ false, /* reverse */ 0);
+
+    fdb_error_t err = wait_future(f1);
+    if (err) {
+      fdb::EmptyFuture f2 = tr.on_error(err);
+      fdb_check(wait_future(f2));
+      continue;
+    }
+
+    FDBKeyValue const *out_kv;
+    int kv_count;
+    int kv_more;
+    fdb_check(f1.get(&out_kv, &kv_count, &kv_more));
+    REQUIRE(kv_count == 4);
+
+    // Every pair is the two lengths, the key and the value
+    int pair_length = 2 * sizeof(int) + key("a").size() + 1;
+    std::vector<uint8_t> buffer(4 * pair_length);
+    int out_count;
+    int out_more;
+    int out_length;
+    fdb_check(f1.get_packed(buffer.data(), buffer.size(), &out_count, &out_more, &out_length));
+    CHECK(out_count == 4);
+    CHECK(out_more == kv_more);
+    CHECK(out_length == 4 * pair_length);
+
+    int offset = 0;
+    for (int i = 0; i < out_count; ++i) {
+      int key_length, value_length;
+      memcpy(&key_length, buffer.data() + offset, sizeof(int));
+      memcpy(&value_length, buffer.data() + offset + sizeof(int), sizeof(int));
+      offset += 2 * sizeof(int);
+      std::string k((const char *)buffer.data() + offset, key_length);
+      offset += key_length;
+      std::string v((const char *)buffer.data() + offset, value_length);
+      offset += value_length;
+
+      CHECK(k == std::string((const char *)out_kv[i].key, out_kv[i].key_length));
+      CHECK(data[k].compare(v) == 0);
+    }
+
+    // A buffer short of the last pair gets the others, and reports that there is more
+    fdb_check(f1.get_packed(buffer.data(), buffer.size() - 1, &out_count, &out_more, &out_length));
+    CHECK(out_count == 3);
+    CHECK(out_more);
+    CHECK(out_length == 3 * pair_length);
+    break;
+  }
+}
+
+TEST_CASE("fdb_transaction_get_multi") {
+  std::map<std::string, std::string> data =
+      create_data({ { "a", "1" }, { "b", "2" }, { "c", "3" } });
+  insert_data(db, data);
+
+  fdb::Transaction tr(db);
+  while (1) {
+    fdb::KeyValueArrayFuture f1 =
+        tr.get_multi({ key("c"), key("missing"), key("a"), key("b") },
+                     /* snapshot */ false);
+
+    fdb_error_t err = wait_future(f1);
+    if (err) {
+      fdb::EmptyFuture f2 = tr.on_error(err);
+      fdb_check(wait_future(f2));
+      continue;
+    }
+
+    FDBKeyValue const *out_kv;
+    int out_count;
+    int out_more;
+    fdb_check(f1.get(&out_kv, &out_count, &out_more));
+
+    // Missing keys are left out and the rest keep the order they were asked for
+    std::vector<std::string> expected = { key("c"), key("a"), key("b") };
+    CHECK(out_count == (int)expected.size());
+    for (int i = 0; i < out_count; ++i) {
+      std::string k((const char *)out_kv[i].key, out_kv[i].key_length);
+      std::string v((const char *)out_kv[i].value, out_kv[i].value_length);
+      CHECK(k == expected[i]);
+      CHECK(data[k] == v);
+    }
+    break;
+  }
+}
+
+TEST_CASE("fdb_transaction_get_batch") {
+  std::map<std::string, std::string> data = create_data(
+      { { "a", "1" }, { "b", "2" }, { "c", "3" }, { "d", "4" }, { "e", "5" } });
+  insert_data(db, data);
+
+  fdb::Transaction tr(db);
+  while (1) {
+    fdb::KeyValueArrayBatchFuture f1 = tr.get_batch(
+        { key("c"), key("missing") },
+        { { key("a"), key("c"), 0 }, { key("b"), key("f"), 2 } },
+        /* snapshot */ false);
+
+    fdb_error_t err = wait_future(f1);
+    if (err) {
+      fdb::EmptyFuture f2 = tr.on_error(err);
+      fdb_check(wait_future(f2));
+      continue;
+    }
+
+    // One result for each key, then one for each range
+    std::vector<std::vector<std::string>> expected = {
+      { key("c") }, {}, { key("a"), key("b") }, { key("b"), key("c") }
+    };
+    for (int i = 0; i < (int)expected.size(); ++i) {
+      FDBKeyValue const *out_kv;
+      int out_count;
+      int out_more;
+      fdb_check(f1.get(i, &out_kv, &out_count, &out_more));
+      CHECK(out_count == (int)expected[i].size());
+      for (int j = 0; j < out_count; ++j) {
+        std::string k((const char *)out_kv[j].key, out_kv[j].key_length);
+        std::string v((const char *)out_kv[j].value, out_kv[j].value_length);
+        CHECK(k == expected[i][j]);
+        CHECK(data[k] == v);
+      }
+      CHECK(out_more == (i == 3));
+    }
+
+    FDBKeyValue const *out_kv;
+    int out_count;
+    int out_more;
+    CHECK(f1.get(expected.size(), &out_kv, &out_count, &out_more) ==
+          2000); // client_invalid_operation
+    break;
+  }
+}
+
+TEST_CASE("fdb_transaction_get_range_aggregate") {
+  std::map<std::string, std::string> data = create_data(
+      { { "a", "\x01" }, { "b", "\x02\x01" }, { "c", "\x03" } });
+  insert_data(db, data);
+
+  fdb::Transaction tr(db);
+  while (1) {
+    fdb::RangeAggregateFuture f1 =
+        tr.get_range_aggregate(key("a"), key("c"), /* snapshot */ false);
+
+    fdb_error_t err = wait_future(f1);
+    if (err) {
+      fdb::EmptyFuture f2 = tr.on_error(err);
+      fdb_check(wait_future(f2));
+      continue;
+    }
+
+    FDBRangeAggregate out;
+    fdb_check(f1.get(&out));
+    CHECK(out.count == 2);
+    CHECK(out.bytes == (int64_t)(key("a").size() + 1 + key("b").size() + 2));
+    CHECK(out.sum == 1 + 0x0102);
+    CHECK(std::string((const char *)out.first_key, out.first_key_length) ==
+          key("a"));
+    CHECK(std::string((const char *)out.last_key, out.last_key_length) ==
+          key("b"));
+
+    // The transaction's own writes are included
+    tr.set(key("b"), "\x05");
+    tr.clear(key("c"));
+    fdb::RangeAggregateFuture f3 =
+        tr.get_range_aggregate(key("a"), key("d"), /* snapshot */ false);
+
+    err = wait_future(f3);
+    if (err) {
+      fdb::EmptyFuture f4 = tr.on_error(err);
+      fdb_check(wait_future(f4));
+      continue;
+    }
+
+    fdb_check(f3.get(&out));
+    CHECK(out.count == 2);
+    CHECK(out.sum == 1 + 5);
+    CHECK(std::string((const char *)out.last_key, out.last_key_length) ==
+          key("b"));
+    break;
+  }
+}
+
 TEST_CASE("cannot read system key") {
   fdb::Transaction tr(db);
 
@@ -1519,6 +1718,51 @@ TEST_CASE("fdb_transaction_get_committed_version") {
   }
 }
 
+TEST_CASE("fdb_database_read_change_feed") {
+  fdb::Transaction tr(db);
+  int64_t version;
+  while (1) {
+    tr.set(key("feed/a"), "1");
+    tr.set(key("outside"), "2");
+    tr.clear_range(key("feed/b"), key("feed/c"));
+    fdb::EmptyFuture f1 = tr.commit();
+
+    fdb_error_t err = wait_future(f1);
+    if (err) {
+      fdb::EmptyFuture f2 = tr.on_error(err);
+      fdb_check(wait_future(f2));
+      continue;
+    }
+    fdb_check(tr.get_committed_version(&version));
+    break;
+  }
+
+  fdb::ChangeFeedFuture f3 = fdb::Database::read_change_feed(
+      db, key("feed/"), key("feed0"), version, version + 1);
+  fdb_check(wait_future(f3));
+
+  const FDBChangeFeedMutation *out_mutations;
+  int out_count;
+  fdb_check(f3.get(&out_mutations, &out_count));
+  REQUIRE(out_count == 2);
+  CHECK(out_mutations[0].version == version);
+  CHECK(out_mutations[0].type == 0);
+  CHECK(std::string((const char *)out_mutations[0].param1,
+                    out_mutations[0].param1_length) == key("feed/a"));
+  CHECK(std::string((const char *)out_mutations[0].param2,
+                    out_mutations[0].param2_length) == "1");
+  CHECK(out_mutations[1].type == 1);
+  CHECK(std::string((const char *)out_mutations[1].param1,
+                    out_mutations[1].param1_length) == key("feed/b"));
+
+  // The feed has nothing past the end version
+  fdb::ChangeFeedFuture f4 = fdb::Database::read_change_feed(
+      db, key("feed/"), key("feed0"), version + 1, version + 1);
+  fdb_check(wait_future(f4));
+  fdb_check(f4.get(&out_mutations, &out_count));
+  CHECK(out_count == 0);
+}
+
 TEST_CASE("fdb_transaction_get_approximate_size") {
   fdb::Transaction tr(db);
   while (1) {
@@ -35,9 +35,14 @@ namespace FDB {
 	const Subspace DirectoryLayer::DEFAULT_CONTENT_SUBSPACE = Subspace();
 	const StringRef DirectoryLayer::PARTITION_LAYER = LiteralStringRef("partition");
 
-	DirectoryLayer::DirectoryLayer(Subspace nodeSubspace, Subspace contentSubspace, bool allowManualPrefixes) :
+	const StringRef DirectoryLayer::METADATA_VERSION_KEY = LiteralStringRef("\xff/metadataVersion");
+	const StringRef DirectoryLayer::METADATA_VERSION_REQUIRED_VALUE = LiteralStringRef("\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00");
+	const size_t DirectoryLayer::MAX_CACHED_NODES = 10000;
+
+	DirectoryLayer::DirectoryLayer(Subspace nodeSubspace, Subspace contentSubspace, bool allowManualPrefixes, bool useMetadataVersionCache) :
 		nodeSubspace(nodeSubspace), contentSubspace(contentSubspace), allowManualPrefixes(allowManualPrefixes),
-		rootNode(nodeSubspace.get(nodeSubspace.key())), allocator(rootNode.get(HIGH_CONTENTION_KEY))
+		useMetadataVersionCache(useMetadataVersionCache), rootNode(nodeSubspace.get(nodeSubspace.key())),
+		allocator(rootNode.get(HIGH_CONTENTION_KEY))
 	{ }
 
 	Subspace DirectoryLayer::nodeWithPrefix(StringRef const& prefix) const {
@@ -53,9 +58,71 @@ namespace FDB {
 		return nodeWithPrefix(prefix.get());
 	}
 
+	Optional<DirectoryLayer::Node> DirectoryLayer::getCachedNode(Optional<Standalone<StringRef>> const& metadataVersion, Path const& targetPath) {
+		if(!metadataVersion.present() || metadataVersion.get() != cacheMetadataVersion) {
+			return Optional<Node>();
+		}
+
+		auto it = nodeCache.find(targetPath);
+		if(it == nodeCache.end()) {
+			return Optional<Node>();
+		}
+
+		Node node(Reference<DirectoryLayer>::addRef(this), it->second.subspace, it->second.path, targetPath);
+		node.layer = it->second.layer;
+		node.loadedMetadata = true;
+		return node;
+	}
+
+	void DirectoryLayer::cacheNode(Optional<Standalone<StringRef>> const& metadataVersion, Node const& node) {
+		if(!metadataVersion.present() || !node.exists()) {
+			return;
+		}
+
+		if(metadataVersion.get() != cacheMetadataVersion || nodeCache.size() >= MAX_CACHED_NODES) {
+			nodeCache.clear();
+			cacheMetadataVersion = metadataVersion.get();
+		}
+		nodeCache[node.targetPath] = CachedNode{ node.subspace, node.path, node.layer };
+	}
+
+	// Makes every transaction that reads the metadata version after this one commits miss the node cache
+	void DirectoryLayer::updateMetadataVersion(Reference<Transaction> const& tr) const {
+		if(useMetadataVersionCache) {
+			tr->atomicOp(METADATA_VERSION_KEY, METADATA_VERSION_REQUIRED_VALUE, FDB_MUTATION_TYPE_SET_VERSIONSTAMPED_VALUE);
+		}
+	}
+
+	// Returns the metadata version read by the transaction, or nothing if the transaction has changed it and so cannot
+	// read it.  The metadata version comes with the read version, so reading it does not go to a storage server.
+	ACTOR Future<Optional<Standalone<StringRef>>> getMetadataVersion(Reference<Transaction> tr) {
+		try {
+			Optional<FDBStandalone<ValueRef>> version = wait(tr->get(DirectoryLayer::METADATA_VERSION_KEY));
+			// A metadata version that has never been set is cached as an empty one
+			return version.present() ? Standalone<StringRef>(version.get()) : Standalone<StringRef>();
+		}
+		catch(Error& e) {
+			if(e.code() != error_code_accessed_unreadable) {
+				throw;
+			}
+			return Optional<Standalone<StringRef>>();
+		}
+	}
+
 	ACTOR Future<DirectoryLayer::Node> find(Reference<DirectoryLayer> dirLayer, Reference<Transaction> tr, IDirectory::Path path) {
 		state int pathIndex = 0;
 		state DirectoryLayer::Node node = DirectoryLayer::Node(dirLayer, dirLayer->rootNode, IDirectory::Path(), path);
+		state Optional<Standalone<StringRef>> metadataVersion;
+
+		if(dirLayer->useMetadataVersionCache) {
+			Optional<Standalone<StringRef>> version = wait(getMetadataVersion(tr));
+			metadataVersion = version;
+
+			Optional<DirectoryLayer::Node> cached = dirLayer->getCachedNode(metadataVersion, path);
+			if(cached.present()) {
+				return cached.get();
+			}
+		}
 
 		for(; pathIndex != path.size(); ++pathIndex) {
 			ASSERT(node.subspace.present());
@@ -68,7 +135,7 @@ namespace FDB {
 			node = _node;
 
 			if(!node.exists() || node.layer == DirectoryLayer::PARTITION_LAYER) {
-				return node;
+				break;
 			}
 		}
 
@@ -77,6 +144,10 @@ namespace FDB {
 			node = _node;
 		}
 
+		if(dirLayer->useMetadataVersionCache) {
+			dirLayer->cacheNode(metadataVersion, node);
+		}
+
 		return node;
 	}
 
@@ -150,8 +221,15 @@ namespace FDB {
 
 	ACTOR Future<Standalone<StringRef>> getPrefix(Reference<DirectoryLayer> dirLayer, Reference<Transaction> tr, Optional<Standalone<StringRef>> prefix) {
 		if(!prefix.present()) {
-			Standalone<StringRef> allocated = wait(dirLayer->allocator.allocate(tr));
-			state Standalone<StringRef> finalPrefix = allocated.withPrefix(dirLayer->contentSubspace.key());
+			state Standalone<StringRef> finalPrefix;
+			if(!dirLayer->prefixPool.empty()) {
+				finalPrefix = dirLayer->prefixPool.back().withPrefix(dirLayer->contentSubspace.key());
+				dirLayer->prefixPool.pop_back();
+			}
+			else {
+				Standalone<StringRef> allocated = wait(dirLayer->allocator.allocate(tr));
+				finalPrefix = allocated.withPrefix(dirLayer->contentSubspace.key());
+			}
 
 			FDBStandalone<RangeResultRef> result = wait(tr->getRange(KeyRangeRef(finalPrefix, strinc(finalPrefix)), 1));
 
@@ -165,6 +243,32 @@ namespace FDB {
 		return prefix.get();
 	}
 
+	ACTOR Future<Void> reservePrefixesInternal(Reference<DirectoryLayer> dirLayer, Reference<Database> db, int count) {
+		state Reference<Transaction> tr = db->createTransaction();
+		state Standalone<VectorRef<StringRef>> allocated;
+
+		loop {
+			try {
+				Standalone<VectorRef<StringRef>> prefixes = wait(dirLayer->allocator.allocateBatch(tr, count));
+				allocated = prefixes;
+				wait(tr->commit());
+				break;
+			}
+			catch(Error& e) {
+				wait(tr->onError(e));
+			}
+		}
+
+		for(const auto& prefix : allocated) {
+			dirLayer->prefixPool.push_back(Standalone<StringRef>(prefix, allocated.arena()));
+		}
+		return Void();
+	}
+
+	Future<Void> DirectoryLayer::reservePrefixes(Reference<Database> const& db, int count) {
+		return reservePrefixesInternal(Reference<DirectoryLayer>::addRef(this), db, count);
+	}
+
 	ACTOR Future<Optional<Subspace>> nodeContainingKey(Reference<DirectoryLayer> dirLayer, Reference<Transaction> tr, Standalone<StringRef> key, bool snapshot) {
 		if(key.startsWith(dirLayer->nodeSubspace.key())) {
 			return dirLayer->rootNode;
@@ -230,6 +334,7 @@ namespace FDB {
 
 		tr->set(parentNode.get(DirectoryLayer::SUB_DIR_KEY).get(path.back(), true).key(), newPrefix);
 		tr->set(node.get(DirectoryLayer::LAYER_KEY).key(), layer);
+		dirLayer->updateMetadataVersion(tr);
 		return dirLayer->contentsOfNode(node, path, layer);
 	}
 
@@ -387,6 +492,7 @@ namespace FDB {
 
 		tr->set(parentNode.subspace.get().get(DirectoryLayer::SUB_DIR_KEY).get(newPath.back(), true).key(), dirLayer->nodeSubspace.unpack(oldNode.subspace.get().key()).getString(0));
 		wait(removeFromParent(dirLayer, tr, oldPath));
+		dirLayer->updateMetadataVersion(tr);
 
 		return dirLayer->contentsOfNode(oldNode.subspace.get(), newPath, oldNode.layer);
 	}
@@ -460,6 +566,7 @@ namespace FDB {
 		futures.push_back(removeFromParent(dirLayer, tr, path));
 
 		wait(waitForAll(futures));
+		dirLayer->updateMetadataVersion(tr);
 
 		return true;
 	}
@@ -23,6 +23,8 @@
 
 #pragma once
 
+#include <map>
+
 #include "IDirectory.h"
 #include "DirectorySubspace.h"
 #include "HighContentionAllocator.h"
@@ -30,7 +32,11 @@
 namespace FDB {
 	class DirectoryLayer : public IDirectory {
 	public:
-		DirectoryLayer(Subspace nodeSubspace = DEFAULT_NODE_SUBSPACE, Subspace contentSubspace = DEFAULT_CONTENT_SUBSPACE, bool allowManualPrefixes = false);
+		// With useMetadataVersionCache, directories that have been found are remembered and opened again without reading
+		// their nodes, for as long as a transaction reads the same \xff/metadataVersion.  Every change this directory
+		// layer makes updates the metadata version, so all changes to the directories must be made by directory layers
+		// that use it.
+		DirectoryLayer(Subspace nodeSubspace = DEFAULT_NODE_SUBSPACE, Subspace contentSubspace = DEFAULT_CONTENT_SUBSPACE, bool allowManualPrefixes = false, bool useMetadataVersionCache = false);
 
 		Future<Reference<DirectorySubspace>> create(Reference<Transaction> const& tr, Path const& path, Standalone<StringRef> const& layer = Standalone<StringRef>(), Optional<Standalone<StringRef>> const& prefix = Optional<Standalone<StringRef>>());
 		Future<Reference<DirectorySubspace>> open(Reference<Transaction> const& tr, Path const& path, Standalone<StringRef> const& layer = Standalone<StringRef>());
@@ -45,6 +51,11 @@ namespace FDB {
 		Future<Void> remove(Reference<Transaction> const& tr, Path const& path = Path());
 		Future<bool> removeIfExists(Reference<Transaction> const& tr, Path const& path = Path());
 
+		// Allocates count prefixes in a transaction of its own and keeps them for directories created later without a
+		// manual prefix, so that those transactions do not contend on the allocator.  Prefixes left in the pool when
+		// the directory layer is destroyed are never used.
+		Future<Void> reservePrefixes(Reference<Database> const& db, int count);
+
 		Reference<DirectoryLayer> getDirectoryLayer();
 		const Standalone<StringRef> getLayer() const;
 		const Path getPath() const;
@@ -61,6 +72,9 @@ namespace FDB {
 		static const int64_t SUB_DIR_KEY;
 		static const uint32_t VERSION[3];
 		static const StringRef DEFAULT_NODE_SUBSPACE_PREFIX;
+		static const StringRef METADATA_VERSION_KEY;
+		static const StringRef METADATA_VERSION_REQUIRED_VALUE;
+		static const size_t MAX_CACHED_NODES;
 
 		struct Node {
 			Node() {}
@@ -98,11 +112,27 @@ namespace FDB {
 
 		Path toAbsolutePath(Path const& subpath) const;
 
+		// A node found by find(), with its metadata loaded
+		struct CachedNode {
+			Optional<Subspace> subspace;
+			Path path;
+			Standalone<StringRef> layer;
+		};
+
+		// Nodes are cached by their target path at one metadata version, which is empty if it has never been set
+		Optional<Node> getCachedNode(Optional<Standalone<StringRef>> const& metadataVersion, Path const& targetPath);
+		void cacheNode(Optional<Standalone<StringRef>> const& metadataVersion, Node const& node);
+		void updateMetadataVersion(Reference<Transaction> const& tr) const;
+
 		Subspace rootNode;
 		Subspace nodeSubspace;
 		Subspace contentSubspace;
 		HighContentionAllocator allocator;
 		bool allowManualPrefixes;
+		bool useMetadataVersionCache;
+		Standalone<StringRef> cacheMetadataVersion;
+		std::map<Path, CachedNode> nodeCache;
+		std::vector<Standalone<StringRef>> prefixPool;
 
 		Path path;
 	};
@@ -18,12 +18,16 @@
  * limitations under the License.
  */
 
+#include <set>
+
 #include "HighContentionAllocator.h"
 
 namespace FDB {
-	ACTOR Future<Standalone<StringRef>> _allocate(Reference<Transaction> tr, Subspace counters, Subspace recent){
+	ACTOR Future<Standalone<VectorRef<StringRef>>> _allocate(Reference<Transaction> tr, Subspace counters, Subspace recent, int batchSize){
+		state Standalone<VectorRef<StringRef>> allocated;
 		state int64_t start = 0;
 		state int64_t window = 0;
+		state int64_t needed = 0;
 
 		loop {
 			FDBStandalone<RangeResultRef> range = wait(tr->getRange(counters.range(), 1, true, true));
@@ -41,7 +45,10 @@ namespace FDB {
 					tr->clear(KeyRangeRef(recent.key(), recent.get(start).key()));
 				}
 
-				int64_t inc = 1;
+				// A batch takes at most a quarter of a window at a time, so that it fills windows no faster than
+				// that many clients allocating one prefix each
+				needed = std::min<int64_t>(batchSize - allocated.size(), std::max<int64_t>(1, HighContentionAllocator::windowSize(start) / 4));
+				int64_t inc = needed;
 				tr->atomicOp(counters.get(start).key(), StringRef((uint8_t*)&inc, 8), FDB_MUTATION_TYPE_ADD);
 				Future<Optional<FDBStandalone<ValueRef>>> countFuture = tr->get(counters.get(start).key(), true);
 				// }
@@ -66,16 +73,26 @@ namespace FDB {
 			}
 
 			loop {
-				state int64_t candidate = deterministicRandom()->randomInt(start, start + window);
+				state std::vector<int64_t> candidates;
+				state std::vector<Future<Optional<FDBStandalone<ValueRef>>>> candidateValues;
+
+				std::set<int64_t> chosen;
+				while((int64_t)chosen.size() < needed) {
+					chosen.insert(deterministicRandom()->randomInt64(start, start + window));
+				}
+				candidates.assign(chosen.begin(), chosen.end());
+				candidateValues.clear();
 
 				// if thread safety is needed, this should be locked {
 				state Future<FDBStandalone<RangeResultRef>> latestCounter = tr->getRange(counters.range(), 1, true, true);
-				state Future<Optional<FDBStandalone<ValueRef>>> candidateValue = tr->get(recent.get(candidate).key());
-				tr->setOption(FDBTransactionOption::FDB_TR_OPTION_NEXT_WRITE_NO_WRITE_CONFLICT_RANGE);
-				tr->set(recent.get(candidate).key(), ValueRef());
+				for(int64_t candidate : candidates) {
+					candidateValues.push_back(tr->get(recent.get(candidate).key()));
+					tr->setOption(FDBTransactionOption::FDB_TR_OPTION_NEXT_WRITE_NO_WRITE_CONFLICT_RANGE);
+					tr->set(recent.get(candidate).key(), ValueRef());
+				}
 				// }
 
-				wait(success(latestCounter) && success(candidateValue));
+				wait(success(latestCounter) && waitForAll(candidateValues));
 				int64_t currentWindowStart = 0;
 				if(latestCounter.get().size() > 0) {
 					currentWindowStart = counters.unpack(latestCounter.get()[0].key).getInt(0);
@@ -85,16 +102,33 @@ namespace FDB {
 					break;
 				}
 
-				if(!candidateValue.get().present()) {
-					tr->addWriteConflictKey(recent.get(candidate).key());
-					return Tuple().append(candidate).pack();
+				for(int i = 0; i < candidates.size(); ++i) {
+					if(!candidateValues[i].get().present()) {
+						tr->addWriteConflictKey(recent.get(candidates[i]).key());
+						allocated.push_back_deep(allocated.arena(), Tuple().append(candidates[i]).pack());
+						--needed;
+					}
+				}
+
+				if(allocated.size() == batchSize) {
+					return allocated;
+				}
+				if(needed == 0) {
+					break;
 				}
 			}
 		}
 	}
 
 	Future<Standalone<StringRef>> HighContentionAllocator::allocate(Reference<Transaction> const& tr) const {
-		return _allocate(tr, counters, recent);
+		return map(_allocate(tr, counters, recent, 1), [](Standalone<VectorRef<StringRef>> const& allocated) {
+			return Standalone<StringRef>(allocated[0], allocated.arena());
+		});
+	}
+
+	Future<Standalone<VectorRef<StringRef>>> HighContentionAllocator::allocateBatch(Reference<Transaction> const& tr, int count) const {
+		ASSERT(count > 0);
+		return _allocate(tr, counters, recent, count);
 	}
 
 	int64_t HighContentionAllocator::windowSize(int64_t start) {
@@ -31,6 +31,10 @@ namespace FDB {
 		HighContentionAllocator(Subspace subspace) : counters(subspace.get(0)), recent(subspace.get(1)) {}
 		Future<Standalone<StringRef>> allocate(Reference<Transaction> const& tr) const;
 
+		// Allocates count distinct prefixes in one transaction.  Each stays reserved once the transaction commits, whether
+		// or not it is used then.
+		Future<Standalone<VectorRef<StringRef>>> allocateBatch(Reference<Transaction> const& tr, int count) const;
+
 		static int64_t windowSize(int64_t start);
 	private:
 		Subspace counters;
@@ -53,22 +53,26 @@ namespace FDB {
 		return *(double*)&big;
 	}
 
+	// Only a 0x00 byte can end a string or start an escape, so memchr skips the bytes in between
 	static size_t find_string_terminator(const StringRef data, size_t offset) {
 		size_t i = offset;
-		while (i < data.size() - 1 && !(data[i] == (uint8_t)'\x00' && data[i+1] != (uint8_t)'\xff')) {
-			i += (data[i] == '\x00' ? 2 : 1);
+		while (i < data.size() - 1) {
+			const uint8_t* z = (const uint8_t*)memchr(data.begin() + i, '\x00', data.size() - 1 - i);
+			if (!z) {
+				return data.size() - 1;
+			}
+			i = z - data.begin();
+			if (data[i+1] != (uint8_t)'\xff') {
+				return i;
+			}
+			i += 2;
 		}
 
 		return i;
 	}
 
-	static size_t find_string_terminator(const Standalone<VectorRef<unsigned char> > data, size_t offset ) {
-		size_t i = offset;
-		while (i < data.size() - 1 && !(data[i] == '\x00' && data[i+1] != (uint8_t)'\xff')) {
-			i += (data[i] == '\x00' ? 2 : 1);
-		}
-
-		return i;
+	static size_t find_string_terminator(const Standalone<VectorRef<unsigned char> >& data, size_t offset ) {
+		return find_string_terminator(StringRef(data.begin(), data.size()), offset);
 	}
 
 	// If encoding and the sign bit is 1 (the number is negative), flip all the bits.
@@ -161,17 +165,22 @@ namespace FDB {
 		const uint8_t utfChar = utf8 ? STRING_CODE : BYTES_CODE;
 		data.append(data.arena(), &utfChar, 1);
 
-		size_t lastPos = 0;
-		for(size_t pos = 0; pos < str.size(); ++pos) {
-			if(str[pos] == '\x00') {
-				data.append(data.arena(), str.begin() + lastPos, pos - lastPos);
-				data.push_back(data.arena(), (uint8_t)'\x00');
-				data.push_back(data.arena(), (uint8_t)'\xff');
-				lastPos = pos + 1;
-			}
+		// Each 0x00 byte is escaped as 0x00 0xff, so counting them first sizes the element exactly
+		int zeros = 0;
+		for(const uint8_t* z = str.begin(); (z = (const uint8_t*)memchr(z, '\x00', str.end() - z)) != nullptr; ++z) {
+			++zeros;
 		}
+		data.reserve(data.arena(), data.size() + str.size() + zeros + 1);
 
-		data.append(data.arena(), str.begin() + lastPos, str.size() - lastPos);
+		const uint8_t* lastPos = str.begin();
+		for(const uint8_t* z; zeros > 0 && (z = (const uint8_t*)memchr(lastPos, '\x00', str.end() - lastPos)) != nullptr; --zeros) {
+			data.append(data.arena(), lastPos, z - lastPos);
+			data.push_back(data.arena(), (uint8_t)'\x00');
+			data.push_back(data.arena(), (uint8_t)'\xff');
+			lastPos = z + 1;
+		}
+
+		data.append(data.arena(), lastPos, str.end() - lastPos);
 		data.push_back(data.arena(), (uint8_t)'\x00');
 
 		return *this;
@@ -332,26 +341,29 @@ namespace FDB {
 			e = data.size();
 		}
 
+		// A string without escaped 0x00 bytes is returned in place, sharing the arena of the tuple
+		const uint8_t* z = (const uint8_t*)memchr(data.begin() + b, '\x00', e - b);
+		if(!z || z == data.begin() + e - 1) {
+			return Standalone<StringRef>(StringRef(data.begin() + b, (z ? z - data.begin() : e) - b), data.arena());
+		}
+
 		Standalone<StringRef> result;
-		VectorRef<uint8_t> staging;
+		uint8_t* staging = new (result.arena()) uint8_t[e - b];
+		size_t length = 0;
 
-		for (size_t i = b; i < e; ++i) {
-			if(data[i] == '\x00') {
-				staging.append(result.arena(), data.begin() + b, i - b);
-				++i;
-				b = i + 1;
+		while(b < e) {
+			size_t i = z ? z - data.begin() : e;
+			memcpy(staging + length, data.begin() + b, i - b);
+			length += i - b;
+			b = i + 2;
 
-				if(i < e) {
-					staging.push_back(result.arena(), '\x00');
-				}
+			if(i + 1 < e) {
+				staging[length++] = '\x00';
 			}
+			z = b < e ? (const uint8_t*)memchr(data.begin() + b, '\x00', e - b) : nullptr;
 		}
 
-		if(b < e) {
-			staging.append(result.arena(), data.begin() + b, e - b);
-		}
-
-		result.StringRef::operator=(StringRef(staging.begin(), staging.size()));
+		result.StringRef::operator=(StringRef(staging, length));
 		return result;
 	}
 
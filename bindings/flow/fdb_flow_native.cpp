@@ -0,0 +1,92 @@
+/*
+ * fdb_flow_native.cpp
+ *
+ * This source file is part of the FoundationDB open source project
+ *
+ * Copyright 2013-2018 Apple Inc. and the FoundationDB project authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "fdb_flow_native.h"
+
+#include "fdbclient/CoordinationInterface.h"
+
+namespace FDB {
+	// The newest API version this client supports, as fdb_c.h's FDB_API_VERSION
+	static const int nativeAPIVersionLatest = 700;
+
+	NativeAPI* NativeAPI::instance = nullptr;
+	NativeAPI::NativeAPI(int version) : version(version) {}
+
+	NativeAPI* NativeAPI::selectAPIVersion(int apiVersion, int abiVersion) {
+		if (abiVersion != FDB_FLOW_NATIVE_ABI_VERSION) {
+			TraceEvent(SevWarnAlways, "NativeAPIVersionMismatch")
+			    .detail("ApplicationABIVersion", abiVersion)
+			    .detail("ClientABIVersion", FDB_FLOW_NATIVE_ABI_VERSION);
+			throw api_version_not_supported();
+		}
+
+		if (NativeAPI::instance) {
+			if (apiVersion != NativeAPI::instance->version) {
+				throw api_version_already_set();
+			} else {
+				return NativeAPI::instance;
+			}
+		}
+
+		if (apiVersion < 500 || apiVersion > nativeAPIVersionLatest) {
+			throw api_version_not_supported();
+		}
+
+		NativeAPI::instance = new NativeAPI(apiVersion);
+		return NativeAPI::instance;
+	}
+
+	bool NativeAPI::isAPIVersionSelected() {
+		return NativeAPI::instance != nullptr;
+	}
+
+	NativeAPI* NativeAPI::getInstance() {
+		if (NativeAPI::instance == nullptr) {
+			throw api_version_unset();
+		} else {
+			return NativeAPI::instance;
+		}
+	}
+
+	void NativeAPI::setNetworkOption(FDBNetworkOptions::Option option, Optional<StringRef> value) {
+		::setNetworkOption(option, value);
+	}
+
+	void NativeAPI::setupNetwork() {
+		::setupNetwork();
+	}
+
+	void NativeAPI::runNetwork() {
+		::runNetwork();
+	}
+
+	void NativeAPI::stopNetwork() {
+		::stopNetwork();
+	}
+
+	Database NativeAPI::createDatabase(std::string const& connFilename) {
+		auto connFile = makeReference<ClusterConnectionFile>(ClusterConnectionFile::lookupClusterFileName(connFilename).first);
+		return Database::createDatabase(connFile, version, false);
+	}
+
+	int NativeAPI::getAPIVersion() const {
+		return version;
+	}
+} // namespace FDB
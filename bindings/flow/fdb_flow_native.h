@@ -0,0 +1,63 @@
+/*
+ * fdb_flow_native.h
+ *
+ * This source file is part of the FoundationDB open source project
+ *
+ * Copyright 2013-2018 Apple Inc. and the FoundationDB project authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FDB_FLOW_FDB_FLOW_NATIVE_H
+#define FDB_FLOW_FDB_FLOW_NATIVE_H
+
+#include "fdbclient/NativeAPI.actor.h"
+#include "fdbclient/ReadYourWrites.h"
+
+// Bumped whenever a change to the client's types means that an application must be rebuilt against the new headers.
+// selectAPIVersion() refuses to run an application built against headers with a different value.
+#define FDB_FLOW_NATIVE_ABI_VERSION 1
+
+namespace FDB {
+	// The native API runs the client inside the application on the thread that calls runNetwork(), which is the
+	// thread the application's own actors run on.  They use the client's Database and ReadYourWritesTransaction
+	// directly, so an operation is a call on the same thread instead of a trip to the fdb_c network thread and back.
+	// The application must link the client statically, and must not also use API (or fdb_c) in the same process.
+	class NativeAPI {
+	public:
+		// abiVersion is left to its default, so that it is the version of the headers the application was built with
+		static NativeAPI* selectAPIVersion(int apiVersion, int abiVersion = FDB_FLOW_NATIVE_ABI_VERSION);
+		static NativeAPI* getInstance();
+		static bool isAPIVersionSelected();
+
+		void setNetworkOption(FDBNetworkOptions::Option option, Optional<StringRef> value = Optional<StringRef>());
+
+		// setupNetwork() creates g_network, after which actors can be started.  runNetwork() runs them, and every
+		// use of the databases it creates, on the calling thread until stopNetwork().
+		void setupNetwork();
+		void runNetwork();
+		void stopNetwork();
+
+		// Must be called on the network thread
+		Database createDatabase(std::string const& connFilename = "");
+
+		int getAPIVersion() const;
+
+	private:
+		static NativeAPI* instance;
+
+		NativeAPI(int version);
+		int version;
+	};
+} // namespace FDB
+#endif // FDB_FLOW_FDB_FLOW_NATIVE_H
@@ -214,7 +214,7 @@ encoded byte slices. To convert a Go type to a byte slice, see the binary
 package.
 
 The current atomic operations in this API are Add, BitAnd, BitOr, BitXor,
-CompareAndClear, Max, Min, SetVersionstampedKey, SetVersionstampedValue
-(all methods on Transaction).
+CompareAndClear, CompareAndSet, Max, Min, SetIfAbsent, SetVersionstampedKey,
+SetVersionstampedValue (all methods on Transaction).
 */
 package fdb
@@ -643,6 +643,16 @@ func (t Transaction) CompareAndClear(key KeyConvertible, param []byte) {
 	t.atomicOp(key.FDBKey(), param, 20)
 }
 
+// Performs an atomic ``set if absent`` operation. If the given key has no value in the database, it is set to the given value. Otherwise the existing value is kept.
+func (t Transaction) SetIfAbsent(key KeyConvertible, param []byte) {
+	t.atomicOp(key.FDBKey(), param, 22)
+}
+
+// Performs an atomic ``compare and set`` operation. The parameter is the expected value followed by the new value, followed by the length of the expected value as a 4-byte little-endian integer. If the existing value in the database is equal to the expected value, then it is replaced by the new value. A key with no value is never set.
+func (t Transaction) CompareAndSet(key KeyConvertible, param []byte) {
+	t.atomicOp(key.FDBKey(), param, 23)
+}
+
 type conflictRangeType int
 
 const (
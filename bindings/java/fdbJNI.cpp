@@ -692,51 +692,26 @@ JNIEXPORT void JNICALL Java_com_apple_foundationdb_FutureResults_FutureResults_1
 		return;
 	}
 
+	if (bufferCapacity < 2 * sizeof(jint)) {
+		throwRuntimeEx(jenv, "Buffer too small for range result summary");
+		return;
+	}
+
+	// The buffer holds a RangeResultSummary, i.e. [keyCount, more], followed by the pairs as
+	// [keyLength, valueLength, key, value], which is the layout fdb_future_get_keyvalue_array_packed writes
 	FDBFuture* f = (FDBFuture*)future;
-	const FDBKeyValue *kvs;
 	int count;
 	fdb_bool_t more;
-	fdb_error_t err = fdb_future_get_keyvalue_array( f, &kvs, &count, &more );
+	int length;
+	fdb_error_t err = fdb_future_get_keyvalue_array_packed(f, buffer + 2 * sizeof(jint),
+	                                                       bufferCapacity - 2 * sizeof(jint), &count, &more, &length);
 	if( err ) {
 		safeThrow( jenv, getThrowable( jenv, err ) );
 		return;
 	}
 
-	// Capacity for Metadata+Keys+Values
-	//  => sizeof(jint) for total key/value pairs
-	//  => sizeof(jint) to store more flag
-	//  => sizeof(jint) to store key length per KV pair
-	//  => sizeof(jint) to store value length per KV pair
-	int totalCapacityNeeded = 2 * sizeof(jint);
-	for(int i = 0; i < count; i++) {
-		totalCapacityNeeded += kvs[i].key_length + kvs[i].value_length + 2*sizeof(jint);
-		if (bufferCapacity < totalCapacityNeeded) {
-			count = i; /* Only fit first `i` K/V pairs */
-			more = true;
-			break;
-		}
-	}
-
-	int offset = 0;
-
-	// First copy RangeResultSummary, i.e. [keyCount, more]
-	memcpy(buffer + offset, &count, sizeof(jint));
-	offset += sizeof(jint);
-
-	memcpy(buffer + offset, &more, sizeof(jint));
-	offset += sizeof(jint);
-
-	for (int i = 0; i < count; i++) {
-		memcpy(buffer + offset, &kvs[i].key_length, sizeof(jint));
-		memcpy(buffer + offset + sizeof(jint), &kvs[i].value_length, sizeof(jint));
-		offset += 2 * sizeof(jint);
-
-		memcpy(buffer + offset, kvs[i].key, kvs[i].key_length);
-		offset += kvs[i].key_length;
-
-		memcpy(buffer + offset, kvs[i].value, kvs[i].value_length);
-		offset += kvs[i].value_length;
-	}
+	memcpy(buffer, &count, sizeof(jint));
+	memcpy(buffer + sizeof(jint), &more, sizeof(jint));
 }
 
 JNIEXPORT jlong JNICALL Java_com_apple_foundationdb_FDBTransaction_Transaction_1getEstimatedRangeSizeBytes(JNIEnv *jenv, jobject, jlong tPtr, 
@@ -321,6 +321,8 @@ else()
   check_symbol_exists(DTRACE_PROBE sys/sdt.h SUPPORT_DTRACE)
   check_symbol_exists(aligned_alloc stdlib.h HAS_ALIGNED_ALLOC)
   message(STATUS "Has aligned_alloc: ${HAS_ALIGNED_ALLOC}")
+  include(CheckIncludeFile)
+  CHECK_INCLUDE_FILE("linux/io_uring.h" HAS_IO_URING)
   if((SUPPORT_DTRACE) AND (USE_DTRACE))
     set(DTRACE_PROBES 1)
   endif()
@@ -40,6 +40,24 @@ else()
   endif()
 endif()
 
+################################################################################
+# Wire compression
+################################################################################
+
+set(DISABLE_WIRE_COMPRESSION OFF CACHE BOOL "Don't try to find zlib and always build without FlowTransport compression")
+if(DISABLE_WIRE_COMPRESSION)
+  set(WITH_WIRE_COMPRESSION OFF)
+else()
+  find_package(ZLIB)
+  if(ZLIB_FOUND)
+    set(WITH_WIRE_COMPRESSION ON)
+    add_compile_options(-DHAVE_ZLIB)
+  else()
+    message(STATUS "zlib was not found - Will compile without wire compression")
+    set(WITH_WIRE_COMPRESSION OFF)
+  endif()
+endif()
+
 ################################################################################
 # Java Bindings
 ################################################################################
@@ -151,6 +169,7 @@ function(print_components)
   message(STATUS "=========================================")
   message(STATUS "Build Java Bindings:                  ${WITH_JAVA}")
   message(STATUS "Build with TLS support:               ${WITH_TLS}")
+  message(STATUS "Build with wire compression:          ${WITH_WIRE_COMPRESSION}")
   message(STATUS "Build Go bindings:                    ${WITH_GO}")
   message(STATUS "Build Ruby bindings:                  ${WITH_RUBY}")
   message(STATUS "Build Python sdist (make package):    ${WITH_PYTHON}")
@@ -0,0 +1,151 @@
+/*
+ * BinaryParser.cs
+ *
+ * This source file is part of the FoundationDB open source project
+ *
+ * Copyright 2013-2020 Apple Inc. and the FoundationDB project authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+using System;
+using System.Collections.Generic;
+using System.IO;
+using System.Linq;
+using System.Text;
+using System.Xml.Linq;
+
+namespace Magnesium
+{
+	// Reads the trace files written by flow/BinaryTraceLogFormatter
+	public static class BinaryParser
+	{
+		static Random r = new Random();
+
+		const string header = "FDBBinaryTrace/1\n";
+
+		public static IEnumerable<Event> Parse(System.IO.Stream stream, string file,
+			bool keepOriginalElement = false, double startTime = -1, double endTime = Double.MaxValue,
+			double samplingFactor = 1.0)
+		{
+			using (var reader = new BinaryReader(stream))
+			{
+				byte[] h = reader.ReadBytes(header.Length);
+				if (Encoding.ASCII.GetString(h) != header)
+					throw new Exception(string.Format("{0} is not a binary trace file", file));
+
+				while (true)
+				{
+					long length;
+					if (!TryReadVarint(reader, out length))
+						break;
+					byte[] body = reader.ReadBytes((int)length);
+					// A file that is still being written can end in the middle of an event
+					if (body.Length < length)
+						break;
+
+					Dictionary<string, string> fields;
+					try
+					{
+						fields = ParseFields(body);
+					}
+					catch (Exception e)
+					{
+						throw new Exception(string.Format("Failed to parse binary event in {0}", file), e);
+					}
+					Event ev = ParseEvent(fields, file, keepOriginalElement, startTime, endTime, samplingFactor);
+					if (ev != null) yield return ev;
+				}
+			}
+		}
+
+		private static bool TryReadVarint(BinaryReader reader, out long value)
+		{
+			value = 0;
+			for (int shift = 0; ; shift += 7)
+			{
+				int b = reader.BaseStream.ReadByte();
+				if (b < 0)
+					return false;
+				value |= (long)(b & 0x7f) << shift;
+				if ((b & 0x80) == 0)
+					return true;
+			}
+		}
+
+		private static long ReadVarint(byte[] buffer, ref int pos)
+		{
+			long value = 0;
+			for (int shift = 0; ; shift += 7)
+			{
+				byte b = buffer[pos++];
+				value |= (long)(b & 0x7f) << shift;
+				if ((b & 0x80) == 0)
+					return value;
+			}
+		}
+
+		private static string ReadString(byte[] buffer, ref int pos)
+		{
+			int length = (int)ReadVarint(buffer, ref pos);
+			string s = Encoding.UTF8.GetString(buffer, pos, length);
+			pos += length;
+			return s;
+		}
+
+		private static Dictionary<string, string> ParseFields(byte[] body)
+		{
+			int pos = 0;
+			long count = ReadVarint(body, ref pos);
+			var fields = new Dictionary<string, string>();
+			for (long i = 0; i < count; i++)
+			{
+				string key = ReadString(body, ref pos);
+				fields[key] = ReadString(body, ref pos);
+			}
+			return fields;
+		}
+
+		private static Event ParseEvent(Dictionary<string, string> fields, string file, bool keepOriginalElement, double startTime, double endTime, double samplingFactor)
+		{
+			if (samplingFactor != 1.0 && r.NextDouble() > samplingFactor)
+				return null;
+
+			bool rolledEvent = fields.ValueOrDefault("TrackLatestType", "") == "Rolled";
+			String timeField = (rolledEvent) ? "OriginalTime" : "Time";
+			double eventTime = double.Parse(fields[timeField]);
+
+			if (eventTime < startTime || eventTime > endTime)
+				return null;
+
+			return new Event {
+				Severity = (Severity)int.Parse(fields.ValueOrDefault("Severity", "40")),
+				Type = string.Intern(fields["Type"]),
+				Time = eventTime,
+				Machine = string.Intern(fields["Machine"]),
+				ID = string.Intern(fields.ValueOrDefault("ID", "0")),
+				TraceFile = file,
+				DDetails = fields
+					.Where(a=>a.Key != "Type" && a.Key != "Time" && a.Key != "Machine" && a.Key != "ID" && a.Key != "Severity" && (!rolledEvent || a.Key != "OriginalTime"))
+					.ToDictionary(a=>string.Intern(a.Key), a=>(object)a.Value),
+				original = keepOriginalElement ? new XElement("Event", fields.Select(a=>new XAttribute(a.Key, a.Value))) : null
+			};
+		}
+
+		private static string ValueOrDefault(this Dictionary<string, string> fields, string key, string def)
+		{
+			string value;
+			return fields.TryGetValue(key, out value) ? value : def;
+		}
+	}
+}
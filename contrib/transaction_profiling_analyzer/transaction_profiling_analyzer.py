@@ -628,7 +628,8 @@ class ReadCounter(object):
         if count_this_range > 0:
             add_boundary(this_range_start_key, last_end, opened_this_range, count_this_range)
 
-        shard_finder.wait_for_shard_addresses(output_range_counts, 0, 5)
+        if shard_finder:
+            shard_finder.wait_for_shard_addresses(output_range_counts, 0, 5)
         return output_range_counts
 
 
@@ -745,7 +746,8 @@ class WriteCounter(object):
         if count_this_range > 0:
             add_boundary(start_key, k, count_this_range)
 
-        shard_finder.wait_for_shard_addresses(output_range_counts, 0, 5)
+        if shard_finder:
+            shard_finder.wait_for_shard_addresses(output_range_counts, 0, 5)
         return output_range_counts
 
     def get_total_writes(self):
@@ -771,6 +773,62 @@ class WriteCounter(object):
 
         return results
 
+class FileTransactionInfoLoader(object):
+    '''
+    Reads the profiles a client wrote with the CSI_PROFILE_SINK knob set to file:<path>, or that a UDP collector saved
+    as they arrived. Each record is
+        IIII - 4 bytes little-endian length of the transaction identifier, then the identifier
+        LLLL - 4 bytes little-endian length of the events, then the events as they would be stored in the database
+    '''
+    def __init__(self, path, full_output=True, type_filter=None, min_timestamp=None, max_timestamp=None):
+        self.path = path
+        self.full_output = full_output
+        self.type_filter = type_filter
+        self.min_timestamp = min_timestamp
+        self.max_timestamp = max_timestamp
+
+    @staticmethod
+    def start_timestamp(info):
+        events = [info.get_version, info.commit] + info.gets + info.get_ranges + info.error_gets + \
+            info.error_get_ranges + info.error_commits
+        timestamps = [e.start_timestamp for e in events if e is not None]
+        return min(timestamps) if timestamps else None
+
+    def fetch_transaction_info(self):
+        transaction_infos = 0
+        invalid_transaction_infos = 0
+        with open(self.path, 'rb') as f:
+            while True:
+                header = f.read(4)
+                if len(header) < 4:
+                    break
+                f.read(struct.unpack('<I', header)[0])
+                header = f.read(4)
+                if len(header) < 4:
+                    break
+                num_bytes = struct.unpack('<I', header)[0]
+                v = f.read(num_bytes)
+                if len(v) < num_bytes:
+                    logger.warning("Discarding a truncated record at the end of %s" % self.path)
+                    break
+
+                transaction_infos += 1
+                try:
+                    info = ClientTransactionInfo(ByteBuffer(v), full_output=self.full_output, type_filter=self.type_filter)
+                except (UnsupportedProtocolVersionError, ValueError):
+                    invalid_transaction_infos += 1
+                    continue
+
+                timestamp = self.start_timestamp(info)
+                if timestamp is not None and ((self.min_timestamp and timestamp < self.min_timestamp) or
+                                              (self.max_timestamp and timestamp > self.max_timestamp)):
+                    continue
+                if info.has_types():
+                    yield info
+
+        print("Processed %d transactions, %d invalid\n" % (transaction_infos, invalid_transaction_infos))
+
+
 def connect(cluster_file=None):
     db = fdb.open(cluster_file=cluster_file)
     return db
@@ -779,6 +837,9 @@ def connect(cluster_file=None):
 def main():
     parser = argparse.ArgumentParser(description="TransactionProfilingAnalyzer")
     parser.add_argument("-C", "--cluster-file", type=str, help="Cluster file")
+    parser.add_argument("--profile-file", type=str,
+                        help="Read the profiles from a file written by clients with CSI_PROFILE_SINK rather than from the database. "
+                             "Start and end times are optional, and shard locations are only read if --cluster-file is given.")
     parser.add_argument("--full-output", action="store_true", help="Print full output from mutations")
     parser.add_argument("--filter-get-version", action="store_true",
                         help="Include get_version type. If no filter args are given all will be returned.")
@@ -839,6 +900,8 @@ def main():
             raise Exception("Can't find dateparser needed to parse human dates")
         import dateparser
         min_timestamp = int(dateparser.parse(args.start_time).timestamp())
+    elif args.profile_file:
+        min_timestamp = None
     else:
         raise Exception("Must specify start time")
 
@@ -849,20 +912,27 @@ def main():
             raise Exception("Can't find dateparser needed to parse human dates")
         import dateparser
         max_timestamp = int(dateparser.parse(args.end_time).timestamp())
+    elif args.profile_file:
+        max_timestamp = None
     else:
         raise Exception("Must specify end time")
 
     now = time.time()
-    if max_timestamp > now:
+    if max_timestamp and max_timestamp > now:
         raise Exception("max_timestamp is %d seconds in the future" % (max_timestamp - now))
-    if min_timestamp > now:
+    if min_timestamp and min_timestamp > now:
         raise Exception("min_timestamp is %d seconds in the future" % (min_timestamp - now))
 
-    logger.info("Loading transactions from %d to %d" % (min_timestamp, max_timestamp))
-
-    db = connect(cluster_file=args.cluster_file)
-    loader = TransactionInfoLoader(db, full_output=full_output, type_filter=type_filter,
-                                   min_timestamp=min_timestamp, max_timestamp=max_timestamp)
+    if args.profile_file:
+        logger.info("Loading transactions from %s" % args.profile_file)
+        db = connect(cluster_file=args.cluster_file) if args.cluster_file else None
+        loader = FileTransactionInfoLoader(args.profile_file, full_output=full_output, type_filter=type_filter,
+                                           min_timestamp=min_timestamp, max_timestamp=max_timestamp)
+    else:
+        logger.info("Loading transactions from %d to %d" % (min_timestamp, max_timestamp))
+        db = connect(cluster_file=args.cluster_file)
+        loader = TransactionInfoLoader(db, full_output=full_output, type_filter=type_filter,
+                                       min_timestamp=min_timestamp, max_timestamp=max_timestamp)
 
     for info in loader.fetch_transaction_info():
         if info.has_types():
@@ -929,9 +999,10 @@ def main():
             else:
                 print(" %d - %d. Omitted\n" % (omit_start+1, len(range_boundaries)))
 
-    shard_finder = ShardFinder(db, args.exclude_ports)
+    shard_finder = ShardFinder(db, args.exclude_ports) if db else None
 
-    print("NOTE: shard locations are current and may not reflect where an operation was performed in the past\n")
+    if shard_finder:
+        print("NOTE: shard locations are current and may not reflect where an operation was performed in the past\n")
 
     if write_counter:
         if args.top_requests:
@@ -24,6 +24,7 @@
 #include <iostream>
 #include <cinttypes>
 #include <cstdio>
+#include <deque>
 #include <vector>
 
 #include "fdbclient/BackupAgent.actor.h"
@@ -41,6 +42,11 @@ void printConvertUsage() {
 	          << "  -b, --begin BEGIN\n"
 	          << "                  Begin version.\n"
 	          << "  -e, --end END   End version.\n"
+	          << "  --parallelism N Number of version chunks converted at once, and of blocks read ahead\n"
+	          << "                  in each log file (defaults to 4).\n"
+	          << "  --chunk_versions VERSIONS\n"
+	          << "                  Versions converted into each output file (defaults to 3600000000,\n"
+	          << "                  about an hour).\n"
 	          << "  --log           Enables trace file logging for the CLI session.\n"
 	          << "  --logdir PATH   Specifes the output directory for trace files. If\n"
 	          << "                  unspecified, defaults to the current directory. Has\n"
@@ -49,7 +55,7 @@ void printConvertUsage() {
 	          << "                  Sets the LogGroup field with the specified value for all\n"
 	          << "                  events in the trace output (defaults to `default').\n"
 	          << "  --trace_format FORMAT\n"
-	          << "                  Select the format of the trace files. xml (the default) and json are supported.\n"
+	          << "                  Select the format of the trace files. xml (the default), json and binary are supported.\n"
 	          << "                  Has no effect unless --log is specified.\n"
 	          << "  -h, --help      Display this help and exit.\n"
 	          << "\n";
@@ -97,10 +103,15 @@ struct ConvertParams {
 	std::string container_url;
 	Version begin = invalidVersion;
 	Version end = invalidVersion;
+	int parallelism = 4;
+	Version chunk_versions = 3600e6;
 	bool log_enabled = false;
 	std::string log_dir, trace_format, trace_log_group;
 
-	bool isValid() { return begin != invalidVersion && end != invalidVersion && !container_url.empty(); }
+	bool isValid() {
+		return begin != invalidVersion && end != invalidVersion && !container_url.empty() && parallelism > 0 &&
+		       chunk_versions > 0;
+	}
 
 	std::string toString() {
 		std::string s;
@@ -110,6 +121,10 @@ struct ConvertParams {
 		s.append(format("%" PRId64, begin));
 		s.append(" End:");
 		s.append(format("%" PRId64, end));
+		s.append(" Parallelism:");
+		s.append(std::to_string(parallelism));
+		s.append(" ChunkVersions:");
+		s.append(format("%" PRId64, chunk_versions));
 		if (log_enabled) {
 			if (!log_dir.empty()) {
 				s.append(" LogDir:").append(log_dir);
@@ -135,11 +150,12 @@ struct VersionedData {
 };
 
 struct MutationFilesReadProgress : public ReferenceCounted<MutationFilesReadProgress> {
-	MutationFilesReadProgress(std::vector<LogFile>& logs, Version begin, Version end)
-	  : files(logs), beginVersion(begin), endVersion(end) {}
+	MutationFilesReadProgress(const std::vector<LogFile>& logs, Version begin, Version end, int readAhead)
+	  : files(logs), beginVersion(begin), endVersion(end), readAhead(readAhead) {}
 
 	struct FileProgress : public ReferenceCounted<FileProgress> {
-		FileProgress(Reference<IAsyncFile> f, int index) : fd(f), idx(index), offset(0), eof(false) {}
+		FileProgress(Reference<IAsyncFile> f, int index, const LogFile& file, int readAhead)
+		  : fd(f), reader(f, file, readAhead), idx(index), offset(0), eof(false) {}
 
 		bool operator<(const FileProgress& rhs) const {
 			if (rhs.mutations.empty()) return true;
@@ -163,19 +179,29 @@ struct MutationFilesReadProgress : public ReferenceCounted<MutationFilesReadProg
 
 			try {
 				// Read block header
-				if (reader.consume<int32_t>() != PARTITIONED_MLOG_VERSION) throw restore_unsupported_file_version();
+				int32_t blockVersion = reader.consume<int32_t>();
+				Standalone<StringRef> records = buf;
+				if (blockVersion == PARTITIONED_MLOG_COMPRESSED_VERSION) {
+					records = fileBackup::decodeCompressedLogBlock(reader);
+				} else if (blockVersion != PARTITIONED_MLOG_VERSION) {
+					throw restore_unsupported_file_version();
+				}
+				StringRefReader recordReader = blockVersion == PARTITIONED_MLOG_VERSION
+				                                   ? reader
+				                                   : StringRefReader(records, restore_corrupted_data());
 
 				while (1) {
 					// If eof reached or first key len bytes is 0xFF then end of block was reached.
-					if (reader.eof() || *reader.rptr == 0xFF) break;
+					if (recordReader.eof() || *recordReader.rptr == 0xFF) break;
 
 					// Deserialize messages written in saveMutationsToFile().
-					msgVersion = bigEndian64(reader.consume<Version>());
-					uint32_t sub = bigEndian32(reader.consume<uint32_t>());
-					int msgSize = bigEndian32(reader.consume<int>());
-					const uint8_t* message = reader.consume(msgSize);
+					msgVersion = bigEndian64(recordReader.consume<Version>());
+					uint32_t sub = bigEndian32(recordReader.consume<uint32_t>());
+					int msgSize = bigEndian32(recordReader.consume<int>());
+					const uint8_t* message = recordReader.consume(msgSize);
 
-					ArenaReader rd(buf.arena(), StringRef(message, msgSize), AssumeVersion(g_network->protocolVersion()));
+					ArenaReader rd(records.arena(), StringRef(message, msgSize),
+					               AssumeVersion(g_network->protocolVersion()));
 					MutationRef m;
 					rd >> m;
 					count++;
@@ -189,7 +215,7 @@ struct MutationFilesReadProgress : public ReferenceCounted<MutationFilesReadProg
 					}
 					if (msgVersion >= minVersion) {
 						mutations.emplace_back(LogMessageVersion(msgVersion, sub), StringRef(message, msgSize),
-						                       buf.arena());
+						                       records.arena());
 						inserted++;
 					}
 				}
@@ -218,6 +244,7 @@ struct MutationFilesReadProgress : public ReferenceCounted<MutationFilesReadProg
 		}
 
 		Reference<IAsyncFile> fd;
+		BlockReader reader;
 		int idx; // index in the MutationFilesReadProgress::files vector
 		int64_t offset; // offset of the file to be read
 		bool eof; // If EOF is seen so far or endVersion is encountered. If true, the file can't be read further.
@@ -298,7 +325,7 @@ struct MutationFilesReadProgress : public ReferenceCounted<MutationFilesReadProg
 		// Attempt decode the first few blocks of log files until beginVersion is consumed
 		std::vector<Future<Void>> fileDecodes;
 		for (int i = 0; i < asyncFiles.size(); i++) {
-			auto fp = makeReference<FileProgress>(asyncFiles[i].get(), i);
+			auto fp = makeReference<FileProgress>(asyncFiles[i].get(), i, progress->getLogFile(i), progress->readAhead);
 			progress->fileProgress.push_back(fp);
 			fileDecodes.push_back(
 			    decodeToVersion(fp, progress->beginVersion, progress->endVersion, progress->getLogFile(i)));
@@ -329,15 +356,13 @@ struct MutationFilesReadProgress : public ReferenceCounted<MutationFilesReadProg
 					return Void();
 				}
 
-				state Standalone<StringRef> buf = makeString(len);
-				int rLen = wait(fp->fd->read(mutateString(buf), len, fp->offset));
-				if (len != rLen) throw restore_bad_read();
+				state Standalone<StringRef> buf = wait(fp->reader.next());
 
 				TraceEvent("ReadFile")
 				    .detail("Name", fp->fd->getFilename())
-				    .detail("Length", rLen)
+				    .detail("Length", len)
 				    .detail("Offset", fp->offset);
-				if (fp->decodeBlock(buf, rLen, minVersion, maxVersion)) break;
+				if (fp->decodeBlock(buf, len, minVersion, maxVersion)) break;
 			}
 			return Void();
 		} catch (Error& e) {
@@ -352,6 +377,7 @@ struct MutationFilesReadProgress : public ReferenceCounted<MutationFilesReadProg
 
 	std::vector<LogFile> files;
 	const Version beginVersion, endVersion;
+	const int readAhead; // Blocks of each file read ahead of decoding
 	std::vector<Reference<FileProgress>> fileProgress;
 };
 
@@ -425,31 +451,22 @@ private:
 	int64_t blockEnd = 0;
 };
 
-ACTOR Future<Void> convert(ConvertParams params) {
-	state Reference<IBackupContainer> container = IBackupContainer::openContainer(params.container_url);
-	state BackupFileList listing = wait(container->dumpFileList());
-	std::sort(listing.logs.begin(), listing.logs.end());
-	TraceEvent("Container").detail("URL", params.container_url).detail("Logs", listing.logs.size());
-	state BackupDescription desc = wait(container->describeBackup());
-	std::cout << "\n" << desc.toString() << "\n";
-
-	// std::cout << "Using Protocol Version: 0x" << std::hex << g_network->protocolVersion().version() << std::dec << "\n";
-
-	std::vector<LogFile> logs = getRelevantLogFiles(listing.logs, params.begin, params.end);
-	printLogFiles("Range has", logs);
-
-	state Reference<MutationFilesReadProgress> progress(new MutationFilesReadProgress(logs, params.begin, params.end));
+// Converts the mutations in [begin, end) into one log file, and returns its name.
+ACTOR Future<std::string> convertChunk(Reference<IBackupContainer> container, std::vector<LogFile> logs, Version begin,
+                                       Version end, int readAhead) {
+	state Reference<MutationFilesReadProgress> progress(
+	    new MutationFilesReadProgress(logs, begin, end, readAhead));
 
 	wait(progress->openLogFiles(container));
 
 	state int blockSize = CLIENT_KNOBS->BACKUP_LOGFILE_BLOCK_SIZE;
-	state Reference<IBackupFile> outFile = wait(container->writeLogFile(params.begin, params.end, blockSize));
+	state Reference<IBackupFile> outFile = wait(container->writeLogFile(begin, end, blockSize));
 	state LogFileWriter logFile(outFile, blockSize);
-	std::cout << "Output file: " << outFile->getFileName() << "\n";
 
 	state MutationList list;
 	state Arena arena;
 	state Version version = invalidVersion;
+	state int64_t mutations = 0;
 	while (progress->hasMutations()) {
 		state VersionedData data = wait(progress->getNextMutation());
 
@@ -463,15 +480,55 @@ ACTOR Future<Void> convert(ConvertParams params) {
 		ArenaReader rd(data.arena, data.message, AssumeVersion(g_network->protocolVersion()));
 		MutationRef m;
 		rd >> m;
-		std::cout << data.version.toString() << " m = " << m.toString() << "\n";
 		list.push_back_deep(arena, m);
 		version = data.version.version;
+		mutations++;
 	}
 	if (list.totalSize() > 0) {
 		wait(LogFileWriter::addMutation(&logFile, version, list));
 	}
 
 	wait(outFile->finish());
+	TraceEvent("ConvertedChunk")
+	    .detail("Begin", begin)
+	    .detail("End", end)
+	    .detail("Mutations", mutations)
+	    .detail("File", outFile->getFileName());
+	return outFile->getFileName();
+}
+
+// Splits the version range into chunks of chunk_versions, which are converted into separate log files. Up to
+// parallelism chunks are converted at once, so memory is bounded by the blocks their log files have read, and the
+// output files are reported in version order.
+ACTOR Future<Void> convert(ConvertParams params) {
+	state Reference<IBackupContainer> container = IBackupContainer::openContainer(params.container_url);
+	state BackupFileList listing = wait(container->dumpFileList());
+	std::sort(listing.logs.begin(), listing.logs.end());
+	TraceEvent("Container").detail("URL", params.container_url).detail("Logs", listing.logs.size());
+	state BackupDescription desc = wait(container->describeBackup());
+	std::cout << "\n" << desc.toString() << "\n";
+
+	// std::cout << "Using Protocol Version: 0x" << std::hex << g_network->protocolVersion().version() << std::dec << "\n";
+
+	printLogFiles("Range has", getRelevantLogFiles(listing.logs, params.begin, params.end));
+
+	state std::deque<Future<std::string>> chunks;
+	state Version chunkBegin = params.begin;
+	loop {
+		if (chunkBegin < params.end && chunks.size() < (size_t)params.parallelism) {
+			Version chunkEnd = std::min(params.end, chunkBegin + params.chunk_versions);
+			chunks.push_back(convertChunk(container, getRelevantLogFiles(listing.logs, chunkBegin, chunkEnd),
+			                              chunkBegin, chunkEnd, params.parallelism));
+			chunkBegin = chunkEnd;
+			continue;
+		}
+		if (chunks.empty()) {
+			break;
+		}
+		std::string fileName = wait(chunks.front());
+		chunks.pop_front();
+		std::cout << "Output file: " << fileName << "\n";
+	}
 
 	return Void();
 }
@@ -512,6 +569,22 @@ int parseCommandLine(ConvertParams* param, CSimpleOpt* args) {
 			}
 			break;
 
+		case OPT_PARALLELISM:
+			if (!sscanf(arg, "%d", &param->parallelism)) {
+				std::cerr << "ERROR: could not parse parallelism " << arg << "\n";
+				printConvertUsage();
+				return FDB_EXIT_ERROR;
+			}
+			break;
+
+		case OPT_CHUNK_VERSIONS:
+			if (!sscanf(arg, "%" SCNd64, &param->chunk_versions)) {
+				std::cerr << "ERROR: could not parse chunk versions " << arg << "\n";
+				printConvertUsage();
+				return FDB_EXIT_ERROR;
+			}
+			break;
+
 		case OPT_CONTAINER:
 			param->container_url = args->OptionArg();
 			break;
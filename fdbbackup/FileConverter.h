@@ -23,6 +23,10 @@
 #pragma once
 
 #include <cinttypes>
+#include <deque>
+#include "fdbclient/BackupContainer.h"
+#include "fdbrpc/IAsyncFile.h"
+#include "flow/genericactors.actor.h"
 #include "flow/SimpleOpt.h"
 
 namespace file_converter {
@@ -38,6 +42,8 @@ enum {
 	OPT_TRACE_FORMAT,
 	OPT_TRACE_LOG_GROUP,
 	OPT_INPUT_FILE,
+	OPT_PARALLELISM,
+	OPT_CHUNK_VERSIONS,
 	OPT_HELP
 };
 
@@ -54,11 +60,55 @@ CSimpleOpt::SOption gConverterOptions[] = { { OPT_CONTAINER, "-r", SO_REQ_SEP },
 	                                        { OPT_TRACE_LOG_GROUP, "--loggroup", SO_REQ_SEP },
 	                                        { OPT_INPUT_FILE, "-i", SO_REQ_SEP },
 	                                        { OPT_INPUT_FILE, "--input", SO_REQ_SEP },
+	                                        { OPT_PARALLELISM, "--parallelism", SO_REQ_SEP },
+	                                        { OPT_CHUNK_VERSIONS, "--chunk_versions", SO_REQ_SEP },
 	                                        { OPT_HELP, "-?", SO_NONE },
 	                                        { OPT_HELP, "-h", SO_NONE },
 	                                        { OPT_HELP, "--help", SO_NONE },
 	                                        SO_END_OF_OPTIONS };
 
+// Reads a log file block by block, keeping the reads of the next few blocks in flight. For a blob store container each
+// read is a ranged GET, so a file is fetched by that many requests at once rather than one after another.
+class BlockReader {
+public:
+	BlockReader() = default;
+	BlockReader(Reference<IAsyncFile> fd, const LogFile& file, int readAhead)
+	  : fd(fd), blockSize(file.blockSize), fileSize(file.fileSize), readAhead(std::max(1, readAhead)) {}
+
+	// Returns the next block, which is empty at the end of the file. Uses the block size as the read size, so the
+	// last block can be shorter.
+	Future<Standalone<StringRef>> next() {
+		fill();
+		if (pending.empty()) {
+			return Standalone<StringRef>();
+		}
+		Future<Standalone<StringRef>> block = pending.front();
+		pending.pop_front();
+		fill();
+		return block;
+	}
+
+private:
+	void fill() {
+		while (pending.size() < (size_t)readAhead && nextOffset < fileSize) {
+			int len = std::min<int64_t>(blockSize, fileSize - nextOffset);
+			Standalone<StringRef> buf = makeString(len);
+			pending.push_back(map(fd->read(mutateString(buf), len, nextOffset), [buf, len](int rLen) {
+				if (rLen != len) throw restore_bad_read();
+				return buf;
+			}));
+			nextOffset += len;
+		}
+	}
+
+	Reference<IAsyncFile> fd;
+	int64_t blockSize = 0;
+	int64_t fileSize = 0;
+	int readAhead = 1;
+	int64_t nextOffset = 0; // The offset of the first block not yet requested
+	std::deque<Future<Standalone<StringRef>>> pending;
+};
+
 }  // namespace file_converter
 
 #endif  // FDBBACKUP_FILECONVERTER_H
@@ -19,6 +19,7 @@
  */
 
 #include <algorithm>
+#include <deque>
 #include <iostream>
 #include <vector>
 
@@ -40,6 +41,8 @@ void printDecodeUsage() {
 	std::cout << "\n"
 	             "  -r, --container   Container URL.\n"
 	             "  -i, --input FILE  Log file to be decoded.\n"
+	             "  --parallelism N   Number of log files read at once, and of blocks read ahead\n"
+	             "                    in each (defaults to 4).\n"
 	             "  --crash           Crash on serious error.\n"
 	             "\n";
 	return;
@@ -48,6 +51,7 @@ void printDecodeUsage() {
 struct DecodeParams {
 	std::string container_url;
 	std::string file;
+	int parallelism = 4;
 	bool log_enabled = false;
 	std::string log_dir, trace_format, trace_log_group;
 
@@ -57,6 +61,8 @@ struct DecodeParams {
 		s.append(container_url);
 		s.append(", File: ");
 		s.append(file);
+		s.append(", Parallelism: ");
+		s.append(std::to_string(parallelism));
 		if (log_enabled) {
 			if (!log_dir.empty()) {
 				s.append(" LogDir:").append(log_dir);
@@ -102,6 +108,13 @@ int parseDecodeCommandLine(DecodeParams* param, CSimpleOpt* args) {
 			param->file = args->OptionArg();
 			break;
 
+		case OPT_PARALLELISM:
+			if (!sscanf(args->OptionArg(), "%d", &param->parallelism) || param->parallelism <= 0) {
+				std::cerr << "ERROR: could not parse parallelism " << args->OptionArg() << "\n";
+				return FDB_EXIT_ERROR;
+			}
+			break;
+
 		case OPT_TRACE:
 			param->log_enabled = true;
 			break;
@@ -213,8 +226,9 @@ struct VersionedKVPart {
 /*
  * Model a decoding progress for a mutation file. Usage is:
  *
- *    DecodeProgress progress(logfile);
+ *    DecodeProgress progress(logfile, readAhead);
  *    wait(progress->openFile(container));
+ *    progress->addUnfinished(previousFileUnfinishedBuffer);
  *    while (!progress->finished()) {
  *        VersionedMutations m = wait(progress->getNextBatch());
  *        ...
@@ -224,16 +238,21 @@ struct VersionedKVPart {
  * decoded into a list of key/value pairs, which are then decoded into batches
  * of mutations. Because a version's mutations can be split into many key/value
  * pairs, the decoding of mutation batch needs to look ahead one more pair. So
- * at any time this object might have two blocks of data in memory.
+ * at any time this object might have two blocks of data in memory, plus the
+ * readAhead blocks being read.
  */
-class DecodeProgress {
+class DecodeProgress : public ReferenceCounted<DecodeProgress> {
 	std::vector<VersionedKVPart> keyValues;
 
 public:
 	DecodeProgress() = default;
-	template <class U>
-	DecodeProgress(const LogFile& file, U &&values)
-	  : file(file), keyValues(std::forward<U>(values)) {}
+	DecodeProgress(const LogFile& file, int readAhead) : file(file), readAhead(readAhead) {}
+
+	// Adds the unfinished version data of the previous file, whose versions are not after this file's.
+	void addUnfinished(std::vector<VersionedKVPart>&& values) {
+		keyValues.insert(keyValues.begin(), std::make_move_iterator(values.begin()),
+		                 std::make_move_iterator(values.end()));
+	}
 
 	// If there are no more mutations to pull from the file.
 	// However, we could have unfinished version in the buffer when EOF is true,
@@ -304,7 +323,7 @@ public:
 				m.arena = buf.arena();
 			}
 			if (isValueComplete(value)) {
-				m.mutations = decode_value(value);
+				m.mutations = decode_value(expandBackupLogValue(m.arena, value));
 				if (m.arena.getSize() == 0) {
 					m.arena = kv.arena;
 				}
@@ -388,6 +407,7 @@ public:
 	ACTOR static Future<Void> openFileImpl(DecodeProgress* self, Reference<IBackupContainer> container) {
 		Reference<IAsyncFile> fd = wait(container->readFile(self->file.fileName));
 		self->fd = fd;
+		self->reader = BlockReader(fd, self->file, self->readAhead);
 		wait(readAndDecodeFile(self));
 		return Void();
 	}
@@ -401,17 +421,13 @@ public:
 				return Void();
 			}
 
-			state Standalone<StringRef> buf = makeString(len);
-			state int rLen = wait(self->fd->read(mutateString(buf), len, self->offset));
+			state Standalone<StringRef> buf = wait(self->reader.next());
 			TraceEvent("ReadFile")
 			    .detail("Name", self->file.fileName)
-			    .detail("Len", rLen)
+			    .detail("Len", buf.size())
 			    .detail("Offset", self->offset);
-			if (rLen != len) {
-				throw restore_corrupted_data();
-			}
-			self->decode_block(buf, rLen);
-			self->offset += rLen;
+			self->decode_block(buf, buf.size());
+			self->offset += buf.size();
 			return Void();
 		} catch (Error& e) {
 			TraceEvent(SevWarn, "CorruptLogFileBlock")
@@ -425,6 +441,8 @@ public:
 
 	LogFile file;
 	Reference<IAsyncFile> fd;
+	BlockReader reader;
+	int readAhead = 1; // Blocks read ahead of decoding
 	int64_t offset = 0;
 	bool eof = false;
 	bool leftover = false; // Done but has unfinished version batch data left
@@ -450,23 +468,36 @@ ACTOR Future<Void> decode_logs(DecodeParams params) {
 	state std::vector<LogFile> logs = getRelevantLogFiles(listing.logs, params);
 	printLogFiles("Relevant files are: ", logs);
 
+	// Up to parallelism files are opened and read ahead while the first of them is decoded, so the files are still
+	// decoded and printed in order.
+	state std::deque<std::pair<Reference<DecodeProgress>, Future<Void>>> opened;
 	state int i = 0;
 	// Previous file's unfinished version data
 	state std::vector<VersionedKVPart> left;
-	for (; i < logs.size(); i++) {
-		if (logs[i].fileSize == 0) continue;
+	loop {
+		for (; i < logs.size() && opened.size() < (size_t)params.parallelism; i++) {
+			if (logs[i].fileSize == 0) continue;
+
+			auto progress = makeReference<DecodeProgress>(logs[i], params.parallelism);
+			opened.emplace_back(progress, progress->openFile(container));
+		}
+		if (opened.empty()) {
+			break;
+		}
 
-		state DecodeProgress progress(logs[i], std::move(left));
-		wait(progress.openFile(container));
-		while (!progress.finished()) {
-			VersionedMutations vms = wait(progress.getNextBatch());
+		state Reference<DecodeProgress> progress = opened.front().first;
+		wait(opened.front().second);
+		opened.pop_front();
+		progress->addUnfinished(std::move(left));
+		while (!progress->finished()) {
+			VersionedMutations vms = wait(progress->getNextBatch());
 			for (const auto& m : vms.mutations) {
 				std::cout << vms.version << " " << m.toString() << "\n";
 			}
 		}
-		left = std::move(progress).getUnfinishedBuffer();
+		left = std::move(*progress).getUnfinishedBuffer();
 		if (!left.empty()) {
-			TraceEvent("UnfinishedFile").detail("File", logs[i].fileName).detail("Q", left.size());
+			TraceEvent("UnfinishedFile").detail("File", progress->file.fileName).detail("Q", left.size());
 		}
 	}
 	return Void();
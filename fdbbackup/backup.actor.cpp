@@ -939,7 +939,7 @@ static void printAgentUsage(bool devhelp) {
 	       "                 Sets the LogGroup field with the specified value for all\n"
 	       "                 events in the trace output (defaults to `default').\n");
 	printf("  --trace_format FORMAT\n"
-		   "                 Select the format of the trace files. xml (the default) and json are supported.\n"
+		   "                 Select the format of the trace files. xml (the default), json and binary are supported.\n"
 		   "                 Has no effect unless --log is specified.\n");
 	printf("  -m SIZE, --memory SIZE\n"
 		   "                 Memory limit. The default value is 8GiB. When specified\n"
@@ -1039,7 +1039,7 @@ static void printBackupUsage(bool devhelp) {
 	       "                 Sets the LogGroup field with the specified value for all\n"
 	       "                 events in the trace output (defaults to `default').\n");
 	printf("  --trace_format FORMAT\n"
-		   "                 Select the format of the trace files. xml (the default) and json are supported.\n"
+		   "                 Select the format of the trace files. xml (the default), json and binary are supported.\n"
 		   "                 Has no effect unless --log is specified.\n");
 	printf("  --max_cleanup_seconds SECONDS\n"
 	       "                 Specifies the amount of time a backup or DR needs to be stale before cleanup will\n"
@@ -1111,7 +1111,7 @@ static void printRestoreUsage(bool devhelp ) {
 	       "                 Sets the LogGroup field with the specified value for all\n"
 	       "                 events in the trace output (defaults to `default').\n");
 	printf("  --trace_format FORMAT\n"
-		   "                 Select the format of the trace files. xml (the default) and json are supported.\n"
+		   "                 Select the format of the trace files. xml (the default), json and binary are supported.\n"
 		   "                 Has no effect unless --log is specified.\n");
 	// TODO: Enable this command-line argument once atomics are supported
 	// printf("  --incremental\n"
@@ -1165,7 +1165,7 @@ static void printDBAgentUsage(bool devhelp) {
 	       "                 Sets the LogGroup field with the specified value for all\n"
 	       "                 events in the trace output (defaults to `default').\n");
 	printf("  --trace_format FORMAT\n"
-		   "                 Select the format of the trace files. xml (the default) and json are supported.\n"
+		   "                 Select the format of the trace files. xml (the default), json and binary are supported.\n"
 		   "                 Has no effect unless --log is specified.\n");
 	printf("  -m SIZE, --memory SIZE\n"
 		   "                 Memory limit. The default value is 8GiB. When specified\n"
@@ -1219,7 +1219,7 @@ static void printDBBackupUsage(bool devhelp) {
 	       "                 Sets the LogGroup field with the specified value for all\n"
 	       "                 events in the trace output (defaults to `default').\n");
 	printf("  --trace_format FORMAT\n"
-		   "                 Select the format of the trace files. xml (the default) and json are supported.\n"
+		   "                 Select the format of the trace files. xml (the default), json and binary are supported.\n"
 		   "                 Has no effect unless --log is specified.\n");
 	printf("  -h, --help     Display this help and exit.\n");
 	printf("\n"
@@ -1446,6 +1446,12 @@ ACTOR Future<std::string> getLayerStatus(Reference<ReadYourWritesTransaction> tr
 		if(last_ts > 0)
 			diffObj["bytes_per_second"] = double(current_stats.bytes_sent - last_stats.bytes_sent) / (now() - last_ts);
 		blobstats.create("recent") = diffObj;
+		// Not in recent, which is summed over all agents below
+		if(diff.part_upload_microseconds > 0)
+			blobstats.create("recent_part_bytes_per_second_per_connection") = diff.part_bytes_sent / (diff.part_upload_microseconds / 1e6);
+		int64_t recentRequests = diff.requests_successful + diff.requests_failed;
+		if(recentRequests > 0)
+			blobstats.create("recent_request_seconds_avg") = diff.request_microseconds / 1e6 / recentRequests;
 		last_stats = current_stats;
 		last_ts = now();
 
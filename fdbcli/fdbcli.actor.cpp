@@ -415,8 +415,8 @@ static void printProgramUsage(const char* name) {
 	       "                 unspecified, defaults to the current directory. Has\n"
 	       "                 no effect unless --log is specified.\n"
 	       "  --trace_format FORMAT\n"
-	       "                 Select the format of the log files. xml (the default) and json\n"
-	       "                 are supported. Has no effect unless --log is specified.\n"
+	       "                 Select the format of the log files. xml (the default), json\n"
+	       "                 and binary are supported. Has no effect unless --log is specified.\n"
 	       "  --exec CMDS    Immediately executes the semicolon separated CLI commands\n"
 	       "                 and then exits.\n"
 	       "  --no-status    Disables the initial status check done when starting\n"
@@ -60,8 +60,9 @@ public:
 	void delref() override { ReferenceCounted<AsyncFileS3BlobStoreWrite>::delref(); }
 
 	struct Part : ReferenceCounted<Part> {
-		Part(int n, int minSize)
-		  : number(n), writer(content.getWriteBuffer(minSize), nullptr, Unversioned()), length(0) {
+		Part(int n, int targetLength)
+		  : number(n), writer(content.getWriteBuffer(targetLength), nullptr, Unversioned()), length(0),
+		    targetLength(targetLength) {
 			etag = std::string();
 			::MD5_Init(&content_md5_buf);
 		}
@@ -72,6 +73,7 @@ public:
 		std::string md5string;
 		PacketWriter writer;
 		int length;
+		int targetLength; // The part is ended and uploaded once it reaches this length
 		void write(const uint8_t* buf, int len) {
 			writer.serializeBytes(buf, len);
 			::MD5_Update(&content_md5_buf, buf, len);
@@ -96,11 +98,11 @@ public:
 
 	ACTOR static Future<Void> write_impl(Reference<AsyncFileS3BlobStoreWrite> f, const uint8_t* data, int length) {
 		state Part* p = f->m_parts.back().getPtr();
-		// If this write will cause the part to cross the min part size boundary then write to the boundary and start a
+		// If this write will cause the part to cross its target length boundary then write to the boundary and start a
 		// new part.
-		while (p->length + length >= f->m_bstore->knobs.multipart_min_part_size) {
+		while (p->length + length >= p->targetLength) {
 			// Finish off this part
-			int finishlen = f->m_bstore->knobs.multipart_min_part_size - p->length;
+			int finishlen = p->targetLength - p->length;
 			p->write((const uint8_t*)data, finishlen);
 
 			// Adjust source buffer args
@@ -132,11 +134,30 @@ public:
 	ACTOR static Future<std::string> doPartUpload(AsyncFileS3BlobStoreWrite* f, Part* p) {
 		p->finalizeMD5();
 		std::string upload_id = wait(f->getUploadID());
+		state double start = now();
 		std::string etag = wait(f->m_bstore->uploadPart(f->m_bucket, f->m_object, upload_id, p->number, &p->content,
 		                                                p->length, p->md5string));
+		f->partUploaded(p->length, now() - start);
 		return etag;
 	}
 
+	// Size later parts so that each takes about multipart_target_seconds to upload at the throughput recent parts got
+	// on their connection, so that a fast connection is not held to many small requests by the request rate limits
+	void partUploaded(int length, double seconds) {
+		S3BlobStoreEndpoint::s_stats.parts_uploaded++;
+		S3BlobStoreEndpoint::s_stats.part_bytes_sent += length;
+		S3BlobStoreEndpoint::s_stats.part_upload_microseconds += (int64_t)(seconds * 1e6);
+
+		const auto& knobs = m_bstore->knobs;
+		if (knobs.multipart_target_seconds <= 0 || seconds <= 0) return;
+		double bytesPerSecond = length / seconds;
+		m_partBytesPerSecond = m_partBytesPerSecond > 0 ? (m_partBytesPerSecond + bytesPerSecond) / 2 : bytesPerSecond;
+		m_partSize = (int)std::max<double>(
+		    knobs.multipart_min_part_size,
+		    std::min<double>(std::max(knobs.multipart_min_part_size, knobs.multipart_max_part_size),
+		                     m_partBytesPerSecond * knobs.multipart_target_seconds));
+	}
+
 	ACTOR static Future<Void> doFinishUpload(AsyncFileS3BlobStoreWrite* f) {
 		// If there is only 1 part then it has not yet been uploaded so just write the whole file at once.
 		if (f->m_parts.size() == 1) {
@@ -218,6 +239,8 @@ private:
 	std::vector<Reference<Part>> m_parts;
 	Promise<Void> m_error;
 	FlowLock m_concurrentUploads;
+	int m_partSize; // Target length of the next part
+	double m_partBytesPerSecond;
 
 	// End the current part and start uploading it, but also wait for a part to finish if too many are in transit.
 	ACTOR static Future<Void> endCurrentPart(AsyncFileS3BlobStoreWrite* f, bool startNew = false) {
@@ -234,8 +257,7 @@ private:
 
 		// Make a new part to write to
 		if (startNew)
-			f->m_parts.push_back(
-			    Reference<Part>(new Part(f->m_parts.size() + 1, f->m_bstore->knobs.multipart_min_part_size)));
+			f->m_parts.push_back(Reference<Part>(new Part(f->m_parts.size() + 1, f->m_partSize)));
 
 		return Void();
 	}
@@ -248,10 +270,11 @@ private:
 public:
 	AsyncFileS3BlobStoreWrite(Reference<S3BlobStoreEndpoint> bstore, std::string bucket, std::string object)
 	  : m_bstore(bstore), m_bucket(bucket), m_object(object), m_cursor(0),
-	    m_concurrentUploads(bstore->knobs.concurrent_writes_per_file) {
+	    m_concurrentUploads(bstore->knobs.concurrent_writes_per_file),
+	    m_partSize(bstore->knobs.multipart_min_part_size), m_partBytesPerSecond(0) {
 
 		// Add first part
-		m_parts.push_back(Reference<Part>(new Part(1, m_bstore->knobs.multipart_min_part_size)));
+		m_parts.push_back(Reference<Part>(new Part(1, m_partSize)));
 	}
 };
 
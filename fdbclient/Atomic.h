@@ -229,6 +229,42 @@ inline Optional<ValueRef> doCompareAndClear(const Optional<ValueRef>& existingVa
 	return existingValueOptional; // No change required.
 }
 
+inline Optional<ValueRef> doSetIfAbsent(const Optional<ValueRef>& existingValueOptional, const ValueRef& otherOperand,
+                                        Arena& ar) {
+	if (!existingValueOptional.present()) {
+		return otherOperand;
+	}
+	return existingValueOptional; // No change required.
+}
+
+// The operand of CompareAndSet is the expected value followed by the new value, followed by the length of the expected
+// value as a 4-byte little-endian integer.  The caller must have checked that the length fits in the operand.
+inline int32_t getCompareAndSetExpectedLength(const ValueRef& operand) {
+	int32_t len;
+	memcpy(&len, operand.end() - sizeof(int32_t), sizeof(int32_t));
+	return littleEndian32(len);
+}
+
+inline bool isValidCompareAndSetOperand(const ValueRef& operand) {
+	if (operand.size() < sizeof(int32_t)) {
+		return false;
+	}
+	int32_t len = getCompareAndSetExpectedLength(operand);
+	return len >= 0 && len <= operand.size() - (int)sizeof(int32_t);
+}
+
+inline Optional<ValueRef> doCompareAndSet(const Optional<ValueRef>& existingValueOptional,
+                                          const ValueRef& otherOperand, Arena& ar) {
+	if (!isValidCompareAndSetOperand(otherOperand)) {
+		return existingValueOptional; // Rejected by the client; never apply a malformed operand.
+	}
+	int32_t len = getCompareAndSetExpectedLength(otherOperand);
+	if (existingValueOptional.present() && existingValueOptional.get() == otherOperand.substr(0, len)) {
+		return otherOperand.substr(len, otherOperand.size() - len - sizeof(int32_t));
+	}
+	return existingValueOptional; // No change required.
+}
+
 static void placeVersionstamp( uint8_t* destination, Version version, uint16_t transactionNumber ) {
 	version = bigEndian64(version);
 	transactionNumber = bigEndian16(transactionNumber);
@@ -508,6 +508,17 @@ Future<Void> eraseLogData(Reference<ReadYourWritesTransaction> tr, Key logUidVal
 Key getApplyKey( Version version, Key backupUid );
 Version getLogKeyVersion(Key key);
 std::pair<Version, uint32_t> decodeBKMutationLogKey(Key key);
+
+// A mutation log value is [protocolVersion:uint64_t][length:uint32_t] followed by length bytes of mutations, each
+// encoded as [type:uint32_t][param1Length:uint32_t][param2Length:uint32_t][param1][param2].  If protocolVersion has
+// compactBackupMutationsFlag set then each mutation is instead encoded by writeCompactBackupMutation(), with varint
+// lengths, param1 sharing a prefix with the previous mutation's param1, and param2 sharing a prefix with param1.
+// Readers of mutation log values must pass them through expandBackupLogValue() first.
+constexpr uint64_t compactBackupMutationsFlag = 0x2000000000000000LL;
+void writeCompactBackupMutation(BinaryWriter& wr, MutationRef const& m, StringRef prevParam1);
+
+// Returns a complete mutation log value in the normal encoding, converting it into arena if it is compact
+StringRef expandBackupLogValue(Arena& arena, StringRef value);
 Future<Void> logError(Database cx, Key keyErrors, const std::string& message);
 Future<Void> logError(Reference<ReadYourWritesTransaction> tr, Key keyErrors, const std::string& message);
 Future<Void> checkVersion(Reference<ReadYourWritesTransaction> const& tr);
@@ -718,6 +729,35 @@ public:
 		return configSpace.pack(LiteralStringRef(__FUNCTION__));
 	}
 
+	// The range files of the last complete snapshot, in the same form as snapshotRangeFileMap.  Range tasks of an
+	// incremental snapshot reference these instead of writing new files for ranges that have not changed.
+	RangeFileMapT lastSnapshotRangeFileMap() {
+		return configSpace.pack(LiteralStringRef(__FUNCTION__));
+	}
+
+	// Disjoint map of range begin to (range end, version) such that no mutation in the range that was copied by a
+	// log task has a version >= version.  Ranges are widened to shard boundaries.
+	typedef KeyBackedMap<Key, std::pair<Key, Version>> ModifiedRangeMapT;
+	ModifiedRangeMapT modifiedRangeMap() {
+		return configSpace.pack(LiteralStringRef(__FUNCTION__));
+	}
+
+	// The version from which log tasks have recorded their mutations in modifiedRangeMap.  Not set when the mutation
+	// logs are written by backup workers, which disables incremental snapshots.
+	KeyBackedProperty<Version> changeTrackingBeginVersion() {
+		return configSpace.pack(LiteralStringRef(__FUNCTION__));
+	}
+
+	// Whether the current snapshot may reuse the unchanged range files of the last snapshot
+	KeyBackedProperty<bool> snapshotReuseRangeFiles() {
+		return configSpace.pack(LiteralStringRef(__FUNCTION__));
+	}
+
+	// Number of consecutive completed snapshots that reused range files, reset by each full snapshot
+	KeyBackedProperty<int64_t> incrementalSnapshotCount() {
+		return configSpace.pack(LiteralStringRef(__FUNCTION__));
+	}
+
 	// Coalesced set of ranges already dispatched for writing.
 	typedef KeyBackedMap<Key, bool> RangeDispatchMapT;
 	RangeDispatchMapT snapshotRangeDispatchMap() {
@@ -775,6 +815,7 @@ public:
 			copy.snapshotBatchSize().clear(tr);
 			copy.snapshotBatchFuture().clear(tr);
 			copy.snapshotBatchDispatchDoneKey().clear(tr);
+			copy.snapshotReuseRangeFiles().clear(tr);
 
 			if(intervalSeconds < 0)
 				intervalSeconds = defaultInterval.get();
@@ -954,8 +995,23 @@ namespace fileBackup {
 ACTOR Future<Standalone<VectorRef<KeyValueRef>>> decodeRangeFileBlock(Reference<IAsyncFile> file, int64_t offset,
                                                                       int len);
 
+// Return the len bytes of a backup file at offset, failing with restore_bad_read if the file is short.
+ACTOR Future<Standalone<StringRef>> readFileBlock(Reference<IAsyncFile> file, int64_t offset, int len);
+
+// Decode a range file block that was read from filename at offset into results, whose arena must keep buf alive.
+// Touches nothing but its arguments, so it can run off the network thread.
+void decodeRangeFileBlock(StringRef buf, Standalone<VectorRef<KeyValueRef>>& results, std::string const& filename,
+                          int64_t offset);
+
 // Return a block of contiguous padding bytes "\0xff" for backup files, growing if needed.
 Value makePadding(int size);
+
+// Return a compressed partitioned mutation log block holding the given serialized records, or nothing if it would not
+// fit in blockSize (or zlib is unavailable).
+Optional<Standalone<StringRef>> encodeCompressedLogBlock(StringRef records, int blockSize);
+
+// Return the serialized records of a compressed partitioned mutation log block whose version has been consumed.
+Standalone<StringRef> decodeCompressedLogBlock(StringRefReader& reader);
 }
 
 // For fast restore simulation test
@@ -22,8 +22,11 @@
 #include <time.h>
 
 #include "fdbclient/BackupAgent.actor.h"
+#include "fdbclient/MutationList.h"
 #include "fdbrpc/simulator.h"
 #include "flow/ActorCollection.h"
+#include "flow/CompressedInt.h"
+#include "flow/UnitTest.h"
 #include "flow/actorcompiler.h" // has to be last include
 
 std::string BackupAgentBase::formatTime(int64_t epochs) {
@@ -214,8 +217,76 @@ std::pair<Version, uint32_t> decodeBKMutationLogKey(Key key) {
 		bigEndian32(*(int32_t*)(key.begin() + backupLogPrefixBytes + sizeof(UID) + sizeof(uint8_t) + sizeof(int64_t))));
 }
 
+static int sharedPrefixLength(StringRef a, StringRef b) {
+	int n = std::min(a.size(), b.size());
+	int i = 0;
+	while (i < n && a[i] == b[i]) {
+		++i;
+	}
+	return i;
+}
+
+void writeCompactBackupMutation(BinaryWriter& wr, MutationRef const& m, StringRef prevParam1) {
+	int p1Shared = sharedPrefixLength(m.param1, prevParam1);
+	int p2Shared = sharedPrefixLength(m.param2, m.param1);
+	wr << (uint8_t)m.type << CompressedInt<int>(p1Shared) << CompressedInt<int>(m.param1.size() - p1Shared);
+	wr.serializeBytes(m.param1.substr(p1Shared));
+	wr << CompressedInt<int>(p2Shared) << CompressedInt<int>(m.param2.size() - p2Shared);
+	wr.serializeBytes(m.param2.substr(p2Shared));
+}
+
+StringRef expandBackupLogValue(Arena& arena, StringRef value) {
+	const int headerSize = sizeof(uint64_t) + sizeof(uint32_t);
+	if (value.size() < headerSize) {
+		return value;
+	}
+	uint64_t protocolVersion = 0;
+	memcpy(&protocolVersion, value.begin(), sizeof(uint64_t));
+	if ((protocolVersion & compactBackupMutationsFlag) == 0) {
+		return value;
+	}
+
+	uint32_t totalBytes = 0;
+	memcpy(&totalBytes, value.begin() + sizeof(uint64_t), sizeof(uint32_t));
+	if (totalBytes + headerSize > value.size()) {
+		throw restore_missing_data();
+	}
+
+	BinaryReader rd(value.substr(headerSize, totalBytes), Unversioned());
+	BinaryWriter wr(IncludeVersion(ProtocolVersion::withBackupMutations()));
+	wr << (uint32_t)0;
+	std::string param1;
+	while (!rd.empty()) {
+		uint8_t type;
+		CompressedInt<int> p1Shared, p1Suffix, p2Shared, p2Suffix;
+		rd >> type >> p1Shared >> p1Suffix;
+		if (p1Shared.value < 0 || p1Suffix.value < 0 || p1Shared.value > param1.size() ||
+		    !isValidMutationType(type)) {
+			throw restore_corrupted_data();
+		}
+		param1.resize(p1Shared.value);
+		param1.append((const char*)rd.readBytes(p1Suffix.value), p1Suffix.value);
+		rd >> p2Shared >> p2Suffix;
+		if (p2Shared.value < 0 || p2Suffix.value < 0 || p2Shared.value > param1.size()) {
+			throw restore_corrupted_data();
+		}
+
+		uint32_t header[3] = { type, (uint32_t)param1.size(), (uint32_t)(p2Shared.value + p2Suffix.value) };
+		wr.serializeBytes(header, sizeof(header));
+		wr.serializeBytes(param1.data(), param1.size());
+		wr.serializeBytes(param1.data(), p2Shared.value);
+		wr.serializeBytes(rd.readBytes(p2Suffix.value), p2Suffix.value);
+	}
+
+	uint32_t expandedBytes = wr.getLength() - headerSize;
+	memcpy((uint8_t*)wr.getData() + sizeof(uint64_t), &expandedBytes, sizeof(uint32_t));
+	return StringRef(arena, wr.toValue());
+}
+
 void decodeBackupLogValue(Arena& arena, VectorRef<MutationRef>& result, int& mutationSize, StringRef value, StringRef addPrefix, StringRef removePrefix, Version version, Reference<KeyRangeMap<Version>> key_version) {
 	try {
+		Arena expandArena;
+		value = expandBackupLogValue(expandArena, value);
 		uint64_t offset(0);
 		uint64_t protocolVersion = 0;
 		memcpy(&protocolVersion, value.begin(), sizeof(uint64_t));
@@ -867,3 +938,43 @@ ACTOR Future<Void> cleanupBackup(Database cx, bool deleteData) {
 		}
 	}
 }
+
+TEST_CASE("/backup/compactMutationLog") {
+	Arena arena;
+	MutationListRef mutations;
+	for (int i = 0; i < 100; ++i) {
+		Key key = StringRef(format("prefix/%d/%s", deterministicRandom()->randomInt(0, 20),
+		                           deterministicRandom()->randomAlphaNumeric(deterministicRandom()->randomInt(0, 10)).c_str()));
+		if (deterministicRandom()->coinflip()) {
+			mutations.push_back_deep(arena, MutationRef(MutationRef::ClearRange, key, keyAfter(key)));
+		} else {
+			mutations.push_back_deep(arena, MutationRef(MutationRef::SetValue, key,
+			                                            StringRef(deterministicRandom()->randomAlphaNumeric(
+			                                                deterministicRandom()->randomInt(0, 100)))));
+		}
+	}
+
+	BinaryWriter normal(IncludeVersion(ProtocolVersion::withBackupMutations()));
+	normal << mutations.totalSize();
+	for (auto b = mutations.blob_begin; b != nullptr; b = b->next) {
+		normal.serializeBytes(b->data);
+	}
+
+	BinaryWriter compact(Unversioned());
+	compact << (ProtocolVersion::withBackupMutations().versionWithFlags() | compactBackupMutationsFlag) << (uint32_t)0;
+	StringRef prev;
+	for (auto& m : mutations) {
+		writeCompactBackupMutation(compact, m, prev);
+		prev = m.param1;
+	}
+	uint32_t compactBytes = compact.getLength() - sizeof(uint64_t) - sizeof(uint32_t);
+	memcpy((uint8_t*)compact.getData() + sizeof(uint64_t), &compactBytes, sizeof(uint32_t));
+	printf("Normal encoding %d bytes, compact encoding %d bytes\n", normal.getLength(), compact.getLength());
+	ASSERT(compact.getLength() < normal.getLength());
+
+	Arena expandArena;
+	ASSERT(expandBackupLogValue(expandArena, compact.toValue()) == normal.toValue());
+	ASSERT(expandBackupLogValue(expandArena, normal.toValue()) == normal.toValue());
+
+	return Void();
+}
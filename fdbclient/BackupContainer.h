@@ -65,9 +65,15 @@ static const uint32_t BACKUP_AGENT_MLOG_VERSION = 2001;
 // Mutation log version written by BackupWorker
 static const uint32_t PARTITIONED_MLOG_VERSION = 4110;
 
+// Mutation log version written by BackupWorker with BACKUP_WORKER_LOG_COMPRESSION
+static const uint32_t PARTITIONED_MLOG_COMPRESSED_VERSION = 4111;
+
 // Snapshot file version written by FileBackupAgent
 static const uint32_t BACKUP_AGENT_SNAPSHOT_FILE_VERSION = 1001;
 
+// Snapshot file version written by FileBackupAgent with BACKUP_RANGEFILE_COMPRESSION
+static const uint32_t BACKUP_AGENT_COMPRESSED_SNAPSHOT_FILE_VERSION = 1002;
+
 struct LogFile {
 	Version beginVersion;
 	Version endVersion;
@@ -239,7 +239,9 @@ Future<Reference<IAsyncFile>> BackupContainerLocalDirectory::readFile(const std:
 			int readAhead = deterministicRandom()->randomInt(0, 3);
 			int reads = deterministicRandom()->randomInt(1, 3);
 			int cacheSize = deterministicRandom()->randomInt(0, 3);
-			return Reference<IAsyncFile>(new AsyncFileReadAheadCache(fr, blockSize, readAhead, reads, cacheSize));
+			int maxReadAhead = deterministicRandom()->coinflip() ? 0 : readAhead + deterministicRandom()->randomInt(1, 5);
+			return Reference<IAsyncFile>(
+			    new AsyncFileReadAheadCache(fr, blockSize, readAhead, reads, cacheSize, maxReadAhead));
 		});
 	}
 
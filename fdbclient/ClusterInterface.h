@@ -251,10 +251,14 @@ struct StatusReply {
 struct StatusRequest {
 	constexpr static FileIdentifier file_identifier = 14419140;
 	ReplyPromise< struct StatusReply > reply;
+	std::vector<std::string> sections; // The fields of the cluster status to return, or all of them if empty
+
+	StatusRequest() {}
+	explicit StatusRequest(std::vector<std::string> sections) : sections(std::move(sections)) {}
 
 	template <class Ar>
 	void serialize(Ar& ar) {
-		serializer(ar, reply);
+		serializer(ar, reply, sections);
 	}
 };
 
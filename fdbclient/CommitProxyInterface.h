@@ -56,6 +56,7 @@ struct CommitProxyInterface {
 	RequestStream< struct ProxySnapRequest > proxySnapReq;
 	RequestStream< struct ExclusionSafetyCheckRequest > exclusionSafetyCheckReq;
 	RequestStream< struct GetDDMetricsRequest > getDDMetrics;
+	RequestStream< struct GetConflictHotspotsRequest > getConflictHotspots;
 
 	UID id() const { return commit.getEndpoint().token; }
 	std::string toString() const { return id().shortString(); }
@@ -76,6 +77,7 @@ struct CommitProxyInterface {
 			proxySnapReq = RequestStream< struct ProxySnapRequest >( commit.getEndpoint().getAdjustedEndpoint(7) );
 			exclusionSafetyCheckReq = RequestStream< struct ExclusionSafetyCheckRequest >( commit.getEndpoint().getAdjustedEndpoint(8) );
 			getDDMetrics = RequestStream< struct GetDDMetricsRequest >( commit.getEndpoint().getAdjustedEndpoint(9) );
+			getConflictHotspots = RequestStream< struct GetConflictHotspotsRequest >( commit.getEndpoint().getAdjustedEndpoint(10) );
 		}
 	}
 
@@ -91,6 +93,7 @@ struct CommitProxyInterface {
 		streams.push_back(proxySnapReq.getReceiver());
 		streams.push_back(exclusionSafetyCheckReq.getReceiver());
 		streams.push_back(getDDMetrics.getReceiver());
+		streams.push_back(getConflictHotspots.getReceiver());
 		FlowTransport::transport().addEndpoints(streams);
 	}
 };
@@ -374,10 +377,13 @@ struct TxnStateRequest {
 	bool last;
 	std::vector<Endpoint> broadcastInfo;
 	ReplyPromise<Void> reply;
+	// When not empty, data is empty and instead is zlib compressed here, decompressing to uncompressedBytes
+	StringRef compressedData;
+	int32_t uncompressedBytes = 0;
 
 	template <class Ar> 
 	void serialize(Ar& ar) { 
-		serializer(ar, data, sequence, last, broadcastInfo, reply, arena);
+		serializer(ar, data, sequence, last, broadcastInfo, reply, compressedData, uncompressedBytes, arena);
 	}
 };
 
@@ -454,6 +460,51 @@ struct GetDDMetricsRequest {
   }
 };
 
+// A range of keys and the number of recent commit conflicts on it, decayed by age
+struct ConflictHotspotRef {
+	KeyRangeRef range;
+	double conflicts;
+
+	ConflictHotspotRef() : conflicts(0) {}
+	ConflictHotspotRef(KeyRangeRef range, double conflicts) : range(range), conflicts(conflicts) {}
+	ConflictHotspotRef(Arena& arena, const ConflictHotspotRef& rhs) : range(arena, rhs.range), conflicts(rhs.conflicts) {}
+
+	int expectedSize() const { return range.expectedSize(); }
+
+	template <class Ar>
+	void serialize(Ar& ar) {
+		serializer(ar, range, conflicts);
+	}
+};
+
+struct GetConflictHotspotsReply {
+	constexpr static FileIdentifier file_identifier = 9301744;
+	Standalone<VectorRef<ConflictHotspotRef>> hotspots; // Sorted by descending conflicts
+
+	GetConflictHotspotsReply() {}
+
+	template <class Ar>
+	void serialize(Ar& ar) {
+		serializer(ar, hotspots);
+	}
+};
+
+// The ranges that a commit proxy has seen the most conflicts on.  Only transactions that report their conflicting keys
+// say which of their read conflict ranges conflicted, so only they are counted.
+struct GetConflictHotspotsRequest {
+	constexpr static FileIdentifier file_identifier = 15282606;
+	int limit;
+	ReplyPromise<struct GetConflictHotspotsReply> reply;
+
+	GetConflictHotspotsRequest() : limit(0) {}
+	explicit GetConflictHotspotsRequest(int limit) : limit(limit) {}
+
+	template <class Ar>
+	void serialize(Ar& ar) {
+		serializer(ar, limit, reply);
+	}
+};
+
 struct ProxySnapRequest
 {
 	constexpr static FileIdentifier file_identifier = 5427684;
@@ -50,6 +50,8 @@ static const char* typeString[] = { "SetValue",
 	                                "AndV2",
 	                                "CompareAndClear",
 	                                "Reserved_For_SpanContextMessage",
+	                                "SetIfAbsent",
+	                                "CompareAndSet",
 	                                "MAX_ATOMIC_OP" };
 
 struct MutationRef {
@@ -77,6 +79,8 @@ struct MutationRef {
 		AndV2,
 		CompareAndClear,
 		Reserved_For_SpanContextMessage /* See fdbserver/SpanContextMessage.h */,
+		SetIfAbsent,
+		CompareAndSet,
 		MAX_ATOMIC_OP
 	};
 	// This is stored this way for serialization purposes.
@@ -127,11 +131,12 @@ struct MutationRef {
 	enum {
 		ATOMIC_MASK = (1 << AddValue) | (1 << And) | (1 << Or) | (1 << Xor) | (1 << AppendIfFits) | (1 << Max) |
 		              (1 << Min) | (1 << SetVersionstampedKey) | (1 << SetVersionstampedValue) | (1 << ByteMin) |
-		              (1 << ByteMax) | (1 << MinV2) | (1 << AndV2) | (1 << CompareAndClear),
+		              (1 << ByteMax) | (1 << MinV2) | (1 << AndV2) | (1 << CompareAndClear) | (1 << SetIfAbsent) |
+		              (1 << CompareAndSet),
 		SINGLE_KEY_MASK = ATOMIC_MASK | (1 << SetValue),
 		NON_ASSOCIATIVE_MASK = (1 << AddValue) | (1 << Or) | (1 << Xor) | (1 << Max) | (1 << Min) |
 		                       (1 << SetVersionstampedKey) | (1 << SetVersionstampedValue) | (1 << MinV2) |
-		                       (1 << CompareAndClear)
+		                       (1 << CompareAndClear) | (1 << SetIfAbsent) | (1 << CompareAndSet)
 	};
 };
 
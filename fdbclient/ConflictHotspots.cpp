@@ -0,0 +1,123 @@
+/*
+ * ConflictHotspots.cpp
+ *
+ * This source file is part of the FoundationDB open source project
+ *
+ * Copyright 2013-2020 Apple Inc. and the FoundationDB project authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "fdbclient/ConflictHotspots.h"
+#include "flow/UnitTest.h"
+
+ConflictHotspots::ConflictHotspots(double halfLife, int maxRanges) : halfLife(halfLife), maxRanges(maxRanges) {}
+
+void ConflictHotspots::addConflicts(KeyRangeRef keys, double now, double conflicts) {
+	if (keys.empty()) {
+		return;
+	}
+	auto rs = counts.modify(keys);
+	for (auto r = rs.begin(); r != rs.end(); ++r) {
+		Count c;
+		c.conflicts = r->value().at(now, halfLife) + conflicts;
+		c.time = now;
+		r->value() = c;
+	}
+	counts.coalesce(keys);
+	if (counts.size() > maxRanges) {
+		prune(now);
+	}
+}
+
+double ConflictHotspots::conflicts(KeyRangeRef keys, double now) const {
+	double hottest = 0;
+	if (keys.empty()) {
+		return hottest;
+	}
+	for (auto r : counts.intersectingRanges(keys)) {
+		hottest = std::max(hottest, r.value().at(now, halfLife));
+	}
+	return hottest;
+}
+
+std::vector<std::pair<KeyRange, double>> ConflictHotspots::hottest(int limit, double now) const {
+	std::vector<std::pair<KeyRange, double>> result;
+	for (auto r : counts.ranges()) {
+		if (r.value().conflicts > 0) {
+			result.emplace_back(r.range(), r.value().at(now, halfLife));
+		}
+	}
+	std::sort(result.begin(), result.end(), [](auto const& a, auto const& b) { return a.second > b.second; });
+	if (result.size() > (size_t)limit) {
+		result.resize(limit);
+	}
+	return result;
+}
+
+// Keeps only the hottest maxRanges / 4 ranges.  The gaps between them are ranges of the map too, so it is left at most
+// half full, and each conflict adds at most two ranges.
+void ConflictHotspots::prune(double now) {
+	std::vector<double> decayed;
+	for (auto r : counts.ranges()) {
+		if (r.value().conflicts > 0) {
+			decayed.push_back(r.value().at(now, halfLife));
+		}
+	}
+	int keep = maxRanges / 4;
+	if (decayed.size() <= (size_t)keep) {
+		return;
+	}
+	std::nth_element(decayed.begin(), decayed.begin() + keep, decayed.end(), std::greater<double>());
+	double threshold = decayed[keep];
+
+	int kept = 0;
+	auto rs = counts.ranges();
+	for (auto r = rs.begin(); r != rs.end(); ++r) {
+		if (r->value().conflicts > 0) {
+			if (r->value().at(now, halfLife) > threshold && kept < keep) {
+				kept++;
+			} else {
+				r->value() = Count();
+			}
+		}
+	}
+	counts.coalesce(allKeys);
+}
+
+TEST_CASE("/fdbclient/ConflictHotspots") {
+	ConflictHotspots hotspots(1.0, 8);
+	hotspots.addConflicts(KeyRangeRef(LiteralStringRef("a"), LiteralStringRef("c")), 0);
+	hotspots.addConflicts(KeyRangeRef(LiteralStringRef("b"), LiteralStringRef("d")), 0);
+	ASSERT(hotspots.conflicts(KeyRangeRef(LiteralStringRef("a"), LiteralStringRef("b")), 0) == 1);
+	ASSERT(hotspots.conflicts(KeyRangeRef(LiteralStringRef("a"), LiteralStringRef("z")), 0) == 2);
+	ASSERT(hotspots.conflicts(KeyRangeRef(LiteralStringRef("x"), LiteralStringRef("z")), 0) == 0);
+
+	// One half life later
+	ASSERT(hotspots.conflicts(KeyRangeRef(LiteralStringRef("b"), LiteralStringRef("c")), 1) == 1);
+
+	auto hottest = hotspots.hottest(1, 0);
+	ASSERT(hottest.size() == 1);
+	ASSERT(hottest[0].first == KeyRangeRef(LiteralStringRef("b"), LiteralStringRef("c")));
+	ASSERT(hottest[0].second == 2);
+
+	// The hottest ranges survive pruning
+	for (int i = 0; i < 20; i++) {
+		Key k = StringRef(format("k%02d", i));
+		hotspots.addConflicts(KeyRangeRef(k, keyAfter(k)), 0);
+	}
+	ASSERT(hotspots.conflicts(KeyRangeRef(LiteralStringRef("b"), LiteralStringRef("c")), 0) == 2);
+	ASSERT(hotspots.hottest(100, 0).size() <= 8);
+
+	return Void();
+}
@@ -0,0 +1,59 @@
+/*
+ * ConflictHotspots.h
+ *
+ * This source file is part of the FoundationDB open source project
+ *
+ * Copyright 2013-2020 Apple Inc. and the FoundationDB project authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FDBCLIENT_CONFLICTHOTSPOTS_H
+#define FDBCLIENT_CONFLICTHOTSPOTS_H
+#pragma once
+
+#include "fdbclient/FDBTypes.h"
+#include "fdbclient/KeyRangeMap.h"
+
+// Counts the commit conflicts seen on each range of keys.  Each count decays by half every halfLife seconds, so the
+// ranges that transactions have conflicted on most often and most recently stand out.  Counts that have decayed the
+// most are dropped to keep the number of distinct ranges near maxRanges.
+class ConflictHotspots : NonCopyable {
+public:
+	ConflictHotspots(double halfLife, int maxRanges);
+
+	void addConflicts(KeyRangeRef keys, double now, double conflicts = 1);
+
+	// The conflict count of the hottest part of keys
+	double conflicts(KeyRangeRef keys, double now) const;
+
+	// Up to limit non-overlapping ranges with their conflict counts, the hottest first
+	std::vector<std::pair<KeyRange, double>> hottest(int limit, double now) const;
+
+private:
+	struct Count {
+		double conflicts = 0;
+		double time = 0;
+
+		double at(double now, double halfLife) const { return conflicts * exp2((time - now) / halfLife); }
+		bool operator==(const Count& r) const { return conflicts == r.conflicts && time == r.time; }
+	};
+
+	void prune(double now);
+
+	double halfLife;
+	int maxRanges;
+	KeyRangeMap<Count> counts;
+};
+
+#endif
@@ -25,17 +25,20 @@
 #include "fdbclient/StorageServerInterface.h"
 #include "flow/genericactors.actor.h"
 #include <vector>
+#include <map>
 #pragma once
 
 #include "fdbclient/NativeAPI.actor.h"
 #include "fdbclient/KeyRangeMap.h"
 #include "fdbclient/CommitProxyInterface.h"
+#include "fdbclient/ConflictHotspots.h"
 #include "fdbclient/SpecialKeySpace.actor.h"
 #include "fdbrpc/QueueModel.h"
 #include "fdbrpc/MultiInterface.h"
 #include "flow/TDMetric.actor.h"
 #include "fdbclient/EventTypes.actor.h"
 #include "fdbrpc/ContinuousSample.h"
+#include "flow/Histogram.h"
 #include "fdbrpc/Smoother.h"
 
 class StorageServerInfo : public ReferencedInterface<StorageServerInterface> {
@@ -66,6 +69,26 @@ struct LocationInfo : MultiInterface<ReferencedInterface<StorageServerInterface>
 	Reference<Locations> locations() {
 		return Reference<Locations>::addRef(this);
 	}
+
+	// Set when setCachedLocation() shares this between all the cached shards of a team, which it is then the entry
+	// for in cx->teamLocations (keyed by the sorted ids of the team's servers) until it is destroyed
+	DatabaseContext* cx = nullptr;
+	std::vector<UID> team;
+
+	virtual ~LocationInfo();
+};
+
+// A location cache entry.  Entries compare equal only when both are empty, so that the CoalescedKeyRangeMap never
+// merges the neighbouring shards of a team that share a LocationInfo into one range that no storage server serves.
+struct CachedLocation {
+	Reference<LocationInfo> info;
+	bool referenced = false; // Set when the entry is looked up, cleared as the eviction hand passes it
+
+	CachedLocation() {}
+	explicit CachedLocation(Reference<LocationInfo> info) : info(std::move(info)) {}
+
+	bool operator==(const CachedLocation& r) const { return !info && !r.info; }
+	bool operator!=(const CachedLocation& r) const { return !(*this == r); }
 };
 
 using CommitProxyInfo = ModelInterface<CommitProxyInterface>;
@@ -209,6 +232,10 @@ public:
 	// Management API, Attempt to kill or suspend a process, return 1 for success, 0 for failure
 	Future<int64_t> rebootWorker(StringRef address, bool check = false, int duration = 0);
 
+	// The next mutations of a change feed of range at versions in [begin, end), as soon as there are any.  The feed
+	// continues from one past the version of the last mutation returned, and has reached end when none are returned.
+	Future<Standalone<VectorRef<ChangeFeedMutationRef>>> readChangeFeed(KeyRange range, Version begin, Version end);
+
 //private: 
 	explicit DatabaseContext( Reference<AsyncVar<Reference<ClusterConnectionFile>>> connectionFile, Reference<AsyncVar<ClientDBInfo>> clientDBInfo,
 		Future<Void> clientInfoMonitor, TaskPriority taskID, LocalityData const& clientLocality, 
@@ -247,6 +274,31 @@ public:
 	};
 	std::map<uint32_t, VersionBatcher> versionBatcher;
 
+	// The newest unlocked read version obtained at each priority, and when it was requested, for transactions that
+	// accept a read version lease.  A lease older than this client's latest commit is not used, so that leased read
+	// versions always see this client's own commits.
+	struct ReadVersionLease {
+		double requestTime = 0;
+		GetReadVersionReply reply;
+	};
+	std::map<TransactionPriority, ReadVersionLease> readVersionLeases;
+	Version latestCommitVersion = invalidVersion;
+
+	struct GetValueBatchRequest {
+		Reference<LocationInfo> location;
+		Key key;
+		Version version;
+		Promise<GetValueReply> reply;
+
+		GetValueBatchRequest(Reference<LocationInfo> location, Key key, Version version)
+		  : location(location), key(key), version(version) {}
+	};
+
+	// Point read batching: getValue calls for the same storage team and version that arrive within
+	// GET_VALUE_BATCH_DELAY of each other are sent as one GetValuesRequest
+	PromiseStream<GetValueBatchRequest> getValueBatchStream;
+	Future<Void> getValueBatcher;
+
 	AsyncTrigger connectionFileChangedTrigger;
 
 	// Disallow any reads at a read version lower than minAcceptableReadVersion.  This way the client does not have to
@@ -265,9 +317,11 @@ public:
 
 	// Cache of location information
 	int locationCacheSize;
-	CoalescedKeyRangeMap<Reference<LocationInfo>> locationCache;
+	CoalescedKeyRangeMap<CachedLocation> locationCache;
+	Key locationCacheHand; // Where the CLOCK eviction in setCachedLocation() resumes
 
 	std::map< UID, StorageServerInfo* > server_interf;
+	std::map<std::vector<UID>, LocationInfo*> teamLocations;
 
 	UID dbId;
 	bool internal; // Only contexts created through the C client and fdbcli are non-internal
@@ -279,6 +333,7 @@ public:
 	Counter transactionReadVersions;
 	Counter transactionReadVersionsThrottled;
 	Counter transactionReadVersionsCompleted;
+	Counter transactionReadVersionsLeased;
 	Counter transactionReadVersionBatches;
 	Counter transactionBatchReadVersions;
 	Counter transactionDefaultReadVersions;
@@ -292,6 +347,9 @@ public:
 	Counter transactionGetKeyRequests;
 	Counter transactionGetValueRequests;
 	Counter transactionGetRangeRequests;
+	Counter transactionGetRangeStreamRequests;
+	Counter transactionGetRangeAggregateRequests;
+	Counter transactionGetRangeFilteredRequests;
 	Counter transactionWatchRequests;
 	Counter transactionGetAddressesForKeyRequests;
 	Counter transactionBytesRead;
@@ -318,9 +376,38 @@ public:
 
 	ContinuousSample<double> latencies, readLatencies, commitLatencies, GRVLatencies, mutationsPerCommit, bytesPerCommit;
 
+	// Latencies of the operations of sampled transactions, logged with the transaction metrics
+	Reference<Histogram> profileGRVLatency, profileGetLatency, profileGetRangeLatency, profileCommitLatency;
+	void initProfileHistograms();
+
 	int outstandingWatches;
 	int maxOutstandingWatches;
 
+	// Watches of the same key and value from different transactions share one watch on the storage servers
+	struct SharedWatch : ReferenceCounted<SharedWatch> {
+		Optional<Value> value;
+		Version version; // The read version the shared watch was started at
+		Future<Version> changed; // The version a storage server read a different value at
+		int subscribers = 0;
+	};
+	std::map<Key, Reference<SharedWatch>> sharedWatches;
+
+	// With SHARD_METRICS_STREAM, waitStorageMetrics of a single shard watches it through one subscription per storage
+	// server rather than with its own WaitMetricsRequest.  A subscription that failed is replaced when next needed.
+	struct ShardMetricsSubscription : ReferenceCounted<ShardMetricsSubscription> {
+		UID id;
+		StorageServerInterface server;
+		ReplyPromiseStream<ShardMetricsStreamReply> stream;
+		int64_t nextWatchId = 0;
+		std::unordered_map<int64_t, Promise<StorageMetrics>> watches;
+		Standalone<VectorRef<ShardMetricsWatchRef>> toWatch; // Not yet sent to the server
+		Standalone<VectorRef<int64_t>> toCancel;
+		Future<Void> reader;
+		Future<Void> sender;
+		Optional<Error> failed;
+	};
+	std::map<UID, Reference<ShardMetricsSubscription>> shardMetricsSubscriptions;
+
 	int snapshotRywEnabled;
 
 	int transactionTracingEnabled;
@@ -350,6 +437,7 @@ public:
 	double healthMetricsLastUpdated;
 	double detailedHealthMetricsLastUpdated;
 	Smoother smoothMidShardSize;
+	ConflictHotspots conflictHotspots; // The read conflict ranges that transactions reporting conflicting keys failed on
 
 	UniqueOrderedOptionList<FDBTransactionOptions> transactionDefaults;
 
@@ -478,6 +478,22 @@ typedef Standalone<struct KeySelectorRef> KeySelector;
 
 enum { invalidVersion = -1, latestVersion = -2, MAX_VERSION = std::numeric_limits<int64_t>::max() };
 
+// One mutation of a change feed, as returned to the client API.  It is laid out like FDBChangeFeedMutation in fdb_c.h,
+// so type is a MutationRef::Type: a set of param1 to param2, or a clear of [param1, param2).
+#pragma pack(push, 4)
+struct ChangeFeedMutationRef {
+	Version version;
+	int type;
+	StringRef param1, param2;
+
+	ChangeFeedMutationRef() : version(invalidVersion), type(0) {}
+	ChangeFeedMutationRef(Version version, int type, StringRef param1, StringRef param2)
+	  : version(version), type(type), param1(param1), param2(param2) {}
+
+	int expectedSize() const { return param1.size() + param2.size(); }
+};
+#pragma pack(pop)
+
 inline Key keyAfter( const KeyRef& key ) {
 	if(key == LiteralStringRef("\xff\xff"))
 		return key;
@@ -704,6 +720,101 @@ struct Traceable<RangeResultRef> : std::true_type {
 	}
 };
 
+// Aggregates of the key-value pairs in a range, which storage servers compute so that only the result is sent
+struct RangeAggregate {
+	constexpr static FileIdentifier file_identifier = 9471236;
+	int64_t count = 0; // Number of key-value pairs
+	int64_t bytes = 0; // Total size of their keys and values
+	// Sum of the values as little-endian integers, the way ADD reads them: only the first 8 bytes of a value count, and
+	// the sum wraps on overflow
+	int64_t sum = 0;
+	Optional<Key> firstKey, lastKey;
+
+	static uint64_t littleEndianValue(ValueRef value) {
+		uint64_t v = 0;
+		for (int i = std::min(value.size(), 8) - 1; i >= 0; i--) {
+			v = (v << 8) | value[i];
+		}
+		return v;
+	}
+
+	void add(KeyValueRef kv) {
+		if (!firstKey.present()) {
+			firstKey = Key(kv.key);
+		}
+		lastKey = Key(kv.key);
+		count++;
+		bytes += kv.key.size() + kv.value.size();
+		sum = (int64_t)((uint64_t)sum + littleEndianValue(kv.value));
+	}
+
+	// Adds the aggregates of a range following the one this covers
+	void append(RangeAggregate const& next) {
+		if (!next.count) {
+			return;
+		}
+		if (!firstKey.present()) {
+			firstKey = next.firstKey;
+		}
+		lastKey = next.lastKey;
+		count += next.count;
+		bytes += next.bytes;
+		sum = (int64_t)((uint64_t)sum + (uint64_t)next.sum);
+	}
+
+	template <class Ar>
+	void serialize(Ar& ar) {
+		serializer(ar, count, bytes, sum, firstKey, lastKey);
+	}
+};
+
+// A predicate and projection that storage servers apply to a range read, so that rows it rejects are not sent.
+// A row matches when every condition that is set holds.
+struct RangeReadFilterRef {
+	constexpr static FileIdentifier file_identifier = 9471239;
+	// The key must be at least as long as keyMask, and equal keyMaskValue in the bits set in keyMask
+	StringRef keyMask, keyMaskValue;
+	StringRef keySuffix;
+	StringRef valuePrefix;
+	// When not negative, values are truncated to this many bytes
+	int maxValueLength = -1;
+
+	RangeReadFilterRef() {}
+	RangeReadFilterRef(Arena& p, const RangeReadFilterRef& toCopy)
+	  : keyMask(p, toCopy.keyMask), keyMaskValue(p, toCopy.keyMaskValue), keySuffix(p, toCopy.keySuffix),
+	    valuePrefix(p, toCopy.valuePrefix), maxValueLength(toCopy.maxValueLength) {}
+
+	bool isValid() const { return keyMask.size() == keyMaskValue.size(); }
+
+	bool matches(KeyValueRef kv) const {
+		if (kv.key.size() < keyMask.size() || !kv.key.endsWith(keySuffix) || !kv.value.startsWith(valuePrefix)) {
+			return false;
+		}
+		for (int i = 0; i < keyMask.size(); i++) {
+			if ((kv.key[i] ^ keyMaskValue[i]) & keyMask[i]) {
+				return false;
+			}
+		}
+		return true;
+	}
+
+	// The part of a matching value that is returned
+	ValueRef project(ValueRef value) const {
+		return maxValueLength >= 0 && value.size() > maxValueLength ? value.substr(0, maxValueLength) : value;
+	}
+
+	int expectedSize() const {
+		return keyMask.expectedSize() + keyMaskValue.expectedSize() + keySuffix.expectedSize() +
+		       valuePrefix.expectedSize();
+	}
+
+	template <class Ar>
+	void serialize(Ar& ar) {
+		serializer(ar, keyMask, keyMaskValue, keySuffix, valuePrefix, maxValueLength);
+	}
+};
+typedef Standalone<RangeReadFilterRef> RangeReadFilter;
+
 struct KeyValueStoreType {
 	constexpr static FileIdentifier file_identifier = 6560359;
 	// These enumerated values are stored in the database configuration, so should NEVER be changed.
@@ -861,6 +972,38 @@ struct StorageBytes {
 	}
 };
 
+// How far a storage engine's background work (such as compaction) has fallen behind its writes, for engines that slow
+// down or stop writes until it catches up.  Each limit is 0 if the engine has no such limit.
+struct StorageEngineDebt {
+	int64_t pendingCompactionBytes = 0; // Estimated bytes background work has to rewrite to catch up
+	int64_t pendingCompactionBytesLimit = 0; // pendingCompactionBytes at which writes stop
+	int64_t level0Files = 0; // Files waiting to be merged into the rest of the store
+	int64_t level0FilesLimit = 0; // level0Files at which writes stop
+	bool stalled = false; // Writes are being slowed down or stopped right now
+
+	StorageEngineDebt() {}
+
+	// How close the engine is to stopping writes, from 0 to 1
+	double stallFraction() const {
+		if (stalled) {
+			return 1.0;
+		}
+		double f = 0;
+		if (pendingCompactionBytesLimit > 0) {
+			f = std::max(f, (double)pendingCompactionBytes / pendingCompactionBytesLimit);
+		}
+		if (level0FilesLimit > 0) {
+			f = std::max(f, (double)level0Files / level0FilesLimit);
+		}
+		return std::min(f, 1.0);
+	}
+
+	template <class Ar>
+	void serialize(Ar& ar) {
+		serializer(ar, pendingCompactionBytes, pendingCompactionBytesLimit, level0Files, level0FilesLimit, stalled);
+	}
+};
+
 struct LogMessageVersion {
 	// Each message pushed into the log system has a unique, totally ordered LogMessageVersion
 	// See ILogSystem::push() for how these are assigned
@@ -27,6 +27,7 @@
 #include "fdbclient/SystemData.h"
 #include "fdbclient/KeyBackedTypes.h"
 #include "fdbclient/JsonBuilder.h"
+#include "flow/UnitTest.h"
 
 #include <cinttypes>
 #include <ctime>
@@ -38,6 +39,9 @@
 #include <boost/algorithm/string/split.hpp>
 #include <boost/algorithm/string/classification.hpp>
 #include <algorithm>
+#ifdef HAVE_ZLIB
+#include <zlib.h>
+#endif
 
 #include "flow/actorcompiler.h"  // This must be the last #include.
 
@@ -442,6 +446,118 @@ namespace fileBackup {
 		return pad.substr(0, size);
 	}
 
+	// Returns a compressed range file block holding kvs[0, count) from begin to end, or nothing if it would not fit in
+	// blockSize (or zlib is unavailable)
+	Optional<Standalone<StringRef>> encodeCompressedRangeBlock(KeyRef begin, const KeyValueRef* kvs, int count, KeyRef end,
+	                                                           int blockSize) {
+#ifdef HAVE_ZLIB
+		std::string raw;
+		auto appendWithLen = [&raw](StringRef s) {
+			uint32_t len = bigEndian32((uint32_t)s.size());
+			raw.append((const char*)&len, sizeof(len));
+			raw.append((const char*)s.begin(), s.size());
+		};
+		for (int i = 0; i < count; i++) {
+			appendWithLen(kvs[i].key);
+			appendWithLen(kvs[i].value);
+		}
+		appendWithLen(end);
+
+		int headerLen = sizeof(uint32_t) * 4 + begin.size();
+		if (headerLen >= blockSize) return Optional<Standalone<StringRef>>();
+		uLongf compressedLen = compressBound(raw.size());
+		Standalone<StringRef> block = makeString(headerLen + compressedLen);
+		uint8_t* p = mutateString(block);
+		if (compress(p + headerLen, &compressedLen, (const Bytef*)raw.data(), raw.size()) != Z_OK ||
+		    headerLen + compressedLen > blockSize) {
+			return Optional<Standalone<StringRef>>();
+		}
+
+		uint32_t header[] = { BACKUP_AGENT_COMPRESSED_SNAPSHOT_FILE_VERSION, bigEndian32((uint32_t)begin.size()),
+			                  bigEndian32((uint32_t)raw.size()), bigEndian32((uint32_t)compressedLen) };
+		memcpy(p, header, sizeof(uint32_t) * 2);
+		memcpy(p + sizeof(uint32_t) * 2, begin.begin(), begin.size());
+		memcpy(p + sizeof(uint32_t) * 2 + begin.size(), header + 2, sizeof(uint32_t) * 2);
+		return Standalone<StringRef>(block.substr(0, headerLen + compressedLen), block.arena());
+#else
+		return Optional<Standalone<StringRef>>();
+#endif
+	}
+
+	// Decodes the rest of a compressed range file block after its header into results, as decodeRangeFileBlock does
+	void decodeCompressedRangeBlock(StringRefReader& reader, Standalone<VectorRef<KeyValueRef>>& results) {
+		uint32_t kLen = reader.consumeNetworkUInt32();
+		const uint8_t* k = reader.consume(kLen);
+		results.push_back(results.arena(), KeyValueRef(KeyRef(k, kLen), ValueRef()));
+
+		uint32_t rawLen = reader.consumeNetworkUInt32();
+		uint32_t compressedLen = reader.consumeNetworkUInt32();
+		const uint8_t* compressed = reader.consume(compressedLen);
+#ifdef HAVE_ZLIB
+		// zlib cannot compress by more than about 1000:1, so anything claiming more is corrupt
+		if (rawLen / 1024 > compressedLen) throw restore_corrupted_data();
+		uint8_t* raw = new (results.arena()) uint8_t[rawLen];
+		uLongf len = rawLen;
+		if (uncompress(raw, &len, compressed, compressedLen) != Z_OK || len != rawLen) throw restore_corrupted_data();
+
+		StringRefReader body(StringRef(raw, rawLen), restore_corrupted_data());
+		loop {
+			kLen = body.consumeNetworkUInt32();
+			k = body.consume(kLen);
+			// The end key is the only key not followed by a value
+			if (body.eof()) {
+				results.push_back(results.arena(), KeyValueRef(KeyRef(k, kLen), ValueRef()));
+				break;
+			}
+			uint32_t vLen = body.consumeNetworkUInt32();
+			const uint8_t* v = body.consume(vLen);
+			results.push_back(results.arena(), KeyValueRef(KeyRef(k, kLen), ValueRef(v, vLen)));
+		}
+#else
+		throw restore_unsupported_file_version();
+#endif
+	}
+
+	// A compressed partitioned log block is its version, the big endian raw and compressed lengths, and the zlib
+	// compressed (version, sub, size, mutation) records that an uncompressed block would hold.
+	Optional<Standalone<StringRef>> encodeCompressedLogBlock(StringRef records, int blockSize) {
+#ifdef HAVE_ZLIB
+		const int headerLen = sizeof(uint32_t) * 3;
+		uLongf compressedLen = compressBound(records.size());
+		Standalone<StringRef> block = makeString(headerLen + compressedLen);
+		uint8_t* p = mutateString(block);
+		if (compress(p + headerLen, &compressedLen, records.begin(), records.size()) != Z_OK ||
+		    headerLen + compressedLen > blockSize) {
+			return Optional<Standalone<StringRef>>();
+		}
+
+		uint32_t header[] = { PARTITIONED_MLOG_COMPRESSED_VERSION, bigEndian32((uint32_t)records.size()),
+			                  bigEndian32((uint32_t)compressedLen) };
+		memcpy(p, header, headerLen);
+		return Standalone<StringRef>(block.substr(0, headerLen + compressedLen), block.arena());
+#else
+		return Optional<Standalone<StringRef>>();
+#endif
+	}
+
+	Standalone<StringRef> decodeCompressedLogBlock(StringRefReader& reader) {
+		uint32_t rawLen = reader.consumeNetworkUInt32();
+		uint32_t compressedLen = reader.consumeNetworkUInt32();
+		const uint8_t* compressed = reader.consume(compressedLen);
+#ifdef HAVE_ZLIB
+		// zlib cannot compress by more than about 1000:1, so anything claiming more is corrupt
+		if (rawLen / 1024 > compressedLen) throw restore_corrupted_data();
+		Standalone<StringRef> records = makeString(rawLen);
+		uLongf len = rawLen;
+		if (uncompress(mutateString(records), &len, compressed, compressedLen) != Z_OK || len != rawLen) {
+			throw restore_corrupted_data();
+		}
+		return records;
+#else
+		throw restore_unsupported_file_version();
+#endif
+	}
+
 	// File Format handlers.
 	// Both Range and Log formats are designed to be readable starting at any 1MB boundary
 	// so they can be read in parallel.
@@ -474,9 +590,75 @@ namespace fileBackup {
 	//   if the next KV pair wouldn't fit within the block after the value
 	//   then the space after the final key to the next 1MB boundary would
 	//   just be padding anyway.
+	//
+	// Compressed files (BACKUP_AGENT_COMPRESSED_SNAPSHOT_FILE_VERSION) keep the same fixed size blocks, so they are
+	// split and read exactly as above, but each block holds as many kv pairs as will compress into it:
+	//
+	//   Header, begin key, raw length, compressed length, compressed([Key, Value]... end key), padding
+	//
+	// The begin key is left uncompressed so that the range a block starts can be read without decompressing it.
 	struct RangeFileWriter {
-	    RangeFileWriter(Reference<IBackupFile> file = Reference<IBackupFile>(), int blockSize = 0)
-	      : file(file), blockSize(blockSize), blockEnd(0), fileVersion(BACKUP_AGENT_SNAPSHOT_FILE_VERSION) {}
+	    RangeFileWriter(Reference<IBackupFile> file = Reference<IBackupFile>(), int blockSize = 0, bool compress = false)
+	      : file(file), blockSize(blockSize), blockEnd(0), fileVersion(BACKUP_AGENT_SNAPSHOT_FILE_VERSION), begun(false),
+	        pendingBytes(0), rawBlockTarget(2 * (int64_t)blockSize) {
+#ifdef HAVE_ZLIB
+			if (compress) fileVersion = BACKUP_AGENT_COMPRESSED_SNAPSHOT_FILE_VERSION;
+#endif
+		}
+
+		bool compressed() const { return fileVersion == BACKUP_AGENT_COMPRESSED_SNAPSHOT_FILE_VERSION; }
+
+		// Writes blocks of the pending kv pairs. Without an end key, the last pending pair is held back to begin the next
+		// block, and blocks are only written once there are enough pending bytes to fill one.
+		ACTOR static Future<Void> writeCompressedBlocks(RangeFileWriter* self, Optional<Key> end) {
+			loop {
+				state int n = self->pending.size();
+				if (!end.present()) {
+					if (self->pendingBytes < self->rawBlockTarget || n < 2) return Void();
+					--n;
+				}
+
+				// Take fewer pairs until they compress into a block
+				state Standalone<StringRef> block;
+				loop {
+					KeyRef blockEnd = n < self->pending.size() ? self->pending[n].key : end.get();
+					Optional<Standalone<StringRef>> b =
+					    encodeCompressedRangeBlock(self->pendingBegin, self->pending.begin(), n, blockEnd, self->blockSize);
+					if (b.present()) {
+						block = b.get();
+						break;
+					}
+					if (n == 0) throw backup_bad_block_size();
+					n = n * 3 / 4;
+				}
+
+				// Pad out the previous block and write this one
+				state int bytesLeft = self->blockEnd - self->file->size();
+				if (bytesLeft > 0) {
+					state Value paddingFFs = makePadding(bytesLeft);
+					wait(self->file->append(paddingFFs.begin(), bytesLeft));
+				}
+				self->blockEnd += self->blockSize;
+				wait(self->file->append(block.begin(), block.size()));
+
+				// Aim to fill the next block as well as this one was filled
+				int64_t rawBytes = 0;
+				for (int i = 0; i < n; i++) rawBytes += self->pending[i].expectedSize();
+				self->rawBlockTarget =
+				    std::max<int64_t>(self->blockSize, rawBytes * 0.95 * self->blockSize / block.size());
+
+				if (n == self->pending.size()) {
+					self->pending = Standalone<VectorRef<KeyValueRef>>();
+					self->pendingBytes = 0;
+					return Void();
+				}
+				self->pendingBegin = self->pending[n].key;
+				Standalone<VectorRef<KeyValueRef>> rest;
+				rest.append_deep(rest.arena(), self->pending.begin() + n, self->pending.size() - n);
+				self->pending = rest;
+				self->pendingBytes -= rawBytes;
+			}
+		}
 
 		// Handles the first block and internal blocks.  Ends current block if needed.
 		// The final flag is used in simulation to pad the file's final block to a whole block size
@@ -531,6 +713,13 @@ namespace fileBackup {
 
 		// Start a new block if needed, then write the key and value
 		ACTOR static Future<Void> writeKV_impl(RangeFileWriter *self, Key k, Value v) {
+			if (self->compressed()) {
+				self->pending.push_back_deep(self->pending.arena(), KeyValueRef(k, v));
+				self->pendingBytes += self->pending.back().expectedSize();
+				wait(writeCompressedBlocks(self, Optional<Key>()));
+				return Void();
+			}
+
 			int toWrite = sizeof(int32_t) + k.size() + sizeof(int32_t) + v.size();
 			wait(self->newBlockIfNeeded(toWrite));
 			wait(self->file->appendStringRefWithLen(k));
@@ -544,6 +733,16 @@ namespace fileBackup {
 
 		// Write begin key or end key.
 		ACTOR static Future<Void> writeKey_impl(RangeFileWriter *self, Key k) {
+			if (self->compressed()) {
+				if (!self->begun) {
+					self->pendingBegin = k;
+					self->begun = true;
+				} else {
+					wait(writeCompressedBlocks(self, k));
+				}
+				return Void();
+			}
+
 			int toWrite = sizeof(uint32_t) + k.size();
 			wait(self->newBlockIfNeeded(toWrite));
 			wait(self->file->appendStringRefWithLen(k));
@@ -560,9 +759,16 @@ namespace fileBackup {
 		uint32_t fileVersion;
 		Key lastKey;
 		Key lastValue;
+
+		// Compressed files only
+		bool begun;
+		Key pendingBegin;
+		Standalone<VectorRef<KeyValueRef>> pending;
+		int64_t pendingBytes;
+		int64_t rawBlockTarget;
 	};
 
-	ACTOR Future<Standalone<VectorRef<KeyValueRef>>> decodeRangeFileBlock(Reference<IAsyncFile> file, int64_t offset, int len) {
+	ACTOR Future<Standalone<StringRef>> readFileBlock(Reference<IAsyncFile> file, int64_t offset, int len) {
 		state Standalone<StringRef> buf = makeString(len);
 		int rLen = wait(file->read(mutateString(buf), len, offset));
 		if(rLen != len)
@@ -570,12 +776,23 @@ namespace fileBackup {
 
 	    simulateBlobFailure();
 
-	    Standalone<VectorRef<KeyValueRef>> results({}, buf.arena());
-		state StringRefReader reader(buf, restore_corrupted_data());
+		return buf;
+	}
+
+	void decodeRangeFileBlock(StringRef buf, Standalone<VectorRef<KeyValueRef>>& results, std::string const& filename,
+	                          int64_t offset) {
+		StringRefReader reader(buf, restore_corrupted_data());
 
 		try {
-			// Read header, currently only decoding BACKUP_AGENT_SNAPSHOT_FILE_VERSION
-			if(reader.consume<int32_t>() != BACKUP_AGENT_SNAPSHOT_FILE_VERSION)
+			// Read header, currently only decoding BACKUP_AGENT_SNAPSHOT_FILE_VERSION and its compressed form
+			int32_t fileVersion = reader.consume<int32_t>();
+			if (fileVersion == BACKUP_AGENT_COMPRESSED_SNAPSHOT_FILE_VERSION) {
+				decodeCompressedRangeBlock(reader, results);
+				for (auto b : reader.remainder())
+					if (b != 0xFF) throw restore_corrupted_data_padding();
+				return;
+			}
+			if(fileVersion != BACKUP_AGENT_SNAPSHOT_FILE_VERSION)
 				throw restore_unsupported_file_version();
 
 			// Read begin key, if this fails then block was invalid.
@@ -610,20 +827,24 @@ namespace fileBackup {
 				if(b != 0xFF)
 					throw restore_corrupted_data_padding();
 
-		    return results;
-
 		} catch(Error &e) {
 		    TraceEvent(SevWarn, "FileRestoreDecodeRangeFileBlockFailed")
 		        .error(e)
-		        .detail("Filename", file->getFilename())
+		        .detail("Filename", filename)
 		        .detail("BlockOffset", offset)
-		        .detail("BlockLen", len)
+		        .detail("BlockLen", buf.size())
 		        .detail("ErrorRelativeOffset", reader.rptr - buf.begin())
 		        .detail("ErrorAbsoluteOffset", reader.rptr - buf.begin() + offset);
 		    throw;
 		}
 	}
 
+	ACTOR Future<Standalone<VectorRef<KeyValueRef>>> decodeRangeFileBlock(Reference<IAsyncFile> file, int64_t offset, int len) {
+		Standalone<StringRef> buf = wait(readFileBlock(file, offset, len));
+		Standalone<VectorRef<KeyValueRef>> results({}, buf.arena());
+		decodeRangeFileBlock(buf, results, file->getFilename(), offset);
+		return results;
+	}
 
 	// Very simple format compared to KeyRange files.
 	// Header, [Key, Value]... Key len
@@ -1057,6 +1278,90 @@ namespace fileBackup {
 			return usedFile;
 		}
 
+		// If this snapshot is incremental and range was written by range files of the last snapshot that cover exactly
+		// range and that no mutation copied by a log task has modified since, then add those files to this snapshot's
+		// range file map instead of reading the range again.  Restoring an older range file is always correct because
+		// the mutation logs from its version onwards are replayed over it.
+		// Returns whether or not the range was covered this way.
+		ACTOR static Future<bool> reuseRangeFiles(Database cx, Reference<Task> task, Reference<TaskBucket> taskBucket, KeyRange range) {
+			state Reference<ReadYourWritesTransaction> tr(new ReadYourWritesTransaction(cx));
+			state BackupConfig backup(task);
+			state Optional<bool> reuse;
+			state Optional<Version> changeTrackingBeginVersion;
+			state BackupConfig::RangeFileMapT::PairsType files;
+			state BackupConfig::ModifiedRangeMapT::PairsType modifiedBefore;
+			state BackupConfig::ModifiedRangeMapT::PairsType modifiedInside;
+			state Version minVersion;
+
+			// Avoid unnecessary conflict by prevent taskbucket's automatic timeout extension
+			// because the following transaction loop extends and updates the task.
+			wait(task->extendMutex.take());
+			state FlowLock::Releaser releaser(task->extendMutex, 1);
+
+			loop {
+				try {
+					tr->setOption(FDBTransactionOptions::ACCESS_SYSTEM_KEYS);
+					tr->setOption(FDBTransactionOptions::LOCK_AWARE);
+
+					wait(store(reuse, backup.snapshotReuseRangeFiles().get(tr))
+						&& store(changeTrackingBeginVersion, backup.changeTrackingBeginVersion().get(tr))
+						&& store(files, backup.lastSnapshotRangeFileMap().getRange(tr, keyAfter(range.begin), keyAfter(range.end), CLIENT_KNOBS->TOO_MANY))
+						&& store(modifiedBefore, backup.modifiedRangeMap().getRange(tr, normalKeys.begin, range.begin, 1, false, true))
+						&& store(modifiedInside, backup.modifiedRangeMap().getRange(tr, range.begin, range.end, CLIENT_KNOBS->TOO_MANY)));
+
+					if(!reuse.orDefault(false) || !changeTrackingBeginVersion.present() || files.empty())
+						return false;
+
+					// The files must tile the range exactly, which they do unless the shards have been split since
+					Key expectedBegin = range.begin;
+					minVersion = std::numeric_limits<Version>::max();
+					for(auto &f : files) {
+						if(f.second.begin != expectedBegin)
+							return false;
+						expectedBegin = f.first;
+						minVersion = std::min(minVersion, f.second.version);
+					}
+					if(expectedBegin != range.end || minVersion < changeTrackingBeginVersion.get())
+						return false;
+
+					for(auto &m : modifiedInside) {
+						if(m.second.second > minVersion)
+							return false;
+					}
+					if(!modifiedBefore.empty() && modifiedBefore.front().second.first > range.begin && modifiedBefore.front().second.second > minVersion)
+						return false;
+
+					Params.beginKey().set(task, range.end);
+					state Version newTimeout = wait(taskBucket->extendTimeout(tr, task, true));
+
+					state int i = 0;
+					state int64_t reusedBytes = 0;
+					for(; i < files.size(); ++i) {
+						Optional<BackupConfig::RangeSlice> s = wait(backup.snapshotRangeFileMap().get(tr, files[i].first));
+						if(!s.present() || s.get().begin >= files[i].second.begin) {
+							backup.snapshotRangeFileMap().set(tr, files[i].first, files[i].second);
+						}
+						reusedBytes += files[i].second.fileSize;
+					}
+
+					wait(tr->commit());
+					task->timeoutVersion = newTimeout;
+
+					TraceEvent("FileBackupReusedRangeFiles")
+						.suppressFor(60)
+						.detail("BackupUID", backup.getUid())
+						.detail("BeginKey", range.begin.printable())
+						.detail("EndKey", range.end.printable())
+						.detail("Files", files.size())
+						.detail("Bytes", reusedBytes)
+						.detail("MinVersion", minVersion);
+					return true;
+				} catch(Error &e) {
+					wait(tr->onError(e));
+				}
+			}
+		}
+
 		ACTOR static Future<Key> addTask(Reference<ReadYourWritesTransaction> tr, Reference<TaskBucket> taskBucket, Reference<Task> parentTask, int priority, Key begin, Key end, TaskCompletionKey completionKey, Reference<TaskFuture> waitFor = Reference<TaskFuture>(), Version scheduledVersion = invalidVersion) {
 			Key key = wait(addBackupTask(BackupRangeTaskFunc::name,
 										 BackupRangeTaskFunc::version,
@@ -1101,6 +1406,13 @@ namespace fileBackup {
 				return Void();
 			}
 
+			if (CLIENT_KNOBS->BACKUP_FULL_SNAPSHOT_INTERVAL > 1) {
+				bool reused = wait(reuseRangeFiles(cx, task, taskBucket, KeyRangeRef(beginKey, endKey)));
+				if (reused) {
+					return Void();
+				}
+			}
+
 			// Read everything from beginKey to endKey, write it to an output file, run the output file processor, and
 			// then set on_done. If we are still writing after X seconds, end the output file and insert a new backup_range
 			// task for the remainder.
@@ -1195,7 +1507,7 @@ namespace fileBackup {
 					outFile = f;
 
 					// Initialize range file writer and write begin key
-					rangeFile = RangeFileWriter(outFile, blockSize);
+					rangeFile = RangeFileWriter(outFile, blockSize, CLIENT_KNOBS->BACKUP_RANGEFILE_COMPRESSION);
 					wait(rangeFile.writeKey(beginKey));
 				}
 
@@ -1790,6 +2102,188 @@ namespace fileBackup {
 	StringRef BackupSnapshotDispatchTask::name = LiteralStringRef("file_backup_dispatch_ranges_5.2");
 	REGISTER_TASKFUNC(BackupSnapshotDispatchTask);
 
+	// Collects the key ranges written by the mutation log values of a BackupLogRangeTask, so that later snapshots can
+	// tell which range files of the last snapshot are still current.  Past BACKUP_CHANGED_RANGES_LIMIT ranges, neighbours
+	// are merged, which can only make more of the key space look changed.
+	struct ChangedRanges {
+		// All parts of one version's log value are in the same log range and arrive in order, but the log ranges are
+		// read in parallel so the parts of different versions interleave.
+		std::map<Version, std::string> partialValues;
+		std::map<Key, Key> ranges;
+
+		bool empty() const { return ranges.empty(); }
+
+		void addLogValue(KeyRef key, ValueRef value) {
+			std::pair<Version, uint32_t> versionPart = decodeBKMutationLogKey(key);
+			auto it = partialValues.find(versionPart.first);
+			if (versionPart.second == 0) {
+				it = partialValues.emplace(versionPart.first, std::string()).first;
+			} else if (it == partialValues.end()) {
+				return;
+			}
+			it->second.append((const char*)value.begin(), value.size());
+
+			const int headerSize = sizeof(uint64_t) + sizeof(uint32_t);
+			uint32_t totalBytes = 0;
+			if (it->second.size() < headerSize) {
+				return;
+			}
+			memcpy(&totalBytes, it->second.data() + sizeof(uint64_t), sizeof(uint32_t));
+			if (it->second.size() < headerSize + totalBytes) {
+				return;
+			}
+
+			Arena arena;
+			StringRef mutations = expandBackupLogValue(arena, StringRef(it->second));
+			memcpy(&totalBytes, mutations.begin() + sizeof(uint64_t), sizeof(uint32_t));
+			StringRef rest = mutations.substr(headerSize, totalBytes);
+			while (rest.size() >= BackupAgentBase::logHeaderSize) {
+				uint32_t header[3];
+				memcpy(header, rest.begin(), sizeof(header));
+				rest = rest.substr(sizeof(header));
+				if (header[1] + header[2] > rest.size()) {
+					throw restore_corrupted_data();
+				}
+				KeyRef param1 = rest.substr(0, header[1]);
+				if (header[0] == MutationRef::ClearRange) {
+					add(KeyRangeRef(param1, rest.substr(header[1], header[2])));
+				} else {
+					add(singleKeyRange(param1, arena));
+				}
+				rest = rest.substr(header[1] + header[2]);
+			}
+			partialValues.erase(it);
+		}
+
+		void add(KeyRangeRef range) {
+			range = range & normalKeys;
+			if (range.empty()) {
+				return;
+			}
+			Key begin = range.begin;
+			Key end = range.end;
+			auto it = ranges.upper_bound(begin);
+			if (it != ranges.begin() && std::prev(it)->second >= begin) {
+				--it;
+				begin = it->first;
+			}
+			while (it != ranges.end() && it->first <= end) {
+				end = std::max(end, it->second);
+				it = ranges.erase(it);
+			}
+			ranges[begin] = end;
+
+			if (ranges.size() > CLIENT_KNOBS->BACKUP_CHANGED_RANGES_LIMIT) {
+				std::map<Key, Key> merged;
+				for (auto i = ranges.begin(); i != ranges.end();) {
+					auto first = i++;
+					merged[first->first] = i == ranges.end() ? first->second : (i++)->second;
+				}
+				ranges.swap(merged);
+			}
+		}
+	};
+
+	// Records in the backup config that the given ranges, widened to the shards containing them, were modified
+	// before version.  Overlapping entries of the disjoint modifiedRangeMap are merged with them.
+	ACTOR static Future<Void> recordChangedRanges(Database cx, Reference<Task> task, Reference<TaskBucket> taskBucket,
+	                                              std::vector<KeyRange> changed, Version version) {
+		state Reference<ReadYourWritesTransaction> tr(new ReadYourWritesTransaction(cx));
+		state BackupConfig config(task);
+		state std::vector<Future<Key>> shardBegins;
+		state std::vector<Future<Key>> shardEnds;
+		state std::vector<KeyRange> shards;
+		state std::vector<Future<BackupConfig::ModifiedRangeMapT::PairsType>> entriesBefore;
+		state std::vector<Future<BackupConfig::ModifiedRangeMapT::PairsType>> entriesInside;
+		state int i;
+
+		loop {
+			try {
+				tr->setOption(FDBTransactionOptions::ACCESS_SYSTEM_KEYS);
+				tr->setOption(FDBTransactionOptions::LOCK_AWARE);
+
+				shardBegins.clear();
+				shardEnds.clear();
+				for (auto& r : changed) {
+					shardBegins.push_back(tr->getKey(lastLessOrEqual(r.begin.withPrefix(keyServersPrefix))));
+					shardEnds.push_back(tr->getKey(firstGreaterOrEqual(r.end.withPrefix(keyServersPrefix))));
+				}
+				wait(waitForAll(shardBegins) && waitForAll(shardEnds) && taskBucket->keepRunning(tr, task));
+
+				shards.clear();
+				for (i = 0; i < changed.size(); ++i) {
+					Key begin = shardBegins[i].get().startsWith(keyServersPrefix)
+					                ? shardBegins[i].get().removePrefix(keyServersPrefix)
+					                : normalKeys.begin;
+					Key end = shardEnds[i].get().startsWith(keyServersPrefix)
+					              ? std::min(shardEnds[i].get().removePrefix(keyServersPrefix), normalKeys.end)
+					              : normalKeys.end;
+					if (!shards.empty() && shards.back().end >= begin) {
+						shards.back() = KeyRangeRef(shards.back().begin, std::max(shards.back().end, KeyRef(end)));
+					} else {
+						shards.push_back(KeyRangeRef(begin, end));
+					}
+				}
+
+				entriesBefore.clear();
+				entriesInside.clear();
+				for (auto& shard : shards) {
+					entriesBefore.push_back(
+					    config.modifiedRangeMap().getRange(tr, normalKeys.begin, shard.begin, 1, false, true));
+					entriesInside.push_back(
+					    config.modifiedRangeMap().getRange(tr, shard.begin, shard.end, CLIENT_KNOBS->TOO_MANY));
+				}
+				wait(waitForAll(entriesBefore) && waitForAll(entriesInside));
+
+				std::map<Key, std::pair<Key, Version>> entries;
+				for (i = 0; i < shards.size(); ++i) {
+					entries.insert(entriesBefore[i].get().begin(), entriesBefore[i].get().end());
+					entries.insert(entriesInside[i].get().begin(), entriesInside[i].get().end());
+				}
+
+				std::set<Key> erased;
+				std::set<Key> written;
+				for (auto& shard : shards) {
+					Key begin = shard.begin;
+					Key end = shard.end;
+					Version v = version;
+					auto it = entries.upper_bound(begin);
+					if (it != entries.begin() && std::prev(it)->second.first > begin) {
+						--it;
+					}
+					while (it != entries.end() && it->first < end) {
+						begin = std::min(begin, it->first);
+						end = std::max(end, it->second.first);
+						v = std::max(v, it->second.second);
+						erased.insert(it->first);
+						it = entries.erase(it);
+					}
+					entries[begin] = std::make_pair(end, v);
+					written.insert(begin);
+				}
+
+				for (auto& k : erased) {
+					if (!written.count(k)) {
+						config.modifiedRangeMap().erase(tr, k);
+					}
+				}
+				for (auto& k : written) {
+					auto it = entries.find(k);
+					if (it != entries.end()) {
+						config.modifiedRangeMap().set(tr, k, it->second);
+					} else {
+						config.modifiedRangeMap().erase(tr, k);
+					}
+				}
+
+				wait(tr->commit());
+				return Void();
+			} catch (Error& e) {
+				wait(tr->onError(e));
+			}
+		}
+	}
+
 	struct BackupLogRangeTaskFunc : BackupTaskFuncBase {
 		static StringRef name;
 	    static constexpr uint32_t version = 1;
@@ -1824,6 +2318,7 @@ namespace fileBackup {
 
 			state BackupConfig config(task);
 			state Reference<IBackupContainer> bc;
+			state Optional<Version> changeTrackingBeginVersion;
 
 			state Reference<ReadYourWritesTransaction> tr(new ReadYourWritesTransaction(cx));
 			loop{
@@ -1837,6 +2332,7 @@ namespace fileBackup {
 						// Backup container must be present if we're still here
 						Reference<IBackupContainer> _bc = wait(config.backupContainer().getOrThrow(tr));
 						bc = _bc;
+						wait(store(changeTrackingBeginVersion, config.changeTrackingBeginVersion().get(tr)));
 					}
 
 					Version currentVersion = tr->getReadVersion().get();
@@ -1887,6 +2383,7 @@ namespace fileBackup {
 			});
 
 			state Version lastVersion;
+			state ChangedRanges changes;
 			try {
 				loop {
 					state RangeResultWithVersion r = waitNext(results.getFuture());
@@ -1897,6 +2394,9 @@ namespace fileBackup {
 						// Remove the backupLogPrefix + UID bytes from the key
 						wait(logFile.writeKV(r.first[i].key.substr(backupLogPrefixBytes + 16), r.first[i].value));
 						lastVersion = r.second;
+						if (changeTrackingBeginVersion.present()) {
+							changes.addLogValue(r.first[i].key, r.first[i].value);
+						}
 					}
 				}
 			} catch (Error &e) {
@@ -1923,6 +2423,14 @@ namespace fileBackup {
 				.detail("EndVersion", endVersion)
 				.detail("LastReadVersion", latestVersion);
 
+			if (!changes.empty()) {
+				std::vector<KeyRange> changed;
+				for (auto& r : changes.ranges) {
+					changed.push_back(KeyRangeRef(r.first, r.second));
+				}
+				wait(recordChangedRanges(cx, task, taskBucket, changed, endVersion));
+			}
+
 			Params.fileSize().set(task, outFile->size());
 
 			return Void();
@@ -2221,6 +2729,41 @@ namespace fileBackup {
 			static TaskParam<Version> endVersion() { return LiteralStringRef(__FUNCTION__); }
 		} Params;
 
+		// Replace the last snapshot range file map with the files of the snapshot just written, for the next snapshot
+		// to reuse.  Nothing reads the map until the next snapshot starts in finish(), so it is rewritten in batches.
+		ACTOR static Future<Void> saveSnapshotRangeFiles(Database cx, Reference<TaskBucket> taskBucket, Reference<Task> task, std::vector<std::pair<Key, BackupConfig::RangeSlice>> files) {
+			state BackupConfig config(task);
+			state Reference<ReadYourWritesTransaction> tr(new ReadYourWritesTransaction(cx));
+			state int batchSize = BUGGIFY ? 1 : 10000;
+			state int begin = 0;
+			state int end;
+
+			loop {
+				try {
+					tr->setOption(FDBTransactionOptions::ACCESS_SYSTEM_KEYS);
+					tr->setOption(FDBTransactionOptions::LOCK_AWARE);
+
+					wait(taskBucket->keepRunning(tr, task));
+
+					if(begin == 0)
+						config.lastSnapshotRangeFileMap().clear(tr);
+
+					end = std::min<int>(files.size(), begin + batchSize);
+					for(int i = begin; i < end; ++i) {
+						config.lastSnapshotRangeFileMap().set(tr, files[i].first, files[i].second);
+					}
+
+					wait(tr->commit());
+					begin = end;
+					if(begin == files.size())
+						return Void();
+					tr->reset();
+				} catch(Error &e) {
+					wait(tr->onError(e));
+				}
+			}
+		}
+
 		ACTOR static Future<Void> _execute(Database cx, Reference<TaskBucket> taskBucket, Reference<FutureBucket> futureBucket, Reference<Task> task) {
 			state BackupConfig config(task);
 			state Reference<IBackupContainer> bc;
@@ -2231,6 +2774,7 @@ namespace fileBackup {
 			state std::map<Key, BackupConfig::RangeSlice> localmap;
 			state Key startKey;
 			state int batchSize = BUGGIFY ? 1 : 1000000;
+			state Optional<Version> changeTrackingBeginVersion;
 
 			loop {
 				try {
@@ -2241,7 +2785,8 @@ namespace fileBackup {
 
 					if(!bc) {
 						// Backup container must be present if we're still here
-						wait(store(bc, config.backupContainer().getOrThrow(tr)));
+						wait(store(bc, config.backupContainer().getOrThrow(tr))
+							&& store(changeTrackingBeginVersion, config.changeTrackingBeginVersion().get(tr)));
 					}
 
 					BackupConfig::RangeFileMapT::PairsType rangeresults = wait(config.snapshotRangeFileMap().getRange(tr, startKey, {}, batchSize));
@@ -2262,6 +2807,7 @@ namespace fileBackup {
 
 			std::vector<std::string> files;
 			std::vector<std::pair<Key, Key>> beginEndKeys;
+			state std::vector<std::pair<Key, BackupConfig::RangeSlice>> snapshotFiles;
 			state Version maxVer = 0;
 			state Version minVer = std::numeric_limits<Version>::max();
 			state int64_t totalBytes = 0;
@@ -2279,6 +2825,7 @@ namespace fileBackup {
 
 					// Add (beginKey, endKey) pairs to the list
 					beginEndKeys.emplace_back(i->second.begin, i->first);
+					snapshotFiles.push_back(*i);
 
 					// Update version range seen
 					if(r.version < minVer)
@@ -2309,6 +2856,10 @@ namespace fileBackup {
 				.detail("EndVersion", maxVer)
 				.detail("TotalBytes", totalBytes);
 
+			if(CLIENT_KNOBS->BACKUP_FULL_SNAPSHOT_INTERVAL > 1 && changeTrackingBeginVersion.present() && !snapshotFiles.empty()) {
+				wait(saveSnapshotRangeFiles(cx, taskBucket, task, snapshotFiles));
+			}
+
 			return Void();
 		}
 
@@ -2325,12 +2876,18 @@ namespace fileBackup {
 			state Optional<Version> restorableVersion;
 			state Optional<Version> firstSnapshotEndVersion;
 			state Optional<std::string> tag;
+			state Optional<Version> changeTrackingBeginVersion;
+			state Optional<bool> reusedRangeFiles;
+			state Optional<int64_t> incrementalSnapshotCount;
 
 			wait(store(stopWhenDone, config.stopWhenDone().getOrThrow(tr))
 						&& store(backupState, config.stateEnum().getOrThrow(tr))
 						&& store(restorableVersion, config.getLatestRestorableVersion(tr))
 						&& store(firstSnapshotEndVersion, config.firstSnapshotEndVersion().get(tr))
-						&& store(tag, config.tag().get(tr)));
+						&& store(tag, config.tag().get(tr))
+						&& store(changeTrackingBeginVersion, config.changeTrackingBeginVersion().get(tr))
+						&& store(reusedRangeFiles, config.snapshotReuseRangeFiles().get(tr))
+						&& store(incrementalSnapshotCount, config.incrementalSnapshotCount().get(tr)));
 
 			// If restorable, update the last restorable version for this tag
 			if(restorableVersion.present() && tag.present()) {
@@ -2349,6 +2906,14 @@ namespace fileBackup {
 			Reference<TaskFuture> snapshotDoneFuture = task->getDoneFuture(futureBucket);
 			if(!stopWhenDone) {
 				wait(config.initNewSnapshot(tr) && success(BackupSnapshotDispatchTask::addTask(tr, taskBucket, task, 1, TaskCompletionKey::signal(snapshotDoneFuture))));
+
+				// Every BACKUP_FULL_SNAPSHOT_INTERVAL'th snapshot reads all ranges again, which bounds how far back
+				// the oldest range file of a snapshot, and so the mutation logs needed to restore it, can reach.
+				int64_t count = reusedRangeFiles.orDefault(false) ? incrementalSnapshotCount.orDefault(0) + 1 : 0;
+				config.incrementalSnapshotCount().set(tr, count);
+				if(changeTrackingBeginVersion.present() && count + 1 < CLIENT_KNOBS->BACKUP_FULL_SNAPSHOT_INTERVAL) {
+					config.snapshotReuseRangeFiles().set(tr, true);
+				}
 			} else {
 				// Set the done future as the snapshot is now complete.
 				wait(snapshotDoneFuture->set(tr, taskBucket));
@@ -2483,6 +3048,8 @@ namespace fileBackup {
 				for (auto& backupRange : backupRanges) {
 					config.startMutationLogs(tr, backupRange, destUidValue);
 				}
+				// The log tasks record which ranges they see modified so that later snapshots can skip the others
+				config.changeTrackingBeginVersion().set(tr, beginVersion);
 			}
 
 			config.stateEnum().set(tr, EBackupState::STATE_RUNNING);
@@ -5027,3 +5594,67 @@ void simulateBlobFailure() {
 		}
 	}
 }
+
+#ifdef HAVE_ZLIB
+TEST_CASE("/backup/rangefile/compressedBlock") {
+	int blockSize = 64 * 1024;
+	Standalone<VectorRef<KeyValueRef>> kvs;
+	for (int i = 0; i < 1000; i++) {
+		kvs.push_back_deep(kvs.arena(), KeyValueRef(StringRef(format("key%08d", i)),
+		                                            StringRef(std::string(deterministicRandom()->randomInt(0, 200), 'a' + i % 26))));
+	}
+
+	Optional<Standalone<StringRef>> block = fileBackup::encodeCompressedRangeBlock(
+	    LiteralStringRef("a"), kvs.begin(), kvs.size(), LiteralStringRef("z"), blockSize);
+	ASSERT(block.present() && block.get().size() <= blockSize);
+
+	Standalone<StringRef> padded = block.get().withSuffix(fileBackup::makePadding(blockSize - block.get().size()));
+	StringRefReader reader(padded, restore_corrupted_data());
+	ASSERT(reader.consume<int32_t>() == BACKUP_AGENT_COMPRESSED_SNAPSHOT_FILE_VERSION);
+	Standalone<VectorRef<KeyValueRef>> results;
+	fileBackup::decodeCompressedRangeBlock(reader, results);
+	ASSERT(results.size() == kvs.size() + 2);
+	ASSERT(results.front().key == LiteralStringRef("a") && results.back().key == LiteralStringRef("z"));
+	for (int i = 0; i < kvs.size(); i++) {
+		ASSERT(results[i + 1].key == kvs[i].key && results[i + 1].value == kvs[i].value);
+	}
+	for (auto b : reader.remainder()) {
+		ASSERT(b == 0xFF);
+	}
+
+	// Pairs that do not compress into a block are refused rather than overflowing it
+	Standalone<VectorRef<KeyValueRef>> random;
+	for (int i = 0; i < 3000; i++) {
+		random.push_back_deep(random.arena(), KeyValueRef(StringRef(deterministicRandom()->randomUniqueID().toString()),
+		                                                  StringRef(deterministicRandom()->randomUniqueID().toString())));
+	}
+	ASSERT(!fileBackup::encodeCompressedRangeBlock(LiteralStringRef("a"), random.begin(), random.size(),
+	                                               LiteralStringRef("z"), blockSize)
+	            .present());
+	return Void();
+}
+#endif
+
+#ifdef HAVE_ZLIB
+TEST_CASE("/backup/logfile/compressedBlock") {
+	int blockSize = 64 * 1024;
+	std::string records;
+	for (int i = 0; i < 2000; i++) {
+		records += format("%08d", i / 10) + std::string(deterministicRandom()->randomInt(0, 100), 'a' + i % 26);
+	}
+
+	Optional<Standalone<StringRef>> block = fileBackup::encodeCompressedLogBlock(StringRef(records), blockSize);
+	ASSERT(block.present() && block.get().size() <= blockSize);
+
+	Standalone<StringRef> padded = block.get().withSuffix(fileBackup::makePadding(blockSize - block.get().size()));
+	StringRefReader reader(padded, restore_corrupted_data());
+	ASSERT(reader.consume<int32_t>() == PARTITIONED_MLOG_COMPRESSED_VERSION);
+	ASSERT(fileBackup::decodeCompressedLogBlock(reader) == StringRef(records));
+	for (auto b : reader.remainder()) {
+		ASSERT(b == 0xFF);
+	}
+
+	ASSERT(!fileBackup::encodeCompressedLogBlock(StringRef(records), block.get().size() - 1).present());
+	return Void();
+}
+#endif
@@ -216,8 +216,10 @@ namespace HTTP {
 		// There should be content (or at least metadata describing that there is no content.
 		// Chunked transfer and 'normal' mode (content length given, data in one segment after headers) are supported.
 		if(r->contentLen >= 0) {
-			// Use response content as the buffer so there's no need to copy it later.
-			r->content = buf.substr(pos);
+			// Use response content as the buffer so there's no need to copy it later, and size it for all of the
+			// content and the slack of one more read so that it is not reallocated and copied as it grows.
+			r->content.reserve(std::max<int64_t>(r->contentLen, buf.size() - pos) + CLIENT_KNOBS->HTTP_READ_SIZE);
+			r->content.append(buf, pos, std::string::npos);
 			pos = 0;
 
 			// Read until there are at least contentLen bytes available at pos
@@ -39,6 +39,14 @@ public:
 	// It is guaranteed, however, that the ThreadFuture will hold a reference to the memory. It will persist until the ThreadFuture's 
 	// ThreadSingleAssignmentVar has its memory released or it is destroyed.
 	virtual ThreadFuture<Optional<Value>> get(const KeyRef& key, bool snapshot=false) = 0;
+	// The keys that are present, with their values, in the order given
+	virtual ThreadFuture<Standalone<RangeResultRef>> getMulti(const VectorRef<KeyRef>& keys, bool snapshot=false) = 0;
+	// One result for each key, holding the key and value if it is present, followed by one for each range.  A range is
+	// read up to its limit in rows, or completely if the limit is not positive.
+	virtual ThreadFuture<Standalone<VectorRef<RangeResultRef>>> getBatch(const VectorRef<KeyRef>& keys,
+	                                                                    const VectorRef<KeyRangeRef>& ranges,
+	                                                                    const std::vector<int>& rangeLimits,
+	                                                                    bool snapshot = false) = 0;
 	virtual ThreadFuture<Key> getKey(const KeySelectorRef& key, bool snapshot=false) = 0;
 	virtual ThreadFuture<Standalone<RangeResultRef>> getRange(const KeySelectorRef& begin, const KeySelectorRef& end, int limit, bool snapshot=false, bool reverse=false) = 0;
 	virtual ThreadFuture<Standalone<RangeResultRef>> getRange(const KeySelectorRef& begin, const KeySelectorRef& end, GetRangeLimits limits, bool snapshot=false, bool reverse=false) = 0;
@@ -51,6 +59,8 @@ public:
 	virtual ThreadFuture<int64_t> getEstimatedRangeSizeBytes(const KeyRangeRef& keys) = 0;
 	virtual ThreadFuture<Standalone<VectorRef<KeyRef>>> getRangeSplitPoints(const KeyRangeRef& range,
 	                                                                        int64_t chunkSize) = 0;
+	// The count, size, little-endian sum and first and last keys of the key-value pairs in the range
+	virtual ThreadFuture<RangeAggregate> getRangeAggregate(const KeyRangeRef& keys, bool snapshot = false) = 0;
 
 	virtual void atomicOp(const KeyRef& key, const ValueRef& value, uint32_t operationType) = 0;
 	virtual void set(const KeyRef& key, const ValueRef& value) = 0;
@@ -87,6 +97,10 @@ public:
 
 	// Management API, Attempt to kill or suspend a process, return 1 for success, 0 for failure
 	virtual ThreadFuture<int64_t> rebootWorker(const StringRef& address, bool check, int duration) = 0;
+
+	// The next mutations of a change feed of range at versions in [begin, end), as soon as there are any
+	virtual ThreadFuture<Standalone<VectorRef<ChangeFeedMutationRef>>> readChangeFeed(const KeyRangeRef& range,
+	                                                                                  Version begin, Version end) = 0;
 };
 
 class IClientApi {
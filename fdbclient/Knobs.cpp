@@ -65,6 +65,9 @@ void ClientKnobs::initialize(bool randomize) {
 	init( DEFAULT_MAX_BACKOFF,                     1.0 );
 	init( BACKOFF_GROWTH_RATE,                     2.0 );
 	init( RESOURCE_CONSTRAINED_MAX_BACKOFF,       30.0 );
+	init( CONFLICT_HOTSPOT_HALF_LIFE,              5.0 ); if( randomize && BUGGIFY ) CONFLICT_HOTSPOT_HALF_LIFE = 0.5;
+	init( CONFLICT_HOTSPOT_MAX_RANGES,            1000 ); if( randomize && BUGGIFY ) CONFLICT_HOTSPOT_MAX_RANGES = 8;
+	init( CONFLICT_HOTSPOT_BACKOFF,               .005 ); if( randomize && BUGGIFY ) CONFLICT_HOTSPOT_BACKOFF = 0.0; // Retry delay per recent conflict on the hottest range a transaction conflicted on
 	init( PROXY_COMMIT_OVERHEAD_BYTES,              23 ); //The size of serializing 7 tags (3 primary, 3 remote, 1 log router) + 2 for the tag length
 	init( SHARD_STAT_SMOOTH_AMOUNT,                5.0 );
 	init( INIT_MID_SHARD_BYTES,                 200000 ); if( randomize && BUGGIFY ) INIT_MID_SHARD_BYTES = 40000; // The same value as SERVER_KNOBS->MIN_SHARD_BYTES
@@ -75,18 +78,29 @@ void ClientKnobs::initialize(bool randomize) {
 	init( VALUE_SIZE_LIMIT,                        1e5 );
 	init( SPLIT_KEY_SIZE_LIMIT,                    KEY_SIZE_LIMIT/2 ); if( randomize && BUGGIFY ) SPLIT_KEY_SIZE_LIMIT = KEY_SIZE_LIMIT - 31;//serverKeysPrefixFor(UID()).size() - 1;
 	init( METADATA_VERSION_CACHE_SIZE,            1000 );
+	init( RYW_SNAPSHOT_CACHE_BYTES_LIMIT,          1e8 ); if( randomize && BUGGIFY ) RYW_SNAPSHOT_CACHE_BYTES_LIMIT = deterministicRandom()->randomInt(0, 10000);
+	init( RANGE_PREFETCH_BYTES,                  80000 ); if( randomize && BUGGIFY ) RANGE_PREFETCH_BYTES = deterministicRandom()->coinflip() ? 0 : deterministicRandom()->randomInt(1, 1000);
 
 	init( MAX_BATCH_SIZE,                         1000 ); if( randomize && BUGGIFY ) MAX_BATCH_SIZE = 1;
 	init( GRV_BATCH_TIMEOUT,                     0.005 ); if( randomize && BUGGIFY ) GRV_BATCH_TIMEOUT = 0.1;
 	init( BROADCAST_BATCH_SIZE,                     20 ); if( randomize && BUGGIFY ) BROADCAST_BATCH_SIZE = 1;
+	init( MAX_READ_VERSION_LEASE,                  1.0 );
+	init( GET_VALUE_BATCHING,                    false ); if( randomize && BUGGIFY ) GET_VALUE_BATCHING = true; // Coalesce concurrent point reads to the same storage team into GetValuesRequests
+	init( GET_VALUE_BATCH_DELAY,                0.0005 ); if( randomize && BUGGIFY ) GET_VALUE_BATCH_DELAY = deterministicRandom()->coinflip() ? 0.0 : 0.01;
+	init( GET_VALUE_BATCH_MAX_KEYS,                100 ); if( randomize && BUGGIFY ) GET_VALUE_BATCH_MAX_KEYS = 2;
 	init( TRANSACTION_TIMEOUT_DELAY_INTERVAL,     10.0 ); if( randomize && BUGGIFY ) TRANSACTION_TIMEOUT_DELAY_INTERVAL = 1.0;
 
 	init( LOCATION_CACHE_EVICTION_SIZE,         600000 );
 	init( LOCATION_CACHE_EVICTION_SIZE_SIM,         10 ); if( randomize && BUGGIFY ) LOCATION_CACHE_EVICTION_SIZE_SIM = 3;
+	init( LOCATION_CACHE_MISS_PREFETCH_SHARDS,      10 ); if( randomize && BUGGIFY ) LOCATION_CACHE_MISS_PREFETCH_SHARDS = deterministicRandom()->randomInt(1, 4);
 
 	init( GET_RANGE_SHARD_LIMIT,                     2 );
 	init( WARM_RANGE_SHARD_LIMIT,                  100 );
 	init( STORAGE_METRICS_SHARD_LIMIT,             100 ); if( randomize && BUGGIFY ) STORAGE_METRICS_SHARD_LIMIT = 3;
+	init( SHARD_METRICS_STREAM,                  false ); if( randomize && BUGGIFY ) SHARD_METRICS_STREAM = true;
+	init( SHARD_METRICS_WATCH_BATCH_DELAY,        0.01 ); if( randomize && BUGGIFY ) SHARD_METRICS_WATCH_BATCH_DELAY = deterministicRandom()->coinflip() ? 0.0 : 0.5;
+	init( CHANGE_FEED_SHARD_LIMIT,                 100 );
+	init( RANGE_AGGREGATE_SHARD_LIMIT,             100 ); if( randomize && BUGGIFY ) RANGE_AGGREGATE_SHARD_LIMIT = 3;
 	init( SHARD_COUNT_LIMIT,                        80 ); if( randomize && BUGGIFY ) SHARD_COUNT_LIMIT = 3;
 	init( STORAGE_METRICS_UNFAIR_SPLIT_LIMIT,  2.0/3.0 );
 	init( STORAGE_METRICS_TOO_MANY_SHARDS_DELAY,  15.0 );
@@ -121,6 +135,8 @@ void ClientKnobs::initialize(bool randomize) {
 	init( TASKBUCKET_CHECK_ACTIVE_AMOUNT,           10 );
 	init( TASKBUCKET_TIMEOUT_VERSIONS,     60*CORE_VERSIONSPERSECOND ); if( randomize && BUGGIFY ) TASKBUCKET_TIMEOUT_VERSIONS = 30*CORE_VERSIONSPERSECOND;
 	init( TASKBUCKET_MAX_TASK_KEYS,               1000 ); if( randomize && BUGGIFY ) TASKBUCKET_MAX_TASK_KEYS = 20;
+	init( TASKBUCKET_CLAIM_SCAN_ROWS,              100 ); if( randomize && BUGGIFY ) TASKBUCKET_CLAIM_SCAN_ROWS = 1;
+	init( TASKBUCKET_MAX_CLAIM_BATCH,               10 ); if( randomize && BUGGIFY ) TASKBUCKET_MAX_CLAIM_BATCH = 1;
 
 	//Backup
 	init( BACKUP_LOCAL_FILE_WRITE_BLOCK,     1024*1024 ); if( randomize && BUGGIFY ) BACKUP_LOCAL_FILE_WRITE_BLOCK = 100;
@@ -133,6 +149,8 @@ void ClientKnobs::initialize(bool randomize) {
 	init( BACKUP_SNAPSHOT_DISPATCH_INTERVAL_SEC,  10 * 60 );  // 10 minutes
 	init( BACKUP_DEFAULT_SNAPSHOT_INTERVAL_SEC,   3600 * 24 * 10); // 10 days
 	init( BACKUP_SHARD_TASK_LIMIT,                1000 ); if( randomize && BUGGIFY ) BACKUP_SHARD_TASK_LIMIT = 4;
+	init( BACKUP_FULL_SNAPSHOT_INTERVAL,             4 ); if( randomize && BUGGIFY ) BACKUP_FULL_SNAPSHOT_INTERVAL = deterministicRandom()->randomInt(1, 3);
+	init( BACKUP_CHANGED_RANGES_LIMIT,            1000 ); if( randomize && BUGGIFY ) BACKUP_CHANGED_RANGES_LIMIT = 4;
 	init( BACKUP_AGGREGATE_POLL_RATE_UPDATE_INTERVAL, 60);
 	init( BACKUP_AGGREGATE_POLL_RATE,              2.0 ); // polls per second target for all agents on the cluster
 	init( BACKUP_LOG_WRITE_BATCH_MAX_SIZE,         1e6 ); //Must be much smaller than TRANSACTION_SIZE_LIMIT
@@ -156,6 +174,7 @@ void ClientKnobs::initialize(bool randomize) {
 	init( VERSIONS_PER_SECOND,                     1e6 ); // Must be the same as SERVER_KNOBS->VERSIONS_PER_SECOND
 	init( SIM_BACKUP_TASKS_PER_AGENT,               10 );
 	init( BACKUP_RANGEFILE_BLOCK_SIZE,      1024 * 1024);
+	init( BACKUP_RANGEFILE_COMPRESSION,           false ); if( randomize && BUGGIFY ) BACKUP_RANGEFILE_COMPRESSION = true; // Requires zlib; such range files cannot be restored by older versions
 	init( BACKUP_LOGFILE_BLOCK_SIZE,        1024 * 1024);
 	init( BACKUP_DISPATCH_ADDTASK_SIZE,             50 );
 	init( RESTORE_DISPATCH_ADDTASK_SIZE,           150 );
@@ -194,14 +213,18 @@ void ClientKnobs::initialize(bool randomize) {
 	init( BLOBSTORE_CONCURRENT_UPLOADS, BACKUP_TASKS_PER_AGENT*2 );
 	init( BLOBSTORE_CONCURRENT_LISTS,               20 );
 	init( BLOBSTORE_CONCURRENT_REQUESTS, BLOBSTORE_CONCURRENT_UPLOADS + BLOBSTORE_CONCURRENT_LISTS + 5);
+	init( BLOBSTORE_MAX_CONNECTION_IDLE,            10 );
+	init( BLOBSTORE_MAX_POOLED_CONNECTIONS, BLOBSTORE_CONCURRENT_REQUESTS );
 
 	init( BLOBSTORE_CONCURRENT_WRITES_PER_FILE,      5 );
 	init( BLOBSTORE_CONCURRENT_READS_PER_FILE,       3 );
 	init( BLOBSTORE_READ_BLOCK_SIZE,       1024 * 1024 );
 	init( BLOBSTORE_READ_AHEAD_BLOCKS,               0 );
 	init( BLOBSTORE_READ_CACHE_BLOCKS_PER_FILE,      2 );
+	init( BLOBSTORE_READ_AHEAD_MAX_BLOCKS,          32 ); if( randomize && BUGGIFY ) BLOBSTORE_READ_AHEAD_MAX_BLOCKS = 0;
 	init( BLOBSTORE_MULTIPART_MAX_PART_SIZE,  20000000 );
 	init( BLOBSTORE_MULTIPART_MIN_PART_SIZE,   5242880 );
+	init( BLOBSTORE_MULTIPART_TARGET_SECONDS,        2 );
 
 	// These are basically unlimited by default but can be used to reduce blob IO if needed
 	init( BLOBSTORE_REQUESTS_PER_SECOND,            200 );
@@ -221,9 +244,12 @@ void ClientKnobs::initialize(bool randomize) {
 		CSI_SIZE_LIMIT = deterministicRandom()->randomInt(1024 * 1024, 100 * 1024 * 1024); // 1 MB - 100 MB
 	}
 	init(CSI_STATUS_DELAY,						  10.0  );
+	init(CSI_PROFILE_SINK,                          "" );
 
 	init( CONSISTENCY_CHECK_RATE_LIMIT_MAX,        50e6 ); // Limit in per sec
 	init( CONSISTENCY_CHECK_ONE_ROUND_TARGET_COMPLETION_TIME,	7 * 24 * 60 * 60 ); // 7 days
+	init( CONSISTENCY_CHECK_USE_CHECKSUMS,                  false );
+	init( CONSISTENCY_CHECK_CHECKSUM_BYTES,                   1e6 ); if( randomize && BUGGIFY ) CONSISTENCY_CHECK_CHECKSUM_BYTES = 100;
 	
 	//fdbcli		
 	init( CLI_CONNECT_PARALLELISM,                  400 );
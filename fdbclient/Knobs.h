@@ -58,6 +58,9 @@ public:
 	double DEFAULT_MAX_BACKOFF;
 	double BACKOFF_GROWTH_RATE;
 	double RESOURCE_CONSTRAINED_MAX_BACKOFF;
+	double CONFLICT_HOTSPOT_HALF_LIFE;
+	int CONFLICT_HOTSPOT_MAX_RANGES;
+	double CONFLICT_HOTSPOT_BACKOFF;
 	int PROXY_COMMIT_OVERHEAD_BYTES;
 	double SHARD_STAT_SMOOTH_AMOUNT;
 	int INIT_MID_SHARD_BYTES;
@@ -68,19 +71,30 @@ public:
 	int64_t VALUE_SIZE_LIMIT;
 	int64_t SPLIT_KEY_SIZE_LIMIT;
 	int METADATA_VERSION_CACHE_SIZE;
+	int64_t RYW_SNAPSHOT_CACHE_BYTES_LIMIT; // Past this, a read your writes transaction forgets what it has read rather than keep it
+	int RANGE_PREFETCH_BYTES; // Byte limit for reading the next batch of a streaming range read before it is asked for; 0 disables
 
 	int MAX_BATCH_SIZE;
 	double GRV_BATCH_TIMEOUT;
 	int BROADCAST_BATCH_SIZE;
+	double MAX_READ_VERSION_LEASE; // The longest read version lease a transaction may ask for, in seconds
+	bool GET_VALUE_BATCHING;
+	double GET_VALUE_BATCH_DELAY;
+	int GET_VALUE_BATCH_MAX_KEYS;
 	double TRANSACTION_TIMEOUT_DELAY_INTERVAL;
 
 	// When locationCache in DatabaseContext gets to be this size, items will be evicted
 	int LOCATION_CACHE_EVICTION_SIZE;
 	int LOCATION_CACHE_EVICTION_SIZE_SIM;
+	int LOCATION_CACHE_MISS_PREFETCH_SHARDS; // On a miss, the locations of up to this many shards from the key onwards are fetched
 
 	int GET_RANGE_SHARD_LIMIT;
 	int WARM_RANGE_SHARD_LIMIT;
 	int STORAGE_METRICS_SHARD_LIMIT;
+	bool SHARD_METRICS_STREAM; // Wait for the metrics of single-shard ranges through one subscription per storage server
+	double SHARD_METRICS_WATCH_BATCH_DELAY; // Shard metrics watches started within this long of each other are sent together
+	int CHANGE_FEED_SHARD_LIMIT; // A change feed streams from one storage server per shard, so it can span at most this many
+	int RANGE_AGGREGATE_SHARD_LIMIT; // Shards of a range aggregate that are requested at once
 	int SHARD_COUNT_LIMIT;
 	double STORAGE_METRICS_UNFAIR_SPLIT_LIMIT;
 	double STORAGE_METRICS_TOO_MANY_SHARDS_DELAY;
@@ -118,6 +132,8 @@ public:
 	int TASKBUCKET_CHECK_ACTIVE_AMOUNT;
 	int TASKBUCKET_TIMEOUT_VERSIONS;
 	int TASKBUCKET_MAX_TASK_KEYS;
+	int TASKBUCKET_CLAIM_SCAN_ROWS; // Keys scanned to choose tasks to claim from
+	int TASKBUCKET_MAX_CLAIM_BATCH; // Tasks a dispatcher claims in one transaction
 
 	// Backup
 	int BACKUP_LOCAL_FILE_WRITE_BLOCK;
@@ -130,6 +146,8 @@ public:
 	int BACKUP_SNAPSHOT_DISPATCH_INTERVAL_SEC;
 	int BACKUP_DEFAULT_SNAPSHOT_INTERVAL_SEC;
 	int BACKUP_SHARD_TASK_LIMIT;
+	int BACKUP_FULL_SNAPSHOT_INTERVAL; // Every Nth snapshot rewrites all ranges, the others reuse unchanged range files; <= 1 disables reuse
+	int BACKUP_CHANGED_RANGES_LIMIT; // Changed key ranges a log task tracks before coarsening them
 	double BACKUP_AGGREGATE_POLL_RATE;
 	double BACKUP_AGGREGATE_POLL_RATE_UPDATE_INTERVAL;
 	int BACKUP_LOG_WRITE_BATCH_MAX_SIZE;
@@ -152,6 +170,7 @@ public:
 	int64_t VERSIONS_PER_SECOND; // Copy of SERVER_KNOBS, as we can't link with it
 	int SIM_BACKUP_TASKS_PER_AGENT;
 	int BACKUP_RANGEFILE_BLOCK_SIZE;
+	bool BACKUP_RANGEFILE_COMPRESSION;
 	int BACKUP_LOGFILE_BLOCK_SIZE;
 	int BACKUP_DISPATCH_ADDTASK_SIZE;
 	int RESTORE_DISPATCH_ADDTASK_SIZE;
@@ -179,6 +198,7 @@ public:
 	double CSI_SAMPLING_PROBABILITY;
 	int64_t CSI_SIZE_LIMIT;
 	double CSI_STATUS_DELAY;
+	std::string CSI_PROFILE_SINK; // "file:<path>" or "udp:<ip:port>" to send sampled profiles there rather than to the database
 
 	int HTTP_SEND_SIZE;
 	int HTTP_READ_SIZE;
@@ -187,6 +207,8 @@ public:
 	int BLOBSTORE_CONNECT_TRIES;
 	int BLOBSTORE_CONNECT_TIMEOUT;
 	int BLOBSTORE_MAX_CONNECTION_LIFE;
+	int BLOBSTORE_MAX_CONNECTION_IDLE;
+	int BLOBSTORE_MAX_POOLED_CONNECTIONS;
 	int BLOBSTORE_REQUEST_TRIES;
 	int BLOBSTORE_REQUEST_TIMEOUT_MIN;
 	int BLOBSTORE_REQUESTS_PER_SECOND;
@@ -197,6 +219,7 @@ public:
 	int BLOBSTORE_CONCURRENT_REQUESTS;
 	int BLOBSTORE_MULTIPART_MAX_PART_SIZE;
 	int BLOBSTORE_MULTIPART_MIN_PART_SIZE;
+	int BLOBSTORE_MULTIPART_TARGET_SECONDS;
 	int BLOBSTORE_CONCURRENT_UPLOADS;
 	int BLOBSTORE_CONCURRENT_LISTS;
 	int BLOBSTORE_CONCURRENT_WRITES_PER_FILE;
@@ -204,11 +227,14 @@ public:
 	int BLOBSTORE_READ_BLOCK_SIZE;
 	int BLOBSTORE_READ_AHEAD_BLOCKS;
 	int BLOBSTORE_READ_CACHE_BLOCKS_PER_FILE;
+	int BLOBSTORE_READ_AHEAD_MAX_BLOCKS;
 	int BLOBSTORE_MAX_SEND_BYTES_PER_SECOND;
 	int BLOBSTORE_MAX_RECV_BYTES_PER_SECOND;
 
 	int CONSISTENCY_CHECK_RATE_LIMIT_MAX;
 	int CONSISTENCY_CHECK_ONE_ROUND_TARGET_COMPLETION_TIME;
+	bool CONSISTENCY_CHECK_USE_CHECKSUMS; // The consistency check role compares storage server checksums rather than data
+	int64_t CONSISTENCY_CHECK_CHECKSUM_BYTES; // The bytes each storage server reads for one checksum request
 
 	// fdbcli
 	int CLI_CONNECT_PARALLELISM;
@@ -2028,7 +2028,7 @@ ACTOR Future<Void> changeCachedRange(Database cx, KeyRangeRef range, bool add) {
 			tr.clear(privateRange);
 			tr.addReadConflictRange(privateRange);
 			Standalone<RangeResultRef> previous =
-			    wait(tr.getRange(KeyRangeRef(storageCachePrefix, sysRange.begin), 1, true));
+			    wait(tr.getRange(KeyRangeRef(storageCachePrefix, sysRange.begin), 1, false, true));
 			bool prevIsCached = false;
 			if (!previous.empty()) {
 				std::vector<uint16_t> prevVal;
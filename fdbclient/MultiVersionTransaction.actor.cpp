@@ -162,6 +162,29 @@ ThreadFuture<int64_t> DLTransaction::getEstimatedRangeSizeBytes(const KeyRangeRe
 	});
 }
 
+ThreadFuture<RangeAggregate> DLTransaction::getRangeAggregate(const KeyRangeRef& keys, bool snapshot) {
+	if (!api->transactionGetRangeAggregate) {
+		return unsupported_operation();
+	}
+	FdbCApi::FDBFuture* f = api->transactionGetRangeAggregate(tr, keys.begin.begin(), keys.begin.size(),
+	                                                          keys.end.begin(), keys.end.size(), snapshot);
+
+	return toThreadFuture<RangeAggregate>(api, f, [](FdbCApi::FDBFuture* f, FdbCApi* api) {
+		FdbCApi::FDBRangeAggregate out;
+		FdbCApi::fdb_error_t error = api->futureGetRangeAggregate(f, &out);
+		ASSERT(!error);
+		RangeAggregate aggregate;
+		aggregate.count = out.count;
+		aggregate.bytes = out.bytes;
+		aggregate.sum = out.sum;
+		if (out.count) {
+			aggregate.firstKey = Key(KeyRef(out.firstKey, out.firstKeyLength));
+			aggregate.lastKey = Key(KeyRef(out.lastKey, out.lastKeyLength));
+		}
+		return aggregate;
+	});
+}
+
 ThreadFuture<Standalone<VectorRef<KeyRef>>> DLTransaction::getRangeSplitPoints(const KeyRangeRef& range,
                                                                                int64_t chunkSize) {
 	if (!api->transactionGetRangeSplitPoints) {
@@ -179,6 +202,61 @@ ThreadFuture<Standalone<VectorRef<KeyRef>>> DLTransaction::getRangeSplitPoints(c
 	});
 }
 
+ThreadFuture<Standalone<RangeResultRef>> DLTransaction::getMulti(const VectorRef<KeyRef>& keys, bool snapshot) {
+	if (!api->transactionGetMulti) {
+		return unsupported_operation();
+	}
+	FdbCApi::FDBFuture* f = api->transactionGetMulti(tr, (const FdbCApi::FDBKey*)keys.begin(), keys.size(), snapshot);
+
+	return toThreadFuture<Standalone<RangeResultRef>>(api, f, [](FdbCApi::FDBFuture* f, FdbCApi* api) {
+		const FdbCApi::FDBKeyValue* kvs;
+		int count;
+		FdbCApi::fdb_bool_t more;
+		FdbCApi::fdb_error_t error = api->futureGetKeyValueArray(f, &kvs, &count, &more);
+		ASSERT(!error);
+
+		// The memory for this is stored in the FDBFuture and is released when the future gets destroyed
+		return Standalone<RangeResultRef>(RangeResultRef(VectorRef<KeyValueRef>((KeyValueRef*)kvs, count), more), Arena());
+	});
+}
+
+ThreadFuture<Standalone<VectorRef<RangeResultRef>>> DLTransaction::getBatch(const VectorRef<KeyRef>& keys,
+                                                                            const VectorRef<KeyRangeRef>& ranges,
+                                                                            const std::vector<int>& rangeLimits,
+                                                                            bool snapshot) {
+	if (!api->transactionGetBatch) {
+		return unsupported_operation();
+	}
+	std::vector<FdbCApi::FDBKey> beginKeys;
+	std::vector<FdbCApi::FDBKey> endKeys;
+	for (const auto& range : ranges) {
+		beginKeys.push_back(FdbCApi::FDBKey{ range.begin.begin(), range.begin.size() });
+		endKeys.push_back(FdbCApi::FDBKey{ range.end.begin(), range.end.size() });
+	}
+	FdbCApi::FDBFuture* f =
+	    api->transactionGetBatch(tr, (const FdbCApi::FDBKey*)keys.begin(), keys.size(), beginKeys.data(),
+	                             endKeys.data(), rangeLimits.data(), ranges.size(), snapshot);
+
+	int resultCount = keys.size() + ranges.size();
+	return toThreadFuture<Standalone<VectorRef<RangeResultRef>>>(
+	    api, f, [resultCount](FdbCApi::FDBFuture* f, FdbCApi* api) {
+		    // The keys and values are stored in the FDBFuture and are released when the future gets destroyed, so
+		    // only the array of results needs memory of its own
+		    Standalone<VectorRef<RangeResultRef>> results;
+		    results.reserve(results.arena(), resultCount);
+		    for (int i = 0; i < resultCount; i++) {
+			    const FdbCApi::FDBKeyValue* kvs;
+			    int count;
+			    FdbCApi::fdb_bool_t more;
+			    FdbCApi::fdb_error_t error = api->futureGetKeyValueArrayBatch(f, i, &kvs, &count, &more);
+			    ASSERT(!error);
+			    results.push_back(results.arena(),
+			                      RangeResultRef(VectorRef<KeyValueRef>((KeyValueRef*)kvs, count), more));
+		    }
+		    return results;
+	    });
+}
+
 void DLTransaction::addReadConflictRange(const KeyRangeRef& keys) {
 	throwIfError(api->transactionAddConflictRange(tr, keys.begin.begin(), keys.begin.size(), keys.end.begin(), keys.end.size(), FDBConflictRangeTypes::READ));
 }
@@ -298,7 +376,27 @@ ThreadFuture<int64_t> DLDatabase::rebootWorker(const StringRef& address, bool ch
 		return res;
 	});
 }
-	
+
+ThreadFuture<Standalone<VectorRef<ChangeFeedMutationRef>>> DLDatabase::readChangeFeed(const KeyRangeRef& range,
+                                                                                    Version begin, Version end) {
+	if (!api->databaseReadChangeFeed) {
+		return unsupported_operation();
+	}
+
+	FdbCApi::FDBFuture* f = api->databaseReadChangeFeed(db, range.begin.begin(), range.begin.size(), range.end.begin(),
+	                                                    range.end.size(), begin, end);
+	return toThreadFuture<Standalone<VectorRef<ChangeFeedMutationRef>>>(api, f, [](FdbCApi::FDBFuture* f, FdbCApi* api) {
+		const FdbCApi::FDBChangeFeedMutation* mutations;
+		int count;
+		FdbCApi::fdb_error_t error = api->futureGetChangeFeedMutations(f, &mutations, &count);
+		ASSERT(!error);
+
+		// The memory for this is stored in the FDBFuture and is released when the future gets destroyed
+		return Standalone<VectorRef<ChangeFeedMutationRef>>(
+		    VectorRef<ChangeFeedMutationRef>((ChangeFeedMutationRef*)mutations, count), Arena());
+	});
+}
+
 // DLApi
 template<class T>
 void loadClientFunction(T *fp, void *lib, std::string libPath, const char *functionName, bool requireFunction = true) {
@@ -334,6 +432,7 @@ void DLApi::init() {
 	loadClientFunction(&api->databaseSetOption, lib, fdbCPath, "fdb_database_set_option");
 	loadClientFunction(&api->databaseDestroy, lib, fdbCPath, "fdb_database_destroy");
 	loadClientFunction(&api->databaseRebootWorker, lib, fdbCPath, "fdb_database_reboot_worker", headerVersion >= 700);
+	loadClientFunction(&api->databaseReadChangeFeed, lib, fdbCPath, "fdb_database_read_change_feed", headerVersion >= 700);
 
 	loadClientFunction(&api->transactionSetOption, lib, fdbCPath, "fdb_transaction_set_option");
 	loadClientFunction(&api->transactionDestroy, lib, fdbCPath, "fdb_transaction_destroy");
@@ -359,6 +458,10 @@ void DLApi::init() {
 	loadClientFunction(&api->transactionGetEstimatedRangeSizeBytes, lib, fdbCPath, "fdb_transaction_get_estimated_range_size_bytes", headerVersion >= 630);
 	loadClientFunction(&api->transactionGetRangeSplitPoints, lib, fdbCPath, "fdb_transaction_get_range_split_points",
 	                   headerVersion >= 700);
+	loadClientFunction(&api->transactionGetMulti, lib, fdbCPath, "fdb_transaction_get_multi", headerVersion >= 700);
+	loadClientFunction(&api->transactionGetBatch, lib, fdbCPath, "fdb_transaction_get_batch", headerVersion >= 700);
+	loadClientFunction(&api->transactionGetRangeAggregate, lib, fdbCPath, "fdb_transaction_get_range_aggregate",
+	                   headerVersion >= 700);
 
 	loadClientFunction(&api->futureGetInt64, lib, fdbCPath, headerVersion >= 620 ? "fdb_future_get_int64" : "fdb_future_get_version");
 	loadClientFunction(&api->futureGetUInt64, lib, fdbCPath, "fdb_future_get_uint64");
@@ -368,6 +471,12 @@ void DLApi::init() {
 	loadClientFunction(&api->futureGetStringArray, lib, fdbCPath, "fdb_future_get_string_array");
 	loadClientFunction(&api->futureGetKeyArray, lib, fdbCPath, "fdb_future_get_key_array", headerVersion >= 700);
 	loadClientFunction(&api->futureGetKeyValueArray, lib, fdbCPath, "fdb_future_get_keyvalue_array");
+	loadClientFunction(&api->futureGetKeyValueArrayBatch, lib, fdbCPath, "fdb_future_get_keyvalue_array_batch",
+	                   headerVersion >= 700);
+	loadClientFunction(&api->futureGetChangeFeedMutations, lib, fdbCPath, "fdb_future_get_change_feed_mutations",
+	                   headerVersion >= 700);
+	loadClientFunction(&api->futureGetRangeAggregate, lib, fdbCPath, "fdb_future_get_range_aggregate",
+	                   headerVersion >= 700);
 	loadClientFunction(&api->futureSetCallback, lib, fdbCPath, "fdb_future_set_callback");
 	loadClientFunction(&api->futureCancel, lib, fdbCPath, "fdb_future_cancel");
 	loadClientFunction(&api->futureDestroy, lib, fdbCPath, "fdb_future_destroy");
@@ -612,6 +721,12 @@ ThreadFuture<int64_t> MultiVersionTransaction::getEstimatedRangeSizeBytes(const
 	return abortableFuture(f, tr.onChange);
 }
 
+ThreadFuture<RangeAggregate> MultiVersionTransaction::getRangeAggregate(const KeyRangeRef& keys, bool snapshot) {
+	auto tr = getTransaction();
+	auto f = tr.transaction ? tr.transaction->getRangeAggregate(keys, snapshot) : ThreadFuture<RangeAggregate>(Never());
+	return abortableFuture(f, tr.onChange);
+}
+
 ThreadFuture<Standalone<VectorRef<KeyRef>>> MultiVersionTransaction::getRangeSplitPoints(const KeyRangeRef& range,
                                                                                          int64_t chunkSize) {
 	auto tr = getTransaction();
@@ -620,6 +735,21 @@ ThreadFuture<Standalone<VectorRef<KeyRef>>> MultiVersionTransaction::getRangeSpl
 	return abortableFuture(f, tr.onChange);
 }
 
+ThreadFuture<Standalone<RangeResultRef>> MultiVersionTransaction::getMulti(const VectorRef<KeyRef>& keys, bool snapshot) {
+	auto tr = getTransaction();
+	auto f = tr.transaction ? tr.transaction->getMulti(keys, snapshot) : ThreadFuture<Standalone<RangeResultRef>>(Never());
+	return abortableFuture(f, tr.onChange);
+}
+
+ThreadFuture<Standalone<VectorRef<RangeResultRef>>> MultiVersionTransaction::getBatch(
+    const VectorRef<KeyRef>& keys, const VectorRef<KeyRangeRef>& ranges, const std::vector<int>& rangeLimits,
+    bool snapshot) {
+	auto tr = getTransaction();
+	auto f = tr.transaction ? tr.transaction->getBatch(keys, ranges, rangeLimits, snapshot)
+	                        : ThreadFuture<Standalone<VectorRef<RangeResultRef>>>(Never());
+	return abortableFuture(f, tr.onChange);
+}
+
 void MultiVersionTransaction::atomicOp(const KeyRef& key, const ValueRef& value, uint32_t operationType) {
 	auto tr = getTransaction();
 	if(tr.transaction) {
@@ -737,7 +867,7 @@ void MultiVersionTransaction::reset() {
 }
 
 // MultiVersionDatabase
-MultiVersionDatabase::MultiVersionDatabase(MultiVersionApi *api, std::string clusterFilePath, Reference<IDatabase> db, bool openConnectors) : dbState(new DatabaseState()) {
+MultiVersionDatabase::MultiVersionDatabase(MultiVersionApi *api, int threadIndex, std::string clusterFilePath, Reference<IDatabase> db, bool openConnectors) : dbState(new DatabaseState()) {
 	dbState->db = db;
 	dbState->dbVar->set(db);
 
@@ -753,7 +883,7 @@ MultiVersionDatabase::MultiVersionDatabase(MultiVersionApi *api, std::string clu
 			dbState->currentClientIndex = -1;
 		}
 
-		api->runOnExternalClients([this, clusterFilePath](Reference<ClientInfo> client) {
+		api->runOnExternalClients(threadIndex, [this, clusterFilePath](Reference<ClientInfo> client) {
 			dbState->addConnection(client, clusterFilePath);
 		});
 
@@ -766,7 +896,7 @@ MultiVersionDatabase::~MultiVersionDatabase() {
 }
 
 Reference<IDatabase> MultiVersionDatabase::debugCreateFromExistingDatabase(Reference<IDatabase> db) {
-	return Reference<IDatabase>(new MultiVersionDatabase(MultiVersionApi::api, "", db, false));
+	return Reference<IDatabase>(new MultiVersionDatabase(MultiVersionApi::api, 0, "", db, false));
 }
 
 Reference<ITransaction> MultiVersionDatabase::createTransaction() {
@@ -803,6 +933,15 @@ ThreadFuture<int64_t> MultiVersionDatabase::rebootWorker(const StringRef& addres
 	return false;
 }
 
+ThreadFuture<Standalone<VectorRef<ChangeFeedMutationRef>>> MultiVersionDatabase::readChangeFeed(const KeyRangeRef& range,
+                                                                                              Version begin,
+                                                                                              Version end) {
+	if (dbState->db) {
+		return dbState->db->readChangeFeed(range, begin, end);
+	}
+	return cluster_version_changed();
+}
+
 void MultiVersionDatabase::Connector::connect() {
 	addref();
 	onMainThreadVoid([this]() {
@@ -970,29 +1109,50 @@ bool MultiVersionApi::apiVersionAtLeast(int minVersion) {
 
 // runOnFailedClients should be used cautiously. Some failed clients may not have successfully loaded all symbols.
 void MultiVersionApi::runOnExternalClients(std::function<void(Reference<ClientInfo>)> func, bool runOnFailedClients) {
+	runOnExternalClients(-1, func, runOnFailedClients);
+}
+
+// A threadIndex of -1 runs on the clients of every network thread
+void MultiVersionApi::runOnExternalClients(int threadIndex, std::function<void(Reference<ClientInfo>)> func, bool runOnFailedClients) {
 	bool newFailure = false;
 
 	auto c = externalClients.begin();
 	while(c != externalClients.end()) {
-		try {
-			if(!c->second->failed || runOnFailedClients) { // TODO: Should we ignore some failures?
-				func(c->second);
-			}
-		}
-		catch(Error &e) {
-			if(e.code() == error_code_external_client_already_loaded) {
-				TraceEvent(SevInfo, "ExternalClientAlreadyLoaded").error(e).detail("LibPath", c->second->libPath);
-				c = externalClients.erase(c);
+		auto& clients = c->second;
+		auto client = clients.begin();
+		while(client != clients.end()) {
+			if(threadIndex >= 0 && (*client)->threadIndex != threadIndex) {
+				++client;
 				continue;
 			}
-			else {
-				TraceEvent(SevWarnAlways, "ExternalClientFailure").error(e).detail("LibPath", c->second->libPath);
-				c->second->failed = true;
-				newFailure = true;
+
+			try {
+				if(!(*client)->failed || runOnFailedClients) { // TODO: Should we ignore some failures?
+					func(*client);
+				}
 			}
+			catch(Error &e) {
+				if(e.code() == error_code_external_client_already_loaded) {
+					TraceEvent(SevInfo, "ExternalClientAlreadyLoaded").error(e).detail("LibPath", (*client)->libPath);
+					client = clients.erase(client);
+					continue;
+				}
+				else {
+					TraceEvent(SevWarnAlways, "ExternalClientFailure").error(e).detail("LibPath", (*client)->libPath);
+					(*client)->failed = true;
+					newFailure = true;
+				}
+			}
+
+			++client;
 		}
 
-		++c;
+		if(clients.empty()) {
+			c = externalClients.erase(c);
+		}
+		else {
+			++c;
+		}
 	}
 
 	if(newFailure) {
@@ -1039,7 +1199,7 @@ void validateOption(Optional<StringRef> value, bool canBePresent, bool canBeAbse
 
 void MultiVersionApi::disableMultiVersionClientApi() {
 	MutexHolder holder(lock);
-	if(networkStartSetup || localClientDisabled) {
+	if(networkStartSetup || localClientDisabled || threadCount > 1) {
 		throw invalid_option();
 	}
 
@@ -1070,7 +1230,7 @@ void MultiVersionApi::addExternalLibrary(std::string path) {
 
 	if(externalClients.count(filename) == 0) {
 		TraceEvent("AddingExternalClient").detail("LibraryPath", filename);
-		externalClients[filename] = makeReference<ClientInfo>(new DLApi(path), path);
+		externalClients[filename].push_back(makeReference<ClientInfo>(new DLApi(path), path));
 	}
 }
 
@@ -1087,7 +1247,7 @@ void MultiVersionApi::addExternalLibraryDirectory(std::string path) {
 		std::string lib = abspath(joinPath(path, filename));
 		if(externalClients.count(filename) == 0) {
 			TraceEvent("AddingExternalClient").detail("LibraryPath", filename);
-			externalClients[filename] = makeReference<ClientInfo>(new DLApi(lib), lib);
+			externalClients[filename].push_back(makeReference<ClientInfo>(new DLApi(lib), lib));
 		}	
 	}
 }
@@ -1101,6 +1261,43 @@ void MultiVersionApi::disableLocalClient() {
 	localClientDisabled = true;
 }
 
+void MultiVersionApi::setThreadCount(int value) {
+	MutexHolder holder(lock);
+	if(networkStartSetup || (value > 1 && bypassMultiClientApi)) {
+		throw invalid_option();
+	}
+
+	threadCount = value;
+}
+
+// Loading a library that is already loaded just returns it again, so each network thread after the first gets its own
+// copy of each external client library, in the temporary directory.  On platforms that allow it, the copies are deleted
+// once they have been loaded.
+void MultiVersionApi::copyExternalLibrariesPerThread() {
+	std::string tempDir;
+	if(!platform::getEnvironmentVar("TMPDIR", tempDir)) {
+#ifdef _WIN32
+		if(!platform::getEnvironmentVar("TEMP", tempDir)) {
+			tempDir = ".";
+		}
+#else
+		tempDir = "/tmp";
+#endif
+	}
+
+	for(auto& it : externalClients) {
+		std::string path = it.second[0]->libPath;
+		std::string contents = readFileBytes(path, fileSize(path));
+		for(int i = 1; i < threadCount; i++) {
+			std::string copy = joinPath(tempDir, format("fdb_c_%016llx_%d_%s", (long long)platform::getRandomSeed(),
+			                                            i, it.first.c_str()));
+			writeFileBytes(copy, contents.data(), contents.size());
+			TraceEvent("CopiedExternalClient").detail("LibraryPath", it.first).detail("CopyPath", copy).detail("ThreadIndex", i);
+			it.second.push_back(makeReference<ClientInfo>(new DLApi(copy), copy, i));
+		}
+	}
+}
+
 void MultiVersionApi::setSupportedClientVersions(Standalone<StringRef> versions) {
 	MutexHolder holder(lock);
 	ASSERT(networkSetup);
@@ -1155,6 +1352,10 @@ void MultiVersionApi::setNetworkOptionInternal(FDBNetworkOptions::Option option,
 		validateOption(value, false, true);
 		disableLocalClient();
 	}
+	else if(option == FDBNetworkOptions::CLIENT_THREADS_PER_VERSION) {
+		validateOption(value, true, false, false);
+		setThreadCount(extractIntOption(value, 1, std::numeric_limits<int>::max()));
+	}
 	else if(option == FDBNetworkOptions::SUPPORTED_CLIENT_VERSIONS) {
 		ASSERT(value.present());
 		setSupportedClientVersions(value.get());
@@ -1195,6 +1396,15 @@ void MultiVersionApi::setupNetwork() {
 
 		networkStartSetup = true;
 
+		if(threadCount > 1) {
+			if(externalClients.empty()) {
+				TraceEvent(SevWarnAlways, "ClientThreadsWithoutExternalClients").detail("ThreadCount", threadCount);
+				throw invalid_option();
+			}
+			localClientDisabled = true;
+			copyExternalLibrariesPerThread();
+		}
+
 		if(externalClients.empty()) {
 			bypassMultiClientApi = true; // SOMEDAY: we won't be able to set this option once it becomes possible to add clients after setupNetwork is called
 		}
@@ -1211,11 +1421,23 @@ void MultiVersionApi::setupNetwork() {
 
 	if(!bypassMultiClientApi) {
 		runOnExternalClients([this](Reference<ClientInfo> client) {
-			TraceEvent("InitializingExternalClient").detail("LibraryPath", client->libPath);
+			TraceEvent("InitializingExternalClient").detail("LibraryPath", client->libPath).detail("ThreadIndex", client->threadIndex);
 			client->api->selectApiVersion(apiVersion);
 			client->loadProtocolVersion();
 		});
 
+		// The copies made for additional network threads are no longer needed once loaded
+		runOnExternalClients([](Reference<ClientInfo> client) {
+			if(client->threadIndex > 0) {
+				try {
+					deleteFile(client->libPath);
+				}
+				catch(Error &e) {
+					TraceEvent(SevWarn, "ExternalClientCopyNotDeleted").error(e).detail("CopyPath", client->libPath);
+				}
+			}
+		}, true);
+
 		MutexHolder holder(lock);
 		runOnExternalClients([this, transportId](Reference<ClientInfo> client) {
 			for(auto option : options) {
@@ -1314,9 +1536,16 @@ Reference<IDatabase> MultiVersionApi::createDatabase(const char *clusterFilePath
 	}
 	lock.leave();
 
+	int threadIndex;
+	{ // lock scope
+		MutexHolder holder(lock);
+		threadIndex = nextThread;
+		nextThread = (nextThread + 1) % threadCount;
+	}
+
 	std::string clusterFile(clusterFilePath);
 	if(localClientDisabled) {
-		return Reference<IDatabase>(new MultiVersionDatabase(this, clusterFile, Reference<IDatabase>()));
+		return Reference<IDatabase>(new MultiVersionDatabase(this, threadIndex, clusterFile, Reference<IDatabase>()));
 	}
 
 	auto db = localClient->api->createDatabase(clusterFilePath);
@@ -1324,10 +1553,10 @@ Reference<IDatabase> MultiVersionApi::createDatabase(const char *clusterFilePath
 		return db;
 	}
 	else {
-		for(auto it : externalClients) {
-			TraceEvent("CreatingDatabaseOnExternalClient").detail("LibraryPath", it.second->libPath).detail("Failed", it.second->failed);
-		}
-		return Reference<IDatabase>(new MultiVersionDatabase(this, clusterFile, db));
+		runOnExternalClients(threadIndex, [](Reference<ClientInfo> client) {
+			TraceEvent("CreatingDatabaseOnExternalClient").detail("LibraryPath", client->libPath).detail("Failed", client->failed);
+		}, true);
+		return Reference<IDatabase>(new MultiVersionDatabase(this, threadIndex, clusterFile, db));
 	}
 }
 
@@ -1335,7 +1564,8 @@ void MultiVersionApi::updateSupportedVersions() {
 	if(networkSetup) {
 		Standalone<VectorRef<uint8_t>> versionStr;
 
-		runOnExternalClients([&versionStr](Reference<ClientInfo> client){
+		// Every network thread runs the same versions
+		runOnExternalClients(0, [&versionStr](Reference<ClientInfo> client){
 			const char *ver = client->api->getClientVersion();
 			versionStr.append(versionStr.arena(), (uint8_t*)ver, (int)strlen(ver));
 			versionStr.append(versionStr.arena(), (uint8_t*)";", 1);
@@ -1430,7 +1660,7 @@ void MultiVersionApi::loadEnvironmentVariableNetworkOptions() {
 	envOptionsLoaded = true;
 }
 
-MultiVersionApi::MultiVersionApi() : bypassMultiClientApi(false), networkStartSetup(false), networkSetup(false), callbackOnMainThread(true), externalClient(false), localClientDisabled(false), apiVersion(0), envOptionsLoaded(false) {}
+MultiVersionApi::MultiVersionApi() : bypassMultiClientApi(false), networkStartSetup(false), networkSetup(false), callbackOnMainThread(true), externalClient(false), localClientDisabled(false), apiVersion(0), envOptionsLoaded(false), threadCount(1), nextThread(0) {}
 
 MultiVersionApi* MultiVersionApi::api = new MultiVersionApi();
 
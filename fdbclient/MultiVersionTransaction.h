@@ -45,6 +45,23 @@ struct FdbCApi : public ThreadSafeReferenceCounted<FdbCApi> {
 		const void *value;
 		int valueLength;
 	} FDBKeyValue;
+	typedef struct changefeedmutation {
+		int64_t version;
+		int type;
+		const uint8_t* param1;
+		int param1Length;
+		const uint8_t* param2;
+		int param2Length;
+	} FDBChangeFeedMutation;
+	typedef struct rangeaggregate {
+		int64_t count;
+		int64_t bytes;
+		int64_t sum;
+		const uint8_t* firstKey;
+		int firstKeyLength;
+		const uint8_t* lastKey;
+		int lastKeyLength;
+	} FDBRangeAggregate;
 #pragma pack(pop)
 
 	typedef int fdb_error_t;
@@ -67,6 +84,9 @@ struct FdbCApi : public ThreadSafeReferenceCounted<FdbCApi> {
 	fdb_error_t (*databaseSetOption)(FDBDatabase *database, FDBDatabaseOptions::Option option, uint8_t const *value, int valueLength);
 	void (*databaseDestroy)(FDBDatabase *database);
 	FDBFuture* (*databaseRebootWorker)(FDBDatabase *database, uint8_t const *address, int addressLength, fdb_bool_t check, int duration);
+	FDBFuture* (*databaseReadChangeFeed)(FDBDatabase* database, uint8_t const* beginKeyName, int beginKeyNameLength,
+	                                     uint8_t const* endKeyName, int endKeyNameLength, int64_t beginVersion,
+	                                     int64_t endVersion);
 
 	//Transaction
 	fdb_error_t (*transactionSetOption)(FDBTransaction *tr, FDBTransactionOptions::Option option, uint8_t const *value, int valueLength);
@@ -94,6 +114,12 @@ struct FdbCApi : public ThreadSafeReferenceCounted<FdbCApi> {
 	FDBFuture* (*transactionGetRangeSplitPoints)(FDBTransaction* tr, uint8_t const* begin_key_name,
 	                                             int begin_key_name_length, uint8_t const* end_key_name,
 	                                             int end_key_name_length, int64_t chunkSize);
+	FDBFuture* (*transactionGetMulti)(FDBTransaction* tr, FDBKey const* keys, int keyCount, fdb_bool_t snapshot);
+	FDBFuture* (*transactionGetBatch)(FDBTransaction* tr, FDBKey const* keys, int keyCount, FDBKey const* rangeBeginKeys,
+	                                  FDBKey const* rangeEndKeys, int const* rangeLimits, int rangeCount,
+	                                  fdb_bool_t snapshot);
+	FDBFuture* (*transactionGetRangeAggregate)(FDBTransaction* tr, uint8_t const* beginKeyName, int beginKeyNameLength,
+	                                           uint8_t const* endKeyName, int endKeyNameLength, fdb_bool_t snapshot);
 
 	FDBFuture* (*transactionCommit)(FDBTransaction *tr);
 	fdb_error_t (*transactionGetCommittedVersion)(FDBTransaction *tr, int64_t *outVersion);
@@ -117,6 +143,10 @@ struct FdbCApi : public ThreadSafeReferenceCounted<FdbCApi> {
 	fdb_error_t (*futureGetStringArray)(FDBFuture *f, const char ***outStrings, int *outCount);
 	fdb_error_t (*futureGetKeyArray)(FDBFuture* f, FDBKey const** outKeys, int* outCount);
 	fdb_error_t (*futureGetKeyValueArray)(FDBFuture *f, FDBKeyValue const ** outKV, int *outCount, fdb_bool_t *outMore);
+	fdb_error_t (*futureGetKeyValueArrayBatch)(FDBFuture* f, int index, FDBKeyValue const** outKV, int* outCount,
+	                                           fdb_bool_t* outMore);
+	fdb_error_t (*futureGetChangeFeedMutations)(FDBFuture* f, FDBChangeFeedMutation const** outMutations, int* outCount);
+	fdb_error_t (*futureGetRangeAggregate)(FDBFuture* f, FDBRangeAggregate* outAggregate);
 	fdb_error_t (*futureSetCallback)(FDBFuture *f, FDBCallback callback, void *callback_parameter);
 	void (*futureCancel)(FDBFuture *f);
 	void (*futureDestroy)(FDBFuture *f);
@@ -146,8 +176,14 @@ public:
 	ThreadFuture<Standalone<VectorRef<const char*>>> getAddressesForKey(const KeyRef& key) override;
 	ThreadFuture<Standalone<StringRef>> getVersionstamp() override;
 	ThreadFuture<int64_t> getEstimatedRangeSizeBytes(const KeyRangeRef& keys) override;
+	ThreadFuture<RangeAggregate> getRangeAggregate(const KeyRangeRef& keys, bool snapshot = false) override;
 	ThreadFuture<Standalone<VectorRef<KeyRef>>> getRangeSplitPoints(const KeyRangeRef& range,
 	                                                                int64_t chunkSize) override;
+	ThreadFuture<Standalone<RangeResultRef>> getMulti(const VectorRef<KeyRef>& keys, bool snapshot=false) override;
+	ThreadFuture<Standalone<VectorRef<RangeResultRef>>> getBatch(const VectorRef<KeyRef>& keys,
+	                                                            const VectorRef<KeyRangeRef>& ranges,
+	                                                            const std::vector<int>& rangeLimits,
+	                                                            bool snapshot = false) override;
 
 	void addReadConflictRange(const KeyRangeRef& keys) override;
 
@@ -198,6 +234,9 @@ public:
 
 	ThreadFuture<int64_t> rebootWorker(const StringRef& address, bool check, int duration) override;
 
+	ThreadFuture<Standalone<VectorRef<ChangeFeedMutationRef>>> readChangeFeed(const KeyRangeRef& range, Version begin,
+	                                                                          Version end) override;
+
 private:
 	const Reference<FdbCApi> api;
 	FdbCApi::FDBDatabase* db; // Always set if API version >= 610, otherwise guaranteed to be set when onReady future is set
@@ -255,8 +294,14 @@ public:
  
 	void addReadConflictRange(const KeyRangeRef& keys) override;
 	ThreadFuture<int64_t> getEstimatedRangeSizeBytes(const KeyRangeRef& keys) override;
+	ThreadFuture<RangeAggregate> getRangeAggregate(const KeyRangeRef& keys, bool snapshot = false) override;
 	ThreadFuture<Standalone<VectorRef<KeyRef>>> getRangeSplitPoints(const KeyRangeRef& range,
 	                                                                int64_t chunkSize) override;
+	ThreadFuture<Standalone<RangeResultRef>> getMulti(const VectorRef<KeyRef>& keys, bool snapshot=false) override;
+	ThreadFuture<Standalone<VectorRef<RangeResultRef>>> getBatch(const VectorRef<KeyRef>& keys,
+	                                                            const VectorRef<KeyRangeRef>& ranges,
+	                                                            const std::vector<int>& rangeLimits,
+	                                                            bool snapshot = false) override;
 
 	void atomicOp(const KeyRef& key, const ValueRef& value, uint32_t operationType) override;
 	void set(const KeyRef& key, const ValueRef& value) override;
@@ -304,11 +349,13 @@ struct ClientInfo : ThreadSafeReferenceCounted<ClientInfo> {
 	std::string libPath;
 	bool external;
 	bool failed;
+	int threadIndex; // Which of the network threads loaded for this version of the client this is
 	std::vector<std::pair<void (*)(void*), void*>> threadCompletionHooks;
 
-	ClientInfo() : protocolVersion(0), api(nullptr), external(false), failed(true) {}
-	ClientInfo(IClientApi *api) : protocolVersion(0), api(api), libPath("internal"), external(false), failed(false) {}
-	ClientInfo(IClientApi *api, std::string libPath) : protocolVersion(0), api(api), libPath(libPath), external(true), failed(false) {}
+	ClientInfo() : protocolVersion(0), api(nullptr), external(false), failed(true), threadIndex(0) {}
+	ClientInfo(IClientApi *api) : protocolVersion(0), api(api), libPath("internal"), external(false), failed(false), threadIndex(0) {}
+	ClientInfo(IClientApi *api, std::string libPath, int threadIndex = 0)
+	  : protocolVersion(0), api(api), libPath(libPath), external(true), failed(false), threadIndex(threadIndex) {}
 
 	void loadProtocolVersion();
 	bool canReplace(Reference<ClientInfo> other) const;
@@ -318,7 +365,7 @@ class MultiVersionApi;
 
 class MultiVersionDatabase final : public IDatabase, ThreadSafeReferenceCounted<MultiVersionDatabase> {
 public:
-	MultiVersionDatabase(MultiVersionApi *api, std::string clusterFilePath, Reference<IDatabase> db, bool openConnectors=true);
+	MultiVersionDatabase(MultiVersionApi *api, int threadIndex, std::string clusterFilePath, Reference<IDatabase> db, bool openConnectors=true);
 	~MultiVersionDatabase();
 
 	Reference<ITransaction> createTransaction() override;
@@ -331,6 +378,9 @@ public:
 
 	ThreadFuture<int64_t> rebootWorker(const StringRef& address, bool check, int duration);
 
+	ThreadFuture<Standalone<VectorRef<ChangeFeedMutationRef>>> readChangeFeed(const KeyRangeRef& range, Version begin,
+	                                                                          Version end);
+
 private:
 	struct DatabaseState;
 
@@ -403,6 +453,8 @@ public:
 
 	Reference<ClientInfo> getLocalClient();
 	void runOnExternalClients(std::function<void(Reference<ClientInfo>)>, bool runOnFailedClients=false);
+	// Runs only on the copies of the external clients that make up the given network thread
+	void runOnExternalClients(int threadIndex, std::function<void(Reference<ClientInfo>)>, bool runOnFailedClients=false);
 
 	void updateSupportedVersions();
 
@@ -422,11 +474,17 @@ private:
 	void addExternalLibraryDirectory(std::string path);
 	void disableLocalClient();
 	void setSupportedClientVersions(Standalone<StringRef> versions);
+	void setThreadCount(int value);
+	void copyExternalLibrariesPerThread();
 
 	void setNetworkOptionInternal(FDBNetworkOptions::Option option, Optional<StringRef> value);
 
 	Reference<ClientInfo> localClient;
-	std::map<std::string, Reference<ClientInfo>> externalClients;
+	// For each external client library, a copy of it loaded for each network thread
+	std::map<std::string, std::vector<Reference<ClientInfo>>> externalClients;
+
+	int threadCount;
+	int nextThread; // The network thread the next database created will use
 
 	bool networkStartSetup;
 	volatile bool networkSetup;
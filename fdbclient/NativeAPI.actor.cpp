@@ -30,6 +30,7 @@
 
 #include "fdbclient/FDBTypes.h"
 #include "fdbrpc/FailureMonitor.h"
+#include "fdbrpc/IAsyncFile.h"
 #include "fdbrpc/MultiInterface.h"
 
 #include "fdbclient/Atomic.h"
@@ -154,6 +155,15 @@ StorageServerInfo::~StorageServerInfo() {
 	}
 }
 
+LocationInfo::~LocationInfo() {
+	if( cx ) {
+		auto it = cx->teamLocations.find( team );
+		if( it != cx->teamLocations.end() && it->second == this )
+			cx->teamLocations.erase( it );
+		cx = nullptr;
+	}
+}
+
 std::string printable( const VectorRef<KeyValueRef>& val ) {
 	std::string s;
 	for(int i=0; i<val.size(); i++)
@@ -287,7 +297,8 @@ ACTOR Future<Void> databaseLogger( DatabaseContext *cx ) {
 			.detail("MaxMutationsPerCommit", cx->mutationsPerCommit.max())
 			.detail("MeanBytesPerCommit", cx->bytesPerCommit.mean())
 			.detail("MedianBytesPerCommit", cx->bytesPerCommit.median())
-			.detail("MaxBytesPerCommit", cx->bytesPerCommit.max());
+			.detail("MaxBytesPerCommit", cx->bytesPerCommit.max())
+			.detail("HedgedReadRequests", cx->queueModel.hedgedRequests);
 
 		cx->latencies.clear();
 		cx->readLatencies.clear();
@@ -296,6 +307,11 @@ ACTOR Future<Void> databaseLogger( DatabaseContext *cx ) {
 		cx->mutationsPerCommit.clear();
 		cx->bytesPerCommit.clear();
 
+		for (auto& h : { cx->profileGRVLatency, cx->profileGetLatency, cx->profileGetRangeLatency, cx->profileCommitLatency }) {
+			h->writeToLog();
+			h->clear();
+		}
+
 		lastLogged = now();
 	}
 }
@@ -305,6 +321,72 @@ struct TrInfoChunk {
 	Key key;
 };
 
+// Where sampled transaction profiles go instead of the database when CSI_PROFILE_SINK is set.  Each profile is written
+// as a record of a little-endian uint32 length and the transaction identifier, then a little-endian uint32 length and
+// the serialized events: the same bytes that would have been split into the database chunks.  A file sink appends the
+// records to the file, and a UDP sink sends each record as one datagram, dropping records that do not fit in one.
+struct ClientProfileSink : ReferenceCounted<ClientProfileSink> {
+	Reference<IAsyncFile> file;
+	int64_t offset = 0;
+	Reference<IUDPSocket> socket;
+	int64_t dropped = 0;
+
+	static void appendRecord(BinaryWriter& wr, std::string const& identifier, BinaryWriter& events) {
+		wr << (uint32_t)identifier.size();
+		wr.serializeBytes(identifier);
+		wr << (uint32_t)events.getLength();
+		wr.serializeBytes(events.getData(), events.getLength());
+	}
+};
+
+ACTOR static Future<Reference<ClientProfileSink>> openClientProfileSink(std::string sink) {
+	state Reference<ClientProfileSink> result = makeReference<ClientProfileSink>();
+	if (StringRef(sink).startsWith(LiteralStringRef("file:"))) {
+		Reference<IAsyncFile> file = wait(IAsyncFileSystem::filesystem()->open(
+		    sink.substr(5), IAsyncFile::OPEN_CREATE | IAsyncFile::OPEN_READWRITE | IAsyncFile::OPEN_NO_AIO, 0644));
+		result->file = file;
+		int64_t size = wait(result->file->size());
+		result->offset = size;
+	} else if (StringRef(sink).startsWith(LiteralStringRef("udp:"))) {
+		Reference<IUDPSocket> socket = wait(INetworkConnections::net()->createUDPSocket(NetworkAddress::parse(sink.substr(4))));
+		result->socket = socket;
+	} else {
+		TraceEvent(SevWarnAlways, "ClientProfileSinkInvalid").detail("Sink", sink);
+		throw invalid_option_value();
+	}
+	TraceEvent("ClientProfileSinkOpened").detail("Sink", sink);
+	return result;
+}
+
+ACTOR static Future<Void> writeClientProfiles(Reference<ClientProfileSink> sink, std::vector<std::pair<std::string, BinaryWriter>>* profiles) {
+	if (sink->file) {
+		BinaryWriter wr(Unversioned());
+		for (auto& entry : *profiles) {
+			ClientProfileSink::appendRecord(wr, entry.first, entry.second);
+		}
+		state Standalone<StringRef> records = wr.toValue();
+		if (records.size()) {
+			wait(sink->file->write(records.begin(), records.size(), sink->offset));
+			sink->offset += records.size();
+		}
+		return Void();
+	}
+
+	state int i = 0;
+	for (; i < profiles->size(); i++) {
+		BinaryWriter wr(Unversioned());
+		ClientProfileSink::appendRecord(wr, (*profiles)[i].first, (*profiles)[i].second);
+		state Standalone<StringRef> record = wr.toValue();
+		if (record.size() > IUDPSocket::MAX_PACKET_SIZE) {
+			++sink->dropped;
+			TraceEvent(SevWarn, "ClientProfileRecordTooLarge").suppressFor(60).detail("Bytes", record.size()).detail("Dropped", sink->dropped);
+			continue;
+		}
+		wait(success(sink->socket->send(record.begin(), record.end())));
+	}
+	return Void();
+}
+
 ACTOR static Future<Void> transactionInfoCommitActor(Transaction *tr, std::vector<TrInfoChunk> *chunks) {
 	state const Key clientLatencyAtomicCtr = CLIENT_LATENCY_INFO_CTR_PREFIX.withPrefix(fdbClientInfoPrefixRange.begin);
 	state int retryCount = 0;
@@ -386,11 +468,24 @@ ACTOR static Future<Void> clientStatusUpdateActor(DatabaseContext *cx) {
 	state Transaction tr;
 	state std::vector<TrInfoChunk> commitQ;
 	state int txBytes = 0;
+	state Reference<ClientProfileSink> sink;
 
 	loop {
 		try {
 			ASSERT(cx->clientStatusUpdater.outStatusQ.empty());
 			cx->clientStatusUpdater.inStatusQ.swap(cx->clientStatusUpdater.outStatusQ);
+
+			if (CLIENT_KNOBS->CSI_PROFILE_SINK.size()) {
+				if (!sink) {
+					Reference<ClientProfileSink> opened = wait(openClientProfileSink(CLIENT_KNOBS->CSI_PROFILE_SINK));
+					sink = opened;
+				}
+				wait(writeClientProfiles(sink, &cx->clientStatusUpdater.outStatusQ));
+				cx->clientStatusUpdater.outStatusQ.clear();
+				wait(delay(CLIENT_KNOBS->CSI_STATUS_DELAY));
+				continue;
+			}
+
 			// Split Transaction Info into chunks
 			state std::vector<TrInfoChunk> trChunksQ;
 			for (auto &entry : cx->clientStatusUpdater.outStatusQ) {
@@ -505,8 +600,8 @@ void updateLocationCacheWithCaches(DatabaseContext* self, const std::map<UID, St
 	// TODO: this needs to be more clever in the future
 	auto ranges = self->locationCache.ranges();
 	for (auto iter = ranges.begin(); iter != ranges.end(); ++iter) {
-		if (iter->value() && iter->value()->hasCaches) {
-			auto& val = iter->value();
+		if (iter->value().info && iter->value().info->hasCaches) {
+			auto& val = iter->value().info;
 			std::vector<Reference<ReferencedInterface<StorageServerInterface>>> interfaces;
 			interfaces.reserve(val->size() - removed.size() + added.size());
 			for (int i = 0; i < val->size(); ++i) {
@@ -518,7 +613,7 @@ void updateLocationCacheWithCaches(DatabaseContext* self, const std::map<UID, St
 			for (const auto& p : added) {
 				interfaces.push_back(makeReference<ReferencedInterface<StorageServerInterface>>(p.second));
 			}
-			iter->value() = makeReference<LocationInfo>(interfaces, true);
+			val = makeReference<LocationInfo>(interfaces, true);
 		}
 	}
 }
@@ -572,25 +667,26 @@ ACTOR Future<Void> updateCachedRanges(DatabaseContext* self, std::map<UID, Stora
 						}
 						for (auto iter = ranges.begin(); iter != ranges.end(); ++iter) {
 							containedRangesEnd = iter->range().end;
-							if (iter->value() && !iter->value()->hasCaches) {
-								iter->value() = addCaches(iter->value(), cacheInterfaces);
+							if (iter->value().info && !iter->value().info->hasCaches) {
+								iter->value().info = addCaches(iter->value().info, cacheInterfaces);
 							}
 						}
 						auto iter = self->locationCache.rangeContaining(begin);
-						if (iter->value() && !iter->value()->hasCaches) {
+						if (iter->value().info && !iter->value().info->hasCaches) {
 							if (end>=iter->range().end) {
 								Key endCopy = iter->range().end; // Copy because insertion invalidates iterator
 								self->locationCache.insert(KeyRangeRef{ begin, endCopy },
-														   addCaches(iter->value(), cacheInterfaces));
+														   CachedLocation(addCaches(iter->value().info, cacheInterfaces)));
 							} else {
 								self->locationCache.insert(KeyRangeRef{ begin, end },
-														   addCaches(iter->value(), cacheInterfaces));
+														   CachedLocation(addCaches(iter->value().info, cacheInterfaces)));
 							}
 						}
 						iter = self->locationCache.rangeContainingKeyBefore(end);
-						if (iter->value() && !iter->value()->hasCaches) {
+						if (iter->value().info && !iter->value().info->hasCaches) {
 							Key beginCopy = iter->range().begin; // Copy because insertion invalidates iterator
-							self->locationCache.insert(KeyRangeRef{beginCopy, end}, addCaches(iter->value(), cacheInterfaces));
+							self->locationCache.insert(KeyRangeRef{beginCopy, end},
+							                           CachedLocation(addCaches(iter->value().info, cacheInterfaces)));
 						}
 					}
 				}
@@ -849,6 +945,7 @@ DatabaseContext::DatabaseContext(Reference<AsyncVar<Reference<ClusterConnectionF
     apiVersion(apiVersion), switchable(switchable), proxyProvisional(false), cc("TransactionMetrics"),
     transactionReadVersions("ReadVersions", cc), transactionReadVersionsThrottled("ReadVersionsThrottled", cc),
     transactionReadVersionsCompleted("ReadVersionsCompleted", cc),
+    transactionReadVersionsLeased("ReadVersionsLeased", cc),
     transactionReadVersionBatches("ReadVersionBatches", cc),
     transactionBatchReadVersions("BatchPriorityReadVersions", cc),
     transactionDefaultReadVersions("DefaultPriorityReadVersions", cc),
@@ -859,7 +956,9 @@ DatabaseContext::DatabaseContext(Reference<AsyncVar<Reference<ClusterConnectionF
     transactionLogicalReads("LogicalUncachedReads", cc), transactionPhysicalReads("PhysicalReadRequests", cc),
     transactionPhysicalReadsCompleted("PhysicalReadRequestsCompleted", cc),
     transactionGetKeyRequests("GetKeyRequests", cc), transactionGetValueRequests("GetValueRequests", cc),
-    transactionGetRangeRequests("GetRangeRequests", cc), transactionWatchRequests("WatchRequests", cc),
+    transactionGetRangeRequests("GetRangeRequests", cc),
+    transactionGetRangeStreamRequests("GetRangeStreamRequests", cc),
+    transactionGetRangeAggregateRequests("GetRangeAggregateRequests", cc), transactionGetRangeFilteredRequests("GetRangeFilteredRequests", cc), transactionWatchRequests("WatchRequests", cc),
     transactionGetAddressesForKeyRequests("GetAddressesForKeyRequests", cc), transactionBytesRead("BytesRead", cc),
     transactionKeysRead("KeysRead", cc), transactionMetadataVersionReads("MetadataVersionReads", cc),
     transactionCommittedMutations("CommittedMutations", cc),
@@ -875,6 +974,7 @@ DatabaseContext::DatabaseContext(Reference<AsyncVar<Reference<ClusterConnectionF
     latencies(1000), readLatencies(1000), commitLatencies(1000), GRVLatencies(1000), mutationsPerCommit(1000),
     bytesPerCommit(1000), mvCacheInsertLocation(0), healthMetricsLastUpdated(0), detailedHealthMetricsLastUpdated(0),
     internal(internal), transactionTracingEnabled(true), smoothMidShardSize(CLIENT_KNOBS->SHARD_STAT_SMOOTH_AMOUNT),
+    conflictHotspots(CLIENT_KNOBS->CONFLICT_HOTSPOT_HALF_LIFE, CLIENT_KNOBS->CONFLICT_HOTSPOT_MAX_RANGES),
     transactionsExpensiveClearCostEstCount("ExpensiveClearCostEstCount", cc),
     specialKeySpace(std::make_unique<SpecialKeySpace>(specialKeys.begin, specialKeys.end, /* test */ false)) {
 	dbId = deterministicRandom()->randomUniqueID();
@@ -887,6 +987,7 @@ DatabaseContext::DatabaseContext(Reference<AsyncVar<Reference<ClusterConnectionF
 
 	snapshotRywEnabled = apiVersionAtLeast(300) ? 1 : 0;
 
+	initProfileHistograms();
 	logger = databaseLogger( this );
 	locationCacheSize = g_network->isSimulated() ?
 			CLIENT_KNOBS->LOCATION_CACHE_EVICTION_SIZE_SIM :
@@ -960,6 +1061,12 @@ DatabaseContext::DatabaseContext(Reference<AsyncVar<Reference<ClusterConnectionF
 		                              std::make_unique<WriteConflictRangeImpl>(writeConflictRangeKeysRange));
 		registerSpecialKeySpaceModule(SpecialKeySpace::MODULE::METRICS, SpecialKeySpace::IMPLTYPE::READONLY,
 		                              std::make_unique<DDStatsRangeImpl>(ddStatsRange));
+		registerSpecialKeySpaceModule(SpecialKeySpace::MODULE::METRICS, SpecialKeySpace::IMPLTYPE::READONLY,
+		                              std::make_unique<HotKeysRangeImpl>(hotKeysRange));
+		registerSpecialKeySpaceModule(SpecialKeySpace::MODULE::METRICS, SpecialKeySpace::IMPLTYPE::READONLY,
+		                              std::make_unique<ConflictHotspotsRangeImpl>(conflictHotspotsRange));
+		registerSpecialKeySpaceModule(SpecialKeySpace::MODULE::METRICS, SpecialKeySpace::IMPLTYPE::READONLY,
+		                              std::make_unique<ProcessMetricsRangeImpl>(processMetricsRange));
 		registerSpecialKeySpaceModule(
 		    SpecialKeySpace::MODULE::METRICS, SpecialKeySpace::IMPLTYPE::READONLY,
 		    std::make_unique<HealthMetricsRangeImpl>(KeyRangeRef(LiteralStringRef("\xff\xff/metrics/health/"),
@@ -1024,6 +1131,7 @@ DatabaseContext::DatabaseContext(const Error& err)
   : deferredError(err), cc("TransactionMetrics"), transactionReadVersions("ReadVersions", cc),
     transactionReadVersionsThrottled("ReadVersionsThrottled", cc),
     transactionReadVersionsCompleted("ReadVersionsCompleted", cc),
+    transactionReadVersionsLeased("ReadVersionsLeased", cc),
     transactionReadVersionBatches("ReadVersionBatches", cc),
     transactionBatchReadVersions("BatchPriorityReadVersions", cc),
     transactionDefaultReadVersions("DefaultPriorityReadVersions", cc),
@@ -1034,7 +1142,9 @@ DatabaseContext::DatabaseContext(const Error& err)
     transactionLogicalReads("LogicalUncachedReads", cc), transactionPhysicalReads("PhysicalReadRequests", cc),
     transactionPhysicalReadsCompleted("PhysicalReadRequestsCompleted", cc),
     transactionGetKeyRequests("GetKeyRequests", cc), transactionGetValueRequests("GetValueRequests", cc),
-    transactionGetRangeRequests("GetRangeRequests", cc), transactionWatchRequests("WatchRequests", cc),
+    transactionGetRangeRequests("GetRangeRequests", cc),
+    transactionGetRangeStreamRequests("GetRangeStreamRequests", cc),
+    transactionGetRangeAggregateRequests("GetRangeAggregateRequests", cc), transactionGetRangeFilteredRequests("GetRangeFilteredRequests", cc), transactionWatchRequests("WatchRequests", cc),
     transactionGetAddressesForKeyRequests("GetAddressesForKeyRequests", cc), transactionBytesRead("BytesRead", cc),
     transactionKeysRead("KeysRead", cc), transactionMetadataVersionReads("MetadataVersionReads", cc),
     transactionCommittedMutations("CommittedMutations", cc),
@@ -1049,30 +1159,45 @@ DatabaseContext::DatabaseContext(const Error& err)
     transactionsThrottled("Throttled", cc), transactionsProcessBehind("ProcessBehind", cc), latencies(1000),
     readLatencies(1000), commitLatencies(1000), GRVLatencies(1000), mutationsPerCommit(1000), bytesPerCommit(1000),
     smoothMidShardSize(CLIENT_KNOBS->SHARD_STAT_SMOOTH_AMOUNT),
+    conflictHotspots(CLIENT_KNOBS->CONFLICT_HOTSPOT_HALF_LIFE, CLIENT_KNOBS->CONFLICT_HOTSPOT_MAX_RANGES),
     transactionsExpensiveClearCostEstCount("ExpensiveClearCostEstCount", cc), internal(false),
-    transactionTracingEnabled(true) {}
+    transactionTracingEnabled(true) {
+	initProfileHistograms();
+}
+
+void DatabaseContext::initProfileHistograms() {
+	profileGRVLatency = Histogram::getHistogram(LiteralStringRef("ClientProfile"), LiteralStringRef("GetReadVersion"), Histogram::Unit::microseconds);
+	profileGetLatency = Histogram::getHistogram(LiteralStringRef("ClientProfile"), LiteralStringRef("Get"), Histogram::Unit::microseconds);
+	profileGetRangeLatency = Histogram::getHistogram(LiteralStringRef("ClientProfile"), LiteralStringRef("GetRange"), Histogram::Unit::microseconds);
+	profileCommitLatency = Histogram::getHistogram(LiteralStringRef("ClientProfile"), LiteralStringRef("Commit"), Histogram::Unit::microseconds);
+}
 
 Database DatabaseContext::create(Reference<AsyncVar<ClientDBInfo>> clientInfo, Future<Void> clientInfoMonitor, LocalityData clientLocality, bool enableLocalityLoadBalance, TaskPriority taskID, bool lockAware, int apiVersion, bool switchable) {
 	return Database( new DatabaseContext( Reference<AsyncVar<Reference<ClusterConnectionFile>>>(), clientInfo, clientInfoMonitor, taskID, clientLocality, enableLocalityLoadBalance, lockAware, true, apiVersion, switchable ) );
 }
 
 DatabaseContext::~DatabaseContext() {
+	getValueBatcher.cancel();
 	cacheListMonitor.cancel();
 	monitorProxiesInfoChange.cancel();
 	for(auto it = server_interf.begin(); it != server_interf.end(); it = server_interf.erase(it))
 		it->second->notifyContextDestroyed();
 	ASSERT_ABORT( server_interf.empty() );
-	locationCache.insert(allKeys, Reference<LocationInfo>());
+	for(auto it = teamLocations.begin(); it != teamLocations.end(); it = teamLocations.erase(it))
+		it->second->cx = nullptr;
+	locationCache.insert(allKeys, CachedLocation());
 }
 
 pair<KeyRange, Reference<LocationInfo>> DatabaseContext::getCachedLocation( const KeyRef& key, bool isBackward ) {
 	if( isBackward ) {
 		auto range = locationCache.rangeContainingKeyBefore(key);
-		return std::make_pair(range->range(), range->value());
+		range->value().referenced = true;
+		return std::make_pair(range->range(), range->value().info);
 	}
 	else {
 		auto range = locationCache.rangeContaining(key);
-		return std::make_pair(range->range(), range->value());
+		range->value().referenced = true;
+		return std::make_pair(range->range(), range->value().info);
 	}
 }
 
@@ -1084,12 +1209,13 @@ bool DatabaseContext::getCachedLocations( const KeyRangeRef& range, vector<std::
 
 	loop {
 		auto r = reverse ? end : begin;
-		if (!r->value()){
+		if (!r->value().info){
 			TEST(result.size()); // had some but not all cached locations
 			result.clear();
 			return false;
 		}
-		result.emplace_back(r->range() & range, r->value());
+		r->value().referenced = true;
+		result.emplace_back(r->range() & range, r->value().info);
 		if (result.size() == limit || begin == end) {
 			break;
 		}
@@ -1110,31 +1236,69 @@ Reference<LocationInfo> DatabaseContext::setCachedLocation( const KeyRangeRef& k
 		serverRefs.push_back( StorageServerInfo::getInterface( this, interf, clientLocality ) );
 	}
 
-	int maxEvictionAttempts = 100, attempts = 0;
-	auto loc = makeReference<LocationInfo>(serverRefs);
-	while( locationCache.size() > locationCacheSize && attempts < maxEvictionAttempts) {
-		TEST( true ); // NativeAPI storage server locationCache entry evicted
-		attempts++;
-		auto r = locationCache.randomRange();
-		Key begin = r.begin(), end = r.end();  // insert invalidates r, so can't be passed a mere reference into it
-		locationCache.insert(KeyRangeRef(begin, end), Reference<LocationInfo>());
+	// Every shard of a team shares one LocationInfo, as long as the team's servers still have the same interfaces
+	std::vector<UID> team;
+	team.reserve(servers.size());
+	for (const auto& interf : servers) {
+		team.push_back(interf.id());
+	}
+	std::sort(team.begin(), team.end());
+
+	auto sameServers = [&serverRefs](LocationInfo* info) {
+		if (info->size() != (int)serverRefs.size()) {
+			return false;
+		}
+		for (int i = 0; i < info->size(); i++) {
+			auto ptr = (*info)[i].getPtr();
+			if (std::none_of(serverRefs.begin(), serverRefs.end(), [ptr](const auto& ref) { return ref.getPtr() == ptr; })) {
+				return false;
+			}
+		}
+		return true;
+	};
+
+	Reference<LocationInfo> loc;
+	auto t = teamLocations.find(team);
+	if (t != teamLocations.end() && sameServers(t->second)) {
+		loc = Reference<LocationInfo>::addRef(t->second);
+	} else {
+		loc = makeReference<LocationInfo>(serverRefs);
+		loc->cx = this;
+		loc->team = team;
+		teamLocations[team] = loc.getPtr();
+	}
+
+	// Evict by CLOCK: the hand sweeps on from where it last stopped, giving an entry that has been looked up since
+	// it last passed a second chance, and evicting the first entry that has not
+	int maxEvictionSteps = 100, steps = 0;
+	while( locationCache.size() > locationCacheSize && steps < maxEvictionSteps ) {
+		steps++;
+		auto r = locationCache.rangeContaining(locationCacheHand);
+		Key begin = r->range().begin, end = r->range().end;  // insert invalidates r, so can't be passed a mere reference into it
+		locationCacheHand = end < allKeys.end ? end : allKeys.begin;
+		if (r->value().referenced) {
+			r->value().referenced = false;
+		} else if (r->value().info) {
+			TEST( true ); // NativeAPI storage server locationCache entry evicted
+			locationCache.insert(KeyRangeRef(begin, end), CachedLocation());
+		}
 	}
-	locationCache.insert( keys, loc );
+	locationCache.insert( keys, CachedLocation(loc) );
 	return loc;
 }
 
 void DatabaseContext::invalidateCache( const KeyRef& key, bool isBackward ) {
 	if( isBackward ) {
-		locationCache.rangeContainingKeyBefore(key)->value() = Reference<LocationInfo>();
+		locationCache.rangeContainingKeyBefore(key)->value() = CachedLocation();
 	} else {
-		locationCache.rangeContaining(key)->value() = Reference<LocationInfo>();
+		locationCache.rangeContaining(key)->value() = CachedLocation();
 	}
 }
 
 void DatabaseContext::invalidateCache( const KeyRangeRef& keys ) {
 	auto rs = locationCache.intersectingRanges(keys);
 	Key begin = rs.begin().begin(), end = rs.end().begin();  // insert invalidates rs, so can't be passed a mere reference into it
-	locationCache.insert(KeyRangeRef(begin, end), Reference<LocationInfo>());
+	locationCache.insert(KeyRangeRef(begin, end), CachedLocation());
 }
 
 Future<Void> DatabaseContext::onProxiesChanged() {
@@ -1191,7 +1355,7 @@ void DatabaseContext::setOption( FDBDatabaseOptions::Option option, Optional<Str
 			    if( clientInfo->get().grvProxies.size() )
 				    grvProxies = makeReference<GrvProxyInfo>(clientInfo->get().grvProxies, true);
 			    server_interf.clear();
-				locationCache.insert( allKeys, Reference<LocationInfo>() );
+				locationCache.insert( allKeys, CachedLocation() );
 				break;
 			case FDBDatabaseOptions::MAX_WATCHES:
 				maxOutstandingWatches = (int)extractIntOption(value, 0, CLIENT_KNOBS->ABSOLUTE_MAX_WATCHES);
@@ -1203,7 +1367,7 @@ void DatabaseContext::setOption( FDBDatabaseOptions::Option option, Optional<Str
 			    if( clientInfo->get().grvProxies.size() )
 				    grvProxies = makeReference<GrvProxyInfo>(clientInfo->get().grvProxies, true);
 			    server_interf.clear();
-				locationCache.insert( allKeys, Reference<LocationInfo>() );
+				locationCache.insert( allKeys, CachedLocation() );
 				break;
 			case FDBDatabaseOptions::SNAPSHOT_RYW_ENABLE:
 				validateOptionValue(value, false);
@@ -1746,6 +1910,8 @@ ACTOR Future<Optional<vector<StorageServerInterface>>> transactionalGetServerInt
 }
 
 //If isBackward == true, returns the shard containing the key before 'key' (an infinitely long, inexpressible key). Otherwise returns the shard containing key
+//The locations of the shards that follow it in that direction are fetched in the same request and cached as well, since a
+//client that misses on one shard is likely to go on to its neighbours, or to have lost them to the same data movement.
 ACTOR Future<pair<KeyRange, Reference<LocationInfo>>> getKeyLocation_internal(Database cx, Key key,
                                                                               TransactionInfo info,
                                                                               bool isBackward = false) {
@@ -1755,6 +1921,7 @@ ACTOR Future<pair<KeyRange, Reference<LocationInfo>>> getKeyLocation_internal(Da
 	} else {
 		ASSERT( key < allKeys.end );
 	}
+	state KeyRange prefetch = isBackward ? KeyRangeRef(allKeys.begin, key) : KeyRangeRef(key, allKeys.end);
 
 	if( info.debugID.present() )
 		g_traceBatch.addEvent("TransactionDebug", info.debugID.get().first(), "NativeAPI.getKeyLocation.Before");
@@ -1765,13 +1932,20 @@ ACTOR Future<pair<KeyRange, Reference<LocationInfo>>> getKeyLocation_internal(Da
 			when (wait(cx->onProxiesChanged())) {}
 			when(GetKeyServerLocationsReply rep = wait(basicLoadBalance(
 			         cx->getCommitProxies(info.useProvisionalProxies), &CommitProxyInterface::getKeyServersLocations,
-			         GetKeyServerLocationsRequest(span.context, key, Optional<KeyRef>(), 100, isBackward, key.arena()),
+			         GetKeyServerLocationsRequest(span.context, prefetch.begin, prefetch.end,
+			                                      CLIENT_KNOBS->LOCATION_CACHE_MISS_PREFETCH_SHARDS, isBackward,
+			                                      prefetch.arena()),
 			         TaskPriority::DefaultPromiseEndpoint))) {
 				++cx->transactionKeyServerLocationRequestsCompleted;
 				if( info.debugID.present() )
 					g_traceBatch.addEvent("TransactionDebug", info.debugID.get().first(), "NativeAPI.getKeyLocation.After");
-				ASSERT( rep.results.size() == 1 );
+				ASSERT( rep.results.size() >= 1 );
 
+				// The first result is the shard containing (or, if isBackward, before) key; cache it last so that it is
+				// the entry least likely to have been evicted by the time it is used
+				for (int i = rep.results.size() - 1; i > 0; i--) {
+					cx->setCachedLocation(rep.results[i].first, rep.results[i].second);
+				}
 				auto locationInfo = cx->setCachedLocation(rep.results[0].first, rep.results[0].second);
 				return std::make_pair(KeyRange(rep.results[0].first, rep.arena), locationInfo);
 			}
@@ -1909,6 +2083,112 @@ Future<Void> Transaction::warmRange(Database cx, KeyRange keys) {
 	return warmRange_impl(this, cx, keys);
 }
 
+// Sends one batch of point reads collected by getValueBatcher, and hands each caller its own reply
+ACTOR Future<Void> sendGetValueBatch(DatabaseContext* cx, std::vector<DatabaseContext::GetValueBatchRequest> requests) {
+	state Span span("NAPI:getValueBatch"_loc);
+	try {
+		if (requests.size() == 1) {
+			GetValueReply reply = wait(loadBalance(
+			    cx, requests[0].location, &StorageServerInterface::getValue,
+			    GetValueRequest(span.context, requests[0].key, requests[0].version, Optional<TagSet>(), Optional<UID>()),
+			    TaskPriority::DefaultPromiseEndpoint, false, cx->enableLocalityLoadBalance ? &cx->queueModel : nullptr));
+			requests[0].reply.send(reply);
+			return Void();
+		}
+
+		state Standalone<VectorRef<KeyRef>> keys;
+		for (const auto& r : requests) {
+			keys.push_back_deep(keys.arena(), r.key);
+		}
+		GetValuesReply reply = wait(loadBalance(
+		    cx, requests[0].location, &StorageServerInterface::getValues,
+		    GetValuesRequest(span.context, keys, requests[0].version, Optional<TagSet>(), Optional<UID>()),
+		    TaskPriority::DefaultPromiseEndpoint, false, cx->enableLocalityLoadBalance ? &cx->queueModel : nullptr));
+
+		// reply.data holds the keys that are present, in request order
+		int next = 0;
+		for (auto& r : requests) {
+			Optional<Value> value;
+			if (next < reply.data.size() && reply.data[next].key == r.key) {
+				value = Value(reply.data[next].value, reply.arena);
+				next++;
+			}
+			GetValueReply single(value, reply.cached);
+			single.penalty = reply.penalty;
+			r.reply.send(single);
+		}
+	} catch (Error& e) {
+		if (e.code() == error_code_actor_cancelled) throw;
+		// Each getValue handles the error on its own, e.g. retrying after wrong_shard_server
+		for (auto& r : requests) {
+			r.reply.sendError(e);
+		}
+	}
+	return Void();
+}
+
+ACTOR Future<Void> getValueBatcher(DatabaseContext* cx, FutureStream<DatabaseContext::GetValueBatchRequest> stream) {
+	// Requests are grouped by the servers that can answer them, so that keys from different shards on the same team
+	// share a batch
+	state std::map<std::pair<std::vector<UID>, Version>, std::vector<DatabaseContext::GetValueBatchRequest>> pending;
+	state PromiseStream<Future<Void>> addActor;
+	state Future<Void> collection = actorCollection(addActor.getFuture());
+	state Future<Void> timeout = Never();
+
+	loop {
+		choose {
+			when(DatabaseContext::GetValueBatchRequest req = waitNext(stream)) {
+				if (pending.empty()) {
+					timeout = delay(CLIENT_KNOBS->GET_VALUE_BATCH_DELAY);
+				}
+				std::vector<UID> team;
+				for (int i = 0; i < req.location->size(); i++) {
+					team.push_back(req.location->getId(i));
+				}
+				std::sort(team.begin(), team.end());
+
+				auto batchKey = std::make_pair(std::move(team), req.version);
+				auto& batch = pending[batchKey];
+				batch.push_back(req);
+				if (batch.size() >= CLIENT_KNOBS->GET_VALUE_BATCH_MAX_KEYS) {
+					addActor.send(sendGetValueBatch(cx, std::move(batch)));
+					pending.erase(batchKey);
+				}
+			}
+			when(wait(timeout)) {
+				for (auto& batch : pending) {
+					addActor.send(sendGetValueBatch(cx, std::move(batch.second)));
+				}
+				pending.clear();
+				timeout = Never();
+			}
+			when(wait(collection)) {
+				ASSERT(false);
+				throw internal_error();
+			}
+		}
+	}
+}
+
+// The reply to a point read, which may be sent as part of a GetValuesRequest batch unless it needs debugging or tag
+// sampling.  Caches are not sent batches.
+Future<GetValueReply> getValueReply(Database const& cx, Reference<LocationInfo> const& location, Key const& key,
+                                    Version version, SpanID spanContext, Optional<TagSet> const& tags,
+                                    Optional<UID> const& getValueID) {
+	if (CLIENT_KNOBS->GET_VALUE_BATCHING && !tags.present() && !getValueID.present() && !location->hasCaches) {
+		if (!cx->getValueBatcher.isValid()) {
+			cx->getValueBatcher = getValueBatcher(cx.getPtr(), cx->getValueBatchStream.getFuture());
+		}
+		DatabaseContext::GetValueBatchRequest req(location, key, version);
+		cx->getValueBatchStream.send(req);
+		return req.reply.getFuture();
+	}
+
+	return loadBalance(cx.getPtr(), location, &StorageServerInterface::getValue,
+	                   GetValueRequest(spanContext, key, version, tags, getValueID), TaskPriority::DefaultPromiseEndpoint,
+	                   false, cx->enableLocalityLoadBalance ? &cx->queueModel : nullptr);
+}
+
 ACTOR Future<Optional<Value>> getValue( Future<Version> version, Key key, Database cx, TransactionInfo info, Reference<TransactionLogInfo> trLogInfo, TagSet tags )
 {
 	state Version ver = wait( version );
@@ -1946,12 +2226,9 @@ ACTOR Future<Optional<Value>> getValue( Future<Version> version, Key key, Databa
 				}
 				choose {
 					when(wait(cx->connectionFileChanged())) { throw transaction_too_old(); }
-					when(GetValueReply _reply = wait(
-					         loadBalance(cx.getPtr(), ssi.second, &StorageServerInterface::getValue,
-					                     GetValueRequest(span.context, key, ver,
-					                                     cx->sampleReadTags() ? tags : Optional<TagSet>(), getValueID),
-					                     TaskPriority::DefaultPromiseEndpoint, false,
-					                     cx->enableLocalityLoadBalance ? &cx->queueModel : nullptr))) {
+					when(GetValueReply _reply = wait(getValueReply(cx, ssi.second, key, ver, span.context,
+					                                               cx->sampleReadTags() ? tags : Optional<TagSet>(),
+					                                               getValueID))) {
 						reply = _reply;
 					}
 				}
@@ -1967,6 +2244,7 @@ ACTOR Future<Optional<Value>> getValue( Future<Version> version, Key key, Databa
 			if (trLogInfo) {
 				int valueSize = reply.value.present() ? reply.value.get().size() : 0;
 				trLogInfo->addLog(FdbClientLogEvents::EventGet(startTimeD, cx->clientLocality.dcId(), latency, valueSize, key));
+				cx->profileGetLatency->sampleSeconds(latency);
 			}
 			cx->getValueCompleted->latency = timer_int() - startTime;
 			cx->getValueCompleted->log();
@@ -2117,12 +2395,11 @@ ACTOR Future<Void> readVersionBatcher(
 	DatabaseContext* cx, FutureStream<std::pair<Promise<GetReadVersionReply>, Optional<UID>>> versionStream,
 	uint32_t flags);
 
-ACTOR Future<Void> watchValue(Future<Version> version, Key key, Optional<Value> value, Database cx,
-                              TransactionInfo info, TagSet tags) {
-	state Version ver = wait( version );
+// Waits until a storage server reads a value of key other than value at a committed version after ver, and returns
+// that version
+ACTOR Future<Version> watchStorageServerValue(Version ver, Key key, Optional<Value> value, Database cx,
+                                              TransactionInfo info, TagSet tags) {
 	state Span span("NAPI:watchValue"_loc, info.spanID);
-	cx->validateVersion(ver);
-	ASSERT(ver != latestVersion);
 
 	loop {
 		state pair<KeyRange, Reference<LocationInfo>> ssi = wait( getKeyLocation(cx, key, &StorageServerInterface::watchValue, info ) );
@@ -2158,7 +2435,7 @@ ACTOR Future<Void> watchValue(Future<Version> version, Key key, Optional<Value>
 
 			// False if there is a master failure between getting the response and getting the committed version,
 			// Dependent on SERVER_KNOBS->MAX_VERSIONS_IN_FLIGHT
-			if (v - resp.version < 50000000) return Void();
+			if (v - resp.version < 50000000) return resp.version;
 			ver = v;
 		} catch (Error& e) {
 			if (e.code() == error_code_wrong_shard_server || e.code() == error_code_all_alternatives_failed) {
@@ -2180,6 +2457,57 @@ ACTOR Future<Void> watchValue(Future<Version> version, Key key, Optional<Value>
 	}
 }
 
+void releaseSharedWatch(Database cx, Key key, Reference<DatabaseContext::SharedWatch> shared) {
+	if (--shared->subscribers == 0) {
+		auto it = cx->sharedWatches.find(key);
+		if (it != cx->sharedWatches.end() && it->second == shared) {
+			cx->sharedWatches.erase(it);
+		}
+	}
+}
+
+ACTOR Future<Void> watchValue(Future<Version> version, Key key, Optional<Value> value, Database cx,
+                              TransactionInfo info, TagSet tags) {
+	state Version ver = wait( version );
+	cx->validateVersion(ver);
+	ASSERT(ver != latestVersion);
+
+	// A watch of a key other transactions are already watching for the same value waits on their watch instead of
+	// sending its own.  Only a change at a version after this watch's read version can fire it.
+	state Reference<DatabaseContext::SharedWatch> shared;
+	auto it = cx->sharedWatches.find(key);
+	if (it == cx->sharedWatches.end() || it->second->changed.isReady()) {
+		shared = makeReference<DatabaseContext::SharedWatch>();
+		shared->value = value;
+		shared->version = ver;
+		shared->changed = watchStorageServerValue(ver, key, value, cx, info, tags);
+		cx->sharedWatches[key] = shared;
+	} else if (it->second->value == value) {
+		TEST(true); // Watch shares the storage server watch of another transaction
+		shared = it->second;
+	} else {
+		wait(success(watchStorageServerValue(ver, key, value, cx, info, tags)));
+		return Void();
+	}
+
+	++shared->subscribers;
+	try {
+		Version changed = wait(shared->changed);
+		releaseSharedWatch(cx, key, shared);
+		if (changed > ver) {
+			return Void();
+		}
+	} catch (Error& e) {
+		releaseSharedWatch(cx, key, shared);
+		throw;
+	}
+
+	// The shared watch was started at an earlier version and fired for a change this watch had already read
+	TEST(true); // Shared watch fired before the read version of a watch
+	wait(success(watchStorageServerValue(ver, key, value, cx, info, tags)));
+	return Void();
+}
+
 void transformRangeLimits(GetRangeLimits limits, bool reverse, GetKeyValuesRequest &req) {
 	if(limits.bytes != 0) {
 		if(!limits.hasRowLimit())
@@ -2418,6 +2746,7 @@ void getRangeFinished(Database cx, Reference<TransactionLogInfo> trLogInfo, doub
 
 	if( trLogInfo ) {
 		trLogInfo->addLog(FdbClientLogEvents::EventGetRange(startTime, cx->clientLocality.dcId(), now()-startTime, bytes, begin.getKey(), end.getKey()));
+		cx->profileGetRangeLatency->sampleSeconds(now() - startTime);
 	}
 
 	if( !snapshot ) {
@@ -2683,6 +3012,379 @@ Future<Standalone<RangeResultRef>> getRange( Database const& cx, Future<Version>
 	return getRange(cx, Reference<TransactionLogInfo>(), fVersion, begin, end, limits, Promise<std::pair<Key, Key>>(), true, reverse, info, tags);
 }
 
+// Reads keys forward a shard at a time.  Each shard is streamed from one of its storage servers, which sends page after
+// page at the same version without waiting for a request per page; a page is only taken off the stream once results
+// has been drained, so a slow reader holds the server back rather than buffering the range here.
+ACTOR Future<Void> getRangeStream( PromiseStream<Standalone<RangeResultRef>> results, Database cx, Future<Version> fVersion,
+	KeyRange keys, GetRangeLimits limits, Promise<std::pair<Key, Key>> conflictRange, TransactionInfo info, TagSet tags )
+{
+	state Span span("NAPI:getRangeStream"_loc, info.spanID);
+	state Key readThrough = keys.begin; // Everything before this has been sent to results
+
+	try {
+		state Version version = wait( fVersion );
+		cx->validateVersion(version);
+
+		while( readThrough < keys.end && !limits.isReached() ) {
+			state pair<KeyRange, Reference<LocationInfo>> location = wait( getKeyLocation( cx, readThrough, &StorageServerInterface::getKeyValuesStream, info ) );
+			state KeyRange range = KeyRangeRef( readThrough, std::min( keys.end, location.first.end ) );
+
+			try {
+				if( location.second->hasCaches ) {
+					// Cache servers do not serve streams, so page through this shard the usual way
+					TEST(true); // getRangeStream of a cached range
+					Standalone<RangeResultRef> rep = wait( getExactRange( cx, version, range, limits, false, info, tags ) );
+					limits.decrement( rep );
+					if( rep.size() ) {
+						readThrough = keyAfter( rep.back().key );
+						results.send( rep );
+					}
+					if( !rep.more ) {
+						readThrough = range.end;
+					}
+					continue;
+				}
+
+				state int useIdx = -1;
+				int healthy = 0;
+				for( int i = 0; i < location.second->size(); i++ ) {
+					if( !IFailureMonitor::failureMonitor().getState( location.second->get( i, &StorageServerInterface::getKeyValuesStream ).getEndpoint() ).failed &&
+					    deterministicRandom()->random01() <= 1.0 / ++healthy ) {
+						useIdx = i;
+					}
+				}
+				if( useIdx < 0 ) {
+					throw all_alternatives_failed();
+				}
+
+				state GetKeyValuesStreamRequest req;
+				req.version = version;
+				req.begin = firstGreaterOrEqual( range.begin );
+				req.end = firstGreaterOrEqual( range.end );
+				req.limit = limits.hasRowLimit() ? limits.rows : std::numeric_limits<int>::max();
+				req.limitBytes = limits.hasByteLimit() ? limits.bytes : std::numeric_limits<int>::max();
+				req.spanContext = span.context;
+				req.tags = cx->sampleReadTags() ? tags : Optional<TagSet>();
+				req.debugID = info.debugID;
+
+				++cx->transactionPhysicalReads;
+				state ReplyPromiseStream<GetKeyValuesStreamReply> replyStream = location.second->get( useIdx, &StorageServerInterface::getKeyValuesStream ).getReplyStream( req );
+				state FutureStream<GetKeyValuesStreamReply> pages = replyStream.getFuture();
+				state bool more = true;
+				try {
+					loop {
+						wait( results.onEmpty() );
+						choose {
+							when( wait( cx->connectionFileChanged() ) ) { throw transaction_too_old(); }
+							when( GetKeyValuesStreamReply rep = waitNext( pages ) ) {
+								more = rep.more;
+								if( rep.data.size() ) {
+									Standalone<RangeResultRef> output;
+									output.arena().dependsOn( rep.arena );
+									output.append( output.arena(), rep.data.begin(), rep.data.size() );
+									output.more = true;
+									limits.decrement( rep.data );
+									readThrough = keyAfter( output.back().key );
+									results.send( output );
+								}
+							}
+						}
+					}
+				} catch( Error& e ) {
+					++cx->transactionPhysicalReadsCompleted;
+					if( e.code() != error_code_end_of_stream )
+						throw;
+				}
+				if( !more ) {
+					readThrough = range.end;
+				}
+			} catch( Error& e ) {
+				if( e.code() == error_code_wrong_shard_server || e.code() == error_code_all_alternatives_failed ||
+				    e.code() == error_code_connection_failed || e.code() == error_code_request_maybe_delivered ||
+				    e.code() == error_code_broken_promise ) {
+					// Pick up from where the stream stopped
+					cx->invalidateCache( KeyRangeRef( readThrough, keys.end ) );
+					wait( delay( CLIENT_KNOBS->WRONG_SHARD_SERVER_DELAY, info.taskID ) );
+				} else {
+					throw;
+				}
+			}
+		}
+
+		if( !limits.isReached() ) {
+			readThrough = keys.end;
+		}
+		conflictRange.send( std::make_pair( keys.begin, readThrough ) );
+		results.sendError( end_of_stream() );
+		return Void();
+	} catch( Error& e ) {
+		// Whatever was delivered has been read, even if the rest never will be
+		if( conflictRange.canBeSet() ) {
+			conflictRange.send( std::make_pair( keys.begin, readThrough ) );
+		}
+		if( e.code() != error_code_actor_cancelled ) {
+			results.sendError( e );
+		}
+		throw;
+	}
+}
+
+// Reads one shard's part of a parallel range read into output a page at a time, waiting for output to be drained before
+// reading the next page.  With endStream, output is ended with end_of_stream or the error that stopped the read.
+ACTOR Future<Void> readParallelRangePart( PromiseStream<Standalone<RangeResultRef>> output, Database cx, Version version,
+	KeyRange range, bool endStream, TransactionInfo info, TagSet tags )
+{
+	try {
+		loop {
+			wait( output.onEmpty() );
+			Standalone<RangeResultRef> rep = wait( getExactRange( cx, version, range,
+				GetRangeLimits( GetRangeLimits::ROW_LIMIT_UNLIMITED, CLIENT_KNOBS->REPLY_BYTE_LIMIT ), false, info, tags ) );
+			if( rep.size() ) {
+				range = KeyRangeRef( keyAfter( rep.back().key ), range.end );
+				output.send( rep );
+			}
+			if( !rep.more || range.empty() ) {
+				break;
+			}
+		}
+		if( endStream ) {
+			output.sendError( end_of_stream() );
+		}
+		return Void();
+	} catch( Error& e ) {
+		if( endStream && e.code() != error_code_actor_cancelled ) {
+			output.sendError( e );
+		}
+		throw;
+	}
+}
+
+// Reads keys with up to parallelism shards being read at once, from whichever storage teams hold them.  Ordered results
+// are sent in key order, and the shards after the one being sent only read ahead one page each.  Unordered results are
+// sent as each shard's pages arrive, so no shard waits on another.
+ACTOR Future<Void> getRangeParallel( PromiseStream<Standalone<RangeResultRef>> results, Database cx, Future<Version> fVersion,
+	KeyRange keys, int parallelism, bool ordered, Promise<std::pair<Key, Key>> conflictRange, TransactionInfo info, TagSet tags )
+{
+	state Span span("NAPI:getRangeParallel"_loc, info.spanID);
+	state Key begin = keys.begin; // Everything before this has a reader
+	state Deque<PromiseStream<Standalone<RangeResultRef>>> parts;
+	state std::vector<Future<Void>> readers;
+
+	try {
+		state Version version = wait( fVersion );
+		cx->validateVersion(version);
+
+		loop {
+			while( begin < keys.end && readers.size() < parallelism ) {
+				state vector<pair<KeyRange, Reference<LocationInfo>>> locations = wait( getKeyRangeLocations( cx,
+					KeyRangeRef( begin, keys.end ), parallelism - readers.size(), false, &StorageServerInterface::getKeyValues, info ) );
+				for( auto& location : locations ) {
+					KeyRange range = KeyRangeRef( begin, std::min( keys.end, location.first.end ) );
+					PromiseStream<Standalone<RangeResultRef>> output = ordered ? PromiseStream<Standalone<RangeResultRef>>() : results;
+					if( ordered ) {
+						parts.push_back( output );
+					}
+					readers.push_back( readParallelRangePart( output, cx, version, range, ordered, info, tags ) );
+					begin = range.end;
+				}
+			}
+			if( readers.empty() ) {
+				break;
+			}
+
+			if( ordered ) {
+				// Send the first shard's pages, while the readers of those after it fetch their first page
+				try {
+					loop {
+						wait( results.onEmpty() );
+						Standalone<RangeResultRef> page = waitNext( parts.front().getFuture() );
+						results.send( page );
+					}
+				} catch( Error& e ) {
+					if( e.code() != error_code_end_of_stream )
+						throw;
+				}
+				parts.pop_front();
+				readers.erase( readers.begin() );
+			} else {
+				wait( waitForAny( readers ) );
+				for( int i = 0; i < readers.size(); ) {
+					if( readers[i].isReady() ) {
+						readers[i].get(); // Throws the error that stopped the reader
+						readers[i] = readers.back();
+						readers.pop_back();
+					} else {
+						++i;
+					}
+				}
+			}
+		}
+
+		conflictRange.send( std::make_pair( keys.begin, keys.end ) );
+		results.sendError( end_of_stream() );
+		return Void();
+	} catch( Error& e ) {
+		// The pages already delivered are scattered over the range when unordered, so conflict on all of it
+		if( conflictRange.canBeSet() ) {
+			conflictRange.send( std::make_pair( keys.begin, keys.end ) );
+		}
+		if( e.code() != error_code_actor_cancelled ) {
+			results.sendError( e );
+		}
+		throw;
+	}
+}
+
+// Moves the mutations that every stream of a change feed has sent, which are those before the least of their ends, from
+// pending to output in version order.  Returns the version the feed has been sent through.
+static Version mergeChangeFeedStreams(std::vector<std::deque<Standalone<MutationsAndVersionRef>>>& pending,
+                                      std::vector<Version> const& ends,
+                                      Standalone<VectorRef<MutationsAndVersionRef>>& output) {
+	Version through = *std::min_element(ends.begin(), ends.end());
+	loop {
+		int next = -1;
+		for (int i = 0; i < pending.size(); i++) {
+			if (!pending[i].empty() && pending[i].front().version < through &&
+			    (next < 0 || pending[i].front().version < pending[next].front().version)) {
+				next = i;
+			}
+		}
+		if (next < 0) {
+			return through;
+		}
+		auto const& m = pending[next].front();
+		output.arena().dependsOn(m.arena());
+		if (output.size() && output.back().version == m.version) {
+			// Shards see the same versions, so two streams can each have part of one commit
+			output.back().mutations.append(output.arena(), m.mutations.begin(), m.mutations.size());
+		} else {
+			output.push_back(output.arena(), m);
+		}
+		pending[next].pop_front();
+	}
+}
+
+// Streams each shard of range from one of its storage servers, and merges the streams by version.  Only the stream
+// that is furthest behind is read from, so the others wait on the storage servers' flow control rather than here.
+ACTOR Future<Void> getChangeFeedStream(Database cx, PromiseStream<Standalone<VectorRef<MutationsAndVersionRef>>> results,
+                                       KeyRange range, Version begin, Version end) {
+	state Span span("NAPI:getChangeFeedStream"_loc);
+	state TransactionInfo info(TaskPriority::DefaultEndpoint, span.context);
+
+	try {
+		loop {
+			state vector<pair<KeyRange, Reference<LocationInfo>>> locations =
+			    wait(getKeyRangeLocations(cx, range, CLIENT_KNOBS->CHANGE_FEED_SHARD_LIMIT, false,
+			                              &StorageServerInterface::changeFeedStream, info));
+			if (locations.back().first.end < range.end) {
+				TEST(true); // Change feed of more than CHANGE_FEED_SHARD_LIMIT shards
+				throw unsupported_operation();
+			}
+
+			state std::vector<ReplyPromiseStream<ChangeFeedStreamReply>> streams;
+			state std::vector<FutureStream<ChangeFeedStreamReply>> replies;
+			state std::vector<std::deque<Standalone<MutationsAndVersionRef>>> pending;
+			state std::vector<Version> ends;
+			try {
+				streams.clear();
+				replies.clear();
+				pending.assign(locations.size(), std::deque<Standalone<MutationsAndVersionRef>>());
+				ends.assign(locations.size(), begin);
+				for (int i = 0; i < locations.size(); i++) {
+					int useIdx = -1;
+					int healthy = 0;
+					for (int j = 0; j < locations[i].second->size(); j++) {
+						if (!IFailureMonitor::failureMonitor()
+						         .getState(locations[i].second->get(j, &StorageServerInterface::changeFeedStream).getEndpoint())
+						         .failed &&
+						    deterministicRandom()->random01() <= 1.0 / ++healthy) {
+							useIdx = j;
+						}
+					}
+					if (useIdx < 0) {
+						throw all_alternatives_failed();
+					}
+
+					ChangeFeedStreamRequest req;
+					req.range = KeyRangeRef(req.arena, locations[i].first & range);
+					req.begin = begin;
+					req.end = end;
+					req.spanContext = span.context;
+					streams.push_back(
+					    locations[i].second->get(useIdx, &StorageServerInterface::changeFeedStream).getReplyStream(req));
+					replies.push_back(streams.back().getFuture());
+				}
+
+				loop {
+					state Standalone<VectorRef<MutationsAndVersionRef>> output;
+					output = Standalone<VectorRef<MutationsAndVersionRef>>();
+					begin = mergeChangeFeedStreams(pending, ends, output);
+					if (output.size()) {
+						results.send(output);
+						wait(results.onEmpty());
+					}
+					if (begin >= end) {
+						results.sendError(end_of_stream());
+						return Void();
+					}
+
+					state int laggard = std::min_element(ends.begin(), ends.end()) - ends.begin();
+					choose {
+						when(wait(cx->connectionFileChanged())) { throw transaction_too_old(); }
+						when(ChangeFeedStreamReply rep = waitNext(replies[laggard])) {
+							for (auto const& m : rep.mutations) {
+								pending[laggard].push_back(Standalone<MutationsAndVersionRef>(m, rep.arena));
+							}
+							ends[laggard] = rep.end;
+						}
+					}
+				}
+			} catch (Error& e) {
+				if (e.code() == error_code_wrong_shard_server || e.code() == error_code_all_alternatives_failed ||
+				    e.code() == error_code_connection_failed || e.code() == error_code_request_maybe_delivered ||
+				    e.code() == error_code_broken_promise || e.code() == error_code_end_of_stream) {
+					// Start over from where the merged feed stopped
+					cx->invalidateCache(range);
+					wait(delay(CLIENT_KNOBS->WRONG_SHARD_SERVER_DELAY, info.taskID));
+				} else {
+					throw;
+				}
+			}
+		}
+	} catch (Error& e) {
+		if (e.code() != error_code_actor_cancelled) {
+			results.sendError(e);
+		}
+		throw;
+	}
+}
+
+ACTOR static Future<Standalone<VectorRef<ChangeFeedMutationRef>>> readChangeFeedActor(Database cx, KeyRange range,
+                                                                                      Version begin, Version end) {
+	state PromiseStream<Standalone<VectorRef<MutationsAndVersionRef>>> results;
+	state Future<Void> stream = getChangeFeedStream(cx, results, range, begin, end);
+	state Standalone<VectorRef<ChangeFeedMutationRef>> mutations;
+	try {
+		Standalone<VectorRef<MutationsAndVersionRef>> batch = waitNext(results.getFuture());
+		mutations.arena().dependsOn(batch.arena());
+		for (auto const& v : batch) {
+			for (auto const& m : v.mutations) {
+				mutations.push_back(mutations.arena(), ChangeFeedMutationRef(v.version, m.type, m.param1, m.param2));
+			}
+		}
+	} catch (Error& e) {
+		if (e.code() != error_code_end_of_stream) {
+			throw;
+		}
+	}
+	return mutations;
+}
+
+Future<Standalone<VectorRef<ChangeFeedMutationRef>>> DatabaseContext::readChangeFeed(KeyRange range, Version begin,
+                                                                                     Version end) {
+	return readChangeFeedActor(Database(Reference<DatabaseContext>::addRef(this)), range, begin, end);
+}
+
 bool DatabaseContext::debugUseTags = false;
 const std::vector<std::string> DatabaseContext::debugTransactionTagChoices = { "a", "b", "c", "d", "e", "f", "g", "h", "i", "j", "k", "l", "m", "n", "o", "p", "q", "r", "s", "t" };
 
@@ -2999,6 +3701,248 @@ Future< Standalone<RangeResultRef> > Transaction::getRange(
 	return getRange( begin, end, GetRangeLimits( limit ), snapshot, reverse );
 }
 
+Future<Void> Transaction::getRangeStream( const PromiseStream<Standalone<RangeResultRef>>& results, const KeyRange& keys,
+	GetRangeLimits limits, bool snapshot )
+{
+	++cx->transactionLogicalReads;
+	++cx->transactionGetRangeStreamRequests;
+
+	if( !limits.isValid() ) {
+		results.sendError( range_limits_invalid() );
+		return range_limits_invalid();
+	}
+
+	Promise<std::pair<Key, Key>> conflictRange;
+	if(!snapshot) {
+		extraConflictRanges.push_back( conflictRange.getFuture() );
+	}
+
+	return ::getRangeStream( results, cx, getReadVersion(), keys, limits, conflictRange, info, options.readTags );
+}
+
+Future<Void> Transaction::getRangeParallel( const PromiseStream<Standalone<RangeResultRef>>& results, const KeyRange& keys,
+	int parallelism, bool ordered, bool snapshot )
+{
+	++cx->transactionLogicalReads;
+	++cx->transactionGetRangeStreamRequests;
+
+	if( parallelism < 1 ) {
+		results.sendError( client_invalid_operation() );
+		return client_invalid_operation();
+	}
+
+	Promise<std::pair<Key, Key>> conflictRange;
+	if(!snapshot) {
+		extraConflictRanges.push_back( conflictRange.getFuture() );
+	}
+
+	return ::getRangeParallel( results, cx, getReadVersion(), keys, parallelism, ordered, conflictRange, info, options.readTags );
+}
+
+// Cache servers do not compute aggregates, so a cached shard is read and aggregated here
+ACTOR Future<RangeAggregate> aggregateExactRange( Database cx, Version version, KeyRange keys, TransactionInfo info, TagSet tags ) {
+	state RangeAggregate result;
+	state KeyRange remaining = keys;
+	loop {
+		Standalone<RangeResultRef> page = wait( getExactRange( cx, version, remaining, GetRangeLimits( GetRangeLimits::ROW_LIMIT_UNLIMITED, CLIENT_KNOBS->REPLY_BYTE_LIMIT ), false, info, tags ) );
+		for( const auto& kv : page ) {
+			result.add( kv );
+		}
+		if( !page.more ) {
+			return result;
+		}
+		remaining = KeyRangeRef( keyAfter( page.back().key ), keys.end );
+	}
+}
+
+ACTOR Future<RangeAggregate> getRangeAggregate( Database cx, Future<Version> fVersion, KeyRange keys, TransactionInfo info, TagSet tags ) {
+	state Span span("NAPI:getRangeAggregate"_loc, info.spanID);
+	state Version version = wait( fVersion );
+	cx->validateVersion(version);
+
+	state RangeAggregate result;
+	state Key begin = keys.begin;
+	// Up to RANGE_AGGREGATE_SHARD_LIMIT shards are aggregated at once, and each reply is for the part of one shard
+	loop {
+		state KeyRange remaining = KeyRangeRef( begin, keys.end );
+		state vector<pair<KeyRange, Reference<LocationInfo>>> locations = wait( getKeyRangeLocations( cx, remaining, CLIENT_KNOBS->RANGE_AGGREGATE_SHARD_LIMIT, false, &StorageServerInterface::getRangeAggregate, info ) );
+		try {
+			state vector<Future<RangeAggregate>> parts;
+			for( const auto& location : locations ) {
+				KeyRange part = location.first & remaining;
+				if( location.second->hasCaches ) {
+					TEST(true); // getRangeAggregate of a cached range
+					parts.push_back( aggregateExactRange( cx, version, part, info, tags ) );
+				} else {
+					parts.push_back( fmap( [](GetRangeAggregateReply const& r) { return r.aggregate; },
+					                       loadBalance( cx.getPtr(), location.second, &StorageServerInterface::getRangeAggregate,
+					                                    GetRangeAggregateRequest( span.context, part, version, cx->sampleReadTags() ? tags : Optional<TagSet>(), info.debugID ),
+					                                    TaskPriority::DefaultPromiseEndpoint, false, cx->enableLocalityLoadBalance ? &cx->queueModel : nullptr ) ) );
+				}
+			}
+			wait( waitForAll( parts ) );
+
+			for( const auto& part : parts ) {
+				result.append( part.get() );
+			}
+			if( locations.back().first.end >= keys.end ) {
+				return result;
+			}
+			begin = locations.back().first.end;
+		} catch( Error& e ) {
+			if( e.code() == error_code_wrong_shard_server || e.code() == error_code_all_alternatives_failed ||
+			    ( e.code() == error_code_transaction_too_old && version == latestVersion ) ) {
+				cx->invalidateCache( remaining );
+				wait( delay( CLIENT_KNOBS->WRONG_SHARD_SERVER_DELAY, info.taskID ) );
+			} else {
+				throw;
+			}
+		}
+	}
+}
+
+Future<RangeAggregate> Transaction::getRangeAggregate( const KeyRange& keys, bool snapshot ) {
+	++cx->transactionLogicalReads;
+	++cx->transactionGetRangeAggregateRequests;
+
+	if( keys.empty() )
+		return RangeAggregate();
+
+	if( !snapshot ) {
+		addReadConflictRange( keys );
+	}
+
+	return ::getRangeAggregate( cx, getReadVersion(), keys, info, options.readTags );
+}
+
+// Reads the rows of keys that match filter, one shard at a time.  Storage servers apply the filter, so the rows
+// it rejects are not sent; cache servers do not, so a cached shard is read in full and filtered here.
+ACTOR Future<Standalone<RangeResultRef>> getRangeFiltered( Database cx, Future<Version> fVersion, KeyRange keys,
+	RangeReadFilter filter, GetRangeLimits limits, bool reverse, Promise<std::pair<Key, Key>> conflictRange,
+	TransactionInfo info, TagSet tags )
+{
+	state Span span("NAPI:getRangeFiltered"_loc, info.spanID);
+	state Standalone<RangeResultRef> output;
+	state KeyRange remaining = keys; // The part of keys that has not been read
+
+	try {
+		state Version version = wait( fVersion );
+		cx->validateVersion(version);
+
+		loop {
+			if( remaining.empty() || limits.isReached() || ( limits.hasSatisfiedMinRows() && output.size() > 0 ) ) {
+				break;
+			}
+
+			state pair<KeyRange, Reference<LocationInfo>> location = wait( getKeyLocation( cx, reverse ? remaining.end : remaining.begin, &StorageServerInterface::getKeyValues, info, reverse ) );
+			state KeyRange range = location.first & remaining;
+			state bool pushdown = !location.second->hasCaches;
+
+			GetKeyValuesRequest req;
+			req.version = version;
+			req.begin = firstGreaterOrEqual( range.begin );
+			req.end = firstGreaterOrEqual( range.end );
+			req.spanContext = span.context;
+			transformRangeLimits(limits, reverse, req);
+			req.tags = cx->sampleReadTags() ? tags : Optional<TagSet>();
+			req.debugID = info.debugID;
+			if( pushdown ) {
+				req.filter = RangeReadFilterRef( req.arena, filter );
+			} else {
+				TEST(true); // getRangeFiltered of a cached range
+			}
+
+			try {
+				++cx->transactionPhysicalReads;
+				state GetKeyValuesReply rep;
+				try {
+					choose {
+						when(wait(cx->connectionFileChanged())) { throw transaction_too_old(); }
+						when(GetKeyValuesReply _rep = wait(
+								 loadBalance(cx.getPtr(), location.second, &StorageServerInterface::getKeyValues,
+											 req, TaskPriority::DefaultPromiseEndpoint, false,
+											 cx->enableLocalityLoadBalance ? &cx->queueModel : nullptr))) {
+							rep = _rep;
+						}
+					}
+					++cx->transactionPhysicalReadsCompleted;
+				} catch(Error&) {
+					++cx->transactionPhysicalReadsCompleted;
+					throw;
+				}
+
+				int fromRow = output.size();
+				if( pushdown ) {
+					output.arena().dependsOn( rep.arena );
+					output.append( output.arena(), rep.data.begin(), rep.data.size() );
+				} else {
+					for( const auto& kv : rep.data ) {
+						if( filter.matches( kv ) ) {
+							output.push_back_deep( output.arena(), KeyValueRef( kv.key, filter.project( kv.value ) ) );
+						}
+					}
+				}
+				limits.decrement( VectorRef<KeyValueRef>( output.begin() + fromRow, output.size() - fromRow ) );
+
+				// Where the next read of this shard starts
+				Key readTo;
+				if( !rep.more ) {
+					readTo = reverse ? range.begin : range.end;
+				} else if( rep.readThrough.present() ) {
+					TEST(true); // getRangeFiltered continues from where the storage server stopped scanning
+					readTo = Key( rep.readThrough.get(), rep.arena );
+				} else {
+					ASSERT( rep.data.size() );
+					readTo = reverse ? Key( rep.data.back().key, rep.arena ) : keyAfter( rep.data.back().key );
+				}
+				remaining = reverse ? KeyRangeRef( remaining.begin, std::max<KeyRef>( readTo, remaining.begin ) )
+				                    : KeyRangeRef( std::min<KeyRef>( readTo, remaining.end ), remaining.end );
+			} catch( Error& e ) {
+				if( e.code() == error_code_wrong_shard_server || e.code() == error_code_all_alternatives_failed ) {
+					cx->invalidateCache( range );
+					wait( delay( CLIENT_KNOBS->WRONG_SHARD_SERVER_DELAY, info.taskID ) );
+				} else {
+					throw;
+				}
+			}
+		}
+
+		output.more = !remaining.empty();
+		if( output.more ) {
+			output.readThrough = KeyRef( output.arena(), reverse ? remaining.end : remaining.begin );
+		}
+		conflictRange.send( reverse ? std::pair<Key, Key>( remaining.end, keys.end ) : std::pair<Key, Key>( keys.begin, remaining.begin ) );
+		return output;
+	} catch( Error& e ) {
+		// The transaction can still commit after this read fails, so it needs the range read so far
+		if( conflictRange.canBeSet() ) {
+			conflictRange.send( reverse ? std::pair<Key, Key>( remaining.end, keys.end ) : std::pair<Key, Key>( keys.begin, remaining.begin ) );
+		}
+		throw;
+	}
+}
+
+Future<Standalone<RangeResultRef>> Transaction::getRangeFiltered( const KeyRange& keys, const RangeReadFilter& filter,
+	GetRangeLimits limits, bool snapshot, bool reverse )
+{
+	++cx->transactionLogicalReads;
+	++cx->transactionGetRangeFilteredRequests;
+
+	if( !limits.isValid() )
+		return range_limits_invalid();
+	if( !filter.isValid() )
+		return client_invalid_operation();
+	if( keys.empty() || limits.isReached() )
+		return Standalone<RangeResultRef>();
+
+	Promise<std::pair<Key, Key>> conflictRange;
+	if( !snapshot ) {
+		extraConflictRanges.push_back( conflictRange.getFuture() );
+	}
+
+	return ::getRangeFiltered( cx, getReadVersion(), keys, filter, limits, reverse, conflictRange, info, options.readTags );
+}
+
 void Transaction::addReadConflictRange( KeyRangeRef const& keys ) {
 	ASSERT( !keys.empty() );
 
@@ -3159,6 +4103,14 @@ double Transaction::getBackoff(int errCode) {
 		}
 	}
 
+	// Transactions that keep conflicting on the same range would mostly conflict again if they all retried together, so
+	// they are spread out over a window that grows with how often that range has conflicted lately
+	if (errCode == error_code_not_committed && conflictHotness > 1) {
+		TEST(true); // Backing off from a conflict hotspot
+		returnedBackoff =
+		    std::max(returnedBackoff, std::min(CLIENT_KNOBS->CONFLICT_HOTSPOT_BACKOFF * conflictHotness, options.maxBackoff));
+	}
+
 	returnedBackoff *= deterministicRandom()->random01();
 
 	// Set backoff for next time
@@ -3182,6 +4134,7 @@ TransactionOptions::TransactionOptions(Database const& cx) {
 void TransactionOptions::clear() {
 	maxBackoff = CLIENT_KNOBS->DEFAULT_MAX_BACKOFF;
 	getReadVersionFlags = 0;
+	readVersionLease = 0;
 	sizeLimit = CLIENT_KNOBS->TRANSACTION_SIZE_LIMIT;
 	maxTransactionLoggingFieldLength = 0;
 	checkWritesEnabled = false;
@@ -3216,6 +4169,7 @@ void Transaction::reset() {
 	readVersion = Future<Version>();
 	metadataVersion = Promise<Optional<Key>>();
 	extraConflictRanges.clear();
+	conflictHotness = 0;
 	versionstampPromise = Promise<Standalone<StringRef>>();
 	commitResult = Promise<Void>();
 	committing = Future<Void>();
@@ -3529,6 +4483,7 @@ ACTOR static Future<Void> tryCommit( Database cx, Reference<TransactionLogInfo>
 						cx->mvCacheInsertLocation = (cx->mvCacheInsertLocation + 1)%cx->metadataVersionCache.size();
 						cx->metadataVersionCache[cx->mvCacheInsertLocation] = std::make_pair(v, ci.metadataVersion);
 					}
+					cx->latestCommitVersion = std::max(cx->latestCommitVersion, v);
 
 					Standalone<StringRef> ret = makeString(10);
 					placeVersionstamp(mutateString(ret), v, ci.txnBatchId);
@@ -3545,8 +4500,10 @@ ACTOR static Future<Void> tryCommit( Database cx, Reference<TransactionLogInfo>
 					double latency = now() - startTime;
 					cx->commitLatencies.addSample(latency);
 					cx->latencies.addSample(now() - tr->startTime);
-					if (trLogInfo)
+					if (trLogInfo) {
 						trLogInfo->addLog(FdbClientLogEvents::EventCommit_V2(startTime, cx->clientLocality.dcId(), latency, req.transaction.mutations.size(), req.transaction.mutations.expectedSize(), ci.version, req));
+						cx->profileCommitLatency->sampleSeconds(latency);
+					}
 					return Void();
 				} else {
 					// clear the RYW transaction which contains previous conflicting keys
@@ -3564,6 +4521,12 @@ ACTOR static Future<Void> tryCommit( Database cx, Reference<TransactionLogInfo>
 							const KeyRange krWithPrefix = KeyRangeRef(kr.begin.withPrefix(conflictingKeysRange.begin),
 							                                          kr.end.withPrefix(conflictingKeysRange.begin));
 							tr->info.conflictingKeys->insert(krWithPrefix, conflictingKeysTrue);
+							cx->conflictHotspots.addConflicts(kr, now());
+						}
+						for (auto const& rCRIndex : mergedIds) {
+							tr->conflictHotness =
+							    std::max(tr->conflictHotness,
+							             cx->conflictHotspots.conflicts(req.transaction.read_conflict_ranges[rCRIndex], now()));
 						}
 					}
 
@@ -3755,6 +4718,12 @@ void Transaction::setOption( FDBTransactionOptions::Option option, Optional<Stri
 			options.getReadVersionFlags |= GetReadVersionRequest::FLAG_CAUSAL_READ_RISKY;
 			break;
 
+		case FDBTransactionOptions::READ_VERSION_LEASE:
+			options.readVersionLease =
+			    extractIntOption(value, 0, CLIENT_KNOBS->MAX_READ_VERSION_LEASE * 1000) / 1000.0;
+			options.getReadVersionFlags |= GetReadVersionRequest::FLAG_CAUSAL_READ_RISKY;
+			break;
+
 		case FDBTransactionOptions::PRIORITY_SYSTEM_IMMEDIATE:
 			validateOptionValue(value, false);
 			options.priority = TransactionPriority::IMMEDIATE;
@@ -4054,8 +5023,10 @@ ACTOR Future<Version> extractReadVersion(Location location, SpanID spanContext,
 	GetReadVersionReply rep = wait(f);
 	double latency = now() - startTime;
 	cx->GRVLatencies.addSample(latency);
-	if (trLogInfo)
+	if (trLogInfo) {
 		trLogInfo->addLog(FdbClientLogEvents::EventGetVersion_V3(startTime, cx->clientLocality.dcId(), latency, priority, rep.version));
+		cx->profileGRVLatency->sampleSeconds(latency);
+	}
 	if (rep.version == 1 && rep.locked) {
 		throw proxy_memory_limit_exceeded();
 	}
@@ -4106,10 +5077,31 @@ ACTOR Future<Version> extractReadVersion(Location location, SpanID spanContext,
 		cx->metadataVersionCache[cx->mvCacheInsertLocation] = std::make_pair(rep.version, rep.metadataVersion);
 	}
 
+	if (!rep.locked) {
+		auto& lease = cx->readVersionLeases[priority];
+		if (rep.version > lease.reply.version) {
+			lease.requestTime = startTime;
+			lease.reply = rep;
+		}
+	}
+
 	metadataVersion.send(rep.metadataVersion);
 	return rep.version;
 }
 
+// A read version this client already holds, if it was requested recently enough to satisfy the transaction's lease
+Optional<GetReadVersionReply> leasedReadVersion(DatabaseContext* cx, TransactionOptions const& options) {
+	if (options.readVersionLease <= 0 || options.tags.size() != 0) {
+		return Optional<GetReadVersionReply>();
+	}
+	auto it = cx->readVersionLeases.find(options.priority);
+	if (it == cx->readVersionLeases.end() || now() - it->second.requestTime > options.readVersionLease ||
+	    it->second.reply.version < cx->latestCommitVersion) {
+		return Optional<GetReadVersionReply>();
+	}
+	return it->second.reply;
+}
+
 Future<Version> Transaction::getReadVersion(uint32_t flags) {
 	if (!readVersion.isValid()) {
 		++cx->transactionReadVersions;
@@ -4167,6 +5159,16 @@ Future<Version> Transaction::getReadVersion(uint32_t flags) {
 			}
 		}
 
+		Optional<GetReadVersionReply> lease = leasedReadVersion(cx.getPtr(), options);
+		if (lease.present()) {
+			TEST(true); // Transaction started at a leased read version
+			++cx->transactionReadVersionsLeased;
+			startTime = now();
+			metadataVersion.send(lease.get().metadataVersion);
+			readVersion = lease.get().version;
+			return readVersion;
+		}
+
 		auto& batcher = cx->versionBatcher[ flags ];
 		if (!batcher.actor.isValid()) {
 			batcher.actor = readVersionBatcher( cx.getPtr(), batcher.stream.getFuture(), options.priority, flags );
@@ -4447,6 +5449,127 @@ ACTOR Future<Standalone<VectorRef<ReadHotRangeWithMetrics>>> getReadHotRanges(Da
 	}
 }
 
+// Fails every watch of a shard metrics subscription with all_alternatives_failed, so that waitStorageMetrics looks up
+// the shard again and watches it through a new subscription
+void failShardMetricsSubscription(DatabaseContext::ShardMetricsSubscription* self, Error const& e) {
+	if (self->failed.present()) return;
+	TraceEvent(SevDebug, "ShardMetricsSubscriptionFailed", self->id).error(e).detail("Server", self->server.id());
+	self->failed = e;
+	std::unordered_map<int64_t, Promise<StorageMetrics>> watches;
+	std::swap(watches, self->watches);
+	for (auto& w : watches) {
+		w.second.sendError(all_alternatives_failed());
+	}
+}
+
+// Delivers the watches reported by each reply of a shard metrics subscription
+ACTOR Future<Void> readShardMetricsSubscription(DatabaseContext::ShardMetricsSubscription* self) {
+	state FutureStream<ShardMetricsStreamReply> replies = self->stream.getFuture();
+	try {
+		loop {
+			ShardMetricsStreamReply rep = waitNext(replies);
+			for (auto const& c : rep.crossed) {
+				auto it = self->watches.find(c.id);
+				if (it != self->watches.end()) {
+					Promise<StorageMetrics> p = it->second;
+					self->watches.erase(it);
+					p.send(c.metrics);
+				}
+			}
+			for (auto id : rep.wrongShard) {
+				auto it = self->watches.find(id);
+				if (it != self->watches.end()) {
+					Promise<StorageMetrics> p = it->second;
+					self->watches.erase(it);
+					p.sendError(wrong_shard_server());
+				}
+			}
+		}
+	} catch (Error& e) {
+		if (e.code() == error_code_actor_cancelled) throw;
+		failShardMetricsSubscription(self, e);
+	}
+	return Void();
+}
+
+// Sends the watches started and cancelled within SHARD_METRICS_WATCH_BATCH_DELAY of each other as one request
+ACTOR Future<Void> sendShardMetricsWatches(DatabaseContext::ShardMetricsSubscription* self) {
+	loop {
+		wait(delay(CLIENT_KNOBS->SHARD_METRICS_WATCH_BATCH_DELAY, TaskPriority::DataDistribution));
+		if (self->failed.present() || (self->toWatch.empty() && self->toCancel.empty())) {
+			return Void();
+		}
+		ShardMetricsWatchRequest req;
+		req.subscriptionId = self->id;
+		req.arena.dependsOn(self->toWatch.arena());
+		req.arena.dependsOn(self->toCancel.arena());
+		req.watches = self->toWatch;
+		req.cancelled = self->toCancel;
+		self->toWatch = Standalone<VectorRef<ShardMetricsWatchRef>>();
+		self->toCancel = Standalone<VectorRef<int64_t>>();
+		ErrorOr<Void> rep = wait(self->server.watchShardMetrics.tryGetReply(req, TaskPriority::DataDistribution));
+		if (rep.isError()) {
+			if (rep.getError().code() == error_code_actor_cancelled) throw rep.getError();
+			failShardMetricsSubscription(self, rep.getError());
+			return Void();
+		}
+	}
+}
+
+Reference<DatabaseContext::ShardMetricsSubscription> getShardMetricsSubscription(Database cx,
+                                                                                 StorageServerInterface const& server) {
+	auto& sub = cx->shardMetricsSubscriptions[server.id()];
+	if (!sub || sub->failed.present()) {
+		sub = makeReference<DatabaseContext::ShardMetricsSubscription>();
+		sub->id = deterministicRandom()->randomUniqueID();
+		sub->server = server;
+		sub->stream = server.shardMetricsStream.getReplyStream(ShardMetricsStreamRequest(sub->id));
+		sub->reader = readShardMetricsSubscription(sub.getPtr());
+	}
+	return sub;
+}
+
+// Waits, like a WaitMetricsRequest, for the metrics of keys within one shard to leave [min, max], through the shard
+// metrics subscription of one of the shard's storage servers
+ACTOR Future<StorageMetrics> waitShardMetrics(Database cx, KeyRange keys, Reference<LocationInfo> location,
+                                              StorageMetrics min, StorageMetrics max) {
+	int useIdx = -1;
+	int healthy = 0;
+	for (int i = 0; i < location->size(); i++) {
+		if (!IFailureMonitor::failureMonitor()
+		         .getState(location->get(i, &StorageServerInterface::shardMetricsStream).getEndpoint())
+		         .failed &&
+		    deterministicRandom()->random01() <= 1.0 / ++healthy) {
+			useIdx = i;
+		}
+	}
+	if (useIdx < 0) {
+		throw all_alternatives_failed();
+	}
+
+	state Reference<DatabaseContext::ShardMetricsSubscription> sub =
+	    getShardMetricsSubscription(cx, location->getInterface(useIdx));
+	state int64_t id = sub->nextWatchId++;
+	state Future<StorageMetrics> crossed = sub->watches[id].getFuture();
+	sub->toWatch.push_back_deep(sub->toWatch.arena(), ShardMetricsWatchRef(id, keys, min, max));
+	if (!sub->sender.isValid() || sub->sender.isReady()) {
+		sub->sender = sendShardMetricsWatches(sub.getPtr());
+	}
+
+	try {
+		StorageMetrics m = wait(crossed);
+		return m;
+	} catch (Error& e) {
+		if (e.code() == error_code_actor_cancelled && !sub->failed.present() && sub->watches.erase(id)) {
+			sub->toCancel.push_back(sub->toCancel.arena(), id);
+			if (!sub->sender.isValid() || sub->sender.isReady()) {
+				sub->sender = sendShardMetricsWatches(sub.getPtr());
+			}
+		}
+		throw;
+	}
+}
+
 ACTOR Future< std::pair<Optional<StorageMetrics>, int> > waitStorageMetrics(
 	Database cx,
 	KeyRange keys,
@@ -4471,6 +5594,8 @@ ACTOR Future< std::pair<Optional<StorageMetrics>, int> > waitStorageMetrics(
 				Future<StorageMetrics> fx;
 				if (locations.size() > 1) {
 					fx = waitStorageMetricsMultipleLocations(locations, min, max, permittedError);
+				} else if (CLIENT_KNOBS->SHARD_METRICS_STREAM) {
+					fx = waitShardMetrics(cx, keys, locations[0].second, min, max);
 				} else {
 					WaitMetricsRequest req( keys, min, max );
 					fx = loadBalance(locations[0].second->locations(), &StorageServerInterface::waitMetrics, req,
@@ -4536,6 +5661,101 @@ ACTOR Future<Standalone<VectorRef<DDMetricsRef>>> waitDataDistributionMetricsLis
 	}
 }
 
+// Each commit proxy sees a share of the commits, so the conflicts the proxies report on a range are summed
+ACTOR Future<Standalone<VectorRef<ConflictHotspotRef>>> getConflictHotspots(Database cx, int limit) {
+	loop {
+		state std::vector<Future<GetConflictHotspotsReply>> replies;
+		for (auto const& proxy : cx->clientInfo->get().commitProxies) {
+			replies.push_back(proxy.getConflictHotspots.getReply(GetConflictHotspotsRequest(limit)));
+		}
+		choose {
+			when(wait(cx->onProxiesChanged())) {}
+			when(wait(replies.empty() ? Never() : waitForAll(replies))) {
+				ConflictHotspots merged(CLIENT_KNOBS->CONFLICT_HOTSPOT_HALF_LIFE, std::numeric_limits<int>::max());
+				for (auto const& reply : replies) {
+					for (auto const& hotspot : reply.get().hotspots) {
+						merged.addConflicts(hotspot.range, now(), hotspot.conflicts);
+					}
+				}
+				Standalone<VectorRef<ConflictHotspotRef>> result;
+				for (auto const& hotspot : merged.hottest(limit, now())) {
+					result.push_back_deep(result.arena(), ConflictHotspotRef(hotspot.first, hotspot.second));
+				}
+				return result;
+			}
+		}
+	}
+}
+
+// Every replica of a shard sees its writes, but only a share of its reads, so read rates are summed across replicas
+// and write rates are taken from whichever replica saw the most
+ACTOR Future<GetHotKeysReply> getHotKeys(Database cx, KeyRange keys, int limit) {
+	state Span span("NAPI:GetHotKeys"_loc);
+	loop {
+		state vector<pair<KeyRange, Reference<LocationInfo>>> locations =
+		    wait(getKeyRangeLocations(cx, keys, CLIENT_KNOBS->STORAGE_METRICS_SHARD_LIMIT, false,
+		                              &StorageServerInterface::getHotKeys,
+		                              TransactionInfo(TaskPriority::DataDistribution, span.context)));
+		try {
+			state vector<Future<ErrorOr<GetHotKeysReply>>> fReplies;
+			for (int i = 0; i < locations.size(); i++) {
+				KeyRangeRef part = locations[i].first & keys;
+				for (int j = 0; j < locations[i].second->size(); j++) {
+					auto const& stream = locations[i].second->get(j, &StorageServerInterface::getHotKeys);
+					if (!IFailureMonitor::failureMonitor().getState(stream.getEndpoint()).failed) {
+						fReplies.push_back(errorOr(stream.getReply(GetHotKeysRequest(part, limit),
+						                                           TaskPriority::DataDistribution)));
+					}
+				}
+			}
+			wait(waitForAll(fReplies));
+
+			std::map<KeyRef, HotKeyRef> readKeys, writeKeys;
+			for (auto const& reply : fReplies) {
+				if (reply.get().isError()) {
+					if (reply.get().getError().code() == error_code_wrong_shard_server) {
+						throw reply.get().getError();
+					}
+					continue; // A replica that can't answer just leaves its reads out of the estimate
+				}
+				for (auto const& k : reply.get().get().readKeys) {
+					auto& merged = readKeys.emplace(k.key, HotKeyRef(k.key, 0, 0)).first->second;
+					merged.hz += k.hz;
+					merged.errorHz += k.errorHz;
+				}
+				for (auto const& k : reply.get().get().writeKeys) {
+					auto& merged = writeKeys.emplace(k.key, HotKeyRef(k.key, 0, 0)).first->second;
+					if (k.hz > merged.hz) {
+						merged = k;
+					}
+				}
+			}
+
+			GetHotKeysReply result;
+			auto hottest = [&](std::map<KeyRef, HotKeyRef> const& merged, VectorRef<HotKeyRef>& out) {
+				std::vector<HotKeyRef> sorted;
+				for (auto const& it : merged) {
+					sorted.push_back(it.second);
+				}
+				std::sort(sorted.begin(), sorted.end(),
+				          [](HotKeyRef const& a, HotKeyRef const& b) { return a.hz > b.hz; });
+				for (int i = 0; i < sorted.size() && i < limit; i++) {
+					out.push_back_deep(result.arena, sorted[i]);
+				}
+			};
+			hottest(readKeys, result.readKeys);
+			hottest(writeKeys, result.writeKeys);
+			return result;
+		} catch (Error& e) {
+			if (e.code() != error_code_wrong_shard_server) {
+				throw;
+			}
+			cx->invalidateCache(keys);
+			wait(delay(CLIENT_KNOBS->WRONG_SHARD_SERVER_DELAY, TaskPriority::DataDistribution));
+		}
+	}
+}
+
 Future<Standalone<VectorRef<ReadHotRangeWithMetrics>>> Transaction::getReadHotRanges(KeyRange const& keys) {
 	return ::getReadHotRanges(cx, keys);
 }
@@ -4660,7 +5880,8 @@ void Transaction::checkDeferredError() { cx->checkDeferredError(); }
 Reference<TransactionLogInfo> Transaction::createTrLogInfoProbabilistically(const Database &cx) {
 	if(!cx->isError()) {
 		double clientSamplingProbability = std::isinf(cx->clientInfo->get().clientTxnInfoSampleRate) ? CLIENT_KNOBS->CSI_SAMPLING_PROBABILITY : cx->clientInfo->get().clientTxnInfoSampleRate;
-		if (((networkOptions.logClientInfo.present() && networkOptions.logClientInfo.get()) || BUGGIFY) && deterministicRandom()->random01() < clientSamplingProbability && (!g_network->isSimulated() || !g_simulator.speedUpSimulation)) {
+		bool logClientInfo = (networkOptions.logClientInfo.present() && networkOptions.logClientInfo.get()) || CLIENT_KNOBS->CSI_PROFILE_SINK.size();
+		if ((logClientInfo || BUGGIFY) && deterministicRandom()->random01() < clientSamplingProbability && (!g_network->isSimulated() || !g_simulator.speedUpSimulation)) {
 			return makeReference<TransactionLogInfo>(TransactionLogInfo::DATABASE);
 		}
 	}
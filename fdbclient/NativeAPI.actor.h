@@ -122,6 +122,7 @@ struct StorageMetrics;
 struct TransactionOptions {
 	double maxBackoff;
 	uint32_t getReadVersionFlags;
+	double readVersionLease; // The staleness of a read version lease this transaction accepts, in seconds
 	uint32_t sizeLimit;
 	int maxTransactionLoggingFieldLength;
 	bool checkWritesEnabled : 1;
@@ -253,6 +254,27 @@ public:
 		                KeySelector(firstGreaterOrEqual(keys.end), keys.arena()), limits, snapshot, reverse);
 	}
 
+	// Sends the keys to results a page at a time, streamed from the storage servers rather than requested page by page,
+	// and then ends results with end_of_stream (or the error that stopped the read).
+	[[nodiscard]] Future<Void> getRangeStream(const PromiseStream<Standalone<RangeResultRef>>& results, const KeyRange& keys,
+	                                          GetRangeLimits limits, bool snapshot = false);
+
+	// Sends all of keys to results, reading up to parallelism shards at once from their storage servers, and then ends
+	// results like getRangeStream. Pages are sent in key order if ordered, and otherwise as soon as they arrive.
+	[[nodiscard]] Future<Void> getRangeParallel(const PromiseStream<Standalone<RangeResultRef>>& results,
+	                                            const KeyRange& keys, int parallelism, bool ordered,
+	                                            bool snapshot = false);
+
+	// The aggregates of the range, computed by the storage servers so that the keys and values are not sent
+	[[nodiscard]] Future<RangeAggregate> getRangeAggregate(const KeyRange& keys, bool snapshot = false);
+
+	// The rows of keys that match filter, which the storage servers select so that the others are not sent. The limits
+	// apply to the matching rows. A result with more set may stop short of the limits; its readThrough says where to
+	// continue. Not supported by ReadYourWritesTransaction, whose read cache only holds whole rows.
+	[[nodiscard]] Future<Standalone<RangeResultRef>> getRangeFiltered(const KeyRange& keys, const RangeReadFilter& filter,
+	                                                                  GetRangeLimits limits, bool snapshot = false,
+	                                                                  bool reverse = false);
+
 	[[nodiscard]] Future<Standalone<VectorRef<const char*>>> getAddressesForKey(const Key& key);
 
 	void enableCheckWrites();
@@ -307,6 +329,9 @@ public:
 
 	TransactionInfo info;
 	int numErrors;
+	// The recent conflicts on the hottest range that the last commit conflicted on, if the transaction reports its
+	// conflicting keys
+	double conflictHotness = 0;
 
 	std::vector<Reference<Watch>> watches;
 
@@ -351,6 +376,15 @@ private:
 ACTOR Future<Version> waitForCommittedVersion(Database cx, Version version, SpanID spanContext);
 ACTOR Future<Standalone<VectorRef<DDMetricsRef>>> waitDataDistributionMetricsList(Database cx, KeyRange keys,
                                                                                int shardLimit);
+// The up to limit hottest read and written keys in keys, as sampled by the storage servers
+ACTOR Future<GetHotKeysReply> getHotKeys(Database cx, KeyRange keys, int limit);
+// The up to limit ranges that the commit proxies have seen the most conflicts on, the hottest first
+ACTOR Future<Standalone<VectorRef<ConflictHotspotRef>>> getConflictHotspots(Database cx, int limit);
+// Sends the mutations committed to range at versions in [begin, end) to results in version order, and then
+// end_of_stream.  The storage servers only keep the mutations of recent versions, so a feed that starts or falls too
+// far behind ends with transaction_too_old and the range has to be read again at a new version.
+ACTOR Future<Void> getChangeFeedStream(Database cx, PromiseStream<Standalone<VectorRef<MutationsAndVersionRef>>> results,
+                                       KeyRange range, Version begin, Version end);
 
 std::string unprintable( const std::string& );
 
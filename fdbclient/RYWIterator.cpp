@@ -409,6 +409,35 @@ TEST_CASE("/fdbclient/WriteMap/clear") {
 	return Void();
 }
 
+TEST_CASE("/fdbclient/WriteMap/pendingSets") {
+	Arena arena = Arena();
+	WriteMap writes = WriteMap(&arena);
+
+	writes.mutate(LiteralStringRef("b"), MutationRef::SetValue, LiteralStringRef("1"), false);
+	writes.mutate(LiteralStringRef("a"), MutationRef::SetValue, LiteralStringRef("2"), true);
+	writes.mutate(LiteralStringRef("b"), MutationRef::SetValue, LiteralStringRef("3"), false);
+	ASSERT(writes.onlyPendingSets());
+
+	auto const& sets = writes.sortedPendingSets();
+	ASSERT(sets.size() == 3);
+	ASSERT(sets[0].key == LiteralStringRef("a") && sets[0].addConflict);
+	ASSERT(sets[1].key == LiteralStringRef("b") && sets[1].value == LiteralStringRef("1"));
+	ASSERT(sets[2].key == LiteralStringRef("b") && sets[2].value == LiteralStringRef("3"));
+
+	// Looking at the tree merges the pending sets into it
+	ASSERT(getWriteMapCount(&writes) == 5);
+	ASSERT(!writes.onlyPendingSets());
+
+	WriteMap::iterator it(&writes);
+	it.skip(LiteralStringRef("a"));
+	ASSERT(it.is_operation() && it.is_conflict_range() && it.op().top().value.get() == LiteralStringRef("2"));
+	it.skip(LiteralStringRef("b"));
+	ASSERT(it.is_operation() && !it.is_conflict_range() && it.op().size() == 1);
+	ASSERT(it.op().top().value.get() == LiteralStringRef("3"));
+
+	return Void();
+}
+
 TEST_CASE("/fdbclient/WriteMap/setVersionstampedKey") {
 	Arena arena = Arena();
 	WriteMap writes = WriteMap(&arena);
@@ -75,6 +75,8 @@ public:
 	Future<Version> getReadVersion();
 	Optional<Version> getCachedReadVersion() { return tr.getCachedReadVersion(); }
 	Future< Optional<Value> > get( const Key& key, bool snapshot = false );
+	Future< Standalone<RangeResultRef> > getMulti( const Standalone<VectorRef<KeyRef>>& keys, bool snapshot = false );
+	Future< Standalone<VectorRef<RangeResultRef>> > getBatch( const Standalone<VectorRef<KeyRef>>& keys, const Standalone<VectorRef<KeyRangeRef>>& ranges, const std::vector<int>& rangeLimits, bool snapshot = false );
 	Future< Key > getKey( const KeySelector& key, bool snapshot = false );
 	Future< Standalone<RangeResultRef> > getRange( const KeySelector& begin, const KeySelector& end, int limit, bool snapshot = false, bool reverse = false );
 	Future< Standalone<RangeResultRef> > getRange( KeySelector begin, KeySelector end, GetRangeLimits limits, bool snapshot = false, bool reverse = false );
@@ -90,6 +92,7 @@ public:
 	[[nodiscard]] Future<Standalone<VectorRef<const char*>>> getAddressesForKey(const Key& key);
 	Future<Standalone<VectorRef<KeyRef>>> getRangeSplitPoints(const KeyRange& range, int64_t chunkSize);
 	Future<int64_t> getEstimatedRangeSizeBytes(const KeyRange& keys);
+	Future<RangeAggregate> getRangeAggregate(const KeyRange& keys, bool snapshot = false);
 
 	void addReadConflictRange( KeyRangeRef const& keys );
 	void makeSelfConflicting() { tr.makeSelfConflicting(); }
@@ -113,7 +116,7 @@ public:
 	[[nodiscard]] Future<Void> onError(Error const& e);
 
 	// These are to permit use as state variables in actors:
-	ReadYourWritesTransaction() : cache(&arena), writes(&arena) {}
+	ReadYourWritesTransaction() : cache(&snapshotArena), writes(&arena) {}
 	void operator=(ReadYourWritesTransaction&& r) noexcept;
 	ReadYourWritesTransaction(ReadYourWritesTransaction&& r) noexcept;
 
@@ -165,7 +168,10 @@ private:
 
 	Arena arena;
 	Transaction tr;
+	Arena snapshotArena; // Holds what the snapshot cache has read, so that dropping the cache frees it
 	SnapshotCache cache;
+	int64_t snapshotCacheBytes = 0;
+	bool snapshotCacheDropped = false;
 	WriteMap writes;
 	CoalescedKeyRefRangeMap<bool> readConflicts;
 	Map<Key, std::vector<Reference<Watch>>> watchMap;                      // Keys that are being watched in this transaction
@@ -190,6 +196,17 @@ private:
 	KeyRangeMap<std::pair<bool, Optional<Value>>> specialKeySpaceWriteMap;
 	Optional<std::string> specialKeySpaceErrorMsg;
 
+	// The batch of a streaming range read that follows the last one returned, read before the application asks for it.
+	// Any write forgets it, since it could change what the batch holds.
+	struct RangePrefetch {
+		KeySelector begin, end;
+		GetRangeLimits limits;
+		bool snapshot;
+		bool reverse;
+		Future<Standalone<RangeResultRef>> result;
+	};
+	Optional<RangePrefetch> rangePrefetch;
+
 	void resetTimeout();
 	void updateConflictMap( KeyRef const& key, WriteMap::iterator& it ); // pre: it.segmentContains(key)
 	void updateConflictMap( KeyRangeRef const& keys, WriteMap::iterator& it ); // pre: it.segmentContains(keys.begin), keys are already inside this->arena
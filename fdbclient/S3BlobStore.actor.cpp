@@ -38,6 +38,13 @@ json_spirit::mObject S3BlobStoreEndpoint::Stats::getJSON() {
 	o["requests_failed"] = requests_failed;
 	o["requests_successful"] = requests_successful;
 	o["bytes_sent"] = bytes_sent;
+	o["parts_uploaded"] = parts_uploaded;
+	o["part_bytes_sent"] = part_bytes_sent;
+	o["part_upload_seconds"] = part_upload_microseconds / 1e6;
+	o["request_seconds"] = request_microseconds / 1e6;
+	o["connections_created"] = connections_created;
+	o["connections_reused"] = connections_reused;
+	o["connections_discarded"] = connections_discarded;
 
 	return o;
 }
@@ -47,6 +54,13 @@ S3BlobStoreEndpoint::Stats S3BlobStoreEndpoint::Stats::operator-(const Stats& rh
 	r.requests_failed = requests_failed - rhs.requests_failed;
 	r.requests_successful = requests_successful - rhs.requests_successful;
 	r.bytes_sent = bytes_sent - rhs.bytes_sent;
+	r.parts_uploaded = parts_uploaded - rhs.parts_uploaded;
+	r.part_bytes_sent = part_bytes_sent - rhs.part_bytes_sent;
+	r.part_upload_microseconds = part_upload_microseconds - rhs.part_upload_microseconds;
+	r.request_microseconds = request_microseconds - rhs.request_microseconds;
+	r.connections_created = connections_created - rhs.connections_created;
+	r.connections_reused = connections_reused - rhs.connections_reused;
+	r.connections_discarded = connections_discarded - rhs.connections_discarded;
 	return r;
 }
 
@@ -57,6 +71,8 @@ S3BlobStoreEndpoint::BlobKnobs::BlobKnobs() {
 	connect_tries = CLIENT_KNOBS->BLOBSTORE_CONNECT_TRIES;
 	connect_timeout = CLIENT_KNOBS->BLOBSTORE_CONNECT_TIMEOUT;
 	max_connection_life = CLIENT_KNOBS->BLOBSTORE_MAX_CONNECTION_LIFE;
+	max_connection_idle = CLIENT_KNOBS->BLOBSTORE_MAX_CONNECTION_IDLE;
+	max_pooled_connections = CLIENT_KNOBS->BLOBSTORE_MAX_POOLED_CONNECTIONS;
 	request_tries = CLIENT_KNOBS->BLOBSTORE_REQUEST_TRIES;
 	request_timeout_min = CLIENT_KNOBS->BLOBSTORE_REQUEST_TIMEOUT_MIN;
 	requests_per_second = CLIENT_KNOBS->BLOBSTORE_REQUESTS_PER_SECOND;
@@ -67,6 +83,7 @@ S3BlobStoreEndpoint::BlobKnobs::BlobKnobs() {
 	delete_requests_per_second = CLIENT_KNOBS->BLOBSTORE_DELETE_REQUESTS_PER_SECOND;
 	multipart_max_part_size = CLIENT_KNOBS->BLOBSTORE_MULTIPART_MAX_PART_SIZE;
 	multipart_min_part_size = CLIENT_KNOBS->BLOBSTORE_MULTIPART_MIN_PART_SIZE;
+	multipart_target_seconds = CLIENT_KNOBS->BLOBSTORE_MULTIPART_TARGET_SECONDS;
 	concurrent_uploads = CLIENT_KNOBS->BLOBSTORE_CONCURRENT_UPLOADS;
 	concurrent_lists = CLIENT_KNOBS->BLOBSTORE_CONCURRENT_LISTS;
 	concurrent_reads_per_file = CLIENT_KNOBS->BLOBSTORE_CONCURRENT_READS_PER_FILE;
@@ -74,6 +91,7 @@ S3BlobStoreEndpoint::BlobKnobs::BlobKnobs() {
 	read_block_size = CLIENT_KNOBS->BLOBSTORE_READ_BLOCK_SIZE;
 	read_ahead_blocks = CLIENT_KNOBS->BLOBSTORE_READ_AHEAD_BLOCKS;
 	read_cache_blocks_per_file = CLIENT_KNOBS->BLOBSTORE_READ_CACHE_BLOCKS_PER_FILE;
+	read_ahead_max_blocks = CLIENT_KNOBS->BLOBSTORE_READ_AHEAD_MAX_BLOCKS;
 	max_send_bytes_per_second = CLIENT_KNOBS->BLOBSTORE_MAX_SEND_BYTES_PER_SECOND;
 	max_recv_bytes_per_second = CLIENT_KNOBS->BLOBSTORE_MAX_RECV_BYTES_PER_SECOND;
 }
@@ -88,6 +106,8 @@ bool S3BlobStoreEndpoint::BlobKnobs::set(StringRef name, int value) {
 	TRY_PARAM(connect_tries, ct);
 	TRY_PARAM(connect_timeout, cto);
 	TRY_PARAM(max_connection_life, mcl);
+	TRY_PARAM(max_connection_idle, mci);
+	TRY_PARAM(max_pooled_connections, mpc);
 	TRY_PARAM(request_tries, rt);
 	TRY_PARAM(request_timeout_min, rtom);
 	// TODO: For backward compatibility because request_timeout was renamed to request_timeout_min
@@ -103,6 +123,7 @@ bool S3BlobStoreEndpoint::BlobKnobs::set(StringRef name, int value) {
 	TRY_PARAM(concurrent_requests, cr);
 	TRY_PARAM(multipart_max_part_size, maxps);
 	TRY_PARAM(multipart_min_part_size, minps);
+	TRY_PARAM(multipart_target_seconds, mpts);
 	TRY_PARAM(concurrent_uploads, cu);
 	TRY_PARAM(concurrent_lists, cl);
 	TRY_PARAM(concurrent_reads_per_file, crpf);
@@ -110,6 +131,7 @@ bool S3BlobStoreEndpoint::BlobKnobs::set(StringRef name, int value) {
 	TRY_PARAM(read_block_size, rbs);
 	TRY_PARAM(read_ahead_blocks, rab);
 	TRY_PARAM(read_cache_blocks_per_file, rcb);
+	TRY_PARAM(read_ahead_max_blocks, ramb);
 	TRY_PARAM(max_send_bytes_per_second, sbps);
 	TRY_PARAM(max_recv_bytes_per_second, rbps);
 #undef TRY_PARAM
@@ -129,6 +151,8 @@ std::string S3BlobStoreEndpoint::BlobKnobs::getURLParameters() const {
 	_CHECK_PARAM(connect_tries, ct);
 	_CHECK_PARAM(connect_timeout, cto);
 	_CHECK_PARAM(max_connection_life, mcl);
+	_CHECK_PARAM(max_connection_idle, mci);
+	_CHECK_PARAM(max_pooled_connections, mpc);
 	_CHECK_PARAM(request_tries, rt);
 	_CHECK_PARAM(request_timeout_min, rto);
 	_CHECK_PARAM(requests_per_second, rps);
@@ -139,6 +163,7 @@ std::string S3BlobStoreEndpoint::BlobKnobs::getURLParameters() const {
 	_CHECK_PARAM(concurrent_requests, cr);
 	_CHECK_PARAM(multipart_max_part_size, maxps);
 	_CHECK_PARAM(multipart_min_part_size, minps);
+	_CHECK_PARAM(multipart_target_seconds, mpts);
 	_CHECK_PARAM(concurrent_uploads, cu);
 	_CHECK_PARAM(concurrent_lists, cl);
 	_CHECK_PARAM(concurrent_reads_per_file, crpf);
@@ -146,6 +171,7 @@ std::string S3BlobStoreEndpoint::BlobKnobs::getURLParameters() const {
 	_CHECK_PARAM(read_block_size, rbs);
 	_CHECK_PARAM(read_ahead_blocks, rab);
 	_CHECK_PARAM(read_cache_blocks_per_file, rcb);
+	_CHECK_PARAM(read_ahead_max_blocks, ramb);
 	_CHECK_PARAM(max_send_bytes_per_second, sbps);
 	_CHECK_PARAM(max_recv_bytes_per_second, rbps);
 #undef _CHECK_PARAM
@@ -509,19 +535,22 @@ Future<Void> S3BlobStoreEndpoint::updateSecret() {
 }
 
 ACTOR Future<S3BlobStoreEndpoint::ReusableConnection> connect_impl(Reference<S3BlobStoreEndpoint> b) {
-	// First try to get a connection from the pool
+	// First try to get a connection from the pool.  The most recently used connection is the least likely to have
+	// been closed by the server, and taking it first lets the rest of an oversized pool go idle and expire.
 	while (!b->connectionPool.empty()) {
-		S3BlobStoreEndpoint::ReusableConnection rconn = b->connectionPool.front();
-		b->connectionPool.pop();
+		S3BlobStoreEndpoint::ReusableConnection rconn = b->connectionPool.back();
+		b->connectionPool.pop_back();
 
 		// If the connection expires in the future then return it
-		if (rconn.expirationTime > now()) {
+		if (rconn.expirationTime > now() && rconn.idleExpirationTime > now()) {
 			TraceEvent("S3BlobStoreEndpointReusingConnected")
 			    .suppressFor(60)
 			    .detail("RemoteEndpoint", rconn.conn->getPeerAddress())
 			    .detail("ExpiresIn", rconn.expirationTime - now());
+			++b->s_stats.connections_reused;
 			return rconn;
 		}
+		++b->s_stats.connections_discarded;
 	}
 	std::string service = b->service;
 	if (service.empty()) service = b->knobs.secure_connection ? "https" : "http";
@@ -534,9 +563,10 @@ ACTOR Future<S3BlobStoreEndpoint::ReusableConnection> connect_impl(Reference<S3B
 	    .detail("RemoteEndpoint", conn->getPeerAddress())
 	    .detail("ExpiresIn", b->knobs.max_connection_life);
 
+	++b->s_stats.connections_created;
 	if (b->lookupSecret) wait(b->updateSecret());
 
-	return S3BlobStoreEndpoint::ReusableConnection({ conn, now() + b->knobs.max_connection_life });
+	return S3BlobStoreEndpoint::ReusableConnection({ conn, now() + b->knobs.max_connection_life, 0 });
 }
 
 Future<S3BlobStoreEndpoint::ReusableConnection> S3BlobStoreEndpoint::connect() {
@@ -544,8 +574,16 @@ Future<S3BlobStoreEndpoint::ReusableConnection> S3BlobStoreEndpoint::connect() {
 }
 
 void S3BlobStoreEndpoint::returnConnection(ReusableConnection& rconn) {
-	// If it expires in the future then add it to the pool in the front
-	if (rconn.expirationTime > now()) connectionPool.push(rconn);
+	// If it expires in the future then add it to the pool as the most recently used
+	if (rconn.expirationTime > now()) {
+		rconn.idleExpirationTime = now() + knobs.max_connection_idle;
+		connectionPool.push_back(rconn);
+		// Close the least recently used connections beyond the pool limit
+		while (connectionPool.size() > std::max(knobs.max_pooled_connections, 0)) {
+			connectionPool.pop_front();
+			++s_stats.connections_discarded;
+		}
+	}
 	rconn.conn = Reference<IConnection>();
 }
 
@@ -620,11 +658,13 @@ ACTOR Future<Reference<HTTP::Response>> doRequest_impl(Reference<S3BlobStoreEndp
 			bstore->setAuthHeaders(verb, resource, headers);
 			remoteAddress = rconn.conn->getPeerAddress();
 			wait(bstore->requestRate->getAllowance(1));
+			state double requestStart = now();
 			Reference<HTTP::Response> _r =
 			    wait(timeoutError(HTTP::doRequest(rconn.conn, verb, resource, headers, &contentCopy, contentLen,
 			                                      bstore->sendRate, &bstore->s_stats.bytes_sent, bstore->recvRate),
 			                      requestTimeout));
 			r = _r;
+			bstore->s_stats.request_microseconds += (int64_t)((now() - requestStart) * 1e6);
 
 			// Since the response was parsed successfully (which is why we are here) reuse the connection unless we
 			// received the "Connection: close" header.
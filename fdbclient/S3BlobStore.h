@@ -34,7 +34,10 @@
 class S3BlobStoreEndpoint : public ReferenceCounted<S3BlobStoreEndpoint> {
 public:
 	struct Stats {
-		Stats() : requests_successful(0), requests_failed(0), bytes_sent(0) {}
+		Stats()
+		  : requests_successful(0), requests_failed(0), bytes_sent(0), parts_uploaded(0), part_bytes_sent(0),
+		    part_upload_microseconds(0), request_microseconds(0), connections_created(0), connections_reused(0),
+		    connections_discarded(0) {}
 		Stats operator-(const Stats& rhs);
 		void clear() { memset(this, 0, sizeof(*this)); }
 		json_spirit::mObject getJSON();
@@ -42,18 +45,27 @@ public:
 		int64_t requests_successful;
 		int64_t requests_failed;
 		int64_t bytes_sent;
+		int64_t parts_uploaded;
+		int64_t part_bytes_sent;
+		int64_t part_upload_microseconds; // Summed over parts, so part_bytes_sent over this is per connection
+		int64_t request_microseconds; // Summed over request attempts that got a response
+		int64_t connections_created;
+		int64_t connections_reused;
+		int64_t connections_discarded; // Pooled connections closed for their age, idle time, or the pool limit
 	};
 
 	static Stats s_stats;
 
 	struct BlobKnobs {
 		BlobKnobs();
-		int secure_connection, connect_tries, connect_timeout, max_connection_life, request_tries, request_timeout_min,
+		int secure_connection, connect_tries, connect_timeout, max_connection_life, max_connection_idle,
+		    max_pooled_connections, request_tries, request_timeout_min,
 		    requests_per_second, list_requests_per_second, write_requests_per_second, read_requests_per_second,
-		    delete_requests_per_second, multipart_max_part_size, multipart_min_part_size, concurrent_requests,
+		    delete_requests_per_second, multipart_max_part_size, multipart_min_part_size, multipart_target_seconds,
+		    concurrent_requests,
 		    concurrent_uploads, concurrent_lists, concurrent_reads_per_file, concurrent_writes_per_file,
-		    read_block_size, read_ahead_blocks, read_cache_blocks_per_file, max_send_bytes_per_second,
-		    max_recv_bytes_per_second;
+		    read_block_size, read_ahead_blocks, read_cache_blocks_per_file, read_ahead_max_blocks,
+		    max_send_bytes_per_second, max_recv_bytes_per_second;
 		bool set(StringRef name, int value);
 		std::string getURLParameters() const;
 		static std::vector<std::string> getKnobDescriptions() {
@@ -62,6 +74,9 @@ public:
 				"connect_tries (or ct)                 Number of times to try to connect for each request.",
 				"connect_timeout (or cto)              Number of seconds to wait for a connect request to succeed.",
 				"max_connection_life (or mcl)          Maximum number of seconds to use a single TCP connection.",
+				"max_connection_idle (or mci)          Maximum number of seconds a connection may stay idle and still "
+				"be reused; should be below the server's keep-alive timeout.",
+				"max_pooled_connections (or mpc)       Maximum number of idle connections kept for reuse.",
 				"request_tries (or rt)                 Number of times to try each request until a parseable HTTP "
 				"response other than 429 is received.",
 				"request_timeout_min (or rtom)         Number of seconds to wait for a request to succeed after a "
@@ -73,6 +88,8 @@ public:
 				"delete_requests_per_second (or drps)  Max number of delete requests to start per second.",
 				"multipart_max_part_size (or maxps)    Max part size for multipart uploads.",
 				"multipart_min_part_size (or minps)    Min part size for multipart uploads.",
+				"multipart_target_seconds (or mpts)    Seconds each multipart part should take to upload. Part sizes "
+				"between the min and max adapt to the observed upload throughput; 0 always uses the min part size.",
 				"concurrent_requests (or cr)           Max number of total requests in progress at once, regardless of "
 				"operation-specific concurrency limits.",
 				"concurrent_uploads (or cu)            Max concurrent uploads (part or whole) that can be in progress "
@@ -83,6 +100,8 @@ public:
 				"read_block_size (or rbs)              Block size in bytes to be used for reads.",
 				"read_ahead_blocks (or rab)            Number of blocks to read ahead of requested offset.",
 				"read_cache_blocks_per_file (or rcb)   Size of the read cache for a file in blocks.",
+				"read_ahead_max_blocks (or ramb)       Max number of blocks the read ahead of a file may grow to as it "
+				"adapts to the observed read latency and throughput; no more than read_ahead_blocks disables this.",
 				"max_send_bytes_per_second (or sbps)   Max send bytes per second for all requests combined.",
 				"max_recv_bytes_per_second (or rbps)   Max receive bytes per second for all requests combined (NOT YET "
 				"USED)."
@@ -128,8 +147,10 @@ public:
 	struct ReusableConnection {
 		Reference<IConnection> conn;
 		double expirationTime;
+		double idleExpirationTime;
 	};
-	std::queue<ReusableConnection> connectionPool;
+	// Idle connections, the most recently used last
+	std::deque<ReusableConnection> connectionPool;
 	Future<ReusableConnection> connect();
 	void returnConnection(ReusableConnection& conn);
 
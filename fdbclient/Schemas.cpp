@@ -185,6 +185,19 @@ const KeyRef JSONSchemas::statusSchema = LiteralStringRef(R"statusSchema(
                   "commit_latency_bands":{
                      "$map": 1
                   },
+                  "commit_batching":{
+                     "target_p99_latency_seconds":0.0,
+                     "observed_p99_latency_seconds":0.0,
+                     "last_decision":{
+                        "$enum":[
+                           "increase",
+                           "decrease",
+                           "hold"
+                        ]
+                     },
+                     "batch_interval_seconds":0.0,
+                     "batch_bytes":0
+                  },
                   "busiest_read_tag":{
                      "tag": "",
                      "fractional_cost": 0.0,
@@ -198,6 +211,22 @@ const KeyRef JSONSchemas::statusSchema = LiteralStringRef(R"statusSchema(
                      "estimated_cost":{
                         "hz": 0.0
                      }
+                  },
+                  "hot_keys":{
+                     "read":[
+                        {
+                           "key":"",
+                           "hz":0.0,
+                           "error_hz":0.0
+                        }
+                     ],
+                     "write":[
+                        {
+                           "key":"",
+                           "hz":0.0,
+                           "error_hz":0.0
+                        }
+                     ]
                   }
                }
             ],
@@ -324,7 +353,8 @@ const KeyRef JSONSchemas::statusSchema = LiteralStringRef(R"statusSchema(
                   "log_server_min_free_space",
                   "log_server_min_free_space_ratio",
                   "storage_server_durability_lag",
-                  "storage_server_list_fetch_failed"
+                  "storage_server_list_fetch_failed",
+                  "storage_server_compaction_debt"
                ]
             },
             "description":"The database is not being saturated by the workload."
@@ -345,7 +375,8 @@ const KeyRef JSONSchemas::statusSchema = LiteralStringRef(R"statusSchema(
                   "log_server_min_free_space",
                   "log_server_min_free_space_ratio",
                   "storage_server_durability_lag",
-                  "storage_server_list_fetch_failed"
+                  "storage_server_list_fetch_failed",
+                  "storage_server_compaction_debt"
                ]
             },
             "description":"The database is not being saturated by the workload."
@@ -392,6 +423,44 @@ const KeyRef JSONSchemas::statusSchema = LiteralStringRef(R"statusSchema(
          "versions" : 1000000
       },
       "degraded_processes":0,
+      "latency_statistics":{
+         "read":{
+            "count":0,
+            "min":0.0,
+            "max":0.0,
+            "median":0.0,
+            "mean":0.0,
+            "p25":0.0,
+            "p90":0.0,
+            "p95":0.0,
+            "p99":0.0,
+            "p99.9":0.0
+         },
+         "commit":{
+            "count":0,
+            "min":0.0,
+            "max":0.0,
+            "median":0.0,
+            "mean":0.0,
+            "p25":0.0,
+            "p90":0.0,
+            "p95":0.0,
+            "p99":0.0,
+            "p99.9":0.0
+         },
+         "grv":{
+            "count":0,
+            "min":0.0,
+            "max":0.0,
+            "median":0.0,
+            "mean":0.0,
+            "p25":0.0,
+            "p90":0.0,
+            "p95":0.0,
+            "p99":0.0,
+            "p99.9":0.0
+         }
+      },
       "database_available":true,
       "database_lock_state": {
          "locked": true,
@@ -605,6 +605,133 @@ Future<Standalone<RangeResultRef>> DDStatsRangeImpl::getRange(ReadYourWritesTran
 	return ddMetricsGetRangeActor(ryw, kr);
 }
 
+ACTOR Future<Standalone<RangeResultRef>> hotKeysGetRangeActor(ReadYourWritesTransaction* ryw, KeyRangeRef kr) {
+	// The hottest keys are reported per storage shard, so this bounds the answer for ranges spanning many shards
+	state const int limit = 100;
+	state Standalone<RangeResultRef> result;
+	state int op = 0;
+	for (; op < 2; op++) {
+		state Key prefix = (op == 0 ? LiteralStringRef("read/") : LiteralStringRef("write/")).withPrefix(hotKeysRange.begin);
+		state KeyRange opRange = KeyRangeRef(prefix, strinc(prefix)) & kr;
+		if (opRange.empty()) {
+			continue;
+		}
+		KeyRange keys = KeyRangeRef(opRange.begin.removePrefix(prefix),
+		                            opRange.end >= strinc(prefix) ? allKeys.end : opRange.end.removePrefix(prefix)) &
+		                allKeys;
+		GetHotKeysReply reply = wait(getHotKeys(ryw->getDatabase(), keys, limit));
+		std::vector<HotKeyRef> hotKeys(op == 0 ? reply.readKeys.begin() : reply.writeKeys.begin(),
+		                               op == 0 ? reply.readKeys.end() : reply.writeKeys.end());
+		std::sort(hotKeys.begin(), hotKeys.end(), [](HotKeyRef const& a, HotKeyRef const& b) { return a.key < b.key; });
+		for (auto const& hotKey : hotKeys) {
+			json_spirit::mObject statsObj;
+			statsObj["hz"] = hotKey.hz;
+			statsObj["error_hz"] = hotKey.errorHz;
+			std::string statsString =
+			    json_spirit::write_string(json_spirit::mValue(statsObj), json_spirit::Output_options::raw_utf8);
+			result.push_back_deep(result.arena(),
+			                      KeyValueRef(hotKey.key.withPrefix(prefix, result.arena()), ValueRef(statsString)));
+		}
+	}
+	return result;
+}
+
+HotKeysRangeImpl::HotKeysRangeImpl(KeyRangeRef kr) : SpecialKeyRangeAsyncImpl(kr) {}
+
+Future<Standalone<RangeResultRef>> HotKeysRangeImpl::getRange(ReadYourWritesTransaction* ryw, KeyRangeRef kr) const {
+	return hotKeysGetRangeActor(ryw, kr);
+}
+
+ACTOR Future<Standalone<RangeResultRef>> conflictHotspotsGetRangeActor(ReadYourWritesTransaction* ryw,
+                                                                       KeyRangeRef kr) {
+	state const int limit = 100;
+	Standalone<VectorRef<ConflictHotspotRef>> hotspots = wait(getConflictHotspots(ryw->getDatabase(), limit));
+	std::vector<ConflictHotspotRef> sorted(hotspots.begin(), hotspots.end());
+	std::sort(sorted.begin(), sorted.end(),
+	          [](ConflictHotspotRef const& a, ConflictHotspotRef const& b) { return a.range.begin < b.range.begin; });
+	Standalone<RangeResultRef> result;
+	for (auto const& hotspot : sorted) {
+		Key key = hotspot.range.begin.withPrefix(conflictHotspotsRange.begin);
+		if (!kr.contains(key)) {
+			continue;
+		}
+		json_spirit::mObject statsObj;
+		statsObj["end"] = printable(hotspot.range.end);
+		statsObj["conflicts"] = hotspot.conflicts;
+		std::string statsString =
+		    json_spirit::write_string(json_spirit::mValue(statsObj), json_spirit::Output_options::raw_utf8);
+		result.push_back_deep(result.arena(), KeyValueRef(key, ValueRef(statsString)));
+	}
+	return result;
+}
+
+ConflictHotspotsRangeImpl::ConflictHotspotsRangeImpl(KeyRangeRef kr) : SpecialKeyRangeAsyncImpl(kr) {}
+
+Future<Standalone<RangeResultRef>> ConflictHotspotsRangeImpl::getRange(ReadYourWritesTransaction* ryw,
+                                                                      KeyRangeRef kr) const {
+	return conflictHotspotsGetRangeActor(ryw, kr);
+}
+
+ACTOR Future<Standalone<RangeResultRef>> processMetricsGetRangeActor(ReadYourWritesTransaction* ryw, KeyRangeRef kr) {
+	state Standalone<RangeResultRef> result;
+	if (!ryw->getDatabase().getPtr() || !ryw->getDatabase()->getConnectionFile()) {
+		return result;
+	}
+	++ryw->getDatabase()->transactionStatusRequests;
+	StatusObject status = wait(StatusClient::statusFetcher(ryw->getDatabase(), { "processes" }));
+
+	StatusObjectReader statusObj(status);
+	StatusObjectReader processesMap;
+	if (!statusObj.get("cluster.processes", processesMap)) {
+		return result;
+	}
+
+	std::map<Key, std::string> metrics;
+	auto add = [&](std::string const& role,
+	               std::string const& address,
+	               std::string const& id,
+	               json_spirit::mObject const& obj) {
+		Key key = StringRef(role + "/" + address + "/" + id).withPrefix(processMetricsRange.begin);
+		if (kr.contains(key)) {
+			metrics[key] = json_spirit::write_string(json_spirit::mValue(obj), json_spirit::Output_options::raw_utf8);
+		}
+	};
+	for (auto const& [processId, processValue] : processesMap.obj()) {
+		StatusObjectReader process(processValue);
+		std::string address;
+		if (!process.tryGet("address", address)) {
+			continue;
+		}
+		json_spirit::mObject processObj = process.obj();
+		processObj.erase("roles");
+		add("process", address, processId, processObj);
+
+		json_spirit::mArray roles;
+		if (!process.tryGet("roles", roles)) {
+			continue;
+		}
+		for (auto const& roleValue : roles) {
+			StatusObjectReader role(roleValue);
+			std::string roleName, id;
+			if (role.tryGet("role", roleName) && role.tryGet("id", id)) {
+				add(roleName, address, id, role.obj());
+			}
+		}
+	}
+
+	for (auto const& [key, value] : metrics) {
+		result.push_back_deep(result.arena(), KeyValueRef(key, ValueRef(value)));
+	}
+	return result;
+}
+
+ProcessMetricsRangeImpl::ProcessMetricsRangeImpl(KeyRangeRef kr) : SpecialKeyRangeAsyncImpl(kr) {}
+
+Future<Standalone<RangeResultRef>> ProcessMetricsRangeImpl::getRange(ReadYourWritesTransaction* ryw,
+                                                                     KeyRangeRef kr) const {
+	return processMetricsGetRangeActor(ryw, kr);
+}
+
 Key SpecialKeySpace::getManagementApiCommandOptionSpecialKey(const std::string& command, const std::string& option) {
 	Key prefix = LiteralStringRef("options/").withPrefix(moduleToBoundary[MODULE::MANAGEMENT].begin);
 	auto pair = command + "/" + option;
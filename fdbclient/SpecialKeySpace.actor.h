@@ -257,6 +257,32 @@ public:
 	Future<Standalone<RangeResultRef>> getRange(ReadYourWritesTransaction* ryw, KeyRangeRef kr) const override;
 };
 
+// \xff\xff/metrics/hot_keys/read/<key> and \xff\xff/metrics/hot_keys/write/<key>, the hottest keys that storage servers
+// have sampled in the read range
+class HotKeysRangeImpl : public SpecialKeyRangeAsyncImpl {
+public:
+	explicit HotKeysRangeImpl(KeyRangeRef kr);
+	Future<Standalone<RangeResultRef>> getRange(ReadYourWritesTransaction* ryw, KeyRangeRef kr) const override;
+};
+
+// \xff\xff/metrics/conflict_hotspots/<begin>, the ranges that the commit proxies have seen the most recent conflicts on,
+// with the end of each range and its decayed count of conflicts as JSON.  Only transactions that report their
+// conflicting keys are counted.
+class ConflictHotspotsRangeImpl : public SpecialKeyRangeAsyncImpl {
+public:
+	explicit ConflictHotspotsRangeImpl(KeyRangeRef kr);
+	Future<Standalone<RangeResultRef>> getRange(ReadYourWritesTransaction* ryw, KeyRangeRef kr) const override;
+};
+
+// \xff\xff/metrics/processes/<role>/<address>/<role id>, the status of each role of each process as JSON, and
+// \xff\xff/metrics/processes/process/<address>/<process id>, the status of each process without its roles.  They are read
+// from only the processes section of the status the cluster controller caches.
+class ProcessMetricsRangeImpl : public SpecialKeyRangeAsyncImpl {
+public:
+	explicit ProcessMetricsRangeImpl(KeyRangeRef kr);
+	Future<Standalone<RangeResultRef>> getRange(ReadYourWritesTransaction* ryw, KeyRangeRef kr) const override;
+};
+
 class ManagementCommandsOptionsImpl : public SpecialKeyRangeRWImpl {
 public:
 	explicit ManagementCommandsOptionsImpl(KeyRangeRef kr);
@@ -374,8 +374,8 @@ ACTOR Future<StatusObject> clientStatusFetcher(Reference<ClusterConnectionFile>
 }
 
 // Cluster section of json output
-ACTOR Future<Optional<StatusObject>> clusterStatusFetcher(ClusterInterface cI, StatusArray *messages) {
-	state StatusRequest req;
+ACTOR Future<Optional<StatusObject>> clusterStatusFetcher(ClusterInterface cI, StatusArray *messages, std::vector<std::string> sections) {
+	state StatusRequest req(sections);
 	state Future<Void> clusterTimeout = delay(30.0);
 	state Optional<StatusObject> oStatusObj;
 
@@ -467,7 +467,7 @@ StatusObject getClientDatabaseStatus(StatusObjectReader client, StatusObjectRead
 	return databaseStatus;
 }
 
-ACTOR Future<StatusObject> statusFetcherImpl( Reference<ClusterConnectionFile> f, Reference<AsyncVar<Optional<ClusterInterface>>> clusterInterface) {
+ACTOR Future<StatusObject> statusFetcherImpl( Reference<ClusterConnectionFile> f, Reference<AsyncVar<Optional<ClusterInterface>>> clusterInterface, std::vector<std::string> sections) {
 	if (!g_network) throw network_not_setup();
 
 	state StatusObject statusObj;
@@ -506,7 +506,7 @@ ACTOR Future<StatusObject> statusFetcherImpl( Reference<ClusterConnectionFile> f
 
 			loop{
 				if (clusterInterface->get().present()) {
-					Optional<StatusObject> _statusObjCluster = wait(clusterStatusFetcher(clusterInterface->get().get(), &clientMessages));
+					Optional<StatusObject> _statusObjCluster = wait(clusterStatusFetcher(clusterInterface->get().get(), &clientMessages, sections));
 					if (_statusObjCluster.present()){
 						statusObjCluster = _statusObjCluster.get();
 						// TODO: this is a temporary fix, getting the number of available coordinators should move to the server side
@@ -571,12 +571,12 @@ ACTOR Future<Void> timeoutMonitorLeader(Database db) {
 	}
 }
 
-Future<StatusObject> StatusClient::statusFetcher( Database db ) {
+Future<StatusObject> StatusClient::statusFetcher( Database db, std::vector<std::string> const& sections ) {
 	db->lastStatusFetch = now();
 	if(!db->statusClusterInterface) {
 		db->statusClusterInterface = makeReference<AsyncVar<Optional<ClusterInterface>>>();
 		db->statusLeaderMon = timeoutMonitorLeader(db);
 	}
 
-	return statusFetcherImpl(db->getConnectionFile(), db->statusClusterInterface);
+	return statusFetcherImpl(db->getConnectionFile(), db->statusClusterInterface, sections);
 }
@@ -28,7 +28,9 @@
 class StatusClient {
 public:
 	enum StatusLevel { MINIMAL = 0, NORMAL = 1, DETAILED = 2, JSON = 3 };
-	static Future<StatusObject> statusFetcher(Database db);
+	// If sections are given, the cluster section only has those of its fields, so that the cluster controller sends less;
+	// client.database_status is then based on the fields that were fetched.
+	static Future<StatusObject> statusFetcher(Database db, std::vector<std::string> const& sections = {});
 };
 
 #endif
\ No newline at end of file
@@ -23,6 +23,7 @@
 #pragma once
 
 #include "fdbclient/FDBTypes.h"
+#include "fdbclient/CommitTransaction.h"
 #include "fdbrpc/Locality.h"
 #include "fdbrpc/QueueModel.h"
 #include "fdbrpc/fdbrpc.h"
@@ -73,6 +74,27 @@ struct StorageServerInterface {
 	RequestStream<struct WatchValueRequest> watchValue;
 	RequestStream<struct ReadHotSubRangeRequest> getReadHotRanges;
 	RequestStream<struct SplitRangeRequest> getRangeSplitPoints;
+	RequestStream<struct GetValuesRequest> getValues;
+
+	// Like getKeyValues, but streams the whole range back in pages rather than stopping at the byte limit
+	RequestStream<struct GetKeyValuesStreamRequest> getKeyValuesStream;
+
+	// The most frequently read and written keys in a range, as sampled when STORAGE_HOT_KEY_SAMPLING is on
+	RequestStream<struct GetHotKeysRequest> getHotKeys;
+
+	// Streams the committed mutations of a key range from a version, as long as this server still has them in memory
+	RequestStream<struct ChangeFeedStreamRequest> changeFeedStream;
+
+	// Aggregates a range within one shard at a version, reading it in pages rather than sending it
+	RequestStream<struct GetRangeAggregateRequest> getRangeAggregate;
+
+	// Checksums a prefix of a range within one shard at a version, so that replicas can be compared without sending the data
+	RequestStream<struct GetRangeChecksumRequest> getRangeChecksum;
+
+	// A data distributor's subscription to the shard metrics bound crossings of this server, and the shard bounds it
+	// watches through it.  Together they replace one outstanding WaitMetricsRequest per shard.
+	RequestStream<struct ShardMetricsStreamRequest> shardMetricsStream;
+	RequestStream<struct ShardMetricsWatchRequest> watchShardMetrics;
 
 	explicit StorageServerInterface(UID uid) : uniqueID( uid ) {}
 	StorageServerInterface() : uniqueID( deterministicRandom()->randomUniqueID() ) {}
@@ -101,6 +123,20 @@ struct StorageServerInterface {
 				watchValue = RequestStream<struct WatchValueRequest>( getValue.getEndpoint().getAdjustedEndpoint(10) );
 				getReadHotRanges = RequestStream<struct ReadHotSubRangeRequest>( getValue.getEndpoint().getAdjustedEndpoint(11) );
 				getRangeSplitPoints = RequestStream<struct SplitRangeRequest>(getValue.getEndpoint().getAdjustedEndpoint(12));
+				getValues = RequestStream<struct GetValuesRequest>(getValue.getEndpoint().getAdjustedEndpoint(13));
+				getKeyValuesStream =
+				    RequestStream<struct GetKeyValuesStreamRequest>(getValue.getEndpoint().getAdjustedEndpoint(14));
+				getHotKeys = RequestStream<struct GetHotKeysRequest>(getValue.getEndpoint().getAdjustedEndpoint(15));
+				changeFeedStream =
+				    RequestStream<struct ChangeFeedStreamRequest>(getValue.getEndpoint().getAdjustedEndpoint(16));
+				getRangeAggregate =
+				    RequestStream<struct GetRangeAggregateRequest>(getValue.getEndpoint().getAdjustedEndpoint(17));
+				getRangeChecksum =
+				    RequestStream<struct GetRangeChecksumRequest>(getValue.getEndpoint().getAdjustedEndpoint(18));
+				shardMetricsStream =
+				    RequestStream<struct ShardMetricsStreamRequest>(getValue.getEndpoint().getAdjustedEndpoint(19));
+				watchShardMetrics =
+				    RequestStream<struct ShardMetricsWatchRequest>(getValue.getEndpoint().getAdjustedEndpoint(20));
 			}
 		} else {
 			ASSERT(Ar::isDeserializing);
@@ -129,6 +165,14 @@ struct StorageServerInterface {
 		streams.push_back(watchValue.getReceiver());
 		streams.push_back(getReadHotRanges.getReceiver());
 		streams.push_back(getRangeSplitPoints.getReceiver());
+		streams.push_back(getValues.getReceiver(TaskPriority::LoadBalancedEndpoint));
+		streams.push_back(getKeyValuesStream.getReceiver(TaskPriority::LoadBalancedEndpoint));
+		streams.push_back(getHotKeys.getReceiver());
+		streams.push_back(changeFeedStream.getReceiver(TaskPriority::LoadBalancedEndpoint));
+		streams.push_back(getRangeAggregate.getReceiver(TaskPriority::LoadBalancedEndpoint));
+		streams.push_back(getRangeChecksum.getReceiver(TaskPriority::LoadBalancedEndpoint));
+		streams.push_back(shardMetricsStream.getReceiver());
+		streams.push_back(watchShardMetrics.getReceiver());
 		FlowTransport::transport().addEndpoints(streams);
 	}
 };
@@ -190,6 +234,44 @@ struct GetValueRequest : TimedRequest {
 	}
 };
 
+// The values of several keys at one version.  data holds the keys that are present, in the order they were requested.
+struct GetValuesReply : public LoadBalancedReply {
+	constexpr static FileIdentifier file_identifier = 13948281;
+	Arena arena;
+	VectorRef<KeyValueRef, VecSerStrategy::String> data;
+	bool cached;
+
+	GetValuesReply() : cached(false) {}
+
+	template <class Ar>
+	void serialize(Ar& ar) {
+		serializer(ar, LoadBalancedReply::penalty, LoadBalancedReply::error, data, cached, arena);
+	}
+};
+
+// A batch of point reads at one version, all of which must be served by the same storage server.  It fails as a whole
+// with wrong_shard_server if any key is not readable there.
+struct GetValuesRequest : TimedRequest {
+	constexpr static FileIdentifier file_identifier = 4129741;
+	SpanID spanContext;
+	Arena arena;
+	VectorRef<KeyRef> keys;
+	Version version;
+	Optional<TagSet> tags;
+	Optional<UID> debugID;
+	ReplyPromise<GetValuesReply> reply;
+
+	GetValuesRequest() {}
+	GetValuesRequest(SpanID spanContext, Standalone<VectorRef<KeyRef>> const& keys, Version ver, Optional<TagSet> tags,
+	                 Optional<UID> debugID)
+	  : spanContext(spanContext), arena(keys.arena()), keys(keys), version(ver), tags(tags), debugID(debugID) {}
+
+	template <class Ar>
+	void serialize(Ar& ar) {
+		serializer(ar, keys, version, tags, debugID, reply, spanContext, arena);
+	}
+};
+
 struct WatchValueReply {
 	constexpr static FileIdentifier file_identifier = 3;
 
@@ -232,12 +314,15 @@ struct GetKeyValuesReply : public LoadBalancedReply {
 	Version version; // useful when latestVersion was requested
 	bool more;
 	bool cached = false;
+	// Set by a filtered read that stopped scanning before reaching its limits; the next read starts after this key
+	// (before it, when reversed) rather than after the last row returned
+	Optional<KeyRef> readThrough;
 
 	GetKeyValuesReply() : version(invalidVersion), more(false), cached(false) {}
 
 	template <class Ar>
 	void serialize( Ar& ar ) {
-		serializer(ar, LoadBalancedReply::penalty, LoadBalancedReply::error, data, version, more, cached, arena);
+		serializer(ar, LoadBalancedReply::penalty, LoadBalancedReply::error, data, version, more, cached, readThrough, arena);
 	}
 };
 
@@ -251,12 +336,182 @@ struct GetKeyValuesRequest : TimedRequest {
 	bool isFetchKeys;
 	Optional<TagSet> tags;
 	Optional<UID> debugID;
+	// Only rows that match are returned, and limit and limitBytes apply to them
+	Optional<RangeReadFilterRef> filter;
 	ReplyPromise<GetKeyValuesReply> reply;
 
 	GetKeyValuesRequest() : isFetchKeys(false) {}
 	template <class Ar>
 	void serialize( Ar& ar ) {
-		serializer(ar, begin, end, version, limit, limitBytes, isFetchKeys, tags, debugID, reply, spanContext, arena);
+		serializer(ar, begin, end, version, limit, limitBytes, isFetchKeys, tags, debugID, reply, spanContext, filter, arena);
+	}
+};
+
+struct GetKeyValuesStreamReply : public ReplyPromiseStreamReply {
+	constexpr static FileIdentifier file_identifier = 1783067;
+	Arena arena;
+	VectorRef<KeyValueRef, VecSerStrategy::String> data;
+	Version version; // useful when latestVersion was requested
+	bool more; // False on the last page
+	bool cached = false;
+
+	GetKeyValuesStreamReply() : version(invalidVersion), more(false), cached(false) {}
+	GetKeyValuesStreamReply(GetKeyValuesReply r)
+	  : arena(r.arena), data(r.data), version(r.version), more(r.more), cached(r.cached) {}
+
+	int expectedSize() const { return sizeof(GetKeyValuesStreamReply) + data.expectedSize(); }
+
+	template <class Ar>
+	void serialize(Ar& ar) {
+		serializer(ar, acknowledgeToken, data, version, more, cached, arena);
+	}
+};
+
+struct GetKeyValuesStreamRequest : TimedRequest {
+	constexpr static FileIdentifier file_identifier = 6795747;
+	SpanID spanContext;
+	Arena arena;
+	KeySelectorRef begin, end;
+	Version version; // or latestVersion
+	int limit, limitBytes; // For the whole stream, not each page
+	Optional<TagSet> tags;
+	Optional<UID> debugID;
+	ReplyPromiseStream<GetKeyValuesStreamReply> reply;
+
+	GetKeyValuesStreamRequest() {}
+	template <class Ar>
+	void serialize(Ar& ar) {
+		serializer(ar, begin, end, version, limit, limitBytes, tags, debugID, reply, spanContext, arena);
+	}
+};
+
+// The mutations committed at one version
+struct MutationsAndVersionRef {
+	VectorRef<MutationRef> mutations;
+	Version version;
+
+	MutationsAndVersionRef() : version(invalidVersion) {}
+	explicit MutationsAndVersionRef(Version version) : version(version) {}
+	MutationsAndVersionRef(Arena& to, MutationsAndVersionRef const& from)
+	  : mutations(to, from.mutations), version(from.version) {}
+
+	int expectedSize() const { return mutations.expectedSize(); }
+
+	template <class Ar>
+	void serialize(Ar& ar) {
+		serializer(ar, mutations, version);
+	}
+};
+
+struct ChangeFeedStreamReply : public ReplyPromiseStreamReply {
+	constexpr static FileIdentifier file_identifier = 1709178;
+	Arena arena;
+	// Sets and clears of keys in the requested range, in version order.  Atomic operations have been applied, so they
+	// appear as sets of the resulting values, and clears are trimmed to the range.
+	VectorRef<MutationsAndVersionRef> mutations;
+	Version end; // Every mutation in the range at a version before this has been sent
+
+	ChangeFeedStreamReply() : end(invalidVersion) {}
+
+	int expectedSize() const { return sizeof(ChangeFeedStreamReply) + mutations.expectedSize(); }
+
+	template <class Ar>
+	void serialize(Ar& ar) {
+		serializer(ar, acknowledgeToken, mutations, end, arena);
+	}
+};
+
+// Streams the mutations of range committed at versions in [begin, end).  The range must be within one shard of the
+// server.  A server only has the mutations of the versions it keeps in memory, so begin has to be recent; otherwise or
+// if the stream falls that far behind, it ends with transaction_too_old and the range has to be read again.
+struct ChangeFeedStreamRequest : TimedRequest {
+	constexpr static FileIdentifier file_identifier = 6279545;
+	SpanID spanContext;
+	Arena arena;
+	KeyRangeRef range;
+	Version begin, end;
+	ReplyPromiseStream<ChangeFeedStreamReply> reply;
+
+	ChangeFeedStreamRequest() : begin(invalidVersion), end(invalidVersion) {}
+	template <class Ar>
+	void serialize(Ar& ar) {
+		serializer(ar, range, begin, end, reply, spanContext, arena);
+	}
+};
+
+struct GetRangeAggregateReply : public LoadBalancedReply {
+	constexpr static FileIdentifier file_identifier = 9471237;
+	RangeAggregate aggregate;
+	bool cached = false;
+
+	GetRangeAggregateReply() {}
+
+	template <class Ar>
+	void serialize(Ar& ar) {
+		serializer(ar, LoadBalancedReply::penalty, LoadBalancedReply::error, aggregate, cached);
+	}
+};
+
+// The aggregates of range at version.  The range must be within one shard of the server.
+struct GetRangeAggregateRequest : TimedRequest {
+	constexpr static FileIdentifier file_identifier = 9471238;
+	SpanID spanContext;
+	Arena arena;
+	KeyRangeRef range;
+	Version version;
+	Optional<TagSet> tags;
+	Optional<UID> debugID;
+	ReplyPromise<GetRangeAggregateReply> reply;
+
+	GetRangeAggregateRequest() {}
+	GetRangeAggregateRequest(SpanID spanContext, KeyRangeRef range, Version version, Optional<TagSet> tags,
+	                         Optional<UID> debugID)
+	  : spanContext(spanContext), range(arena, range), version(version), tags(tags), debugID(debugID) {}
+
+	template <class Ar>
+	void serialize(Ar& ar) {
+		serializer(ar, range, version, tags, debugID, reply, spanContext, arena);
+	}
+};
+
+struct GetRangeChecksumReply {
+	constexpr static FileIdentifier file_identifier = 9471240;
+	uint32_t checksum = 0;
+	int64_t keys = 0;
+	int64_t bytes = 0;
+	// If more is set, only the range up to readThrough was checksummed
+	bool more = false;
+	Key readThrough;
+
+	GetRangeChecksumReply() {}
+
+	template <class Ar>
+	void serialize(Ar& ar) {
+		serializer(ar, checksum, keys, bytes, more, readThrough);
+	}
+};
+
+// A crc32c of the keys and values of range at version, read in order until at least limitBytes have been read.  The
+// range must be within one shard of the server.  Replicas that hold the same data reply with the same checksum and
+// readThrough, so a caller can compare them and continue from readThrough.
+struct GetRangeChecksumRequest : TimedRequest {
+	constexpr static FileIdentifier file_identifier = 9471241;
+	SpanID spanContext;
+	Arena arena;
+	KeyRangeRef range;
+	Version version;
+	int64_t limitBytes;
+	Optional<UID> debugID;
+	ReplyPromise<GetRangeChecksumReply> reply;
+
+	GetRangeChecksumRequest() : version(invalidVersion), limitBytes(0) {}
+	GetRangeChecksumRequest(SpanID spanContext, KeyRangeRef range, Version version, int64_t limitBytes,
+	                        Optional<UID> debugID)
+	  : spanContext(spanContext), range(arena, range), version(version), limitBytes(limitBytes), debugID(debugID) {}
+
+	template <class Ar>
+	void serialize(Ar& ar) {
+		serializer(ar, range, version, limitBytes, debugID, reply, spanContext, arena);
 	}
 };
 
@@ -408,6 +663,86 @@ struct WaitMetricsRequest {
 	}
 };
 
+// The bounds of one shard watched through a shard metrics subscription.  Like a WaitMetricsRequest, it is reported once
+// any of min or max is exceeded, and is then no longer watched.
+struct ShardMetricsWatchRef {
+	int64_t id; // Chosen by the subscriber, unique within the subscription
+	KeyRangeRef keys;
+	StorageMetrics min, max;
+
+	ShardMetricsWatchRef() : id(0) {}
+	ShardMetricsWatchRef(int64_t id, KeyRangeRef const& keys, StorageMetrics const& min, StorageMetrics const& max)
+	  : id(id), keys(keys), min(min), max(max) {}
+	ShardMetricsWatchRef(Arena& arena, ShardMetricsWatchRef const& rhs)
+	  : id(rhs.id), keys(arena, rhs.keys), min(rhs.min), max(rhs.max) {}
+
+	int expectedSize() const { return keys.expectedSize(); }
+
+	template <class Ar>
+	void serialize(Ar& ar) {
+		serializer(ar, id, keys, min, max);
+	}
+};
+
+struct ShardMetricsCrossing {
+	int64_t id;
+	StorageMetrics metrics;
+
+	ShardMetricsCrossing() : id(0) {}
+	ShardMetricsCrossing(int64_t id, StorageMetrics const& metrics) : id(id), metrics(metrics) {}
+
+	template <class Ar>
+	void serialize(Ar& ar) {
+		serializer(ar, id, metrics);
+	}
+};
+
+struct ShardMetricsStreamReply : public ReplyPromiseStreamReply {
+	constexpr static FileIdentifier file_identifier = 4197412;
+	std::vector<ShardMetricsCrossing> crossed; // Watches whose bounds were exceeded, with the current metrics
+	std::vector<int64_t> wrongShard; // Watches of keys this server no longer (or never did) serve
+
+	int expectedSize() const {
+		return sizeof(ShardMetricsStreamReply) + crossed.size() * sizeof(ShardMetricsCrossing) +
+		       wrongShard.size() * sizeof(int64_t);
+	}
+
+	template <class Ar>
+	void serialize(Ar& ar) {
+		serializer(ar, acknowledgeToken, crossed, wrongShard);
+	}
+};
+
+// Opens a subscription, which lasts until the stream ends.  Each reply batches the watches that fired since the last.
+struct ShardMetricsStreamRequest {
+	constexpr static FileIdentifier file_identifier = 4197413;
+	UID subscriptionId;
+	ReplyPromiseStream<ShardMetricsStreamReply> reply;
+
+	ShardMetricsStreamRequest() {}
+	explicit ShardMetricsStreamRequest(UID subscriptionId) : subscriptionId(subscriptionId) {}
+
+	template <class Ar>
+	void serialize(Ar& ar) {
+		serializer(ar, subscriptionId, reply);
+	}
+};
+
+// Adds and cancels watches of an open subscription.  Fails with operation_obsolete if the subscription is not open.
+struct ShardMetricsWatchRequest {
+	constexpr static FileIdentifier file_identifier = 4197414;
+	Arena arena;
+	UID subscriptionId;
+	VectorRef<ShardMetricsWatchRef> watches;
+	VectorRef<int64_t> cancelled;
+	ReplyPromise<Void> reply;
+
+	template <class Ar>
+	void serialize(Ar& ar) {
+		serializer(ar, subscriptionId, watches, cancelled, reply, arena);
+	}
+};
+
 struct SplitMetricsReply {
 	constexpr static FileIdentifier file_identifier = 11530792;
 	Standalone<VectorRef<KeyRef>> splits;
@@ -511,6 +846,54 @@ struct SplitRangeRequest {
 	}
 };
 
+// A key and its estimated access rate. Estimates come from a space-saving sample, which can overcount a key by at
+// most errorHz but never undercounts it.
+struct HotKeyRef {
+	KeyRef key;
+	double hz;
+	double errorHz;
+
+	HotKeyRef() : hz(0), errorHz(0) {}
+	HotKeyRef(KeyRef key, double hz, double errorHz) : key(key), hz(hz), errorHz(errorHz) {}
+	HotKeyRef(Arena& arena, const HotKeyRef& rhs) : key(arena, rhs.key), hz(rhs.hz), errorHz(rhs.errorHz) {}
+
+	int expectedSize() const { return key.expectedSize(); }
+
+	template <class Ar>
+	void serialize(Ar& ar) {
+		serializer(ar, key, hz, errorHz);
+	}
+};
+
+struct GetHotKeysReply {
+	constexpr static FileIdentifier file_identifier = 14583021;
+	Arena arena;
+	// Each sorted by descending rate
+	VectorRef<HotKeyRef> readKeys;
+	VectorRef<HotKeyRef> writeKeys;
+
+	template <class Ar>
+	void serialize(Ar& ar) {
+		serializer(ar, readKeys, writeKeys, arena);
+	}
+};
+
+struct GetHotKeysRequest {
+	constexpr static FileIdentifier file_identifier = 7352260;
+	Arena arena;
+	KeyRangeRef keys;
+	int limit;
+	ReplyPromise<GetHotKeysReply> reply;
+
+	GetHotKeysRequest() : limit(0) {}
+	GetHotKeysRequest(KeyRangeRef const& keys, int limit) : keys(arena, keys), limit(limit) {}
+
+	template <class Ar>
+	void serialize(Ar& ar) {
+		serializer(ar, keys, limit, reply, arena);
+	}
+};
+
 struct GetStorageMetricsReply {
 	constexpr static FileIdentifier file_identifier = 15491478;
 	StorageMetrics load;
@@ -552,21 +935,46 @@ struct StorageQueuingMetricsReply {
 	Optional<TransactionTag> busiestTag;
 	double busiestTagFractionalBusyness;
 	double busiestTagRate;
+	double slowReadFraction = 0; // Of recent reads, those slower than AUTO_TAG_THROTTLE_SLOW_READ_LATENCY
+	StorageEngineDebt engineDebt;
 
 	template <class Ar>
 	void serialize(Ar& ar) {
-		serializer(ar, localTime, instanceID, bytesDurable, bytesInput, version, storageBytes, durableVersion, cpuUsage, diskUsage, localRateLimit, busiestTag, busiestTagFractionalBusyness, busiestTagRate);
+		serializer(ar, localTime, instanceID, bytesDurable, bytesInput, version, storageBytes, durableVersion, cpuUsage, diskUsage, localRateLimit, busiestTag, busiestTagFractionalBusyness, busiestTagRate, slowReadFraction, engineDebt);
 	}
 };
 
 struct StorageQueuingMetricsRequest {
-	// SOMEDAY: Send threshold value to avoid polling faster than the information changes?
 	constexpr static FileIdentifier file_identifier = 3978640;
+	// A requester that has a reply already can ask to be answered only once it is out of date: the server holds the
+	// request until it has taken in or made durable bytesChange bytes, or its durability lag has moved by lagChange
+	// versions, since the known reply, or for at most maxDelay seconds.  Asking again on each reply then keeps the
+	// requester current without polling idle servers.
+	double maxDelay = 0; // Zero to reply at once
+	int64_t bytesChange = 0;
+	Version lagChange = 0;
+	int64_t knownInstanceID = -1;
+	int64_t knownBytesInput = 0, knownBytesDurable = 0;
+	Version knownLag = 0;
 	ReplyPromise<struct StorageQueuingMetricsReply> reply;
 
+	StorageQueuingMetricsRequest() {}
+	StorageQueuingMetricsRequest(StorageQueuingMetricsReply const& known, double maxDelay, int64_t bytesChange,
+	                             Version lagChange)
+	  : maxDelay(maxDelay), bytesChange(bytesChange), lagChange(lagChange), knownInstanceID(known.instanceID),
+	    knownBytesInput(known.bytesInput), knownBytesDurable(known.bytesDurable),
+	    knownLag(known.version - known.durableVersion) {}
+
+	// Whether a server that has held this request for heldFor seconds, and whose queue is now as given, should reply
+	bool shouldReply(int64_t instanceID, int64_t bytesInput, int64_t bytesDurable, Version lag, double heldFor) const {
+		return heldFor >= maxDelay || instanceID != knownInstanceID || bytesInput - knownBytesInput >= bytesChange ||
+		       bytesDurable - knownBytesDurable >= bytesChange || std::abs(lag - knownLag) >= lagChange;
+	}
+
 	template <class Ar>
 	void serialize(Ar& ar) {
-		serializer(ar, reply);
+		serializer(ar, reply, maxDelay, bytesChange, lagChange, knownInstanceID, knownBytesInput, knownBytesDurable,
+		           knownLag);
 	}
 };
 
@@ -223,6 +223,12 @@ const Value storageCacheServerValue(const StorageServerInterface& ssi) {
 
 const KeyRangeRef ddStatsRange = KeyRangeRef(LiteralStringRef("\xff\xff/metrics/data_distribution_stats/"),
                                              LiteralStringRef("\xff\xff/metrics/data_distribution_stats/\xff\xff"));
+const KeyRangeRef hotKeysRange = KeyRangeRef(LiteralStringRef("\xff\xff/metrics/hot_keys/"),
+                                             LiteralStringRef("\xff\xff/metrics/hot_keys0"));
+const KeyRangeRef conflictHotspotsRange = KeyRangeRef(LiteralStringRef("\xff\xff/metrics/conflict_hotspots/"),
+                                                      LiteralStringRef("\xff\xff/metrics/conflict_hotspots0"));
+const KeyRangeRef processMetricsRange = KeyRangeRef(LiteralStringRef("\xff\xff/metrics/processes/"),
+                                                    LiteralStringRef("\xff\xff/metrics/processes0"));
 
 //    "\xff/storageCache/[[begin]]" := "[[vector<uint16_t>]]"
 const KeyRangeRef storageCacheKeys( LiteralStringRef("\xff/storageCache/"), LiteralStringRef("\xff/storageCache0") );
@@ -246,6 +252,14 @@ void decodeStorageCacheValue( const ValueRef& value, vector<uint16_t>& serverInd
 	}
 }
 
+//    "\xff/storageCacheAuto/[[begin]]" := "[[end]]"
+const KeyRangeRef storageCacheAutoKeys(LiteralStringRef("\xff/storageCacheAuto/"),
+                                       LiteralStringRef("\xff/storageCacheAuto0"));
+
+const Key storageCacheAutoKey(const KeyRef& begin) {
+	return begin.withPrefix(storageCacheAutoKeys.begin);
+}
+
 const Value logsValue( const vector<std::pair<UID, NetworkAddress>>& logs, const vector<std::pair<UID, NetworkAddress>>& oldLogs ) {
 	BinaryWriter wr(IncludeVersion(ProtocolVersion::withLogsValue()));
 	wr << logs;
@@ -750,6 +764,7 @@ const KeyRef fdbClientInfoTxnSizeLimit = LiteralStringRef("\xff\x02/fdbClientInf
 
 // ConsistencyCheck settings
 const KeyRef fdbShouldConsistencyCheckBeSuspended = LiteralStringRef("\xff\x02/ConsistencyCheck/Suspend");
+const KeyRef fdbConsistencyCheckCursorPrefix = LiteralStringRef("\xff\x02/ConsistencyCheck/Cursor/");
 
 // Request latency measurement key
 const KeyRef latencyBandConfigKey = LiteralStringRef("\xff\x02/latencyBandConfig");
@@ -82,6 +82,12 @@ const Key storageCacheKey( const KeyRef& k );
 const Value storageCacheValue( const std::vector<uint16_t>& serverIndices );
 void decodeStorageCacheValue( const ValueRef& value, std::vector<uint16_t>& serverIndices );
 
+//    "\xff/storageCacheAuto/[[begin]]" := "[[end]]"
+//	The cached ranges that data distribution admitted on its own because they were read hot. Data distribution only
+//	ever uncaches these, so that ranges cached by hand are left alone.
+extern const KeyRangeRef storageCacheAutoKeys;
+const Key storageCacheAutoKey(const KeyRef& begin);
+
 //    "\xff/serverKeys/[[serverID]]/[[begin]]" := "[[serverKeysTrue]]" |" [[serverKeysFalse]]"
 //	An internal mapping of what shards any given server currently has ownership of
 //	Using the serverID as a prefix, then followed by the beginning of the shard range
@@ -99,6 +105,9 @@ extern const ValueRef conflictingKeysTrue, conflictingKeysFalse;
 extern const KeyRangeRef writeConflictRangeKeysRange;
 extern const KeyRangeRef readConflictRangeKeysRange;
 extern const KeyRangeRef ddStatsRange;
+extern const KeyRangeRef hotKeysRange;
+extern const KeyRangeRef conflictHotspotsRange;
+extern const KeyRangeRef processMetricsRange;
 
 extern const KeyRef cacheKeysPrefix;
 
@@ -353,6 +362,8 @@ extern const KeyRef fdbClientInfoTxnSizeLimit;
 
 // Consistency Check settings
 extern const KeyRef fdbShouldConsistencyCheckBeSuspended;
+// Where each client of a checksum consistency check resumes, by client id
+extern const KeyRef fdbConsistencyCheckCursorPrefix;
 
 // Request latency measurement key
 extern const KeyRef latencyBandConfigKey;
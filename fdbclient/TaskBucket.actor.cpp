@@ -130,82 +130,43 @@ unsigned int Task::getPriority() const {
 
 class TaskBucketImpl {
 public:
-	ACTOR static Future<Optional<Key>> getTaskKey(Reference<ReadYourWritesTransaction> tr, Reference<TaskBucket> taskBucket, int priority = 0) {
-		Standalone<StringRef> uid = StringRef(deterministicRandom()->randomUniqueID().toString());
-
-		// Get keyspace for the specified priority level
-		state Subspace space = taskBucket->getAvailableSpace(priority);
-
-		{
-			// Get a task key that is <= a random UID task key, if successful then return it
-			Key k = wait(tr->getKey(lastLessOrEqual(space.pack(uid)), true));
-			if(space.contains(k))
-				return Optional<Key>(k);
+	// Adds the UID of each task in values, a range of space, to uids
+	static void addTaskUIDs(Subspace const& space, Standalone<RangeResultRef> const& values, std::vector<Key>& uids) {
+		for (auto& kv : values) {
+			Key uid = space.unpack(kv.key).getString(0);
+			if (uids.empty() || uids.back() != uid)
+				uids.push_back(uid);
 		}
-
-		{
-			// Get a task key that is <= the maximum possible UID, if successful return it.
-			Key k = wait(tr->getKey(lastLessOrEqual(space.pack(maxUIDKey)), true));
-			if(space.contains(k))
-				return Optional<Key>(k);
-		}
-
-		return Optional<Key>();
 	}
-	
-	ACTOR static Future<Reference<Task>> getOne(Reference<ReadYourWritesTransaction> tr, Reference<TaskBucket> taskBucket) {
-		if (taskBucket->priority_batch)
-			tr->setOption( FDBTransactionOptions::PRIORITY_BATCH );
 
-		taskBucket->setOptions(tr);
-
-		// give it some chances for the timed out tasks to get into the task loop in the case of 
-		// many other new tasks get added so that the timed out tasks never get chances to re-run
-		if (deterministicRandom()->random01() < CLIENT_KNOBS->TASKBUCKET_CHECK_TIMEOUT_CHANCE) {
-			bool anyTimeouts = wait(requeueTimedOutTasks(tr, taskBucket));
-			TEST(anyTimeouts); // Found a task that timed out
-		}
-
-		state std::vector<Future<Optional<Key>>> taskKeyFutures(CLIENT_KNOBS->TASKBUCKET_MAX_PRIORITY + 1);
-
-		// Start looking for a task at each priority, highest first
-		state int pri;
-		for(pri = CLIENT_KNOBS->TASKBUCKET_MAX_PRIORITY; pri >= 0; --pri)
-			taskKeyFutures[pri] = getTaskKey(tr, taskBucket, pri);
-		
-		// Task key and subspace it is located in.
-		state Optional<Key> taskKey;
-		state Subspace availableSpace;
-
-		// In priority order from highest to lowest, wait for fetch to finish and if it found a task then cancel the rest.
-		for(pri = CLIENT_KNOBS->TASKBUCKET_MAX_PRIORITY; pri >= 0; --pri) {
-			// If we already have a task key then cancel this fetch
-			if(taskKey.present())
-				taskKeyFutures[pri].cancel();
-			else {
-				Optional<Key> key = wait(taskKeyFutures[pri]);
-				if(key.present()) {
-					taskKey = key;
-					availableSpace = taskBucket->getAvailableSpace(pri);
-				}
+	// Returns the UIDs of up to count tasks in space, chosen randomly from the TASKBUCKET_CLAIM_SCAN_ROWS keys that
+	// follow a random UID.  These are snapshot reads, so agents that claim different tasks do not conflict.
+	ACTOR static Future<std::vector<Key>> getTaskUIDs(Reference<ReadYourWritesTransaction> tr, Subspace space, int count) {
+		state Key start = space.pack(StringRef(deterministicRandom()->randomUniqueID().toString()));
+		state std::vector<Key> uids;
+
+		state Standalone<RangeResultRef> after = wait(tr->getRange(KeyRangeRef(start, space.range().end), CLIENT_KNOBS->TASKBUCKET_CLAIM_SCAN_ROWS, true));
+		addTaskUIDs(space, after, uids);
+
+		// Wrap around to the beginning of the space if the scan reached its end
+		if (!after.more && after.size() < CLIENT_KNOBS->TASKBUCKET_CLAIM_SCAN_ROWS) {
+			Standalone<RangeResultRef> before = wait(tr->getRange(KeyRangeRef(space.range().begin, start), CLIENT_KNOBS->TASKBUCKET_CLAIM_SCAN_ROWS - after.size(), true));
+			for (auto& kv : before) {
+				Key uid = space.unpack(kv.key).getString(0);
+				if (std::find(uids.begin(), uids.end(), uid) == uids.end())
+					uids.push_back(uid);
 			}
 		}
 
-		// If we don't have a task key, requeue timed out tasks and try again by calling self. 
-		if(!taskKey.present()) {
-			bool anyTimeouts = wait(requeueTimedOutTasks(tr, taskBucket));
-			// If there were timeouts, try to get a task since there should now be one in one of the available spaces.
-			if(anyTimeouts) {
-				TEST(true); // Try to get one task from timeouts subspace
-				Reference<Task> task = wait(getOne(tr, taskBucket));
-				return task;
-			}
-			return Reference<Task>();
-		}
+		deterministicRandom()->randomShuffle(uids);
+		if (uids.size() > count)
+			uids.resize(count);
+		return uids;
+	}
 
-		// Now we know the task key is present and we have the available space for the task's priority
-		state Tuple t = availableSpace.unpack(taskKey.get());
-		state Key taskUID = t.getString(0);
+	// Moves the task taskUID from availableSpace to a new timeout version and returns it.  Reading the task's range is
+	// the only conflict range the claim adds.
+	ACTOR static Future<Reference<Task>> claimTask(Reference<ReadYourWritesTransaction> tr, Reference<TaskBucket> taskBucket, Subspace availableSpace, Key taskUID) {
 		state Subspace taskAvailableSpace = availableSpace.get(taskUID);
 
 		state Reference<Task> task(new Task());
@@ -230,6 +191,53 @@ public:
 		return task;
 	}
 
+	// Claims up to count tasks, from the highest priority down
+	ACTOR static Future<std::vector<Reference<Task>>> getMany(Reference<ReadYourWritesTransaction> tr, Reference<TaskBucket> taskBucket, int count) {
+		if (taskBucket->priority_batch)
+			tr->setOption( FDBTransactionOptions::PRIORITY_BATCH );
+
+		taskBucket->setOptions(tr);
+
+		// give it some chances for the timed out tasks to get into the task loop in the case of 
+		// many other new tasks get added so that the timed out tasks never get chances to re-run
+		if (deterministicRandom()->random01() < CLIENT_KNOBS->TASKBUCKET_CHECK_TIMEOUT_CHANCE) {
+			bool anyTimeouts = wait(requeueTimedOutTasks(tr, taskBucket));
+			TEST(anyTimeouts); // Found a task that timed out
+		}
+
+		state std::vector<Reference<Task>> tasks;
+		state int pri;
+		for(pri = CLIENT_KNOBS->TASKBUCKET_MAX_PRIORITY; pri >= 0 && tasks.size() < count; --pri) {
+			state Subspace availableSpace = taskBucket->getAvailableSpace(pri);
+			std::vector<Key> uids = wait(getTaskUIDs(tr, availableSpace, count - tasks.size()));
+
+			state std::vector<Future<Reference<Task>>> claims;
+			for (auto& uid : uids)
+				claims.push_back(claimTask(tr, taskBucket, availableSpace, uid));
+			std::vector<Reference<Task>> claimed = wait(getAll(claims));
+			tasks.insert(tasks.end(), claimed.begin(), claimed.end());
+		}
+
+		// If we don't have a task, requeue timed out tasks and try again by calling self.
+		if(tasks.empty()) {
+			bool anyTimeouts = wait(requeueTimedOutTasks(tr, taskBucket));
+			// If there were timeouts, try to get a task since there should now be one in one of the available spaces.
+			if(anyTimeouts) {
+				TEST(true); // Try to get one task from timeouts subspace
+				std::vector<Reference<Task>> requeued = wait(getMany(tr, taskBucket, count));
+				return requeued;
+			}
+		}
+		TEST(tasks.size() > 1); // Claimed several tasks in one transaction
+
+		return tasks;
+	}
+
+	ACTOR static Future<Reference<Task>> getOne(Reference<ReadYourWritesTransaction> tr, Reference<TaskBucket> taskBucket) {
+		std::vector<Reference<Task>> tasks = wait(getMany(tr, taskBucket, 1));
+		return tasks.empty() ? Reference<Task>() : tasks[0];
+	}
+
 	// Verify that the user configured task verification key still has the user specified value
 	ACTOR static Future<bool> taskVerify(Reference<TaskBucket> tb, Reference<ReadYourWritesTransaction> tr, Reference<Task> task) {
 
@@ -433,45 +441,39 @@ public:
 		for(int i = 0; i < tasks.size(); ++i)
 			availableSlots.push_back(i);
 
-		state std::vector<Future<Reference<Task>>> getTasks;
+		state Future<std::vector<Reference<Task>>> getTasks;
 		state unsigned int getBatchSize = 1;
 
 		loop {
 			// Start running tasks while slots are available and we keep finding work to do
 			++taskBucket->dispatchSlotChecksStarted;
 			while(!availableSlots.empty()) {
-				getTasks.clear();
-				for(int i = 0, imax = std::min<unsigned int>(getBatchSize, availableSlots.size()); i < imax; ++i)
-					getTasks.push_back(taskBucket->getOne(cx));
-				wait(waitForAllReady(getTasks));
-
-				bool done = false;
-				for(int i = 0; i < getTasks.size(); ++i) {
-					if(getTasks[i].isError()) {
-						++taskBucket->dispatchErrors;
-						done = true;
-						continue;
-					}
-					Reference<Task> task = getTasks[i].get();
-					if(task) {
-						// Start the task
-						++taskBucket->dispatchDoTasks;
-						int slot = availableSlots.back();
-						availableSlots.pop_back();
-						tasks[slot] = taskBucket->doTask(cx, futureBucket, task);
-					}
-					else {
-						++taskBucket->dispatchEmptyTasks;
-						done = true;
-					}
+				// The tasks of a batch are claimed in one transaction
+				state int batchSize = std::min<unsigned int>(getBatchSize, availableSlots.size());
+				getTasks = taskBucket->getMany(cx, batchSize);
+				wait(ready(getTasks));
+
+				if(getTasks.isError()) {
+					++taskBucket->dispatchErrors;
+					getBatchSize = 1;
+					break;
 				}
 
-				if(done) {
+				for(auto& task : getTasks.get()) {
+					// Start the task
+					++taskBucket->dispatchDoTasks;
+					int slot = availableSlots.back();
+					availableSlots.pop_back();
+					tasks[slot] = taskBucket->doTask(cx, futureBucket, task);
+				}
+
+				if(getTasks.get().size() < batchSize) {
+					++taskBucket->dispatchEmptyTasks;
 					getBatchSize = 1;
 					break;
 				}
 				else
-					getBatchSize = std::min<unsigned int>(getBatchSize * 2, maxConcurrentTasks);
+					getBatchSize = std::min<unsigned int>({ getBatchSize * 2, (unsigned int)maxConcurrentTasks, (unsigned int)CLIENT_KNOBS->TASKBUCKET_MAX_CLAIM_BATCH });
 			}
 			++taskBucket->dispatchSlotChecksComplete;
 			
@@ -899,6 +901,10 @@ Future<Reference<Task>> TaskBucket::getOne(Reference<ReadYourWritesTransaction>
 	return TaskBucketImpl::getOne(tr, Reference<TaskBucket>::addRef(this));
 }
 
+Future<std::vector<Reference<Task>>> TaskBucket::getMany(Reference<ReadYourWritesTransaction> tr, int count) {
+	return TaskBucketImpl::getMany(tr, Reference<TaskBucket>::addRef(this), count);
+}
+
 Future<bool> TaskBucket::doOne(Database cx, Reference<FutureBucket> futureBucket) {
 	return TaskBucketImpl::doOne(cx, Reference<TaskBucket>::addRef(this), futureBucket);
 }
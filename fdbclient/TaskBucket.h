@@ -190,6 +190,12 @@ public:
 		return runRYWTransaction(cx, [=](Reference<ReadYourWritesTransaction> tr){ return getOne(tr); });
 	}
 
+	// Claims up to count tasks in one transaction
+	Future<std::vector<Reference<Task>>> getMany(Reference<ReadYourWritesTransaction> tr, int count);
+	Future<std::vector<Reference<Task>>> getMany(Database cx, int count) {
+		return runRYWTransaction(cx, [=](Reference<ReadYourWritesTransaction> tr){ return getMany(tr, count); });
+	}
+
 	Future<bool> doTask(Database cx, Reference<FutureBucket> futureBucket, Reference<Task> task);
 
 	Future<bool> doOne(Database cx, Reference<FutureBucket> futureBucket);
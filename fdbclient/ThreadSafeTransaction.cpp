@@ -76,6 +76,17 @@ ThreadFuture<int64_t> ThreadSafeDatabase::rebootWorker(const StringRef& address,
 	} );
 }
 
+ThreadFuture<Standalone<VectorRef<ChangeFeedMutationRef>>> ThreadSafeDatabase::readChangeFeed(const KeyRangeRef& range,
+                                                                                            Version begin,
+                                                                                            Version end) {
+	DatabaseContext *db = this->db;
+	KeyRange r = range;
+	return onMainThread( [db, r, begin, end]() -> Future<Standalone<VectorRef<ChangeFeedMutationRef>>> {
+		db->checkDeferredError();
+		return db->readChangeFeed(r, begin, end);
+	} );
+}
+
 ThreadSafeDatabase::ThreadSafeDatabase(std::string connFilename, int apiVersion) {
 	ClusterConnectionFile *connFile = new ClusterConnectionFile(ClusterConnectionFile::lookupClusterFileName(connFilename).first);
 
@@ -153,6 +164,31 @@ ThreadFuture< Optional<Value> > ThreadSafeTransaction::get( const KeyRef& key, b
 		} );
 }
 
+ThreadFuture< Standalone<RangeResultRef> > ThreadSafeTransaction::getMulti( const VectorRef<KeyRef>& keys, bool snapshot ) {
+	Standalone<VectorRef<KeyRef>> k;
+	k.append_deep(k.arena(), keys.begin(), keys.size());
+
+	ReadYourWritesTransaction *tr = this->tr;
+	return onMainThread( [tr, k, snapshot]() -> Future< Standalone<RangeResultRef> > {
+			tr->checkDeferredError();
+			return tr->getMulti(k, snapshot);
+		} );
+}
+
+ThreadFuture< Standalone<VectorRef<RangeResultRef>> > ThreadSafeTransaction::getBatch( const VectorRef<KeyRef>& keys, const VectorRef<KeyRangeRef>& ranges, const std::vector<int>& rangeLimits, bool snapshot ) {
+	Standalone<VectorRef<KeyRef>> k;
+	k.append_deep(k.arena(), keys.begin(), keys.size());
+	Standalone<VectorRef<KeyRangeRef>> r;
+	r.append_deep(r.arena(), ranges.begin(), ranges.size());
+
+	// All of the reads are started by one task on the network thread
+	ReadYourWritesTransaction *tr = this->tr;
+	return onMainThread( [tr, k, r, rangeLimits, snapshot]() -> Future< Standalone<VectorRef<RangeResultRef>> > {
+			tr->checkDeferredError();
+			return tr->getBatch(k, r, rangeLimits, snapshot);
+		} );
+}
+
 ThreadFuture< Key > ThreadSafeTransaction::getKey( const KeySelectorRef& key, bool snapshot ) {
 	KeySelector k = key;
 
@@ -173,6 +209,16 @@ ThreadFuture<int64_t> ThreadSafeTransaction::getEstimatedRangeSizeBytes( const K
 		} );
 }
 
+ThreadFuture<RangeAggregate> ThreadSafeTransaction::getRangeAggregate(const KeyRangeRef& keys, bool snapshot) {
+	KeyRange r = keys;
+
+	ReadYourWritesTransaction* tr = this->tr;
+	return onMainThread([tr, r, snapshot]() -> Future<RangeAggregate> {
+		tr->checkDeferredError();
+		return tr->getRangeAggregate(r, snapshot);
+	});
+}
+
 ThreadFuture<Standalone<VectorRef<KeyRef>>> ThreadSafeTransaction::getRangeSplitPoints(const KeyRangeRef& range,
                                                                                        int64_t chunkSize) {
 	KeyRange r = range;
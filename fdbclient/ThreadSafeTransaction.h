@@ -43,6 +43,9 @@ public:
 
 	ThreadFuture<int64_t> rebootWorker(const StringRef& address, bool check, int duration);
 
+	ThreadFuture<Standalone<VectorRef<ChangeFeedMutationRef>>> readChangeFeed(const KeyRangeRef& range, Version begin,
+	                                                                          Version end);
+
 private:
 	friend class ThreadSafeTransaction;
 	DatabaseContext* db;
@@ -62,6 +65,8 @@ public:
 	ThreadFuture<Version> getReadVersion() override;
 
 	ThreadFuture< Optional<Value> > get( const KeyRef& key, bool snapshot = false ) override;
+	ThreadFuture< Standalone<RangeResultRef> > getMulti( const VectorRef<KeyRef>& keys, bool snapshot = false ) override;
+	ThreadFuture< Standalone<VectorRef<RangeResultRef>> > getBatch( const VectorRef<KeyRef>& keys, const VectorRef<KeyRangeRef>& ranges, const std::vector<int>& rangeLimits, bool snapshot = false ) override;
 	ThreadFuture< Key > getKey( const KeySelectorRef& key, bool snapshot = false ) override;
 	ThreadFuture< Standalone<RangeResultRef> > getRange( const KeySelectorRef& begin, const KeySelectorRef& end, int limit, bool snapshot = false, bool reverse = false ) override;
 	ThreadFuture< Standalone<RangeResultRef> > getRange( const KeySelectorRef& begin, const KeySelectorRef& end, GetRangeLimits limits, bool snapshot = false, bool reverse = false ) override;
@@ -74,6 +79,7 @@ public:
 	ThreadFuture<Standalone<VectorRef<const char*>>> getAddressesForKey(const KeyRef& key) override;
 	ThreadFuture<Standalone<StringRef>> getVersionstamp() override;
 	ThreadFuture<int64_t> getEstimatedRangeSizeBytes(const KeyRangeRef& keys) override;
+	ThreadFuture<RangeAggregate> getRangeAggregate(const KeyRangeRef& keys, bool snapshot = false) override;
 	ThreadFuture<Standalone<VectorRef<KeyRef>>> getRangeSplitPoints(const KeyRangeRef& range,
 	                                                                int64_t chunkSize) override;
 
@@ -19,11 +19,21 @@
  */
 
 #include "fdbclient/Tuple.h"
+#include "flow/UnitTest.h"
 
+// Only a 0x00 byte can end a string or start an escape, so memchr skips the bytes in between
 static size_t find_string_terminator(const StringRef data, size_t offset) {
 	size_t i = offset;
-	while (i < data.size() - 1 && !(data[i] == '\x00' && data[i+1] != (uint8_t)'\xff')) {
-		i += (data[i] == '\x00' ? 2 : 1);
+	while (i < data.size() - 1) {
+		const uint8_t* z = (const uint8_t*)memchr(data.begin() + i, '\x00', data.size() - 1 - i);
+		if (!z) {
+			return data.size() - 1;
+		}
+		i = z - data.begin();
+		if (data[i+1] != (uint8_t)'\xff') {
+			return i;
+		}
+		i += 2;
 	}
 
 	return i;
@@ -75,17 +85,22 @@ Tuple& Tuple::append(StringRef const& str, bool utf8) {
 	const uint8_t utfChar = uint8_t(utf8 ? '\x02' : '\x01');
 	data.append(data.arena(), &utfChar, 1);
 
-	size_t lastPos = 0;
-	for(size_t pos = 0; pos < str.size(); ++pos) {
-		if(str[pos] == '\x00') {
-			data.append(data.arena(), str.begin() + lastPos, pos - lastPos);
-			data.push_back(data.arena(), (uint8_t)'\x00');
-			data.push_back(data.arena(), (uint8_t)'\xff');
-			lastPos = pos + 1;
-		}
+	// Each 0x00 byte is escaped as 0x00 0xff, so counting them first sizes the element exactly
+	int zeros = 0;
+	for(const uint8_t* z = str.begin(); (z = (const uint8_t*)memchr(z, '\x00', str.end() - z)) != nullptr; ++z) {
+		++zeros;
+	}
+	data.reserve(data.arena(), data.size() + str.size() + zeros + 1);
+
+	const uint8_t* lastPos = str.begin();
+	for(const uint8_t* z; zeros > 0 && (z = (const uint8_t*)memchr(lastPos, '\x00', str.end() - lastPos)) != nullptr; --zeros) {
+		data.append(data.arena(), lastPos, z - lastPos);
+		data.push_back(data.arena(), (uint8_t)'\x00');
+		data.push_back(data.arena(), (uint8_t)'\xff');
+		lastPos = z + 1;
 	}
 
-	data.append(data.arena(), str.begin() + lastPos, str.size() - lastPos);
+	data.append(data.arena(), lastPos, str.end() - lastPos);
 	data.push_back(data.arena(), (uint8_t)'\x00');
 
 	return *this;
@@ -164,26 +179,29 @@ Standalone<StringRef> Tuple::getString(size_t index) const {
 		e = data.size();
 	}
 
+	// A string without escaped 0x00 bytes is returned in place, sharing the arena of the tuple
+	const uint8_t* z = (const uint8_t*)memchr(data.begin() + b, '\x00', e - b);
+	if(!z || z == data.begin() + e - 1) {
+		return Standalone<StringRef>(StringRef(data.begin() + b, (z ? z - data.begin() : e) - b), data.arena());
+	}
+
 	Standalone<StringRef> result;
-	VectorRef<uint8_t> staging;
+	uint8_t* staging = new (result.arena()) uint8_t[e - b];
+	size_t length = 0;
 
-	for (size_t i = b; i < e; ++i) {
-		if(data[i] == '\x00') {
-			staging.append(result.arena(), data.begin() + b, i - b);
-			++i;
-			b = i + 1;
+	while(b < e) {
+		size_t i = z ? z - data.begin() : e;
+		memcpy(staging + length, data.begin() + b, i - b);
+		length += i - b;
+		b = i + 2;
 
-			if(i < e) {
-				staging.push_back(result.arena(), '\x00');
-			}
+		if(i + 1 < e) {
+			staging[length++] = '\x00';
 		}
+		z = b < e ? (const uint8_t*)memchr(data.begin() + b, '\x00', e - b) : nullptr;
 	}
 
-	if(b < e) {
-		staging.append(result.arena(), data.begin() + b, e - b);
-	}
-
-	result.StringRef::operator=(StringRef(staging.begin(), staging.size()));
+	result.StringRef::operator=(StringRef(staging, length));
 	return result;
 }
 
@@ -262,3 +280,27 @@ Tuple Tuple::subTuple(size_t start, size_t end) const {
 	size_t endPos = end < offsets.size() ? offsets[end] : data.size();
 	return Tuple(StringRef(data.begin() + offsets[start], endPos - offsets[start]));
 }
+
+TEST_CASE("/fdbclient/Tuple/escapedStrings") {
+	const StringRef strings[] = { LiteralStringRef(""), LiteralStringRef("plain"), LiteralStringRef("\x00"),
+		                          LiteralStringRef("a\x00\xff\x00b"), LiteralStringRef("\x00\x00end\x00") };
+
+	Tuple t;
+	for (const auto& str : strings) {
+		t.append(str).append(int64_t(-5));
+	}
+
+	Tuple u = Tuple::unpack(t.pack());
+	ASSERT(u.size() == 2 * sizeof(strings) / sizeof(strings[0]));
+	for (int i = 0; i < sizeof(strings) / sizeof(strings[0]); i++) {
+		ASSERT(u.getType(2 * i) == Tuple::ElementType::BYTES);
+		ASSERT(u.getString(2 * i) == strings[i]);
+		ASSERT(u.getInt(2 * i + 1) == -5);
+	}
+
+	// A string element at the end of a truncated tuple has no terminator
+	Tuple v = Tuple::unpack(Tuple().append(LiteralStringRef("a\x00b")).pack().substr(0, 5));
+	ASSERT(v.getString(0) == LiteralStringRef("a\x00b"));
+
+	return Void();
+}
@@ -39,13 +39,21 @@ namespace PTreeImpl {
 
 	#pragma warning(disable: 4800)
 
+	// The size class nodes of the given size are allocated from.  Nodes are most of a storage server's MVCC memory, and
+	// its nodes are just too big for 64 bytes, so they get a size class of their own rather than the general one of 96.
+	inline constexpr int allocatedSize(int size) {
+		return size <= 64 ? 64 : size <= 80 ? 80 : nextFastAllocatedSize(size);
+	}
+
 	template<class T>
-	struct PTree : public ReferenceCounted<PTree<T>>, FastAllocated<PTree<T>>, NonCopyable {
-		uint32_t priority;
+	struct PTree : public ReferenceCounted<PTree<T>>, NonCopyable {
+		// The flags share a word with priority (which is then 30 random bits) so that they fill the space after the
+		// reference count instead of padding out the node
+		uint32_t priority : 30;
+		uint32_t updated : 1;
+		uint32_t replacedPointer : 1;
 		Reference<PTree> pointer[3];
 		Version lastUpdateVersion;
-		bool updated;
-		bool replacedPointer;
 		T data;
 
 		Reference<PTree> child(bool which, Version at) const {
@@ -63,6 +71,16 @@ namespace PTreeImpl {
 		PTree( uint32_t pri, T const& data, Reference<PTree> const& left, Reference<PTree> const& right, Version ver ) : priority(pri), data(data), lastUpdateVersion(ver), updated(false) {
 			pointer[0] = left; pointer[1] = right;
 		}
+
+		[[nodiscard]] static void* operator new(size_t s) {
+			if (s != sizeof(PTree)) abort();
+			INSTRUMENT_ALLOCATE(typeid(PTree).name());
+			return FastAllocator<allocatedSize(sizeof(PTree))>::allocate();
+		}
+		static void operator delete(void* s) {
+			INSTRUMENT_RELEASE(typeid(PTree).name());
+			FastAllocator<allocatedSize(sizeof(PTree))>::release(s);
+		}
 	private:
 		PTree(PTree const&);
 	};
@@ -135,9 +153,9 @@ namespace PTreeImpl {
 				// and should drop its reference count
 				Reference<PTree<T>> r;
 				if (which)
-				    r = makeReference<PTree<T>>(node->priority, node->data, node->child(0, at), ptr, at);
+				    r = makeReference<PTree<T>>((uint32_t)node->priority, node->data, node->child(0, at), ptr, at);
 			    else
-				    r = makeReference<PTree<T>>(node->priority, node->data, ptr, node->child(1, at), at);
+				    r = makeReference<PTree<T>>((uint32_t)node->priority, node->data, ptr, node->child(1, at), at);
 			    node->pointer[2].clear();
 				return r;
 			} else {
@@ -150,9 +168,9 @@ namespace PTreeImpl {
 		}
 		if ( node->updated ) {
 			if (which)
-			    return makeReference<PTree<T>>(node->priority, node->data, node->child(0, at), ptr, at);
+			    return makeReference<PTree<T>>((uint32_t)node->priority, node->data, node->child(0, at), ptr, at);
 		    else
-			    return makeReference<PTree<T>>(node->priority, node->data, ptr, node->child(1, at), at);
+			    return makeReference<PTree<T>>((uint32_t)node->priority, node->data, ptr, node->child(1, at), at);
 	    } else {
 			node->lastUpdateVersion = at;
 			node->replacedPointer = which;
@@ -540,7 +558,7 @@ namespace PTreeImpl {
 		if (p->updated && p->lastUpdateVersion <= newOldestVersion) {
 		/* If the node has been updated, figure out which pointer was replaced. And replace that pointer with the updated pointer.
 		   Then we can get rid of the updated child pointer and then make room in the node for future updates */
-			auto which = p->replacedPointer;
+			bool which = p->replacedPointer;
 			p->pointer[which] = p->pointer[2];
 			p->updated = false;
 			p->pointer[2] = Reference<PTree<T>>();
@@ -606,7 +624,7 @@ public:
 	}
 
 	// For each item in the versioned map, 4 PTree nodes are potentially allocated:
-	static const int overheadPerItem = nextFastAllocatedSize(sizeof(PTreeT)) * 4;
+	static const int overheadPerItem = PTreeImpl::allocatedSize(sizeof(PTreeT)) * 4;
 	struct iterator;
 
 	VersionedMap() : oldestVersion(0), latestVersion(0) {
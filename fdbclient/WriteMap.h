@@ -22,6 +22,9 @@
 #define FDBCLIENT_WRITEMAP_H
 #pragma once
 
+#include <algorithm>
+#include <vector>
+
 #include "fdbclient/FDBTypes.h"
 #include "fdbclient/VersionedMap.h"
 #include "fdbclient/SnapshotCache.h"
@@ -140,17 +143,19 @@ private:
 	typedef Reference<PTreeT> Tree;
 
 public:
-	explicit WriteMap(Arena* arena) : arena(arena), ver(-1), scratch_iterator(this), writeMapEmpty(true)  {
+	explicit WriteMap(Arena* arena) : arena(arena), ver(-1), scratch_iterator(this), writeMapEmpty(true), treeEmpty(true) {
 		PTreeImpl::insert( writes, ver, WriteMapEntry( allKeys.begin, OperationStack(), false, false, false, false, false ) );
 		PTreeImpl::insert( writes, ver, WriteMapEntry( allKeys.end, OperationStack(), false, false, false, false, false ) );
 		PTreeImpl::insert( writes, ver, WriteMapEntry( afterAllKeys, OperationStack(), false, false, false, false, false ) );
 	}
 
 	WriteMap(WriteMap&& r) noexcept
-	  : writeMapEmpty(r.writeMapEmpty), writes(std::move(r.writes)), ver(r.ver),
-	    scratch_iterator(std::move(r.scratch_iterator)), arena(r.arena) {}
+	  : writeMapEmpty(r.writeMapEmpty), treeEmpty(r.treeEmpty), pendingSets(std::move(r.pendingSets)),
+	    writes(std::move(r.writes)), ver(r.ver), scratch_iterator(std::move(r.scratch_iterator)), arena(r.arena) {}
 	WriteMap& operator=(WriteMap&& r) noexcept {
 		writeMapEmpty = r.writeMapEmpty;
+		treeEmpty = r.treeEmpty;
+		pendingSets = std::move(r.pendingSets);
 		writes = std::move(r.writes);
 		ver = r.ver;
 		scratch_iterator = std::move(r.scratch_iterator);
@@ -161,6 +166,54 @@ public:
 	//a write with addConflict false on top of an existing write with a conflict range will not remove the conflict
 	void mutate( KeyRef key, MutationRef::Type operation, ValueRef param, bool addConflict ) {
 		writeMapEmpty = false;
+		if (operation == MutationRef::SetValue) {
+			pendingSets.push_back(PendingSet{ key, param, addConflict });
+			return;
+		}
+		mutateTree(key, operation, param, addConflict);
+	}
+
+	// Blind sets are appended to pendingSets rather than inserted into the tree one at a time.  They are sorted and
+	// merged into the tree only when something needs to look at it or change it in some other way, so every pending set
+	// is newer than everything in the tree.  A transaction that does nothing but set keys can be written out straight
+	// from the sorted sets, without ever building the tree.
+	struct PendingSet {
+		KeyRef key;
+		ValueRef value;
+		bool addConflict;
+	};
+
+	// True if the only writes are pending sets, which sortedPendingSets() then gives in full
+	bool onlyPendingSets() const { return treeEmpty; }
+
+	// The pending sets in key order, and for each key in the order they were made
+	std::vector<PendingSet> const& sortedPendingSets() {
+		std::stable_sort(pendingSets.begin(), pendingSets.end(),
+		                 [](PendingSet const& a, PendingSet const& b) { return a.key < b.key; });
+		return pendingSets;
+	}
+
+private:
+	void flushPendingSets() {
+		if (pendingSets.empty()) {
+			return;
+		}
+		sortedPendingSets();
+		std::vector<PendingSet> sets;
+		sets.swap(pendingSets);
+		for (auto const& s : sets) {
+			mutateTree(s.key, MutationRef::SetValue, s.value, s.addConflict);
+		}
+	}
+
+	Tree const& flushedTree() {
+		flushPendingSets();
+		return writes;
+	}
+
+	void mutateTree( KeyRef key, MutationRef::Type operation, ValueRef param, bool addConflict ) {
+		flushPendingSets();
+		treeEmpty = false;
 		auto& it = scratch_iterator;
 		it.reset(writes, ver);
 		it.skip( key );
@@ -206,8 +259,11 @@ public:
 		}
 	}
 
+public:
 	void clear( KeyRangeRef keys, bool addConflict ) {
 		writeMapEmpty = false;
+		flushPendingSets();
+		treeEmpty = false;
 		if( !addConflict ) {
 			clearNoConflict( keys );
 			return;
@@ -243,6 +299,8 @@ public:
 	}
 
 	void addUnmodifiedAndUnreadableRange( KeyRangeRef keys ) {
+		flushPendingSets();
+		treeEmpty = false;
 		auto& it = scratch_iterator;
 		it.reset(writes, ver);
 		it.skip( keys.begin );
@@ -274,6 +332,8 @@ public:
 
 	void addConflictRange( KeyRangeRef keys ) {
 		writeMapEmpty = false;
+		flushPendingSets();
+		treeEmpty = false;
 		auto& it = scratch_iterator;
 		it.reset(writes, ver);
 		it.skip( keys.begin );
@@ -328,7 +388,7 @@ public:
 		// Modified keys may be dependent (need to be collapsed with a snapshot value) or independent (value is known regardless of the snapshot value)
 		// Every key will belong to exactly one segment.  The first segment begins at "" and the last segment ends at \xff\xff.
 
-		explicit iterator( WriteMap* map ) : tree(map->writes), at( map->ver ), offset(false) { ++map->ver; }
+		explicit iterator( WriteMap* map ) : tree(map->flushedTree()), at( map->ver ), offset(false) { ++map->ver; }
 			// Creates an iterator which is conceptually before the beginning of map (you may essentially only call skip() or ++ on it)
 			// This iterator also represents a snapshot (will be unaffected by future writes)
 
@@ -438,6 +498,22 @@ public:
 			default:
 				throw operation_failed();
 			}
+		} else if (newEntry.type == MutationRef::SetIfAbsent) {
+			switch (existingEntry.type) {
+			case MutationRef::SetValue:
+				return RYWMutation(doSetIfAbsent(existingEntry.value, newEntry.value.get(), arena),
+				                   MutationRef::SetValue);
+			default:
+				throw operation_failed();
+			}
+		} else if (newEntry.type == MutationRef::CompareAndSet) {
+			switch (existingEntry.type) {
+			case MutationRef::SetValue:
+				return RYWMutation(doCompareAndSet(existingEntry.value, newEntry.value.get(), arena),
+				                   MutationRef::SetValue);
+			default:
+				throw operation_failed();
+			}
 		} else if (newEntry.type == MutationRef::AppendIfFits) {
 			switch(existingEntry.type) {
 				case MutationRef::SetValue:
@@ -534,7 +610,8 @@ public:
 		
 	static void coalesceOver(OperationStack& stack, RYWMutation newEntry, Arena& arena) {
 		RYWMutation existingEntry = stack.top();
-		if (existingEntry.type == newEntry.type && newEntry.type != MutationRef::CompareAndClear) {
+		if (existingEntry.type == newEntry.type && newEntry.type != MutationRef::CompareAndClear &&
+		    newEntry.type != MutationRef::SetIfAbsent && newEntry.type != MutationRef::CompareAndSet) {
 			if (isNonAssociativeOp(existingEntry.type) && existingEntry.value.present() && existingEntry.value.get().size() != newEntry.value.get().size()) {
 				stack.push(newEntry);
 			}
@@ -568,6 +645,8 @@ private:
 	friend class ReadYourWritesTransaction;
 	Arena* arena;
 	bool writeMapEmpty;
+	bool treeEmpty; // Nothing but the pending sets has been written
+	std::vector<PendingSet> pendingSets;
 	Tree writes;
 	Version ver;  // an internal version number for the tree - no connection to database versions!  Currently this is incremented after reads, so that consecutive writes have the same version and those separated by reads have different versions.
 	iterator scratch_iterator;   // Avoid unnecessary memory allocation in write operations
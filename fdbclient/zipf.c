@@ -109,6 +109,36 @@ void zipfian_generator(int items) {
   zipfian_generator2(0, items - 1);
 }
 
+void zipfian_init(zipfian_state* z, int min, int max, double zipfianconstant) {
+  int items = max - min + 1;
+  z->base = min;
+  z->theta = zipfianconstant;
+  z->alpha = 1.0 / (1.0 - z->theta);
+  z->zeta2theta = zetastatic(2, z->theta);
+  z->zetan = zetastatic(items, z->theta);
+  z->countforzeta = items;
+}
+
+int zipfian_next_with(zipfian_state* z, int itemcount, double u) {
+  double eta, uz;
+  int ret;
+
+  if (itemcount > z->countforzeta) {
+    z->zetan = zetastatic2(z->countforzeta, itemcount, z->theta, z->zetan);
+    z->countforzeta = itemcount;
+  }
+  eta = (1 - pow(2.0 / itemcount, 1 - z->theta)) / (1 - z->zeta2theta / z->zetan);
+
+  uz = u * z->zetan;
+  if (uz < 1.0) {
+    return z->base;
+  }
+  if (uz < 1.0 + pow(0.5, z->theta)) {
+    return z->base + 1;
+  }
+  ret = (int)(itemcount * pow(eta * u - eta + 1, z->alpha));
+  return z->base + (ret < itemcount ? ret : itemcount - 1);
+}
 
 #if 0 /* test */
 void main() {
@@ -17,6 +17,25 @@ void zipfian_generator3(int min, int max, double zipfianconstant);
 void zipfian_generator(int items);
 int zipfian_next();
 
+/*
+ * A zipfian generator whose state is owned by the caller, so that several can be used at once, and which is given its
+ * uniform random numbers by the caller, so that it can be driven by a deterministic random source.
+ */
+typedef struct {
+  int base;
+  int countforzeta;
+  double theta, alpha, zetan, zeta2theta;
+} zipfian_state;
+
+void zipfian_init(zipfian_state* z, int min, int max, double zipfianconstant);
+
+/*
+ * Returns a value in [min, min + itemcount), where the smaller values are the more popular.  itemcount may grow past
+ * the number of items the generator was initialized with, in which case zeta is extended incrementally.  u must be
+ * uniformly distributed in [0, 1].
+ */
+int zipfian_next_with(zipfian_state* z, int itemcount, double u);
+
 #ifdef __cplusplus
 }
 #endif
@@ -35,6 +35,9 @@
 #include <sys/inotify.h>
 #include <time.h>
 #include <linux/limits.h>
+#include <sched.h>
+#include <dirent.h>
+#include <sys/syscall.h>
 #endif
 
 #ifdef __FreeBSD__
@@ -52,6 +55,10 @@
 #include <stdlib.h>
 
 #include <cinttypes>
+#include <algorithm>
+#include <fstream>
+#include <map>
+#include <set>
 #include <unordered_map>
 #include <unordered_set>
 #include <vector>
@@ -356,6 +363,30 @@ int mkdir(std::string const& directory) {
 	return 0;
 }
 
+// Parses a cpu list such as "0-3,8,10-11", the format used by taskset and by /sys/devices/system.
+bool parse_cpu_list(const std::string& list, std::vector<int>& cpus) {
+	cpus.clear();
+	std::stringstream ss(list);
+	std::string item;
+	while (std::getline(ss, item, ',')) {
+		item.erase(std::remove_if(item.begin(), item.end(), isspace), item.end());
+		if (item.empty())
+			continue;
+		char* endptr;
+		long first = strtol(item.c_str(), &endptr, 10);
+		long last = first;
+		if (*endptr == '-')
+			last = strtol(endptr + 1, &endptr, 10);
+		if (*endptr != '\0' || first < 0 || last < first)
+			return false;
+		for (long cpu = first; cpu <= last; cpu++)
+			cpus.push_back(cpu);
+	}
+	std::sort(cpus.begin(), cpus.end());
+	cpus.erase(std::unique(cpus.begin(), cpus.end()), cpus.end());
+	return true;
+}
+
 struct Command {
 private:
 	std::vector<std::string> commands;
@@ -374,12 +405,18 @@ public:
 	const char *delete_envvars;
 	bool deconfigured;
 	bool kill_on_configuration_change;
+	// "auto", an explicit cpu list, or empty for no pinning
+	std::string cpu_affinity;
+	// Bind memory to the NUMA nodes of the pinned cpus
+	bool numa_bind;
+	// "auto" (the cpus that NIC interrupts are pinned to) or a cpu list that cpu_affinity = auto will not use
+	std::string reserved_cpus;
 
 	// one pair for each of stdout and stderr
 	int pipes[2][2];
 
 	Command() : argv(nullptr) { }
-	Command(const CSimpleIni& ini, std::string _section, uint64_t id, fdb_fd_set fds, int* maxfd) : section(_section), argv(nullptr), fork_retry_time(-1), quiet(false), delete_envvars(nullptr), fds(fds), deconfigured(false), kill_on_configuration_change(true) {
+	Command(const CSimpleIni& ini, std::string _section, uint64_t id, fdb_fd_set fds, int* maxfd) : section(_section), argv(nullptr), fork_retry_time(-1), quiet(false), delete_envvars(nullptr), fds(fds), deconfigured(false), kill_on_configuration_change(true), numa_bind(true) {
 		char _ssection[strlen(section.c_str()) + 22];
 		snprintf(_ssection, strlen(section.c_str()) + 22, "%s.%" PRIu64, section.c_str(), id);
 		ssection = _ssection;
@@ -477,6 +514,34 @@ public:
 			kill_on_configuration_change = false;
 		}
 
+		const char* affinity = get_value_multi(ini, "cpu_affinity", ssection.c_str(), section.c_str(), "general", nullptr);
+		if (affinity && strlen(affinity) > 0) {
+			std::vector<int> cpus;
+			cpu_affinity = affinity;
+			if (cpu_affinity != "auto" && (!parse_cpu_list(cpu_affinity, cpus) || cpus.empty())) {
+				log_msg(SevError, "Unable to parse cpu affinity for %s\n", ssection.c_str());
+				return;
+			}
+#ifndef __linux__
+			log_msg(SevWarn, "cpu_affinity is only supported on Linux and is ignored for %s\n", ssection.c_str());
+#endif
+		}
+
+		const char* nb = get_value_multi(ini, "numa_bind", ssection.c_str(), section.c_str(), "general", nullptr);
+		if (nb && strcmp(nb, "true")) {
+			numa_bind = false;
+		}
+
+		const char* rc = get_value_multi(ini, "reserved_cpus", ssection.c_str(), section.c_str(), "general", nullptr);
+		reserved_cpus = rc ? rc : "auto";
+		if (reserved_cpus != "auto") {
+			std::vector<int> cpus;
+			if (!parse_cpu_list(reserved_cpus, cpus)) {
+				log_msg(SevError, "Unable to parse reserved cpus for %s\n", ssection.c_str());
+				return;
+			}
+		}
+
 		const char* binary = get_value_multi(ini, "command", ssection.c_str(), section.c_str(), "general", nullptr);
 		if (!binary) {
 			log_msg(SevError, "Unable to resolve command for %s\n", ssection.c_str());
@@ -490,7 +555,8 @@ public:
 		for (auto i : keys) {
 			if (!strcmp(i.pItem, "command") || !strcmp(i.pItem, "restart_delay") || !strcmp(i.pItem, "initial_restart_delay") || !strcmp(i.pItem, "restart_backoff") ||
 				!strcmp(i.pItem, "restart_delay_reset_interval") || !strcmp(i.pItem, "disable_lifecycle_logging") || !strcmp(i.pItem, "delete_envvars") ||
-				!strcmp(i.pItem, "kill_on_configuration_change"))
+				!strcmp(i.pItem, "kill_on_configuration_change") || !strcmp(i.pItem, "cpu_affinity") || !strcmp(i.pItem, "numa_bind") ||
+				!strcmp(i.pItem, "reserved_cpus"))
 			{
 				continue;
 			}
@@ -549,6 +615,9 @@ public:
 		if (rhs.commands.size() != commands.size())
 			return true;
 
+		if (cpu_affinity != rhs.cpu_affinity || numa_bind != rhs.numa_bind || reserved_cpus != rhs.reserved_cpus)
+			return true;
+
 		for (size_t i = 0; i < commands.size(); i++) {
 			if (commands[i].compare(rhs.commands[i]) != 0)
 				return true;
@@ -586,10 +655,162 @@ CSimpleOpt::SOption g_rgOptions[] = {
 	SO_END_OF_OPTIONS
 };
 
+#ifdef __linux__
+std::string read_first_line(const std::string& path) {
+	std::ifstream file(path);
+	std::string line;
+	std::getline(file, line);
+	return line;
+}
+
+std::vector<int> online_cpus() {
+	std::vector<int> cpus;
+	if (!parse_cpu_list(read_first_line("/sys/devices/system/cpu/online"), cpus) || cpus.empty()) {
+		cpus.clear();
+		long count = sysconf(_SC_NPROCESSORS_ONLN);
+		for (long cpu = 0; cpu < count; cpu++)
+			cpus.push_back(cpu);
+	}
+	return cpus;
+}
+
+// Maps each online cpu to its NUMA node.  Machines without NUMA information have everything on node 0.
+std::map<int, int> cpu_nodes() {
+	std::map<int, int> nodes;
+	std::vector<int> nodeIds;
+	parse_cpu_list(read_first_line("/sys/devices/system/node/online"), nodeIds);
+	for (int node : nodeIds) {
+		std::vector<int> cpus;
+		if (parse_cpu_list(read_first_line("/sys/devices/system/node/node" + std::to_string(node) + "/cpulist"), cpus)) {
+			for (int cpu : cpus)
+				nodes[cpu] = node;
+		}
+	}
+	return nodes;
+}
+
+std::vector<std::string> list_dir(const std::string& path) {
+	std::vector<std::string> entries;
+	DIR* dir = opendir(path.c_str());
+	if (!dir)
+		return entries;
+	while (struct dirent* entry = readdir(dir)) {
+		if (entry->d_name[0] != '.')
+			entries.push_back(entry->d_name);
+	}
+	closedir(dir);
+	return entries;
+}
+
+// The cpus that the interrupts of network devices have been pinned to.  Interrupts that may be delivered to every
+// online cpu (e.g. the default before irqbalance runs) do not reserve anything.
+std::set<int> nic_interrupt_cpus(size_t onlineCount) {
+	std::set<int> reserved;
+	for (auto& dev : list_dir("/sys/class/net")) {
+		for (auto& irq : list_dir("/sys/class/net/" + dev + "/device/msi_irqs")) {
+			std::vector<int> cpus;
+			if (parse_cpu_list(read_first_line("/proc/irq/" + irq + "/smp_affinity_list"), cpus) && !cpus.empty() &&
+			    cpus.size() < onlineCount) {
+				reserved.insert(cpus.begin(), cpus.end());
+			}
+		}
+	}
+	return reserved;
+}
+
+// Chooses the cpus a process is pinned to.  With cpu_affinity = auto, the processes that use it are ordered by id and
+// dealt round robin across the NUMA nodes, each getting its own cpu among the cpus not reserved for interrupts.
+std::vector<int> choose_cpus(Command* cmd, uint64_t id) {
+	std::vector<int> cpus;
+	if (cmd->cpu_affinity.empty())
+		return cpus;
+	if (cmd->cpu_affinity != "auto") {
+		parse_cpu_list(cmd->cpu_affinity, cpus);
+		return cpus;
+	}
+
+	std::vector<int> online = online_cpus();
+	std::set<int> reserved;
+	if (cmd->reserved_cpus == "auto") {
+		reserved = nic_interrupt_cpus(online.size());
+	} else {
+		std::vector<int> list;
+		parse_cpu_list(cmd->reserved_cpus, list);
+		reserved.insert(list.begin(), list.end());
+	}
+
+	std::map<int, int> nodes = cpu_nodes();
+	std::map<int, std::vector<int>> available;
+	for (int cpu : online) {
+		if (!reserved.count(cpu))
+			available[nodes.count(cpu) ? nodes[cpu] : 0].push_back(cpu);
+	}
+	if (available.empty()) {
+		for (int cpu : online)
+			available[nodes.count(cpu) ? nodes[cpu] : 0].push_back(cpu);
+	}
+	if (available.empty())
+		return cpus;
+
+	std::vector<uint64_t> autoIds;
+	for (auto& i : id_command) {
+		if (i.second->cpu_affinity == "auto")
+			autoIds.push_back(i.first);
+	}
+	std::sort(autoIds.begin(), autoIds.end());
+	size_t index = std::find(autoIds.begin(), autoIds.end(), id) - autoIds.begin();
+
+	auto node = available.begin();
+	std::advance(node, index % available.size());
+	cpus.push_back(node->second[(index / available.size()) % node->second.size()]);
+	return cpus;
+}
+
+// Applies the placement in the child before exec; both the cpu mask and the memory policy survive execv.
+void apply_placement(Command* cmd, const std::vector<int>& cpus) {
+	if (cpus.empty())
+		return;
+
+	cpu_set_t set;
+	CPU_ZERO(&set);
+	for (int cpu : cpus) {
+		if (cpu < CPU_SETSIZE)
+			CPU_SET(cpu, &set);
+	}
+	if (sched_setaffinity(0, sizeof(set), &set) != 0) {
+		fprintf(stderr, "Unable to set cpu affinity for %s (sched_setaffinity error %d: %s)\n", cmd->ssection.c_str(), errno, strerror(errno));
+	}
+
+	if (!cmd->numa_bind)
+		return;
+
+	std::map<int, int> nodes = cpu_nodes();
+	const int maxNodes = 1024;
+	const int bitsPerWord = 8 * sizeof(unsigned long);
+	unsigned long nodeMask[maxNodes / bitsPerWord] = {};
+	bool any = false;
+	for (int cpu : cpus) {
+		auto node = nodes.find(cpu);
+		if (node != nodes.end() && node->second < maxNodes) {
+			nodeMask[node->second / bitsPerWord] |= 1UL << (node->second % bitsPerWord);
+			any = true;
+		}
+	}
+	const int MPOL_BIND_POLICY = 2; // MPOL_BIND from <numaif.h>, which is part of libnuma rather than libc
+	if (any && syscall(SYS_set_mempolicy, MPOL_BIND_POLICY, nodeMask, maxNodes + 1) != 0) {
+		fprintf(stderr, "Unable to bind memory for %s (set_mempolicy error %d: %s)\n", cmd->ssection.c_str(), errno, strerror(errno));
+	}
+}
+#endif
+
 void start_process(Command* cmd, uint64_t id, uid_t uid, gid_t gid, int delay, sigset_t* mask) {
 	if (!cmd->argv)
 		return;
 
+#ifdef __linux__
+	std::vector<int> cpus = choose_cpus(cmd, id);
+#endif
+
 	pid_t pid = fork();
 
 	if (pid < 0) { /* fork error */
@@ -632,6 +853,8 @@ void start_process(Command* cmd, uint64_t id, uid_t uid, gid_t gid, int delay, s
 
 		sigprocmask(SIG_SETMASK, mask, nullptr);
 
+		apply_placement(cmd, cpus);
+
 		/* death of our parent raises SIGHUP */
 		prctl(PR_SET_PDEATHSIG, SIGHUP);
 		if (getppid() == 1) /* parent already died before prctl */
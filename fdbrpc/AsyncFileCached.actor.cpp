@@ -19,6 +19,8 @@
  */
 
 #include "fdbrpc/AsyncFileCached.actor.h"
+#include "flow/UnitTest.h"
+#include "flow/actorcompiler.h" // This must be the last #include.
 
 //Page caches used in non-simulated environments
 Optional<Reference<EvictablePageCache>> pc4k, pc64k;
@@ -39,6 +41,8 @@ EvictablePage::~EvictablePage() {
 			pageCache->pages[index]->index = index;
 			pageCache->pages.pop_back();
 		}
+	} else if (protectedSegment) {
+		pageCache->protectedPages.erase(EvictablePageCache::List::s_iterator_to(*this));
 	} else {
 		// remove it from the LRU
 		pageCache->lruPages.erase(EvictablePageCache::List::s_iterator_to(*this));
@@ -102,7 +106,7 @@ Future<Void> AsyncFileCached::read_write_impl(AsyncFileCached* self,
 		++self->countCacheFinds;
 		auto p = self->pages.find( pageOffset );
 		if ( p == self->pages.end() ) {
-			AFCPage* page = new AFCPage( self, pageOffset );
+			AFCPage* page = new AFCPage( self, pageOffset, !writing && self->isScanMiss(pageOffset) );
 			p = self->pages.insert( std::make_pair(pageOffset, page) ).first;
 		} else {
 			self->pageCache->updateHit(p->second);
@@ -143,7 +147,7 @@ Future<Void> AsyncFileCached::readZeroCopy( void** data, int* length, int64_t of
 
 	auto p = pages.find( offset );
 	if ( p == pages.end() ) {
-		AFCPage* page = new AFCPage( this, offset );
+		AFCPage* page = new AFCPage( this, offset, isScanMiss(offset) );
 		p = pages.insert( std::make_pair(offset, page) ).first;
 	} else {
 		p->second->pageCache->updateHit(p->second);
@@ -295,3 +299,54 @@ AsyncFileCached::~AsyncFileCached() {
 	}
 	openFiles.erase( filename );
 }
+
+namespace {
+
+struct TestEvictablePage : EvictablePage {
+	std::set<int>* resident;
+	int id;
+
+	TestEvictablePage(Reference<EvictablePageCache> pageCache, std::set<int>* resident, int id, bool scan = false)
+	  : EvictablePage(pageCache), resident(resident), id(id) {
+		pageCache->allocate(this, scan);
+		resident->insert(id);
+	}
+
+	bool evict() override {
+		resident->erase(id);
+		delete this;
+		return true;
+	}
+};
+
+} // namespace
+
+TEST_CASE("/fdbrpc/EvictablePageCache/SLRU") {
+	state Reference<EvictablePageCache> cache(new EvictablePageCache(4096, 4096 * 10, EvictablePageCache::SLRU));
+	state std::set<int> resident;
+	std::map<int, TestEvictablePage*> pages;
+
+	// Pages hit a second time are protected and survive a scan of pages that are each read once
+	for (int i = 0; i < 4; i++) {
+		pages[i] = new TestEvictablePage(cache, &resident, i);
+		cache->updateHit(pages[i]);
+	}
+	for (int i = 4; i < 100; i++) {
+		new TestEvictablePage(cache, &resident, i, deterministicRandom()->coinflip());
+	}
+	if (cache->maxProtectedPages >= 4) {
+		for (int i = 0; i < 4; i++) {
+			ASSERT(resident.count(i));
+		}
+	}
+	ASSERT(resident.size() <= cache->maxPages);
+
+	while (!cache->lruPages.empty()) {
+		cache->lruPages.front().evict();
+	}
+	while (!cache->protectedPages.empty()) {
+		cache->protectedPages.front().evict();
+	}
+	ASSERT(resident.empty());
+	return Void();
+}
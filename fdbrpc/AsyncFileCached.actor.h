@@ -43,48 +43,81 @@ struct EvictablePage {
 	int index;
 	class Reference<struct EvictablePageCache> pageCache;
 	bi::list_member_hook<> member_hook;
+	bool protectedSegment; // SLRU only: true once the page has been hit, and so is in the protected segment
 
 	virtual bool evict() = 0; // true if page was evicted, false if it isn't immediately evictable (but will be evicted regardless if possible)
 
-	EvictablePage(Reference<EvictablePageCache> pageCache) : data(0), index(-1), pageCache(pageCache) {}
+	EvictablePage(Reference<EvictablePageCache> pageCache)
+	  : data(0), index(-1), pageCache(pageCache), protectedSegment(false) {}
 	virtual ~EvictablePage();
 };
 
 struct EvictablePageCache : ReferenceCounted<EvictablePageCache> {
 	using List = bi::list< EvictablePage, bi::member_hook< EvictablePage, bi::list_member_hook<>, &EvictablePage::member_hook>>;
-	enum CacheEvictionType { RANDOM = 0, LRU = 1 };
+	// SLRU is a segmented LRU: pages enter a probationary segment and move to a protected segment when they are hit
+	// again, so a scan that touches each page once can only push out other probationary pages.
+	enum CacheEvictionType { RANDOM = 0, LRU = 1, SLRU = 2 };
 
 	static CacheEvictionType evictionPolicyStringToEnum(const std::string &policy) {
 		std::string cep = policy;
 		std::transform(cep.begin(), cep.end(), cep.begin(), ::tolower);
-		if (cep != "random" && cep != "lru")
+		if (cep != "random" && cep != "lru" && cep != "slru")
 			throw invalid_cache_eviction_policy();
 
 		if (cep == "random")
 			return RANDOM;
+		if (cep == "slru")
+			return SLRU;
 		return LRU;
 	}
 
-	EvictablePageCache() : pageSize(0), maxPages(0), cacheEvictionType(RANDOM) {}
+	EvictablePageCache() : pageSize(0), maxPages(0), maxProtectedPages(0), cacheEvictionType(RANDOM) {}
 
-	explicit EvictablePageCache(int pageSize, int64_t maxSize) : pageSize(pageSize), maxPages(maxSize / pageSize), cacheEvictionType(evictionPolicyStringToEnum(FLOW_KNOBS->CACHE_EVICTION_POLICY)) {
+	explicit EvictablePageCache(int pageSize, int64_t maxSize)
+	  : EvictablePageCache(pageSize, maxSize, evictionPolicyStringToEnum(FLOW_KNOBS->CACHE_EVICTION_POLICY)) {}
+
+	EvictablePageCache(int pageSize, int64_t maxSize, CacheEvictionType cacheEvictionType)
+	  : pageSize(pageSize), maxPages(maxSize / pageSize),
+	    maxProtectedPages(maxPages * FLOW_KNOBS->CACHE_PROTECTED_FRACTION), cacheEvictionType(cacheEvictionType) {
 		cacheEvictions.init(LiteralStringRef("EvictablePageCache.CacheEvictions"));
 	}
 
-	void allocate(EvictablePage* page) {
+	// A page read as part of a sequential scan is placed where it will be evicted first, since a scan seldom rereads
+	// what it has just read.
+	void allocate(EvictablePage* page, bool scan = false) {
 		try_evict();
 		try_evict();
 		page->data = pageSize == 4096 ? FastAllocator<4096>::allocate() : aligned_alloc(4096,pageSize);
 		if (RANDOM == cacheEvictionType) {
 			page->index = pages.size();
 			pages.push_back(page);
+		} else if (scan) {
+			lruPages.push_front(*page);
 		} else {
 			lruPages.push_back(*page); // new page is considered the most recently used (placed at LRU tail)
 		}
 	}
 
 	void updateHit(EvictablePage* page) {
-		if (RANDOM != cacheEvictionType) {
+		if (RANDOM == cacheEvictionType) {
+			return;
+		}
+		if (SLRU == cacheEvictionType) {
+			if (page->protectedSegment) {
+				protectedPages.erase(List::s_iterator_to(*page));
+			} else {
+				lruPages.erase(List::s_iterator_to(*page));
+				page->protectedSegment = true;
+			}
+			protectedPages.push_back(*page);
+			// Demote the least recently used protected pages so that they get one more chance before eviction
+			while (protectedPages.size() > (uint64_t)std::max<int64_t>(maxProtectedPages, 1)) {
+				EvictablePage& demoted = protectedPages.front();
+				protectedPages.pop_front();
+				demoted.protectedSegment = false;
+				lruPages.push_back(demoted);
+			}
+		} else {
 			// on a hit, update page's location in the LRU so that it's most recent (tail)
 			lruPages.erase(List::s_iterator_to(*page));
 			lruPages.push_back(*page);
@@ -102,29 +135,40 @@ struct EvictablePageCache : ReferenceCounted<EvictablePageCache> {
 					}
 				}
 			}
-		} else {
-			// For now, LRU is the only other CACHE_EVICTION option
-			if (lruPages.size() >= (uint64_t)maxPages) {
-				int i = 0;
-				// try the least recently used pages first (starting at head of the LRU list)
-				for (List::iterator it = lruPages.begin();
-				     it != lruPages.end() && i < FLOW_KNOBS->MAX_EVICT_ATTEMPTS;
-				     ++it, ++i) { // If we don't manage to evict anything, just go ahead and exceed the cache limit
-					if (it->evict()) {
-						++cacheEvictions;
-						break;
-					}
-				}
+		} else if (lruPages.size() + protectedPages.size() >= (uint64_t)maxPages) {
+			// try the least recently used pages first (starting at head of the LRU list), and for SLRU only fall back
+			// to the protected segment if no probationary page could be evicted
+			int i = 0;
+			if (try_evict_from(lruPages, i) || SLRU != cacheEvictionType) {
+				return;
 			}
+			try_evict_from(protectedPages, i);
 		}
 	}
 
 	std::vector<EvictablePage*> pages;
-	List lruPages;
+	List lruPages; // for SLRU, the probationary segment
+	List protectedPages;
 	int pageSize;
 	int64_t maxPages;
+	int64_t maxProtectedPages;
 	Int64MetricHandle cacheEvictions;
 	const CacheEvictionType cacheEvictionType;
+
+private:
+	bool try_evict_from(List& list, int& attempts) {
+		// If we don't manage to evict anything, just go ahead and exceed the cache limit
+		for (List::iterator it = list.begin(); it != list.end() && attempts < FLOW_KNOBS->MAX_EVICT_ATTEMPTS;
+		     ++attempts) {
+			// evict() deletes the page, which unlinks it, so advance first
+			EvictablePage& page = *it++;
+			if (page.evict()) {
+				++cacheEvictions;
+				return true;
+			}
+		}
+		return false;
+	}
 };
 
 struct OpenFileInfo : NonCopyable {
@@ -253,6 +297,8 @@ private:
 	Reference<EvictablePageCache> pageCache;
 	Future<Void> currentTruncate;
 	int64_t currentTruncateSize;
+	int64_t nextMissOffset; // The page after the last one read into the cache, to detect sequential scans
+	int sequentialMisses;
 
 	// Map of pointers which hold page buffers for pages which have been overwritten
 	// but at the time of write there were still readZeroCopy holders.
@@ -279,7 +325,7 @@ private:
 	Int64MetricHandle countCacheReadBytes;
 
 	AsyncFileCached( Reference<IAsyncFile> uncached, const std::string& filename, int64_t length, Reference<EvictablePageCache> pageCache )
-		: uncached(uncached), filename(filename), length(length), prevLength(length), pageCache(pageCache), currentTruncate(Void()), currentTruncateSize(0) {
+		: uncached(uncached), filename(filename), length(length), prevLength(length), pageCache(pageCache), currentTruncate(Void()), currentTruncateSize(0), nextMissOffset(-1), sequentialMisses(0) {
 		if( !g_network->isSimulated() ) {
 			countFileCacheWrites.init(LiteralStringRef("AsyncFile.CountFileCacheWrites"), filename);
 			countFileCacheReads.init(LiteralStringRef("AsyncFile.CountFileCacheReads"), filename);
@@ -343,6 +389,14 @@ private:
 	                                    int length, int64_t offset);
 
 	void remove_page( AFCPage* page );
+
+	// Called on a read miss. Returns true once CACHE_SCAN_DETECT_PAGES consecutive pages have been missed in order,
+	// which is taken as a hint that the file is being scanned.
+	bool isScanMiss(int64_t pageOffset) {
+		sequentialMisses = pageOffset == nextMissOffset ? sequentialMisses + 1 : 0;
+		nextMissOffset = pageOffset + pageCache->pageSize;
+		return FLOW_KNOBS->CACHE_SCAN_DETECT_PAGES > 0 && sequentialMisses >= FLOW_KNOBS->CACHE_SCAN_DETECT_PAGES;
+	}
 };
 
 struct AFCPage : public EvictablePage, public FastAllocated<AFCPage> {
@@ -566,8 +620,8 @@ struct AFCPage : public EvictablePage, public FastAllocated<AFCPage> {
 		return Void();
 	}
 
-	AFCPage( AsyncFileCached* owner, int64_t offset ) : EvictablePage(owner->pageCache), owner(owner), pageOffset(offset), dirty(false), valid(false), truncated(false), notReading(Void()), notFlushing(Void()), zeroCopyRefCount(0), flushableIndex(-1), writeThroughCount(0) {
-		pageCache->allocate(this);
+	AFCPage( AsyncFileCached* owner, int64_t offset, bool scan ) : EvictablePage(owner->pageCache), owner(owner), pageOffset(offset), dirty(false), valid(false), truncated(false), notReading(Void()), notFlushing(Void()), zeroCopyRefCount(0), flushableIndex(-1), writeThroughCount(0) {
+		pageCache->allocate(this, scan);
 	}
 
 	virtual ~AFCPage() {
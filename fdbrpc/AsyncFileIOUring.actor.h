@@ -0,0 +1,552 @@
+/*
+ * AsyncFileIOUring.actor.h
+ *
+ * This source file is part of the FoundationDB open source project
+ *
+ * Copyright 2013-2020 Apple Inc. and the FoundationDB project authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+#if defined(__linux__) && defined(HAS_IO_URING)
+
+// When actually compiled (NO_INTELLISENSE), include the generated version of this file.  In intellisense use the source version.
+#if defined(NO_INTELLISENSE) && !defined(FLOW_ASYNCFILEIOURING_ACTOR_G_H)
+	#define FLOW_ASYNCFILEIOURING_ACTOR_G_H
+	#include "fdbrpc/AsyncFileIOUring.actor.g.h"
+#elif !defined(FLOW_ASYNCFILEIOURING_ACTOR_H)
+	#define FLOW_ASYNCFILEIOURING_ACTOR_H
+
+#include "fdbrpc/IAsyncFile.h"
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include "fdbrpc/linux_io_uring.h"
+#include "flow/Knobs.h"
+#include "flow/UnitTest.h"
+#include <stdio.h>
+#include "flow/genericactors.actor.h"
+#include "flow/actorcompiler.h"  // This must be the last #include.
+
+// An unbuffered file using a single io_uring shared by all files.  Like AsyncFileKAIO, requests are queued by priority
+// and submitted in one batch per run loop iteration, and completions are signalled on the reactor's eventfd.  Unlike
+// KAIO, sync() is submitted through the ring as well instead of going to the EIO thread pool.
+class AsyncFileIOUring final : public IAsyncFile, public ReferenceCounted<AsyncFileIOUring> {
+public:
+	static Future<Reference<IAsyncFile>> open( std::string filename, int flags, int mode, void* ignore ) {
+		ASSERT( isEnabled() );
+		ASSERT( flags & OPEN_UNBUFFERED );
+
+		if (flags & OPEN_LOCK)
+			mode |= 02000;  // Enable mandatory locking for this file if it is supported by the filesystem
+
+		std::string open_filename = filename;
+		if (flags & OPEN_ATOMIC_WRITE_AND_CREATE) {
+			ASSERT( (flags & OPEN_CREATE) && (flags & OPEN_READWRITE) && !(flags & OPEN_EXCLUSIVE) );
+			open_filename = filename + ".part";
+		}
+
+		int fd = ::open( open_filename.c_str(), openFlags(flags), mode );
+		if (fd<0) {
+			Error e = errno==ENOENT ? file_not_found() : io_error();
+			TraceEvent("AsyncFileIOUringOpenFailed").error(e).detail("Filename", filename).detailf("Flags", "%x", flags)
+			  .detailf("OSFlags", "%x", openFlags(flags)).detailf("Mode", "0%o", mode).GetLastError();
+			return e;
+		} else {
+			TraceEvent("AsyncFileIOUringOpen")
+				.detail("Filename", filename)
+				.detail("Flags", flags)
+				.detail("Mode", mode)
+				.detail("Fd", fd);
+		}
+
+		Reference<AsyncFileIOUring> r(new AsyncFileIOUring( fd, flags, filename ));
+
+		if (flags & OPEN_LOCK) {
+			// Acquire a "write" lock for the entire file
+			flock lockDesc;
+			lockDesc.l_type = F_WRLCK;
+			lockDesc.l_whence = SEEK_SET;
+			lockDesc.l_start = 0;
+			lockDesc.l_len = 0;
+			lockDesc.l_pid = 0;
+			if (fcntl(fd, F_SETLK, &lockDesc) == -1) {
+				TraceEvent(SevError, "UnableToLockFile").detail("Filename", filename).GetLastError();
+				return io_error();
+			}
+		}
+
+		struct stat buf;
+		if (fstat( fd, &buf )) {
+			TraceEvent("AsyncFileIOUringFStatError").detail("Fd",fd).detail("Filename", filename).GetLastError();
+			return io_error();
+		}
+
+		r->lastFileSize = r->nextFileSize = buf.st_size;
+		return Reference<IAsyncFile>(std::move(r));
+	}
+
+	// Sets up the shared ring.  Returns false, leaving AsyncFileIOUring disabled, if the kernel does not support
+	// io_uring, so that the caller can fall back to AsyncFileKAIO.
+	static bool init( Reference<IEventFD> ev, double ioTimeout ) {
+		ASSERT( FLOW_KNOBS->IO_URING_ENTRIES >= FLOW_KNOBS->MAX_OUTSTANDING );
+		if (!ctx.ring.setup(FLOW_KNOBS->IO_URING_ENTRIES) || !ctx.ring.registerEventFD(ev->getFD())) {
+			TraceEvent(SevWarnAlways, "IOUringSetupError").GetLastError();
+			if (ctx.ring.fd >= 0) {
+				close(ctx.ring.fd);
+				ctx.ring.fd = -1;
+			}
+			return false;
+		}
+
+		if( !g_network->isSimulated() ) {
+			ctx.countAIOSubmit.init(LiteralStringRef("AsyncFile.CountAIOSubmit"));
+			ctx.countAIOCollect.init(LiteralStringRef("AsyncFile.CountAIOCollect"));
+			ctx.submitMetric.init(LiteralStringRef("AsyncFile.Submit"));
+			ctx.countPreSubmitTruncate.init(LiteralStringRef("AsyncFile.CountPreAIOSubmitTruncate"));
+			ctx.preSubmitTruncateBytes.init(LiteralStringRef("AsyncFile.PreAIOSubmitTruncateBytes"));
+		}
+
+		TraceEvent("IOUringInit").detail("Entries", ctx.ring.sqEntries);
+		setTimeout(ioTimeout);
+		ctx.enabled = true;
+		poll(ev);
+
+		g_network->setGlobal(INetwork::enRunCycleFunc, (flowGlobalType) &AsyncFileIOUring::launch);
+		return true;
+	}
+
+	static bool isEnabled() { return ctx.enabled; }
+	static void setTimeout(double ioTimeout) { ctx.setIOTimeout(ioTimeout); }
+
+	void addref() override { ReferenceCounted<AsyncFileIOUring>::addref(); }
+	void delref() override { ReferenceCounted<AsyncFileIOUring>::delref(); }
+
+	Future<int> read(void* data, int length, int64_t offset) override {
+		++countFileLogicalReads;
+		++countLogicalReads;
+
+		if(failed) {
+			return io_timeout();
+		}
+
+		IOBlock *io = new IOBlock(IORING_OP_READV, fd);
+		io->iov.iov_base = data;
+		io->iov.iov_len = length;
+		io->offset = offset;
+
+		enqueue(io, this);
+		return io->result.getFuture();
+	}
+	Future<Void> write(void const* data, int length, int64_t offset) override {
+		++countFileLogicalWrites;
+		++countLogicalWrites;
+
+		if(failed) {
+			return io_timeout();
+		}
+
+		IOBlock *io = new IOBlock(IORING_OP_WRITEV, fd);
+		io->iov.iov_base = (void*)data;
+		io->iov.iov_len = length;
+		io->offset = offset;
+
+		nextFileSize = std::max( nextFileSize, offset+length );
+
+		enqueue(io, this);
+		return success(io->result.getFuture());
+	}
+#ifndef FALLOC_FL_ZERO_RANGE
+#define FALLOC_FL_ZERO_RANGE 0x10
+#endif
+	Future<Void> zeroRange(int64_t offset, int64_t length) override {
+		bool success = false;
+		if (ctx.fallocateZeroSupported) {
+			int rc = fallocate( fd, FALLOC_FL_ZERO_RANGE, offset, length );
+			if (rc == EOPNOTSUPP) {
+				ctx.fallocateZeroSupported = false;
+			}
+			if (rc == 0) {
+				success = true;
+			}
+		}
+		return success ? Void() : IAsyncFile::zeroRange(offset, length);
+	}
+	Future<Void> truncate(int64_t size) override {
+		++countFileLogicalWrites;
+		++countLogicalWrites;
+
+		if(failed) {
+			return io_timeout();
+		}
+
+		int result = -1;
+		bool completed = false;
+		if( ctx.fallocateSupported && size >= lastFileSize ) {
+			result = fallocate( fd, 0, 0, size);
+			if (result != 0) {
+				int fallocateErrCode = errno;
+				TraceEvent("AsyncFileIOUringAllocateError").detail("Fd",fd).detail("Filename", filename).detail("Size", size).GetLastError();
+				if ( fallocateErrCode == EOPNOTSUPP ) {
+					// Mark fallocate as unsupported. Try again with truncate.
+					ctx.fallocateSupported = false;
+				} else {
+					return io_error();
+				}
+			} else {
+				completed = true;
+			}
+		}
+		if ( !completed )
+			result = ftruncate(fd, size);
+
+		if(result != 0) {
+			TraceEvent("AsyncFileIOUringTruncateError").detail("Fd",fd).detail("Filename", filename).GetLastError();
+			return io_error();
+		}
+
+		lastFileSize = nextFileSize = size;
+
+		return Void();
+	}
+
+	Future<Void> sync() override {
+		++countFileLogicalWrites;
+		++countLogicalWrites;
+
+		if(failed) {
+			return io_timeout();
+		}
+
+		IOBlock *io = new IOBlock(IORING_OP_FSYNC, fd);
+		io->fsyncFlags = IORING_FSYNC_DATASYNC;
+		enqueue(io, this);
+		Future<Void> fsync = success(io->result.getFuture());
+
+		if (flags & OPEN_ATOMIC_WRITE_AND_CREATE) {
+			flags &= ~OPEN_ATOMIC_WRITE_AND_CREATE;
+
+			return AsyncFileEIO::waitAndAtomicRename( fsync, filename+".part", filename );
+		}
+
+		return fsync;
+	}
+	Future<int64_t> size() const override { return nextFileSize; }
+	int64_t debugFD() const override { return fd; }
+	std::string getFilename() const override { return filename; }
+	~AsyncFileIOUring() {
+		close(fd);
+	}
+
+	static void launch() {
+		if (ctx.queue.size() && ctx.outstanding < FLOW_KNOBS->MAX_OUTSTANDING - FLOW_KNOBS->MIN_SUBMIT) {
+			ctx.submitMetric = true;
+
+			double begin = timer_monotonic();
+			if (!ctx.outstanding) ctx.ioStallBegin = begin;
+
+			int n = std::min<size_t>(FLOW_KNOBS->MAX_OUTSTANDING - ctx.outstanding, ctx.queue.size());
+			n = std::min<int>(n, ctx.ring.sqSpace());
+
+			for(int i=0; i<n; i++) {
+				auto io = ctx.queue.top();
+				ctx.queue.pop();
+				io->startTime = now();
+
+				if(ctx.ioTimeout > 0) {
+					ctx.appendToRequestList(io);
+				}
+
+				if (io->opcode != IORING_OP_FSYNC && io->owner->lastFileSize != io->owner->nextFileSize) {
+					++ctx.countPreSubmitTruncate;
+					int64_t truncateSize = io->owner->nextFileSize - io->owner->lastFileSize;
+					ASSERT(truncateSize > 0);
+					ctx.preSubmitTruncateBytes += truncateSize;
+					io->owner->truncate(io->owner->nextFileSize);
+				}
+
+				io->prepare(ctx.ring.nextSQE(i));
+			}
+
+			// The kernel consumes every published entry even if it fails some of them early; its errors are reported
+			// as completions, so there is nothing to requeue here.
+			int rc = ctx.ring.submit(n);
+			if (rc < 0) {
+				TraceEvent(SevError, "IOUringSubmitError").GetLastError();
+				throw io_error();
+			}
+			ctx.outstanding += n;
+
+			ctx.submitMetric = false;
+			++ctx.countAIOSubmit;
+
+			double elapsed = timer_monotonic() - begin;
+			g_network->networkInfo.metrics.secSquaredSubmit += elapsed*elapsed/2;
+
+			if(elapsed > FLOW_KNOBS->SLOW_LOOP_CUTOFF && nondeterministicRandom()->random01() < elapsed) {
+				TraceEvent("SlowIOUringLaunch").detail("SubmitTime", elapsed).detail("Count", n);
+			}
+		}
+	}
+
+	bool failed;
+private:
+	int fd, flags;
+	int64_t lastFileSize, nextFileSize;
+	std::string filename;
+	Int64MetricHandle countFileLogicalWrites;
+	Int64MetricHandle countFileLogicalReads;
+
+	Int64MetricHandle countLogicalWrites;
+	Int64MetricHandle countLogicalReads;
+
+	struct IOBlock : FastAllocated<IOBlock> {
+		uint8_t opcode;
+		int fd;
+		iovec iov;
+		int64_t offset;
+		uint32_t fsyncFlags;
+		Promise<int> result;
+		Reference<AsyncFileIOUring> owner;
+		int64_t prio;
+		IOBlock *prev;
+		IOBlock *next;
+		double startTime;
+
+		struct indirect_order_by_priority { bool operator () ( IOBlock* a, IOBlock* b ) { return a->prio < b->prio; } };
+
+		IOBlock(uint8_t opcode, int fd) : opcode(opcode), fd(fd), offset(0), fsyncFlags(0), prev(nullptr), next(nullptr), startTime(0) {
+			iov.iov_base = nullptr;
+			iov.iov_len = 0;
+		}
+
+		TaskPriority getTask() const { return static_cast<TaskPriority>((prio>>32)+1); }
+
+		void prepare(io_uring_sqe* sqe) const {
+			sqe->opcode = opcode;
+			sqe->fd = fd;
+			sqe->user_data = (uint64_t)this;
+			if (opcode == IORING_OP_FSYNC) {
+				sqe->fsync_flags = fsyncFlags;
+			} else {
+				sqe->addr = (uint64_t)&iov;
+				sqe->len = 1;
+				sqe->off = offset;
+			}
+		}
+
+		ACTOR static void deliver( Promise<int> result, bool failed, int r, TaskPriority task ) {
+			wait( delay(0, task) );
+			if (failed) result.sendError(io_timeout());
+			else if (r < 0) result.sendError(io_error());
+			else result.send(r);
+		}
+
+		void setResult( int r ) {
+			if (r<0) {
+				errno = -r;
+				TraceEvent("AsyncFileIOUringIOError").GetLastError().detail("Fd", fd).detail("Op", opcode).detail("Nbytes", iov.iov_len)
+					.detail("Offset", offset).detail("Ptr", int64_t(iov.iov_base)).detail("Filename", owner->filename);
+			}
+			deliver( result, owner->failed, r, getTask() );
+			delete this;
+		}
+
+		void timeout(bool warnOnly) {
+			TraceEvent(SevWarnAlways, "AsyncFileIOUringTimeout").detail("Fd", fd).detail("Op", opcode).detail("Nbytes", iov.iov_len)
+				.detail("Offset", offset).detail("Filename", owner->filename);
+			g_network->setGlobal(INetwork::enASIOTimedOut, (flowGlobalType)true);
+
+			if(!warnOnly)
+				owner->failed = true;
+		}
+	};
+
+	struct Context {
+		LinuxIOUring ring;
+		bool enabled;
+		int outstanding;
+		double ioStallBegin;
+		bool fallocateSupported;
+		bool fallocateZeroSupported;
+		std::priority_queue<IOBlock*, std::vector<IOBlock*>, IOBlock::indirect_order_by_priority> queue;
+		Int64MetricHandle countAIOSubmit;
+		Int64MetricHandle countAIOCollect;
+		Int64MetricHandle submitMetric;
+
+		double ioTimeout;
+		bool timeoutWarnOnly;
+		IOBlock *submittedRequestList;
+
+		Int64MetricHandle countPreSubmitTruncate;
+		Int64MetricHandle preSubmitTruncateBytes;
+
+		uint32_t opsIssued;
+		Context() : enabled(false), outstanding(0), ioStallBegin(0), fallocateSupported(true), fallocateZeroSupported(true), submittedRequestList(nullptr), opsIssued(0) {
+			setIOTimeout(0);
+		}
+
+		void setIOTimeout(double timeout) {
+			ioTimeout = fabs(timeout);
+			timeoutWarnOnly = timeout < 0;
+		}
+
+		void appendToRequestList(IOBlock *io) {
+			ASSERT(!io->next && !io->prev);
+
+			if(submittedRequestList) {
+				io->prev = submittedRequestList->prev;
+				io->prev->next = io;
+
+				submittedRequestList->prev = io;
+				io->next = submittedRequestList;
+			}
+			else {
+				submittedRequestList = io;
+				io->next = io->prev = io;
+			}
+		}
+
+		void removeFromRequestList(IOBlock *io) {
+			if(io->next == nullptr) {
+				ASSERT(io->prev == nullptr);
+				return;
+			}
+
+			ASSERT(io->prev != nullptr);
+
+			if(io == io->next) {
+				ASSERT(io == submittedRequestList && io == io->prev);
+				submittedRequestList = nullptr;
+			}
+			else {
+				io->next->prev = io->prev;
+				io->prev->next = io->next;
+
+				if(submittedRequestList == io) {
+					submittedRequestList = io->next;
+				}
+			}
+
+			io->next = io->prev = nullptr;
+		}
+	};
+	static Context ctx;
+
+	explicit AsyncFileIOUring(int fd, int flags, std::string const& filename) : failed(false), fd(fd), flags(flags), filename(filename) {
+		if( !g_network->isSimulated() ) {
+			countFileLogicalWrites.init(LiteralStringRef("AsyncFile.CountFileLogicalWrites"), filename);
+			countFileLogicalReads.init( LiteralStringRef("AsyncFile.CountFileLogicalReads"), filename);
+			countLogicalWrites.init(LiteralStringRef("AsyncFile.CountLogicalWrites"));
+			countLogicalReads.init( LiteralStringRef("AsyncFile.CountLogicalReads"));
+		}
+	}
+
+	void enqueue( IOBlock* io, AsyncFileIOUring* owner ) {
+		ASSERT( io->opcode == IORING_OP_FSYNC || (int64_t(io->iov.iov_base) % 4096 == 0 && io->offset % 4096 == 0 && io->iov.iov_len % 4096 == 0) );
+
+		io->prio = (int64_t(g_network->getCurrentTask())<<32) - (++ctx.opsIssued);
+		io->owner = Reference<AsyncFileIOUring>::addRef(owner);
+
+		ctx.queue.push(io);
+	}
+
+	static int openFlags(int flags) {
+		int oflags = O_DIRECT | O_CLOEXEC;
+		ASSERT( bool(flags & OPEN_READONLY) != bool(flags & OPEN_READWRITE) );  // readonly xor readwrite
+		if( flags & OPEN_EXCLUSIVE ) oflags |= O_EXCL;
+		if( flags & OPEN_CREATE )    oflags |= O_CREAT;
+		if( flags & OPEN_READONLY )  oflags |= O_RDONLY;
+		if( flags & OPEN_READWRITE ) oflags |= O_RDWR;
+		if( flags & OPEN_ATOMIC_WRITE_AND_CREATE ) oflags |= O_TRUNC;
+		return oflags;
+	}
+
+	ACTOR static void poll( Reference<IEventFD> ev ) {
+		loop {
+			wait(success(ev->read()));
+
+			wait(delay(0, TaskPriority::DiskIOComplete));
+
+			// Reap first so that the IOBlocks are only touched once the kernel has released the completion ring
+			std::vector<std::pair<IOBlock*, int>> completed;
+			ctx.ring.reap([&](io_uring_cqe const& cqe) { completed.emplace_back((IOBlock*)cqe.user_data, cqe.res); });
+
+			++ctx.countAIOCollect;
+			int n = completed.size();
+			if (n) {
+				double t = timer_monotonic();
+				double elapsed = t - ctx.ioStallBegin;
+				ctx.ioStallBegin = t;
+				g_network->networkInfo.metrics.secSquaredDiskStall += elapsed*elapsed/2;
+			}
+
+			ctx.outstanding -= n;
+
+			if(ctx.ioTimeout > 0) {
+				double currentTime = now();
+				while(ctx.submittedRequestList && currentTime - ctx.submittedRequestList->startTime > ctx.ioTimeout) {
+					ctx.submittedRequestList->timeout(ctx.timeoutWarnOnly);
+					ctx.removeFromRequestList(ctx.submittedRequestList);
+				}
+			}
+
+			for(auto& c : completed) {
+				if(ctx.ioTimeout > 0) {
+					ctx.removeFromRequestList(c.first);
+				}
+
+				c.first->setResult( c.second );
+			}
+		}
+	}
+};
+
+ACTOR Future<Void> runIOUringRoundTrip(Reference<IAsyncFile> f) {
+	state void *buf = FastAllocator<4096>::allocate();
+	state int i = 0;
+	for(; i < 16; i++) {
+		memset(buf, i, 4096);
+		wait(f->write(buf, 4096, i * 4096));
+	}
+	wait(f->sync());
+	for(i = 0; i < 16; i++) {
+		memset(buf, 0xff, 4096);
+		int r = wait(f->read(buf, 4096, i * 4096));
+		ASSERT(r == 4096 && ((uint8_t*)buf)[0] == i && ((uint8_t*)buf)[4095] == i);
+	}
+	FastAllocator<4096>::release(buf);
+	return Void();
+}
+
+TEST_CASE("/fdbrpc/AsyncFileIOUring/RoundTrip") {
+	// This test does nothing in simulation, or where the ring could not be set up
+	if (!g_network->isSimulated() && AsyncFileIOUring::isEnabled()) {
+		state Reference<IAsyncFile> f;
+		Reference<IAsyncFile> f_ = wait(AsyncFileIOUring::open(
+		    "/tmp/__IO_URING_TEST_FILE__",
+		    IAsyncFile::OPEN_UNBUFFERED | IAsyncFile::OPEN_READWRITE | IAsyncFile::OPEN_CREATE, 0666, nullptr));
+		f = f_;
+		wait(runIOUringRoundTrip(f));
+		ASSERT(!((AsyncFileIOUring*)f.getPtr())->failed);
+		wait(AsyncFileEIO::deleteFile(f->getFilename(), true));
+	}
+	return Void();
+}
+
+AsyncFileIOUring::Context AsyncFileIOUring::ctx;
+
+#include "flow/unactorcompiler.h"
+#endif
+#endif
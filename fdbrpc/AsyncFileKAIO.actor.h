@@ -162,6 +162,7 @@ public:
 			ctx.countPreSubmitTruncate.init(LiteralStringRef("AsyncFile.CountPreAIOSubmitTruncate"));
 			ctx.preSubmitTruncateBytes.init(LiteralStringRef("AsyncFile.PreAIOSubmitTruncateBytes"));
 			ctx.slowAioSubmitMetric.init(LiteralStringRef("AsyncFile.SlowAIOSubmit"));
+			ctx.countBackgroundThrottled.init(LiteralStringRef("AsyncFile.CountBackgroundThrottled"));
 		}
 		
 		int rc = io_setup( FLOW_KNOBS->MAX_OUTSTANDING, &ctx.iocx );
@@ -369,6 +370,12 @@ public:
 			for(int i=0; i<n; i++) {
 				auto io = ctx.queue.top();
 
+				// The queue is ordered by priority, so once background work is held back everything after it is too
+				if (ctx.throttleBackground(io)) {
+					n = i;
+					break;
+				}
+
 				KAIOLogBlockEvent(io, OpLogEntry::LAUNCH);
 
 				ctx.queue.pop();
@@ -388,6 +395,11 @@ public:
 					io->owner->truncate(io->owner->nextFileSize);
 				}
 			}
+			if (!n) {
+				ctx.submitMetric = false;
+				return;
+			}
+
 			double truncateComplete = timer_monotonic();
 			int rc = io_submit( ctx.iocx, n, (linux_iocb**)toStart );
 			double end = timer_monotonic();
@@ -523,11 +535,43 @@ private:
 
 		EventMetricHandle<SlowAioSubmit> slowAioSubmitMetric;
 
+		// Token bucket for I/O issued from tasks at or below KAIO_BACKGROUND_TASK_PRIORITY
+		double backgroundBudget;
+		double backgroundBudgetTime;
+		Future<Void> backgroundWake;
+		Int64MetricHandle countBackgroundThrottled;
+
 		uint32_t opsIssued;
-		Context() : iocx(0), evfd(-1), outstanding(0), opsIssued(0), ioStallBegin(0), fallocateSupported(true), fallocateZeroSupported(true), submittedRequestList(nullptr) {
+		Context() : iocx(0), evfd(-1), outstanding(0), opsIssued(0), ioStallBegin(0), fallocateSupported(true), fallocateZeroSupported(true), submittedRequestList(nullptr),
+		            backgroundBudget(0), backgroundBudgetTime(0) {
 			setIOTimeout(0);
 		}
 
+		// Returns true if io is background work that has used up its share of the disk for now, in which case a timer
+		// is left running so that the run loop wakes up to launch it once the budget has refilled.
+		bool throttleBackground(IOBlock* io) {
+			const double rate = FLOW_KNOBS->KAIO_BACKGROUND_BYTES_PER_SECOND;
+			if (rate <= 0 || io->getTask() > static_cast<TaskPriority>(FLOW_KNOBS->KAIO_BACKGROUND_TASK_PRIORITY)) {
+				return false;
+			}
+
+			// Allow bursts of up to a tenth of a second of the budget
+			double t = now();
+			backgroundBudget = std::min(rate / 10, backgroundBudget + (t - backgroundBudgetTime) * rate);
+			backgroundBudgetTime = t;
+			if (backgroundBudget <= 0) {
+				if (!backgroundWake.isValid() || backgroundWake.isReady()) {
+					backgroundWake = delay(-backgroundBudget / rate, TaskPriority::DiskIOComplete);
+				}
+				++countBackgroundThrottled;
+				return true;
+			}
+
+			// A request larger than the remaining budget still goes, and the debt is paid before the next one
+			backgroundBudget -= io->nbytes;
+			return false;
+		}
+
 		void setIOTimeout(double timeout) {
 			ioTimeout = fabs(timeout);
 			timeoutWarnOnly = timeout < 0;
@@ -29,9 +29,14 @@
 
 #include "flow/flow.h"
 #include "fdbrpc/IAsyncFile.h"
+#include "fdbrpc/Smoother.h"
 #include "flow/actorcompiler.h"  // This must be the last #include.
 
-// Read-only file type that wraps another file instance, reads in large blocks, and reads ahead of the actual range requested
+// Read-only file type that wraps another file instance, reads in large blocks, and reads ahead of the actual range requested.
+// If maxReadAheadBlocks is greater than readAheadBlocks the read ahead window adapts to the underlying file: it doubles
+// whenever a sequential reader has to wait for a block, and otherwise settles at the bandwidth-delay product of the
+// measured block latency and fetch rate.  Growth above readAheadBlocks is limited by READ_AHEAD_ADAPTIVE_MAX_BYTES,
+// which is shared by all open files in the process.
 class AsyncFileReadAheadCache final : public IAsyncFile, public ReferenceCounted<AsyncFileReadAheadCache> {
 public:
 	void addref() override { ReferenceCounted<AsyncFileReadAheadCache>::addref(); }
@@ -49,9 +54,13 @@ public:
 		wait(f->m_max_concurrent_reads.take());
 
 		state Reference<CacheBlock> block(new CacheBlock(length));
+		state double start = now();
 		try {
 			int len = wait(f->m_f->read(block->data, length, offset));
 			block->len = len;
+			f->m_fetched.addDelta(len);
+			double latency = now() - start;
+			f->m_block_latency = f->m_block_latency == 0 ? latency : 0.9 * f->m_block_latency + 0.1 * latency;
 		} catch(Error &e) {
 			f->m_max_concurrent_reads.release(1);
 			throw e;
@@ -91,6 +100,10 @@ public:
 		ASSERT(lastBlockNum <= lastBlockNumInFile);
 		int lastBlockToStart = std::min<int>(lastBlockNum + f->m_read_ahead_blocks, lastBlockNumInFile);
 
+		state bool sequential = firstBlockNum == f->m_last_block_read || firstBlockNum == f->m_last_block_read + 1;
+		state bool stalled = false;
+		f->m_last_block_read = lastBlockNum;
+
 		state int blockNum;
 		for(blockNum = firstBlockNum; blockNum <= lastBlockToStart; ++blockNum) {
 			Future<Reference<CacheBlock>> fblock;
@@ -107,8 +120,10 @@ public:
 				fblock = i->second;
 
 			// Only put blocks we actually need into our local cache
-			if(blockNum <= lastBlockNum)
+			if(blockNum <= lastBlockNum) {
 				localCache[blockNum] = fblock;
+				stalled = stalled || !fblock.isReady();
+			}
 		}
 
 		// Read block(s) and copy data
@@ -130,6 +145,10 @@ public:
 		ASSERT(wpos == length);
 		localCache.clear();
 
+		if (sequential) {
+			f->adaptReadAhead(stalled);
+		}
+
 		// If the cache is too large then go through the cache in block number order and remove any entries whose future
 		// has a reference count of 1, stopping once the cache is no longer too big.  There is no point in removing
 		// an entry from the cache if it has a reference count of > 1 because it will continue to exist and use memory
@@ -138,13 +157,17 @@ public:
 		//printf("cache block limit: %d   Cache contents:\n", f->m_cache_block_limit);
 		//for(auto &m : f->m_blocks) printf("\tblock %d refcount %d\n", m.first, m.second.getFutureReferenceCount());
 
-		if(f->m_blocks.size() > f->m_cache_block_limit) {
+		// An adaptive read ahead window is not evicted before it is read, so the cache is kept one block larger than it
+		int cacheBlockLimit = f->m_max_read_ahead_blocks > f->m_min_read_ahead_blocks
+		                          ? std::max(f->m_cache_block_limit, f->m_read_ahead_blocks + 1)
+		                          : f->m_cache_block_limit;
+		if(f->m_blocks.size() > cacheBlockLimit) {
 			auto i = f->m_blocks.begin();
 			while(i != f->m_blocks.end()) {
 				if(i->second.getFutureReferenceCount() == 1) {
 					//printf("evicting block %d\n", i->first);
 					i = f->m_blocks.erase(i);
-					if(f->m_blocks.size() <= f->m_cache_block_limit)
+					if(f->m_blocks.size() <= cacheBlockLimit)
 						break;
 				}
 				else
@@ -155,6 +178,36 @@ public:
 		return wpos;
 	}
 
+	// Bytes of adaptive read ahead, above each file's readAheadBlocks, reserved by all files in this process
+	static int64_t& adaptiveReadAheadBytes() {
+		static int64_t bytes = 0;
+		return bytes;
+	}
+
+	void adaptReadAhead(bool stalled) {
+		if (m_max_read_ahead_blocks <= m_min_read_ahead_blocks) {
+			return;
+		}
+
+		int target;
+		if (stalled) {
+			target = std::max(1, m_read_ahead_blocks * 2);
+		} else {
+			// Enough blocks in flight to cover one block latency at the rate blocks are being fetched, plus one
+			double bdp = m_fetched.smoothRate() * m_block_latency / m_block_size;
+			target = std::min<int>(m_read_ahead_blocks, std::ceil(bdp) + 1);
+		}
+		target = std::max(m_min_read_ahead_blocks, std::min(m_max_read_ahead_blocks, target));
+
+		int64_t& reserved = adaptiveReadAheadBytes();
+		if (target > m_read_ahead_blocks) {
+			int64_t available = FLOW_KNOBS->READ_AHEAD_ADAPTIVE_MAX_BYTES - reserved;
+			target = std::min<int64_t>(target, m_read_ahead_blocks + std::max<int64_t>(0, available / m_block_size));
+		}
+		reserved += (int64_t)(target - m_read_ahead_blocks) * m_block_size;
+		m_read_ahead_blocks = target;
+	}
+
 	Future<int> read(void* data, int length, int64_t offset) override {
 		return read_impl(Reference<AsyncFileReadAheadCache>::addRef(this), data, length, offset);
 	}
@@ -181,21 +234,34 @@ public:
 		for(auto &it : m_blocks) {
 			it.second.cancel();
 		}
+		adaptiveReadAheadBytes() -= (int64_t)(m_read_ahead_blocks - m_min_read_ahead_blocks) * m_block_size;
 	}
 
 	Reference<IAsyncFile> m_f;
 	int m_block_size;
-	int m_read_ahead_blocks;
+	int m_read_ahead_blocks; // The current read ahead window
+	int m_min_read_ahead_blocks;
+	int m_max_read_ahead_blocks;
 	int m_cache_block_limit;
 	FlowLock m_max_concurrent_reads;
 
+	Smoother m_fetched; // Bytes read from the underlying file
+	double m_block_latency; // Moving average of the time to read one block, or 0 before the first read
+	int m_last_block_read;
+
 	// Map block numbers to future
 	std::map<int, Future<Reference<CacheBlock>>> m_blocks;
 
-	AsyncFileReadAheadCache(Reference<IAsyncFile> f, int blockSize, int readAheadBlocks, int maxConcurrentReads, int cacheSizeBlocks)
-		: m_f(f), m_block_size(blockSize), m_read_ahead_blocks(readAheadBlocks), m_max_concurrent_reads(maxConcurrentReads),
-		  m_cache_block_limit(std::max<int>(1, cacheSizeBlocks)) {
-	}
+	// When the window adapts it also bounds the reads in flight, so maxConcurrentReads is raised to cover it
+	AsyncFileReadAheadCache(Reference<IAsyncFile> f, int blockSize, int readAheadBlocks, int maxConcurrentReads,
+	                        int cacheSizeBlocks, int maxReadAheadBlocks = 0)
+	  : m_f(f), m_block_size(blockSize), m_read_ahead_blocks(readAheadBlocks), m_min_read_ahead_blocks(readAheadBlocks),
+	    m_max_read_ahead_blocks(std::max(readAheadBlocks, maxReadAheadBlocks)),
+	    m_cache_block_limit(std::max<int>(1, cacheSizeBlocks)),
+	    m_max_concurrent_reads(maxReadAheadBlocks > readAheadBlocks
+	                               ? std::max(maxConcurrentReads, maxReadAheadBlocks + 1)
+	                               : maxConcurrentReads),
+	    m_fetched(FLOW_KNOBS->READ_AHEAD_RATE_FOLDING_TIME), m_block_latency(0), m_last_block_read(-2) {}
 };
 
 #include "flow/unactorcompiler.h"
@@ -128,6 +128,17 @@ void SimpleFailureMonitor::endpointNotFound(Endpoint const& endpoint) {
 void SimpleFailureMonitor::notifyDisconnect(NetworkAddress const& address) {
 	//TraceEvent("NotifyDisconnect").detail("Address", address);
 	endpointKnownFailed.triggerRange(Endpoint({ address }, UID()), Endpoint({ address }, UID(-1, -1)));
+
+	auto trigger = disconnectTriggers.find(address);
+	if (trigger != disconnectTriggers.end()) {
+		Promise<Void> p = trigger->second;
+		disconnectTriggers.erase(trigger);
+		p.send(Void());
+	}
+}
+
+Future<Void> SimpleFailureMonitor::onDisconnect(NetworkAddress const& address) {
+	return disconnectTriggers[address].getFuture();
 }
 
 Future<Void> SimpleFailureMonitor::onDisconnectOrFailure(Endpoint const& endpoint) {
@@ -101,6 +101,9 @@ public:
 	// Returns when onFailed(endpoint) || transport().onDisconnect( endpoint.getPrimaryAddress() ), but more efficiently
 	virtual Future<Void> onDisconnectOrFailure(Endpoint const& endpoint) = 0;
 
+	// Returns when the next time the connection to address closes, i.e. when notifyDisconnect(address) is next called
+	virtual Future<Void> onDisconnect(NetworkAddress const& address) = 0;
+
 	// Returns true if the endpoint is failed but the address of the endpoint is not failed.
 	virtual bool onlyEndpointFailed(Endpoint const& endpoint) const = 0;
 
@@ -146,6 +149,7 @@ public:
 	FailureStatus getState(Endpoint const& endpoint) const override;
 	FailureStatus getState(NetworkAddress const& address) const override;
 	Future<Void> onDisconnectOrFailure(Endpoint const& endpoint) override;
+	Future<Void> onDisconnect(NetworkAddress const& address) override;
 	bool onlyEndpointFailed(Endpoint const& endpoint) const override;
 	bool permanentlyFailed(Endpoint const& endpoint) const override;
 
@@ -155,6 +159,7 @@ private:
 	std::unordered_map<NetworkAddress, FailureStatus> addressStatus;
 	YieldedAsyncMap<Endpoint, bool> endpointKnownFailed;
 	std::unordered_set<Endpoint> failedEndpoints;
+	std::unordered_map<NetworkAddress, Promise<Void>> disconnectTriggers;
 
 	friend class OnStateChangedActorActor;
 };
@@ -27,6 +27,9 @@
 #if VALGRIND
 #include <memcheck.h>
 #endif
+#ifdef HAVE_ZLIB
+#include <zlib.h>
+#endif
 
 #include "flow/crc32c.h"
 #include "fdbrpc/fdbrpc.h"
@@ -48,7 +51,9 @@ static NetworkAddressList g_currentDeliveryPeerAddress = NetworkAddressList();
 
 constexpr UID WLTOKEN_ENDPOINT_NOT_FOUND(-1, 0);
 constexpr UID WLTOKEN_PING_PACKET(-1, 1);
+constexpr UID WLTOKEN_INDIRECT_PING(-1, 11);
 constexpr int PACKET_LEN_WIDTH = sizeof(uint32_t);
+constexpr uint32_t PACKET_COMPRESSED_FLAG = 1u << 31; // Set in the length of a packet whose contents are compressed
 const uint64_t TOKEN_STREAM_FLAG = 1;
 
 class EndpointMap : NonCopyable {
@@ -199,6 +204,57 @@ struct PingReceiver final : NetworkMessageReceiver {
 	}
 };
 
+struct IndirectPingReply {
+	constexpr static FileIdentifier file_identifier = 4730253;
+	bool reachable;
+
+	IndirectPingReply() : reachable(false) {}
+	explicit IndirectPingReply(bool reachable) : reachable(reachable) {}
+
+	template <class Ar>
+	void serialize(Ar& ar) {
+		serializer(ar, reachable);
+	}
+};
+
+// Asks the receiver to ping target on the sender's behalf, and to reply whether target answered
+struct IndirectPingRequest {
+	constexpr static FileIdentifier file_identifier = 4730252;
+	NetworkAddress target;
+	ReplyPromise<IndirectPingReply> reply;
+
+	IndirectPingRequest() {}
+	explicit IndirectPingRequest(NetworkAddress const& target) : target(target) {}
+
+	template <class Ar>
+	void serialize(Ar& ar) {
+		serializer(ar, target, reply);
+	}
+};
+
+ACTOR static void pingForPeer(IndirectPingRequest req) {
+	state ReplyPromise<Void> ping;
+	FlowTransport::transport().sendUnreliable(SerializeSource<ReplyPromise<Void>>(ping),
+	                                          Endpoint({ req.target }, WLTOKEN_PING_PACKET), true);
+	choose {
+		when(wait(ping.getFuture())) { req.reply.send(IndirectPingReply(true)); }
+		when(wait(delay(FLOW_KNOBS->CONNECTION_MONITOR_TIMEOUT, TaskPriority::ReadSocket))) {
+			req.reply.send(IndirectPingReply(false));
+		}
+	}
+}
+
+struct IndirectPingReceiver final : NetworkMessageReceiver {
+	IndirectPingReceiver(EndpointMap& endpoints) {
+		endpoints.insertWellKnown(this, WLTOKEN_INDIRECT_PING, TaskPriority::ReadSocket);
+	}
+	void receive(ArenaObjectReader& reader) override {
+		IndirectPingRequest req;
+		reader.deserialize(req);
+		pingForPeer(req);
+	}
+};
+
 class TransportData {
 public:
 	TransportData(uint64_t transportId);
@@ -208,6 +264,8 @@ public:
 	void initMetrics() {
 		bytesSent.init(LiteralStringRef("Net2.BytesSent"));
 		countPacketsReceived.init(LiteralStringRef("Net2.CountPacketsReceived"));
+		bytesCopiedOnReceive.init(LiteralStringRef("Net2.BytesCopiedOnReceive"));
+		bytesSavedByCompression.init(LiteralStringRef("Net2.BytesSavedByCompression"));
 		countPacketsGenerated.init(LiteralStringRef("Net2.CountPacketsGenerated"));
 		countConnEstablished.init(LiteralStringRef("Net2.CountConnEstablished"));
 		countConnClosedWithError.init(LiteralStringRef("Net2.CountConnClosedWithError"));
@@ -228,13 +286,17 @@ public:
 	std::set<NetworkAddress> orderedAddresses;
 	Reference<AsyncVar<bool>> degraded;
 	bool warnAlwaysForLargePacket;
+	uint16_t localDcHash; // Advertised in ConnectPacket, or 0 if the dcId is unknown
 
 	EndpointMap endpoints;
 	EndpointNotFoundReceiver endpointNotFoundReceiver{ endpoints };
 	PingReceiver pingReceiver{ endpoints };
+	IndirectPingReceiver indirectPingReceiver{ endpoints };
 
 	Int64MetricHandle bytesSent;
 	Int64MetricHandle countPacketsReceived;
+	Int64MetricHandle bytesCopiedOnReceive;
+	Int64MetricHandle bytesSavedByCompression;
 	Int64MetricHandle countPacketsGenerated;
 	Int64MetricHandle countConnEstablished;
 	Int64MetricHandle countConnClosedWithError;
@@ -280,6 +342,9 @@ ACTOR Future<Void> pingLatencyLogger(TransportData* self) {
 				    .detail("Count", peer->pingLatencies.getPopulationSize())
 				    .detail("BytesReceived", peer->bytesReceived - peer->lastLoggedBytesReceived)
 				    .detail("BytesSent", peer->bytesSent - peer->lastLoggedBytesSent)
+				    .detail("PacketsQueued", peer->packetsQueued)
+				    .detail("WriteCalls", peer->writeCalls)
+				    .detail("WriteCallsPerPacket", peer->packetsQueued ? (double)peer->writeCalls / peer->packetsQueued : 0.0)
 				    .detail("ConnectOutgoingCount", peer->connectOutgoingCount)
 				    .detail("ConnectIncomingCount", peer->connectIncomingCount)
 				    .detail("ConnectFailedCount", peer->connectFailedCount)
@@ -292,6 +357,8 @@ ACTOR Future<Void> pingLatencyLogger(TransportData* self) {
 				peer->connectOutgoingCount = 0;
 				peer->connectIncomingCount = 0;
 				peer->connectFailedCount = 0;
+				peer->packetsQueued = 0;
+				peer->writeCalls = 0;
 				peer->pingLatencies.clear();
 				peer->connectLatencies.clear();
 				peer->lastLoggedBytesReceived = peer->bytesReceived;
@@ -307,10 +374,12 @@ ACTOR Future<Void> pingLatencyLogger(TransportData* self) {
 }
 
 TransportData::TransportData(uint64_t transportId)
-	  : endpoints(/*wellKnownTokenCount*/ 11),
+	  : endpoints(/*wellKnownTokenCount*/ 12),
 	  	endpointNotFoundReceiver(endpoints),
 		pingReceiver(endpoints),
+		indirectPingReceiver(endpoints),
 		warnAlwaysForLargePacket(true),
+		localDcHash(0),
 		lastIncompatibleMessage(0),
 		transportId(transportId),
 		numIncompatibleConnections(0)
@@ -335,8 +404,11 @@ struct ConnectPacket {
 	 // IP Address to reconnect to the originating process. Only one of these must be populated.
 	uint32_t canonicalRemoteIp4;
 
+	// Older peers ignore every flag but FLAG_IPV6.  The bits above FLAG_COMPRESSION hold a hash of the sender's dcId.
 	enum ConnectPacketFlags {
-		  FLAG_IPV6 = 1
+		  FLAG_IPV6 = 1,
+		  FLAG_COMPRESSION = 2, // The sender can decompress packets sent with PACKET_COMPRESSED_FLAG
+		  DC_HASH_SHIFT = 2
 	};
 	uint16_t flags;
 	uint8_t canonicalRemoteIp6[16];
@@ -367,6 +439,10 @@ struct ConnectPacket {
 
 	bool isIPv6() const { return flags & FLAG_IPV6; }
 
+	void setCompression(uint16_t dcHash) { flags = (flags & FLAG_IPV6) | FLAG_COMPRESSION | (dcHash << DC_HASH_SHIFT); }
+	bool acceptsCompression() const { return flags & FLAG_COMPRESSION; }
+	uint16_t dcHash() const { return flags >> DC_HASH_SHIFT; }
+
 	uint32_t totalPacketSize() const { return connectPacketLength + sizeof(connectPacketLength); }
 
 	template <class Ar>
@@ -391,6 +467,30 @@ struct ConnectPacket {
 
 #pragma pack( pop )
 
+// 14 bits of a dcId for ConnectPacket, never 0, which stands for a process with no dcId
+static uint16_t dcHashOf(Optional<Standalone<StringRef>> const& dcId) {
+	if (!dcId.present()) return 0;
+	uint16_t hash = crc32c_append(0, dcId.get().begin(), dcId.get().size()) & 0x3fff;
+	return hash ? hash : 1;
+}
+
+// Whether to compress packets sent to the process that sent pkt.  Data centers whose hashes collide are treated as one.
+static bool shouldCompressTo(TransportData* transport, ConnectPacket const& pkt) {
+#ifdef HAVE_ZLIB
+	if (!pkt.acceptsCompression()) return false;
+	switch (FLOW_KNOBS->WIRE_COMPRESSION) {
+	case 1:
+		return transport->localDcHash && pkt.dcHash() && transport->localDcHash != pkt.dcHash();
+	case 2:
+		return true;
+	default:
+		return false;
+	}
+#else
+	return false;
+#endif
+}
+
 ACTOR static Future<Void> connectionReader(TransportData* transport, Reference<IConnection> conn, Reference<struct Peer> peer,
                                            Promise<Reference<struct Peer>> onConnected);
 
@@ -399,6 +499,7 @@ static ReliablePacket* sendPacket( TransportData* self, Reference<Peer> peer, IS
 
 ACTOR Future<Void> connectionMonitor( Reference<Peer> peer ) {
 	state Endpoint remotePingEndpoint({ peer->destination }, WLTOKEN_PING_PACKET);
+	state int64_t lastCycleBytesReceived = -1;
 	loop {
 		if (!FlowTransport::isClient() && !peer->destination.isPublic() && peer->compatible) {
 			// Don't send ping messages to clients unless necessary. Instead monitor incoming client pings.
@@ -424,7 +525,7 @@ ACTOR Future<Void> connectionMonitor( Reference<Peer> peer ) {
 		//because then it would not call the destructor of connectionReader when connectionReader is cancelled.
 		wait(delay(0, TaskPriority::ReadSocket));
 
-		if (peer->reliable.empty() && peer->unsent.empty() && peer->outstandingReplies==0) {
+		if (peer->reliable.empty() && peer->unsentEmpty() && peer->outstandingReplies==0) {
 			if (peer->peerReferences == 0 &&
 					(peer->lastDataPacketSentTime < now() - FLOW_KNOBS->CONNECTION_MONITOR_UNREFERENCED_CLOSE_DELAY)) {
 				// TODO: What about when peerReference == -1?
@@ -439,6 +540,15 @@ ACTOR Future<Void> connectionMonitor( Reference<Peer> peer ) {
 
 		wait (delayJittered(FLOW_KNOBS->CONNECTION_MONITOR_LOOP_TIME, TaskPriority::ReadSocket));
 
+		if (FLOW_KNOBS->CONNECTION_MONITOR_SKIP_BUSY_PINGS && peer->compatible && peer->destination.isPublic() &&
+		    peer->bytesReceived != lastCycleBytesReceived && lastCycleBytesReceived >= 0) {
+			// Anything received since the last cycle already shows the connection is alive, just as it would end a
+			// ping timeout below, so only links that have gone quiet are pinged. Clients are left alone, since the
+			// ping is how their idle connections are checked after the loop above.
+			lastCycleBytesReceived = peer->bytesReceived;
+			continue;
+		}
+
 		// TODO: Stop monitoring and close the connection with no onDisconnect requests outstanding
 		state ReplyPromise<Void> reply;
 		FlowTransport::transport().sendUnreliable( SerializeSource<ReplyPromise<Void>>(reply), remotePingEndpoint, true );
@@ -475,6 +585,7 @@ ACTOR Future<Void> connectionMonitor( Reference<Peer> peer ) {
 				}
 			}
 		}
+		lastCycleBytesReceived = peer->bytesReceived;
 	}
 }
 
@@ -482,7 +593,13 @@ ACTOR Future<Void> connectionWriter( Reference<Peer> self, Reference<IConnection
 	state double lastWriteTime = now();
 	loop {
 		//wait( delay(0, TaskPriority::WriteSocket) );
-		wait( delayJittered(std::max<double>(FLOW_KNOBS->MIN_COALESCE_DELAY, FLOW_KNOBS->MAX_COALESCE_DELAY - (now() - lastWriteTime)), TaskPriority::WriteSocket) );
+		state double coalesceDelay = std::max<double>(FLOW_KNOBS->MIN_COALESCE_DELAY, FLOW_KNOBS->MAX_COALESCE_DELAY - (now() - lastWriteTime));
+		// Under a steady stream of small packets (GRV and point read replies, say) hold writes back a little longer, so
+		// that each write call gathers more of them
+		if (self->bytesPerWrite < FLOW_KNOBS->ADAPTIVE_COALESCE_BYTES) {
+			coalesceDelay = std::max(coalesceDelay, FLOW_KNOBS->MAX_ADAPTIVE_COALESCE_DELAY - (now() - lastWriteTime));
+		}
+		wait( delayJittered(coalesceDelay, TaskPriority::WriteSocket) );
 		//wait( delay(500e-6, TaskPriority::WriteSocket) );
 		//wait( yield(TaskPriority::WriteSocket) );
 
@@ -490,24 +607,50 @@ ACTOR Future<Void> connectionWriter( Reference<Peer> self, Reference<IConnection
 		loop {
 			lastWriteTime = now();
 
-			int sent = conn->write(self->unsent.getUnsent(), /* limit= */ FLOW_KNOBS->MAX_PACKET_SEND_BYTES);
+			// Bulk packets go out only when nothing else is waiting, but one that has been started must be finished
+			// before anything else can be sent.
+			bool fromBulk = self->bulkPacketRemaining > 0 || (self->unsent.empty() && !self->unsentBulk.empty());
+			int sent;
+			if (fromBulk) {
+				if (self->bulkPacketRemaining == 0) {
+					ASSERT(!self->bulkPackets.empty());
+					self->bulkPacketRemaining = self->bulkPackets.front().first;
+					self->bulkPackets.pop_front();
+				}
+				sent = conn->write(self->unsentBulk.getUnsent(),
+				                   /* limit= */ std::min(FLOW_KNOBS->MAX_PACKET_SEND_BYTES, self->bulkPacketRemaining));
+			} else {
+				sent = conn->write(self->unsent.getUnsent(), /* limit= */ FLOW_KNOBS->MAX_PACKET_SEND_BYTES);
+			}
+			++self->writeCalls;
+			self->bytesPerWrite = 0.9 * self->bytesPerWrite + 0.1 * sent;
 			if (sent) {
 				self->bytesSent += sent;
 				self->transport->bytesSent += sent;
-				self->unsent.sent(sent);
+				if (fromBulk) {
+					self->unsentBulk.sent(sent);
+					self->bulkPacketRemaining -= sent;
+				} else {
+					self->unsent.sent(sent);
+				}
 			}
 
-			if (self->unsent.empty()) {
+			if (self->unsentEmpty()) {
 				break;
 			}
 
+			// Moving between the queues is not a sign of a full write buffer
+			if (fromBulk ? self->bulkPacketRemaining == 0 : self->unsent.empty()) {
+				continue;
+			}
+
 			TEST(true); // We didn't write everything, so apparently the write buffer is full.  Wait for it to be nonfull.
 			wait( conn->onWritable() );
 			wait( yield(TaskPriority::WriteSocket) );
 		}
 
 		// Wait until there is something to send
-		while ( self->unsent.empty() )
+		while ( self->unsentEmpty() )
 			wait( self->dataToSend.onTrigger() );
 	}
 }
@@ -542,6 +685,55 @@ ACTOR Future<Void> delayedHealthUpdate(NetworkAddress address) {
 	return Void();
 }
 
+// SWIM-style indirect probe: when the connection to a server fails, ask a few other servers that we are connected to
+// whether they can still reach it. If every one that answers cannot, the peer is marked failed now rather than after
+// FAILURE_DETECTION_DELAY. If any one can, only the path from here is at fault and the usual delay applies.
+ACTOR Future<Void> indirectProbe(Reference<Peer> self) {
+	state std::vector<Future<IndirectPingReply>> replies;
+	state double startTime = now();
+	std::vector<NetworkAddress> helpers;
+	for (auto& it : self->transport->peers) {
+		Reference<Peer> const& p = it.second;
+		if (p != self && p->destination.isPublic() && p->compatible && !p->outgoingConnectionIdle &&
+		    IFailureMonitor::failureMonitor().getState(p->destination).isAvailable()) {
+			helpers.push_back(p->destination);
+		}
+	}
+	deterministicRandom()->randomShuffle(helpers);
+	for (int i = 0; i < helpers.size() && i < FLOW_KNOBS->INDIRECT_PING_PROBES; i++) {
+		IndirectPingRequest req(self->destination);
+		replies.push_back(req.reply.getFuture());
+		FlowTransport::transport().sendUnreliable(SerializeSource<IndirectPingRequest>(req),
+		                                          Endpoint({ helpers[i] }, WLTOKEN_INDIRECT_PING), false);
+	}
+	if (replies.empty()) {
+		return Void();
+	}
+
+	wait(waitForAllReady(replies) || delay(FLOW_KNOBS->INDIRECT_PING_TIMEOUT, TaskPriority::ReadSocket));
+
+	int unreachable = 0;
+	for (auto& r : replies) {
+		if (r.isReady() && !r.isError()) {
+			if (r.get().reachable) {
+				TraceEvent("IndirectProbeReachable").suppressFor(1.0).detail("PeerAddr", self->destination);
+				return Void();
+			}
+			++unreachable;
+		}
+	}
+	if (unreachable > 0) {
+		TraceEvent("IndirectProbeMarkFailed")
+		    .suppressFor(1.0)
+		    .detail("PeerAddr", self->destination)
+		    .detail("Probes", replies.size())
+		    .detail("Unreachable", unreachable)
+		    .detail("Elapsed", now() - startTime);
+		IFailureMonitor::failureMonitor().setStatus(self->destination, FailureStatus(true));
+	}
+	return Void();
+}
+
 ACTOR Future<Void> connectionKeeper( Reference<Peer> self,
 		Reference<IConnection> conn = Reference<IConnection>(),
 		Future<Void> reader = Void()) {
@@ -551,6 +743,7 @@ ACTOR Future<Void> connectionKeeper( Reference<Peer> self,
 	ASSERT_WE_THINK(FlowTransport::transport().getLocalAddress() != self->destination);
 
 	state Future<Void> delayedHealthUpdateF;
+	state Future<Void> indirectProbeF;
 	state Optional<double> firstConnFailedTime = Optional<double>();
 	state int retryConnect = false;
 
@@ -561,7 +754,7 @@ ACTOR Future<Void> connectionKeeper( Reference<Peer> self,
 			if (!conn) {  // Always, except for the first loop with an incoming connection
 				self->outgoingConnectionIdle = true;
 				// Wait until there is something to send.
-				while (self->unsent.empty()) {
+				while (self->unsentEmpty()) {
 					// Override waiting, if we are in failed state to update failure monitoring status.
 					Future<Void> retryConnectF = Never();
 					if (retryConnect) {
@@ -598,11 +791,12 @@ ACTOR Future<Void> connectionKeeper( Reference<Peer> self,
 						         wait(INetworkConnections::net()->connect(self->destination))) {
 							conn = _conn;
 							wait(conn->connectHandshake());
+							indirectProbeF = Future<Void>();
 							self->connectLatencies.addSample(now() - self->lastConnectTime);
 							if (FlowTransport::isClient()) {
 								IFailureMonitor::failureMonitor().setStatus(self->destination, FailureStatus(false));
 							}
-							if (self->unsent.empty()) {
+							if (self->unsentEmpty()) {
 								delayedHealthUpdateF = delayedHealthUpdate(self->destination);
 								choose {
 									when(wait(delayedHealthUpdateF)) {
@@ -642,6 +836,7 @@ ACTOR Future<Void> connectionKeeper( Reference<Peer> self,
 			}
 
 			firstConnFailedTime.reset();
+			indirectProbeF = Future<Void>();
 			try {
 				self->transport->countConnEstablished++;
 				if (!delayedHealthUpdateF.isValid())
@@ -687,9 +882,16 @@ ACTOR Future<Void> connectionKeeper( Reference<Peer> self,
 					IFailureMonitor::failureMonitor().setStatus(self->destination, FailureStatus(true));
 				} else if (now() - firstConnFailedTime.get() > FLOW_KNOBS->FAILURE_DETECTION_DELAY) {
 					IFailureMonitor::failureMonitor().setStatus(self->destination, FailureStatus(true));
+				} else if (FLOW_KNOBS->INDIRECT_PING_PROBES > 0 && !FlowTransport::isClient() &&
+				           !indirectProbeF.isValid() &&
+				           IFailureMonitor::failureMonitor().getState(self->destination).isAvailable()) {
+					// Cancelled once a connection is made again, so a late verdict can't fail a recovered peer
+					indirectProbeF = indirectProbe(self);
 				}
 			}
 
+			// Compressed packets are never reliable, so none outlive the connection they were negotiated on
+			self->compressSends = false;
 			self->discardUnreliablePackets();
 			reader = Future<Void>();
 			bool ok = e.code() == error_code_connection_failed || e.code() == error_code_actor_cancelled ||
@@ -741,7 +943,7 @@ ACTOR Future<Void> connectionKeeper( Reference<Peer> self,
 			if (e.code() == error_code_actor_cancelled) throw;
 			// Try to recover, even from serious errors, by retrying
 
-			if(self->peerReferences <= 0 && self->reliable.empty() && self->unsent.empty() && self->outstandingReplies==0) {
+			if(self->peerReferences <= 0 && self->reliable.empty() && self->unsentEmpty() && self->outstandingReplies==0) {
 				TraceEvent("PeerDestroy").error(e).suppressFor(1.0).detail("PeerAddr", self->destination);
 				self->connect.cancel();
 				self->transport->peers.erase(self->destination);
@@ -755,9 +957,9 @@ ACTOR Future<Void> connectionKeeper( Reference<Peer> self,
 Peer::Peer(TransportData* transport, NetworkAddress const& destination)
   : transport(transport), destination(destination), outgoingConnectionIdle(true), lastConnectTime(0.0),
     reconnectionDelay(FLOW_KNOBS->INITIAL_RECONNECTION_TIME), compatible(true), outstandingReplies(0),
-    incompatibleProtocolVersionNewer(false), peerReferences(-1), bytesReceived(0), lastDataPacketSentTime(now()),
+    incompatibleProtocolVersionNewer(false), compressSends(false), peerReferences(-1), bytesReceived(0), lastDataPacketSentTime(now()),
     pingLatencies(destination.isPublic() ? FLOW_KNOBS->PING_SAMPLE_AMOUNT : 1), lastLoggedBytesReceived(0),
-    bytesSent(0), lastLoggedBytesSent(0), lastLoggedTime(0.0), connectOutgoingCount(0), connectIncomingCount(0),
+    bytesSent(0), lastLoggedBytesSent(0), bytesPerWrite(0), bulkPacketRemaining(0), packetsQueued(0), writeCalls(0), lastLoggedTime(0.0), connectOutgoingCount(0), connectIncomingCount(0),
 	connectFailedCount(0), connectLatencies(destination.isPublic() ? FLOW_KNOBS->NETWORK_CONNECT_SAMPLE_AMOUNT : 1) {
 	IFailureMonitor::failureMonitor().setStatus(destination, FailureStatus(false));
 }
@@ -768,6 +970,43 @@ void Peer::send(PacketBuffer* pb, ReliablePacket* rp, bool firstUnsent) {
 	if (firstUnsent) dataToSend.trigger();
 }
 
+void Peer::sendBulk(PacketBuffer* first, int offset, int size, UID token, bool firstUnsent) {
+	// The part of the packet in first, the last buffer of unsent, is copied to a buffer of its own, and unsent is
+	// cut back to end where the packet began.  The buffers after first hold only this packet, so they are moved.
+	PacketBuffer* head = first->nextPacketBuffer();
+	PacketBuffer* tail = first->nextPacketBuffer();
+	while (tail != nullptr && tail->nextPacketBuffer() != nullptr) {
+		tail = tail->nextPacketBuffer();
+	}
+	int inFirst = first->bytes_written - offset;
+	if (inFirst > 0) {
+		PacketBuffer* copy = PacketBuffer::create(inFirst);
+		memcpy(copy->data(), first->data() + offset, inFirst);
+		copy->bytes_written = inFirst;
+		copy->next = head;
+		if (tail == nullptr) {
+			tail = copy;
+		}
+		head = copy;
+	}
+	first->next = nullptr;
+	first->bytes_written = offset;
+
+	ASSERT(head != nullptr);
+	unsentBulk.appendWriteBuffer(head, tail);
+	bulkPackets.emplace_back(size, token);
+	if (firstUnsent) dataToSend.trigger();
+}
+
+bool Peer::hasBulkPacketTo(UID token) const {
+	for (auto& p : bulkPackets) {
+		if (p.second == token) {
+			return true;
+		}
+	}
+	return false;
+}
+
 void Peer::prependConnectPacket() {
 	// Send the ConnectPacket expected at the beginning of a new connection
 	ConnectPacket pkt;
@@ -787,16 +1026,28 @@ void Peer::prependConnectPacket() {
 	pkt.protocolVersion = g_network->protocolVersion();
 	pkt.protocolVersion.addObjectSerializerFlag();
 	pkt.connectionId = transport->transportId;
+#ifdef HAVE_ZLIB
+	pkt.setCompression(transport->localDcHash);
+#endif
 
 	PacketBuffer* pb_first = PacketBuffer::create();
 	PacketWriter wr( pb_first, nullptr, Unversioned() );
 	pkt.serialize(wr);
 	unsent.prependWriteBuffer(pb_first, wr.finish());
+
+	// The rest of a bulk packet that was partly sent on the previous connection would be garbage on this one
+	if (bulkPacketRemaining > 0) {
+		unsentBulk.sent(bulkPacketRemaining);
+		bulkPacketRemaining = 0;
+	}
 }
 
 void Peer::discardUnreliablePackets() {
 	// Throw away the current unsent list, dropping the reference count on each PacketBuffer that accounts for presence in the unsent list
 	unsent.discardAll();
+	unsentBulk.discardAll();
+	bulkPackets.clear();
+	bulkPacketRemaining = 0;
 
 	// If there are reliable packets, compact reliable packets into a new unsent range
 	if(!reliable.empty()) {
@@ -905,6 +1156,33 @@ ACTOR static void deliver(TransportData* self, Endpoint destination, ArenaReader
 		g_network->setCurrentTask( TaskPriority::ReadSocket );
 }
 
+// Inflates the contents of a packet sent with PACKET_COMPRESSED_FLAG, which are the length of the uncompressed packet
+// followed by a zlib stream, into a new buffer in arena
+static StringRef decompressPacket(const uint8_t* p, uint32_t packetLen, Arena& arena, NetworkAddress const& peerAddress) {
+#ifdef HAVE_ZLIB
+	uint32_t rawLen = 0;
+	if (packetLen >= sizeof(rawLen)) {
+		memcpy(&rawLen, p, sizeof(rawLen));
+	}
+	if (rawLen < sizeof(UID) || rawLen > FLOW_KNOBS->PACKET_LIMIT) {
+		TraceEvent(SevError, "CompressedPacketInvalid").detail("FromPeer", peerAddress.toString()).detail("Length", (int)packetLen).detail("UncompressedLength", rawLen);
+		throw platform_error();
+	}
+	uint8_t* raw = new (arena) uint8_t[rawLen];
+	uLongf inflatedLen = rawLen;
+	int rc = uncompress(raw, &inflatedLen, p + sizeof(rawLen), packetLen - sizeof(rawLen));
+	if (rc != Z_OK || inflatedLen != rawLen) {
+		TraceEvent(SevError, "CompressedPacketInvalid").detail("FromPeer", peerAddress.toString()).detail("Length", (int)packetLen).detail("UncompressedLength", rawLen).detail("ZlibResult", rc);
+		throw platform_error();
+	}
+	return StringRef(raw, rawLen);
+#else
+	// We never advertise FLAG_COMPRESSION without zlib
+	TraceEvent(SevError, "CompressedPacketUnsupported").detail("FromPeer", peerAddress.toString()).detail("Length", (int)packetLen);
+	throw platform_error();
+#endif
+}
+
 static void scanPackets(TransportData* transport, uint8_t*& unprocessed_begin, const uint8_t* e, Arena& arena,
                         NetworkAddress const& peerAddress, ProtocolVersion peerProtocolVersion) {
 	// Find each complete packet in the given byte range and queue a ready task to deliver it.
@@ -926,13 +1204,15 @@ static void scanPackets(TransportData* transport, uint8_t*& unprocessed_begin, c
 			packetLen = *(uint32_t*)p; p += PACKET_LEN_WIDTH;
 		}
 
+		const bool compressed = packetLen & PACKET_COMPRESSED_FLAG;
+		packetLen &= ~PACKET_COMPRESSED_FLAG;
 		if (packetLen > FLOW_KNOBS->PACKET_LIMIT) {
 			TraceEvent(SevError, "PacketLimitExceeded").detail("FromPeer", peerAddress.toString()).detail("Length", (int)packetLen);
 			throw platform_error();
 		}
 
 		if (e-p<packetLen) break;
-		ASSERT( packetLen >= sizeof(UID) );
+		ASSERT( compressed || packetLen >= sizeof(UID) );
 
 		if (checksumEnabled) {
 			bool isBuggifyEnabled = false;
@@ -976,7 +1256,13 @@ static void scanPackets(TransportData* transport, uint8_t*& unprocessed_begin, c
 #endif
 		// remove object serializer flag to account for flat buffer
 		peerProtocolVersion.removeObjectSerializerFlag();
-		ArenaReader reader(arena, StringRef(p, packetLen), AssumeVersion(peerProtocolVersion));
+		Arena packetArena = arena;
+		StringRef packet(p, packetLen);
+		if (compressed) {
+			packetArena = Arena();
+			packet = decompressPacket(p, packetLen, packetArena, peerAddress);
+		}
+		ArenaReader reader(packetArena, packet, AssumeVersion(peerProtocolVersion));
 		UID token;
 		reader >> token;
 
@@ -1008,7 +1294,7 @@ static int getNewBufferSize(const uint8_t* begin, const uint8_t* end, const Netw
 	if (len < PACKET_LEN_WIDTH) {
 		return FLOW_KNOBS->MIN_PACKET_BUFFER_BYTES;
 	}
-	const uint32_t packetLen = *(uint32_t*)begin;
+	const uint32_t packetLen = *(uint32_t*)begin & ~PACKET_COMPRESSED_FLAG;
 	if (packetLen > FLOW_KNOBS->PACKET_LIMIT) {
 		TraceEvent(SevError, "PacketLimitExceeded").detail("FromPeer", peerAddress.toString()).detail("Length", (int)packetLen);
 		throw platform_error();
@@ -1034,6 +1320,7 @@ ACTOR static Future<Void> connectionReader(
 	state bool compatible = false;
 	state bool incompatiblePeerCounted = false;
 	state bool incompatibleProtocolVersionNewer = false;
+	state bool compressSends = false;
 	state NetworkAddress peerAddress;
 	state ProtocolVersion peerProtocolVersion;
 
@@ -1045,13 +1332,21 @@ ACTOR static Future<Void> connectionReader(
 		loop {
 			loop {
 				state int readAllBytes = buffer_end - unprocessed_end;
-				if (readAllBytes < FLOW_KNOBS->MIN_PACKET_BUFFER_FREE_BYTES) {
+				// Packets are deserialized in place from this buffer, so the only copy on the receive path is the start of
+				// a packet that did not fit.  Once the next packet's length is known and it is not going to fit, move to a
+				// buffer sized for it right away rather than reading more of it here only to copy that too.
+				const bool nextPacketWontFit =
+				    !expectConnectPacket && unprocessed_end - unprocessed_begin >= PACKET_LEN_WIDTH &&
+				    getNewBufferSize(unprocessed_begin, unprocessed_end, peerAddress, peerProtocolVersion) >
+				        buffer_end - unprocessed_begin;
+				if (readAllBytes < FLOW_KNOBS->MIN_PACKET_BUFFER_FREE_BYTES || nextPacketWontFit) {
 					Arena newArena;
 					const int unproc_len = unprocessed_end - unprocessed_begin;
 					const int len = getNewBufferSize(unprocessed_begin, unprocessed_end, peerAddress, peerProtocolVersion);
 					uint8_t* const newBuffer = new (newArena) uint8_t[ len ];
 					if (unproc_len > 0) {
 						memcpy(newBuffer, unprocessed_begin, unproc_len);
+						transport->bytesCopiedOnReceive += unproc_len;
 					}
 					arena = newArena;
 					unprocessed_begin = newBuffer;
@@ -1127,6 +1422,7 @@ ACTOR static Future<Void> connectionReader(
 						if(connectionId > 1) {
 							transport->multiVersionConnections[connectionId] = now() + FLOW_KNOBS->CONNECTION_ID_TIMEOUT;
 						}
+						compressSends = compatible && shouldCompressTo(transport, pkt);
 						unprocessed_begin += connectPacketSize;
 						expectConnectPacket = false;
 
@@ -1143,6 +1439,7 @@ ACTOR static Future<Void> connectionReader(
 								incompatiblePeerCounted = true;
 							}
 							ASSERT( pkt.canonicalRemotePort == peerAddress.port );
+							peer->compressSends = compressSends;
 							onConnected.send(peer);
 						} else {
 							peerProtocolVersion = protocolVersion;
@@ -1159,6 +1456,8 @@ ACTOR static Future<Void> connectionReader(
 							}
 							onConnected.send( peer );
 							wait( delay(0) );  // Check for cancellation
+							// Not before now, since accepting this connection closed the peer's previous one
+							peer->compressSends = compressSends;
 						}
 					}
 				}
@@ -1309,6 +1608,10 @@ NetworkAddress FlowTransport::getLocalAddress() const {
 	return self->localAddresses.address;
 }
 
+void FlowTransport::setLocalDcId(Optional<Standalone<StringRef>> const& dcId) {
+	self->localDcHash = dcHashOf(dcId);
+}
+
 std::map<NetworkAddress, std::pair<uint64_t, double>>* FlowTransport::getIncompatiblePeers() {
 	for(auto it = self->incompatiblePeers.begin(); it != self->incompatiblePeers.end();) {
 		if( self->multiVersionConnections.count(it->second.first) ) {
@@ -1365,7 +1668,7 @@ void FlowTransport::removePeerReference(const Endpoint& endpoint, bool isStream)
 				.detail("Address", endpoint.getPrimaryAddress())
 				.detail("Token", endpoint.token);
 		}
-		if(peer->peerReferences == 0 && peer->reliable.empty() && peer->unsent.empty() && peer->outstandingReplies==0 && peer->lastDataPacketSentTime < now() - FLOW_KNOBS->CONNECTION_MONITOR_UNREFERENCED_CLOSE_DELAY) {
+		if(peer->peerReferences == 0 && peer->reliable.empty() && peer->unsentEmpty() && peer->outstandingReplies==0 && peer->lastDataPacketSentTime < now() - FLOW_KNOBS->CONNECTION_MONITOR_UNREFERENCED_CLOSE_DELAY) {
 			peer->resetPing.trigger();
 		}
 	}
@@ -1413,6 +1716,47 @@ static void sendLocal( TransportData* self, ISerializeSource const& what, const
 	deliver(self, destination, ArenaReader(copy.arena(), copy, AssumeVersion(g_network->protocolVersion())), false);
 }
 
+// Writes the token and message as the contents of a compressed packet if they are large enough and compress well, and
+// otherwise uncompressed.  Returns whether the packet is compressed.
+static bool writeMaybeCompressed(TransportData* self, PacketWriter& wr, UID const& token, ISerializeSource const& what) {
+	// The message has to be contiguous to compress it, so serialize it on its own first
+	ObjectWriter writer(AssumeVersion(wr.protocolVersion()));
+	what.serializeObjectWriter(writer);
+	Standalone<StringRef> message = writer.toStringRef();
+#ifdef HAVE_ZLIB
+	const uint32_t rawLen = sizeof(token) + message.size();
+	if (rawLen >= FLOW_KNOBS->WIRE_COMPRESSION_MIN_BYTES) {
+		z_stream zs;
+		memset(&zs, 0, sizeof(zs));
+		if (deflateInit(&zs, FLOW_KNOBS->WIRE_COMPRESSION_LEVEL) == Z_OK) {
+			const uLong bound = deflateBound(&zs, rawLen);
+			uint8_t* out = new (message.arena()) uint8_t[bound];
+			zs.next_out = out;
+			zs.avail_out = bound;
+			zs.next_in = (Bytef*)&token;
+			zs.avail_in = sizeof(token);
+			int rc = deflate(&zs, Z_NO_FLUSH);
+			if (rc == Z_OK) {
+				zs.next_in = (Bytef*)message.begin();
+				zs.avail_in = message.size();
+				rc = deflate(&zs, Z_FINISH);
+			}
+			const uint32_t compressedLen = sizeof(rawLen) + zs.total_out;
+			deflateEnd(&zs);
+			if (rc == Z_STREAM_END && compressedLen < rawLen) {
+				wr << rawLen;
+				wr.serializeBytes(out, zs.total_out);
+				self->bytesSavedByCompression += rawLen - compressedLen;
+				return true;
+			}
+		}
+	}
+#endif
+	wr << token;
+	wr.serializeBytes(message);
+	return false;
+}
+
 static ReliablePacket* sendPacket(TransportData* self, Reference<Peer> peer, ISerializeSource const& what,
                                   const Endpoint& destination, bool reliable) {
 	const bool checksumEnabled = !destination.getPrimaryAddress().isTLS();
@@ -1424,13 +1768,15 @@ static ReliablePacket* sendPacket(TransportData* self, Reference<Peer> peer, ISe
 		return nullptr;
 	}
 
-	bool firstUnsent = peer->unsent.empty();
+	bool firstUnsent = peer->unsentEmpty();
 
 	PacketBuffer* pb = peer->unsent.getWriteBuffer();
 	ReliablePacket* rp = reliable ? new ReliablePacket : 0;
 
 	int prevBytesWritten = pb->bytes_written;
 	PacketBuffer* checksumPb = pb;
+	PacketBuffer* const firstPb = pb;
+	const int firstOffset = pb->bytes_written;
 
 	PacketWriter wr(pb,rp,AssumeVersion(g_network->protocolVersion()));  // SOMEDAY: Can we downgrade to talk to older peers?
 
@@ -1443,8 +1789,13 @@ static ReliablePacket* sendPacket(TransportData* self, Reference<Peer> peer, ISe
 	}
 
 	wr.writeAhead(packetInfoSize , &packetInfoBuffer);
-	wr << destination.token;
-	what.serializePacketWriter(wr);
+	bool compressed = false;
+	if (peer->compressSends && !reliable) {
+		compressed = writeMaybeCompressed(self, wr, destination.token, what);
+	} else {
+		wr << destination.token;
+		what.serializePacketWriter(wr);
+	}
 	pb = wr.finish();
 	len = wr.size() - packetInfoSize;
 
@@ -1469,7 +1820,8 @@ static ReliablePacket* sendPacket(TransportData* self, Reference<Peer> peer, ISe
 	}
 
 	// Write packet length and checksum into packet buffer
-	packetInfoBuffer.write(&len, sizeof(len));
+	const uint32_t lenAndFlags = compressed ? len | PACKET_COMPRESSED_FLAG : len;
+	packetInfoBuffer.write(&lenAndFlags, sizeof(lenAndFlags));
 	if (checksumEnabled) {
 		packetInfoBuffer.write(&checksum, sizeof(checksum), sizeof(len));
 	}
@@ -1500,7 +1852,14 @@ static ReliablePacket* sendPacket(TransportData* self, Reference<Peer> peer, ISe
 	}
 #endif
 
-	peer->send(pb, rp, firstUnsent);
+	if (!reliable && FLOW_KNOBS->BULK_PACKET_BYTES > 0 &&
+	    (len >= FLOW_KNOBS->BULK_PACKET_BYTES || peer->hasBulkPacketTo(destination.token))) {
+		TEST(true); // Packet sent in the bulk lane
+		peer->sendBulk(firstPb, firstOffset, packetInfoSize + len, destination.token, firstUnsent);
+	} else {
+		peer->send(pb, rp, firstUnsent);
+	}
+	++peer->packetsQueued;
 	if (destination.token != WLTOKEN_PING_PACKET) {
 		peer->lastDataPacketSentTime = now();
 	}
@@ -140,8 +140,13 @@ struct Peer : public ReferenceCounted<Peer> {
 	TransportData* transport;
 	NetworkAddress destination;
 	UnsentPacketQueue unsent;
+	// Large unreliable packets, which connectionWriter sends only when unsent is empty, so that they don't hold up
+	// the small packets queued after them.  See FLOW_KNOBS->BULK_PACKET_BYTES.
+	UnsentPacketQueue unsentBulk;
+	std::deque<std::pair<int, UID>> bulkPackets; // Size and token of each packet in unsentBulk not yet started
+	int bulkPacketRemaining; // Bytes of the packet connectionWriter is sending from unsentBulk, which it must finish first
 	ReliablePacketList reliable;
-	AsyncTrigger dataToSend;  // Triggered when unsent.empty() becomes false
+	AsyncTrigger dataToSend;  // Triggered when unsentEmpty() becomes false
 	Future<Void> connect;
 	AsyncTrigger resetPing;
 	AsyncTrigger resetConnection;
@@ -151,6 +156,7 @@ struct Peer : public ReferenceCounted<Peer> {
 	double reconnectionDelay;
 	int peerReferences;
 	bool incompatibleProtocolVersionNewer;
+	bool compressSends; // Unreliable packets may be sent compressed, as negotiated by the peer's ConnectPacket on the current connection
 	int64_t bytesReceived;
 	int64_t bytesSent;
 	double lastDataPacketSentTime;
@@ -159,7 +165,10 @@ struct Peer : public ReferenceCounted<Peer> {
 	double lastLoggedTime;
 	int64_t lastLoggedBytesReceived;
 	int64_t lastLoggedBytesSent;
+	double bytesPerWrite; // Moving average of the bytes each connectionWriter write call sent
 	// Cleared every time stats are logged for this peer.
+	int packetsQueued;
+	int writeCalls;
 	int connectOutgoingCount;
 	int connectIncomingCount;
 	int connectFailedCount;
@@ -167,8 +176,17 @@ struct Peer : public ReferenceCounted<Peer> {
 
 	explicit Peer(TransportData* transport, NetworkAddress const& destination);
 
+	bool unsentEmpty() const { return unsent.empty() && unsentBulk.empty(); }
+
 	void send(PacketBuffer* pb, ReliablePacket* rp, bool firstUnsent);
 
+	// Move the unreliable packet of size bytes that was just written to the end of unsent, starting at offset in
+	// first, to the end of unsentBulk
+	void sendBulk(PacketBuffer* first, int offset, int size, UID token, bool firstUnsent);
+
+	// True if a packet to token is waiting in unsentBulk, so that later packets to it must follow it there
+	bool hasBulkPacketTo(UID token) const;
+
 	void prependConnectPacket();
 
 	void discardUnreliablePackets();
@@ -200,6 +218,10 @@ public:
 	NetworkAddressList getLocalAddresses() const;
 	// Returns all local NetworkAddress.
 
+	void setLocalDcId(Optional<Standalone<StringRef>> const& dcId);
+	// Connections opened from now on advertise dcId, so that peers in other data centers know to compress packets
+	// sent to this process when FLOW_KNOBS->WIRE_COMPRESSION is 1
+
 	std::map<NetworkAddress, std::pair<uint64_t, double>>* getIncompatiblePeers();
 	// Returns the same of all peers that have attempted to connect, but have incompatible protocol versions
 
@@ -77,10 +77,12 @@ Optional<LoadBalancedReply> getLoadBalancedReply(const LoadBalancedReply *reply)
 Optional<LoadBalancedReply> getLoadBalancedReply(const void*);
 
 // Returns true if we got a value for our request
-// Throws an error if the request returned an error that should bubble out
+// Returns an error if the request returned an error that should bubble out
 // Returns false if we got an error that should result in reissuing the request
+// Errors are returned rather than thrown so that the calling actor passes them on without unwinding the stack, which
+// matters when many requests fail at once (such as with wrong_shard_server while shards move)
 template <class T>
-bool checkAndProcessResult(ErrorOr<T> result, Reference<ModelHolder> holder, bool atMostOnce, bool triedAllOptions) {
+ErrorOr<bool> checkAndProcessResult(ErrorOr<T> result, Reference<ModelHolder> holder, bool atMostOnce, bool triedAllOptions) {
 	Optional<LoadBalancedReply> loadBalancedReply;
 	if(!result.isError()) {
 		loadBalancedReply = getLoadBalancedReply(&result.get());
@@ -115,15 +117,15 @@ bool checkAndProcessResult(ErrorOr<T> result, Reference<ModelHolder> holder, boo
 	}
 
 	if(receivedResponse) {
-		throw loadBalancedReply.present() ? loadBalancedReply.get().error.get() : result.getError();
+		return loadBalancedReply.present() ? loadBalancedReply.get().error.get() : result.getError();
 	}
 
 	if(atMostOnce && maybeDelivered) {
-		throw request_maybe_delivered();
+		return request_maybe_delivered();
 	}
 
 	if(triedAllOptions && errCode == error_code_process_behind) {
-		throw process_behind(); 
+		return process_behind();
 	}
 
 	return false;
@@ -142,8 +144,12 @@ Future<Optional<REPLY_TYPE(Request)>> makeRequest(RequestStream<Request> const*
 	state Reference<ModelHolder> holder(new ModelHolder(model, stream->getEndpoint().token.first()));
 
 	ErrorOr<REPLY_TYPE(Request)> result = wait(stream->tryGetReply(request));
-	if(checkAndProcessResult(result, holder, atMostOnce, triedAllOptions)) {
-		return result.get();	
+	ErrorOr<bool> processed = checkAndProcessResult(result, holder, atMostOnce, triedAllOptions);
+	if (processed.isError()) {
+		throw processed.getError();
+	}
+	if (processed.get()) {
+		return result.get();
 	}
 	else {
 		return Optional<REPLY_TYPE(Request)>();
@@ -198,7 +204,39 @@ Future< REPLY_TYPE(Request) > loadBalance(
 	if( nextAlt >= bestAlt )
 		nextAlt++;
 
-	if(model) {
+	if(model && FLOW_KNOBS->LOAD_BALANCE_LATENCY_AWARE) {
+		// Power of two choices: of two random healthy servers, send to the one expected to answer sooner and hedge to
+		// the other once the request has outlasted the chosen server's usual slow reply
+		vector<int> healthy;
+		for(int i=0; i<alternatives->size(); i++) {
+			if(i == alternatives->countBest() && healthy.size() >= 2) {
+				break;
+			}
+			RequestStream<Request> const* thisStream = &alternatives->get( i, channel );
+			if (!IFailureMonitor::failureMonitor().getState( thisStream->getEndpoint() ).failed && now() > model->getMeasurement(thisStream->getEndpoint().token.first()).failedUntil) {
+				healthy.push_back(i);
+			}
+		}
+
+		if(healthy.size() == 1) {
+			bestAlt = healthy[0];
+			nextAlt = (bestAlt + 1) % alternatives->size();
+		} else if(healthy.size() >= 2) {
+			int first = deterministicRandom()->randomInt(0, healthy.size());
+			int second = deterministicRandom()->randomInt(0, healthy.size() - 1);
+			if(second >= first) {
+				second++;
+			}
+			bestAlt = healthy[first];
+			nextAlt = healthy[second];
+			auto& bestData = model->getMeasurement(alternatives->get( bestAlt, channel ).getEndpoint().token.first());
+			auto& nextData = model->getMeasurement(alternatives->get( nextAlt, channel ).getEndpoint().token.first());
+			if(nextData.expectedLatency() < bestData.expectedLatency()) {
+				std::swap(bestAlt, nextAlt);
+			}
+			secondDelay = delay( std::max(model->getMeasurement(alternatives->get( bestAlt, channel ).getEndpoint().token.first()).hedgeLatency, FLOW_KNOBS->BASE_SECOND_REQUEST_TIME) );
+		}
+	} else if(model) {
 		double bestMetric = 1e9;
 		double nextMetric = 1e9;
 		double bestTime = 1e9;
@@ -415,7 +453,9 @@ Future< REPLY_TYPE(Request) > loadBalance(
 			loop {
 				choose {
 					when(ErrorOr<Optional<REPLY_TYPE(Request)>> result = wait( errorOr(firstRequest) )) {
-						if(model) {
+						if(model && FLOW_KNOBS->LOAD_BALANCE_LATENCY_AWARE) {
+							model->secondBudget = std::min(model->secondBudget+FLOW_KNOBS->LOAD_BALANCE_HEDGE_BUDGET, FLOW_KNOBS->SECOND_REQUEST_MAX_BUDGET);
+						} else if(model) {
 							model->secondMultiplier = std::max(model->secondMultiplier-FLOW_KNOBS->SECOND_REQUEST_MULTIPLIER_DECAY, 1.0);
 							model->secondBudget = std::min(model->secondBudget+FLOW_KNOBS->SECOND_REQUEST_BUDGET_GROWTH, FLOW_KNOBS->SECOND_REQUEST_MAX_BUDGET);
 						}
@@ -435,7 +475,11 @@ Future< REPLY_TYPE(Request) > loadBalance(
 					when(wait(secondDelay)) {
 						secondDelay = Never();
 						if(model && model->secondBudget >= 1.0) {
-							model->secondMultiplier += FLOW_KNOBS->SECOND_REQUEST_MULTIPLIER_GROWTH;
+							if(FLOW_KNOBS->LOAD_BALANCE_LATENCY_AWARE) {
+								model->hedgedRequests++;
+							} else {
+								model->secondMultiplier += FLOW_KNOBS->SECOND_REQUEST_MULTIPLIER_GROWTH;
+							}
 							model->secondBudget -= 1.0;
 							break;
 						}
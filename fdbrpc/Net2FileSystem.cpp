@@ -35,6 +35,7 @@
 #include "fdbrpc/AsyncFileEIO.actor.h"
 #include "fdbrpc/AsyncFileWinASIO.actor.h"
 #include "fdbrpc/AsyncFileKAIO.actor.h"
+#include "fdbrpc/AsyncFileIOUring.actor.h"
 #include "flow/AsioReactor.h"
 #include "flow/Platform.h"
 #include "fdbrpc/AsyncFileWriteChecker.h"
@@ -63,9 +64,14 @@ Future<Reference<class IAsyncFile>> Net2FileSystem::open(const std::string& file
 	// of Kernel AIO. And EIO_USE_ODIRECT can be used to turn on or off O_DIRECT within
 	// EIO.
 	if ((flags & IAsyncFile::OPEN_UNBUFFERED) && !(flags & IAsyncFile::OPEN_NO_AIO) &&
-	    !FLOW_KNOBS->DISABLE_POSIX_KERNEL_AIO)
+	    !FLOW_KNOBS->DISABLE_POSIX_KERNEL_AIO) {
+#ifdef HAS_IO_URING
+		if (AsyncFileIOUring::isEnabled())
+			f = AsyncFileIOUring::open(filename, flags, mode, nullptr);
+		else
+#endif
 		f = AsyncFileKAIO::open(filename, flags, mode, nullptr);
-	else
+	} else
 #endif
 	f = Net2AsyncFile::open(filename, flags, mode, static_cast<boost::asio::io_service*> ((void*) g_network->global(INetwork::enASIOService)));
 	if(FLOW_KNOBS->PAGE_WRITE_CHECKSUM_HISTORY > 0)
@@ -89,8 +95,16 @@ void Net2FileSystem::newFileSystem(double ioTimeout, const std::string& fileSyst
 Net2FileSystem::Net2FileSystem(double ioTimeout, const std::string& fileSystemPath) {
 	Net2AsyncFile::init();
 #ifdef __linux__
-	if (!FLOW_KNOBS->DISABLE_POSIX_KERNEL_AIO)
-		AsyncFileKAIO::init( Reference<IEventFD>(N2::ASIOReactor::getEventFD()), ioTimeout );
+	if (!FLOW_KNOBS->DISABLE_POSIX_KERNEL_AIO) {
+		// Only one of these can drive the run loop's submission hook, so KAIO is the fallback if io_uring is unavailable
+		bool useIOUring = false;
+#ifdef HAS_IO_URING
+		if (FLOW_KNOBS->USE_IO_URING)
+			useIOUring = AsyncFileIOUring::init( Reference<IEventFD>(N2::ASIOReactor::getEventFD()), ioTimeout );
+#endif
+		if (!useIOUring)
+			AsyncFileKAIO::init( Reference<IEventFD>(N2::ASIOReactor::getEventFD()), ioTimeout );
+	}
 
 	if (fileSystemPath.empty()) {
 		checkFileSystem = false;
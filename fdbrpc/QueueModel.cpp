@@ -20,13 +20,16 @@
 
 #include "fdbrpc/QueueModel.h"
 #include "fdbrpc/LoadBalance.h"
+#include "flow/UnitTest.h"
 
 void QueueModel::endRequest( uint64_t id, double latency, double penalty, double delta, bool clean, bool futureVersion ) {
 	auto& d = data[id];
 	d.smoothOutstanding.addDelta(-delta);
+	d.inFlight--;
 
 	if(clean) {
 		d.latency = latency;
+		d.addLatencySample(latency);
 	} else {
 		d.latency = std::max(d.latency, latency);
 	}
@@ -54,9 +57,24 @@ QueueData& QueueModel::getMeasurement( uint64_t id ) {
 double QueueModel::addRequest( uint64_t id ) {
 	auto& d = data[id];
 	d.smoothOutstanding.addDelta(d.penalty);
+	d.inFlight++;
 	return d.penalty;
 }
 
+void QueueData::addLatencySample(double sample) {
+	smoothLatency += FLOW_KNOBS->LOAD_BALANCE_LATENCY_SMOOTHING * (sample - smoothLatency);
+
+	// Stochastic approximation of a quantile: with steps up of p and down of 1-p, the estimate settles where a fraction
+	// 1-p of samples are above it. Scaling the steps by the mean keeps it in proportion to how fast the server is.
+	double p = FLOW_KNOBS->LOAD_BALANCE_HEDGE_PERCENTILE;
+	double step = FLOW_KNOBS->LOAD_BALANCE_LATENCY_SMOOTHING * smoothLatency;
+	if (sample > hedgeLatency) {
+		hedgeLatency += step * p;
+	} else {
+		hedgeLatency = std::max(hedgeLatency - step * (1 - p), 0.0);
+	}
+}
+
 Optional<LoadBalancedReply> getLoadBalancedReply(const LoadBalancedReply *reply) {
 	return *reply;
 }
@@ -73,6 +91,22 @@ Optional<BasicLoadBalancedReply> getBasicLoadBalancedReply(const void*) {
 	return Optional<BasicLoadBalancedReply>();
 }
 
+TEST_CASE("/fdbrpc/QueueModel/hedgeLatency") {
+	QueueData d;
+	// Nine in ten replies are fast, the rest are a hundred times slower
+	for (int i = 0; i < 100000; i++) {
+		d.addLatencySample(deterministicRandom()->random01() < 0.9 ? 0.001 : 0.1);
+	}
+	double p = FLOW_KNOBS->LOAD_BALANCE_HEDGE_PERCENTILE;
+	if (p > 0.9) {
+		ASSERT(d.hedgeLatency > 0.001);
+	} else if (p < 0.9) {
+		ASSERT(d.hedgeLatency < 0.1);
+	}
+	ASSERT(d.smoothLatency > 0.001 && d.smoothLatency < 0.1);
+	return Void();
+}
+
 /*
 void QueueModel::addMeasurement( uint64_t id, QueueDetails qd ){
 	if (data[new_index].count(id))
@@ -35,7 +35,21 @@ struct QueueData {
 	double failedUntil;
 	double futureVersionBackoff;
 	double increaseBackoffTime;
-	QueueData() : latency(0.001), penalty(1.0), smoothOutstanding(FLOW_KNOBS->QUEUE_MODEL_SMOOTHING_AMOUNT), failedUntil(0), futureVersionBackoff(FLOW_KNOBS->FUTURE_VERSION_INITIAL_BACKOFF), increaseBackoffTime(0) {}
+
+	// Used by the latency aware load balancing mode (LOAD_BALANCE_LATENCY_AWARE)
+	double smoothLatency; // exponentially weighted moving average of clean reply latencies
+	double hedgeLatency; // running estimate of the LOAD_BALANCE_HEDGE_PERCENTILE latency
+	int inFlight;
+
+	QueueData() : latency(0.001), penalty(1.0), smoothOutstanding(FLOW_KNOBS->QUEUE_MODEL_SMOOTHING_AMOUNT), failedUntil(0), futureVersionBackoff(FLOW_KNOBS->FUTURE_VERSION_INITIAL_BACKOFF), increaseBackoffTime(0),
+	  smoothLatency(0.001), hedgeLatency(0.001), inFlight(0) {}
+
+	void addLatencySample(double sample);
+
+	// The latency a new request to this server can expect, given the requests already waiting on it
+	double expectedLatency() const {
+		return smoothLatency * penalty * (1.0 + inFlight * FLOW_KNOBS->LOAD_BALANCE_IN_FLIGHT_PENALTY);
+	}
 };
 
 typedef double TimeEstimate;
@@ -47,11 +61,12 @@ public:
 	double addRequest( uint64_t id );
 	double secondMultiplier;
 	double secondBudget;
+	int64_t hedgedRequests; // backup requests sent in latency aware mode
 	PromiseStream< Future<Void> > addActor;
 	Future<Void> laggingRequests; // requests for which a different recipient already answered
 	int laggingRequestCount;
 
-	QueueModel() : secondMultiplier(1.0), secondBudget(0), laggingRequestCount(0) {
+	QueueModel() : secondMultiplier(1.0), secondBudget(0), hedgedRequests(0), laggingRequestCount(0) {
 		laggingRequests = actorCollection( addActor.getFuture(), &laggingRequestCount );
 	}
 
@@ -348,6 +348,64 @@ bool PolicyAnd::selectReplicas(
 	return passed;
 }
 
+PolicyValidationCache::PolicyValidationCache(Reference<IReplicationPolicy> const& policy)
+  : _policy(policy), _hits(0), _misses(0) {
+	if (policy) {
+		std::set<std::string> keys = policy->attributeKeys();
+		_attribKeys.assign(keys.begin(), keys.end());
+	}
+}
+
+PolicyValidationCache::~PolicyValidationCache() {}
+
+bool PolicyValidationCache::validate(std::vector<LocalityEntry> const& team, Reference<LocalitySet> const& fromServers) {
+	if (_keysFrom.getPtr() != fromServers.getPtr()) {
+		_keysFrom = fromServers;
+		_groupKeys.clear();
+		for (auto& key : _attribKeys) {
+			_groupKeys.push_back(fromServers->getGroupKeyIndex(fromServers->keyIndex(key)));
+		}
+	}
+
+	// One row per member of its values for the policy's attributes, with -1 for a missing one
+	_rows.resize(team.size());
+	for (int i = 0; i < team.size(); i++) {
+		_rows[i].clear();
+		for (auto& key : _groupKeys) {
+			auto value = fromServers->getValueViaGroupKey(team[i], key);
+			_rows[i].push_back(value.present() ? value.get()._id : -1);
+		}
+	}
+	std::sort(_rows.begin(), _rows.end());
+
+	// Renumber each attribute's values in order of appearance, so that teams whose members share values in the same
+	// way have the same pattern
+	_pattern.assign(1 + team.size() * _groupKeys.size(), -1);
+	_pattern[0] = team.size();
+	for (int k = 0; k < _groupKeys.size(); k++) {
+		_seen.clear();
+		for (int i = 0; i < _rows.size(); i++) {
+			int value = _rows[i][k];
+			if (value < 0) continue;
+			auto it = std::find(_seen.begin(), _seen.end(), value);
+			_pattern[1 + i * _groupKeys.size() + k] = it - _seen.begin();
+			if (it == _seen.end()) {
+				_seen.push_back(value);
+			}
+		}
+	}
+
+	auto it = _results.find(_pattern);
+	if (it != _results.end()) {
+		_hits++;
+		return it->second;
+	}
+	_misses++;
+	bool valid = _policy->validate(team, fromServers);
+	_results[_pattern] = valid;
+	return valid;
+}
+
 void testPolicySerialization(Reference<IReplicationPolicy>& policy) {
 	std::string	policyInfo = policy->info();
 
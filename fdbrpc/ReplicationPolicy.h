@@ -72,6 +72,36 @@ struct IReplicationPolicy : public ReferenceCounted<IReplicationPolicy> {
 	virtual void attributeKeys(std::set<std::string>*) const = 0;
 };
 
+// Remembers which teams satisfy a policy.  A policy only compares the values that a team's members have for the
+// attributes it names, and only tests them for equality, so its answer depends on which members share values and not
+// on the values themselves.  Results are kept by that pattern, which most teams of a cluster share (every team of three
+// distinct zones has the same one), and which stays valid as servers join and leave or the locality set is rebuilt.
+struct PolicyValidationCache {
+	explicit PolicyValidationCache(Reference<IReplicationPolicy> const& policy);
+	~PolicyValidationCache();
+
+	// The same as policy->validate(team, fromServers), for a fromServers containing the team
+	bool validate(std::vector<LocalityEntry> const& team, Reference<LocalitySet> const& fromServers);
+
+	Reference<IReplicationPolicy> const& policy() const { return _policy; }
+	int64_t hits() const { return _hits; }
+	int64_t misses() const { return _misses; }
+	int size() const { return _results.size(); }
+
+private:
+	Reference<IReplicationPolicy> _policy;
+	std::vector<std::string> _attribKeys;
+	Reference<LocalitySet> _keysFrom; // The locality set that _groupKeys were looked up in
+	std::vector<AttribKey> _groupKeys;
+	std::map<std::vector<int>, bool> _results;
+	int64_t _hits, _misses;
+
+	// Cache temporary members
+	std::vector<std::vector<int>> _rows;
+	std::vector<int> _pattern;
+	std::vector<int> _seen;
+};
+
 template <class Archive>
 inline void load(Archive& ar, Reference<IReplicationPolicy>& value) {
 	bool present;
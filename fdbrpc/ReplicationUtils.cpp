@@ -956,3 +956,81 @@ TEST_CASE("/fdbrpc/Replication/test") {
 	ASSERT(testReplication() == 0);
 	return Void();
 }
+
+// Random teams of servers, from 1 to maxSize of them, drawn from the servers of the locality set
+static std::vector<std::vector<LocalityEntry>> randomTeams(Reference<LocalitySet> const& servers, int count,
+                                                           int maxSize) {
+	std::vector<std::vector<LocalityEntry>> teams(count);
+	auto const& entries = servers->getEntries();
+	for (auto& team : teams) {
+		int size = deterministicRandom()->randomInt(1, maxSize + 1);
+		for (int i = 0; i < size; i++) {
+			team.push_back(deterministicRandom()->randomChoice(entries));
+		}
+	}
+	return teams;
+}
+
+TEST_CASE("/fdbrpc/Replication/validationCache") {
+	std::vector<repTestType> indexes;
+	Reference<LocalitySet> servers = createTestLocalityMap(indexes, 3, 2, 3, 2, 0, 0);
+
+	for (auto& policy : getStaticPolicies()) {
+		PolicyValidationCache cache(policy);
+		auto teams = randomTeams(servers, 500, std::min(policy->maxResults() + 2, 8));
+		for (int pass = 0; pass < 2; pass++) {
+			for (auto& team : teams) {
+				ASSERT(cache.validate(team, servers) == policy->validate(team, servers));
+			}
+		}
+		ASSERT(cache.hits() >= teams.size());
+		ASSERT(cache.misses() == cache.size());
+	}
+
+	// Results outlive the locality set they were found in
+	Reference<IReplicationPolicy> policy(
+	    new PolicyAcross(2, "dc", Reference<IReplicationPolicy>(new PolicyAcross(2, "zoneid", Reference<IReplicationPolicy>(new PolicyOne())))));
+	PolicyValidationCache cache(policy);
+	for (auto& team : randomTeams(servers, 200, 4)) {
+		cache.validate(team, servers);
+	}
+	std::vector<repTestType> otherIndexes;
+	Reference<LocalitySet> otherServers = createTestLocalityMap(otherIndexes, 4, 3, 2, 2, 0, 0);
+	for (auto& team : randomTeams(otherServers, 200, 4)) {
+		ASSERT(cache.validate(team, otherServers) == policy->validate(team, otherServers));
+	}
+
+	return Void();
+}
+
+TEST_CASE("!/fdbrpc/Replication/performance/validationCache") {
+	std::vector<repTestType> indexes;
+	Reference<LocalitySet> servers = createTestLocalityMap(indexes, 3, 4, 10, 4, 0, 0);
+	Reference<IReplicationPolicy> policy(new PolicyAnd(
+	    { Reference<IReplicationPolicy>(new PolicyAcross(
+	          2, "dc", Reference<IReplicationPolicy>(new PolicyAcross(2, "zoneid", Reference<IReplicationPolicy>(new PolicyOne()))))),
+	      Reference<IReplicationPolicy>(new PolicyAcross(3, "rack", Reference<IReplicationPolicy>(new PolicyOne()))) }));
+	auto teams = randomTeams(servers, 100000, 6);
+	printf("%d servers, %d teams, policy %s\n", servers->size(), (int)teams.size(), policy->info().c_str());
+
+	double start = timer();
+	int valid = 0;
+	for (auto& team : teams) {
+		valid += policy->validate(team, servers);
+	}
+	double elapsed = timer() - start;
+	printf("Uncached: %.0f validations/s (%d valid)\n", teams.size() / elapsed, valid);
+
+	PolicyValidationCache cache(policy);
+	start = timer();
+	int cachedValid = 0;
+	for (auto& team : teams) {
+		cachedValid += cache.validate(team, servers);
+	}
+	elapsed = timer() - start;
+	printf("Cached:   %.0f validations/s (%d valid, %d patterns, %lld hits)\n", teams.size() / elapsed,
+	       cachedValid, cache.size(), (long long)cache.hits());
+	ASSERT(valid == cachedValid);
+
+	return Void();
+}
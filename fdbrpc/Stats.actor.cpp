@@ -80,6 +80,11 @@ void Counter::clear() {
 	metric = 0;
 }
 
+std::set<CounterCollection*>& CounterCollection::all() {
+	static std::set<CounterCollection*> collections;
+	return collections;
+}
+
 void CounterCollection::logToTraceEvent(TraceEvent &te) const {
 	for (ICounter* c : counters) {
 		te.detail(c->getName().c_str(), c);
@@ -35,8 +35,10 @@ MyCounters() : foo("foo", cc), bar("bar", cc), baz("baz", cc) {}
 
 #include <cstdint>
 #include <cstddef>
+#include <set>
 #include "flow/flow.h"
 #include "flow/TDMetric.actor.h"
+#include "flow/Histogram.h"
 #include "fdbrpc/ContinuousSample.h"
 
 struct ICounter {
@@ -67,14 +69,20 @@ struct Traceable<ICounter*> : std::true_type {
 	}
 };
 
-struct CounterCollection {
-	CounterCollection(std::string name, std::string id = std::string()) : name(name), id(id) {}
+struct CounterCollection : NonCopyable {
+	CounterCollection(std::string name, std::string id = std::string()) : name(name), id(id) { all().insert(this); }
 	std::vector<struct ICounter*> counters, counters_to_remove;
-	~CounterCollection() { for (auto c : counters_to_remove) c->remove(); }
+	~CounterCollection() {
+		all().erase(this);
+		for (auto c : counters_to_remove) c->remove();
+	}
 	std::string name;
 	std::string id;
 
 	void logToTraceEvent(TraceEvent& te) const;
+
+	// Every live collection in this process, so that they can be read without going through their owners
+	static std::set<CounterCollection*>& all();
 };
 
 struct Counter : ICounter, NonCopyable {
@@ -207,9 +215,11 @@ private:
 	}
 };
 
+// Logs latency statistics every loggingInterval, along with a snapshot of the histogram they came from so that
+// readers such as status can merge them across processes.
 class LatencySample {
 public:
-	LatencySample(std::string name, UID id, double loggingInterval, int sampleSize) : name(name), id(id), sample(sampleSize), sampleStart(now()) {
+	LatencySample(std::string name, UID id, double loggingInterval) : name(name), id(id), sampleStart(now()) {
 		logger = recurring([this](){ logSample(); }, loggingInterval);
 	}
 
@@ -222,11 +232,13 @@ private:
 	UID id;
 	double sampleStart;
 
-	ContinuousSample<double> sample;
+	LogLinearHistogram sample;
 	Future<Void> logger;
 
 	void logSample() {
 		TraceEvent(name.c_str(), id)
+			.setMaxFieldLength(-1)
+			.setMaxEventLength(-1)
 			.detail("Count", sample.getPopulationSize())
 			.detail("Elapsed", now() - sampleStart)
 			.detail("Min", sample.min())
@@ -238,6 +250,7 @@ private:
 			.detail("P95", sample.percentile(0.95))
 			.detail("P99", sample.percentile(0.99))
 			.detail("P99.9", sample.percentile(0.999))
+			.detail("Histogram", sample.toString())
 			.trackLatest(id.toString() + "/" + name);
 
 		sample.clear();
@@ -23,9 +23,18 @@
 #pragma once
 
 #include <fdbrpc/fdbrpc.h>
+#include "flow/Histogram.h"
+
+// The points a request passes on its way through a server. The time between two stages is charged to the later one,
+// so the stages split a request's latency into run loop queueing (Started), waiting for MVCC to catch up to the
+// request's version (VersionReady), work before the storage engine is reached (EngineStarted), the engine itself
+// (EngineFinished) and building and sending the reply (Replied). A stage a request skips, such as the engine for a
+// read served from memory, is simply never marked and its time goes to the next stage that is.
+enum class RequestStage : uint8_t { Received, Started, VersionReady, EngineStarted, EngineFinished, Replied, COUNT };
 
 class TimedRequest {
 	double _requestTime;
+	double _stageTimes[(int)RequestStage::COUNT] = {};
 
 public:
 	double requestTime() const {
@@ -33,6 +42,14 @@ public:
 		return _requestTime;
 	}
 
+	// Records that the request has reached stage now. Marking a stage again moves it.
+	void markStage(RequestStage stage) { _stageTimes[(int)stage] = timer(); }
+
+	// When the request reached stage, or 0 if it hasn't
+	double stageTime(RequestStage stage) const {
+		return stage == RequestStage::Received ? _requestTime : _stageTimes[(int)stage];
+	}
+
 	TimedRequest() {
 		if (!FlowTransport::isClient()) {
 			_requestTime = timer();
@@ -42,4 +59,70 @@ public:
 	}
 };
 
+// Keeps a histogram of the time requests spend in each RequestStage and logs them every loggingInterval, so that a
+// role's latency can be attributed to the stage it was spent in.
+class RequestStageLatencySample {
+public:
+	RequestStageLatencySample(std::string name, UID id, double loggingInterval)
+	  : name(name), id(id), sampleStart(now()) {
+		logger = recurring([this]() { logSample(); }, loggingInterval);
+	}
+
+	void addRequest(TimedRequest const& req) {
+		double last = req.stageTime(RequestStage::Received);
+		if (last <= 0) return;
+		for (int stage = (int)RequestStage::Received + 1; stage < (int)RequestStage::COUNT; stage++) {
+			double t = req.stageTime((RequestStage)stage);
+			if (t > 0) {
+				stages[stage].addSample(std::max(t - last, 0.0));
+				last = t;
+			}
+		}
+	}
+
+	static const char* stageName(RequestStage stage) {
+		switch (stage) {
+		case RequestStage::Received:
+			return "Received";
+		case RequestStage::Started:
+			return "Queued";
+		case RequestStage::VersionReady:
+			return "VersionWait";
+		case RequestStage::EngineStarted:
+			return "PreEngine";
+		case RequestStage::EngineFinished:
+			return "Engine";
+		case RequestStage::Replied:
+			return "Reply";
+		default:
+			UNREACHABLE();
+		}
+	}
+
+private:
+	std::string name;
+	UID id;
+	double sampleStart;
+
+	LogLinearHistogram stages[(int)RequestStage::COUNT];
+	Future<Void> logger;
+
+	void logSample() {
+		TraceEvent ev(name.c_str(), id);
+		ev.detail("Elapsed", now() - sampleStart);
+		for (int stage = (int)RequestStage::Received + 1; stage < (int)RequestStage::COUNT; stage++) {
+			std::string prefix = stageName((RequestStage)stage);
+			LogLinearHistogram& sample = stages[stage];
+			ev.detail(prefix + "Count", sample.getPopulationSize())
+			    .detail(prefix + "Mean", sample.mean())
+			    .detail(prefix + "Median", sample.median())
+			    .detail(prefix + "P99", sample.percentile(0.99))
+			    .detail(prefix + "Max", sample.max());
+			sample.clear();
+		}
+		ev.trackLatest(id.toString() + "/" + name);
+		sampleStart = now();
+	}
+};
+
 #endif
@@ -242,6 +242,274 @@ struct NetNotifiedQueue final : NotifiedQueue<T>, FlowReceiver, FastAllocated<Ne
 	bool isStream() const override { return true; }
 };
 
+// Sent by the consumer of a ReplyPromiseStream to its producer: the total expectedSize() of the replies consumed so far
+struct AcknowledgementReply {
+	constexpr static FileIdentifier file_identifier = 1389929;
+	int64_t bytes;
+
+	AcknowledgementReply() : bytes(0) {}
+	explicit AcknowledgementReply(int64_t bytes) : bytes(bytes) {}
+
+	template <class Ar>
+	void serialize(Ar& ar) {
+		serializer(ar, bytes);
+	}
+};
+
+// The reply type of a ReplyPromiseStream must derive from this, serialize acknowledgeToken and provide expectedSize().
+// The first reply carries the token of the producer's acknowledgement endpoint.
+struct ReplyPromiseStreamReply {
+	Optional<UID> acknowledgeToken;
+};
+
+// Registered by the producer of a ReplyPromiseStream to learn how much of what it sent has been consumed, so that it
+// can keep no more than bytesLimit outstanding
+struct AcknowledgementReceiver final : FlowReceiver, FastAllocated<AcknowledgementReceiver> {
+	using FastAllocated<AcknowledgementReceiver>::operator new;
+	using FastAllocated<AcknowledgementReceiver>::operator delete;
+
+	int64_t bytesSent;
+	int64_t bytesAcknowledged;
+	int64_t bytesLimit;
+	Promise<Void> ready; // Replaced whenever the producer has to wait for acknowledgements
+	Promise<Void> consumerGone;
+	Future<Void> failures; // Throws operation_obsolete once the consumer is gone or disconnected
+
+	AcknowledgementReceiver() : bytesSent(0), bytesAcknowledged(0), bytesLimit(0) {}
+
+	void receive(ArenaObjectReader& reader) override {
+		ErrorOr<AcknowledgementReply> message;
+		reader.deserialize(message);
+		if (message.isError()) {
+			// The consumer sends operation_obsolete when it is no longer reading the stream
+			if (!consumerGone.isSet()) consumerGone.send(Void());
+		} else {
+			bytesAcknowledged = std::max(bytesAcknowledged, message.get().bytes);
+			if (!ready.isSet() && bytesSent - bytesAcknowledged < bytesLimit) {
+				// Sending can lead to ready being replaced, so hold a copy
+				Promise<Void> hold = ready;
+				hold.send(Void());
+			}
+		}
+	}
+};
+
+// The queue behind a ReplyPromiseStream.  On the consumer it acknowledges each reply as it is popped; on the producer
+// it tracks those acknowledgements.
+template <class T>
+struct NetNotifiedQueueWithAcknowledgements final : NotifiedQueue<T>,
+                                                    FlowReceiver,
+                                                    FastAllocated<NetNotifiedQueueWithAcknowledgements<T>> {
+	using FastAllocated<NetNotifiedQueueWithAcknowledgements<T>>::operator new;
+	using FastAllocated<NetNotifiedQueueWithAcknowledgements<T>>::operator delete;
+
+	AcknowledgementReceiver acknowledgements; // Producer side
+	Endpoint acknowledgeEndpoint; // Consumer side, set from the first reply
+	int64_t bytesConsumed = 0; // Consumer side
+	bool sentError = false;
+
+	NetNotifiedQueueWithAcknowledgements(int futures, int promises) : NotifiedQueue<T>(futures, promises) {}
+	NetNotifiedQueueWithAcknowledgements(int futures, int promises, const Endpoint& remoteEndpoint)
+	  : NotifiedQueue<T>(futures, promises), FlowReceiver(remoteEndpoint, true) {
+		// The producer stops if the connection to the consumer breaks
+		acknowledgements.failures = tagError<Void>(
+		    makeDependent<T>(IFailureMonitor::failureMonitor()).onDisconnect(remoteEndpoint.getPrimaryAddress()) ||
+		        acknowledgements.consumerGone.getFuture(),
+		    operation_obsolete());
+	}
+
+	void destroy() override { delete this; }
+	void receive(ArenaObjectReader& reader) override {
+		this->addPromiseRef();
+		ErrorOr<EnsureTable<T>> message;
+		reader.deserialize(message);
+		if (message.isError()) {
+			this->sendError(message.getError());
+		} else {
+			T& reply = message.get().asUnderlyingType();
+			if (reply.acknowledgeToken.present()) {
+				acknowledgeEndpoint = FlowTransport::transport().loadedEndpoint(reply.acknowledgeToken.get());
+			}
+			if (this->shouldFireImmediately()) {
+				// A waiting consumer takes this without calling pop()
+				acknowledge(reply.expectedSize());
+			}
+			this->send(std::move(reply));
+		}
+		this->delPromiseRef();
+	}
+
+	T pop() override {
+		T res = this->popImpl();
+		acknowledge(res.expectedSize());
+		return res;
+	}
+
+	void acknowledge(int64_t bytes) {
+		if (!acknowledgeEndpoint.isValid()) return;
+		bytesConsumed += bytes;
+		FlowTransport::transport().sendUnreliable(
+		    SerializeSource<ErrorOr<AcknowledgementReply>>(AcknowledgementReply(bytesConsumed)), acknowledgeEndpoint,
+		    false);
+	}
+
+	~NetNotifiedQueueWithAcknowledgements() {
+		if (acknowledgeEndpoint.isValid() && !this->error.isValid()) {
+			// Tell the producer that nobody is reading the stream any more
+			FlowTransport::transport().sendUnreliable(
+			    SerializeSource<ErrorOr<AcknowledgementReply>>(operation_obsolete()), acknowledgeEndpoint, false);
+		}
+		if (isRemoteEndpoint() && !sentError && !acknowledgements.failures.isReady()) {
+			// The producer went away without ending the stream
+			FlowTransport::transport().sendUnreliable(SerializeSource<ErrorOr<EnsureTable<T>>>(broken_promise()),
+			                                          getEndpoint(TaskPriority::ReadSocket), false);
+		}
+	}
+
+	bool isStream() const override { return true; }
+};
+
+// A stream of replies to one request, sent with flow control: the producer waits on onReady() before each send, which
+// keeps no more than setByteLimit() bytes sent but not yet consumed.  The producer ends the stream with an error,
+// usually end_of_stream.  Like stream.send(), delivery is unreliable; the consumer sees connection_failed instead of
+// any replies lost to a disconnect.
+template <class T>
+class ReplyPromiseStream {
+public:
+	template <class U>
+	void send(U&& value) const {
+		if (queue->isRemoteEndpoint()) {
+			if (!queue->acknowledgements.isLocalEndpoint()) {
+				value.acknowledgeToken = queue->acknowledgements.getEndpoint(TaskPriority::ReadSocket).token;
+			}
+			queue->acknowledgements.bytesSent += value.expectedSize();
+			FlowTransport::transport().sendUnreliable(SerializeSource<ErrorOr<EnsureTable<T>>>(value), getEndpoint(),
+			                                          false);
+		} else {
+			queue->send(std::forward<U>(value));
+		}
+	}
+
+	template <class E>
+	void sendError(const E& exc) const {
+		if (queue->isRemoteEndpoint()) {
+			if (!queue->sentError) {
+				queue->sentError = true;
+				FlowTransport::transport().sendUnreliable(SerializeSource<ErrorOr<EnsureTable<T>>>(exc), getEndpoint(),
+				                                          false);
+			}
+		} else {
+			queue->sendError(exc);
+		}
+	}
+
+	FutureStream<T> getFuture() const {
+		queue->addFutureRef();
+		return FutureStream<T>(queue);
+	}
+
+	ReplyPromiseStream() : queue(new NetNotifiedQueueWithAcknowledgements<T>(0, 1)), errors(new SAV<Void>(0, 1)) {}
+	explicit ReplyPromiseStream(const Endpoint& endpoint)
+	  : queue(new NetNotifiedQueueWithAcknowledgements<T>(0, 1, endpoint)), errors(new SAV<Void>(0, 1)) {}
+	ReplyPromiseStream(const ReplyPromiseStream& rhs) : queue(rhs.queue), errors(rhs.errors) {
+		queue->addPromiseRef();
+		if (errors) errors->addPromiseRef();
+	}
+	ReplyPromiseStream(ReplyPromiseStream&& rhs) noexcept : queue(rhs.queue), errors(rhs.errors) {
+		rhs.queue = nullptr;
+		rhs.errors = nullptr;
+	}
+	void operator=(const ReplyPromiseStream& rhs) {
+		rhs.queue->addPromiseRef();
+		if (rhs.errors) rhs.errors->addPromiseRef();
+		reset();
+		queue = rhs.queue;
+		errors = rhs.errors;
+	}
+	void operator=(ReplyPromiseStream&& rhs) noexcept {
+		if (queue != rhs.queue) {
+			reset();
+			queue = rhs.queue;
+			errors = rhs.errors;
+			rhs.queue = nullptr;
+			rhs.errors = nullptr;
+		}
+	}
+	~ReplyPromiseStream() { reset(); }
+
+	// Turns this copy's reference into a future that is broken once every other copy is gone; used by
+	// endStreamOnDisconnect to notice that the consumer has lost interest
+	Future<Void> getErrorFutureAndDelPromiseRef() {
+		ASSERT(errors && errors->getPromiseReferenceCount() > 1);
+		errors->addFutureRef();
+		errors->delPromiseRef();
+		Future<Void> res(errors);
+		errors = nullptr;
+		return res;
+	}
+
+	void setByteLimit(int64_t byteLimit) { queue->acknowledgements.bytesLimit = byteLimit; }
+
+	// For the producer: ready once fewer than the byte limit are outstanding, or operation_obsolete once nobody can
+	// consume what is sent
+	Future<Void> onReady() {
+		AcknowledgementReceiver& acks = queue->acknowledgements;
+		if (acks.failures.isValid() && acks.failures.isReady()) {
+			return acks.failures;
+		}
+		if (acks.bytesSent - acks.bytesAcknowledged < acks.bytesLimit) {
+			return Void();
+		}
+		if (acks.ready.isSet()) {
+			acks.ready = Promise<Void>();
+		}
+		return acks.failures.isValid() ? acks.ready.getFuture() || acks.failures : acks.ready.getFuture();
+	}
+
+	const Endpoint& getEndpoint() const { return queue->getEndpoint(TaskPriority::ReadSocket); }
+
+	bool operator==(const ReplyPromiseStream<T>& rhs) const { return queue == rhs.queue; }
+	bool isEmpty() const { return !queue->isReady(); }
+	uint32_t size() const { return queue->size(); }
+
+private:
+	void reset() {
+		if (queue) queue->delPromiseRef();
+		if (errors) errors->delPromiseRef();
+		queue = nullptr;
+		errors = nullptr;
+	}
+
+	NetNotifiedQueueWithAcknowledgements<T>* queue;
+	SAV<Void>* errors;
+};
+
+template <class T>
+struct serializable_traits<ReplyPromiseStream<T>> : std::true_type {
+	template <class Archiver>
+	static void serialize(Archiver& ar, ReplyPromiseStream<T>& p) {
+		if constexpr (Archiver::isDeserializing) {
+			UID token;
+			serializer(ar, token);
+			auto endpoint = FlowTransport::transport().loadedEndpoint(token);
+			p = ReplyPromiseStream<T>(endpoint);
+		} else {
+			const auto& ep = p.getEndpoint().token;
+			serializer(ar, ep);
+		}
+	}
+};
+
+template <class Reply>
+ReplyPromiseStream<Reply> const& getReplyPromiseStream(ReplyPromiseStream<Reply> const& p) {
+	return p;
+}
+
+template <class Request>
+auto const& getReplyPromiseStream(Request const& r) {
+	return r.reply;
+}
+
 template <class T>
 class RequestStream {
 public:
@@ -314,6 +582,30 @@ public:
 		return waitValueOrSignal(p.getFuture(), Never(), getEndpoint(taskID), p);
 	}
 
+	// stream.getReplyStream( request )
+	//   Unreliable at most once delivery: Delivers request unless there is a connection failure, and returns the stream of
+	//   replies.  The stream ends with connection_failed if the connection fails before the producer ends it, which is
+	//   only noticed while the caller holds on to the returned ReplyPromiseStream (not just its FutureStream).
+	template <class X>
+	auto getReplyStream(const X& value) const {
+		auto& p = getReplyPromiseStream(value);
+		if (queue->isRemoteEndpoint()) {
+			Future<Void> disc =
+			    makeDependent<T>(IFailureMonitor::failureMonitor()).onDisconnectOrFailure(getEndpoint());
+			if (disc.isReady()) {
+				p.sendError(request_maybe_delivered());
+			} else {
+				FlowTransport::transport().sendUnreliable(SerializeSource<T>(value), getEndpoint(), true);
+				auto watched = p;
+				Future<Void> errors = watched.getErrorFutureAndDelPromiseRef();
+				endStreamOnDisconnect(disc, watched, errors);
+			}
+		} else {
+			send(value);
+		}
+		return p;
+	}
+
 	template <class X>
 	Future<ErrorOr<REPLY_TYPE(X)>> tryGetReply(const X& value) const {
 		if (queue->isRemoteEndpoint()) {
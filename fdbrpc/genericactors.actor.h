@@ -221,6 +221,22 @@ Future<ErrorOr<X>> waitValueOrSignal( Future<X> value, Future<Void> signal, Endp
 	}
 }
 
+// Ends stream with connection_failed when signal fires first, since replies may have been lost.  Returns once errors,
+// from stream.getErrorFutureAndDelPromiseRef(), is broken because every other copy of stream is gone.
+ACTOR template <class X>
+void endStreamOnDisconnect(Future<Void> signal, ReplyPromiseStream<X> stream, Future<Void> errors) {
+	try {
+		choose {
+			when(wait(signal)) { stream.sendError(connection_failed()); }
+			when(wait(errors)) {}
+		}
+	} catch (Error& e) {
+		if (e.code() != error_code_broken_promise) {
+			stream.sendError(e);
+		}
+	}
+}
+
 ACTOR template <class T> 
 Future<T> sendCanceler( ReplyPromise<T> reply, ReliablePacket* send, Endpoint endpoint ) {
 	try {
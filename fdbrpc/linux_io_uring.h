@@ -0,0 +1,129 @@
+/*
+ * linux_io_uring.h
+ *
+ * This source file is part of the FoundationDB open source project
+ *
+ * Copyright 2013-2020 Apple Inc. and the FoundationDB project authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+// io_uring system calls and a minimal submission/completion ring, in the spirit of linux_kaio.h (no liburing)
+
+#include <atomic>
+#include <cerrno>
+#include <cstring>
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#if !defined(__NR_io_uring_setup) && defined(__x86_64__)
+#define __NR_io_uring_setup 425
+#define __NR_io_uring_enter 426
+#define __NR_io_uring_register 427
+#endif
+
+static int io_uring_setup(unsigned entries, io_uring_params* p) { return syscall( __NR_io_uring_setup, entries, p ); }
+static int io_uring_enter(int fd, unsigned toSubmit, unsigned minComplete, unsigned flags) { return syscall( __NR_io_uring_enter, fd, toSubmit, minComplete, flags, nullptr, 0 ); }
+static int io_uring_register(int fd, unsigned opcode, const void* arg, unsigned nrArgs) { return syscall( __NR_io_uring_register, fd, opcode, arg, nrArgs ); }
+
+struct LinuxIOUring {
+	int fd = -1;
+	unsigned sqEntries = 0;
+
+	// Submission queue ring
+	std::atomic<unsigned>* sqHead = nullptr;
+	std::atomic<unsigned>* sqTail = nullptr;
+	unsigned* sqMask = nullptr;
+	unsigned* sqArray = nullptr;
+	io_uring_sqe* sqes = nullptr;
+
+	// Completion queue ring
+	std::atomic<unsigned>* cqHead = nullptr;
+	std::atomic<unsigned>* cqTail = nullptr;
+	unsigned* cqMask = nullptr;
+	io_uring_cqe* cqes = nullptr;
+
+	// Returns false if the kernel does not support io_uring (or it is disallowed), in which case the ring is unusable
+	bool setup(unsigned entries) {
+		io_uring_params p;
+		memset(&p, 0, sizeof(p));
+		fd = io_uring_setup(entries, &p);
+		if (fd < 0) return false;
+
+		size_t sqRingSize = p.sq_off.array + p.sq_entries * sizeof(unsigned);
+		size_t cqRingSize = p.cq_off.cqes + p.cq_entries * sizeof(io_uring_cqe);
+		bool singleMmap = p.features & IORING_FEAT_SINGLE_MMAP;
+		if (singleMmap) sqRingSize = cqRingSize = std::max(sqRingSize, cqRingSize);
+
+		uint8_t* sq = (uint8_t*)mmap(nullptr, sqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQ_RING);
+		if (sq == MAP_FAILED) return false;
+		uint8_t* cq = sq;
+		if (!singleMmap) {
+			cq = (uint8_t*)mmap(nullptr, cqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_CQ_RING);
+			if (cq == MAP_FAILED) return false;
+		}
+		sqes = (io_uring_sqe*)mmap(nullptr, p.sq_entries * sizeof(io_uring_sqe), PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQES);
+		if (sqes == MAP_FAILED) return false;
+
+		sqEntries = p.sq_entries;
+		sqHead = (std::atomic<unsigned>*)(sq + p.sq_off.head);
+		sqTail = (std::atomic<unsigned>*)(sq + p.sq_off.tail);
+		sqMask = (unsigned*)(sq + p.sq_off.ring_mask);
+		sqArray = (unsigned*)(sq + p.sq_off.array);
+		cqHead = (std::atomic<unsigned>*)(cq + p.cq_off.head);
+		cqTail = (std::atomic<unsigned>*)(cq + p.cq_off.tail);
+		cqMask = (unsigned*)(cq + p.cq_off.ring_mask);
+		cqes = (io_uring_cqe*)(cq + p.cq_off.cqes);
+		return true;
+	}
+
+	// Completions are signalled on the given eventfd, the same way AsyncFileKAIO's are
+	bool registerEventFD(int evfd) { return io_uring_register(fd, IORING_REGISTER_EVENTFD, &evfd, 1) == 0; }
+
+	unsigned sqSpace() const { return sqEntries - (sqTail->load(std::memory_order_relaxed) - sqHead->load(std::memory_order_acquire)); }
+
+	// The next free submission entry, zeroed.  Requires sqSpace() > 0 counting every entry not yet published.
+	io_uring_sqe* nextSQE(unsigned pending) {
+		unsigned index = (sqTail->load(std::memory_order_relaxed) + pending) & *sqMask;
+		sqArray[index] = index;
+		memset(&sqes[index], 0, sizeof(io_uring_sqe));
+		return &sqes[index];
+	}
+
+	// Publishes the next n submission entries and submits them with a single system call
+	int submit(unsigned n) {
+		sqTail->store(sqTail->load(std::memory_order_relaxed) + n, std::memory_order_release);
+		int rc;
+		do {
+			rc = io_uring_enter(fd, n, 0, 0);
+		} while (rc < 0 && errno == EINTR);
+		return rc;
+	}
+
+	// Calls f(cqe) for each available completion and then releases them to the kernel.  Returns the number reaped.
+	template <class F>
+	int reap(F&& f) {
+		unsigned head = cqHead->load(std::memory_order_relaxed);
+		unsigned tail = cqTail->load(std::memory_order_acquire);
+		int n = 0;
+		for (; head != tail; ++head, ++n) {
+			f(cqes[head & *cqMask]);
+		}
+		cqHead->store(head, std::memory_order_release);
+		return n;
+	}
+};
@@ -415,6 +415,25 @@ int sf_open( const char* filename, int flags, int convFlags, int mode ) {
 #error How do i open a file on a new platform?
 #endif
 
+// Reads or writes at offset, in one system call where the platform has one
+int64_t sf_pread( int h, void* data, unsigned int length, int64_t offset ) {
+#if defined(_WIN32)
+	if( _lseeki64( h, offset, SEEK_SET ) == -1 ) return -1;
+	return _read( h, data, length );
+#else
+	return ::pread( h, data, length, offset );
+#endif
+}
+
+int64_t sf_pwrite( int h, const void* data, unsigned int length, int64_t offset ) {
+#if defined(_WIN32)
+	if( _lseeki64( h, offset, SEEK_SET ) == -1 ) return -1;
+	return _write( h, data, length );
+#else
+	return ::pwrite( h, data, length, offset );
+#endif
+}
+
 class SimpleFile : public IAsyncFile, public ReferenceCounted<SimpleFile> {
 public:
 	static void init() {}
@@ -533,20 +552,15 @@ private:
 
 		wait( waitUntilDiskReady( self->diskParameters, length ) );
 
-		if( _lseeki64( self->h, offset, SEEK_SET ) == -1 ) {
-			TraceEvent(SevWarn, "SimpleFileIOError").detail("Location", 1);
-			throw io_error();
-		}
-
-		unsigned int read_bytes = 0;
-		if( ( read_bytes = _read( self->h, data, (unsigned int) length ) ) == -1 ) {
+		int64_t read_bytes = sf_pread( self->h, data, (unsigned int) length, offset );
+		if( read_bytes == -1 ) {
 			TraceEvent(SevWarn, "SimpleFileIOError").detail("Location", 2);
 			throw io_error();
 		}
 
 		if (randLog) {
 			uint32_t a = crc32c_append( 0, (const uint8_t*)data, read_bytes );
-			fprintf( randLog, "SFR2 %s %s %s %d %d\n", self->dbgId.shortString().c_str(), self->filename.c_str(), opId.shortString().c_str(), read_bytes, a );
+			fprintf( randLog, "SFR2 %s %s %s %d %d\n", self->dbgId.shortString().c_str(), self->filename.c_str(), opId.shortString().c_str(), (int)read_bytes, a );
 		}
 
 		debugFileCheck("SimpleFileRead", self->filename, data, offset, length);
@@ -567,13 +581,8 @@ private:
 		if(self->delayOnWrite)
 			wait( waitUntilDiskReady( self->diskParameters, data.size() ) );
 
-		if( _lseeki64( self->h, offset, SEEK_SET ) == -1 ) {
-			TraceEvent(SevWarn, "SimpleFileIOError").detail("Location", 3);
-			throw io_error();
-		}
-
-		unsigned int write_bytes = 0;
-		if ( ( write_bytes = _write( self->h, (void*)data.begin(), data.size() ) ) == -1 ) {
+		int64_t write_bytes = sf_pwrite( self->h, data.begin(), data.size(), offset );
+		if ( write_bytes == -1 ) {
 			TraceEvent(SevWarn, "SimpleFileIOError").detail("Location", 4);
 			throw io_error();
 		}
@@ -755,7 +764,7 @@ public:
 		}
 
 		mutex.enter();
-		tasks.push( Task( time + seconds, taskID, taskCount++, machine, f ) );
+		tasks.push( Task( time + seconds, taskID, taskCount++, machine, f ), time );
 		mutex.leave();
 
 		return f;
@@ -967,9 +976,8 @@ public:
 			}
 			//if (!randLog/* && now() >= 32.0*/)
 			//	randLog = fopen("randLog.txt", "wt");
-			Task t = std::move( self->tasks.top() ); // Unfortunately still a copy under gcc where .top() returns const&
+			Task t = self->tasks.pop();
 			self->currentTaskID = t.taskID;
-			self->tasks.pop();
 			self->mutex.leave();
 
 			self->execTask(t);
@@ -1654,6 +1662,40 @@ public:
 		}
 	};
 
+	// The tasks waiting to run, in (time, stable) order. Most are due at the current time (zero delays, onProcess and
+	// onMainThread), and those wait in a FIFO, which keeps them in stable order without the cost of the heap that holds
+	// later ones. Nothing later than a task in the FIFO runs before it, so the FIFO never holds tasks of two times.
+	class TaskQueue {
+	public:
+		void push( Task&& task, double now ) {
+			if( task.time == now && ( ready.empty() || ready.back().time == now ) ) {
+				ready.push_back( std::move(task) );
+			} else {
+				later.push_back( std::move(task) );
+				std::push_heap( later.begin(), later.end() );
+			}
+		}
+
+		size_t size() const { return ready.size() + later.size(); }
+
+		// Removes and returns the next task to run. Requires size() > 0.
+		Task pop() {
+			if( !ready.empty() && ( later.empty() || later.front() < ready.front() ) ) {
+				Task t = std::move( ready.front() );
+				ready.pop_front();
+				return t;
+			}
+			std::pop_heap( later.begin(), later.end() );
+			Task t = std::move( later.back() );
+			later.pop_back();
+			return t;
+		}
+
+	private:
+		std::deque<Task> ready;
+		std::vector<Task> later; // A heap ordered by Task::operator<
+	};
+
 	void execTask(struct Task& t) {
 		if (t.machine->failed) {
 			t.action.send(Never());
@@ -1685,7 +1727,7 @@ public:
 
 		mutex.enter();
 		ASSERT(taskID >= TaskPriority::Min && taskID <= TaskPriority::Max);
-		tasks.push( Task( time, taskID, taskCount++, getCurrentProcess(), std::move(signal) ) );
+		tasks.push( Task( time, taskID, taskCount++, getCurrentProcess(), std::move(signal) ), time );
 		mutex.leave();
 	}
 	bool isOnMainThread() const override {
@@ -1718,7 +1760,7 @@ public:
 	std::map<ProcessInfo*, Promise<Void>> filesDeadMap;
 
 	//tasks is guarded by ISimulator::mutex
-	std::priority_queue<Task, std::vector<Task>> tasks;
+	TaskQueue tasks;
 
 	std::vector<std::function<void()>> stopCallbacks;
 
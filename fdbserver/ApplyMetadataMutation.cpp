@@ -569,6 +569,18 @@ void applyMetadataMutations(SpanID const& spanContext, ProxyCommitData& proxyCom
 	                       &proxyCommitData.cacheInfo, uid_applyMutationsData, proxyCommitData.commit,
 	                       proxyCommitData.cx, &proxyCommitData.committedVersion, &proxyCommitData.storageCache,
 	                       &proxyCommitData.tag_popped, initialCommit);
+
+	// Resynchronize keyRouting with every part of keyInfo the mutations could have changed
+	for (auto const& m : mutations) {
+		if (m.type == MutationRef::SetValue && m.param1.startsWith(keyServersPrefix)) {
+			KeyRef k = m.param1.removePrefix(keyServersPrefix);
+			proxyCommitData.keyRouting.update(KeyRangeRef(k, k));
+		} else if (m.type == MutationRef::ClearRange && keyServersKeys.intersects(KeyRangeRef(m.param1, m.param2))) {
+			KeyRangeRef r = KeyRangeRef(m.param1, m.param2) & keyServersKeys;
+			proxyCommitData.keyRouting.update(
+			    KeyRangeRef(r.begin.removePrefix(keyServersPrefix), r.end.removePrefix(keyServersPrefix)));
+		}
+	}
 }
 
 void applyMetadataMutations(SpanID const& spanContext, const UID& dbgid, Arena& arena,
@@ -0,0 +1,251 @@
+/*
+ * ArtVersionHistory.cpp
+ *
+ * This source file is part of the FoundationDB open source project
+ *
+ * Copyright 2013-2020 Apple Inc. and the FoundationDB project authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <map>
+
+#include "fdbserver/ArtVersionHistory.h"
+#include "flow/UnitTest.h"
+
+// art_tree is otherwise only used nested in VersionedBTree
+#define ART_GLOBAL_SCOPE
+#include "fdbserver/art.h"
+#include "fdbserver/art_impl.h"
+
+static_assert(sizeof(void*) >= sizeof(Version), "Versions are stored in art_leaf::value");
+static_assert(ArtVersionHistory::MAX_KEY_LENGTH < ART_MAX_KEY_LEN, "Keys must fit art_tree's bound stack");
+
+namespace {
+
+Version versionOf(const art_iterator& it) {
+	return (Version)(intptr_t)it.value();
+}
+
+void* asValue(Version v) {
+	return (void*)(intptr_t)v;
+}
+
+// Greater than every key stored except itself, so that every key has a successor and keys past the end of the last
+// range need no special case.  Its version is never read.
+KeyRef endSentinel() {
+	static const std::string sentinel(ArtVersionHistory::MAX_KEY_LENGTH + 1, '\xff');
+	return KeyRef((const uint8_t*)sentinel.data(), sentinel.size());
+}
+
+KeyRef clampBegin(KeyRef k) {
+	return k.size() <= ArtVersionHistory::MAX_KEY_LENGTH ? k : k.substr(0, ArtVersionHistory::MAX_KEY_LENGTH);
+}
+
+KeyRef clampEnd(KeyRef k, Arena& arena) {
+	if (k.size() <= ArtVersionHistory::MAX_KEY_LENGTH) {
+		return k;
+	}
+	KeyRef prefix = k.substr(0, ArtVersionHistory::MAX_KEY_LENGTH);
+	for (int i = 0; i < prefix.size(); i++) {
+		if (prefix[i] != 0xff) {
+			return strinc(prefix, arena);
+		}
+	}
+	return endSentinel();
+}
+
+} // namespace
+
+ArtVersionHistory::ArtVersionHistory(Version v) {
+	reset(v);
+}
+
+ArtVersionHistory::~ArtVersionHistory() {}
+
+void ArtVersionHistory::clear(Version v) {
+	reset(v);
+}
+
+void ArtVersionHistory::reset(Version v) {
+	arena = Arena();
+	tree = new (arena) art_tree(arena);
+	KeyRef first;
+	tree->insert(first, asValue(v));
+	KeyRef last = endSentinel();
+	tree->insert(last, asValue(v));
+	liveCount = 2;
+	erasedSinceRebuild = 0;
+}
+
+// The entry covering k, i.e. the last one <= k.  k must be less than the sentinel.
+static art_iterator floorEntry(art_tree* tree, KeyRef k) {
+	art_iterator it = tree->upper_bound(k);
+	--it;
+	return it;
+}
+
+bool ArtVersionHistory::intersects(KeyRef begin, KeyRef end, Version version) {
+	Arena temp;
+	KeyRef b = clampBegin(begin);
+	KeyRef e = clampEnd(end, temp);
+	if (!(b < e)) return false;
+
+	art_iterator it = floorEntry(tree, b);
+	while (true) {
+		if (versionOf(it) > version) return true;
+		++it;
+		if (!(it.key() < e)) return false;
+	}
+}
+
+void ArtVersionHistory::addConflictRange(KeyRef begin, KeyRef end, Version version) {
+	Arena temp;
+	KeyRef b = clampBegin(begin);
+	KeyRef e = clampEnd(end, temp);
+	if (!(b < e)) return;
+
+	// Keys from end on keep the version they had
+	if (e != endSentinel()) {
+		art_iterator atEnd = floorEntry(tree, e);
+		if (atEnd.key() != e) {
+			tree->insert(e, asValue(versionOf(atEnd)));
+			liveCount++;
+		}
+	}
+
+	art_iterator it = tree->lower_bound(b);
+	if (it.key() == b) {
+		*it.value_ptr() = asValue(version);
+		++it;
+	} else {
+		tree->insert(b, asValue(version));
+		liveCount++;
+	}
+
+	// Everything else in [b, e) is now covered by b
+	while (it.key() < e) {
+		art_iterator next = it;
+		++next;
+		tree->erase(it);
+		liveCount--;
+		erasedSinceRebuild++;
+		it = next;
+	}
+
+	if (erasedSinceRebuild > std::max(liveCount, 10000)) rebuild();
+}
+
+Key ArtVersionHistory::removeBefore(Version oldestVersion, KeyRef from, int count) {
+	// As in SkipList::removeBefore, an entry is merged into the one before it when both are older than oldestVersion,
+	// since no read that is not too old can tell them apart
+	art_iterator it = floorEntry(tree, clampBegin(from));
+	bool wasAbove = true;
+	while (count-- > 0) {
+		art_iterator x = it;
+		++x;
+		if (x.key() == endSentinel()) return Key();
+
+		bool isAbove = versionOf(x) >= oldestVersion;
+		if (isAbove || wasAbove) {
+			it = x;
+		} else {
+			tree->erase(x);
+			liveCount--;
+			erasedSinceRebuild++;
+		}
+		wasAbove = isAbove;
+	}
+
+	Key resume = it.key();
+	if (erasedSinceRebuild > std::max(liveCount, 10000)) rebuild();
+	return resume;
+}
+
+void ArtVersionHistory::rebuild() {
+	// art_tree allocates everything in the arena and never frees, so copy the live entries into a fresh one.  The old
+	// tree is only read from here on, so it is fine that it now points at the new arena.
+	Arena oldArena = arena;
+	art_iterator it = tree->lower_bound(KeyRef());
+
+	arena = Arena();
+	tree = new (arena) art_tree(arena);
+	for (; it != art_iterator(); ++it) {
+		KeyRef k = it.key();
+		tree->insert(k, it.value());
+	}
+	erasedSinceRebuild = 0;
+}
+
+namespace {
+
+// Keys with long shared prefixes, and occasionally keys too long to store exactly
+Key randomHistoryKey(bool allowLong) {
+	static const char* prefixes[] = { "", "\x01", "\x01\x02\x15tenant", "\x01\x02\x15tenant\x00\x02user", "\xff" };
+	std::string k = prefixes[deterministicRandom()->randomInt(0, 5)];
+	int n = deterministicRandom()->randomInt(0, 4);
+	for (int i = 0; i < n; i++) k += "\x00\x01za\xff"[deterministicRandom()->randomInt(0, 5)];
+	if (allowLong && deterministicRandom()->random01() < 0.05) {
+		k += std::string(ArtVersionHistory::MAX_KEY_LENGTH + deterministicRandom()->randomInt(-10, 10),
+		                 deterministicRandom()->coinflip() ? '\xff' : 'a');
+	}
+	return Key(k);
+}
+
+} // namespace
+
+TEST_CASE("/fdbserver/ArtVersionHistory/MatchesMap") {
+	// With long keys the tree may report extra conflicts but must never miss one
+	bool allowLong = deterministicRandom()->coinflip();
+	std::map<Key, Version> expected;
+	expected[Key()] = 0;
+	ArtVersionHistory history(0);
+	Version now = 0, oldest = 0;
+	Key removalKey;
+
+	for (int step = 0; step < 5000; step++) {
+		now += deterministicRandom()->randomInt(1, 4);
+		for (int i = deterministicRandom()->randomInt(0, 4); i > 0; i--) {
+			Key b = randomHistoryKey(allowLong), e = randomHistoryKey(allowLong);
+			if (e < b) std::swap(b, e);
+			history.addConflictRange(b, e, now);
+			if (b < e) {
+				Version atEnd = std::prev(expected.upper_bound(e))->second;
+				expected.erase(expected.lower_bound(b), expected.lower_bound(e));
+				expected[e] = atEnd;
+				expected[b] = now;
+			}
+		}
+
+		if (deterministicRandom()->random01() < 0.3) {
+			oldest = std::max(oldest, now - deterministicRandom()->randomInt(0, 20));
+			removalKey = history.removeBefore(oldest, removalKey, deterministicRandom()->randomInt(1, 30));
+		}
+
+		for (int i = 0; i < 5; i++) {
+			Key b = randomHistoryKey(allowLong), e = randomHistoryKey(allowLong);
+			if (e < b) std::swap(b, e);
+			Version v = deterministicRandom()->randomInt64(oldest, now + 1);
+			bool conflict = false;
+			if (b < e) {
+				for (auto it = std::prev(expected.upper_bound(b)); it != expected.end() && it->first < e; ++it) {
+					conflict = conflict || it->second > v;
+				}
+			}
+			bool result = history.intersects(b, e, v);
+			ASSERT(result == conflict || (allowLong && result));
+		}
+	}
+
+	return Void();
+}
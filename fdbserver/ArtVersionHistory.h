@@ -0,0 +1,69 @@
+/*
+ * ArtVersionHistory.h
+ *
+ * This source file is part of the FoundationDB open source project
+ *
+ * Copyright 2013-2020 Apple Inc. and the FoundationDB project authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FDBSERVER_ARTVERSIONHISTORY_H
+#define FDBSERVER_ARTVERSIONHISTORY_H
+#pragma once
+
+#include "fdbclient/FDBTypes.h"
+#include "flow/Arena.h"
+
+struct art_tree;
+
+// The write history of a ConflictSet kept in an adaptive radix tree (fdbserver/art.h) instead of a SkipList.  Each
+// entry maps a key to the newest version at which any key from it up to the next entry was written, so a read range
+// conflicts if any entry covering it is newer than the read snapshot.  Keys share their prefixes in the tree's inner
+// nodes, which is much more compact than a skip list node per key when keys have long common (e.g. tuple encoded)
+// prefixes.
+//
+// Keys longer than MAX_KEY_LENGTH are widened to the nearest shorter keys outside them, which can only add conflicts.
+class ArtVersionHistory : NonCopyable {
+public:
+	static constexpr int MAX_KEY_LENGTH = 5000;
+
+	// Every key is initially treated as last written at version v
+	explicit ArtVersionHistory(Version v);
+	~ArtVersionHistory();
+
+	void clear(Version v);
+
+	// True if any key in [begin, end) was written after version
+	bool intersects(KeyRef begin, KeyRef end, Version version);
+
+	// Records that every key in [begin, end) was written at version, which must be newer than any recorded so far
+	void addConflictRange(KeyRef begin, KeyRef end, Version version);
+
+	// Merges away up to count entries older than oldestVersion, scanning forward from the entry covering from.  Returns
+	// the key to continue from next time, which wraps around to the empty key at the end.
+	Key removeBefore(Version oldestVersion, KeyRef from, int count);
+
+	int count() const { return liveCount; }
+
+private:
+	void reset(Version v);
+	void rebuild();
+
+	Arena arena;
+	art_tree* tree;
+	int liveCount; // art_tree::count() does not account for erased keys
+	int erasedSinceRebuild; // The arena only grows, so it is rebuilt once most of what it holds has been erased
+};
+
+#endif
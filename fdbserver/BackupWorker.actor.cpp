@@ -643,6 +643,72 @@ ACTOR Future<Void> addMutation(Reference<IBackupFile> logFile, VersionedMessage
 	return Void();
 }
 
+// Records of a mutation log file waiting to be packed into compressed blocks.
+struct CompressedLogBuffer {
+	std::string records;
+	std::vector<int> recordEnds; // Offset in records just past each record
+	int rawBlockTarget; // Raw bytes expected to compress into one block, adapted to the observed ratio
+	bool writing = false; // Whether writeCompressedLogBlocks() is appending to the file
+
+	explicit CompressedLogBuffer(int blockSize) : rawBlockTarget(2 * blockSize) {}
+};
+
+// Write buffered records to a log file as compressed blocks, as many as fit into each. Unless flushAll is set, only
+// full blocks are written. A record too large to compress into a block is written to an uncompressed block instead.
+ACTOR Future<Void> writeCompressedLogBlocks(Reference<IBackupFile> logFile, CompressedLogBuffer* buffer,
+                                            int64_t* blockEnd, int blockSize, bool flushAll) {
+	state int n;
+	state Optional<Standalone<StringRef>> block;
+	state int rawLen;
+	ASSERT(!buffer->writing);
+	buffer->writing = true;
+	while (!buffer->recordEnds.empty() && (flushAll || buffer->records.size() >= buffer->rawBlockTarget)) {
+		n = buffer->recordEnds.size();
+		loop {
+			rawLen = buffer->recordEnds[n - 1];
+			block = fileBackup::encodeCompressedLogBlock(StringRef((const uint8_t*)buffer->records.data(), rawLen),
+			                                             blockSize);
+			if (block.present() || n == 1) break;
+			n = std::min(n - 1, n * 3 / 4 + 1);
+		}
+
+		const int bytesLeft = *blockEnd - logFile->size();
+		if (bytesLeft > 0) {
+			state Value paddingFFs = fileBackup::makePadding(bytesLeft);
+			wait(logFile->append(paddingFFs.begin(), bytesLeft));
+		}
+		*blockEnd += blockSize;
+
+		if (block.present()) {
+			wait(logFile->append(block.get().begin(), block.get().size()));
+			buffer->rawBlockTarget = std::max<int>(blockSize, rawLen * 0.95 * blockSize / block.get().size());
+		} else {
+			wait(logFile->append((uint8_t*)&PARTITIONED_MLOG_VERSION, sizeof(PARTITIONED_MLOG_VERSION)));
+			wait(logFile->append(buffer->records.data(), rawLen));
+		}
+
+		buffer->records.erase(0, rawLen);
+		buffer->recordEnds.erase(buffer->recordEnds.begin(), buffer->recordEnds.begin() + n);
+		for (int& end : buffer->recordEnds) {
+			end -= rawLen;
+		}
+	}
+	buffer->writing = false;
+	return Void();
+}
+
+// Buffer a mutation for a compressed log file, writing out blocks as they fill.
+Future<Void> addCompressedMutation(Reference<IBackupFile> logFile, CompressedLogBuffer* buffer,
+                                   VersionedMessage message, StringRef mutation, int64_t* blockEnd, int blockSize) {
+	BinaryWriter wr(Unversioned());
+	wr << bigEndian64(message.version.version) << bigEndian32(message.version.sub) << bigEndian32(mutation.size());
+	buffer->records.append((const char*)wr.getData(), wr.getLength());
+	buffer->records.append((const char*)mutation.begin(), mutation.size());
+	buffer->recordEnds.push_back(buffer->records.size());
+	if (buffer->writing || buffer->records.size() < buffer->rawBlockTarget) return Void();
+	return writeCompressedLogBlocks(logFile, buffer, blockEnd, blockSize, false);
+}
+
 ACTOR static Future<Void> updateLogBytesWritten(BackupData* self, std::vector<UID> backupUids,
                                                 std::vector<Reference<IBackupFile>> logFiles) {
 	state Reference<ReadYourWritesTransaction> tr(new ReadYourWritesTransaction(self->cx));
@@ -674,6 +740,7 @@ ACTOR Future<Void> saveMutationsToFile(BackupData* self, Version popVersion, int
 	state std::vector<Future<Reference<IBackupFile>>> logFileFutures;
 	state std::vector<Reference<IBackupFile>> logFiles;
 	state std::vector<int64_t> blockEnds;
+	state std::vector<CompressedLogBuffer> compressedBuffers; // Per log file, if BACKUP_WORKER_LOG_COMPRESSION
 	state std::vector<UID> activeUids; // active Backups' UIDs
 	state std::vector<Version> beginVersions; // logFiles' begin versions
 	state KeyRangeMap<std::set<int>> keyRangeMap; // range to index in logFileFutures, logFiles, & blockEnds
@@ -728,6 +795,9 @@ ACTOR Future<Void> saveMutationsToFile(BackupData* self, Version popVersion, int
 	}
 
 	blockEnds = std::vector<int64_t>(logFiles.size(), 0);
+	if (SERVER_KNOBS->BACKUP_WORKER_LOG_COMPRESSION) {
+		compressedBuffers = std::vector<CompressedLogBuffer>(logFiles.size(), CompressedLogBuffer(blockSize));
+	}
 	for (idx = 0; idx < numMsg; idx++) {
 		const auto& message = self->messages[idx];
 		MutationRef m;
@@ -743,8 +813,11 @@ ACTOR Future<Void> saveMutationsToFile(BackupData* self, Version popVersion, int
 		if (m.type != MutationRef::Type::ClearRange) {
 			for (int index : keyRangeMap[m.param1]) {
 				if (message.getVersion() >= beginVersions[index]) {
-					adds.push_back(
-					    addMutation(logFiles[index], message, message.message, &blockEnds[index], blockSize));
+					adds.push_back(compressedBuffers.empty()
+					                   ? addMutation(logFiles[index], message, message.message, &blockEnds[index],
+					                                 blockSize)
+					                   : addCompressedMutation(logFiles[index], &compressedBuffers[index], message,
+					                                           message.message, &blockEnds[index], blockSize));
 				}
 			}
 		} else {
@@ -761,8 +834,12 @@ ACTOR Future<Void> saveMutationsToFile(BackupData* self, Version popVersion, int
 				mutations.push_back(wr.toValue());
 				for (int index : range.value()) {
 					if (message.getVersion() >= beginVersions[index]) {
-						adds.push_back(
-						    addMutation(logFiles[index], message, mutations.back(), &blockEnds[index], blockSize));
+						adds.push_back(compressedBuffers.empty()
+						                   ? addMutation(logFiles[index], message, mutations.back(),
+						                                 &blockEnds[index], blockSize)
+						                   : addCompressedMutation(logFiles[index], &compressedBuffers[index],
+						                                           message, mutations.back(), &blockEnds[index],
+						                                           blockSize));
 					}
 				}
 			}
@@ -771,6 +848,14 @@ ACTOR Future<Void> saveMutationsToFile(BackupData* self, Version popVersion, int
 		mutations.clear();
 	}
 
+	if (!compressedBuffers.empty()) {
+		std::vector<Future<Void>> flushes;
+		for (int i = 0; i < logFiles.size(); i++) {
+			flushes.push_back(writeCompressedLogBlocks(logFiles[i], &compressedBuffers[i], &blockEnds[i], blockSize, true));
+		}
+		wait(waitForAll(flushes));
+	}
+
 	std::vector<Future<Void>> finished;
 	std::transform(logFiles.begin(), logFiles.end(), std::back_inserter(finished),
 	               [](const Reference<IBackupFile>& f) { return f->finish(); });
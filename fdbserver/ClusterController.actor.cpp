@@ -213,6 +213,45 @@ public:
 		return ( now() - startTime < 2 * FLOW_KNOBS->SERVER_REQUEST_INTERVAL ) || ( IFailureMonitor::failureMonitor().getState(worker.details.interf.storage.getEndpoint()).isAvailable() && ( !checkStable || worker.reboots < 2 ) );
 	}
 
+	void indexWorker( Optional<Key> const& processId ) {
+		unindexWorker(processId);
+		auto it = id_worker.find(processId);
+		if (it == id_worker.end()) return;
+		Optional<Key> dcId = it->second.details.interf.locality.dcId();
+		ProcessClass::ClassType classType = it->second.details.processClass.classType();
+		dc_class_workers[dcId][classType].insert(processId);
+		id_indexedAs[processId] = std::make_pair(dcId, classType);
+	}
+
+	void unindexWorker( Optional<Key> const& processId ) {
+		auto it = id_indexedAs.find(processId);
+		if (it == id_indexedAs.end()) return;
+		auto& classes = dc_class_workers[it->second.first];
+		auto& ids = classes[it->second.second];
+		ids.erase(processId);
+		if (ids.empty()) {
+			classes.erase(it->second.second);
+			if (classes.empty()) dc_class_workers.erase(it->second.first);
+		}
+		id_indexedAs.erase(it);
+	}
+
+	// Calls f on the id_worker entry of each worker in dcIds (in any datacenter if empty) whose process class has the
+	// given fitness for role.  Fitness depends only on the class, so recruitment can visit workers a fitness at a time
+	// from the best, and stop once no worker of a worse fitness could be chosen, instead of going through every worker.
+	template <class F>
+	void forEachWorkerWithFitness( std::set<Optional<Key>> const& dcIds, ProcessClass::ClusterRole role, ProcessClass::Fitness fitness, F const& f ) {
+		for (auto& dc : dc_class_workers) {
+			if (dcIds.size() && !dcIds.count(dc.first)) continue;
+			for (auto& c : dc.second) {
+				if (ProcessClass(c.first, ProcessClass::CommandLineSource).machineClassFitness(role) != fitness) continue;
+				for (auto& processId : c.second) {
+					f(*id_worker.find(processId));
+				}
+			}
+		}
+	}
+
 	bool isLongLivedStateless( Optional<Key> const& processId ) {
 		return (db.serverInfo->get().distributor.present() && db.serverInfo->get().distributor.get().locality.processId() == processId) ||
 				   (db.serverInfo->get().ratekeeper.present() && db.serverInfo->get().ratekeeper.get().locality.processId() == processId);
@@ -312,22 +351,23 @@ public:
 
 		logServerSet = Reference<LocalitySet>(new LocalityMap<WorkerDetails>());
 		logServerMap = (LocalityMap<WorkerDetails>*) logServerSet.getPtr();
-		for( auto& it : id_worker ) {
-			if (std::find(exclusionWorkerIds.begin(), exclusionWorkerIds.end(), it.second.details.interf.id()) == exclusionWorkerIds.end()) {
-				auto fitness = it.second.details.processClass.machineClassFitness(ProcessClass::TLog);
-				if (workerAvailable(it.second, checkStable) && !conf.isExcludedServer(it.second.details.interf.addresses()) && fitness != ProcessClass::NeverAssign && (!dcIds.size() || dcIds.count(it.second.details.interf.locality.dcId()))) {
-					fitness_workers[std::make_pair(fitness, it.second.details.degraded)].push_back(it.second.details);
-				}
-				else {
-					unavailableLocals.push_back(it.second.details.interf.locality);
-				}
-			}
-		}
+		auto usable = [&](WorkerInfo const& worker) {
+			return workerAvailable(worker, checkStable) && !conf.isExcludedServer(worker.details.interf.addresses());
+		};
+		auto excluded = [&](WorkerInfo const& worker) {
+			return std::find(exclusionWorkerIds.begin(), exclusionWorkerIds.end(), worker.details.interf.id()) != exclusionWorkerIds.end();
+		};
 
 		results.reserve(results.size() + id_worker.size());
 		for (int fitness = ProcessClass::BestFit; fitness != ProcessClass::NeverAssign && !bCompleted; fitness++)
 		{
 			auto fitnessEnum = (ProcessClass::Fitness) fitness;
+			// The workers of a fitness are only needed if no team could be made of the better ones
+			forEachWorkerWithFitness(dcIds, ProcessClass::TLog, fitnessEnum, [&](std::pair<const Optional<Key>, WorkerInfo> const& it) {
+				if (!excluded(it.second) && usable(it.second)) {
+					fitness_workers[std::make_pair(fitnessEnum, it.second.details.degraded)].push_back(it.second.details);
+				}
+			});
 			for(int addingDegraded = 0; addingDegraded < 2; addingDegraded++) {
 				auto workerItr = fitness_workers.find(std::make_pair(fitnessEnum,(bool)addingDegraded));
 				if (workerItr != fitness_workers.end()) {
@@ -381,6 +421,14 @@ public:
 
 		// If policy cannot be satisfied
 		if (!bCompleted) {
+			for (auto& it : id_worker) {
+				if (!excluded(it.second) &&
+				    (!usable(it.second) || it.second.details.processClass.machineClassFitness(ProcessClass::TLog) == ProcessClass::NeverAssign ||
+				     (dcIds.size() && !dcIds.count(it.second.details.interf.locality.dcId())))) {
+					unavailableLocals.push_back(it.second.details.interf.locality);
+				}
+			}
+
 			std::vector<LocalityData> tLocalities;
 			for (auto& object : logServerMap->getObjects()) {
 				tLocalities.push_back(object->interf.locality);
@@ -486,18 +534,22 @@ public:
 	WorkerFitnessInfo getWorkerForRoleInDatacenter(Optional<Standalone<StringRef>> const& dcId, ProcessClass::ClusterRole role, ProcessClass::Fitness unacceptableFitness, DatabaseConfiguration const& conf, std::map< Optional<Standalone<StringRef>>, int>& id_used, bool checkStable = false ) {
 		std::map<std::pair<ProcessClass::Fitness,int>, std::pair<vector<WorkerDetails>,vector<WorkerDetails>>> fitness_workers;
 
-		for( auto& it : id_worker ) {
-			auto fitness = it.second.details.processClass.machineClassFitness( role );
-			if(conf.isExcludedServer(it.second.details.interf.addresses())) {
-				fitness = std::max(fitness, ProcessClass::ExcludeFit);
-			}
-			if( workerAvailable(it.second, checkStable) && fitness < unacceptableFitness && it.second.details.interf.locality.dcId()==dcId ) {
-				if (isLongLivedStateless(it.first)) {
-					fitness_workers[ std::make_pair(fitness, id_used[it.first]) ].second.push_back(it.second.details);
-				} else {
-					fitness_workers[ std::make_pair(fitness, id_used[it.first]) ].first.push_back(it.second.details);
+		for (int f = ProcessClass::BestFit; f < unacceptableFitness; f++) {
+			// Exclusion only makes a worker's fitness worse, so a candidate better than f cannot be displaced
+			if (fitness_workers.size() && fitness_workers.begin()->first.first < f) break;
+			forEachWorkerWithFitness({ dcId }, role, (ProcessClass::Fitness)f, [&](std::pair<const Optional<Key>, WorkerInfo> const& it) {
+				auto fitness = (ProcessClass::Fitness)f;
+				if(conf.isExcludedServer(it.second.details.interf.addresses())) {
+					fitness = std::max(fitness, ProcessClass::ExcludeFit);
+				}
+				if( workerAvailable(it.second, checkStable) && fitness < unacceptableFitness ) {
+					if (isLongLivedStateless(it.first)) {
+						fitness_workers[ std::make_pair(fitness, id_used[it.first]) ].second.push_back(it.second.details);
+					} else {
+						fitness_workers[ std::make_pair(fitness, id_used[it.first]) ].first.push_back(it.second.details);
+					}
 				}
-			}
+			});
 		}
 
 		for( auto& it : fitness_workers ) {
@@ -528,21 +580,26 @@ public:
 			return results;
 		}
 
-		for (auto& it : id_worker) {
-			auto fitness = it.second.details.processClass.machineClassFitness( role );
-			if (workerAvailable(it.second, checkStable) &&
-			    !conf.isExcludedServer(it.second.details.interf.addresses()) &&
-			    it.second.details.interf.locality.dcId() == dcId &&
-			    (!minWorker.present() ||
-			     (it.second.details.interf.id() != minWorker.get().worker.interf.id() &&
-			      (fitness < minWorker.get().fitness ||
-			       (fitness == minWorker.get().fitness && id_used[it.first] <= minWorker.get().used))))) {
-				if (isLongLivedStateless(it.first)) {
-					fitness_workers[ std::make_pair(fitness, id_used[it.first]) ].second.push_back(it.second.details);
-				} else {
-					fitness_workers[ std::make_pair(fitness, id_used[it.first]) ].first.push_back(it.second.details);
+		int candidates = 0;
+		for (int f = ProcessClass::BestFit; f <= ProcessClass::NeverAssign; f++) {
+			// Every candidate so far is better than f, so the ones left cannot be chosen once there are enough
+			if (results.size() + candidates >= amount) break;
+			auto fitness = (ProcessClass::Fitness)f;
+			forEachWorkerWithFitness({ dcId }, role, fitness, [&](std::pair<const Optional<Key>, WorkerInfo> const& it) {
+				if (workerAvailable(it.second, checkStable) &&
+				    !conf.isExcludedServer(it.second.details.interf.addresses()) &&
+				    (!minWorker.present() ||
+				     (it.second.details.interf.id() != minWorker.get().worker.interf.id() &&
+				      (fitness < minWorker.get().fitness ||
+				       (fitness == minWorker.get().fitness && id_used[it.first] <= minWorker.get().used))))) {
+					if (isLongLivedStateless(it.first)) {
+						fitness_workers[ std::make_pair(fitness, id_used[it.first]) ].second.push_back(it.second.details);
+					} else {
+						fitness_workers[ std::make_pair(fitness, id_used[it.first]) ].first.push_back(it.second.details);
+					}
+					candidates++;
 				}
-			}
+			});
 		}
 
 		for( auto& it : fitness_workers ) {
@@ -1412,6 +1469,9 @@ public:
 	}
 
 	std::map< Optional<Standalone<StringRef>>, WorkerInfo > id_worker;
+	// The registered workers by datacenter and process class, kept up to date by indexWorker() and unindexWorker()
+	std::map<Optional<Key>, std::map<ProcessClass::ClassType, std::set<Optional<Key>>>> dc_class_workers;
+	std::map<Optional<Key>, std::pair<Optional<Key>, ProcessClass::ClassType>> id_indexedAs;
 	std::map< Optional<Standalone<StringRef>>, ProcessClass > id_class; //contains the mapping from process id to process class from the database
 	Standalone<RangeResultRef> lastProcessClasses;
 	bool gotProcessClasses;
@@ -1454,6 +1514,13 @@ public:
 	Counter getClientWorkersRequests;
 	Counter registerMasterRequests;
 	Counter statusRequests;
+	Counter cachedStatusRequests;
+
+	// The last status computed, which answers status requests until it is older than STATUS_CACHE_MAX_AGE
+	Optional<StatusReply> cachedStatus;
+	double cachedStatusTime; // When the computation of cachedStatus started
+	double lastStatusRequestTime;
+	Future<ErrorOr<StatusReply>> statusComputation;
 
 	ClusterControllerData( ClusterControllerFullInterface const& ccInterface, LocalityData const& locality )
 		: clusterControllerProcessId(locality.processId()), clusterControllerDcId(locality.dcId()),
@@ -1467,7 +1534,9 @@ public:
 			getWorkersRequests("GetWorkersRequests", clusterControllerMetrics),
 			getClientWorkersRequests("GetClientWorkersRequests", clusterControllerMetrics),
 			registerMasterRequests("RegisterMasterRequests", clusterControllerMetrics),
-			statusRequests("StatusRequests", clusterControllerMetrics)
+			statusRequests("StatusRequests", clusterControllerMetrics),
+			cachedStatusRequests("CachedStatusRequests", clusterControllerMetrics),
+			cachedStatusTime(0), lastStatusRequestTime(-std::numeric_limits<double>::infinity())
 	{
 		auto serverInfo = ServerDBInfo();
 		serverInfo.id = deterministicRandom()->randomUniqueID();
@@ -1852,6 +1921,7 @@ ACTOR Future<Void> workerAvailabilityWatch( WorkerInterface worker, ProcessClass
 					cluster->masterProcessId = Optional<Key>();
 				}
 				cluster->removedDBInfoEndpoints.insert(worker.updateServerDBInfo.getEndpoint());
+				cluster->unindexWorker( worker.locality.processId() );
 				cluster->id_worker.erase( worker.locality.processId() );
 				cluster->updateWorkerList.set( worker.locality.processId(), Optional<ProcessData>() );
 				return Void();
@@ -2119,6 +2189,7 @@ void registerWorker( RegisterWorkerRequest req, ClusterControllerData *self ) {
 
 	if( info == self->id_worker.end() ) {
 		self->id_worker[w.locality.processId()] = WorkerInfo( workerAvailabilityWatch( w, newProcessClass, self ), req.reply, req.generation, w, req.initialClass, newProcessClass, newPriorityInfo, req.degraded, req.issues );
+		self->indexWorker(w.locality.processId());
 		if (!self->masterProcessId.present() && w.locality.processId() == self->db.serverInfo->get().master.locality.processId()) {
 			self->masterProcessId = w.locality.processId();
 		}
@@ -2140,6 +2211,7 @@ void registerWorker( RegisterWorkerRequest req, ClusterControllerData *self ) {
 			info->second.details.interf = w;
 			info->second.watcher = workerAvailabilityWatch( w, newProcessClass, self );
 		}
+		self->indexWorker(w.locality.processId());
 		checkOutstandingRequests( self );
 	} else {
 		TEST(true); // Received an old worker registration request.
@@ -2258,6 +2330,83 @@ ACTOR Future<Void> timeKeeper(ClusterControllerData *self) {
 	}
 }
 
+ACTOR Future<ErrorOr<StatusReply>> computeStatus(ClusterControllerData* self, ServerCoordinators coordinators) {
+	state double start = now();
+	vector<WorkerDetails> workers;
+	std::vector<ProcessIssues> workerIssues;
+
+	for(auto& it : self->id_worker) {
+		workers.push_back(it.second.details);
+		if(it.second.issues.size()) {
+			workerIssues.push_back(ProcessIssues(it.second.details.interf.address(), it.second.issues));
+		}
+	}
+
+	std::vector<NetworkAddress> incompatibleConnections;
+	for(auto it = self->db.incompatibleConnections.begin(); it != self->db.incompatibleConnections.end();) {
+		if(it->second < now()) {
+			it = self->db.incompatibleConnections.erase(it);
+		} else {
+			incompatibleConnections.push_back(it->first);
+			it++;
+		}
+	}
+
+	state ErrorOr<StatusReply> result = wait(errorOr(clusterGetStatus(self->db.serverInfo, self->cx, workers, workerIssues, &self->db.clientStatus, coordinators, incompatibleConnections, self->datacenterVersionDifference)));
+
+	if (result.isError() && result.getError().code() == error_code_actor_cancelled)
+		throw result.getError();
+
+	if (result.present()) {
+		self->cachedStatus = result.get();
+		self->cachedStatusTime = start;
+	}
+	return result;
+}
+
+// Returns the status computation in progress, or starts one, so that at most one runs at a time
+Future<ErrorOr<StatusReply>> getStatus(ClusterControllerData* self, ServerCoordinators const& coordinators) {
+	if (!self->statusComputation.isValid() || self->statusComputation.isReady()) {
+		self->statusComputation = computeStatus(self, coordinators);
+	}
+	return self->statusComputation;
+}
+
+bool isCachedStatusFresh(ClusterControllerData* self) {
+	return self->cachedStatus.present() && now() - self->cachedStatusTime <= SERVER_KNOBS->STATUS_CACHE_MAX_AGE;
+}
+
+// The status with only the requested fields of the cluster status
+StatusReply filterStatus(StatusReply const& status, std::vector<std::string> const& sections) {
+	if (sections.empty()) {
+		return status;
+	}
+	StatusObject filtered;
+	for (auto const& section : sections) {
+		auto it = status.statusObj.find(section);
+		if (it != status.statusObj.end()) {
+			filtered[section] = it->second;
+		}
+	}
+	return StatusReply(filtered);
+}
+
+// Recomputes the cached status before it gets too old while status is being polled, so that polling is answered from
+// the cache rather than waiting for a computation.
+ACTOR Future<Void> statusCacheRefresher(ClusterControllerData* self, ServerCoordinators coordinators) {
+	if (SERVER_KNOBS->STATUS_CACHE_MAX_AGE <= 0) {
+		return Void();
+	}
+	loop {
+		wait(delay(SERVER_KNOBS->STATUS_CACHE_MAX_AGE / 2));
+		if (now() - self->lastStatusRequestTime <= SERVER_KNOBS->STATUS_CACHE_IDLE_TIMEOUT &&
+		    (!self->cachedStatus.present() ||
+		     now() - self->cachedStatusTime >= SERVER_KNOBS->STATUS_CACHE_MAX_AGE / 2)) {
+			wait(success(getStatus(self, coordinators)));
+		}
+	}
+}
+
 ACTOR Future<Void> statusServer(FutureStream< StatusRequest> requests,
 								ClusterControllerData *self,
 								ServerCoordinators coordinators)
@@ -2273,6 +2422,12 @@ ACTOR Future<Void> statusServer(FutureStream< StatusRequest> requests,
 			// Wait til first request is ready
 			StatusRequest req = waitNext(requests);
 			++self->statusRequests;
+			self->lastStatusRequestTime = now();
+			if (isCachedStatusFresh(self)) {
+				++self->cachedStatusRequests;
+				req.reply.send(filterStatus(self->cachedStatus.get(), req.sections));
+				continue;
+			}
 			requests_batch.push_back(req);
 
 			// Earliest time at which we may begin a new request
@@ -2299,30 +2454,7 @@ ACTOR Future<Void> statusServer(FutureStream< StatusRequest> requests,
 			}
 
 			// Get status but trap errors to send back to client.
-			vector<WorkerDetails> workers;
-			std::vector<ProcessIssues> workerIssues;
-
-			for(auto& it : self->id_worker) {
-				workers.push_back(it.second.details);
-				if(it.second.issues.size()) {
-					workerIssues.push_back(ProcessIssues(it.second.details.interf.address(), it.second.issues));
-				}
-			}
-
-			std::vector<NetworkAddress> incompatibleConnections;
-			for(auto it = self->db.incompatibleConnections.begin(); it != self->db.incompatibleConnections.end();) {
-				if(it->second < now()) {
-					it = self->db.incompatibleConnections.erase(it);
-				} else {
-					incompatibleConnections.push_back(it->first);
-					it++;
-				}
-			}
-
-			state ErrorOr<StatusReply> result = wait(errorOr(clusterGetStatus(self->db.serverInfo, self->cx, workers, workerIssues, &self->db.clientStatus, coordinators, incompatibleConnections, self->datacenterVersionDifference)));
-
-			if (result.isError() && result.getError().code() == error_code_actor_cancelled)
-				throw result.getError();
+			state ErrorOr<StatusReply> result = wait(getStatus(self, coordinators));
 
 			// Update last_request_time now because GetStatus is finished and the delay is to be measured between requests
 			last_request_time = now();
@@ -2332,7 +2464,7 @@ ACTOR Future<Void> statusServer(FutureStream< StatusRequest> requests,
 				if (result.isError())
 					requests_batch.back().reply.sendError(result.getError());
 				else
-					requests_batch.back().reply.send(result.get());
+					requests_batch.back().reply.send(filterStatus(result.get(), requests_batch.back().sections));
 				requests_batch.pop_back();
 				wait( yield() );
 			}
@@ -2407,6 +2539,7 @@ ACTOR Future<Void> monitorProcessClasses(ClusterControllerData *self) {
 
 						if (newProcessClass != w.second.details.processClass) {
 							w.second.details.processClass = newProcessClass;
+							self->indexWorker(w.first);
 							w.second.priorityInfo.processClassFitness = newProcessClass.machineClassFitness(ProcessClass::ClusterController);
 							if (!w.second.reply.isSet()) {
 								w.second.reply.send( RegisterWorkerReply(w.second.details.processClass, w.second.priorityInfo) );
@@ -2857,6 +2990,9 @@ ACTOR Future<Void> monitorRatekeeper(ClusterControllerData *self) {
 ACTOR Future<Void> dbInfoUpdater( ClusterControllerData* self ) {
 	state Future<Void> dbInfoChange = self->db.serverInfo->onChange();
 	state Future<Void> updateDBInfo = self->updateDBInfo.onTrigger();
+	// The fields of the last info broadcast to every worker, which the next broadcast to every worker can be a delta from
+	state std::vector<Standalone<StringRef>> lastBroadcastFields;
+	state Optional<UID> lastBroadcastId;
 	loop {
 		choose {
 			when(wait(updateDBInfo)) {
@@ -2883,9 +3019,22 @@ ACTOR Future<Void> dbInfoUpdater( ClusterControllerData* self ) {
 		dbInfoChange = self->db.serverInfo->onChange();
 		updateDBInfo = self->updateDBInfo.onTrigger();
 
-		req.serializedDbInfo = BinaryWriter::toValue(self->db.serverInfo->get(), AssumeVersion(g_network->protocolVersion()));
+		// Workers that are being sent the info because they are new or missed an update get all of it
+		if (SERVER_KNOBS->DBINFO_SEND_DELTAS && dbInfoChange.isReady()) {
+			std::vector<Standalone<StringRef>> fields = serializeServerDBInfoFields(self->db.serverInfo->get());
+			if (lastBroadcastId.present()) {
+				req.serializedDbInfo = encodeServerDBInfoDelta(lastBroadcastFields, fields);
+				req.deltaBase = lastBroadcastId;
+			} else {
+				req.serializedDbInfo = BinaryWriter::toValue(self->db.serverInfo->get(), AssumeVersion(g_network->protocolVersion()));
+			}
+			lastBroadcastFields = std::move(fields);
+			lastBroadcastId = self->db.serverInfo->get().id;
+		} else {
+			req.serializedDbInfo = BinaryWriter::toValue(self->db.serverInfo->get(), AssumeVersion(g_network->protocolVersion()));
+		}
 
-		TraceEvent("DBInfoStartBroadcast", self->id);
+		TraceEvent("DBInfoStartBroadcast", self->id).detail("Bytes", req.serializedDbInfo.size()).detail("Delta", req.deltaBase.present());
 		choose {
 			when(std::vector<Endpoint> notUpdated = wait( broadcastDBInfoRequest(req, SERVER_KNOBS->DBINFO_SEND_AMOUNT, Optional<Endpoint>(), false) )) {
 				TraceEvent("DBInfoFinishBroadcast", self->id).detail("NotUpdated", notUpdated.size());
@@ -2908,6 +3057,7 @@ ACTOR Future<Void> clusterControllerCore( ClusterControllerFullInterface interf,
 	self.addActor.send( clusterWatchDatabase( &self, &self.db ) );  // Start the master database
 	self.addActor.send( self.updateWorkerList.init( self.db.db ) );
 	self.addActor.send( statusServer( interf.clientInterface.databaseStatus.getFuture(), &self, coordinators));
+	self.addActor.send( statusCacheRefresher( &self, coordinators ) );
 	self.addActor.send( timeKeeper(&self) );
 	self.addActor.send( monitorProcessClasses(&self) );
 	self.addActor.send( monitorServerInfoConfig(&self.db) );
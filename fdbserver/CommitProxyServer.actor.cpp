@@ -20,9 +20,11 @@
 
 #include <algorithm>
 #include <tuple>
+#include <unordered_set>
 
 #include <fdbclient/DatabaseContext.h>
 #include "fdbclient/Atomic.h"
+#include "fdbclient/BackupAgent.actor.h"
 #include "fdbclient/FDBTypes.h"
 #include "fdbclient/Knobs.h"
 #include "fdbclient/CommitProxyInterface.h"
@@ -50,6 +52,10 @@
 #include "flow/Trace.h"
 #include "flow/Tracing.h"
 
+#ifdef HAVE_ZLIB
+#include <zlib.h>
+#endif
+
 #include "flow/actorcompiler.h"  // This must be the last #include.
 
 ACTOR Future<Void> broadcastTxnRequest(TxnStateRequest req, int sendAmount, bool sendReply) {
@@ -75,6 +81,50 @@ ACTOR Future<Void> broadcastTxnRequest(TxnStateRequest req, int sendAmount, bool
 	return Void();
 }
 
+void compressTxnStateRequest(TxnStateRequest& req) {
+#ifdef HAVE_ZLIB
+	if (!SERVER_KNOBS->TXN_STATE_COMPRESSION || req.data.empty()) return;
+	BinaryWriter wr(Unversioned());
+	wr << req.data;
+	uLongf compressedLen = compressBound(wr.getLength());
+	uint8_t* compressed = new (req.arena) uint8_t[compressedLen];
+	if (compress2(compressed, &compressedLen, (const Bytef*)wr.getData(), wr.getLength(), Z_BEST_SPEED) != Z_OK ||
+	    compressedLen >= wr.getLength()) {
+		return;
+	}
+	req.compressedData = StringRef(compressed, compressedLen);
+	req.uncompressedBytes = wr.getLength();
+	req.data = VectorRef<KeyValueRef>();
+#endif
+}
+
+void decompressTxnStateRequest(TxnStateRequest& req) {
+	if (!req.compressedData.size()) return;
+#ifdef HAVE_ZLIB
+	// The keys and values are left pointing into the decompressed buffer, so it has to live in the request's arena
+	uint8_t* raw = new (req.arena) uint8_t[req.uncompressedBytes];
+	uLongf rawLen = req.uncompressedBytes;
+	if (uncompress(raw, &rawLen, req.compressedData.begin(), req.compressedData.size()) != Z_OK ||
+	    rawLen != req.uncompressedBytes) {
+		TraceEvent(SevError, "TxnStateDecompressFailed").detail("Sequence", req.sequence);
+		throw internal_error();
+	}
+	ArenaReader rd(req.arena, StringRef(raw, rawLen), Unversioned());
+	rd >> req.data;
+	req.compressedData = StringRef();
+#else
+	// The master only compresses when it is built with zlib, and so is every process in the cluster
+	ASSERT(false);
+#endif
+}
+
+// Replies to a TxnStateRequest once it has been applied locally and every proxy it was relayed to has acknowledged it
+ACTOR Future<Void> replyTxnRequest(Future<Void> relayed, ReplyPromise<Void> reply) {
+	wait(relayed);
+	reply.send(Void());
+	return Void();
+}
+
 ACTOR void discardCommit(UID id, Future<LogSystemDiskQueueAdapter::CommitMessage> fcm, Future<Void> dummyCommitState) {
 	ASSERT(!dummyCommitState.isReady());
 	LogSystemDiskQueueAdapter::CommitMessage cm = wait(fcm);
@@ -188,7 +238,47 @@ struct ResolutionRequestBuilder {
 	}
 };
 
-ACTOR Future<Void> commitBatcher(ProxyCommitData *commitData, PromiseStream<std::pair<std::vector<CommitTransactionRequest>, int> > out, FutureStream<CommitTransactionRequest> in, int desiredBytes, int64_t memBytesLimit) {
+// Tunes commitBatchInterval and commitBatchByteLimit in place of the smoothing in commitBatch(), to keep p99 commit
+// latency under COMMIT_BATCH_LATENCY_TARGET with batches as large as that allows.  Each interval over the target
+// shrinks both multiplicatively and each interval under it grows them by a fixed step, so the controller settles just
+// below the target and backs off quickly when load ramps.
+ACTOR Future<Void> commitBatchController(ProxyCommitData* commitData) {
+	state double minInterval = SERVER_KNOBS->COMMIT_TRANSACTION_BATCH_INTERVAL_MIN;
+	state double maxInterval = std::max(minInterval, SERVER_KNOBS->COMMIT_TRANSACTION_BATCH_INTERVAL_MAX);
+	state int minBytes = std::min<int>(commitData->commitBatchByteLimit, SERVER_KNOBS->COMMIT_TRANSACTION_BATCH_BYTES_MIN);
+	state int maxBytes = std::max<int>(commitData->commitBatchByteLimit, SERVER_KNOBS->COMMIT_TRANSACTION_BATCH_BYTES_MAX);
+
+	loop {
+		wait(delay(SERVER_KNOBS->COMMIT_BATCH_CONTROL_INTERVAL));
+
+		int64_t samples = commitData->batchControlLatencies.getPopulationSize();
+		double p99 = samples ? commitData->batchControlLatencies.percentile(0.99) : 0;
+		const char* decision = "hold";
+		if (samples && p99 > SERVER_KNOBS->COMMIT_BATCH_LATENCY_TARGET) {
+			decision = "decrease";
+			commitData->commitBatchInterval *= SERVER_KNOBS->COMMIT_BATCH_CONTROL_BACKOFF;
+			commitData->commitBatchByteLimit *= SERVER_KNOBS->COMMIT_BATCH_CONTROL_BACKOFF;
+		} else if (samples) {
+			decision = "increase";
+			commitData->commitBatchInterval += (maxInterval - minInterval) * SERVER_KNOBS->COMMIT_BATCH_CONTROL_INCREASE;
+			commitData->commitBatchByteLimit += (maxBytes - minBytes) * SERVER_KNOBS->COMMIT_BATCH_CONTROL_INCREASE;
+		}
+		commitData->commitBatchInterval = std::max(minInterval, std::min(maxInterval, commitData->commitBatchInterval));
+		commitData->commitBatchByteLimit = std::max(minBytes, std::min(maxBytes, commitData->commitBatchByteLimit));
+		commitData->batchControlLatencies.clear();
+
+		TraceEvent("CommitBatchController", commitData->dbgid)
+		    .detail("TargetLatency", SERVER_KNOBS->COMMIT_BATCH_LATENCY_TARGET)
+		    .detail("Samples", samples)
+		    .detail("P99Latency", p99)
+		    .detail("Decision", decision)
+		    .detail("BatchInterval", commitData->commitBatchInterval)
+		    .detail("BatchBytes", commitData->commitBatchByteLimit)
+		    .trackLatest(commitData->dbgid.toString() + "/CommitBatchController");
+	}
+}
+
+ACTOR Future<Void> commitBatcher(ProxyCommitData *commitData, PromiseStream<std::pair<std::vector<CommitTransactionRequest>, int> > out, FutureStream<CommitTransactionRequest> in, int64_t memBytesLimit) {
 	wait(delayJittered(commitData->commitBatchInterval, TaskPriority::ProxyCommitBatcher));
 
 	state double lastBatch = 0;
@@ -205,7 +295,7 @@ ACTOR Future<Void> commitBatcher(ProxyCommitData *commitData, PromiseStream<std:
 			timeout = delayJittered(SERVER_KNOBS->MAX_COMMIT_BATCH_INTERVAL, TaskPriority::ProxyCommitBatcher);
 		}
 
-		while(!timeout.isReady() && !(batch.size() == SERVER_KNOBS->COMMIT_TRANSACTION_BATCH_COUNT_MAX || batchBytes >= desiredBytes)) {
+		while(!timeout.isReady() && !(batch.size() == SERVER_KNOBS->COMMIT_TRANSACTION_BATCH_COUNT_MAX || batchBytes >= commitData->commitBatchByteLimit)) {
 			choose{
 				when(CommitTransactionRequest req = waitNext(in)) {
 					//WARNING: this code is run at a high priority, so it needs to do as little work as possible
@@ -300,23 +390,49 @@ ACTOR Future<Void> addBackupMutations(ProxyCommitData* self, const std::map<Key,
 
 	// Serialize the log range mutations within the map
 	for (; logRangeMutation != logRangeMutations->cend(); ++logRangeMutation) {
-		//FIXME: this is re-implementing the serialize function of MutationListRef in order to have a yield
-		valueWriter = BinaryWriter(IncludeVersion(ProtocolVersion::withBackupMutations()));
-		valueWriter << logRangeMutation->second.totalSize();
-
-		state MutationListRef::Blob* blobIter = logRangeMutation->second.blob_begin;
-		while(blobIter) {
-			if(yieldBytes > SERVER_KNOBS->DESIRED_TOTAL_BYTES) {
-				yieldBytes = 0;
-				if(g_network->check_yield(TaskPriority::ProxyCommitYield1)) {
-					*computeDuration += g_network->timer() - *computeStart;
-					wait(delay(0, TaskPriority::ProxyCommitYield1));
-					*computeStart = g_network->timer();
+		if (SERVER_KNOBS->BACKUP_COMPACT_MUTATION_LOG) {
+			// See expandBackupLogValue() for the format
+			valueWriter = BinaryWriter(Unversioned());
+			valueWriter << (ProtocolVersion::withBackupMutations().versionWithFlags() | compactBackupMutationsFlag)
+			            << (uint32_t)0;
+
+			state MutationListRef::Iterator mutationIter = logRangeMutation->second.begin();
+			state StringRef prevParam1;
+			for (; mutationIter != logRangeMutation->second.end(); ++mutationIter) {
+				if(yieldBytes > SERVER_KNOBS->DESIRED_TOTAL_BYTES) {
+					yieldBytes = 0;
+					if(g_network->check_yield(TaskPriority::ProxyCommitYield1)) {
+						*computeDuration += g_network->timer() - *computeStart;
+						wait(delay(0, TaskPriority::ProxyCommitYield1));
+						*computeStart = g_network->timer();
+					}
 				}
+				writeCompactBackupMutation(valueWriter, *mutationIter, prevParam1);
+				prevParam1 = mutationIter->param1;
+				yieldBytes += mutationIter->expectedSize();
+			}
+
+			uint32_t compactBytes = valueWriter.getLength() - sizeof(uint64_t) - sizeof(uint32_t);
+			memcpy((uint8_t*)valueWriter.getData() + sizeof(uint64_t), &compactBytes, sizeof(uint32_t));
+		} else {
+			//FIXME: this is re-implementing the serialize function of MutationListRef in order to have a yield
+			valueWriter = BinaryWriter(IncludeVersion(ProtocolVersion::withBackupMutations()));
+			valueWriter << logRangeMutation->second.totalSize();
+
+			state MutationListRef::Blob* blobIter = logRangeMutation->second.blob_begin;
+			while(blobIter) {
+				if(yieldBytes > SERVER_KNOBS->DESIRED_TOTAL_BYTES) {
+					yieldBytes = 0;
+					if(g_network->check_yield(TaskPriority::ProxyCommitYield1)) {
+						*computeDuration += g_network->timer() - *computeStart;
+						wait(delay(0, TaskPriority::ProxyCommitYield1));
+						*computeStart = g_network->timer();
+					}
+				}
+				valueWriter.serializeBytes(blobIter->data);
+				yieldBytes += blobIter->data.size();
+				blobIter = blobIter->next;
 			}
-			valueWriter.serializeBytes(blobIter->data);
-			yieldBytes += blobIter->data.size();
-			blobIter = blobIter->next;
 		}
 
 		Key val = valueWriter.toValue();
@@ -542,6 +658,62 @@ bool canReject(const std::vector<CommitTransactionRequest>& trs) {
 	return true;
 }
 
+// Until the lease is handed back, the master gives no other proxy a version, so a lease that no batch has used up by
+// the time it runs out is returned without waiting for the next batch
+ACTOR Future<Void> releaseCommitVersionLease(ProxyCommitData* commitData, double duration) {
+	wait(delay(duration, TaskPriority::ProxyMasterVersionReply));
+	CommitVersionLease& lease = commitData->commitVersionLease;
+	if (!lease.held()) {
+		return Void();
+	}
+
+	GetCommitVersionRequest req(SpanID(), commitData->commitVersionRequestNumber++,
+	                            commitData->mostRecentProcessedRequestNumber, commitData->dbgid);
+	req.leasedVersion = lease.last;
+	req.leaseBatches = lease.batches;
+	req.releaseLease = true;
+	commitData->commitVersionLease = CommitVersionLease();
+
+	GetCommitVersionReply rep = wait(brokenPromiseToNever(
+	    commitData->master.getCommitVersion.getReply(req, TaskPriority::ProxyMasterVersionReply)));
+	commitData->mostRecentProcessedRequestNumber =
+	    std::max(commitData->mostRecentProcessedRequestNumber, rep.requestNum);
+	return Void();
+}
+
+Future<GetCommitVersionReply> requestCommitVersion(CommitBatchContext* self, SpanID spanContext) {
+	ProxyCommitData* const pProxyCommitData = self->pProxyCommitData;
+	ASSERT(pProxyCommitData->latestLocalCommitBatchVersionRequested < self->localBatchNumber);
+	pProxyCommitData->latestLocalCommitBatchVersionRequested = self->localBatchNumber;
+
+	// A batch can only take its version from the lease if the batch before it did, or was given the lease, since
+	// otherwise the previous version is not known yet
+	CommitVersionLease& lease = pProxyCommitData->commitVersionLease;
+	if (lease.held() && lease.batch == self->localBatchNumber - 1 && lease.last < lease.end && now() < lease.expires) {
+		TEST(true); // Commit version assigned from a lease
+		Version version = std::min(
+		    lease.end,
+		    std::max<Version>(lease.last + 1,
+		                      lease.start + SERVER_KNOBS->VERSIONS_PER_SECOND * (now() - lease.startTime)));
+		GetCommitVersionReply rep(version, lease.last, 0);
+		lease.last = version;
+		lease.batch = self->localBatchNumber;
+		++lease.batches;
+		return rep;
+	}
+
+	GetCommitVersionRequest req(spanContext, pProxyCommitData->commitVersionRequestNumber++,
+	                            pProxyCommitData->mostRecentProcessedRequestNumber, pProxyCommitData->dbgid);
+	if (lease.held()) {
+		req.leasedVersion = lease.last;
+		req.leaseBatches = lease.batches;
+		pProxyCommitData->commitVersionLease = CommitVersionLease();
+		pProxyCommitData->commitVersionLeaseRelease = Void();
+	}
+	return brokenPromiseToNever(
+		pProxyCommitData->master.getCommitVersion.getReply(req, TaskPriority::ProxyMasterVersionReply));
+}
+
 ACTOR Future<Void> preresolutionProcessing(CommitBatchContext* self) {
 
 	state ProxyCommitData* const pProxyCommitData = self->pProxyCommitData;
@@ -562,11 +734,23 @@ ACTOR Future<Void> preresolutionProcessing(CommitBatchContext* self) {
 		self->pProxyCommitData->lastMasterReset = now();
 	}
 
+	// While the batch just before this one is resolving, this one can already be waiting on the master for its version
+	// rather than waiting to ask.  The master replies to each proxy's requests in order, so it is safe as long as the
+	// previous batch has asked first.  A batch which has asked can no longer be rejected, since its version must be
+	// pushed, but only one batch at a time asks ahead this way.
+	state Future<GetCommitVersionReply> versionReplyFuture;
+	if (SERVER_KNOBS->PROXY_PIPELINE_COMMIT_VERSION_REQUESTS &&
+	    pProxyCommitData->latestLocalCommitBatchVersionRequested == localBatchNumber - 1 &&
+	    pProxyCommitData->latestLocalCommitBatchResolving.get() == localBatchNumber - 2) {
+		TEST(true); // Commit version requested while the previous batch is resolving
+		versionReplyFuture = requestCommitVersion(self, span.context);
+	}
+
 	// Pre-resolution the commits
 	TEST(pProxyCommitData->latestLocalCommitBatchResolving.get() < localBatchNumber - 1); // Wait for local batch
 	wait(pProxyCommitData->latestLocalCommitBatchResolving.whenAtLeast(localBatchNumber - 1));
 	double queuingDelay = g_network->now() - timeStart;
-	if ((queuingDelay > (double)SERVER_KNOBS->MAX_READ_TRANSACTION_LIFE_VERSIONS / SERVER_KNOBS->VERSIONS_PER_SECOND ||
+	if (!versionReplyFuture.isValid() && (queuingDelay > (double)SERVER_KNOBS->MAX_READ_TRANSACTION_LIFE_VERSIONS / SERVER_KNOBS->VERSIONS_PER_SECOND ||
 	     (g_network->isSimulated() && BUGGIFY_WITH_PROB(0.01))) &&
 	    SERVER_KNOBS->PROXY_REJECT_BATCH_QUEUED_TOO_LONG && canReject(trs)) {
 		// Disabled for the recovery transaction. otherwise, recovery can't finish and keeps doing more recoveries.
@@ -603,15 +787,27 @@ ACTOR Future<Void> preresolutionProcessing(CommitBatchContext* self) {
 		                      "CommitProxyServer.commitBatch.GettingCommitVersion");
 	}
 
-	GetCommitVersionRequest req(span.context, pProxyCommitData->commitVersionRequestNumber++,
-	                            pProxyCommitData->mostRecentProcessedRequestNumber, pProxyCommitData->dbgid);
-	GetCommitVersionReply versionReply = wait(brokenPromiseToNever(
-		pProxyCommitData->master.getCommitVersion.getReply(
-			req, TaskPriority::ProxyMasterVersionReply
-		)
-	));
-
-	pProxyCommitData->mostRecentProcessedRequestNumber = versionReply.requestNum;
+	if (!versionReplyFuture.isValid()) {
+		versionReplyFuture = requestCommitVersion(self, span.context);
+	}
+	GetCommitVersionReply versionReply = wait(versionReplyFuture);
+
+	pProxyCommitData->mostRecentProcessedRequestNumber =
+	    std::max(pProxyCommitData->mostRecentProcessedRequestNumber, versionReply.requestNum);
+
+	// If a later batch has already asked the master, that request hands the lease back unused
+	if (versionReply.leaseEnd > versionReply.version &&
+	    pProxyCommitData->latestLocalCommitBatchVersionRequested == localBatchNumber) {
+		CommitVersionLease& lease = pProxyCommitData->commitVersionLease;
+		lease.batch = localBatchNumber;
+		lease.start = lease.last = versionReply.version;
+		lease.end = versionReply.leaseEnd;
+		lease.startTime = now();
+		lease.expires = lease.startTime + versionReply.leaseDuration;
+		lease.batches = 0;
+		pProxyCommitData->commitVersionLeaseRelease =
+		    releaseCommitVersionLease(pProxyCommitData, versionReply.leaseDuration);
+	}
 
 	pProxyCommitData->stats.txnCommitVersionAssigned += trs.size();
 	pProxyCommitData->stats.lastCommitVersionAssigned = versionReply.version;
@@ -849,6 +1045,108 @@ ACTOR Future<Void> applyMetadataToCommittedTransactions(CommitBatchContext* self
 }
 
 /// This second pass through committed transactions assigns the actual mutations to the appropriate storage servers' tags
+// Sets out to an operand that has the effect of applying op with a and then with b, or returns false if there is none
+bool combineAtomicOperands(MutationRef::Type op, ValueRef a, ValueRef b, Arena& arena, ValueRef& out) {
+	switch (op) {
+	case MutationRef::ByteMin:
+		out = doByteMin(a, b, arena);
+		return true;
+	case MutationRef::ByteMax:
+		out = doByteMax(a, b, arena);
+		return true;
+	default:
+		break;
+	}
+
+	// The other ops resize the existing value to the length of their operand, so they only compose when the operands
+	// have the same length
+	if (a.size() != b.size() || a.size() == 0) {
+		return false;
+	}
+	switch (op) {
+	case MutationRef::AddValue:
+		out = doLittleEndianAdd(a, b, arena);
+		return true;
+	case MutationRef::And:
+	case MutationRef::AndV2:
+		out = doAnd(a, b, arena);
+		return true;
+	case MutationRef::Or:
+		out = doOr(a, b, arena);
+		return true;
+	case MutationRef::Xor:
+		out = doXor(a, b, arena);
+		return true;
+	case MutationRef::Max:
+		out = doMax(a, b, arena);
+		return true;
+	case MutationRef::Min:
+	case MutationRef::MinV2:
+		out = doMin(a, b, arena);
+		return true;
+	default:
+		return false;
+	}
+}
+
+bool canCoalesce(MutationRef const& m) {
+	if (m.param1 >= systemKeys.begin) {
+		return false;
+	}
+	switch (m.type) {
+	case MutationRef::ByteMin:
+	case MutationRef::ByteMax:
+		return true;
+	case MutationRef::AddValue:
+	case MutationRef::And:
+	case MutationRef::AndV2:
+	case MutationRef::Or:
+	case MutationRef::Xor:
+	case MutationRef::Max:
+	case MutationRef::Min:
+	case MutationRef::MinV2:
+		return m.param2.size() > 0;
+	default:
+		return false;
+	}
+}
+
+// All transactions in a batch commit at the same version, so a run of the same atomic op on the same key, with no other
+// write to that key in between, can be logged and applied as one mutation.  The first mutation of the run takes the
+// combined operand and the others become NoOps, which are not sent to the logs.
+void coalesceAtomicOps(CommitBatchContext* self) {
+	std::vector<CommitTransactionRequest>& trs = self->trs;
+	// For each key, the mutation that later ops on it may be merged into, and the arena that owns it
+	std::map<KeyRef, std::pair<MutationRef*, Arena*>> runs;
+
+	for (int t = 0; t < trs.size(); t++) {
+		if (!(self->committed[t] == ConflictBatch::TransactionCommitted && (!self->locked || trs[t].isLockAware()))) {
+			continue;
+		}
+		for (auto& m : trs[t].transaction.mutations) {
+			if (m.type == MutationRef::ClearRange) {
+				runs.erase(runs.lower_bound(m.param1), runs.lower_bound(m.param2));
+				continue;
+			}
+			auto run = runs.find(m.param1);
+			if (run != runs.end() && run->second.first->type == m.type) {
+				ValueRef combined;
+				if (combineAtomicOperands((MutationRef::Type)m.type, run->second.first->param2, m.param2,
+				                          *run->second.second, combined)) {
+					run->second.first->param2 = combined;
+					m.type = MutationRef::NoOp;
+					continue;
+				}
+			}
+			if (canCoalesce(m)) {
+				runs[m.param1] = std::make_pair(&m, &trs[t].arena);
+			} else if (run != runs.end()) {
+				runs.erase(run);
+			}
+		}
+	}
+}
+
 ACTOR Future<Void> assignMutationsToStorageServers(CommitBatchContext* self) {
 	state ProxyCommitData* const pProxyCommitData = self->pProxyCommitData;
 	state std::vector<CommitTransactionRequest>& trs = self->trs;
@@ -876,6 +1174,10 @@ ACTOR Future<Void> assignMutationsToStorageServers(CommitBatchContext* self) {
 			}
 
 			auto& m = (*pMutations)[mutationNum];
+			if (m.type == MutationRef::NoOp) {
+				// Merged into an earlier mutation by coalesceAtomicOps()
+				continue;
+			}
 			self->mutationCount++;
 			self->mutationBytes += m.expectedSize();
 			self->yieldBytes += m.expectedSize();
@@ -895,7 +1197,7 @@ ACTOR Future<Void> assignMutationsToStorageServers(CommitBatchContext* self) {
 					double prob = mul * cost / totalCosts;
 
 					if (deterministicRandom()->random01() < prob) {
-						for (const auto& ssInfo : pProxyCommitData->keyInfo[m.param1].src_info) {
+						for (const auto& ssInfo : pProxyCommitData->keyRouting[m.param1].src_info) {
 							auto id = ssInfo->interf.id();
 							// scale cost
 							cost = cost < CLIENT_KNOBS->COMMIT_SAMPLE_COST ? CLIENT_KNOBS->COMMIT_SAMPLE_COST : cost;
@@ -923,20 +1225,21 @@ ACTOR Future<Void> assignMutationsToStorageServers(CommitBatchContext* self) {
 			}
 			else if (m.type == MutationRef::ClearRange) {
 				KeyRangeRef clearRange(KeyRangeRef(m.param1, m.param2));
-				auto ranges = pProxyCommitData->keyInfo.intersectingRanges(clearRange);
-				auto firstRange = ranges.begin();
-				++firstRange;
-				if (firstRange == ranges.end()) {
+				KeyRoutingIndex& keyRouting = pProxyCommitData->keyRouting;
+				int firstRange = keyRouting.indexOf(clearRange.begin);
+				int endRange = keyRouting.lowerBound(clearRange.end);
+				if (endRange == firstRange + 1) {
 					// Fast path
-					DEBUG_MUTATION("ProxyCommit", self->commitVersion, m).detail("Dbgid", pProxyCommitData->dbgid).detail("To", ranges.begin().value().tags).detail("Mutation", m);
+					ServerCacheInfo& info = keyRouting.info(firstRange);
+					DEBUG_MUTATION("ProxyCommit", self->commitVersion, m).detail("Dbgid", pProxyCommitData->dbgid).detail("To", info.tags).detail("Mutation", m);
 
-					ranges.begin().value().populateTags();
-					self->toCommit.addTags(ranges.begin().value().tags);
+					info.populateTags();
+					self->toCommit.addTags(info.tags);
 
 					// check whether clear is sampled
 					if (checkSample && !trCost->get().clearIdxCosts.empty() &&
 					    trCost->get().clearIdxCosts[0].first == mutationNum) {
-						for (const auto& ssInfo : ranges.begin().value().src_info) {
+						for (const auto& ssInfo : info.src_info) {
 							auto id = ssInfo->interf.id();
 							pProxyCommitData->updateSSTagCost(id, trs[self->transactionNum].tagSet.get(), m,
 							                                  trCost->get().clearIdxCosts[0].second);
@@ -947,14 +1250,15 @@ ACTOR Future<Void> assignMutationsToStorageServers(CommitBatchContext* self) {
 				else {
 					TEST(true); //A clear range extends past a shard boundary
 					std::set<Tag> allSources;
-					for (auto r : ranges) {
-						r.value().populateTags();
-						allSources.insert(r.value().tags.begin(), r.value().tags.end());
+					for (int r = firstRange; r < endRange; r++) {
+						ServerCacheInfo& info = keyRouting.info(r);
+						info.populateTags();
+						allSources.insert(info.tags.begin(), info.tags.end());
 
 						// check whether clear is sampled
 						if (checkSample && !trCost->get().clearIdxCosts.empty() &&
 						    trCost->get().clearIdxCosts[0].first == mutationNum) {
-							for (const auto& ssInfo : r.value().src_info) {
+							for (const auto& ssInfo : info.src_info) {
 								auto id = ssInfo->interf.id();
 								pProxyCommitData->updateSSTagCost(id, trs[self->transactionNum].tagSet.get(), m,
 								                                  trCost->get().clearIdxCosts[0].second);
@@ -1056,6 +1360,9 @@ ACTOR Future<Void> postResolution(CommitBatchContext* self) {
 	wait(applyMetadataToCommittedTransactions(self));
 
 	// Second pass
+	if (SERVER_KNOBS->PROXY_COALESCE_ATOMIC_OPS) {
+		coalesceAtomicOps(self);
+	}
 	wait(assignMutationsToStorageServers(self));
 
 	// Serialize and backup the mutations as a single mutation
@@ -1257,6 +1564,11 @@ ACTOR Future<Void> reply(CommitBatchContext* self) {
 				}
 				// At least one keyRange index should be returned
 				ASSERT(conflictingKRIndices.size());
+				std::unordered_set<int> conflictingIds(conflictingKRIndices.begin(), conflictingKRIndices.end());
+				for (int rCRIndex : conflictingIds) {
+					pProxyCommitData->conflictHotspots.addConflicts(tr.transaction.read_conflict_ranges[rCRIndex],
+					                                                now());
+				}
 				tr.reply.send(CommitID(invalidVersion, t, Optional<Value>(),
 				                           Optional<Standalone<VectorRef<int>>>(conflictingKRIndices)));
 			} else {
@@ -1270,6 +1582,9 @@ ACTOR Future<Void> reply(CommitBatchContext* self) {
 		// TODO: filter if pipelined with large commit
 		const double duration = endTime - tr.requestTime();
 		pProxyCommitData->stats.commitLatencySample.addMeasurement(duration);
+		if (SERVER_KNOBS->COMMIT_BATCH_LATENCY_TARGET > 0) {
+			pProxyCommitData->batchControlLatencies.addSample(duration);
+		}
 		if(pProxyCommitData->latencyBandConfig.present()) {
 			bool filter = self->maxTransactionBytes > pProxyCommitData->latencyBandConfig.get().commitConfig.maxCommitBytes.orDefault(std::numeric_limits<int>::max());
 			pProxyCommitData->stats.commitLatencyBands.addMeasurement(duration, filter);
@@ -1297,13 +1612,15 @@ ACTOR Future<Void> reply(CommitBatchContext* self) {
 			TraceEvent("KeyResolverSize", pProxyCommitData->dbgid).detail("Size", pProxyCommitData->keyResolvers.size());
 	}
 
-	// Dynamic batching for commits
-	double target_latency = (now() - self->startTime) * SERVER_KNOBS->COMMIT_TRANSACTION_BATCH_INTERVAL_LATENCY_FRACTION;
-	pProxyCommitData->commitBatchInterval = std::max(
-	    SERVER_KNOBS->COMMIT_TRANSACTION_BATCH_INTERVAL_MIN,
-	    std::min(SERVER_KNOBS->COMMIT_TRANSACTION_BATCH_INTERVAL_MAX,
-	             target_latency * SERVER_KNOBS->COMMIT_TRANSACTION_BATCH_INTERVAL_SMOOTHER_ALPHA +
-	                 pProxyCommitData->commitBatchInterval * (1 - SERVER_KNOBS->COMMIT_TRANSACTION_BATCH_INTERVAL_SMOOTHER_ALPHA)));
+	// Dynamic batching for commits, unless commitBatchController is tuning it instead
+	if (SERVER_KNOBS->COMMIT_BATCH_LATENCY_TARGET <= 0) {
+		double target_latency = (now() - self->startTime) * SERVER_KNOBS->COMMIT_TRANSACTION_BATCH_INTERVAL_LATENCY_FRACTION;
+		pProxyCommitData->commitBatchInterval = std::max(
+		    SERVER_KNOBS->COMMIT_TRANSACTION_BATCH_INTERVAL_MIN,
+		    std::min(SERVER_KNOBS->COMMIT_TRANSACTION_BATCH_INTERVAL_MAX,
+		             target_latency * SERVER_KNOBS->COMMIT_TRANSACTION_BATCH_INTERVAL_SMOOTHER_ALPHA +
+		                 pProxyCommitData->commitBatchInterval * (1 - SERVER_KNOBS->COMMIT_TRANSACTION_BATCH_INTERVAL_SMOOTHER_ALPHA)));
+	}
 
 	pProxyCommitData->commitBatchesMemBytesCount -= self->currentBatchMemBytesCount;
 	ASSERT_ABORT(pProxyCommitData->commitBatchesMemBytesCount >= 0);
@@ -1505,6 +1822,17 @@ ACTOR Future<Void> ddMetricsRequestServer(CommitProxyInterface proxy, Reference<
 	}
 }
 
+ACTOR Future<Void> conflictHotspotsRequestServer(CommitProxyInterface proxy, ProxyCommitData* commitData) {
+	loop {
+		GetConflictHotspotsRequest req = waitNext(proxy.getConflictHotspots.getFuture());
+		GetConflictHotspotsReply reply;
+		for (auto const& hotspot : commitData->conflictHotspots.hottest(req.limit, now())) {
+			reply.hotspots.push_back_deep(reply.hotspots.arena(), ConflictHotspotRef(hotspot.first, hotspot.second));
+		}
+		req.reply.send(reply);
+	}
+}
+
 ACTOR Future<Void> monitorRemoteCommitted(ProxyCommitData* self) {
 	loop {
 		wait(delay(0)); //allow this actor to be cancelled if we are removed after db changes.
@@ -1754,19 +2082,23 @@ ACTOR Future<Void> commitProxyServerCore(CommitProxyInterface proxy, MasterInter
 	addActor.send(readRequestServer(proxy, addActor, &commitData));
 	addActor.send(rejoinServer(proxy, &commitData));
 	addActor.send(ddMetricsRequestServer(proxy, db));
+	addActor.send(conflictHotspotsRequestServer(proxy, &commitData));
 	addActor.send(reportTxnTagCommitCost(proxy.id(), db, &commitData.ssTrTagCommitCost));
 
 	// wait for txnStateStore recovery
 	wait(success(commitData.txnStateStore->readValue(StringRef())));
 
-	int commitBatchByteLimit =
+	commitData.commitBatchByteLimit =
 	    (int)std::min<double>(SERVER_KNOBS->COMMIT_TRANSACTION_BATCH_BYTES_MAX,
 	                          std::max<double>(SERVER_KNOBS->COMMIT_TRANSACTION_BATCH_BYTES_MIN,
 	                                           SERVER_KNOBS->COMMIT_TRANSACTION_BATCH_BYTES_SCALE_BASE *
 	                                               pow(commitData.db->get().client.commitProxies.size(),
 	                                                   SERVER_KNOBS->COMMIT_TRANSACTION_BATCH_BYTES_SCALE_POWER)));
 
-	commitBatcherActor = commitBatcher(&commitData, batchedCommits, proxy.commit.getFuture(), commitBatchByteLimit, commitBatchesMemoryLimit);
+	commitBatcherActor = commitBatcher(&commitData, batchedCommits, proxy.commit.getFuture(), commitBatchesMemoryLimit);
+	if (SERVER_KNOBS->COMMIT_BATCH_LATENCY_TARGET > 0) {
+		addActor.send(commitBatchController(&commitData));
+	}
 	loop choose{
 		when( wait( dbInfoChange ) ) {
 			dbInfoChange = commitData.db->onChange();
@@ -1808,8 +2140,14 @@ ACTOR Future<Void> commitProxyServerCore(CommitProxyInterface proxy, MasterInter
 		}
 		when(state TxnStateRequest req = waitNext(proxy.txnState.getFuture())) {
 			state ReplyPromise<Void> reply = req.reply;
+			// Relay the chunk, still compressed, before applying it, so that the proxies further down the tree do not
+			// wait on this one's processing
+			state Future<Void> relayed = broadcastTxnRequest(req, SERVER_KNOBS->TXN_STATE_SEND_AMOUNT, false);
 			if(req.last) maxSequence = req.sequence + 1;
 			if (!txnSequences.count(req.sequence)) {
+				txnSequences.insert(req.sequence);
+				decompressTxnStateRequest(req);
+
 				txnSequences.insert(req.sequence);
 
 				ASSERT(!commitData.validState.isSet()); // Although we may receive the CommitTransactionRequest for the recovery transaction before all of the TxnStateRequest, we will not get a resolution result from any resolver until the master has submitted its initial (sequence 0) resolution request, which it doesn't do until we have acknowledged all TxnStateRequests
@@ -1865,6 +2203,7 @@ ACTOR Future<Void> commitProxyServerCore(CommitProxyInterface proxy, MasterInter
 
 						//insert keyTag data separately from metadata mutations so that we can do one bulk insert which avoids a lot of map lookups.
 						commitData.keyInfo.rawInsert(keyInfoData);
+						commitData.keyRouting.invalidate();
 
 						Arena arena;
 						bool confChanges;
@@ -1880,7 +2219,7 @@ ACTOR Future<Void> commitProxyServerCore(CommitProxyInterface proxy, MasterInter
 					commitData.txnStateStore->enableSnapshot();
 				}
 			}
-			addActor.send(broadcastTxnRequest(req, SERVER_KNOBS->TXN_STATE_SEND_AMOUNT, true));
+			addActor.send(replyTxnRequest(relayed, reply));
 			wait(yield());
 		}
 	}
@@ -32,6 +32,13 @@ ConflictSet* newConflictSet();
 void clearConflictSet(ConflictSet*, Version);
 void destroyConflictSet(ConflictSet*);
 
+// By default each detectConflicts call removes some of the history that has aged out of the MVCC window.  With
+// inlinePrune false it only advances the window, and the owner must call pruneConflictSet to remove the history.
+void setConflictSetInlinePrune(ConflictSet*, bool inlinePrune);
+// Examines up to nodeCount entries of history, removing those too old to conflict with anything.  Returns true when
+// a pass over the whole history is complete.
+bool pruneConflictSet(ConflictSet*, int nodeCount);
+
 struct ConflictBatch {
 	explicit ConflictBatch(ConflictSet*, std::map<int, VectorRef<int>>* conflictingKeyRangeMap = nullptr,
 	                       Arena* resolveBatchReplyArena = nullptr);
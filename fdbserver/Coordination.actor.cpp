@@ -206,53 +206,46 @@ TEST_CASE("/fdbserver/Coordination/localGenerationReg/simple") {
 	return Void();
 }
 
-ACTOR Future<Void> openDatabase(ClientData* db, int* clientCount, Reference<AsyncVar<bool>> hasConnectedClients, OpenDatabaseCoordRequest req) {
-	++(*clientCount);
-	hasConnectedClients->set(true);
-	
-	if(req.supportedVersions.size() > 0) {
-		db->clientStatusInfoMap[req.reply.getEndpoint().getPrimaryAddress()] = ClientStatusInfo(req.traceLogGroup, req.supportedVersions, req.issues);
+void sendClientInfo(ClientData& clientData, OpenDatabaseCoordRequest& req) {
+	if (req.supportedVersions.size() > 0) {
+		clientData.clientStatusInfoMap.erase(req.reply.getEndpoint().getPrimaryAddress());
 	}
-
-	while (db->clientInfo->get().read().id == req.knownClientInfoID && !db->clientInfo->get().read().forward.present()) {
-		choose {
-			when (wait( yieldedFuture(db->clientInfo->onChange()) )) {}
-			when (wait( delayJittered( SERVER_KNOBS->CLIENT_REGISTER_INTERVAL ) )) { break; }  // The client might be long gone!
-		}
-	}
-
-	if(req.supportedVersions.size() > 0) {
-		db->clientStatusInfoMap.erase(req.reply.getEndpoint().getPrimaryAddress());
-	}
-
-	req.reply.send( db->clientInfo->get() );
-
-	if(--(*clientCount) == 0) {
-		hasConnectedClients->set(false);
-	}
-
-	return Void();
+	req.reply.send(clientData.clientInfo->get());
 }
 
-ACTOR Future<Void> remoteMonitorLeader( int* clientCount, Reference<AsyncVar<bool>> hasConnectedClients, Reference<AsyncVar<Optional<LeaderInfo>>> currentElectedLeader, ElectionResultRequest req ) {
-	++(*clientCount);
-	hasConnectedClients->set(true);
-
-	while (!currentElectedLeader->get().present() || req.knownLeader == currentElectedLeader->get().get().changeID) {
-		choose {
-			when (wait( yieldedFuture(currentElectedLeader->onChange()) ) ) {}
-			when (wait( delayJittered( SERVER_KNOBS->CLIENT_REGISTER_INTERVAL ) )) { break; }
+// Long polls waiting for a value, such as the client info or the elected leader, to change. Rather than an actor and a
+// timer per request, every waiting request is answered at once when the value changes, and the rest are answered once
+// they have waited CLIENT_REGISTER_INTERVAL, since the requester might be long gone.
+template <class Request>
+struct LongPollWaiters {
+	Deque<std::pair<double, Request>> waiting; // In arrival order
+
+	void add(Request req) { waiting.emplace_back(now(), std::move(req)); }
+
+	// Removes and calls `send` on each request for which `isAnswered` is true
+	template <class P, class F>
+	void answer(P&& isAnswered, F&& send) {
+		Deque<std::pair<double, Request>> stillWaiting;
+		for (int i = 0; i < waiting.size(); i++) {
+			if (isAnswered(waiting[i].second)) {
+				send(waiting[i].second);
+			} else {
+				stillWaiting.push_back(std::move(waiting[i]));
+			}
 		}
+		waiting = std::move(stillWaiting);
 	}
 
-	req.reply.send( currentElectedLeader->get() );
-
-	if(--(*clientCount) == 0) {
-		hasConnectedClients->set(false);
+	template <class F>
+	void answerExpired(F&& send) {
+		while (!waiting.empty() && now() - waiting.front().first >= SERVER_KNOBS->CLIENT_REGISTER_INTERVAL) {
+			send(waiting.front().second);
+			waiting.pop_front();
+		}
 	}
 
-	return Void();
-}
+	size_t size() const { return waiting.size(); }
+};
 
 // This actor implements a *single* leader-election register (essentially, it ignores
 // the .key member of each request).  It returns any time the leader election is in the
@@ -267,13 +260,17 @@ ACTOR Future<Void> leaderRegister(LeaderElectionRegInterface interf, Key key) {
 	state int leaderIntervalCount = 0;
 	state Future<Void> notifyCheck = delay(SERVER_KNOBS->NOTIFICATION_FULL_CLEAR_TIME / SERVER_KNOBS->MIN_NOTIFICATIONS);
 	state ClientData clientData;
-	state int clientCount = 0;
+	state LongPollWaiters<OpenDatabaseCoordRequest> openDatabaseWaiters;
+	state LongPollWaiters<ElectionResultRequest> electionResultWaiters;
 	state Reference<AsyncVar<bool>> hasConnectedClients = makeReference<AsyncVar<bool>>(false);
-	state ActorCollection actors(false);
 	state Future<Void> leaderMon;
 	state AsyncVar<Value> leaderInterface;
 	state Reference<AsyncVar<Optional<LeaderInfo>>> currentElectedLeader =
 	    makeReference<AsyncVar<Optional<LeaderInfo>>>();
+	state Future<Void> clientInfoChange = clientData.clientInfo->onChange();
+	state Future<Void> electedLeaderChange = currentElectedLeader->onChange();
+	state Future<Void> longPollCheck = delay(SERVER_KNOBS->COORDINATOR_LONG_POLL_CHECK_INTERVAL);
+	state Future<Void> connectedClientsChange = hasConnectedClients->onChange();
 
 	loop choose {
 		when ( OpenDatabaseCoordRequest req = waitNext( interf.openDatabase.getFuture() ) ) {
@@ -283,7 +280,11 @@ ACTOR Future<Void> leaderRegister(LeaderElectionRegInterface interf, Key key) {
 				if(!leaderMon.isValid()) {
 					leaderMon = monitorLeaderForProxies(req.clusterKey, req.coordinators, &clientData, currentElectedLeader);
 				}
-				actors.add(openDatabase(&clientData, &clientCount, hasConnectedClients, req));
+				if(req.supportedVersions.size() > 0) {
+					clientData.clientStatusInfoMap[req.reply.getEndpoint().getPrimaryAddress()] = ClientStatusInfo(req.traceLogGroup, req.supportedVersions, req.issues);
+				}
+				openDatabaseWaiters.add(req);
+				hasConnectedClients->set(true);
 			}
 		}
 		when ( ElectionResultRequest req = waitNext( interf.electionResult.getFuture() ) ) {
@@ -293,9 +294,33 @@ ACTOR Future<Void> leaderRegister(LeaderElectionRegInterface interf, Key key) {
 				if(!leaderMon.isValid()) {
 					leaderMon = monitorLeaderForProxies(req.key, req.coordinators, &clientData, currentElectedLeader);
 				}
-				actors.add(remoteMonitorLeader(&clientCount, hasConnectedClients, currentElectedLeader, req));
+				electionResultWaiters.add(req);
+				hasConnectedClients->set(true);
 			}
 		}
+		when ( wait( clientInfoChange ) ) {
+			clientInfoChange = clientData.clientInfo->onChange();
+			ClientData* data = &clientData;
+			auto const& info = clientData.clientInfo->get().read();
+			openDatabaseWaiters.answer([&info](OpenDatabaseCoordRequest const& req) { return info.id != req.knownClientInfoID || info.forward.present(); },
+			                           [data](OpenDatabaseCoordRequest& req) { sendClientInfo(*data, req); });
+			hasConnectedClients->set(openDatabaseWaiters.size() + electionResultWaiters.size() > 0);
+		}
+		when ( wait( electedLeaderChange ) ) {
+			electedLeaderChange = currentElectedLeader->onChange();
+			auto const& leader = currentElectedLeader->get();
+			electionResultWaiters.answer([&leader](ElectionResultRequest const& req) { return leader.present() && req.knownLeader != leader.get().changeID; },
+			                             [&leader](ElectionResultRequest& req) { req.reply.send(leader); });
+			hasConnectedClients->set(openDatabaseWaiters.size() + electionResultWaiters.size() > 0);
+		}
+		when ( wait( longPollCheck ) ) {
+			longPollCheck = delay(SERVER_KNOBS->COORDINATOR_LONG_POLL_CHECK_INTERVAL);
+			ClientData* data = &clientData;
+			Optional<LeaderInfo> leader = currentElectedLeader->get();
+			openDatabaseWaiters.answerExpired([data](OpenDatabaseCoordRequest& req) { sendClientInfo(*data, req); });
+			electionResultWaiters.answerExpired([&leader](ElectionResultRequest& req) { req.reply.send(leader); });
+			hasConnectedClients->set(openDatabaseWaiters.size() + electionResultWaiters.size() > 0);
+		}
 		when ( GetLeaderRequest req = waitNext( interf.getLeader.getFuture() ) ) {
 			if (currentNominee.present() && currentNominee.get().changeID != req.knownLeader) {
 				req.reply.send( currentNominee.get() );
@@ -407,13 +432,13 @@ ACTOR Future<Void> leaderRegister(LeaderElectionRegInterface interf, Key key) {
 				notify.pop_front();
 			}
 		}
-		when( wait(hasConnectedClients->onChange()) ) {
+		when( wait(connectedClientsChange) ) {
+			connectedClientsChange = hasConnectedClients->onChange();
 			if(!hasConnectedClients->get() && !nextInterval.isValid()) {
 				TraceEvent("LeaderRegisterUnneeded").detail("Key", key);
 				return Void();
 			}
 		}
-		when( wait(actors.getResult()) ) {}
 	}
 }
 
@@ -241,6 +241,13 @@ public:
 		return (physicalBytes + (inflightPenalty*inFlightBytes)) * availableSpaceMultiplier;
 	}
 
+	int64_t getReadBandwidth() const override {
+		return getAverage([](StorageMetrics const& load) { return load.bytesReadPerKSecond; });
+	}
+	int64_t getWriteBandwidth() const override {
+		return getAverage([](StorageMetrics const& load) { return load.bytesPerKSecond; });
+	}
+
 	int64_t getMinAvailableSpace(bool includeInFlight = true) const override {
 		int64_t minAvailableSpace = std::numeric_limits<int64_t>::max();
 		for (const auto& server : servers) {
@@ -320,18 +327,23 @@ public:
 private:
 	// Calculate an "average" of the metrics replies that we received.  Penalize teams from which we did not receive all replies.
 	int64_t getLoadAverage() const {
-		int64_t bytesSum = 0;
+		return getAverage([](StorageMetrics const& load) { return load.bytes; });
+	}
+
+	template <class F>
+	int64_t getAverage(F metric) const {
+		int64_t sum = 0;
 		int added = 0;
 		for(int i=0; i<servers.size(); i++)
 			if( servers[i]->serverMetrics.present() ) {
 				added++;
-				bytesSum += servers[i]->serverMetrics.get().load.bytes;
+				sum += metric(servers[i]->serverMetrics.get().load);
 			}
 
 		if( added < servers.size() )
-			bytesSum *= 2;
+			sum *= 2;
 
-		return added == 0 ? 0 : bytesSum / added;
+		return added == 0 ? 0 : sum / added;
 	}
 
 	// Calculate the max of the metrics replies that we received.
@@ -546,6 +558,57 @@ ACTOR Future<Void> storageServerTracker(struct DDTeamCollection* self, Database
 
 Future<Void> teamTracker(struct DDTeamCollection* const& self, Reference<TCTeamInfo> const& team, bool const& badTeam, bool const& redundantTeam);
 
+// Servers or machines bucketed by how many teams they are on, so that team building can find the least used ones and
+// update the members of each team it adds without rescanning every server in the cluster for each team
+template <class K, class V>
+class TeamCountIndex {
+public:
+	void set(K const& key, V const& value, int count) {
+		erase(key);
+		auto& bucket = buckets[count];
+		positions[key] = std::make_pair(count, (int)bucket.size());
+		bucket.emplace_back(key, value);
+	}
+
+	// Moves an indexed key to a new count; keys that were never set are ignored
+	void update(K const& key, int count) {
+		auto p = positions.find(key);
+		if (p == positions.end() || p->second.first == count) return;
+		V value = buckets[p->second.first][p->second.second].second;
+		set(key, value, count);
+	}
+
+	bool empty() const { return positions.empty(); }
+	int size() const { return positions.size(); }
+	int minCount() const {
+		ASSERT(!empty());
+		return buckets.begin()->first;
+	}
+	std::vector<std::pair<K, V>> const& leastUsed() const {
+		ASSERT(!empty());
+		return buckets.begin()->second;
+	}
+
+private:
+	void erase(K const& key) {
+		auto p = positions.find(key);
+		if (p == positions.end()) return;
+		auto b = buckets.find(p->second.first);
+		auto& bucket = b->second;
+		int i = p->second.second;
+		if (i + 1 < bucket.size()) {
+			bucket[i] = std::move(bucket.back());
+			positions[bucket[i].first].second = i;
+		}
+		bucket.pop_back();
+		if (bucket.empty()) buckets.erase(b);
+		positions.erase(p);
+	}
+
+	std::map<int, std::vector<std::pair<K, V>>> buckets; // Never holds an empty bucket
+	std::map<K, std::pair<int, int>> positions; // key -> (count, index in its bucket)
+};
+
 struct DDTeamCollection : ReferenceCounted<DDTeamCollection> {
 	// clang-format off
 	enum { REQUESTING_WORKER = 0, GETTING_WORKER = 1, GETTING_STORAGE = 2 };
@@ -617,6 +680,7 @@ struct DDTeamCollection : ReferenceCounted<DDTeamCollection> {
 
 	Reference<LocalitySet> storageServerSet;
 	std::vector<LocalityEntry> forcedEntries, resultEntries;
+	PolicyValidationCache storagePolicyCache; // Which patterns of localities make a team satisfying storagePolicy
 
 	std::vector<DDTeamCollection*> teamCollections;
 	AsyncVar<Optional<Key>> healthyZone;
@@ -642,7 +706,6 @@ struct DDTeamCollection : ReferenceCounted<DDTeamCollection> {
 
 	bool satisfiesPolicy(const std::vector<Reference<TCServerInfo>>& team, int amount = -1) {
 		forcedEntries.clear();
-		resultEntries.clear();
 		if(amount == -1) {
 			amount = team.size();
 		}
@@ -651,8 +714,7 @@ struct DDTeamCollection : ReferenceCounted<DDTeamCollection> {
 			forcedEntries.push_back(team[i]->localityEntry);
 		}
 
-		bool result = storageServerSet->selectReplicas(configuration.storagePolicy, forcedEntries, resultEntries);
-		return result && resultEntries.size() == 0;
+		return storagePolicyCache.validate(forcedEntries, storageServerSet);
 	}
 
 	DDTeamCollection(Database const& cx, UID distributorId, MoveKeysLock const& lock,
@@ -669,7 +731,7 @@ struct DDTeamCollection : ReferenceCounted<DDTeamCollection> {
 	    checkTeamDelay(delay(SERVER_KNOBS->CHECK_TEAM_DELAY, TaskPriority::DataDistribution)),
 	    initialFailureReactionDelay(
 	        delayed(readyToStart, SERVER_KNOBS->INITIAL_FAILURE_REACTION_DELAY, TaskPriority::DataDistribution)),
-	    healthyTeamCount(0), storageServerSet(new LocalityMap<UID>()),
+	    healthyTeamCount(0), storageServerSet(new LocalityMap<UID>()), storagePolicyCache(configuration.storagePolicy),
 	    initializationDoneActor(logOnCompletion(readyToStart && initialFailureReactionDelay, this)),
 	    optimalTeamCount(0), recruitingStream(0), restartRecruiting(SERVER_KNOBS->DEBOUNCE_RECRUITING_DELAY),
 	    unhealthyServers(0), includedDCs(includedDCs), otherTrackedDCs(otherTrackedDCs),
@@ -886,7 +948,7 @@ struct DDTeamCollection : ReferenceCounted<DDTeamCollection> {
 					if (self->teams[currentIndex]->isHealthy() &&
 					    (!req.preferLowerUtilization || self->teams[currentIndex]->hasHealthyAvailableSpace(self->medianAvailableSpace)))
 					{
-						int64_t loadBytes = self->teams[currentIndex]->getLoadBytes(true, req.inflightPenalty);
+						int64_t loadBytes = req.getLoad(*self->teams[currentIndex]);
 						if((!bestOption.present() || (req.preferLowerUtilization && loadBytes < bestLoadBytes) || (!req.preferLowerUtilization && loadBytes > bestLoadBytes)) &&
 						    (!req.teamMustHaveShards || self->shardsAffectedByTeamFailure->hasShards(ShardsAffectedByTeamFailure::Team(self->teams[currentIndex]->getServerIDs(), self->primary)))) 
 						{
@@ -929,7 +991,7 @@ struct DDTeamCollection : ReferenceCounted<DDTeamCollection> {
 				}
 
 				for( int i = 0; i < randomTeams.size(); i++ ) {
-					int64_t loadBytes = randomTeams[i]->getLoadBytes(true, req.inflightPenalty);
+					int64_t loadBytes = req.getLoad(*randomTeams[i]);
 					if( !bestOption.present() || ( req.preferLowerUtilization && loadBytes < bestLoadBytes ) || ( !req.preferLowerUtilization && loadBytes > bestLoadBytes ) ) {
 						bestLoadBytes = loadBytes;
 						bestOption = randomTeams[i];
@@ -1550,36 +1612,32 @@ struct DDTeamCollection : ReferenceCounted<DDTeamCollection> {
 		// Step 1: Create machineLocalityMap which will be used in building machine team
 		rebuildMachineLocalityMap();
 
-		// Add a team in each iteration
-		while (addedMachineTeams < machineTeamsToBuild || notEnoughMachineTeamsForAMachine()) {
-			// Step 2: Get least used machines from which we choose machines as a machine team
-			std::vector<Reference<TCMachineInfo>> leastUsedMachines; // A less used machine has less number of teams
-			int minTeamCount = std::numeric_limits<int>::max();
-			for (auto& machine : machine_info) {
-				// Skip invalid machine whose representative server is not in server_info
-				ASSERT_WE_THINK(server_info.find(machine.second->serversOnMachine[0]->id) != server_info.end());
-				// Skip unhealthy machines
-				if (!isMachineHealthy(machine.second)) continue;
-				// Skip machine with incomplete locality
-				if (!isValidLocality(configuration.storagePolicy,
-				                     machine.second->serversOnMachine[0]->lastKnownInterface.locality)) {
-					continue;
-				}
-
-				// Invariant: We only create correct size machine teams.
-				// When configuration (e.g., team size) is changed, the DDTeamCollection will be destroyed and rebuilt
-				// so that the invariant will not be violated.
-				int teamCount = machine.second->machineTeams.size();
+		// Step 2: Index the machines by their number of machine teams, from which we choose the least used machines.
+		// Health and locality do not change while this runs, so only the members of each added team need updating.
+		// candidateMachines are those a team may be built around; healthyMachines are those that need enough teams.
+		TeamCountIndex<Standalone<StringRef>, Reference<TCMachineInfo>> candidateMachines, healthyMachines;
+		for (auto& machine : machine_info) {
+			// Skip invalid machine whose representative server is not in server_info
+			ASSERT_WE_THINK(server_info.find(machine.second->serversOnMachine[0]->id) != server_info.end());
+			// Skip unhealthy machines
+			if (!isMachineHealthy(machine.second)) continue;
 
-				if (teamCount < minTeamCount) {
-					leastUsedMachines.clear();
-					minTeamCount = teamCount;
-				}
-				if (teamCount == minTeamCount) {
-					leastUsedMachines.push_back(machine.second);
-				}
+			// Invariant: We only create correct size machine teams.
+			// When configuration (e.g., team size) is changed, the DDTeamCollection will be destroyed and rebuilt
+			// so that the invariant will not be violated.
+			int teamCount = machine.second->machineTeams.size();
+			healthyMachines.set(machine.first, machine.second, teamCount);
+			// Skip machine with incomplete locality
+			if (isValidLocality(configuration.storagePolicy,
+			                    machine.second->serversOnMachine[0]->lastKnownInterface.locality)) {
+				candidateMachines.set(machine.first, machine.second, teamCount);
 			}
+		}
+		int targetMachineTeamNumPerMachine = getTargetMachineTeamNumPerMachine();
 
+		// Add a team in each iteration
+		while (addedMachineTeams < machineTeamsToBuild ||
+		       (!healthyMachines.empty() && healthyMachines.minCount() < targetMachineTeamNumPerMachine)) {
 			std::vector<UID*> team;
 			std::vector<LocalityEntry> forcedAttributes;
 
@@ -1591,10 +1649,11 @@ struct DDTeamCollection : ReferenceCounted<DDTeamCollection> {
 				// Step 3: Create a representative process for each machine.
 				// Construct forcedAttribute from leastUsedMachines.
 				// We will use forcedAttribute to call existing function to form a team
-				if (leastUsedMachines.size()) {
+				if (!candidateMachines.empty()) {
 					forcedAttributes.clear();
 					// Randomly choose 1 least used machine
-					Reference<TCMachineInfo> tcMachineInfo = deterministicRandom()->randomChoice(leastUsedMachines);
+					auto const& leastUsedMachines = candidateMachines.leastUsed();
+					Reference<TCMachineInfo> tcMachineInfo = deterministicRandom()->randomChoice(leastUsedMachines).second;
 					ASSERT(!tcMachineInfo->serversOnMachine.empty());
 					LocalityEntry process = tcMachineInfo->localityEntry;
 					forcedAttributes.push_back(process);
@@ -1669,6 +1728,10 @@ struct DDTeamCollection : ReferenceCounted<DDTeamCollection> {
 
 				addMachineTeam(machines);
 				addedMachineTeams++;
+				for (auto& machine : machines) {
+					candidateMachines.update(machine->machineID, machine->machineTeams.size());
+					healthyMachines.update(machine->machineID, machine->machineTeams.size());
+				}
 			} else {
 				traceAllInfo(true);
 				TraceEvent(SevWarn, "DataDistributionBuildTeams", distributorId)
@@ -1727,33 +1790,17 @@ struct DDTeamCollection : ReferenceCounted<DDTeamCollection> {
 		return false;
 	}
 
-	// Return the healthy server with the least number of correct-size server teams
-	Reference<TCServerInfo> findOneLeastUsedServer() {
-		vector<Reference<TCServerInfo>> leastUsedServers;
-		int minTeams = std::numeric_limits<int>::max();
-		for (auto& server : server_info) {
-			// Only pick healthy server, which is not failed or excluded.
-			if (server_status.get(server.first).isUnhealthy()) continue;
-			if (!isValidLocality(configuration.storagePolicy, server.second->lastKnownInterface.locality)) continue;
-
-			int numTeams = server.second->teams.size();
-			if (numTeams < minTeams) {
-				minTeams = numTeams;
-				leastUsedServers.clear();
-			}
-			if (minTeams == numTeams) {
-				leastUsedServers.push_back(server.second);
-			}
-		}
-
-		if (leastUsedServers.empty()) {
+	// Return the healthy server with the least number of correct-size server teams, from an index of the healthy
+	// servers with valid locality
+	Reference<TCServerInfo> findOneLeastUsedServer(TeamCountIndex<UID, Reference<TCServerInfo>> const& candidates) {
+		if (candidates.empty()) {
 			// If we cannot find a healthy server with valid locality
 			TraceEvent("NoHealthyAndValidLocalityServers")
 				.detail("Servers", server_info.size())
 				.detail("UnhealthyServers", unhealthyServers);
 			return Reference<TCServerInfo>();
 		} else {
-			return deterministicRandom()->randomChoice(leastUsedServers);
+			return deterministicRandom()->randomChoice(candidates.leastUsed()).second;
 		}
 	}
 
@@ -1959,15 +2006,18 @@ struct DDTeamCollection : ReferenceCounted<DDTeamCollection> {
 		return healthyTeamCount;
 	}
 
+	int getTargetMachineTeamNumPerMachine() const {
+		// If we want to remove the machine team with most machine teams, we use the same logic as
+		// notEnoughTeamsForAServer
+		return SERVER_KNOBS->TR_FLAG_REMOVE_MT_WITH_MOST_TEAMS
+		           ? (SERVER_KNOBS->DESIRED_TEAMS_PER_SERVER * (configuration.storageTeamSize + 1)) / 2
+		           : SERVER_KNOBS->DESIRED_TEAMS_PER_SERVER;
+	}
+
 	// Each machine is expected to have targetMachineTeamNumPerMachine
 	// Return true if there exists a machine that does not have enough teams.
 	bool notEnoughMachineTeamsForAMachine() {
-		// If we want to remove the machine team with most machine teams, we use the same logic as
-		// notEnoughTeamsForAServer
-		int targetMachineTeamNumPerMachine =
-		    SERVER_KNOBS->TR_FLAG_REMOVE_MT_WITH_MOST_TEAMS
-		        ? (SERVER_KNOBS->DESIRED_TEAMS_PER_SERVER * (configuration.storageTeamSize + 1)) / 2
-		        : SERVER_KNOBS->DESIRED_TEAMS_PER_SERVER;
+		int targetMachineTeamNumPerMachine = getTargetMachineTeamNumPerMachine();
 		for (auto& m : machine_info) {
 			// If SERVER_KNOBS->TR_FLAG_REMOVE_MT_WITH_MOST_TEAMS is false,
 			// The desired machine team number is not the same with the desired server team number
@@ -1981,9 +2031,7 @@ struct DDTeamCollection : ReferenceCounted<DDTeamCollection> {
 		return false;
 	}
 
-	// Each server is expected to have targetTeamNumPerServer teams.
-	// Return true if there exists a server that does not have enough teams.
-	bool notEnoughTeamsForAServer() {
+	int getTargetTeamNumPerServer() const {
 		// We build more teams than we finally want so that we can use serverTeamRemover() actor to remove the teams
 		// whose member belong to too many teams. This allows us to get a more balanced number of teams per server.
 		// We want to ensure every server has targetTeamNumPerServer teams.
@@ -1993,6 +2041,13 @@ struct DDTeamCollection : ReferenceCounted<DDTeamCollection> {
 		// (#servers * DESIRED_TEAMS_PER_SERVER * storageTeamSize) / #servers.
 		int targetTeamNumPerServer = (SERVER_KNOBS->DESIRED_TEAMS_PER_SERVER * (configuration.storageTeamSize + 1)) / 2;
 		ASSERT(targetTeamNumPerServer > 0);
+		return targetTeamNumPerServer;
+	}
+
+	// Each server is expected to have targetTeamNumPerServer teams.
+	// Return true if there exists a server that does not have enough teams.
+	bool notEnoughTeamsForAServer() {
+		int targetTeamNumPerServer = getTargetTeamNumPerServer();
 		for (auto& s : server_info) {
 			if (s.second->teams.size() < targetTeamNumPerServer && !server_status.get(s.first).isUnhealthy()) {
 				return true;
@@ -2037,7 +2092,23 @@ struct DDTeamCollection : ReferenceCounted<DDTeamCollection> {
 			addedMachineTeams = addBestMachineTeams(machineTeamsToBuild);
 		}
 
-		while (addedTeams < teamsToBuild || notEnoughTeamsForAServer()) {
+		// Index the servers by their number of teams, so that each team added only updates its own members rather
+		// than every server being rescanned for each team. Server health does not change while this runs.
+		// candidateServers are the healthy servers with valid locality that a team may be built around.
+		TeamCountIndex<UID, Reference<TCServerInfo>> candidateServers, healthyServers;
+		for (auto& server : server_info) {
+			// Only pick healthy server, which is not failed or excluded.
+			if (server_status.get(server.first).isUnhealthy()) continue;
+			int numTeams = server.second->teams.size();
+			healthyServers.set(server.first, server.second, numTeams);
+			if (isValidLocality(configuration.storagePolicy, server.second->lastKnownInterface.locality)) {
+				candidateServers.set(server.first, server.second, numTeams);
+			}
+		}
+		int targetTeamNumPerServer = getTargetTeamNumPerServer();
+
+		while (addedTeams < teamsToBuild ||
+		       (!healthyServers.empty() && healthyServers.minCount() < targetTeamNumPerServer)) {
 			// Step 1: Create 1 best machine team
 			std::vector<UID> bestServerTeam;
 			int bestScore = std::numeric_limits<int>::max();
@@ -2045,7 +2116,7 @@ struct DDTeamCollection : ReferenceCounted<DDTeamCollection> {
 			bool earlyQuitBuild = false;
 			for (int i = 0; i < maxAttempts && i < 100; ++i) {
 				// Step 2: Choose 1 least used server and then choose 1 least used machine team from the server
-				Reference<TCServerInfo> chosenServer = findOneLeastUsedServer();
+				Reference<TCServerInfo> chosenServer = findOneLeastUsedServer(candidateServers);
 				if (!chosenServer.isValid()) {
 					TraceEvent(SevWarn, "NoValidServer").detail("Primary", primary);
 					earlyQuitBuild = true;
@@ -2126,6 +2197,11 @@ struct DDTeamCollection : ReferenceCounted<DDTeamCollection> {
 			// Step 4: Add the server team
 			addTeam(bestServerTeam.begin(), bestServerTeam.end(), false);
 			addedTeams++;
+			for (auto& id : bestServerTeam) {
+				int numTeams = server_info[id]->teams.size();
+				candidateServers.update(id, numTeams);
+				healthyServers.update(id, numTeams);
+			}
 		}
 
 		healthyMachineTeamCount = getHealthyMachineTeamCount();
@@ -3781,12 +3857,16 @@ ACTOR Future<Void> keyValueStoreTypeTracker(DDTeamCollection* self, TCServerInfo
 ACTOR Future<Void> waitForAllDataRemoved( Database cx, UID serverID, Version addedVersion, DDTeamCollection* teams ) {
 	state Transaction tr(cx);
 	loop {
+		// The data distributor knows how many shards are still assigned to the server, so only read serverKeys
+		// once that count has dropped to zero instead of scanning it on every poll while the server drains.
+		wait(teams->shardsAffectedByTeamFailure->onNoShards(serverID));
 		try {
 			tr.setOption(FDBTransactionOptions::PRIORITY_SYSTEM_IMMEDIATE);
 			Version ver = wait( tr.getReadVersion() );
 
 			//we cannot remove a server immediately after adding it, because a perfectly timed master recovery could cause us to not store the mutations sent to the short lived storage server.
-			if(ver > addedVersion + SERVER_KNOBS->MAX_READ_TRANSACTION_LIFE_VERSIONS) {
+			if(ver > addedVersion + SERVER_KNOBS->MAX_READ_TRANSACTION_LIFE_VERSIONS &&
+			   teams->shardsAffectedByTeamFailure->getNumberOfShards(serverID) == 0) {
 				bool canRemove = wait( canRemoveStorageServer( &tr, serverID ) );
 				// TraceEvent("WaitForAllDataRemoved")
 				//     .detail("Server", serverID)
@@ -5529,6 +5609,30 @@ TEST_CASE("DataDistribution/AddTeamsBestOf/NotUseMachineID") {
 	return Void();
 }
 
+TEST_CASE("DataDistribution/AddTeamsBestOf/LargeCluster") {
+	wait(Future<Void>(Void()));
+
+	int teamSize = 3; // replication size
+	int processSize = 1000;
+	int desiredTeams = SERVER_KNOBS->DESIRED_TEAMS_PER_SERVER * processSize;
+	int maxTeams = SERVER_KNOBS->MAX_TEAMS_PER_SERVER * processSize;
+
+	Reference<IReplicationPolicy> policy = Reference<IReplicationPolicy>(new PolicyAcross(teamSize, "zoneid", Reference<IReplicationPolicy>(new PolicyOne())));
+	state std::unique_ptr<DDTeamCollection> collection = testTeamCollection(teamSize, policy, processSize);
+
+	double start = timer();
+	int result = collection->addTeamsBestOf(desiredTeams, desiredTeams, maxTeams);
+	printf("addTeamsBestOf built %d teams for %d servers in %f seconds\n", result, processSize, timer() - start);
+
+	// The team counts are tracked incrementally while building, so check them against a full scan
+	ASSERT(result >= desiredTeams);
+	ASSERT(!collection->notEnoughTeamsForAServer());
+	ASSERT(!collection->notEnoughMachineTeamsForAMachine());
+	ASSERT(collection->sanityCheckTeams() == true);
+
+	return Void();
+}
+
 TEST_CASE("DataDistribution/AddAllTeams/isExhaustive") {
 	Reference<IReplicationPolicy> policy = Reference<IReplicationPolicy>(new PolicyAcross(3, "zoneid", Reference<IReplicationPolicy>(new PolicyOne())));
 	state int processSize = 10;
@@ -44,6 +44,9 @@ struct IDataDistributionTeam {
 	virtual void addDataInFlightToTeam( int64_t delta ) = 0;
 	virtual int64_t getDataInFlightToTeam() const = 0;
 	virtual int64_t getLoadBytes(bool includeInFlight = true, double inflightPenalty = 1.0) const = 0;
+	// The read and write bandwidth of the team's servers, in bytes per ksecond, from their last storage metrics
+	virtual int64_t getReadBandwidth() const = 0;
+	virtual int64_t getWriteBandwidth() const = 0;
 	virtual int64_t getMinAvailableSpace(bool includeInFlight = true) const = 0;
 	virtual double getMinAvailableSpaceRatio(bool includeInFlight = true) const = 0;
 	virtual bool hasHealthyAvailableSpace(double minRatio) const = 0;
@@ -60,6 +63,15 @@ struct IDataDistributionTeam {
 	virtual void addServers(const vector<UID> &servers) = 0;
 	virtual std::string getTeamID() const = 0;
 
+	// getLoadBytes() with the team's bandwidth counted in, which rebalancing uses when DD_REBALANCE_LOAD_AWARE is set
+	int64_t getLoadScore(bool includeInFlight = true, double inflightPenalty = 1.0) const {
+		return getLoadBytes(includeInFlight, inflightPenalty) + bandwidthLoad(getReadBandwidth(), getWriteBandwidth());
+	}
+	static int64_t bandwidthLoad(int64_t bytesReadPerKSecond, int64_t bytesWrittenPerKSecond) {
+		return SERVER_KNOBS->DD_REBALANCE_READ_WEIGHT * bytesReadPerKSecond +
+		       SERVER_KNOBS->DD_REBALANCE_WRITE_WEIGHT * bytesWrittenPerKSecond;
+	}
+
 	std::string getDesc() const {
 		const auto& servers = getLastKnownServerInterfaces();
 		std::string s = format("TeamID:%s", getTeamID().c_str());
@@ -77,6 +89,7 @@ struct GetTeamRequest {
 	bool wantsTrueBest;
 	bool preferLowerUtilization;
 	bool teamMustHaveShards;
+	bool scoreByLoad = false; // Compare teams by getLoadScore() rather than getLoadBytes()
 	double inflightPenalty;
 	std::vector<UID> completeSources;
 	std::vector<UID> src;
@@ -86,12 +99,17 @@ struct GetTeamRequest {
 	GetTeamRequest( bool wantsNewServers, bool wantsTrueBest, bool preferLowerUtilization, bool teamMustHaveShards, double inflightPenalty = 1.0 ) 
 		: wantsNewServers( wantsNewServers ), wantsTrueBest( wantsTrueBest ), preferLowerUtilization( preferLowerUtilization ), teamMustHaveShards( teamMustHaveShards ), inflightPenalty( inflightPenalty ) {}
 
+	int64_t getLoad(IDataDistributionTeam const& team) const {
+		return scoreByLoad ? team.getLoadScore(true, inflightPenalty) : team.getLoadBytes(true, inflightPenalty);
+	}
+
 	std::string getDesc() const {
 		std::stringstream ss;
 
 		ss << "WantsNewServers:" << wantsNewServers << " WantsTrueBest:" << wantsTrueBest
 		   << " PreferLowerUtilization:" << preferLowerUtilization 
 		   << " teamMustHaveShards:" << teamMustHaveShards
+		   << " scoreByLoad:" << scoreByLoad
 		   << " inflightPenalty:" << inflightPenalty << ";";
 		ss << "CompleteSources:";
 		for (const auto& cs : completeSources) {
@@ -163,6 +181,9 @@ public:
 	//       intersecting shards.
 
 	int getNumberOfShards(UID ssID) const;
+	// Ready once no shard is assigned to ssID.  It can become ready while a relocation is only queued, so callers
+	// still have to check serverKeys before treating the server as empty.
+	Future<Void> onNoShards(UID ssID);
 	vector<KeyRange> getShardsFor( Team team );
 	bool hasShards(Team team) const;
 
@@ -187,8 +208,10 @@ private:
 	KeyRangeMap< std::pair<vector<Team>,vector<Team>> > shard_teams;	// A shard can be affected by the failure of multiple teams if it is a queued merge, or when usable_regions > 1
 	std::set< std::pair<Team,KeyRange>, OrderByTeamKey > team_shards;
 	std::map< UID, int > storageServerShards;
+	std::map<UID, Promise<Void>> noShardsWaiters;
 
 	void erase(Team team, KeyRange const& range);
+	void notifyNoShards(UID ssID);
 	void insert(Team team, KeyRange const& range);
 };
 
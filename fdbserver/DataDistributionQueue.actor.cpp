@@ -165,6 +165,14 @@ public:
 		});
 	}
 
+	int64_t getReadBandwidth() const override {
+		return sum([](IDataDistributionTeam const& team) { return team.getReadBandwidth(); });
+	}
+
+	int64_t getWriteBandwidth() const override {
+		return sum([](IDataDistributionTeam const& team) { return team.getWriteBandwidth(); });
+	}
+
 	int64_t getMinAvailableSpace(bool includeInFlight = true) const override {
 		int64_t result = std::numeric_limits<int64_t>::max();
 		for (const auto& team : teams) {
@@ -783,6 +791,68 @@ struct DDQueueData {
 		launchQueuedWork(combined, ddEnabledState);
 	}
 
+	bool canMergeRelocations(RelocateData const& rd, RelocateData const& other) {
+		return other.src.size() && other.src == rd.src && other.priority == rd.priority &&
+		       other.healthPriority == rd.healthPriority && other.boundaryPriority == -1 &&
+		       other.wantsNewServers == rd.wantsNewServers && queue[other.src[0]].count(other);
+	}
+
+	// Relocations of adjacent shards off the same servers for the same health reason, such as all the shards of a failed
+	// team, are launched as one, so that they share a destination team and moveKeys rewrites keyServers and serverKeys
+	// for all of them in the same transactions.  Relocations of a shard's boundaries or for rebalancing are sized for
+	// one shard, and are left alone.
+	void mergeAdjacentRelocations(RelocateData& rd) {
+		if (SERVER_KNOBS->DD_MERGE_ADJACENT_RELOCATIONS <= 1 || rd.healthPriority == -1 || rd.boundaryPriority != -1 ||
+		    rd.priority != rd.healthPriority) {
+			return;
+		}
+
+		int merged = 1;
+		while (merged < SERVER_KNOBS->DD_MERGE_ADJACENT_RELOCATIONS) {
+			Optional<RelocateData> other;
+			if (rd.keys.end < allKeys.end) {
+				auto next = queueMap.rangeContaining(rd.keys.end);
+				if (next->range() == next->value().keys && canMergeRelocations(rd, next->value())) {
+					other = next->value();
+				}
+			}
+			if (!other.present() && rd.keys.begin > allKeys.begin) {
+				auto prev = queueMap.rangeContainingKeyBefore(rd.keys.begin);
+				if (prev->range() == prev->value().keys && canMergeRelocations(rd, prev->value())) {
+					other = prev->value();
+				}
+			}
+			if (!other.present()) {
+				break;
+			}
+
+			TEST(true); // Adjacent queued relocations merged
+			RelocateData combined(rd);
+			combined.keys = KeyRangeRef(std::min(rd.keys.begin, other.get().keys.begin),
+			                            std::max(rd.keys.end, other.get().keys.end));
+			combined.startTime = std::min(rd.startTime, other.get().startTime);
+			// Only servers with all of both ranges have all of the combined one
+			for (int i = 0; i < combined.completeSources.size(); i++) {
+				auto& complete = other.get().completeSources;
+				if (std::find(complete.begin(), complete.end(), combined.completeSources[i]) == complete.end()) {
+					swapAndPop(&combined.completeSources, i--);
+				}
+			}
+
+			for (auto& id : rd.src) {
+				ASSERT(queue[id].erase(rd));
+				ASSERT(queue[id].erase(other.get()));
+				queue[id].insert(combined);
+			}
+			queuedRelocations--;
+			finishRelocation(other.get().priority, other.get().healthPriority);
+			queueMap.insert(combined.keys, combined);
+
+			rd = combined;
+			merged++;
+		}
+	}
+
 	// For each relocateData rd in the queue, check if there exist inflight relocate data whose keyrange is overlapped
 	// with rd. If there exist, cancel them by cancelling their actors and reducing the src servers' busyness of those
 	// canceled inflight relocateData. Launch the relocation for the rd.
@@ -795,6 +865,12 @@ struct DDQueueData {
 		for(; it != combined.end(); it++ ) {
 			RelocateData rd( *it );
 
+			// An earlier relocation in this pass may have merged this one into itself
+			if (!rd.src.size() || !queue[rd.src[0]].count(rd)) {
+				continue;
+			}
+			mergeAdjacentRelocations(rd);
+
 			// Check if there is an inflight shard that is overlapped with the queued relocateShard (rd)
 			bool overlappingInFlight = false;
 			auto intersectingInFlight = inFlight.intersectingRanges( rd.keys );
@@ -1165,7 +1241,16 @@ ACTOR Future<Void> dataDistributionRelocator(DDQueueData* self, RelocateData rd,
 	}
 }
 
-// Move a random shard of sourceTeam's to destTeam if sourceTeam has much more data than destTeam
+// The load of a shard that rebalancing weighs it by, to match IDataDistributionTeam::getLoadScore() if byLoad
+static int64_t rebalanceLoad(StorageMetrics const& metrics, bool byLoad) {
+	return metrics.bytes +
+	       (byLoad ? IDataDistributionTeam::bandwidthLoad(metrics.bytesReadPerKSecond, metrics.bytesPerKSecond) : 0);
+}
+
+// Move a random shard of sourceTeam's to destTeam if sourceTeam has much more data than destTeam.  If
+// DD_REBALANCE_LOAD_AWARE is set, teams and shards are compared by their bandwidth as well as their bytes, so the shard
+// chosen is the most loaded one found, and the teams must also differ by DD_REBALANCE_LOAD_HYSTERESIS of the source's
+// load so that a hot shard is not moved back and forth between teams whose load it only just tips.
 ACTOR Future<bool> rebalanceTeams( DDQueueData* self, int priority, Reference<IDataDistributionTeam> sourceTeam, 
                                    Reference<IDataDistributionTeam> destTeam, bool primary, TraceEvent *traceEvent ) {
 	if(g_network->isSimulated() && g_simulator.speedUpSimulation) {
@@ -1185,16 +1270,18 @@ ACTOR Future<bool> rebalanceTeams( DDQueueData* self, int priority, Reference<ID
 	if( !shards.size() )
 		return false;
 
+	state bool byLoad = SERVER_KNOBS->DD_REBALANCE_LOAD_AWARE;
 	state KeyRange moveShard;
 	state StorageMetrics metrics;
 	state int retries = 0;
 	while(retries < SERVER_KNOBS->REBALANCE_MAX_RETRIES) {
 		state KeyRange testShard = deterministicRandom()->randomChoice( shards );
 		StorageMetrics testMetrics = wait( brokenPromiseToNever( self->getShardMetrics.getReply(GetMetricsRequest(testShard)) ) );
-		if(testMetrics.bytes > metrics.bytes) {
+		if(rebalanceLoad(testMetrics, byLoad) > rebalanceLoad(metrics, byLoad)) {
 			moveShard = testShard;
 			metrics = testMetrics;
-			if(metrics.bytes > averageShardBytes) {
+			// A shard larger than average is good enough when balancing bytes, but the hottest one is wanted otherwise
+			if(!byLoad && metrics.bytes > averageShardBytes) {
 				break;
 			}
 		}
@@ -1203,12 +1290,23 @@ ACTOR Future<bool> rebalanceTeams( DDQueueData* self, int priority, Reference<ID
 
 	int64_t sourceBytes = sourceTeam->getLoadBytes(false);
 	int64_t destBytes = destTeam->getLoadBytes();
+	int64_t sourceLoad = byLoad ? sourceTeam->getLoadScore(false) : sourceBytes;
+	int64_t destLoad = byLoad ? destTeam->getLoadScore() : destBytes;
+	int64_t shardLoad = rebalanceLoad(metrics, byLoad);
 
-	bool sourceAndDestTooSimilar = sourceBytes - destBytes <= 3 * std::max<int64_t>(SERVER_KNOBS->MIN_SHARD_BYTES, metrics.bytes);
+	bool sourceAndDestTooSimilar =
+	    sourceLoad - destLoad <= 3 * std::max<int64_t>(SERVER_KNOBS->MIN_SHARD_BYTES, shardLoad) ||
+	    (byLoad && sourceLoad - destLoad <= SERVER_KNOBS->DD_REBALANCE_LOAD_HYSTERESIS * sourceLoad);
 	traceEvent->detail("SourceBytes", sourceBytes)
 		.detail("DestBytes", destBytes)
 		.detail("ShardBytes", metrics.bytes)
 		.detail("SourceAndDestTooSimilar", sourceAndDestTooSimilar);
+	if (byLoad) {
+		traceEvent->detail("SourceLoad", sourceLoad)
+			.detail("DestLoad", destLoad)
+			.detail("ShardLoad", shardLoad)
+			.detail("ShardBytesReadPerKSecond", metrics.bytesReadPerKSecond);
+	}
 
 	if( sourceAndDestTooSimilar || metrics.bytes == 0 ) {
 		return false;
@@ -1271,17 +1369,20 @@ ACTOR Future<Void> BgDDMountainChopper( DDQueueData* self, int teamCollectionInd
 			traceEvent.detail("QueuedRelocations", self->priority_relocations[SERVER_KNOBS->PRIORITY_REBALANCE_OVERUTILIZED_TEAM]);
 			if (self->priority_relocations[SERVER_KNOBS->PRIORITY_REBALANCE_OVERUTILIZED_TEAM] <
 			    SERVER_KNOBS->DD_REBALANCE_PARALLELISM) {
+				state GetTeamRequest destRequest(true, false, true, false);
+				destRequest.scoreByLoad = SERVER_KNOBS->DD_REBALANCE_LOAD_AWARE;
 				std::pair<Optional<Reference<IDataDistributionTeam>>,bool> _randomTeam = wait(brokenPromiseToNever(
-				    self->teamCollections[teamCollectionIndex].getTeam.getReply(GetTeamRequest(true, false, true, false))));
+				    self->teamCollections[teamCollectionIndex].getTeam.getReply(destRequest)));
 				randomTeam = _randomTeam;
 				traceEvent.detail("DestTeam", printable(randomTeam.first.map<std::string>([](const Reference<IDataDistributionTeam>& team){
 					return team->getDesc();
 				})));
 
 				if (randomTeam.first.present()) {
+					state GetTeamRequest sourceRequest(true, true, false, true);
+					sourceRequest.scoreByLoad = SERVER_KNOBS->DD_REBALANCE_LOAD_AWARE;
 					std::pair<Optional<Reference<IDataDistributionTeam>>,bool> loadedTeam =
-						wait(brokenPromiseToNever(self->teamCollections[teamCollectionIndex].getTeam.getReply(
-							GetTeamRequest(true, true, false, true))));
+						wait(brokenPromiseToNever(self->teamCollections[teamCollectionIndex].getTeam.getReply(sourceRequest)));
 
 					traceEvent.detail("SourceTeam", printable(loadedTeam.first.map<std::string>([](const Reference<IDataDistributionTeam>& team){
 						return team->getDesc();
@@ -1379,8 +1480,10 @@ ACTOR Future<Void> BgDDValleyFiller( DDQueueData* self, int teamCollectionIndex)
 				})));
 
 				if (randomTeam.first.present()) {
+					state GetTeamRequest destRequest(true, true, true, false);
+					destRequest.scoreByLoad = SERVER_KNOBS->DD_REBALANCE_LOAD_AWARE;
 					std::pair<Optional<Reference<IDataDistributionTeam>>,bool> unloadedTeam = wait(brokenPromiseToNever(
-					    self->teamCollections[teamCollectionIndex].getTeam.getReply(GetTeamRequest(true, true, true, false))));
+					    self->teamCollections[teamCollectionIndex].getTeam.getReply(destRequest)));
 
 					traceEvent.detail("DestTeam", printable(unloadedTeam.first.map<std::string>([](const Reference<IDataDistributionTeam>& team){
 						return team->getDesc();
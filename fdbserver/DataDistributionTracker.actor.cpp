@@ -23,7 +23,9 @@
 #include "fdbserver/DataDistribution.actor.h"
 #include "fdbserver/Knobs.h"
 #include "fdbclient/DatabaseContext.h"
+#include "fdbclient/ManagementAPI.actor.h"
 #include "flow/ActorCollection.h"
+#include "flow/UnitTest.h"
 #include "flow/actorcompiler.h"  // This must be the last #include.
 
 // The used bandwidth of a shard. The higher the value is, the busier the shard is.
@@ -54,6 +56,154 @@ ReadBandwidthStatus getReadBandwidthStatus(StorageMetrics const& metrics) {
 	}
 }
 
+// Decides which read hot ranges the storage cache role should hold when STORAGE_CACHE_AUTO_ADMIT is set. A range is
+// admitted once it has been reported read hot STORAGE_CACHE_ADMIT_HITS times, so that a single burst does not churn the
+// cache, and only while the admitted ranges fit in STORAGE_CACHE_AUTO_MAX_BYTES. When they do not, admitted ranges with
+// less decayed read bandwidth ("heat") than the new range are evicted to make room. Ranges that go
+// STORAGE_CACHE_IDLE_TIMEOUT without being reported read hot are forgotten, and uncached if they were admitted.
+struct StorageCacheAdmission {
+	struct Entry {
+		Key end;
+		int64_t bytes = 0;
+		double heat = 0;
+		double heatTime = 0;
+		double lastHot = 0;
+		int hits = 0;
+		bool admitted = false;
+	};
+
+	struct Decision {
+		std::vector<KeyRange> toCache;
+		std::vector<KeyRange> toUncache;
+	};
+
+	std::map<Key, Entry> ranges; // By begin key. Tracked ranges never overlap.
+	int64_t admittedBytes = 0;
+
+	static double decayedHeat(Entry const& e, double now) {
+		return e.heat * std::pow(0.5, (now - e.heatTime) / SERVER_KNOBS->STORAGE_CACHE_HEAT_HALF_LIFE);
+	}
+
+	// Seeds a range that an earlier data distributor admitted. Its size is not known, and it has to be reported read hot
+	// again within STORAGE_CACHE_IDLE_TIMEOUT to stay cached.
+	void restore(KeyRangeRef keys, double now) {
+		Entry& e = ranges[keys.begin];
+		e.end = keys.end;
+		e.heatTime = e.lastHot = now;
+		e.hits = SERVER_KNOBS->STORAGE_CACHE_ADMIT_HITS;
+		e.admitted = true;
+	}
+
+	Decision recordHot(KeyRangeRef keys, int64_t bytes, double readBandwidth, double now) {
+		Decision decision;
+		auto it = ranges.lower_bound(keys.begin);
+		if (it != ranges.begin() && std::prev(it)->second.end > keys.begin) {
+			--it;
+		}
+		std::vector<std::map<Key, Entry>::iterator> overlapping;
+		bool anyAdmitted = false;
+		for (; it != ranges.end() && it->first < keys.end; ++it) {
+			overlapping.push_back(it);
+			anyAdmitted = anyAdmitted || it->second.admitted;
+		}
+
+		if (anyAdmitted) {
+			// Some of the range is already cached, so credit what is cached rather than growing it
+			for (auto& o : overlapping) {
+				if (o->second.admitted) {
+					o->second.heat = decayedHeat(o->second, now) + readBandwidth;
+					o->second.heatTime = o->second.lastHot = now;
+					++o->second.hits;
+				}
+			}
+			return decision;
+		}
+
+		Key begin = keys.begin;
+		Entry merged;
+		merged.end = keys.end;
+		merged.bytes = bytes;
+		merged.heat = readBandwidth;
+		for (auto& o : overlapping) {
+			begin = std::min(begin, o->first);
+			merged.end = std::max(merged.end, o->second.end);
+			merged.bytes = std::max(merged.bytes, o->second.bytes);
+			merged.heat += decayedHeat(o->second, now);
+			merged.hits = std::max(merged.hits, o->second.hits);
+			ranges.erase(o);
+		}
+		merged.heatTime = merged.lastHot = now;
+		++merged.hits;
+
+		if (merged.hits >= SERVER_KNOBS->STORAGE_CACHE_ADMIT_HITS &&
+		    merged.bytes <= SERVER_KNOBS->STORAGE_CACHE_AUTO_MAX_BYTES) {
+			std::vector<std::pair<double, Key>> colder;
+			for (auto& r : ranges) {
+				if (r.second.admitted) {
+					double heat = decayedHeat(r.second, now);
+					if (heat < merged.heat) {
+						colder.emplace_back(heat, r.first);
+					}
+				}
+			}
+			std::sort(colder.begin(), colder.end());
+			int64_t freed = 0;
+			int victims = 0;
+			while (admittedBytes - freed + merged.bytes > SERVER_KNOBS->STORAGE_CACHE_AUTO_MAX_BYTES &&
+			       victims < colder.size()) {
+				freed += ranges[colder[victims++].second].bytes;
+			}
+			if (admittedBytes - freed + merged.bytes <= SERVER_KNOBS->STORAGE_CACHE_AUTO_MAX_BYTES) {
+				// Evicted ranges stay tracked, so that they can be admitted again if they get hotter
+				for (int i = 0; i < victims; ++i) {
+					Entry& victim = ranges[colder[i].second];
+					decision.toUncache.push_back(KeyRangeRef(colder[i].second, victim.end));
+					victim.admitted = false;
+					admittedBytes -= victim.bytes;
+				}
+				merged.admitted = true;
+				admittedBytes += merged.bytes;
+				decision.toCache.push_back(KeyRangeRef(begin, merged.end));
+			}
+		}
+		ranges[begin] = merged;
+		return decision;
+	}
+
+	// Called when caching a range did not happen, e.g. because some of it was already cached by hand
+	void rejectAdmission(KeyRangeRef keys) {
+		auto it = ranges.find(keys.begin);
+		if (it != ranges.end() && it->second.admitted) {
+			it->second.admitted = false;
+			admittedBytes -= it->second.bytes;
+		}
+	}
+
+	Decision evictIdle(double now) {
+		Decision decision;
+		for (auto it = ranges.begin(); it != ranges.end();) {
+			if (now - it->second.lastHot > SERVER_KNOBS->STORAGE_CACHE_IDLE_TIMEOUT) {
+				if (it->second.admitted) {
+					decision.toUncache.push_back(KeyRangeRef(it->first, it->second.end));
+					admittedBytes -= it->second.bytes;
+				}
+				it = ranges.erase(it);
+			} else {
+				++it;
+			}
+		}
+		return decision;
+	}
+
+	std::vector<KeyRange> tracked() const {
+		std::vector<KeyRange> result;
+		for (auto& r : ranges) {
+			result.push_back(KeyRangeRef(r.first, r.second.end));
+		}
+		return result;
+	}
+};
+
 ACTOR Future<Void> updateMaxShardSize( Reference<AsyncVar<int64_t>> dbSizeEstimate, Reference<AsyncVar<Optional<int64_t>>> maxShardSize ) {
 	state int64_t lastDbSize = 0;
 	state int64_t granularity = g_network->isSimulated() ?
@@ -90,6 +240,8 @@ struct DataDistributionTracker {
 
 	// Read hot detection
 	PromiseStream<KeyRange> readHotShard;
+	PromiseStream<Standalone<VectorRef<ReadHotRangeWithMetrics>>> readHotRanges;
+	StorageCacheAdmission cacheAdmission;
 
 	// The reference to trackerCancelled must be extracted by actors,
 	// because by the time (trackerCancelled == true) this memory cannot
@@ -327,6 +479,9 @@ ACTOR Future<Void> readHotDetector(DataDistributionTracker* self) {
 						    .detail("KeyRangeBegin", keyRange.keys.begin)
 						    .detail("KeyRangeEnd", keyRange.keys.end);
 					}
+					if (SERVER_KNOBS->STORAGE_CACHE_AUTO_ADMIT && readHotRanges.size()) {
+						self->readHotRanges.send(readHotRanges);
+					}
 					break;
 				} catch (Error& e) {
 					wait(tr.onError(e));
@@ -340,6 +495,154 @@ ACTOR Future<Void> readHotDetector(DataDistributionTracker* self) {
 	}
 }
 
+// Estimates the size of a read hot range from its read bandwidth and its read density (bytes read / bytes)
+int64_t readHotRangeBytes(ReadHotRangeWithMetrics const& range) {
+	return range.density > 0 ? range.readBandwidth * SERVER_KNOBS->STORAGE_METRICS_AVERAGE_INTERVAL / range.density : 0;
+}
+
+// Caches `keys` and records it as automatically admitted, unless there is no storage cache server or some of the keys
+// are already cached. Returns whether the keys were cached.
+ACTOR Future<bool> autoCacheRange(Database cx, KeyRange keys) {
+	state Transaction tr(cx);
+	state Value falseValue = storageCacheValue(std::vector<uint16_t>{});
+	loop {
+		tr.setOption(FDBTransactionOptions::ACCESS_SYSTEM_KEYS);
+		tr.setOption(FDBTransactionOptions::LOCK_AWARE);
+		try {
+			state Future<Standalone<RangeResultRef>> cacheServers = tr.getRange(storageCacheServerKeys, 1);
+			state Future<Standalone<RangeResultRef>> atBegin = tr.getRange(
+			    KeyRangeRef(storageCacheKeys.begin, keyAfter(storageCacheKey(keys.begin))), 1, false, true);
+			state Future<Standalone<RangeResultRef>> inside = tr.getRange(
+			    KeyRangeRef(keyAfter(storageCacheKey(keys.begin)), storageCacheKey(keys.end)), CLIENT_KNOBS->TOO_MANY);
+			wait(success(cacheServers) && success(atBegin) && success(inside));
+			if (cacheServers.get().empty() || (atBegin.get().size() && atBegin.get()[0].value != falseValue)) {
+				return false;
+			}
+			for (const auto& kv : inside.get()) {
+				if (kv.value != falseValue) {
+					return false;
+				}
+			}
+			tr.set(storageCacheAutoKey(keys.begin), keys.end);
+			wait(tr.commit());
+			break;
+		} catch (Error& e) {
+			wait(tr.onError(e));
+		}
+	}
+	wait(addCachedRange(cx, keys));
+	return true;
+}
+
+ACTOR Future<Void> autoUncacheRange(Database cx, KeyRange keys) {
+	wait(removeCachedRange(cx, keys));
+	state Transaction tr(cx);
+	loop {
+		tr.setOption(FDBTransactionOptions::ACCESS_SYSTEM_KEYS);
+		tr.setOption(FDBTransactionOptions::LOCK_AWARE);
+		try {
+			tr.clear(storageCacheAutoKey(keys.begin));
+			wait(tr.commit());
+			return Void();
+		} catch (Error& e) {
+			wait(tr.onError(e));
+		}
+	}
+}
+
+ACTOR Future<Void> applyCacheDecision(DataDistributionTracker* self, StorageCacheAdmission::Decision decision) {
+	state int i = 0;
+	for (; i < decision.toUncache.size(); ++i) {
+		TraceEvent("StorageCacheAutoEvict", self->distributorId).detail("Range", decision.toUncache[i]);
+		wait(autoUncacheRange(self->cx, decision.toUncache[i]));
+	}
+	for (i = 0; i < decision.toCache.size(); ++i) {
+		bool cached = wait(autoCacheRange(self->cx, decision.toCache[i]));
+		if (!cached) {
+			self->cacheAdmission.rejectAdmission(decision.toCache[i]);
+		}
+		TraceEvent("StorageCacheAutoAdmit", self->distributorId)
+		    .detail("Range", decision.toCache[i])
+		    .detail("Cached", cached)
+		    .detail("AdmittedBytes", self->cacheAdmission.admittedBytes);
+	}
+	return Void();
+}
+
+ACTOR Future<Void> recordReadHotRanges(DataDistributionTracker* self,
+                                       Standalone<VectorRef<ReadHotRangeWithMetrics>> readHotRanges) {
+	state int i = 0;
+	for (; i < readHotRanges.size(); ++i) {
+		wait(applyCacheDecision(self, self->cacheAdmission.recordHot(readHotRanges[i].keys,
+		                                                             readHotRangeBytes(readHotRanges[i]),
+		                                                             readHotRanges[i].readBandwidth, now())));
+	}
+	return Void();
+}
+
+// The tracker only reports a shard when it becomes read hot, so the ranges that stay hot are looked up again before
+// idle ranges are evicted
+ACTOR Future<Void> refreshCachedRanges(DataDistributionTracker* self) {
+	state std::vector<KeyRange> tracked = self->cacheAdmission.tracked();
+	state int i = 0;
+	for (; i < tracked.size(); ++i) {
+		state Transaction tr(self->cx);
+		loop {
+			try {
+				Standalone<VectorRef<ReadHotRangeWithMetrics>> readHotRanges =
+				    wait(tr.getReadHotRanges(tracked[i]));
+				wait(recordReadHotRanges(self, readHotRanges));
+				break;
+			} catch (Error& e) {
+				wait(tr.onError(e));
+			}
+		}
+	}
+	wait(applyCacheDecision(self, self->cacheAdmission.evictIdle(now())));
+	return Void();
+}
+
+ACTOR Future<Void> restoreAutoCachedRanges(DataDistributionTracker* self) {
+	state Transaction tr(self->cx);
+	loop {
+		tr.setOption(FDBTransactionOptions::ACCESS_SYSTEM_KEYS);
+		tr.setOption(FDBTransactionOptions::LOCK_AWARE);
+		try {
+			Standalone<RangeResultRef> ranges = wait(tr.getRange(storageCacheAutoKeys, CLIENT_KNOBS->TOO_MANY));
+			for (const auto& kv : ranges) {
+				self->cacheAdmission.restore(KeyRangeRef(kv.key.removePrefix(storageCacheAutoKeys.begin), kv.value),
+				                             now());
+			}
+			return Void();
+		} catch (Error& e) {
+			wait(tr.onError(e));
+		}
+	}
+}
+
+// Admits the read hot ranges found by readHotDetector to the storage cache role, and evicts them once they cool down
+ACTOR Future<Void> storageCacheAutoManager(DataDistributionTracker* self) {
+	state Future<Void> evictionTimer =
+	    delay(SERVER_KNOBS->STORAGE_CACHE_EVICTION_INTERVAL, TaskPriority::DataDistribution);
+	try {
+		wait(restoreAutoCachedRanges(self));
+		loop choose {
+			when(Standalone<VectorRef<ReadHotRangeWithMetrics>> readHotRanges =
+			         waitNext(self->readHotRanges.getFuture())) {
+				wait(recordReadHotRanges(self, readHotRanges));
+			}
+			when(wait(evictionTimer)) {
+				wait(refreshCachedRanges(self));
+				evictionTimer = delay(SERVER_KNOBS->STORAGE_CACHE_EVICTION_INTERVAL, TaskPriority::DataDistribution);
+			}
+		}
+	} catch (Error& e) {
+		if (e.code() != error_code_actor_cancelled)
+			self->output.sendError(e); // Propagate failure to dataDistributionTracker
+		throw e;
+	}
+}
+
 /*
 ACTOR Future<Void> extrapolateShardBytes( Reference<AsyncVar<Optional<int64_t>>> inBytes, Reference<AsyncVar<Optional<int64_t>>> outBytes ) {
 	state std::deque< std::pair<double,int64_t> > past;
@@ -908,6 +1211,8 @@ ACTOR Future<Void> dataDistributionTracker(Reference<InitialDataDistribution> in
 	                                   anyZeroHealthyTeams, *shards, *trackerCancelled);
 	state Future<Void> loggingTrigger = Void();
 	state Future<Void> readHotDetect = readHotDetector(&self);
+	state Future<Void> cacheAutoManager =
+	    SERVER_KNOBS->STORAGE_CACHE_AUTO_ADMIT ? storageCacheAutoManager(&self) : Future<Void>(Never());
 	try {
 		wait( trackInitialShards( &self, initData ) );
 		initData = Reference<InitialDataDistribution>();
@@ -964,8 +1269,8 @@ void ShardsAffectedByTeamFailure::erase(Team team, KeyRange const& range) {
 	if(team_shards.erase( std::pair<Team,KeyRange>(team, range) ) > 0) {
 		for (auto uid = team.servers.begin(); uid != team.servers.end(); ++uid) {
 			// Safeguard against going negative after eraseServer() sets value to 0
-			if (storageServerShards[*uid] > 0) {
-				storageServerShards[*uid]--;
+			if (storageServerShards[*uid] > 0 && --storageServerShards[*uid] == 0) {
+				notifyNoShards(*uid);
 			}
 		}
 	}
@@ -973,6 +1278,24 @@ void ShardsAffectedByTeamFailure::erase(Team team, KeyRange const& range) {
 
 void ShardsAffectedByTeamFailure::eraseServer(UID ssID) {
 	storageServerShards[ssID] = 0;
+	notifyNoShards(ssID);
+}
+
+Future<Void> ShardsAffectedByTeamFailure::onNoShards(UID ssID) {
+	if (getNumberOfShards(ssID) == 0) {
+		return Void();
+	}
+	return noShardsWaiters[ssID].getFuture();
+}
+
+void ShardsAffectedByTeamFailure::notifyNoShards(UID ssID) {
+	auto it = noShardsWaiters.find(ssID);
+	if (it != noShardsWaiters.end()) {
+		// Remove the waiter before firing it, since the woken actors may wait on this server again
+		Promise<Void> noShards = it->second;
+		noShardsWaiters.erase(it);
+		noShards.send(Void());
+	}
 }
 
 void ShardsAffectedByTeamFailure::insert(Team team, KeyRange const& range) {
@@ -1100,3 +1423,71 @@ void ShardsAffectedByTeamFailure::check() {
 				}
 	}
 }
+
+TEST_CASE("/DataDistribution/StorageCacheAdmission") {
+	StorageCacheAdmission admission;
+	int64_t half = SERVER_KNOBS->STORAGE_CACHE_AUTO_MAX_BYTES / 2;
+	KeyRange a = KeyRangeRef(LiteralStringRef("a"), LiteralStringRef("b"));
+	KeyRange b = KeyRangeRef(LiteralStringRef("b"), LiteralStringRef("c"));
+	KeyRange c = KeyRangeRef(LiteralStringRef("c"), LiteralStringRef("d"));
+	KeyRange d = KeyRangeRef(LiteralStringRef("e"), LiteralStringRef("f"));
+
+	// A range is only admitted once it has been reported often enough
+	for (int i = 1; i < SERVER_KNOBS->STORAGE_CACHE_ADMIT_HITS; ++i) {
+		ASSERT(admission.recordHot(a, half, 100, 0).toCache.empty());
+	}
+	StorageCacheAdmission::Decision decision = admission.recordHot(a, half, 100, 0);
+	ASSERT(decision.toCache.size() == 1 && decision.toCache[0] == a && decision.toUncache.empty());
+	for (int i = 1; i < SERVER_KNOBS->STORAGE_CACHE_ADMIT_HITS; ++i) {
+		admission.recordHot(b, half, 200, 0);
+	}
+	decision = admission.recordHot(b, half, 200, 0);
+	ASSERT(decision.toCache.size() == 1 && decision.toCache[0] == b && decision.toUncache.empty());
+	ASSERT(admission.admittedBytes == 2 * half);
+
+	// A hotter range replaces the coldest admitted range once the budget is used up
+	for (int i = 1; i < SERVER_KNOBS->STORAGE_CACHE_ADMIT_HITS; ++i) {
+		admission.recordHot(c, half, 1000, 0);
+	}
+	decision = admission.recordHot(c, half, 1000, 0);
+	ASSERT(decision.toCache.size() == 1 && decision.toCache[0] == c);
+	ASSERT(decision.toUncache.size() == 1 && decision.toUncache[0] == a);
+
+	// A colder range does not
+	for (int i = 0; i < SERVER_KNOBS->STORAGE_CACHE_ADMIT_HITS; ++i) {
+		decision = admission.recordHot(d, half, 1, 0);
+		ASSERT(decision.toCache.empty() && decision.toUncache.empty());
+	}
+
+	// Reports that overlap a cached range are credited to it
+	decision = admission.recordHot(KeyRangeRef(LiteralStringRef("c1"), LiteralStringRef("c2")), half, 1000, 0);
+	ASSERT(decision.toCache.empty() && decision.toUncache.empty());
+	ASSERT(admission.admittedBytes == 2 * half);
+
+	decision = admission.evictIdle(SERVER_KNOBS->STORAGE_CACHE_IDLE_TIMEOUT + 1);
+	ASSERT(decision.toCache.empty() && decision.toUncache.size() == 2);
+	ASSERT(admission.admittedBytes == 0 && admission.tracked().empty());
+	return Void();
+}
+
+TEST_CASE("/DataDistribution/ShardsAffectedByTeamFailure/OnNoShards") {
+	ShardsAffectedByTeamFailure shards;
+	UID a = deterministicRandom()->randomUniqueID();
+	UID b = deterministicRandom()->randomUniqueID();
+	KeyRange range = KeyRangeRef(LiteralStringRef("a"), LiteralStringRef("b"));
+
+	shards.defineShard(range);
+	shards.moveShard(range, { ShardsAffectedByTeamFailure::Team({ a }, true) });
+	ASSERT(shards.getNumberOfShards(a) == 1);
+	Future<Void> aEmpty = shards.onNoShards(a);
+	ASSERT(!aEmpty.isReady() && shards.onNoShards(b).isReady());
+
+	shards.moveShard(range, { ShardsAffectedByTeamFailure::Team({ b }, true) });
+	ASSERT(aEmpty.isReady() && shards.getNumberOfShards(a) == 0);
+	Future<Void> bEmpty = shards.onNoShards(b);
+	ASSERT(!bEmpty.isReady());
+
+	shards.eraseServer(b);
+	ASSERT(bEmpty.isReady());
+	return Void();
+}
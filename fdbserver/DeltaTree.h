@@ -25,6 +25,7 @@
 #include "fdbclient/FDBTypes.h"
 #include "fdbserver/Knobs.h"
 #include <string.h>
+#include <type_traits>
 
 typedef uint64_t Word;
 // Get the number of prefix bytes that are the same between a and b, up to their common length of cl
@@ -150,6 +151,30 @@ static int perfectSubtreeSplitPointCached(int subtree_size) {
 //    // Retrieves the previously stored boolean
 //    bool getPrefixSource() const;
 //
+// Optionally, T may implement the following to allow Mirror::enableSearchIndex() to be used
+//
+//    // Returns a fixed width prefix of *this starting after the first skipLen bytes, such that for any two T's which
+//    // share their first skipLen bytes, a.getSearchPrefix(skipLen) < b.getSearchPrefix(skipLen) implies a < b
+//    uint64_t getSearchPrefix(int skipLen) const;
+//
+template <typename T, typename = void>
+struct HasSearchPrefix : std::false_type {};
+
+template <typename T>
+struct HasSearchPrefix<T, std::void_t<decltype(std::declval<const T&>().getSearchPrefix(0))>> : std::true_type {};
+
+// Optionally, T may implement the following to allow Mirror::enableFilter() to be used
+//
+//    // Returns a hash of the part of *this that mayContain() queries should match on.  Two T's that a point lookup
+//    // treats as the same must have the same hash.
+//    uint64_t getFilterHash() const;
+//
+template <typename T, typename = void>
+struct HasFilterHash : std::false_type {};
+
+template <typename T>
+struct HasFilterHash<T, std::void_t<decltype(std::declval<const T&>().getFilterHash())>> : std::true_type {};
+
 #pragma pack(push, 1)
 template <typename T, typename DeltaT = typename T::Delta>
 struct DeltaTree {
@@ -379,9 +404,158 @@ public:
 		const T* lower;
 		const T* upper;
 
+		// The search index holds every node in order along with its search prefix and depth, see enableSearchIndex()
+		int searchIndexAfterSeeks = 0;
+		int searchSeeks = 0;
+		int searchSkipLen = 0;
+		bool searchIndexValid = false;
+		std::vector<uint64_t> searchPrefixes;
+		std::vector<DecodedNode*> searchNodes;
+		std::vector<uint8_t> searchDepths;
+
+		bool addToSearchIndex(DecodedNode* n, int depth) {
+			if (n == nullptr) {
+				return true;
+			}
+			if (!addToSearchIndex(n->getLeftChild(arena), depth + 1)) {
+				return false;
+			}
+			// Prefixes are only comparable between items that share the bounds' common prefix
+			if (n->item.getCommonPrefixLen(*lower, 0) < searchSkipLen) {
+				return false;
+			}
+			searchPrefixes.push_back(n->item.getSearchPrefix(searchSkipLen));
+			searchNodes.push_back(n);
+			searchDepths.push_back(std::min(depth, 255));
+			return addToSearchIndex(n->getRightChild(arena), depth + 1);
+		}
+
+		// Returns true if seeks should use the search index, building it if this is the seek that enables it
+		bool useSearchIndex() {
+			if (searchIndexValid) {
+				return true;
+			}
+			if (searchIndexAfterSeeks <= 0 || root == nullptr || ++searchSeeks < searchIndexAfterSeeks) {
+				return false;
+			}
+
+			searchSkipLen = lower->getCommonPrefixLen(*upper, 0);
+			searchPrefixes.reserve(tree->numItems);
+			searchNodes.reserve(tree->numItems);
+			searchDepths.reserve(tree->numItems);
+			searchIndexValid = addToSearchIndex(root, 0);
+			if (!searchIndexValid) {
+				invalidateSearchIndex();
+				searchIndexAfterSeeks = 0;
+			}
+			return searchIndexValid;
+		}
+
+		void invalidateSearchIndex() {
+			searchIndexValid = false;
+			searchSeeks = 0;
+			searchPrefixes.clear();
+			searchNodes.clear();
+			searchDepths.clear();
+		}
+
+		// The filter is a bloom filter of the filter hashes of every item in the tree, see enableFilter()
+		int filterAfterLookups = 0;
+		int filterLookups = 0;
+		int filterBitsPerItem = 0;
+		int filterProbes = 0;
+		bool filterValid = false;
+		std::vector<uint64_t> filterBits;
+
+		void addToFilter(uint64_t hash) {
+			uint64_t bits = filterBits.size() * 64;
+			uint32_t h1 = hash;
+			uint32_t h2 = hash >> 32;
+			for (int i = 0; i < filterProbes; ++i) {
+				uint64_t b = (h1 + (uint64_t)i * h2) % bits;
+				filterBits[b / 64] |= uint64_t(1) << (b % 64);
+			}
+		}
+
+		bool filterHas(uint64_t hash) const {
+			uint64_t bits = filterBits.size() * 64;
+			uint32_t h1 = hash;
+			uint32_t h2 = hash >> 32;
+			for (int i = 0; i < filterProbes; ++i) {
+				uint64_t b = (h1 + (uint64_t)i * h2) % bits;
+				if ((filterBits[b / 64] & (uint64_t(1) << (b % 64))) == 0) {
+					return false;
+				}
+			}
+			return true;
+		}
+
+		void addNodesToFilter(DecodedNode* n) {
+			if (n != nullptr) {
+				addNodesToFilter(n->getLeftChild(arena));
+				addToFilter(n->item.getFilterHash());
+				addNodesToFilter(n->getRightChild(arena));
+			}
+		}
+
+		// Returns true if lookups should use the filter, building it if this is the lookup that enables it
+		bool useFilter() {
+			if (filterValid) {
+				return true;
+			}
+			if (filterAfterLookups <= 0 || root == nullptr || ++filterLookups < filterAfterLookups) {
+				return false;
+			}
+
+			// Size for the items the tree can hold once the rest of its free space is used, so that inserts into
+			// the page rarely push the filter's false positive rate up by much
+			int items = std::max<int>(tree->numItems, 1);
+			int bytesPerItem = std::max<int>(tree->nodeBytesUsed / items, 1);
+			items += tree->nodeBytesFree / bytesPerItem;
+			filterBits.assign((items * filterBitsPerItem + 63) / 64, 0);
+			addNodesToFilter(root);
+			filterValid = true;
+			return true;
+		}
+
 	public:
 		Cursor getCursor() { return Cursor(this); }
 
+		// After afterSeeks calls to Cursor::seek() without a hint, decode the whole tree and index it by the search
+		// prefix of each item.  Later seeks then binary search the prefixes, and compare whole items only for the few
+		// whose prefix equals the query's.  An insert discards the index, which is rebuilt after another afterSeeks
+		// seeks.  Has no effect unless T implements getSearchPrefix(), or if afterSeeks is 0.
+		void enableSearchIndex(int afterSeeks) {
+			if constexpr (HasSearchPrefix<T>::value) {
+				searchIndexAfterSeeks = afterSeeks;
+			}
+		}
+
+		// After afterLookups calls to mayContain(), decode the whole tree and build a bloom filter of its items'
+		// filter hashes with bitsPerItem bits per item.  Later calls then return false for most T's that are not in
+		// the tree without seeking into it.  Inserts are added to the filter, and erased items stay in it.  Has no
+		// effect unless T implements getFilterHash(), or if afterLookups or bitsPerItem is 0.
+		void enableFilter(int afterLookups, int bitsPerItem) {
+			if constexpr (HasFilterHash<T>::value) {
+				if (bitsPerItem > 0) {
+					filterAfterLookups = afterLookups;
+					filterBitsPerItem = bitsPerItem;
+					// ln(2) * bits per item probes minimizes the false positive rate
+					filterProbes = std::max(1, std::min(8, (bitsPerItem * 7 + 5) / 10));
+				}
+			}
+		}
+
+		// Returns false only if no item in the tree has the same filter hash as k.  A true result means nothing.
+		bool mayContain(const T& k) {
+			if constexpr (HasFilterHash<T>::value) {
+				if (useFilter()) {
+					return filterHas(k.getFilterHash());
+				}
+			}
+			return true;
+		}
+
 		// Try to insert k into the DeltaTree, updating byte counts and initialHeight if they
 		// have changed (they won't if k already exists in the tree but was deleted).
 		// Returns true if successful, false if k does not fit in the space available
@@ -492,6 +666,16 @@ public:
 				tree->maxHeight = height;
 			}
 
+			if (searchIndexValid) {
+				invalidateSearchIndex();
+			}
+
+			if constexpr (HasFilterHash<T>::value) {
+				if (filterValid) {
+					addToFilter(newNode->item.getFilterHash());
+				}
+			}
+
 			return true;
 		}
 
@@ -653,6 +837,13 @@ public:
 		// Otherwise, returns the result of s.compare(item at cursor position)
 		// Does not skip/avoid deleted nodes.
 		int seek(const T& s, int skipLen = 0) {
+			if constexpr (HasSearchPrefix<T>::value) {
+				int cmp;
+				if (mirror->useSearchIndex() && seekSearchIndex(s, skipLen, cmp)) {
+					return cmp;
+				}
+			}
+
 			DecodedNode* n = mirror->root;
 			node = nullptr;
 			int cmp = 0;
@@ -802,6 +993,49 @@ public:
 		}
 
 	private:
+		// Same result as seek() but found with the mirror's search index.  Returns false, without moving the cursor,
+		// if s is outside the range that the index covers.
+		bool seekSearchIndex(const T& s, int skipLen, int& cmp) {
+			int skip = mirror->searchSkipLen;
+			if (s.getCommonPrefixLen(*mirror->lower, std::min(skipLen, skip)) < skip) {
+				return false;
+			}
+
+			// Items before lo are less than s and items from hi on are greater, so only [lo, hi) need full compares
+			const uint64_t prefix = s.getSearchPrefix(skip);
+			const uint64_t* prefixes = mirror->searchPrefixes.data();
+			int count = mirror->searchPrefixes.size();
+			int lo = std::lower_bound(prefixes, prefixes + count, prefix) - prefixes;
+			int hi = std::upper_bound(prefixes + lo, prefixes + count, prefix) - prefixes;
+			while (lo < hi) {
+				int mid = lo + (hi - lo) / 2;
+				cmp = s.compare(mirror->searchNodes[mid]->item, skip);
+				if (cmp == 0) {
+					node = mirror->searchNodes[mid];
+					return true;
+				}
+				if (cmp > 0) {
+					lo = mid + 1;
+				} else {
+					hi = mid;
+				}
+			}
+
+			// s falls between lo - 1 and lo.  Of two adjacent items one is an ancestor of the other, and the deeper
+			// one is where a search from the root would end.
+			int prev = lo - 1;
+			if (prev < 0) {
+				node = mirror->searchNodes[lo];
+			} else if (lo == count) {
+				node = mirror->searchNodes[prev];
+			} else {
+				node = mirror->searchDepths[prev] > mirror->searchDepths[lo] ? mirror->searchNodes[prev]
+				                                                             : mirror->searchNodes[lo];
+			}
+			cmp = s.compare(node->item, skip);
+			return true;
+		}
+
 		bool _hideDeletedBackward() {
 			while (node != nullptr && node->isDeleted()) {
 				_movePrev();
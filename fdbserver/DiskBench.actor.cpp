@@ -0,0 +1,280 @@
+/*
+ * DiskBench.actor.cpp
+ *
+ * This source file is part of the FoundationDB open source project
+ *
+ * Copyright 2013-2020 Apple Inc. and the FoundationDB project authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Characterizes a disk for capacity planning with the I/O patterns of the server's own files:
+//   fdbserver -r diskbench --datadir /var/lib/foundationdb/data
+// The test file is opened unbuffered and uncached, so on Linux it goes through AsyncFileKAIO with O_DIRECT exactly as
+// the storage engines and the DiskQueue do, and the page cache doesn't hide the device.
+
+#include <cinttypes>
+#include "flow/flow.h"
+#include "flow/Histogram.h"
+#include "flow/Platform.h"
+#include "fdbrpc/IAsyncFile.h"
+#include "fdbserver/DiskBench.h"
+#include "fdbserver/Knobs.h"
+#include "flow/actorcompiler.h" // This must be the last #include.
+
+namespace {
+
+const int diskBenchBlockSize = 4096;
+
+struct DiskBenchConfig {
+	int64_t fileSize = 1LL << 30;
+	double phaseDuration = 10.0;
+	int fillWriteSize = 1 << 20;
+	std::vector<int> readQueueDepths = { 1, 8, 32, 128 };
+	// The p99 latency of a cache-missing point read that a storage server can serve without falling behind
+	double readLatencyTarget = 0.005;
+	std::vector<int> appendSizes = { 4096, 64 << 10, 1 << 20 };
+	int pageWritesPerCommit = 256;
+	int pageWriteQueueDepth = 64;
+};
+
+struct AlignedBuffer : ReferenceCounted<AlignedBuffer>, NonCopyable {
+	uint8_t* data;
+	explicit AlignedBuffer(int size) : data((uint8_t*)aligned_alloc(diskBenchBlockSize, size)) {
+		// Random contents so that a compressing or deduplicating drive does the same work as for real data
+		generateRandomData(data, size);
+	}
+	~AlignedBuffer() { aligned_free(data); }
+};
+
+struct PhaseResult {
+	LogLinearHistogram latency;
+	int64_t ops = 0;
+	int64_t bytes = 0;
+	double elapsed = 0;
+
+	double rate() const { return elapsed > 0 ? ops / elapsed : 0; }
+	double bandwidth() const { return elapsed > 0 ? bytes / elapsed : 0; }
+};
+
+void reportPhase(const char* phase, int parameter, PhaseResult const& result) {
+	printf("%-12s %8d %10" PRId64 " ops %10.1f ops/s %8.2f MB/s  latency p50 %.6f p90 %.6f p99 %.6f max %.6f\n", phase,
+	       parameter, result.ops, result.rate(), result.bandwidth() / 1e6, result.latency.median(),
+	       result.latency.percentile(0.9), result.latency.percentile(0.99), result.latency.max());
+	TraceEvent("DiskBench")
+	    .detail("Phase", phase)
+	    .detail("Parameter", parameter)
+	    .detail("Operations", result.ops)
+	    .detail("Bytes", result.bytes)
+	    .detail("Elapsed", result.elapsed)
+	    .detail("Rate", result.rate())
+	    .detail("LatencyP50", result.latency.median())
+	    .detail("LatencyP90", result.latency.percentile(0.9))
+	    .detail("LatencyP99", result.latency.percentile(0.99))
+	    .detail("LatencyMax", result.latency.max())
+	    .detail("Histogram", result.latency.toString());
+}
+
+// Writes the whole file once, so that later reads hit allocated blocks instead of holes the filesystem answers
+// without touching the device
+ACTOR Future<PhaseResult> fillFile(Reference<IAsyncFile> file, DiskBenchConfig* config) {
+	state PhaseResult result;
+	state Reference<AlignedBuffer> buf = makeReference<AlignedBuffer>(config->fillWriteSize);
+	state double start = timer();
+	wait(file->truncate(config->fileSize));
+	state int64_t offset = 0;
+	for (; offset < config->fileSize; offset += config->fillWriteSize) {
+		state double writeStart = timer();
+		wait(file->write(buf->data, config->fillWriteSize, offset));
+		result.latency.addSample(timer() - writeStart);
+		result.ops++;
+		result.bytes += config->fillWriteSize;
+	}
+	wait(file->sync());
+	result.elapsed = timer() - start;
+	return result;
+}
+
+ACTOR Future<Void> randomReader(Reference<IAsyncFile> file, int64_t blocks, double end, PhaseResult* result) {
+	state Reference<AlignedBuffer> buf = makeReference<AlignedBuffer>(diskBenchBlockSize);
+	while (timer() < end) {
+		state double start = timer();
+		int bytes = wait(file->read(buf->data, diskBenchBlockSize,
+		                            deterministicRandom()->randomInt64(0, blocks) * diskBenchBlockSize));
+		result->latency.addSample(timer() - start);
+		result->ops++;
+		result->bytes += bytes;
+	}
+	return Void();
+}
+
+// A storage server's reads that miss its cache are independent 4KiB page reads, as many at once as it has
+// outstanding requests
+ACTOR Future<PhaseResult> benchRandomReads(Reference<IAsyncFile> file, DiskBenchConfig* config, int queueDepth) {
+	state PhaseResult result;
+	state double start = timer();
+	state std::vector<Future<Void>> readers;
+	for (int i = 0; i < queueDepth; i++) {
+		readers.push_back(
+		    randomReader(file, config->fileSize / diskBenchBlockSize, start + config->phaseDuration, &result));
+	}
+	wait(waitForAll(readers));
+	result.elapsed = timer() - start;
+	return result;
+}
+
+// The DiskQueue appends each TLog commit to the end of its file and acknowledges it only after the sync
+ACTOR Future<PhaseResult> benchAppends(Reference<IAsyncFile> file, DiskBenchConfig* config, int appendSize) {
+	state PhaseResult result;
+	state Reference<AlignedBuffer> buf = makeReference<AlignedBuffer>(appendSize);
+	state int64_t offset = 0;
+	state double start = timer();
+	while (timer() < start + config->phaseDuration) {
+		state double commitStart = timer();
+		if (offset + appendSize > config->fileSize) {
+			offset = 0;
+		}
+		wait(file->write(buf->data, appendSize, offset));
+		wait(file->sync());
+		result.latency.addSample(timer() - commitStart);
+		result.ops++;
+		result.bytes += appendSize;
+		offset += appendSize;
+	}
+	result.elapsed = timer() - start;
+	return result;
+}
+
+ACTOR Future<Void> pageWriter(Reference<IAsyncFile> file, int64_t pages, int pageSize, int* remaining,
+                              PhaseResult* result) {
+	state Reference<AlignedBuffer> buf = makeReference<AlignedBuffer>(pageSize);
+	while (*remaining > 0) {
+		--*remaining;
+		state double start = timer();
+		wait(file->write(buf->data, pageSize, deterministicRandom()->randomInt64(0, pages) * pageSize));
+		result->latency.addSample(timer() - start);
+		result->ops++;
+		result->bytes += pageSize;
+	}
+	return Void();
+}
+
+// Redwood's pager writes a commit's dirty pages concurrently to free pages scattered through the file, then syncs.
+// Returns the page write results and the commit results.
+ACTOR Future<std::pair<PhaseResult, PhaseResult>> benchPageWrites(Reference<IAsyncFile> file,
+                                                                  DiskBenchConfig* config, int pageSize) {
+	state PhaseResult writes;
+	state PhaseResult commits;
+	state double start = timer();
+	while (timer() < start + config->phaseDuration) {
+		state double commitStart = timer();
+		state int remaining = config->pageWritesPerCommit;
+		state std::vector<Future<Void>> writers;
+		for (int i = 0; i < config->pageWriteQueueDepth; i++) {
+			writers.push_back(pageWriter(file, config->fileSize / pageSize, pageSize, &remaining, &writes));
+		}
+		wait(waitForAll(writers));
+		wait(file->sync());
+		commits.latency.addSample(timer() - commitStart);
+		commits.ops++;
+		commits.bytes += (int64_t)config->pageWritesPerCommit * pageSize;
+	}
+	writes.elapsed = commits.elapsed = timer() - start;
+	return std::make_pair(writes, commits);
+}
+
+} // namespace
+
+ACTOR Future<Void> diskBench(std::string dataFolder) {
+	state DiskBenchConfig config;
+	state std::string folder = dataFolder.size() ? dataFolder : ".";
+	state std::string filename = joinPath(folder, "diskbench.tmp");
+	state Reference<IAsyncFile> file;
+	state Error err;
+	state int i = 0;
+
+	// The projections for a single process
+	state double readCapacity = 0;
+	state int readCapacityQueueDepth = 0;
+	state double commitCapacity = 0;
+	state double logBandwidth = 0;
+	state double pageWriteBandwidth = 0;
+
+	platform::createDirectory(folder);
+	printf("Benchmarking `%s' with a %" PRId64 " MB file, %.0f seconds per phase\n", filename.c_str(),
+	       config.fileSize >> 20, config.phaseDuration);
+	try {
+		Reference<IAsyncFile> f = wait(IAsyncFileSystem::filesystem()->open(
+		    filename,
+		    IAsyncFile::OPEN_READWRITE | IAsyncFile::OPEN_CREATE | IAsyncFile::OPEN_UNCACHED |
+		        IAsyncFile::OPEN_UNBUFFERED | IAsyncFile::OPEN_LOCK,
+		    0600));
+		file = f;
+
+		PhaseResult fill = wait(fillFile(file, &config));
+		reportPhase("Fill", config.fillWriteSize, fill);
+
+		for (i = 0; i < config.readQueueDepths.size(); i++) {
+			PhaseResult reads = wait(benchRandomReads(file, &config, config.readQueueDepths[i]));
+			reportPhase("RandomRead", config.readQueueDepths[i], reads);
+			if (reads.latency.percentile(0.99) <= config.readLatencyTarget && reads.rate() > readCapacity) {
+				readCapacity = reads.rate();
+				readCapacityQueueDepth = config.readQueueDepths[i];
+			}
+		}
+
+		for (i = 0; i < config.appendSizes.size(); i++) {
+			PhaseResult appends = wait(benchAppends(file, &config, config.appendSizes[i]));
+			reportPhase("AppendSync", config.appendSizes[i], appends);
+			if (config.appendSizes[i] == diskBenchBlockSize) {
+				commitCapacity = appends.rate();
+			}
+			logBandwidth = std::max(logBandwidth, appends.bandwidth());
+		}
+
+		std::pair<PhaseResult, PhaseResult> pageWrites =
+		    wait(benchPageWrites(file, &config, SERVER_KNOBS->REDWOOD_DEFAULT_PAGE_SIZE));
+		reportPhase("PageWrite", SERVER_KNOBS->REDWOOD_DEFAULT_PAGE_SIZE, pageWrites.first);
+		reportPhase("PageCommit", config.pageWritesPerCommit, pageWrites.second);
+		pageWriteBandwidth = pageWrites.first.bandwidth();
+
+		printf("\nProjected capacity of one process on this disk:\n");
+		if (readCapacityQueueDepth) {
+			printf("  storage server: %.0f uncached point reads/s at queue depth %d with p99 under %.1f ms\n",
+			       readCapacity, readCapacityQueueDepth, config.readLatencyTarget * 1e3);
+		} else {
+			printf("  storage server: no queue depth kept the p99 of uncached point reads under %.1f ms\n",
+			       config.readLatencyTarget * 1e3);
+		}
+		printf("  storage server: %.2f MB/s of Redwood page writes\n", pageWriteBandwidth / 1e6);
+		printf("  tlog: %.0f small commits/s, %.2f MB/s of mutations in large commits\n", commitCapacity,
+		       logBandwidth / 1e6);
+		TraceEvent("DiskBenchCapacity")
+		    .detail("Filename", filename)
+		    .detail("PointReadsPerSecond", readCapacity)
+		    .detail("PointReadQueueDepth", readCapacityQueueDepth)
+		    .detail("PageWriteBytesPerSecond", pageWriteBandwidth)
+		    .detail("CommitsPerSecond", commitCapacity)
+		    .detail("LogBytesPerSecond", logBandwidth);
+	} catch (Error& e) {
+		fprintf(stderr, "ERROR: Disk benchmark of `%s' failed: %s\n", filename.c_str(), e.what());
+		err = e;
+	}
+
+	file = Reference<IAsyncFile>();
+	wait(IAsyncFileSystem::filesystem()->deleteFile(filename, false));
+	if (err.code() != invalid_error_code) {
+		throw err;
+	}
+	return Void();
+}
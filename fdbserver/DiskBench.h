@@ -0,0 +1,31 @@
+/*
+ * DiskBench.h
+ *
+ * This source file is part of the FoundationDB open source project
+ *
+ * Copyright 2013-2020 Apple Inc. and the FoundationDB project authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FDBSERVER_DISKBENCH_H
+#define FDBSERVER_DISKBENCH_H
+#pragma once
+
+#include "flow/flow.h"
+
+// Measures the disk under dataFolder with the I/O patterns of the storage engines and the TLog's DiskQueue, and
+// prints latency percentiles with the capacity a single process could expect from it (fdbserver -r diskbench).
+Future<Void> diskBench(std::string const& dataFolder);
+
+#endif
@@ -163,7 +163,7 @@ class RawDiskQueue_TwoFiles : public Tracked<RawDiskQueue_TwoFiles> {
 public:
 	RawDiskQueue_TwoFiles( std::string basename, std::string fileExtension, UID dbgid, int64_t fileSizeWarningLimit )
 		: basename(basename), fileExtension(fileExtension), onError(delayed(error.getFuture())), onStopped(stopped.getFuture()),
-		readingFile(-1), readingPage(-1), writingPos(-1), dbgid(dbgid),
+		readingFile(-1), readingPage(-1), readAheadFile(-1), readAheadPage(-1), writingPos(-1), dbgid(dbgid),
 		dbg_file0BeginSeq(0), fileExtensionBytes(SERVER_KNOBS->DISK_QUEUE_FILE_EXTENSION_BYTES),
 		fileShrinkBytes(SERVER_KNOBS->DISK_QUEUE_FILE_SHRINK_BYTES), readingBuffer( dbgid ),
 		readyToPush(Void()), fileSizeWarningLimit(fileSizeWarningLimit), lastCommit(Void()), isFirstCommit(true)
@@ -265,6 +265,9 @@ public:
 	StringBuffer readingBuffer; // Pages that have been read and not yet returned
 	int readingFile;  // File index where the next page (after readingBuffer) should be read from, i.e., files[readingFile]. readingFile = 2 if recovery is complete (all files have been read). 
 	int64_t readingPage;  // Page within readingFile that is the next page after readingBuffer
+	Future<Standalone<StringRef>> readAhead; // During recovery, the read of the chunk that follows readingBuffer
+	int readAheadFile;  // Where readAhead was read from, which may be past the end of readingFile
+	int64_t readAheadPage;
 
 	int64_t writingPos;  // Position within files[1] that will be next written
 
@@ -674,29 +677,54 @@ public:
 		return result;
 	}
 
-	Future<int> fillReadingBuffer() {
-		// If we're right at the end of a file...
-		if ( readingPage*sizeof(Page) >= (size_t)files[readingFile].size ) {
-			readingFile++;
-			readingPage = 0;
-			if (readingFile>=2) {
-				// Recovery complete
-				readingBuffer.clear();
-				writingPos = files[1].size;
-				return 0;
-			}
+	// Reads nPages into a buffer of its own, so that it can be left running past the point where recovery stops reading
+	ACTOR static UNCANCELLABLE Future<Standalone<StringRef>> readChunk(RawDiskQueue_TwoFiles* self, int file, int64_t page, int len) {
+		state TrackMe trackMe(self);
+		state Standalone<StringRef> result = makeAlignedString(sizeof(Page), len);
+		int bytesRead = wait( self->files[file].f->read( mutateString(result), len, page*sizeof(Page) ) );
+		ASSERT( bytesRead == len );
+		return result;
+	}
+
+	// Starts reading the chunk that begins at (file, page), or at the start of the next file if that is the end of this one
+	void startReadAhead( int file, int64_t page ) {
+		if ( page*sizeof(Page) >= (size_t)files[file].size ) {
+			file++;
+			page = 0;
 		}
+		readAheadFile = file;
+		readAheadPage = page;
+		if (file >= 2) {
+			readAhead = Standalone<StringRef>();
+			return;
+		}
+
+		int len = std::min<int64_t>( (files[file].size/sizeof(Page) - page)*sizeof(Page), BUGGIFY_WITH_PROB(1.0) ? sizeof(Page)*deterministicRandom()->randomInt(1,4) : SERVER_KNOBS->DISK_QUEUE_RECOVERY_READ_BYTES );
+		readAhead = readChunk( this, file, page, len );
+	}
 
-		// Read up to 1MB into readingBuffer
-		int len = std::min<int64_t>( (files[readingFile].size/sizeof(Page) - readingPage)*sizeof(Page), BUGGIFY_WITH_PROB(1.0) ? sizeof(Page)*deterministicRandom()->randomInt(1,4) : (1<<20) );
-		readingBuffer.clear();
-		readingBuffer.alignReserve( sizeof(Page), len );
-		void* p = readingBuffer.append(len);
+	// Moves the chunk after readingBuffer into it, and starts reading the one after that so that the disk is kept busy
+	// while the caller parses this one
+	ACTOR static Future<int> fillReadingBuffer( RawDiskQueue_TwoFiles* self ) {
+		if (!self->readAhead.isValid()) self->startReadAhead( self->readingFile, self->readingPage );
+		state int file = self->readAheadFile;
+		state int64_t page = self->readAheadPage;
+		Standalone<StringRef> chunk = wait( self->readAhead );
+		self->readAhead = Future<Standalone<StringRef>>();
+
+		self->readingFile = file;
+		self->readingBuffer.clear();
+		if (file >= 2) {
+			// Recovery complete
+			self->writingPos = self->files[1].size;
+			return 0;
+		}
 
-		auto pos = readingPage * sizeof(Page);
-		readingPage += len / sizeof(Page);
-		ASSERT( int64_t(p) % sizeof(Page) == 0 );
-		return files[readingFile].f->read( p, len, pos );
+		self->readingPage = page + chunk.size() / sizeof(Page);
+		ASSERT( int64_t(chunk.begin()) % sizeof(Page) == 0 );
+		self->readingBuffer.str = chunk;
+		self->startReadAhead( self->readingFile, self->readingPage );
+		return chunk.size();
 	}
 
 	ACTOR static UNCANCELLABLE Future<Standalone<StringRef>> readNextPage(RawDiskQueue_TwoFiles* self) {
@@ -711,7 +739,7 @@ public:
 				state Future<Void> f = Void();
 				//if (BUGGIFY) f = delay( deterministicRandom()->random01() * 0.1 );
 
-				int read = wait( self->fillReadingBuffer() );
+				int read = wait( fillReadingBuffer(self) );
 				ASSERT( read == self->readingBuffer.size() );
 
 				wait(f);
@@ -753,6 +781,12 @@ public:
 			TEST( file==0 ); // truncate before last read page on file 0
 			TEST( file==1 && pos != self->files[1].size ); // truncate before last read page on file 1
 
+			// Don't leave a read of pages past the end of the queue outstanding while they are zeroed and rewritten
+			if (self->readAhead.isValid()) {
+				wait( success( errorOr( self->readAhead ) ) );
+				self->readAhead = Future<Standalone<StringRef>>();
+			}
+
 			self->readingFile = 2;
 			self->readingBuffer.clear();
 			self->writingPos = pos;
@@ -785,7 +819,8 @@ public:
 	// FIXME: Is setting lastCommittedSeq to -1 instead of 0 necessary?
 	DiskQueue( std::string basename, std::string fileExtension, UID dbgid, DiskQueueVersion diskQueueVersion, int64_t fileSizeWarningLimit )
 		: rawQueue( new RawDiskQueue_TwoFiles(basename, fileExtension, dbgid, fileSizeWarningLimit) ), dbgid(dbgid), diskQueueVersion(diskQueueVersion), anyPopped(false), nextPageSeq(0), poppedSeq(0), lastPoppedSeq(0),
-		  nextReadLocation(-1), readBufPage(nullptr), readBufPos(0), pushed_page_buffer(nullptr), recovered(false), initialized(false), lastCommittedSeq(-1), warnAlwaysForMemory(true)
+		  nextReadLocation(-1), readBufPage(nullptr), readBufPos(0), pushed_page_buffer(nullptr), recovered(false), initialized(false), lastCommittedSeq(-1), warnAlwaysForMemory(true),
+		  lastRawCommit(Void()), commitCoalescing(false)
 	{
 	}
 
@@ -851,6 +886,22 @@ public:
 
 	Future<Void> commit() override {
 		ASSERT( recovered );
+		// While a commit is being written, later commits wait for it and are flushed together, so that their pushes
+		// share pages instead of each one padding out a page of its own.
+		if (commitCoalescing) {
+			return coalescedCommit.getFuture();
+		}
+		if (SERVER_KNOBS->DISK_QUEUE_COALESCE_COMMITS && !lastRawCommit.isReady() && (pushedPageCount() || anyPopped)) {
+			TEST(true); // DiskQueue coalescing commits
+			commitCoalescing = true;
+			coalescedCommit = Promise<Void>();
+			commitCoalesced(this, lastRawCommit, coalescedCommit);
+			return coalescedCommit.getFuture();
+		}
+		return commitPushed();
+	}
+
+	Future<Void> commitPushed() {
 		if (!pushedPageCount()) {
 			if (!anyPopped) return Void();
 			addEmptyPage(); // To remove poped pages, we push an empty page to specify that pages behind it were poped.
@@ -880,6 +931,7 @@ public:
 		auto f = rawQueue->pushAndCommit( pushed_page_buffer->ref(), pushed_page_buffer, poppedSeq/sizeof(Page) - lastPoppedSeq/sizeof(Page) );
 		lastPoppedSeq = poppedSeq;
 		pushed_page_buffer = 0;
+		lastRawCommit = f;
 		return f;
 	}
 
@@ -930,6 +982,18 @@ private:
 		delete self;
 	}
 
+	ACTOR static void commitCoalesced(DiskQueue* self, Future<Void> previous, Promise<Void> committed) {
+		state TrackMe trackMe(self);
+		wait(success(errorOr(previous)));
+		self->commitCoalescing = false;
+		try {
+			wait(self->commitPushed());
+			committed.send(Void());
+		} catch (Error& e) {
+			committed.sendError(e);
+		}
+	}
+
 	ACTOR static void close(DiskQueue* self) {
 		wait( self->onSafeToDestruct() );
 		TraceEvent("DQCloseDone", self->dbgid).detail("File0Name", self->rawQueue->files[0].dbgFilename);
@@ -996,6 +1060,32 @@ private:
 				return false;
 			}
 		}
+		// checkHash() for each of count consecutive pages, with the crc32c checksums computed as a batch
+		static bool checkHashes(Page* pages, int count) {
+			const int batchSize = 16;
+			for (int begin = 0; begin < count; begin += batchSize) {
+				uint32_t crcs[batchSize];
+				const uint8_t* inputs[batchSize];
+				size_t lengths[batchSize];
+				Page* batch[batchSize];
+				int n = 0;
+				for (int i = begin; i < std::min(count, begin + batchSize); i++) {
+					if (pages[i].diskQueueVersion() != DiskQueueVersion::V1) {
+						if (!pages[i].checkHash()) return false;
+						continue;
+					}
+					crcs[n] = 0xfdbeefdb;
+					inputs[n] = (const uint8_t*)&pages[i]._unused;
+					lengths[n] = sizeof(Page) - sizeof(uint32_t);
+					batch[n++] = &pages[i];
+				}
+				crc32c_append_batch(crcs, inputs, lengths, n);
+				for (int i = 0; i < n; i++) {
+					if (batch[i]->hash32 != crcs[i]) return false;
+				}
+			}
+			return true;
+		}
 		void zeroPad() {
 			memset( payload+payloadSize, 0, maxPayload-payloadSize );
 		}
@@ -1137,7 +1227,8 @@ private:
 			// we don't have to double allocate in a hot, memory hungry call.
 			uint8_t *buf = mutateString(pagedData);
 			Page *data = reinterpret_cast<Page*>(const_cast<uint8_t*>(pagedData.begin()));
-			if (ch == CheckHashes::YES && !data->checkHash()) throw io_error();
+			// Check every page up front, before copying payloads over their headers
+			if (ch == CheckHashes::YES && !Page::checkHashes(data, pagedData.size() / sizeof(Page))) throw io_error();
 			if (ch == CheckHashes::NO && data->payloadSize > Page::maxPayload) throw io_error();
 
 			// Only start copying from `start` in the first page.
@@ -1147,7 +1238,6 @@ private:
 				buf += length;
 			}
 			data++;
-			if (ch == CheckHashes::YES && !data->checkHash()) throw io_error();
 			if (ch == CheckHashes::NO && data->payloadSize > Page::maxPayload) throw io_error();
 
 			// Copy all the middle pages
@@ -1158,7 +1248,6 @@ private:
 				memmove(buf, data->payload, length);
 				buf += length;
 				data++;
-				if (ch == CheckHashes::YES && !data->checkHash()) throw io_error();
 				if (ch == CheckHashes::NO && data->payloadSize > Page::maxPayload) throw io_error();
 			}
 
@@ -1368,6 +1457,10 @@ private:
 	loc_t lastPoppedSeq;  // poppedSeq the last time commit was called.
 	loc_t lastCommittedSeq; // The seq location where the last commit finishes at.
 
+	Future<Void> lastRawCommit; // The most recent commit handed to rawQueue
+	bool commitCoalescing;  // commit() has been called since lastRawCommit, and will be flushed when it is durable
+	Promise<Void> coalescedCommit;
+
 	// Buffer of pushed pages that haven't been committed.  The last one (backPage()) is still mutable.
 	StringBuffer* pushed_page_buffer;
 	Page& backPage() {
@@ -36,6 +36,7 @@ struct GrvProxyStats {
 	Counter txnBatchPriorityStartIn, txnBatchPriorityStartOut;
 	Counter txnDefaultPriorityStartIn, txnDefaultPriorityStartOut;
 	Counter txnThrottled;
+	Counter txnTagThrottled;
 
 	LatencyBands grvLatencyBands;
 	LatencySample grvLatencySample;
@@ -78,8 +79,8 @@ struct GrvProxyStats {
 	    txnBatchPriorityStartOut("TxnBatchPriorityStartOut", cc),
 	    txnDefaultPriorityStartIn("TxnDefaultPriorityStartIn", cc),
 	    txnDefaultPriorityStartOut("TxnDefaultPriorityStartOut", cc), txnThrottled("TxnThrottled", cc),
-	    grvLatencySample("GRVLatencyMetrics", id, SERVER_KNOBS->LATENCY_METRICS_LOGGING_INTERVAL,
-	                     SERVER_KNOBS->LATENCY_SAMPLE_SIZE),
+	    txnTagThrottled("TxnTagThrottled", cc),
+	    grvLatencySample("GRVLatencyMetrics", id, SERVER_KNOBS->LATENCY_METRICS_LOGGING_INTERVAL),
 	    grvLatencyBands("GRVLatencyMetrics", id, SERVER_KNOBS->STORAGE_LOGGING_DELAY) {
 		logger = traceCounters("GrvProxyMetrics", id, SERVER_KNOBS->WORKER_LOGGING_INTERVAL, &cc, "GrvProxyMetrics");
 		for(int i = 0; i < FLOW_KNOBS->BASIC_LOAD_BALANCE_BUCKETS; i++) {
@@ -161,6 +162,89 @@ struct GrvTransactionRateInfo {
 	}
 };
 
+// Token buckets for the tags that ratekeeper has throttled, so that the proxy holds each tag to its share of the
+// throttled rate itself instead of relying on clients to do so.  Requests for a tag that has run out of tokens wait in
+// a queue of their own until the bucket refills or the throttle expires, while other requests go ahead.
+struct GrvTagThrottler {
+	struct TagBucket {
+		double rate = 0; // This proxy's share of the tag's rate, in transactions per second
+		double tokens = 0;
+		double expiration = 0;
+	};
+
+	PrioritizedTransactionTagMap<TagBucket> buckets;
+	std::deque<GetReadVersionRequest> throttled;
+	double lastRefill = now();
+
+	// Replaces the buckets with ones for the throttles most recently received from ratekeeper, carrying over the tokens
+	// of those that remain and adding the tokens earned since the last refill
+	void refill(PrioritizedTransactionTagMap<ClientTagThrottleLimits> const& throttledTags, int proxyCount) {
+		double elapsed = now() - lastRefill;
+		lastRefill = now();
+
+		PrioritizedTransactionTagMap<TagBucket> refilled;
+		for (auto const& [priority, tags] : throttledTags) {
+			auto oldBuckets = buckets.find(priority);
+			for (auto const& [tag, limits] : tags) {
+				if (limits.expiration <= now() || limits.tpsRate == std::numeric_limits<double>::max()) {
+					continue;
+				}
+				TagBucket& bucket = refilled[priority][tag];
+				bucket.rate = limits.tpsRate / proxyCount;
+				bucket.expiration = limits.expiration;
+				double capacity = bucket.rate * SERVER_KNOBS->START_TRANSACTION_TAG_THROTTLE_BURST;
+				if (oldBuckets != buckets.end() && oldBuckets->second.count(tag)) {
+					bucket.tokens = std::min(capacity, oldBuckets->second[tag].tokens + elapsed * bucket.rate);
+				} else {
+					bucket.tokens = capacity;
+				}
+			}
+		}
+		buckets = std::move(refilled);
+	}
+
+	// Whether req may start now, taking its tokens if so.  A bucket with any tokens left may go into debt, so that a
+	// request for more transactions than it can hold still starts eventually.
+	bool tryStart(GetReadVersionRequest const& req) {
+		if (req.tags.empty() || buckets.empty()) {
+			return true;
+		}
+		auto priorityBuckets = buckets.find(req.priority);
+		if (priorityBuckets == buckets.end()) {
+			return true;
+		}
+		for (auto const& [tag, count] : req.tags) {
+			auto bucket = priorityBuckets->second.find(tag);
+			if (bucket != priorityBuckets->second.end() && bucket->second.tokens <= 0 &&
+			    bucket->second.expiration > now()) {
+				return false;
+			}
+		}
+		for (auto const& [tag, count] : req.tags) {
+			auto bucket = priorityBuckets->second.find(tag);
+			if (bucket != priorityBuckets->second.end()) {
+				bucket->second.tokens -= count;
+			}
+		}
+		return true;
+	}
+
+	// Removes and returns the throttled requests that may now start, oldest first
+	std::vector<GetReadVersionRequest> releaseReady() {
+		std::vector<GetReadVersionRequest> ready;
+		std::deque<GetReadVersionRequest> stillThrottled;
+		for (auto& req : throttled) {
+			if (tryStart(req)) {
+				ready.push_back(std::move(req));
+			} else {
+				stillThrottled.push_back(std::move(req));
+			}
+		}
+		throttled = std::move(stillThrottled);
+		return ready;
+	}
+};
+
 struct GrvProxyData {
 	GrvProxyInterface proxy;
 	UID dbgid;
@@ -297,7 +381,8 @@ ACTOR Future<Void> queueGetReadVersionRequests(
     SpannedDeque<GetReadVersionRequest>* defaultQueue, SpannedDeque<GetReadVersionRequest>* batchQueue,
     FutureStream<GetReadVersionRequest> readVersionRequests, PromiseStream<Void> GRVTimer, double* lastGRVTime,
     double* GRVBatchTime, FutureStream<double> normalGRVLatency, GrvProxyStats* stats,
-    GrvTransactionRateInfo* batchRateInfo, TransactionTagMap<uint64_t>* transactionTagCounter) {
+    GrvTransactionRateInfo* batchRateInfo, TransactionTagMap<uint64_t>* transactionTagCounter,
+    GrvTagThrottler* tagThrottler) {
 	loop choose{
 			when(GetReadVersionRequest req = waitNext(readVersionRequests)) {
 				//WARNING: this code is run at a high priority, so it needs to do as little work as possible
@@ -311,20 +396,29 @@ ACTOR Future<Void> queueGetReadVersionRequests(
 					TraceEvent(SevWarnAlways, "ProxyGRVThresholdExceeded").suppressFor(60);
 				} else {
 					stats->addRequest(req.transactionCount);
-					// TODO: check whether this is reasonable to do in the fast path
-					for(auto tag : req.tags) {
-						(*transactionTagCounter)[tag.first] += tag.second;
-					}
 
 					if (req.debugID.present())
 						g_traceBatch.addEvent("TransactionDebug", req.debugID.get().first(), "GrvProxyServer.queueTransactionStartRequests.Before");
 
-					if (systemQueue->empty() && defaultQueue->empty() && batchQueue->empty()) {
+					if (systemQueue->empty() && defaultQueue->empty() && batchQueue->empty() &&
+					    tagThrottler->throttled.empty()) {
 						forwardPromise(GRVTimer, delayJittered(std::max(0.0, *GRVBatchTime - (now() - *lastGRVTime)), TaskPriority::ProxyGRVTimer));
 					}
 
 					++stats->txnRequestIn;
 					stats->txnStartIn += req.transactionCount;
+					if (!tagThrottler->tryStart(req)) {
+						TEST(true); // GRV proxy holding request for throttled tag
+						stats->txnTagThrottled += req.transactionCount;
+						tagThrottler->throttled.push_back(req);
+						continue;
+					}
+					// Held requests are counted when they are released, so that ratekeeper sees the rate at which
+					// each tag actually starts
+					// TODO: check whether this is reasonable to do in the fast path
+					for(auto tag : req.tags) {
+						(*transactionTagCounter)[tag.first] += tag.second;
+					}
 					if (req.priority >= TransactionPriority::IMMEDIATE) {
 						stats->txnSystemPriorityStartIn += req.transactionCount;
 						systemQueue->push_back(req);
@@ -561,6 +655,7 @@ ACTOR static Future<Void> transactionStarter(GrvProxyInterface proxy, Reference<
 
 	state TransactionTagMap<uint64_t> transactionTagCounter;
 	state PrioritizedTransactionTagMap<ClientTagThrottleLimits> throttledTags;
+	state GrvTagThrottler tagThrottler;
 
 	state PromiseStream<double> normalGRVLatency;
 	state Span span;
@@ -572,7 +667,7 @@ ACTOR static Future<Void> transactionStarter(GrvProxyInterface proxy, Reference<
 	addActor.send(queueGetReadVersionRequests(db, &systemQueue, &defaultQueue, &batchQueue,
 	                                          proxy.getConsistentReadVersion.getFuture(), GRVTimer, &lastGRVTime,
 	                                          &GRVBatchTime, normalGRVLatency.getFuture(), &grvProxyData->stats,
-	                                          &batchRateInfo, &transactionTagCounter));
+	                                          &batchRateInfo, &transactionTagCounter, &tagThrottler));
 
 	while (std::find(db->get().client.grvProxies.begin(), db->get().client.grvProxies.end(), proxy) ==
 	       db->get().client.grvProxies.end()) {
@@ -597,6 +692,29 @@ ACTOR static Future<Void> transactionStarter(GrvProxyInterface proxy, Reference<
 		normalRateInfo.reset();
 		batchRateInfo.reset();
 
+		if (SERVER_KNOBS->START_TRANSACTION_ENFORCE_TAG_THROTTLES) {
+			tagThrottler.refill(throttledTags, std::max((int)db->get().client.grvProxies.size(), 1));
+			GrvProxyStats& stats = grvProxyData->stats;
+			for (auto& req : tagThrottler.releaseReady()) {
+				for (auto const& [tag, count] : req.tags) {
+					transactionTagCounter[tag] += count;
+				}
+				if (req.priority >= TransactionPriority::IMMEDIATE) {
+					stats.txnSystemPriorityStartIn += req.transactionCount;
+					systemQueue.push_back(req);
+					systemQueue.span.addParent(req.spanContext);
+				} else if (req.priority >= TransactionPriority::DEFAULT) {
+					stats.txnDefaultPriorityStartIn += req.transactionCount;
+					defaultQueue.push_back(req);
+					defaultQueue.span.addParent(req.spanContext);
+				} else {
+					stats.txnBatchPriorityStartIn += req.transactionCount;
+					batchQueue.push_back(req);
+					batchQueue.span.addParent(req.spanContext);
+				}
+			}
+		}
+
 		int transactionsStarted[2] = {0,0};
 		int systemTransactionsStarted[2] = {0,0};
 		int defaultPriTransactionsStarted[2] = { 0, 0 };
@@ -649,7 +767,7 @@ ACTOR static Future<Void> transactionStarter(GrvProxyInterface proxy, Reference<
 			requestsToStart++;
 		}
 
-		if (!systemQueue.empty() || !defaultQueue.empty() || !batchQueue.empty()) {
+		if (!systemQueue.empty() || !defaultQueue.empty() || !batchQueue.empty() || !tagThrottler.throttled.empty()) {
 			forwardPromise(GRVTimer, delayJittered(SERVER_KNOBS->START_TRANSACTION_BATCH_QUEUE_CHECK_INTERVAL, TaskPriority::ProxyGRVTimer));
 		}
 
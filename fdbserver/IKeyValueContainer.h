@@ -25,7 +25,7 @@
 
 // Stored in the IndexedSets that hold the database.
 // Each KeyValueMapPair is 32 bytes, excluding arena memory.
-// It is stored in an IndexedSet<KeyValueMapPair, uint64_t>::Node, for a total size of 72 bytes.
+// It is stored in an IndexedSet<KeyValueMapPair, KeyValueMetric>::Node, for a total size of 80 bytes.
 struct KeyValueMapPair {
 	Arena arena; // 8 Bytes (excluding arena memory)
 	KeyRef key; // 12 Bytes
@@ -70,10 +70,44 @@ bool operator<(CompatibleWithKey const& l, KeyValueMapPair const& r) {
 	return l < r.key;
 }
 
+template <>
+struct IndexedSetKeyOf<KeyValueMapPair> {
+	static constexpr bool enabled = true;
+	static StringRef get(KeyValueMapPair const& p) { return p.key; }
+};
+
+// The metric of each element of an IKeyValueContainer: the memory it takes, and 1, so that the sums kept in the
+// IndexedSet also count keys
+struct KeyValueMetric {
+	uint64_t bytes = 0;
+	uint64_t count = 0;
+
+	KeyValueMetric() = default;
+	KeyValueMetric(int zero) { ASSERT(zero == 0); } // Metric metricDelta = 0 in IndexedSet::erase
+	KeyValueMetric(uint64_t bytes, uint64_t count) : bytes(bytes), count(count) {}
+
+	KeyValueMetric operator+(KeyValueMetric const& r) const { return KeyValueMetric(bytes + r.bytes, count + r.count); }
+	KeyValueMetric operator-(KeyValueMetric const& r) const { return KeyValueMetric(bytes - r.bytes, count - r.count); }
+	bool operator<(KeyValueMetric const& r) const { return bytes < r.bytes; }
+};
+
+// A position by count, for finding the nth element with IndexedSet::index()
+struct KeyValueIndex {
+	int64_t n = 0;
+
+	KeyValueIndex() = default;
+	explicit KeyValueIndex(int64_t n) : n(n) {}
+
+	KeyValueIndex operator+(KeyValueMetric const& r) const { return KeyValueIndex(n + r.count); }
+	KeyValueIndex operator-(KeyValueMetric const& r) const { return KeyValueIndex(n - r.count); }
+	bool operator<(KeyValueMetric const& r) const { return n < (int64_t)r.count; }
+	bool operator<(KeyValueIndex const& r) const { return n < r.n; }
+};
+
 class IKeyValueContainer {
 public:
-	using const_iterator = IndexedSet<KeyValueMapPair, uint64_t>::const_iterator;
-	using iterator = IndexedSet<KeyValueMapPair, uint64_t>::iterator;
+	using const_iterator = IndexedSet<KeyValueMapPair, KeyValueMetric>::const_iterator;
+	using iterator = IndexedSet<KeyValueMapPair, KeyValueMetric>::iterator;
 
 	IKeyValueContainer() = default;
 	~IKeyValueContainer() = default;
@@ -103,21 +137,32 @@ public:
 	void erase(iterator begin, iterator end) { data.erase(begin, end); }
 	iterator insert(const StringRef& key, const StringRef& val, bool replaceExisting = true) {
 		KeyValueMapPair pair(key, val);
-		return data.insert(pair, pair.arena.getSize() + data.getElementBytes(), replaceExisting);
+		return data.insert(pair, KeyValueMetric(pair.arena.getSize() + data.getElementBytes(), 1), replaceExisting);
 	}
 	int insert(const std::vector<std::pair<KeyValueMapPair, uint64_t>>& pairs, bool replaceExisting = true) {
-		return data.insert(pairs, replaceExisting);
+		withCounts.clear();
+		withCounts.reserve(pairs.size());
+		for (auto const& p : pairs) {
+			withCounts.emplace_back(p.first, KeyValueMetric(p.second, 1));
+		}
+		return data.insert(withCounts, replaceExisting);
 	}
 
-	uint64_t sumTo(const_iterator to) const { return data.sumTo(to); }
-	uint64_t sumTo(iterator to) const { return data.sumTo(const_iterator{ to }); }
+	uint64_t sumTo(const_iterator to) const { return data.sumTo(to).bytes; }
+	uint64_t sumTo(iterator to) const { return data.sumTo(const_iterator{ to }).bytes; }
+
+	// The number of elements before to, and the element with n elements before it (or end()), in O(log N) time
+	uint64_t countTo(const_iterator to) const { return data.sumTo(to).count; }
+	uint64_t countTo(iterator to) const { return data.sumTo(const_iterator{ to }).count; }
+	const_iterator index(uint64_t n) const { return data.index(KeyValueIndex(n)); }
 
-	static constexpr int getElementBytes() { return IndexedSet<KeyValueMapPair, uint64_t>::getElementBytes(); }
+	static constexpr int getElementBytes() { return IndexedSet<KeyValueMapPair, KeyValueMetric>::getElementBytes(); }
 
 private:
 	IKeyValueContainer(IKeyValueContainer const&); // unimplemented
 	void operator=(IKeyValueContainer const&); // unimplemented
-	IndexedSet<KeyValueMapPair, uint64_t> data;
+	IndexedSet<KeyValueMapPair, KeyValueMetric> data;
+	std::vector<std::pair<KeyValueMapPair, KeyValueMetric>> withCounts; // Reused by the batch insert
 };
 
 #endif
@@ -24,6 +24,7 @@
 
 #include "fdbclient/FDBTypes.h"
 #include "fdbserver/Knobs.h"
+#include "flow/genericactors.actor.h"
 
 class IClosable {
 public:
@@ -35,6 +36,15 @@ public:
 	virtual void close() = 0;     // invalidate this interface, but do not delete the data.  Outstanding operations may or may not take effect in the background.
 };
 
+// The result of IKeyValueStore::skipKeys()
+struct SkippedKeys {
+	Optional<Key> key; // The key reached, if there were enough keys
+	int64_t count = 0; // The keys passed over, including key if present
+
+	SkippedKeys() = default;
+	SkippedKeys(Optional<Key> key, int64_t count) : key(key), count(count) {}
+};
+
 class IKeyValueStore : public IClosable {
 public:
 	virtual KeyValueStoreType getType() const = 0;
@@ -42,15 +52,60 @@ public:
 	virtual void clear(KeyRangeRef range, const Arena* arena = nullptr) = 0;
 	virtual Future<Void> commit(bool sequential = false) = 0;  // returns when prior sets and clears are (atomically) durable
 
+	// Bulk loading writes a block of distinct key-value pairs, sorted by key, as if by set() on each.  It takes effect
+	// in order with other writes at the next commit(), but unlike set() the block may become durable before that commit
+	// returns (or even if it never happens), so it must only be used for keys that are discarded on recovery unless a
+	// later commit says otherwise.  Stores that can load a block more cheaply than by individual sets say so here.
+	virtual bool canBulkLoad() const { return false; }
+	virtual void bulkLoad(Standalone<VectorRef<KeyValueRef>> data) {
+		for (auto& kv : data) set(kv, &data.arena());
+	}
+
+	// Hints that range, which holds no data, is about to be filled as one unit (such as a shard being fetched) that is
+	// likely to be cleared as one later, so that the store can keep it apart from other data.  Writes to the range
+	// must wait for the returned future.
+	virtual Future<Void> reserveRange(KeyRangeRef range) { return Void(); }
+
+	// Stores that keep older versions of their contents can retain the contents as of chosen commits.
+	// retainSnapshot(v, oldestRetained) names what the next commit() makes durable snapshot v, and lets the store drop
+	// snapshots older than oldestRetained.  Snapshot v can be read with readRangeAtSnapshot() once hasSnapshot(v).
+	virtual bool canRetainSnapshots() const { return false; }
+	virtual void retainSnapshot(Version v, Version oldestRetained) {}
+	virtual bool hasSnapshot(Version v) const { return false; }
+	virtual Future<Standalone<RangeResultRef>> readRangeAtSnapshot(KeyRangeRef keys, Version v, int rowLimit = 1 << 30,
+	                                                               int byteLimit = 1 << 30) {
+		return unsupported_operation();
+	}
+
 	virtual Future<Optional<Value>> readValue( KeyRef key, Optional<UID> debugID = Optional<UID>() ) = 0;
 
 	// Like readValue(), but returns only the first maxLength bytes of the value if it is longer
 	virtual Future<Optional<Value>> readValuePrefix( KeyRef key, int maxLength, Optional<UID> debugID = Optional<UID>() ) = 0;
 
+	// Reads each keys[i].first as readValuePrefix() would with maxLength keys[i].second, or as readValue() would if
+	// that is negative, and returns the values in the same order.  The reads may be served from different commits,
+	// as separate reads could be.  Stores that can look up several keys for less than the cost of a read each
+	// override this.
+	virtual Future<std::vector<Optional<Value>>> readValues(std::vector<std::pair<KeyRef, int>> const& keys,
+	                                                        Optional<UID> debugID = Optional<UID>()) {
+		std::vector<Future<Optional<Value>>> reads;
+		reads.reserve(keys.size());
+		for (const auto& [key, maxLength] : keys) {
+			reads.push_back(maxLength < 0 ? readValue(key, debugID) : readValuePrefix(key, maxLength, debugID));
+		}
+		return getAll(reads);
+	}
+
 	// If rowLimit>=0, reads first rows sorted ascending, otherwise reads last rows sorted descending
 	// The total size of the returned value (less the last entry) will be less than byteLimit
 	virtual Future<Standalone<RangeResultRef>> readRange( KeyRangeRef keys, int rowLimit = 1<<30, int byteLimit = 1<<30 ) = 0;
 
+	// Stores that can move by a number of keys without reading the keys in between say so here.  skipKeys(keys, n)
+	// returns the nth key of keys, counting forward from keys.begin if n > 0 or backward from keys.end if n < 0, or
+	// if keys has fewer than |n| keys, how many it has.  It must take less than reading |n| rows would.
+	virtual bool canSkipKeys() const { return false; }
+	virtual Future<SkippedKeys> skipKeys(KeyRangeRef keys, int64_t n) { return unsupported_operation(); }
+
 	// To debug MEMORY_RADIXTREE type ONLY
 	// Returns (1) how many key & value pairs have been inserted (2) how many nodes have been created (3) how many
 	// key size is less than 12 bytes
@@ -59,6 +114,9 @@ public:
 	// Returns the amount of free and total space for this store, in bytes
 	virtual StorageBytes getStorageBytes() const = 0;
 
+	// Returns how far the store's background work is behind its writes, for stores that can stall writes on it
+	virtual StorageEngineDebt getEngineDebt() const { return StorageEngineDebt(); }
+
 	virtual void resyncLog() {}
 
 	virtual void enableSnapshot() {}
@@ -0,0 +1,111 @@
+/*
+ * InternedKey.h
+ *
+ * This source file is part of the FoundationDB open source project
+ *
+ * Copyright 2013-2020 Apple Inc. and the FoundationDB project authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FDBSERVER_INTERNEDKEY_H
+#define FDBSERVER_INTERNEDKEY_H
+#pragma once
+
+#include "fdbclient/FDBTypes.h"
+
+// Compares the concatenations a1 + a2 and b1 + b2 without building either
+inline int compareConcatenated(StringRef a1, StringRef a2, StringRef b1, StringRef b2) {
+	if (!a1.size()) std::swap(a1, a2);
+	if (!b1.size()) std::swap(b1, b2);
+	while (a1.size() && b1.size()) {
+		int n = std::min(a1.size(), b1.size());
+		int c = memcmp(a1.begin(), b1.begin(), n);
+		if (c) return c;
+		a1 = a1.substr(n);
+		b1 = b1.substr(n);
+		if (!a1.size()) std::swap(a1, a2);
+		if (!b1.size()) std::swap(b1, b2);
+	}
+	return a1.size() ? 1 : b1.size() ? -1 : 0;
+}
+
+struct KeyPrefix : ReferenceCounted<KeyPrefix>, FastAllocated<KeyPrefix> {
+	Key bytes;
+	explicit KeyPrefix(StringRef bytes) : bytes(bytes) {}
+};
+
+// A key held as a prefix shared with other keys and a suffix of its own.  Sorted sets of sampled keys hold long runs of
+// keys that begin the same way (a directory, a table or an index), and interning stores such a prefix once instead of
+// once per key.  The suffix is a std::string so that the short suffixes these keys usually have need no allocation of
+// their own.  An InternedKey orders and compares exactly like the key it stands for.
+struct InternedKey {
+	Reference<KeyPrefix> prefix; // Null if nothing is shared
+	std::string suffix;
+
+	InternedKey() {}
+	InternedKey(StringRef key) : suffix((const char*)key.begin(), key.size()) {}
+	// prefix->bytes must be a prefix of key
+	InternedKey(Reference<KeyPrefix> const& prefix, StringRef key)
+	  : prefix(prefix), suffix((const char*)key.begin() + prefix->bytes.size(), key.size() - prefix->bytes.size()) {}
+
+	StringRef prefixBytes() const { return prefix ? StringRef(prefix->bytes) : StringRef(); }
+	StringRef suffixBytes() const { return StringRef((const uint8_t*)suffix.data(), suffix.size()); }
+	int size() const { return prefixBytes().size() + suffix.size(); }
+
+	Key toKey() const { return prefixBytes().withSuffix(suffixBytes()); }
+
+	// The length of the longest common prefix of this key and key
+	int commonPrefixLength(StringRef key) const {
+		StringRef p = prefixBytes();
+		int n = 0;
+		while (n < p.size() && n < key.size() && p[n] == key[n]) n++;
+		if (n < p.size()) return n;
+		StringRef s = suffixBytes();
+		int i = 0;
+		while (i < s.size() && n + i < key.size() && s[i] == key[n + i]) i++;
+		return n + i;
+	}
+
+	int compare(StringRef r) const { return compareConcatenated(prefixBytes(), suffixBytes(), r, StringRef()); }
+	int compare(InternedKey const& r) const {
+		// Neighbouring keys usually share their prefix, and then only the suffixes differ
+		if (prefix == r.prefix) return suffixBytes().compare(r.suffixBytes());
+		return compareConcatenated(prefixBytes(), suffixBytes(), r.prefixBytes(), r.suffixBytes());
+	}
+};
+
+inline bool operator==(InternedKey const& l, InternedKey const& r) {
+	return l.size() == r.size() && l.compare(r) == 0;
+}
+inline bool operator!=(InternedKey const& l, InternedKey const& r) { return !(l == r); }
+inline bool operator<(InternedKey const& l, InternedKey const& r) { return l.compare(r) < 0; }
+inline bool operator>(InternedKey const& l, InternedKey const& r) { return l.compare(r) > 0; }
+inline bool operator<=(InternedKey const& l, InternedKey const& r) { return l.compare(r) <= 0; }
+inline bool operator>=(InternedKey const& l, InternedKey const& r) { return l.compare(r) >= 0; }
+
+inline bool operator==(InternedKey const& l, StringRef r) { return l.size() == r.size() && l.compare(r) == 0; }
+inline bool operator!=(InternedKey const& l, StringRef r) { return !(l == r); }
+inline bool operator<(InternedKey const& l, StringRef r) { return l.compare(r) < 0; }
+inline bool operator>(InternedKey const& l, StringRef r) { return l.compare(r) > 0; }
+inline bool operator<=(InternedKey const& l, StringRef r) { return l.compare(r) <= 0; }
+inline bool operator>=(InternedKey const& l, StringRef r) { return l.compare(r) >= 0; }
+
+inline bool operator==(StringRef l, InternedKey const& r) { return r == l; }
+inline bool operator!=(StringRef l, InternedKey const& r) { return r != l; }
+inline bool operator<(StringRef l, InternedKey const& r) { return r > l; }
+inline bool operator>(StringRef l, InternedKey const& r) { return r < l; }
+inline bool operator<=(StringRef l, InternedKey const& r) { return r >= l; }
+inline bool operator>=(StringRef l, InternedKey const& r) { return r <= l; }
+
+#endif
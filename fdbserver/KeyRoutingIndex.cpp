@@ -0,0 +1,147 @@
+/*
+ * KeyRoutingIndex.cpp
+ *
+ * This source file is part of the FoundationDB open source project
+ *
+ * Copyright 2013-2020 Apple Inc. and the FoundationDB project authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <algorithm>
+
+#include "fdbserver/KeyRoutingIndex.h"
+#include "flow/UnitTest.h"
+
+// Big endian and zero padded, so that a key whose prefix is less than another's is itself less
+uint64_t KeyRoutingIndex::prefixOf(KeyRef key) {
+	uint64_t prefix = 0;
+	int n = std::min(key.size(), 8);
+	for (int i = 0; i < n; i++) {
+		prefix |= (uint64_t)key[i] << (56 - 8 * i);
+	}
+	return prefix;
+}
+
+void KeyRoutingIndex::rebuild() {
+	prefixes.clear();
+	entries.clear();
+	prefixes.reserve(keyInfo->size());
+	entries.reserve(keyInfo->size());
+	for (auto r : keyInfo->ranges()) {
+		prefixes.push_back(prefixOf(r.begin()));
+		entries.push_back(Entry{ r.begin(), &r.value() });
+	}
+	stale = false;
+}
+
+void KeyRoutingIndex::update(KeyRangeRef changed) {
+	if (stale) return;
+
+	int lo = findFirst(changed.begin, false);
+	int hi = findFirst(changed.end, true);
+
+	std::vector<Entry> replacement;
+	auto r = keyInfo->rangeContaining(changed.begin);
+	if (r.begin() < changed.begin) ++r;
+	for (auto end = keyInfo->ranges().end(); r != end && r.begin() <= changed.end; ++r) {
+		replacement.push_back(Entry{ r.begin(), &r.value() });
+	}
+
+	int n = replacement.size();
+	if (n > hi - lo) {
+		prefixes.insert(prefixes.begin() + hi, n - (hi - lo), 0);
+		entries.insert(entries.begin() + hi, n - (hi - lo), Entry());
+	} else {
+		prefixes.erase(prefixes.begin() + lo + n, prefixes.begin() + hi);
+		entries.erase(entries.begin() + lo + n, entries.begin() + hi);
+	}
+	for (int i = 0; i < n; i++) {
+		prefixes[lo + i] = prefixOf(replacement[i].begin);
+		entries[lo + i] = replacement[i];
+	}
+}
+
+int KeyRoutingIndex::size() {
+	ensureBuilt();
+	return entries.size();
+}
+
+int KeyRoutingIndex::indexOf(KeyRef key) {
+	ensureBuilt();
+	// The first boundary is always the empty key, so some boundary is <= key
+	return findFirst(key, true) - 1;
+}
+
+int KeyRoutingIndex::lowerBound(KeyRef key) {
+	ensureBuilt();
+	return findFirst(key, false);
+}
+
+// The index of the first boundary after key, or if after is false the first at or after key
+int KeyRoutingIndex::findFirst(KeyRef key, bool after) const {
+	// Boundaries with a smaller prefix are less than key and those with a larger one are greater, so only those with
+	// the same prefix need to be compared in full
+	uint64_t prefix = prefixOf(key);
+	auto samePrefix = std::equal_range(prefixes.begin(), prefixes.end(), prefix);
+	auto first = entries.begin() + (samePrefix.first - prefixes.begin());
+	auto last = entries.begin() + (samePrefix.second - prefixes.begin());
+	auto it = after ? std::upper_bound(first, last, key, [](KeyRef k, Entry const& e) { return k < e.begin; })
+	                : std::lower_bound(first, last, key, [](Entry const& e, KeyRef k) { return e.begin < k; });
+	return it - entries.begin();
+}
+
+namespace {
+
+Key randomRoutingKey() {
+	static const char* prefixes[] = { "", "a", "\x01\x02\x15tenant", "\x01\x02\x15tenant\x01\x02" };
+	std::string k = prefixes[deterministicRandom()->randomInt(0, 4)];
+	int n = deterministicRandom()->randomInt(0, 4);
+	for (int i = 0; i < n; i++) k += "\x00\x01za\xfe"[deterministicRandom()->randomInt(0, 5)];
+	return Key(k);
+}
+
+} // namespace
+
+TEST_CASE("/fdbserver/KeyRoutingIndex/MatchesMap") {
+	KeyRangeMap<ServerCacheInfo> keyInfo;
+	KeyRoutingIndex index(&keyInfo);
+
+	for (int step = 0; step < 2000; step++) {
+		Key b = randomRoutingKey(), e = randomRoutingKey();
+		if (e < b) std::swap(b, e);
+		if (deterministicRandom()->coinflip()) {
+			e = keyInfo.rangeContaining(b).end();
+		}
+		ServerCacheInfo info;
+		info.tags.push_back(Tag(0, step));
+		keyInfo.insert(KeyRangeRef(b, e), info);
+		if (deterministicRandom()->random01() < 0.05) {
+			index.invalidate();
+		} else {
+			index.update(KeyRangeRef(b, e));
+		}
+
+		ASSERT(index.size() == keyInfo.size());
+		for (int i = 0; i < 5; i++) {
+			Key k = randomRoutingKey();
+			auto r = keyInfo.rangeContaining(k);
+			int j = index.indexOf(k);
+			ASSERT(index.begin(j) == r.begin() && &index.info(j) == &r.value());
+			int lb = index.lowerBound(k);
+			ASSERT(lb == (r.begin() == k ? j : j + 1));
+		}
+	}
+
+	return Void();
+}
@@ -0,0 +1,74 @@
+/*
+ * KeyRoutingIndex.h
+ *
+ * This source file is part of the FoundationDB open source project
+ *
+ * Copyright 2013-2020 Apple Inc. and the FoundationDB project authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FDBSERVER_KEYROUTINGINDEX_H
+#define FDBSERVER_KEYROUTINGINDEX_H
+#pragma once
+
+#include <vector>
+
+#include "fdbclient/KeyRangeMap.h"
+#include "fdbclient/StorageServerInterface.h"
+
+// A sorted array of the shard boundaries in a commit proxy's keyInfo map, each pointing at the ServerCacheInfo of the
+// shard it begins, so that routing a mutation is a binary search over contiguous memory rather than a walk down the
+// map's tree.  The search runs over the first eight bytes of each boundary, kept in an array of their own, and only
+// compares whole keys among boundaries that share those bytes.
+//
+// keyInfo remains the source of truth.  Whoever changes its shape must report the keys affected to update(), or call
+// invalidate() to have the index rebuilt the next time it is used.  Changes to values in place need not be reported.
+class KeyRoutingIndex : NonCopyable {
+public:
+	explicit KeyRoutingIndex(KeyRangeMap<ServerCacheInfo>* keyInfo) : keyInfo(keyInfo), stale(true) {}
+
+	// The shard boundaries in [changed.begin, changed.end] (inclusive of end) may have been added, removed or replaced
+	void update(KeyRangeRef changed);
+	void invalidate() { stale = true; }
+
+	// The number of shards, and the index of the one containing key
+	int size();
+	int indexOf(KeyRef key);
+	// The index of the first shard beginning at or after key, or size() if there is none
+	int lowerBound(KeyRef key);
+
+	KeyRef begin(int i) const { return entries[i].begin; }
+	ServerCacheInfo& info(int i) const { return *entries[i].info; }
+	ServerCacheInfo& operator[](KeyRef key) { return info(indexOf(key)); }
+
+private:
+	struct Entry {
+		KeyRef begin; // Points into keyInfo's copy of the key
+		ServerCacheInfo* info;
+	};
+
+	static uint64_t prefixOf(KeyRef key);
+	void rebuild();
+	void ensureBuilt() {
+		if (stale) rebuild();
+	}
+	int findFirst(KeyRef key, bool after) const;
+
+	KeyRangeMap<ServerCacheInfo>* keyInfo;
+	std::vector<uint64_t> prefixes; // prefixes[i] == prefixOf(entries[i].begin)
+	std::vector<Entry> entries;
+	bool stale;
+};
+
+#endif
@@ -0,0 +1,294 @@
+/*
+ * KeyValueStoreBenchmark.actor.cpp
+ *
+ * This source file is part of the FoundationDB open source project
+ *
+ * Copyright 2013-2020 Apple Inc. and the FoundationDB project authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// End-to-end microbenchmarks of the storage engines through IKeyValueStore. The engines are only linked into
+// fdbserver, so these are unit tests rather than flowbench benchmarks; run them on the real network with
+//   fdbserver -r unittests -f tests/KVStoreBenchmark.txt
+// Each engine runs the same phases against a fresh store in the working directory.  RangeScan and ReverseRangeScan
+// read the same number of rows in opposite directions, so their rates can be compared directly.
+
+#include <cinttypes>
+#include "flow/flow.h"
+#include "flow/Histogram.h"
+#include "flow/UnitTest.h"
+#include "fdbrpc/IAsyncFile.h"
+#include "fdbserver/IKeyValueStore.h"
+#include "flow/actorcompiler.h" // This must be the last #include.
+
+namespace {
+
+struct KVBenchmarkConfig {
+	int recordCount = 1e6;
+	int keySize = 16;
+	int valueSize = 100;
+	int commitBytes = 5e6;
+	int pointReads = 1e5;
+	int rangeScans = 1e4;
+	int rangeScanRows = 100;
+	int randomWrites = 1e5;
+	int clearRanges = 1e3;
+	int clearRangeRecords = 100;
+	std::vector<int> commitBatchSizes = { 1, 10, 100, 1000 };
+	int commitsPerBatchSize = 100;
+};
+
+// Keys are fixed width so that key i sorts as index i and any index range maps to a key range
+Key benchmarkKey(KVBenchmarkConfig const& config, int64_t index) {
+	Key key = makeString(config.keySize);
+	uint8_t* s = mutateString(key);
+	memset(s, '0', config.keySize);
+	for (int i = config.keySize - 1; i >= 0 && index; --i, index /= 10) {
+		s[i] = '0' + index % 10;
+	}
+	return key;
+}
+
+void reportPhase(KeyValueStoreType type, const char* phase, int64_t ops, int64_t bytes, double elapsed,
+                 LogLinearHistogram const& latency) {
+	printf("%-26s %-22s %10" PRId64 " ops %8.2f s %12.1f ops/s %8.2f MB/s  latency p50 %.6f p99 %.6f max %.6f\n",
+	       type.toString().c_str(), phase, ops, elapsed, ops / elapsed, bytes / elapsed / 1e6, latency.median(),
+	       latency.percentile(0.99), latency.max());
+	TraceEvent("KVStoreBenchmark")
+	    .detail("StoreType", type)
+	    .detail("Phase", phase)
+	    .detail("Operations", ops)
+	    .detail("Bytes", bytes)
+	    .detail("Elapsed", elapsed)
+	    .detail("Rate", ops / elapsed)
+	    .detail("LatencyP50", latency.median())
+	    .detail("LatencyP99", latency.percentile(0.99))
+	    .detail("LatencyMax", latency.max())
+	    .detail("Histogram", latency.toString());
+}
+
+ACTOR Future<Void> benchSequentialInsert(IKeyValueStore* kvs, KVBenchmarkConfig* config) {
+	state LogLinearHistogram latency;
+	state std::string value = deterministicRandom()->randomAlphaNumeric(config->valueSize);
+	state int64_t bytes = 0;
+	state int batchBytes = 0;
+	state double start = timer();
+	state int i = 0;
+	for (; i < config->recordCount; ++i) {
+		Key key = benchmarkKey(*config, i);
+		kvs->set(KeyValueRef(key, value));
+		batchBytes += key.size() + value.size();
+		if (batchBytes >= config->commitBytes || i == config->recordCount - 1) {
+			state double commitStart = timer();
+			wait(kvs->commit());
+			latency.addSample(timer() - commitStart);
+			bytes += batchBytes;
+			batchBytes = 0;
+		}
+	}
+	reportPhase(kvs->getType(), "SequentialInsert", config->recordCount, bytes, timer() - start, latency);
+	return Void();
+}
+
+ACTOR Future<Void> benchPointRead(IKeyValueStore* kvs, KVBenchmarkConfig* config) {
+	state LogLinearHistogram latency;
+	state int64_t bytes = 0;
+	state double start = timer();
+	state int i = 0;
+	for (; i < config->pointReads; ++i) {
+		state double readStart = timer();
+		Optional<Value> v =
+		    wait(kvs->readValue(benchmarkKey(*config, deterministicRandom()->randomInt(0, config->recordCount))));
+		latency.addSample(timer() - readStart);
+		ASSERT(v.present());
+		bytes += v.get().size();
+	}
+	reportPhase(kvs->getType(), "PointRead", config->pointReads, bytes, timer() - start, latency);
+	return Void();
+}
+
+// A reverse scan reads the rows before a random key, as a query for the latest entries under a prefix does, so
+// comparing it to the forward scan shows what stepping backwards through each engine costs
+ACTOR Future<Void> benchRangeScan(IKeyValueStore* kvs, KVBenchmarkConfig* config, bool reverse) {
+	state LogLinearHistogram latency;
+	state int64_t bytes = 0;
+	state int64_t rows = 0;
+	state double start = timer();
+	state int i = 0;
+	for (; i < config->rangeScans; ++i) {
+		state double readStart = timer();
+		state Future<Standalone<RangeResultRef>> scan;
+		if (reverse) {
+			int end = deterministicRandom()->randomInt(std::min(config->rangeScanRows, config->recordCount),
+			                                           config->recordCount + 1);
+			scan = kvs->readRange(KeyRangeRef(LiteralStringRef(""), benchmarkKey(*config, end)),
+			                      -config->rangeScanRows);
+		} else {
+			int begin = deterministicRandom()->randomInt(0, std::max(1, config->recordCount - config->rangeScanRows));
+			scan = kvs->readRange(KeyRangeRef(benchmarkKey(*config, begin), LiteralStringRef("\xff")),
+			                      config->rangeScanRows);
+		}
+		Standalone<RangeResultRef> result = wait(scan);
+		latency.addSample(timer() - readStart);
+		rows += result.size();
+		bytes += result.expectedSize();
+	}
+	reportPhase(kvs->getType(), reverse ? "ReverseRangeScan" : "RangeScan", rows, bytes, timer() - start, latency);
+	return Void();
+}
+
+ACTOR Future<Void> benchRandomWrite(IKeyValueStore* kvs, KVBenchmarkConfig* config) {
+	state LogLinearHistogram latency;
+	state std::string value = deterministicRandom()->randomAlphaNumeric(config->valueSize);
+	state int64_t bytes = 0;
+	state int batchBytes = 0;
+	state double start = timer();
+	state int i = 0;
+	for (; i < config->randomWrites; ++i) {
+		Key key = benchmarkKey(*config, deterministicRandom()->randomInt(0, config->recordCount));
+		kvs->set(KeyValueRef(key, value));
+		batchBytes += key.size() + value.size();
+		if (batchBytes >= config->commitBytes || i == config->randomWrites - 1) {
+			state double commitStart = timer();
+			wait(kvs->commit());
+			latency.addSample(timer() - commitStart);
+			bytes += batchBytes;
+			batchBytes = 0;
+		}
+	}
+	reportPhase(kvs->getType(), "RandomWrite", config->randomWrites, bytes, timer() - start, latency);
+	return Void();
+}
+
+// Times a commit of each batch size, so that per-commit overhead can be told apart from per-mutation cost
+ACTOR Future<Void> benchCommitBatchSizes(IKeyValueStore* kvs, KVBenchmarkConfig* config) {
+	state std::string value = deterministicRandom()->randomAlphaNumeric(config->valueSize);
+	state int b = 0;
+	for (; b < config->commitBatchSizes.size(); ++b) {
+		state int batchSize = config->commitBatchSizes[b];
+		state LogLinearHistogram latency;
+		state double start = timer();
+		state int c = 0;
+		for (; c < config->commitsPerBatchSize; ++c) {
+			for (int i = 0; i < batchSize; ++i) {
+				kvs->set(KeyValueRef(benchmarkKey(*config, deterministicRandom()->randomInt(0, config->recordCount)),
+				                     value));
+			}
+			state double commitStart = timer();
+			wait(kvs->commit());
+			latency.addSample(timer() - commitStart);
+		}
+		int64_t mutations = (int64_t)batchSize * config->commitsPerBatchSize;
+		reportPhase(kvs->getType(), format("CommitBatch%d", batchSize).c_str(), mutations,
+		            mutations * (config->keySize + config->valueSize), timer() - start, latency);
+	}
+	return Void();
+}
+
+ACTOR Future<Void> benchClearRange(IKeyValueStore* kvs, KVBenchmarkConfig* config) {
+	state LogLinearHistogram latency;
+	state double start = timer();
+	state int i = 0;
+	for (; i < config->clearRanges; ++i) {
+		int begin = deterministicRandom()->randomInt(0, std::max(1, config->recordCount - config->clearRangeRecords));
+		kvs->clear(
+		    KeyRangeRef(benchmarkKey(*config, begin), benchmarkKey(*config, begin + config->clearRangeRecords)));
+		state double commitStart = timer();
+		wait(kvs->commit());
+		latency.addSample(timer() - commitStart);
+	}
+	reportPhase(kvs->getType(), "ClearRange", config->clearRanges,
+	            (int64_t)config->clearRanges * config->clearRangeRecords * (config->keySize + config->valueSize),
+	            timer() - start, latency);
+	return Void();
+}
+
+void deleteBenchmarkFiles(std::string const& filename) {
+	for (auto suffix : { "", "-wal", "0.fdq", "1.fdq" }) {
+		deleteFile(filename + suffix);
+	}
+}
+
+ACTOR Future<Void> benchmarkKVStore(KeyValueStoreType type, std::string filename) {
+	state KVBenchmarkConfig config;
+	if (type == KeyValueStoreType::SSD_ROCKSDB_V1) {
+		platform::eraseDirectoryRecursive(filename);
+	} else {
+		deleteBenchmarkFiles(filename);
+	}
+
+	state IKeyValueStore* kvs = openKVStore(type, filename, deterministicRandom()->randomUniqueID(), 2e9);
+	state Future<Void> error = kvs->getError();
+	wait(kvs->init());
+
+	printf("\nstoreType: %s  records: %d  keySize: %d  valueSize: %d\n", type.toString().c_str(), config.recordCount,
+	       config.keySize, config.valueSize);
+	choose {
+		when(wait(error)) {}
+		when(wait(benchSequentialInsert(kvs, &config))) {}
+	}
+	choose {
+		when(wait(error)) {}
+		when(wait(benchPointRead(kvs, &config))) {}
+	}
+	choose {
+		when(wait(error)) {}
+		when(wait(benchRangeScan(kvs, &config, false))) {}
+	}
+	choose {
+		when(wait(error)) {}
+		when(wait(benchRangeScan(kvs, &config, true))) {}
+	}
+	choose {
+		when(wait(error)) {}
+		when(wait(benchRandomWrite(kvs, &config))) {}
+	}
+	choose {
+		when(wait(error)) {}
+		when(wait(benchCommitBatchSizes(kvs, &config))) {}
+	}
+	choose {
+		when(wait(error)) {}
+		when(wait(benchClearRange(kvs, &config))) {}
+	}
+
+	Future<Void> closed = kvs->onClosed();
+	kvs->dispose();
+	wait(closed);
+	return Void();
+}
+
+} // namespace
+
+TEST_CASE("!/KeyValueStore/benchmark/memory") {
+	wait(benchmarkKVStore(KeyValueStoreType::MEMORY, "kvbench-memory"));
+	return Void();
+}
+
+TEST_CASE("!/KeyValueStore/benchmark/ssd-2") {
+	wait(benchmarkKVStore(KeyValueStoreType::SSD_BTREE_V2, "kvbench.sqlite"));
+	return Void();
+}
+
+TEST_CASE("!/KeyValueStore/benchmark/redwood") {
+	wait(benchmarkKVStore(KeyValueStoreType::SSD_REDWOOD_V1, "kvbench.redwood"));
+	return Void();
+}
+
+#ifdef SSD_ROCKSDB_EXPERIMENTAL
+TEST_CASE("!/KeyValueStore/benchmark/rocksdb") {
+	wait(benchmarkKVStore(KeyValueStoreType::SSD_ROCKSDB_V1, "kvbench.rocksdb"));
+	return Void();
+}
+#endif
@@ -253,6 +253,31 @@ public:
 		return result;
 	}
 
+	bool canSkipKeys() const override { return std::is_same<Container, IKeyValueContainer>::value; }
+
+	// The IndexedSet behind IKeyValueContainer counts the keys under each node, so this is O(log N) however far it
+	// skips
+	Future<SkippedKeys> skipKeys(KeyRangeRef keys, int64_t n) override {
+		if constexpr (!std::is_same<Container, IKeyValueContainer>::value) {
+			return IKeyValueStore::skipKeys(keys, n);
+		} else {
+			if (recovering.isError()) throw recovering.getError();
+			if (!recovering.isReady()) return waitAndSkipKeys(this, keys, n);
+
+			uint64_t begin = data.countTo(data.lower_bound(keys.begin));
+			uint64_t end = data.countTo(data.lower_bound(keys.end));
+			int64_t count = end > begin ? end - begin : 0;
+			int64_t distance = std::abs(n);
+			if (n == 0 || distance > count) {
+				return SkippedKeys(Optional<Key>(), std::min(distance, count));
+			}
+
+			auto it = data.index(n > 0 ? begin + n - 1 : end + n);
+			ASSERT(it != data.end());
+			return SkippedKeys(Key(it.getKey(reserved_buffer)), distance);
+		}
+	}
+
 	void resyncLog() override {
 		ASSERT(recovering.isReady());
 		resetSnapshot = true;
@@ -367,6 +392,9 @@ private:
 	int64_t memoryLimit; // The upper limit on the memory used by the store (excluding, possibly, some clear operations)
 	std::vector<std::pair<KeyValueMapPair, uint64_t>> dataSets;
 
+	// Only IKeyValueContainer implements the batch insert used for sequential commits
+	bool canInsertSequential() const { return type == KeyValueStoreType::MEMORY; }
+
 	int64_t commit_queue(OpQueue& ops, bool log, bool sequential = false) {
 		int64_t total = 0, count = 0;
 		IDiskQueue::location log_location = 0;
@@ -376,6 +404,11 @@ private:
 			total += o->p1.size() + o->p2.size() + OP_DISK_OVERHEAD;
 			if (o->op == OpSet) {
 				if (sequential) {
+					// Keys are only batched while they ascend, which is what the container's batch insert relies on
+					if (!dataSets.empty() && dataSets.back().first.key >= o->p1) {
+						data.insert(dataSets);
+						dataSets.clear();
+					}
 					KeyValueMapPair pair(o->p1, o->p2);
 					dataSets.push_back(std::make_pair(pair, pair.arena.getSize() + data.getElementBytes()));
 				} else {
@@ -446,6 +479,10 @@ private:
 			state OpQueue recoveryQueue;
 			state OpHeader h;
 			state Standalone<StringRef> lastSnapshotKey;
+			// Consecutive snapshot items, which ascend from snapshotRunBegin, are queued as one clear followed by
+			// their sets so that commit_queue can insert them as a batch
+			state Standalone<VectorRef<KeyValueRef>> snapshotRun;
+			state Key snapshotRunBegin;
 
 			TraceEvent("KVSMemRecoveryStarted", self->id)
 				.detail("SnapshotEndLocation", uncommittedSnapshotEnd);
@@ -488,6 +525,10 @@ private:
 						StringRef p1 = data.substr(0, h.len1);
 						StringRef p2 = data.substr(h.len1, h.len2);
 
+						if (h.op != OpSnapshotItem && h.op != OpSnapshotItemDelta) {
+							queueSnapshotRun(recoveryQueue, snapshotRunBegin, snapshotRun);
+						}
+
 						if (h.op == OpSnapshotItem || h.op == OpSnapshotItemDelta) { // snapshot data item
 							/*if (p1 < uncommittedNextKey) {
 								TraceEvent(SevError, "RecSnapshotBack", self->id)
@@ -511,9 +552,19 @@ private:
 								// Copy the suffix into the new reconstituted key
 								memcpy(mutateString(p1) + borrowed, suffix.begin(), suffix.size());
 							}
-							if( p1 >= uncommittedNextKey )
-								recoveryQueue.clear( KeyRangeRef(uncommittedNextKey, p1), &uncommittedNextKey.arena() ); //FIXME: Not sure what this line is for, is it necessary?
-							recoveryQueue.set( KeyValueRef(p1, p2), &data.arena() );
+							if( p1 >= uncommittedNextKey ) {
+								// Clearing from uncommittedNextKey up to p1 removes keys that were cleared between
+								// snapshots; across the run this is the single clear queued by queueSnapshotRun()
+								if (snapshotRun.empty()) {
+									snapshotRunBegin = uncommittedNextKey;
+									snapshotRun.arena().dependsOn(snapshotRunBegin.arena());
+								}
+								snapshotRun.arena().dependsOn(data.arena());
+								snapshotRun.push_back(snapshotRun.arena(), KeyValueRef(p1, p2));
+							} else {
+								queueSnapshotRun(recoveryQueue, snapshotRunBegin, snapshotRun);
+								recoveryQueue.set( KeyValueRef(p1, p2), &data.arena() );
+							}
 							uncommittedNextKey = keyAfter(p1);
 							++dbgSnapshotItemCount;
 							lastSnapshotKey = Key(p1, data.arena());
@@ -541,7 +592,7 @@ private:
 						} else if (h.op == OpClearToEnd) { //clear all data from begin key to end
 							recoveryQueue.clear_to_end( p1, &data.arena() );
 						} else if (h.op == OpCommit) { // commit previous transaction
-							self->commit_queue(recoveryQueue, false);
+							self->commit_queue(recoveryQueue, false, self->canInsertSequential());
 							++dbgCommitCount;
 							self->recoveredSnapshotKey = uncommittedNextKey;
 							self->previousSnapshotEnd = uncommittedPrevSnapshotEnd;
@@ -614,6 +665,19 @@ private:
 		}
 	}
 
+	// Queues a run of ascending snapshot items as they would have been queued one at a time, i.e. clearing everything
+	// from begin up to just past the last item, then setting each item
+	static void queueSnapshotRun(OpQueue& queue, KeyRef begin, Standalone<VectorRef<KeyValueRef>>& run) {
+		if (run.empty()) return;
+		TEST(run.size() > 1); // KeyValueStoreMemory recovered a run of snapshot items
+		KeyRef end = keyAfter(run.back().key, run.arena());
+		queue.clear(KeyRangeRef(begin, end), &run.arena());
+		for (auto& kv : run) {
+			queue.set(kv, &run.arena());
+		}
+		run = Standalone<VectorRef<KeyValueRef>>();
+	}
+
 	// Snapshots an entire data set
 	void fullSnapshot(Container& snapshotData) {
 		previousSnapshotEnd = log_op(OpSnapshotAbort, StringRef(), StringRef());
@@ -806,6 +870,10 @@ private:
 		wait( self->recovering );
 		return self->readRange(keys, rowLimit, byteLimit).get();
 	}
+	ACTOR static Future<SkippedKeys> waitAndSkipKeys(KeyValueStoreMemory* self, KeyRange keys, int64_t n) {
+		wait( self->recovering );
+		return self->skipKeys(keys, n).get();
+	}
 	ACTOR static Future<Void> waitAndCommit(KeyValueStoreMemory* self, bool sequential) {
 		wait(self->recovering);
 		wait(self->commit(sequential));
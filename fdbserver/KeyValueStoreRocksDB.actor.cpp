@@ -2,6 +2,8 @@
 
 #include <rocksdb/db.h>
 #include <rocksdb/options.h>
+#include <rocksdb/rate_limiter.h>
+#include <rocksdb/sst_file_writer.h>
 #include <rocksdb/utilities/table_properties_collectors.h>
 #include "flow/flow.h"
 #include "flow/IThreadPool.h"
@@ -42,9 +44,27 @@ rocksdb::Options getOptions() {
 	if (SERVER_KNOBS->ROCKSDB_BACKGROUND_PARALLELISM > 0) {
 		options.IncreaseParallelism(SERVER_KNOBS->ROCKSDB_BACKGROUND_PARALLELISM);
 	}
+	if (SERVER_KNOBS->ROCKSDB_BACKGROUND_BYTES_PER_SECOND > 0) {
+		// Flushes and compactions share this cap, within which RocksDB tunes their rate to the work pending
+		options.rate_limiter.reset(rocksdb::NewGenericRateLimiter(SERVER_KNOBS->ROCKSDB_BACKGROUND_BYTES_PER_SECOND,
+		                                                          100 * 1000, 10, rocksdb::RateLimiter::Mode::kWritesOnly,
+		                                                          true));
+	}
 	return options;
 }
 
+// A shard's range can be kept in a column family of its own, so that clearing the whole shard drops the column family
+// instead of leaving a range tombstone for reads to skip until compaction.  The shard map column family maps the name
+// of each such column family to its range, and is written in the same batches as the data so that the two agree after
+// a crash; a column family missing from it is dropped when the store is opened.
+struct ShardColumnFamily {
+	KeyRange range;
+	std::string name;
+	rocksdb::ColumnFamilyHandle* cf;
+};
+using ShardMap = std::map<Key, ShardColumnFamily, std::less<>>; // by range.begin
+const std::string shardMapName = "fdbShardMap";
+
 struct RocksDBKeyValueStore : IKeyValueStore {
 	using DB = rocksdb::DB*;
 	using CF = rocksdb::ColumnFamilyHandle*;
@@ -52,6 +72,8 @@ struct RocksDBKeyValueStore : IKeyValueStore {
 	struct Writer : IThreadPoolReceiver {
 		DB& db;
 		UID id;
+		std::map<uint32_t, CF> handles; // Open column families by id
+		std::vector<CF> droppedHandles; // Kept until close, since readers may still be using them
 
 		explicit Writer(DB& db, UID id) : db(db), id(id) {}
 
@@ -73,15 +95,33 @@ struct RocksDBKeyValueStore : IKeyValueStore {
 
 		struct OpenAction : TypedAction<Writer, OpenAction> {
 			std::string path;
+			ShardMap* shards;
+			CF* shardMap;
 			ThreadReturnPromise<Void> done;
 
 			double getTimeEstimate() const override { return SERVER_KNOBS->COMMIT_TIME_ESTIMATE; }
 		};
 		void action(OpenAction& a) {
-			std::vector<rocksdb::ColumnFamilyDescriptor> defaultCF = { rocksdb::ColumnFamilyDescriptor{
-				"default", getCFOptions() } };
+			// Bulk load files left behind by a commit that never completed
+			for (const auto& f : platform::listFiles(a.path, ".sst")) {
+				if (StringRef(f).startsWith(LiteralStringRef("bulkload-"))) {
+					deleteFile(joinPath(a.path, f));
+				}
+			}
+			std::vector<std::string> names;
+			if (!rocksdb::DB::ListColumnFamilies(getOptions(), a.path, &names).ok()) {
+				// A new database
+				names = { rocksdb::kDefaultColumnFamilyName };
+			}
+			std::vector<rocksdb::ColumnFamilyDescriptor> descriptors;
+			for (const auto& name : names) {
+				descriptors.push_back(rocksdb::ColumnFamilyDescriptor{ name, getCFOptions() });
+			}
 			std::vector<rocksdb::ColumnFamilyHandle*> handle;
-			auto status = rocksdb::DB::Open(getOptions(), a.path, defaultCF, &handle, &db);
+			auto status = rocksdb::DB::Open(getOptions(), a.path, descriptors, &handle, &db);
+			if (status.ok()) {
+				status = loadShards(a, names, handle);
+			}
 			if (!status.ok()) {
 				TraceEvent(SevError, "RocksDBError").detail("Error", status.ToString()).detail("Method", "Open");
 				a.done.sendError(statusToError(status));
@@ -91,43 +131,171 @@ struct RocksDBKeyValueStore : IKeyValueStore {
 			}
 		}
 
+		// Fills in the shard column families from the shard map, creating the map if there is none yet
+		rocksdb::Status loadShards(OpenAction& a, const std::vector<std::string>& names, const std::vector<CF>& handle) {
+			std::map<std::string, CF> unmapped;
+			for (int i = 0; i < names.size(); ++i) {
+				handles[handle[i]->GetID()] = handle[i];
+				if (names[i] == shardMapName) {
+					*a.shardMap = handle[i];
+				} else if (names[i] != rocksdb::kDefaultColumnFamilyName) {
+					unmapped[names[i]] = handle[i];
+				}
+			}
+			if (*a.shardMap == nullptr && SERVER_KNOBS->ROCKSDB_SHARD_COLUMN_FAMILIES) {
+				auto s = db->CreateColumnFamily(getCFOptions(), shardMapName, a.shardMap);
+				if (!s.ok()) {
+					return s;
+				}
+				handles[(*a.shardMap)->GetID()] = *a.shardMap;
+			}
+			if (*a.shardMap != nullptr) {
+				std::unique_ptr<rocksdb::Iterator> cursor(db->NewIterator({}, *a.shardMap));
+				for (cursor->SeekToFirst(); cursor->Valid(); cursor->Next()) {
+					std::string name = cursor->key().ToString();
+					auto found = unmapped.find(name);
+					if (found == unmapped.end()) {
+						return rocksdb::Status::Corruption("Missing shard column family", name);
+					}
+					KeyRange range = BinaryReader::fromStringRef<KeyRange>(toStringRef(cursor->value()), IncludeVersion());
+					(*a.shards)[range.begin] = ShardColumnFamily{ range, name, found->second };
+					unmapped.erase(found);
+				}
+				if (!cursor->status().ok()) {
+					return cursor->status();
+				}
+			}
+			// Created for a shard whose commit never happened, or cleared by a commit that was not followed by the drop
+			for (const auto& [name, cf] : unmapped) {
+				auto s = db->DropColumnFamily(cf);
+				if (!s.ok()) {
+					return s;
+				}
+				handles.erase(cf->GetID());
+				db->DestroyColumnFamilyHandle(cf);
+			}
+			return rocksdb::Status::OK();
+		}
+
+		struct AddShardAction : TypedAction<Writer, AddShardAction> {
+			std::string name;
+			ThreadReturnPromise<CF> result;
+			explicit AddShardAction(std::string name) : name(name) {}
+			double getTimeEstimate() const override { return SERVER_KNOBS->COMMIT_TIME_ESTIMATE; }
+		};
+		void action(AddShardAction& a) {
+			CF cf = nullptr;
+			auto s = db->CreateColumnFamily(getCFOptions(), a.name, &cf);
+			if (!s.ok()) {
+				TraceEvent(SevError, "RocksDBError").detail("Error", s.ToString()).detail("Method", "AddShard");
+				a.result.sendError(statusToError(s));
+				return;
+			}
+			handles[cf->GetID()] = cf;
+			a.result.send(cf);
+		}
+
 		struct DeleteVisitor : public rocksdb::WriteBatch::Handler {
-			VectorRef<KeyRangeRef>& deletes;
+			std::vector<std::pair<uint32_t, KeyRangeRef>>& deletes;
 			Arena& arena;
 
-			DeleteVisitor(VectorRef<KeyRangeRef>& deletes, Arena& arena) : deletes(deletes), arena(arena) {}
+			DeleteVisitor(std::vector<std::pair<uint32_t, KeyRangeRef>>& deletes, Arena& arena)
+			  : deletes(deletes), arena(arena) {}
 
-			rocksdb::Status DeleteRangeCF(uint32_t /*column_family_id*/, const rocksdb::Slice& begin,
+			rocksdb::Status DeleteRangeCF(uint32_t column_family_id, const rocksdb::Slice& begin,
 			                              const rocksdb::Slice& end) override {
 				KeyRangeRef kr(toStringRef(begin), toStringRef(end));
-				deletes.push_back_deep(arena, kr);
+				deletes.emplace_back(column_family_id, KeyRangeRef(arena, kr));
 				return rocksdb::Status::OK();
 			}
 		};
 
+		// Writes a bulk loaded block to an sst file, to be ingested by the commit that follows it
+		struct BuildFileAction : TypedAction<Writer, BuildFileAction> {
+			std::string file;
+			Standalone<VectorRef<KeyValueRef>> data;
+			BuildFileAction(std::string file, Standalone<VectorRef<KeyValueRef>> data) : file(file), data(data) {}
+			double getTimeEstimate() const override { return SERVER_KNOBS->COMMIT_TIME_ESTIMATE; }
+		};
+		void action(BuildFileAction& a) {
+			rocksdb::SstFileWriter writer(rocksdb::EnvOptions(), getOptions());
+			auto s = writer.Open(a.file);
+			for (int i = 0; s.ok() && i < a.data.size(); ++i) {
+				s = writer.Put(toSlice(a.data[i].key), toSlice(a.data[i].value));
+			}
+			if (s.ok()) {
+				s = writer.Finish();
+			}
+			if (!s.ok()) {
+				// The commit fails when it finds the file missing
+				TraceEvent(SevError, "RocksDBError").detail("Error", s.ToString()).detail("Method", "BuildFile");
+				deleteFile(a.file);
+			}
+		}
+
+		// A commit is applied as a sequence of write batches and, between them, bulk loaded files, in the order the
+		// writes were made.  Only bulk loading splits a commit, so it is otherwise written atomically.
+		struct CommitStep {
+			std::unique_ptr<rocksdb::WriteBatch> batch;
+			std::string file; // if batch is null, to be ingested into cf
+			CF cf;
+		};
+
 		struct CommitAction : TypedAction<Writer, CommitAction> {
-			std::unique_ptr<rocksdb::WriteBatch> batchToCommit;
+			std::vector<CommitStep> steps;
+			std::vector<CF> dropped; // Shard column families cleared by this commit, dropped once it is written
 			ThreadReturnPromise<Void> done;
 			double getTimeEstimate() const override { return SERVER_KNOBS->COMMIT_TIME_ESTIMATE; }
 		};
 		void action(CommitAction& a) {
-			Standalone<VectorRef<KeyRangeRef>> deletes;
-			DeleteVisitor dv(deletes, deletes.arena());
-			ASSERT(a.batchToCommit->Iterate(&dv).ok());
-			// If there are any range deletes, we should have added them to be deleted.
-			ASSERT(!deletes.empty() || !a.batchToCommit->HasDeleteRange());
+			Arena arena;
+			std::vector<std::pair<uint32_t, KeyRangeRef>> deletes;
+			DeleteVisitor dv(deletes, arena);
 			rocksdb::WriteOptions options;
 			options.sync = !SERVER_KNOBS->ROCKSDB_UNSAFE_AUTO_FSYNC;
-			auto s = db->Write(options, a.batchToCommit.get());
+			rocksdb::IngestExternalFileOptions ingestOptions;
+			ingestOptions.move_files = true;
+			rocksdb::Status s;
+			const char* method = "Commit";
+			for (int i = 0; s.ok() && i < a.steps.size(); ++i) {
+				auto& step = a.steps[i];
+				if (step.batch) {
+					int deletesBefore = deletes.size();
+					ASSERT(step.batch->Iterate(&dv).ok());
+					// If there are any range deletes, we should have added them to be deleted.
+					ASSERT(deletes.size() > deletesBefore || !step.batch->HasDeleteRange());
+					s = db->Write(options, step.batch.get());
+				} else {
+					// A successful ingestion moves the file into the database
+					s = db->IngestExternalFile(step.cf, { step.file }, ingestOptions);
+					if (!s.ok()) {
+						method = "IngestFile";
+						deleteFile(step.file);
+					}
+				}
+			}
 			if (!s.ok()) {
-				TraceEvent(SevError, "RocksDBError").detail("Error", s.ToString()).detail("Method", "Commit");
+				TraceEvent(SevError, "RocksDBError").detail("Error", s.ToString()).detail("Method", method);
 				a.done.sendError(statusToError(s));
 			} else {
 				a.done.send(Void());
-				for (const auto& keyRange : deletes) {
+				for (CF cf : a.dropped) {
+					// If this fails the store drops it when next opened, since it is no longer in the shard map
+					auto ds = db->DropColumnFamily(cf);
+					if (!ds.ok()) {
+						TraceEvent(SevWarn, "RocksDBError").detail("Error", ds.ToString()).detail("Method", "DropShard");
+					}
+					handles.erase(cf->GetID());
+					droppedHandles.push_back(cf);
+				}
+				for (const auto& [cfID, keyRange] : deletes) {
+					auto cf = handles.find(cfID);
+					if (cf == handles.end()) {
+						continue;
+					}
 					auto begin = toSlice(keyRange.begin);
 					auto end = toSlice(keyRange.end);
-					ASSERT(db->SuggestCompactRange(db->DefaultColumnFamily(), &begin, &end).ok());
+					ASSERT(db->SuggestCompactRange(cf->second, &begin, &end).ok());
 				}
 			}
 		}
@@ -144,6 +312,14 @@ struct RocksDBKeyValueStore : IKeyValueStore {
 				a.done.send(Void());
 				return;
 			}
+			for (const auto& [_, cf] : handles) {
+				db->DestroyColumnFamilyHandle(cf);
+			}
+			for (CF cf : droppedHandles) {
+				db->DestroyColumnFamilyHandle(cf);
+			}
+			handles.clear();
+			droppedHandles.clear();
 			auto s = db->Close();
 			if (!s.ok()) {
 				TraceEvent(SevError, "RocksDBError").detail("Error", s.ToString()).detail("Method", "Close");
@@ -166,18 +342,65 @@ struct RocksDBKeyValueStore : IKeyValueStore {
 	struct Reader : IThreadPoolReceiver {
 		DB& db;
 
+		// Iterators are kept for reuse by later range reads on this thread, refreshed to the latest data each time,
+		// which is cheaper than creating a new one.  The bounds they were created with point to these slices, so
+		// moving a bound only needs the slice to be changed.  Only the default column family's are kept, since a
+		// shard's column family can be dropped.
+		rocksdb::Slice forwardUpperBound;
+		rocksdb::Slice reverseLowerBound;
+		rocksdb::Slice shardBound;
+		std::unique_ptr<rocksdb::Iterator> forwardIterator;
+		std::unique_ptr<rocksdb::Iterator> reverseIterator;
+		std::unique_ptr<rocksdb::Iterator> shardIterator;
+
 		explicit Reader(DB& db) : db(db) {}
 
 		void init() override {}
 
+		static rocksdb::ReadOptions getScanOptions() {
+			rocksdb::ReadOptions options;
+			if (SERVER_KNOBS->ROCKSDB_READ_RANGE_READAHEAD_BYTES > 0) {
+				options.readahead_size = SERVER_KNOBS->ROCKSDB_READ_RANGE_READAHEAD_BYTES;
+			}
+			return options;
+		}
+
+		// Returns an iterator over the latest data in cf, whose upper (forward) or lower (reverse) bound is bound.  It is
+		// valid until the next call.
+		rocksdb::Iterator* getIterator(CF cf, bool forward, StringRef bound) {
+			const bool isDefault = cf == db->DefaultColumnFamily();
+			rocksdb::Slice& boundSlice = !isDefault ? shardBound : forward ? forwardUpperBound : reverseLowerBound;
+			std::unique_ptr<rocksdb::Iterator>& iterator =
+			    !isDefault ? shardIterator : forward ? forwardIterator : reverseIterator;
+			boundSlice = toSlice(bound);
+			if (isDefault && iterator && iterator->Refresh().ok()) {
+				return iterator.get();
+			}
+			rocksdb::ReadOptions options = getScanOptions();
+			if (forward) {
+				options.iterate_upper_bound = &boundSlice;
+			} else {
+				options.iterate_lower_bound = &boundSlice;
+			}
+			iterator.reset(db->NewIterator(options, cf));
+			return iterator.get();
+		}
+
 		struct ReadValueAction : TypedAction<Reader, ReadValueAction> {
 			Key key;
+			CF cf;
+			int maxLength; // Only this many bytes of the value are returned, unless it is negative
 			Optional<UID> debugID;
 			ThreadReturnPromise<Optional<Value>> result;
-			ReadValueAction(KeyRef key, Optional<UID> debugID)
-				: key(key), debugID(debugID)
+			ReadValueAction(KeyRef key, CF cf, Optional<UID> debugID, int maxLength = -1)
+				: key(key), cf(cf), maxLength(maxLength), debugID(debugID)
 			{}
 			double getTimeEstimate() const override { return SERVER_KNOBS->READ_VALUE_TIME_ESTIMATE; }
+
+			Value toValue(const rocksdb::PinnableSlice& value) const {
+				StringRef v = toStringRef(value);
+				return Value(maxLength >= 0 && v.size() > maxLength ? v.substr(0, maxLength) : v);
+			}
 		};
 		void action(ReadValueAction& a) {
 			Optional<TraceBatch> traceBatch;
@@ -186,13 +409,13 @@ struct RocksDBKeyValueStore : IKeyValueStore {
 				traceBatch.get().addEvent("GetValueDebug", a.debugID.get().first(), "Reader.Before");
 			}
 			rocksdb::PinnableSlice value;
-			auto s = db->Get({}, db->DefaultColumnFamily(), toSlice(a.key), &value);
+			auto s = db->Get({}, a.cf, toSlice(a.key), &value);
 			if (a.debugID.present()) {
 				traceBatch.get().addEvent("GetValueDebug", a.debugID.get().first(), "Reader.After");
 				traceBatch.get().dump();
 			}
 			if (s.ok()) {
-				a.result.send(Value(toStringRef(value)));
+				a.result.send(a.toValue(value));
 			} else {
 				if (!s.IsNotFound()) {
 					TraceEvent(SevError, "RocksDBError").detail("Error", s.ToString()).detail("Method", "ReadValue");
@@ -201,12 +424,60 @@ struct RocksDBKeyValueStore : IKeyValueStore {
 			}
 		}
 
+		// Point reads that arrived together, served with one MultiGet
+		struct MultiReadValueAction : TypedAction<Reader, MultiReadValueAction> {
+			std::vector<std::unique_ptr<ReadValueAction>> reads;
+			double getTimeEstimate() const override { return SERVER_KNOBS->READ_VALUE_TIME_ESTIMATE * reads.size(); }
+		};
+		void action(MultiReadValueAction& a) {
+			const int n = a.reads.size();
+			Optional<TraceBatch> traceBatch;
+			std::vector<rocksdb::Slice> keys;
+			std::vector<CF> cfs;
+			keys.reserve(n);
+			cfs.reserve(n);
+			for (auto& r : a.reads) {
+				if (r->debugID.present()) {
+					if (!traceBatch.present()) {
+						traceBatch = { TraceBatch{} };
+					}
+					traceBatch.get().addEvent("GetValueDebug", r->debugID.get().first(), "Reader.Before");
+				}
+				keys.push_back(toSlice(r->key));
+				cfs.push_back(r->cf);
+			}
+			std::vector<rocksdb::PinnableSlice> values(n);
+			std::vector<rocksdb::Status> statuses(n);
+			db->MultiGet({}, n, cfs.data(), keys.data(), values.data(), statuses.data());
+
+			for (int i = 0; i < n; ++i) {
+				auto& r = a.reads[i];
+				if (r->debugID.present()) {
+					traceBatch.get().addEvent("GetValueDebug", r->debugID.get().first(), "Reader.After");
+				}
+				if (statuses[i].ok()) {
+					r->result.send(r->toValue(values[i]));
+				} else {
+					if (!statuses[i].IsNotFound()) {
+						TraceEvent(SevError, "RocksDBError")
+						    .detail("Error", statuses[i].ToString())
+						    .detail("Method", "MultiReadValue");
+					}
+					r->result.send(Optional<Value>());
+				}
+			}
+			if (traceBatch.present()) {
+				traceBatch.get().dump();
+			}
+		}
+
 		struct ReadValuePrefixAction : TypedAction<Reader, ReadValuePrefixAction> {
 			Key key;
+			CF cf;
 			int maxLength;
 			Optional<UID> debugID;
 			ThreadReturnPromise<Optional<Value>> result;
-			ReadValuePrefixAction(Key key, int maxLength, Optional<UID> debugID) : key(key), maxLength(maxLength), debugID(debugID) {};
+			ReadValuePrefixAction(Key key, CF cf, int maxLength, Optional<UID> debugID) : key(key), cf(cf), maxLength(maxLength), debugID(debugID) {};
 			double getTimeEstimate() const override { return SERVER_KNOBS->READ_VALUE_TIME_ESTIMATE; }
 		};
 		void action(ReadValuePrefixAction& a) {
@@ -217,7 +488,7 @@ struct RocksDBKeyValueStore : IKeyValueStore {
 				traceBatch.get().addEvent("GetValuePrefixDebug", a.debugID.get().first(),
 				                          "Reader.Before"); //.detail("TaskID", g_network->getCurrentTask());
 			}
-			auto s = db->Get({}, db->DefaultColumnFamily(), toSlice(a.key), &value);
+			auto s = db->Get({}, a.cf, toSlice(a.key), &value);
 			if (a.debugID.present()) {
 				traceBatch.get().addEvent("GetValuePrefixDebug", a.debugID.get().first(),
 				                          "Reader.After"); //.detail("TaskID", g_network->getCurrentTask());
@@ -233,56 +504,62 @@ struct RocksDBKeyValueStore : IKeyValueStore {
 		}
 
 		struct ReadRangeAction : TypedAction<Reader, ReadRangeAction>, FastAllocated<ReadRangeAction> {
-			KeyRange keys;
+			// The range to read, split into the pieces held by each column family, in key order
+			std::vector<std::pair<KeyRange, CF>> pieces;
 			int rowLimit, byteLimit;
 			ThreadReturnPromise<Standalone<RangeResultRef>> result;
-			ReadRangeAction(KeyRange keys, int rowLimit, int byteLimit) : keys(keys), rowLimit(rowLimit), byteLimit(byteLimit) {}
+			ReadRangeAction(std::vector<std::pair<KeyRange, CF>> pieces, int rowLimit, int byteLimit)
+			  : pieces(std::move(pieces)), rowLimit(rowLimit), byteLimit(byteLimit) {}
 			double getTimeEstimate() const override { return SERVER_KNOBS->READ_RANGE_TIME_ESTIMATE; }
 		};
 		void action(ReadRangeAction& a) {
 			Standalone<RangeResultRef> result;
 			if (a.rowLimit == 0 || a.byteLimit == 0) {
 				a.result.send(result);
+				return;
 			}
 			int accumulatedBytes = 0;
+			bool full = false;
 			rocksdb::Status s;
 			if (a.rowLimit >= 0) {
-				rocksdb::ReadOptions options;
-				auto endSlice = toSlice(a.keys.end);
-				options.iterate_upper_bound = &endSlice;
-				auto cursor = std::unique_ptr<rocksdb::Iterator>(db->NewIterator(options));
-				cursor->Seek(toSlice(a.keys.begin));
-				while (cursor->Valid() && toStringRef(cursor->key()) < a.keys.end) {
-					KeyValueRef kv(toStringRef(cursor->key()), toStringRef(cursor->value()));
-					accumulatedBytes += sizeof(KeyValueRef) + kv.expectedSize();
-					result.push_back_deep(result.arena(), kv);
-					// Calling `cursor->Next()` is potentially expensive, so short-circut here just in case.
-					if (result.size() >= a.rowLimit || accumulatedBytes >= a.byteLimit) {
-						break;
+				for (int p = 0; !full && s.ok() && p < a.pieces.size(); ++p) {
+					const KeyRange& keys = a.pieces[p].first;
+					rocksdb::Iterator* cursor = getIterator(a.pieces[p].second, true, keys.end);
+					cursor->Seek(toSlice(keys.begin));
+					while (cursor->Valid() && toStringRef(cursor->key()) < keys.end) {
+						KeyValueRef kv(toStringRef(cursor->key()), toStringRef(cursor->value()));
+						accumulatedBytes += sizeof(KeyValueRef) + kv.expectedSize();
+						result.push_back_deep(result.arena(), kv);
+						// Calling `cursor->Next()` is potentially expensive, so short-circut here just in case.
+						if (result.size() >= a.rowLimit || accumulatedBytes >= a.byteLimit) {
+							full = true;
+							break;
+						}
+						cursor->Next();
 					}
-					cursor->Next();
+					s = cursor->status();
 				}
-				s = cursor->status();
 			} else {
-				rocksdb::ReadOptions options;
-				auto beginSlice = toSlice(a.keys.begin);
-				options.iterate_lower_bound = &beginSlice;
-				auto cursor = std::unique_ptr<rocksdb::Iterator>(db->NewIterator(options));
-				cursor->SeekForPrev(toSlice(a.keys.end));
-				if (cursor->Valid() && toStringRef(cursor->key()) == a.keys.end) {
-					cursor->Prev();
-				}
-				while (cursor->Valid() && toStringRef(cursor->key()) >= a.keys.begin) {
-					KeyValueRef kv(toStringRef(cursor->key()), toStringRef(cursor->value()));
-					accumulatedBytes += sizeof(KeyValueRef) + kv.expectedSize();
-					result.push_back_deep(result.arena(), kv);
-					// Calling `cursor->Prev()` is potentially expensive, so short-circut here just in case.
-					if (result.size() >= -a.rowLimit || accumulatedBytes >= a.byteLimit) {
-						break;
+				for (int p = a.pieces.size() - 1; !full && s.ok() && p >= 0; --p) {
+					const KeyRange& keys = a.pieces[p].first;
+					rocksdb::Iterator* cursor = getIterator(a.pieces[p].second, false, keys.begin);
+					cursor->SeekForPrev(toSlice(keys.end));
+					if (cursor->Valid() && toStringRef(cursor->key()) == keys.end) {
+						cursor->Prev();
 					}
-					cursor->Prev();
+					while (cursor->Valid() && toStringRef(cursor->key()) >= keys.begin) {
+						KeyValueRef kv(toStringRef(cursor->key()), toStringRef(cursor->value()));
+						accumulatedBytes += sizeof(KeyValueRef) + kv.expectedSize();
+						result.push_back_deep(result.arena(), kv);
+						// Calling `cursor->Prev()` is potentially expensive, so short-circut here just in case.
+						if (result.size() >= -a.rowLimit || accumulatedBytes >= a.byteLimit) {
+							full = true;
+							break;
+						}
+						cursor->Prev();
+					}
+					s = cursor->status();
 				}
-				s = cursor->status();
 			}
 
 			if (!s.ok()) {
@@ -305,13 +582,32 @@ struct RocksDBKeyValueStore : IKeyValueStore {
 	Promise<Void> errorPromise;
 	Promise<Void> closePromise;
 	std::unique_ptr<rocksdb::WriteBatch> writeBatch;
+	// Writes made before the latest bulk load, in order, for the next commit
+	std::vector<Writer::CommitStep> pendingSteps;
+	int bulkLoadFiles = 0;
+	// Filled in by the writer when the database is opened
+	ShardMap shards;
+	CF shardMap = nullptr;
+	// Shard column families being created, which are dropped instead if any of their range is cleared first
+	struct PendingShard : ReferenceCounted<PendingShard> {
+		KeyRange range;
+		bool cleared = false;
+		Promise<Void> added;
+		explicit PendingShard(KeyRange range) : range(range) {}
+	};
+	std::vector<Reference<PendingShard>> pendingShards;
+	std::vector<CF> droppedShards; // for the next commit
+	// Point reads waiting for the end of the current tick to be sent to the readers together
+	std::vector<std::unique_ptr<Reader::ReadValueAction>> pendingReads;
+	Future<Void> pendingReadsSent;
 
 	explicit RocksDBKeyValueStore(const std::string& path, UID id)
 		: path(path)
 		, id(id)
 	{
 		writeThread = createGenericThreadPool();
-		readThreads = createGenericThreadPool();
+		readThreads =
+		    SERVER_KNOBS->ROCKSDB_READ_WORK_STEALING ? createWorkStealingThreadPool() : createGenericThreadPool();
 		writeThread->addThread(new Writer(db, id));
 		for (unsigned i = 0; i < SERVER_KNOBS->ROCKSDB_READ_PARALLELISM; ++i) {
 			readThreads->addThread(new Reader(db));
@@ -323,6 +619,8 @@ struct RocksDBKeyValueStore : IKeyValueStore {
 	}
 
 	ACTOR static void doClose(RocksDBKeyValueStore* self, bool deleteOnClose) {
+		self->pendingReadsSent.cancel();
+		self->pendingReads.clear();
 		wait(self->readThreads->stop());
 		auto a = new Writer::CloseAction(self->path, deleteOnClose);
 		auto f = a->done.getFuture();
@@ -351,54 +649,244 @@ struct RocksDBKeyValueStore : IKeyValueStore {
 	Future<Void> init() override {
 		std::unique_ptr<Writer::OpenAction> a(new Writer::OpenAction());
 		a->path = path;
+		a->shards = &shards;
+		a->shardMap = &shardMap;
 		auto res = a->done.getFuture();
 		writeThread->post(a.release());
 		return res;
 	}
 
-	void set(KeyValueRef kv, const Arena*) override {
+	rocksdb::WriteBatch* getWriteBatch() {
 		if (writeBatch == nullptr) {
 			writeBatch.reset(new rocksdb::WriteBatch());
 		}
-		writeBatch->Put(toSlice(kv.key), toSlice(kv.value));
+		return writeBatch.get();
+	}
+
+	// The shard column family holding key, or null if it is in the default one
+	ShardColumnFamily* shardFor(KeyRef key) {
+		auto it = shards.upper_bound(key);
+		if (it == shards.begin()) {
+			return nullptr;
+		}
+		--it;
+		return it->second.range.contains(key) ? &it->second : nullptr;
+	}
+
+	CF cfFor(KeyRef key) {
+		ShardColumnFamily* shard = shardFor(key);
+		return shard ? shard->cf : db->DefaultColumnFamily();
+	}
+
+	// The pieces of range in key order, each with the shard column family holding it, or null for the default one
+	std::vector<std::pair<KeyRange, ShardColumnFamily*>> split(KeyRangeRef range) {
+		std::vector<std::pair<KeyRange, ShardColumnFamily*>> pieces;
+		auto it = shards.upper_bound(range.begin);
+		if (it != shards.begin() && range.begin < std::prev(it)->second.range.end) {
+			--it;
+		}
+		KeyRef begin = range.begin;
+		while (begin < range.end) {
+			if (it == shards.end() || range.end <= it->second.range.begin) {
+				pieces.emplace_back(KeyRangeRef(begin, range.end), nullptr);
+				break;
+			}
+			ShardColumnFamily& shard = it->second;
+			if (begin < shard.range.begin) {
+				pieces.emplace_back(KeyRangeRef(begin, shard.range.begin), nullptr);
+				begin = shard.range.begin;
+			}
+			KeyRef end = shard.range.end < range.end ? shard.range.end : range.end;
+			pieces.emplace_back(KeyRangeRef(begin, end), &shard);
+			begin = end;
+			++it;
+		}
+		return pieces;
+	}
+
+	void set(KeyValueRef kv, const Arena*) override {
+		getWriteBatch()->Put(cfFor(kv.key), toSlice(kv.key), toSlice(kv.value));
 	}
 
 	void clear(KeyRangeRef keyRange, const Arena*) override {
-		if (writeBatch == nullptr) {
-			writeBatch.reset(new rocksdb::WriteBatch());
+		for (auto& pending : pendingShards) {
+			if (pending->range.intersects(keyRange)) {
+				pending->cleared = true;
+			}
+		}
+		rocksdb::WriteBatch* batch = getWriteBatch();
+		std::vector<Key> removed;
+		for (const auto& [range, shard] : split(keyRange)) {
+			if (shard == nullptr) {
+				batch->DeleteRange(db->DefaultColumnFamily(), toSlice(range.begin), toSlice(range.end));
+			} else if (range == shard->range) {
+				// Unmapped in the same batch as the rest of the commit, and dropped after it
+				batch->Delete(shardMap, shard->name);
+				droppedShards.push_back(shard->cf);
+				removed.push_back(shard->range.begin);
+			} else {
+				batch->DeleteRange(shard->cf, toSlice(range.begin), toSlice(range.end));
+			}
+		}
+		for (const auto& begin : removed) {
+			shards.erase(begin);
+		}
+	}
+
+	// Not cancelled along with the caller's wait, so that pendingShards is always cleaned up
+	ACTOR static void addShard(RocksDBKeyValueStore* self, Reference<PendingShard> pending) {
+		state std::string name = format("shard-%s", deterministicRandom()->randomUniqueID().toString().c_str());
+		auto a = new Writer::AddShardAction(name);
+		state Future<CF> created = a->result.getFuture();
+		self->writeThread->post(a);
+		try {
+			CF cf = wait(created);
+			self->pendingShards.erase(std::find(self->pendingShards.begin(), self->pendingShards.end(), pending));
+			if (pending->cleared) {
+				self->droppedShards.push_back(cf);
+			} else {
+				// Mapped in the same batch as the writes to it
+				self->shards[pending->range.begin] = ShardColumnFamily{ pending->range, name, cf };
+				self->getWriteBatch()->Put(self->shardMap, name,
+				                           toSlice(BinaryWriter::toValue(pending->range, IncludeVersion())));
+			}
+			pending->added.send(Void());
+		} catch (Error& e) {
+			pending->added.sendError(e);
+		}
+	}
+
+	// Creates a column family for the range, unless that is disabled or the range is already part of a shard's
+	Future<Void> reserveRange(KeyRangeRef range) override {
+		if (shardMap == nullptr || !SERVER_KNOBS->ROCKSDB_SHARD_COLUMN_FAMILIES || range.empty()) {
+			return Void();
+		}
+		auto pieces = split(range);
+		if (pieces.size() != 1 || pieces[0].second != nullptr) {
+			return Void();
 		}
+		for (auto& pending : pendingShards) {
+			if (pending->range.intersects(range)) {
+				return Void();
+			}
+		}
+		auto pending = makeReference<PendingShard>(range);
+		pendingShards.push_back(pending);
+		addShard(this, pending);
+		return pending->added.getFuture();
+	}
+
+	bool canBulkLoad() const override { return SERVER_KNOBS->ROCKSDB_BULK_LOAD; }
 
-		writeBatch->DeleteRange(toSlice(keyRange.begin), toSlice(keyRange.end));
+	// The block is built into an sst file on the writer thread, which the next commit ingests instead of writing each
+	// pair through the memtable and WAL and then compacting it down the levels.
+	void bulkLoad(Standalone<VectorRef<KeyValueRef>> data) override {
+		if (data.empty()) {
+			return;
+		}
+		if (writeBatch != nullptr) {
+			pendingSteps.push_back({ std::move(writeBatch), std::string(), nullptr });
+		}
+		// Each column family's part of the block is ingested from its own file
+		for (int begin = 0; begin < data.size();) {
+			CF cf = cfFor(data[begin].key);
+			int end = begin + 1;
+			while (end < data.size() && cfFor(data[end].key) == cf) {
+				++end;
+			}
+			std::string file = joinPath(path, format("bulkload-%s-%d.sst", id.toString().c_str(), bulkLoadFiles++));
+			Standalone<VectorRef<KeyValueRef>> part(VectorRef<KeyValueRef>(data.begin() + begin, end - begin),
+			                                        data.arena());
+			writeThread->post(new Writer::BuildFileAction(file, part));
+			pendingSteps.push_back({ nullptr, file, cf });
+			begin = end;
+		}
 	}
 
 	Future<Void> commit(bool) override {
 		// If there is nothing to write, don't write.
-		if (writeBatch == nullptr) {
+		if (writeBatch == nullptr && pendingSteps.empty() && droppedShards.empty()) {
 			return Void();
 		}
 		auto a = new Writer::CommitAction();
-		a->batchToCommit = std::move(writeBatch);
+		a->steps = std::move(pendingSteps);
+		pendingSteps.clear();
+		if (writeBatch != nullptr) {
+			a->steps.push_back({ std::move(writeBatch), std::string(), nullptr });
+		}
+		a->dropped = std::move(droppedShards);
+		droppedShards.clear();
 		auto res = a->done.getFuture();
 		writeThread->post(a);
 		return res;
 	}
 
+	// Sends the point reads made during the last tick to the readers, together in batches of up to
+	// ROCKSDB_READ_VALUE_BATCH_SIZE so that several readers can still share them.
+	ACTOR static Future<Void> sendPendingReads(RocksDBKeyValueStore* self) {
+		wait(delay(0));
+		state std::vector<std::unique_ptr<Reader::ReadValueAction>> reads = std::move(self->pendingReads);
+		self->pendingReads.clear();
+		for (int i = 0; i < reads.size();) {
+			int n = std::min<int>(reads.size() - i, SERVER_KNOBS->ROCKSDB_READ_VALUE_BATCH_SIZE);
+			if (n == 1) {
+				self->readThreads->post(reads[i++].release());
+				continue;
+			}
+			auto a = new Reader::MultiReadValueAction();
+			for (int end = i + n; i < end; ++i) {
+				a->reads.push_back(std::move(reads[i]));
+			}
+			self->readThreads->post(a);
+		}
+		return Void();
+	}
+
 	Future<Optional<Value>> readValue(KeyRef key, Optional<UID> debugID) override {
-		auto a = new Reader::ReadValueAction(key, debugID);
+		auto a = new Reader::ReadValueAction(key, cfFor(key), debugID);
 		auto res = a->result.getFuture();
-		readThreads->post(a);
+		if (SERVER_KNOBS->ROCKSDB_READ_VALUE_BATCH_SIZE <= 1) {
+			readThreads->post(a);
+			return res;
+		}
+		pendingReads.emplace_back(a);
+		if (pendingReads.size() == 1) {
+			pendingReadsSent = sendPendingReads(this);
+		}
 		return res;
 	}
 
+	// Sent straight to the readers as MultiGets, since the caller has already gathered the keys
+	Future<std::vector<Optional<Value>>> readValues(std::vector<std::pair<KeyRef, int>> const& keys,
+	                                                Optional<UID> debugID) override {
+		std::vector<Future<Optional<Value>>> results;
+		results.reserve(keys.size());
+		for (int i = 0; i < keys.size();) {
+			int n = std::min<int>(keys.size() - i, std::max(1, SERVER_KNOBS->ROCKSDB_READ_VALUE_BATCH_SIZE));
+			auto a = new Reader::MultiReadValueAction();
+			for (int end = i + n; i < end; ++i) {
+				a->reads.emplace_back(
+				    new Reader::ReadValueAction(keys[i].first, cfFor(keys[i].first), debugID, keys[i].second));
+				results.push_back(a->reads.back()->result.getFuture());
+			}
+			readThreads->post(a);
+		}
+		return getAll(results);
+	}
+
 	Future<Optional<Value>> readValuePrefix(KeyRef key, int maxLength, Optional<UID> debugID) override {
-		auto a = new Reader::ReadValuePrefixAction(key, maxLength, debugID);
+		auto a = new Reader::ReadValuePrefixAction(key, cfFor(key), maxLength, debugID);
 		auto res = a->result.getFuture();
 		readThreads->post(a);
 		return res;
 	}
 
 	Future<Standalone<RangeResultRef>> readRange(KeyRangeRef keys, int rowLimit, int byteLimit) override {
-		auto a = new Reader::ReadRangeAction(keys, rowLimit, byteLimit);
+		std::vector<std::pair<KeyRange, CF>> pieces;
+		for (const auto& [range, shard] : split(keys)) {
+			pieces.emplace_back(range, shard ? shard->cf : db->DefaultColumnFamily());
+		}
+		auto a = new Reader::ReadRangeAction(std::move(pieces), rowLimit, byteLimit);
 		auto res = a->result.getFuture();
 		readThreads->post(a);
 		return res;
@@ -406,7 +894,7 @@ struct RocksDBKeyValueStore : IKeyValueStore {
 
 	StorageBytes getStorageBytes() const override {
 		uint64_t live = 0;
-		ASSERT(db->GetIntProperty(rocksdb::DB::Properties::kEstimateLiveDataSize, &live));
+		ASSERT(db->GetAggregatedIntProperty(rocksdb::DB::Properties::kEstimateLiveDataSize, &live));
 
 		int64_t free;
 		int64_t total;
@@ -414,6 +902,40 @@ struct RocksDBKeyValueStore : IKeyValueStore {
 
 		return StorageBytes(free, total, live, free);
 	}
+
+	// Read from the properties of each column family holding data, so that ratekeeper can slow down commits before
+	// RocksDB stalls them
+	StorageEngineDebt getEngineDebt() const override {
+		StorageEngineDebt debt;
+		if (db == nullptr) {
+			return debt;
+		}
+		rocksdb::ColumnFamilyOptions options = getCFOptions();
+		debt.pendingCompactionBytesLimit = options.hard_pending_compaction_bytes_limit;
+		debt.level0FilesLimit = options.level0_stop_writes_trigger;
+
+		auto add = [&](CF cf) {
+			uint64_t value = 0;
+			if (db->GetIntProperty(cf, rocksdb::DB::Properties::kEstimatePendingCompactionBytes, &value)) {
+				debt.pendingCompactionBytes += value;
+			}
+			std::string files;
+			if (db->GetProperty(cf, rocksdb::DB::Properties::kNumFilesAtLevelPrefix + "0", &files)) {
+				debt.level0Files = std::max<int64_t>(debt.level0Files, atoll(files.c_str()));
+			}
+		};
+		add(db->DefaultColumnFamily());
+		for (const auto& [begin, shard] : shards) {
+			add(shard.cf);
+		}
+
+		uint64_t stopped = 0;
+		uint64_t delayedRate = 0;
+		db->GetIntProperty(rocksdb::DB::Properties::kIsWriteStopped, &stopped);
+		db->GetIntProperty(rocksdb::DB::Properties::kActualDelayedWriteRate, &delayedRate);
+		debt.stalled = stopped != 0 || delayedRate != 0;
+		return debt;
+	}
 };
 
 } // namespace
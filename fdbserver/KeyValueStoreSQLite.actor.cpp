@@ -683,10 +683,11 @@ struct RawCursor {
 	BtCursor *cursor;
 	KeyInfo keyInfo;
 	bool valid;
+	int prefetchPages; // Sibling leaves to read ahead of a range scan, set by getRange
 
 	operator bool() const { return valid; }
 
-	RawCursor( SQLiteDB& db, int table, bool write) : cursor(0), db(db), valid(false) {
+	RawCursor( SQLiteDB& db, int table, bool write) : cursor(0), db(db), valid(false), prefetchPages(0) {
 		keyInfo.db = db.db;
 		keyInfo.enc = db.db->aDb[0].pSchema->enc;
 		keyInfo.aColl[0] = db.db->pDfltColl;
@@ -724,11 +725,13 @@ struct RawCursor {
 		int empty=1;
 		db.checkError("BtreeNext", sqlite3BtreeNext(cursor, &empty));
 		valid = !empty;
+		if (valid && prefetchPages) sqlite3BtreePrefetch(cursor, 1, prefetchPages, 0);
 	}
 	void movePrevious() {
 		int empty=1;
 		db.checkError("BtreePrevious", sqlite3BtreePrevious(cursor, &empty));
 		valid = !empty;
+		if (valid && prefetchPages) sqlite3BtreePrefetch(cursor, 0, prefetchPages, 0);
 	}
 	int size() {
 		int64_t size;
@@ -1116,11 +1119,19 @@ struct RawCursor {
 			return result;
 		}
 
+		// Only scans big enough to finish the current leaf read ahead, at most as far as byteLimit could reach
+		struct PrefetchScope {
+			RawCursor& c;
+			PrefetchScope(RawCursor& c, int pages) : c(c) { c.prefetchPages = pages; }
+			~PrefetchScope() { c.prefetchPages = 0; }
+		} prefetchScope(*this, std::max(0, std::min(SERVER_KNOBS->SQLITE_CURSOR_PREFETCH_PAGES, byteLimit / SERVER_KNOBS->SQLITE_BTREE_PAGE_USABLE - 1)));
+
 		if(db.fragment_values) {
 			if(rowLimit > 0) {
 				int r = moveTo(keys.begin);
 				if (r < 0)
 					moveNext();
+				prefetchStart(true);
 
 				DefragmentingReader i(*this, result.arena(), true);
 				Optional<KeyRef> nextKey = i.peek();
@@ -1136,6 +1147,7 @@ struct RawCursor {
 				int r = moveTo(keys.end);
 				if (r >= 0)
 					movePrevious();
+				prefetchStart(false);
 				DefragmentingReader i(*this, result.arena(), false);
 				Optional<KeyRef> nextKey = i.peek();
 				while(nextKey.present() && nextKey.get() >= keys.begin && rowLimit != 0 && accumulatedBytes < byteLimit) {
@@ -1151,6 +1163,7 @@ struct RawCursor {
 			if (rowLimit > 0) {
 				int r = moveTo( keys.begin );
 				if (r < 0) moveNext();
+				prefetchStart(true);
 				while (this->valid && rowLimit != 0 && accumulatedBytes < byteLimit) {
 					KeyValueRef kv = decodeKV( getEncodedRow( result.arena() ) );
 					if (kv.key >= keys.end) break;
@@ -1162,6 +1175,7 @@ struct RawCursor {
 			} else {
 				int r = moveTo( keys.end );
 				if (r >= 0) movePrevious();
+				prefetchStart(false);
 				while (this->valid && rowLimit != 0 && accumulatedBytes < byteLimit) {
 					KeyValueRef kv = decodeKV( getEncodedRow( result.arena() ) );
 					if (kv.key < keys.begin) break;
@@ -1180,6 +1194,11 @@ struct RawCursor {
 		return result;
 	}
 
+	// A scan that starts part way through a leaf still reads ahead from it
+	void prefetchStart( bool forward ) {
+		if (valid && prefetchPages > 0) sqlite3BtreePrefetch(cursor, forward, prefetchPages, 1);
+	}
+
 	int moveTo( KeyRef key, bool ignore_fragment_mode = false ) {
 		UnpackedRecord r;
 		r.pKeyInfo = &keyInfo;
@@ -1492,6 +1511,8 @@ public:
 
 	Future<Optional<Value>> readValue(KeyRef key, Optional<UID> debugID) override;
 	Future<Optional<Value>> readValuePrefix(KeyRef key, int maxLength, Optional<UID> debugID) override;
+	Future<std::vector<Optional<Value>>> readValues(std::vector<std::pair<KeyRef, int>> const& keys,
+	                                                Optional<UID> debugID) override;
 	Future<Standalone<RangeResultRef>> readRange(KeyRangeRef keys, int rowLimit = 1 << 30,
 	                                             int byteLimit = 1 << 30) override;
 
@@ -1503,9 +1524,13 @@ public:
 		int vacuumedPages = 0;
 	};
 
-	Future<SpringCleaningWorkPerformed> doClean();
+	// Cleans for up to the spring cleaning time estimates, doing at most maxPages pages of lazy deletion and vacuuming
+	Future<SpringCleaningWorkPerformed> doClean(int64_t maxPages = std::numeric_limits<int64_t>::max());
 	void startReadThreads();
 
+	// Writer thread actions, including commits, that have been requested but not finished
+	int64_t writeQueueLength() const { return writesRequested - writesComplete; }
+
 private:
 	KeyValueStoreType type;
 	UID logID;
@@ -1588,6 +1613,35 @@ private:
 			//if (t >= 1.0) TraceEvent("ReadValuePrefixActionSlow",dbgid).detail("Elapsed", t);
 		}
 
+		// Several point reads served by one cursor in one trip through the read thread pool
+		struct ReadValuesAction final : TypedAction<Reader, ReadValuesAction>, FastAllocated<ReadValuesAction> {
+			Arena arena;
+			std::vector<std::pair<KeyRef, int>> keys;
+			Optional<UID> debugID;
+			ThreadReturnPromise<std::vector<Optional<Value>>> result;
+			ReadValuesAction(std::vector<std::pair<KeyRef, int>> const& keys, Optional<UID> debugID) : debugID(debugID) {
+				this->keys.reserve(keys.size());
+				for (const auto& [key, maxLength] : keys) {
+					this->keys.emplace_back(KeyRef(arena, key), maxLength);
+				}
+			}
+			double getTimeEstimate() const override { return SERVER_KNOBS->READ_VALUE_TIME_ESTIMATE * keys.size(); }
+		};
+		void action( ReadValuesAction& rv ) {
+			if (rv.debugID.present()) g_traceBatch.addEvent("GetValuesDebug", rv.debugID.get().first(), "Reader.Before");
+
+			Reference<ReadCursor> cursor = getCursor();
+			std::vector<Optional<Value>> values;
+			values.reserve(rv.keys.size());
+			for (const auto& [key, maxLength] : rv.keys) {
+				values.push_back(maxLength < 0 ? cursor->get().get(key) : cursor->get().getPrefix(key, maxLength));
+			}
+			rv.result.send(values);
+			++counter;
+
+			if (rv.debugID.present()) g_traceBatch.addEvent("GetValuesDebug", rv.debugID.get().first(), "Reader.After");
+		}
+
 		struct ReadRangeAction : TypedAction<Reader, ReadRangeAction>, FastAllocated<ReadRangeAction> {
 			KeyRange keys;
 			int rowLimit, byteLimit;
@@ -1775,7 +1829,9 @@ private:
 		}
 
 		struct SpringCleaningAction : TypedAction<Writer, SpringCleaningAction>, FastAllocated<SpringCleaningAction> {
+			int64_t maxPages;
 			ThreadReturnPromise<SpringCleaningWorkPerformed> result;
+			explicit SpringCleaningAction(int64_t maxPages) : maxPages(maxPages) {}
 			double getTimeEstimate() const override {
 				return std::max(SERVER_KNOBS->SPRING_CLEANING_LAZY_DELETE_TIME_ESTIMATE, SERVER_KNOBS->SPRING_CLEANING_VACUUM_TIME_ESTIMATE);
 			}
@@ -1807,11 +1863,18 @@ private:
 					break;
 				}
 
+				int64_t pagesLeft = a.maxPages - workPerformed.lazyDeletePages - workPerformed.vacuumedPages;
+				if(pagesLeft <= 0) {
+					TEST(true); // SQLite spring cleaning stopped by its page budget
+					break;
+				}
+
 				if(canDelete && (!canVacuum || deterministicRandom()->random01() < lazyDeleteBatchProbability)) {
 					TEST(canVacuum); // SQLite lazy deletion when vacuuming is active
 					TEST(!canVacuum); // SQLite lazy deletion when vacuuming is inactive
 
 					int pagesToDelete = std::max(1, std::min(SERVER_KNOBS->SPRING_CLEANING_LAZY_DELETE_BATCH_SIZE, SERVER_KNOBS->SPRING_CLEANING_MAX_LAZY_DELETE_PAGES - workPerformed.lazyDeletePages));
+					pagesToDelete = std::min<int64_t>(pagesToDelete, pagesLeft);
 					int pagesDeleted = cursor->lazyDelete(pagesToDelete) ;
 					freeTableEmpty = (pagesDeleted != pagesToDelete);
 					workPerformed.lazyDeletePages += pagesDeleted;
@@ -1928,10 +1991,36 @@ IKeyValueStore* keyValueStoreSQLite( std::string const& filename, UID logID, Key
 	return new KeyValueStoreSQLite(filename, logID, storeType, checkChecksums, checkIntegrity);
 }
 
+// If SPRING_CLEANING_PAGES_PER_SECOND is set, spring cleaning draws its pages from a token bucket that fills at that
+// rate, or at SPRING_CLEANING_BUSY_RATE_FRACTION of it while commits and other writes are queued behind the writer
+// thread, so that a large backlog of free pages is cleaned at a predictable pace without delaying foreground writes.
 ACTOR Future<Void> cleanPeriodically( KeyValueStoreSQLite* self ) {
+	state double pageTokens = SERVER_KNOBS->SPRING_CLEANING_PAGE_BURST;
+	state double lastRefill = now();
 	wait(delayJittered(SERVER_KNOBS->SPRING_CLEANING_NO_ACTION_INTERVAL));
 	loop {
-		KeyValueStoreSQLite::SpringCleaningWorkPerformed workPerformed = wait(self->doClean());
+		state int64_t maxPages = std::numeric_limits<int64_t>::max();
+		if (SERVER_KNOBS->SPRING_CLEANING_PAGES_PER_SECOND > 0) {
+			double rate = SERVER_KNOBS->SPRING_CLEANING_PAGES_PER_SECOND;
+			if (self->writeQueueLength() > SERVER_KNOBS->SPRING_CLEANING_BUSY_WRITE_QUEUE) {
+				TEST(true); // SQLite spring cleaning slowed by queued writes
+				rate *= SERVER_KNOBS->SPRING_CLEANING_BUSY_RATE_FRACTION;
+			}
+			pageTokens = std::min<double>(SERVER_KNOBS->SPRING_CLEANING_PAGE_BURST, pageTokens + rate * (now() - lastRefill));
+			lastRefill = now();
+
+			// Wait for enough tokens for a lazy delete batch rather than cleaning a few pages at a time
+			double wanted = std::max(1, std::min(SERVER_KNOBS->SPRING_CLEANING_LAZY_DELETE_BATCH_SIZE, SERVER_KNOBS->SPRING_CLEANING_PAGE_BURST));
+			if (pageTokens < wanted) {
+				wait(delayJittered(rate > 0 ? std::min((wanted - pageTokens) / rate, SERVER_KNOBS->SPRING_CLEANING_NO_ACTION_INTERVAL)
+				                            : SERVER_KNOBS->SPRING_CLEANING_NO_ACTION_INTERVAL));
+				continue;
+			}
+			maxPages = pageTokens;
+		}
+
+		KeyValueStoreSQLite::SpringCleaningWorkPerformed workPerformed = wait(self->doClean(maxPages));
+		pageTokens -= workPerformed.lazyDeletePages + workPerformed.vacuumedPages;
 
 		double duration = std::numeric_limits<double>::max();
 		if (workPerformed.lazyDeletePages >= SERVER_KNOBS->SPRING_CLEANING_LAZY_DELETE_BATCH_SIZE) {
@@ -2043,6 +2132,14 @@ Future<Optional<Value>> KeyValueStoreSQLite::readValuePrefix( KeyRef key, int ma
 	readThreads->post(p);
 	return f;
 }
+Future<std::vector<Optional<Value>>> KeyValueStoreSQLite::readValues(std::vector<std::pair<KeyRef, int>> const& keys,
+                                                                    Optional<UID> debugID) {
+	++readsRequested;
+	auto p = new Reader::ReadValuesAction(keys, debugID);
+	auto f = p->result.getFuture();
+	readThreads->post(p);
+	return f;
+}
 Future<Standalone<RangeResultRef>> KeyValueStoreSQLite::readRange( KeyRangeRef keys, int rowLimit, int byteLimit ) {
 	++readsRequested;
 	auto p = new Reader::ReadRangeAction(keys, rowLimit, byteLimit);
@@ -2050,9 +2147,9 @@ Future<Standalone<RangeResultRef>> KeyValueStoreSQLite::readRange( KeyRangeRef k
 	readThreads->post(p);
 	return f;
 }
-Future<KeyValueStoreSQLite::SpringCleaningWorkPerformed> KeyValueStoreSQLite::doClean() {
+Future<KeyValueStoreSQLite::SpringCleaningWorkPerformed> KeyValueStoreSQLite::doClean(int64_t maxPages) {
 	++writesRequested;
-	auto p = new Writer::SpringCleaningAction;
+	auto p = new Writer::SpringCleaningAction(maxPages);
 	auto f = p->result.getFuture();
 	writeThread->post(p);
 	return f;
@@ -62,6 +62,7 @@ void ServerKnobs::initialize(bool randomize, ClientKnobs* clientKnobs, bool isSi
 	init( LEGACY_TLOG_UPGRADE_ENTRIES_PER_VERSION,               100 );
 	init( VERSION_MESSAGES_OVERHEAD_FACTOR_1024THS,             1072 ); // Based on a naive interpretation of the gcc version of std::deque, we would expect this to be 16 bytes overhead per 512 bytes data. In practice, it seems to be 24 bytes overhead per 512.
 	init( VERSION_MESSAGES_ENTRY_BYTES_WITH_OVERHEAD, std::ceil(16.0 * VERSION_MESSAGES_OVERHEAD_FACTOR_1024THS / 1024) );
+	init( TAG_MESSAGE_INDEX_ENTRY_BYTES_WITH_OVERHEAD, std::ceil(8.0 * VERSION_MESSAGES_OVERHEAD_FACTOR_1024THS / 1024) ); // TagMessageIndex entries are half the size of the pairs older TLogs keep
 	init( LOG_SYSTEM_PUSHED_DATA_BLOCK_SIZE,                     1e5 );
 	init( MAX_MESSAGE_SIZE,            std::max<int>(LOG_SYSTEM_PUSHED_DATA_BLOCK_SIZE, 1e5 + 2e4 + 1) + 8 ); // VALUE_SIZE_LIMIT + SYSTEM_KEY_SIZE_LIMIT + 9 bytes (4 bytes for length, 4 bytes for sequence number, and 1 byte for mutation type)
 	init( TLOG_MESSAGE_BLOCK_BYTES,                             10e6 );
@@ -70,6 +71,8 @@ void ServerKnobs::initialize(bool randomize, ClientKnobs* clientKnobs, bool isSi
 	init( PARALLEL_GET_MORE_REQUESTS,                             32 ); if( randomize && BUGGIFY ) PARALLEL_GET_MORE_REQUESTS = 2;
 	init( MULTI_CURSOR_PRE_FETCH_LIMIT,                           10 );
 	init( MAX_QUEUE_COMMIT_BYTES,                               15e6 ); if( randomize && BUGGIFY ) MAX_QUEUE_COMMIT_BYTES = 5000;
+	init( TLOG_GROUP_COMMIT_DELAY_FRACTION,                      0.0 ); if( randomize && BUGGIFY ) TLOG_GROUP_COMMIT_DELAY_FRACTION = deterministicRandom()->random01(); // Of the smoothed queue commit latency, to wait for more commits to join an idle queue's next commit
+	init( TLOG_MAX_GROUP_COMMIT_DELAY,                         0.002 );
 	init( DESIRED_OUTSTANDING_MESSAGES,                         5000 ); if( randomize && BUGGIFY ) DESIRED_OUTSTANDING_MESSAGES = deterministicRandom()->randomInt(0,100);
 	init( DESIRED_GET_MORE_DELAY,                              0.005 );
 	init( CONCURRENT_LOG_ROUTER_READS,                             5 ); if( randomize && BUGGIFY ) CONCURRENT_LOG_ROUTER_READS = 1;
@@ -77,11 +80,15 @@ void ServerKnobs::initialize(bool randomize, ClientKnobs* clientKnobs, bool isSi
 	init( DISK_QUEUE_ADAPTER_MIN_SWITCH_TIME,                    1.0 );
 	init( DISK_QUEUE_ADAPTER_MAX_SWITCH_TIME,                    5.0 );
 	init( TLOG_SPILL_REFERENCE_MAX_PEEK_MEMORY_BYTES,            2e9 ); if ( randomize && BUGGIFY ) TLOG_SPILL_REFERENCE_MAX_PEEK_MEMORY_BYTES = 2e6;
+	init( TLOG_SPILLED_PEEK_CACHE_BYTES,                        50e6 ); if ( randomize && BUGGIFY ) TLOG_SPILLED_PEEK_CACHE_BYTES = deterministicRandom()->coinflip() ? 0 : 2e5;
 	init( TLOG_SPILL_REFERENCE_MAX_BATCHES_PER_PEEK,           100 ); if ( randomize && BUGGIFY ) TLOG_SPILL_REFERENCE_MAX_BATCHES_PER_PEEK = 1;
 	init( TLOG_SPILL_REFERENCE_MAX_BYTES_PER_BATCH,           16<<10 ); if ( randomize && BUGGIFY ) TLOG_SPILL_REFERENCE_MAX_BYTES_PER_BATCH = 500;
+	init( TLOG_SPILL_REFERENCE_MAX_READ_GAP_BYTES,            64<<10 ); if ( randomize && BUGGIFY ) TLOG_SPILL_REFERENCE_MAX_READ_GAP_BYTES = deterministicRandom()->coinflip() ? 0 : 1e6;
 	init( DISK_QUEUE_FILE_EXTENSION_BYTES,                    10<<20 ); // BUGGIFYd per file within the DiskQueue
 	init( DISK_QUEUE_FILE_SHRINK_BYTES,                      100<<20 ); // BUGGIFYd per file within the DiskQueue
 	init( DISK_QUEUE_MAX_TRUNCATE_BYTES,                       2<<30 ); if ( randomize && BUGGIFY ) DISK_QUEUE_MAX_TRUNCATE_BYTES = 0;
+	init( DISK_QUEUE_COALESCE_COMMITS,                         false ); if ( randomize && BUGGIFY ) DISK_QUEUE_COALESCE_COMMITS = true;
+	init( DISK_QUEUE_RECOVERY_READ_BYTES,                      4<<20 ); // Size of each read while recovering a DiskQueue, one of which is kept in flight ahead of the reader
 	init( TLOG_DEGRADED_DURATION,                                5.0 );
 	init( MAX_CACHE_VERSIONS,                                   10e6 );
 	init( TLOG_IGNORE_POP_AUTO_ENABLE_DELAY,                   300.0 );
@@ -115,6 +122,10 @@ void ServerKnobs::initialize(bool randomize, ClientKnobs* clientKnobs, bool isSi
 	init( DD_QUEUE_MAX_KEY_SERVERS,                              100 ); if( randomize && BUGGIFY ) DD_QUEUE_MAX_KEY_SERVERS = 1;
 	init( DD_REBALANCE_PARALLELISM,                               50 );
 	init( DD_REBALANCE_RESET_AMOUNT,                              30 );
+	init( DD_REBALANCE_LOAD_AWARE,                             false ); if( randomize && BUGGIFY ) DD_REBALANCE_LOAD_AWARE = true; // Rebalancing weighs teams and shards by read and write bandwidth as well as bytes
+	init( DD_REBALANCE_READ_WEIGHT,                            100.0 ); // Kiloseconds of read bandwidth counted as stored bytes
+	init( DD_REBALANCE_WRITE_WEIGHT,                            50.0 ); // Kiloseconds of write bandwidth counted as stored bytes
+	init( DD_REBALANCE_LOAD_HYSTERESIS,                          0.2 ); if( randomize && BUGGIFY ) DD_REBALANCE_LOAD_HYSTERESIS = deterministicRandom()->random01();
 	init( BG_DD_MAX_WAIT,                                      120.0 );
 	init( BG_DD_MIN_WAIT,                                        0.1 );
 	init( BG_DD_INCREASE_RATE,                                  1.10 );
@@ -163,6 +174,12 @@ void ServerKnobs::initialize(bool randomize, ClientKnobs* clientKnobs, bool isSi
 		Shard with a read bandwidth smaller than this value will never be too busy to handle the reads.
 	*/
 	init( SHARD_MAX_BYTES_READ_PER_KSEC_JITTER,     0.1 );
+	init( STORAGE_CACHE_AUTO_ADMIT,                  false ); if( randomize && BUGGIFY ) STORAGE_CACHE_AUTO_ADMIT = true; // Cache read hot ranges on the storage cache role without manual configuration
+	init( STORAGE_CACHE_AUTO_MAX_BYTES,                1e9 ); if( randomize && BUGGIFY ) STORAGE_CACHE_AUTO_MAX_BYTES = 1e6;
+	init( STORAGE_CACHE_ADMIT_HITS,                      2 ); if( randomize && BUGGIFY ) STORAGE_CACHE_ADMIT_HITS = 1; // Times a range must be reported read hot before it is cached
+	init( STORAGE_CACHE_HEAT_HALF_LIFE,              300.0 );
+	init( STORAGE_CACHE_IDLE_TIMEOUT,                600.0 ); if( randomize && BUGGIFY ) STORAGE_CACHE_IDLE_TIMEOUT = 10.0; // Cached ranges not reported read hot for this long are uncached
+	init( STORAGE_CACHE_EVICTION_INTERVAL,            60.0 ); if( randomize && BUGGIFY ) STORAGE_CACHE_EVICTION_INTERVAL = 5.0;
 	bool buggifySmallBandwidthSplit = randomize && BUGGIFY;
 	init( SHARD_MAX_BYTES_PER_KSEC,                 1LL*1000000*1000 ); if( buggifySmallBandwidthSplit ) SHARD_MAX_BYTES_PER_KSEC = 10LL*1000*1000;
 	/* 1*1MB/sec * 1000sec/ksec
@@ -203,6 +220,7 @@ void ServerKnobs::initialize(bool randomize, ClientKnobs* clientKnobs, bool isSi
 		*/
 
 	init( STORAGE_METRIC_TIMEOUT,         isSimulated ? 60.0 : 600.0 ); if( randomize && BUGGIFY ) STORAGE_METRIC_TIMEOUT = deterministicRandom()->coinflip() ? 10.0 : 30.0;
+	init( SHARD_METRICS_STREAM_DELAY,                            0.1 ); if( randomize && BUGGIFY ) SHARD_METRICS_STREAM_DELAY = deterministicRandom()->coinflip() ? 0.0 : 1.0;
 	init( METRIC_DELAY,                                          0.1 ); if( randomize && BUGGIFY ) METRIC_DELAY = 1.0;
 	init( ALL_DATA_REMOVED_DELAY,                                1.0 );
 	init( INITIAL_FAILURE_REACTION_DELAY,                       30.0 ); if( randomize && BUGGIFY ) INITIAL_FAILURE_REACTION_DELAY = 0.0;
@@ -228,6 +246,7 @@ void ServerKnobs::initialize(bool randomize, ClientKnobs* clientKnobs, bool isSi
 	init( DD_SHARD_SIZE_GRANULARITY_SIM,                      500000 ); if( randomize && BUGGIFY ) DD_SHARD_SIZE_GRANULARITY_SIM = 0;
 	init( DD_MOVE_KEYS_PARALLELISM,                               15 ); if( randomize && BUGGIFY ) DD_MOVE_KEYS_PARALLELISM = 1;
 	init( DD_FETCH_SOURCE_PARALLELISM,                          1000 ); if( randomize && BUGGIFY ) DD_FETCH_SOURCE_PARALLELISM = 1;
+	init( DD_MERGE_ADJACENT_RELOCATIONS,                           8 ); if( randomize && BUGGIFY ) DD_MERGE_ADJACENT_RELOCATIONS = deterministicRandom()->randomInt(1, 50);
 	init( DD_MERGE_LIMIT,                                       2000 ); if( randomize && BUGGIFY ) DD_MERGE_LIMIT = 2;
 	init( DD_SHARD_METRICS_TIMEOUT,                             60.0 ); if( randomize && BUGGIFY ) DD_SHARD_METRICS_TIMEOUT = 0.1;
 	init( DD_LOCATION_CACHE_SIZE,                            2000000 ); if( randomize && BUGGIFY ) DD_LOCATION_CACHE_SIZE = 3;
@@ -299,6 +318,8 @@ void ServerKnobs::initialize(bool randomize, ClientKnobs* clientKnobs, bool isSi
 					 - 4 // next pageNumber size
 	);
 	init( SQLITE_FRAGMENT_MIN_SAVINGS,                          0.20 );
+	init( SQLITE_CURSOR_PREFETCH_PAGES,                           16 ); if( randomize && BUGGIFY ) SQLITE_CURSOR_PREFETCH_PAGES = deterministicRandom()->randomInt(0, 4); // Sibling leaves read ahead by range scans
+	init( SQLITE_PREFETCH_MAX_READS,                             128 ); // Per file
 
 	// KeyValueStoreSqlite spring cleaning
 	init( SPRING_CLEANING_NO_ACTION_INTERVAL,                    1.0 ); if( randomize && BUGGIFY ) SPRING_CLEANING_NO_ACTION_INTERVAL = deterministicRandom()->coinflip() ? 0.1 : deterministicRandom()->random01() * 5;
@@ -312,6 +333,10 @@ void ServerKnobs::initialize(bool randomize, ClientKnobs* clientKnobs, bool isSi
 	init( SPRING_CLEANING_LAZY_DELETE_BATCH_SIZE,                100 ); if( randomize && BUGGIFY ) SPRING_CLEANING_LAZY_DELETE_BATCH_SIZE = deterministicRandom()->randomInt(1, 1000);
 	init( SPRING_CLEANING_MIN_VACUUM_PAGES,                        1 ); if( randomize && BUGGIFY ) SPRING_CLEANING_MIN_VACUUM_PAGES = deterministicRandom()->randomInt(0, 100);
 	init( SPRING_CLEANING_MAX_VACUUM_PAGES,                      1e9 ); if( randomize && BUGGIFY ) SPRING_CLEANING_MAX_VACUUM_PAGES = deterministicRandom()->coinflip() ? 0 : deterministicRandom()->randomInt(1, 1e4);
+	init( SPRING_CLEANING_PAGES_PER_SECOND,                      0.0 ); if( randomize && BUGGIFY ) SPRING_CLEANING_PAGES_PER_SECOND = deterministicRandom()->randomInt(100, 10000);
+	init( SPRING_CLEANING_PAGE_BURST,                          10000 ); if( randomize && BUGGIFY ) SPRING_CLEANING_PAGE_BURST = deterministicRandom()->randomInt(1, 1000);
+	init( SPRING_CLEANING_BUSY_WRITE_QUEUE,                       10 ); if( randomize && BUGGIFY ) SPRING_CLEANING_BUSY_WRITE_QUEUE = deterministicRandom()->randomInt(0, 10);
+	init( SPRING_CLEANING_BUSY_RATE_FRACTION,                    0.1 ); if( randomize && BUGGIFY ) SPRING_CLEANING_BUSY_RATE_FRACTION = deterministicRandom()->random01();
 
 	// KeyValueStoreMemory
 	init( REPLACE_CONTENTS_BYTES,                                1e5 );
@@ -319,9 +344,15 @@ void ServerKnobs::initialize(bool randomize, ClientKnobs* clientKnobs, bool isSi
 	// KeyValueStoreRocksDB
 	init( ROCKSDB_BACKGROUND_PARALLELISM,                          0 );
 	init( ROCKSDB_READ_PARALLELISM,                                4 );
+	init( ROCKSDB_READ_WORK_STEALING,                           false ); if( randomize && BUGGIFY ) ROCKSDB_READ_WORK_STEALING = true; // Readers share work through per-thread queues rather than one queue
 	init( ROCKSDB_MEMTABLE_BYTES,                  512 * 1024 * 1024 );
 	init( ROCKSDB_UNSAFE_AUTO_FSYNC,                           false );
 	init( ROCKSDB_PERIODIC_COMPACTION_SECONDS,                     0 );
+	init( ROCKSDB_READ_VALUE_BATCH_SIZE,                          32 ); // Point reads in one tick are sent to a reader as one MultiGet of up to this many keys
+	init( ROCKSDB_READ_RANGE_READAHEAD_BYTES,                      0 ); // 0 leaves range read readahead to RocksDB
+	init( ROCKSDB_BULK_LOAD,                                    true ); // Fetched shard data is ingested as sst files
+	init( ROCKSDB_SHARD_COLUMN_FAMILIES,                       false ); // Fetched shards get their own column families, which are dropped when the shard is cleared
+	init( ROCKSDB_BACKGROUND_BYTES_PER_SECOND,                     0 ); // Cap on flush and compaction writes; 0 leaves them unlimited
 
 	// Leader election
 	bool longLeaderElection = randomize && BUGGIFY;
@@ -345,6 +376,8 @@ void ServerKnobs::initialize(bool randomize, ClientKnobs* clientKnobs, bool isSi
 	init( START_TRANSACTION_RATE_WINDOW,                         2.0 );
 	init( START_TRANSACTION_MAX_EMPTY_QUEUE_BUDGET,             10.0 );
 	init( START_TRANSACTION_MAX_QUEUE_SIZE,                      1e6 );
+	init( START_TRANSACTION_ENFORCE_TAG_THROTTLES,             false ); if( randomize && BUGGIFY ) START_TRANSACTION_ENFORCE_TAG_THROTTLES = true;
+	init( START_TRANSACTION_TAG_THROTTLE_BURST,                  1.0 ); if( randomize && BUGGIFY ) START_TRANSACTION_TAG_THROTTLE_BURST = 0.1; // Seconds of a throttled tag's rate that it can bank
 	init( KEY_LOCATION_MAX_QUEUE_SIZE,                           1e6 );
 
 	init( COMMIT_TRANSACTION_BATCH_INTERVAL_FROM_IDLE,         0.0005 ); if( randomize && BUGGIFY ) COMMIT_TRANSACTION_BATCH_INTERVAL_FROM_IDLE = 0.005;
@@ -363,7 +396,16 @@ void ServerKnobs::initialize(bool randomize, ClientKnobs* clientKnobs, bool isSi
 	init( COMMIT_TRANSACTION_BATCH_BYTES_SCALE_BASE,           100000 );
 	init( COMMIT_TRANSACTION_BATCH_BYTES_SCALE_POWER,             0.0 );
 
+	// If COMMIT_BATCH_LATENCY_TARGET is set, the batch interval and bytes are instead tuned (within the bounds above) to keep p99 commit latency under it
+	init( COMMIT_BATCH_LATENCY_TARGET,                            0.0 ); if( randomize && BUGGIFY ) COMMIT_BATCH_LATENCY_TARGET = deterministicRandom()->random01() * 0.2;
+	init( COMMIT_BATCH_CONTROL_INTERVAL,                          1.0 ); if( randomize && BUGGIFY ) COMMIT_BATCH_CONTROL_INTERVAL = 0.1;
+	init( COMMIT_BATCH_CONTROL_INCREASE,                         0.05 ); // Fraction of the allowed range grown by after an interval under the target
+	init( COMMIT_BATCH_CONTROL_BACKOFF,                           0.7 ); // Factor shrunk by after an interval over the target
+
 	init( RESOLVER_COALESCE_TIME,                                1.0 );
+	init( PROXY_COALESCE_ATOMIC_OPS,                            true ); if( randomize && BUGGIFY ) PROXY_COALESCE_ATOMIC_OPS = false;
+	init( PROXY_CONFLICT_HOTSPOT_HALF_LIFE,                     60.0 );
+	init( PROXY_CONFLICT_HOTSPOT_MAX_RANGES,                   10000 ); if( randomize && BUGGIFY ) PROXY_CONFLICT_HOTSPOT_MAX_RANGES = 8;
 	init( BUGGIFIED_ROW_LIMIT,                  APPLY_MUTATION_BYTES ); if( randomize && BUGGIFY ) BUGGIFIED_ROW_LIMIT = deterministicRandom()->randomInt(3, 30);
 	init( PROXY_SPIN_DELAY,                                     0.01 );
 	init( UPDATE_REMOTE_LOG_VERSION_INTERVAL,                    2.0 );
@@ -380,8 +422,12 @@ void ServerKnobs::initialize(bool randomize, ClientKnobs* clientKnobs, bool isSi
 	init( PROXY_COMPUTE_BUCKETS,                                20000 );
 	init( PROXY_COMPUTE_GROWTH_RATE,                             0.01 );
 	init( TXN_STATE_SEND_AMOUNT,                                    4 );
+	init( TXN_STATE_COMPRESSION,                                false ); if( randomize && BUGGIFY ) TXN_STATE_COMPRESSION = true; // zlib compress the txnStateStore chunks sent to commit proxies in recovery; ignored without zlib
 	init( REPORT_TRANSACTION_COST_ESTIMATION_DELAY,               0.1 );
 	init( PROXY_REJECT_BATCH_QUEUED_TOO_LONG,                    true );
+	init( PROXY_PIPELINE_COMMIT_VERSION_REQUESTS,               false ); if( randomize && BUGGIFY ) PROXY_PIPELINE_COMMIT_VERSION_REQUESTS = true; // A batch may ask the master for its version while the one before it is still resolving
+	init( COMMIT_VERSION_LEASE_MAX_DURATION,                      0.0 ); if( randomize && BUGGIFY ) COMMIT_VERSION_LEASE_MAX_DURATION = deterministicRandom()->random01() * 0.05;
+	init( COMMIT_VERSION_LEASE_BATCHES,                            10 ); if( randomize && BUGGIFY ) COMMIT_VERSION_LEASE_BATCHES = deterministicRandom()->randomInt(2, 100);
 
 	init( RESET_MASTER_BATCHES,                                   200 );
 	init( RESET_RESOLVER_BATCHES,                                 200 );
@@ -411,6 +457,16 @@ void ServerKnobs::initialize(bool randomize, ClientKnobs* clientKnobs, bool isSi
 	init( SAMPLE_EXPIRATION_TIME,                                1.0 );
 	init( SAMPLE_POLL_TIME,                                      0.1 );
 	init( RESOLVER_STATE_MEMORY_LIMIT,                           1e6 );
+	init( RESOLVER_PARTITIONS,                                     1 ); if( randomize && BUGGIFY ) RESOLVER_PARTITIONS = deterministicRandom()->randomInt(2, 5); // Threads (and conflict sets) used by one resolver, each for part of its key range
+	init( RESOLVER_REPARTITION_INTERVAL,                        60.0 ); if( randomize && BUGGIFY ) RESOLVER_REPARTITION_INTERVAL = 5.0;
+	init( RESOLVER_REPARTITION_IMBALANCE,                        2.0 ); // Repartition once the busiest partition samples this many times the average load
+	init( RESOLVER_ART_CONFLICT_SET,                           false ); if( randomize && BUGGIFY ) RESOLVER_ART_CONFLICT_SET = true; // Keep conflict history in an adaptive radix tree instead of a skip list
+	init( RESOLVER_BACKGROUND_PRUNE,                           false ); if( randomize && BUGGIFY ) RESOLVER_BACKGROUND_PRUNE = true; // Remove aged out conflict history in a low priority task instead of while resolving batches
+	init( RESOLVER_PRUNE_INTERVAL,                              0.05 ); // Seconds between passes of the background prune over the conflict history
+	init( RESOLVER_PRUNE_SLICE_TIME,                          0.0005 ); if( randomize && BUGGIFY ) RESOLVER_PRUNE_SLICE_TIME = 0.00001;
+	init( RESOLVER_PRUNE_NODES,                                 1000 ); if( randomize && BUGGIFY ) RESOLVER_PRUNE_NODES = deterministicRandom()->randomInt(1, 100); // History entries examined between checks of the slice time
+	init( RESOLVER_CAPTURE_FILE,                                  "" ); // If set, each resolver appends the batches it resolves to <file>.<resolver id>, to be replayed with -r conflictsetreplay
+	init( RESOLVER_CAPTURE_MAX_BYTES,                            1e9 ); // Stop capturing once a resolver's capture file reaches this size
 	init( LAST_LIMITED_RATIO,                                    2.0 );
 
 	// Backup Worker
@@ -419,6 +475,8 @@ void ServerKnobs::initialize(bool randomize, ClientKnobs* clientKnobs, bool isSi
 	init( BACKUP_FILE_BLOCK_BYTES,                       1024 * 1024 );
 	init( BACKUP_LOCK_BYTES,                                     3e9 ); if(randomize && BUGGIFY) BACKUP_LOCK_BYTES = deterministicRandom()->randomInt(1024, 4096) * 1024;
 	init( BACKUP_UPLOAD_DELAY,                                  10.0 ); if(randomize && BUGGIFY) BACKUP_UPLOAD_DELAY = deterministicRandom()->random01() * 60;
+	init( BACKUP_WORKER_LOG_COMPRESSION,                       false ); if(randomize && BUGGIFY) BACKUP_WORKER_LOG_COMPRESSION = true;
+	init( BACKUP_COMPACT_MUTATION_LOG,                         false ); if(randomize && BUGGIFY) BACKUP_COMPACT_MUTATION_LOG = true;
 
 	//Cluster Controller
 	init( CLUSTER_CONTROLLER_LOGGING_DELAY,                      5.0 );
@@ -445,6 +503,7 @@ void ServerKnobs::initialize(bool randomize, ClientKnobs* clientKnobs, bool isSi
 	init( REPLACE_INTERFACE_CHECK_DELAY,                         5.0 );
 	init( COORDINATOR_REGISTER_INTERVAL,                         5.0 );
 	init( CLIENT_REGISTER_INTERVAL,                            600.0 );
+	init( COORDINATOR_LONG_POLL_CHECK_INTERVAL,                  1.0 ); // How often coordinators answer long polls that have waited CLIENT_REGISTER_INTERVAL
 
 	init( INCOMPATIBLE_PEERS_LOGGING_INTERVAL,                   600 ); if( randomize && BUGGIFY ) INCOMPATIBLE_PEERS_LOGGING_INTERVAL = 60.0;
 	init( EXPECTED_MASTER_FITNESS,            ProcessClass::UnsetFit );
@@ -459,6 +518,7 @@ void ServerKnobs::initialize(bool randomize, ClientKnobs* clientKnobs, bool isSi
 	init( POLICY_GENERATIONS,                                    100 ); if( randomize && BUGGIFY ) POLICY_GENERATIONS = 10;
 	init( DBINFO_SEND_AMOUNT,                                      5 );
 	init( DBINFO_BATCH_DELAY,                                    0.1 );
+	init( DBINFO_SEND_DELTAS,                                  false ); if( randomize && BUGGIFY ) DBINFO_SEND_DELTAS = true; // Broadcast only the changed fields of ServerDBInfo; every process must understand deltas
 
 	//Move Keys
 	init( SHARD_READY_DELAY,                                    0.25 );
@@ -483,6 +543,9 @@ void ServerKnobs::initialize(bool randomize, ClientKnobs* clientKnobs, bool isSi
 	init( SLOW_SMOOTHING_AMOUNT,                                10.0 ); if( slowRatekeeper ) SLOW_SMOOTHING_AMOUNT = 50.0;
 	init( METRIC_UPDATE_RATE,                                     .1 ); if( slowRatekeeper ) METRIC_UPDATE_RATE = 0.5;
 	init( DETAILED_METRIC_UPDATE_RATE,                           5.0 );
+	init( QUEUING_METRICS_HEARTBEAT,                             1.0 ); if( randomize && BUGGIFY ) QUEUING_METRICS_HEARTBEAT = deterministicRandom()->random01() * 5;
+	init( QUEUING_METRICS_CHANGE_FRACTION,                      0.01 ); if( randomize && BUGGIFY ) QUEUING_METRICS_CHANGE_FRACTION = 0.2;
+	init( QUEUING_METRICS_CHECK_INTERVAL,                       0.02 );
 	init (RATEKEEPER_DEFAULT_LIMIT,                              1e6 ); if( randomize && BUGGIFY ) RATEKEEPER_DEFAULT_LIMIT = 0;
 
 	bool smallStorageTarget = randomize && BUGGIFY;
@@ -503,9 +566,14 @@ void ServerKnobs::initialize(bool randomize, ClientKnobs* clientKnobs, bool isSi
 	init( TLOG_SPILL_THRESHOLD,                               1500e6 ); if( smallTlogTarget ) TLOG_SPILL_THRESHOLD = 1500e3; if( randomize && BUGGIFY ) TLOG_SPILL_THRESHOLD = 0;
 	init( REFERENCE_SPILL_UPDATE_STORAGE_BYTE_LIMIT,            20e6 ); if( (randomize && BUGGIFY) || smallTlogTarget ) REFERENCE_SPILL_UPDATE_STORAGE_BYTE_LIMIT = 1e6;
 	init( TLOG_HARD_LIMIT_BYTES,                              3000e6 ); if( smallTlogTarget ) TLOG_HARD_LIMIT_BYTES = 30e6;
+	init( TLOG_SPILL_RESIDENT_LAG_VERSIONS,  10 * VERSIONS_PER_SECOND ); if( randomize && BUGGIFY ) TLOG_SPILL_RESIDENT_LAG_VERSIONS = deterministicRandom()->coinflip() ? 0 : VERSIONS_PER_SECOND;
+	init( TLOG_SPILL_RESIDENT_EXTRA_BYTES,                     500e6 ); if( smallTlogTarget ) TLOG_SPILL_RESIDENT_EXTRA_BYTES = 500e3;
 	init( TLOG_RECOVER_MEMORY_LIMIT, TARGET_BYTES_PER_TLOG + SPRING_BYTES_TLOG );
 
 	init( MAX_TRANSACTIONS_PER_BYTE,                            1000 );
+	init( RATEKEEPER_PREDICTIVE_STORAGE_QUEUE,                 false ); if( randomize && BUGGIFY ) RATEKEEPER_PREDICTIVE_STORAGE_QUEUE = true; // Control on where storage queues are heading rather than where they are
+	init( RATEKEEPER_PREDICTION_SECONDS,                         2.0 ); if( randomize && BUGGIFY ) RATEKEEPER_PREDICTION_SECONDS = deterministicRandom()->random01() * 10;
+	init( STORAGE_ENGINE_DEBT_TARGET,                            0.5 ); if( randomize && BUGGIFY ) STORAGE_ENGINE_DEBT_TARGET = deterministicRandom()->random01() * 0.9;
 
 	init( MIN_AVAILABLE_SPACE,                                   1e8 );
 	init( MIN_AVAILABLE_SPACE_RATIO,                            0.05 );
@@ -520,6 +588,10 @@ void ServerKnobs::initialize(bool randomize, ClientKnobs* clientKnobs, bool isSi
 	init( NEEDED_TPS_HISTORY_SAMPLES,                            200 );
 	init( TARGET_DURABILITY_LAG_VERSIONS,                      350e6 ); // Should be larger than STORAGE_DURABILITY_LAG_SOFT_MAX
 	init( AUTO_TAG_THROTTLE_DURABILITY_LAG_VERSIONS,           250e6 );
+	init( AUTO_TAG_THROTTLE_READ_LOAD,                         false ); if( randomize && BUGGIFY ) AUTO_TAG_THROTTLE_READ_LOAD = true; // Also throttle busy read tags on servers saturated by reads
+	init( AUTO_TAG_THROTTLE_STORAGE_CPU_PERCENT,                90.0 );
+	init( AUTO_TAG_THROTTLE_SLOW_READ_LATENCY,                  0.05 ); if( randomize && BUGGIFY ) AUTO_TAG_THROTTLE_SLOW_READ_LATENCY = 0.005;
+	init( AUTO_TAG_THROTTLE_SLOW_READ_FRACTION,                  0.1 );
 	init( TARGET_DURABILITY_LAG_VERSIONS_BATCH,                250e6 ); // Should be larger than STORAGE_DURABILITY_LAG_SOFT_MAX
 	init( DURABILITY_LAG_UNLIMITED_THRESHOLD,                   50e6 );
 	init( INITIAL_DURABILITY_LAG_MULTIPLIER,                    1.02 );
@@ -549,6 +621,11 @@ void ServerKnobs::initialize(bool randomize, ClientKnobs* clientKnobs, bool isSi
 	init( READ_HOT_SUB_RANGE_CHUNK_SIZE,                        10000000); // 10MB
 	init( EMPTY_READ_PENALTY,                                   20 ); // 20 bytes
 	init( READ_SAMPLING_ENABLED,                                false ); if ( randomize && BUGGIFY ) READ_SAMPLING_ENABLED = true;// enable/disable read sampling
+	init( STORAGE_HOT_KEY_SAMPLING,                             false ); if ( randomize && BUGGIFY ) STORAGE_HOT_KEY_SAMPLING = true; // Track the most read and written keys on each storage server
+	init( STORAGE_HOT_KEY_SAMPLE_RATE,                           0.01 ); if ( randomize && BUGGIFY ) STORAGE_HOT_KEY_SAMPLE_RATE = 1.0; // Fraction of reads and writes fed to the hot key sample
+	init( STORAGE_HOT_KEY_SAMPLE_CAPACITY,                        100 ); if ( randomize && BUGGIFY ) STORAGE_HOT_KEY_SAMPLE_CAPACITY = 2; // Keys counted by each of the read and write samples
+	init( STORAGE_HOT_KEY_SAMPLE_INTERVAL,                       10.0 ); // Seconds of samples that hot key rates are measured over
+	init( STORAGE_HOT_KEY_STATUS_COUNT,                             5 ); // Hot read and write keys reported in status per storage server
 
 	//Storage Server
 	init( STORAGE_LOGGING_DELAY,                                 5.0 );
@@ -559,11 +636,24 @@ void ServerKnobs::initialize(bool randomize, ClientKnobs* clientKnobs, bool isSi
 	init( FETCH_BLOCK_BYTES,                                     2e6 );
 	init( FETCH_KEYS_PARALLELISM_BYTES,                          4e6 ); if( randomize && BUGGIFY ) FETCH_KEYS_PARALLELISM_BYTES = 3e6;
 	init( FETCH_KEYS_LOWER_PRIORITY,                               0 );
+	init( FETCH_KEYS_SPLIT_BYTES,                                  0 ); if( randomize && BUGGIFY ) FETCH_KEYS_SPLIT_BYTES = deterministicRandom()->randomInt(1000, 100000); // A moving shard is split into pieces of about this size that are fetched in parallel; 0 disables
+	init( FETCH_KEYS_SPLIT_TIMEOUT,                              5.0 ); // Shards whose split points take longer than this to get are fetched whole
+	init( RANGESTREAM_PAGE_BYTES,                                1e6 ); if( randomize && BUGGIFY ) RANGESTREAM_PAGE_BYTES = 1000;
+	init( RANGESTREAM_LIMIT_BYTES,                               4e6 ); if( randomize && BUGGIFY ) RANGESTREAM_LIMIT_BYTES = 1; // Bytes sent on a range stream but not yet consumed
+	init( RANGE_FILTER_SCAN_BYTES,                             1e7 ); if( randomize && BUGGIFY ) RANGE_FILTER_SCAN_BYTES = 1000; // Bytes a filtered range read scans before replying with what matched so far
+	init( STORAGE_SKIP_KEYS_MIN_OFFSET,                          100 ); if( randomize && BUGGIFY ) STORAGE_SKIP_KEYS_MIN_OFFSET = 2; // Key selectors this far from their key are resolved by counting keys in the storage engine, if it can, rather than reading them
+	init( CHANGE_FEED_EMPTY_REPLY_INTERVAL,                      0.1 ); if( randomize && BUGGIFY ) CHANGE_FEED_EMPTY_REPLY_INTERVAL = 0.001;
 	init( BUGGIFY_BLOCK_BYTES,                                 10000 );
 	init( STORAGE_COMMIT_BYTES,                             10000000 ); if( randomize && BUGGIFY ) STORAGE_COMMIT_BYTES = 2000000;
 	init( STORAGE_DURABILITY_LAG_REJECT_THRESHOLD,              0.25 );
 	init( STORAGE_DURABILITY_LAG_MIN_RATE,                       0.1 );
 	init( STORAGE_COMMIT_INTERVAL,                               0.5 ); if( randomize && BUGGIFY ) STORAGE_COMMIT_INTERVAL = 2.0;
+	init( STORAGE_SNAPSHOT_INTERVAL_VERSIONS,                      0 ); if( randomize && BUGGIFY ) STORAGE_SNAPSHOT_INTERVAL_VERSIONS = 2 * VERSIONS_PER_SECOND;
+	init( STORAGE_SNAPSHOT_RETENTION_VERSIONS,   600 * VERSIONS_PER_SECOND ); if( randomize && BUGGIFY ) STORAGE_SNAPSHOT_RETENTION_VERSIONS = 20 * VERSIONS_PER_SECOND;
+	init( STORAGE_COMMIT_PIPELINE_DEPTH,                           1 ); if( randomize && BUGGIFY ) STORAGE_COMMIT_PIPELINE_DEPTH = deterministicRandom()->randomInt(2, 5); // Storage engine commits that may be outstanding while the next batch is written
+	init( STORAGE_READ_CACHE_BYTES,                                0 ); if( randomize && BUGGIFY ) STORAGE_READ_CACHE_BYTES = deterministicRandom()->randomInt(0, 100000); // Values read from the storage engine are cached up to this size; 0 disables
+	init( STORAGE_READ_SCHEDULER_PARALLELISM,                      0 ); if( randomize && BUGGIFY ) STORAGE_READ_SCHEDULER_PARALLELISM = deterministicRandom()->randomInt(1, 20); // Reads served at once before the rest queue by tag; 0 disables
+	init( STORAGE_READ_TAG_QUEUE_LIMIT,                         1000 ); if( randomize && BUGGIFY ) STORAGE_READ_TAG_QUEUE_LIMIT = deterministicRandom()->randomInt(10, 100); // Reads queued for one tag beyond which more are rejected
 	init( UPDATE_SHARD_VERSION_INTERVAL,                        0.25 ); if( randomize && BUGGIFY ) UPDATE_SHARD_VERSION_INTERVAL = 1.0;
 	init( BYTE_SAMPLING_FACTOR,                                  250 ); //cannot buggify because of differences in restarting tests
 	init( BYTE_SAMPLING_OVERHEAD,                                100 );
@@ -573,6 +663,7 @@ void ServerKnobs::initialize(bool randomize, ClientKnobs* clientKnobs, bool isSi
 	init( BYTE_SAMPLE_LOAD_PARALLELISM,                            8 ); if( randomize && BUGGIFY ) BYTE_SAMPLE_LOAD_PARALLELISM = 1;
 	init( BYTE_SAMPLE_LOAD_DELAY,                                0.0 ); if( randomize && BUGGIFY ) BYTE_SAMPLE_LOAD_DELAY = 0.1;
 	init( BYTE_SAMPLE_START_DELAY,                               1.0 ); if( randomize && BUGGIFY ) BYTE_SAMPLE_START_DELAY = 0.0;
+	init( BYTE_SAMPLE_LOAD_WITH_RESTORE,                       false ); if( randomize && BUGGIFY ) BYTE_SAMPLE_LOAD_WITH_RESTORE = true; // Load the byte sample while the shard state is restored, instead of BYTE_SAMPLE_START_DELAY after
 	init( UPDATE_STORAGE_PROCESS_STATS_INTERVAL,                 5.0 );
 	init( BEHIND_CHECK_DELAY,                                    2.0 );
 	init( BEHIND_CHECK_COUNT,                                      2 );
@@ -616,6 +707,8 @@ void ServerKnobs::initialize(bool randomize, ClientKnobs* clientKnobs, bool isSi
 	// Status
 	init( STATUS_MIN_TIME_BETWEEN_REQUESTS,                      0.0 );
 	init( MAX_STATUS_REQUESTS_PER_SECOND,                      256.0 );
+	init( STATUS_CACHE_MAX_AGE,                                  1.0 ); if( randomize && BUGGIFY ) STATUS_CACHE_MAX_AGE = deterministicRandom()->coinflip() ? 0.0 : 5.0;
+	init( STATUS_CACHE_IDLE_TIMEOUT,                            30.0 );
 	init( CONFIGURATION_ROWS_TO_FETCH,                         20000 );
 	init( DISABLE_DUPLICATE_LOG_WARNING,                       false );
 	init( HISTOGRAM_REPORT_INTERVAL,                           300.0 );
@@ -657,6 +750,7 @@ void ServerKnobs::initialize(bool randomize, ClientKnobs* clientKnobs, bool isSi
 	init( FASTRESTORE_HEARTBEAT_MAX_DELAY,                        10 ); if( randomize && BUGGIFY ) { FASTRESTORE_HEARTBEAT_MAX_DELAY = FASTRESTORE_HEARTBEAT_DELAY * 10; }
 	init( FASTRESTORE_APPLIER_FETCH_KEYS_SIZE,                   100 ); if( randomize && BUGGIFY ) { FASTRESTORE_APPLIER_FETCH_KEYS_SIZE = deterministicRandom()->random01() * 10240 + 1; }
 	init( FASTRESTORE_LOADER_SEND_MUTATION_MSG_BYTES, 1.0 * 1024.0 * 1024.0 ); if( randomize && BUGGIFY ) { FASTRESTORE_LOADER_SEND_MUTATION_MSG_BYTES = deterministicRandom()->random01() < 0.2 ? 1024 : deterministicRandom()->random01() * 5.0 * 1024.0 * 1024.0 + 1; }
+	init( FASTRESTORE_LOADER_SEND_INFLIGHT_MSGS,                 10 ); if( randomize && BUGGIFY ) { FASTRESTORE_LOADER_SEND_INFLIGHT_MSGS = deterministicRandom()->random01() < 0.2 ? 1 : deterministicRandom()->random01() * 20 + 1; }
 	init( FASTRESTORE_GET_RANGE_VERSIONS_EXPENSIVE,            false ); if( randomize && BUGGIFY ) { FASTRESTORE_GET_RANGE_VERSIONS_EXPENSIVE = deterministicRandom()->random01() < 0.5 ? true : false; }
 	init( FASTRESTORE_REQBATCH_PARALLEL,                          50 ); if( randomize && BUGGIFY ) { FASTRESTORE_REQBATCH_PARALLEL = deterministicRandom()->random01() * 100 + 1; }
 	init( FASTRESTORE_REQBATCH_LOG,                            false ); if( randomize && BUGGIFY ) { FASTRESTORE_REQBATCH_LOG = deterministicRandom()->random01() < 0.2 ? true : false; }
@@ -679,16 +773,29 @@ void ServerKnobs::initialize(bool randomize, ClientKnobs* clientKnobs, bool isSi
 	init( FASTRESTORE_EXPENSIVE_VALIDATION,                    false ); if( randomize && BUGGIFY ) { FASTRESTORE_EXPENSIVE_VALIDATION = deterministicRandom()->random01() < 0.5 ? true : false;}
 	init( FASTRESTORE_WRITE_BW_MB,                                70 ); if( randomize && BUGGIFY ) { FASTRESTORE_WRITE_BW_MB = deterministicRandom()->random01() < 0.5 ? 2 : 100;}
 	init( FASTRESTORE_RATE_UPDATE_SECONDS,                       1.0 ); if( randomize && BUGGIFY ) { FASTRESTORE_RATE_UPDATE_SECONDS = deterministicRandom()->random01() < 0.5 ? 0.1 : 2;}
+	init( FASTRESTORE_LOADER_DECODE_THREADS,                       4 );
 
 	init( REDWOOD_DEFAULT_PAGE_SIZE,                            4096 );
 	init( REDWOOD_KVSTORE_CONCURRENT_READS,                       64 );
 	init( REDWOOD_COMMIT_CONCURRENT_READS,                        64 );
+	init( REDWOOD_COMMIT_BUILD_THREADS,                            0 ); // Threads that build and compress pages during commits; 0 builds them on the main thread
 	init( REDWOOD_PAGE_REBUILD_FILL_FACTOR,                     0.66 );
+	init( REDWOOD_PAGE_CACHE_PROTECTED_FRACTION,                 0.8 ); if( randomize && BUGGIFY ) REDWOOD_PAGE_CACHE_PROTECTED_FRACTION = deterministicRandom()->random01(); // Of the page cache, that pages hit more than once may occupy
+	init( REDWOOD_SCAN_NO_HIT_LEAVES,                             16 ); if( randomize && BUGGIFY ) REDWOOD_SCAN_NO_HIT_LEAVES = deterministicRandom()->randomInt(1, 4);
+	init( REDWOOD_SCAN_READ_AHEAD_LEAVES,                          8 ); if( randomize && BUGGIFY ) REDWOOD_SCAN_READ_AHEAD_LEAVES = deterministicRandom()->randomInt(0, 3);
+	init( REDWOOD_SEARCH_INDEX_SEEKS,                             16 ); if( randomize && BUGGIFY ) REDWOOD_SEARCH_INDEX_SEEKS = deterministicRandom()->randomInt(0, 3);
+	init( REDWOOD_LEAF_FILTER_LOOKUPS,                             4 ); if( randomize && BUGGIFY ) REDWOOD_LEAF_FILTER_LOOKUPS = deterministicRandom()->randomInt(0, 3);
+	init( REDWOOD_LEAF_FILTER_BITS_PER_KEY,                       10 ); if( randomize && BUGGIFY ) REDWOOD_LEAF_FILTER_BITS_PER_KEY = deterministicRandom()->randomInt(1, 4);
+	init( REDWOOD_PAGE_COMPRESSION_BLOCKS,                         0 ); if( randomize && BUGGIFY ) REDWOOD_PAGE_COMPRESSION_BLOCKS = deterministicRandom()->randomInt(2, 5); // Leaf pages are built this many blocks large and stored compressed, if above 1
+	init( REDWOOD_PAGE_COMPRESSION_LEVEL,                          1 );
+	init( REDWOOD_SPLIT_BOUNDARY_SEARCH_FRACTION,               0.05 ); if( randomize && BUGGIFY ) REDWOOD_SPLIT_BOUNDARY_SEARCH_FRACTION = deterministicRandom()->random01() * 0.5; // Of a page, that a page split may give up to find a shorter boundary key
+	init( REDWOOD_OUT_OF_LINE_VALUE_SIZE,                          0 ); if( randomize && BUGGIFY ) REDWOOD_OUT_OF_LINE_VALUE_SIZE = deterministicRandom()->randomInt(100, 10000);
 	init( REDWOOD_LAZY_CLEAR_BATCH_SIZE_PAGES,                    10 );
 	init( REDWOOD_LAZY_CLEAR_MIN_PAGES,                            0 );
 	init( REDWOOD_LAZY_CLEAR_MAX_PAGES,                          1e6 );
 	init( REDWOOD_REMAP_CLEANUP_WINDOW,                           50 );
 	init( REDWOOD_REMAP_CLEANUP_LAG,                             0.1 );
+	init( REDWOOD_REMAP_CLEANUP_BATCH_SIZE,                      100 ); if( randomize && BUGGIFY ) REDWOOD_REMAP_CLEANUP_BATCH_SIZE = deterministicRandom()->randomInt(1, 10);
 	init( REDWOOD_LOGGING_INTERVAL,                              5.0 );
 
 	// Server request latency measurement
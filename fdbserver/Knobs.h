@@ -62,6 +62,7 @@ public:
 	int LEGACY_TLOG_UPGRADE_ENTRIES_PER_VERSION;
 	int VERSION_MESSAGES_OVERHEAD_FACTOR_1024THS; // Multiplicative factor to bound total space used to store a version message (measured in 1/1024ths, e.g. a value of 2048 yields a factor of 2).
 	int64_t VERSION_MESSAGES_ENTRY_BYTES_WITH_OVERHEAD;
+	int64_t TAG_MESSAGE_INDEX_ENTRY_BYTES_WITH_OVERHEAD;
 	double TLOG_MESSAGE_BLOCK_OVERHEAD_FACTOR;
 	int64_t TLOG_MESSAGE_BLOCK_BYTES;
 	int64_t MAX_MESSAGE_SIZE;
@@ -70,6 +71,8 @@ public:
 	int PARALLEL_GET_MORE_REQUESTS;
 	int MULTI_CURSOR_PRE_FETCH_LIMIT;
 	int64_t MAX_QUEUE_COMMIT_BYTES;
+	double TLOG_GROUP_COMMIT_DELAY_FRACTION;
+	double TLOG_MAX_GROUP_COMMIT_DELAY;
 	int DESIRED_OUTSTANDING_MESSAGES;
 	double DESIRED_GET_MORE_DELAY;
 	int CONCURRENT_LOG_ROUTER_READS;
@@ -77,11 +80,15 @@ public:
 	double DISK_QUEUE_ADAPTER_MIN_SWITCH_TIME;
 	double DISK_QUEUE_ADAPTER_MAX_SWITCH_TIME;
 	int64_t TLOG_SPILL_REFERENCE_MAX_PEEK_MEMORY_BYTES;
+	int64_t TLOG_SPILLED_PEEK_CACHE_BYTES;
 	int64_t TLOG_SPILL_REFERENCE_MAX_BATCHES_PER_PEEK;
 	int64_t TLOG_SPILL_REFERENCE_MAX_BYTES_PER_BATCH;
+	int64_t TLOG_SPILL_REFERENCE_MAX_READ_GAP_BYTES; // Spilled commits of a tag at most this far apart are read as one range by a peek
 	int64_t DISK_QUEUE_FILE_EXTENSION_BYTES; // When we grow the disk queue, by how many bytes should it grow?
 	int64_t DISK_QUEUE_FILE_SHRINK_BYTES; // When we shrink the disk queue, by how many bytes should it shrink?
 	int DISK_QUEUE_MAX_TRUNCATE_BYTES;  // A truncate larger than this will cause the file to be replaced instead.
+	bool DISK_QUEUE_COALESCE_COMMITS; // Commits made while the previous one is being written are flushed together
+	int DISK_QUEUE_RECOVERY_READ_BYTES;
 	double TLOG_DEGRADED_DURATION;
 	int64_t MAX_CACHE_VERSIONS;
 	double TXS_POPPED_MAX_DELAY;
@@ -111,6 +118,10 @@ public:
 	int DD_QUEUE_MAX_KEY_SERVERS;
 	int DD_REBALANCE_PARALLELISM;
 	int DD_REBALANCE_RESET_AMOUNT;
+	bool DD_REBALANCE_LOAD_AWARE;
+	double DD_REBALANCE_READ_WEIGHT;
+	double DD_REBALANCE_WRITE_WEIGHT;
+	double DD_REBALANCE_LOAD_HYSTERESIS;
 	double BG_DD_MAX_WAIT;
 	double BG_DD_MIN_WAIT;
 	double BG_DD_INCREASE_RATE;
@@ -152,7 +163,14 @@ public:
 	double SHARD_MAX_READ_DENSITY_RATIO;
 	int64_t SHARD_READ_HOT_BANDWITH_MIN_PER_KSECONDS;
 	double SHARD_MAX_BYTES_READ_PER_KSEC_JITTER;
+	bool STORAGE_CACHE_AUTO_ADMIT;
+	int64_t STORAGE_CACHE_AUTO_MAX_BYTES;
+	int STORAGE_CACHE_ADMIT_HITS;
+	double STORAGE_CACHE_HEAT_HALF_LIFE;
+	double STORAGE_CACHE_IDLE_TIMEOUT;
+	double STORAGE_CACHE_EVICTION_INTERVAL;
 	double STORAGE_METRIC_TIMEOUT;
+	double SHARD_METRICS_STREAM_DELAY; // Shard metrics watches that fire within this long of each other are reported together
 	double METRIC_DELAY;
 	double ALL_DATA_REMOVED_DELAY;
 	double INITIAL_FAILURE_REACTION_DELAY;
@@ -178,6 +196,7 @@ public:
 	int64_t DD_SHARD_SIZE_GRANULARITY_SIM;
 	int DD_MOVE_KEYS_PARALLELISM;
 	int DD_FETCH_SOURCE_PARALLELISM;
+	int DD_MERGE_ADJACENT_RELOCATIONS; // Up to this many queued relocations of adjacent shards off the same servers, for the same health reason, launch as one
 	int DD_MERGE_LIMIT;
 	double DD_SHARD_METRICS_TIMEOUT;
 	int64_t DD_LOCATION_CACHE_SIZE;
@@ -233,6 +252,8 @@ public:
 	int SQLITE_FRAGMENT_PRIMARY_PAGE_USABLE;
 	int SQLITE_FRAGMENT_OVERFLOW_PAGE_USABLE;
 	double SQLITE_FRAGMENT_MIN_SAVINGS;
+	int SQLITE_CURSOR_PREFETCH_PAGES;
+	int SQLITE_PREFETCH_MAX_READS;
 	int SQLITE_CHUNK_SIZE_PAGES;
 	int SQLITE_CHUNK_SIZE_PAGES_SIM;
 
@@ -248,6 +269,10 @@ public:
 	int SPRING_CLEANING_LAZY_DELETE_BATCH_SIZE;
 	int SPRING_CLEANING_MIN_VACUUM_PAGES;
 	int SPRING_CLEANING_MAX_VACUUM_PAGES;
+	double SPRING_CLEANING_PAGES_PER_SECOND; // Rate of the token bucket limiting spring cleaning pages; 0 disables the limit
+	int SPRING_CLEANING_PAGE_BURST; // Capacity of the spring cleaning token bucket, in pages
+	int SPRING_CLEANING_BUSY_WRITE_QUEUE; // Queued writer thread actions above which the bucket fills more slowly
+	double SPRING_CLEANING_BUSY_RATE_FRACTION; // Of SPRING_CLEANING_PAGES_PER_SECOND, used while the writer thread is busy
 
 	// KeyValueStoreMemory
 	int64_t REPLACE_CONTENTS_BYTES;
@@ -255,9 +280,15 @@ public:
 	// KeyValueStoreRocksDB
 	int ROCKSDB_BACKGROUND_PARALLELISM;
 	int ROCKSDB_READ_PARALLELISM;
+	bool ROCKSDB_READ_WORK_STEALING;
 	int64_t ROCKSDB_MEMTABLE_BYTES;
 	bool ROCKSDB_UNSAFE_AUTO_FSYNC;
 	int64_t ROCKSDB_PERIODIC_COMPACTION_SECONDS;
+	int ROCKSDB_READ_VALUE_BATCH_SIZE;
+	int64_t ROCKSDB_READ_RANGE_READAHEAD_BYTES;
+	bool ROCKSDB_BULK_LOAD;
+	bool ROCKSDB_SHARD_COLUMN_FAMILIES;
+	int64_t ROCKSDB_BACKGROUND_BYTES_PER_SECOND;
 
 	// Leader election
 	int MAX_NOTIFICATIONS;
@@ -280,6 +311,8 @@ public:
 	double START_TRANSACTION_RATE_WINDOW;
 	double START_TRANSACTION_MAX_EMPTY_QUEUE_BUDGET;
 	int START_TRANSACTION_MAX_QUEUE_SIZE;
+	bool START_TRANSACTION_ENFORCE_TAG_THROTTLES;
+	double START_TRANSACTION_TAG_THROTTLE_BURST;
 	int KEY_LOCATION_MAX_QUEUE_SIZE;
 
 	double COMMIT_TRANSACTION_BATCH_INTERVAL_FROM_IDLE;
@@ -292,11 +325,18 @@ public:
 	int    COMMIT_TRANSACTION_BATCH_BYTES_MAX;
 	double COMMIT_TRANSACTION_BATCH_BYTES_SCALE_BASE;
 	double COMMIT_TRANSACTION_BATCH_BYTES_SCALE_POWER;
+	double COMMIT_BATCH_LATENCY_TARGET;
+	double COMMIT_BATCH_CONTROL_INTERVAL;
+	double COMMIT_BATCH_CONTROL_INCREASE;
+	double COMMIT_BATCH_CONTROL_BACKOFF;
 	int64_t COMMIT_BATCHES_MEM_BYTES_HARD_LIMIT;
 	double COMMIT_BATCHES_MEM_FRACTION_OF_TOTAL;
 	double COMMIT_BATCHES_MEM_TO_TOTAL_MEM_SCALE_FACTOR;
 
 	double RESOLVER_COALESCE_TIME;
+	bool PROXY_COALESCE_ATOMIC_OPS; // Merge runs of the same atomic op on the same key within a commit batch into one mutation
+	double PROXY_CONFLICT_HOTSPOT_HALF_LIFE;
+	int PROXY_CONFLICT_HOTSPOT_MAX_RANGES;
 	int BUGGIFIED_ROW_LIMIT;
 	double PROXY_SPIN_DELAY;
 	double UPDATE_REMOTE_LOG_VERSION_INTERVAL;
@@ -311,8 +351,12 @@ public:
 	int PROXY_COMPUTE_BUCKETS;
 	double PROXY_COMPUTE_GROWTH_RATE;
 	int TXN_STATE_SEND_AMOUNT;
+	bool TXN_STATE_COMPRESSION;
 	double REPORT_TRANSACTION_COST_ESTIMATION_DELAY;
 	bool PROXY_REJECT_BATCH_QUEUED_TOO_LONG;
+	bool PROXY_PIPELINE_COMMIT_VERSION_REQUESTS;
+	double COMMIT_VERSION_LEASE_MAX_DURATION; // The longest the master leases a commit proxy a range of versions to assign itself; 0 disables leases
+	int COMMIT_VERSION_LEASE_BATCHES; // A lease lasts for about this many of the proxy's recent commit batches
 
 	int RESET_MASTER_BATCHES;
 	int RESET_RESOLVER_BATCHES;
@@ -339,6 +383,16 @@ public:
 	double SAMPLE_EXPIRATION_TIME;
 	double SAMPLE_POLL_TIME;
 	int64_t RESOLVER_STATE_MEMORY_LIMIT;
+	int RESOLVER_PARTITIONS;
+	double RESOLVER_REPARTITION_INTERVAL;
+	double RESOLVER_REPARTITION_IMBALANCE;
+	bool RESOLVER_ART_CONFLICT_SET;
+	bool RESOLVER_BACKGROUND_PRUNE;
+	double RESOLVER_PRUNE_INTERVAL;
+	double RESOLVER_PRUNE_SLICE_TIME;
+	int RESOLVER_PRUNE_NODES;
+	std::string RESOLVER_CAPTURE_FILE;
+	int64_t RESOLVER_CAPTURE_MAX_BYTES;
 
 	// Backup Worker
 	double BACKUP_TIMEOUT;  // master's reaction time for backup failure
@@ -346,6 +400,8 @@ public:
 	int BACKUP_FILE_BLOCK_BYTES;
 	int64_t BACKUP_LOCK_BYTES;
 	double BACKUP_UPLOAD_DELAY;
+	bool BACKUP_WORKER_LOG_COMPRESSION; // Write zlib compressed mutation log blocks, which older versions cannot restore
+	bool BACKUP_COMPACT_MUTATION_LOG; // Commit proxies write backup and DR mutation logs with varint lengths and shared key prefixes, which older agents cannot read
 
 	//Cluster Controller
 	double CLUSTER_CONTROLLER_LOGGING_DELAY;
@@ -373,6 +429,7 @@ public:
 	double REPLACE_INTERFACE_CHECK_DELAY;
 	double COORDINATOR_REGISTER_INTERVAL;
 	double CLIENT_REGISTER_INTERVAL;
+	double COORDINATOR_LONG_POLL_CHECK_INTERVAL;
 
 	// Knobs used to select the best policy (via monte carlo)
 	int POLICY_RATING_TESTS;	// number of tests per policy (in order to compare)
@@ -387,6 +444,7 @@ public:
 	double RECRUITMENT_TIMEOUT;
 	int DBINFO_SEND_AMOUNT;
 	double DBINFO_BATCH_DELAY;
+	bool DBINFO_SEND_DELTAS;
 
 	//Move Keys
 	double SHARD_READY_DELAY;
@@ -409,6 +467,9 @@ public:
 	double SLOW_SMOOTHING_AMOUNT;
 	double METRIC_UPDATE_RATE;
 	double DETAILED_METRIC_UPDATE_RATE;
+	double QUEUING_METRICS_HEARTBEAT; // Longest a storage server or TLog holds ratekeeper's request for its queue
+	double QUEUING_METRICS_CHANGE_FRACTION; // Of the queue and durability lag targets, the change that is reported at once
+	double QUEUING_METRICS_CHECK_INTERVAL;
 	double LAST_LIMITED_RATIO;
 	double RATEKEEPER_DEFAULT_LIMIT;
 
@@ -424,6 +485,8 @@ public:
 	int64_t SPRING_BYTES_TLOG_BATCH;
 	int64_t TLOG_SPILL_THRESHOLD;
 	int64_t TLOG_HARD_LIMIT_BYTES;
+	int64_t TLOG_SPILL_RESIDENT_LAG_VERSIONS; // Tags popped within this many versions of the tLog's version are caught up; 0 disables
+	int64_t TLOG_SPILL_RESIDENT_EXTRA_BYTES; // Bytes above TLOG_SPILL_THRESHOLD a tLog may hold to keep caught-up tags resident
 	int64_t TLOG_RECOVER_MEMORY_LIMIT;
 	double TLOG_IGNORE_POP_AUTO_ENABLE_DELAY;
 
@@ -441,6 +504,9 @@ public:
 	bool AUTO_TAG_THROTTLING_ENABLED;
 
 	double MAX_TRANSACTIONS_PER_BYTE;
+	bool RATEKEEPER_PREDICTIVE_STORAGE_QUEUE;
+	double RATEKEEPER_PREDICTION_SECONDS;
+	double STORAGE_ENGINE_DEBT_TARGET; // Of the way to a storage engine write stall, past which commits are slowed down
 
 	int64_t MIN_AVAILABLE_SPACE;
 	double MIN_AVAILABLE_SPACE_RATIO;
@@ -455,6 +521,10 @@ public:
 	int NEEDED_TPS_HISTORY_SAMPLES;
 	int64_t TARGET_DURABILITY_LAG_VERSIONS;
 	int64_t AUTO_TAG_THROTTLE_DURABILITY_LAG_VERSIONS;
+	bool AUTO_TAG_THROTTLE_READ_LOAD;
+	double AUTO_TAG_THROTTLE_STORAGE_CPU_PERCENT;
+	double AUTO_TAG_THROTTLE_SLOW_READ_LATENCY;
+	double AUTO_TAG_THROTTLE_SLOW_READ_FRACTION;
 	int64_t TARGET_DURABILITY_LAG_VERSIONS_BATCH;
 	int64_t DURABILITY_LAG_UNLIMITED_THRESHOLD;
 	double INITIAL_DURABILITY_LAG_MULTIPLIER;
@@ -476,6 +546,11 @@ public:
 	int64_t READ_HOT_SUB_RANGE_CHUNK_SIZE;
 	int64_t EMPTY_READ_PENALTY;
 	bool READ_SAMPLING_ENABLED;
+	bool STORAGE_HOT_KEY_SAMPLING;
+	double STORAGE_HOT_KEY_SAMPLE_RATE;
+	int STORAGE_HOT_KEY_SAMPLE_CAPACITY;
+	double STORAGE_HOT_KEY_SAMPLE_INTERVAL;
+	int STORAGE_HOT_KEY_STATUS_COUNT;
 
 	//Storage Server
 	double STORAGE_LOGGING_DELAY;
@@ -486,6 +561,13 @@ public:
 	int FETCH_BLOCK_BYTES;
 	int FETCH_KEYS_PARALLELISM_BYTES;
 	int FETCH_KEYS_LOWER_PRIORITY;
+	int64_t FETCH_KEYS_SPLIT_BYTES;
+	double FETCH_KEYS_SPLIT_TIMEOUT;
+	int RANGESTREAM_PAGE_BYTES;
+	int RANGESTREAM_LIMIT_BYTES;
+	int RANGE_FILTER_SCAN_BYTES;
+	int STORAGE_SKIP_KEYS_MIN_OFFSET;
+	double CHANGE_FEED_EMPTY_REPLY_INTERVAL; // A change feed of an idle range reports its progress this often
 	int BUGGIFY_BLOCK_BYTES;
 	int64_t STORAGE_HARD_LIMIT_BYTES;
 	int64_t STORAGE_DURABILITY_LAG_HARD_MAX;
@@ -494,6 +576,12 @@ public:
 	double STORAGE_DURABILITY_LAG_MIN_RATE;
 	int STORAGE_COMMIT_BYTES;
 	double STORAGE_COMMIT_INTERVAL;
+	int STORAGE_COMMIT_PIPELINE_DEPTH;
+	int64_t STORAGE_SNAPSHOT_INTERVAL_VERSIONS; // On engines that can retain snapshots, every multiple of this version is made durable as a snapshot that range reads older than the MVCC window can use; 0 disables
+	int64_t STORAGE_SNAPSHOT_RETENTION_VERSIONS; // How far behind the durable version such snapshots are kept
+	int64_t STORAGE_READ_CACHE_BYTES;
+	int STORAGE_READ_SCHEDULER_PARALLELISM;
+	int STORAGE_READ_TAG_QUEUE_LIMIT;
 	double UPDATE_SHARD_VERSION_INTERVAL;
 	int BYTE_SAMPLING_FACTOR;
 	int BYTE_SAMPLING_OVERHEAD;
@@ -503,6 +591,7 @@ public:
 	int BYTE_SAMPLE_LOAD_PARALLELISM;
 	double BYTE_SAMPLE_LOAD_DELAY;
 	double BYTE_SAMPLE_START_DELAY;
+	bool BYTE_SAMPLE_LOAD_WITH_RESTORE;
 	double UPDATE_STORAGE_PROCESS_STATS_INTERVAL;
 	double BEHIND_CHECK_DELAY;
 	int BEHIND_CHECK_COUNT;
@@ -546,6 +635,8 @@ public:
 	// Status
 	double STATUS_MIN_TIME_BETWEEN_REQUESTS;
 	double MAX_STATUS_REQUESTS_PER_SECOND;
+	double STATUS_CACHE_MAX_AGE; // Status requests are answered with a status computed at most this long ago; 0 disables the cache
+	double STATUS_CACHE_IDLE_TIMEOUT; // The cached status is kept fresh while there have been requests within this long
 	int CONFIGURATION_ROWS_TO_FETCH;
 	bool DISABLE_DUPLICATE_LOG_WARNING;
 	double HISTOGRAM_REPORT_INTERVAL;
@@ -591,6 +682,7 @@ public:
 	int64_t FASTRESTORE_HEARTBEAT_MAX_DELAY; // master claim a node is down if no heart beat from the node for this delay
 	int64_t FASTRESTORE_APPLIER_FETCH_KEYS_SIZE; // number of keys to fetch in a txn on applier
 	int64_t FASTRESTORE_LOADER_SEND_MUTATION_MSG_BYTES; // desired size of mutation message sent from loader to appliers
+	int FASTRESTORE_LOADER_SEND_INFLIGHT_MSGS; // max unacknowledged mutation messages a loader sends per restore asset
 	bool FASTRESTORE_GET_RANGE_VERSIONS_EXPENSIVE; // parse each range file to get (range, version) it has?
 	int64_t FASTRESTORE_REQBATCH_PARALLEL; // number of requests to wait on for getBatchReplies()
 	bool FASTRESTORE_REQBATCH_LOG; // verbose log information for getReplyBatches
@@ -613,16 +705,29 @@ public:
 	bool FASTRESTORE_EXPENSIVE_VALIDATION; // when set true, performance will be heavily affected
 	double FASTRESTORE_WRITE_BW_MB; // target aggregated write bandwidth from all appliers
 	double FASTRESTORE_RATE_UPDATE_SECONDS; // how long to update appliers target write rate
+	int FASTRESTORE_LOADER_DECODE_THREADS; // threads per loader that decode backup file blocks; 0 decodes on the network thread
 
 	int REDWOOD_DEFAULT_PAGE_SIZE;  // Page size for new Redwood files
 	int REDWOOD_KVSTORE_CONCURRENT_READS;  // Max number of simultaneous point or range reads in progress.
 	int REDWOOD_COMMIT_CONCURRENT_READS;   // Max number of concurrent reads done to support commit operations
+	int REDWOOD_COMMIT_BUILD_THREADS;
 	double REDWOOD_PAGE_REBUILD_FILL_FACTOR; // When rebuilding pages, start a new page after this capacity
+	int REDWOOD_PAGE_COMPRESSION_BLOCKS;
+	int REDWOOD_PAGE_COMPRESSION_LEVEL;
+	double REDWOOD_SPLIT_BOUNDARY_SEARCH_FRACTION;
+	int REDWOOD_OUT_OF_LINE_VALUE_SIZE; // Leaf values at least this large are written to pages of their own; 0 keeps every value in its leaf
+	double REDWOOD_PAGE_CACHE_PROTECTED_FRACTION;
+	int REDWOOD_SCAN_NO_HIT_LEAVES; // Leaf pages after which a range read stops promoting the pages it reads in the cache
+	int REDWOOD_SCAN_READ_AHEAD_LEAVES; // Leaf pages a range read reads ahead of itself once it moves past its first leaf
+	int REDWOOD_SEARCH_INDEX_SEEKS; // Seeks into a cached page after which it is indexed by key prefix for faster seeks; 0 disables
+	int REDWOOD_LEAF_FILTER_LOOKUPS; // Point lookups into a cached leaf page after which it gets a bloom filter of its keys; 0 disables
+	int REDWOOD_LEAF_FILTER_BITS_PER_KEY; // Size of a leaf page's bloom filter in bits per key it can hold
 	int REDWOOD_LAZY_CLEAR_BATCH_SIZE_PAGES; // Number of pages to try to pop from the lazy delete queue and process at once
 	int REDWOOD_LAZY_CLEAR_MIN_PAGES;  // Minimum number of pages to free before ending a lazy clear cycle, unless the queue is empty
 	int REDWOOD_LAZY_CLEAR_MAX_PAGES;  // Maximum number of pages to free before ending a lazy clear cycle, unless the queue is empty
 	int64_t REDWOOD_REMAP_CLEANUP_WINDOW;  // Remap remover lag interval in which to coalesce page writes
 	double REDWOOD_REMAP_CLEANUP_LAG; // Maximum allowed remap remover lag behind the cleanup window as a multiple of the window size
+	int REDWOOD_REMAP_CLEANUP_BATCH_SIZE; // Remap entries popped before their copies are started, sorted by destination page
 	double REDWOOD_LOGGING_INTERVAL;
 
 	// Server request latency measurement
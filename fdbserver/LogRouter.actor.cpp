@@ -42,20 +42,38 @@ struct LogRouterData {
 		Version durableKnownCommittedVersion;
 		Tag tag;
 
+		// The last peek reply built for this tag.  Messages below the router's version never change, so a peek from
+		// the same begin version (a retried or duplicated request, or a new remote tLog catching up) can reuse it
+		// instead of serializing the same messages again.
+		Version peekCacheBegin = invalidVersion;
+		Version peekCacheEnd = invalidVersion;
+		bool peekCacheFull = false; // The reply was cut at DESIRED_TOTAL_BYTES, so it is the same at any later version
+		Value peekCacheMessages;
+
 		TagData( Tag tag, Version popped, Version durableKnownCommittedVersion ) : tag(tag), popped(popped), durableKnownCommittedVersion(durableKnownCommittedVersion) {}
 
 		TagData(TagData&& r) noexcept
 		  : version_messages(std::move(r.version_messages)), tag(r.tag), popped(r.popped),
-		    durableKnownCommittedVersion(r.durableKnownCommittedVersion) {}
+		    durableKnownCommittedVersion(r.durableKnownCommittedVersion), peekCacheBegin(r.peekCacheBegin),
+		    peekCacheEnd(r.peekCacheEnd), peekCacheFull(r.peekCacheFull),
+		    peekCacheMessages(std::move(r.peekCacheMessages)) {}
 		void operator=(TagData&& r) noexcept {
 			version_messages = std::move(r.version_messages);
 			tag = r.tag;
 			popped = r.popped;
 			durableKnownCommittedVersion = r.durableKnownCommittedVersion;
+			peekCacheBegin = r.peekCacheBegin;
+			peekCacheEnd = r.peekCacheEnd;
+			peekCacheFull = r.peekCacheFull;
+			peekCacheMessages = std::move(r.peekCacheMessages);
 		}
 
 		// Erase messages not needed to update *from* versions >= before (thus, messages with toversion <= before)
 		ACTOR Future<Void> eraseMessagesBefore( TagData *self, Version before, LogRouterData *tlogData, TaskPriority taskID ) {
+			if (self->peekCacheBegin < before) {
+				self->peekCacheBegin = invalidVersion;
+				self->peekCacheMessages = Value();
+			}
 			while(!self->version_messages.empty() && self->version_messages.front().first < before) {
 				Version version = self->version_messages.front().first;
 				int64_t messagesErased = 0;
@@ -111,6 +129,7 @@ struct LogRouterData {
 	Counter getMoreCount; // Increase by 1 when LR tries to pull data from satellite tLog.
 	Counter
 	    getMoreBlockedCount; // Increase by 1 if data is not available when LR tries to pull data from satellite tLog.
+	Counter peekCacheHits; // Increase by 1 when a peek reply is reused rather than serialized again.
 	Future<Void> logger;
 	Reference<EventCacheHolder> eventCacheHolder;
 
@@ -136,7 +155,7 @@ struct LogRouterData {
 	    version(req.startVersion - 1), minPopped(0), generation(req.recoveryCount), startVersion(req.startVersion),
 	    allowPops(false), minKnownCommittedVersion(0), poppedVersion(0), foundEpochEnd(false),
 	    cc("LogRouter", dbgid.toString()), getMoreCount("GetMoreCount", cc),
-	    getMoreBlockedCount("GetMoreBlockedCount", cc),
+	    getMoreBlockedCount("GetMoreBlockedCount", cc), peekCacheHits("PeekCacheHits", cc),
 	    peekLatencyDist(Histogram::getHistogram(LiteralStringRef("LogRouter"), LiteralStringRef("PeekTLogLatency"),
 	                                            Histogram::Unit::microseconds)) {
 		//setup just enough of a logSet to be able to call getPushLocations
@@ -483,12 +502,27 @@ ACTOR Future<Void> logRouterPeekMessages( LogRouterData* self, TLogPeekRequest r
 	}
 
 	Version endVersion = self->version.get() + 1;
-	peekMessagesFromMemory( self, req, messages, endVersion );
-
 	TLogPeekReply reply;
+	auto tagData = self->getTagData(req.tag);
+	if (tagData && tagData->peekCacheBegin == req.begin &&
+	    (tagData->peekCacheFull || tagData->peekCacheEnd == endVersion)) {
+		++self->peekCacheHits;
+		endVersion = tagData->peekCacheEnd;
+		reply.arena.dependsOn(tagData->peekCacheMessages.arena());
+		reply.messages = tagData->peekCacheMessages;
+	} else {
+		peekMessagesFromMemory( self, req, messages, endVersion );
+		reply.messages = messages.toValue();
+		if (tagData) {
+			tagData->peekCacheBegin = req.begin;
+			tagData->peekCacheEnd = endVersion;
+			tagData->peekCacheFull = endVersion != self->version.get() + 1;
+			tagData->peekCacheMessages = messages.toValue();
+		}
+	}
+
 	reply.maxKnownVersion = self->version.get();
 	reply.minKnownCommittedVersion = self->poppedVersion;
-	reply.messages = messages.toValue();
 	reply.popped = self->minPopped.get() >= self->startVersion ? self->minPopped.get() : 0;
 	reply.end = endVersion;
 	reply.onlySpilled = false;
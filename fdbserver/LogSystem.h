@@ -878,12 +878,21 @@ struct LogPushData : NonCopyable {
 		}
 		uint32_t subseq = this->subsequence++;
 		uint32_t msgsize = rawMessageWithoutLength.size() + sizeof(subseq) + sizeof(uint16_t) + sizeof(Tag)*prev_tags.size();
+		// Serialize the message once, into the first location, and copy it to the others
+		int firstOffset = -1;
 		for(int loc : msg_locations) {
 			BinaryWriter& wr = messagesWriter[loc];
-			wr << msgsize << subseq << uint16_t(prev_tags.size());
-			for(auto& tag : prev_tags)
-				wr << tag;
-			wr.serializeBytes(rawMessageWithoutLength);
+			if (firstOffset == -1) {
+				firstOffset = wr.getLength();
+				wr.reserve(sizeof(msgsize) + msgsize);
+				wr << msgsize << subseq << uint16_t(prev_tags.size());
+				for(auto& tag : prev_tags)
+					wr << tag;
+				wr.serializeBytes(rawMessageWithoutLength);
+			} else {
+				BinaryWriter& from = messagesWriter[msg_locations[0]];
+				wr.serializeBytes((uint8_t*)from.getData() + firstOffset, sizeof(msgsize) + msgsize);
+			}
 		}
 	}
 
@@ -935,6 +944,7 @@ struct LogPushData : NonCopyable {
 
 			if (first) {
 				firstOffset = wr.getLength();
+				wr.reserve(sizeof(uint32_t) * 2 + sizeof(uint16_t) + sizeof(Tag) * prev_tags.size() + expectedSizeOf(item));
 				wr << uint32_t(0) << subseq << uint16_t(prev_tags.size());
 				for(auto& tag : prev_tags)
 					wr << tag;
@@ -992,6 +1002,13 @@ private:
 		*(uint32_t*)((uint8_t*)wr.getData() + offset) = length - sizeof(uint32_t);
 		return true;
 	}
+
+	// An upper bound on the serialized size of a typed message, or 0 if it is small and not worth reserving space for
+	static int expectedSizeOf(MutationRef const& m) { return sizeof(uint8_t) + 2 * sizeof(uint32_t) + m.expectedSize(); }
+	template <class T>
+	static int expectedSizeOf(T const&) {
+		return 0;
+	}
 };
 
 #endif
@@ -151,13 +151,18 @@ struct GetCommitVersionReply {
 	Version version;
 	Version prevVersion;
 	uint64_t requestNum;
+	// If leaseEnd > version, the proxy may assign its following batches versions up to leaseEnd itself for
+	// leaseDuration seconds, and must then hand the lease back
+	Version leaseEnd;
+	double leaseDuration;
 
-	GetCommitVersionReply() : resolverChangesVersion(0), version(0), prevVersion(0), requestNum(0) {}
-	explicit GetCommitVersionReply( Version version, Version prevVersion, uint64_t requestNum ) : version(version), prevVersion(prevVersion), resolverChangesVersion(0), requestNum(requestNum) {}
+	GetCommitVersionReply()
+	  : resolverChangesVersion(0), version(0), prevVersion(0), requestNum(0), leaseEnd(0), leaseDuration(0) {}
+	explicit GetCommitVersionReply( Version version, Version prevVersion, uint64_t requestNum ) : version(version), prevVersion(prevVersion), resolverChangesVersion(0), requestNum(requestNum), leaseEnd(0), leaseDuration(0) {}
 
 	template <class Ar>
 	void serialize(Ar& ar) {
-		serializer(ar, resolverChanges, resolverChangesVersion, version, prevVersion, requestNum);
+		serializer(ar, resolverChanges, resolverChangesVersion, version, prevVersion, requestNum, leaseEnd, leaseDuration);
 	}
 };
 
@@ -167,6 +172,10 @@ struct GetCommitVersionRequest {
 	uint64_t requestNum;
 	uint64_t mostRecentProcessedRequestNum;
 	UID requestingProxy;
+	// Set when the proxy held a version lease: the last version it assigned from it, and to how many batches
+	Optional<Version> leasedVersion;
+	int leaseBatches = 0;
+	bool releaseLease = false; // Only hands the lease back, without asking for a version
 	ReplyPromise<GetCommitVersionReply> reply;
 
 	GetCommitVersionRequest() { }
@@ -177,7 +186,8 @@ struct GetCommitVersionRequest {
 
 	template <class Ar>
 	void serialize(Ar& ar) {
-		serializer(ar, requestNum, mostRecentProcessedRequestNum, requestingProxy, reply, spanContext);
+		serializer(ar, requestNum, mostRecentProcessedRequestNum, requestingProxy, reply, spanContext, leasedVersion,
+		           leaseBatches, releaseLease);
 	}
 };
 
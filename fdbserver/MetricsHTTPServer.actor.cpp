@@ -0,0 +1,297 @@
+/*
+ * MetricsHTTPServer.actor.cpp
+ *
+ * This source file is part of the FoundationDB open source project
+ *
+ * Copyright 2013-2020 Apple Inc. and the FoundationDB project authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// A minimal HTTP server on the Net2 loop for scraping this process's metrics.  A scrape only reads the current values
+// of counters and histograms that are maintained anyway, so it costs nothing between scrapes.
+
+#include <cctype>
+#include "flow/ActorCollection.h"
+#include "flow/Histogram.h"
+#include "flow/Net2Packet.h"
+#include "flow/SystemMonitor.h"
+#include "flow/UnitTest.h"
+#include "fdbrpc/Stats.h"
+#include "fdbserver/MetricsHTTPServer.h"
+#include "flow/actorcompiler.h" // This must be the last #include.
+
+namespace {
+
+const int maxRequestBytes = 8192;
+const double requestTimeout = 10.0;
+
+// Prometheus names are lower snake case, so TLogQueue becomes t_log_queue and GRVProxy becomes grv_proxy
+std::string metricName(std::string const& name) {
+	std::string result;
+	for (int i = 0; i < name.size(); i++) {
+		unsigned char c = name[i];
+		if (isupper(c)) {
+			bool wordStart = i > 0 && (!isupper((unsigned char)name[i - 1]) ||
+			                           (i + 1 < name.size() && islower((unsigned char)name[i + 1])));
+			if (wordStart && result.size() && result.back() != '_') {
+				result += '_';
+			}
+			result += tolower(c);
+		} else if (isalnum(c)) {
+			result += c;
+		} else if (result.size() && result.back() != '_') {
+			result += '_';
+		}
+	}
+	return result;
+}
+
+std::string labelValue(std::string const& value) {
+	std::string result;
+	for (char c : value) {
+		if (c == '\\' || c == '"') {
+			result += '\\';
+			result += c;
+		} else if (c == '\n') {
+			result += "\\n";
+		} else {
+			result += c;
+		}
+	}
+	return result;
+}
+
+// The format requires all the samples of a metric to follow its TYPE line, but a metric such as a storage server
+// counter can come from several collections in one process
+struct MetricFamilies {
+	struct Family {
+		const char* type;
+		std::string samples;
+	};
+	std::map<std::string, Family> families;
+
+	void add(std::string const& family, const char* type, std::string const& sample, std::string const& labels,
+	         std::string const& value) {
+		Family& f = families[family];
+		f.type = type;
+		f.samples += sample + labels + " " + value + "\n";
+	}
+
+	std::string toString() const {
+		std::string result;
+		for (auto const& f : families) {
+			result += "# TYPE " + f.first + " " + f.second.type + "\n" + f.second.samples;
+		}
+		return result;
+	}
+};
+
+void addCounters(MetricFamilies& metrics) {
+	for (CounterCollection* cc : CounterCollection::all()) {
+		std::string prefix = "fdb_" + metricName(cc->name) + "_";
+		std::string labels = cc->id.empty() ? "" : "{id=\"" + labelValue(cc->id) + "\"}";
+		for (ICounter* c : cc->counters) {
+			std::string name = prefix + metricName(c->getName());
+			metrics.add(name, c->hasRate() ? "counter" : "gauge", name, labels,
+			            format("%lld", (long long)c->getValue()));
+		}
+	}
+}
+
+// Each bucket i of a Histogram holds the samples below 2^(i+1) units, and the last one also holds everything larger
+void addHistograms(MetricFamilies& metrics) {
+	for (auto const& it : GetHistogramRegistry().getHistograms()) {
+		Histogram const* h = it.second;
+		double scale = 1;
+		std::string name = "fdb_histogram_" + metricName(h->group) + "_" + metricName(h->op);
+		switch (h->unit) {
+		case Histogram::Unit::microseconds:
+			name += "_seconds";
+			scale = 1e-6;
+			break;
+		case Histogram::Unit::bytes:
+			name += "_bytes";
+			break;
+		case Histogram::Unit::bytes_per_second:
+			name += "_bytes_per_second";
+			break;
+		}
+
+		// There is no sum of the samples, so only the buckets and the count are exported
+		uint64_t count = 0;
+		for (int i = 0; i < 31; i++) {
+			count += h->totalCount(i);
+			metrics.add(name, "histogram", name + "_bucket", format("{le=\"%g\"}", ((uint64_t)2 << i) * scale),
+			            format("%llu", (unsigned long long)count));
+		}
+		count += h->totalCount(31);
+		metrics.add(name, "histogram", name + "_bucket", "{le=\"+Inf\"}", format("%llu", (unsigned long long)count));
+		metrics.add(name, "histogram", name + "_count", "", format("%llu", (unsigned long long)count));
+	}
+}
+
+void addNetworkMetrics(MetricFamilies& metrics) {
+	NetworkData net;
+	net.init();
+	auto counter = [&](const char* name, int64_t value) {
+		metrics.add(name, "counter", name, "", format("%lld", (long long)value));
+	};
+	counter("fdb_network_bytes_sent", net.bytesSent);
+	counter("fdb_network_bytes_received", net.bytesReceived);
+	counter("fdb_network_packets_generated", net.countPacketsGenerated);
+	counter("fdb_network_packets_received", net.countPacketsReceived);
+	counter("fdb_network_run_loop_iterations", net.countRunLoop);
+	counter("fdb_network_tasks", net.countTasks);
+	counter("fdb_network_yields", net.countYields);
+	counter("fdb_network_connections_established", net.countConnEstablished);
+	counter("fdb_network_connections_closed_with_error", net.countConnClosedWithError);
+	counter("fdb_network_connections_closed_without_error", net.countConnClosedWithoutError);
+	counter("fdb_network_tls_handshake_failures", net.countTLSHandshakeFailures);
+	metrics.add("fdb_network_sleep_seconds", "counter", "fdb_network_sleep_seconds", "",
+	            format("%g", net.countSleepTime));
+
+	NetworkMetrics const& nm = g_network->networkInfo.metrics;
+	for (int i = 0; i < NetworkMetrics::SLOW_EVENT_BINS; i++) {
+		// Bin i counts the tasks that ran for at least 2^i million TSC cycles without yielding
+		metrics.add("fdb_network_slow_tasks", "counter", "fdb_network_slow_tasks",
+		            format("{min_cycles=\"%lld\"}", (1LL << i) * 1000000),
+		            format("%llu", (unsigned long long)nm.countSlowEvents[i]));
+	}
+	metrics.add("fdb_network_run_loop_busyness", "gauge", "fdb_network_run_loop_busyness", "",
+	            format("%g", nm.lastRunLoopBusyness));
+}
+
+void writeResponse(UnsentPacketQueue* unsent, int code, const char* reason, std::string const& body) {
+	std::string head = format("HTTP/1.1 %d %s\r\n"
+	                          "Content-Type: text/plain; version=0.0.4; charset=utf-8\r\n"
+	                          "Content-Length: %d\r\n"
+	                          "Connection: close\r\n\r\n",
+	                          code, reason, (int)body.size());
+	PacketBuffer* first = PacketBuffer::create();
+	PacketWriter writer(first, nullptr, Unversioned());
+	writer.serializeBytes(StringRef(head));
+	writer.serializeBytes(StringRef(body));
+	unsent->appendWriteBuffer(first, writer.finish());
+}
+
+// Answers one request and closes the connection.  Scrapers open a connection per scrape, and the request line is all
+// that matters, so there is no keep-alive and the headers are only read to find their end.
+ACTOR Future<Void> serveRequest(Reference<IConnection> conn) {
+	state std::string request;
+	state UnsentPacketQueue unsent;
+	state size_t headEnd = std::string::npos;
+
+	wait(conn->acceptHandshake());
+	loop {
+		int originalSize = request.size();
+		request.resize(originalSize + 1024);
+		int len = conn->read((uint8_t*)&request[originalSize], (uint8_t*)&request[0] + request.size());
+		request.resize(originalSize + len);
+		headEnd = request.find("\r\n\r\n");
+		if (headEnd != std::string::npos || request.size() > maxRequestBytes) {
+			break;
+		}
+		if (len == 0) {
+			wait(conn->onReadable());
+			wait(delay(0, TaskPriority::ReadSocket));
+		}
+	}
+
+	std::string line = request.substr(0, request.find("\r\n"));
+	std::string path = line.substr(line.find(' ') + 1);
+	path = path.substr(0, path.find_first_of(" ?"));
+	if (headEnd == std::string::npos) {
+		writeResponse(&unsent, 400, "Bad Request", "Bad request\n");
+	} else if (line.compare(0, 4, "GET ") != 0) {
+		writeResponse(&unsent, 405, "Method Not Allowed", "Only GET is supported\n");
+	} else if (path != "/metrics") {
+		writeResponse(&unsent, 404, "Not Found", "Metrics are at /metrics\n");
+	} else {
+		writeResponse(&unsent, 200, "OK", renderPrometheusMetrics());
+	}
+
+	loop {
+		int len = conn->write(unsent.getUnsent());
+		unsent.sent(len);
+		if (unsent.empty()) {
+			break;
+		}
+		wait(conn->onWritable());
+		wait(yield(TaskPriority::WriteSocket));
+	}
+	return Void();
+}
+
+ACTOR Future<Void> serveConnection(Reference<IConnection> conn) {
+	try {
+		wait(timeoutError(serveRequest(conn), requestTimeout));
+	} catch (Error& e) {
+		if (e.code() == error_code_actor_cancelled) {
+			conn->close();
+			throw;
+		}
+		TraceEvent(SevDebug, "MetricsHTTPRequestFailed").error(e).detail("Peer", conn->getPeerAddress());
+	}
+	conn->close();
+	return Void();
+}
+
+ACTOR Future<Void> metricsHTTPServerImpl(NetworkAddress address) {
+	state Reference<IListener> listener = INetworkConnections::net()->listen(address);
+	state ActorCollection connections(false);
+	TraceEvent("MetricsHTTPServerListening").detail("Address", address);
+
+	loop {
+		wait(delay(0, TaskPriority::AcceptSocket));
+		Reference<IConnection> conn = wait(listener->accept());
+		connections.add(serveConnection(conn));
+	}
+}
+
+} // namespace
+
+std::string renderPrometheusMetrics() {
+	MetricFamilies metrics;
+	addCounters(metrics);
+	addHistograms(metrics);
+	addNetworkMetrics(metrics);
+	return metrics.toString();
+}
+
+Future<Void> metricsHTTPServer(NetworkAddress const& address) {
+	return metricsHTTPServerImpl(address);
+}
+
+TEST_CASE("/fdbserver/MetricsHTTPServer/metricName") {
+	ASSERT(metricName("QueryQueue") == "query_queue");
+	ASSERT(metricName("TLogQueue") == "t_log_queue");
+	ASSERT(metricName("GRVProxy") == "grv_proxy");
+	ASSERT(metricName("Bytes.Input") == "bytes_input");
+	ASSERT(metricName("p99") == "p99");
+	return Void();
+}
+
+TEST_CASE("/fdbserver/MetricsHTTPServer/render") {
+	CounterCollection cc("MetricsTest", "a\"b");
+	Counter requests("Requests", cc);
+	requests += 3;
+	int64_t queued = 7;
+	specialCounter(cc, "QueueLength", [&queued]() { return queued; });
+
+	std::string text = renderPrometheusMetrics();
+	ASSERT(text.find("# TYPE fdb_metrics_test_requests counter\n") != std::string::npos);
+	ASSERT(text.find("fdb_metrics_test_requests{id=\"a\\\"b\"} 3\n") != std::string::npos);
+	ASSERT(text.find("fdb_metrics_test_queue_length{id=\"a\\\"b\"} 7\n") != std::string::npos);
+	return Void();
+}
@@ -553,6 +553,8 @@ struct LogData : NonCopyable, public ReferenceCounted<LogData> {
 template <class T>
 void TLogQueue::push( T const& qe, Reference<LogData> logData ) {
 	BinaryWriter wr( Unversioned() );  // outer framing is not versioned
+	// The messages make up nearly all of the entry; the rest is a few fixed size fields
+	wr.reserve(qe.expectedSize() + 64);
 	wr << uint32_t(0);
 	IncludeVersion(ProtocolVersion::withTLogQueueEntryRef()).write(wr);  // payload is versioned
 	wr << qe;
@@ -0,0 +1,327 @@
+/*
+ * PartitionedConflictSet.cpp
+ *
+ * This source file is part of the FoundationDB open source project
+ *
+ * Copyright 2013-2020 Apple Inc. and the FoundationDB project authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <algorithm>
+#include <atomic>
+
+#include "fdbserver/PartitionedConflictSet.h"
+#include "flow/Platform.h"
+#include "flow/ThreadPrimitives.h"
+#include "flow/UnitTest.h"
+
+struct PartitionedConflictSet::Partition {
+	ConflictSet* cs;
+
+	// The current batch, clipped to this partition.  Only transactions with a conflict range here are included.
+	Arena arena;
+	std::vector<CommitTransactionRef> transactions;
+	std::vector<int> batchIndex; // Index in this partition's batch -> index in the whole batch
+	std::vector<std::vector<int>> readIndex; // [index in this partition's batch][read range here] -> original index
+	Version now, newOldestVersion;
+
+	std::vector<int> nonConflicting;
+	std::vector<int> tooOld;
+	std::map<int, VectorRef<int>> conflictingKeyRanges;
+	Arena conflictingKeyRangeArena;
+	Optional<Error> error;
+
+	Partition() : cs(newConflictSet()), now(0), newOldestVersion(0) {}
+	~Partition() { destroyConflictSet(cs); }
+
+	void clear() {
+		arena = Arena();
+		transactions.clear();
+		batchIndex.clear();
+		readIndex.clear();
+		nonConflicting.clear();
+		tooOld.clear();
+		conflictingKeyRanges.clear();
+		conflictingKeyRangeArena = Arena();
+		error = Optional<Error>();
+	}
+
+	// The transaction in this partition's batch for batch transaction t, which must be the newest one added so far
+	CommitTransactionRef& transactionFor(int t, const CommitTransactionRef& original) {
+		if (batchIndex.empty() || batchIndex.back() != t) {
+			batchIndex.push_back(t);
+			readIndex.emplace_back();
+			transactions.emplace_back();
+			transactions.back().read_snapshot = original.read_snapshot;
+			transactions.back().report_conflicting_keys = original.report_conflicting_keys;
+		}
+		return transactions.back();
+	}
+
+	void run() {
+		try {
+			ConflictBatch batch(cs, &conflictingKeyRanges, &conflictingKeyRangeArena);
+			for (const auto& tr : transactions) {
+				batch.addTransaction(tr);
+			}
+			batch.detectConflicts(now, newOldestVersion, nonConflicting, &tooOld);
+		} catch (Error& e) {
+			error = e;
+		}
+	}
+};
+
+// A thread that resolves one partition each time the network thread signals it
+struct PartitionedConflictSet::Worker {
+	Partition* partition;
+	Event start;
+	Event* done;
+	std::atomic<bool> stopping;
+	THREAD_HANDLE thread;
+
+	Worker(Partition* partition, Event* done) : partition(partition), done(done), stopping(false) {
+		thread = startThread(workerThread, this);
+	}
+	~Worker() {
+		stopping.store(true);
+		start.set();
+		waitThread(thread);
+	}
+
+	THREAD_FUNC workerThread(void* arg) {
+		Worker* self = (Worker*)arg;
+		loop {
+			self->start.block();
+			if (self->stopping.load()) break;
+			self->partition->run();
+			self->done->set();
+		}
+		THREAD_RETURN;
+	}
+};
+
+PartitionedConflictSet::PartitionedConflictSet(int partitionCount, bool useThreads) {
+	ASSERT(partitionCount >= 1 && partitionCount <= 256);
+	// Until setBoundaries() is called with sampled split points, spread the partitions evenly over the first byte
+	for (int i = 0; i < partitionCount; i++) {
+		uint8_t b = i * 256 / partitionCount;
+		boundaries.push_back(i ? Key(StringRef(&b, 1)) : Key());
+		partitions.emplace_back(new Partition);
+	}
+	if (useThreads) {
+		for (int i = 1; i < partitionCount; i++) {
+			workers.emplace_back(new Worker(partitions[i].get(), &done));
+		}
+	}
+}
+
+PartitionedConflictSet::~PartitionedConflictSet() {
+	workers.clear();
+}
+
+void PartitionedConflictSet::setBoundaries(std::vector<Key> const& newBoundaries, Version v) {
+	ASSERT(newBoundaries.size() == partitions.size() && newBoundaries[0].size() == 0);
+	ASSERT(std::is_sorted(newBoundaries.begin(), newBoundaries.end()));
+	boundaries = newBoundaries;
+	for (auto& p : partitions) {
+		clearConflictSet(p->cs, v);
+	}
+}
+
+void PartitionedConflictSet::split(const VectorRef<CommitTransactionRef>& transactions) {
+	const int count = partitions.size();
+	for (int t = 0; t < transactions.size(); t++) {
+		const CommitTransactionRef& tr = transactions[t];
+		for (int r = 0; r < tr.read_conflict_ranges.size(); r++) {
+			const KeyRangeRef& range = tr.read_conflict_ranges[r];
+			int p = std::upper_bound(boundaries.begin(), boundaries.end(), range.begin) - boundaries.begin() - 1;
+			// An empty range stays whole in the partition of its begin key, just as it would in one ConflictSet
+			for (int first = p; p < count && (p == first || boundaries[p] < range.end); p++) {
+				Partition& part = *partitions[p];
+				KeyRef begin = std::max<KeyRef>(range.begin, boundaries[p]);
+				KeyRef end = p + 1 < count ? std::min<KeyRef>(range.end, boundaries[p + 1]) : range.end;
+				part.transactionFor(t, tr).read_conflict_ranges.push_back(part.arena, KeyRangeRef(begin, end));
+				part.readIndex.back().push_back(r);
+			}
+		}
+		for (const KeyRangeRef& range : tr.write_conflict_ranges) {
+			int p = std::upper_bound(boundaries.begin(), boundaries.end(), range.begin) - boundaries.begin() - 1;
+			for (int first = p; p < count && (p == first || boundaries[p] < range.end); p++) {
+				Partition& part = *partitions[p];
+				KeyRef begin = std::max<KeyRef>(range.begin, boundaries[p]);
+				KeyRef end = p + 1 < count ? std::min<KeyRef>(range.end, boundaries[p + 1]) : range.end;
+				part.transactionFor(t, tr).write_conflict_ranges.push_back(part.arena, KeyRangeRef(begin, end));
+			}
+		}
+	}
+}
+
+void PartitionedConflictSet::run() {
+	for (auto& w : workers) {
+		w->start.set();
+	}
+	// The calling thread takes partition 0, or every partition if there are no workers
+	for (int i = 0; i < partitions.size() - workers.size(); i++) {
+		partitions[i]->run();
+	}
+	for (int i = 0; i < workers.size(); i++) {
+		done.block();
+	}
+	for (auto& p : partitions) {
+		if (p->error.present()) throw p->error.get();
+	}
+}
+
+void PartitionedConflictSet::resolve(const VectorRef<CommitTransactionRef>& transactions, Version now,
+                                     Version newOldestVersion, std::vector<int>& nonConflicting,
+                                     std::vector<int>& tooOld, std::map<int, VectorRef<int>>* conflictingKeyRangeMap,
+                                     Arena* resolveBatchReplyArena) {
+	for (auto& p : partitions) {
+		p->clear();
+		p->now = now;
+		p->newOldestVersion = newOldestVersion;
+	}
+	split(transactions);
+
+	// Every partition runs a batch, even an empty one, so that all of them forget old versions together
+	run();
+
+	// A transaction that touches no partition has no conflict ranges, and so commits
+	std::vector<uint8_t> verdict(transactions.size(), ConflictBatch::TransactionCommitted);
+	for (auto& p : partitions) {
+		std::vector<bool> committed(p->transactions.size(), false);
+		for (int i : p->nonConflicting) committed[i] = true;
+		for (int i = 0; i < committed.size(); i++) {
+			uint8_t& v = verdict[p->batchIndex[i]];
+			if (!committed[i] && v == ConflictBatch::TransactionCommitted) v = ConflictBatch::TransactionConflict;
+		}
+		for (int i : p->tooOld) verdict[p->batchIndex[i]] = ConflictBatch::TransactionTooOld;
+	}
+
+	for (int t = 0; t < verdict.size(); t++) {
+		if (verdict[t] == ConflictBatch::TransactionCommitted)
+			nonConflicting.push_back(t);
+		else if (verdict[t] == ConflictBatch::TransactionTooOld)
+			tooOld.push_back(t);
+	}
+
+	if (conflictingKeyRangeMap) {
+		for (auto& p : partitions) {
+			for (const auto& it : p->conflictingKeyRanges) {
+				int t = p->batchIndex[it.first];
+				if (verdict[t] != ConflictBatch::TransactionConflict || !it.second.size()) continue;
+				VectorRef<int>& out = (*conflictingKeyRangeMap)[t];
+				for (int r : it.second) {
+					int original = p->readIndex[it.first][r];
+					// A read range split over several partitions may conflict in more than one of them
+					if (std::find(out.begin(), out.end(), original) == out.end())
+						out.push_back(*resolveBatchReplyArena, original);
+				}
+			}
+		}
+		for (auto& it : *conflictingKeyRangeMap) {
+			std::sort(it.second.begin(), it.second.end());
+		}
+	}
+}
+
+namespace {
+
+struct TestBatch {
+	Arena arena;
+	VectorRef<CommitTransactionRef> transactions;
+};
+
+StringRef testKey(Arena& arena, int i) {
+	// The leading bytes are spread over the whole key space so that every partition sees traffic
+	uint8_t k[4] = { uint8_t(i * 37), uint8_t(i * 11), uint8_t(i >> 8), uint8_t(i) };
+	return StringRef(arena, StringRef(k, 4));
+}
+
+// Every transaction either only reads or only writes, so no transaction's writes can land in a partition where it
+// did not commit, and a PartitionedConflictSet must then give exactly the verdicts of a single ConflictSet.
+TestBatch randomBatch(Version version) {
+	TestBatch b;
+	int count = deterministicRandom()->randomInt(0, 40);
+	for (int t = 0; t < count; t++) {
+		CommitTransactionRef tr;
+		tr.read_snapshot = version - deterministicRandom()->randomInt(1, 20);
+		tr.report_conflicting_keys = deterministicRandom()->coinflip();
+		if (deterministicRandom()->coinflip()) {
+			int reads = deterministicRandom()->randomInt(1, 4);
+			for (int r = 0; r < reads; r++) {
+				StringRef a = testKey(b.arena, deterministicRandom()->randomInt(0, 300));
+				StringRef e = testKey(b.arena, deterministicRandom()->randomInt(0, 300));
+				if (e < a) std::swap(a, e);
+				if (deterministicRandom()->random01() < 0.1) a = StringRef();
+				if (a == e) continue;
+				tr.read_conflict_ranges.push_back(b.arena, KeyRangeRef(a, e));
+			}
+		} else {
+			int writes = deterministicRandom()->randomInt(1, 4);
+			for (int w = 0; w < writes; w++) {
+				StringRef a = testKey(b.arena, deterministicRandom()->randomInt(0, 300));
+				tr.write_conflict_ranges.push_back(b.arena, singleKeyRange(a, b.arena));
+			}
+		}
+		b.transactions.push_back(b.arena, tr);
+	}
+	return b;
+}
+
+} // namespace
+
+TEST_CASE("/fdbserver/PartitionedConflictSet/MatchesSingleConflictSet") {
+	int partitionCount = deterministicRandom()->randomInt(1, 9);
+	PartitionedConflictSet partitioned(partitionCount, !g_network->isSimulated() && deterministicRandom()->coinflip());
+	ConflictSet* single = newConflictSet();
+
+	for (Version version = 100; version < 600; version++) {
+		if (version == 300) {
+			// Moving the boundaries resets history, so reset the single set to the same version
+			Arena arena;
+			std::vector<Key> b(1, Key());
+			for (int i = 1; i < partitionCount; i++) b.push_back(Key(testKey(arena, i * 300 / partitionCount)));
+			std::sort(b.begin() + 1, b.end());
+			partitioned.setBoundaries(b, version - 1);
+			clearConflictSet(single, version - 1);
+		}
+
+		TestBatch batch = randomBatch(version);
+		std::vector<int> nonConflicting, tooOld, expectedNonConflicting, expectedTooOld;
+		std::map<int, VectorRef<int>> cKR, expectedCKR;
+		Arena arena;
+
+		ConflictBatch b(single, &expectedCKR, &arena);
+		for (const auto& tr : batch.transactions) b.addTransaction(tr);
+		b.detectConflicts(version, version - 10, expectedNonConflicting, &expectedTooOld);
+
+		partitioned.resolve(batch.transactions, version, version - 10, nonConflicting, tooOld, &cKR, &arena);
+
+		ASSERT(nonConflicting == expectedNonConflicting);
+		ASSERT(tooOld == expectedTooOld);
+		for (int t = 0; t < batch.transactions.size(); t++) {
+			const CommitTransactionRef& tr = batch.transactions[t];
+			bool conflicted = !std::binary_search(nonConflicting.begin(), nonConflicting.end(), t) &&
+			                  !std::binary_search(tooOld.begin(), tooOld.end(), t);
+			if (conflicted && tr.report_conflicting_keys) {
+				ASSERT(cKR[t].size());
+				for (int r : cKR[t]) ASSERT(r >= 0 && r < tr.read_conflict_ranges.size());
+			}
+		}
+	}
+
+	destroyConflictSet(single);
+	return Void();
+}
@@ -0,0 +1,77 @@
+/*
+ * PartitionedConflictSet.h
+ *
+ * This source file is part of the FoundationDB open source project
+ *
+ * Copyright 2013-2020 Apple Inc. and the FoundationDB project authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FDBSERVER_PARTITIONEDCONFLICTSET_H
+#define FDBSERVER_PARTITIONEDCONFLICTSET_H
+#pragma once
+
+#include <map>
+#include <memory>
+#include <vector>
+
+#include "fdbserver/ConflictSet.h"
+#include "flow/ThreadPrimitives.h"
+
+// A conflict set split by key range into partitions, each with its own ConflictSet, so that one resolver can check a
+// batch on several threads.  Each transaction's conflict ranges are clipped to the partitions they intersect, every
+// partition runs a ConflictBatch over its share of the batch, and the verdicts are merged: a transaction commits only
+// if it commits in every partition it touches, and is too old if it is too old in any of them.
+//
+// As with several resolvers, a transaction that conflicts in one partition still has its writes recorded in the
+// others, which can only add conflicts, never hide one.
+//
+// resolve() does not return until every partition is done, so the caller sees it as one synchronous call, just like
+// ConflictBatch::detectConflicts.  Partition 0 runs on the calling thread.
+class PartitionedConflictSet : NonCopyable {
+public:
+	// With useThreads false (as in simulation) the partitions are resolved one after another on the calling thread.
+	PartitionedConflictSet(int partitionCount, bool useThreads);
+	~PartitionedConflictSet();
+
+	int size() const { return boundaries.size(); }
+
+	// Partition i holds the keys in [boundaries[i], boundaries[i+1]); boundaries[0] is always the empty key.
+	std::vector<Key> const& getBoundaries() const { return boundaries; }
+
+	// Moves the partition boundaries.  Conflict history does not move with them: every partition forgets its
+	// history and instead treats every key as last written at version v, so reads older than v conflict until they
+	// age out.  v must be at least the newest version already resolved.
+	void setBoundaries(std::vector<Key> const& newBoundaries, Version v);
+
+	// Resolves one batch, with the same results as adding every transaction to a ConflictBatch on a single
+	// ConflictSet and calling detectConflicts(now, newOldestVersion, nonConflicting, &tooOld).
+	void resolve(const VectorRef<CommitTransactionRef>& transactions, Version now, Version newOldestVersion,
+	             std::vector<int>& nonConflicting, std::vector<int>& tooOld,
+	             std::map<int, VectorRef<int>>* conflictingKeyRangeMap, Arena* resolveBatchReplyArena);
+
+private:
+	struct Partition;
+	struct Worker;
+
+	void split(const VectorRef<CommitTransactionRef>& transactions);
+	void run();
+
+	std::vector<Key> boundaries;
+	std::vector<std::unique_ptr<Partition>> partitions;
+	std::vector<std::unique_ptr<Worker>> workers; // workers[i] runs partitions[i+1]
+	Event done; // Set by a worker each time it finishes its partition
+};
+
+#endif
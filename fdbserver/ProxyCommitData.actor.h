@@ -25,8 +25,10 @@
 #elif !defined(FDBSERVER_PROXYCOMMITDATA_ACTOR_H)
 #define FDBSERVER_PROXYCOMMITDATA_ACTOR_H
 
+#include "fdbclient/ConflictHotspots.h"
 #include "fdbclient/FDBTypes.h"
 #include "fdbrpc/Stats.h"
+#include "fdbserver/KeyRoutingIndex.h"
 #include "fdbserver/Knobs.h"
 #include "fdbserver/LogSystemDiskQueueAdapter.h"
 #include "flow/IRandom.h"
@@ -91,8 +93,7 @@ struct ProxyStats {
 	    conflictRanges("ConflictRanges", cc), keyServerLocationIn("KeyServerLocationIn", cc),
 	    keyServerLocationOut("KeyServerLocationOut", cc), keyServerLocationErrors("KeyServerLocationErrors", cc),
 	    lastCommitVersionAssigned(0), txnExpensiveClearCostEstCount("ExpensiveClearCostEstCount", cc),
-	    commitLatencySample("CommitLatencyMetrics", id, SERVER_KNOBS->LATENCY_METRICS_LOGGING_INTERVAL,
-	                        SERVER_KNOBS->LATENCY_SAMPLE_SIZE),
+	    commitLatencySample("CommitLatencyMetrics", id, SERVER_KNOBS->LATENCY_METRICS_LOGGING_INTERVAL),
 	    commitLatencyBands("CommitLatencyMetrics", id, SERVER_KNOBS->STORAGE_LOGGING_DELAY) {
 		specialCounter(cc, "LastAssignedCommitVersion", [this]() { return this->lastCommitVersionAssigned; });
 		specialCounter(cc, "Version", [pVersion]() { return *pVersion; });
@@ -105,6 +106,20 @@ struct ProxyStats {
 	}
 };
 
+// Versions the master has leased this proxy.  While the lease lasts, each batch takes the next version from it
+// itself instead of asking the master, and the next request to the master hands it back.
+struct CommitVersionLease {
+	int64_t batch = 0; // The local batch which took the last version, so only the one after it can take another
+	Version start = invalidVersion; // The version the master gave along with the lease
+	Version last = invalidVersion; // The last version assigned from the lease
+	Version end = invalidVersion; // The last version the lease covers
+	double startTime = 0;
+	double expires = 0;
+	int batches = 0; // Batches which took a version from the lease
+
+	bool held() const { return end != invalidVersion; }
+};
+
 struct ProxyCommitData {
 	UID dbgid;
 	int64_t commitBatchesMemBytesCount;
@@ -126,6 +141,7 @@ struct ProxyCommitData {
 	uint64_t mostRecentProcessedRequestNumber;
 	KeyRangeMap<Deque<std::pair<Version, int>>> keyResolvers;
 	KeyRangeMap<ServerCacheInfo> keyInfo;
+	KeyRoutingIndex keyRouting; // Of keyInfo, for routing mutations
 	KeyRangeMap<bool> cacheInfo;
 	std::map<Key, ApplyMutationsData> uid_applyMutationsData;
 	bool firstProxy;
@@ -133,9 +149,14 @@ struct ProxyCommitData {
 	bool locked;
 	Optional<Value> metadataVersion;
 	double commitBatchInterval;
+	int commitBatchByteLimit;
+	ContinuousSample<double> batchControlLatencies; // Commit latencies since the batch controller last adjusted
 
 	int64_t localCommitBatchesStarted;
 	NotifiedVersion latestLocalCommitBatchResolving;
+	int64_t latestLocalCommitBatchVersionRequested = 0; // Requests must reach the master in batch order
+	CommitVersionLease commitVersionLease;
+	Future<Void> commitVersionLeaseRelease;
 	NotifiedVersion latestLocalCommitBatchLogging;
 
 	RequestStream<GetReadVersionRequest> getConsistentReadVersion;
@@ -159,6 +180,7 @@ struct ProxyCommitData {
 
 	vector<double> commitComputePerOperation;
 	UIDTransactionTagMap<TransactionCommitCostEstimation> ssTrTagCommitCost;
+	ConflictHotspots conflictHotspots; // The read conflict ranges that transactions reporting conflicting keys failed on
 	double lastMasterReset;
 	double lastResolverReset;
 
@@ -166,13 +188,9 @@ struct ProxyCommitData {
 	// more CPU efficient. When a tag related to a storage server does change, we empty out all of these vectors to
 	// signify they must be repopulated. We do not repopulate them immediately to avoid a slow task.
 	const vector<Tag>& tagsForKey(StringRef key) {
-		auto& tags = keyInfo[key].tags;
-		if (!tags.size()) {
-			auto& r = keyInfo.rangeContaining(key).value();
-			r.populateTags();
-			return r.tags;
-		}
-		return tags;
+		auto& info = keyRouting[key];
+		info.populateTags();
+		return info.tags;
 	}
 
 	bool needsCacheTag(KeyRangeRef range) {
@@ -217,15 +235,19 @@ struct ProxyCommitData {
 	                Version recoveryTransactionVersion, RequestStream<CommitTransactionRequest> commit,
 	                Reference<AsyncVar<ServerDBInfo>> db, bool firstProxy)
 	  : dbgid(dbgid), stats(dbgid, &version, &committedVersion, &commitBatchesMemBytesCount), master(master),
+	    keyRouting(&keyInfo),
 	    logAdapter(nullptr), txnStateStore(nullptr), popRemoteTxs(false), committedVersion(recoveryTransactionVersion),
 	    version(0), minKnownCommittedVersion(0), lastVersionTime(0), commitVersionRequestNumber(1),
 	    mostRecentProcessedRequestNumber(0), getConsistentReadVersion(getConsistentReadVersion), commit(commit),
 	    lastCoalesceTime(0), localCommitBatchesStarted(0), locked(false),
-	    commitBatchInterval(SERVER_KNOBS->COMMIT_TRANSACTION_BATCH_INTERVAL_MIN), firstProxy(firstProxy),
+	    commitBatchInterval(SERVER_KNOBS->COMMIT_TRANSACTION_BATCH_INTERVAL_MIN), commitBatchByteLimit(0),
+	    batchControlLatencies(SERVER_KNOBS->LATENCY_SAMPLE_SIZE), firstProxy(firstProxy),
 	    cx(openDBOnServer(db, TaskPriority::DefaultEndpoint, true, true)), db(db),
 	    singleKeyMutationEvent(LiteralStringRef("SingleKeyMutation")), commitBatchesMemBytesCount(0), lastTxsPop(0),
 	    lastStartCommit(0), lastCommitLatency(SERVER_KNOBS->REQUIRED_MIN_RECOVERY_DURATION),
-		lastCommitTime(0), lastMasterReset(now()), lastResolverReset(now()) {
+		lastCommitTime(0),
+	    conflictHotspots(SERVER_KNOBS->PROXY_CONFLICT_HOTSPOT_HALF_LIFE, SERVER_KNOBS->PROXY_CONFLICT_HOTSPOT_MAX_RANGES),
+	    lastMasterReset(now()), lastResolverReset(now()) {
 		commitComputePerOperation.resize(SERVER_KNOBS->PROXY_COMPUTE_BUCKETS, 0.0);
 	}
 };
@@ -45,6 +45,7 @@ enum limitReason_t {
 	log_server_min_free_space_ratio,
 	storage_server_durability_lag, // 10
 	storage_server_list_fetch_failed,
+	storage_server_compaction_debt, // a storage server's engine is close to stalling writes until compaction catches up
 	limitReason_t_end
 };
 
@@ -62,7 +63,8 @@ const char* limitReasonName[] = {
 	"log_server_min_free_space",
 	"log_server_min_free_space_ratio",
 	"storage_server_durability_lag",
-	"storage_server_list_fetch_failed"
+	"storage_server_list_fetch_failed",
+	"storage_server_compaction_debt"
 };
 static_assert(sizeof(limitReasonName) / sizeof(limitReasonName[0]) == limitReason_t_end, "limitReasonDesc table size");
 
@@ -80,7 +82,8 @@ const char* limitReasonDesc[] = {
 	"Log server running out of space (approaching 100MB limit).",
 	"Log server running out of space (approaching 5% limit).",
 	"Storage server durable version falling behind.",
-	"Unable to fetch storage server list."
+	"Unable to fetch storage server list.",
+	"Storage server storage engine falling behind on compaction."
 };
 
 static_assert(sizeof(limitReasonDesc) / sizeof(limitReasonDesc[0]) == limitReason_t_end, "limitReasonDesc table size");
@@ -598,7 +601,17 @@ ACTOR Future<Void> trackStorageServerQueueInfo( RatekeeperData* self, StorageSer
 	TraceEvent("RkTracking", self->id).detail("StorageServer", ssi.id()).detail("Locality", ssi.locality.toString());
 	try {
 		loop {
-			ErrorOr<StorageQueuingMetricsReply> reply = wait( ssi.getQueuingMetrics.getReplyUnlessFailedFor( StorageQueuingMetricsRequest(), 0, 0 ) ); // SOMEDAY: or tryGetReply?
+			// Once there is a reply, the server holds the next request until the reply is out of date, so an idle
+			// server answers once per heartbeat and a busy one as often as METRIC_UPDATE_RATE allows
+			state double requested = now();
+			StorageQueuingMetricsRequest request;
+			if (myQueueInfo->value.valid) {
+				request = StorageQueuingMetricsRequest(
+				    myQueueInfo->value.lastReply, SERVER_KNOBS->QUEUING_METRICS_HEARTBEAT,
+				    SERVER_KNOBS->QUEUING_METRICS_CHANGE_FRACTION * SERVER_KNOBS->TARGET_BYTES_PER_STORAGE_SERVER,
+				    SERVER_KNOBS->QUEUING_METRICS_CHANGE_FRACTION * SERVER_KNOBS->TARGET_DURABILITY_LAG_VERSIONS);
+			}
+			ErrorOr<StorageQueuingMetricsReply> reply = wait( ssi.getQueuingMetrics.getReplyUnlessFailedFor( request, 0, 0 ) ); // SOMEDAY: or tryGetReply?
 			if (reply.present()) {
 				myQueueInfo->value.valid = true;
 				myQueueInfo->value.prevReply = myQueueInfo->value.lastReply;
@@ -633,7 +646,7 @@ ACTOR Future<Void> trackStorageServerQueueInfo( RatekeeperData* self, StorageSer
 				myQueueInfo->value.valid = false;
 			}
 
-			wait(delayJittered(SERVER_KNOBS->METRIC_UPDATE_RATE) && IFailureMonitor::failureMonitor().onStateEqual(ssi.getQueuingMetrics.getEndpoint(), FailureStatus(false)));
+			wait(delayJittered(std::max(0.0, requested + SERVER_KNOBS->METRIC_UPDATE_RATE - now())) && IFailureMonitor::failureMonitor().onStateEqual(ssi.getQueuingMetrics.getEndpoint(), FailureStatus(false)));
 		}
 	} catch (...) {
 		// including cancellation
@@ -649,7 +662,14 @@ ACTOR Future<Void> trackTLogQueueInfo( RatekeeperData* self, TLogInterface tli )
 		.detail("TransactionLog", tli.id());
 	try {
 		loop {
-			ErrorOr<TLogQueuingMetricsReply> reply = wait( tli.getQueuingMetrics.getReplyUnlessFailedFor( TLogQueuingMetricsRequest(), 0, 0 ) );  // SOMEDAY: or tryGetReply?
+			state double requested = now();
+			TLogQueuingMetricsRequest request;
+			if (myQueueInfo->value.valid) {
+				request = TLogQueuingMetricsRequest(
+				    myQueueInfo->value.lastReply, SERVER_KNOBS->QUEUING_METRICS_HEARTBEAT,
+				    SERVER_KNOBS->QUEUING_METRICS_CHANGE_FRACTION * SERVER_KNOBS->TARGET_BYTES_PER_TLOG);
+			}
+			ErrorOr<TLogQueuingMetricsReply> reply = wait( tli.getQueuingMetrics.getReplyUnlessFailedFor( request, 0, 0 ) );  // SOMEDAY: or tryGetReply?
 			if (reply.present()) {
 				myQueueInfo->value.valid = true;
 				myQueueInfo->value.prevReply = myQueueInfo->value.lastReply;
@@ -676,7 +696,7 @@ ACTOR Future<Void> trackTLogQueueInfo( RatekeeperData* self, TLogInterface tli )
 				myQueueInfo->value.valid = false;
 			}
 
-			wait(delayJittered(SERVER_KNOBS->METRIC_UPDATE_RATE) && IFailureMonitor::failureMonitor().onStateEqual(tli.getQueuingMetrics.getEndpoint(), FailureStatus(false)));
+			wait(delayJittered(std::max(0.0, requested + SERVER_KNOBS->METRIC_UPDATE_RATE - now())) && IFailureMonitor::failureMonitor().onStateEqual(tli.getQueuingMetrics.getEndpoint(), FailureStatus(false)));
 		}
 	} catch (...) {
 		// including cancellation
@@ -923,6 +943,14 @@ void tryAutoThrottleTag(RatekeeperData* self, TransactionTag tag, double rate, d
 	}
 }
 
+// A server can be saturated by reads, burning its CPU or slowing its reads, without its write queue or durability lag
+// ever growing
+bool isReadSaturated(StorageQueueInfo const& ss) {
+	return SERVER_KNOBS->AUTO_TAG_THROTTLE_READ_LOAD &&
+	       (ss.lastReply.cpuUsage > SERVER_KNOBS->AUTO_TAG_THROTTLE_STORAGE_CPU_PERCENT ||
+	        ss.lastReply.slowReadFraction > SERVER_KNOBS->AUTO_TAG_THROTTLE_SLOW_READ_FRACTION);
+}
+
 void tryAutoThrottleTag(RatekeeperData* self, StorageQueueInfo& ss, int64_t storageQueue,
                         int64_t storageDurabilityLag) {
 	// NOTE: we just keep it simple and don't differentiate write-saturation and read-saturation at the moment. In most of situation, this works.
@@ -936,9 +964,23 @@ void tryAutoThrottleTag(RatekeeperData* self, StorageQueueInfo& ss, int64_t stor
 			tryAutoThrottleTag(self, ss.busiestReadTag.get(), ss.busiestReadTagRate,
 			                   ss.busiestReadTagFractionalBusyness, TagThrottledReason::BUSY_READ);
 		}
+	} else if (isReadSaturated(ss) && ss.busiestReadTag.present()) {
+		TEST(true); // Busy read tag throttled on a read saturated storage server
+		tryAutoThrottleTag(self, ss.busiestReadTag.get(), ss.busiestReadTagRate, ss.busiestReadTagFractionalBusyness,
+		                   TagThrottledReason::BUSY_READ);
 	}
 }
 
+// The storage queue RATEKEEPER_PREDICTION_SECONDS from now if the current input and durable rates hold. Controlling on
+// this adds a derivative term to the spring, so that limits tighten while a queue is growing towards its target and
+// relax while it drains, instead of only once it has crossed. The term is bounded by the spring so that a noisy rate
+// cannot move the limit further than the spring itself would.
+static int64_t predictedStorageQueue(StorageQueueInfo& ss, int64_t storageQueue, int64_t springBytes) {
+	double growth = ss.smoothInputBytes.smoothRate() - ss.smoothDurableBytes.smoothRate();
+	double change = std::max<double>(-springBytes, std::min<double>(springBytes, growth * SERVER_KNOBS->RATEKEEPER_PREDICTION_SECONDS));
+	return std::max<int64_t>(0, storageQueue + change);
+}
+
 void updateRate(RatekeeperData* self, RatekeeperLimits* limits) {
 	//double controlFactor = ;  // dt / eFoldingTime
 
@@ -961,12 +1003,15 @@ void updateRate(RatekeeperData* self, RatekeeperLimits* limits) {
 	int64_t worstFreeSpaceStorageServer = std::numeric_limits<int64_t>::max();
 	int64_t worstStorageQueueStorageServer = 0;
 	int64_t limitingStorageQueueStorageServer = 0;
+	int64_t worstPredictedStorageQueue = 0;
+	int64_t limitingPredictedStorageQueue = 0;
 	int64_t worstDurabilityLag = 0;
 
 	std::multimap<double, StorageQueueInfo*> storageTpsLimitReverseIndex;
 	std::multimap<int64_t, StorageQueueInfo*> storageDurabilityLagReverseIndex;
 
 	std::map<UID, limitReason_t> ssReasons;
+	std::map<UID, int64_t> ssControlQueues;
 
 	// Look at each storage server's write queue and local rate, compute and store the desired rate ratio
 	for(auto i = self->storageQueueInfo.begin(); i != self->storageQueueInfo.end(); ++i) {
@@ -1004,7 +1049,14 @@ void updateRate(RatekeeperData* self, RatekeeperLimits* limits) {
 		ssMetrics.cpuUsage = ss.lastReply.cpuUsage;
 		ssMetrics.diskUsage = ss.lastReply.diskUsage;
 
-		double targetRateRatio = std::min(( storageQueue - targetBytes + springBytes ) / (double)springBytes, 2.0);
+		int64_t controlQueue = storageQueue;
+		if (SERVER_KNOBS->RATEKEEPER_PREDICTIVE_STORAGE_QUEUE) {
+			controlQueue = predictedStorageQueue(ss, storageQueue, springBytes);
+		}
+		worstPredictedStorageQueue = std::max(worstPredictedStorageQueue, controlQueue);
+		ssControlQueues[ss.id] = controlQueue;
+
+		double targetRateRatio = std::min(( controlQueue - targetBytes + springBytes ) / (double)springBytes, 2.0);
 
 		if (limits->priority == TransactionPriority::DEFAULT) {
 			tryAutoThrottleTag(self, ss, storageQueue, storageDurabilityLag);
@@ -1050,6 +1102,20 @@ void updateRate(RatekeeperData* self, RatekeeperLimits* limits) {
 			}
 		}
 
+		// Slow down before the storage engine stalls writes itself, which would hold back durability all at once
+		double engineDebt = ss.lastReply.engineDebt.stallFraction();
+		if (engineDebt > SERVER_KNOBS->STORAGE_ENGINE_DEBT_TARGET) {
+			double lim = actualTps * std::max(0.0, (1.0 - engineDebt) / (1.0 - SERVER_KNOBS->STORAGE_ENGINE_DEBT_TARGET));
+			if (lim < limitTps) {
+				limitTps = lim;
+				if (ssLimitReason == limitReason_t::unlimited ||
+				    ssLimitReason == limitReason_t::storage_server_write_bandwidth_mvcc ||
+				    ssLimitReason == limitReason_t::storage_server_write_queue_size) {
+					ssLimitReason = limitReason_t::storage_server_compaction_debt;
+				}
+			}
+		}
+
 		storageTpsLimitReverseIndex.insert(std::make_pair(limitTps, &ss));
 
 		if (limitTps < limits->tpsLimit && (ssLimitReason == limitReason_t::storage_server_min_free_space || ssLimitReason == limitReason_t::storage_server_min_free_space_ratio)) {
@@ -1072,6 +1138,7 @@ void updateRate(RatekeeperData* self, RatekeeperLimits* limits) {
 		}
 
 		limitingStorageQueueStorageServer = ss->second->lastReply.bytesInput - ss->second->smoothDurableBytes.smoothTotal();
+		limitingPredictedStorageQueue = ssControlQueues[ss->second->id];
 		limits->tpsLimit = ss->first;
 		reasonID = storageTpsLimitReverseIndex.begin()->second->id; // Although we aren't controlling based on the worst SS, we still report it as the limiting process
 		limitReason = ssReasons[reasonID];
@@ -1277,6 +1344,9 @@ void updateRate(RatekeeperData* self, RatekeeperLimits* limits) {
 		    .detail("WorstFreeSpaceTLog", worstFreeSpaceTLog)
 		    .detail("WorstStorageServerQueue", worstStorageQueueStorageServer)
 		    .detail("LimitingStorageServerQueue", limitingStorageQueueStorageServer)
+		    .detail("StorageQueueModel", SERVER_KNOBS->RATEKEEPER_PREDICTIVE_STORAGE_QUEUE ? "Predictive" : "Reactive")
+		    .detail("WorstStorageServerPredictedQueue", worstPredictedStorageQueue)
+		    .detail("LimitingStorageServerPredictedQueue", limitingPredictedStorageQueue)
 		    .detail("WorstTLogQueue", worstStorageQueueTLog)
 		    .detail("TotalDiskUsageBytes", totalDiskUsageBytes)
 		    .detail("WorstStorageServerVersionLag", worstVersionLag)
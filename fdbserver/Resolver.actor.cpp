@@ -21,6 +21,7 @@
 #include "flow/ActorCollection.h"
 #include "fdbclient/NativeAPI.actor.h"
 #include "fdbserver/ConflictSet.h"
+#include "fdbserver/PartitionedConflictSet.h"
 #include "fdbserver/ResolverInterface.h"
 #include "fdbserver/MasterInterface.h"
 #include "fdbserver/WorkerInterface.actor.h"
@@ -30,6 +31,8 @@
 #include "fdbserver/Orderer.actor.h"
 #include "fdbserver/StorageMetrics.h"
 #include "fdbclient/SystemData.h"
+#include "fdbrpc/IAsyncFile.h"
+#include "flow/UnitTest.h"
 
 #include "flow/actorcompiler.h"  // This must be the last #include.
 
@@ -55,6 +58,8 @@ struct Resolver : ReferenceCounted<Resolver> {
 	AsyncTrigger checkNeededVersion;
 	std::map<NetworkAddress, ProxyRequestsInfo> proxyInfoMap;
 	ConflictSet *conflictSet;
+	std::unique_ptr<PartitionedConflictSet> partitionedConflictSet; // Used instead of conflictSet if RESOLVER_PARTITIONS > 1
+	double nextRepartitionTime;
 	TransientStorageMetricSample iopsSample;
 
 	Version debugMinRecentStateVersion;
@@ -78,15 +83,29 @@ struct Resolver : ReferenceCounted<Resolver> {
 
 	Future<Void> logger;
 
+	// Set while resolved batches are being appended to a RESOLVER_CAPTURE_FILE
+	Reference<IAsyncFile> captureFile;
+	int64_t captureBytes;
+	Future<Void> captureWrites;
+
 	Resolver( UID dbgid, int commitProxyCount, int resolverCount )
-		: dbgid(dbgid), commitProxyCount(commitProxyCount), resolverCount(resolverCount), version(-1), conflictSet( newConflictSet() ), iopsSample( SERVER_KNOBS->KEY_BYTES_PER_SAMPLE ), debugMinRecentStateVersion(0),
+		: dbgid(dbgid), commitProxyCount(commitProxyCount), resolverCount(resolverCount), version(-1), conflictSet( nullptr ), nextRepartitionTime(0), iopsSample( SERVER_KNOBS->KEY_BYTES_PER_SAMPLE ), debugMinRecentStateVersion(0),
 		  cc("Resolver", dbgid.toString()),
 		  resolveBatchIn("ResolveBatchIn", cc), resolveBatchStart("ResolveBatchStart", cc), resolvedTransactions("ResolvedTransactions", cc), resolvedBytes("ResolvedBytes", cc),
 		  resolvedReadConflictRanges("ResolvedReadConflictRanges", cc), resolvedWriteConflictRanges("ResolvedWriteConflictRanges", cc), transactionsAccepted("TransactionsAccepted", cc),
 		  transactionsTooOld("TransactionsTooOld", cc), transactionsConflicted("TransactionsConflicted", cc), resolvedStateTransactions("ResolvedStateTransactions", cc), 
 		  resolvedStateMutations("ResolvedStateMutations", cc), resolvedStateBytes("ResolvedStateBytes", cc), resolveBatchOut("ResolveBatchOut", cc), metricsRequests("MetricsRequests", cc),
-		  splitRequests("SplitRequests", cc)
+		  splitRequests("SplitRequests", cc), captureBytes(0), captureWrites(Void())
 	{
+		if (SERVER_KNOBS->RESOLVER_PARTITIONS > 1) {
+			// Simulation resolves the partitions one at a time so that it stays deterministic
+			partitionedConflictSet.reset(new PartitionedConflictSet(SERVER_KNOBS->RESOLVER_PARTITIONS, !g_network->isSimulated()));
+			nextRepartitionTime = now() + SERVER_KNOBS->RESOLVER_REPARTITION_INTERVAL;
+		} else {
+			conflictSet = newConflictSet();
+			setConflictSetInlinePrune(conflictSet, !SERVER_KNOBS->RESOLVER_BACKGROUND_PRUNE);
+		}
+
 		specialCounter(cc, "Version", [this](){ return this->version.get(); });
 		specialCounter(cc, "NeededVersion", [this](){ return this->neededVersion.get(); });
 		specialCounter(cc, "TotalStateBytes", [this](){ return this->totalStateBytes.get(); });
@@ -94,12 +113,86 @@ struct Resolver : ReferenceCounted<Resolver> {
 		logger = traceCounters("ResolverMetrics", dbgid, SERVER_KNOBS->WORKER_LOGGING_INTERVAL, &cc, "ResolverMetrics");
 	}
 	~Resolver() {
-		destroyConflictSet( conflictSet );
+		if (conflictSet) destroyConflictSet( conflictSet );
+	}
+
+	bool sampleKeys() const { return resolverCount > 1 || partitionedConflictSet; }
+
+	// Moves the partition boundaries to even out the sampled load once the busiest partition is sufficiently hot.
+	// Because this forgets conflict history, it happens at most once per RESOLVER_REPARTITION_INTERVAL.
+	void maybeRepartition(Version resolvedVersion) {
+		if (!partitionedConflictSet || now() < nextRepartitionTime) return;
+		nextRepartitionTime = now() + SERVER_KNOBS->RESOLVER_REPARTITION_INTERVAL;
+
+		int64_t total = iopsSample.getEstimate(allKeys);
+		if (total <= 0) return;
+
+		const std::vector<Key>& current = partitionedConflictSet->getBoundaries();
+		const int count = current.size();
+		int64_t busiest = 0;
+		for (int i = 0; i < count; i++) {
+			KeyRef end = i + 1 < count ? KeyRef(current[i + 1]) : allKeys.end;
+			if (current[i] < end) busiest = std::max(busiest, iopsSample.getEstimate(KeyRangeRef(current[i], end)));
+		}
+		if (busiest <= SERVER_KNOBS->RESOLVER_REPARTITION_IMBALANCE * total / count) return;
+
+		std::vector<Key> boundaries(1, Key());
+		for (int i = 1; i < count; i++) {
+			boundaries.push_back(Key(iopsSample.splitEstimate(allKeys, total * i / count)));
+		}
+		std::sort(boundaries.begin(), boundaries.end());
+
+		TraceEvent("ResolverRepartition", dbgid)
+		    .detail("Partitions", count)
+		    .detail("BusiestPartition", busiest)
+		    .detail("TotalSample", total)
+		    .detail("Version", resolvedVersion);
+		partitionedConflictSet->setBoundaries(boundaries, resolvedVersion);
 	}
 
 };
 } // namespace
 
+// Encodes the conflict ranges of a batch as one record of a resolver capture file (see ResolverCaptureBatch)
+static Standalone<StringRef> encodeCaptureRecord(ResolveTransactionBatchRequest const& req) {
+	Arena arena;
+	ResolverCaptureBatch batch;
+	batch.prevVersion = req.prevVersion;
+	batch.version = req.version;
+	batch.transactions.reserve(arena, req.transactions.size());
+	for (auto& tr : req.transactions) {
+		CommitTransactionRef captured;
+		captured.read_conflict_ranges = tr.read_conflict_ranges;
+		captured.write_conflict_ranges = tr.write_conflict_ranges;
+		captured.read_snapshot = tr.read_snapshot;
+		captured.report_conflicting_keys = tr.report_conflicting_keys;
+		batch.transactions.push_back(arena, captured);
+	}
+
+	BinaryWriter payload(IncludeVersion());
+	payload << batch;
+	BinaryWriter record(Unversioned());
+	record << (uint32_t)payload.getLength();
+	record.serializeBytes(payload.getData(), payload.getLength());
+	return record.toValue();
+}
+
+// Writes are chained so that records land in the order they were resolved; a failure stops the capture
+ACTOR Future<Void> writeCaptureRecord(Resolver* self, Reference<IAsyncFile> file, Future<Void> previous,
+                                      Standalone<StringRef> record, int64_t offset) {
+	try {
+		wait(previous);
+		wait(file->write(record.begin(), record.size(), offset));
+	} catch (Error& e) {
+		if (e.code() == error_code_actor_cancelled) throw;
+		if (self->captureFile) {
+			TraceEvent(SevWarnAlways, "ResolverCaptureFailed", self->dbgid).error(e);
+			self->captureFile.clear();
+		}
+	}
+	return Void();
+}
+
 ACTOR Future<Void> resolveBatch(
 	Reference<Resolver> self, 
 	ResolveTransactionBatchRequest req)
@@ -159,6 +252,17 @@ ACTOR Future<Void> resolveBatch(
 		self->resolvedTransactions += req.transactions.size();
 		self->resolvedBytes += req.transactions.expectedSize();
 
+		if (self->captureFile) {
+			Standalone<StringRef> record = encodeCaptureRecord(req);
+			self->captureWrites =
+			    writeCaptureRecord(self.getPtr(), self->captureFile, self->captureWrites, record, self->captureBytes);
+			self->captureBytes += record.size();
+			if (self->captureBytes >= SERVER_KNOBS->RESOLVER_CAPTURE_MAX_BYTES) {
+				TraceEvent("ResolverCaptureComplete", self->dbgid).detail("Bytes", self->captureBytes);
+				self->captureFile.clear();
+			}
+		}
+
 		if(proxyInfo.lastVersion > 0) {
 			proxyInfo.outstandingBatches.erase(proxyInfo.outstandingBatches.begin(), proxyInfo.outstandingBatches.upper_bound(req.lastReceivedVersion));
 		}
@@ -176,22 +280,29 @@ ACTOR Future<Void> resolveBatch(
 
 		// Detect conflicts
 		double expire = now() + SERVER_KNOBS->SAMPLE_EXPIRATION_TIME;
-		ConflictBatch conflictBatch(self->conflictSet, &reply.conflictingKeyRangeMap, &reply.arena);
+		self->maybeRepartition(req.prevVersion);
+		ConflictBatch conflictBatch(self->conflictSet, &reply.conflictingKeyRangeMap, &reply.arena); // Unused if partitioned
 		int keys = 0;
 		for(int t=0; t<req.transactions.size(); t++) {
-			conflictBatch.addTransaction( req.transactions[t] );
+			if (!self->partitionedConflictSet) {
+				conflictBatch.addTransaction( req.transactions[t] );
+			}
 			self->resolvedReadConflictRanges += req.transactions[t].read_conflict_ranges.size();
 			self->resolvedWriteConflictRanges += req.transactions[t].write_conflict_ranges.size();
 			keys += req.transactions[t].write_conflict_ranges.size()*2 + req.transactions[t].read_conflict_ranges.size()*2;
 			
-			if(self->resolverCount > 1) {
+			if(self->sampleKeys()) {
 				for(auto it : req.transactions[t].write_conflict_ranges)
 					self->iopsSample.addAndExpire( it.begin, SERVER_KNOBS->SAMPLE_OFFSET_PER_KEY + it.begin.size(), expire );
 				for(auto it : req.transactions[t].read_conflict_ranges)
 					self->iopsSample.addAndExpire( it.begin, SERVER_KNOBS->SAMPLE_OFFSET_PER_KEY + it.begin.size(), expire );
 			}
 		}
-		conflictBatch.detectConflicts( req.version, req.version - SERVER_KNOBS->MAX_WRITE_TRANSACTION_LIFE_VERSIONS, commitList, &tooOldList);
+		if (!self->partitionedConflictSet) {
+			conflictBatch.detectConflicts( req.version, req.version - SERVER_KNOBS->MAX_WRITE_TRANSACTION_LIFE_VERSIONS, commitList, &tooOldList);
+		} else {
+			self->partitionedConflictSet->resolve( req.transactions, req.version, req.version - SERVER_KNOBS->MAX_WRITE_TRANSACTION_LIFE_VERSIONS, commitList, tooOldList, &reply.conflictingKeyRangeMap, &reply.arena);
+		}
 
 		reply.debugID = req.debugID;
 		reply.committed.resize( reply.arena, req.transactions.size() );
@@ -309,17 +420,55 @@ ACTOR Future<Void> resolveBatch(
 	return Void();
 }
 
+// Removes the conflict history that has aged out of the MVCC window, instead of resolveBatch doing it.  Each slice runs
+// at low priority for at most RESOLVER_PRUNE_SLICE_TIME, so resolving a batch never waits for more than one slice.  A
+// burst that moves the window a long way leaves extra history behind until the following passes have removed it.
+static bool pruneConflictHistorySlice(ConflictSet* conflictSet) {
+	double end = timer() + SERVER_KNOBS->RESOLVER_PRUNE_SLICE_TIME;
+	while (!pruneConflictSet(conflictSet, SERVER_KNOBS->RESOLVER_PRUNE_NODES)) {
+		if (timer() >= end) return false;
+	}
+	return true;
+}
+
+ACTOR Future<Void> pruneConflictHistory(Reference<Resolver> self) {
+	loop {
+		wait(delay(SERVER_KNOBS->RESOLVER_PRUNE_INTERVAL, TaskPriority::Low));
+		while (!pruneConflictHistorySlice(self->conflictSet)) {
+			wait(delay(0, TaskPriority::Low));
+		}
+	}
+}
+
 ACTOR Future<Void> resolverCore(
 	ResolverInterface resolver,
 	InitializeResolverRequest initReq)
 {
 	state Reference<Resolver> self(new Resolver(resolver.id(), initReq.commitProxyCount, initReq.resolverCount));
 	state ActorCollection actors(false);
-	state Future<Void> doPollMetrics = self->resolverCount > 1 ? Void() : Future<Void>(Never());
+	state Future<Void> doPollMetrics = self->sampleKeys() ? Void() : Future<Void>(Never());
 	actors.add( waitFailureServer(resolver.waitFailure.getFuture()) );
 	actors.add( traceRole(Role::RESOLVER, resolver.id()) );
+	if (self->conflictSet && SERVER_KNOBS->RESOLVER_BACKGROUND_PRUNE) {
+		actors.add(pruneConflictHistory(self));
+	}
 
 	TraceEvent("ResolverInit", resolver.id()).detail("RecoveryCount", initReq.recoveryCount);
+
+	if (!SERVER_KNOBS->RESOLVER_CAPTURE_FILE.empty()) {
+		state std::string captureFilename = SERVER_KNOBS->RESOLVER_CAPTURE_FILE + "." + resolver.id().toString();
+		try {
+			Reference<IAsyncFile> captureFile = wait(IAsyncFileSystem::filesystem()->open(
+			    captureFilename,
+			    IAsyncFile::OPEN_NO_AIO | IAsyncFile::OPEN_CREATE | IAsyncFile::OPEN_READWRITE | IAsyncFile::OPEN_UNCACHED,
+			    0600));
+			self->captureFile = captureFile;
+			TraceEvent("ResolverCaptureStart", resolver.id()).detail("File", captureFilename);
+		} catch (Error& e) {
+			if (e.code() == error_code_actor_cancelled) throw;
+			TraceEvent(SevWarnAlways, "ResolverCaptureOpenFailed", resolver.id()).error(e).detail("File", captureFilename);
+		}
+	}
 	loop choose {
 		when ( ResolveTransactionBatchRequest batch = waitNext( resolver.resolve.getFuture() ) ) {
 			actors.add( resolveBatch(self, batch) );
@@ -370,3 +519,32 @@ ACTOR Future<Void> resolver(
 		throw;
 	}
 }
+
+TEST_CASE("/fdbserver/Resolver/captureRecord") {
+	ResolveTransactionBatchRequest req;
+	req.prevVersion = 10;
+	req.version = 20;
+	CommitTransactionRef tr;
+	tr.read_snapshot = 5;
+	tr.read_conflict_ranges.push_back_deep(req.arena, KeyRangeRef(LiteralStringRef("a"), LiteralStringRef("b")));
+	tr.write_conflict_ranges.push_back_deep(req.arena, singleKeyRange(LiteralStringRef("c"), req.arena));
+	tr.mutations.push_back_deep(req.arena, MutationRef(MutationRef::SetValue, LiteralStringRef("c"), LiteralStringRef("v")));
+	req.transactions.push_back(req.arena, tr);
+
+	Standalone<StringRef> record = encodeCaptureRecord(req);
+	uint32_t length;
+	memcpy(&length, record.begin(), sizeof(length));
+	ASSERT(length + sizeof(length) == record.size());
+
+	ResolverCaptureBatch batch;
+	ArenaReader reader(record.arena(), record.substr(sizeof(length)), IncludeVersion());
+	reader >> batch;
+	ASSERT(batch.prevVersion == 10 && batch.version == 20);
+	ASSERT(batch.transactions.size() == 1);
+	ASSERT(batch.transactions[0].read_snapshot == 5);
+	ASSERT(batch.transactions[0].read_conflict_ranges[0] == tr.read_conflict_ranges[0]);
+	ASSERT(batch.transactions[0].write_conflict_ranges[0] == tr.write_conflict_ranges[0]);
+	ASSERT(batch.transactions[0].mutations.empty());
+
+	return Void();
+}
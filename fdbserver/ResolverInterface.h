@@ -160,4 +160,18 @@ struct ResolutionSplitRequest {
 	}
 };
 
+// One resolved batch as written to a RESOLVER_CAPTURE_FILE and read back by -r conflictsetreplay. Only what conflict
+// detection looks at is kept, so the transactions have no mutations. Each record in the file is a 32-bit length
+// followed by the batch serialized with IncludeVersion().
+struct ResolverCaptureBatch {
+	Version prevVersion;
+	Version version;
+	VectorRef<CommitTransactionRef> transactions;
+
+	template <class Archive>
+	void serialize(Archive& ar) {
+		serializer(ar, prevVersion, version, transactions);
+	}
+};
+
 #endif
@@ -745,7 +745,8 @@ ACTOR static Future<Void> handleApplyToDBRequest(RestoreVersionBatchRequest req,
 }
 
 // Copy from WriteDuringRead.actor.cpp with small modifications
-// Not all AtomicOps are handled in this function: SetVersionstampedKey, SetVersionstampedValue, and CompareAndClear
+// Not all AtomicOps are handled in this function: SetVersionstampedKey, SetVersionstampedValue, CompareAndClear, SetIfAbsent
+// and CompareAndSet
 Value applyAtomicOp(Optional<StringRef> existingValue, Value value, MutationRef::Type type) {
 	Arena arena;
 	if (type == MutationRef::AddValue)
@@ -159,6 +159,19 @@ struct StagingKey {
 					val = key;
 					type = MutationRef::ClearRange;
 				} // else no-op
+			} else if (mutation.type == MutationRef::SetIfAbsent || mutation.type == MutationRef::CompareAndSet) {
+				Arena arena;
+				Optional<StringRef> inputVal;
+				if (hasBaseValue()) {
+					inputVal = val;
+				}
+				Optional<ValueRef> retVal = mutation.type == MutationRef::SetIfAbsent
+				                                ? doSetIfAbsent(inputVal, mutation.param2, arena)
+				                                : doCompareAndSet(inputVal, mutation.param2, arena);
+				if (retVal.present()) {
+					val = retVal.get();
+					type = MutationRef::SetValue;
+				} // else no-op
 			} else if (isAtomicOp((MutationRef::Type)mutation.type)) {
 				Optional<StringRef> inputVal;
 				if (hasBaseValue()) {
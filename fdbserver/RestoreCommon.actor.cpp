@@ -306,16 +306,9 @@ std::string RestoreConfigFR::toString() {
 // parallelFileRestore is copied from FileBackupAgent.actor.cpp for the same reason as RestoreConfigFR is copied
 namespace parallelFileRestore {
 
-ACTOR Future<Standalone<VectorRef<KeyValueRef>>> decodeLogFileBlock(Reference<IAsyncFile> file, int64_t offset,
-                                                                    int len) {
-	state Standalone<StringRef> buf = makeString(len);
-	int rLen = wait(file->read(mutateString(buf), len, offset));
-	if (rLen != len) throw restore_bad_read();
-
-	simulateBlobFailure();
-
-	Standalone<VectorRef<KeyValueRef>> results({}, buf.arena());
-	state StringRefReader reader(buf, restore_corrupted_data());
+void decodeLogFileBlock(StringRef buf, Standalone<VectorRef<KeyValueRef>>& results, std::string const& filename,
+                        int64_t offset) {
+	StringRefReader reader(buf, restore_corrupted_data());
 
 	try {
 		// Read header, currently only decoding version BACKUP_AGENT_MLOG_VERSION
@@ -339,18 +332,24 @@ ACTOR Future<Standalone<VectorRef<KeyValueRef>>> decodeLogFileBlock(Reference<IA
 		for (auto b : reader.remainder())
 			if (b != 0xFF) throw restore_corrupted_data_padding();
 
-		return results;
-
 	} catch (Error& e) {
 		TraceEvent(SevError, "FileRestoreCorruptLogFileBlock")
 		    .error(e)
-		    .detail("Filename", file->getFilename())
+		    .detail("Filename", filename)
 		    .detail("BlockOffset", offset)
-		    .detail("BlockLen", len)
+		    .detail("BlockLen", buf.size())
 		    .detail("ErrorRelativeOffset", reader.rptr - buf.begin())
 		    .detail("ErrorAbsoluteOffset", reader.rptr - buf.begin() + offset);
 		throw;
 	}
 }
 
+ACTOR Future<Standalone<VectorRef<KeyValueRef>>> decodeLogFileBlock(Reference<IAsyncFile> file, int64_t offset,
+                                                                    int len) {
+	Standalone<StringRef> buf = wait(fileBackup::readFileBlock(file, offset, len));
+	Standalone<VectorRef<KeyValueRef>> results({}, buf.arena());
+	decodeLogFileBlock(buf, results, file->getFilename(), offset);
+	return results;
+}
+
 } // namespace parallelFileRestore
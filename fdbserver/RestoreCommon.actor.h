@@ -248,6 +248,11 @@ struct RestoreFileFR {
 namespace parallelFileRestore {
 ACTOR Future<Standalone<VectorRef<KeyValueRef>>> decodeLogFileBlock(Reference<IAsyncFile> file, int64_t offset,
                                                                     int len);
+
+// Decode a log file block that was read from filename at offset into results, whose arena must keep buf alive.
+// Touches nothing but its arguments, so it can run off the network thread.
+void decodeLogFileBlock(StringRef buf, Standalone<VectorRef<KeyValueRef>>& results, std::string const& filename,
+                        int64_t offset);
 } // namespace parallelFileRestore
 
 // Send each request in requests via channel of the request's interface.
@@ -21,6 +21,8 @@
 // This file implements the functions and actors used by the RestoreLoader role.
 // The RestoreLoader role starts with the restoreLoaderCore actor
 
+#include <atomic>
+#include <thread>
 #include "flow/UnitTest.h"
 #include "fdbclient/BackupContainer.h"
 #include "fdbclient/BackupAgent.actor.h"
@@ -57,16 +59,113 @@ ACTOR Future<Void> sendMutationsToApplier(
     std::map<UID, RestoreApplierInterface>* pApplierInterfaces);
 ACTOR static Future<Void> _parseLogFileToMutationsOnLoader(NotifiedVersion* pProcessedFileOffset,
                                                            SerializedMutationListMap* mutationMap,
-                                                           Reference<IBackupContainer> bc, RestoreAsset asset);
+                                                           Reference<IBackupContainer> bc,
+                                                           Reference<IThreadPool> decodeThreads, RestoreAsset asset);
 ACTOR static Future<Void> parseLogFileToMutationsOnLoader(NotifiedVersion* pProcessedFileOffset,
                                                           SerializedMutationListMap* mutationMap,
-                                                          Reference<IBackupContainer> bc, RestoreAsset asset);
+                                                          Reference<IBackupContainer> bc,
+                                                          Reference<IThreadPool> decodeThreads, RestoreAsset asset);
 ACTOR static Future<Void> _parseRangeFileToMutationsOnLoader(
     std::map<LoadingParam, VersionedMutationsMap>::iterator kvOpsIter,
     std::map<LoadingParam, SampledMutationsVec>::iterator samplesIter, LoaderCounters* cc,
-    Reference<IBackupContainer> bc, Version version, RestoreAsset asset);
+    Reference<IBackupContainer> bc, Reference<IThreadPool> decodeThreads, Version version, RestoreAsset asset);
 ACTOR Future<Void> handleFinishVersionBatchRequest(RestoreVersionBatchRequest req, Reference<RestoreLoaderData> self);
 
+static void decodeBlock(bool isRangeFile, StringRef block, Standalone<VectorRef<KeyValueRef>>& results,
+                        std::string const& filename, int64_t offset) {
+	if (isRangeFile) {
+		fileBackup::decodeRangeFileBlock(block, results, filename, offset);
+	} else {
+		parallelFileRestore::decodeLogFileBlock(block, results, filename, offset);
+	}
+}
+
+// A block decode handed to a loader's decode threads.  The block and results belong to the readAndDecodeBlock() actor
+// that posted it, so if that actor is cancelled it must either stop the job before it starts or wait for it to finish.
+struct BlockDecodeJob : ThreadSafeReferenceCounted<BlockDecodeJob> {
+	enum Phase { Queued, Running, Done, Abandoned };
+
+	bool isRangeFile;
+	StringRef block;
+	Standalone<VectorRef<KeyValueRef>>* results;
+	std::string filename;
+	int64_t offset;
+	std::atomic<int> phase{ Queued };
+	ThreadReturnPromise<Void> done;
+
+	void waitUntilSafe() {
+		int expected = Queued;
+		if (phase.compare_exchange_strong(expected, Abandoned)) {
+			return;
+		}
+		while (phase.load() != Done) {
+			std::this_thread::yield();
+		}
+	}
+};
+
+struct BlockDecoder final : IThreadPoolReceiver {
+	void init() override {}
+
+	struct Decode final : TypedAction<BlockDecoder, Decode> {
+		explicit Decode(Reference<BlockDecodeJob> job) : job(job) {}
+		double getTimeEstimate() const override { return 0.001; }
+		Reference<BlockDecodeJob> job;
+	};
+
+	void action(Decode& d) {
+		BlockDecodeJob& job = *d.job;
+		int expected = BlockDecodeJob::Queued;
+		if (!job.phase.compare_exchange_strong(expected, BlockDecodeJob::Running)) {
+			job.done.send(Void());
+			return;
+		}
+		try {
+			decodeBlock(job.isRangeFile, job.block, *job.results, job.filename, job.offset);
+			job.phase.store(BlockDecodeJob::Done);
+			job.done.send(Void());
+		} catch (Error& e) {
+			job.phase.store(BlockDecodeJob::Done);
+			job.done.sendError(e);
+		} catch (...) {
+			job.phase.store(BlockDecodeJob::Done);
+			job.done.sendError(unknown_error());
+		}
+	}
+};
+
+// Reads a block of a range or log file and decodes it on one of decodeThreads, or on the network thread if there are
+// none.  The blocks of a file are read and decoded in parallel, and their results are merged on the network thread.
+ACTOR static Future<Standalone<VectorRef<KeyValueRef>>> readAndDecodeBlock(Reference<IThreadPool> decodeThreads,
+                                                                           Reference<IAsyncFile> file,
+                                                                           bool isRangeFile, int64_t offset, int len) {
+	state Standalone<StringRef> block = wait(fileBackup::readFileBlock(file, offset, len));
+	// The results point into block
+	state Standalone<VectorRef<KeyValueRef>> results({}, block.arena());
+	if (!decodeThreads) {
+		decodeBlock(isRangeFile, block, results, file->getFilename(), offset);
+		return results;
+	}
+
+	state Reference<BlockDecodeJob> job(new BlockDecodeJob());
+	job->isRangeFile = isRangeFile;
+	job->block = block;
+	job->results = &results;
+	job->filename = file->getFilename();
+	job->offset = offset;
+	state Future<Void> decoded = job->done.getFuture();
+	decodeThreads->post(new BlockDecoder::Decode(job));
+	try {
+		wait(decoded);
+	} catch (Error& e) {
+		if (e.code() == error_code_actor_cancelled) {
+			job->waitUntilSafe();
+		}
+		throw;
+	}
+	return results;
+}
+
 // Dispatch requests based on node's business (i.e, cpu usage for now) and requests' priorities
 // Requests for earlier version batches are preferred; which is equivalent to
 // sendMuttionsRequests are preferred than loadingFileRequests
@@ -219,6 +318,13 @@ ACTOR Future<Void> dispatchRequests(Reference<RestoreLoaderData> self) {
 ACTOR Future<Void> restoreLoaderCore(RestoreLoaderInterface loaderInterf, int nodeIndex, Database cx,
                                      RestoreControllerInterface ci) {
 	state Reference<RestoreLoaderData> self = makeReference<RestoreLoaderData>(loaderInterf.id(), nodeIndex, ci);
+	// Blocks are only decoded on threads outside of simulation, which must stay deterministic
+	if (!g_network->isSimulated() && SERVER_KNOBS->FASTRESTORE_LOADER_DECODE_THREADS > 0) {
+		self->decodeThreads = createGenericThreadPool();
+		for (int i = 0; i < SERVER_KNOBS->FASTRESTORE_LOADER_DECODE_THREADS; ++i) {
+			self->decodeThreads->addThread(new BlockDecoder());
+		}
+	}
 	state Future<Void> error = actorCollection(self->addActor.getFuture());
 	state ActorCollection actors(false); // actors whose errors can be ignored
 	state Future<Void> exitRole = Never();
@@ -372,19 +478,28 @@ ACTOR static Future<Void> _parsePartitionedLogFileOnLoader(
 	StringRefReader reader(buf, restore_corrupted_data());
 	try {
 		// Read block header
-		if (reader.consume<int32_t>() != PARTITIONED_MLOG_VERSION) throw restore_unsupported_file_version();
+		int32_t blockVersion = reader.consume<int32_t>();
+		Standalone<StringRef> records = buf;
+		if (blockVersion == PARTITIONED_MLOG_COMPRESSED_VERSION) {
+			records = fileBackup::decodeCompressedLogBlock(reader);
+		} else if (blockVersion != PARTITIONED_MLOG_VERSION) {
+			throw restore_unsupported_file_version();
+		}
+		StringRefReader recordReader = blockVersion == PARTITIONED_MLOG_VERSION
+		                                   ? reader
+		                                   : StringRefReader(records, restore_corrupted_data());
 
 		VersionedMutationsMap& kvOps = kvOpsIter->second;
 		while (1) {
 			// If eof reached or first key len bytes is 0xFF then end of block was reached.
-			if (reader.eof() || *reader.rptr == 0xFF) break;
+			if (recordReader.eof() || *recordReader.rptr == 0xFF) break;
 
 			// Deserialize messages written in saveMutationsToFile().
 			LogMessageVersion msgVersion;
-			msgVersion.version = reader.consumeNetworkUInt64();
-			msgVersion.sub = reader.consumeNetworkUInt32();
-			int msgSize = reader.consumeNetworkInt32();
-			const uint8_t* message = reader.consume(msgSize);
+			msgVersion.version = recordReader.consumeNetworkUInt64();
+			msgVersion.sub = recordReader.consumeNetworkUInt32();
+			int msgSize = recordReader.consumeNetworkInt32();
+			const uint8_t* message = recordReader.consume(msgSize);
 
 			// Skip mutations out of the version range
 			if (!asset.isInVersionRange(msgVersion.version)) continue;
@@ -397,7 +512,7 @@ ACTOR static Future<Void> _parsePartitionedLogFileOnLoader(
 			// only one clear mutation is generated (i.e., always inserted).
 			ASSERT(inserted);
 
-			ArenaReader rd(buf.arena(), StringRef(message, msgSize), AssumeVersion(g_network->protocolVersion()));
+			ArenaReader rd(records.arena(), StringRef(message, msgSize), AssumeVersion(g_network->protocolVersion()));
 			MutationRef mutation;
 			rd >> mutation;
 
@@ -446,6 +561,9 @@ ACTOR static Future<Void> _parsePartitionedLogFileOnLoader(
 				                                   SampledMutation(mutation.param1, sampleInfo.sampledSize));
 			}
 		}
+		if (blockVersion == PARTITIONED_MLOG_VERSION) {
+			reader = recordReader;
+		}
 
 		// Make sure any remaining bytes in the block are 0xFF
 		for (auto b : reader.remainder()) {
@@ -499,7 +617,7 @@ ACTOR static Future<Void> parsePartitionedLogFileOnLoader(
 
 ACTOR Future<Void> _processLoadingParam(KeyRangeMap<Version>* pRangeVersions, LoadingParam param,
                                         Reference<LoaderBatchData> batchData, UID loaderID,
-                                        Reference<IBackupContainer> bc) {
+                                        Reference<IBackupContainer> bc, Reference<IThreadPool> decodeThreads) {
 	// Temporary data structure for parsing log files into (version, <K, V, mutationType>)
 	// Must use StandAlone to save mutations, otherwise, the mutationref memory will be corrupted
 	// mutationMap: Key is the unique identifier for a batch of mutation logs at the same version
@@ -528,8 +646,9 @@ ACTOR Future<Void> _processLoadingParam(KeyRangeMap<Version>* pRangeVersions, Lo
 		subAsset.offset = j;
 		subAsset.len = std::min<int64_t>(param.blockSize, param.asset.len - j);
 		if (param.isRangeFile) {
-			fileParserFutures.push_back(_parseRangeFileToMutationsOnLoader(
-			    kvOpsPerLPIter, samplesIter, &batchData->counters, bc, param.rangeVersion.get(), subAsset));
+			fileParserFutures.push_back(_parseRangeFileToMutationsOnLoader(kvOpsPerLPIter, samplesIter,
+			                                                               &batchData->counters, bc, decodeThreads,
+			                                                               param.rangeVersion.get(), subAsset));
 		} else {
 			// TODO: Sanity check the log file's range is overlapped with the restored version range
 			if (param.isPartitionedLog()) {
@@ -537,8 +656,8 @@ ACTOR Future<Void> _processLoadingParam(KeyRangeMap<Version>* pRangeVersions, Lo
 				                                                            kvOpsPerLPIter, samplesIter,
 				                                                            &batchData->counters, bc, subAsset));
 			} else {
-				fileParserFutures.push_back(
-				    parseLogFileToMutationsOnLoader(&processedFileOffset, &mutationMap, bc, subAsset));
+				fileParserFutures.push_back(parseLogFileToMutationsOnLoader(&processedFileOffset, &mutationMap, bc,
+				                                                            decodeThreads, subAsset));
 			}
 		}
 	}
@@ -586,7 +705,7 @@ ACTOR Future<Void> handleLoadFileRequest(RestoreLoadFileRequest req, Reference<R
 		    .detail("ProcessLoadParam", req.param.toString());
 		ASSERT(batchData->sampleMutations.find(req.param) == batchData->sampleMutations.end());
 		batchData->processedFileParams[req.param] =
-		    _processLoadingParam(&self->rangeVersions, req.param, batchData, self->id(), self->bc);
+		    _processLoadingParam(&self->rangeVersions, req.param, batchData, self->id(), self->bc, self->decodeThreads);
 		self->inflightLoadingReqs++;
 		isDuplicated = false;
 	} else {
@@ -813,10 +932,13 @@ ACTOR Future<Void> sendMutationsToApplier(
 	state int mIndex = 0;
 	state LogMessageVersion commitVersion;
 	state std::vector<Future<Void>> fSends;
+	// Versions below sentVersions[i] are fully contained in messages up to fSends[i]
+	state std::vector<LogMessageVersion> sentVersions;
+	state int ackedSends = 0;
 	for (auto& applierID : applierIDs) {
 		applierVersionedMutationsBuffer[applierID] = VersionedMutationsVec();
 	}
-	KeyRangeMap<UID> krMap;
+	state KeyRangeMap<UID> krMap;
 	buildApplierRangeMap(&krMap, pRangeToApplier);
 	for (kvOp = kvOps.begin(); kvOp != kvOps.end(); kvOp++) {
 		commitVersion = kvOp->first;
@@ -890,11 +1012,20 @@ ACTOR Future<Void> sendMutationsToApplier(
 				    .detail("Requests", requests.size());
 				fSends.push_back(sendBatchRequests(&RestoreApplierInterface::sendMutationVector, *pApplierInterfaces,
 				                                   requests, TaskPriority::RestoreLoaderSendMutations));
+				sentVersions.push_back(commitVersion);
 				msgIndex++;
 				msgSize = 0;
 				for (auto& applierID : applierIDs) {
 					applierVersionedMutationsBuffer[applierID] = VersionedMutationsVec();
 				}
+
+				// Appliers apply an asset's messages in msgIndex order, so bound the messages waiting on them and
+				// free the mutations of versions they have acknowledged instead of holding the asset until the end.
+				while (fSends.size() - ackedSends >= SERVER_KNOBS->FASTRESTORE_LOADER_SEND_INFLIGHT_MSGS) {
+					wait(fSends[ackedSends]);
+					kvOps.erase(kvOps.begin(), kvOps.lower_bound(sentVersions[ackedSends]));
+					ackedSends++;
+				}
 			}
 		} // Mutations at the same LogMessageVersion
 	} // all versions of mutations in the same file
@@ -1039,7 +1170,7 @@ void _parseSerializedMutation(KeyRangeMap<Version>* pRangeVersions,
 	Arena tempArena;
 	for (auto& m : mutationMap) {
 		StringRef k = m.first.contents();
-		StringRef val = m.second.first.contents();
+		StringRef val = expandBackupLogValue(tempArena, m.second.first.contents());
 
 		StringRefReader kReader(k, restore_corrupted_data());
 		uint64_t commitVersion = kReader.consume<uint64_t>(); // Consume little Endian data
@@ -1126,12 +1257,13 @@ void _parseSerializedMutation(KeyRangeMap<Version>* pRangeVersions,
 // kvOpsIter: saves the parsed versioned-mutations for the sepcific LoadingParam;
 // samplesIter: saves the sampled mutations from the parsed versioned-mutations;
 // bc: backup container to read the backup file
+// decodeThreads: threads to decode the block on, if any
 // version: the version the parsed mutations should be at
 // asset: RestoreAsset about which backup data should be parsed
 ACTOR static Future<Void> _parseRangeFileToMutationsOnLoader(
     std::map<LoadingParam, VersionedMutationsMap>::iterator kvOpsIter,
     std::map<LoadingParam, SampledMutationsVec>::iterator samplesIter, LoaderCounters* cc,
-    Reference<IBackupContainer> bc, Version version, RestoreAsset asset) {
+    Reference<IBackupContainer> bc, Reference<IThreadPool> decodeThreads, Version version, RestoreAsset asset) {
 	state VersionedMutationsMap& kvOps = kvOpsIter->second;
 	state SampledMutationsVec& sampleMutations = samplesIter->second;
 
@@ -1154,7 +1286,7 @@ ACTOR static Future<Void> _parseRangeFileToMutationsOnLoader(
 			// version
 			Reference<IAsyncFile> inFile = wait(bc->readFile(asset.filename));
 			Standalone<VectorRef<KeyValueRef>> kvs =
-			    wait(fileBackup::decodeRangeFileBlock(inFile, asset.offset, asset.len));
+			    wait(readAndDecodeBlock(decodeThreads, inFile, true, asset.offset, asset.len));
 			TraceEvent("FastRestoreLoaderDecodedRangeFile")
 			    .detail("BatchIndex", asset.batchIndex)
 			    .detail("Filename", asset.filename)
@@ -1251,11 +1383,13 @@ ACTOR static Future<Void> _parseRangeFileToMutationsOnLoader(
 // pMutationMap: concatenated mutation list string at the mutation's commit version
 ACTOR static Future<Void> _parseLogFileToMutationsOnLoader(NotifiedVersion* pProcessedFileOffset,
                                                            SerializedMutationListMap* pMutationMap,
-                                                           Reference<IBackupContainer> bc, RestoreAsset asset) {
+                                                           Reference<IBackupContainer> bc,
+                                                           Reference<IThreadPool> decodeThreads, RestoreAsset asset) {
 	Reference<IAsyncFile> inFile = wait(bc->readFile(asset.filename));
-	// decodeLogFileBlock() must read block by block!
+	// Log files must be decoded block by block! The blocks of a file are decoded in parallel, but concatenated below in
+	// file order.
 	state Standalone<VectorRef<KeyValueRef>> data =
-	    wait(parallelFileRestore::decodeLogFileBlock(inFile, asset.offset, asset.len));
+	    wait(readAndDecodeBlock(decodeThreads, inFile, false, asset.offset, asset.len));
 	TraceEvent("FastRestoreLoaderDecodeLogFile")
 	    .detail("BatchIndex", asset.batchIndex)
 	    .detail("RestoreAsset", asset.toString())
@@ -1278,11 +1412,12 @@ ACTOR static Future<Void> _parseLogFileToMutationsOnLoader(NotifiedVersion* pPro
 // retry on _parseLogFileToMutationsOnLoader
 ACTOR static Future<Void> parseLogFileToMutationsOnLoader(NotifiedVersion* pProcessedFileOffset,
                                                           SerializedMutationListMap* pMutationMap,
-                                                          Reference<IBackupContainer> bc, RestoreAsset asset) {
+                                                          Reference<IBackupContainer> bc,
+                                                          Reference<IThreadPool> decodeThreads, RestoreAsset asset) {
 	state int readFileRetries = 0;
 	loop {
 		try {
-			wait(_parseLogFileToMutationsOnLoader(pProcessedFileOffset, pMutationMap, bc, asset));
+			wait(_parseLogFileToMutationsOnLoader(pProcessedFileOffset, pMutationMap, bc, decodeThreads, asset));
 			break;
 		} catch (Error& e) {
 			if (e.code() == error_code_restore_bad_read || e.code() == error_code_restore_unsupported_file_version ||
@@ -1440,7 +1575,7 @@ TEST_CASE("/FastRestore/RestoreLoader/splitMutation") {
 	ASSERT(mvector.size() == nodeIDs.size());
 
 	// Method 2: Use new intersection based method
-	KeyRangeMap<UID> krMap;
+	state KeyRangeMap<UID> krMap;
 	buildApplierRangeMap(&krMap, &rangeToApplier);
 
 	MutationsVec mvector2;
@@ -32,6 +32,7 @@
 #include "fdbclient/CommitTransaction.h"
 #include "fdbrpc/fdbrpc.h"
 #include "fdbrpc/Stats.h"
+#include "flow/IThreadPool.h"
 #include "fdbserver/CoordinationInterface.h"
 #include "fdbrpc/Locality.h"
 #include "fdbclient/RestoreWorkerInterface.actor.h"
@@ -163,6 +164,9 @@ struct RestoreLoaderData : RestoreRoleData, public ReferenceCounted<RestoreLoade
 	Reference<IBackupContainer> bc; // Backup container is used to read backup files
 	Key bcUrl; // The url used to get the bc
 
+	// Threads that decode backup file blocks; without them blocks are decoded on the network thread
+	Reference<IThreadPool> decodeThreads;
+
 	// Request scheduler
 	std::priority_queue<RestoreLoadFileRequest> loadingQueue; // request queue of loading files
 	std::priority_queue<RestoreSendMutationsToAppliersRequest>
@@ -66,6 +66,26 @@ struct ServerDBInfo {
 	void serialize( Ar& ar ) {
 		serializer(ar, id, clusterInterface, client, distributor, master, ratekeeper, resolvers, recoveryCount, recoveryState, masterLifetime, logSystemConfig, priorCommittedLogServers, latencyBandConfig, infoGeneration);
 	}
+
+	// Calls f(index, field) for each serialized field, so that a delta can carry just the fields that changed.
+	// New fields must be added at the end.
+	template <class Info, class F>
+	static void forEachField(Info& info, F&& f) {
+		f(0, info.id);
+		f(1, info.clusterInterface);
+		f(2, info.client);
+		f(3, info.distributor);
+		f(4, info.master);
+		f(5, info.ratekeeper);
+		f(6, info.resolvers);
+		f(7, info.recoveryCount);
+		f(8, info.recoveryState);
+		f(9, info.masterLifetime);
+		f(10, info.logSystemConfig);
+		f(11, info.priorCommittedLogServers);
+		f(12, info.latencyBandConfig);
+		f(13, info.infoGeneration);
+	}
 };
 
 struct UpdateServerDBInfoRequest {
@@ -73,10 +93,12 @@ struct UpdateServerDBInfoRequest {
 	Standalone<StringRef> serializedDbInfo;
 	std::vector<Endpoint> broadcastInfo;
 	ReplyPromise<std::vector<Endpoint>> reply;
+	// If present, serializedDbInfo is a delta from encodeServerDBInfoDelta against the ServerDBInfo with this id
+	Optional<UID> deltaBase;
 
 	template <class Ar>
 	void serialize(Ar& ar) {
-		serializer(ar, serializedDbInfo, broadcastInfo, reply);
+		serializer(ar, serializedDbInfo, broadcastInfo, reply, deltaBase);
 	}
 };
 
@@ -94,7 +116,21 @@ struct GetServerDBInfoRequest {
 
 ACTOR Future<Void> broadcastTxnRequest(TxnStateRequest req, int sendAmount, bool sendReply);
 
+// Moves req.data into req.compressedData if TXN_STATE_COMPRESSION is set and that makes it smaller
+void compressTxnStateRequest(TxnStateRequest& req);
+// Restores req.data from req.compressedData, if the request was compressed
+void decompressTxnStateRequest(TxnStateRequest& req);
+
 ACTOR Future<std::vector<Endpoint>> broadcastDBInfoRequest(UpdateServerDBInfoRequest req, int sendAmount, Optional<Endpoint> sender, bool sendReply);
 
+// Serializes each field of info separately, as the input to encodeServerDBInfoDelta
+std::vector<Standalone<StringRef>> serializeServerDBInfoFields(ServerDBInfo const& info);
+// Encodes the fields that differ between two results of serializeServerDBInfoFields
+Standalone<StringRef> encodeServerDBInfoDelta(std::vector<Standalone<StringRef>> const& base,
+                                              std::vector<Standalone<StringRef>> const& fields);
+// Decodes the ServerDBInfo carried by req, or returns an empty Optional if req is a delta against an info other than
+// current
+Optional<ServerDBInfo> decodeServerDBInfoRequest(UpdateServerDBInfoRequest const& req, ServerDBInfo const& current);
+
 #include "flow/unactorcompiler.h"
 #endif
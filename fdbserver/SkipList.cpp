@@ -22,6 +22,7 @@
 #include <memory.h>
 #include <stdio.h>
 #include <algorithm>
+#include <cinttypes>
 #include <numeric>
 #include <string>
 #include <vector>
@@ -32,7 +33,17 @@
 #include "fdbclient/FDBTypes.h"
 #include "fdbclient/KeyRangeMap.h"
 #include "fdbclient/SystemData.h"
+#include "fdbserver/ArtVersionHistory.h"
 #include "fdbserver/ConflictSet.h"
+#include "fdbserver/Knobs.h"
+#include "fdbserver/ResolverInterface.h"
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
 
 using std::max;
 using std::min;
@@ -222,12 +233,21 @@ private:
 		return level;
 	}
 
+	// The first 8 bytes of a key, zero padded, as a big endian integer.  Comparing prefixes as integers orders keys
+	// the same way memcmp does, so most comparisons during a finger walk are decided without touching the key bytes.
+	static force_inline uint64_t keyPrefix(const uint8_t* key, int length) {
+		uint64_t p = 0;
+		memcpy(&p, key, min(length, 8));
+		return bigEndian64(p);
+	}
+
 	// Represent a node in the SkipList. The node has multiple (i.e., level) pointers to
 	// other nodes, and keeps a record of the max versions for each level.
 	struct Node {
 		int level() const { return nPointers - 1; }
 		uint8_t* value() { return end() + nPointers * (sizeof(Node*) + sizeof(Version)); }
 		int length() const { return valueLength; }
+		uint64_t prefix() const { return valuePrefix; }
 
 		// Returns the next node pointer at the given level.
 		Node* getNext(int level) { return *((Node**)end() + level); }
@@ -262,6 +282,7 @@ private:
 			if (value.size() > 0) {
 				memcpy(n->value(), value.begin(), value.size());
 			}
+			n->valuePrefix = keyPrefix(value.begin(), value.size());
 			return n;
 		}
 
@@ -294,6 +315,7 @@ private:
 		uint8_t* end() { return (uint8_t*)(this + 1); }
 		uint8_t const* end() const { return (uint8_t const*)(this + 1); }
 		int nPointers, valueLength;
+		uint64_t valuePrefix; // keyPrefix() of value, stored inline so it shares a cache line with the pointers
 	};
 
 	static force_inline bool less(const uint8_t* a, int aLen, const uint8_t* b, int bLen) {
@@ -303,6 +325,15 @@ private:
 		return aLen < bLen;
 	}
 
+	// less() for keys whose keyPrefix() is known.  Only keys sharing their first 8 bytes need a memcmp.
+	static force_inline bool less(uint64_t aPrefix, const uint8_t* a, int aLen, uint64_t bPrefix, const uint8_t* b,
+	                              int bLen) {
+		if (aPrefix != bPrefix) return aPrefix < bPrefix;
+		// Equal prefixes with a key of at most 8 bytes means that key is a prefix of the other (zero padding included)
+		if (aLen <= 8 || bLen <= 8) return aLen < bLen;
+		return less(a + 8, aLen - 8, b + 8, bLen - 8);
+	}
+
 	Node* header;
 
 	void destroy() {
@@ -324,12 +355,19 @@ public:
 		Node* x = nullptr;
 		Node* alreadyChecked = nullptr;
 		StringRef value;
+		uint64_t valuePrefix = 0;
 
 		Finger() = default;
-		Finger(Node* header, const StringRef& ptr) : value(ptr), x(header) {}
+		Finger(Node* header, const StringRef& ptr)
+		  : x(header), value(ptr), valuePrefix(keyPrefix(ptr.begin(), ptr.size())) {}
 
-		void init(const StringRef& value, Node* header) {
+		void setValue(const StringRef& value) {
 			this->value = value;
+			valuePrefix = keyPrefix(value.begin(), value.size());
+		}
+
+		void init(const StringRef& value, Node* header) {
+			setValue(value);
 			x = header;
 			alreadyChecked = nullptr;
 			level = MaxLevels;
@@ -349,7 +387,8 @@ public:
 		force_inline bool advance() {
 			Node* next = x->getNext(level - 1);
 
-			if (next == alreadyChecked || !less(next->value(), next->length(), value.begin(), value.size())) {
+			if (next == alreadyChecked ||
+			    !less(next->prefix(), next->value(), next->length(), valuePrefix, value.begin(), value.size())) {
 				alreadyChecked = next;
 				level--;
 				finger[level] = x;
@@ -372,7 +411,8 @@ public:
 		force_inline Node* found() const {
 			// valid after finished returns true
 			Node* n = finger[0]->getNext(0); // or alreadyChecked, but that is more easily invalidated
-			if (n && n->length() == value.size() && !memcmp(n->value(), value.begin(), value.size()))
+			if (n && n->prefix() == valuePrefix && n->length() == value.size() &&
+			    !memcmp(n->value(), value.begin(), value.size()))
 				return n;
 			else
 				return nullptr;
@@ -496,10 +536,12 @@ public:
 		// vtune: 11 parts
 		results[0].init(values[0], header);
 		const StringRef& endValue = values[count - 1];
+		const uint64_t endPrefix = keyPrefix(endValue.begin(), endValue.size());
 		while (results[0].level > 1) {
 			results[0].nextLevel();
 			Node* ac = results[0].alreadyChecked;
-			if (ac && less(ac->value(), ac->length(), endValue.begin(), endValue.size())) break;
+			if (ac && less(ac->prefix(), ac->value(), ac->length(), endPrefix, endValue.begin(), endValue.size()))
+				break;
 		}
 
 		// Init all the other fingers to start descending where we stopped
@@ -513,7 +555,7 @@ public:
 			results[i].level = startLevel;
 			results[i].x = x;
 			results[i].alreadyChecked = nullptr;
-			results[i].value = values[i];
+			results[i].setValue(values[i]);
 			for (int j = startLevel; j < MaxLevels; j++) results[i].finger[j] = results[0].finger[j];
 		}
 
@@ -728,19 +770,58 @@ private:
 };
 
 struct ConflictSet {
-	ConflictSet() : oldestVersion(0), removalKey(makeString(0)) {}
+	ConflictSet() : oldestVersion(0), removalKey(makeString(0)), inlinePrune(true) {
+		if (SERVER_KNOBS->RESOLVER_ART_CONFLICT_SET) {
+			artHistory = std::make_unique<ArtVersionHistory>(0);
+		}
+	}
 	~ConflictSet() {}
 
+	// Exactly one of versionHistory and artHistory is used: the SkipList, or artHistory if it is set
 	SkipList versionHistory;
+	std::unique_ptr<ArtVersionHistory> artHistory;
 	Key removalKey;
 	Version oldestVersion;
+	bool inlinePrune; // Whether detectConflicts removes aged out history itself, rather than leaving it to pruneConflictSet
+
+	int count() const { return artHistory ? artHistory->count() : versionHistory.count(); }
 };
 
 ConflictSet* newConflictSet() {
 	return new ConflictSet;
 }
+void setConflictSetInlinePrune(ConflictSet* cs, bool inlinePrune) {
+	cs->inlinePrune = inlinePrune;
+}
+
+// Examines up to nodeCount entries of history from where the last removal stopped, removing those older than
+// oldestVersion.  Returns true if it reached the end of the history, so that the next removal starts over.
+static bool removeBefore(ConflictSet* cs, int nodeCount) {
+	if (cs->artHistory) {
+		cs->removalKey = cs->artHistory->removeBefore(cs->oldestVersion, cs->removalKey, nodeCount);
+	} else {
+		SkipList::Finger finger;
+		int temp;
+		cs->versionHistory.find(&cs->removalKey, &finger, &temp, 1);
+		cs->versionHistory.removeBefore(cs->oldestVersion, finger, nodeCount);
+		cs->removalKey = finger.getValue();
+	}
+	return cs->removalKey.size() == 0;
+}
+
+bool pruneConflictSet(ConflictSet* cs, int nodeCount) {
+	double t = timer();
+	bool wrapped = removeBefore(cs, nodeCount);
+	g_removeBefore += timer() - t;
+	return wrapped;
+}
+
 void clearConflictSet(ConflictSet* cs, Version v) {
-	SkipList(v).swap(cs->versionHistory);
+	if (cs->artHistory) {
+		cs->artHistory->clear(v);
+	} else {
+		SkipList(v).swap(cs->versionHistory);
+	}
 }
 void destroyConflictSet(ConflictSet* cs) {
 	delete cs;
@@ -880,11 +961,9 @@ void ConflictBatch::detectConflicts(Version now, Version newOldestVersion, std::
 	t = timer();
 	if (newOldestVersion > cs->oldestVersion) {
 		cs->oldestVersion = newOldestVersion;
-		SkipList::Finger finger;
-		int temp;
-		cs->versionHistory.find(&cs->removalKey, &finger, &temp, 1);
-		cs->versionHistory.removeBefore(cs->oldestVersion, finger, combinedWriteConflictRanges.size() * 3 + 10);
-		cs->removalKey = finger.getValue();
+		if (cs->inlinePrune) {
+			removeBefore(cs, combinedWriteConflictRanges.size() * 3 + 10);
+		}
 	}
 	g_removeBefore += timer() - t;
 }
@@ -892,6 +971,16 @@ void ConflictBatch::detectConflicts(Version now, Version newOldestVersion, std::
 void ConflictBatch::checkReadConflictRanges() {
 	if (combinedReadConflictRanges.empty()) return;
 
+	if (cs->artHistory) {
+		for (const ReadConflictRange& r : combinedReadConflictRanges) {
+			if (cs->artHistory->intersects(r.begin, r.end, r.version)) {
+				transactionConflictStatus[r.transaction] = true;
+				if (r.conflictingKeyRange != nullptr) r.conflictingKeyRange->push_back(*r.cKRArena, r.indexInTx);
+			}
+		}
+		return;
+	}
+
 	cs->versionHistory.detectConflicts(&combinedReadConflictRanges[0], combinedReadConflictRanges.size(),
 	                                   transactionConflictStatus);
 }
@@ -920,6 +1009,13 @@ void ConflictBatch::addConflictRanges(Version now, std::vector<std::pair<StringR
 void ConflictBatch::mergeWriteConflictRanges(Version now) {
 	if (combinedWriteConflictRanges.empty()) return;
 
+	if (cs->artHistory) {
+		for (const auto& range : combinedWriteConflictRanges) {
+			cs->artHistory->addConflictRange(range.first, range.second, now);
+		}
+		return;
+	}
+
 	addConflictRanges(now, combinedWriteConflictRanges.begin(), combinedWriteConflictRanges.end(), &cs->versionHistory);
 }
 
@@ -1099,5 +1195,140 @@ void skipListTest() {
 		printf("%20s: %s\n", counter->getMetric().name().c_str(), counter->getMetric().formatted().c_str());
 	}
 
-	printf("%d entries in version history\n", cs->versionHistory.count());
+	printf("%d entries in version history\n", cs->count());
+}
+
+namespace {
+// Counts the hardware cache misses of this thread while it runs, where the platform and permissions allow it
+struct CacheMissCounter {
+	int fd = -1;
+
+	CacheMissCounter() {
+#ifdef __linux__
+		perf_event_attr attr;
+		memset(&attr, 0, sizeof(attr));
+		attr.type = PERF_TYPE_HARDWARE;
+		attr.size = sizeof(attr);
+		attr.config = PERF_COUNT_HW_CACHE_MISSES;
+		attr.disabled = 1;
+		attr.exclude_kernel = 1;
+		attr.exclude_hv = 1;
+		fd = syscall(__NR_perf_event_open, &attr, 0, -1, -1, 0);
+#endif
+	}
+	~CacheMissCounter() {
+#ifdef __linux__
+		if (fd >= 0) close(fd);
+#endif
+	}
+
+	bool available() const { return fd >= 0; }
+
+	void start() {
+#ifdef __linux__
+		if (fd >= 0) {
+			ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+			ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+		}
+#endif
+	}
+
+	uint64_t stop() {
+		uint64_t count = 0;
+#ifdef __linux__
+		if (fd >= 0) {
+			ioctl(fd, PERF_EVENT_IOC_DISABLE, 0);
+			if (read(fd, &count, sizeof(count)) != sizeof(count)) count = 0;
+		}
+#endif
+		return count;
+	}
+};
+} // namespace
+
+// Replays a file captured by a resolver with RESOLVER_CAPTURE_FILE through a new ConflictSet, as the resolver would
+// have resolved it, so that conflict set changes can be measured against production key distributions.  Knobs such
+// as RESOLVER_ART_CONFLICT_SET select the implementation being measured.
+void conflictSetReplay(std::string const& captureFile) {
+	printf("Conflict set replay of %s\n", captureFile.c_str());
+
+	Standalone<StringRef> data(readFileBytes(captureFile, std::numeric_limits<int>::max()));
+	std::vector<ResolverCaptureBatch> batches;
+	int transactions = 0, conflictRanges = 0;
+	for (int offset = 0; offset + sizeof(uint32_t) <= data.size();) {
+		uint32_t length;
+		memcpy(&length, data.begin() + offset, sizeof(length));
+		offset += sizeof(length);
+		if (offset + length > data.size()) {
+			printf("Ignoring truncated record at offset %d\n", offset - (int)sizeof(length));
+			break;
+		}
+		ArenaReader reader(data.arena(), data.substr(offset, length), IncludeVersion());
+		batches.emplace_back();
+		reader >> batches.back();
+		offset += length;
+
+		transactions += batches.back().transactions.size();
+		for (auto& tr : batches.back().transactions) {
+			conflictRanges += tr.read_conflict_ranges.size() + tr.write_conflict_ranges.size();
+		}
+	}
+	printf("Read %zu batches, %d transactions, %d conflict ranges\n", batches.size(), transactions, conflictRanges);
+
+	ConflictSet* cs = newConflictSet();
+	if (!batches.empty()) {
+		clearConflictSet(cs, batches.front().prevVersion);
+	}
+	for (auto counter : skc) {
+		counter->clear();
+	}
+
+	CacheMissCounter cacheMisses;
+	uint64_t memoryBefore = getResidentMemoryUsage();
+	int committed = 0, tooOld = 0;
+	cacheMisses.start();
+	double start = timer();
+	for (const auto& batch : batches) {
+		Arena replyArena;
+		std::map<int, VectorRef<int>> conflictingKeyRangeMap;
+		std::vector<int> commitList, tooOldList;
+
+		double t = timer();
+		ConflictBatch conflictBatch(cs, &conflictingKeyRangeMap, &replyArena);
+		for (const auto& tr : batch.transactions) {
+			conflictBatch.addTransaction(tr);
+		}
+		g_add += timer() - t;
+
+		t = timer();
+		conflictBatch.detectConflicts(batch.version, batch.version - SERVER_KNOBS->MAX_WRITE_TRANSACTION_LIFE_VERSIONS,
+		                              commitList, &tooOldList);
+		g_detectConflicts += timer() - t;
+
+		committed += commitList.size();
+		tooOld += tooOldList.size();
+	}
+	double elapsed = timer() - start;
+	uint64_t misses = cacheMisses.stop();
+	uint64_t memoryAfter = getResidentMemoryUsage();
+
+	printf("Replayed:         %0.3f sec\n", elapsed);
+	printf("                  %0.3f Mtransactions/sec\n", transactions / elapsed / 1e6);
+	printf("                  %0.3f Mkeys/sec\n", conflictRanges * 2 / elapsed / 1e6);
+	printf("Committed:        %d, conflicted: %d, too old: %d\n", committed, transactions - committed - tooOld, tooOld);
+	if (cacheMisses.available()) {
+		printf("Cache misses:     %" PRIu64 " (%0.1f per transaction)\n", misses,
+		       transactions ? (double)misses / transactions : 0.0);
+	} else {
+		printf("Cache misses:     unavailable\n");
+	}
+	printf("Resident memory:  %0.1f MB before, %0.1f MB after\n", memoryBefore / 1e6, memoryAfter / 1e6);
+	printf("%d entries in version history\n", cs->count());
+
+	printf("Performance counters:\n");
+	for (const auto& counter : skc) {
+		printf("%20s: %s\n", counter->getMetric().name().c_str(), counter->getMetric().formatted().c_str());
+	}
+
+	destroyConflictSet(cs);
 }
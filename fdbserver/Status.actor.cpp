@@ -32,6 +32,7 @@
 #include "fdbserver/QuietDatabase.h"
 #include "fdbserver/RecoveryState.h"
 #include "fdbclient/JsonBuilder.h"
+#include "flow/Histogram.h"
 #include "flow/actorcompiler.h"  // This must be the last #include.
 
 const char* RecoveryStatus::names[] = {
@@ -536,6 +537,25 @@ struct RolesInfo {
 				    obj["busiest_write_tag"] = busiestWriteTagObj;
 				}
 			}
+
+			TraceEventFields const& hotKeys = metrics.at("HotKeys");
+			if(hotKeys.size()) {
+				JsonBuilderObject hotKeysObj;
+				for(std::string op : { "Read", "Write" }) {
+					JsonBuilderArray keysArr;
+					int count = hotKeys.getInt(op + "Keys");
+					for(int i = 0; i < count; i++) {
+						JsonBuilderObject keyObj;
+						std::string prefix = op + std::to_string(i);
+						keyObj["key"] = hotKeys.getValue(prefix + "Key");
+						keyObj["hz"] = hotKeys.getDouble(prefix + "Hz");
+						keyObj["error_hz"] = hotKeys.getDouble(prefix + "ErrorHz");
+						keysArr.push_back(keyObj);
+					}
+					hotKeysObj[op == "Read" ? "read" : "write"] = keysArr;
+				}
+				obj["hot_keys"] = hotKeysObj;
+			}
 		} catch (Error& e) {
 			if(e.code() != error_code_attribute_not_found)
 				throw e;
@@ -589,6 +609,17 @@ struct RolesInfo {
 			if(commitLatencyBands.size()) {
 				obj["commit_latency_bands"] = addLatencyBandInfo(commitLatencyBands);
 			}
+
+			TraceEventFields const& batchController = metrics.at("CommitBatchController");
+			if(batchController.size()) {
+				JsonBuilderObject batching;
+				batching["target_p99_latency_seconds"] = batchController.getDouble("TargetLatency");
+				batching["observed_p99_latency_seconds"] = batchController.getDouble("P99Latency");
+				batching["last_decision"] = batchController.getValue("Decision");
+				batching["batch_interval_seconds"] = batchController.getDouble("BatchInterval");
+				batching["batch_bytes"] = batchController.getInt64("BatchBytes");
+				obj["commit_batching"] = batching;
+			}
 		} catch (Error &e) {
 			if(e.code() != error_code_attribute_not_found) {
 				throw e;
@@ -642,6 +673,55 @@ struct RolesInfo {
 	}
 };
 
+// Merge the latency histograms logged by roles alongside their latency statistics
+template <class Interface>
+static void mergeLatencyHistograms(LogLinearHistogram& merged, vector<std::pair<Interface, EventMap>> const& roles,
+                                   std::string const& eventName) {
+	for (auto& role : roles) {
+		auto event = role.second.find(eventName);
+		if (event == role.second.end() || !event->second.size()) continue;
+		try {
+			merged.merge(LogLinearHistogram::fromString(event->second.getValue("Histogram")));
+		} catch (Error& e) {
+			// Processes of older versions do not log a histogram
+			if (e.code() != error_code_attribute_not_found) throw e;
+		}
+	}
+}
+
+static void addLatencyStatistics(JsonBuilderObject& obj, std::string const& key, LogLinearHistogram const& h) {
+	if (!h.getPopulationSize()) return;
+	JsonBuilderObject latencyStats;
+	latencyStats["count"] = (int64_t)h.getPopulationSize();
+	latencyStats["min"] = h.min();
+	latencyStats["max"] = h.max();
+	latencyStats["median"] = h.median();
+	latencyStats["mean"] = h.mean();
+	latencyStats["p25"] = h.percentile(0.25);
+	latencyStats["p90"] = h.percentile(0.9);
+	latencyStats["p95"] = h.percentile(0.95);
+	latencyStats["p99"] = h.percentile(0.99);
+	latencyStats["p99.9"] = h.percentile(0.999);
+	obj[key] = latencyStats;
+}
+
+// Cluster wide latency statistics over the last logging interval of every storage server and proxy
+static JsonBuilderObject clusterLatencyStatistics(
+    vector<std::pair<StorageServerInterface, EventMap>> const& storageServers,
+    vector<std::pair<CommitProxyInterface, EventMap>> const& commitProxies,
+    vector<std::pair<GrvProxyInterface, EventMap>> const& grvProxies) {
+	LogLinearHistogram read, commit, grv;
+	mergeLatencyHistograms(read, storageServers, "ReadLatencyMetrics");
+	mergeLatencyHistograms(commit, commitProxies, "CommitLatencyMetrics");
+	mergeLatencyHistograms(grv, grvProxies, "GRVLatencyMetrics");
+
+	JsonBuilderObject obj;
+	addLatencyStatistics(obj, "read", read);
+	addLatencyStatistics(obj, "commit", commit);
+	addLatencyStatistics(obj, "grv", grv);
+	return obj;
+}
+
 ACTOR static Future<JsonBuilderObject> processStatusFetcher(
     Reference<AsyncVar<ServerDBInfo>> db, std::vector<WorkerDetails> workers, WorkerEvents pMetrics,
     WorkerEvents mMetrics, WorkerEvents nMetrics, WorkerEvents errors, WorkerEvents traceFileOpenErrors,
@@ -1669,7 +1749,7 @@ ACTOR static Future<vector<std::pair<StorageServerInterface, EventMap>>> getStor
 	state vector<StorageServerInterface> servers = wait(timeoutError(getStorageServers(cx, true), 5.0));
 	state vector<std::pair<StorageServerInterface, EventMap>> results;
 	state vector<TraceEventFields> busiestWriteTags;
-	wait(store(results, getServerMetrics(servers, address_workers,std::vector<std::string>{ "StorageMetrics", "ReadLatencyMetrics","ReadLatencyBands", "BusiestReadTag" }))
+	wait(store(results, getServerMetrics(servers, address_workers,std::vector<std::string>{ "StorageMetrics", "ReadLatencyMetrics","ReadLatencyBands", "BusiestReadTag", "HotKeys" }))
 	    && store(busiestWriteTags, getServerBusiestWriteTags(servers, address_workers, rkWorker)));
 
 	ASSERT(busiestWriteTags.size() == results.size());
@@ -1692,7 +1772,7 @@ ACTOR static Future<vector<std::pair<CommitProxyInterface, EventMap>>> getCommit
     Reference<AsyncVar<ServerDBInfo>> db, std::unordered_map<NetworkAddress, WorkerInterface> address_workers) {
 	vector<std::pair<CommitProxyInterface, EventMap>> results =
 	    wait(getServerMetrics(db->get().client.commitProxies, address_workers,
-	                          std::vector<std::string>{ "CommitLatencyMetrics", "CommitLatencyBands" }));
+	                          std::vector<std::string>{ "CommitLatencyMetrics", "CommitLatencyBands", "CommitBatchController" }));
 
 	return results;
 }
@@ -2706,6 +2786,11 @@ ACTOR Future<StatusReply> clusterGetStatus(
 		statusObj["processes"] = processStatus;
 		statusObj["clients"] = clientStatusFetcher(clientStatus);
 
+		JsonBuilderObject latencyStatistics = clusterLatencyStatistics(storageServers, commitProxies, grvProxies);
+		if (!latencyStatistics.empty()) {
+			statusObj["latency_statistics"] = latencyStatistics;
+		}
+
 		JsonBuilderArray incompatibleConnectionsArray;
 		for(auto it : incompatibleConnections) {
 			incompatibleConnectionsArray.push_back(it.toString());
@@ -921,6 +921,18 @@ bool expandMutation( MutationRef& m, StorageCacheData::VersionedData const& data
 				return expandMutation(m, data, eagerTrustedEnd, ar);
 			}
 			return false;
+		case MutationRef::SetIfAbsent:
+			if (oldVal.present()) {
+				return false;
+			}
+			break;
+		case MutationRef::CompareAndSet:
+			if (oldVal.present() && isValidCompareAndSetOperand(m.param2) &&
+			    oldVal.get() == m.param2.substr(0, getCompareAndSetExpectedLength(m.param2))) {
+				m.param2 = doCompareAndSet(oldVal, m.param2, ar).get();
+				break;
+			}
+			return false;
 		}
 		m.type = MutationRef::SetValue;
 	}
@@ -1869,6 +1881,8 @@ ACTOR Future<Void> pullAsyncData( StorageCacheData *data ) {
 							case MutationRef::Or:
 							case MutationRef::Xor:
 							case MutationRef::CompareAndClear:
+							case MutationRef::SetIfAbsent:
+							case MutationRef::CompareAndSet:
 								++data->counters.atomicMutations;
 								break;
 						}
@@ -25,6 +25,8 @@
 #include "fdbclient/StorageServerInterface.h"
 #include "fdbclient/KeyRangeMap.h"
 #include "fdbserver/Knobs.h"
+#include "flow/BTreeIndexedSet.h"
+#include "fdbserver/InternedKey.h"
 #include "flow/actorcompiler.h"  // This must be the last #include.
 
 const StringRef STORAGESERVER_HISTOGRAM_GROUP = LiteralStringRef("StorageServer");
@@ -33,15 +35,62 @@ const StringRef FETCH_KEYS_BYTES_HISTOGRAM = LiteralStringRef("FetchKeysSize");
 const StringRef FETCH_KEYS_BYTES_PER_SECOND_HISTOGRAM = LiteralStringRef("FetchKeysBandwidth");
 
 struct StorageMetricSample {
-	IndexedSet<Key, int64_t> sample;
+	// Searched and summed over far more often than it changes, and never iterated across a change, so a B-tree.  The
+	// keys are interned (see insert()) because a byte sample holds a key for every few hundred bytes on the server.
+	BTreeIndexedSet<InternedKey, int64_t> sample;
 	int64_t metricUnitsPerSample;
 
+	// Interning only pays for itself once a prefix is shared by a few keys
+	static constexpr int minInternedPrefix = 8;
+
 	StorageMetricSample( int64_t metricUnitsPerSample ) : metricUnitsPerSample(metricUnitsPerSample) {}
 
 	int64_t getEstimate( KeyRangeRef keys ) const {
 		return sample.sumRange( keys.begin, keys.end );
 	}
-	KeyRef splitEstimate( KeyRangeRef range, int64_t offset, bool front = true ) const {
+
+	// key as an element of the sample, sharing a prefix with one of the elements it will be inserted between.  A key
+	// takes the longest prefix of a neighbour that it starts with, or else starts a new prefix from what it has in
+	// common with a neighbour, so prefixes follow the keys present and are freed with the last key using them.
+	InternedKey intern( KeyRef key ) const {
+		auto next = sample.lower_bound(key);
+		auto prev = sample.previous(next);
+		Reference<KeyPrefix> shared;
+		int common = 0;
+		for (auto it : { prev, next }) {
+			if (it == sample.end()) continue;
+			int length = it->commonPrefixLength(key);
+			if (it->prefix && it->prefix->bytes.size() <= length &&
+			    (!shared || it->prefix->bytes.size() > shared->bytes.size())) {
+				shared = it->prefix;
+			}
+			common = std::max(common, length);
+		}
+		if (!shared && common >= minInternedPrefix) {
+			shared = makeReference<KeyPrefix>(key.substr(0, common));
+		}
+		return shared ? InternedKey(shared, key) : InternedKey(key);
+	}
+
+	// The same as sample.insert() and sample.addMetric(), but interning keys that are not in the sample yet
+	void insert( KeyRef key, int64_t metric, bool replaceExisting = true ) {
+		auto it = sample.find(key);
+		if (it == sample.end()) {
+			sample.insert(intern(key), metric);
+		} else if (replaceExisting) {
+			sample.insert(*it, metric);
+		}
+	}
+	int64_t addMetric( KeyRef key, int64_t metric ) {
+		auto it = sample.find(key);
+		if (it == sample.end()) {
+			sample.insert(intern(key), metric);
+			return metric;
+		}
+		return sample.addMetric(*it, metric);
+	}
+
+	Key splitEstimate( KeyRangeRef range, int64_t offset, bool front = true ) const {
 		auto fwd_split = sample.index( front ? sample.sumTo(sample.lower_bound(range.begin)) + offset : sample.sumTo(sample.lower_bound(range.end)) - offset );
 		
 		if( fwd_split == sample.end() || *fwd_split >= range.end )
@@ -52,6 +101,9 @@ struct StorageMetricSample {
 
 		auto bck_split = fwd_split;
 
+		// The shortest key in [begin, end), which is a prefix of end
+		auto between = [](KeyRef begin, Key const& end) { return Key(keyBetween(KeyRangeRef(begin, end)), end.arena()); };
+
 		// Butterfly search - start at midpoint then go in both directions.
 		while ((fwd_split != sample.end() && *fwd_split < range.end) ||
 			   (bck_split != sample.begin() && *bck_split > range.begin)) {
@@ -59,7 +111,8 @@ struct StorageMetricSample {
 				auto it = bck_split;
 				bck_split.decrementNonEnd();
 
-				KeyRef split = keyBetween(KeyRangeRef(bck_split != sample.begin() ? std::max<KeyRef>(*bck_split,range.begin) : range.begin, *it));
+				Key lower = bck_split != sample.begin() && *bck_split > range.begin ? bck_split->toKey() : Key(range.begin);
+				Key split = between(lower, it->toKey());
 				if(!front || (getEstimate(KeyRangeRef(range.begin, split)) > 0 && split.size() <= CLIENT_KNOBS->SPLIT_KEY_SIZE_LIMIT))
 					return split;
 			}
@@ -68,7 +121,7 @@ struct StorageMetricSample {
 				auto it = fwd_split;
 				++it;
 
-				KeyRef split = keyBetween(KeyRangeRef(*fwd_split, it != sample.end() ? std::min<KeyRef>(*it, range.end) : range.end));
+				Key split = between(fwd_split->toKey(), it != sample.end() && *it < range.end ? it->toKey() : Key(range.end));
 				if(front || (getEstimate(KeyRangeRef(split, range.end)) > 0 && split.size() <= CLIENT_KNOBS->SPLIT_KEY_SIZE_LIMIT))
 					return split;
 
@@ -100,8 +153,123 @@ TEST_CASE("/fdbserver/StorageMetricSample/simple") {
 	return Void();
 }
 
+TEST_CASE("/fdbserver/StorageMetricSample/internedKeys") {
+	StorageMetricSample s(1000);
+	std::vector<Key> keys;
+	for (int i = 0; i < 200; i++) {
+		keys.push_back(StringRef(format("%s/%04d", deterministicRandom()->coinflip() ? "table/users" : "table/orders",
+		                                deterministicRandom()->randomInt(0, 1000))));
+		s.insert(keys.back(), 10);
+	}
+	s.insert(LiteralStringRef("table/order"), 10);
+	s.insert(LiteralStringRef("t"), 10);
+	s.addMetric(LiteralStringRef("t"), 5);
+	keys.push_back(LiteralStringRef("table/order"));
+	keys.push_back(LiteralStringRef("t"));
+	std::sort(keys.begin(), keys.end());
+	keys.resize(std::unique(keys.begin(), keys.end()) - keys.begin());
+
+	// The sample orders and finds its keys as if they were not interned, and does share their prefixes
+	int shared = 0;
+	auto it = s.sample.begin();
+	for (auto const& k : keys) {
+		ASSERT(it != s.sample.end() && *it == k && it->toKey() == k);
+		ASSERT(s.sample.find(k) == it);
+		shared += it->prefix.isValid();
+		++it;
+	}
+	ASSERT(it == s.sample.end());
+	ASSERT(shared > keys.size() / 2);
+	ASSERT(s.getEstimate(KeyRangeRef(LiteralStringRef("table/orders/"), LiteralStringRef("table/orders0"))) ==
+	       10 * std::count_if(keys.begin(), keys.end(), [](Key const& k) { return k.startsWith(LiteralStringRef("table/orders/")); }));
+
+	InternedKey a(makeReference<KeyPrefix>(LiteralStringRef("table/")), LiteralStringRef("table/orders"));
+	ASSERT(a > LiteralStringRef("table/order") && a < LiteralStringRef("table/orders0") && a == LiteralStringRef("table/orders"));
+	ASSERT(a == InternedKey(LiteralStringRef("table/orders")) && a < InternedKey(LiteralStringRef("table/ordersa")));
+
+	return Void();
+}
+
+struct ShardMetricsSubscription;
+
+// A shard watched through a ShardMetricsSubscription.  Unlike a WaitMetricsRequest it has no actor of its own: changes
+// are added to metrics where they are noticed, and a watch that crosses its bounds is queued on its subscription.
+struct ShardMetricsWatch {
+	int64_t id;
+	KeyRange keys;
+	StorageMetrics min, max;
+	StorageMetrics metrics;
+	ShardMetricsSubscription* subscription;
+	bool fired = false;
+
+	ShardMetricsWatch(ShardMetricsWatchRef const& ref, StorageMetrics const& metrics,
+	                  ShardMetricsSubscription* subscription)
+	  : id(ref.id), keys(ref.keys), min(ref.min), max(ref.max), metrics(metrics), subscription(subscription) {}
+
+	bool inBounds() const { return min.allLessOrEqual(metrics) && metrics.allLessOrEqual(max); }
+	void add(StorageMetrics const& delta) {
+		if (fired) return;
+		metrics += delta;
+		check();
+	}
+	void check();
+	void wrongShard();
+};
+
+struct ShardMetricsSubscription {
+	UID id;
+	std::unordered_map<int64_t, std::unique_ptr<ShardMetricsWatch>> watches;
+	ShardMetricsStreamReply pending; // Reported by the next reply; watches in it are removed when it is sent
+	AsyncTrigger pendingChanged;
+
+	explicit ShardMetricsSubscription(UID id) : id(id) {}
+};
+
+inline void ShardMetricsWatch::check() {
+	if (!fired && !inBounds()) {
+		fired = true;
+		subscription->pending.crossed.emplace_back(id, metrics);
+		subscription->pendingChanged.trigger();
+	}
+}
+
+inline void ShardMetricsWatch::wrongShard() {
+	if (fired) return;
+	fired = true;
+	subscription->pending.wrongShard.push_back(id);
+	subscription->pendingChanged.trigger();
+}
+
+// Everything waiting on the metrics of one range of StorageServerMetrics::waitMetricsMap
+struct MetricsWaiters {
+	std::vector<PromiseStream<StorageMetrics>> streams; // Of WaitMetricsRequests
+	std::vector<ShardMetricsWatch*> watches;
+
+	size_t size() const { return streams.size() + watches.size(); }
+
+	void send(StorageMetrics const& delta) const {
+		for (int i = 0; i < streams.size(); i++) {
+			streams[i].send(delta);
+		}
+		for (auto w : watches) {
+			w->add(delta);
+		}
+	}
+
+	void sendError(Error const& e) const {
+		for (int i = 0; i < streams.size(); i++) {
+			streams[i].sendError(e);
+		}
+		for (auto w : watches) {
+			w->wrongShard();
+		}
+	}
+
+	bool operator==(MetricsWaiters const& rhs) const { return streams == rhs.streams && watches == rhs.watches; }
+};
+
 struct TransientStorageMetricSample : StorageMetricSample {
-	Deque< std::pair<double, std::pair<Key, int64_t>> > queue;
+	Deque< std::pair<double, std::pair<InternedKey, int64_t>> > queue;
 
 	TransientStorageMetricSample( int64_t metricUnitsPerSample ) : StorageMetricSample(metricUnitsPerSample) {}
 
@@ -126,12 +294,12 @@ struct TransientStorageMetricSample : StorageMetricSample {
 		sample.erase( keys.begin, keys.end );
 	}
 
-	void poll(KeyRangeMap< vector< PromiseStream< StorageMetrics > > > & waitMap, StorageMetrics m) {
+	void poll(KeyRangeMap<MetricsWaiters>& waitMap, StorageMetrics m) {
 		double now = ::now();
 		while (queue.size() && 
 				queue.front().first <= now )
 		{
-			KeyRef key = queue.front().second.first;
+			InternedKey const& key = queue.front().second.first;
 			int64_t delta = queue.front().second.second;
 			ASSERT( delta != 0 );
 
@@ -139,11 +307,9 @@ struct TransientStorageMetricSample : StorageMetricSample {
 				sample.erase( key );
 
 			StorageMetrics deltaM = m * delta;
-			auto v = waitMap[key];
-			for(int i=0; i<v.size(); i++) {
-				TEST( true ); // TransientStorageMetricSample poll update 
-				v[i].send( deltaM );
-			}
+			auto v = waitMap[key.toKey()];
+			TEST( v.size() ); // TransientStorageMetricSample poll update
+			v.send( deltaM );
 
 			queue.pop_front();
 		}
@@ -154,7 +320,7 @@ struct TransientStorageMetricSample : StorageMetricSample {
 		while (queue.size() && 
 				queue.front().first <= now )
 		{
-			KeyRef key = queue.front().second.first;
+			InternedKey const& key = queue.front().second.first;
 			int64_t delta = queue.front().second.second;
 			ASSERT( delta != 0 );
 
@@ -181,25 +347,102 @@ private:
 			metric = metric<0 ? -metricUnitsPerSample : metricUnitsPerSample;
 		}
 		
-		if( sample.addMetric( key, metric ) == 0 )
+		if( addMetric( key, metric ) == 0 )
 			sample.erase( key );
 
 		return metric;
 	}
 };
 
+// Tracks the most frequently seen keys with the space-saving algorithm: at most `capacity` keys are counted, and a key
+// that is not counted replaces the least counted one, inheriting its count as an error bound. Any key seen more than
+// 1/capacity of the time is guaranteed to be counted. Counts are kept for the current interval, and reports come
+// from the last complete one.
+struct HotKeySample {
+	struct Counter {
+		int64_t count;
+		int64_t error;
+	};
+
+	int capacity;
+	double sampleRate;
+	std::map<Key, Counter, std::less<>> counts;
+	std::set<std::pair<int64_t, KeyRef>> byCount; // KeyRefs point into the keys of counts
+
+	std::map<Key, Counter, std::less<>> lastCounts;
+	double lastInterval = 0;
+	double intervalStart;
+
+	HotKeySample(int capacity, double sampleRate)
+	  : capacity(capacity), sampleRate(sampleRate), intervalStart(now()) {}
+
+	void sample(KeyRef key) {
+		if (sampleRate < 1 && deterministicRandom()->random01() >= sampleRate) {
+			return;
+		}
+		auto it = counts.find(key);
+		if (it != counts.end()) {
+			byCount.erase(std::make_pair(it->second.count, KeyRef(it->first)));
+			++it->second.count;
+			byCount.emplace(it->second.count, it->first);
+			return;
+		}
+		Counter counter{ 1, 0 };
+		if (counts.size() >= (size_t)capacity) {
+			auto least = byCount.begin();
+			counter = Counter{ least->first + 1, least->first };
+			auto evicted = counts.find(least->second);
+			byCount.erase(least);
+			counts.erase(evicted);
+		}
+		it = counts.emplace(Key(key), counter).first;
+		byCount.emplace(counter.count, it->first);
+	}
+
+	// Starts a new interval, keeping the one that just ended for reports
+	void rollover() {
+		double t = now();
+		lastCounts.clear();
+		lastCounts.swap(counts);
+		byCount.clear();
+		lastInterval = t - intervalStart;
+		intervalStart = t;
+	}
+
+	// Appends up to limit of the hottest keys in range from the last interval, hottest first
+	void getHotKeys(KeyRangeRef range, int limit, Arena& arena, VectorRef<HotKeyRef>& result) const {
+		if (lastInterval <= 0) return;
+		std::vector<std::pair<int64_t, KeyRef>> inRange;
+		for (auto it = lastCounts.lower_bound(range.begin); it != lastCounts.end() && it->first < range.end; ++it) {
+			inRange.emplace_back(it->second.count, it->first);
+		}
+		std::sort(inRange.begin(), inRange.end(), std::greater<>());
+		double scale = 1.0 / (std::min(sampleRate, 1.0) * lastInterval);
+		for (int i = 0; i < inRange.size() && i < limit; i++) {
+			const Counter& counter = lastCounts.find(inRange[i].second)->second;
+			result.push_back_deep(arena,
+			                      HotKeyRef(inRange[i].second, counter.count * scale, counter.error * scale));
+		}
+	}
+};
+
 struct StorageServerMetrics {
-	KeyRangeMap< vector< PromiseStream< StorageMetrics > > > waitMetricsMap;
+	KeyRangeMap<MetricsWaiters> waitMetricsMap;
+	std::map<UID, std::unique_ptr<ShardMetricsSubscription>> shardMetricsSubscriptions;
 	StorageMetricSample byteSample;
 	TransientStorageMetricSample iopsSample,
 	    bandwidthSample; // FIXME: iops and bandwidth calculations are not effectively tested, since they aren't
 	                     // currently used by data distribution
 	TransientStorageMetricSample bytesReadSample;
+	// Only fed when STORAGE_HOT_KEY_SAMPLING is on
+	HotKeySample readHotKeys, writeHotKeys;
 
 	StorageServerMetrics()
 	  : byteSample(0), iopsSample(SERVER_KNOBS->IOPS_UNITS_PER_SAMPLE),
 	    bandwidthSample(SERVER_KNOBS->BANDWIDTH_UNITS_PER_SAMPLE),
-	    bytesReadSample(SERVER_KNOBS->BYTES_READ_UNITS_PER_SAMPLE) {}
+	    bytesReadSample(SERVER_KNOBS->BYTES_READ_UNITS_PER_SAMPLE),
+	    readHotKeys(SERVER_KNOBS->STORAGE_HOT_KEY_SAMPLE_CAPACITY, SERVER_KNOBS->STORAGE_HOT_KEY_SAMPLE_RATE),
+	    writeHotKeys(SERVER_KNOBS->STORAGE_HOT_KEY_SAMPLE_CAPACITY, SERVER_KNOBS->STORAGE_HOT_KEY_SAMPLE_RATE) {}
 
 	// Get the current estimated metrics for the given keys
 	StorageMetrics getMetrics(KeyRangeRef const& keys) const {
@@ -235,13 +478,11 @@ struct StorageServerMetrics {
 			                                    SERVER_KNOBS->STORAGE_METRICS_AVERAGE_INTERVAL_PER_KSECONDS;
 		if (!notifyMetrics.allZero()) {
 			auto& v = waitMetricsMap[key];
-			for(int i=0; i<v.size(); i++) {
-				if (g_network->isSimulated()) {
-					TEST(true); // shard notify metrics
-				}
-				// ShardNotifyMetrics
-				v[i].send( notifyMetrics );
+			if (g_network->isSimulated()) {
+				TEST(v.size()); // shard notify metrics
 			}
+			// ShardNotifyMetrics
+			v.send( notifyMetrics );
 		}
 	}
 
@@ -255,24 +496,20 @@ struct StorageServerMetrics {
 			StorageMetrics notifyMetrics;
 			notifyMetrics.bytesReadPerKSecond = bytesReadPerKSecond;
 			auto& v = waitMetricsMap[key];
-			for (int i = 0; i < v.size(); i++) {
-				TEST(true); // ShardNotifyMetrics
-				v[i].send(notifyMetrics);
-			}
+			TEST(v.size()); // ShardNotifyMetrics
+			v.send(notifyMetrics);
 		}
 	}
 
 	// Called by StorageServerDisk when the size of a key in byteSample changes, to notify WaitMetricsRequest
 	// Should not be called for keys past allKeys.end
-	void notifyBytes( RangeMap<Key, std::vector<PromiseStream<StorageMetrics>>, KeyRangeRef>::iterator shard, int64_t bytes ) {
+	void notifyBytes( RangeMap<Key, MetricsWaiters, KeyRangeRef>::iterator shard, int64_t bytes ) {
 		ASSERT(shard.end() <= allKeys.end);
 
 		StorageMetrics notifyMetrics;
 		notifyMetrics.bytes = bytes;
-		for(int i=0; i < shard.value().size(); i++) {
-			TEST( true ); // notifyBytes
-			shard.value()[i].send( notifyMetrics );
-		}
+		TEST( shard.value().size() ); // notifyBytes
+		shard.value().send( notifyMetrics );
 	}
 
 	// Called by StorageServerDisk when the size of a key in byteSample changes, to notify WaitMetricsRequest
@@ -290,8 +527,7 @@ struct StorageServerMetrics {
 		for (auto r = rs.begin(); r != rs.end(); ++r){
 			auto &v = r->value();
 			TEST( v.size() );  // notifyNotReadable() sending errors to intersecting ranges
-			for (int n=0; n<v.size(); n++)
-				v[n].sendError( wrong_shard_server() );
+			v.sendError( wrong_shard_server() );
 		}
 	}
 
@@ -312,7 +548,7 @@ struct StorageServerMetrics {
 	//static void waitMetrics( StorageServerMetrics* const& self, WaitMetricsRequest const& req );
 
 	// This function can run on untrusted user data.  We must validate all divisions carefully.
-	KeyRef getSplitKey(int64_t remaining, int64_t estimated, int64_t limits, int64_t used, int64_t infinity,
+	Key getSplitKey(int64_t remaining, int64_t estimated, int64_t limits, int64_t used, int64_t infinity,
 	                   bool isLastShard, const StorageMetricSample& sample, double divisor, KeyRef const& lastKey,
 	                   KeyRef const& key, bool hasUsed) const {
 		ASSERT(remaining >= 0);
@@ -355,7 +591,7 @@ struct StorageServerMetrics {
 			while( true ) {
 				if( remaining.bytes < 2*SERVER_KNOBS->MIN_SHARD_BYTES )
 					break;
-				KeyRef key = req.keys.end;
+				Key key = req.keys.end;
 				bool hasUsed = used.bytes != 0 || used.bytesPerKSecond != 0 || used.iosPerKSecond != 0;
 				key = getSplitKey( remaining.bytes, estimated.bytes, req.limits.bytes, used.bytes, 
 					req.limits.infinity, req.isLastShard, byteSample, 1, lastKey, key, hasUsed );
@@ -375,7 +611,7 @@ struct StorageServerMetrics {
 				estimated -= diff;
 				
 				used = StorageMetrics();
-				lastKey = key;
+				lastKey = reply.splits.back();
 			}
 
 			reply.used = getMetrics( KeyRangeRef(lastKey, req.keys.end) ) + used;
@@ -421,13 +657,100 @@ struct StorageServerMetrics {
 
 	Future<Void> waitMetrics(WaitMetricsRequest req, Future<Void> delay);
 
+	// Returns nullptr if a subscription with this id is already open
+	ShardMetricsSubscription* addShardMetricsSubscription(UID id) {
+		auto& sub = shardMetricsSubscriptions[id];
+		if (sub) {
+			return nullptr;
+		}
+		sub = std::make_unique<ShardMetricsSubscription>(id);
+		return sub.get();
+	}
+
+	void removeShardMetricsSubscription(UID id) {
+		auto it = shardMetricsSubscriptions.find(id);
+		if (it == shardMetricsSubscriptions.end()) return;
+		std::unique_ptr<ShardMetricsSubscription> sub = std::move(it->second);
+		shardMetricsSubscriptions.erase(it);
+		while (!sub->watches.empty()) {
+			removeShardMetricsWatch(sub->watches.begin()->second.get());
+		}
+	}
+
+	// Starts watching ref, reporting it on the next reply at once if it is already out of bounds
+	void addShardMetricsWatch(ShardMetricsSubscription* sub, ShardMetricsWatchRef const& ref, bool readable) {
+		auto existing = sub->watches.find(ref.id);
+		if (existing != sub->watches.end()) {
+			removeShardMetricsWatch(existing->second.get());
+		}
+		auto& watch = sub->watches[ref.id];
+		watch = std::make_unique<ShardMetricsWatch>(ref, getMetrics(ref.keys), sub);
+		auto rs = waitMetricsMap.modify(ref.keys);
+		for (auto r = rs.begin(); r != rs.end(); ++r) {
+			r->value().watches.push_back(watch.get());
+		}
+		if (!readable) {
+			watch->wrongShard();
+		} else {
+			watch->check();
+		}
+	}
+
+	void removeShardMetricsWatch(ShardMetricsWatch* watch) {
+		KeyRange keys = watch->keys;
+		int64_t id = watch->id;
+		auto rs = waitMetricsMap.modify(keys);
+		for (auto r = rs.begin(); r != rs.end(); ++r) {
+			auto& x = r->value().watches;
+			for (int j = 0; j < x.size(); j++) {
+				if (x[j] == watch) {
+					swapAndPop(&x, j);
+					break;
+				}
+			}
+		}
+		watch->subscription->watches.erase(id); // Destroys watch
+		waitMetricsMap.coalesce(keys);
+	}
+
+	// Takes the watches that fired since the last call for a reply, and stops watching them
+	ShardMetricsStreamReply takeFiredShardMetricsWatches(ShardMetricsSubscription* sub) {
+		ShardMetricsStreamReply reply;
+		std::swap(reply, sub->pending);
+		for (auto& c : reply.crossed) {
+			auto it = sub->watches.find(c.id);
+			if (it != sub->watches.end()) {
+				c.metrics = it->second->metrics;
+				removeShardMetricsWatch(it->second.get());
+			}
+		}
+		for (auto id : reply.wrongShard) {
+			auto it = sub->watches.find(id);
+			if (it != sub->watches.end()) {
+				removeShardMetricsWatch(it->second.get());
+			}
+		}
+		return reply;
+	}
+
+	// Recomputes the metrics of every watch of sub, in place of the deltas accumulated since it started or was last
+	// resynchronized, which (like those of a WaitMetricsRequest) can drift
+	void resyncShardMetricsWatches(ShardMetricsSubscription* sub) {
+		for (auto& w : sub->watches) {
+			if (!w.second->fired) {
+				w.second->metrics = getMetrics(w.second->keys);
+				w.second->check();
+			}
+		}
+	}
+
 	// Given a read hot shard, this function will divide the shard into chunks and find those chunks whose
 	// readBytes/sizeBytes exceeds the `readDensityRatio`. Please make sure to run unit tests
 	// `StorageMetricsSampleTests.txt` after change made.
-	std::vector<ReadHotRangeWithMetrics> getReadHotRanges(KeyRangeRef shard, double readDensityRatio,
-	                                                      int64_t baseChunkSize,
-	                                                      int64_t minShardReadBandwidthPerKSeconds) const {
-		std::vector<ReadHotRangeWithMetrics> toReturn;
+	Standalone<VectorRef<ReadHotRangeWithMetrics>> getReadHotRanges(KeyRangeRef shard, double readDensityRatio,
+	                                                               int64_t baseChunkSize,
+	                                                               int64_t minShardReadBandwidthPerKSeconds) const {
+		Standalone<VectorRef<ReadHotRangeWithMetrics>> toReturn;
 
 		double shardSize = (double)byteSample.getEstimate(shard);
 		int64_t shardReadBandwidth = bytesReadSample.getEstimate(shard);
@@ -438,13 +761,14 @@ struct StorageServerMetrics {
 		if (shardSize <= baseChunkSize) {
 			// Shard is small, use it as is
 			if (bytesReadSample.getEstimate(shard) > (readDensityRatio * shardSize)) {
-				toReturn.emplace_back(shard, bytesReadSample.getEstimate(shard) / shardSize,
-				                      bytesReadSample.getEstimate(shard) /
-				                          SERVER_KNOBS->STORAGE_METRICS_AVERAGE_INTERVAL);
+				toReturn.push_back_deep(toReturn.arena(),
+				                        ReadHotRangeWithMetrics(shard, bytesReadSample.getEstimate(shard) / shardSize,
+				                                                bytesReadSample.getEstimate(shard) /
+				                                                    SERVER_KNOBS->STORAGE_METRICS_AVERAGE_INTERVAL));
 			}
 			return toReturn;
 		}
-		KeyRef beginKey = shard.begin;
+		Key beginKey = shard.begin;
 		auto endKey =
 		    byteSample.sample.index(byteSample.sample.sumTo(byteSample.sample.lower_bound(beginKey)) + baseChunkSize);
 		while (endKey != byteSample.sample.end()) {
@@ -459,20 +783,24 @@ struct StorageServerMetrics {
 				++endKey;
 				continue;
 			}
-			if (bytesReadSample.getEstimate(KeyRangeRef(beginKey, *endKey)) >
-			    (readDensityRatio * std::max(baseChunkSize, byteSample.getEstimate(KeyRangeRef(beginKey, *endKey))))) {
-				auto range = KeyRangeRef(beginKey, *endKey);
+			Key end = endKey->toKey();
+			if (bytesReadSample.getEstimate(KeyRangeRef(beginKey, end)) >
+			    (readDensityRatio * std::max(baseChunkSize, byteSample.getEstimate(KeyRangeRef(beginKey, end))))) {
+				auto range = KeyRangeRef(beginKey, end);
 				if (!toReturn.empty() && toReturn.back().keys.end == range.begin) {
 					// in case two consecutive chunks both are over the ratio, merge them.
-					range = KeyRangeRef(toReturn.back().keys.begin, *endKey);
+					range = KeyRangeRef(toReturn.back().keys.begin, end);
 					toReturn.pop_back();
 				}
-				toReturn.emplace_back(
-				    range,
-				    (double)bytesReadSample.getEstimate(range) / std::max(baseChunkSize, byteSample.getEstimate(range)),
-				    bytesReadSample.getEstimate(range) / SERVER_KNOBS->STORAGE_METRICS_AVERAGE_INTERVAL);
+				toReturn.push_back_deep(
+				    toReturn.arena(),
+				    ReadHotRangeWithMetrics(range,
+				                            (double)bytesReadSample.getEstimate(range) /
+				                                std::max(baseChunkSize, byteSample.getEstimate(range)),
+				                            bytesReadSample.getEstimate(range) /
+				                                SERVER_KNOBS->STORAGE_METRICS_AVERAGE_INTERVAL));
 			}
-			beginKey = *endKey;
+			beginKey = end;
 			endKey = byteSample.sample.index(byteSample.sample.sumTo(byteSample.sample.lower_bound(beginKey)) +
 			                                 baseChunkSize);
 		}
@@ -481,17 +809,23 @@ struct StorageServerMetrics {
 
 	void getReadHotRanges(ReadHotSubRangeRequest req) const {
 		ReadHotSubRangeReply reply;
-		auto _ranges = getReadHotRanges(req.keys, SERVER_KNOBS->SHARD_MAX_READ_DENSITY_RATIO,
-		                                SERVER_KNOBS->READ_HOT_SUB_RANGE_CHUNK_SIZE,
-		                                SERVER_KNOBS->SHARD_READ_HOT_BANDWITH_MIN_PER_KSECONDS);
-		reply.readHotRanges = VectorRef(_ranges.data(), _ranges.size());
+		reply.readHotRanges = getReadHotRanges(req.keys, SERVER_KNOBS->SHARD_MAX_READ_DENSITY_RATIO,
+		                                       SERVER_KNOBS->READ_HOT_SUB_RANGE_CHUNK_SIZE,
+		                                       SERVER_KNOBS->SHARD_READ_HOT_BANDWITH_MIN_PER_KSECONDS);
+		req.reply.send(reply);
+	}
+
+	void getHotKeys(GetHotKeysRequest req) const {
+		GetHotKeysReply reply;
+		readHotKeys.getHotKeys(req.keys, req.limit, reply.arena, reply.readKeys);
+		writeHotKeys.getHotKeys(req.keys, req.limit, reply.arena, reply.writeKeys);
 		req.reply.send(reply);
 	}
 
-	std::vector<KeyRef> getSplitPoints(KeyRangeRef range, int64_t chunkSize) {
-		std::vector<KeyRef> toReturn;
+	Standalone<VectorRef<KeyRef>> getSplitPoints(KeyRangeRef range, int64_t chunkSize) {
+		Standalone<VectorRef<KeyRef>> toReturn;
 		KeyRef beginKey = range.begin;
-		IndexedSet<Key, int64_t>::iterator endKey =
+		auto endKey =
 		    byteSample.sample.index(byteSample.sample.sumTo(byteSample.sample.lower_bound(beginKey)) + chunkSize);
 		while (endKey != byteSample.sample.end()) {
 			if (*endKey > range.end) {
@@ -501,8 +835,8 @@ struct StorageServerMetrics {
 				++endKey;
 				continue;
 			}
-			toReturn.push_back(*endKey);
-			beginKey = *endKey;
+			toReturn.push_back_deep(toReturn.arena(), endKey->toKey());
+			beginKey = toReturn.back();
 			endKey =
 			    byteSample.sample.index(byteSample.sample.sumTo(byteSample.sample.lower_bound(beginKey)) + chunkSize);
 		}
@@ -511,9 +845,7 @@ struct StorageServerMetrics {
 
 	void getSplitPoints(SplitRangeRequest req) {
 		SplitRangeReply reply;
-		std::vector<KeyRef> points = getSplitPoints(req.keys, req.chunkSize);
-
-		reply.splitPoints.append_deep(reply.splitPoints.arena(), points.data(), points.size());
+		reply.splitPoints = getSplitPoints(req.keys, req.chunkSize);
 		req.reply.send(reply);
 	}
 
@@ -551,7 +883,7 @@ TEST_CASE("/fdbserver/StorageMetricSample/rangeSplitPoints/simple") {
 	ssm.byteSample.sample.insert(LiteralStringRef("But"), 100 * sampleUnit);
 	ssm.byteSample.sample.insert(LiteralStringRef("Cat"), 300 * sampleUnit);
 
-	vector<KeyRef> t = ssm.getSplitPoints(KeyRangeRef(LiteralStringRef("A"), LiteralStringRef("C")), 2000 * sampleUnit);
+	Standalone<VectorRef<KeyRef>> t = ssm.getSplitPoints(KeyRangeRef(LiteralStringRef("A"), LiteralStringRef("C")), 2000 * sampleUnit);
 
 	ASSERT(t.size() == 1 && t[0] == LiteralStringRef("Bah"));
 
@@ -572,7 +904,7 @@ TEST_CASE("/fdbserver/StorageMetricSample/rangeSplitPoints/multipleReturnedPoint
 	ssm.byteSample.sample.insert(LiteralStringRef("But"), 100 * sampleUnit);
 	ssm.byteSample.sample.insert(LiteralStringRef("Cat"), 300 * sampleUnit);
 
-	vector<KeyRef> t = ssm.getSplitPoints(KeyRangeRef(LiteralStringRef("A"), LiteralStringRef("C")), 600 * sampleUnit);
+	Standalone<VectorRef<KeyRef>> t = ssm.getSplitPoints(KeyRangeRef(LiteralStringRef("A"), LiteralStringRef("C")), 600 * sampleUnit);
 
 	ASSERT(t.size() == 3 && t[0] == LiteralStringRef("Absolute") && t[1] == LiteralStringRef("Apple") &&
 	       t[2] == LiteralStringRef("Bah"));
@@ -594,7 +926,7 @@ TEST_CASE("/fdbserver/StorageMetricSample/rangeSplitPoints/noneSplitable") {
 	ssm.byteSample.sample.insert(LiteralStringRef("But"), 100 * sampleUnit);
 	ssm.byteSample.sample.insert(LiteralStringRef("Cat"), 300 * sampleUnit);
 
-	vector<KeyRef> t = ssm.getSplitPoints(KeyRangeRef(LiteralStringRef("A"), LiteralStringRef("C")), 10000 * sampleUnit);
+	Standalone<VectorRef<KeyRef>> t = ssm.getSplitPoints(KeyRangeRef(LiteralStringRef("A"), LiteralStringRef("C")), 10000 * sampleUnit);
 
 	ASSERT(t.size() == 0);
 
@@ -616,7 +948,7 @@ TEST_CASE("/fdbserver/StorageMetricSample/rangeSplitPoints/chunkTooLarge") {
 	ssm.byteSample.sample.insert(LiteralStringRef("But"), 10 * sampleUnit);
 	ssm.byteSample.sample.insert(LiteralStringRef("Cat"), 30 * sampleUnit);
 
-	vector<KeyRef> t = ssm.getSplitPoints(KeyRangeRef(LiteralStringRef("A"), LiteralStringRef("C")), 1000 * sampleUnit);
+	Standalone<VectorRef<KeyRef>> t = ssm.getSplitPoints(KeyRangeRef(LiteralStringRef("A"), LiteralStringRef("C")), 1000 * sampleUnit);
 
 	ASSERT(t.size() == 0);
 
@@ -643,7 +975,7 @@ TEST_CASE("/fdbserver/StorageMetricSample/readHotDetect/simple") {
 	ssm.byteSample.sample.insert(LiteralStringRef("But"), 100 * sampleUnit);
 	ssm.byteSample.sample.insert(LiteralStringRef("Cat"), 300 * sampleUnit);
 
-	std::vector<ReadHotRangeWithMetrics> t =
+	Standalone<VectorRef<ReadHotRangeWithMetrics>> t =
 	    ssm.getReadHotRanges(KeyRangeRef(LiteralStringRef("A"), LiteralStringRef("C")), 2.0, 200 * sampleUnit, 0);
 
 	ASSERT(t.size() == 1 && (*t.begin()).keys.begin == LiteralStringRef("Bah") &&
@@ -674,12 +1006,12 @@ TEST_CASE("/fdbserver/StorageMetricSample/readHotDetect/moreThanOneRange") {
 	ssm.byteSample.sample.insert(LiteralStringRef("Cat"), 300 * sampleUnit);
 	ssm.byteSample.sample.insert(LiteralStringRef("Dah"), 300 * sampleUnit);
 
-	std::vector<ReadHotRangeWithMetrics> t =
+	Standalone<VectorRef<ReadHotRangeWithMetrics>> t =
 	    ssm.getReadHotRanges(KeyRangeRef(LiteralStringRef("A"), LiteralStringRef("D")), 2.0, 200 * sampleUnit, 0);
 
 	ASSERT(t.size() == 2 && (*t.begin()).keys.begin == LiteralStringRef("Bah") &&
 	       (*t.begin()).keys.end == LiteralStringRef("Bob"));
-	ASSERT(t.at(1).keys.begin == LiteralStringRef("Cat") && t.at(1).keys.end == LiteralStringRef("Dah"));
+	ASSERT(t[1].keys.begin == LiteralStringRef("Cat") && t[1].keys.end == LiteralStringRef("Dah"));
 
 	return Void();
 }
@@ -707,12 +1039,44 @@ TEST_CASE("/fdbserver/StorageMetricSample/readHotDetect/consecutiveRanges") {
 	ssm.byteSample.sample.insert(LiteralStringRef("Cat"), 300 * sampleUnit);
 	ssm.byteSample.sample.insert(LiteralStringRef("Dah"), 300 * sampleUnit);
 
-	std::vector<ReadHotRangeWithMetrics> t =
+	Standalone<VectorRef<ReadHotRangeWithMetrics>> t =
 	    ssm.getReadHotRanges(KeyRangeRef(LiteralStringRef("A"), LiteralStringRef("D")), 2.0, 200 * sampleUnit, 0);
 
 	ASSERT(t.size() == 2 && (*t.begin()).keys.begin == LiteralStringRef("Bah") &&
 	       (*t.begin()).keys.end == LiteralStringRef("But"));
-	ASSERT(t.at(1).keys.begin == LiteralStringRef("Cat") && t.at(1).keys.end == LiteralStringRef("Dah"));
+	ASSERT(t[1].keys.begin == LiteralStringRef("Cat") && t[1].keys.end == LiteralStringRef("Dah"));
+
+	return Void();
+}
+
+TEST_CASE("/fdbserver/StorageMetricSample/hotKeys/spaceSaving") {
+	HotKeySample sample(3, 1.0);
+
+	// "a" is seen half the time, so it must stay counted however the other keys churn while the capacity is full
+	for (int i = 0; i < 1000; i++) {
+		sample.sample(LiteralStringRef("a"));
+		sample.sample(StringRef(format("other%d", i % 10)));
+	}
+	sample.sample(LiteralStringRef("b"));
+	ASSERT(sample.counts.size() == 3 && sample.byCount.size() == 3);
+	ASSERT(sample.counts[LiteralStringRef("a")].count == 1000);
+
+	sample.intervalStart -= 10;
+	sample.rollover();
+	ASSERT(sample.counts.empty() && sample.byCount.empty());
+
+	Arena arena;
+	VectorRef<HotKeyRef> hotKeys;
+	sample.getHotKeys(allKeys, 2, arena, hotKeys);
+	ASSERT(hotKeys.size() == 2);
+	ASSERT(hotKeys[0].key == LiteralStringRef("a"));
+	ASSERT(hotKeys[0].hz > 50 && hotKeys[0].errorHz == 0);
+	ASSERT(hotKeys[0].hz >= hotKeys[1].hz);
+
+	// Only keys in the requested range are reported
+	VectorRef<HotKeyRef> inRange;
+	sample.getHotKeys(KeyRangeRef(LiteralStringRef("b"), LiteralStringRef("c")), 10, arena, inRange);
+	ASSERT(inRange.size() == 1 && inRange[0].key == LiteralStringRef("b"));
 
 	return Void();
 }
@@ -275,11 +275,27 @@ struct TLogQueuingMetricsReply {
 
 struct TLogQueuingMetricsRequest {
 	constexpr static FileIdentifier file_identifier = 7798476;
+	// As in StorageQueuingMetricsRequest, a requester with a reply can have the request held until the TLog has taken
+	// in or made durable bytesChange bytes since it, or for at most maxDelay seconds
+	double maxDelay = 0; // Zero to reply at once
+	int64_t bytesChange = 0;
+	int64_t knownInstanceID = -1;
+	int64_t knownBytesInput = 0, knownBytesDurable = 0;
 	ReplyPromise<struct TLogQueuingMetricsReply> reply;
 
+	TLogQueuingMetricsRequest() {}
+	TLogQueuingMetricsRequest(TLogQueuingMetricsReply const& known, double maxDelay, int64_t bytesChange)
+	  : maxDelay(maxDelay), bytesChange(bytesChange), knownInstanceID(known.instanceID),
+	    knownBytesInput(known.bytesInput), knownBytesDurable(known.bytesDurable) {}
+
+	bool shouldReply(int64_t instanceID, int64_t bytesInput, int64_t bytesDurable, double heldFor) const {
+		return heldFor >= maxDelay || instanceID != knownInstanceID || bytesInput - knownBytesInput >= bytesChange ||
+		       bytesDurable - knownBytesDurable >= bytesChange;
+	}
+
 	template <class Ar>
 	void serialize(Ar& ar) {
-		serializer(ar, reply);
+		serializer(ar, reply, maxDelay, bytesChange, knownInstanceID, knownBytesInput, knownBytesDurable);
 	}
 };
 
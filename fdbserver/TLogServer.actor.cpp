@@ -41,6 +41,7 @@
 #include "fdbrpc/Stats.h"
 #include "fdbserver/ServerDBInfo.h"
 #include "fdbserver/LogSystem.h"
+#include "fdbserver/TagMessageIndex.h"
 #include "fdbserver/WaitFailure.h"
 #include "fdbserver/RecoveryState.h"
 #include "fdbserver/FDBExecHelper.actor.h"
@@ -289,6 +290,57 @@ struct SpilledData {
 	uint32_t mutationBytes = 0;
 };
 
+// Replies to peeks of spilled data that stopped short of the end of what was spilled.  Such a reply depends only on
+// durable data that does not change until it is popped, so a repeated peek of the same tag from the same version (by
+// log routers or backup workers sharing a tag, or by a storage server catching up again after a reboot) can be answered
+// without going back to disk.  Entries for popped data are left to age out; tLogPeekMessages checks the popped version
+// before it looks here.
+class SpilledPeekCache : NonCopyable {
+public:
+	struct Entry {
+		Standalone<StringRef> messages;
+		Version end;
+	};
+
+	int64_t hits = 0;
+	int64_t misses = 0;
+
+	Optional<Entry> get(UID logId, Tag tag, Version begin) {
+		auto it = entries.find(Key(logId, tag, begin));
+		if (it == entries.end()) {
+			++misses;
+			return Optional<Entry>();
+		}
+		++hits;
+		lru.splice(lru.end(), lru, it->second.second);
+		return it->second.first;
+	}
+
+	void insert(UID logId, Tag tag, Version begin, StringRef messages, Version end) {
+		const int64_t limit = SERVER_KNOBS->TLOG_SPILLED_PEEK_CACHE_BYTES;
+		Key key(logId, tag, begin);
+		if (messages.size() > limit || entries.count(key)) return;
+		lru.push_back(key);
+		// Copied so that the cache holds exactly the bytes it counts, and not the rest of the writer's buffer
+		entries.emplace(key, std::make_pair(Entry{ Standalone<StringRef>(messages), end }, std::prev(lru.end())));
+		bytes += messages.size();
+		while (bytes > limit) {
+			auto oldest = entries.find(lru.front());
+			bytes -= oldest->second.first.messages.size();
+			entries.erase(oldest);
+			lru.pop_front();
+		}
+	}
+
+	int64_t getBytes() const { return bytes; }
+
+private:
+	typedef std::tuple<UID, Tag, Version> Key;
+	std::map<Key, std::pair<Entry, std::list<Key>::iterator>> entries;
+	std::list<Key> lru; // Least recently used first
+	int64_t bytes = 0;
+};
+
 struct TLogData : NonCopyable {
 	AsyncTrigger newLogData;
 	// A process has only 1 SharedTLog, which holds data for multiple logs, so that it obeys its assigned memory limit.
@@ -320,6 +372,10 @@ struct TLogData : NonCopyable {
 
 	int64_t diskQueueCommitBytes;
 	AsyncVar<bool> largeDiskQueueCommitBytes; //becomes true when diskQueueCommitBytes is greater than MAX_QUEUE_COMMIT_BYTES
+	int64_t commitsSinceQueueCommit; // tLogCommit requests pushed to persistentQueue since its last commit began
+	int64_t queueCommits;
+	int64_t queueCommitsBatched; // tLogCommit requests made durable by those queueCommits
+	double queueCommitLatency; // Smoothed duration of a persistentQueue commit, which is mostly its fsync
 
 	Reference<AsyncVar<ServerDBInfo>> dbInfo;
 	Database cx;
@@ -336,6 +392,7 @@ struct TLogData : NonCopyable {
 
 	WorkerCache<TLogInterface> tlogCache;
 	FlowLock peekMemoryLimiter;
+	SpilledPeekCache spilledPeekCache;
 
 	PromiseStream<Future<Void>> sharedActors;
 	Promise<Void> terminated;
@@ -356,8 +413,6 @@ struct TLogData : NonCopyable {
 	Reference<AsyncVar<bool>> degraded;
 	// End of fields used by snapshot based backup and restore
 
-	std::vector<TagsAndMessage> tempTagMessages;
-
 	Reference<Histogram> commitLatencyDist;
 
 	TLogData(UID dbgid, UID workerID, IKeyValueStore* persistentData, IDiskQueue* persistentQueue,
@@ -365,7 +420,8 @@ struct TLogData : NonCopyable {
 	  : dbgid(dbgid), workerID(workerID), instanceID(deterministicRandom()->randomUniqueID().first()),
 	    persistentData(persistentData), rawPersistentQueue(persistentQueue),
 	    persistentQueue(new TLogQueue(persistentQueue, dbgid)), dbInfo(dbInfo), degraded(degraded), queueCommitBegin(0),
-	    queueCommitEnd(0), diskQueueCommitBytes(0), largeDiskQueueCommitBytes(false), bytesInput(0), bytesDurable(0),
+	    queueCommitEnd(0), diskQueueCommitBytes(0), largeDiskQueueCommitBytes(false),
+	    commitsSinceQueueCommit(0), queueCommits(0), queueCommitsBatched(0), queueCommitLatency(0), bytesInput(0), bytesDurable(0),
 	    targetVolatileBytes(SERVER_KNOBS->TLOG_SPILL_THRESHOLD), overheadBytesInput(0), overheadBytesDurable(0),
 	    peekMemoryLimiter(SERVER_KNOBS->TLOG_SPILL_REFERENCE_MAX_PEEK_MEMORY_BYTES),
 	    concurrentLogRouterReads(SERVER_KNOBS->CONCURRENT_LOG_ROUTER_READS), ignorePopRequest(false),
@@ -378,7 +434,7 @@ struct TLogData : NonCopyable {
 
 struct LogData : NonCopyable, public ReferenceCounted<LogData> {
 	struct TagData : NonCopyable, public ReferenceCounted<TagData> {
-		std::deque<std::pair<Version, LengthPrefixedStringRef>> versionMessages;
+		TagMessageIndex versionMessages;
 		bool nothingPersistent;				// true means tag is *known* to have no messages in persistentData.  false means nothing.
 		bool poppedRecently;					// `popped` has changed since last updatePersistentData
 		Version popped;				// see popped version tracking contract below
@@ -415,7 +471,7 @@ struct LogData : NonCopyable, public ReferenceCounted<LogData> {
 				int64_t messagesErased = 0;
 
 				while(!self->versionMessages.empty() && self->versionMessages.front().first == version) {
-					auto const& m = self->versionMessages.front();
+					auto m = self->versionMessages.front();
 					++messagesErased;
 
 					if(self->tag.locality != tagLocalityTxs && self->tag != txsTag) {
@@ -427,7 +483,7 @@ struct LogData : NonCopyable, public ReferenceCounted<LogData> {
 					self->versionMessages.pop_front();
 				}
 
-				int64_t bytesErased = messagesErased * SERVER_KNOBS->VERSION_MESSAGES_ENTRY_BYTES_WITH_OVERHEAD;
+				int64_t bytesErased = messagesErased * SERVER_KNOBS->TAG_MESSAGE_INDEX_ENTRY_BYTES_WITH_OVERHEAD;
 				logData->bytesDurable += bytesErased;
 				tlogData->bytesDurable += bytesErased;
 				tlogData->overheadBytesDurable += bytesErased;
@@ -619,6 +675,12 @@ struct LogData : NonCopyable, public ReferenceCounted<LogData> {
 		specialCounter(cc, "QueueDiskBytesTotal", [tLogData](){ return tLogData->rawPersistentQueue->getStorageBytes().total; });
 		specialCounter(cc, "PeekMemoryReserved", [tLogData]() { return tLogData->peekMemoryLimiter.activePermits(); });
 		specialCounter(cc, "PeekMemoryRequestsStalled", [tLogData]() { return tLogData->peekMemoryLimiter.waiters(); });
+		specialCounter(cc, "SpilledPeekCacheBytes", [tLogData]() { return tLogData->spilledPeekCache.getBytes(); });
+		specialCounter(cc, "SpilledPeekCacheHits", [tLogData]() { return tLogData->spilledPeekCache.hits; });
+		specialCounter(cc, "SpilledPeekCacheMisses", [tLogData]() { return tLogData->spilledPeekCache.misses; });
+		specialCounter(cc, "QueueCommits", [tLogData]() { return tLogData->queueCommits; });
+		specialCounter(cc, "QueueCommitsBatched", [tLogData]() { return tLogData->queueCommitsBatched; });
+		specialCounter(cc, "QueueCommitLatencyMicros", [tLogData]() { return int64_t(tLogData->queueCommitLatency * 1e6); });
 		specialCounter(cc, "Geneartion", [this]() { return this->recoveryCount; });
 	}
 
@@ -680,6 +742,8 @@ struct LogData : NonCopyable, public ReferenceCounted<LogData> {
 template <class T>
 void TLogQueue::push( T const& qe, Reference<LogData> logData ) {
 	BinaryWriter wr( Unversioned() );  // outer framing is not versioned
+	// The messages make up nearly all of the entry; the rest is a few fixed size fields
+	wr.reserve(qe.expectedSize() + 64);
 	wr << uint32_t(0);
 	IncludeVersion(ProtocolVersion::withTLogQueueEntryRef()).write(wr);  // payload is versioned
 	wr << qe;
@@ -873,8 +937,22 @@ ACTOR Future<Void> popDiskQueue( TLogData* self, Reference<LogData> logData ) {
 		if (locationIter != logData->versionLocation.end()) {
 			lastCommittedLocation = locationIter->value.first;
 		}
-		self->persistentQueue->pop( std::min(minLocation, lastCommittedLocation) );
+		IDiskQueue::location popLocation = std::min(minLocation, lastCommittedLocation);
+		self->persistentQueue->pop( popLocation );
 		logData->queuePoppedVersion = std::max(logData->queuePoppedVersion, minVersion);
+
+		// A stopped generation that is still needed keeps the whole queue after it, including every newer generation
+		int64_t heldBytes = self->rawPersistentQueue->getNextPushLocation().lo - popLocation.lo;
+		if (logData->stopped && heldBytes > SERVER_KNOBS->TLOG_HARD_LIMIT_BYTES) {
+			TraceEvent(SevWarn, "TLogQueueHeldByStoppedGeneration", self->dbgid)
+			    .suppressFor(60.0)
+			    .detail("LogId", logData->logId)
+			    .detail("HeldBytes", heldBytes)
+			    .detail("Generations", self->popOrder.size())
+			    .detail("MinPoppedTag", logData->minPoppedTag.toString())
+			    .detail("MinPoppedTagVersion", logData->minPoppedTagVersion)
+			    .detail("QueuePoppedVersion", logData->queuePoppedVersion);
+		}
 	}
 
 	return Void();
@@ -908,7 +986,7 @@ ACTOR Future<Void> updatePersistentData( TLogData* self, Reference<LogData> logD
 				state Version lastVersion = std::numeric_limits<Version>::min();
 				state IDiskQueue::location firstLocation = std::numeric_limits<IDiskQueue::location>::max();
 				// Transfer unpopped messages with version numbers less than newPersistentDataVersion to persistentData
-				state std::deque<std::pair<Version, LengthPrefixedStringRef>>::iterator msg = tagData->versionMessages.begin();
+				state TagMessageIndex::iterator msg = tagData->versionMessages.begin();
 				state int refSpilledTagCount = 0;
 				wr = BinaryWriter( AssumeVersion(logData->protocolVersion) );
 				// We prefix our spilled locations with a count, so that we can read this back out as a VectorRef.
@@ -956,7 +1034,7 @@ ACTOR Future<Void> updatePersistentData( TLogData* self, Reference<LogData> logD
 						Future<Void> f = yield(TaskPriority::UpdateStorage);
 						if(!f.isReady()) {
 							wait(f);
-							msg = std::upper_bound(tagData->versionMessages.begin(), tagData->versionMessages.end(), std::make_pair(currentVersion, LengthPrefixedStringRef()), CompareFirst<std::pair<Version, LengthPrefixedStringRef>>());
+							msg = tagData->versionMessages.upperBound(currentVersion);
 						}
 					}
 				}
@@ -1130,6 +1208,25 @@ ACTOR Future<Void> tLogPop( TLogData* self, TLogPopRequest req, Reference<LogDat
 // latencies for more important work (e.g. commits).
 // This actor is just a loop that calls updatePersistentData and popDiskQueue whenever
 // (a) there's data to be spilled or (b) we should update metadata after some commits have been fully popped.
+// Spilling past the returned version would move unpopped data of a caught-up tag, one popped within
+// TLOG_SPILL_RESIDENT_LAG_VERSIONS of the log's version, to disk.  Each of those tags has a storage server that is
+// peeking near the tip, and would then have to read from disk, so a lagging tag should not push their data out.
+Version getSpillResidentVersion(Reference<LogData> logData) {
+	Version residentVersion = std::numeric_limits<Version>::max();
+	if (SERVER_KNOBS->TLOG_SPILL_RESIDENT_LAG_VERSIONS <= 0) {
+		return residentVersion;
+	}
+	for (const auto& tags : logData->tag_data) {
+		for (const auto& tagData : tags) {
+			if (tagData && !tagData->versionMessages.empty() &&
+			    tagData->popped >= logData->version.get() - SERVER_KNOBS->TLOG_SPILL_RESIDENT_LAG_VERSIONS) {
+				residentVersion = std::min(residentVersion, tagData->popped);
+			}
+		}
+	}
+	return residentVersion;
+}
+
 ACTOR Future<Void> updateStorage( TLogData* self ) {
 	while(self->spillOrder.size() && !self->id_data.count(self->spillOrder.front())) {
 		self->spillOrder.pop_front();
@@ -1226,6 +1323,17 @@ ACTOR Future<Void> updateStorage( TLogData* self ) {
 				++sizeItr;
 				nextVersion = sizeItr == logData->version_sizes.end() ? logData->version.get() : sizeItr->key;
 			}
+
+			// Unless memory is beyond the extra allowance, stop short of the caught-up tags' data, and leave the
+			// lagging tags' data below it to be spilled.
+			Version residentVersion = getSpillResidentVersion(logData);
+			if (nextVersion >= residentVersion &&
+			    logData->bytesInput.getValue() - logData->bytesDurable.getValue() <
+			        self->targetVolatileBytes + SERVER_KNOBS->TLOG_SPILL_RESIDENT_EXTRA_BYTES) {
+				TEST(true); // TLog kept caught-up tags in memory instead of spilling them
+				nextVersion = std::max<Version>(logData->persistentDataVersion, residentVersion - 1);
+				totalSize = 0;
+			}
 		}
 
 		//TraceEvent("UpdateStorageVer", logData->logId).detail("NextVersion", nextVersion).detail("PersistentDataVersion", logData->persistentDataVersion).detail("TotalSize", totalSize);
@@ -1265,6 +1373,59 @@ ACTOR Future<Void> updateStorageLoop( TLogData* self ) {
 	}
 }
 
+// Adds a message, already copied into one of logData's message blocks at stored, to the in memory index of each of its
+// tags that this log holds
+static void indexMessage( Reference<LogData> const& logData, Version version, VectorRef<Tag> tags, uint8_t const* stored,
+                          int& expectedBytes, int& txsBytes, int64_t& overheadBytes ) {
+	for(auto tag : tags) {
+		if(logData->locality == tagLocalitySatellite) {
+			if(!(tag.locality == tagLocalityTxs || tag.locality == tagLocalityLogRouter || tag == txsTag)) {
+				continue;
+			}
+		} else if(!(logData->locality == tagLocalitySpecial || logData->locality == tag.locality || tag.locality < 0)) {
+			continue;
+		}
+
+		if(tag.locality == tagLocalityLogRouter) {
+			if(!logData->logRouterTags) {
+				continue;
+			}
+			tag.id = tag.id % logData->logRouterTags;
+		}
+		if(tag.locality == tagLocalityTxs) {
+			if (logData->txsTags > 0) {
+				tag.id = tag.id % logData->txsTags;
+			} else {
+				tag = txsTag;
+			}
+		}
+		Reference<LogData::TagData> tagData = logData->getTagData(tag);
+		if(!tagData) {
+			tagData = logData->createTagData(tag, 0, true, true, false);
+		}
+
+		if (version >= tagData->popped) {
+			LengthPrefixedStringRef message((uint32_t*)stored);
+			tagData->versionMessages.push_back(version, message);
+			if(message.expectedSize() > SERVER_KNOBS->MAX_MESSAGE_SIZE) {
+				TraceEvent(SevWarnAlways, "LargeMessage").detail("Size", message.expectedSize());
+			}
+			if (tag.locality != tagLocalityTxs && tag != txsTag) {
+				expectedBytes += message.expectedSize();
+			} else {
+				txsBytes += message.expectedSize();
+			}
+
+			// The factor of VERSION_MESSAGES_OVERHEAD is intended to be an overestimate of the actual memory used to store a
+			// TagMessageIndex entry in its std::deque. In practice, this number is probably something like 528/512 ~= 1.03,
+			// but this could vary based on the implementation. There will also be a fixed overhead per index, including its
+			// few bases, but its size should be trivial relative to the size of the TLog queue and can be thought of as
+			// increasing the capacity of the queue slightly.
+			overheadBytes += SERVER_KNOBS->TAG_MESSAGE_INDEX_ENTRY_BYTES_WITH_OVERHEAD;
+		}
+	}
+}
+
 void commitMessages( TLogData* self, Reference<LogData> logData, Version version, const std::vector<TagsAndMessage>& taggedMessages ) {
 	// SOMEDAY: This method of copying messages is reasonably memory efficient, but it's still a lot of bytes copied.  Find a
 	// way to do the memory allocation right as we receive the messages in the network layer.
@@ -1306,52 +1467,7 @@ void commitMessages( TLogData* self, Reference<LogData> logData, Version version
 
 		DEBUG_TAGS_AND_MESSAGE("TLogCommitMessages", version, msg.getRawMessage()).detail("UID", self->dbgid).detail("LogId", logData->logId);
 		block.append(block.arena(), msg.message.begin(), msg.message.size());
-		for(auto tag : msg.tags) {
-			if(logData->locality == tagLocalitySatellite) {
-				if(!(tag.locality == tagLocalityTxs || tag.locality == tagLocalityLogRouter || tag == txsTag)) {
-					continue;
-				}
-			} else if(!(logData->locality == tagLocalitySpecial || logData->locality == tag.locality || tag.locality < 0)) {
-				continue;
-			}
-
-			if(tag.locality == tagLocalityLogRouter) {
-				if(!logData->logRouterTags) {
-					continue;
-				}
-				tag.id = tag.id % logData->logRouterTags;
-			}
-			if(tag.locality == tagLocalityTxs) {
-				if (logData->txsTags > 0) {
-					tag.id = tag.id % logData->txsTags;
-				} else {
-					tag = txsTag;
-				}
-			}
-			Reference<LogData::TagData> tagData = logData->getTagData(tag);
-			if(!tagData) {
-				tagData = logData->createTagData(tag, 0, true, true, false);
-			}
-
-			if (version >= tagData->popped) {
-				tagData->versionMessages.emplace_back(version, LengthPrefixedStringRef((uint32_t*)(block.end() - msg.message.size())));
-				if(tagData->versionMessages.back().second.expectedSize() > SERVER_KNOBS->MAX_MESSAGE_SIZE) {
-					TraceEvent(SevWarnAlways, "LargeMessage").detail("Size", tagData->versionMessages.back().second.expectedSize());
-				}
-				if (tag.locality != tagLocalityTxs && tag != txsTag) {
-					expectedBytes += tagData->versionMessages.back().second.expectedSize();
-				} else {
-					txsBytes += tagData->versionMessages.back().second.expectedSize();
-				}
-
-				// The factor of VERSION_MESSAGES_OVERHEAD is intended to be an overestimate of the actual memory used to store this data in a std::deque.
-				// In practice, this number is probably something like 528/512 ~= 1.03, but this could vary based on the implementation.
-				// There will also be a fixed overhead per std::deque, but its size should be trivial relative to the size of the TLog
-				// queue and can be thought of as increasing the capacity of the queue slightly.
-				overheadBytes += SERVER_KNOBS->VERSION_MESSAGES_ENTRY_BYTES_WITH_OVERHEAD;
-			}
-		}
-
+		indexMessage(logData, version, msg.tags, block.end() - msg.message.size(), expectedBytes, txsBytes, overheadBytes);
 		msgSize -= msg.message.size();
 	}
 	logData->messageBlocks.emplace_back(version, block);
@@ -1366,15 +1482,42 @@ void commitMessages( TLogData* self, Reference<LogData> logData, Version version
 	//TraceEvent("TLogPushed", self->dbgid).detail("Bytes", addedBytes).detail("MessageBytes", messages.size()).detail("Tags", tags.size()).detail("ExpectedBytes", expectedBytes).detail("MCount", mCount).detail("TCount", tCount);
 }
 
+// The messages of a commit are contiguous, so they are copied into a block all at once and indexed where they land,
+// rather than parsed into a list and then copied one at a time
 void commitMessages( TLogData *self, Reference<LogData> logData, Version version, Arena arena, StringRef messages ) {
-	ArenaReader rd( arena, messages, Unversioned() );
-	self->tempTagMessages.clear();
+	if(!messages.size()) {
+		return;
+	}
+
+	Standalone<VectorRef<uint8_t>> block;
+	if(!logData->messageBlocks.empty()) {
+		block = logData->messageBlocks.back().second;
+		block.pop_front(block.size());
+	}
+	if(messages.size() > block.capacity() - block.size()) {
+		block = Standalone<VectorRef<uint8_t>>();
+		block.reserve(block.arena(), std::max<int64_t>(SERVER_KNOBS->TLOG_MESSAGE_BLOCK_BYTES, messages.size()));
+	}
+	block.append(block.arena(), messages.begin(), messages.size());
+
+	int64_t overheadBytes = 0;
+	int expectedBytes = 0;
+	int txsBytes = 0;
+	ArenaReader rd( block.arena(), StringRef(block.begin(), block.size()), Unversioned() );
 	while(!rd.empty()) {
-		TagsAndMessage tagsAndMsg;
-		tagsAndMsg.loadFromArena(&rd, nullptr);
-		self->tempTagMessages.push_back(std::move(tagsAndMsg));
+		TagsAndMessage msg;
+		msg.loadFromArena(&rd, nullptr);
+		DEBUG_TAGS_AND_MESSAGE("TLogCommitMessages", version, msg.getRawMessage()).detail("UID", self->dbgid).detail("LogId", logData->logId);
+		indexMessage(logData, version, msg.tags, msg.message.begin(), expectedBytes, txsBytes, overheadBytes);
 	}
-	commitMessages(self, logData, version, self->tempTagMessages);
+
+	logData->messageBlocks.emplace_back(version, block);
+	int64_t addedBytes = int64_t(block.size()) * SERVER_KNOBS->TLOG_MESSAGE_BLOCK_OVERHEAD_FACTOR + overheadBytes;
+
+	logData->version_sizes[version] = std::make_pair(expectedBytes, txsBytes);
+	logData->bytesInput += addedBytes;
+	self->bytesInput += addedBytes;
+	self->overheadBytesInput += overheadBytes;
 }
 
 Version poppedVersion( Reference<LogData> self, Tag tag) {
@@ -1388,10 +1531,10 @@ Version poppedVersion( Reference<LogData> self, Tag tag) {
 	return tagData->popped;
 }
 
-std::deque<std::pair<Version, LengthPrefixedStringRef>> & getVersionMessages( Reference<LogData> self, Tag tag ) {
+TagMessageIndex const& getVersionMessages( Reference<LogData> self, Tag tag ) {
 	auto tagData = self->getTagData(tag);
 	if (!tagData) {
-		static std::deque<std::pair<Version, LengthPrefixedStringRef>> empty;
+		static TagMessageIndex empty;
 		return empty;
 	}
 	return tagData->versionMessages;
@@ -1404,7 +1547,7 @@ void peekMessagesFromMemory( Reference<LogData> self, TLogPeekRequest const& req
 	//TraceEvent("TLogPeekMem", self->dbgid).detail("Tag", req.tag1).detail("PDS", self->persistentDataSequence).detail("PDDS", self->persistentDataDurableSequence).detail("Oldest", map1.empty() ? 0 : map1.begin()->key ).detail("OldestMsgCount", map1.empty() ? 0 : map1.begin()->value.size());
 
 	Version begin = std::max( req.begin, self->persistentDataDurableVersion+1 );
-	auto it = std::lower_bound(deque.begin(), deque.end(), std::make_pair(begin, LengthPrefixedStringRef()), CompareFirst<std::pair<Version, LengthPrefixedStringRef>>());
+	auto it = deque.lowerBound(begin);
 
 	Version currentVersion = -1;
 	for(; it != deque.end(); ++it) {
@@ -1585,10 +1728,17 @@ ACTOR Future<Void> tLogPeekMessages( TLogData* self, TLogPeekRequest req, Refere
 
 	state Version endVersion = logData->version.get() + 1;
 	state bool onlySpilled = false;
+	state Optional<SpilledPeekCache::Entry> cachedPeek;
+	if (req.begin <= logData->persistentDataDurableVersion && SERVER_KNOBS->TLOG_SPILLED_PEEK_CACHE_BYTES > 0) {
+		cachedPeek = self->spilledPeekCache.get(logData->logId, req.tag, req.begin);
+	}
 
 	//grab messages from disk
 	//TraceEvent("TLogPeekMessages", self->dbgid).detail("ReqBeginEpoch", req.begin.epoch).detail("ReqBeginSeq", req.begin.sequence).detail("Epoch", self->epoch()).detail("PersistentDataSeq", self->persistentDataSequence).detail("Tag1", req.tag1).detail("Tag2", req.tag2);
-	if( req.begin <= logData->persistentDataDurableVersion ) {
+	if (cachedPeek.present()) {
+		endVersion = cachedPeek.get().end;
+		onlySpilled = true;
+	} else if( req.begin <= logData->persistentDataDurableVersion ) {
 		// Just in case the durable version changes while we are waiting for the read, we grab this data from memory.  We may or may not actually send it depending on
 		// whether we get enough data from disk.
 		// SOMEDAY: Only do this if an initial attempt to read from disk results in insufficient data and the required data is no longer in memory
@@ -1629,6 +1779,7 @@ ACTOR Future<Void> tLogPeekMessages( TLogData* self, TLogPeekRequest req, Refere
 			//TraceEvent("TLogPeekResults", self->dbgid).detail("ForAddress", req.reply.getEndpoint().getPrimaryAddress()).detail("Tag1Results", s1).detail("Tag2Results", s2).detail("Tag1ResultsLim", kv1.size()).detail("Tag2ResultsLim", kv2.size()).detail("Tag1ResultsLast", kv1.size() ? kv1[0].key : "").detail("Tag2ResultsLast", kv2.size() ? kv2[0].key : "").detail("Limited", limited).detail("NextEpoch", next_pos.epoch).detail("NextSeq", next_pos.sequence).detail("NowEpoch", self->epoch()).detail("NowSeq", self->sequence.getNextSequence());
 
 			state std::vector<std::pair<IDiskQueue::location, IDiskQueue::location>> commitLocations;
+			state std::vector<Version> commitVersions;
 			state bool earlyEnd = false;
 			uint32_t mutationBytes = 0;
 			state uint64_t commitBytes = 0;
@@ -1647,6 +1798,7 @@ ACTOR Future<Void> tLogPeekMessages( TLogData* self, TLogPeekRequest req, Refere
 						firstVersion = std::min(firstVersion, sd.version);
 						const IDiskQueue::location end = sd.start.lo + sd.length;
 						commitLocations.emplace_back(sd.start, end);
+						commitVersions.push_back(sd.version);
 						// This isn't perfect, because we aren't accounting for page boundaries, but should be
 						// close enough.
 						commitBytes += sd.length;
@@ -1656,44 +1808,77 @@ ACTOR Future<Void> tLogPeekMessages( TLogData* self, TLogPeekRequest req, Refere
 				if (earlyEnd) break;
 			}
 			earlyEnd = earlyEnd || (kvrefs.size() >= SERVER_KNOBS->TLOG_SPILL_REFERENCE_MAX_BATCHES_PER_PEEK+1);
+
+			// Commits that are next to each other in the queue, as they usually are for a busy tag, are read with one
+			// request and split apart below.  So are commits separated by only a few other commits, which are read
+			// and skipped, so that catching up on a tag becomes a few large sequential reads.
+			state std::vector<std::pair<IDiskQueue::location, IDiskQueue::location>> readLocations;
+			for (int i = 0; i < commitLocations.size();) {
+				int j = i + 1;
+				while (j < commitLocations.size() && commitLocations[j].first >= commitLocations[j - 1].second &&
+				       commitLocations[j].first.lo - commitLocations[j - 1].second.lo <=
+				           SERVER_KNOBS->TLOG_SPILL_REFERENCE_MAX_READ_GAP_BYTES) {
+					commitBytes += commitLocations[j].first.lo - commitLocations[j - 1].second.lo;
+					j++;
+				}
+				readLocations.emplace_back(commitLocations[i].first, commitLocations[j - 1].second);
+				i = j;
+			}
+			commitLocations.clear();
+
 			wait( self->peekMemoryLimiter.take(TaskPriority::TLogSpilledPeekReply, commitBytes) );
 			state FlowLock::Releaser memoryReservation(self->peekMemoryLimiter, commitBytes);
 			state std::vector<Future<Standalone<StringRef>>> messageReads;
-			messageReads.reserve( commitLocations.size() );
-			for (const auto& pair : commitLocations) {
-				messageReads.push_back( self->rawPersistentQueue->read(pair.first, pair.second, CheckHashes::YES ) );
+			messageReads.reserve( readLocations.size() );
+			for (const auto& location : readLocations) {
+				messageReads.push_back( self->rawPersistentQueue->read(location.first, location.second, CheckHashes::YES ) );
 			}
-			commitLocations.clear();
+			readLocations.clear();
 			wait( waitForAll( messageReads ) );
 
 			state Version lastRefMessageVersion = 0;
 			state int index = 0;
+			state int offset = 0; // Of the next commit in messageReads[index]
+			state int nextCommit = 0; // Index in commitVersions of the next commit to be returned
 			loop {
 				if (index >= messageReads.size()) break;
 				Standalone<StringRef> queueEntryData = messageReads[index].get();
 				uint8_t valid;
-				const uint32_t length = *(uint32_t*)queueEntryData.begin();
-				queueEntryData = queueEntryData.substr( 4, queueEntryData.size() - 4);
+				ASSERT( offset + sizeof(uint32_t) <= queueEntryData.size() );
+				const uint32_t length = *(uint32_t*)(queueEntryData.begin() + offset);
+				ASSERT( offset + sizeof(uint32_t) + length + sizeof(valid) <= queueEntryData.size() );
+				queueEntryData = queueEntryData.substr( offset + 4, length + sizeof(valid) );
+				offset += 4 + length + sizeof(valid);
 				BinaryReader rd( queueEntryData, IncludeVersion() );
 				state TLogQueueEntry entry;
 				rd >> entry >> valid;
-				ASSERT( valid == 0x01 );
-				ASSERT( length + sizeof(valid) == queueEntryData.size() );
 
-				messages << VERSION_HEADER << entry.version;
+				// Commits read only because they lie between two of ours belong to other tags or generations
+				if (entry.id == logData->logId && nextCommit < commitVersions.size() &&
+				    entry.version == commitVersions[nextCommit]) {
+					ASSERT( valid == 0x01 );
+					nextCommit++;
 
-				std::vector<StringRef> rawMessages =
-				    wait(parseMessagesForTag(entry.messages, req.tag, logData->logRouterTags));
-				for (const StringRef& msg : rawMessages) {
-					messages.serializeBytes(msg);
-					DEBUG_TAGS_AND_MESSAGE("TLogPeekFromDisk", entry.version, msg).detail("UID", self->dbgid).detail("LogId", logData->logId).detail("PeekTag", req.tag);
-				}
+					messages << VERSION_HEADER << entry.version;
+
+					std::vector<StringRef> rawMessages =
+					    wait(parseMessagesForTag(entry.messages, req.tag, logData->logRouterTags));
+					for (const StringRef& msg : rawMessages) {
+						messages.serializeBytes(msg);
+						DEBUG_TAGS_AND_MESSAGE("TLogPeekFromDisk", entry.version, msg).detail("UID", self->dbgid).detail("LogId", logData->logId).detail("PeekTag", req.tag);
+					}
 
-				lastRefMessageVersion = entry.version;
-				index++;
+					lastRefMessageVersion = entry.version;
+				}
+				if (offset == messageReads[index].get().size()) {
+					index++;
+					offset = 0;
+				}
 			}
 
+			ASSERT( nextCommit == commitVersions.size() );
 			messageReads.clear();
+			commitVersions.clear();
 			memoryReservation.release();
 
 			if (earlyEnd) {
@@ -1716,7 +1901,16 @@ ACTOR Future<Void> tLogPeekMessages( TLogData* self, TLogPeekRequest req, Refere
 	TLogPeekReply reply;
 	reply.maxKnownVersion = logData->version.get();
 	reply.minKnownCommittedVersion = logData->minKnownCommittedVersion;
-	reply.messages = messages.toValue();
+	if (cachedPeek.present()) {
+		reply.arena = cachedPeek.get().messages.arena();
+		reply.messages = cachedPeek.get().messages;
+	} else {
+		reply.messages = messages.toValue();
+		// Only a reply that ended early is complete without what is still in memory
+		if (onlySpilled && SERVER_KNOBS->TLOG_SPILLED_PEEK_CACHE_BYTES > 0) {
+			self->spilledPeekCache.insert(logData->logId, req.tag, req.begin, reply.messages, endVersion);
+		}
+	}
 	reply.end = endVersion;
 	reply.onlySpilled = onlySpilled;
 
@@ -1794,12 +1988,17 @@ ACTOR Future<Void> doQueueCommit( TLogData* self, Reference<LogData> logData, st
 	logData->queueCommittingVersion = ver;
 
 	g_network->setCurrentTask(TaskPriority::TLogCommitReply);
+	state double commitStart = now();
 	Future<Void> c = self->persistentQueue->commit();
 	self->diskQueueCommitBytes = 0;
 	self->largeDiskQueueCommitBytes.set(false);
+	self->queueCommits++;
+	self->queueCommitsBatched += self->commitsSinceQueueCommit;
+	self->commitsSinceQueueCommit = 0;
 
 	state Future<Void> degraded = watchDegraded(self);
 	wait(c);
+	self->queueCommitLatency = 0.9 * self->queueCommitLatency + 0.1 * (now() - commitStart);
 	if(g_network->isSimulated() && !g_simulator.speedUpSimulation && BUGGIFY_WITH_PROB(0.0001)) {
 		wait(delay(6.0));
 	}
@@ -1838,6 +2037,7 @@ ACTOR Future<Void> doQueueCommit( TLogData* self, Reference<LogData> logData, st
 
 ACTOR Future<Void> commitQueue( TLogData* self ) {
 	state Reference<LogData> logData;
+	state bool waitedForCommit;
 
 	loop {
 		int foundCount = 0;
@@ -1870,9 +2070,21 @@ ACTOR Future<Void> commitQueue( TLogData* self ) {
 
 			choose {
 				when(wait( logData->version.whenAtLeast( std::max(logData->queueCommittingVersion, logData->queueCommittedVersion.get()) + 1 ) ) ) {
+					waitedForCommit = self->queueCommitBegin != self->queueCommitEnd.get();
 					while( self->queueCommitBegin != self->queueCommitEnd.get() && !self->largeDiskQueueCommitBytes.get() ) {
 						wait( self->queueCommitEnd.whenAtLeast(self->queueCommitBegin) || self->largeDiskQueueCommitBytes.onChange() );
 					}
+					// Commits that arrive while one is in flight are already merged into the next one.  When the queue
+					// was idle, hold this commit back for part of a typical fsync so that the rest of a burst joins it.
+					if( !waitedForCommit && !self->largeDiskQueueCommitBytes.get() ) {
+						double groupDelay = std::min( SERVER_KNOBS->TLOG_MAX_GROUP_COMMIT_DELAY, self->queueCommitLatency * SERVER_KNOBS->TLOG_GROUP_COMMIT_DELAY_FRACTION );
+						if( groupDelay > 0 ) {
+							choose {
+								when( wait( delay( groupDelay, TaskPriority::TLogCommit ) ) ) {}
+								when( wait( self->largeDiskQueueCommitBytes.onChange() ) ) {}
+							}
+						}
+					}
 					self->sharedActors.send(doQueueCommit(self, logData, missingFinalCommit));
 					missingFinalCommit.clear();
 				}
@@ -1947,6 +2159,7 @@ ACTOR Future<Void> tLogCommit(
 		if( self->diskQueueCommitBytes > SERVER_KNOBS->MAX_QUEUE_COMMIT_BYTES ) {
 			self->largeDiskQueueCommitBytes.set(true);
 		}
+		self->commitsSinceQueueCommit++;
 
 		// Notifies the commitQueue actor to commit persistentQueue, and also unblocks tLogPeekMessages actors
 		logData->version.set( req.version );
@@ -2145,6 +2358,15 @@ void getQueuingMetrics( TLogData* self, Reference<LogData> logData, TLogQueuingM
 	req.reply.send( reply );
 }
 
+ACTOR Future<Void> waitForQueuingMetricsChange( TLogData* self, Reference<LogData> logData, TLogQueuingMetricsRequest req ) {
+	state double start = now();
+	while (!req.shouldReply(self->instanceID, self->bytesInput, self->bytesDurable, now() - start)) {
+		wait(delay(std::min(SERVER_KNOBS->QUEUING_METRICS_CHECK_INTERVAL, start + req.maxDelay - now())));
+	}
+	getQueuingMetrics(self, logData, req);
+	return Void();
+}
+
 
 ACTOR Future<Void>
 tLogSnapCreate(TLogSnapRequest snapReq, TLogData* self, Reference<LogData> logData) {
@@ -2255,7 +2477,11 @@ ACTOR Future<Void> serveTLogInterface( TLogData* self, TLogInterface tli, Refere
 			logData->addActor.send( tLogLock(self, reply, logData) );
 		}
 		when (TLogQueuingMetricsRequest req = waitNext(tli.getQueuingMetrics.getFuture())) {
-			getQueuingMetrics(self, logData, req);
+			if (req.maxDelay > 0) {
+				logData->addActor.send(waitForQueuingMetricsChange(self, logData, req));
+			} else {
+				getQueuingMetrics(self, logData, req);
+			}
 		}
 		when (TLogConfirmRunningRequest req = waitNext(tli.confirmRunning.getFuture())){
 			if (req.debugID.present() ) {
@@ -2509,10 +2735,30 @@ ACTOR Future<Void> checkRecovered(TLogData* self) {
 }
 
 // Recovery persistent state of tLog from disk
+ACTOR Future<Void> restorePoppedTags( TLogData* self, Reference<LogData> logData, KeyRef rawId ) {
+	state KeyRange tagKeys = prefixRange( rawId.withPrefix(persistTagPoppedKeys.begin) );
+	loop {
+		if(logData->removed.isReady()) break;
+		Standalone<RangeResultRef> data = wait( self->persistentData->readRange( tagKeys, BUGGIFY ? 3 : 1<<30, 1<<20 ) );
+		if (!data.size()) break;
+		((KeyRangeRef&)tagKeys) = KeyRangeRef( keyAfter(data.back().key, tagKeys.arena()), tagKeys.end );
+
+		for(auto &kv : data) {
+			Tag tag = decodeTagPoppedKey(rawId, kv.key);
+			Version popped = decodeTagPoppedValue(kv.value);
+			TraceEvent("TLogRestorePopped", logData->logId).detail("Tag", tag.toString()).detail("To", popped);
+			auto tagData = logData->getTagData(tag);
+			ASSERT( !tagData );
+			logData->createTagData(tag, popped, false, false, false);
+			logData->getTagData(tag)->persistentPopped = popped;
+		}
+	}
+	return Void();
+}
+
 ACTOR Future<Void> restorePersistentState( TLogData* self, LocalityData locality, Promise<Void> oldLog, Promise<Void> recovered, PromiseStream<InitializeTLogRequest> tlogRequests ) {
 	state double startt = now();
 	state Reference<LogData> logData;
-	state KeyRange tagKeys;
 	// PERSIST: Read basic state from persistentData; replay persistentQueue but don't erase it
 
 	TraceEvent("TLogRestorePersistentState", self->dbgid);
@@ -2594,6 +2840,7 @@ ACTOR Future<Void> restorePersistentState( TLogData* self, LocalityData locality
 	state Promise<Void> registerWithMaster;
 	state std::map<UID, TLogInterface> id_interf;
 	state std::vector<std::pair<Version, UID>> logsByVersion;
+	state std::vector<Future<Void>> restoredPopped;
 	for(idx = 0; idx < fVers.get().size(); idx++) {
 		state KeyRef rawId = fVers.get()[idx].key.removePrefix(persistCurrentVersionKeys.begin);
 		UID id1 = BinaryReader::fromStringRef<UID>( rawId, Unversioned() );
@@ -2638,25 +2885,11 @@ ACTOR Future<Void> restorePersistentState( TLogData* self, LocalityData locality
 
 		TraceEvent("TLogPersistentStateRestore", self->dbgid).detail("LogId", logData->logId).detail("Ver", ver);
 		// Restore popped keys.  Pop operations that took place after the last (committed) updatePersistentDataVersion might be lost, but
-		// that is fine because we will get the corresponding data back, too.
-		tagKeys = prefixRange( rawId.withPrefix(persistTagPoppedKeys.begin) );
-		loop {
-			if(logData->removed.isReady()) break;
-			Standalone<RangeResultRef> data = wait( self->persistentData->readRange( tagKeys, BUGGIFY ? 3 : 1<<30, 1<<20 ) );
-			if (!data.size()) break;
-			((KeyRangeRef&)tagKeys) = KeyRangeRef( keyAfter(data.back().key, tagKeys.arena()), tagKeys.end );
-
-			for(auto &kv : data) {
-				Tag tag = decodeTagPoppedKey(rawId, kv.key);
-				Version popped = decodeTagPoppedValue(kv.value);
-				TraceEvent("TLogRestorePopped", logData->logId).detail("Tag", tag.toString()).detail("To", popped);
-				auto tagData = logData->getTagData(tag);
-				ASSERT( !tagData );
-				logData->createTagData(tag, popped, false, false, false);
-				logData->getTagData(tag)->persistentPopped = popped;
-			}
-		}
+		// that is fine because we will get the corresponding data back, too.  The generations are independent, so their reads
+		// overlap.
+		restoredPopped.push_back(restorePoppedTags(self, logData, rawId));
 	}
+	wait(waitForAll(restoredPopped));
 
 	std::sort(logsByVersion.begin(), logsByVersion.end());
 	for (const auto& pair : logsByVersion) {
@@ -3062,7 +3295,7 @@ struct DequeAllocator : std::allocator<T> {
 
 TEST_CASE("/fdbserver/tlogserver/VersionMessagesOverheadFactor" ) {
 
-	typedef std::pair<Version, LengthPrefixedStringRef> TestType; // type used by versionMessages
+	typedef TagMessageIndex::Entry TestType; // type of the entries of versionMessages
 
 	for(int i = 1; i < 9; ++i) {
 		for(int j = 0; j < 20; ++j) {
@@ -3091,3 +3324,59 @@ TEST_CASE("/fdbserver/tlogserver/VersionMessagesOverheadFactor" ) {
 
 	return Void();
 }
+
+TEST_CASE("/fdbserver/tlogserver/TagMessageIndex") {
+	// Messages in two blocks, so that the index needs a new base when the second is below the first, and versions
+	// that jump too far for a 32 bit delta
+	state Standalone<VectorRef<uint8_t>> blocks[2];
+	state std::deque<std::pair<Version, LengthPrefixedStringRef>> expected;
+	state TagMessageIndex index;
+	for (auto& block : blocks) {
+		block.reserve(block.arena(), 100000);
+	}
+	Version version = 0;
+	for (int i = 0; i < 1000; ++i) {
+		version += deterministicRandom()->random01() < 0.01 ? (int64_t)std::numeric_limits<uint32_t>::max() + 1
+		                                                    : deterministicRandom()->randomInt(0, 3);
+		auto& block = blocks[deterministicRandom()->randomInt(0, 2)];
+		uint32_t length = deterministicRandom()->randomInt(0, 20);
+		block.append(block.arena(), (uint8_t*)&length, sizeof(length));
+		block.resize(block.arena(), block.size() + length);
+		LengthPrefixedStringRef message((uint32_t*)(block.end() - length - sizeof(length)));
+		expected.emplace_back(version, message);
+		index.push_back(version, message);
+
+		if (deterministicRandom()->random01() < 0.3) {
+			ASSERT(index.front().first == expected.front().first &&
+			       index.front().second.getLengthPtr() == expected.front().second.getLengthPtr());
+			expected.pop_front();
+			index.pop_front();
+		}
+		ASSERT(index.size() == expected.size());
+		if (!expected.empty()) {
+			ASSERT(index.back().first == expected.back().first &&
+			       index.back().second.getLengthPtr() == expected.back().second.getLengthPtr());
+		}
+	}
+
+	auto e = expected.begin();
+	for (auto it = index.begin(); it != index.end(); ++it, ++e) {
+		ASSERT(it->first == e->first && it->second.getLengthPtr() == e->second.getLengthPtr());
+	}
+	ASSERT(e == expected.end());
+
+	for (int i = 0; i < 100 && !expected.empty(); ++i) {
+		Version v = expected[deterministicRandom()->randomInt(0, expected.size())].first;
+		auto lower = std::lower_bound(expected.begin(), expected.end(), std::make_pair(v, LengthPrefixedStringRef()),
+		                              CompareFirst<std::pair<Version, LengthPrefixedStringRef>>());
+		auto upper = std::upper_bound(expected.begin(), expected.end(), std::make_pair(v, LengthPrefixedStringRef()),
+		                              CompareFirst<std::pair<Version, LengthPrefixedStringRef>>());
+		auto it = index.lowerBound(v);
+		ASSERT(it->second.getLengthPtr() == lower->second.getLengthPtr());
+		it = index.upperBound(v);
+		ASSERT(upper == expected.end() ? it == index.end()
+		                               : it->second.getLengthPtr() == upper->second.getLengthPtr());
+	}
+
+	return Void();
+}
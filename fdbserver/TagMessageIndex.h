@@ -0,0 +1,166 @@
+/*
+ * TagMessageIndex.h
+ *
+ * This source file is part of the FoundationDB open source project
+ *
+ * Copyright 2013-2020 Apple Inc. and the FoundationDB project authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FDBSERVER_TAGMESSAGEINDEX_H
+#define FDBSERVER_TAGMESSAGEINDEX_H
+#pragma once
+
+#include <deque>
+#include "fdbserver/LogSystem.h"
+
+// The messages of one tag that a TLog holds in memory, in version order.  The messages themselves are in the log's
+// message blocks; an entry holds a message as an offset from a base pointer and its version as a delta from a base
+// version, which is half the size of a (version, pointer) pair.  A new base is started only when a message's offset or
+// version delta would not fit in 32 bits, which is about once per message block, so bases cost next to nothing.
+//
+// Reads see (version, message) pairs as if this were a std::deque of them.  Like a std::deque's, iterators are
+// invalidated by push_back() and pop_front().
+class TagMessageIndex {
+public:
+	typedef std::pair<Version, LengthPrefixedStringRef> value_type;
+
+	struct Entry {
+		uint32_t versionDelta;
+		uint32_t offset;
+	};
+
+private:
+	struct Base {
+		Version version;
+		const uint8_t* bytes;
+		int64_t firstEntry; // Counted from the first entry ever pushed, so that popping entries does not move it
+	};
+
+	std::deque<Entry> entries;
+	std::deque<Base> bases;
+	int64_t poppedEntries = 0;
+
+	// The index in bases of the base of entries[i], searching forward from base b
+	size_t baseOf(size_t i, size_t b = 0) const {
+		int64_t n = poppedEntries + i;
+		while (b + 1 < bases.size() && bases[b + 1].firstEntry <= n) {
+			++b;
+		}
+		return b;
+	}
+
+	value_type decode(size_t i, size_t b) const {
+		Entry const& e = entries[i];
+		Base const& base = bases[b];
+		return value_type(base.version + e.versionDelta, LengthPrefixedStringRef((uint32_t*)(base.bytes + e.offset)));
+	}
+
+	Version versionAt(size_t i) const {
+		// There are few bases, so a linear search of them is cheap next to the binary search of entries
+		return bases[baseOf(i)].version + entries[i].versionDelta;
+	}
+
+public:
+	class iterator {
+	public:
+		iterator() : index(nullptr), i(0), b(0) {}
+
+		value_type const& operator*() const { return current; }
+		value_type const* operator->() const { return &current; }
+
+		iterator& operator++() {
+			++i;
+			load();
+			return *this;
+		}
+
+		bool operator==(iterator const& r) const { return i == r.i; }
+		bool operator!=(iterator const& r) const { return i != r.i; }
+
+	private:
+		friend class TagMessageIndex;
+
+		TagMessageIndex const* index;
+		size_t i;
+		size_t b;
+		value_type current;
+
+		iterator(TagMessageIndex const* index, size_t i) : index(index), i(i), b(0) { load(); }
+
+		void load() {
+			if (i < index->entries.size()) {
+				b = index->baseOf(i, b);
+				current = index->decode(i, b);
+			}
+		}
+	};
+
+	bool empty() const { return entries.empty(); }
+	size_t size() const { return entries.size(); }
+
+	value_type front() const { return decode(0, 0); }
+	value_type back() const { return decode(entries.size() - 1, bases.size() - 1); }
+
+	iterator begin() const { return iterator(this, 0); }
+	iterator end() const { return iterator(this, entries.size()); }
+
+	// The first message with a version >= version, or > version
+	iterator lowerBound(Version version) const {
+		return iterator(this, partitionPoint([&](size_t i) { return versionAt(i) < version; }));
+	}
+	iterator upperBound(Version version) const {
+		return iterator(this, partitionPoint([&](size_t i) { return versionAt(i) <= version; }));
+	}
+
+	// version must not be less than that of the last message pushed
+	void push_back(Version version, LengthPrefixedStringRef message) {
+		const uint8_t* bytes = (const uint8_t*)message.getLengthPtr();
+		if (bases.empty() || bytes < bases.back().bytes ||
+		    uintptr_t(bytes - bases.back().bytes) > std::numeric_limits<uint32_t>::max() ||
+		    version - bases.back().version > std::numeric_limits<uint32_t>::max()) {
+			bases.push_back(Base{ version, bytes, poppedEntries + (int64_t)entries.size() });
+		}
+		Base const& base = bases.back();
+		entries.push_back(Entry{ uint32_t(version - base.version), uint32_t(bytes - base.bytes) });
+	}
+
+	void pop_front() {
+		entries.pop_front();
+		++poppedEntries;
+		if (entries.empty()) {
+			bases.clear();
+		} else if (bases.size() > 1 && bases[1].firstEntry <= poppedEntries) {
+			bases.pop_front();
+		}
+	}
+
+private:
+	// The first index in entries for which before(index) is false, where before is true for a prefix of entries
+	template <class F>
+	size_t partitionPoint(F const& before) const {
+		size_t lo = 0, hi = entries.size();
+		while (lo < hi) {
+			size_t mid = lo + (hi - lo) / 2;
+			if (before(mid)) {
+				lo = mid + 1;
+			} else {
+				hi = mid;
+			}
+		}
+		return lo;
+	}
+};
+
+#endif
@@ -25,6 +25,7 @@
 #include "fdbrpc/fdbrpc.h"
 #include "fdbrpc/IAsyncFile.h"
 #include "fdbserver/CoroFlow.h"
+#include "fdbserver/Knobs.h"
 #include "fdbrpc/simulator.h"
 #include "fdbrpc/AsyncFileReadAhead.actor.h"
 
@@ -80,6 +81,8 @@ struct VFSAsyncFile {
 
 	int chunkSize;
 
+	std::vector<Future<int>> prefetches; // Reads started by asyncPrefetch only to fill the page cache
+
 	VFSAsyncFile(std::string const& filename, int flags) : filename(filename), flags(flags), pLockCount(&filename_lockCount_openCount[filename].first), debug_zcrefs(0), debug_zcreads(0), debug_reads(0), chunkSize(0) {
 		filename_lockCount_openCount[filename].second++;
 	}
@@ -117,6 +120,26 @@ static int asyncRead(sqlite3_file *pFile, void *zBuf, int iAmt, sqlite_int64 iOf
 	}
 }
 
+static void asyncPrefetch(sqlite3_file *pFile, sqlite_int64 iOfst, int iAmt) {
+	VFSAsyncFile *p = (VFSAsyncFile*)pFile;
+	// Finished reads are forgotten; an error is seen again by the read that needs the page
+	auto& prefetches = p->prefetches;
+	prefetches.erase(std::remove_if(prefetches.begin(), prefetches.end(), [](const Future<int>& f) { return f.isReady(); }),
+	                 prefetches.end());
+	if (prefetches.size() >= SERVER_KNOBS->SQLITE_PREFETCH_MAX_READS) {
+		return;
+	}
+	try {
+		// The buffer is held until the read is done, even if the file is closed first
+		Arena arena;
+		Future<int> f = p->file->read(new (arena) uint8_t[iAmt], iAmt, iOfst);
+		if (!f.isReady()) {
+			prefetches.push_back(uncancellable(holdWhile(arena, f)));
+		}
+	} catch (Error& ) {
+	}
+}
+
 #if 1
 static int asyncReleaseZeroCopy(sqlite3_file* pFile, void* data, int iAmt, sqlite_int64 iOfst) {
 	VFSAsyncFile *p = (VFSAsyncFile*)pFile;
@@ -513,7 +536,8 @@ static int asyncOpen(
 		asyncShmBarrier,
 		asyncShmUnmap,
 		asyncReadZeroCopy,
-		asyncReleaseZeroCopy
+		asyncReleaseZeroCopy,
+		asyncPrefetch
 	};
 
 	VFSAsyncFile *p = (VFSAsyncFile*)pFile; /* Populate this structure */
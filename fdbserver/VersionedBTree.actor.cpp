@@ -28,7 +28,11 @@
 #include "fdbserver/IPager.h"
 #include "fdbrpc/IAsyncFile.h"
 #include "flow/crc32c.h"
+#include "flow/Hash3.h"
 #include "flow/ActorCollection.h"
+#include "flow/IThreadPool.h"
+#include <atomic>
+#include <thread>
 #include <map>
 #include <vector>
 #include "fdbclient/CommitTransaction.h"
@@ -38,6 +42,9 @@
 #include "flow/actorcompiler.h"
 #include <cinttypes>
 #include <boost/intrusive/list.hpp>
+#ifdef HAVE_ZLIB
+#include <zlib.h>
+#endif
 
 #define REDWOOD_DEBUG 0
 
@@ -716,12 +723,12 @@ class FastAllocatedPage : public IPage, public FastAllocated<FastAllocatedPage>,
 public:
 	// Create a fast-allocated page with size total bytes INCLUDING checksum
 	FastAllocatedPage(int size, int bufferSize) : logicalSize(size), bufferSize(bufferSize) {
-		buffer = (uint8_t*)allocateFast(bufferSize);
+		buffer = allocateBuffer(bufferSize);
 		// Mark any unused page portion defined
 		VALGRIND_MAKE_MEM_DEFINED(buffer + logicalSize, bufferSize - logicalSize);
 	};
 
-	virtual ~FastAllocatedPage() { freeFast(bufferSize, buffer); }
+	virtual ~FastAllocatedPage() { freeBuffer(bufferSize, buffer); }
 
 	virtual Reference<IPage> clone() const {
 		FastAllocatedPage* p = new FastAllocatedPage(logicalSize, bufferSize);
@@ -751,6 +758,23 @@ public:
 	bool verifyChecksum(LogicalPageID pageID) { return getChecksum() == calculateChecksum(pageID); }
 
 private:
+	// The pager reads and writes page buffers directly with unbuffered I/O, so every buffer must be aligned to the
+	// physical block size.  FastAllocator blocks of 4k and up are, but allocateFast() falls back to new[] above 16k.
+	static uint8_t* allocateBuffer(int size) {
+		if (size <= 16384) {
+			return (uint8_t*)allocateFast(size);
+		}
+		return (uint8_t*)aligned_alloc(4096, size);
+	}
+
+	static void freeBuffer(int size, uint8_t* buffer) {
+		if (size <= 16384) {
+			freeFast(size, buffer);
+		} else {
+			aligned_free(buffer);
+		}
+	}
+
 	int logicalSize;
 	int bufferSize;
 	uint8_t* buffer;
@@ -772,8 +796,11 @@ struct RedwoodMetrics {
 	struct Level {
 		unsigned int pageRead;
 		unsigned int pageReadExt;
+		unsigned int pageCacheHit;
+		unsigned int pageCacheMiss;
 		unsigned int pageBuild;
 		unsigned int pageBuildExt;
+		unsigned int pageBuildCompressed;
 		unsigned int pageCommitStart;
 		unsigned int pageModify;
 		unsigned int pageModifyExt;
@@ -801,6 +828,7 @@ struct RedwoodMetrics {
 	unsigned int opCommit;
 	unsigned int opGet;
 	unsigned int opGetRange;
+	unsigned int opGetFilterReject;
 	unsigned int pagerDiskWrite;
 	unsigned int pagerDiskRead;
 	unsigned int pagerRemapFree;
@@ -814,6 +842,10 @@ struct RedwoodMetrics {
 	unsigned int pagerEvictFail;
 	unsigned int btreeLeafPreload;
 	unsigned int btreeLeafPreloadExt;
+	unsigned int outOfLineValueWrite;
+	unsigned int outOfLineValueWritePages;
+	unsigned int outOfLineValueRead;
+	unsigned int outOfLineValueReadPages;
 
 	// Return number of pages read or written, from cache or disk
 	unsigned int pageOps() const {
@@ -836,6 +868,10 @@ struct RedwoodMetrics {
 	void getFields(TraceEvent* e, std::string* s = nullptr, bool skipZeroes = false) {
 		std::pair<const char*, unsigned int> metrics[] = { { "BTreePreload", btreeLeafPreload },
 			                                               { "BTreePreloadExt", btreeLeafPreloadExt },
+			                                               { "OutOfLineValueWrite", outOfLineValueWrite },
+			                                               { "OutOfLineValueWritePages", outOfLineValueWritePages },
+			                                               { "OutOfLineValueRead", outOfLineValueRead },
+			                                               { "OutOfLineValueReadPages", outOfLineValueReadPages },
 			                                               { "", 0 },
 			                                               { "OpSet", opSet },
 			                                               { "OpSetKeyBytes", opSetKeyBytes },
@@ -845,6 +881,7 @@ struct RedwoodMetrics {
 			                                               { "", 0 },
 			                                               { "OpGet", opGet },
 			                                               { "OpGetRange", opGetRange },
+			                                               { "OpGetFilterReject", opGetFilterReject },
 			                                               { "OpCommit", opCommit },
 			                                               { "", 0 },
 			                                               { "PagerDiskWrite", pagerDiskWrite },
@@ -886,11 +923,14 @@ struct RedwoodMetrics {
 			std::pair<const char*, unsigned int> metrics[] = {
 				{ "PageBuild", level.pageBuild },
 				{ "PageBuildExt", level.pageBuildExt },
+				{ "PageBuildCompressed", level.pageBuildCompressed },
 				{ "PageModify", level.pageModify },
 				{ "PageModifyExt", level.pageModifyExt },
 				{ "", 0 },
 				{ "PageRead", level.pageRead },
 				{ "PageReadExt", level.pageReadExt },
+				{ "PageCacheHit", level.pageCacheHit },
+				{ "PageCacheMiss", level.pageCacheMiss },
 				{ "PageCommitStart", level.pageCommitStart },
 				{ "", 0 },
 				{ "LazyClearInt", level.lazyClearRequeue },
@@ -975,25 +1015,33 @@ ACTOR Future<Void> redwoodMetricsLogger() {
 // ObjectType must have the methods
 //   bool evictable() const;            // return true if the entry can be evicted
 //   Future<Void> onEvictable() const;  // ready when entry can be evicted
+//
+// The eviction order is a segmented LRU.  New objects start out in the probationary segment, and only move to the
+// protected segment when they are hit again.  Objects are evicted from the probationary segment first, so a scan of
+// many objects that are each used once only displaces other probationary objects and leaves the protected ones,
+// the working set, in the cache.  When the protected segment outgrows its share of the cache its least recently used
+// object is moved back to the most recently used end of the probationary segment.
 template <class IndexType, class ObjectType>
 class ObjectCache : NonCopyable {
 
 	struct Entry : public boost::intrusive::list_base_hook<> {
-		Entry() : hits(0) {}
+		Entry() : hits(0), isProtected(false) {}
 		IndexType index;
 		ObjectType item;
 		int hits;
+		bool isProtected;
 	};
 
 	typedef std::unordered_map<IndexType, Entry> CacheT;
 	typedef boost::intrusive::list<Entry> EvictionOrderT;
 
 public:
-	ObjectCache(int sizeLimit = 1) : sizeLimit(sizeLimit) {}
+	ObjectCache(int sizeLimit = 1) { setSizeLimit(sizeLimit); }
 
 	void setSizeLimit(int n) {
 		ASSERT(n > 0);
 		sizeLimit = n;
+		protectedLimit = n * SERVER_KNOBS->REDWOOD_PAGE_CACHE_PROTECTED_FRACTION;
 	}
 
 	// Get the object for i if it exists, else return nullptr.
@@ -1010,21 +1058,30 @@ public:
 	}
 
 	// Get the object for i or create a new one.
-	// After a get(), the object for i is the last in evictionOrder.
-	// If noHit is set, do not consider this access to be cache hit if the object is present
+	// After a get(), the object for i is the last in its segment of the eviction order.
+	// If noHit is set, do not consider this access to be cache hit if the object is present, so it is neither moved
+	// nor promoted to the protected segment.  Bulk scans use this to avoid displacing the working set.
 	// If noMiss is set, do not consider this access to be a cache miss if the object is not present
 	ObjectType& get(const IndexType& index, bool noHit = false, bool noMiss = false) {
 		Entry& entry = cache[index];
 
-		// If entry is linked into evictionOrder then move it to the back of the order
+		// If entry is linked into an eviction order then move it to the back of the protected one
 		if (entry.is_linked()) {
 			if (!noHit) {
 				++entry.hits;
 				++g_redwoodMetrics.pagerCacheHit;
 
-				// Move the entry to the back of the eviction order
-				evictionOrder.erase(evictionOrder.iterator_to(entry));
-				evictionOrder.push_back(entry);
+				unlink(entry);
+				entry.isProtected = true;
+				protectedOrder.push_back(entry);
+
+				// Keep the protected segment within its share by demoting its oldest entries
+				while (protectedOrder.size() > protectedLimit) {
+					Entry& toDemote = protectedOrder.front();
+					protectedOrder.pop_front();
+					toDemote.isProtected = false;
+					probationOrder.push_back(toDemote);
+				}
 			}
 		} else {
 			if (!noMiss) {
@@ -1033,12 +1090,17 @@ public:
 			// Finish initializing entry
 			entry.index = index;
 			entry.hits = 0;
-			// Insert the newly created Entry at the back of the eviction order
-			evictionOrder.push_back(entry);
+			entry.isProtected = false;
+			// Insert the newly created Entry at the back of the probationary eviction order
+			probationOrder.push_back(entry);
 
 			// While the cache is too big, evict the oldest entry until the oldest entry can't be evicted.
 			while (cache.size() > sizeLimit) {
-				Entry& toEvict = evictionOrder.front();
+				// The new entry is always probationary, so the protected segment is only evicted from once it is
+				// the only probationary entry left
+				EvictionOrderT& order =
+				    (&probationOrder.front() == &entry && !protectedOrder.empty()) ? protectedOrder : probationOrder;
+				Entry& toEvict = order.front();
 
 				// It's critical that we do not evict the item we just added because it would cause the reference
 				// returned to be invalid.  An eviction could happen with a no-hit access to a cache resident page
@@ -1053,8 +1115,8 @@ public:
 				             toString(index).c_str());
 
 				if (!toEvict.item.evictable()) {
-					evictionOrder.erase(evictionOrder.iterator_to(toEvict));
-					evictionOrder.push_back(toEvict);
+					order.erase(order.iterator_to(toEvict));
+					order.push_back(toEvict);
 					++g_redwoodMetrics.pagerEvictFail;
 					break;
 				} else {
@@ -1063,7 +1125,7 @@ public:
 					}
 					debug_printf("Evicting %s to make room for %s\n", toString(toEvict.index).c_str(),
 					             toString(index).c_str());
-					evictionOrder.pop_front();
+					order.pop_front();
 					cache.erase(toEvict.index);
 				}
 			}
@@ -1083,7 +1145,8 @@ public:
 		// structures so we know for sure that no page will become unevictable
 		// after it is either evictable or onEvictable() is ready.
 		cache.swap(self->cache);
-		evictionOrder.swap(self->evictionOrder);
+		evictionOrder.swap(self->probationOrder);
+		evictionOrder.splice(evictionOrder.end(), self->protectedOrder);
 
 		state typename EvictionOrderT::iterator i = evictionOrder.begin();
 		state typename EvictionOrderT::iterator iEnd = evictionOrder.begin();
@@ -1102,17 +1165,24 @@ public:
 	}
 
 	Future<Void> clear() {
-		ASSERT(evictionOrder.size() == cache.size());
+		ASSERT(count() == cache.size());
 		return clear_impl(this);
 	}
 
-	int count() const { return evictionOrder.size(); }
+	int count() const { return probationOrder.size() + protectedOrder.size(); }
 
 private:
+	void unlink(Entry& entry) {
+		EvictionOrderT& order = entry.isProtected ? protectedOrder : probationOrder;
+		order.erase(order.iterator_to(entry));
+	}
+
 	int64_t sizeLimit;
+	int64_t protectedLimit;
 
 	CacheT cache;
-	EvictionOrderT evictionOrder;
+	EvictionOrderT probationOrder;
+	EvictionOrderT protectedOrder;
 };
 
 ACTOR template <class T>
@@ -1594,8 +1664,9 @@ public:
 		             page->begin());
 
 		int blockSize = header ? smallestPhysicalBlock : self->physicalPageSize;
-		// TODO:  Could a dispatched read try to write to page after it has been destroyed if this actor is cancelled?
-		int readBytes = wait(self->pageFile->read(page->mutate(), blockSize, (int64_t)pageID * blockSize));
+		// The read lands directly in the page buffer, so the page must outlive it even if this actor is cancelled
+		int readBytes = wait(uncancellable(
+		    holdWhile(page, self->pageFile->read(page->mutate(), blockSize, (int64_t)pageID * blockSize))));
 		debug_printf("DWALPager(%s) op=readPhysicalComplete %s ptr=%p bytes=%d\n", self->filename.c_str(),
 		             toString(pageID).c_str(), page->begin(), readBytes);
 
@@ -1818,6 +1889,23 @@ public:
 		return Void();
 	}
 
+	// Starts removeRemapEntry() for a batch of popped entries in order of their original page IDs, so that the copies
+	// they make are written in ascending physical order and adjacent pages are submitted together.  The sort is stable
+	// so entries for the same original page are still processed in queue order.
+	static void removeRemapEntries(DWALPager* self, std::vector<RemappedPage>& batch, Version oldestRetainedVersion,
+	                               ActorCollection& tasks) {
+		std::stable_sort(batch.begin(), batch.end(), [](const RemappedPage& a, const RemappedPage& b) {
+			return a.originalPageID < b.originalPageID;
+		});
+		for (auto& p : batch) {
+			Future<Void> task = removeRemapEntry(self, p, oldestRetainedVersion);
+			if (!task.isReady()) {
+				tasks.add(task);
+			}
+		}
+		batch.clear();
+	}
+
 	ACTOR static Future<Void> remapCleanup(DWALPager* self) {
 		state ActorCollection tasks(true);
 		state Promise<Void> signal;
@@ -1837,6 +1925,7 @@ public:
 		self->remapDestinationsSimOnly.clear();
 
 		state int sinceYield = 0;
+		state std::vector<RemappedPage> batch;
 		loop {
 			state Optional<RemappedPage> p = wait(self->remapQueue.pop(cutoff));
 			debug_printf("DWALPager(%s) remapCleanup popped %s\n", self->filename.c_str(), ::toString(p).c_str());
@@ -1846,9 +1935,9 @@ public:
 				break;
 			}
 
-			Future<Void> task = removeRemapEntry(self, p.get(), oldestRetainedVersion);
-			if(!task.isReady()) {
-				tasks.add(task);
+			batch.push_back(p.get());
+			if (batch.size() >= SERVER_KNOBS->REDWOOD_REMAP_CLEANUP_BATCH_SIZE) {
+				removeRemapEntries(self, batch, oldestRetainedVersion, tasks);
 			}
 
 			// If the stop flag is set and we've reached the minimum stop version according the the allowed lag then stop.
@@ -1862,6 +1951,7 @@ public:
 			}
 		}
 
+		removeRemapEntries(self, batch, oldestRetainedVersion, tasks);
 		debug_printf("DWALPager(%s) remapCleanup stopped (stop=%d)\n", self->filename.c_str(), self->remapCleanupStop);
 		signal.send(Void());
 		wait(tasks.getResult());
@@ -2343,13 +2433,46 @@ struct RedwoodRecordRef {
 	RedwoodRecordRef(KeyRef key = KeyRef(), Version ver = 0, Optional<ValueRef> value = {})
 	  : key(key), version(ver), value(value) {}
 
-	RedwoodRecordRef(Arena& arena, const RedwoodRecordRef& toCopy) : key(arena, toCopy.key), version(toCopy.version) {
+	RedwoodRecordRef(Arena& arena, const RedwoodRecordRef& toCopy)
+	  : key(arena, toCopy.key), version(toCopy.version), valueOutOfLine(toCopy.valueOutOfLine) {
 		if (toCopy.value.present()) {
 			value = ValueRef(arena, toCopy.value.get());
 		}
 	}
 
-	KeyValueRef toKeyValueRef() const { return KeyValueRef(key, value.get()); }
+	KeyValueRef toKeyValueRef() const {
+		ASSERT(!valueOutOfLine);
+		return KeyValueRef(key, value.get());
+	}
+
+	// A leaf record's value that is too large to keep in the page is stored in pages of its own, and the record's
+	// value is then its size followed by the IDs of those pages.
+	inline bool isValueOutOfLine() const { return valueOutOfLine; }
+
+	inline int getOutOfLineValueSize() const {
+		ASSERT(valueOutOfLine);
+		return *(const uint32_t*)value.get().begin();
+	}
+
+	inline BTreePageIDRef getOutOfLinePages() const {
+		ASSERT(valueOutOfLine);
+		return BTreePageIDRef((LogicalPageID*)(value.get().begin() + sizeof(uint32_t)),
+		                      (value.get().size() - sizeof(uint32_t)) / sizeof(LogicalPageID));
+	}
+
+	static Value makeOutOfLineValue(int size, BTreePageIDRef pages) {
+		Value v = makeString(sizeof(uint32_t) + pages.size() * sizeof(LogicalPageID));
+		uint8_t* w = mutateString(v);
+		*(uint32_t*)w = size;
+		memcpy(w + sizeof(uint32_t), pages.begin(), pages.size() * sizeof(LogicalPageID));
+		return v;
+	}
+
+	inline RedwoodRecordRef withOutOfLineValue(ValueRef ref) const {
+		RedwoodRecordRef r(key, version, ref);
+		r.valueOutOfLine = true;
+		return r;
+	}
 
 	// RedwoodRecordRefs are used for both internal and leaf pages of the BTree.
 	// Boundary records in internal pages are made from leaf records.
@@ -2389,6 +2512,25 @@ struct RedwoodRecordRef {
 		return skipLen + commonPrefixLength(key, other.key, skipLen);
 	}
 
+	// The big endian value of the 8 key bytes after skip, zero padded, which orders records with the same first skip
+	// bytes by key.  Used by DeltaTree's search index.
+	uint64_t getSearchPrefix(int skip) const {
+		uint64_t prefix = 0;
+		int end = std::min(key.size(), skip + 8);
+		for (int i = skip; i < end; ++i) {
+			prefix |= (uint64_t)key[i] << (8 * (7 - (i - skip)));
+		}
+		return prefix;
+	}
+
+	// A hash of only the key, so that a point lookup at any version matches every record for its key.  Used by
+	// DeltaTree's filter.
+	uint64_t getFilterHash() const {
+		uint32_t a = 0, b = 0;
+		hashlittle2(key.begin(), key.size(), &a, &b);
+		return ((uint64_t)b << 32) | a;
+	}
+
 	// Compares and orders by key, version, chunk.total, chunk.start, value
 	// This is the same order that delta compression uses for prefix borrowing
 	int compare(const RedwoodRecordRef& rhs, int skip = 0) const {
@@ -2418,6 +2560,7 @@ struct RedwoodRecordRef {
 	KeyRef key;
 	Optional<ValueRef> value;
 	Version version;
+	bool valueOutOfLine = false;
 
 	int expectedSize() const { return key.expectedSize() + value.expectedSize(); }
 	int kvBytes() const { return expectedSize(); }
@@ -2494,6 +2637,8 @@ struct RedwoodRecordRef {
 		//    Value bytes
 		//    Version delta bytes
 		//
+		// The version delta size bits mean nothing without HAS_VERSION, so a record without a version that has them
+		// all set has its value stored out of line.
 
 		enum EFlags {
 			PREFIX_SOURCE_PREV = 0x80,
@@ -2581,10 +2726,20 @@ struct RedwoodRecordRef {
 		bool hasVersion() const { return flags & HAS_VERSION; }
 
 		int getVersionDeltaSizeBytes() const {
+			if (!hasVersion()) {
+				return 0;
+			}
 			int code = (flags & VERSION_DELTA_SIZE) >> 2;
 			return VersionDeltaSizes[code];
 		}
 
+		bool isValueOutOfLine() const { return (flags & (HAS_VERSION | VERSION_DELTA_SIZE)) == VERSION_DELTA_SIZE; }
+
+		void setValueOutOfLine() {
+			ASSERT(!hasVersion());
+			flags |= VERSION_DELTA_SIZE;
+		}
+
 		static int getVersionDeltaSizeBytes(Version d) {
 			if (d == 0) {
 				return 0;
@@ -2683,7 +2838,9 @@ struct RedwoodRecordRef {
 				v = base.version + getVersionDelta(r.rptr);
 			}
 
-			return RedwoodRecordRef(k, v, value);
+			RedwoodRecordRef rec(k, v, value);
+			rec.valueOutOfLine = isValueOutOfLine();
+			return rec;
 		}
 
 		int size() const {
@@ -2715,6 +2872,9 @@ struct RedwoodRecordRef {
 			if (hasVersion()) {
 				flagString += "HasVersion|";
 			}
+			if (isValueOutOfLine()) {
+				flagString += "ValueOutOfLine|";
+			}
 			int lengthFormat = flags & LENGTHS_FORMAT;
 
 			Reader r(data());
@@ -2739,7 +2899,9 @@ struct RedwoodRecordRef {
 				value = getValue();
 			}
 
-			return RedwoodRecordRef(StringRef(), 0, value);
+			RedwoodRecordRef rec(StringRef(), 0, value);
+			rec.valueOutOfLine = isValueOutOfLine();
+			return rec;
 		}
 	};
 #pragma pack(pop)
@@ -2826,6 +2988,10 @@ struct RedwoodRecordRef {
 			wptr += d.setVersionDelta(version - base.version, wptr);
 		}
 
+		if (valueOutOfLine) {
+			d.setValueOutOfLine();
+		}
+
 		return wptr - (uint8_t*)&d;
 	}
 
@@ -2846,7 +3012,9 @@ struct RedwoodRecordRef {
 		std::string r;
 		r += format("'%s'@%" PRId64 " => ", key.printable().c_str(), version);
 		if (value.present()) {
-			if (leaf) {
+			if (leaf && valueOutOfLine) {
+				r += format("<%d bytes in %s>", getOutOfLineValueSize(), ::toString(getOutOfLinePages()).c_str());
+			} else if (leaf) {
 				r += format("'%s'", kvformat(value.get()).c_str());
 			} else {
 				r += format("[%s]", ::toString(getChildPage()).c_str());
@@ -2869,6 +3037,10 @@ struct BTreePage {
 	};
 #pragma pack(pop)
 
+	// A leaf page can be stored compressed, which is marked by this bit of height.  The stored page is this header
+	// followed by the uint32_t size of the page once decompressed, and then everything after the header compressed.
+	static constexpr uint8_t compressedFlag = 0x80;
+
 	int size() const {
 		auto& t = tree();
 		return (uint8_t*)&t - (uint8_t*)this + t.size();
@@ -2876,6 +3048,8 @@ struct BTreePage {
 
 	bool isLeaf() const { return height == 1; }
 
+	bool isCompressed() const { return height & compressedFlag; }
+
 	BinaryTree& tree() { return *(BinaryTree*)(this + 1); }
 
 	const BinaryTree& tree() const { return *(const BinaryTree*)(this + 1); }
@@ -3056,10 +3230,12 @@ public:
 
 #pragma pack(push, 1)
 	struct MetaKey {
-		static constexpr int FORMAT_VERSION = 8;
+		static constexpr int FORMAT_VERSION = 9;
 		// This serves as the format version for the entire tree, individual pages will not be versioned
 		uint16_t formatVersion;
 		uint8_t height;
+		// Set once any leaf has had a value stored out of line, after which leaves cannot be freed without reading them
+		bool hasOutOfLineValues;
 		LazyClearQueueT::QueueState lazyDeleteQueue;
 		InPlaceArray<LogicalPageID> root;
 
@@ -3071,8 +3247,9 @@ public:
 		}
 
 		std::string toString() {
-			return format("{height=%d  formatVersion=%d  root=%s  lazyDeleteQueue=%s}", (int)height, (int)formatVersion,
-			              ::toString(root.get()).c_str(), lazyDeleteQueue.toString().c_str());
+			return format("{height=%d  formatVersion=%d  hasOutOfLineValues=%d  root=%s  lazyDeleteQueue=%s}",
+			              (int)height, (int)formatVersion, (int)hasOutOfLineValues, ::toString(root.get()).c_str(),
+			              lazyDeleteQueue.toString().c_str());
 		}
 	};
 #pragma pack(pop)
@@ -3149,6 +3326,16 @@ public:
 	  : m_pager(pager), m_writeVersion(invalidVersion), m_lastCommittedVersion(invalidVersion), m_pBuffer(nullptr),
 	    m_commitReadLock(new FlowLock(SERVER_KNOBS->REDWOOD_COMMIT_CONCURRENT_READS)), m_name(name) {
 
+		// Page builds only run on threads outside of simulation, which must stay deterministic
+		if (!g_network->isSimulated() && SERVER_KNOBS->REDWOOD_COMMIT_BUILD_THREADS > 0) {
+			// Initialize the split point cache that DeltaTree::build() uses before any thread can race to do it
+			perfectSubtreeSplitPointCached(0);
+			m_buildThreads = createGenericThreadPool();
+			for (int i = 0; i < SERVER_KNOBS->REDWOOD_COMMIT_BUILD_THREADS; ++i) {
+				m_buildThreads->addThread(new PageBuilder());
+			}
+		}
+
 		m_lazyClearActor = 0;
 		m_init = init_impl(this);
 		m_latestCommit = m_init;
@@ -3190,20 +3377,29 @@ public:
 
 				debug_printf("LazyClear: processing %s\n", toString(entry).c_str());
 
-				// Level 1 (leaf) nodes should never be in the lazy delete queue
-				ASSERT(btPage.height > 1);
+				// Leaves are only queued once some leaf has held a value out of line
+				ASSERT(btPage.height > 1 || self->m_header.hasOutOfLineValues);
 
 				// Iterate over page entries, skipping key decoding using BTreePage::ValueTree which uses
 				// RedwoodRecordRef::DeltaValueOnly as the delta type type to skip key decoding
 				BTreePage::ValueTree::Mirror reader(&btPage.valueTree(), &dbBegin, &dbEnd);
 				auto c = reader.getCursor();
-				ASSERT(c.moveFirst());
 				Version v = entry.version;
-				while (1) {
-					if (c.get().value.present()) {
+				bool more = c.moveFirst();
+				ASSERT(more || btPage.height == 1);
+				while (more) {
+					if (btPage.height == 1) {
+						// A leaf is only here to free the pages of its out of line values
+						if (c.get().isValueOutOfLine()) {
+							BTreePageIDRef valuePages = c.get().getOutOfLinePages();
+							self->freeBTreePage(valuePages, v);
+							freedPages += valuePages.size();
+						}
+					} else if (c.get().value.present()) {
 						BTreePageIDRef btChildPageID = c.get().getChildPage();
-						// If this page is height 2, then the children are leaves so free them directly
-						if (btPage.height == 2) {
+						// If this page is height 2, then the children are leaves so free them directly, unless they
+						// may have out of line values to free as well
+						if (btPage.height == 2 && !self->m_header.hasOutOfLineValues) {
 							debug_printf("LazyClear: freeing child %s\n", toString(btChildPageID).c_str());
 							self->freeBTreePage(btChildPageID, v);
 							freedPages += btChildPageID.size();
@@ -3217,9 +3413,7 @@ public:
 							metrics.lazyClearRequeueExt += (btChildPageID.size() - 1);
 						}
 					}
-					if (!c.moveNext()) {
-						break;
-					}
+					more = c.moveNext();
 				}
 
 				// Free the page, now that its children have either been freed or queued
@@ -3263,6 +3457,7 @@ public:
 			debug_printf("new root %s\n", toString(newRoot).c_str());
 			self->m_header.root.set(newRoot, sizeof(headerSpace) - sizeof(m_header));
 			self->m_header.height = 1;
+			self->m_header.hasOutOfLineValues = false;
 			++latest;
 			Reference<IPage> page = self->m_pager->newPageBuffer();
 			makeEmptyRoot(page);
@@ -3306,7 +3501,8 @@ public:
 		KeyRef m = snapshot->getMetaKey();
 
 		// Currently all internal records generated in the write path are at version 0
-		return Reference<IStoreCursor>(new Cursor(snapshot, ((MetaKey*)m.begin())->root.get(), (Version)0));
+		return Reference<IStoreCursor>(
+		    new Cursor(snapshot, ((MetaKey*)m.begin())->root.get(), (Version)0, m_blockSize));
 	}
 
 	// Must be nondecreasing
@@ -3591,6 +3787,7 @@ private:
 	Version m_lastCommittedVersion;
 	Version m_newOldestVersion;
 	Reference<FlowLock> m_commitReadLock;
+	Reference<IThreadPool> m_buildThreads;
 	Future<Void> m_latestCommit;
 	Future<Void> m_init;
 	std::string m_name;
@@ -3608,6 +3805,80 @@ private:
 	Future<int> m_lazyClearActor;
 	bool m_lazyClearStop;
 
+	// Builds the DeltaTree of one page into btPage, which has room for pageSize bytes of tree, and if compressed is
+	// not null compresses the page into it.  Touches nothing but its arguments, so it can run on a build thread.
+	static void buildPage(BTreePage* btPage, int pageSize, int capacity, const RedwoodRecordRef* begin,
+	                      const RedwoodRecordRef* end, const RedwoodRecordRef* lowerBound,
+	                      const RedwoodRecordRef* upperBound, uint8_t* compressed, int compressedCapacity,
+	                      int& written, int& compressedSize) {
+		written = btPage->tree().build(pageSize, begin, end, lowerBound, upperBound);
+		compressedSize = 0;
+		if (compressed != nullptr && written <= pageSize) {
+			compressedSize = compressPage(btPage, capacity, compressed, compressedCapacity);
+		}
+	}
+
+	// A page build handed to m_buildThreads.  The records it reads belong to the writePages() actor that posted it,
+	// so if that actor is cancelled it must either stop the job before it starts or wait for it to finish.
+	struct PageBuildJob : ThreadSafeReferenceCounted<PageBuildJob> {
+		enum Phase { Queued, Running, Done, Abandoned };
+
+		BTreePage* btPage;
+		int pageSize;
+		int capacity;
+		const RedwoodRecordRef* begin;
+		const RedwoodRecordRef* end;
+		const RedwoodRecordRef* lowerBound;
+		const RedwoodRecordRef* upperBound;
+		uint8_t* compressed;
+		int compressedCapacity;
+		int written = 0;
+		int compressedSize = 0;
+		std::atomic<int> phase{ Queued };
+		ThreadReturnPromise<Void> done;
+
+		void waitUntilSafe() {
+			int expected = Queued;
+			if (phase.compare_exchange_strong(expected, Abandoned)) {
+				return;
+			}
+			while (phase.load() != Done) {
+				std::this_thread::yield();
+			}
+		}
+	};
+
+	struct PageBuilder final : IThreadPoolReceiver {
+		void init() override {}
+
+		struct Build final : TypedAction<PageBuilder, Build> {
+			explicit Build(Reference<PageBuildJob> job) : job(job) {}
+			double getTimeEstimate() const override { return 0.001; }
+			Reference<PageBuildJob> job;
+		};
+
+		void action(Build& b) {
+			PageBuildJob& job = *b.job;
+			int expected = PageBuildJob::Queued;
+			if (!job.phase.compare_exchange_strong(expected, PageBuildJob::Running)) {
+				job.done.send(Void());
+				return;
+			}
+			try {
+				buildPage(job.btPage, job.pageSize, job.capacity, job.begin, job.end, job.lowerBound, job.upperBound,
+				          job.compressed, job.compressedCapacity, job.written, job.compressedSize);
+				job.phase.store(PageBuildJob::Done);
+				job.done.send(Void());
+			} catch (Error& e) {
+				job.phase.store(PageBuildJob::Done);
+				job.done.sendError(e);
+			} catch (...) {
+				job.phase.store(PageBuildJob::Done);
+				job.done.sendError(unknown_error());
+			}
+		}
+	};
+
 	// Writes entries to 1 or more pages and return a vector of boundary keys with their IPage(s)
 	ACTOR static Future<Standalone<VectorRef<RedwoodRecordRef>>> writePages(
 	    VersionedBTree* self, const RedwoodRecordRef* lowerBound, const RedwoodRecordRef* upperBound,
@@ -3615,15 +3886,19 @@ private:
 		ASSERT(entries.size() > 0);
 		state Standalone<VectorRef<RedwoodRecordRef>> records;
 
+		// Compressed leaves are built as if they had this many blocks, and then stored in as few as they compress to
+		state bool compressLeaf = height == 1 && pageCompressionBlocks() > 1;
+		state int blockCount = compressLeaf ? pageCompressionBlocks() : 1;
+		state int baseBlockCount = blockCount;
+
 		// This is how much space for the binary tree exists in the page, after the header
 		state int blockSize = self->m_blockSize;
-		state int pageSize = blockSize - sizeof(BTreePage);
+		state int pageSize = blockSize * blockCount - sizeof(BTreePage);
 		state int pageFillTarget = pageSize * SERVER_KNOBS->REDWOOD_PAGE_REBUILD_FILL_FACTOR;
-		state int blockCount = 1;
 
 		state int kvBytes = 0;
 		state int compressedBytes = BTreePage::BinaryTree::emptyTreeSize();
-		state bool largeTree = false;
+		state bool largeTree = pageSize > BTreePage::BinaryTree::SmallSizeLimit;
 
 		state int start = 0;
 		state int i = 0;
@@ -3637,6 +3912,9 @@ private:
 		state RedwoodRecordRef pageLowerBound = lowerBound->withoutValue();
 		state RedwoodRecordRef pageUpperBound;
 
+		// Size of each node added to the page being built, so that its last few records can be taken back out
+		state std::vector<int> nodeSizes;
+
 		while (1) {
 			// While there are still entries to add and the page isn't full enough, add an entry
 			while (i < entries.size() && (i - start < minimumEntries || compressedBytes < pageFillTarget)) {
@@ -3693,9 +3971,42 @@ private:
 
 				kvBytes += entry.kvBytes();
 				compressedBytes += nodeSize;
+				nodeSizes.push_back(nodeSize);
 				++i;
 			}
 
+			// The boundary between this page and the next is stored in the parent, so a shorter one means more fanout
+			// there.  Leaf boundaries are truncated below to the prefix that separates the pages, and an internal
+			// page boundary is the lower bound its first child page was built against so it is used as is.  Rather
+			// than splitting exactly where the page filled, split before whichever of the last few records gives the
+			// shortest boundary.  Once the page has grown past its blocks the node sizes no longer add up, so leave it.
+			if (i < entries.size() && blockCount == baseBlockCount) {
+				auto boundaryLen = [&](int j) {
+					return height == 1 ? entries[j].getCommonPrefixLen(entries[j - 1], 0) + 1 : entries[j].key.size();
+				};
+				int minBytes = compressedBytes - pageSize * SERVER_KNOBS->REDWOOD_SPLIT_BOUNDARY_SEARCH_FRACTION;
+				int bytes = compressedBytes;
+				int best = i;
+				int bestLen = boundaryLen(i);
+				for (int j = i - 1; j - start >= minimumEntries; --j) {
+					bytes -= nodeSizes[j - start];
+					if (bytes < minBytes) {
+						break;
+					}
+					int len = boundaryLen(j);
+					if (len < bestLen) {
+						best = j;
+						bestLen = len;
+					}
+				}
+				while (i > best) {
+					--i;
+					kvBytes -= entries[i].kvBytes();
+					compressedBytes -= nodeSizes[i - start];
+					nodeSizes.pop_back();
+				}
+			}
+
 			// Flush the accumulated records to a page
 			state int nextStart = i;
 			// If we are building internal pages and there is a record after this page (index nextStart) but it has an
@@ -3717,9 +4028,8 @@ private:
 			}
 
 			state std::vector<Reference<IPage>> pages;
-			BTreePage* btPage;
-
-			int capacity = blockSize * blockCount;
+			state BTreePage* btPage = nullptr;
+			state int capacity = blockSize * blockCount;
 			if (blockCount == 1) {
 				Reference<IPage> page = self->m_pager->newPageBuffer();
 				btPage = (BTreePage*)page->mutate();
@@ -3737,8 +4047,45 @@ private:
 			    start, i, i - start, compressedBytes, pageSize, (float)compressedBytes / pageSize * 100,
 			    pageLowerBound.toString(false).c_str(), pageUpperBound.toString(false).c_str());
 
-			int written =
-			    btPage->tree().build(pageSize, &entries[start], &entries[i], &pageLowerBound, &pageUpperBound);
+			// Only store the page compressed if that saves at least one block
+			state std::unique_ptr<uint8_t[]> compressed;
+			if (blockCount != 1 && compressLeaf) {
+				compressed.reset(new uint8_t[capacity - blockSize]);
+			}
+
+			state int written;
+			state int compressedSize;
+			if (self->m_buildThreads) {
+				state Reference<PageBuildJob> job(new PageBuildJob());
+				job->btPage = btPage;
+				job->pageSize = pageSize;
+				job->capacity = capacity;
+				job->begin = &entries[start];
+				job->end = &entries[i];
+				job->lowerBound = &pageLowerBound;
+				job->upperBound = &pageUpperBound;
+				job->compressed = compressed.get();
+				job->compressedCapacity = capacity - blockSize;
+				state Future<Void> built = job->done.getFuture();
+				self->m_buildThreads->post(new PageBuilder::Build(job));
+				try {
+					wait(built);
+				} catch (Error& e) {
+					if (e.code() == error_code_actor_cancelled) {
+						job->waitUntilSafe();
+						if (blockCount != 1) {
+							delete[](uint8_t*) btPage;
+						}
+					}
+					throw;
+				}
+				written = job->written;
+				compressedSize = job->compressedSize;
+			} else {
+				buildPage(btPage, pageSize, capacity, &entries[start], &entries[i], &pageLowerBound, &pageUpperBound,
+				          compressed.get(), capacity - blockSize, written, compressedSize);
+			}
+
 			if (written > pageSize) {
 				debug_printf("ERROR:  Wrote %d bytes to %d byte page (%d blocks). recs %d  kvBytes %d  compressed %d\n",
 				             written, pageSize, blockCount, i - start, kvBytes, compressedBytes);
@@ -3750,25 +4097,36 @@ private:
 
 			auto& metrics = g_redwoodMetrics.level(btPage->height);
 			metrics.pageBuild += 1;
-			metrics.pageBuildExt += blockCount - 1;
 			metrics.buildFillPct += (double)written / capacity;
 			metrics.buildStoredPct += (double)btPage->kvBytes / capacity;
 			metrics.buildItemCount += btPage->tree().numItems;
 
 			// Create chunked pages
 			// TODO: Avoid copying page bytes, but this is not trivial due to how pager checksums are currently handled.
+			int storedSize = capacity;
 			if (blockCount != 1) {
 				// Mark the slack in the page buffer as defined
 				VALGRIND_MAKE_MEM_DEFINED(((uint8_t*)btPage) + written, (blockCount * blockSize) - written);
 				const uint8_t* rptr = (const uint8_t*)btPage;
-				for (int b = 0; b < blockCount; ++b) {
+
+				if (compressedSize > 0) {
+					rptr = compressed.get();
+					storedSize = compressedSize;
+					metrics.pageBuildCompressed += 1;
+				}
+
+				for (int b = 0; b * blockSize < storedSize; ++b) {
 					Reference<IPage> page = self->m_pager->newPageBuffer();
-					memcpy(page->mutate(), rptr, blockSize);
+					int n = std::min(blockSize, storedSize - b * blockSize);
+					memcpy(page->mutate(), rptr, n);
+					memset(page->mutate() + n, 0, blockSize - n);
 					rptr += blockSize;
 					pages.push_back(std::move(page));
 				}
 				delete[](uint8_t*) btPage;
+				compressed.reset();
 			}
+			metrics.pageBuildExt += (storedSize - 1) / blockSize;
 
 			// Write this btree page, which is made of 1 or more pager pages.
 			state int p;
@@ -3825,6 +4183,7 @@ private:
 			start = nextStart;
 			kvBytes = 0;
 			compressedBytes = BTreePage::BinaryTree::emptyTreeSize();
+			nodeSizes.clear();
 			pageLowerBound = pageUpperBound;
 		}
 
@@ -3873,6 +4232,9 @@ private:
 			}
 		}
 
+		// An uninitialized page of size bytes, for the caller to fill in
+		explicit SuperPage(int size) : m_data(new uint8_t[size]), m_size(size) {}
+
 		virtual ~SuperPage() { delete[] m_data; }
 
 		Reference<IPage> clone() const override {
@@ -3894,10 +4256,69 @@ private:
 		int m_size;
 	};
 
+	static int pageCompressionBlocks() {
+#ifdef HAVE_ZLIB
+		return SERVER_KNOBS->REDWOOD_PAGE_COMPRESSION_BLOCKS;
+#else
+		return 0;
+#endif
+	}
+
+	// Writes the first rawSize bytes of btPage to dst in compressed form.  Returns the stored size, or 0 if it is not
+	// less than capacity.
+	static int compressPage(const BTreePage* btPage, int rawSize, uint8_t* dst, int capacity) {
+#ifdef HAVE_ZLIB
+		const int headerSize = sizeof(BTreePage) + sizeof(uint32_t);
+		if (capacity <= headerSize) {
+			return 0;
+		}
+		uLongf len = capacity - headerSize;
+		if (compress2(dst + headerSize, &len, (const Bytef*)(btPage + 1), btPage->size() - sizeof(BTreePage),
+		              SERVER_KNOBS->REDWOOD_PAGE_COMPRESSION_LEVEL) != Z_OK) {
+			return 0;
+		}
+		memcpy(dst, btPage, sizeof(BTreePage));
+		((BTreePage*)dst)->height |= BTreePage::compressedFlag;
+		uint32_t size = rawSize;
+		memcpy(dst + sizeof(BTreePage), &size, sizeof(size));
+		return headerSize + len;
+#else
+		return 0;
+#endif
+	}
+
+	// A compressed page is decompressed once and the result is kept with the stored page, so that it stays around for
+	// as long as the pager caches that.
+	static Reference<const IPage> getDecompressedPage(Reference<const IPage> stored) {
+		if (stored->userData == nullptr) {
+			const BTreePage* storedBTPage = (const BTreePage*)stored->begin();
+			uint32_t size;
+			memcpy(&size, storedBTPage + 1, sizeof(size));
+			const uint8_t* compressed = (const uint8_t*)(storedBTPage + 1) + sizeof(size);
+
+			Reference<SuperPage> page(new SuperPage(size));
+			BTreePage* btPage = (BTreePage*)page->mutate();
+			memcpy(btPage, storedBTPage, sizeof(BTreePage));
+			btPage->height &= ~BTreePage::compressedFlag;
+#ifdef HAVE_ZLIB
+			uLongf len = size - sizeof(BTreePage);
+			if (uncompress((Bytef*)(btPage + 1), &len, compressed, stored->begin() + stored->size() - compressed) != Z_OK) {
+				throw checksum_failed();
+			}
+#else
+			TraceEvent(SevError, "RedwoodCompressedPageUnsupported").detail("Size", size);
+			throw checksum_failed();
+#endif
+			stored->userData = new Reference<const IPage>(page);
+			stored->userDataDestructor = [](void* ptr) { delete (Reference<const IPage>*)ptr; };
+		}
+		return *(Reference<const IPage>*)stored->userData;
+	}
+
 	ACTOR static Future<Reference<const IPage>> readPage(Reference<IPagerSnapshot> snapshot, BTreePageIDRef id,
 	                                                     const RedwoodRecordRef* lowerBound,
 	                                                     const RedwoodRecordRef* upperBound,
-	                                                     bool forLazyClear = false) {
+	                                                     bool forLazyClear = false, bool noHit = false) {
 		if (!forLazyClear) {
 			debug_printf("readPage() op=read %s @%" PRId64 " lower=%s upper=%s\n", toString(id).c_str(),
 			             snapshot->getVersion(), lowerBound->toString(false).c_str(),
@@ -3910,32 +4331,51 @@ private:
 		wait(yield());
 
 		state Reference<const IPage> page;
+		// A page that is ready right away was already cached
+		state bool cached;
 
 		if (id.size() == 1) {
-			Reference<const IPage> p = wait(snapshot->getPhysicalPage(id.front(), !forLazyClear, false));
+			Future<Reference<const IPage>> read = snapshot->getPhysicalPage(id.front(), !forLazyClear, noHit);
+			cached = read.isReady();
+			Reference<const IPage> p = wait(read);
 			page = p;
 		} else {
 			ASSERT(!id.empty());
 			std::vector<Future<Reference<const IPage>>> reads;
+			cached = true;
 			for (auto& pageID : id) {
-				reads.push_back(snapshot->getPhysicalPage(pageID, !forLazyClear, false));
+				reads.push_back(snapshot->getPhysicalPage(pageID, !forLazyClear, noHit));
+				cached = cached && reads.back().isReady();
 			}
 			std::vector<Reference<const IPage>> pages = wait(getAll(reads));
 			// TODO:  Cache reconstituted super pages somehow, perhaps with help from the Pager.
 			page = Reference<const IPage>(new SuperPage(pages));
 		}
 
+		if (((const BTreePage*)page->begin())->isCompressed()) {
+			page = getDecompressedPage(page);
+		}
+
 		debug_printf("readPage() op=readComplete %s @%" PRId64 " \n", toString(id).c_str(), snapshot->getVersion());
 		const BTreePage* pTreePage = (const BTreePage*)page->begin();
 		auto& metrics = g_redwoodMetrics.level(pTreePage->height);
 		metrics.pageRead += 1;
 		metrics.pageReadExt += (id.size() - 1);
+		if (!forLazyClear) {
+			cached ? ++metrics.pageCacheHit : ++metrics.pageCacheMiss;
+		}
 
 		if (!forLazyClear && page->userData == nullptr) {
 			debug_printf("readPage() Creating Reader for %s @%" PRId64 " lower=%s upper=%s\n", toString(id).c_str(),
 			             snapshot->getVersion(), lowerBound->toString(false).c_str(),
 			             upperBound->toString(false).c_str());
-			page->userData = new BTreePage::BinaryTree::Mirror(&pTreePage->tree(), lowerBound, upperBound);
+			auto mirror = new BTreePage::BinaryTree::Mirror(&pTreePage->tree(), lowerBound, upperBound);
+			mirror->enableSearchIndex(SERVER_KNOBS->REDWOOD_SEARCH_INDEX_SEEKS);
+			if (pTreePage->isLeaf()) {
+				mirror->enableFilter(SERVER_KNOBS->REDWOOD_LEAF_FILTER_LOOKUPS,
+				                     SERVER_KNOBS->REDWOOD_LEAF_FILTER_BITS_PER_KEY);
+			}
+			page->userData = mirror;
 			page->userDataDestructor = [](void* ptr) { delete (BTreePage::BinaryTree::Mirror*)ptr; };
 		}
 
@@ -3956,6 +4396,50 @@ private:
 		}
 	}
 
+	// Writes a value to pages of its own, in page sized pieces, and returns what its record holds in its place
+	ACTOR static Future<Value> writeOutOfLineValue(VersionedBTree* self, ValueRef value) {
+		state Standalone<BTreePageIDRef> pageIDs;
+		state int offset = 0;
+		while (offset < value.size()) {
+			Reference<IPage> page = self->m_pager->newPageBuffer();
+			int n = std::min(self->m_blockSize, value.size() - offset);
+			memcpy(page->mutate(), value.begin() + offset, n);
+			memset(page->mutate() + n, 0, self->m_blockSize - n);
+			LogicalPageID id = wait(self->m_pager->newPageID());
+			self->m_pager->updatePage(id, page);
+			pageIDs.push_back(pageIDs.arena(), id);
+			offset += n;
+		}
+		self->m_header.hasOutOfLineValues = true;
+		++g_redwoodMetrics.outOfLineValueWrite;
+		g_redwoodMetrics.outOfLineValueWritePages += pageIDs.size();
+		return RedwoodRecordRef::makeOutOfLineValue(value.size(), pageIDs);
+	}
+
+	// Reads up to maxLength bytes of the value of rec, which is stored out of line in pages of blockSize bytes.  Only
+	// the pages holding those bytes are read.
+	ACTOR static Future<Value> readOutOfLineValue(Reference<IPagerSnapshot> snapshot, RedwoodRecordRef rec,
+	                                              int blockSize, int maxLength, bool noHit) {
+		state int size = std::min(rec.getOutOfLineValueSize(), maxLength);
+		state std::vector<Future<Reference<const IPage>>> reads;
+		BTreePageIDRef pageIDs = rec.getOutOfLinePages();
+		for (int i = 0; i < pageIDs.size() && i * blockSize < size; ++i) {
+			reads.push_back(snapshot->getPhysicalPage(pageIDs[i], true, noHit));
+		}
+		std::vector<Reference<const IPage>> pages = wait(getAll(reads));
+
+		++g_redwoodMetrics.outOfLineValueRead;
+		g_redwoodMetrics.outOfLineValueReadPages += pages.size();
+		Value value = makeString(size);
+		uint8_t* w = mutateString(value);
+		for (int offset = 0, i = 0; offset < size; ++i) {
+			int n = std::min(pages[i]->size(), size - offset);
+			memcpy(w + offset, pages[i]->begin(), n);
+			offset += n;
+		}
+		return value;
+	}
+
 	void freeBTreePage(BTreePageIDRef btPageID, Version v) {
 		// Free individual pages at v
 		for (LogicalPageID id : btPageID) {
@@ -4312,7 +4796,9 @@ private:
 		// TODO:  Decide if it is okay to update if the subtree boundaries are expanded.  It can result in
 		// records in a DeltaTree being outside its decode boundary range, which isn't actually invalid
 		// though it is awkward to reason about.
-		state bool tryToUpdate = btPage->tree().numItems > 0 && update->boundariesNormal();
+		// A page that was stored compressed is larger than the blocks it is stored in, so it must be rebuilt
+		state bool tryToUpdate = btPage->tree().numItems > 0 && update->boundariesNormal() &&
+		                         page->size() == rootID.size() * self->m_blockSize;
 
 		// If trying to update the page, we need to clone it so we don't modify the original.
 		// TODO: Refactor DeltaTree::Mirror so it can be shared between different versions of pages
@@ -4344,12 +4830,38 @@ private:
 
 		// Leaf Page
 		if (isLeaf) {
+			// Values too large to keep in the leaf are written to pages of their own before the merge, which does not
+			// wait.  These are the records for them, in key order.
+			state Standalone<VectorRef<RedwoodRecordRef>> outOfLine;
+			state int nextOutOfLine = 0;
+			if (SERVER_KNOBS->REDWOOD_OUT_OF_LINE_VALUE_SIZE > 0) {
+				state MutationBuffer::const_iterator m = mBegin;
+				for (; m != mEnd; ++m) {
+					// The same test as applyBoundaryChange below
+					if (m.mutation().boundaryChanged && (m != mBegin || m.key() == update->subtreeLowerBound->key) &&
+					    m.mutation().boundarySet() &&
+					    m.mutation().boundaryValue.get().size() >= SERVER_KNOBS->REDWOOD_OUT_OF_LINE_VALUE_SIZE) {
+						Value ref = wait(writeOutOfLineValue(self, m.mutation().boundaryValue.get()));
+						outOfLine.push_back_deep(outOfLine.arena(),
+						                         RedwoodRecordRef(m.key()).withOutOfLineValue(ref));
+					}
+				}
+			}
+
 			bool updating = tryToUpdate;
 			bool changesMade = false;
 
 			// Couldn't make changes in place, so now do a linear merge and build new pages.
 			state Standalone<VectorRef<RedwoodRecordRef>> merged;
 
+			// A record's out of line value goes with it when it is removed from the page
+			auto freeValue = [&](const RedwoodRecordRef& rec) {
+				if (rec.isValueOutOfLine()) {
+					debug_printf("%s Freeing out of line value of %s\n", context.c_str(), rec.toString().c_str());
+					self->freeBTreePage(rec.getOutOfLinePages(), writeVersion);
+				}
+			};
+
 			auto switchToLinearMerge = [&]() {
 				updating = false;
 				auto c = cursor;
@@ -4394,6 +4906,7 @@ private:
 						cursor.moveNext();
 					} else {
 						changesMade = true;
+						freeValue(cursor.get());
 						// If updating, erase from the page, otherwise do not add to the output set
 						if (updating) {
 							debug_printf("%s Erasing %s [existing, boundary start]\n", context.c_str(),
@@ -4415,6 +4928,9 @@ private:
 				// excluded from the merge output
 				if (applyBoundaryChange && mBegin.mutation().boundarySet()) {
 					RedwoodRecordRef rec(mBegin.key(), 0, mBegin.mutation().boundaryValue.get());
+					if (nextOutOfLine < outOfLine.size() && outOfLine[nextOutOfLine].key == mBegin.key()) {
+						rec = outOfLine[nextOutOfLine++];
+					}
 					changesMade = true;
 
 					// If updating, add to the page, else add to the output set
@@ -4459,9 +4975,17 @@ private:
 						changesMade = true;
 					}
 
-					debug_printf("%s Seeking forward to next boundary (remove=%d updating=%d) %s\n", context.c_str(),
-					             remove, updating, mBegin.key().toString().c_str());
-					cursor.seekGreaterThanOrEqual(end, update->skipLen);
+					// Records being removed are visited only if they may have out of line values to free
+					if (!updating && self->m_header.hasOutOfLineValues) {
+						while (cursor.valid() && cursor.get().compare(end, update->skipLen) < 0) {
+							freeValue(cursor.get());
+							cursor.moveNext();
+						}
+					} else {
+						debug_printf("%s Seeking forward to next boundary (remove=%d updating=%d) %s\n",
+						             context.c_str(), remove, updating, mBegin.key().toString().c_str());
+						cursor.seekGreaterThanOrEqual(end, update->skipLen);
+					}
 				} else {
 					// Otherwise we must visit the records.  If updating, the visit is to erase them, and if doing a
 					// linear merge than the visit is to add them to the output set.
@@ -4469,6 +4993,7 @@ private:
 						if (updating) {
 							debug_printf("%s Erasing %s [existing, boundary start]\n", context.c_str(),
 							             cursor.get().toString().c_str());
+							freeValue(cursor.get());
 							btPage->kvBytes -= cursor.get().kvBytes();
 							cursor.erase();
 							changesMade = true;
@@ -4495,6 +5020,12 @@ private:
 				if (remove != updating) {
 					debug_printf("%s Ignoring remaining records, remove=%d updating=%d\n", context.c_str(), remove,
 					             updating);
+					if (remove && self->m_header.hasOutOfLineValues) {
+						while (cursor.valid()) {
+							freeValue(cursor.get());
+							cursor.moveNext();
+						}
+					}
 				} else {
 					// If updating and the key is changing, we must visit the records to erase them.
 					// If not updating and the key is not changing, we must visit the records to add them to the output
@@ -4504,6 +5035,7 @@ private:
 							debug_printf(
 							    "%s Erasing %s and beyond [existing, matches changed upper mutation boundary]\n",
 							    context.c_str(), cursor.get().toString().c_str());
+							freeValue(cursor.get());
 							btPage->kvBytes -= cursor.get().kvBytes();
 							cursor.erase();
 						} else {
@@ -4706,7 +5238,7 @@ private:
 							while (c != u.cEnd) {
 								const RedwoodRecordRef& rec = c.get();
 								if (rec.value.present()) {
-									if (btPage->height == 2) {
+									if (btPage->height == 2 && !self->m_header.hasOutOfLineValues) {
 										debug_printf("%s: freeing child page in cleared subtree range: %s\n",
 										             context.c_str(), ::toString(rec.getChildPage()).c_str());
 										self->freeBTreePage(rec.getChildPage(), writeVersion);
@@ -5050,6 +5582,8 @@ public:
 
 		InternalCursor(Reference<IPagerSnapshot> pager, BTreePageIDRef root) : pager(pager), rootPageID(root) {}
 
+		Reference<IPagerSnapshot> getPager() const { return pager; }
+
 		std::string toString() const {
 			std::string r;
 
@@ -5251,6 +5785,9 @@ public:
 		std::unordered_map<LogicalPageID, Reference<const IPage>> pages;
 		VersionedBTree* btree;
 		bool valid;
+		bool noHit;
+		bool filterRejected;
+		int readAheadLeaves;
 
 		struct PathEntry {
 			BTreePage* btPage;
@@ -5259,10 +5796,22 @@ public:
 		VectorRef<PathEntry> path;
 
 	public:
-		BTreeCursor() {}
+		BTreeCursor() : noHit(false), filterRejected(false), readAheadLeaves(0) {}
+
+		// Page reads from here on are not cache hits, so that the pages do not displace other pages from the cache
+		// that are more likely to be used again.  For cursors that scan far more pages than they will revisit.
+		void setNoHit(bool noHit) { this->noHit = noHit; }
+
+		// Each time a move reaches another leaf, start reading the next n leaves after it in the direction of the
+		// move that share its parent, so that a sequential scan of uncached pages waits on one read at a time
+		// instead of one read per leaf.
+		void setReadAhead(int n) { readAheadLeaves = n; }
 
 		bool isValid() const { return valid; }
 
+		// True if the last seek was a point lookup that a leaf's filter answered without seeking into the leaf
+		bool rejectedByFilter() const { return filterRejected; }
+
 		std::string toString() const {
 			std::string r = format("{ptr=%p %s ", this, ::toString(pager->getVersion()).c_str());
 			for (int i = 0; i < path.size(); ++i) {
@@ -5279,6 +5828,20 @@ public:
 
 		const RedwoodRecordRef& get() { return path.back().cursor.get(); }
 
+		// Reads up to maxLength bytes of the value of rec, a leaf record on this cursor's path (or popped from it)
+		// whose value is stored out of line
+		Future<Value> readOutOfLineValue(const RedwoodRecordRef& rec, int maxLength = std::numeric_limits<int>::max()) {
+			return VersionedBTree::readOutOfLineValue(pager, rec, btree->m_blockSize, maxLength, noHit);
+		}
+
+		// The value of the current record, wherever it is stored
+		Future<Value> readValue() {
+			if (get().isValueOutOfLine()) {
+				return readOutOfLineValue(get());
+			}
+			return Value(get().value.get());
+		}
+
 		bool inRoot() const { return path.size() == 1; }
 
 		// Pop and return the page cursor at the end of the path.
@@ -5296,15 +5859,17 @@ public:
 			if (page.isValid()) {
 				// The pager won't see this access so count it as a cache hit
 				++g_redwoodMetrics.pagerCacheHit;
+				++g_redwoodMetrics.level(((const BTreePage*)page->begin())->height).pageCacheHit;
 				path.push_back(arena, { (BTreePage*)page->begin(), getCursor(page) });
 				return Void();
 			}
 
-			return map(readPage(pager, id, &lowerBound, &upperBound), [this, &page, id](Reference<const IPage> p) {
-				page = p;
-				path.push_back(arena, { (BTreePage*)p->begin(), getCursor(p) });
-				return Void();
-			});
+			return map(readPage(pager, id, &lowerBound, &upperBound, false, noHit),
+			           [this, &page, id](Reference<const IPage> p) {
+				           page = p;
+				           path.push_back(arena, { (BTreePage*)p->begin(), getCursor(p) });
+				           return Void();
+			           });
 		}
 
 		Future<Void> pushPage(BTreePage::BinaryTree::Cursor c) {
@@ -5332,15 +5897,30 @@ public:
 		//     If there is a record in the tree > query then moveNext() will move to it.
 		// If non-zero is returned then the cursor is valid and the return value is logically equivalent
 		// to query.compare(cursor.get())
-		ACTOR Future<int> seek_impl(BTreeCursor* self, RedwoodRecordRef query, int prefetchBytes) {
-			state RedwoodRecordRef internalPageQuery = query.withMaxPageID();
+		// If pointLookup is true and the leaf where query must be has a filter that rules query's key out, then 0 is
+		// returned, the cursor is invalid, filterRejected is set, and the cursor's position is undefined so it must
+		// be seeked again before it can be moved.
+		// If beforeQuery is true then only records < query are wanted, so internal pages are seeked to the branch
+		// that holds the greatest record < query rather than to the one that would hold query.  They differ when
+		// query is a child's lower boundary, and then this saves reading the child only to step back out of it.
+		ACTOR Future<int> seek_impl(BTreeCursor* self, RedwoodRecordRef query, int prefetchBytes, bool pointLookup,
+		                            bool beforeQuery) {
+			state RedwoodRecordRef internalPageQuery = beforeQuery ? query : query.withMaxPageID();
 			self->path = self->path.slice(0, 1);
+			self->filterRejected = false;
 			debug_printf("seek(%s, %d) start cursor = %s\n", query.toString().c_str(), prefetchBytes,
 			             self->toString().c_str());
 
 			loop {
 				auto& entry = self->path.back();
 				if (entry.btPage->isLeaf()) {
+					if (pointLookup && !entry.cursor.mirror->mayContain(query)) {
+						self->valid = false;
+						self->filterRejected = true;
+						debug_printf("seek(%s, %d) loop exit rejected by filter cursor=%s\n", query.toString().c_str(),
+						             prefetchBytes, self->toString().c_str());
+						return 0;
+					}
 					int cmp = entry.cursor.seek(query);
 					self->valid = entry.cursor.valid() && !entry.cursor.node->isDeleted();
 					debug_printf("seek(%s, %d) loop exit cmp=%d cursor=%s\n", query.toString().c_str(), prefetchBytes,
@@ -5384,7 +5964,26 @@ public:
 			}
 		}
 
-		Future<int> seek(RedwoodRecordRef query, int prefetchBytes) { return seek_impl(this, query, prefetchBytes); }
+		Future<int> seek(RedwoodRecordRef query, int prefetchBytes, bool pointLookup = false,
+		                 bool beforeQuery = false) {
+			return seek_impl(this, query, prefetchBytes, pointLookup, beforeQuery);
+		}
+
+		// Seeks cursor to the first record >= query and returns true if it exists and has the same key as query.
+		// When false is returned the cursor's position is undefined.
+		ACTOR Future<bool> seekKey_impl(BTreeCursor* self, RedwoodRecordRef query) {
+			debug_printf("seekKey(%s) start\n", query.toString().c_str());
+			int cmp = wait(self->seek(query, 0, true));
+			if (self->filterRejected) {
+				return false;
+			}
+			if (cmp > 0 || (cmp == 0 && !self->isValid())) {
+				wait(self->moveNext());
+			}
+			return self->isValid() && self->get().key == query.key;
+		}
+
+		Future<bool> seekKey(RedwoodRecordRef query) { return seekKey_impl(this, query); }
 
 		ACTOR Future<Void> seekGTE_impl(BTreeCursor* self, RedwoodRecordRef query, int prefetchBytes) {
 			debug_printf("seekGTE(%s, %d) start\n", query.toString().c_str(), prefetchBytes);
@@ -5401,7 +6000,7 @@ public:
 
 		ACTOR Future<Void> seekLT_impl(BTreeCursor* self, RedwoodRecordRef query, int prefetchBytes) {
 			debug_printf("seekLT(%s, %d) start\n", query.toString().c_str(), prefetchBytes);
-			int cmp = wait(self->seek(query, prefetchBytes));
+			int cmp = wait(self->seek(query, prefetchBytes, false, true));
 			if (cmp <= 0) {
 				wait(self->movePrev());
 			}
@@ -5433,6 +6032,15 @@ public:
 
 				// Stop if successful
 				if (success) {
+					if (self->readAheadLeaves > 0 && entry.btPage->height == 2) {
+						auto c = entry.cursor;
+						for (int n = 0; n < self->readAheadLeaves && (forward ? c.moveNext() : c.movePrev());) {
+							if (c.get().value.present()) {
+								preLoadPage(self->pager.getPtr(), c.get().getChildPage());
+								++n;
+							}
+						}
+					}
 					break;
 				}
 
@@ -5489,14 +6097,15 @@ public:
 	// KeyValueRefs returned become invalid once the cursor is moved
 	class Cursor : public IStoreCursor, public ReferenceCounted<Cursor>, public FastAllocated<Cursor>, NonCopyable {
 	public:
-		Cursor(Reference<IPagerSnapshot> pageSource, BTreePageIDRef root, Version internalRecordVersion)
-		  : m_version(internalRecordVersion), m_cur1(pageSource, root), m_cur2(m_cur1) {}
+		Cursor(Reference<IPagerSnapshot> pageSource, BTreePageIDRef root, Version internalRecordVersion, int blockSize)
+		  : m_version(internalRecordVersion), m_blockSize(blockSize), m_cur1(pageSource, root), m_cur2(m_cur1) {}
 
 		void addref() { ReferenceCounted<Cursor>::addref(); }
 		void delref() { ReferenceCounted<Cursor>::delref(); }
 
 	private:
 		Version m_version;
+		int m_blockSize;
 		// If kv is valid
 		//   - kv.key references memory held by cur1
 		//   - If cur1 points to a non split KV pair
@@ -5568,7 +6177,7 @@ public:
 			// If we found the target key with a present value then return it as it is valid for any cmp type
 			if (self->m_cur1.present() && self->m_cur1.get().key == key) {
 				debug_printf("Target key found.  Cursor: %s\n", self->toString().c_str());
-				self->m_kv = self->m_cur1.get().toKeyValueRef();
+				wait(setKV(self));
 				return Void();
 			}
 
@@ -5621,6 +6230,19 @@ public:
 			return Void();
 		}
 
+		// Sets kv to the record at cur1, first reading its value into arena if it is stored out of line
+		ACTOR static Future<Void> setKV(Cursor* self) {
+			if (!self->m_cur1.get().isValueOutOfLine()) {
+				self->m_kv = self->m_cur1.get().toKeyValueRef();
+				return Void();
+			}
+			Value v = wait(readOutOfLineValue(self->m_cur1.getPager(), self->m_cur1.get(), self->m_blockSize,
+			                                  std::numeric_limits<int>::max(), false));
+			self->m_arena = v.arena();
+			self->m_kv = KeyValueRef(self->m_cur1.get().key, v);
+			return Void();
+		}
+
 		ACTOR static Future<Void> move(Cursor* self, bool fwd) {
 			debug_printf("Cursor::move(%d): Start %s\n", fwd, self->toString().c_str());
 			ASSERT(self->m_cur1.valid());
@@ -5659,7 +6281,7 @@ public:
 				    (self->m_cur1.presentAtVersion(self->m_version) &&
 				     (!self->m_cur2.validAtVersion(self->m_version) ||
 				      self->m_cur2.get().key != self->m_cur1.get().key))) {
-					self->m_kv = self->m_cur1.get().toKeyValueRef();
+					wait(setKV(self));
 					return Void();
 				}
 
@@ -5744,13 +6366,39 @@ public:
 
 	Future<Void> commit(bool sequential = false) override {
 		Future<Void> c = m_tree->commit();
-		m_tree->setOldestVersion(m_tree->getLatestVersion());
+		// Older tree versions are only kept for as long as a retained snapshot needs them
+		Version oldest = m_tree->getLatestVersion();
+		if (!m_snapshots.empty()) {
+			oldest = std::min(oldest, m_snapshots.begin()->second);
+		}
+		m_tree->setOldestVersion(oldest);
 		m_tree->setWriteVersion(m_tree->getWriteVersion() + 1);
 		return catchError(c);
 	}
 
 	KeyValueStoreType getType() const override { return KeyValueStoreType::SSD_REDWOOD_V1; }
 
+	bool canRetainSnapshots() const override { return true; }
+
+	void retainSnapshot(Version v, Version oldestRetained) override {
+		m_snapshots.erase(m_snapshots.begin(), m_snapshots.lower_bound(oldestRetained));
+		m_snapshots[v] = m_tree->getWriteVersion();
+	}
+
+	bool hasSnapshot(Version v) const override {
+		auto s = m_snapshots.find(v);
+		return s != m_snapshots.end() && s->second <= m_tree->getLastCommittedVersion();
+	}
+
+	Future<Standalone<RangeResultRef>> readRangeAtSnapshot(KeyRangeRef keys, Version v, int rowLimit = 1 << 30,
+	                                                       int byteLimit = 1 << 30) override {
+		if (!hasSnapshot(v)) {
+			return transaction_too_old();
+		}
+		debug_printf("READRANGE %s @%" PRId64 "\n", printable(keys).c_str(), v);
+		return catchError(readRange_impl(this, keys, rowLimit, byteLimit, m_snapshots[v]));
+	}
+
 	StorageBytes getStorageBytes() const override { return m_tree->getStorageBytes(); }
 
 	Future<Void> getError() { return delayed(m_error.getFuture()); };
@@ -5768,13 +6416,13 @@ public:
 	Future<Standalone<RangeResultRef>> readRange(KeyRangeRef keys, int rowLimit = 1 << 30,
 	                                             int byteLimit = 1 << 30) override {
 		debug_printf("READRANGE %s\n", printable(keys).c_str());
-		return catchError(readRange_impl(this, keys, rowLimit, byteLimit));
+		return catchError(readRange_impl(this, keys, rowLimit, byteLimit, m_tree->getLastCommittedVersion()));
 	}
 
 	ACTOR static Future<Standalone<RangeResultRef>> readRange_impl(KeyValueStoreRedwoodUnversioned* self, KeyRange keys,
-	                                                               int rowLimit, int byteLimit) {
+	                                                               int rowLimit, int byteLimit, Version readVersion) {
 		state VersionedBTree::BTreeCursor cur;
-		wait(self->m_tree->initBTreeCursor(&cur, self->m_tree->getLastCommittedVersion()));
+		wait(self->m_tree->initBTreeCursor(&cur, readVersion));
 
 		state Reference<FlowLock> readLock = self->m_concurrentReads;
 		wait(readLock->take());
@@ -5792,6 +6440,14 @@ public:
 		// Prefetch is disabled for now pending some decent logic for deciding how much to fetch
 		state int prefetchBytes = 0;
 
+		// Once a read has gone through enough leaves to be a bulk scan, such as a backup or consistency check, its
+		// remaining page reads stop promoting pages in the cache
+		state int leavesRead = 0;
+
+		// Values stored out of line are read alongside the scan and put in their places in result at the end
+		state std::vector<int> outOfLineIndexes;
+		state std::vector<Future<Value>> outOfLineValues;
+
 		if (rowLimit > 0) {
 			wait(cur.seekGTE(keys.begin, prefetchBytes));
 			while (cur.isValid()) {
@@ -5799,12 +6455,20 @@ public:
 				bool isRoot = cur.inRoot();
 				BTreePage::BinaryTree::Cursor leafCursor = cur.popPath();
 				while (leafCursor.valid()) {
-					KeyValueRef kv = leafCursor.get().toKeyValueRef();
-					if (kv.key >= keys.end) {
+					const RedwoodRecordRef& rec = leafCursor.get();
+					if (rec.key >= keys.end) {
 						break;
 					}
-					accumulatedBytes += kv.expectedSize();
-					result.push_back_deep(result.arena(), kv);
+					if (rec.isValueOutOfLine()) {
+						outOfLineIndexes.push_back(result.size());
+						outOfLineValues.push_back(cur.readOutOfLineValue(rec));
+						accumulatedBytes += rec.key.expectedSize() + rec.getOutOfLineValueSize();
+						result.push_back_deep(result.arena(), KeyValueRef(rec.key, ValueRef()));
+					} else {
+						KeyValueRef kv = rec.toKeyValueRef();
+						accumulatedBytes += kv.expectedSize();
+						result.push_back_deep(result.arena(), kv);
+					}
 					if (--rowLimit == 0 || accumulatedBytes >= byteLimit) {
 						break;
 					}
@@ -5815,6 +6479,14 @@ public:
 				if (leafCursor.valid() || isRoot) {
 					break;
 				}
+				// The read has gone on past its first leaf so it is likely to go on further
+				if (++leavesRead == 1) {
+					cur.setReadAhead(std::min(SERVER_KNOBS->REDWOOD_SCAN_READ_AHEAD_LEAVES,
+					                          SERVER_KNOBS->REDWOOD_KVSTORE_CONCURRENT_READS));
+				}
+				if (leavesRead == SERVER_KNOBS->REDWOOD_SCAN_NO_HIT_LEAVES) {
+					cur.setNoHit(true);
+				}
 				wait(cur.moveNext());
 			}
 		} else {
@@ -5824,12 +6496,20 @@ public:
 				bool isRoot = cur.inRoot();
 				BTreePage::BinaryTree::Cursor leafCursor = cur.popPath();
 				while (leafCursor.valid()) {
-					KeyValueRef kv = leafCursor.get().toKeyValueRef();
-					if (kv.key < keys.begin) {
+					const RedwoodRecordRef& rec = leafCursor.get();
+					if (rec.key < keys.begin) {
 						break;
 					}
-					accumulatedBytes += kv.expectedSize();
-					result.push_back_deep(result.arena(), kv);
+					if (rec.isValueOutOfLine()) {
+						outOfLineIndexes.push_back(result.size());
+						outOfLineValues.push_back(cur.readOutOfLineValue(rec));
+						accumulatedBytes += rec.key.expectedSize() + rec.getOutOfLineValueSize();
+						result.push_back_deep(result.arena(), KeyValueRef(rec.key, ValueRef()));
+					} else {
+						KeyValueRef kv = rec.toKeyValueRef();
+						accumulatedBytes += kv.expectedSize();
+						result.push_back_deep(result.arena(), kv);
+					}
 					if (++rowLimit == 0 || accumulatedBytes >= byteLimit) {
 						break;
 					}
@@ -5840,10 +6520,26 @@ public:
 				if (leafCursor.valid() || isRoot) {
 					break;
 				}
+				// The read has gone on past its first leaf so it is likely to go on further
+				if (++leavesRead == 1) {
+					cur.setReadAhead(std::min(SERVER_KNOBS->REDWOOD_SCAN_READ_AHEAD_LEAVES,
+					                          SERVER_KNOBS->REDWOOD_KVSTORE_CONCURRENT_READS));
+				}
+				if (leavesRead == SERVER_KNOBS->REDWOOD_SCAN_NO_HIT_LEAVES) {
+					cur.setNoHit(true);
+				}
 				wait(cur.movePrev());
 			}
 		}
 
+		if (!outOfLineValues.empty()) {
+			std::vector<Value> values = wait(getAll(outOfLineValues));
+			for (int i = 0; i < values.size(); ++i) {
+				result.arena().dependsOn(values[i].arena());
+				result[outOfLineIndexes[i]].value = values[i];
+			}
+		}
+
 		result.more = rowLimit == 0 || accumulatedBytes >= byteLimit;
 		if (result.more) {
 			ASSERT(result.size() > 0);
@@ -5852,6 +6548,98 @@ public:
 		return result;
 	}
 
+	bool canSkipKeys() const override { return true; }
+
+	Future<SkippedKeys> skipKeys(KeyRangeRef keys, int64_t n) override {
+		debug_printf("SKIPKEYS %s %" PRId64 "\n", printable(keys).c_str(), n);
+		return catchError(skipKeys_impl(this, keys, n));
+	}
+
+	// Leaves that lie entirely within keys are passed over using their item counts, so no records are decoded
+	// except in the first and last leaves.  Every leaf page along the way is still read; internal pages do not
+	// record how many keys are under each child.
+	ACTOR static Future<SkippedKeys> skipKeys_impl(KeyValueStoreRedwoodUnversioned* self, KeyRange keys, int64_t n) {
+		state VersionedBTree::BTreeCursor cur;
+		wait(self->m_tree->initBTreeCursor(&cur, self->m_tree->getLastCommittedVersion()));
+
+		state Reference<FlowLock> readLock = self->m_concurrentReads;
+		wait(readLock->take());
+		state FlowLock::Releaser releaser(*readLock);
+		++g_redwoodMetrics.opGetRange;
+
+		if (n == 0) {
+			return SkippedKeys();
+		}
+
+		state bool forward = n > 0;
+		state int64_t remaining = std::abs(n);
+		state int64_t count = 0;
+		state int leavesRead = 0;
+
+		if (forward) {
+			wait(cur.seekGTE(keys.begin, 0));
+		} else {
+			wait(cur.seekLT(keys.end, 0));
+		}
+
+		while (cur.isValid()) {
+			bool isRoot = cur.inRoot();
+			BTreePage::BinaryTree::Cursor leafCursor = cur.popPath();
+
+			// Past the first leaf the cursor starts at the near edge of the leaf, so if the far edge is still in keys
+			// the whole leaf counts.
+			if (leavesRead > 0) {
+				BTreePage::BinaryTree::Cursor edge = leafCursor;
+				bool inside = forward ? edge.moveLast() && edge.get().key < keys.end
+				                      : edge.moveFirst() && edge.get().key >= keys.begin;
+				int items = edge.mirror->tree->numItems;
+				if (inside && items <= remaining) {
+					count += items;
+					remaining -= items;
+					if (remaining == 0) {
+						return SkippedKeys(Key(edge.get().key), count);
+					}
+					leafCursor = BTreePage::BinaryTree::Cursor();
+				}
+			}
+
+			bool outOfRange = false;
+			while (leafCursor.valid()) {
+				KeyRef key = leafCursor.get().key;
+				if (forward ? key >= keys.end : key < keys.begin) {
+					outOfRange = true;
+					break;
+				}
+				++count;
+				if (--remaining == 0) {
+					return SkippedKeys(Key(key), count);
+				}
+				if (forward) {
+					leafCursor.moveNext();
+				} else {
+					leafCursor.movePrev();
+				}
+			}
+			if (outOfRange || isRoot) {
+				break;
+			}
+			if (++leavesRead == 1) {
+				cur.setReadAhead(std::min(SERVER_KNOBS->REDWOOD_SCAN_READ_AHEAD_LEAVES,
+				                          SERVER_KNOBS->REDWOOD_KVSTORE_CONCURRENT_READS));
+			}
+			if (leavesRead == SERVER_KNOBS->REDWOOD_SCAN_NO_HIT_LEAVES) {
+				cur.setNoHit(true);
+			}
+			if (forward) {
+				wait(cur.moveNext());
+			} else {
+				wait(cur.movePrev());
+			}
+		}
+
+		return SkippedKeys(Optional<Key>(), count);
+	}
+
 	ACTOR static Future<Optional<Value>> readValue_impl(KeyValueStoreRedwoodUnversioned* self, Key key,
 	                                                    Optional<UID> debugID) {
 		state VersionedBTree::BTreeCursor cur;
@@ -5862,9 +6650,13 @@ public:
 		state FlowLock::Releaser releaser(*readLock);
 		++g_redwoodMetrics.opGet;
 
-		wait(cur.seekGTE(key, 0));
-		if (cur.isValid() && cur.get().key == key) {
-			return cur.get().value.get();
+		bool found = wait(cur.seekKey(key));
+		if (found) {
+			Value v = wait(cur.readValue());
+			return v;
+		}
+		if (cur.rejectedByFilter()) {
+			++g_redwoodMetrics.opGetFilterReject;
 		}
 		return Optional<Value>();
 	}
@@ -5885,6 +6677,10 @@ public:
 
 		wait(cur.seekGTE(key, 0));
 		if (cur.isValid() && cur.get().key == key) {
+			if (cur.get().isValueOutOfLine()) {
+				Value v = wait(cur.readOutOfLineValue(cur.get(), maxLength));
+				return v;
+			}
 			Value v = cur.get().value.get();
 			int len = std::min(v.size(), maxLength);
 			return Value(v.substr(0, len));
@@ -5897,6 +6693,51 @@ public:
 		return catchError(readValuePrefix_impl(this, key, maxLength, debugID));
 	}
 
+	// All of the keys are looked up with one cursor, under one read lock, at one version.  They are visited in key
+	// order so that each seek finds the pages along its path among those the cursor already holds.
+	ACTOR static Future<std::vector<Optional<Value>>> readValues_impl(KeyValueStoreRedwoodUnversioned* self,
+	                                                                  std::vector<std::pair<KeyRef, int>> keys,
+	                                                                  Optional<UID> debugID) {
+		state VersionedBTree::BTreeCursor cur;
+		wait(self->m_tree->initBTreeCursor(&cur, self->m_tree->getLastCommittedVersion()));
+
+		state Reference<FlowLock> readLock = self->m_concurrentReads;
+		wait(readLock->take());
+		state FlowLock::Releaser releaser(*readLock);
+
+		state std::vector<int> order(keys.size());
+		for (int i = 0; i < order.size(); ++i) {
+			order[i] = i;
+		}
+		const auto& k = keys;
+		std::sort(order.begin(), order.end(), [&k](int a, int b) { return k[a].first < k[b].first; });
+
+		state std::vector<Optional<Value>> values(keys.size());
+		state int i = 0;
+		for (; i < order.size(); ++i) {
+			++g_redwoodMetrics.opGet;
+			bool found = wait(cur.seekKey(keys[order[i]].first));
+			if (found && cur.get().isValueOutOfLine()) {
+				int maxLength = keys[order[i]].second;
+				Value v = wait(
+				    cur.readOutOfLineValue(cur.get(), maxLength >= 0 ? maxLength : std::numeric_limits<int>::max()));
+				values[order[i]] = v;
+			} else if (found) {
+				ValueRef v = cur.get().value.get();
+				int maxLength = keys[order[i]].second;
+				values[order[i]] = Value(maxLength >= 0 && v.size() > maxLength ? v.substr(0, maxLength) : v);
+			} else if (cur.rejectedByFilter()) {
+				++g_redwoodMetrics.opGetFilterReject;
+			}
+		}
+		return values;
+	}
+
+	Future<std::vector<Optional<Value>>> readValues(std::vector<std::pair<KeyRef, int>> const& keys,
+	                                                Optional<UID> debugID = Optional<UID>()) override {
+		return catchError(readValues_impl(this, keys, debugID));
+	}
+
 	virtual ~KeyValueStoreRedwoodUnversioned(){};
 
 private:
@@ -5906,6 +6747,8 @@ private:
 	Promise<Void> m_closed;
 	Promise<Void> m_error;
 	Reference<FlowLock> m_concurrentReads;
+	// Retained snapshots, from the version the storage server named them by to the tree version holding them
+	std::map<Version, Version> m_snapshots;
 
 	template <typename T>
 	inline Future<T> catchError(Future<T> f) {
@@ -6017,18 +6860,19 @@ ACTOR Future<int> verifyRangeBTreeCursor(VersionedBTree* btree, Key start, Key e
 			       iLast->first.first.c_str());
 			break;
 		}
-		if (cur.get().value.get() != iLast->second.get()) {
+		Value value = wait(cur.readValue());
+		if (value != iLast->second.get()) {
 			++errors;
 			++*pErrorCount;
 			printf("VerifyRange(@%" PRId64 ", %s, %s) ERROR: Tree key '%s' has tree value '%s' but expected '%s'\n", v,
 			       start.printable().c_str(), end.printable().c_str(), cur.get().key.toString().c_str(),
-			       cur.get().value.get().toString().c_str(), iLast->second.get().c_str());
+			       value.toString().c_str(), iLast->second.get().c_str());
 			break;
 		}
 
 		ASSERT(errors == 0);
 
-		results.push_back(KeyValue(KeyValueRef(cur.get().key, cur.get().value.get())));
+		results.push_back(KeyValue(KeyValueRef(cur.get().key, value)));
 		wait(cur.moveNext());
 	}
 
@@ -6081,13 +6925,14 @@ ACTOR Future<int> verifyRangeBTreeCursor(VersionedBTree* btree, Key start, Key e
 			       r->key.toString().c_str());
 			break;
 		}
-		if (cur.get().value.get() != r->value) {
+		Value value = wait(cur.readValue());
+		if (value != r->value) {
 			++errors;
 			++*pErrorCount;
 			printf("VerifyRangeReverse(@%" PRId64
 			       ", %s, %s) ERROR: Tree key '%s' has tree value '%s' but expected '%s'\n",
 			       v, start.printable().c_str(), end.printable().c_str(), cur.get().key.toString().c_str(),
-			       cur.get().value.get().toString().c_str(), r->value.toString().c_str());
+			       value.toString().c_str(), r->value.toString().c_str());
 			break;
 		}
 
@@ -6320,11 +7165,16 @@ ACTOR Future<int> seekAllBTreeCursor(VersionedBTree* btree, Version v,
 			debug_printf("Verifying @%" PRId64 " '%s'\n", ver, key.c_str());
 			state Arena arena;
 			wait(cur.seekGTE(RedwoodRecordRef(KeyRef(arena, key), 0), 0));
-			bool foundKey = cur.isValid() && cur.get().key == key;
-			bool hasValue = foundKey && cur.get().value.present();
+			state bool foundKey = cur.isValid() && cur.get().key == key;
+			state bool hasValue = foundKey && cur.get().value.present();
+			state Value value;
+			if (hasValue) {
+				Value curValue = wait(cur.readValue());
+				value = curValue;
+			}
 
 			if (val.present()) {
-				bool valueMatch = hasValue && cur.get().value.get() == val.get();
+				bool valueMatch = hasValue && value == val.get();
 				if (!foundKey || !hasValue || !valueMatch) {
 					++errors;
 					++*pErrorCount;
@@ -6336,14 +7186,14 @@ ACTOR Future<int> seekAllBTreeCursor(VersionedBTree* btree, Version v,
 						       val.get().c_str(), ver);
 					} else if (!valueMatch) {
 						printf("Verify ERROR: value_incorrect: for '%s' found '%s' expected '%s' @%" PRId64 "\n",
-						       key.c_str(), cur.get().value.get().toString().c_str(), val.get().c_str(), ver);
+						       key.c_str(), value.toString().c_str(), val.get().c_str(), ver);
 					}
 				}
 			} else if (foundKey && hasValue) {
 				++errors;
 				++*pErrorCount;
 				printf("Verify ERROR: cleared_key_found: '%s' -> '%s' @%" PRId64 "\n", key.c_str(),
-				       cur.get().value.get().toString().c_str(), ver);
+				       value.toString().c_str(), ver);
 			}
 		}
 		++i;
@@ -6605,6 +7455,31 @@ TEST_CASE("!/redwood/correctness/unit/RedwoodRecordRef") {
 		ASSERT(r2.getChildPage().begin() != id.begin());
 	}
 
+	// Test out of line values
+	{
+		LogicalPageID ids[] = { 7, 9, 11 };
+		BTreePageIDRef id(ids, 3);
+		Value ref = RedwoodRecordRef::makeOutOfLineValue(10000, id);
+		RedwoodRecordRef r = RedwoodRecordRef(LiteralStringRef("abc")).withOutOfLineValue(ref);
+		ASSERT(r.isValueOutOfLine());
+		ASSERT(r.getOutOfLineValueSize() == 10000);
+		ASSERT(r.getOutOfLinePages() == id);
+
+		RedwoodRecordRef base(LiteralStringRef("ab"), 0, LiteralStringRef("x"));
+		std::vector<uint8_t> buf(100);
+		RedwoodRecordRef::Delta& d = *(RedwoodRecordRef::Delta*)&buf.front();
+		ASSERT(r.writeDelta(d, base) == r.deltaSize(base, 0, false));
+		Arena mem;
+		RedwoodRecordRef decoded = d.apply(base, mem);
+		ASSERT(decoded == r);
+		ASSERT(decoded.isValueOutOfLine());
+		ASSERT(decoded.getOutOfLinePages() == id);
+
+		// A record with a value in line decoded against one with a value out of line is not out of line
+		base.writeDelta(d, decoded);
+		ASSERT(!d.apply(decoded, mem).isValueOutOfLine());
+	}
+
 	deltaTest(RedwoodRecordRef(LiteralStringRef(""), 0, LiteralStringRef("")),
 	          RedwoodRecordRef(LiteralStringRef(""), 0, LiteralStringRef("")));
 
@@ -6854,6 +7729,62 @@ TEST_CASE("!/redwood/correctness/unit/deltaTree/RedwoodRecordRef") {
 		printf("Elapsed %f\n", elapsed);
 	}
 
+	{
+		DeltaTree<RedwoodRecordRef>::Mirror mirror(tree, &prev, &next);
+		DeltaTree<RedwoodRecordRef>::Mirror indexed(tree, &prev, &next);
+		indexed.enableSearchIndex(1);
+		DeltaTree<RedwoodRecordRef>::Cursor c = mirror.getCursor();
+		DeltaTree<RedwoodRecordRef>::Cursor ci = indexed.getCursor();
+
+		printf("Comparing 1M random seeks using a search index to the same seeks without one.\n");
+		for (int i = 0; i < 1000000; ++i) {
+			RedwoodRecordRef query = items[deterministicRandom()->randomInt(0, items.size())];
+			if (deterministicRandom()->coinflip()) {
+				int length = deterministicRandom()->randomInt(0, 31);
+				query.key = StringRef(arena, deterministicRandom()->randomAlphaNumeric(length));
+			}
+			int cmp = c.seek(query);
+			int cmpIndexed = ci.seek(query);
+			if (c.node->raw != ci.node->raw || (cmp > 0) != (cmpIndexed > 0) || (cmp < 0) != (cmpIndexed < 0)) {
+				printf("Indexed seek mismatch!  query=%s  found=%s (%d)  expected=%s (%d)\n", query.toString().c_str(),
+				       ci.get().toString().c_str(), cmpIndexed, c.get().toString().c_str(), cmp);
+				ASSERT(false);
+			}
+		}
+
+		// Inserting discards the index, and seeks after it still match
+		RedwoodRecordRef extra(LiteralStringRef("search index insert"));
+		if (indexed.insert(extra)) {
+			ASSERT(ci.seek(extra) == 0 && ci.get() == extra);
+			ASSERT(indexed.erase(extra));
+		}
+	}
+
+	{
+		DeltaTree<RedwoodRecordRef>::Mirror filtered(tree, &prev, &next);
+		filtered.enableFilter(1, 10);
+
+		printf("Checking that a filter never rejects an item in the tree.\n");
+		for (auto& item : items) {
+			ASSERT(filtered.mayContain(item));
+		}
+
+		int rejected = 0;
+		for (int i = 0; i < 10000; ++i) {
+			RedwoodRecordRef query(StringRef(arena, deterministicRandom()->randomAlphaNumeric(40)));
+			rejected += filtered.mayContain(query) ? 0 : 1;
+		}
+		printf("Filter rejected %d of 10000 absent keys\n", rejected);
+		ASSERT(rejected > 9000);
+
+		// Inserts are added to the filter
+		RedwoodRecordRef extra(LiteralStringRef("filter insert"));
+		if (filtered.insert(extra)) {
+			ASSERT(filtered.mayContain(extra));
+			ASSERT(filtered.erase(extra));
+		}
+	}
+
 	{
 		printf("Doing 5M random seeks using 10k random cursors, each from a different mirror.\n");
 		double start = timer();
@@ -7206,6 +8137,40 @@ struct SimpleCounter {
 	std::string toString() { return format("%" PRId64 "/%.2f/%.2f", x, rate() / 1e6, avgRate() / 1e6); }
 };
 
+struct TestCacheEntry {
+	bool evictable() const { return true; }
+	Future<Void> onEvictable() const { return Void(); }
+	int value = 0;
+};
+
+TEST_CASE("!/redwood/correctness/unit/objectCache/scanResistant") {
+	state int cacheSize = 100;
+	state int hotCount = cacheSize * SERVER_KNOBS->REDWOOD_PAGE_CACHE_PROTECTED_FRACTION / 2;
+	state ObjectCache<int, TestCacheEntry> cache(cacheSize);
+
+	// Use the hot set twice so that it is protected
+	for (int pass = 0; pass < 2; ++pass) {
+		for (int i = 0; i < hotCount; ++i) {
+			cache.get(i).value = i;
+		}
+	}
+
+	// A scan of many more entries that are each used once, with and without noHit
+	for (int i = 0; i < cacheSize * 10; ++i) {
+		cache.get(cacheSize + i, deterministicRandom()->coinflip());
+	}
+	ASSERT(cache.count() == cacheSize);
+
+	for (int i = 0; i < hotCount; ++i) {
+		TestCacheEntry* e = cache.getIfExists(i);
+		ASSERT(e != nullptr && e->value == i);
+	}
+
+	wait(cache.clear());
+	ASSERT(cache.count() == 0);
+	return Void();
+}
+
 TEST_CASE("!/redwood/performance/mutationBuffer") {
 	// This test uses pregenerated short random keys
 	int count = 10e6;
@@ -7598,6 +8563,50 @@ TEST_CASE("!/redwood/correctness/pager/cow") {
 	return Void();
 }
 
+TEST_CASE("!/redwood/correctness/retainedSnapshots") {
+	state std::string fileName = "unittest_snapshots.redwood";
+	printf("Deleting old test data\n");
+	deleteFile(fileName);
+
+	state IKeyValueStore* kvs = openKVStore(KeyValueStoreType::SSD_REDWOOD_V1, fileName, UID(), 0);
+	wait(kvs->init());
+	ASSERT(kvs->canRetainSnapshots());
+
+	state Key key = LiteralStringRef("key");
+	state KeyRange range = KeyRangeRef(key, keyAfter(key));
+	kvs->set(KeyValueRef(key, LiteralStringRef("a")));
+	kvs->retainSnapshot(100, 0);
+	ASSERT(!kvs->hasSnapshot(100));
+	wait(kvs->commit());
+	ASSERT(kvs->hasSnapshot(100));
+
+	// Later commits do not change what the snapshot reads
+	kvs->set(KeyValueRef(key, LiteralStringRef("b")));
+	wait(kvs->commit());
+	kvs->clear(range);
+	kvs->retainSnapshot(200, 0);
+	wait(kvs->commit());
+	kvs->set(KeyValueRef(key, LiteralStringRef("c")));
+	wait(kvs->commit());
+
+	Standalone<RangeResultRef> at100 = wait(kvs->readRangeAtSnapshot(range, 100));
+	ASSERT(at100.size() == 1 && at100[0].value == LiteralStringRef("a"));
+	Standalone<RangeResultRef> at200 = wait(kvs->readRangeAtSnapshot(range, 200));
+	ASSERT(at200.empty());
+	Standalone<RangeResultRef> latest = wait(kvs->readRange(range));
+	ASSERT(latest.size() == 1 && latest[0].value == LiteralStringRef("c"));
+
+	// Snapshots older than the retained window are dropped
+	kvs->retainSnapshot(300, 150);
+	wait(kvs->commit());
+	ASSERT(!kvs->hasSnapshot(100) && kvs->hasSnapshot(200) && kvs->hasSnapshot(300));
+
+	Future<Void> closed = kvs->onClosed();
+	kvs->dispose();
+	wait(closed);
+	return Void();
+}
+
 TEST_CASE("!/redwood/performance/set") {
 	state SignalableActorCollection actors;
 
@@ -22,7 +22,14 @@
 #define ART_IMPL_H
 
 
+// By default this implements the art_tree nested in VersionedBTree.  Define ART_GLOBAL_SCOPE before including art.h
+// and this file to implement a namespace scope art_tree instead.
+#ifndef ART_GLOBAL_SCOPE
 using art_tree =  VersionedBTree::art_tree;
+#define ART_ITERATOR VersionedBTree::art_iterator
+#else
+#define ART_ITERATOR art_iterator
+#endif
 using art_leaf = art_tree::art_leaf;
 #define art_node art_tree::art_node
 
@@ -36,25 +43,25 @@ int art_tree::node_sizes[] = {
         sizeof(art_node4_kv), sizeof(art_node16_kv), sizeof(art_node48_kv), sizeof(art_node256_kv)};
 
 
-VersionedBTree::art_iterator art_tree::insert(KeyRef &k, void *value) {
+ART_ITERATOR art_tree::insert(KeyRef &k, void *value) {
 #define INIT_DEPTH 0
 #define REPLACE 1
     int old_val = 0;
     art_leaf *l = iterative_insert(this->root, &this->root, k, value, INIT_DEPTH, &old_val, REPLACE);
 
     if (!old_val) this->size++;
-    return VersionedBTree::art_iterator(l);
+    return ART_ITERATOR(l);
 }
 
-VersionedBTree::art_iterator art_tree::insert_if_absent(KeyRef &k, void *value, int *existing) {
+ART_ITERATOR art_tree::insert_if_absent(KeyRef &k, void *value, int *existing) {
 #define INIT_DEPTH 0
 #define DONTREPLACE 0
     art_leaf *l = iterative_insert(this->root, &this->root, k, value, INIT_DEPTH, existing, DONTREPLACE);
     if (!existing) this->size++;
-    return VersionedBTree::art_iterator(l);
+    return ART_ITERATOR(l);
 }
 
-VersionedBTree::art_iterator art_tree::lower_bound(const KeyRef &key) {
+ART_ITERATOR art_tree::lower_bound(const KeyRef &key) {
     if (!size) return art_iterator(nullptr);
     art_node *n = root;
     art_leaf *res = nullptr;
@@ -65,7 +72,7 @@ VersionedBTree::art_iterator art_tree::lower_bound(const KeyRef &key) {
     return art_iterator(res);
 }
 
-VersionedBTree::art_iterator art_tree::upper_bound(const KeyRef &key) {
+ART_ITERATOR art_tree::upper_bound(const KeyRef &key) {
     if (!size) return art_iterator(nullptr);
     art_node *n = root;
     art_leaf *res = nullptr;
@@ -154,7 +161,11 @@ art_leaf *art_tree::maximum(art_node *n) {
 
 void art_tree::art_bound_iterative(art_node *n, const KeyRef &k, int depth, art_leaf **result, bool strict) {
 
+#ifndef ART_GLOBAL_SCOPE
     static stack_entry arena[ART_MAX_KEY_LEN]; //Single threaded implementation.
+#else
+    static thread_local stack_entry arena[ART_MAX_KEY_LEN]; //May be used from several threads (e.g. by a partitioned resolver)
+#endif
 
     stack_entry *head = nullptr, *tmp, *curr_arena = arena;
     int ret;
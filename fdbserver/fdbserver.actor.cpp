@@ -48,7 +48,9 @@
 #include "fdbserver/CoordinationInterface.h"
 #include "fdbserver/CoroFlow.h"
 #include "fdbserver/DataDistribution.actor.h"
+#include "fdbserver/DiskBench.h"
 #include "fdbserver/IKeyValueStore.h"
+#include "fdbserver/MetricsHTTPServer.h"
 #include "fdbserver/MoveKeys.actor.h"
 #include "fdbserver/NetworkTest.h"
 #include "fdbserver/ServerDBInfo.h"
@@ -90,7 +92,7 @@ enum {
 	OPT_DCID, OPT_MACHINE_CLASS, OPT_BUGGIFY, OPT_VERSION, OPT_CRASHONERROR, OPT_HELP, OPT_NETWORKIMPL, OPT_NOBUFSTDOUT, OPT_BUFSTDOUTERR, OPT_TRACECLOCK,
 	OPT_NUMTESTERS, OPT_DEVHELP, OPT_ROLLSIZE, OPT_MAXLOGS, OPT_MAXLOGSSIZE, OPT_KNOB, OPT_TESTSERVERS, OPT_TEST_ON_SERVERS, OPT_METRICSCONNFILE,
 	OPT_METRICSPREFIX, OPT_LOGGROUP, OPT_LOCALITY, OPT_IO_TRUST_SECONDS, OPT_IO_TRUST_WARN_ONLY, OPT_FILESYSTEM, OPT_PROFILER_RSS_SIZE, OPT_KVFILE,
-	OPT_TRACE_FORMAT, OPT_WHITELIST_BINPATH, OPT_BLOB_CREDENTIAL_FILE
+	OPT_TRACE_FORMAT, OPT_WHITELIST_BINPATH, OPT_BLOB_CREDENTIAL_FILE, OPT_METRICS_HTTP_ADDRESS
 };
 
 CSimpleOpt::SOption g_rgOptions[] = {
@@ -166,6 +168,7 @@ CSimpleOpt::SOption g_rgOptions[] = {
 	{ OPT_TEST_ON_SERVERS,       "--testonservers",             SO_NONE },
 	{ OPT_METRICSCONNFILE,       "--metrics_cluster",           SO_REQ_SEP },
 	{ OPT_METRICSPREFIX,         "--metrics_prefix",            SO_REQ_SEP },
+	{ OPT_METRICS_HTTP_ADDRESS,  "--metrics_http_address",      SO_REQ_SEP },
 	{ OPT_IO_TRUST_SECONDS,      "--io_trust_seconds",          SO_REQ_SEP },
 	{ OPT_IO_TRUST_WARN_ONLY,    "--io_trust_warn_only",        SO_NONE },
 	{ OPT_TRACE_FORMAT      ,    "--trace_format",              SO_REQ_SEP },
@@ -443,6 +446,7 @@ ACTOR Future<Void> dumpDatabase( Database cx, std::string outputFilename, KeyRan
 
 void memoryTest();
 void skipListTest();
+void conflictSetReplay(std::string const& captureFile);
 
 Future<Void> startSystemMonitor(std::string dataFolder, Optional<Standalone<StringRef>> dcId,
                                 Optional<Standalone<StringRef>> zoneId, Optional<Standalone<StringRef>> machineId) {
@@ -569,8 +573,8 @@ static void printUsage( const char *name, bool devhelp ) {
 	       " Sets the LogGroup field with the specified value for all"
 	       " events in the trace output (defaults to `default').");
 	printOptionUsage("--trace_format FORMAT",
-	       " Select the format of the log files. xml (the default) and json"
-	       " are supported.");
+	       " Select the format of the log files. xml (the default), json"
+	       " and binary are supported.");
 	printOptionUsage("--tracer       TRACER",
 		   " Select a tracer for transaction tracing. Currently disabled"
 		   " (the default) and log_file are supported.");
@@ -607,7 +611,7 @@ static void printUsage( const char *name, bool devhelp ) {
 		printOptionUsage("-r ROLE, --role ROLE",
 			   " Server role (valid options are fdbd, test, multitest,"
 			   " simulation, networktestclient, networktestserver, restore"
-			   " consistencycheck, kvfileintegritycheck, kvfilegeneratesums). The default is `fdbd'.");
+			   " consistencycheck, kvfileintegritycheck, kvfilegeneratesums, diskbench). The default is `fdbd'.");
 #ifdef _WIN32
 		printOptionUsage("-n, --newconsole",
 			   " Create a new console.");
@@ -659,6 +663,9 @@ static void printUsage( const char *name, bool devhelp ) {
 		printOptionUsage("--metrics_prefix PREFIX",
 			   " The prefix where this process will store its metric data."
 			   " Must be specified if using a different database for metrics.");
+		printOptionUsage("--metrics_http_address ADDRESS",
+			   " The IP:Port at which this process serves its metrics over HTTP"
+			   " at /metrics, in the Prometheus text format. Disabled by default.");
 		printOptionUsage("--knob_KNOBNAME KNOBVALUE",
 			   " Changes a database knob. KNOBNAME should be lowercase.");
 		printOptionUsage("--io_trust_seconds SECONDS",
@@ -889,8 +896,10 @@ void restoreRoleFilesHelper(std::string dirSrc, std::string dirToMove, std::stri
 
 namespace {
 enum class ServerRole {
+	ConflictSetReplay,
 	ConsistencyCheck,
 	CreateTemplateDatabase,
+	DiskBench,
 	DSLTest,
 	FDBD,
 	KVFileGenerateIOLogChecksums,
@@ -926,6 +935,7 @@ struct CLIOptions {
 
 	std::vector<std::string> publicAddressStrs, listenAddressStrs;
 	NetworkAddressList publicAddresses, listenAddresses;
+	Optional<NetworkAddress> metricsHTTPAddress;
 
 	const char* targetKey = nullptr;
 	uint64_t memLimit =
@@ -1060,6 +1070,8 @@ private:
 					role = ServerRole::MultiTester;
 				else if (!strcmp(sRole, "skiplisttest"))
 					role = ServerRole::SkipListTest;
+				else if (!strcmp(sRole, "conflictsetreplay"))
+					role = ServerRole::ConflictSetReplay;
 				else if (!strcmp(sRole, "search"))
 					role = ServerRole::SearchMutations;
 				else if (!strcmp(sRole, "dsltest"))
@@ -1080,6 +1092,8 @@ private:
 					role = ServerRole::KVFileGenerateIOLogChecksums;
 				else if (!strcmp(sRole, "consistencycheck"))
 					role = ServerRole::ConsistencyCheck;
+				else if (!strcmp(sRole, "diskbench"))
+					role = ServerRole::DiskBench;
 				else {
 					fprintf(stderr, "ERROR: Unknown role `%s'\n", sRole);
 					printHelpTeaser(argv[0]);
@@ -1349,6 +1363,15 @@ private:
 			case OPT_METRICSPREFIX:
 				metricsPrefix = args.OptionArg();
 				break;
+			case OPT_METRICS_HTTP_ADDRESS:
+				try {
+					metricsHTTPAddress = NetworkAddress::parse(args.OptionArg());
+				} catch (Error&) {
+					fprintf(stderr, "ERROR: Could not parse metrics HTTP address `%s'\n", args.OptionArg());
+					printHelpTeaser(argv[0]);
+					flushAndExit(FDB_EXIT_ERROR);
+				}
+				break;
 			case OPT_IO_TRUST_SECONDS: {
 				const char* a = args.OptionArg();
 				if (!sscanf(a, "%lf", &fileIoTimeout)) {
@@ -1437,7 +1460,8 @@ private:
 		    std::any_of(publicAddressStrs.begin(), publicAddressStrs.end(),
 		                [](const std::string& addr) { return StringRef(addr).startsWith(LiteralStringRef("auto:")); });
 		if ((role != ServerRole::Simulation && role != ServerRole::CreateTemplateDatabase &&
-		     role != ServerRole::KVFileIntegrityCheck && role != ServerRole::KVFileGenerateIOLogChecksums) ||
+		     role != ServerRole::KVFileIntegrityCheck && role != ServerRole::KVFileGenerateIOLogChecksums &&
+		     role != ServerRole::DiskBench) ||
 		    autoPublicAddress) {
 
 			if (seedSpecified && !fileExists(connFile)) {
@@ -1629,6 +1653,11 @@ int main(int argc, char* argv[]) {
 			flushAndExit(FDB_EXIT_SUCCESS);
 		}
 
+		if (role == ServerRole::ConflictSetReplay) {
+			conflictSetReplay(opts.testFile);
+			flushAndExit(FDB_EXIT_SUCCESS);
+		}
+
 		if (role == ServerRole::DSLTest) {
 			dsltest();
 			flushAndExit(FDB_EXIT_SUCCESS);
@@ -1913,6 +1942,9 @@ int main(int argc, char* argv[]) {
 				                      opts.storageMemLimit, opts.metricsConnFile, opts.metricsPrefix, opts.rsssize,
 				                      opts.whitelistBinPaths));
 				actors.push_back(histogramReport());
+				if (opts.metricsHTTPAddress.present()) {
+					actors.push_back(metricsHTTPServer(opts.metricsHTTPAddress.get()));
+				}
 				// actors.push_back( recurring( []{}, .001 ) );  // for ASIO latency measurement
 
 				f = stopAfter(waitForAll(actors));
@@ -1951,6 +1983,9 @@ int main(int argc, char* argv[]) {
 		} else if (role == ServerRole::KVFileIntegrityCheck) {
 			f = stopAfter(KVFileCheck(opts.kvFile, true));
 			g_network->run();
+		} else if (role == ServerRole::DiskBench) {
+			f = stopAfter(diskBench(opts.dataFolder));
+			g_network->run();
 		} else if (role == ServerRole::KVFileGenerateIOLogChecksums) {
 			Optional<Void> result;
 			try {
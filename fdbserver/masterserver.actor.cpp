@@ -55,15 +55,22 @@ using std::max;
 struct CommitProxyVersionReplies {
 	std::map<uint64_t, GetCommitVersionReply> replies;
 	NotifiedVersion latestRequestNum;
+	double lastRequestTime; // When the proxy last asked for a version
+	double lastVersionTime; // When the proxy's last request was answered
+	double batchRate; // Smoothed commit batches per second, counting those it assigned from a lease
 
 	CommitProxyVersionReplies(CommitProxyVersionReplies&& r) noexcept
-	  : replies(std::move(r.replies)), latestRequestNum(std::move(r.latestRequestNum)) {}
+	  : replies(std::move(r.replies)), latestRequestNum(std::move(r.latestRequestNum)),
+	    lastRequestTime(r.lastRequestTime), lastVersionTime(r.lastVersionTime), batchRate(r.batchRate) {}
 	void operator=(CommitProxyVersionReplies&& r) noexcept {
 		replies = std::move(r.replies);
 		latestRequestNum = std::move(r.latestRequestNum);
+		lastRequestTime = r.lastRequestTime;
+		lastVersionTime = r.lastVersionTime;
+		batchRate = r.batchRate;
 	}
 
-	CommitProxyVersionReplies() : latestRequestNum(0) {}
+	CommitProxyVersionReplies() : latestRequestNum(0), lastRequestTime(0), lastVersionTime(0), batchRate(0) {}
 };
 
 ACTOR Future<Void> masterTerminateOnConflict( UID dbgid, Promise<Void> fullyRecovered, Future<Void> onConflict, Future<Void> switchedState ) {
@@ -193,6 +200,12 @@ struct MasterData : NonCopyable, ReferenceCounted<MasterData> {
 	Reference< ILogSystem > logSystem;
 	Version version;   // The last version assigned to a proxy by getVersion()
 	double lastVersionTime;
+	// While a commit proxy holds a version lease it may assign versions up to versionLeaseEnd itself, so no other
+	// proxy can be given one until it hands back the last version it used
+	Optional<UID> versionLeaseHolder;
+	Version versionLeaseEnd;
+	AsyncTrigger versionLeaseReleased;
+	int versionLeaseWaiters; // Requests from other proxies waiting for the lease to be handed back
 	LogSystemDiskQueueAdapter* txnStateLogAdapter;
 	IKeyValueStore* txnStateStore;
 	int64_t memoryLimit;
@@ -226,6 +239,14 @@ struct MasterData : NonCopyable, ReferenceCounted<MasterData> {
 	int64_t registrationCount; // Number of different MasterRegistrationRequests sent to clusterController
 
 	RecoveryState recoveryState;
+	double lastRecoveryStateTime;
+
+	// The seconds since the last MasterRecoveryState event, that is how long recovery spent in the state it reported
+	double timeInPreviousRecoveryState() {
+		double elapsed = now() - lastRecoveryStateTime;
+		lastRecoveryStateTime = now();
+		return elapsed;
+	}
 
 	AsyncVar<Standalone<VectorRef<ResolverMoveRef>>> resolverChanges;
 	Version resolverChangesVersion;
@@ -248,7 +269,8 @@ struct MasterData : NonCopyable, ReferenceCounted<MasterData> {
 	    safeLocality(tagLocalityInvalid), primaryLocality(tagLocalityInvalid), neverCreated(false),
 	    lastEpochEnd(invalidVersion), liveCommittedVersion(invalidVersion), databaseLocked(false),
 	    minKnownCommittedVersion(invalidVersion), recoveryTransactionVersion(invalidVersion), lastCommitTime(0),
-	    registrationCount(0), version(invalidVersion), lastVersionTime(0), txnStateStore(0), memoryLimit(2e9),
+	    registrationCount(0), lastRecoveryStateTime(now()), version(invalidVersion), lastVersionTime(0), versionLeaseEnd(invalidVersion),
+	    versionLeaseWaiters(0), txnStateStore(0), memoryLimit(2e9),
 	    addActor(addActor), hasConfiguration(false), recruitmentStalled(makeReference<AsyncVar<bool>>(false)) {
 		if(forceRecovery && !myInterface.locality.dcId().present()) {
 			TraceEvent(SevError, "ForcedRecoveryRequiresDcID");
@@ -606,12 +628,14 @@ ACTOR Future<vector<Standalone<CommitTransactionRef>>> recruitEverything( Refere
 		TraceEvent("MasterRecoveryState", self->dbgid)
 			.detail("StatusCode", status)
 			.detail("Status", RecoveryStatus::names[status])
+			.detail("PreviousStateSeconds", self->timeInPreviousRecoveryState())
 			.trackLatest("MasterRecoveryState");
 		return Never();
 	} else
 		TraceEvent("MasterRecoveryState", self->dbgid)
 		    .detail("StatusCode", RecoveryStatus::recruiting_transaction_servers)
 		    .detail("Status", RecoveryStatus::names[RecoveryStatus::recruiting_transaction_servers])
+		    .detail("PreviousStateSeconds", self->timeInPreviousRecoveryState())
 		    .detail("RequiredTLogs", self->configuration.tLogReplicationFactor)
 		    .detail("DesiredTLogs", self->configuration.getDesiredLogs())
 		    .detail("RequiredCommitProxies", 1)
@@ -646,6 +670,7 @@ ACTOR Future<vector<Standalone<CommitTransactionRef>>> recruitEverything( Refere
 	TraceEvent("MasterRecoveryState", self->dbgid)
 	    .detail("StatusCode", RecoveryStatus::initializing_transaction_servers)
 	    .detail("Status", RecoveryStatus::names[RecoveryStatus::initializing_transaction_servers])
+	    .detail("PreviousStateSeconds", self->timeInPreviousRecoveryState())
 	    .detail("CommitProxies", recruits.commitProxies.size())
 	    .detail("GrvProxies", recruits.grvProxies.size())
 	    .detail("TLogs", recruits.tLogs.size())
@@ -779,7 +804,8 @@ ACTOR Future<Void> sendInitialCommitToResolvers( Reference<MasterData> self ) {
 	ASSERT(self->recoveryTransactionVersion);
 
 	state Standalone<RangeResultRef> data = self->txnStateStore->readRange(txnKeys, BUGGIFY ? 3 : SERVER_KNOBS->DESIRED_TOTAL_BYTES, SERVER_KNOBS->DESIRED_TOTAL_BYTES).get();
-	state std::vector<Future<Void>> txnReplies;
+	// Chunks in flight to the commit proxies, oldest first, with the memory each one holds
+	state Deque<std::pair<Future<Void>, int64_t>> txnReplies;
 	state int64_t dataOutstanding = 0;
 
 	state std::vector<Endpoint> endpoints;
@@ -798,20 +824,27 @@ ACTOR Future<Void> sendInitialCommitToResolvers( Reference<MasterData> self ) {
 		req.sequence = txnSequence;
 		req.last = !nextData.size();
 		req.broadcastInfo = endpoints;
-		txnReplies.push_back(broadcastTxnRequest(req, SERVER_KNOBS->TXN_STATE_SEND_AMOUNT, false));
-		dataOutstanding += SERVER_KNOBS->TXN_STATE_SEND_AMOUNT*data.arena().getSize();
+		compressTxnStateRequest(req);
+		int64_t chunkMemory = SERVER_KNOBS->TXN_STATE_SEND_AMOUNT*data.arena().getSize();
+		txnReplies.push_back(std::make_pair(broadcastTxnRequest(req, SERVER_KNOBS->TXN_STATE_SEND_AMOUNT, false), chunkMemory));
+		dataOutstanding += chunkMemory;
 		data = nextData;
 		txnSequence++;
 
-		if(dataOutstanding > SERVER_KNOBS->MAX_TXS_SEND_MEMORY) {
-			wait( waitForAll(txnReplies) );
-			txnReplies = vector<Future<Void>>();
-			dataOutstanding = 0;
+		// Keep the pipeline to the commit proxies full: only wait for the oldest chunks to be acknowledged, rather than
+		// draining everything in flight, until enough memory is released to send the next one
+		while(dataOutstanding > SERVER_KNOBS->MAX_TXS_SEND_MEMORY) {
+			wait( txnReplies.front().first );
+			dataOutstanding -= txnReplies.front().second;
+			txnReplies.pop_front();
 		}
 
 		wait(yield());
 	}
-	wait( waitForAll(txnReplies) );
+	while(!txnReplies.empty()) {
+		wait( txnReplies.front().first );
+		txnReplies.pop_front();
+	}
 
 	vector<Future<ResolveTransactionBatchReply>> replies;
 	for(auto& r : self->resolvers) {
@@ -879,6 +912,7 @@ ACTOR Future<Void> recoverFrom( Reference<MasterData> self, Reference<ILogSystem
 	TraceEvent("MasterRecoveryState", self->dbgid)
 		.detail("StatusCode", RecoveryStatus::reading_transaction_system_state)
 		.detail("Status", RecoveryStatus::names[RecoveryStatus::reading_transaction_system_state])
+		.detail("PreviousStateSeconds", self->timeInPreviousRecoveryState())
 		.trackLatest("MasterRecoveryState");
 	self->hasConfiguration = false;
 
@@ -951,6 +985,26 @@ ACTOR Future<Void> recoverFrom( Reference<MasterData> self, Reference<ILogSystem
 	return Void();
 }
 
+// How long a lease of versions to give the proxy along with its version, or 0 for none.  Every version names the one
+// before it, so a lease is exclusive: it is only granted to a proxy which has recently had the commit stream to itself,
+// and is sized to cover about COMMIT_VERSION_LEASE_BATCHES of its batches.
+double versionLeaseDuration(MasterData* self, UID proxy, CommitProxyVersionReplies const& replies) {
+	const double maxDuration = SERVER_KNOBS->COMMIT_VERSION_LEASE_MAX_DURATION;
+	if (maxDuration <= 0 || replies.batchRate <= 0 || self->versionLeaseWaiters > 0) {
+		return 0;
+	}
+	double duration = std::min(maxDuration, SERVER_KNOBS->COMMIT_VERSION_LEASE_BATCHES / replies.batchRate);
+	if (replies.batchRate * duration < 2) {
+		return 0;
+	}
+	for (auto& it : self->lastCommitProxyVersionReplies) {
+		if (it.first != proxy && now() - it.second.lastRequestTime < maxDuration) {
+			return 0;
+		}
+	}
+	return duration;
+}
+
 ACTOR Future<Void> getVersion(Reference<MasterData> self, GetCommitVersionRequest req) {
 	state Span span("M:getVersion"_loc, { req.spanContext });
 	state std::map<UID, CommitProxyVersionReplies>::iterator proxyItr = self->lastCommitProxyVersionReplies.find(req.requestingProxy); // lastCommitProxyVersionReplies never changes
@@ -961,9 +1015,23 @@ ACTOR Future<Void> getVersion(Reference<MasterData> self, GetCommitVersionReques
 		return Void();
 	}
 
+	proxyItr->second.lastRequestTime = now();
+
 	TEST(proxyItr->second.latestRequestNum.get() < req.requestNum - 1); // Commit version request queued up
 	wait(proxyItr->second.latestRequestNum.whenAtLeast(req.requestNum-1));
 
+	while (self->versionLeaseHolder.present() && self->versionLeaseHolder.get() != req.requestingProxy) {
+		TEST(true); // Commit version request waits for another proxy's version lease
+		++self->versionLeaseWaiters;
+		try {
+			wait(self->versionLeaseReleased.onTrigger());
+		} catch (Error& e) {
+			--self->versionLeaseWaiters;
+			throw;
+		}
+		--self->versionLeaseWaiters;
+	}
+
 	auto itr = proxyItr->second.replies.find(req.requestNum);
 	if (itr != proxyItr->second.replies.end()) {
 		TEST(true); // Duplicate request for sequence
@@ -976,14 +1044,40 @@ ACTOR Future<Void> getVersion(Reference<MasterData> self, GetCommitVersionReques
 	}
 	else {
 		GetCommitVersionReply rep;
-
-		if(self->version == invalidVersion) {
-			self->lastVersionTime = now();
+		double t1 = now();
+
+		int batches = req.leaseBatches + (req.releaseLease ? 0 : 1);
+		if (proxyItr->second.lastVersionTime > 0 && t1 > proxyItr->second.lastVersionTime) {
+			proxyItr->second.batchRate =
+			    0.5 * proxyItr->second.batchRate + 0.5 * batches / (t1 - proxyItr->second.lastVersionTime);
+		}
+		proxyItr->second.lastVersionTime = t1;
+
+		if (self->versionLeaseHolder.present()) {
+			// The holder hands back the lease with each request.  It names the last version it assigned itself, or
+			// none if it never took up the lease, which left self->version the last version assigned.
+			ASSERT(self->versionLeaseHolder.get() == req.requestingProxy);
+			Version used = req.leasedVersion.present() ? req.leasedVersion.get() : self->version;
+			ASSERT(used >= self->version && used <= self->versionLeaseEnd);
+			TEST(used == self->versionLeaseEnd); // Version lease used up
+			self->lastVersionTime = std::min(
+			    t1, self->lastVersionTime + double(used - self->version) / SERVER_KNOBS->VERSIONS_PER_SECOND);
+			self->version = used;
+			self->versionLeaseHolder = Optional<UID>();
+			self->versionLeaseReleased.trigger();
+		}
+
+		if (req.releaseLease) {
+			TEST(true); // Version lease handed back when it ran out
+			rep.version = rep.prevVersion = self->version;
+		}
+		else if(self->version == invalidVersion) {
+			self->lastVersionTime = t1;
 			self->version = self->recoveryTransactionVersion;
 			rep.prevVersion = self->lastEpochEnd;
+			rep.version = self->version;
 		}
 		else {
-			double t1 = now();
 			if(BUGGIFY) {
 				t1 = self->lastVersionTime;
 			}
@@ -1002,9 +1096,22 @@ ACTOR Future<Void> getVersion(Reference<MasterData> self, GetCommitVersionReques
 				if(self->resolverNeedingChanges.empty())
 					self->resolverChanges.set(Standalone<VectorRef<ResolverMoveRef>>());
 			}
+
+			rep.version = self->version;
+
+			double leaseDuration = versionLeaseDuration(self.getPtr(), req.requestingProxy, proxyItr->second);
+			if (leaseDuration > 0) {
+				TEST(true); // Commit proxy given a version lease
+				self->versionLeaseHolder = req.requestingProxy;
+				self->versionLeaseEnd =
+				    self->version + std::min<Version>(SERVER_KNOBS->MAX_READ_TRANSACTION_LIFE_VERSIONS,
+				                                      std::max<Version>(SERVER_KNOBS->COMMIT_VERSION_LEASE_BATCHES,
+				                                                        SERVER_KNOBS->VERSIONS_PER_SECOND * leaseDuration));
+				rep.leaseEnd = self->versionLeaseEnd;
+				rep.leaseDuration = leaseDuration;
+			}
 		}
 
-		rep.version = self->version;
 		rep.requestNum = req.requestNum;
 
 		proxyItr->second.replies.erase(proxyItr->second.replies.begin(), proxyItr->second.replies.upper_bound(req.mostRecentProcessedRequestNum));
@@ -1161,7 +1268,9 @@ ACTOR Future<Void> resolutionBalancing(Reference<MasterData> self) {
 				//for(auto& it : key_resolver.ranges())
 				//	TraceEvent("KeyResolver").detail("Range", it.range()).detail("Value", it.value());
 
-				self->resolverChangesVersion = self->version + 1;
+				// A proxy holding a version lease will not see the changes until it hands it back
+				self->resolverChangesVersion =
+				    (self->versionLeaseHolder.present() ? self->versionLeaseEnd : self->version) + 1;
 				for (auto& p : self->commitProxies) self->resolverNeedingChanges.insert(p.id());
 				self->resolverChanges.set(movedRanges);
 			} catch( Error&e ) {
@@ -1252,6 +1361,7 @@ ACTOR Future<Void> trackTlogRecovery( Reference<MasterData> self, Reference<Asyn
 			TraceEvent("MasterRecoveryState", self->dbgid)
 			.detail("StatusCode", RecoveryStatus::fully_recovered)
 			.detail("Status", RecoveryStatus::names[RecoveryStatus::fully_recovered])
+			.detail("PreviousStateSeconds", self->timeInPreviousRecoveryState())
 			.detail("FullyRecoveredAtVersion", self->version)
 			.trackLatest("MasterRecoveryState");
 
@@ -1263,12 +1373,14 @@ ACTOR Future<Void> trackTlogRecovery( Reference<MasterData> self, Reference<Asyn
 			TraceEvent("MasterRecoveryState", self->dbgid)
 			.detail("StatusCode", RecoveryStatus::storage_recovered)
 			.detail("Status", RecoveryStatus::names[RecoveryStatus::storage_recovered])
+			.detail("PreviousStateSeconds", self->timeInPreviousRecoveryState())
 			.trackLatest("MasterRecoveryState");
 		} else if( allLogs && self->recoveryState < RecoveryState::ALL_LOGS_RECRUITED ) {
 			self->recoveryState = RecoveryState::ALL_LOGS_RECRUITED;
 			TraceEvent("MasterRecoveryState", self->dbgid)
 			.detail("StatusCode", RecoveryStatus::all_logs_recruited)
 			.detail("Status", RecoveryStatus::names[RecoveryStatus::all_logs_recruited])
+			.detail("PreviousStateSeconds", self->timeInPreviousRecoveryState())
 			.trackLatest("MasterRecoveryState");
 		}
 
@@ -1448,6 +1560,7 @@ ACTOR Future<Void> masterCore( Reference<MasterData> self ) {
 	TraceEvent("MasterRecoveryState", self->dbgid)
 		.detail("StatusCode", RecoveryStatus::reading_coordinated_state)
 		.detail("Status", RecoveryStatus::names[RecoveryStatus::reading_coordinated_state])
+		.detail("PreviousStateSeconds", self->timeInPreviousRecoveryState())
 		.trackLatest("MasterRecoveryState");
 
 	wait( self->cstate.read() );
@@ -1456,6 +1569,7 @@ ACTOR Future<Void> masterCore( Reference<MasterData> self ) {
 	TraceEvent("MasterRecoveryState", self->dbgid)
 		.detail("StatusCode", RecoveryStatus::locking_coordinated_state)
 		.detail("Status", RecoveryStatus::names[RecoveryStatus::locking_coordinated_state])
+		.detail("PreviousStateSeconds", self->timeInPreviousRecoveryState())
 		.detail("TLogs", self->cstate.prevDBState.tLogs.size())
 		.detail("ActiveGenerations", self->cstate.myDBState.oldTLogData.size() + 1)
 		.detail("MyRecoveryCount", self->cstate.prevDBState.recoveryCount+2)
@@ -1534,6 +1648,7 @@ ACTOR Future<Void> masterCore( Reference<MasterData> self ) {
 	TraceEvent("MasterRecoveryState", self->dbgid)
 		.detail("StatusCode", RecoveryStatus::recovery_transaction)
 		.detail("Status", RecoveryStatus::names[RecoveryStatus::recovery_transaction])
+		.detail("PreviousStateSeconds", self->timeInPreviousRecoveryState())
 		.detail("PrimaryLocality", self->primaryLocality)
 		.detail("DcId", self->myInterface.locality.dcId())
 		.trackLatest("MasterRecoveryState");
@@ -1642,6 +1757,7 @@ ACTOR Future<Void> masterCore( Reference<MasterData> self ) {
 	TraceEvent("MasterRecoveryState", self->dbgid)
 		.detail("StatusCode", RecoveryStatus::writing_coordinated_state)
 		.detail("Status", RecoveryStatus::names[RecoveryStatus::writing_coordinated_state])
+		.detail("PreviousStateSeconds", self->timeInPreviousRecoveryState())
 		.detail("TLogList", self->logSystem->describe())
 		.trackLatest("MasterRecoveryState");
 
@@ -1679,6 +1795,7 @@ ACTOR Future<Void> masterCore( Reference<MasterData> self ) {
 	TraceEvent("MasterRecoveryState", self->dbgid)
 		.detail("StatusCode", RecoveryStatus::accepting_commits)
 		.detail("Status", RecoveryStatus::names[RecoveryStatus::accepting_commits])
+		.detail("PreviousStateSeconds", self->timeInPreviousRecoveryState())
 		.detail("StoreType", self->configuration.storageServerStoreType)
 		.detail("RecoveryDuration", recoveryDuration)
 		.trackLatest("MasterRecoveryState");
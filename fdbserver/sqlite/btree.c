@@ -4868,6 +4868,48 @@ SQLITE_PRIVATE int sqlite3BtreePrevious(BtCursor *pCur, int *pRes){
   return rc;
 }
 
+/*
+** Hint the VFS to start reading the leaves a range scan will move onto
+** next, so that the scan does not wait for each one in turn.  When the
+** cursor has just entered a leaf (or bForce is set), the up to nPage
+** siblings that follow it (or precede it, if !bForward) in its parent are
+** passed to xPrefetch.  Pages already in the pager cache are skipped.
+*/
+SQLITE_PRIVATE void sqlite3BtreePrefetch(BtCursor *pCur, int bForward, int nPage, int bForce){
+  BtShared *pBt = pCur->pBt;
+  sqlite3_file *fd = sqlite3PagerFile(pBt->pPager);
+  MemPage *pPage, *pParent;
+  int idx, n;
+
+  if( pCur->eState!=CURSOR_VALID || pCur->iPage<1 || nPage<=0 ) return;
+  if( !fd->pMethods || !fd->pMethods->xPrefetch ) return;
+  pPage = pCur->apPage[pCur->iPage];
+  if( !pPage->leaf ) return;
+  if( !bForce && pCur->aiIdx[pCur->iPage]!=(bForward ? 0 : pPage->nCell-1) ) return;
+
+  pParent = pCur->apPage[pCur->iPage-1];
+  idx = pCur->aiIdx[pCur->iPage-1];
+  for(n=0; n<nPage; n++){
+    Pgno pgno;
+    DbPage *pDbPage;
+    idx += bForward ? 1 : -1;
+    if( idx<0 || idx>pParent->nCell ) break;
+    /* Child i is the left child of cell i, and child nCell the right child */
+    if( idx<pParent->nCell ){
+      pgno = get4byte(findCell(pParent, idx));
+    }else{
+      pgno = get4byte(&pParent->aData[pParent->hdrOffset+8]);
+    }
+    if( pgno==0 || pgno>btreePagecount(pBt) ) break;
+    pDbPage = sqlite3PagerLookup(pBt->pPager, pgno);
+    if( pDbPage ){
+      sqlite3PagerUnref(pDbPage);
+      continue;
+    }
+    fd->pMethods->xPrefetch(fd, (pgno-1)*(i64)pBt->pageSize, pBt->pageSize);
+  }
+}
+
 /*
 ** Allocate a new page from the database file.
 **
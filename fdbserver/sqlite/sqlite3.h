@@ -693,6 +693,7 @@ struct sqlite3_io_methods {
   /* Additional methods may be added in future releases */
   int (*xReadZeroCopy)(sqlite3_file*, void** data, int iAmt, sqlite3_int64 iOfst, int *pWasCached);
   int (*xReleaseZeroCopy)(sqlite3_file*, void* data, int iAmt, sqlite3_int64 iOfst);
+  void (*xPrefetch)(sqlite3_file*, sqlite3_int64 iOfst, int iAmt); /* Optional hint that a read is coming */
 };
 
 /*
@@ -27,6 +27,7 @@
 #include "fdbrpc/LoadBalance.h"
 #include "flow/ActorCollection.h"
 #include "flow/Arena.h"
+#include "flow/crc32c.h"
 #include "flow/Hash3.h"
 #include "flow/Histogram.h"
 #include "flow/IRandom.h"
@@ -98,12 +99,14 @@ struct AddingShard : NonCopyable {
 	enum Phase { WaitPrevious, Fetching, Waiting };
 
 	Phase phase;
+	bool fetchSplit = false; // Already split by fetchKeys, which only splits a shard up front once
 
 	AddingShard( StorageServer* server, KeyRangeRef const& keys );
 
 	// When fetchKeys "partially completes" (splits an adding shard in two), this is used to construct the left half
 	AddingShard( AddingShard* prev, KeyRange const& keys )
-		: keys(keys), fetchClient(prev->fetchClient), server(prev->server), transferredVersion(prev->transferredVersion), phase(prev->phase)
+		: keys(keys), fetchClient(prev->fetchClient), server(prev->server), transferredVersion(prev->transferredVersion), phase(prev->phase),
+		  fetchSplit(prev->fetchSplit)
 	{
 	}
 	~AddingShard() {
@@ -150,8 +153,191 @@ public:
 	}
 };
 
+// A bounded cache of values recently read from the storage engine, evicting the least recently used.  Every write of
+// data to the engine goes through StorageServerDisk, which invalidates the keys it touches both when it is written and
+// again once it is committed (the engine may go on returning the old value until then), so a cached value is always
+// what the engine itself would return.
+struct StorageReadCache : ReferenceCounted<StorageReadCache>, NonCopyable {
+	struct Entry {
+		Optional<Value> value;
+		std::list<KeyRef>::iterator lruPosition;
+	};
+
+	std::map<Key, Entry> entries;
+	std::list<KeyRef> lru; // Most recently used first; refers to keys in entries
+	int64_t bytes = 0;
+	int64_t capacity;
+
+	// Incremented by every invalidation, so that a read which was in flight across one does not cache what it read
+	uint64_t generation = 0;
+	Standalone<VectorRef<KeyRangeRef>> uncommitted; // Invalidated since the last commit began
+
+	explicit StorageReadCache(int64_t capacity) : capacity(capacity) {}
+
+	static int64_t entryBytes(KeyRef key, Optional<Value> const& value) {
+		return key.expectedSize() + (value.present() ? value.get().expectedSize() : 0) + sizeof(Entry) +
+		       sizeof(KeyRef) + 64; // Roughly the map and list node overhead
+	}
+
+	Optional<Optional<Value>> get(KeyRef key) {
+		auto it = entries.find(key);
+		if (it == entries.end()) return Optional<Optional<Value>>();
+		lru.splice(lru.begin(), lru, it->second.lruPosition);
+		return it->second.value;
+	}
+
+	void insert(KeyRef key, Optional<Value> const& value, uint64_t readGeneration) {
+		if (readGeneration != generation || entries.count(key)) return;
+		int64_t size = entryBytes(key, value);
+		if (size > capacity) return;
+		while (bytes + size > capacity) {
+			erase(entries.find(lru.back()));
+		}
+		auto it = entries.emplace(Key(key), Entry{ value, lru.end() }).first;
+		lru.push_front(it->first);
+		it->second.lruPosition = lru.begin();
+		bytes += size;
+	}
+
+	void invalidate(KeyRef key) {
+		++generation;
+		auto it = entries.find(key);
+		if (it != entries.end()) erase(it);
+		uncommitted.push_back(uncommitted.arena(), singleKeyRange(key, uncommitted.arena()));
+	}
+
+	void invalidate(KeyRangeRef keys) {
+		++generation;
+		eraseRange(keys);
+		uncommitted.push_back_deep(uncommitted.arena(), keys);
+	}
+
+	// Called when the commit that made the writes in written durable finishes
+	void committed(VectorRef<KeyRangeRef> written) {
+		++generation;
+		for (auto& keys : written) {
+			eraseRange(keys);
+		}
+	}
+
+private:
+	void eraseRange(KeyRangeRef keys) {
+		auto it = entries.lower_bound(keys.begin);
+		while (it != entries.end() && it->first < keys.end) {
+			erase(it++);
+		}
+	}
+
+	void erase(std::map<Key, Entry>::iterator it) {
+		bytes -= entryBytes(it->first, it->second.value);
+		lru.erase(it->second.lruPosition);
+		entries.erase(it);
+	}
+};
+
+// Lets a bounded number of reads run at once and queues the rest by transaction tag, untagged reads sharing one queue.
+// Each free slot goes to the queue whose tag has been charged the least read cost so far.  A tag which goes idle and
+// comes back starts level with the tag admitted most recently (start-time fair queueing), so it gets no credit for the
+// time it was idle, and one tag's big scans cannot hold up everyone else's reads for longer than it takes to catch up.
+struct StorageReadScheduler : ReferenceCounted<StorageReadScheduler>, NonCopyable {
+	struct TagQueue {
+		Deque<Promise<Void>> waiting;
+		int running = 0;
+		int64_t charged = 0;
+	};
+
+	TransactionTagMap<TagQueue> queues;
+	int running = 0;
+	int parallelism;
+	int tagQueueLimit; // Per tag; untagged reads are never rejected here
+	int64_t virtualTime = 0; // What the most recently admitted tag had been charged
+
+	StorageReadScheduler(int parallelism, int tagQueueLimit) : parallelism(parallelism), tagQueueLimit(tagQueueLimit) {}
+
+	// Reads tagged with more than one tag are queued by the first
+	static TransactionTag tagOf(Optional<TagSet> const& tags) {
+		if (!tags.present() || tags.get().size() == 0) return TransactionTag();
+		return TransactionTag(*tags.get().begin(), tags.get().getArena());
+	}
+
+	// Becomes ready when the read may start, which must be followed by finish(), or fails with server_overloaded if its
+	// tag already has too many reads queued
+	Future<Void> admit(TransactionTag const& tag) {
+		auto it = queues.find(tag);
+		if (it == queues.end()) {
+			it = queues.emplace(tag, TagQueue()).first;
+			it->second.charged = virtualTime;
+		}
+		TagQueue& q = it->second;
+		if (running < parallelism) {
+			start(q);
+			return Void();
+		}
+		if (tag.size() && q.waiting.size() >= tagQueueLimit) {
+			TEST(true); // Storage server read rejected by tag queue limit
+			return server_overloaded();
+		}
+		TEST(true); // Storage server read queued by tag
+		q.waiting.push_back(Promise<Void>());
+		return q.waiting.back().getFuture();
+	}
+
+	void finish(TransactionTag const& tag) {
+		auto it = queues.find(tag);
+		ASSERT(it != queues.end() && it->second.running > 0);
+		it->second.running--;
+		running--;
+		dispatch();
+	}
+
+	void charge(Optional<TagSet> const& tags, int64_t cost) {
+		auto it = queues.find(tagOf(tags));
+		if (it != queues.end()) it->second.charged += cost;
+	}
+
+private:
+	void start(TagQueue& q) {
+		virtualTime = std::max(virtualTime, q.charged);
+		q.running++;
+		running++;
+	}
+
+	void dispatch() {
+		while (running < parallelism) {
+			auto next = queues.end();
+			for (auto it = queues.begin(); it != queues.end();) {
+				TagQueue& q = it->second;
+				// Reads cancelled while queued leave their promises behind
+				while (!q.waiting.empty() && q.waiting.front().getFutureReferenceCount() == 0) {
+					q.waiting.pop_front();
+				}
+				if (q.waiting.empty()) {
+					// An idle tag is only remembered while it owes more than the tags now being admitted
+					if (q.running == 0 && q.charged <= virtualTime) {
+						it = queues.erase(it);
+						continue;
+					}
+				} else if (next == queues.end() || q.charged < next->second.charged) {
+					next = it;
+				}
+				++it;
+			}
+			if (next == queues.end()) return;
+
+			Promise<Void> ready = next->second.waiting.front();
+			next->second.waiting.pop_front();
+			start(next->second);
+			ready.send(Void());
+		}
+	}
+};
+
 struct StorageServerDisk {
-	explicit StorageServerDisk(struct StorageServer* data, IKeyValueStore* storage) : data(data), storage(storage) {}
+	explicit StorageServerDisk(struct StorageServer* data, IKeyValueStore* storage) : data(data), storage(storage) {
+		if (SERVER_KNOBS->STORAGE_READ_CACHE_BYTES > 0) {
+			readCache = makeReference<StorageReadCache>(SERVER_KNOBS->STORAGE_READ_CACHE_BYTES);
+		}
+	}
 
 	void makeNewStorageServerDurable();
 	bool makeVersionMutationsDurable(Version& prevStorageVersion, Version newStorageVersion, int64_t& bytesLeft);
@@ -162,25 +348,48 @@ struct StorageServerDisk {
 
 	void writeMutation( MutationRef mutation );
 	void writeKeyValue( KeyValueRef kv );
+	bool canBulkLoad() const { return storage->canBulkLoad(); }
+	Future<Void> reserveRange( KeyRangeRef keys ) { return storage->reserveRange( keys ); }
+	bool canRetainSnapshots() const { return storage->canRetainSnapshots(); }
+	void retainSnapshot(Version v, Version oldestRetained) { storage->retainSnapshot(v, oldestRetained); }
+	bool hasSnapshot(Version v) const { return storage->hasSnapshot(v); }
+	Future<Standalone<RangeResultRef>> readRangeAtSnapshot(KeyRangeRef keys, Version v, int rowLimit, int byteLimit) {
+		return storage->readRangeAtSnapshot(keys, v, rowLimit, byteLimit);
+	}
+	void bulkLoad( Standalone<VectorRef<KeyValueRef>> data );
 	void clearRange( KeyRangeRef keys );
 
 	Future<Void> getError() { return storage->getError(); }
 	Future<Void> init() { return storage->init(); }
-	Future<Void> commit() { return storage->commit(); }
+	Future<Void> commit() { return readCache ? commitAndInvalidate( storage, readCache ) : storage->commit(); }
 
 	// SOMEDAY: Put readNextKeyInclusive in IKeyValueStore
 	Future<Key> readNextKeyInclusive( KeyRef key ) { return readFirstKey(storage, KeyRangeRef(key, allKeys.end)); }
-	Future<Optional<Value>> readValue( KeyRef key, Optional<UID> debugID = Optional<UID>() ) { return storage->readValue(key, debugID); }
-	Future<Optional<Value>> readValuePrefix( KeyRef key, int maxLength, Optional<UID> debugID = Optional<UID>() ) { return storage->readValuePrefix(key, maxLength, debugID); }
+	Future<Optional<Value>> readValue( KeyRef key, Optional<UID> debugID = Optional<UID>() );
+	Future<Optional<Value>> readValuePrefix( KeyRef key, int maxLength, Optional<UID> debugID = Optional<UID>() );
+	Future<std::vector<Optional<Value>>> readValues(std::vector<std::pair<KeyRef, int>> const& keys,
+	                                                Optional<UID> debugID = Optional<UID>());
 	Future<Standalone<RangeResultRef>> readRange( KeyRangeRef keys, int rowLimit = 1<<30, int byteLimit = 1<<30 ) { return storage->readRange(keys, rowLimit, byteLimit); }
+	bool canSkipKeys() const { return storage->canSkipKeys(); }
+	Future<SkippedKeys> skipKeys(KeyRangeRef keys, int64_t n) { return storage->skipKeys(keys, n); }
 
 	KeyValueStoreType getKeyValueStoreType() const { return storage->getType(); }
 	StorageBytes getStorageBytes() const { return storage->getStorageBytes(); }
+	StorageEngineDebt getEngineDebt() const { return storage->getEngineDebt(); }
 	std::tuple<size_t, size_t, size_t> getSize() const { return storage->getSize(); }
+	int64_t getReadCacheBytes() const { return readCache ? readCache->bytes : 0; }
 
 private:
 	struct StorageServer* data;
 	IKeyValueStore* storage;
+	Reference<StorageReadCache> readCache; // Null if disabled
+
+	void invalidateReadCache(KeyRef key) {
+		if (readCache) readCache->invalidate(key);
+	}
+	void invalidateReadCache(KeyRangeRef keys) {
+		if (readCache) readCache->invalidate(keys);
+	}
 
 	void writeMutations(const VectorRef<MutationRef>& mutations, Version debugVersion, const char* debugContext);
 
@@ -189,6 +398,39 @@ private:
 		if (r.size()) return r[0].key;
 		else return range.end;
 	}
+
+	ACTOR static Future<Void> commitAndInvalidate( IKeyValueStore* storage, Reference<StorageReadCache> cache ) {
+		state Standalone<VectorRef<KeyRangeRef>> written = cache->uncommitted;
+		cache->uncommitted = Standalone<VectorRef<KeyRangeRef>>();
+		wait( storage->commit() );
+		cache->committed( written );
+		return Void();
+	}
+
+	ACTOR static Future<Optional<Value>> readValueAndCache( IKeyValueStore* storage, Reference<StorageReadCache> cache, Key key, Optional<UID> debugID ) {
+		state uint64_t generation = cache->generation;
+		Optional<Value> value = wait( storage->readValue( key, debugID ) );
+		cache->insert( key, value, generation );
+		return value;
+	}
+
+	// Fills in values[missed[i]] by reading keys[i] from storage, and caches the whole values among them
+	ACTOR static Future<std::vector<Optional<Value>>> readValuesAndCache(IKeyValueStore* storage,
+	                                                                     Reference<StorageReadCache> cache,
+	                                                                     std::vector<std::pair<KeyRef, int>> keys,
+	                                                                     std::vector<int> missed,
+	                                                                     std::vector<Optional<Value>> values,
+	                                                                     Optional<UID> debugID) {
+		state uint64_t generation = cache->generation;
+		std::vector<Optional<Value>> read = wait(storage->readValues(keys, debugID));
+		for (int i = 0; i < keys.size(); i++) {
+			if (keys[i].second < 0) {
+				cache->insert(keys[i].first, read[i], generation);
+			}
+			values[missed[i]] = std::move(read[i]);
+		}
+		return values;
+	}
 };
 
 struct UpdateEagerReadInfo {
@@ -218,6 +460,14 @@ struct UpdateEagerReadInfo {
 			} else {
 				keys.emplace_back(m.param1, m.param2.size() + 1);
 			}
+		} else if (m.type == MutationRef::SetIfAbsent) {
+			// Only the presence of a value matters
+			keys.emplace_back(m.param1, 1);
+		} else if (m.type == MutationRef::CompareAndSet) {
+			// A value longer than the expected one cannot match, so one extra byte is enough to tell
+			keys.emplace_back(m.param1, isValidCompareAndSetOperand(m.param2)
+			                                ? getCompareAndSetExpectedLength(m.param2) + 1
+			                                : 1);
 		} else if ((m.type == MutationRef::AppendIfFits) || (m.type == MutationRef::ByteMin) ||
 		           (m.type == MutationRef::ByteMax))
 			keys.emplace_back(m.param1, CLIENT_KNOBS->VALUE_SIZE_LIMIT);
@@ -233,6 +483,23 @@ struct UpdateEagerReadInfo {
 		//value gets populated in doEagerReads
 	}
 
+	// An atomic op whose key has a value or a clear in the latest version of versionedData is applied to that rather
+	// than to what storage holds (see applyMutation()), so those keys need not be read.  update() holds the
+	// durableVersionLock from the eager reads until the mutations are applied, so changeDurableVersion() cannot remove
+	// those entries meanwhile.  Clear ranges' end keys are left alone, since applyMutation() clamps them to storage.
+	template <class View>
+	void skipKeysInVersionedData(View const& latest) {
+		int kept = 0;
+		for (int i = 0; i < keys.size(); i++) {
+			auto it = latest.lastLessOrEqual(keys[i].first);
+			bool inMemory = it != latest.end() && ((it->isValue() && it.key() == keys[i].first) ||
+			                                       (it->isClearTo() && it->getEndKey() > keys[i].first));
+			if (!inMemory) keys[kept++] = keys[i];
+		}
+		TEST(kept < keys.size()); // Skipped eager reads of keys in versionedData
+		keys.resize(kept);
+	}
+
 	Optional<Value>& getValue(KeyRef key) {
 		int i = std::lower_bound(keys.begin(), keys.end(),std::pair<KeyRef, int>(key, 0), [](const std::pair<KeyRef, int>& lhs, const std::pair<KeyRef, int>& rhs) { return lhs.first < rhs.first; } ) - keys.begin();
 		ASSERT( i < keys.size() && keys[i].first == key );
@@ -259,6 +526,25 @@ struct FetchInjectionInfo {
 	vector<VerUpdateRef> changes;
 };
 
+// All watches of one key on a storage server share a WatchedKey.  A single watcher re-reads the key each time it
+// changes and fires the watches that were waiting on a value other than the one it read, so a mutation costs one read
+// per watched key instead of one per watch.
+struct WatchedKey : ReferenceCounted<WatchedKey> {
+	Key key;
+	Version readVersion; // The latest version the watcher has read the key at
+	Optional<Value> value; // The value of the key at readVersion
+	// The watched value, mapped to the promise fired when the key stops having it and the number of watches waiting on it
+	std::map<Optional<Value>, std::pair<Promise<Version>, int>> waiters;
+	Promise<Void> stop; // Sent when the last watch of the key is cancelled
+
+	WatchedKey(KeyRef key, Version readVersion, Optional<Value> value)
+	  : key(key), readVersion(readVersion), value(value) {}
+};
+
+template <class Request, class HandleFunction>
+Future<Void> scheduledRead(struct StorageServer* const& self, Reference<StorageReadScheduler> const& scheduler,
+                           Request const& req, HandleFunction const& fun);
+
 struct StorageServer {
 	typedef VersionedMap<KeyRef, ValueOrClearToRef> VersionedData;
 
@@ -350,6 +636,20 @@ public:
 	Arena lastArena;
 	double cpuUsage;
 	double diskUsage;
+	Smoother smoothReads, smoothSlowReads;
+
+	// Reads slower than AUTO_TAG_THROTTLE_SLOW_READ_LATENCY, as a recent fraction of all reads, are reported to
+	// ratekeeper so that it can throttle busy read tags while reads suffer even though the write queue is not growing
+	void recordReadLatency(double duration) {
+		smoothReads.addDelta(1);
+		if (duration > SERVER_KNOBS->AUTO_TAG_THROTTLE_SLOW_READ_LATENCY) {
+			smoothSlowReads.addDelta(1);
+		}
+	}
+	double slowReadFraction() {
+		double reads = smoothReads.smoothRate();
+		return reads > 0 ? std::min(1.0, smoothSlowReads.smoothRate() / reads) : 0.0;
+	}
 
 	std::map<Version, Standalone<VerUpdateRef>> const& getMutationLog() const { return mutationLog; }
 	std::map<Version, Standalone<VerUpdateRef>>& getMutableMutationLog() { return mutationLog; }
@@ -447,6 +747,18 @@ public:
 
 	CoalescedKeyRangeMap< Version > newestDirtyVersion; // Similar to newestAvailableVersion, but includes (only) keys that were only partly available (due to cancelled fetchKeys)
 
+	// readableSince[k] is the version since which k has been continuously readable here, or invalidVersion if it is not
+	// readable.  Storage engine snapshots at or after that version hold k, so range reads older than the MVCC window can
+	// be served from them.
+	CoalescedKeyRangeMap< Version > readableSince;
+
+	// The mutations applied by addMutation(), one entry per version, kept for change feeds until their version is
+	// forgotten along with the rest of the MVCC window.  The mutations share the arenas of mutationLog.
+	Deque<Standalone<MutationsAndVersionRef>> changeFeedLog;
+	Version changeFeedLogBegin; // changeFeedLog has every mutation at a version >= changeFeedLogBegin...
+	CoalescedKeyRangeMap< Version > changeFeedVersion; // ...and after changeFeedVersion[k], for the keys k fetched since
+	NotifiedVersion knownCommittedVersion; // Versions up to this one are applied and will not be rolled back
+
 	// The following are in rough order from newest to oldest
 	Version lastTLogVersion, lastVersionWithData, restoredVersion;
 	NotifiedVersion version;
@@ -468,6 +780,7 @@ public:
 	Key sk;
 	Reference<AsyncVar<ServerDBInfo>> db;
 	Database cx;
+	std::map<Key, Reference<WatchedKey>> watchedKeys; // Declared before actors, since watches unregister when cancelled
 	ActorCollection actors;
 
 	StorageServerMetrics metrics;
@@ -579,12 +892,19 @@ public:
 	};
 
 	TransactionTagCounter transactionTagCounter;
+	Reference<StorageReadScheduler> readScheduler; // Null if disabled
+
+	// Accounts a finished read to its tags, both for ratekeeper and for readScheduler
+	void addReadCost(Optional<TagSet> const& tags, int64_t bytes) {
+		transactionTagCounter.addRequest(tags, bytes);
+		if (readScheduler) readScheduler->charge(tags, transactionTagCounter.costFunction(bytes));
+	}
 
 	Optional<LatencyBandConfig> latencyBandConfig;
 
 	struct Counters {
 		CounterCollection cc;
-		Counter allQueries, getKeyQueries, getValueQueries, getRangeQueries, finishedQueries, rowsQueried, bytesQueried, watchQueries, emptyQueries;
+		Counter allQueries, getKeyQueries, getValueQueries, getValuesQueries, getRangeQueries, getRangeStreamQueries, getRangeAggregateQueries, getRangeChecksumQueries, snapshotRangeQueries, changeFeedStreamQueries, finishedQueries, rowsQueried, bytesQueried, watchQueries, emptyQueries;
 		Counter bytesInput, bytesDurable, bytesFetched,
 			mutationBytes;  // Like bytesInput but without MVCC accounting
 		Counter sampledBytesCleared;
@@ -593,15 +913,23 @@ public:
 		Counter loops;
 		Counter fetchWaitingMS, fetchWaitingCount, fetchExecutingMS, fetchExecutingCount;
 		Counter readsRejected;
+		Counter readCacheHits, readCacheMisses;
 
 		LatencySample readLatencySample;
 		LatencyBands readLatencyBands;
+		RequestStageLatencySample readStageLatencies;
 
 		Counters(StorageServer* self)
 			: cc("StorageServer", self->thisServerID.toString()),
 			getKeyQueries("GetKeyQueries", cc),
 			getValueQueries("GetValueQueries",cc),
+			getValuesQueries("GetValuesQueries", cc),
 			getRangeQueries("GetRangeQueries", cc),
+			getRangeStreamQueries("GetRangeStreamQueries", cc),
+			getRangeAggregateQueries("GetRangeAggregateQueries", cc),
+			getRangeChecksumQueries("GetRangeChecksumQueries", cc),
+			snapshotRangeQueries("SnapshotRangeQueries", cc),
+			changeFeedStreamQueries("ChangeFeedStreamQueries", cc),
 			allQueries("QueryQueue", cc),
 			finishedQueries("FinishedQueries", cc),
 			rowsQueried("RowsQueried", cc),
@@ -625,8 +953,11 @@ public:
 			fetchExecutingMS("FetchExecutingMS", cc),
 			fetchExecutingCount("FetchExecutingCount", cc),
 			readsRejected("ReadsRejected", cc),
-			readLatencySample("ReadLatencyMetrics", self->thisServerID, SERVER_KNOBS->LATENCY_METRICS_LOGGING_INTERVAL, SERVER_KNOBS->LATENCY_SAMPLE_SIZE),
-			readLatencyBands("ReadLatencyBands", self->thisServerID, SERVER_KNOBS->STORAGE_LOGGING_DELAY)
+			readCacheHits("ReadCacheHits", cc),
+			readCacheMisses("ReadCacheMisses", cc),
+			readLatencySample("ReadLatencyMetrics", self->thisServerID, SERVER_KNOBS->LATENCY_METRICS_LOGGING_INTERVAL),
+			readLatencyBands("ReadLatencyBands", self->thisServerID, SERVER_KNOBS->STORAGE_LOGGING_DELAY),
+			readStageLatencies("ReadStageLatencies", self->thisServerID, SERVER_KNOBS->LATENCY_METRICS_LOGGING_INTERVAL)
 		{
 			specialCounter(cc, "LastTLogVersion", [self](){ return self->lastTLogVersion; });
 			specialCounter(cc, "Version", [self](){ return self->version.get(); });
@@ -646,11 +977,14 @@ public:
 			specialCounter(cc, "BytesStored", [self](){ return self->metrics.byteSample.getEstimate(allKeys); });
 			specialCounter(cc, "ActiveWatches", [self](){ return self->numWatches; });
 			specialCounter(cc, "WatchBytes", [self](){ return self->watchBytes; });
+			specialCounter(cc, "ReadCacheBytes", [self](){ return self->storage.getReadCacheBytes(); });
 
 			specialCounter(cc, "KvstoreBytesUsed", [self](){ return self->storage.getStorageBytes().used; });
 			specialCounter(cc, "KvstoreBytesFree", [self](){ return self->storage.getStorageBytes().free; });
 			specialCounter(cc, "KvstoreBytesAvailable", [self](){ return self->storage.getStorageBytes().available; });
 			specialCounter(cc, "KvstoreBytesTotal", [self](){ return self->storage.getStorageBytes().total; });
+			specialCounter(cc, "KvstorePendingCompactionBytes", [self](){ return self->storage.getEngineDebt().pendingCompactionBytes; });
+			specialCounter(cc, "KvstoreLevel0Files", [self](){ return self->storage.getEngineDebt().level0Files; });
 			specialCounter(cc, "KvstoreSizeTotal", [self]() { return std::get<0>(self->storage.getSize()); });
 			specialCounter(cc, "KvstoreNodeTotal", [self]() { return std::get<1>(self->storage.getSize()); });
 			specialCounter(cc, "KvstoreInlineKey", [self]() { return std::get<2>(self->storage.getSize()); });
@@ -668,7 +1002,8 @@ public:
 	    counters(this), tag(invalidTag), maxQueryQueue(0), thisServerID(ssi.id()),
 	    readQueueSizeMetric(LiteralStringRef("StorageServer.ReadQueueSize")), behind(false), versionBehind(false),
 	    byteSampleClears(false, LiteralStringRef("\xff\xff\xff")), noRecentUpdates(false), lastUpdate(now()),
-	    poppedAllAfter(std::numeric_limits<Version>::max()), cpuUsage(0.0), diskUsage(0.0) {
+	    poppedAllAfter(std::numeric_limits<Version>::max()), cpuUsage(0.0), diskUsage(0.0),
+	    smoothReads(SERVER_KNOBS->SMOOTHING_AMOUNT), smoothSlowReads(SERVER_KNOBS->SMOOTHING_AMOUNT) {
 		version.initMetric(LiteralStringRef("StorageServer.Version"), counters.cc.id);
 		oldestVersion.initMetric(LiteralStringRef("StorageServer.OldestVersion"), counters.cc.id);
 		durableVersion.initMetric(LiteralStringRef("StorageServer.DurableVersion"), counters.cc.id);
@@ -676,9 +1011,17 @@ public:
 
 		newestAvailableVersion.insert(allKeys, invalidVersion);
 		newestDirtyVersion.insert(allKeys, invalidVersion);
+		readableSince.insert(allKeys, invalidVersion);
+		changeFeedVersion.insert(allKeys, invalidVersion);
+		changeFeedLogBegin = invalidVersion;
 		addShard( ShardInfo::newNotAssigned( allKeys ) );
 
 		cx = openDBOnServer(db, TaskPriority::DefaultEndpoint, true, true);
+
+		if (SERVER_KNOBS->STORAGE_READ_SCHEDULER_PARALLELISM > 0) {
+			readScheduler = makeReference<StorageReadScheduler>(SERVER_KNOBS->STORAGE_READ_SCHEDULER_PARALLELISM,
+			                                                    SERVER_KNOBS->STORAGE_READ_TAG_QUEUE_LIMIT);
+		}
 	}
 
 	//~StorageServer() { fclose(log); }
@@ -719,24 +1062,29 @@ public:
 		return true;
 	}
 
-	void checkChangeCounter( uint64_t oldShardChangeCounter, KeyRef const& key ) {
+	// Whether the shard holding key or keys has changed since oldShardChangeCounter, so that a read has to fail with
+	// wrong_shard_server.  The reading actors throw it themselves, which passes the error on without unwinding the
+	// stack, since many reads fail this way at once while shards move.
+	bool shardChangedSince( uint64_t oldShardChangeCounter, KeyRef const& key ) {
 		if (oldShardChangeCounter != shardChangeCounter &&
 			shards[key]->changeCounter > oldShardChangeCounter)
 		{
 			TEST(true); // shard change during getValueQ
-			throw wrong_shard_server();
+			return true;
 		}
+		return false;
 	}
 
-	void checkChangeCounter( uint64_t oldShardChangeCounter, KeyRangeRef const& keys ) {
+	bool shardChangedSince( uint64_t oldShardChangeCounter, KeyRangeRef const& keys ) {
 		if (oldShardChangeCounter != shardChangeCounter) {
 			auto sh = shards.intersectingRanges(keys);
 			for(auto i = sh.begin(); i != sh.end(); ++i)
 				if (i->value()->changeCounter > oldShardChangeCounter) {
 					TEST(true); // shard change during range operation
-					throw wrong_shard_server();
+					return true;
 				}
 		}
+		return false;
 	}
 
 	Counter::Value queueSize() {
@@ -779,8 +1127,44 @@ public:
 		}
 		return fun(this, request);
 	}
+
+	// Like readGuard(), but the read also waits for its turn in readScheduler if there is one
+	template<class Request, class HandleFunction>
+	Future<Void> scheduledReadGuard(const Request& request, const HandleFunction& fun) {
+		if (!readScheduler) return readGuard(request, fun);
+		return readGuard(request, [scheduler = readScheduler, fun = &fun](StorageServer* self, Request const& req) {
+			return scheduledRead(self, scheduler, req, fun);
+		});
+	}
 };
 
+ACTOR template <class Request, class HandleFunction>
+Future<Void> scheduledRead(StorageServer* self, Reference<StorageReadScheduler> scheduler, Request req,
+                           HandleFunction fun) {
+	state TransactionTag tag = StorageReadScheduler::tagOf(req.tags);
+	state Future<Void> admitted = scheduler->admit(tag);
+	state bool queued = !admitted.isReady();
+	try {
+		wait(admitted);
+	} catch (Error& e) {
+		if (e.code() != error_code_server_overloaded) throw;
+		self->sendErrorWithPenalty(req.reply, e, self->getPenalty());
+		++self->counters.readsRejected;
+		return Void();
+	}
+
+	try {
+		// A queued read is admitted on the stack of the read that finished before it
+		if (queued) wait(delay(0, TaskPriority::DefaultEndpoint));
+		wait(fun(self, req));
+	} catch (Error& e) {
+		scheduler->finish(tag);
+		throw;
+	}
+	scheduler->finish(tag);
+	return Void();
+}
+
 const StringRef StorageServer::CurrentRunningFetchKeys::emptyString = LiteralStringRef("");
 const KeyRangeRef StorageServer::CurrentRunningFetchKeys::emptyKeyRange = KeyRangeRef(StorageServer::CurrentRunningFetchKeys::emptyString, StorageServer::CurrentRunningFetchKeys::emptyString);
 
@@ -982,12 +1366,14 @@ ACTOR Future<Void> getValueQ( StorageServer* data, GetValueRequest req ) {
 		// Active load balancing runs at a very high priority (to obtain accurate queue lengths)
 		// so we need to downgrade here
 		wait( delay(0, TaskPriority::DefaultEndpoint) );
+		req.markStage(RequestStage::Started);
 
 		if( req.debugID.present() )
 			g_traceBatch.addEvent("GetValueDebug", req.debugID.get().first(), "getValueQ.DoRead"); //.detail("TaskID", g_network->getCurrentTask());
 
 		state Optional<Value> v;
 		state Version version = wait( waitForVersion( data, req.version, req.spanContext ) );
+		req.markStage(RequestStage::VersionReady);
 		if( req.debugID.present() )
 			g_traceBatch.addEvent("GetValueDebug", req.debugID.get().first(), "getValueQ.AfterVersion"); //.detail("TaskID", g_network->getCurrentTask());
 
@@ -1005,13 +1391,15 @@ ACTOR Future<Void> getValueQ( StorageServer* data, GetValueRequest req ) {
 			path = 1;
 		} else if (!i || !i->isClearTo() || i->getEndKey() <= req.key) {
 			path = 2;
+			req.markStage(RequestStage::EngineStarted);
 			Optional<Value> vv = wait( data->storage.readValue( req.key, req.debugID ) );
+			req.markStage(RequestStage::EngineFinished);
 			// Validate that while we were reading the data we didn't lose the version or shard
 			if (version < data->storageVersion()) {
 				TEST(true); // transaction_too_old after readValue
 				throw transaction_too_old();
 			}
-			data->checkChangeCounter(changeCounter, req.key);
+			if (data->shardChangedSince(changeCounter, req.key)) throw wrong_shard_server();
 			v = vv;
 		}
 
@@ -1041,6 +1429,9 @@ ACTOR Future<Void> getValueQ( StorageServer* data, GetValueRequest req ) {
 			                : SERVER_KNOBS->EMPTY_READ_PENALTY;
 			data->metrics.notifyBytesReadPerKSecond(req.key, bytesReadPerKSecond);
 		}
+		if (SERVER_KNOBS->STORAGE_HOT_KEY_SAMPLING) {
+			data->metrics.readHotKeys.sample(req.key);
+		}
 
 		if( req.debugID.present() )
 			g_traceBatch.addEvent("GetValueDebug", req.debugID.get().first(), "getValueQ.AfterRead"); //.detail("TaskID", g_network->getCurrentTask());
@@ -1059,13 +1450,16 @@ ACTOR Future<Void> getValueQ( StorageServer* data, GetValueRequest req ) {
 		data->sendErrorWithPenalty(req.reply, e, data->getPenalty());
 	}
 
-	data->transactionTagCounter.addRequest(req.tags, resultSize);
+	data->addReadCost(req.tags, resultSize);
 
 	++data->counters.finishedQueries;
 	--data->readQueueSizeMetric;
 
+	req.markStage(RequestStage::Replied);
+	data->counters.readStageLatencies.addRequest(req);
 	double duration = g_network->timer() - req.requestTime();
 	data->counters.readLatencySample.addMeasurement(duration);
+	data->recordReadLatency(duration);
 	if(data->latencyBandConfig.present()) {
 		int maxReadBytes = data->latencyBandConfig.get().readConfig.maxReadBytes.orDefault(std::numeric_limits<int>::max());
 		data->counters.readLatencyBands.addMeasurement(duration, resultSize > maxReadBytes);
@@ -1074,11 +1468,271 @@ ACTOR Future<Void> getValueQ( StorageServer* data, GetValueRequest req ) {
 	return Void();
 };
 
+// Like getValueQ for each of several keys at one version.  The keys that are not in the versioned data are read from
+// storage concurrently.
+ACTOR Future<Void> getValuesQ( StorageServer* data, GetValuesRequest req ) {
+	state int64_t resultSize = 0;
+	Span span("SS:getValues"_loc, { req.spanContext });
+
+	try {
+		++data->counters.getValuesQueries;
+		++data->counters.allQueries;
+		++data->readQueueSizeMetric;
+		data->maxQueryQueue = std::max<int>( data->maxQueryQueue, data->counters.allQueries.getValue() - data->counters.finishedQueries.getValue());
+
+		// Active load balancing runs at a very high priority (to obtain accurate queue lengths)
+		// so we need to downgrade here
+		wait( delay(0, TaskPriority::DefaultEndpoint) );
+
+		if( req.debugID.present() )
+			g_traceBatch.addEvent("GetValueDebug", req.debugID.get().first(), "getValuesQ.DoRead");
+
+		state Version version = wait( waitForVersion( data, req.version, req.spanContext ) );
+		if( req.debugID.present() )
+			g_traceBatch.addEvent("GetValueDebug", req.debugID.get().first(), "getValuesQ.AfterVersion");
+
+		state uint64_t changeCounter = data->shardChangeCounter;
+
+		// Values from the versioned data are copied, since it may be forgotten while waiting for the storage reads
+		state Arena valuesArena;
+		state std::vector<Optional<ValueRef>> values(req.keys.size());
+		state std::vector<int> storageKeys;
+		state std::vector<std::pair<KeyRef, int>> storageReadKeys;
+		{
+			auto view = data->data().at(version);
+			for (int k = 0; k < req.keys.size(); k++) {
+				const KeyRef& key = req.keys[k];
+				if (!data->shards[key]->isReadable()) {
+					throw wrong_shard_server();
+				}
+				auto i = view.lastLessOrEqual(key);
+				if (i && i->isValue() && i.key() == key) {
+					values[k] = ValueRef(valuesArena, i->getValue());
+				} else if (!i || !i->isClearTo() || i->getEndKey() <= key) {
+					storageKeys.push_back(k);
+					storageReadKeys.emplace_back(key, -1);
+				}
+			}
+		}
+
+		if (storageReadKeys.size()) {
+			std::vector<Optional<Value>> storageValues = wait(data->storage.readValues(storageReadKeys, req.debugID));
+			// Validate that while we were reading the data we didn't lose the version or shard
+			if (version < data->storageVersion()) {
+				TEST(true); // transaction_too_old after readValue in getValuesQ
+				throw transaction_too_old();
+			}
+			for (int r = 0; r < storageValues.size(); r++) {
+				if (data->shardChangedSince(changeCounter, req.keys[storageKeys[r]])) throw wrong_shard_server();
+				if (storageValues[r].present()) {
+					values[storageKeys[r]] = ValueRef(valuesArena, storageValues[r].get());
+				}
+			}
+		}
+
+		GetValuesReply reply;
+		for (int k = 0; k < req.keys.size(); k++) {
+			const KeyRef& key = req.keys[k];
+			if (values[k].present()) {
+				++data->counters.rowsQueried;
+				resultSize += values[k].get().size();
+				data->counters.bytesQueried += values[k].get().size();
+				reply.data.push_back_deep(reply.arena, KeyValueRef(key, values[k].get()));
+			} else {
+				++data->counters.emptyQueries;
+			}
+
+			if (SERVER_KNOBS->READ_SAMPLING_ENABLED) {
+				// If the read yields no value, randomly sample the empty read.
+				int64_t bytesReadPerKSecond =
+				    values[k].present()
+				        ? std::max((int64_t)(key.size() + values[k].get().size()), SERVER_KNOBS->EMPTY_READ_PENALTY)
+				        : SERVER_KNOBS->EMPTY_READ_PENALTY;
+				data->metrics.notifyBytesReadPerKSecond(key, bytesReadPerKSecond);
+			}
+
+			// Check if the desired key might be cached
+			reply.cached = reply.cached || data->cachedRangeMap[key];
+		}
+
+		if( req.debugID.present() )
+			g_traceBatch.addEvent("GetValueDebug", req.debugID.get().first(), "getValuesQ.AfterRead");
+
+		reply.penalty = data->getPenalty();
+		req.reply.send(reply);
+	} catch (Error& e) {
+		if(!canReplyWith(e))
+			throw;
+		data->sendErrorWithPenalty(req.reply, e, data->getPenalty());
+	}
+
+	data->addReadCost(req.tags, resultSize);
+
+	++data->counters.finishedQueries;
+	--data->readQueueSizeMetric;
+
+	double duration = g_network->timer() - req.requestTime();
+	data->counters.readLatencySample.addMeasurement(duration);
+	data->recordReadLatency(duration);
+	if(data->latencyBandConfig.present()) {
+		int maxReadBytes = data->latencyBandConfig.get().readConfig.maxReadBytes.orDefault(std::numeric_limits<int>::max());
+		data->counters.readLatencyBands.addMeasurement(duration, resultSize > maxReadBytes);
+	}
+
+	return Void();
+}
+
 // Pessimistic estimate the number of overhead bytes used by each
-// watch. Watch key references are stored in an AsyncMap<Key,bool>, and actors
-// must be kept alive until the watch is finished.
+// watch. Watches are registered in a WatchedKey shared by all watches of
+// the key, and actors must be kept alive until the watch is finished.
 static constexpr size_t WATCH_OVERHEAD_BYTES = 1000;
 
+// Fires the watches of a key that were waiting on a value other than the one read at version
+void fireWatchedKey(WatchedKey* watched, Version version, Optional<Value> const& value) {
+	watched->readVersion = version;
+	watched->value = value;
+	std::vector<Promise<Version>> fired;
+	for (auto it = watched->waiters.begin(); it != watched->waiters.end();) {
+		if (it->first != value) {
+			fired.push_back(it->second.first);
+			it = watched->waiters.erase(it);
+		} else {
+			++it;
+		}
+	}
+	// Firing can wake watches that register again, so the waiters are not touched while sending
+	for (auto& p : fired) {
+		p.send(version);
+	}
+}
+
+void removeWatchedKey(StorageServer* data, WatchedKey* watched) {
+	auto it = data->watchedKeys.find(watched->key);
+	if (it != data->watchedKeys.end() && it->second.getPtr() == watched) {
+		data->watchedKeys.erase(it);
+	}
+}
+
+ACTOR Future<Void> watchedKeyLoop(StorageServer* data, WatchedKey* watched) {
+	loop {
+		state Version minVersion = data->data().latestVersion;
+		state Future<Void> watchFuture = data->watches.onChange(watched->key);
+		try {
+			state Version latest = data->version.get();
+			TEST(latest >= minVersion && latest < data->data().latestVersion); // Starting watch loop with latestVersion > data->version
+			GetValueRequest getReq(SpanID(), watched->key, latest, Optional<TagSet>(), Optional<UID>());
+			state Future<Void> getValue = getValueQ( data, getReq ); //we are relying on the delay zero at the top of getValueQ, if removed we need one here
+			GetValueReply reply = wait( getReq.reply.getFuture() );
+			//TraceEvent("WatcherCheckValue").detail("Key",  watched->key  ).detail("CurrentValue",  reply.value  ).detail("Ver", latest);
+
+			if(reply.error.present()) {
+				ASSERT(reply.error.get().code() != error_code_future_version);
+				throw reply.error.get();
+			}
+			if(BUGGIFY) {
+				throw transaction_too_old();
+			}
+
+			DEBUG_MUTATION("ShardWatchValue", latest, MutationRef(MutationRef::DebugKey, watched->key, reply.value.present() ? StringRef( reply.value.get() ) : LiteralStringRef("<null>") ) );
+
+			fireWatchedKey(watched, latest, reply.value);
+			if (watched->waiters.empty()) {
+				return Void();
+			}
+
+			if(latest < minVersion) {
+				// If the version we read is less than minVersion, then we may fail to be notified of any changes that occur up to or including minVersion
+				// To prevent that, we'll check the key again once the version reaches our minVersion
+				watchFuture = watchFuture || data->version.whenAtLeast(minVersion);
+			}
+			if(BUGGIFY) {
+				// Simulate a trigger on the watch that results in the loop going around without the value changing
+				watchFuture = watchFuture || delay(deterministicRandom()->random01());
+			}
+			wait(watchFuture);
+		} catch( Error &e ) {
+			if( e.code() != error_code_transaction_too_old ) {
+				throw;
+			}
+
+			TEST(true); // Reading a watched key failed with transaction_too_old
+		}
+
+		wait(data->version.whenAtLeast(data->data().latestVersion));
+	}
+}
+
+// Runs the watcher of a key until it has no watches left, and passes its errors on to them
+ACTOR Future<Void> watchedKeyWatcher(StorageServer* data, Reference<WatchedKey> watched) {
+	try {
+		choose {
+			when(wait(watchedKeyLoop(data, watched.getPtr()))) {}
+			when(wait(watched->stop.getFuture())) {}
+		}
+		removeWatchedKey(data, watched.getPtr());
+	} catch (Error& e) {
+		if (e.code() == error_code_actor_cancelled) {
+			throw;
+		}
+		removeWatchedKey(data, watched.getPtr());
+		std::map<Optional<Value>, std::pair<Promise<Version>, int>> waiters;
+		waiters.swap(watched->waiters);
+		for (auto& w : waiters) {
+			w.second.first.sendError(e);
+		}
+	}
+	return Void();
+}
+
+// Waits, as one of the watches of key, until the key stops having value.  Returns the version the watcher read a
+// different value at, which is before readVersion if the watcher had not yet caught up with the read of this watch.
+ACTOR Future<Version> watchKey(StorageServer* data, Key key, Optional<Value> value, Version readVersion) {
+	state Reference<WatchedKey> watched;
+	state bool started = false;
+	auto it = data->watchedKeys.find(key);
+	if (it == data->watchedKeys.end()) {
+		watched = makeReference<WatchedKey>(key, readVersion, value);
+		data->watchedKeys[key] = watched;
+		started = true;
+	} else {
+		watched = it->second;
+		if (watched->readVersion >= readVersion && watched->value != value) {
+			TEST(true); // Watched key already changed since this watch read it
+			return watched->readVersion;
+		}
+	}
+
+	auto& waiter = watched->waiters[value];
+	++waiter.second;
+	state Future<Version> changed = waiter.first.getFuture();
+	if (started) {
+		data->actors.add(watchedKeyWatcher(data, watched));
+	}
+
+	++data->numWatches;
+	data->watchBytes += (key.expectedSize() + value.expectedSize() + WATCH_OVERHEAD_BYTES);
+	try {
+		Version version = wait(changed);
+		--data->numWatches;
+		data->watchBytes -= (key.expectedSize() + value.expectedSize() + WATCH_OVERHEAD_BYTES);
+		return version;
+	} catch (Error& e) {
+		--data->numWatches;
+		data->watchBytes -= (key.expectedSize() + value.expectedSize() + WATCH_OVERHEAD_BYTES);
+		if (e.code() == error_code_actor_cancelled) {
+			auto w = watched->waiters.find(value);
+			if (w != watched->waiters.end() && --w->second.second == 0) {
+				watched->waiters.erase(w);
+				if (watched->waiters.empty()) {
+					removeWatchedKey(data, watched.getPtr());
+					watched->stop.send(Void());
+				}
+			}
+		}
+		throw;
+	}
+}
+
 ACTOR Future<Void> watchValue_impl( StorageServer* data, WatchValueRequest req, SpanID parent ) {
 	state Location spanLocation = "SS:WatchValueImpl"_loc;
 	state Span span(spanLocation, { parent });
@@ -1092,17 +1746,13 @@ ACTOR Future<Void> watchValue_impl( StorageServer* data, WatchValueRequest req,
 		if( req.debugID.present() )
 			g_traceBatch.addEvent("WatchValueDebug", req.debugID.get().first(), "watchValueQ.AfterVersion"); //.detail("TaskID", g_network->getCurrentTask());
 
-		state Version minVersion = data->data().latestVersion;
-		state Future<Void> watchFuture = data->watches.onChange(req.key);
 		loop {
 			try {
 				state Version latest = data->version.get();
-				TEST(latest >= minVersion && latest < data->data().latestVersion); // Starting watch loop with latestVersion > data->version
 				GetValueRequest getReq( span.context, req.key, latest, req.tags, req.debugID );
 				state Future<Void> getValue = getValueQ( data, getReq ); //we are relying on the delay zero at the top of getValueQ, if removed we need one here
 				GetValueReply reply = wait( getReq.reply.getFuture() );
 				span = Span(spanLocation, parent);
-				//TraceEvent("WatcherCheckValue").detail("Key",  req.key  ).detail("Value",  req.value  ).detail("CurrentValue",  v  ).detail("Ver", latest);
 
 				if(reply.error.present()) {
 					ASSERT(reply.error.get().code() != error_code_future_version);
@@ -1111,8 +1761,6 @@ ACTOR Future<Void> watchValue_impl( StorageServer* data, WatchValueRequest req,
 				if(BUGGIFY) {
 					throw transaction_too_old();
 				}
-				
-				DEBUG_MUTATION("ShardWatchValue", latest, MutationRef(MutationRef::DebugKey, req.key, reply.value.present() ? StringRef( reply.value.get() ) : LiteralStringRef("<null>") ) );
 
 				if( req.debugID.present() )
 					g_traceBatch.addEvent("WatchValueDebug", req.debugID.get().first(), "watchValueQ.AfterRead"); //.detail("TaskID", g_network->getCurrentTask());
@@ -1128,26 +1776,13 @@ ACTOR Future<Void> watchValue_impl( StorageServer* data, WatchValueRequest req,
 					return Void();
 				}
 
-				++data->numWatches;
-				data->watchBytes += (req.key.expectedSize() + req.value.expectedSize() + WATCH_OVERHEAD_BYTES);
-				try {
-					if(latest < minVersion) {
-						// If the version we read is less than minVersion, then we may fail to be notified of any changes that occur up to or including minVersion
-						// To prevent that, we'll check the key again once the version reaches our minVersion
-						watchFuture = watchFuture || data->version.whenAtLeast(minVersion);
-					}
-					if(BUGGIFY) {
-						// Simulate a trigger on the watch that results in the loop going around without the value changing
-						watchFuture = watchFuture || delay(deterministicRandom()->random01());
-					}
-					wait(watchFuture);
-					--data->numWatches;
-					data->watchBytes -= (req.key.expectedSize() + req.value.expectedSize() + WATCH_OVERHEAD_BYTES);
-				} catch( Error &e ) {
-					--data->numWatches;
-					data->watchBytes -= (req.key.expectedSize() + req.value.expectedSize() + WATCH_OVERHEAD_BYTES);
-					throw;
+				Version changed = wait(watchKey(data, req.key, req.value, latest));
+				if (changed > latest) {
+					req.reply.send(WatchValueReply{ changed });
+					return Void();
 				}
+				// The shared watcher read the key before this watch did, so its value may have changed back since
+				TEST(true); // Watched key changed before the version this watch read it at
 			} catch( Error &e ) {
 				if( e.code() != error_code_transaction_too_old ) {
 					throw;
@@ -1156,7 +1791,6 @@ ACTOR Future<Void> watchValue_impl( StorageServer* data, WatchValueRequest req,
 				TEST(true); // Reading a watched key failed with transaction_too_old
 			}
 
-			watchFuture = data->watches.onChange(req.key);
 			wait(data->version.whenAtLeast(data->data().latestVersion));
 		}
 	} catch (Error& e) {
@@ -1237,6 +1871,8 @@ void merge( Arena& arena, VectorRef<KeyValueRef, VecSerStrategy::String>& output
 			int& vCount, int limit, bool stopAtEndOfBase, int& pos, int limitBytes = 1<<30 )
 // Combines data from base (at an older version) with sets from newer versions in [start, end) and appends the first (up to) |limit| rows to output
 // If limit<0, base and output are in descending order, and start->key()>end->key(), but start is still inclusive and end is exclusive
+// Rows from base are not copied, so arena must already depend on base's memory.  Rows from vm_output point into
+// versionedData, which may be freed once the version is forgotten, so they are.
 {
 	ASSERT(limit != 0);
 
@@ -1248,7 +1884,7 @@ void merge( Arena& arena, VectorRef<KeyValueRef, VecSerStrategy::String>& output
 	KeyValueRef const* baseEnd = base.end();
 	while (baseStart!=baseEnd && vCount>0 && output.size() < adjustedLimit && accumulatedBytes < limitBytes) {
 		if (forward ? baseStart->key < vm_output[pos].key : baseStart->key > vm_output[pos].key) {
-			output.push_back_deep( arena, *baseStart++ );
+			output.push_back( arena, *baseStart++ );
 		}
 		else {
 			output.push_back_deep( arena, vm_output[pos]);
@@ -1259,7 +1895,7 @@ void merge( Arena& arena, VectorRef<KeyValueRef, VecSerStrategy::String>& output
 		accumulatedBytes += sizeof(KeyValueRef) + output.end()[-1].expectedSize();
 	}
 	while (baseStart!=baseEnd && output.size() < adjustedLimit && accumulatedBytes < limitBytes) {
-		output.push_back_deep( arena, *baseStart++ );
+		output.push_back( arena, *baseStart++ );
 		accumulatedBytes += sizeof(KeyValueRef) + output.end()[-1].expectedSize();
 	}
 	if( !stopAtEndOfBase ) {
@@ -1344,6 +1980,7 @@ ACTOR Future<GetKeyValuesReply> readRange( StorageServer* data, Version version,
 
 			ASSERT( atStorageVersion.size() <= limit );
 			if (data->storageVersion() > version) throw transaction_too_old();
+			result.arena.dependsOn( atStorageVersion.arena() );
 
 			// merge the sets in resultCache with the sets on disk, stopping at the last key from disk if there is 'more'
 			int prevSize = result.data.size();
@@ -1414,6 +2051,7 @@ ACTOR Future<GetKeyValuesReply> readRange( StorageServer* data, Version version,
 
 			ASSERT(atStorageVersion.size() <= -limit);
 			if (data->storageVersion() > version) throw transaction_too_old();
+			result.arena.dependsOn(atStorageVersion.arena());
 
 			int prevSize = result.data.size();
 			merge( result.arena, result.data, resultCache,
@@ -1449,30 +2087,198 @@ ACTOR Future<GetKeyValuesReply> readRange( StorageServer* data, Version version,
 	return result;
 }
 
-//bool selectorInRange( KeySelectorRef const& sel, KeyRangeRef const& range ) {
-	// Returns true if the given range suffices to at least begin to resolve the given KeySelectorRef
-//	return sel.getKey() >= range.begin && (sel.isBackward() ? sel.getKey() <= range.end : sel.getKey() < range.end);
-//}
+// Like IKeyValueStore::skipKeys, but of the data at version: returns the nth key of range counting forward from
+// range.begin if n > 0 or backward from range.end if n < 0, or how many keys range has if fewer than |n|.  The gaps
+// between the MVCC entries in range are counted by the storage engine, so the cost is O(MVCC entries in range) rather
+// than O(|n|).  Requires storage.canSkipKeys().
+ACTOR Future<SkippedKeys> skipKeys(StorageServer* data, Version version, KeyRange range, int64_t n) {
+	state StorageServer::VersionedData::ViewAtVersion view = data->data().at(version);
+	state StorageServer::VersionedData::iterator vCurrent = view.end();
+	state KeyRef readBegin;
+	state KeyRef readEnd;
+	state Key readTemp;
+	state int64_t distance = std::abs(n);
+	state int64_t count = 0;
 
-ACTOR Future<Key> findKey( StorageServer* data, KeySelectorRef sel, Version version, KeyRange range, int* pOffset, SpanID parentSpan)
-// Attempts to find the key indicated by sel in the data at version, within range.
-// Precondition: selectorInRange(sel, range)
-// If it is found, offset is set to 0 and a key is returned which falls inside range.
-// If the search would depend on any key outside range OR if the key selector offset is too large (range read returns too many bytes), it returns either
-//   a negative offset and a key in [range.begin, sel.getKey()], indicating the key is (the first key <= returned key) + offset, or
-//   a positive offset and a key in (sel.getKey(), range.end], indicating the key is (the first key >= returned key) + offset-1
-// The range passed in to this function should specify a shard.  If range.begin is repeatedly not the beginning of a shard, then it is possible to get stuck looping here
-{
-	ASSERT( version != latestVersion );
-	ASSERT( selectorInRange(sel, range) && version >= data->oldestVersion.get() );
+	if (n == 0) {
+		return SkippedKeys();
+	}
 
-	// Count forward or backward distance items, skipping the first one if it == key and skipEqualKey
-	state bool forward = sel.offset > 0;                  // If forward, result >= sel.getKey(); else result <= sel.getKey()
-	state int sign = forward ? +1 : -1;
-	state bool skipEqualKey = sel.orEqual == forward;
+	if (n > 0) {
+		vCurrent = view.lastLessOrEqual(range.begin);
+		if (vCurrent && vCurrent->isClearTo() && vCurrent->getEndKey() > range.begin)
+			readBegin = vCurrent->getEndKey();
+		else
+			readBegin = range.begin;
+
+		vCurrent = view.lower_bound(readBegin);
+
+		loop {
+			// Count the keys on disk up to vCurrent (or the end of the range)
+			readEnd = vCurrent ? std::min(vCurrent.key(), range.end) : range.end;
+			if (readBegin < readEnd) {
+				SkippedKeys skipped = wait(data->storage.skipKeys(KeyRangeRef(readBegin, readEnd), distance - count));
+				if (data->storageVersion() > version) throw transaction_too_old();
+				count += skipped.count;
+				if (skipped.key.present()) {
+					return SkippedKeys(skipped.key, count);
+				}
+			}
+
+			if (!vCurrent || vCurrent.key() >= range.end) {
+				break;
+			}
+			if (vCurrent->isClearTo()) {
+				readBegin = vCurrent->getEndKey();
+			} else {
+				if (++count == distance) {
+					return SkippedKeys(Key(vCurrent.key()), count);
+				}
+				readBegin = readTemp = keyAfter(vCurrent.key());
+			}
+			++vCurrent;
+		}
+	} else {
+		vCurrent = view.lastLess(range.end);
+		if (vCurrent && vCurrent->isClearTo() && vCurrent->getEndKey() >= range.end) {
+			readEnd = vCurrent.key();
+			--vCurrent;
+		} else {
+			readEnd = range.end;
+		}
+
+		loop {
+			// Count the keys on disk back to vCurrent (or the beginning of the range)
+			if (!vCurrent) {
+				readBegin = range.begin;
+			} else if (vCurrent->isClearTo()) {
+				readBegin = std::max(vCurrent->getEndKey(), range.begin);
+			} else {
+				readTemp = keyAfter(vCurrent.key());
+				readBegin = std::max<KeyRef>(readTemp, range.begin);
+			}
+			if (readBegin < readEnd) {
+				SkippedKeys skipped =
+				    wait(data->storage.skipKeys(KeyRangeRef(readBegin, readEnd), -(distance - count)));
+				if (data->storageVersion() > version) throw transaction_too_old();
+				count += skipped.count;
+				if (skipped.key.present()) {
+					return SkippedKeys(skipped.key, count);
+				}
+			}
+
+			if (!vCurrent || vCurrent.key() < range.begin) {
+				break;
+			}
+			if (!vCurrent->isClearTo() && ++count == distance) {
+				return SkippedKeys(Key(vCurrent.key()), count);
+			}
+			readEnd = vCurrent.key();
+			--vCurrent;
+		}
+	}
+
+	return SkippedKeys(Optional<Key>(), count);
+}
+
+// Like readRange, but returns only the rows that match filter, and limit and *pLimitBytes count only those. The range
+// is read in pages, and once RANGE_FILTER_SCAN_BYTES have been scanned the rows found so far are returned with
+// readThrough set to where the scan stopped, so that a filter that matches little does not hold a read open too long.
+ACTOR Future<GetKeyValuesReply> readRangeFiltered(StorageServer* data, Version version, KeyRange range, int limit,
+                                                  int* pLimitBytes, RangeReadFilterRef filter, SpanID parentSpan) {
+	state GetKeyValuesReply result;
+	state KeyRange remaining = range;
+	state int64_t scannedBytes = 0;
+	state bool reverse = limit < 0;
+	state int limitRows = std::abs(limit);
+
+	result.version = version;
+	loop {
+		state int pageBytes = SERVER_KNOBS->RANGESTREAM_PAGE_BYTES;
+		GetKeyValuesReply page = wait(readRange(data, version, remaining,
+		                                        reverse ? -std::numeric_limits<int>::max()
+		                                                : std::numeric_limits<int>::max(),
+		                                        &pageBytes, parentSpan));
+		result.cached = page.cached;
+		for (auto const& kv : page.data) {
+			scannedBytes += kv.expectedSize();
+			if (filter.matches(kv)) {
+				KeyValueRef projected(kv.key, filter.project(kv.value));
+				result.data.push_back_deep(result.arena, projected);
+				*pLimitBytes -= sizeof(KeyValueRef) + projected.expectedSize();
+				if (--limitRows == 0 || *pLimitBytes <= 0) {
+					result.more = true;
+					return result;
+				}
+			}
+		}
+		if (!page.more || page.data.empty()) {
+			result.more = false;
+			return result;
+		}
+
+		KeyRef last = page.data.back().key;
+		remaining = reverse ? KeyRangeRef(remaining.begin, last) : KeyRangeRef(keyAfter(last), remaining.end);
+		if (remaining.empty()) {
+			result.more = false;
+			return result;
+		}
+		if (scannedBytes >= SERVER_KNOBS->RANGE_FILTER_SCAN_BYTES) {
+			result.more = true;
+			result.readThrough = KeyRef(result.arena, reverse ? remaining.end : remaining.begin);
+			return result;
+		}
+		wait(yield());
+	}
+}
+
+//bool selectorInRange( KeySelectorRef const& sel, KeyRangeRef const& range ) {
+	// Returns true if the given range suffices to at least begin to resolve the given KeySelectorRef
+//	return sel.getKey() >= range.begin && (sel.isBackward() ? sel.getKey() <= range.end : sel.getKey() < range.end);
+//}
+
+ACTOR Future<Key> findKey( StorageServer* data, KeySelectorRef sel, Version version, KeyRange range, int* pOffset, SpanID parentSpan)
+// Attempts to find the key indicated by sel in the data at version, within range.
+// Precondition: selectorInRange(sel, range)
+// If it is found, offset is set to 0 and a key is returned which falls inside range.
+// If the search would depend on any key outside range OR if the key selector offset is too large (range read returns too many bytes), it returns either
+//   a negative offset and a key in [range.begin, sel.getKey()], indicating the key is (the first key <= returned key) + offset, or
+//   a positive offset and a key in (sel.getKey(), range.end], indicating the key is (the first key >= returned key) + offset-1
+// The range passed in to this function should specify a shard.  If range.begin is repeatedly not the beginning of a shard, then it is possible to get stuck looping here
+{
+	ASSERT( version != latestVersion );
+	ASSERT( selectorInRange(sel, range) && version >= data->oldestVersion.get() );
+
+	// Count forward or backward distance items, skipping the first one if it == key and skipEqualKey
+	state bool forward = sel.offset > 0;                  // If forward, result >= sel.getKey(); else result <= sel.getKey()
+	state int sign = forward ? +1 : -1;
+	state bool skipEqualKey = sel.orEqual == forward;
 	state int distance = forward ? sel.offset : 1-sel.offset;
 	state Span span("SS.findKey"_loc, { parentSpan });
 
+	// Far from its key, a selector is resolved by counting rather than reading the keys it passes over
+	if (distance >= SERVER_KNOBS->STORAGE_SKIP_KEYS_MIN_OFFSET && data->storage.canSkipKeys()) {
+		SkippedKeys skipped = wait(skipKeys(
+		    data, version,
+		    forward ? KeyRangeRef(skipEqualKey ? keyAfter(sel.getKey()) : sel.getKey(), range.end)
+		            : KeyRangeRef(range.begin, skipEqualKey ? sel.getKey() : keyAfter(sel.getKey())),
+		    distance * sign));
+
+		if (SERVER_KNOBS->READ_SAMPLING_ENABLED) {
+			int64_t bytesReadPerKSecond =
+			    skipped.key.present() ? std::max((int64_t)skipped.key.get().size(), SERVER_KNOBS->EMPTY_READ_PENALTY)
+			                          : SERVER_KNOBS->EMPTY_READ_PENALTY;
+			data->metrics.notifyBytesReadPerKSecond(sel.getKey(), bytesReadPerKSecond);
+		}
+
+		if (skipped.key.present()) {
+			*pOffset = 0;
+			return skipped.key.get();
+		}
+		*pOffset = (int)(distance - skipped.count) * sign;
+		return forward ? range.end : range.begin;
+	}
+
 	//Don't limit the number of bytes if this is a trivial key selector (there will be at most two items returned from the read range in this case)
 	state int maxBytes;
 	if (sel.offset <= 1 && sel.offset >= 0)
@@ -1538,14 +2344,99 @@ ACTOR Future<Key> findKey( StorageServer* data, KeySelectorRef sel, Version vers
 }
 
 KeyRange getShardKeyRange( StorageServer* data, const KeySelectorRef& sel )
-// Returns largest range such that the shard state isReadable and selectorInRange(sel, range) or wrong_shard_server if no such range exists
+// Returns largest range such that the shard state isReadable and selectorInRange(sel, range), or an empty range if no such
+// range exists, for which the caller throws wrong_shard_server
 {
 	auto i = sel.isBackward() ? data->shards.rangeContainingKeyBefore( sel.getKey() ) : data->shards.rangeContaining( sel.getKey() );
-	if (!i->value()->isReadable()) throw wrong_shard_server();
+	if (!i->value()->isReadable()) return KeyRange();
 	ASSERT( selectorInRange(sel, i->range()) );
 	return i->range();
 }
 
+// A range read older than the MVCC window can still be answered if the storage engine retained a snapshot at exactly
+// its version and every key it covers has been readable here since then.  Only plain key ranges are read this way.
+bool canReadFromSnapshot(StorageServer* data, GetKeyValuesRequest const& req) {
+	return req.version != latestVersion && req.version < data->oldestVersion.get() && !req.filter.present() &&
+	       req.begin.isFirstGreaterOrEqual() && req.end.isFirstGreaterOrEqual() && data->storage.hasSnapshot(req.version);
+}
+
+bool readableAtSnapshot(StorageServer* data, KeyRangeRef keys, Version version) {
+	auto ranges = data->readableSince.intersectingRanges(keys);
+	for (auto r = ranges.begin(); r != ranges.end(); ++r) {
+		if (r->value() == invalidVersion || r->value() > version) {
+			return false;
+		}
+	}
+	return true;
+}
+
+ACTOR Future<Void> getKeyValuesAtSnapshotQ(StorageServer* data, GetKeyValuesRequest req) {
+	state Span span("SS:getKeyValuesAtSnapshot"_loc, { req.spanContext });
+	state int64_t resultSize = 0;
+
+	++data->counters.getRangeQueries;
+	++data->counters.snapshotRangeQueries;
+	++data->counters.allQueries;
+	++data->readQueueSizeMetric;
+	data->maxQueryQueue = std::max<int>( data->maxQueryQueue, data->counters.allQueries.getValue() - data->counters.finishedQueries.getValue());
+
+	wait(delay(0, TaskPriority::DefaultEndpoint));
+	req.markStage(RequestStage::Started);
+
+	try {
+		KeyRange shard = getShardKeyRange(data, req.begin);
+		if (shard.empty()) throw wrong_shard_server();
+		state KeyRange keys = KeyRangeRef(req.begin.getKey(), std::max(req.begin.getKey(), req.end.getKey()));
+		if (keys.end > shard.end) {
+			throw wrong_shard_server();
+		}
+		if (!readableAtSnapshot(data, keys, req.version)) {
+			throw transaction_too_old();
+		}
+		req.markStage(RequestStage::VersionReady);
+
+		state uint64_t changeCounter = data->shardChangeCounter;
+		state GetKeyValuesReply reply;
+		if (!keys.empty()) {
+			req.markStage(RequestStage::EngineStarted);
+			Standalone<RangeResultRef> rows =
+			    wait(data->storage.readRangeAtSnapshot(keys, req.version, req.limit, req.limitBytes));
+			req.markStage(RequestStage::EngineFinished);
+			reply.arena.dependsOn(rows.arena());
+			reply.data.append(reply.arena, rows.begin(), rows.size());
+			reply.more = rows.more;
+		}
+		if (data->shardChangedSince(changeCounter, keys)) throw wrong_shard_server();
+		reply.version = req.version;
+		reply.penalty = data->getPenalty();
+		req.reply.send(reply);
+
+		for (auto& kv : reply.data) {
+			resultSize += kv.expectedSize();
+		}
+		data->counters.bytesQueried += resultSize;
+		data->counters.rowsQueried += reply.data.size();
+		if (reply.data.size() == 0) {
+			++data->counters.emptyQueries;
+		}
+	} catch (Error& e) {
+		if (!canReplyWith(e))
+			throw;
+		data->sendErrorWithPenalty(req.reply, e, data->getPenalty());
+	}
+
+	data->addReadCost(req.tags, resultSize);
+	++data->counters.finishedQueries;
+	--data->readQueueSizeMetric;
+
+	req.markStage(RequestStage::Replied);
+	data->counters.readStageLatencies.addRequest(req);
+	double duration = g_network->timer() - req.requestTime();
+	data->counters.readLatencySample.addMeasurement(duration);
+	data->recordReadLatency(duration);
+	return Void();
+}
+
 ACTOR Future<Void> getKeyValuesQ( StorageServer* data, GetKeyValuesRequest req )
 // Throws a wrong_shard_server if the keys in the request or result depend on data outside this server OR if a large selector offset prevents
 // all data from being read in one range read
@@ -1568,15 +2459,18 @@ ACTOR Future<Void> getKeyValuesQ( StorageServer* data, GetKeyValuesRequest req )
 	} else {
 		wait( delay(0, TaskPriority::DefaultEndpoint) );
 	}
+	req.markStage(RequestStage::Started);
 	
 	try {
 		if( req.debugID.present() )
 			g_traceBatch.addEvent("TransactionDebug", req.debugID.get().first(), "storageserver.getKeyValues.Before");
 		state Version version = wait( waitForVersion( data, req.version, span.context ) );
+		req.markStage(RequestStage::VersionReady);
 
 		state uint64_t changeCounter = data->shardChangeCounter;
 //		try {
 		state KeyRange shard = getShardKeyRange( data, req.begin );
+		if (shard.empty()) throw wrong_shard_server();
 
 		if( req.debugID.present() )
 			g_traceBatch.addEvent("TransactionDebug", req.debugID.get().first(), "storageserver.getKeyValues.AfterVersion");
@@ -1588,6 +2482,8 @@ ACTOR Future<Void> getKeyValuesQ( StorageServer* data, GetKeyValuesRequest req )
 			throw wrong_shard_server();
 		}
 
+		// Resolving the selectors and reading the range both go to the engine for whatever isn't in memory
+		req.markStage(RequestStage::EngineStarted);
 		state int offset1;
 		state int offset2;
 		state Future<Key> fBegin = req.begin.isFirstGreaterOrEqual()
@@ -1624,72 +2520,511 @@ ACTOR Future<Void> getKeyValuesQ( StorageServer* data, GetKeyValuesRequest req )
 			none.more = false;
 			none.penalty = data->getPenalty();
 
-			data->checkChangeCounter( changeCounter, KeyRangeRef( std::min<KeyRef>(req.begin.getKey(), req.end.getKey()), std::max<KeyRef>(req.begin.getKey(), req.end.getKey()) ) );
+			if (data->shardChangedSince(changeCounter, KeyRangeRef( std::min<KeyRef>(req.begin.getKey(), req.end.getKey()), std::max<KeyRef>(req.begin.getKey(), req.end.getKey()) ))) throw wrong_shard_server();
 			req.reply.send( none );
 		} else {
 			state int remainingLimitBytes = req.limitBytes;
 
-			GetKeyValuesReply _r = wait( readRange(data, version, KeyRangeRef(begin, end), req.limit, &remainingLimitBytes, span.context) );
-			GetKeyValuesReply r = _r;
+			state Future<GetKeyValuesReply> fRead =
+			    req.filter.present() ? readRangeFiltered(data, version, KeyRangeRef(begin, end), req.limit,
+			                                             &remainingLimitBytes, req.filter.get(), span.context)
+			                         : readRange(data, version, KeyRangeRef(begin, end), req.limit,
+			                                     &remainingLimitBytes, span.context);
+			GetKeyValuesReply _r = wait(fRead);
+			GetKeyValuesReply r = _r;
+			req.markStage(RequestStage::EngineFinished);
+
+			if( req.debugID.present() )
+				g_traceBatch.addEvent("TransactionDebug", req.debugID.get().first(), "storageserver.getKeyValues.AfterReadRange");
+			//.detail("Begin",begin).detail("End",end).detail("SizeOf",r.data.size());
+			if (data->shardChangedSince(changeCounter, KeyRangeRef( std::min<KeyRef>(begin, std::min<KeyRef>(req.begin.getKey(), req.end.getKey())), std::max<KeyRef>(end, std::max<KeyRef>(req.begin.getKey(), req.end.getKey())) ))) throw wrong_shard_server();
+			if (EXPENSIVE_VALIDATION) {
+				for (int i = 0; i < r.data.size(); i++)
+					ASSERT(r.data[i].key >= begin && r.data[i].key < end);
+				ASSERT(r.data.size() <= std::abs(req.limit));
+			}
+
+			/*for( int i = 0; i < r.data.size(); i++ ) {
+				StorageMetrics m;
+				m.bytesPerKSecond = r.data[i].expectedSize();
+				m.iosPerKSecond = 1; //FIXME: this should be 1/r.data.size(), but we cannot do that because it is an int
+				data->metrics.notify(r.data[i].key, m);
+			}*/
+
+			// For performance concerns, the cost of a range read is billed to the start key and end key of the range.
+			int64_t totalByteSize = 0;
+			for (int i = 0; i < r.data.size(); i++) {
+				totalByteSize += r.data[i].expectedSize();
+			}
+			if (totalByteSize > 0 && SERVER_KNOBS->READ_SAMPLING_ENABLED) {
+				int64_t bytesReadPerKSecond = std::max(totalByteSize, SERVER_KNOBS->EMPTY_READ_PENALTY) / 2;
+				data->metrics.notifyBytesReadPerKSecond(r.data[0].key, bytesReadPerKSecond);
+				data->metrics.notifyBytesReadPerKSecond(r.data[r.data.size() - 1].key, bytesReadPerKSecond);
+			}
+			if (SERVER_KNOBS->STORAGE_HOT_KEY_SAMPLING) {
+				for (int i = 0; i < r.data.size(); i++) {
+					data->metrics.readHotKeys.sample(r.data[i].key);
+				}
+			}
+
+			r.penalty = data->getPenalty();
+			req.reply.send( r );
+
+			resultSize = req.limitBytes - remainingLimitBytes;
+			data->counters.bytesQueried += resultSize;
+			data->counters.rowsQueried += r.data.size();
+			if(r.data.size() == 0) {
+				++data->counters.emptyQueries;
+			}
+		}
+	} catch (Error& e) {
+		if(!canReplyWith(e))
+			throw;
+		data->sendErrorWithPenalty(req.reply, e, data->getPenalty());
+	}
+
+	data->addReadCost(req.tags, resultSize);
+	++data->counters.finishedQueries;
+	--data->readQueueSizeMetric;
+
+	req.markStage(RequestStage::Replied);
+	data->counters.readStageLatencies.addRequest(req);
+	double duration = g_network->timer() - req.requestTime();
+	data->counters.readLatencySample.addMeasurement(duration);
+	data->recordReadLatency(duration);
+	if(data->latencyBandConfig.present()) {
+		int maxReadBytes = data->latencyBandConfig.get().readConfig.maxReadBytes.orDefault(std::numeric_limits<int>::max());
+		int maxSelectorOffset = data->latencyBandConfig.get().readConfig.maxKeySelectorOffset.orDefault(std::numeric_limits<int>::max());
+		data->counters.readLatencyBands.addMeasurement(
+		    duration, resultSize > maxReadBytes || abs(req.begin.offset) > maxSelectorOffset ||
+		                                     abs(req.end.offset) > maxSelectorOffset);
+	}
+
+	return Void();
+}
+
+ACTOR Future<Void> getKeyValuesStreamQ( StorageServer* data, GetKeyValuesStreamRequest req )
+// Like getKeyValuesQ, but instead of stopping at one reply's worth it sends the whole range (up to the request's limits)
+// in pages of RANGESTREAM_PAGE_BYTES, all read at the same version, and waits for the client to consume them whenever
+// RANGESTREAM_LIMIT_BYTES are outstanding.  The stream ends with end_of_stream after the page with more == false.
+{
+	state Span span("SS:getKeyValuesStream"_loc, { req.spanContext });
+	state int64_t resultSize = 0;
+
+	req.reply.setByteLimit(SERVER_KNOBS->RANGESTREAM_LIMIT_BYTES);
+	++data->counters.getRangeStreamQueries;
+	++data->counters.allQueries;
+	++data->readQueueSizeMetric;
+	data->maxQueryQueue = std::max<int>( data->maxQueryQueue, data->counters.allQueries.getValue() - data->counters.finishedQueries.getValue());
+
+	// Received at a very high priority, so downgrade before doing real work
+	wait( delay(0, TaskPriority::DefaultEndpoint) );
+
+	try {
+		if( req.debugID.present() )
+			g_traceBatch.addEvent("TransactionDebug", req.debugID.get().first(), "storageserver.getKeyValuesStream.Before");
+		state Version version = wait( waitForVersion( data, req.version, span.context ) );
+
+		state uint64_t changeCounter = data->shardChangeCounter;
+		state KeyRange shard = getShardKeyRange( data, req.begin );
+		if (shard.empty()) throw wrong_shard_server();
+
+		if ( !selectorInRange(req.end, shard) && !(req.end.isFirstGreaterOrEqual() && req.end.getKey() == shard.end) ) {
+			throw wrong_shard_server();
+		}
+
+		state int offset1;
+		state int offset2;
+		state Future<Key> fBegin = req.begin.isFirstGreaterOrEqual()
+		                               ? Future<Key>(req.begin.getKey())
+		                               : findKey(data, req.begin, version, shard, &offset1, span.context);
+		state Future<Key> fEnd = req.end.isFirstGreaterOrEqual()
+		                             ? Future<Key>(req.end.getKey())
+		                             : findKey(data, req.end, version, shard, &offset2, span.context);
+		state Key begin = wait(fBegin);
+		state Key end = wait(fEnd);
+
+		// See getKeyValuesQ
+		if ((offset1 && offset1!=1) || (offset2 && offset2!=1)) {
+			TEST(true); // wrong_shard_server due to offset in getKeyValuesStreamQ
+			throw wrong_shard_server();
+		}
+
+		// The keys whose shard assignment the result depends on
+		state KeyRange readKeys = KeyRangeRef( std::min<KeyRef>(begin, std::min<KeyRef>(req.begin.getKey(), req.end.getKey())),
+		                                       std::max<KeyRef>(end, std::max<KeyRef>(req.begin.getKey(), req.end.getKey())) );
+		state int remainingLimit = req.limit;
+		state int remainingLimitBytes = req.limitBytes;
+		loop {
+			wait( req.reply.onReady() );
+			// Each page has to be readable at the version the stream started with
+			if (version < data->oldestVersion.get()) {
+				throw transaction_too_old();
+			}
+
+			state GetKeyValuesStreamReply page;
+			if (begin >= end) {
+				page = GetKeyValuesStreamReply();
+				page.version = version;
+				page.more = false;
+			} else {
+				state int pageBytes = std::min(remainingLimitBytes, SERVER_KNOBS->RANGESTREAM_PAGE_BYTES);
+				state int pageBytesLeft = pageBytes;
+				GetKeyValuesReply r = wait( readRange(data, version, KeyRangeRef(begin, end), remainingLimit, &pageBytesLeft, span.context) );
+				page = GetKeyValuesStreamReply(r);
+
+				int64_t totalByteSize = 0;
+				for (int i = 0; i < page.data.size(); i++) {
+					totalByteSize += page.data[i].expectedSize();
+				}
+				if (totalByteSize > 0 && SERVER_KNOBS->READ_SAMPLING_ENABLED) {
+					int64_t bytesReadPerKSecond = std::max(totalByteSize, SERVER_KNOBS->EMPTY_READ_PENALTY) / 2;
+					data->metrics.notifyBytesReadPerKSecond(page.data[0].key, bytesReadPerKSecond);
+					data->metrics.notifyBytesReadPerKSecond(page.data[page.data.size() - 1].key, bytesReadPerKSecond);
+				}
+				if (SERVER_KNOBS->STORAGE_HOT_KEY_SAMPLING) {
+					for (int i = 0; i < page.data.size(); i++) {
+						data->metrics.readHotKeys.sample(page.data[i].key);
+					}
+				}
+
+				remainingLimit -= remainingLimit > 0 ? page.data.size() : -page.data.size();
+				remainingLimitBytes -= pageBytes - pageBytesLeft;
+				resultSize += pageBytes - pageBytesLeft;
+				data->counters.bytesQueried += pageBytes - pageBytesLeft;
+			}
+			if (data->shardChangedSince(changeCounter, readKeys)) throw wrong_shard_server();
+
+			data->counters.rowsQueried += page.data.size();
+			if(page.data.size() == 0) {
+				++data->counters.emptyQueries;
+			}
+
+			// A page that stopped short only because of the page size is followed by the next one
+			bool last = !page.more || remainingLimit == 0 || remainingLimitBytes <= 0;
+			if (!last) {
+				ASSERT(page.data.size());
+				if (remainingLimit > 0) {
+					begin = keyAfter(page.data.back().key);
+				} else {
+					end = page.data.back().key;
+				}
+			}
+
+			req.reply.send( page );
+			if (last) {
+				req.reply.sendError( end_of_stream() );
+				break;
+			}
+			wait( yield() );
+		}
+	} catch (Error& e) {
+		// operation_obsolete means the client is gone
+		if (e.code() != error_code_operation_obsolete) {
+			if(!canReplyWith(e))
+				throw;
+			req.reply.sendError(e);
+		}
+	}
+
+	data->addReadCost(req.tags, resultSize);
+	++data->counters.finishedQueries;
+	--data->readQueueSizeMetric;
+
+	double duration = g_network->timer() - req.requestTime();
+	data->counters.readLatencySample.addMeasurement(duration);
+	data->recordReadLatency(duration);
+
+	return Void();
+}
+
+ACTOR Future<Void> getRangeAggregateQ( StorageServer* data, GetRangeAggregateRequest req )
+// Reads req.range in pages of RANGESTREAM_PAGE_BYTES and replies with only their aggregates.  Throws a
+// wrong_shard_server if the range is not within one readable shard of this server.
+{
+	state Span span("SS:getRangeAggregate"_loc, { req.spanContext });
+	state int64_t resultSize = 0;
+
+	++data->counters.getRangeAggregateQueries;
+	++data->counters.allQueries;
+	++data->readQueueSizeMetric;
+	data->maxQueryQueue = std::max<int>( data->maxQueryQueue, data->counters.allQueries.getValue() - data->counters.finishedQueries.getValue());
+
+	// Active load balancing runs at a very high priority (to obtain accurate queue lengths)
+	// so we need to downgrade here
+	wait( delay(0, TaskPriority::DefaultEndpoint) );
+
+	try {
+		if( req.debugID.present() )
+			g_traceBatch.addEvent("TransactionDebug", req.debugID.get().first(), "storageserver.getRangeAggregate.Before");
+		state Version version = wait( waitForVersion( data, req.version, span.context ) );
+
+		state uint64_t changeCounter = data->shardChangeCounter;
+		state KeyRange shard = getShardKeyRange( data, firstGreaterOrEqual(req.range.begin) );
+		if (shard.empty()) throw wrong_shard_server();
+		if ( !shard.contains(req.range) ) {
+			throw wrong_shard_server();
+		}
+
+		state GetRangeAggregateReply reply;
+		state Key begin = req.range.begin;
+		loop {
+			// Each page is read at the request version, which has to stay in memory until the last one
+			if (version < data->oldestVersion.get()) {
+				throw transaction_too_old();
+			}
+
+			state int pageBytesLeft = SERVER_KNOBS->RANGESTREAM_PAGE_BYTES;
+			GetKeyValuesReply page = wait( readRange(data, version, KeyRangeRef(begin, req.range.end), std::numeric_limits<int>::max(), &pageBytesLeft, span.context) );
+			if (data->shardChangedSince(changeCounter, req.range)) throw wrong_shard_server();
+
+			for (auto const& kv : page.data) {
+				reply.aggregate.add(kv);
+			}
+
+			int64_t pageBytes = SERVER_KNOBS->RANGESTREAM_PAGE_BYTES - pageBytesLeft;
+			if (page.data.size() && SERVER_KNOBS->READ_SAMPLING_ENABLED) {
+				int64_t bytesReadPerKSecond = std::max(pageBytes, SERVER_KNOBS->EMPTY_READ_PENALTY) / 2;
+				data->metrics.notifyBytesReadPerKSecond(page.data[0].key, bytesReadPerKSecond);
+				data->metrics.notifyBytesReadPerKSecond(page.data[page.data.size() - 1].key, bytesReadPerKSecond);
+			}
+			resultSize += pageBytes;
+			data->counters.bytesQueried += pageBytes;
+			data->counters.rowsQueried += page.data.size();
+
+			if (!page.more) {
+				break;
+			}
+			ASSERT(page.data.size());
+			begin = keyAfter(page.data.back().key);
+			wait( yield() );
+		}
+		if (!reply.aggregate.count) {
+			++data->counters.emptyQueries;
+		}
+
+		if( req.debugID.present() )
+			g_traceBatch.addEvent("TransactionDebug", req.debugID.get().first(), "storageserver.getRangeAggregate.AfterReadRange");
+		reply.penalty = data->getPenalty();
+		req.reply.send( reply );
+	} catch (Error& e) {
+		if(!canReplyWith(e))
+			throw;
+		data->sendErrorWithPenalty(req.reply, e, data->getPenalty());
+	}
+
+	data->addReadCost(req.tags, resultSize);
+	++data->counters.finishedQueries;
+	--data->readQueueSizeMetric;
+
+	double duration = g_network->timer() - req.requestTime();
+	data->counters.readLatencySample.addMeasurement(duration);
+	data->recordReadLatency(duration);
+
+	return Void();
+}
+
+// Appends the length and bytes of s to the crc32c checksum
+static uint32_t checksumAppend(uint32_t checksum, StringRef s) {
+	uint32_t size = s.size();
+	checksum = crc32c_append(checksum, (const uint8_t*)&size, sizeof(size));
+	return crc32c_append(checksum, s.begin(), s.size());
+}
+
+ACTOR Future<Void> getRangeChecksumQ( StorageServer* data, GetRangeChecksumRequest req )
+// Reads req.range in pages of RANGESTREAM_PAGE_BYTES until req.limitBytes have been read, and replies with a checksum
+// of what was read.  Throws a wrong_shard_server if the range is not within one readable shard of this server.
+{
+	state Span span("SS:getRangeChecksum"_loc, { req.spanContext });
+
+	++data->counters.getRangeChecksumQueries;
+	++data->counters.allQueries;
+	++data->readQueueSizeMetric;
+	data->maxQueryQueue = std::max<int>( data->maxQueryQueue, data->counters.allQueries.getValue() - data->counters.finishedQueries.getValue());
+
+	// Active load balancing runs at a very high priority (to obtain accurate queue lengths)
+	// so we need to downgrade here
+	wait( delay(0, TaskPriority::DefaultEndpoint) );
+
+	try {
+		if( req.debugID.present() )
+			g_traceBatch.addEvent("TransactionDebug", req.debugID.get().first(), "storageserver.getRangeChecksum.Before");
+		state Version version = wait( waitForVersion( data, req.version, span.context ) );
+
+		state uint64_t changeCounter = data->shardChangeCounter;
+		state KeyRange shard = getShardKeyRange( data, firstGreaterOrEqual(req.range.begin) );
+		if (shard.empty()) throw wrong_shard_server();
+		if ( !shard.contains(req.range) ) {
+			throw wrong_shard_server();
+		}
 
-			if( req.debugID.present() )
-				g_traceBatch.addEvent("TransactionDebug", req.debugID.get().first(), "storageserver.getKeyValues.AfterReadRange");
-			//.detail("Begin",begin).detail("End",end).detail("SizeOf",r.data.size());
-			data->checkChangeCounter( changeCounter, KeyRangeRef( std::min<KeyRef>(begin, std::min<KeyRef>(req.begin.getKey(), req.end.getKey())), std::max<KeyRef>(end, std::max<KeyRef>(req.begin.getKey(), req.end.getKey())) ) );
-			if (EXPENSIVE_VALIDATION) {
-				for (int i = 0; i < r.data.size(); i++)
-					ASSERT(r.data[i].key >= begin && r.data[i].key < end);
-				ASSERT(r.data.size() <= std::abs(req.limit));
+		state GetRangeChecksumReply reply;
+		state Key begin = req.range.begin;
+		loop {
+			// Each page is read at the request version, which has to stay in memory until the last one
+			if (version < data->oldestVersion.get()) {
+				throw transaction_too_old();
 			}
 
-			/*for( int i = 0; i < r.data.size(); i++ ) {
-				StorageMetrics m;
-				m.bytesPerKSecond = r.data[i].expectedSize();
-				m.iosPerKSecond = 1; //FIXME: this should be 1/r.data.size(), but we cannot do that because it is an int
-				data->metrics.notify(r.data[i].key, m);
-			}*/
+			// The page limit only depends on what has been read so far, so replicas with the same data stop at the
+			// same key
+			state int pageLimit = std::max<int64_t>(1, std::min<int64_t>(SERVER_KNOBS->RANGESTREAM_PAGE_BYTES, req.limitBytes - reply.bytes));
+			state int pageBytesLeft = pageLimit;
+			GetKeyValuesReply page = wait( readRange(data, version, KeyRangeRef(begin, req.range.end), std::numeric_limits<int>::max(), &pageBytesLeft, span.context) );
+			if (data->shardChangedSince(changeCounter, req.range)) throw wrong_shard_server();
 
-			// For performance concerns, the cost of a range read is billed to the start key and end key of the range.
-			int64_t totalByteSize = 0;
-			for (int i = 0; i < r.data.size(); i++) {
-				totalByteSize += r.data[i].expectedSize();
-			}
-			if (totalByteSize > 0 && SERVER_KNOBS->READ_SAMPLING_ENABLED) {
-				int64_t bytesReadPerKSecond = std::max(totalByteSize, SERVER_KNOBS->EMPTY_READ_PENALTY) / 2;
-				data->metrics.notifyBytesReadPerKSecond(r.data[0].key, bytesReadPerKSecond);
-				data->metrics.notifyBytesReadPerKSecond(r.data[r.data.size() - 1].key, bytesReadPerKSecond);
+			for (auto const& kv : page.data) {
+				reply.checksum = checksumAppend(checksumAppend(reply.checksum, kv.key), kv.value);
 			}
 
-			r.penalty = data->getPenalty();
-			req.reply.send( r );
+			int64_t pageBytes = pageLimit - pageBytesLeft;
+			reply.keys += page.data.size();
+			reply.bytes += pageBytes;
+			data->counters.bytesQueried += pageBytes;
+			data->counters.rowsQueried += page.data.size();
 
-			resultSize = req.limitBytes - remainingLimitBytes;
-			data->counters.bytesQueried += resultSize;
-			data->counters.rowsQueried += r.data.size();
-			if(r.data.size() == 0) {
-				++data->counters.emptyQueries;
+			if (!page.more) {
+				break;
+			}
+			ASSERT(page.data.size());
+			begin = keyAfter(page.data.back().key);
+			if (reply.bytes >= req.limitBytes) {
+				reply.more = true;
+				reply.readThrough = begin;
+				break;
 			}
+			wait( yield() );
+		}
+		if (!reply.keys) {
+			++data->counters.emptyQueries;
 		}
+
+		if( req.debugID.present() )
+			g_traceBatch.addEvent("TransactionDebug", req.debugID.get().first(), "storageserver.getRangeChecksum.AfterReadRange");
+		req.reply.send( reply );
 	} catch (Error& e) {
 		if(!canReplyWith(e))
 			throw;
-		data->sendErrorWithPenalty(req.reply, e, data->getPenalty());
+		req.reply.sendError(e);
 	}
 
-	data->transactionTagCounter.addRequest(req.tags, resultSize);
 	++data->counters.finishedQueries;
 	--data->readQueueSizeMetric;
 
 	double duration = g_network->timer() - req.requestTime();
 	data->counters.readLatencySample.addMeasurement(duration);
-	if(data->latencyBandConfig.present()) {
-		int maxReadBytes = data->latencyBandConfig.get().readConfig.maxReadBytes.orDefault(std::numeric_limits<int>::max());
-		int maxSelectorOffset = data->latencyBandConfig.get().readConfig.maxKeySelectorOffset.orDefault(std::numeric_limits<int>::max());
-		data->counters.readLatencyBands.addMeasurement(
-		    duration, resultSize > maxReadBytes || abs(req.begin.offset) > maxSelectorOffset ||
-		                                     abs(req.end.offset) > maxSelectorOffset);
+
+	return Void();
+}
+
+// Appends the mutations of the changeFeedLog entry that are in range to reply, and returns their size
+int appendChangeFeedMutations( ChangeFeedStreamReply& reply, Standalone<MutationsAndVersionRef> const& entry, KeyRangeRef range ) {
+	MutationsAndVersionRef filtered(entry.version);
+	int bytes = 0;
+	for (auto& m : entry.mutations) {
+		if (m.type == MutationRef::ClearRange) {
+			KeyRangeRef cleared = KeyRangeRef(m.param1, m.param2) & range;
+			if (!cleared.empty()) {
+				filtered.mutations.push_back_deep(reply.arena, MutationRef(MutationRef::ClearRange, cleared.begin, cleared.end));
+				bytes += cleared.expectedSize();
+			}
+		} else if (range.contains(m.param1)) {
+			filtered.mutations.push_back(reply.arena, m);
+			bytes += m.expectedSize();
+		}
 	}
+	if (filtered.mutations.size()) {
+		reply.arena.dependsOn(entry.arena());
+		reply.mutations.push_back(reply.arena, filtered);
+	}
+	return bytes;
+}
+
+ACTOR Future<Void> changeFeedStreamQ( StorageServer* data, ChangeFeedStreamRequest req )
+// Sends the mutations of req.range from changeFeedLog in pages of up to RANGESTREAM_PAGE_BYTES, each ending at a known
+// committed version so that nothing sent can be rolled back.  A stream that runs out of committed mutations waits for
+// more, sending a page at most every CHANGE_FEED_EMPTY_REPLY_INTERVAL seconds to report its progress while the range
+// is idle.  It ends with end_of_stream after the page that reaches req.end.
+{
+	state Span span("SS:changeFeedStream"_loc, { req.spanContext });
+	state Version begin = req.begin; // Every mutation before this has been sent
+	state double lastReply = now();
+
+	req.reply.setByteLimit(SERVER_KNOBS->RANGESTREAM_LIMIT_BYTES);
+	++data->counters.changeFeedStreamQueries;
+
+	// Received at a very high priority, so downgrade before doing real work
+	wait( delay(0, TaskPriority::DefaultEndpoint) );
+
+	try {
+		auto shard = data->shards.rangeContaining( req.range.begin );
+		if (!shard->value()->isReadable() || !shard->range().contains( req.range )) {
+			throw wrong_shard_server();
+		}
+		state uint64_t changeCounter = data->shardChangeCounter;
+		for (auto r : data->changeFeedVersion.intersectingRanges( req.range )) {
+			if (begin <= r.value()) {
+				TEST(true); // Change feed of a shard fetched after its begin version
+				throw transaction_too_old();
+			}
+		}
+
+		loop {
+			wait( req.reply.onReady() );
+			wait( data->knownCommittedVersion.whenAtLeast( begin ) );
+			if (data->shardChangedSince(changeCounter, req.range)) throw wrong_shard_server();
+			if (begin < data->changeFeedLogBegin) {
+				TEST(true); // Change feed fell out of the MVCC window
+				throw transaction_too_old();
+			}
+
+			state ChangeFeedStreamReply reply;
+			reply = ChangeFeedStreamReply();
+			Version end = std::min( req.end, data->knownCommittedVersion.get() + 1 );
+
+			// Find the first entry at or after begin
+			int lo = 0, hi = data->changeFeedLog.size();
+			while (lo < hi) {
+				int mid = lo + (hi - lo) / 2;
+				if (data->changeFeedLog[mid].version < begin) {
+					lo = mid + 1;
+				} else {
+					hi = mid;
+				}
+			}
+			int bytes = 0;
+			reply.end = end;
+			for (int i = lo; i < data->changeFeedLog.size() && data->changeFeedLog[i].version < end; i++) {
+				if (bytes >= SERVER_KNOBS->RANGESTREAM_PAGE_BYTES) {
+					reply.end = data->changeFeedLog[i].version;
+					break;
+				}
+				bytes += appendChangeFeedMutations( reply, data->changeFeedLog[i], req.range );
+			}
+			begin = reply.end;
+			data->counters.bytesQueried += bytes;
 
+			if (reply.mutations.empty() && begin < req.end && now() - lastReply < SERVER_KNOBS->CHANGE_FEED_EMPTY_REPLY_INTERVAL) {
+				wait( delay( SERVER_KNOBS->CHANGE_FEED_EMPTY_REPLY_INTERVAL - (now() - lastReply) ) );
+				continue;
+			}
+
+			req.reply.send( reply );
+			lastReply = now();
+			if (begin >= req.end) {
+				req.reply.sendError( end_of_stream() );
+				break;
+			}
+			wait( yield() );
+		}
+	} catch (Error& e) {
+		// operation_obsolete means the client is gone
+		if (e.code() != error_code_operation_obsolete) {
+			if(!canReplyWith(e))
+				throw;
+			req.reply.sendError(e);
+		}
+	}
 	return Void();
 }
 
@@ -1710,11 +3045,12 @@ ACTOR Future<Void> getKeyQ( StorageServer* data, GetKeyRequest req ) {
 		state Version version = wait( waitForVersion( data, req.version, req.spanContext ) );
 		state uint64_t changeCounter = data->shardChangeCounter;
 		state KeyRange shard = getShardKeyRange( data, req.sel );
+		if (shard.empty()) throw wrong_shard_server();
 
 		state int offset;
 		Key k = wait( findKey( data, req.sel, version, shard, &offset, req.spanContext ) );
 
-		data->checkChangeCounter( changeCounter, KeyRangeRef( std::min<KeyRef>(req.sel.getKey(), k), std::max<KeyRef>(req.sel.getKey(), k) ) );
+		if (data->shardChangedSince(changeCounter, KeyRangeRef( std::min<KeyRef>(req.sel.getKey(), k), std::max<KeyRef>(req.sel.getKey(), k) ))) throw wrong_shard_server();
 
 		KeySelector updated;
 		if (offset < 0)
@@ -1748,13 +3084,14 @@ ACTOR Future<Void> getKeyQ( StorageServer* data, GetKeyRequest req ) {
 	// SOMEDAY: The size reported here is an undercount of the bytes read due to the fact that we have to scan for the key
 	// It would be more accurate to count all the read bytes, but it's not critical because this function is only used if
 	// read-your-writes is disabled
-	data->transactionTagCounter.addRequest(req.tags, resultSize);
+	data->addReadCost(req.tags, resultSize);
 
 	++data->counters.finishedQueries;
 	--data->readQueueSizeMetric;
 
 	double duration = g_network->timer() - req.requestTime();
 	data->counters.readLatencySample.addMeasurement(duration);
+	data->recordReadLatency(duration);
 	if(data->latencyBandConfig.present()) {
 		int maxReadBytes = data->latencyBandConfig.get().readConfig.maxReadBytes.orDefault(std::numeric_limits<int>::max());
 		int maxSelectorOffset = data->latencyBandConfig.get().readConfig.maxKeySelectorOffset.orDefault(std::numeric_limits<int>::max());
@@ -1773,11 +3110,13 @@ void getQueuingMetrics( StorageServer* self, StorageQueuingMetricsRequest const&
 	reply.bytesDurable = self->counters.bytesDurable.getValue();
 
 	reply.storageBytes = self->storage.getStorageBytes();
+	reply.engineDebt = self->storage.getEngineDebt();
 	reply.localRateLimit = self->currentRate();
 
 	reply.version = self->version.get();
 	reply.cpuUsage = self->cpuUsage;
 	reply.diskUsage = self->diskUsage;
+	reply.slowReadFraction = self->slowReadFraction();
 	reply.durableVersion = self->durableVersion.get();
 
 	Optional<StorageServer::TransactionTagCounter::TagInfo> busiestTag = self->transactionTagCounter.getBusiestTag();
@@ -1788,6 +3127,16 @@ void getQueuingMetrics( StorageServer* self, StorageQueuingMetricsRequest const&
 	req.reply.send( reply );
 }
 
+ACTOR Future<Void> waitForQueuingMetricsChange( StorageServer* self, StorageQueuingMetricsRequest req ) {
+	state double start = now();
+	while (!req.shouldReply(self->instanceID, self->counters.bytesInput.getValue(), self->counters.bytesDurable.getValue(),
+	                        self->version.get() - self->durableVersion.get(), now() - start)) {
+		wait(delay(std::min(SERVER_KNOBS->QUEUING_METRICS_CHECK_INTERVAL, start + req.maxDelay - now())));
+	}
+	getQueuingMetrics(self, req);
+	return Void();
+}
+
 #ifndef __INTEL_COMPILER
 #pragma endregion
 #endif
@@ -1799,6 +3148,7 @@ void getQueuingMetrics( StorageServer* self, StorageQueuingMetricsRequest const&
 
 ACTOR Future<Void> doEagerReads( StorageServer* data, UpdateEagerReadInfo* eager ) {
 	eager->finishKeyBegin();
+	eager->skipKeysInVersionedData( data->data().atLatest() );
 
 	vector<Future<Key>> keyEnd( eager->keyBegin.size() );
 	for(int i=0; i<keyEnd.size(); i++)
@@ -1806,11 +3156,7 @@ ACTOR Future<Void> doEagerReads( StorageServer* data, UpdateEagerReadInfo* eager
 
 	state Future<vector<Key>> futureKeyEnds = getAll(keyEnd);
 
-	vector<Future<Optional<Value>>> value( eager->keys.size() );
-	for(int i=0; i<value.size(); i++)
-		value[i] = data->storage.readValuePrefix( eager->keys[i].first, eager->keys[i].second );
-
-	state Future<vector<Optional<Value>>> futureValues = getAll(value);
+	state Future<vector<Optional<Value>>> futureValues = data->storage.readValues(eager->keys);
 	state vector<Key> keyEndVal = wait( futureKeyEnds );
 	vector<Optional<Value>> optionalValues = wait ( futureValues);
 
@@ -1983,6 +3329,20 @@ bool expandMutation( MutationRef& m, StorageServer::VersionedData const& data, U
 				return expandMutation(m, data, eager, eagerTrustedEnd, ar);
 			}
 			return false;
+		// The eager reads of these two are truncated (see UpdateEagerReadInfo::addMutation()), so oldVal is only
+		// compared, never written back.
+		case MutationRef::SetIfAbsent:
+			if (oldVal.present()) {
+				return false;
+			}
+			break;
+		case MutationRef::CompareAndSet:
+			if (oldVal.present() && isValidCompareAndSetOperand(m.param2) &&
+			    oldVal.get() == m.param2.substr(0, getCompareAndSetExpectedLength(m.param2))) {
+				m.param2 = doCompareAndSet(oldVal, m.param2, ar).get();
+				break;
+			}
+			return false;
 		}
 		m.type = MutationRef::SetValue;
 	}
@@ -1997,6 +3357,9 @@ void applyMutation( StorageServer *self, MutationRef const& m, Arena& arena, Sto
 	metrics.bytesPerKSecond = mvccStorageBytes( m ) / 2;
 	metrics.iosPerKSecond = 1;
 	self->metrics.notify(m.param1, metrics);
+	if (SERVER_KNOBS->STORAGE_HOT_KEY_SAMPLING) {
+		self->metrics.writeHotKeys.sample(m.param1);
+	}
 
 	if (m.type == MutationRef::SetValue) {
 		auto prev = data.atLatest().lastLessOrEqual(m.param1);
@@ -2277,6 +3640,48 @@ ACTOR Future<Void> fetchKeys( StorageServer *data, AddingShard* shard ) {
 
 		TraceEvent(SevDebug, "FetchKeysVersionSatisfied", data->thisServerID).detail("FKID", interval.pairID);
 
+		// Split a large shard into pieces that are each fetched by their own fetchKeys, so that they are fetched
+		// concurrently (still bounded by fetchKeysParallelismLock) and load balanced across the source replicas
+		// rather than streamed one block at a time. No updates have been collected yet, so none need splitting.
+		if (SERVER_KNOBS->FETCH_KEYS_SPLIT_BYTES > 0 && !shard->fetchSplit) {
+			state Standalone<VectorRef<KeyRef>> splitPoints;
+			try {
+				Standalone<VectorRef<KeyRef>> points =
+				    wait(timeout(Transaction(data->cx).getRangeSplitPoints(keys, SERVER_KNOBS->FETCH_KEYS_SPLIT_BYTES),
+				                 SERVER_KNOBS->FETCH_KEYS_SPLIT_TIMEOUT, Standalone<VectorRef<KeyRef>>()));
+				splitPoints = points;
+			} catch (Error& e) {
+				if (e.code() == error_code_actor_cancelled) throw;
+				TraceEvent(SevWarn, "FetchKeysSplitFailed", data->thisServerID).error(e).detail("FKID", interval.pairID);
+			}
+
+			std::vector<KeyRef> boundaries;
+			for (auto& k : splitPoints) {
+				if (k > keys.begin && k < keys.end && (boundaries.empty() || k > boundaries.back())) {
+					boundaries.push_back(k);
+				}
+			}
+			shard->fetchSplit = true;
+			if (!boundaries.empty()) {
+				TEST(true); // fetchKeys splits a shard to fetch its pieces in parallel
+				ASSERT(shard->phase == AddingShard::WaitPrevious && shard->updates.empty());
+				boundaries.push_back(keys.end);
+				shard->server->addShard(ShardInfo::addingSplitLeft(KeyRangeRef(keys.begin, boundaries[0]), shard));
+				for (int i = 0; i + 1 < boundaries.size(); i++) {
+					shard->server->addShard(ShardInfo::newAdding(data, KeyRangeRef(boundaries[i], boundaries[i + 1])));
+					data->shards.rangeContaining(boundaries[i]).value()->adding->fetchSplit = true;
+				}
+				shard = data->shards.rangeContaining(keys.begin).value()->adding.get();
+				warningLogger = logFetchKeysWarning(shard);
+				TraceEvent(SevDebug, "FetchKeysSplit", data->thisServerID)
+				    .detail("FKID", interval.pairID)
+				    .detail("KeyBegin", keys.begin)
+				    .detail("KeyEnd", keys.end)
+				    .detail("Pieces", boundaries.size());
+				keys = shard->keys;
+			}
+		}
+
 		wait( data->fetchKeysParallelismLock.take( TaskPriority::DefaultYield, fetchBlockBytes ) );
 		state FlowLock::Releaser holdingFKPL( data->fetchKeysParallelismLock, fetchBlockBytes );
 
@@ -2298,6 +3703,9 @@ ACTOR Future<Void> fetchKeys( StorageServer *data, AddingShard* shard ) {
 
 		TraceEvent(SevDebug, "FetchKeysUnblocked", data->thisServerID).detail("FKID", interval.pairID).detail("Version", fetchVersion);
 
+		// The shard's keys were cleared before it could be fetched again, so the storage engine may lay them out as a unit
+		wait( data->storage.reserveRange( keys ) );
+
 		// Get the history
 		state int debug_getRangeRetries = 0;
 		state int debug_nextRetryToLog = 1;
@@ -2334,17 +3742,23 @@ ACTOR Future<Void> fetchKeys( StorageServer *data, AddingShard* shard ) {
 				//wait( data->fetchKeysStorageWriteLock.take() );
 				//state FlowLock::Releaser holdingFKSWL( data->fetchKeysStorageWriteLock );
 
-				// Write this_block to storage
+				// Write this_block to storage.  The keys are not available until setAvailableStatus commits, and are cleared
+				// on recovery until then, so they can be bulk loaded.
 				state KeyValueRef *kvItr = this_block.begin();
-				for(; kvItr != this_block.end(); ++kvItr) {
-					data->storage.writeKeyValue( *kvItr );
-					wait(yield());
+				state YieldBudget yieldBudget;
+				if (data->storage.canBulkLoad()) {
+					data->storage.bulkLoad( Standalone<VectorRef<KeyValueRef>>( this_block, this_block.arena() ) );
+				} else {
+					for(; kvItr != this_block.end(); ++kvItr) {
+						data->storage.writeKeyValue( *kvItr );
+						if (yieldBudget.shouldYield()) wait(yield());
+					}
 				}
 
 				kvItr = this_block.begin();
 				for(; kvItr != this_block.end(); ++kvItr) {
 					data->byteSampleApplySet( *kvItr, invalidVersion );
-					wait(yield());
+					if (yieldBudget.shouldYield()) wait(yield());
 				}
 
 				if (this_block.more) {
@@ -2359,6 +3773,7 @@ ACTOR Future<Void> fetchKeys( StorageServer *data, AddingShard* shard ) {
 						shard = data->shards.rangeContaining( keys.begin ).value()->adding.get();
 						warningLogger = logFetchKeysWarning(shard);
 						AddingShard* otherShard = data->shards.rangeContaining( nfk ).value()->adding.get();
+						otherShard->fetchSplit = true;
 						keys = shard->keys;
 
 						// Split our prior updates.  The ones that apply to our new, restricted key range will go back into shard->updates,
@@ -2444,6 +3859,8 @@ ACTOR Future<Void> fetchKeys( StorageServer *data, AddingShard* shard ) {
 		shard->transferredVersion = data->version.get() + 1;
 		//shard->transferredVersion = batch->changes[0].version;  //< FIXME: This obeys the documented properties, and seems "safer" because it never introduces extra versions into the data structure, but violates some ASSERTs currently
 		data->mutableData().createNewVersion( shard->transferredVersion );
+		// The updates of the fetch are all applied at transferredVersion, so change feeds of its keys start after it
+		data->changeFeedVersion.insert( shard->keys, shard->transferredVersion );
 		ASSERT( shard->transferredVersion > data->storageVersion() );
 		ASSERT( shard->transferredVersion == data->data().getLatestVersion() );
 
@@ -2483,6 +3900,7 @@ ACTOR Future<Void> fetchKeys( StorageServer *data, AddingShard* shard ) {
 
 		ASSERT( data->shards[shard->keys.begin]->assigned() && data->shards[shard->keys.begin]->keys == shard->keys );  // We aren't changing whether the shard is assigned
 		data->newestAvailableVersion.insert(shard->keys, latestVersion);
+		data->readableSince.insert(shard->keys, data->durableVersion.get());
 		shard->readWrite.send(Void());
 		data->addShard( ShardInfo::newReadWrite(shard->keys, data) );   // invalidates shard!
 		coalesceShards(data, keys);
@@ -2629,6 +4047,7 @@ void changeServerKeys( StorageServer* data, const KeyRangeRef& keys, bool nowAss
 	// SOMEDAY: Could this just use shards?  Then we could explicitly do the removeDataRange here when an adding/transferred shard is cancelled
 	auto vr = data->newestAvailableVersion.intersectingRanges(keys);
 	std::vector<std::pair<KeyRange,Version>> changeNewestAvailable;
+	std::vector<std::pair<KeyRange, Version>> changeReadableSince;
 	std::vector<KeyRange> removeRanges;
 	for (auto r = vr.begin(); r != vr.end(); ++r) {
 		KeyRangeRef range = keys & r->range();
@@ -2645,6 +4064,7 @@ void changeServerKeys( StorageServer* data, const KeyRangeRef& keys, bool nowAss
 				ASSERT( r->value() == latestVersion);  // Not that we care, but this used to be checked instead of dataAvailable
 				ASSERT( data->mutableData().getLatestVersion() > version || context == CSK_RESTORE );
 				changeNewestAvailable.emplace_back(range, version);
+				changeReadableSince.emplace_back(range, invalidVersion);
 				removeRanges.push_back( range );
 			}
 			data->addShard( ShardInfo::newNotAssigned(range) );
@@ -2653,6 +4073,7 @@ void changeServerKeys( StorageServer* data, const KeyRangeRef& keys, bool nowAss
 			// SOMEDAY: Avoid restarting adding/transferred shards
 			if (version==0){ // bypass fetchkeys; shard is known empty at version 0
 				changeNewestAvailable.emplace_back(range, latestVersion);
+				changeReadableSince.emplace_back(range, 0);
 				data->addShard( ShardInfo::newReadWrite(range, data) );
 				setAvailableStatus(data, range, true);
 			} else {
@@ -2668,6 +4089,8 @@ void changeServerKeys( StorageServer* data, const KeyRangeRef& keys, bool nowAss
 	// Update newestAvailableVersion when a shard becomes (un)available (in a separate loop to avoid invalidating vr above)
 	for(auto r = changeNewestAvailable.begin(); r != changeNewestAvailable.end(); ++r)
 		data->newestAvailableVersion.insert( r->first, r->second );
+	for (auto& r : changeReadableSince)
+		data->readableSince.insert(r.first, r.second);
 
 	if (!nowAssigned)
 		data->metrics.notifyNotReadable( keys );
@@ -2707,6 +4130,12 @@ void StorageServer::addMutation(Version version, MutationRef const& mutation, Ke
 		return;
 	}
 	expanded = addMutationToMutationLog(mLog, expanded);
+	if (changeFeedLog.empty() || changeFeedLog.back().version != version) {
+		changeFeedLog.push_back(Standalone<MutationsAndVersionRef>(MutationsAndVersionRef(version)));
+	}
+	// expanded may be in a block of mLog's arena that was added after the last dependsOn()
+	changeFeedLog.back().arena().dependsOn(mLog.arena());
+	changeFeedLog.back().mutations.push_back(changeFeedLog.back().arena(), expanded);
 	DEBUG_MUTATION("applyMutation", version, expanded).detail("UID", thisServerID).detail("ShardBegin", shard.begin).detail("ShardEnd", shard.end);
 	applyMutation( this, expanded, mLog.arena(), mutableData() );
 	//printf("\nSSUpdate: Printing versioned tree after applying mutation\n");
@@ -3089,6 +4518,8 @@ ACTOR Future<Void> update( StorageServer* data, bool* pReceivedUpdate )
 						case MutationRef::Or:
 						case MutationRef::Xor:
 						case MutationRef::CompareAndClear:
+						case MutationRef::SetIfAbsent:
+						case MutationRef::CompareAndSet:
 							++data->counters.atomicMutations;
 							break;
 					}
@@ -3125,6 +4556,11 @@ ACTOR Future<Void> update( StorageServer* data, bool* pReceivedUpdate )
 			setDataVersion(data->thisServerID, data->version.get());
 			if (data->otherError.getFuture().isReady()) data->otherError.getFuture().get();
 
+			Version knownCommittedVersion = std::min(data->version.get(), cursor->getMinKnownCommittedVersion());
+			if (knownCommittedVersion > data->knownCommittedVersion.get()) {
+				data->knownCommittedVersion.set(knownCommittedVersion);
+			}
+
 			Version maxVersionsInMemory = SERVER_KNOBS->MAX_READ_TRANSACTION_LIFE_VERSIONS;
 			for(int i = 0; i < data->recoveryVersionSkips.size(); i++) {
 				maxVersionsInMemory += data->recoveryVersionSkips[i].second;
@@ -3172,16 +4608,99 @@ ACTOR Future<Void> update( StorageServer* data, bool* pReceivedUpdate )
 	}
 }
 
+// A storage engine commit started by updateStorage whose version has not yet been made the durable version
+struct StorageCommitInFlight {
+	Future<Void> durable;
+	Version version;
+	Promise<Void> durableInProgress;
+};
+
+// Waits for the oldest commit in inFlight and makes its version durable
+ACTOR Future<Void> finishStorageCommit(StorageServer* data, Deque<StorageCommitInFlight>* inFlight) {
+	state Future<Void> durable = inFlight->front().durable;
+	state Version newOldestVersion = inFlight->front().version;
+	state Promise<Void> durableInProgress = inFlight->front().durableInProgress;
+	inFlight->pop_front();
+
+	wait(durable);
+
+	debug_advanceMinCommittedVersion(data->thisServerID, newOldestVersion);
+
+	if (newOldestVersion > data->rebootAfterDurableVersion) {
+		TraceEvent("RebootWhenDurableTriggered", data->thisServerID)
+		    .detail("NewOldestVersion", newOldestVersion)
+		    .detail("RebootAfterDurableVersion", data->rebootAfterDurableVersion);
+		// To avoid brokenPromise error, which is caused by the sender of the durableInProgress (i.e., this process)
+		// never sets durableInProgress, we should set durableInProgress before send the please_reboot() error.
+		// Otherwise, in the race situation when storage server receives both reboot and
+		// brokenPromise of durableInProgress, the worker of the storage server will die.
+		// We will eventually end up with no worker for storage server role.
+		// The data distributor's buildTeam() will get stuck in building a team
+		durableInProgress.sendError(please_reboot());
+		for (int i = 0; i < inFlight->size(); i++) {
+			(*inFlight)[i].durableInProgress.sendError(please_reboot());
+		}
+		throw please_reboot();
+	}
+
+	durableInProgress.send(Void());
+	wait(delay(0, TaskPriority::UpdateStorage)); // Setting durableInProgess could cause the storage server to shut
+	                                             // down, so delay to check for cancellation
+
+	// Taking and releasing the durableVersionLock ensures that no eager reads both begin before the commit was
+	// effective and are applied after we change the durable version. Also ensure that we have to lock while calling
+	// changeDurableVersion, because otherwise the latest version of mutableData might be partially loaded.
+	wait(data->durableVersionLock.take());
+	data->popVersion(data->durableVersion.get() + 1);
+
+	while (!changeDurableVersion(data, newOldestVersion)) {
+		if (g_network->check_yield(TaskPriority::UpdateStorage)) {
+			data->durableVersionLock.release();
+			wait(delay(0, TaskPriority::UpdateStorage));
+			wait(data->durableVersionLock.take());
+		}
+	}
+
+	data->durableVersionLock.release();
+
+	//TraceEvent("StorageServerDurable", data->thisServerID).detail("Version", newOldestVersion);
+
+	return Void();
+}
+
 ACTOR Future<Void> updateStorage(StorageServer* data) {
+	// Up to STORAGE_COMMIT_PIPELINE_DEPTH commits may be outstanding, so that the next batch of mutations can be written
+	// to storage while the previous one commits.  Storage then holds some version in [durableVersion, storageVersion].
+	state Deque<StorageCommitInFlight> inFlight;
+	state Future<Void> durableDelay = Void();
+
 	loop {
-		ASSERT( data->durableVersion.get() == data->storageVersion() );
+		ASSERT( inFlight.empty() ? data->durableVersion.get() == data->storageVersion()
+		                         : data->durableVersion.get() < data->storageVersion() );
 		if (g_network->isSimulated()) {
 			double endTime = g_simulator.checkDisabled(format("%s/updateStorage", data->thisServerID.toString().c_str()));
 			if(endTime > now()) {
 				wait(delay(endTime - now(), TaskPriority::UpdateStorage));
 			}
 		}
-		wait( data->desiredOldestVersion.whenAtLeast( data->storageVersion()+1 ) );
+
+		// Finish commits as they complete until there is room for another, the commit interval has passed, and there
+		// are new versions to make durable
+		loop {
+			if (inFlight.size() < SERVER_KNOBS->STORAGE_COMMIT_PIPELINE_DEPTH && durableDelay.isReady() &&
+			    data->desiredOldestVersion.get() > data->storageVersion()) {
+				break;
+			}
+			if (!inFlight.empty() && inFlight.front().durable.isReady()) {
+				wait(finishStorageCommit(data, &inFlight));
+				continue;
+			}
+			Future<Void> ready = data->desiredOldestVersion.whenAtLeast(data->storageVersion() + 1) && durableDelay;
+			if (!inFlight.empty()) {
+				ready = ready || inFlight.front().durable;
+			}
+			wait(ready);
+		}
 		wait( delay(0, TaskPriority::UpdateStorage) );
 
 		state Promise<Void> durableInProgress;
@@ -3192,6 +4711,19 @@ ACTOR Future<Void> updateStorage(StorageServer* data) {
 		state Version desiredVersion = data->desiredOldestVersion.get();
 		state int64_t bytesLeft = SERVER_KNOBS->STORAGE_COMMIT_BYTES;
 
+		// Snapshots are taken at exact multiples of the interval, so that readers can name them, and so a commit never
+		// goes past the next one
+		state int64_t snapshotInterval =
+		    data->storage.canRetainSnapshots() ? SERVER_KNOBS->STORAGE_SNAPSHOT_INTERVAL_VERSIONS : 0;
+		state bool stoppedAtSnapshot = false;
+		if (snapshotInterval > 0) {
+			Version nextSnapshot = (startOldestVersion / snapshotInterval + 1) * snapshotInterval;
+			if (nextSnapshot < desiredVersion) {
+				desiredVersion = nextSnapshot;
+				stoppedAtSnapshot = true;
+			}
+		}
+
 		// Write mutations to storage until we reach the desiredVersion or have written too much (bytesleft)
 		loop {
 			state bool done = data->storage.makeVersionMutationsDurable(newOldestVersion, desiredVersion, bytesLeft);
@@ -3200,6 +4732,10 @@ ACTOR Future<Void> updateStorage(StorageServer* data) {
 			// immediately (without waiting) but asynchronously frees memory.
 			Future<Void> finishedForgetting =
 			    data->mutableData().forgetVersionsBeforeAsync(newOldestVersion, TaskPriority::UpdateStorage);
+			while (!data->changeFeedLog.empty() && data->changeFeedLog.front().version < newOldestVersion) {
+				data->changeFeedLog.pop_front();
+			}
+			data->changeFeedLogBegin = std::max(data->changeFeedLogBegin, newOldestVersion);
 			data->oldestVersion.set(newOldestVersion);
 			wait(finishedForgetting);
 			wait(yield(TaskPriority::UpdateStorage));
@@ -3208,56 +4744,18 @@ ACTOR Future<Void> updateStorage(StorageServer* data) {
 
 		// Set the new durable version as part of the outstanding change set, before commit
 		if (startOldestVersion != newOldestVersion) data->storage.makeVersionDurable(newOldestVersion);
+		if (snapshotInterval > 0 && newOldestVersion != startOldestVersion && newOldestVersion % snapshotInterval == 0) {
+			data->storage.retainSnapshot(newOldestVersion,
+			                             newOldestVersion - SERVER_KNOBS->STORAGE_SNAPSHOT_RETENTION_VERSIONS);
+		}
 
 		debug_advanceMaxCommittedVersion(data->thisServerID, newOldestVersion);
-		state Future<Void> durable = data->storage.commit();
-		state Future<Void> durableDelay = Void();
+		inFlight.push_back(StorageCommitInFlight{ data->storage.commit(), newOldestVersion, durableInProgress });
+		durableDelay = Void();
 
-		if (bytesLeft > 0) {
+		if (bytesLeft > 0 && !stoppedAtSnapshot) {
 			durableDelay = delay(SERVER_KNOBS->STORAGE_COMMIT_INTERVAL, TaskPriority::UpdateStorage);
 		}
-
-		wait(durable);
-
-		debug_advanceMinCommittedVersion(data->thisServerID, newOldestVersion);
-
-		if (newOldestVersion > data->rebootAfterDurableVersion) {
-			TraceEvent("RebootWhenDurableTriggered", data->thisServerID)
-			    .detail("NewOldestVersion", newOldestVersion)
-			    .detail("RebootAfterDurableVersion", data->rebootAfterDurableVersion);
-			// To avoid brokenPromise error, which is caused by the sender of the durableInProgress (i.e., this process)
-			// never sets durableInProgress, we should set durableInProgress before send the please_reboot() error.
-			// Otherwise, in the race situation when storage server receives both reboot and
-			// brokenPromise of durableInProgress, the worker of the storage server will die.
-			// We will eventually end up with no worker for storage server role.
-			// The data distributor's buildTeam() will get stuck in building a team
-			durableInProgress.sendError(please_reboot());
-			throw please_reboot();
-		}
-
-		durableInProgress.send(Void());
-		wait(delay(0, TaskPriority::UpdateStorage)); // Setting durableInProgess could cause the storage server to shut
-		                                             // down, so delay to check for cancellation
-
-		// Taking and releasing the durableVersionLock ensures that no eager reads both begin before the commit was
-		// effective and are applied after we change the durable version. Also ensure that we have to lock while calling
-		// changeDurableVersion, because otherwise the latest version of mutableData might be partially loaded.
-		wait(data->durableVersionLock.take());
-		data->popVersion(data->durableVersion.get() + 1);
-
-		while (!changeDurableVersion(data, newOldestVersion)) {
-			if (g_network->check_yield(TaskPriority::UpdateStorage)) {
-				data->durableVersionLock.release();
-				wait(delay(0, TaskPriority::UpdateStorage));
-				wait(data->durableVersionLock.take());
-			}
-		}
-
-		data->durableVersionLock.release();
-
-		//TraceEvent("StorageServerDurable", data->thisServerID).detail("Version", newOldestVersion);
-
-		wait(durableDelay);
 	}
 }
 
@@ -3312,19 +4810,85 @@ void setAssignedStatus( StorageServer* self, KeyRangeRef keys, bool nowAssigned
 	}
 }
 
+Future<Optional<Value>> StorageServerDisk::readValue( KeyRef key, Optional<UID> debugID ) {
+	if (!readCache) return storage->readValue(key, debugID);
+	Optional<Optional<Value>> cached = readCache->get(key);
+	if (cached.present()) {
+		++data->counters.readCacheHits;
+		return cached.get();
+	}
+	++data->counters.readCacheMisses;
+	return readValueAndCache(storage, readCache, key, debugID);
+}
+
+Future<Optional<Value>> StorageServerDisk::readValuePrefix( KeyRef key, int maxLength, Optional<UID> debugID ) {
+	if (readCache) {
+		Optional<Optional<Value>> cached = readCache->get(key);
+		if (cached.present()) {
+			++data->counters.readCacheHits;
+			if (cached.get().present() && cached.get().get().size() > maxLength) {
+				return Optional<Value>(cached.get().get().substr(0, maxLength));
+			}
+			return cached.get();
+		}
+	}
+	return storage->readValuePrefix(key, maxLength, debugID);
+}
+
+Future<std::vector<Optional<Value>>> StorageServerDisk::readValues(std::vector<std::pair<KeyRef, int>> const& keys,
+                                                                  Optional<UID> debugID) {
+	if (!readCache) return storage->readValues(keys, debugID);
+	std::vector<Optional<Value>> values(keys.size());
+	std::vector<std::pair<KeyRef, int>> missedKeys;
+	std::vector<int> missed;
+	for (int i = 0; i < keys.size(); i++) {
+		const auto& [key, maxLength] = keys[i];
+		Optional<Optional<Value>> cached = readCache->get(key);
+		if (cached.present()) {
+			++data->counters.readCacheHits;
+			if (maxLength >= 0 && cached.get().present() && cached.get().get().size() > maxLength) {
+				values[i] = Value(cached.get().get().substr(0, maxLength), cached.get().get().arena());
+			} else {
+				values[i] = cached.get();
+			}
+		} else {
+			if (maxLength < 0) {
+				++data->counters.readCacheMisses;
+			}
+			missedKeys.push_back(keys[i]);
+			missed.push_back(i);
+		}
+	}
+	if (missed.empty()) {
+		return values;
+	}
+	return readValuesAndCache(storage, readCache, missedKeys, missed, values, debugID);
+}
+
 void StorageServerDisk::clearRange( KeyRangeRef keys ) {
+	invalidateReadCache(keys);
 	storage->clear(keys);
 }
 
 void StorageServerDisk::writeKeyValue( KeyValueRef kv ) {
+	invalidateReadCache(kv.key);
 	storage->set( kv );
 }
 
+void StorageServerDisk::bulkLoad( Standalone<VectorRef<KeyValueRef>> data ) {
+	if (data.size()) {
+		invalidateReadCache(KeyRangeRef(data.front().key, keyAfter(data.back().key)));
+	}
+	storage->bulkLoad( data );
+}
+
 void StorageServerDisk::writeMutation( MutationRef mutation ) {
 	// FIXME: DEBUG_MUTATION(debugContext, debugVersion, *m);
 	if (mutation.type == MutationRef::SetValue) {
+		invalidateReadCache(mutation.param1);
 		storage->set( KeyValueRef(mutation.param1, mutation.param2) );
 	} else if (mutation.type == MutationRef::ClearRange) {
+		invalidateReadCache(KeyRangeRef(mutation.param1, mutation.param2));
 		storage->clear( KeyRangeRef(mutation.param1, mutation.param2) );
 	} else
 		ASSERT(false);
@@ -3335,8 +4899,10 @@ void StorageServerDisk::writeMutations(const VectorRef<MutationRef>& mutations,
 	for (const auto& m : mutations) {
 		DEBUG_MUTATION(debugContext, debugVersion, m).detail("UID", data->thisServerID);
 		if (m.type == MutationRef::SetValue) {
+			invalidateReadCache(m.param1);
 			storage->set(KeyValueRef(m.param1, m.param2));
 		} else if (m.type == MutationRef::ClearRange) {
+			invalidateReadCache(KeyRangeRef(m.param1, m.param2));
 			storage->clear(KeyRangeRef(m.param1, m.param2));
 		}
 	}
@@ -3390,7 +4956,7 @@ ACTOR Future<Void> applyByteSampleResult( StorageServer* data, IKeyValueStore* s
 		for( int j = 0; j < bs.size(); j++ ) {
 			KeyRef key = bs[j].key.removePrefix(persistByteSampleKeys.begin);
 			if(!data->byteSampleClears.rangeContaining(key).value()) {
-				data->metrics.byteSample.sample.insert( key, BinaryReader::fromStringRef<int32_t>(bs[j].value, Unversioned()), false );
+				data->metrics.byteSample.insert( key, BinaryReader::fromStringRef<int32_t>(bs[j].value, Unversioned()), false );
 			}
 		}
 		if( rangeSize >= SERVER_KNOBS->STORAGE_LIMIT_BYTES ) {
@@ -3420,7 +4986,9 @@ ACTOR Future<Void> restoreByteSample(StorageServer* data, IKeyValueStore* storag
 	wait( applyByteSampleResult(data, storage, persistByteSampleSampleKeys.begin, persistByteSampleSampleKeys.end, &byteSampleSample) );
 	byteSampleSampleRecovered.send(Void());
 	wait( startRestore );
-	wait( delay(SERVER_KNOBS->BYTE_SAMPLE_START_DELAY) );
+	if( !SERVER_KNOBS->BYTE_SAMPLE_LOAD_WITH_RESTORE ) {
+		wait( delay(SERVER_KNOBS->BYTE_SAMPLE_START_DELAY) );
+	}
 
 	size_t bytes_per_fetch = 0;
 	// Since the expected size also includes (as of now) the space overhead of the container, we calculate our own number here
@@ -3468,7 +5036,11 @@ ACTOR Future<bool> restoreDurableState( StorageServer* data, IKeyValueStore* sto
 
 	state Promise<Void> byteSampleSampleRecovered;
 	state Promise<Void> startByteSampleRestore;
-	data->byteSampleRecovery = restoreByteSample(data, storage, byteSampleSampleRecovered, startByteSampleRestore.getFuture());
+	// The byte sample can be read while the shards are restored, because byteSampleClears keeps the samples of the
+	// unavailable ranges cleared below from being loaded, whichever happens first
+	data->byteSampleRecovery =
+	    restoreByteSample(data, storage, byteSampleSampleRecovered,
+	                      SERVER_KNOBS->BYTE_SAMPLE_LOAD_WITH_RESTORE ? Future<Void>(Void()) : startByteSampleRestore.getFuture());
 
 	TraceEvent("ReadingDurableState", data->thisServerID);
 	wait( waitForAll( std::vector{ fFormat, fID, fVersion, fLogProtocol, fPrimaryLocality } ) );
@@ -3503,6 +5075,7 @@ ACTOR Future<bool> restoreDurableState( StorageServer* data, IKeyValueStore* sto
 
 	state Standalone<RangeResultRef> available = fShardAvailable.get();
 	state int availableLoc;
+	state YieldBudget yieldBudget;
 	for(availableLoc=0; availableLoc<available.size(); availableLoc++) {
 		KeyRangeRef keys(
 			available[availableLoc].key.removePrefix(persistShardAvailableKeys.begin),
@@ -3512,7 +5085,8 @@ ACTOR Future<bool> restoreDurableState( StorageServer* data, IKeyValueStore* sto
 		/*if(nowAvailable)
 		  TraceEvent("AvailableShard", data->thisServerID).detail("RangeBegin", keys.begin).detail("RangeEnd", keys.end);*/
 		data->newestAvailableVersion.insert( keys, nowAvailable ? latestVersion : invalidVersion );
-		wait(yield());
+		data->readableSince.insert(keys, nowAvailable ? version : invalidVersion);
+		if (yieldBudget.shouldYield()) wait(yield());
 	}
 
 	state Standalone<RangeResultRef> assigned = fShardAssigned.get();
@@ -3528,7 +5102,7 @@ ACTOR Future<bool> restoreDurableState( StorageServer* data, IKeyValueStore* sto
 		changeServerKeys(data, keys, nowAssigned, version, CSK_RESTORE);
 
 		if (!nowAssigned) ASSERT( data->newestAvailableVersion.allEqual(keys, invalidVersion) );
-		wait(yield());
+		if (yieldBudget.shouldYield()) wait(yield());
 	}
 
 	wait( delay( 0.0001 ) );
@@ -3598,7 +5172,7 @@ void StorageServer::byteSampleApplySet( KeyValueRef kv, Version ver ) {
 	if (old != byteSample.end()) delta = -byteSample.getMetric(old);
 	if (sampleInfo.inSample) {
 		delta += sampleInfo.sampledSize;
-		byteSample.insert( key, sampleInfo.sampledSize );
+		metrics.byteSample.insert( key, sampleInfo.sampledSize );
 		addMutationToMutationLogOrStorage( ver, MutationRef(MutationRef::SetValue, key.withPrefix(persistByteSampleKeys.begin), BinaryWriter::toValue( sampleInfo.sampledSize, Unversioned() )) );
 	} else {
 		bool any = old != byteSample.end();
@@ -3655,7 +5229,8 @@ void StorageServer::byteSampleApplyClear( KeyRangeRef range, Version ver ) {
 	}
 
 	if (any) {
-		byteSample.eraseAsync( range.begin, range.end );
+		// Freeing the sample's leaves a few dozen keys at a time is cheap enough to do synchronously
+		byteSample.erase( range.begin, range.end );
 		auto diskRange = range.withPrefix( persistByteSampleKeys.begin );
 		addMutationToMutationLogOrStorage( ver, MutationRef(MutationRef::ClearRange, diskRange.begin, diskRange.end) );
 	}
@@ -3676,7 +5251,7 @@ ACTOR Future<Void> waitMetrics( StorageServerMetrics* self, WaitMetricsRequest r
 	{
 		auto rs = self->waitMetricsMap.modify( req.keys );
 		for(auto r = rs.begin(); r != rs.end(); ++r)
-			r->value().push_back( change );
+			r->value().streams.push_back( change );
 		loop {
 			try {
 				choose {
@@ -3728,7 +5303,7 @@ ACTOR Future<Void> waitMetrics( StorageServerMetrics* self, WaitMetricsRequest r
 
 	auto rs = self->waitMetricsMap.modify( req.keys );
 	for(auto i = rs.begin(); i != rs.end(); ++i) {
-		auto &x = i->value();
+		auto &x = i->value().streams;
 		for( int j = 0; j < x.size(); j++ ) {
 			if( x[j] == change ) {
 				swapAndPop(&x, j);
@@ -3751,6 +5326,70 @@ Future<Void> StorageServerMetrics::waitMetrics(WaitMetricsRequest req, Future<Vo
 	return ::waitMetrics(this, req, delay);
 }
 
+// Serves one data distributor's subscription to shard metrics: the watches it adds through watchShardMetrics fire into
+// the subscription, and the fired ones are sent as one reply every SHARD_METRICS_STREAM_DELAY.  Every
+// STORAGE_METRIC_TIMEOUT the metrics of all of its watches are recomputed, which is what a WaitMetricsRequest timing
+// out would otherwise achieve for each shard.
+ACTOR Future<Void> shardMetricsStreamQ( StorageServer* self, ShardMetricsStreamRequest req ) {
+	state ShardMetricsSubscription* sub = self->metrics.addShardMetricsSubscription( req.subscriptionId );
+	state Future<Void> resync = delayJittered( SERVER_KNOBS->STORAGE_METRIC_TIMEOUT );
+
+	if (!sub) {
+		req.reply.sendError( operation_obsolete() );
+		return Void();
+	}
+	req.reply.setByteLimit( SERVER_KNOBS->RANGESTREAM_LIMIT_BYTES );
+
+	try {
+		loop {
+			if (sub->pending.crossed.empty() && sub->pending.wrongShard.empty()) {
+				choose {
+					when( wait( sub->pendingChanged.onTrigger() ) ) {}
+					when( wait( resync ) ) {
+						wait( req.reply.onReady() ); // Throws operation_obsolete if the subscriber is gone
+						self->metrics.resyncShardMetricsWatches( sub );
+						resync = delayJittered( SERVER_KNOBS->STORAGE_METRIC_TIMEOUT );
+					}
+				}
+			}
+			if (!sub->pending.crossed.empty() || !sub->pending.wrongShard.empty()) {
+				// Gather whatever else fires meanwhile into the same reply; this also keeps watches from being removed
+				// while waitMetricsMap is being iterated to notify them
+				wait( delay( SERVER_KNOBS->SHARD_METRICS_STREAM_DELAY ) );
+				wait( req.reply.onReady() );
+				req.reply.send( self->metrics.takeFiredShardMetricsWatches( sub ) );
+			}
+		}
+	} catch (Error& e) {
+		if (e.code() == error_code_actor_cancelled) throw; // Only cancelled when the storage server is shutting down
+		self->metrics.removeShardMetricsSubscription( req.subscriptionId );
+		// operation_obsolete means the subscriber is gone
+		if (e.code() != error_code_operation_obsolete) {
+			if (!canReplyWith(e)) throw;
+			req.reply.sendError(e);
+		}
+	}
+	return Void();
+}
+
+void watchShardMetrics( StorageServer* self, ShardMetricsWatchRequest const& req ) {
+	auto sub = self->metrics.shardMetricsSubscriptions.find( req.subscriptionId );
+	if (sub == self->metrics.shardMetricsSubscriptions.end()) {
+		req.reply.sendError( operation_obsolete() );
+		return;
+	}
+	for (auto id : req.cancelled) {
+		auto w = sub->second->watches.find( id );
+		if (w != sub->second->watches.end()) {
+			self->metrics.removeShardMetricsWatch( w->second.get() );
+		}
+	}
+	for (auto const& w : req.watches) {
+		self->metrics.addShardMetricsWatch( sub->second.get(), w, self->isReadable( w.keys ) );
+	}
+	req.reply.send( Void() );
+}
+
 #ifndef __INTEL_COMPILER
 #pragma endregion
 #endif
@@ -3760,6 +5399,34 @@ Future<Void> StorageServerMetrics::waitMetrics(WaitMetricsRequest req, Future<Vo
 #pragma region Core
 #endif
 
+// Closes an interval of the hot key samples every STORAGE_HOT_KEY_SAMPLE_INTERVAL and logs the hottest keys in it
+ACTOR Future<Void> hotKeysLogger(StorageServer* self) {
+	loop {
+		wait(delay(SERVER_KNOBS->STORAGE_HOT_KEY_SAMPLE_INTERVAL));
+		self->metrics.readHotKeys.rollover();
+		self->metrics.writeHotKeys.rollover();
+
+		Arena arena;
+		VectorRef<HotKeyRef> readKeys, writeKeys;
+		self->metrics.readHotKeys.getHotKeys(allKeys, SERVER_KNOBS->STORAGE_HOT_KEY_STATUS_COUNT, arena, readKeys);
+		self->metrics.writeHotKeys.getHotKeys(allKeys, SERVER_KNOBS->STORAGE_HOT_KEY_STATUS_COUNT, arena, writeKeys);
+
+		TraceEvent ev("HotKeys", self->thisServerID);
+		ev.detail("ReadKeys", readKeys.size()).detail("WriteKeys", writeKeys.size());
+		for (int i = 0; i < readKeys.size(); i++) {
+			ev.detail(format("Read%dKey", i).c_str(), readKeys[i].key)
+			    .detail(format("Read%dHz", i).c_str(), readKeys[i].hz)
+			    .detail(format("Read%dErrorHz", i).c_str(), readKeys[i].errorHz);
+		}
+		for (int i = 0; i < writeKeys.size(); i++) {
+			ev.detail(format("Write%dKey", i).c_str(), writeKeys[i].key)
+			    .detail(format("Write%dHz", i).c_str(), writeKeys[i].hz)
+			    .detail(format("Write%dErrorHz", i).c_str(), writeKeys[i].errorHz);
+		}
+		ev.trackLatest(self->thisServerID.toString() + "/HotKeys");
+	}
+}
+
 ACTOR Future<Void> metricsCore( StorageServer* self, StorageServerInterface ssi ) {
 	state Future<Void> doPollMetrics = Void();
 
@@ -3769,6 +5436,9 @@ ACTOR Future<Void> metricsCore( StorageServer* self, StorageServerInterface ssi
 	self->actors.add(traceCounters("StorageMetrics", self->thisServerID, SERVER_KNOBS->STORAGE_LOGGING_DELAY,
 	                               &self->counters.cc, self->thisServerID.toString() + "/StorageMetrics",
 								   [tag](TraceEvent& te) { te.detail("Tag", tag.toString()); }));
+	if (SERVER_KNOBS->STORAGE_HOT_KEY_SAMPLING) {
+		self->actors.add(hotKeysLogger(self));
+	}
 
 	loop {
 		choose {
@@ -3780,6 +5450,12 @@ ACTOR Future<Void> metricsCore( StorageServer* self, StorageServerInterface ssi
 					self->actors.add( self->metrics.waitMetrics( req, delayJittered( SERVER_KNOBS->STORAGE_METRIC_TIMEOUT ) ) );
 				}
 			}
+			when (ShardMetricsStreamRequest req = waitNext(ssi.shardMetricsStream.getFuture())) {
+				self->actors.add( shardMetricsStreamQ( self, req ) );
+			}
+			when (ShardMetricsWatchRequest req = waitNext(ssi.watchShardMetrics.getFuture())) {
+				watchShardMetrics( self, req );
+			}
 			when (SplitMetricsRequest req = waitNext(ssi.splitMetrics.getFuture())) {
 				if (!self->isReadable( req.keys )) {
 					TEST( true );	// splitMetrics immediate wrong_shard_server()
@@ -3800,6 +5476,14 @@ ACTOR Future<Void> metricsCore( StorageServer* self, StorageServerInterface ssi
 					self->metrics.getReadHotRanges(req);
 				}
 			}
+			when(GetHotKeysRequest req = waitNext(ssi.getHotKeys.getFuture())) {
+				if (!self->isReadable(req.keys)) {
+					TEST(true); // getHotKeys immediate wrong_shard_server()
+					self->sendErrorWithPenalty(req.reply, wrong_shard_server(), self->getPenalty());
+				} else {
+					self->metrics.getHotKeys(req);
+				}
+			}
 			when(SplitRangeRequest req = waitNext(ssi.getRangeSplitPoints.getFuture())) {
 				if (!self->isReadable(req.keys)) {
 					TEST(true); // getSplitPoints immediate wrong_shard_server()
@@ -3849,17 +5533,26 @@ ACTOR Future<Void> checkBehind( StorageServer* self ) {
 	}
 }
 
-ACTOR Future<Void> serveGetValueRequests( StorageServer* self, FutureStream<GetValueRequest> getValue ) {
+ACTOR Future<Void> serveGetValueRequests( StorageServer* self, FutureStream<GetValueRequest> getValue, FutureStream<GetValuesRequest> getValues ) {
 	loop {
-		GetValueRequest req = waitNext(getValue);
 		// Warning: This code is executed at extremely high priority (TaskPriority::LoadBalancedEndpoint), so downgrade before doing real work
-		if( req.debugID.present() )
-			g_traceBatch.addEvent("GetValueDebug", req.debugID.get().first(), "storageServer.received"); //.detail("TaskID", g_network->getCurrentTask());
+		choose {
+			when(GetValueRequest req = waitNext(getValue)) {
+				if( req.debugID.present() )
+					g_traceBatch.addEvent("GetValueDebug", req.debugID.get().first(), "storageServer.received"); //.detail("TaskID", g_network->getCurrentTask());
 
-		if (SHORT_CIRCUT_ACTUAL_STORAGE && normalKeys.contains(req.key))
-			req.reply.send(GetValueReply());
-		else
-			self->actors.add(self->readGuard(req , getValueQ));
+				if (SHORT_CIRCUT_ACTUAL_STORAGE && normalKeys.contains(req.key))
+					req.reply.send(GetValueReply());
+				else
+					self->actors.add(self->scheduledReadGuard(req, getValueQ));
+			}
+			when(GetValuesRequest req = waitNext(getValues)) {
+				if( req.debugID.present() )
+					g_traceBatch.addEvent("GetValueDebug", req.debugID.get().first(), "storageServer.received");
+
+				self->actors.add(self->scheduledReadGuard(req, getValuesQ));
+			}
+		}
 	}
 }
 
@@ -3867,7 +5560,43 @@ ACTOR Future<Void> serveGetKeyValuesRequests( StorageServer* self, FutureStream<
 	loop {
 		GetKeyValuesRequest req = waitNext(getKeyValues);
 		// Warning: This code is executed at extremely high priority (TaskPriority::LoadBalancedEndpoint), so downgrade before doing real work
-		self->actors.add(self->readGuard(req, getKeyValuesQ));
+		if (canReadFromSnapshot(self, req)) {
+			self->actors.add(self->scheduledReadGuard(req, getKeyValuesAtSnapshotQ));
+		} else {
+			self->actors.add(self->scheduledReadGuard(req, getKeyValuesQ));
+		}
+	}
+}
+
+ACTOR Future<Void> serveGetKeyValuesStreamRequests( StorageServer* self, FutureStream<GetKeyValuesStreamRequest> getKeyValuesStream ) {
+	loop {
+		GetKeyValuesStreamRequest req = waitNext(getKeyValuesStream);
+		// Warning: This code is executed at extremely high priority (TaskPriority::LoadBalancedEndpoint), so downgrade before doing real work
+		self->actors.add(getKeyValuesStreamQ(self, req));
+	}
+}
+
+ACTOR Future<Void> serveGetRangeAggregateRequests( StorageServer* self, FutureStream<GetRangeAggregateRequest> getRangeAggregate ) {
+	loop {
+		GetRangeAggregateRequest req = waitNext(getRangeAggregate);
+		// Warning: This code is executed at extremely high priority (TaskPriority::LoadBalancedEndpoint), so downgrade before doing real work
+		self->actors.add(getRangeAggregateQ(self, req));
+	}
+}
+
+ACTOR Future<Void> serveGetRangeChecksumRequests( StorageServer* self, FutureStream<GetRangeChecksumRequest> getRangeChecksum ) {
+	loop {
+		GetRangeChecksumRequest req = waitNext(getRangeChecksum);
+		// Warning: This code is executed at extremely high priority (TaskPriority::LoadBalancedEndpoint), so downgrade before doing real work
+		self->actors.add(getRangeChecksumQ(self, req));
+	}
+}
+
+ACTOR Future<Void> serveChangeFeedStreamRequests( StorageServer* self, FutureStream<ChangeFeedStreamRequest> changeFeedStream ) {
+	loop {
+		ChangeFeedStreamRequest req = waitNext(changeFeedStream);
+		// Warning: This code is executed at extremely high priority (TaskPriority::LoadBalancedEndpoint), so downgrade before doing real work
+		self->actors.add(changeFeedStreamQ(self, req));
 	}
 }
 
@@ -3875,7 +5604,7 @@ ACTOR Future<Void> serveGetKeyRequests( StorageServer* self, FutureStream<GetKey
 	loop {
 		GetKeyRequest req = waitNext(getKey);
 		// Warning: This code is executed at extremely high priority (TaskPriority::LoadBalancedEndpoint), so downgrade before doing real work
-		self->actors.add(self->readGuard(req , getKeyQ));
+		self->actors.add(self->scheduledReadGuard(req, getKeyQ));
 	}
 }
 
@@ -3883,7 +5612,6 @@ ACTOR Future<Void> serveWatchValueRequests( StorageServer* self, FutureStream<Wa
 	loop {
 		WatchValueRequest req = waitNext(watchValue);
 		// TODO: fast load balancing?
-		// SOMEDAY: combine watches for the same key/value into a single watch
 		self->actors.add(self->readGuard(req, watchValueQ));
 	}
 }
@@ -3926,14 +5654,20 @@ ACTOR Future<Void> storageServerCore( StorageServer* self, StorageServerInterfac
 	state Future<Void> checkLastUpdate = Void();
 	state Future<Void> updateProcessStatsTimer = delay(SERVER_KNOBS->FASTRESTORE_UPDATE_PROCESS_STATS_INTERVAL);
 
+	// Nothing before the restored version is in changeFeedLog
+	self->changeFeedLogBegin = self->version.get() + 1;
 	self->actors.add(updateStorage(self));
 	self->actors.add(waitFailureServer(ssi.waitFailure.getFuture()));
 	self->actors.add(self->otherError.getFuture());
 	self->actors.add(metricsCore(self, ssi));
 	self->actors.add(logLongByteSampleRecovery(self->byteSampleRecovery));
 	self->actors.add(checkBehind(self));
-	self->actors.add(serveGetValueRequests(self, ssi.getValue.getFuture()));
+	self->actors.add(serveGetValueRequests(self, ssi.getValue.getFuture(), ssi.getValues.getFuture()));
 	self->actors.add(serveGetKeyValuesRequests(self, ssi.getKeyValues.getFuture()));
+	self->actors.add(serveGetKeyValuesStreamRequests(self, ssi.getKeyValuesStream.getFuture()));
+	self->actors.add(serveGetRangeAggregateRequests(self, ssi.getRangeAggregate.getFuture()));
+	self->actors.add(serveGetRangeChecksumRequests(self, ssi.getRangeChecksum.getFuture()));
+	self->actors.add(serveChangeFeedStreamRequests(self, ssi.changeFeedStream.getFuture()));
 	self->actors.add(serveGetKeyRequests(self, ssi.getKey.getFuture()));
 	self->actors.add(serveWatchValueRequests(self, ssi.watchValue.getFuture()));
 	self->actors.add(traceRole(Role::STORAGE_SERVER, ssi.id()));
@@ -4009,7 +5743,11 @@ ACTOR Future<Void> storageServerCore( StorageServer* self, StorageServerInterfac
 				}
 			}
 			when (StorageQueuingMetricsRequest req = waitNext(ssi.getQueuingMetrics.getFuture())) {
-				getQueuingMetrics(self, req);
+				if (req.maxDelay > 0) {
+					self->actors.add(waitForQueuingMetricsChange(self, req));
+				} else {
+					getQueuingMetrics(self, req);
+				}
 			}
 			when( ReplyPromise<KeyValueStoreType> reply = waitNext(ssi.getKeyValueStoreType.getFuture()) ) {
 				reply.send( self->storage.getKeyValueStoreType() );
@@ -4310,7 +6048,7 @@ void versionedMapTest() {
 	printf("SS Ptree node is %zu bytes\n", sizeof( StorageServer::VersionedData::PTreeT ) );
 
 	const int NSIZE = sizeof(VersionedMap<int,int>::PTreeT);
-	const int ASIZE = NSIZE <= 64 ? 64 : nextFastAllocatedSize(NSIZE);
+	const int ASIZE = PTreeImpl::allocatedSize(NSIZE);
 
 	auto before = FastAllocator< ASIZE >::getTotalMemory();
 
@@ -634,6 +634,160 @@ void logMetrics( vector<PerfMetric> metrics ) {
 				.detail( "Formatted", format(metrics[idx].format_code().c_str(), metrics[idx].value() ) );
 }
 
+ACTOR Future<Void> measurePerfWorkloadCPU(double* cpuSeconds, double startDelay, double duration) {
+	wait(delay(startDelay));
+	state double start = getProcessorTimeProcess();
+	wait(delay(duration));
+	*cpuSeconds = getProcessorTimeProcess() - start;
+	return Void();
+}
+
+void PerfWorkloadMetrics::measureCPU(double startDelay, double duration) {
+	cpuMeasurement = measurePerfWorkloadCPU(&cpuSeconds, startDelay, duration);
+}
+
+void PerfWorkloadMetrics::addOperation(vector<PerfMetric>& m, std::string const& operation, double duration,
+                                       int64_t count, int64_t bytes, ContinuousSample<double>& latencies) {
+	std::string prefix = "Perf/" + operation + "/";
+	if (duration > 0) {
+		m.emplace_back(prefix + "OpsPerSecond", count / duration, false);
+	}
+	if (latencies.getPopulationSize()) {
+		m.emplace_back(prefix + "LatencyMeanMs", 1000 * latencies.mean(), true);
+		m.emplace_back(prefix + "LatencyP50Ms", 1000 * latencies.median(), true);
+		m.emplace_back(prefix + "LatencyP90Ms", 1000 * latencies.percentile(0.90), true);
+		m.emplace_back(prefix + "LatencyP99Ms", 1000 * latencies.percentile(0.99), true);
+		m.emplace_back(prefix + "LatencyMaxMs", 1000 * latencies.max(), true);
+	}
+	if (bytes && count) {
+		m.emplace_back(prefix + "BytesPerOp", (double)bytes / count, true);
+	}
+}
+
+void PerfWorkloadMetrics::addCPU(vector<PerfMetric>& m, int64_t count) const {
+	if (g_network->isSimulated() || !cpuMeasurement.isValid() || !cpuMeasurement.isReady() || !count) {
+		return;
+	}
+	m.emplace_back("Perf/All/CPUMicrosecondsPerOp", 1e6 * cpuSeconds / count, true);
+}
+
+// Performance results are written as
+//   { "test": <title>, "passed": <bool>, "clients": <count>,
+//     "perf": { <operation>: { <statistic>: <value>, ... }, ... },
+//     "metrics": { <name>: <value>, ... },
+//     "regressions": [ { "metric": <name>, "baseline": <value>, "value": <value>, "change": <fraction> }, ... ] }
+// where "perf" holds the PerfWorkloadMetrics and "metrics" everything else the workloads reported. A baseline is the
+// results file of an earlier run of the same spec; only "perf" is compared.
+json_spirit::mObject perfResultsToJson(vector<PerfMetric> const& metrics) {
+	json_spirit::mObject perf, other;
+	for (auto const& metric : metrics) {
+		size_t split = metric.name().rfind('/');
+		if (boost::starts_with(metric.name(), "Perf/") && split > 4) {
+			std::string operation = metric.name().substr(5, split - 5);
+			if (!perf.count(operation)) {
+				perf[operation] = json_spirit::mObject();
+			}
+			perf[operation].get_obj()[metric.name().substr(split + 1)] = metric.value();
+		} else {
+			other[metric.name()] = metric.value();
+		}
+	}
+	json_spirit::mObject result;
+	result["perf"] = perf;
+	result["metrics"] = other;
+	return result;
+}
+
+// Throughput regresses when it falls; every other statistic (latency, CPU and bytes per operation) when it rises
+bool perfStatisticHigherIsBetter(std::string const& statistic) {
+	return boost::ends_with(statistic, "OpsPerSecond");
+}
+
+json_spirit::mArray comparePerfResults(json_spirit::mObject const& perf, json_spirit::mObject const& baseline,
+                                       double threshold) {
+	json_spirit::mArray regressions;
+	for (auto const& operation : perf) {
+		auto baseOperation = baseline.find(operation.first);
+		if (baseOperation == baseline.end() || baseOperation->second.type() != json_spirit::obj_type) {
+			continue;
+		}
+		for (auto const& statistic : operation.second.get_obj()) {
+			auto base = baseOperation->second.get_obj().find(statistic.first);
+			if (base == baseOperation->second.get_obj().end() || base->second.get_real() == 0) {
+				continue;
+			}
+			double baseValue = base->second.get_real();
+			double value = statistic.second.get_real();
+			double change = (value - baseValue) / baseValue;
+			if (perfStatisticHigherIsBetter(statistic.first) ? change < -threshold : change > threshold) {
+				std::string name = "Perf/" + operation.first + "/" + statistic.first;
+				TraceEvent(SevWarnAlways, "PerfRegression")
+				    .detail("Metric", name)
+				    .detail("Baseline", baseValue)
+				    .detail("Value", value)
+				    .detail("Change", change);
+				printf("Performance regression: %s %f -> %f (%+.1f%%)\n", name.c_str(), baseValue, value, 100 * change);
+				json_spirit::mObject regression;
+				regression["metric"] = name;
+				regression["baseline"] = baseValue;
+				regression["value"] = value;
+				regression["change"] = change;
+				regressions.push_back(regression);
+			}
+		}
+	}
+	return regressions;
+}
+
+// Writes the results of a test to spec.perfResultsFile and compares them against spec.perfBaselineFile, returning
+// false if the baseline could not be read or a metric regressed
+bool reportPerfResults(TestSpec const& spec, DistributedTestResults const& testResults, bool passed) {
+	json_spirit::mObject results = perfResultsToJson(testResults.metrics);
+	bool ok = true;
+	if (spec.perfBaselineFile.size()) {
+		json_spirit::mValue baseline;
+		try {
+			std::string contents = readFileBytes(spec.perfBaselineFile, 100e6);
+			if (!json_spirit::read_string(contents, baseline) || baseline.type() != json_spirit::obj_type ||
+			    !baseline.get_obj().count("perf") || baseline.get_obj()["perf"].type() != json_spirit::obj_type) {
+				throw io_error();
+			}
+		} catch (Error& e) {
+			TraceEvent(SevError, "TestFailure")
+			    .error(e)
+			    .detail("Reason", "Unable to read performance baseline")
+			    .detail("File", spec.perfBaselineFile);
+			return false;
+		}
+		json_spirit::mArray regressions = comparePerfResults(results["perf"].get_obj(),
+		                                                     baseline.get_obj()["perf"].get_obj(),
+		                                                     spec.perfRegressionThreshold);
+		TraceEvent(regressions.empty() ? SevInfo : SevWarnAlways, "PerfBaselineComparison")
+		    .detail("Workload", spec.title)
+		    .detail("Baseline", spec.perfBaselineFile)
+		    .detail("Threshold", spec.perfRegressionThreshold)
+		    .detail("Regressions", regressions.size());
+		ok = regressions.empty();
+		results["regressions"] = regressions;
+	}
+	if (spec.perfResultsFile.size()) {
+		results["test"] = spec.title.toString();
+		results["passed"] = passed && ok;
+		results["clients"] = testResults.successes + testResults.failures;
+		try {
+			writeFile(spec.perfResultsFile,
+			          json_spirit::write_string(json_spirit::mValue(results), json_spirit::pretty_print));
+		} catch (Error& e) {
+			TraceEvent(SevError, "TestFailure")
+			    .error(e)
+			    .detail("Reason", "Unable to write performance results")
+			    .detail("File", spec.perfResultsFile);
+			ok = false;
+		}
+	}
+	return ok;
+}
+
 template <class T>
 void throwIfError(const std::vector<Future<ErrorOr<T>>> &futures, std::string errorMsg) {
 	for(auto &future:futures) {
@@ -851,6 +1005,10 @@ ACTOR Future<bool> runTest( Database cx, std::vector< TesterInterface > testers,
 		}
 	}
 
+	if (spec.perfResultsFile.size() || spec.perfBaselineFile.size()) {
+		ok = reportPerfResults(spec, testResults, ok) && ok;
+	}
+
 	TraceEvent(ok ? SevInfo : SevWarnAlways, "TestResults")
 		.detail("Workload", spec.title)
 		.detail("Passed", (int)ok);
@@ -1006,6 +1164,19 @@ std::map<std::string, std::function<void(const std::string& value, TestSpec* spe
 		        spec->simDrAgents = ISimulator::BackupAgentType::NoBackupAgents;
 	        TraceEvent("TestParserTest").detail("ParsedSimDrAgents", spec->simDrAgents);
 		}},
+	{ "perfResultsFile", [](const std::string& value, TestSpec* spec) {
+			spec->perfResultsFile = value;
+			TraceEvent("TestParserTest").detail("ParsedPerfResultsFile", spec->perfResultsFile);
+		}},
+	{ "perfBaselineFile", [](const std::string& value, TestSpec* spec) {
+			spec->perfBaselineFile = value;
+			TraceEvent("TestParserTest").detail("ParsedPerfBaselineFile", spec->perfBaselineFile);
+		}},
+	{ "perfRegressionThreshold", [](const std::string& value, TestSpec* spec) {
+			sscanf( value.c_str(), "%lf", &spec->perfRegressionThreshold );
+			ASSERT( spec->perfRegressionThreshold >= 0 );
+			TraceEvent("TestParserTest").detail("ParsedPerfRegressionThreshold", spec->perfRegressionThreshold);
+		}},
 	{ "checkOnly", [](const std::string& value, TestSpec* spec) {
 			if(value == "true")
 				spec->phases = TestWorkload::CHECK;
@@ -1346,6 +1517,9 @@ ACTOR Future<Void> runTests( Reference<ClusterConnectionFile> connFile, test_typ
 		options.push_back_deep(options.arena(), KeyValueRef(LiteralStringRef("indefinite"), LiteralStringRef("true")));
 		options.push_back_deep(options.arena(), KeyValueRef(LiteralStringRef("rateLimitMax"), StringRef(rateLimitMax)));
 		options.push_back_deep(options.arena(), KeyValueRef(LiteralStringRef("shuffleShards"), LiteralStringRef("true")));
+		if (CLIENT_KNOBS->CONSISTENCY_CHECK_USE_CHECKSUMS) {
+			options.push_back_deep(options.arena(), KeyValueRef(LiteralStringRef("useChecksums"), LiteralStringRef("true")));
+		}
 		spec.options.push_back_deep(spec.options.arena(), options);
 		testSpecs.push_back(spec);
 	} else {
@@ -47,6 +47,7 @@
 #include "flow/Profiler.h"
 #include "flow/ThreadHelper.actor.h"
 #include "flow/Trace.h"
+#include "flow/UnitTest.h"
 #include "flow/network.h"
 
 #ifdef __linux__
@@ -115,6 +116,82 @@ ACTOR Future<std::vector<Endpoint>> broadcastDBInfoRequest(UpdateServerDBInfoReq
 	return notUpdated;
 }
 
+std::vector<Standalone<StringRef>> serializeServerDBInfoFields(ServerDBInfo const& info) {
+	std::vector<Standalone<StringRef>> fields;
+	ServerDBInfo::forEachField(info, [&fields](int index, auto const& field) {
+		fields.push_back(BinaryWriter::toValue(field, AssumeVersion(g_network->protocolVersion())));
+	});
+	return fields;
+}
+
+Standalone<StringRef> encodeServerDBInfoDelta(std::vector<Standalone<StringRef>> const& base,
+                                              std::vector<Standalone<StringRef>> const& fields) {
+	BinaryWriter wr(AssumeVersion(g_network->protocolVersion()));
+	for (uint8_t i = 0; i < fields.size(); i++) {
+		if (i >= base.size() || fields[i] != base[i]) {
+			wr << i << fields[i];
+		}
+	}
+	return wr.toValue();
+}
+
+Optional<ServerDBInfo> decodeServerDBInfoRequest(UpdateServerDBInfoRequest const& req, ServerDBInfo const& current) {
+	if (!req.deltaBase.present()) {
+		return BinaryReader::fromStringRef<ServerDBInfo>(req.serializedDbInfo,
+		                                                 AssumeVersion(g_network->protocolVersion()));
+	}
+	if (req.deltaBase.get() != current.id) {
+		return Optional<ServerDBInfo>();
+	}
+	ServerDBInfo info = current;
+	BinaryReader rd(req.serializedDbInfo, AssumeVersion(g_network->protocolVersion()));
+	while (!rd.empty()) {
+		uint8_t index;
+		StringRef bytes;
+		rd >> index >> bytes;
+		ServerDBInfo::forEachField(info, [index, bytes](int i, auto& field) {
+			if (i == index) {
+				field = BinaryReader::fromStringRef<std::decay_t<decltype(field)>>(
+				    bytes, AssumeVersion(g_network->protocolVersion()));
+			}
+		});
+	}
+	return info;
+}
+
+TEST_CASE("/fdbserver/worker/ServerDBInfoDelta") {
+	ServerDBInfo base;
+	base.id = deterministicRandom()->randomUniqueID();
+	base.infoGeneration = 1;
+	base.recoveryState = RecoveryState::RECRUITING;
+	base.priorCommittedLogServers.push_back(deterministicRandom()->randomUniqueID());
+
+	ServerDBInfo info = base;
+	info.id = deterministicRandom()->randomUniqueID();
+	info.infoGeneration = 2;
+	info.recoveryState = RecoveryState::FULLY_RECOVERED;
+	info.priorCommittedLogServers.clear();
+
+	std::vector<Standalone<StringRef>> baseFields = serializeServerDBInfoFields(base);
+	std::vector<Standalone<StringRef>> fields = serializeServerDBInfoFields(info);
+	UpdateServerDBInfoRequest req;
+	req.serializedDbInfo = encodeServerDBInfoDelta(baseFields, fields);
+	req.deltaBase = base.id;
+	ASSERT(req.serializedDbInfo.size() < BinaryWriter::toValue(info, AssumeVersion(g_network->protocolVersion())).size());
+
+	Optional<ServerDBInfo> decoded = decodeServerDBInfoRequest(req, base);
+	ASSERT(decoded.present() && serializeServerDBInfoFields(decoded.get()) == fields);
+
+	// A worker that has some other info cannot apply the delta
+	ASSERT(!decodeServerDBInfoRequest(req, info).present());
+
+	req.serializedDbInfo = BinaryWriter::toValue(info, AssumeVersion(g_network->protocolVersion()));
+	req.deltaBase = Optional<UID>();
+	decoded = decodeServerDBInfoRequest(req, ServerDBInfo());
+	ASSERT(decoded.present() && serializeServerDBInfoFields(decoded.get()) == fields);
+	return Void();
+}
+
 ACTOR static Future<Void> extractClientInfo( Reference<AsyncVar<ServerDBInfo>> db, Reference<AsyncVar<ClientDBInfo>> info ) {
 	state std::vector<UID> lastCommitProxyUIDs;
 	state std::vector<CommitProxyInterface> lastCommitProxies;
@@ -711,6 +788,7 @@ ACTOR Future<Void> storageServerRollbackRebooter( Future<Void> prevStorageServer
 		DUMPTOKEN(recruited.splitMetrics);
 		DUMPTOKEN(recruited.getReadHotRanges);
 		DUMPTOKEN(recruited.getRangeSplitPoints);
+		DUMPTOKEN(recruited.getHotKeys);
 		DUMPTOKEN(recruited.getStorageMetrics);
 		DUMPTOKEN(recruited.waitFailure);
 		DUMPTOKEN(recruited.getQueuingMetrics);
@@ -1043,6 +1121,7 @@ ACTOR Future<Void> workerServer(
 				DUMPTOKEN(recruited.splitMetrics);
 				DUMPTOKEN(recruited.getReadHotRanges);
 				DUMPTOKEN(recruited.getRangeSplitPoints);
+				DUMPTOKEN(recruited.getHotKeys);
 				DUMPTOKEN(recruited.getStorageMetrics);
 				DUMPTOKEN(recruited.waitFailure);
 				DUMPTOKEN(recruited.getQueuingMetrics);
@@ -1143,26 +1222,33 @@ ACTOR Future<Void> workerServer(
 
 		loop choose {
 			when( UpdateServerDBInfoRequest req = waitNext( interf.updateServerDBInfo.getFuture() ) ) {
-				ServerDBInfo localInfo = BinaryReader::fromStringRef<ServerDBInfo>(req.serializedDbInfo, AssumeVersion(g_network->protocolVersion()));
-				localInfo.myLocality = locality;
-
-				if(localInfo.infoGeneration < dbInfo->get().infoGeneration && localInfo.clusterInterface == dbInfo->get().clusterInterface) {
-					std::vector<Endpoint> rep = req.broadcastInfo;
-					rep.push_back(interf.updateServerDBInfo.getEndpoint());
-					req.reply.send(rep);
+				Optional<ServerDBInfo> receivedInfo = decodeServerDBInfoRequest(req, dbInfo->get());
+				if(!receivedInfo.present()) {
+					// A delta against an info this worker never received. Pass it on, and ask for the whole info.
+					TEST(true); // Worker could not apply a ServerDBInfo delta
+					errorForwarders.add(success(broadcastDBInfoRequest(req, SERVER_KNOBS->DBINFO_SEND_AMOUNT, interf.updateServerDBInfo.getEndpoint(), true)));
 				} else {
-					Optional<Endpoint> notUpdated;
-					if(!ccInterface->get().present() || localInfo.clusterInterface != ccInterface->get().get()) {
-						notUpdated = interf.updateServerDBInfo.getEndpoint();
-					}
-					else if(localInfo.infoGeneration > dbInfo->get().infoGeneration || dbInfo->get().clusterInterface != ccInterface->get().get()) {
+					ServerDBInfo localInfo = receivedInfo.get();
+					localInfo.myLocality = locality;
 
-						TraceEvent("GotServerDBInfoChange").detail("ChangeID", localInfo.id).detail("MasterID", localInfo.master.id())
-						.detail("RatekeeperID", localInfo.ratekeeper.present() ? localInfo.ratekeeper.get().id() : UID())
-						.detail("DataDistributorID", localInfo.distributor.present() ? localInfo.distributor.get().id() : UID());
-						dbInfo->set(localInfo);
+					if(localInfo.infoGeneration < dbInfo->get().infoGeneration && localInfo.clusterInterface == dbInfo->get().clusterInterface) {
+						std::vector<Endpoint> rep = req.broadcastInfo;
+						rep.push_back(interf.updateServerDBInfo.getEndpoint());
+						req.reply.send(rep);
+					} else {
+						Optional<Endpoint> notUpdated;
+						if(!ccInterface->get().present() || localInfo.clusterInterface != ccInterface->get().get()) {
+							notUpdated = interf.updateServerDBInfo.getEndpoint();
+						}
+						else if(localInfo.infoGeneration > dbInfo->get().infoGeneration || dbInfo->get().clusterInterface != ccInterface->get().get()) {
+
+							TraceEvent("GotServerDBInfoChange").detail("ChangeID", localInfo.id).detail("MasterID", localInfo.master.id())
+							.detail("RatekeeperID", localInfo.ratekeeper.present() ? localInfo.ratekeeper.get().id() : UID())
+							.detail("DataDistributorID", localInfo.distributor.present() ? localInfo.distributor.get().id() : UID());
+							dbInfo->set(localInfo);
+						}
+						errorForwarders.add(success(broadcastDBInfoRequest(req, SERVER_KNOBS->DBINFO_SEND_AMOUNT, notUpdated, true)));
 					}
-					errorForwarders.add(success(broadcastDBInfoRequest(req, SERVER_KNOBS->DBINFO_SEND_AMOUNT, notUpdated, true)));
 				}
 			}
 			when( RebootRequest req = waitNext( interf.clientInterface.reboot.getFuture() ) ) {
@@ -1355,6 +1441,7 @@ ACTOR Future<Void> workerServer(
 					DUMPTOKEN(recruited.splitMetrics);
 					DUMPTOKEN(recruited.getReadHotRanges);
 					DUMPTOKEN(recruited.getRangeSplitPoints);
+					DUMPTOKEN(recruited.getHotKeys);
 					DUMPTOKEN(recruited.getStorageMetrics);
 					DUMPTOKEN(recruited.waitFailure);
 					DUMPTOKEN(recruited.getQueuingMetrics);
@@ -1824,6 +1911,7 @@ ACTOR Future<Void> fdbd(
 	state Promise<Void> recoveredDiskFiles;
 
 	actors.push_back(serveProtocolInfo());
+	FlowTransport::transport().setLocalDcId(localities.dcId());
 
 	try {
 		ServerCoordinators coordinators( connFile );
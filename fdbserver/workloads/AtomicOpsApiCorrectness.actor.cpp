@@ -55,7 +55,7 @@ public:
 
 	Future<Void> start(Database const& cx) override {
 		if (opType == -1)
-			opType = sharedRandomNumber % 9;
+			opType = sharedRandomNumber % 11;
 
 		switch (opType) {
 		case 0:
@@ -85,6 +85,12 @@ public:
 		case 8:
 			TEST(true); // Testing atomic CompareAndClear
 			return testCompareAndClear(cx->clone(), this);
+		case 9:
+			TEST(true); // Testing atomic SetIfAbsent
+			return testSetIfAbsent(cx->clone(), this);
+		case 10:
+			TEST(true); // Testing atomic CompareAndSet
+			return testCompareAndSet(cx->clone(), this);
 		default:
 			ASSERT(false);
 		}
@@ -384,6 +390,112 @@ public:
 		return Void();
 	}
 
+	// Sets the key to val1 or clears it, then applies a SetIfAbsent of val2 or a CompareAndSet of expected val2 and new
+	// value val3, first through a storage server and then within one RYW transaction
+	ACTOR Future<Void> testConditionalSetAtomicOpApi(Database cx, AtomicOpsApiCorrectnessWorkload* self,
+	                                                 uint32_t opType, Key key, bool keySet) {
+		state uint64_t intValue1 = deterministicRandom()->randomInt(0, 10000000);
+		state uint64_t intValue2 =
+		    deterministicRandom()->coinflip() ? intValue1 : deterministicRandom()->randomInt(0, 10000000);
+		state uint64_t intValue3 = deterministicRandom()->randomInt(0, 10000000);
+
+		state Value val1 = StringRef((const uint8_t*)&intValue1, sizeof(intValue1));
+		state Value operand;
+		state Optional<uint64_t> expectedOutput;
+		if (opType == MutationRef::SetIfAbsent) {
+			operand = StringRef((const uint8_t*)&intValue2, sizeof(intValue2));
+			expectedOutput = keySet ? intValue1 : intValue2;
+		} else {
+			int32_t expectedLength = littleEndian32(sizeof(intValue2));
+			operand = StringRef((const uint8_t*)&intValue2, sizeof(intValue2))
+			              .withSuffix(StringRef((const uint8_t*)&intValue3, sizeof(intValue3)))
+			              .withSuffix(StringRef((const uint8_t*)&expectedLength, sizeof(expectedLength)));
+			if (keySet) {
+				expectedOutput = intValue1 == intValue2 ? intValue3 : intValue1;
+			}
+		}
+
+		// Do operation on Storage Server
+		loop {
+			try {
+				wait(runRYWTransactionNoRetry(cx, [=](Reference<ReadYourWritesTransaction> tr) -> Future<Void> {
+					if (keySet) {
+						tr->set(key, val1);
+					} else {
+						tr->clear(key);
+					}
+					return Void();
+				}));
+				wait(runRYWTransactionNoRetry(cx, [=](Reference<ReadYourWritesTransaction> tr) -> Future<Void> {
+					tr->atomicOp(key, operand, opType);
+					return Void();
+				}));
+				break;
+			} catch (Error& e) {
+				TraceEvent(SevInfo, "AtomicOpApiThrow").detail("ErrCode", e.code());
+				wait(delay(1));
+			}
+		}
+
+		{
+			Optional<Value> outputVal = wait(runRYWTransaction(
+			    cx, [=](Reference<ReadYourWritesTransaction> tr) -> Future<Optional<Value>> { return tr->get(key); }));
+			self->checkConditionalSetOutput(outputVal, expectedOutput, "StorageServer", opType, intValue1, intValue2);
+		}
+
+		{
+			// Do operation at RYW layer
+			Optional<Value> outputVal =
+			    wait(runRYWTransaction(cx, [=](Reference<ReadYourWritesTransaction> tr) -> Future<Optional<Value>> {
+				    if (keySet) {
+					    tr->set(key, val1);
+				    } else {
+					    tr->clear(key);
+				    }
+				    tr->atomicOp(key, operand, opType);
+				    return tr->get(key);
+			    }));
+			self->checkConditionalSetOutput(outputVal, expectedOutput, "RYWLayer", opType, intValue1, intValue2);
+		}
+
+		return Void();
+	}
+
+	void checkConditionalSetOutput(Optional<Value> const& outputVal, Optional<uint64_t> const& expectedOutput,
+	                               const char* opOn, uint32_t opType, uint64_t intValue1, uint64_t intValue2) {
+		uint64_t output = 0;
+		if (outputVal.present()) {
+			ASSERT(outputVal.get().size() == sizeof(uint64_t));
+			memcpy(&output, outputVal.get().begin(), outputVal.get().size());
+		}
+		if (outputVal.present() != expectedOutput.present() || (outputVal.present() && output != expectedOutput.get())) {
+			TraceEvent(SevError, "AtomicOpApiCorrectnessUnexpectedOutput")
+			    .detail("OpOn", opOn)
+			    .detail("InValue1", intValue1)
+			    .detail("InValue2", intValue2)
+			    .detail("AtomicOp", opType)
+			    .detail("ExpectedOutput", expectedOutput)
+			    .detail("ActualOutput", outputVal.present() ? Optional<uint64_t>(output) : Optional<uint64_t>());
+			testFailed = true;
+		}
+	}
+
+	ACTOR Future<Void> testSetIfAbsent(Database cx, AtomicOpsApiCorrectnessWorkload* self) {
+		state Key key = self->getTestKey("test_key_set_if_absent_");
+		TraceEvent(SevInfo, "Running Atomic Op SET_IF_ABSENT Correctness Current Api Version");
+		wait(self->testConditionalSetAtomicOpApi(cx, self, MutationRef::SetIfAbsent, key, true));
+		wait(self->testConditionalSetAtomicOpApi(cx, self, MutationRef::SetIfAbsent, key, false));
+		return Void();
+	}
+
+	ACTOR Future<Void> testCompareAndSet(Database cx, AtomicOpsApiCorrectnessWorkload* self) {
+		state Key key = self->getTestKey("test_key_compare_and_set_");
+		TraceEvent(SevInfo, "Running Atomic Op COMPARE_AND_SET Correctness Current Api Version");
+		wait(self->testConditionalSetAtomicOpApi(cx, self, MutationRef::CompareAndSet, key, true));
+		wait(self->testConditionalSetAtomicOpApi(cx, self, MutationRef::CompareAndSet, key, false));
+		return Void();
+	}
+
 	ACTOR Future<Void> testMin(Database cx, AtomicOpsApiCorrectnessWorkload* self) {
 		state int currentApiVersion = getApiVersion(cx);
 		state Key key = self->getTestKey("test_key_min_");
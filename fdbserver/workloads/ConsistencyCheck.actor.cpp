@@ -72,6 +72,13 @@ struct ConsistencyCheckWorkload : TestWorkload
 	//Randomize shard order with each iteration if true
 	bool shuffleShards;
 
+	//If true, compare checksums computed by the storage servers rather than the data itself, resuming from the cursor
+	//saved under fdbConsistencyCheckCursorPrefix.  Shards are visited in key order, so shuffleShards is ignored.
+	bool useChecksums;
+
+	//The number of bytes each storage server reads for one checksum request
+	int64_t checksumBytes;
+
 	bool success;
 
 	//Number of times this client has run its portion of the consistency check
@@ -95,6 +102,8 @@ struct ConsistencyCheckWorkload : TestWorkload
 		failureIsError = getOption(options, LiteralStringRef("failureIsError"), false);
 		rateLimitMax = getOption(options, LiteralStringRef("rateLimitMax"), 0);
 		shuffleShards = getOption(options, LiteralStringRef("shuffleShards"), false);
+		useChecksums = getOption(options, LiteralStringRef("useChecksums"), false);
+		checksumBytes = std::max<int64_t>(getOption(options, LiteralStringRef("checksumBytes"), CLIENT_KNOBS->CONSISTENCY_CHECK_CHECKSUM_BYTES), 1);
 		indefinite = getOption(options, LiteralStringRef("indefinite"), false);
 		suspendConsistencyCheck.set(true);
 
@@ -315,7 +324,10 @@ struct ConsistencyCheckWorkload : TestWorkload
 						state Standalone<VectorRef<KeyValueRef>> keyLocations = keyLocationPromise.getFuture().get();
 
 						//Check that each shard has the same data on all storage servers that it resides on
-						wait(::success(self->checkDataConsistency(cx, keyLocations, configuration, self)));
+						if(self->useChecksums)
+							wait(::success(self->checkDataConsistencyByChecksum(cx, keyLocations, configuration, self)));
+						else
+							wait(::success(self->checkDataConsistency(cx, keyLocations, configuration, self)));
 					}
 				}
 			}
@@ -605,6 +617,197 @@ struct ConsistencyCheckWorkload : TestWorkload
 		}
 	}
 
+	Key checksumCursorKey() const { return fdbConsistencyCheckCursorPrefix.withSuffix(format("%d", clientId)); }
+
+	//Reads the key from which this client's checksum check resumes
+	ACTOR Future<Key> getChecksumCursor(Database cx, ConsistencyCheckWorkload *self)
+	{
+		state Transaction tr(cx);
+		loop {
+			try {
+				tr.setOption(FDBTransactionOptions::ACCESS_SYSTEM_KEYS);
+				tr.setOption(FDBTransactionOptions::LOCK_AWARE);
+				Optional<Value> cursor = wait(tr.get(self->checksumCursorKey()));
+				return cursor.present() ? Key(cursor.get()) : Key();
+			} catch( Error &e ) {
+				wait( tr.onError(e) );
+			}
+		}
+	}
+
+	//Saves the key from which this client's checksum check resumes, or clears it once the whole database has been checked
+	ACTOR Future<Void> setChecksumCursor(Database cx, ConsistencyCheckWorkload *self, Optional<Key> cursor)
+	{
+		state Transaction tr(cx);
+		loop {
+			try {
+				tr.setOption(FDBTransactionOptions::ACCESS_SYSTEM_KEYS);
+				tr.setOption(FDBTransactionOptions::LOCK_AWARE);
+				if(cursor.present())
+					tr.set(self->checksumCursorKey(), cursor.get());
+				else
+					tr.clear(self->checksumCursorKey());
+				wait(tr.commit());
+				return Void();
+			} catch( Error &e ) {
+				wait( tr.onError(e) );
+			}
+		}
+	}
+
+	//Checks that each shard is the same on each storage server that it resides on by comparing checksums of it computed by
+	//the storage servers, in requests of checksumBytes.  The check reads at most rateLimitMax bytes per second from each
+	//server, and saves its position after each request so that a restarted check continues where it stopped.
+	//Out of every <shardSampleFactor> shards, 1 is checked, and the sample moves by one shard with each repetition.
+	//Returns false if there is a failure
+	ACTOR Future<bool> checkDataConsistencyByChecksum(Database cx, VectorRef<KeyValueRef> keyLocations, DatabaseConfiguration configuration, ConsistencyCheckWorkload *self)
+	{
+		state int effectiveClientCount = (self->distributed) ? self->clientCount : 1;
+		state int sampleStride = effectiveClientCount * self->shardSampleFactor;
+		state int sampleOffset = ((self->distributed ? self->clientId : 0) + (self->repetitions % self->shardSampleFactor) * effectiveClientCount) % sampleStride;
+		state Reference<IRateControl> rateLimiter = Reference<IRateControl>( new SpeedLimit(self->rateLimitMax, 1) );
+		state Span span(deterministicRandom()->randomUniqueID(), "WL:ConsistencyCheckChecksum"_loc);
+		state Key cursor = wait(self->getChecksumCursor(cx, self));
+		state int64_t bytesChecked = 0;
+		state int k = 0;
+
+		TraceEvent("ConsistencyCheck_ChecksumStart").detail("Cursor", printable(cursor)).detail("RateLimit", self->rateLimitMax);
+
+		for(k = 0; k < keyLocations.size() - 1; k++)
+		{
+			state KeyRangeRef range(keyLocations[k].key, keyLocations[k + 1].key);
+			if(k % sampleStride != sampleOffset || range.end <= cursor)
+				continue;
+
+			state vector<UID> sourceStorageServers;
+			state vector<UID> destStorageServers;
+			state vector<StorageServerInterface> storageServerInterfaces;
+			state Transaction tr(cx);
+			tr.setOption(FDBTransactionOptions::LOCK_AWARE);
+			loop {
+				try {
+					Standalone<RangeResultRef> UIDtoTagMap = wait( tr.getRange( serverTagKeys, CLIENT_KNOBS->TOO_MANY ) );
+					ASSERT( !UIDtoTagMap.more && UIDtoTagMap.size() < CLIENT_KNOBS->TOO_MANY );
+					decodeKeyServersValue(UIDtoTagMap, keyLocations[k].value, sourceStorageServers, destStorageServers, false);
+
+					state vector<UID> storageServers = destStorageServers.size() > 0 ? destStorageServers : sourceStorageServers;
+					vector< Future< Optional<Value> > > serverListEntries;
+					for(int s=0; s<storageServers.size(); s++)
+						serverListEntries.push_back( tr.get( serverListKeyFor(storageServers[s]) ) );
+					state vector<Optional<Value>> serverListValues = wait( getAll(serverListEntries) );
+					storageServerInterfaces.clear();
+					for(int s=0; s<serverListValues.size(); s++) {
+						if (serverListValues[s].present())
+							storageServerInterfaces.push_back( decodeServerListValue(serverListValues[s].get()) );
+						else if (self->performQuiescentChecks)
+							self->testFailure("/FF/serverList changing in a quiescent database");
+					}
+					break;
+				}
+				catch(Error &e) {
+					wait( tr.onError(e) );
+				}
+			}
+
+			state Key begin = std::max<KeyRef>(range.begin, cursor);
+			state Transaction onErrorTr(cx); // This transaction exists only to access onError and its backoff behavior
+			loop
+			{
+				try
+				{
+					Version version = wait(self->getVersion(cx, self));
+					state GetRangeChecksumRequest req(span.context, KeyRangeRef(begin, range.end), version, self->checksumBytes, Optional<UID>());
+
+					state vector<Future<ErrorOr<GetRangeChecksumReply>>> checksumFutures;
+					for(int j = 0; j < storageServerInterfaces.size(); j++)
+					{
+						resetReply(req);
+						checksumFutures.push_back(storageServerInterfaces[j].getRangeChecksum.getReplyUnlessFailedFor(req, 2, 0));
+					}
+					wait(waitForAll(checksumFutures));
+
+					state int firstValidServer = -1;
+					state int64_t bytesRead = 0;
+					for(int j = 0; j < checksumFutures.size(); j++)
+					{
+						ErrorOr<GetRangeChecksumReply> current = checksumFutures[j].get();
+						if(!current.present())
+						{
+							TraceEvent("ConsistencyCheck_StorageServerUnavailable").suppressFor(1.0).error(current.getError())
+								.detail("StorageServer", storageServerInterfaces[j].id()).detail("ShardBegin", printable(range.begin)).detail("ShardEnd", printable(range.end))
+								.detail("Address", storageServerInterfaces[j].address());
+
+							//All shards should be available in quiscence
+							if(self->performQuiescentChecks)
+							{
+								self->testFailure("Storage server unavailable");
+								return false;
+							}
+							continue;
+						}
+
+						bytesRead = std::max(bytesRead, current.get().bytes);
+						if(firstValidServer == -1)
+						{
+							firstValidServer = j;
+							continue;
+						}
+
+						GetRangeChecksumReply const& reference = checksumFutures[firstValidServer].get().get();
+						if(current.get().checksum != reference.checksum || current.get().keys != reference.keys ||
+						   current.get().bytes != reference.bytes || current.get().more != reference.more ||
+						   current.get().readThrough != reference.readThrough)
+						{
+							TraceEvent("ConsistencyCheck_ChecksumMismatch")
+								.detail(format("StorageServer%d", j).c_str(), storageServerInterfaces[j].id())
+								.detail(format("StorageServer%d", firstValidServer).c_str(), storageServerInterfaces[firstValidServer].id())
+								.detail("RangeBegin", printable(req.range.begin))
+								.detail("RangeEnd", printable(req.range.end))
+								.detail("VersionNumber", req.version)
+								.detail(format("Server%dChecksum", j).c_str(), current.get().checksum)
+								.detail(format("Server%dChecksum", firstValidServer).c_str(), reference.checksum)
+								.detail(format("Server%dKeys", j).c_str(), current.get().keys)
+								.detail(format("Server%dKeys", firstValidServer).c_str(), reference.keys)
+								.detail(format("Server%dReadThrough", j).c_str(), printable(current.get().readThrough))
+								.detail(format("Server%dReadThrough", firstValidServer).c_str(), printable(reference.readThrough));
+
+							self->testFailure("Data inconsistent", true);
+							return false;
+						}
+					}
+
+					//Each server read about as much as the largest reply, so charge that against the per-server limit
+					if(self->rateLimitMax > 0)
+						wait(rateLimiter->getAllowance(bytesRead));
+					bytesChecked += bytesRead;
+
+					if(firstValidServer >= 0 && checksumFutures[firstValidServer].get().get().more)
+						begin = checksumFutures[firstValidServer].get().get().readThrough;
+					else if(firstValidServer >= 0)
+						begin = range.end;
+					else
+						throw all_alternatives_failed();
+
+					cursor = begin;
+					wait(self->setChecksumCursor(cx, self, cursor));
+					if(begin == range.end)
+						break;
+				}
+				catch(Error &e)
+				{
+					state Error err = e;
+					wait(onErrorTr.onError(err));
+					TraceEvent("ConsistencyCheck_RetryChecksum").error(err);
+				}
+			}
+		}
+
+		//The whole database has been checked, so the next round starts from the beginning
+		wait(self->setChecksumCursor(cx, self, Optional<Key>()));
+		TraceEvent("ConsistencyCheck_ChecksumFinished").detail("BytesChecked", bytesChecked).detail("Repetitions", self->repetitions);
+		return true;
+	}
+
 	//Checks that the data in each shard is the same on each storage server that it resides on.  Also performs some sanity checks on the sizes of shards and storage servers.
 	//Returns false if there is a failure
 	ACTOR Future<bool> checkDataConsistency(Database cx, VectorRef<KeyValueRef> keyLocations, DatabaseConfiguration configuration, ConsistencyCheckWorkload *self)
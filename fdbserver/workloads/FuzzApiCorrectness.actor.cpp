@@ -24,6 +24,7 @@
 #include <sstream>
 
 #include "fdbserver/TesterInterface.actor.h"
+#include "fdbclient/Atomic.h"
 #include "fdbclient/ThreadSafeTransaction.h"
 #include "flow/ActorCollection.h"
 #include "fdbserver/workloads/workloads.actor.h"
@@ -939,7 +940,8 @@ struct FuzzApiCorrectnessWorkload : TestWorkload {
 							(key >= (workload->useSystemKeys ? systemKeys.end : normalKeys.end))) ),
 				std::make_pair( error_code_client_invalid_operation, ExceptionContract::requiredIf(
 							(op == MutationRef::SetVersionstampedKey && (pos < 0 || pos + 10 > key.size() - 4)) ||
-							(op == MutationRef::SetVersionstampedValue && (pos < 0 || pos + 10 > value.size() - 4))) )
+							(op == MutationRef::SetVersionstampedValue && (pos < 0 || pos + 10 > value.size() - 4)) ||
+							(op == MutationRef::CompareAndSet && !isValidCompareAndSetOperand(value))) )
 			};
 		}
 
@@ -0,0 +1,158 @@
+/*
+ * GetRangeStream.actor.cpp
+ *
+ * This source file is part of the FoundationDB open source project
+ *
+ * Copyright 2013-2020 Apple Inc. and the FoundationDB project authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "fdbclient/NativeAPI.actor.h"
+#include "fdbserver/TesterInterface.actor.h"
+#include "fdbserver/workloads/workloads.actor.h"
+#include "flow/actorcompiler.h"  // This must be the last #include.
+
+// Checks that Transaction::getRangeStream and getRangeParallel return the same rows as getRange at the same version
+struct GetRangeStreamWorkload : TestWorkload {
+	int nodeCount, valueBytes;
+	double testDuration;
+
+	vector<Future<Void>> clients;
+	PerfIntCounter streams, rowsCompared;
+	bool failed = false;
+
+	GetRangeStreamWorkload(WorkloadContext const& wcx)
+		: TestWorkload(wcx), streams("Streams"), rowsCompared("RowsCompared") {
+		nodeCount = getOption( options, LiteralStringRef("nodeCount"), 2000 );
+		valueBytes = getOption( options, LiteralStringRef("valueBytes"), 1000 );
+		testDuration = getOption( options, LiteralStringRef("testDuration"), 30.0 );
+	}
+
+	std::string description() const override { return "GetRangeStream"; }
+
+	Future<Void> setup(Database const& cx) override { return clientId ? Void() : setup(cx, this); }
+
+	Future<Void> start(Database const& cx) override {
+		clients.push_back( timeout( client( cx, this ), testDuration, Void() ) );
+		return waitForAll( clients );
+	}
+
+	Future<bool> check(Database const& cx) override {
+		clients.clear();
+		return !failed;
+	}
+
+	void getMetrics(vector<PerfMetric>& m) override {
+		m.push_back( streams.getMetric() );
+		m.push_back( rowsCompared.getMetric() );
+	}
+
+	Key keyForIndex( int index ) const { return StringRef(format( "getRangeStream/%08d", index )); }
+
+	ACTOR static Future<Void> setup( Database cx, GetRangeStreamWorkload* self ) {
+		state int i = 0;
+		while( i < self->nodeCount ) {
+			state Transaction tr(cx);
+			loop {
+				try {
+					for( int j = i; j < std::min( i + 100, self->nodeCount ); j++ ) {
+						tr.set( self->keyForIndex( j ), Value( std::string( deterministicRandom()->randomInt( 0, self->valueBytes ), 'v' ) ) );
+					}
+					wait( tr.commit() );
+					break;
+				} catch( Error& e ) {
+					wait( tr.onError( e ) );
+				}
+			}
+			i += 100;
+		}
+		return Void();
+	}
+
+	ACTOR static Future<Void> client( Database cx, GetRangeStreamWorkload* self ) {
+		loop {
+			state Transaction tr(cx);
+			state int begin = deterministicRandom()->randomInt( 0, self->nodeCount );
+			state int end = deterministicRandom()->randomInt( begin, self->nodeCount + 1 );
+			state KeyRange keys = KeyRangeRef( self->keyForIndex( begin ), self->keyForIndex( end ) );
+			state GetRangeLimits limits = deterministicRandom()->coinflip()
+			                                  ? GetRangeLimits()
+			                                  : GetRangeLimits( deterministicRandom()->randomInt( 1, self->nodeCount ) );
+			loop {
+				try {
+					state Standalone<RangeResultRef> expected = wait( tr.getRange( keys, limits, true ) );
+					// getRange may stop early; keep reading until the limit or the end of the range
+					state GetRangeLimits rest = limits;
+					rest.decrement( expected );
+					while( expected.more && expected.size() && !rest.isReached() ) {
+						Standalone<RangeResultRef> next = wait( tr.getRange( KeyRangeRef( keyAfter( expected.back().key ), keys.end ), rest, true ) );
+						expected.arena().dependsOn( next.arena() );
+						expected.append( expected.arena(), next.begin(), next.size() );
+						expected.more = next.more;
+						rest.decrement( next );
+					}
+
+					// getRangeParallel reads the whole range, so it is only compared against unlimited reads
+					state bool parallel = !limits.hasRowLimit() && deterministicRandom()->coinflip();
+					state bool ordered = !parallel || deterministicRandom()->coinflip();
+					state PromiseStream<Standalone<RangeResultRef>> results;
+					state Future<Void> stream = parallel
+					    ? tr.getRangeParallel( results, keys, deterministicRandom()->randomInt( 1, 5 ), ordered, true )
+					    : tr.getRangeStream( results, keys, limits, true );
+					state Standalone<RangeResultRef> actual;
+					try {
+						loop {
+							Standalone<RangeResultRef> page = waitNext( results.getFuture() );
+							actual.arena().dependsOn( page.arena() );
+							actual.append( actual.arena(), page.begin(), page.size() );
+							// Take pages slowly now and then so the storage server has to wait for acknowledgements
+							if( deterministicRandom()->random01() < 0.05 ) {
+								wait( delay( deterministicRandom()->random01() ) );
+							}
+						}
+					} catch( Error& e ) {
+						if( e.code() != error_code_end_of_stream ) throw;
+					}
+					if( !ordered ) {
+						std::sort( actual.begin(), actual.end(), KeyValueRef::OrderByKey() );
+					}
+
+					if( actual.size() != expected.size() ) {
+						TraceEvent(SevError, "GetRangeStreamRowCountMismatch")
+						    .detail("Begin", keys.begin).detail("End", keys.end).detail("Limit", limits.rows)
+						    .detail("Parallel", parallel).detail("Ordered", ordered)
+						    .detail("Expected", expected.size()).detail("Actual", actual.size());
+						self->failed = true;
+					} else {
+						for( int i = 0; i < actual.size(); i++ ) {
+							if( actual[i] != expected[i] ) {
+								TraceEvent(SevError, "GetRangeStreamRowMismatch")
+								    .detail("Index", i).detail("Expected", expected[i].key).detail("Actual", actual[i].key);
+								self->failed = true;
+								break;
+							}
+						}
+					}
+					++self->streams;
+					self->rowsCompared += actual.size();
+					break;
+				} catch( Error& e ) {
+					wait( tr.onError( e ) );
+				}
+			}
+		}
+	}
+};
+
+WorkloadFactory<GetRangeStreamWorkload> GetRangeStreamWorkloadFactory("GetRangeStream");
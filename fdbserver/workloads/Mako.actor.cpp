@@ -42,6 +42,8 @@ struct MakoWorkload : TestWorkload {
 	std::vector<PerfMetric> periodicMetrics;
 	// store latency of each operation with sampling
 	std::vector<ContinuousSample<double>> opLatencies;
+	// CPU time of the benchmark
+	PerfWorkloadMetrics perfMetrics;
 	// key used to store checkSum for given key range
 	std::vector<Key> csKeys;
 	// key prefix of for all generated keys
@@ -225,6 +227,13 @@ struct MakoWorkload : TestWorkload {
 				}
 			}
 
+			// Standard performance metrics, for comparison against a baseline run
+			for (const int& op : opExecutedAtOnce) {
+				PerfWorkloadMetrics::addOperation(m, opNames[op], testDuration, opCounters[op].getValue(), 0,
+				                                  opLatencies[op]);
+			}
+			perfMetrics.addCPU(m, totalOps.getValue());
+
 			// insert logging metrics if exists
 			m.insert(m.end(), periodicMetrics.begin(), periodicMetrics.end());
 		}
@@ -392,6 +401,7 @@ struct MakoWorkload : TestWorkload {
 
 		if (self->enableLogging) clients.push_back(tracePeriodically(self));
 
+		self->perfMetrics.measureCPU(0, self->testDuration);
 		wait(timeout(waitForAll(clients), self->testDuration, Void()));
 		return Void();
 	}
@@ -259,6 +259,32 @@ struct RYWPerformanceWorkload : TestWorkload {
 		}
 	}
 
+	ACTOR static Future<Void> test_blind_sets( Database cx, RYWPerformanceWorkload* self ) {
+		state ReadYourWritesTransaction tr( cx );
+		state std::vector<Key> keys;
+		for( int i = 0; i < self->nodes; i++ ) {
+			keys.push_back( self->keyForIndex(i) );
+		}
+		deterministicRandom()->randomShuffle(keys);
+
+		loop {
+			try {
+				state double startTime = timer();
+
+				for( auto& k : keys ) {
+					tr.set( k, LiteralStringRef("bar") );
+				}
+				wait( tr.commit() );
+
+				fprintf(stderr, "%f", self->nodes / (timer() - startTime));
+
+				return Void();
+			} catch( Error &e ) {
+				wait( tr.onError(e) );
+			}
+		}
+	}
+
 	ACTOR static Future<Void> _start( Database cx, RYWPerformanceWorkload* self ) {
 		state int i;
 		fprintf(stderr, "test_get_single, ");
@@ -285,6 +311,9 @@ struct RYWPerformanceWorkload : TestWorkload {
 			if( i == 13 ) fprintf(stderr, "\n");
 			else fprintf(stderr, ", ");
 		}
+		fprintf(stderr, "test_blind_sets, ");
+		wait( self->test_blind_sets( cx, self ) );
+		fprintf(stderr, "\n");
 		return Void();
 	}
 
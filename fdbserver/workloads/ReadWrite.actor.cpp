@@ -116,6 +116,7 @@ struct ReadWriteWorkload : KVWorkload {
 	std::vector<std::pair<uint64_t, double> > ratesAtKeyCounts;
 
 	std::vector<PerfMetric> periodicMetrics;
+	PerfWorkloadMetrics perfMetrics;
 
 	bool doSetup;
 
@@ -305,6 +306,15 @@ struct ReadWriteWorkload : KVWorkload {
 		m.emplace_back("Bytes written/sec", (writes * (keyBytes + (minValueBytes+maxValueBytes)*0.5)) / duration, false);
 		m.insert(m.end(), periodicMetrics.begin(), periodicMetrics.end());
 
+		int64_t rowBytes = keyBytes + (minValueBytes + maxValueBytes) / 2;
+		int64_t transactions = aTransactions.getValue() + bTransactions.getValue();
+		PerfWorkloadMetrics::addOperation(m, "Transaction", duration, transactions, 0, latencies);
+		PerfWorkloadMetrics::addOperation(m, "GRV", duration, GRVLatencies.getPopulationSize(), 0, GRVLatencies);
+		PerfWorkloadMetrics::addOperation(m, "Read", duration, reads, reads * rowBytes, readLatencies);
+		PerfWorkloadMetrics::addOperation(m, "Commit", duration, commitLatencies.getPopulationSize(), writes * rowBytes,
+		                                  commitLatencies);
+		perfMetrics.addCPU(m, reads + writes);
+
 		std::vector<std::pair<uint64_t, double> >::iterator ratesItr = ratesAtKeyCounts.begin();
 		for(; ratesItr != ratesAtKeyCounts.end(); ratesItr++)
 			m.emplace_back(format("%ld keys imported bytes/sec", ratesItr->first), ratesItr->second, false);
@@ -526,6 +536,7 @@ struct ReadWriteWorkload : KVWorkload {
 			clients.push_back(tracePeriodically(self));
 
 		self->clientBegin = now();
+		self->perfMetrics.measureCPU(self->metricsStart, self->metricsDuration);
 		for(int c = 0; c < self->actorCount; c++) {
 			Future<Void> worker;
 			if (self->useRYW)
@@ -29,6 +29,7 @@ struct StreamingReadWorkload : TestWorkload {
 	int actorCount, keyBytes, valueBytes, readsPerTransaction, nodeCount;
 	int rangesPerTransaction;
 	bool readSequentially;
+	bool useStream; // Read each range with Transaction::getRangeStream rather than getRange
 	double testDuration, warmingDelay;
 	Value constantValue;
 
@@ -52,6 +53,7 @@ struct StreamingReadWorkload : TestWorkload {
 		warmingDelay = getOption( options, LiteralStringRef("warmingDelay"), 0.0 );
 		constantValue = Value( format( valueFormat.c_str(), 42 ) );
 		readSequentially = getOption( options, LiteralStringRef("readSequentially"), false);
+		useStream = getOption( options, LiteralStringRef("useStream"), false);
 	}
 
 	std::string description() const override { return "StreamingRead"; }
@@ -120,19 +122,39 @@ struct StreamingReadWorkload : TestWorkload {
 						else if(currentIndex > maxIndex - thisRangeSize)
 							currentIndex = minIndex;
 
-						Standalone<RangeResultRef> values = 
-							wait( tr.getRange(
-								firstGreaterOrEqual( self->keyForIndex( currentIndex ) ),
-								firstGreaterOrEqual( self->keyForIndex( currentIndex + thisRangeSize ) ),
-								thisRangeSize ) );
-	
-						for(int i = 0; i < values.size(); i++)
-							self->readValueBytes += values[i].value.size();
+						state int rowsRead = 0;
+						if(self->useStream) {
+							state PromiseStream<Standalone<RangeResultRef>> results;
+							state Future<Void> stream = tr.getRangeStream( results,
+								KeyRangeRef( self->keyForIndex( currentIndex ), self->keyForIndex( currentIndex + thisRangeSize ) ),
+								GetRangeLimits( thisRangeSize ) );
+							try {
+								loop {
+									Standalone<RangeResultRef> page = waitNext( results.getFuture() );
+									for(int i = 0; i < page.size(); i++)
+										self->readValueBytes += page[i].value.size();
+									rowsRead += page.size();
+								}
+							} catch (Error& e) {
+								if(e.code() != error_code_end_of_stream)
+									throw;
+							}
+						} else {
+							Standalone<RangeResultRef> values =
+								wait( tr.getRange(
+									firstGreaterOrEqual( self->keyForIndex( currentIndex ) ),
+									firstGreaterOrEqual( self->keyForIndex( currentIndex + thisRangeSize ) ),
+									thisRangeSize ) );
+
+							for(int i = 0; i < values.size(); i++)
+								self->readValueBytes += values[i].value.size();
+							rowsRead = values.size();
+						}
 
 						if(self->readSequentially)
-							currentIndex += values.size();
-	
-						self->readKeys += values.size();
+							currentIndex += rowsRead;
+
+						self->readKeys += rowsRead;
 						break;
 					} catch (Error& e) {
 						wait( tr.onError(e) );
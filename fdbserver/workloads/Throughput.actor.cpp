@@ -178,10 +178,15 @@ struct MeasureSinglePeriod : IMeasurer {
 	
 	ContinuousSample<double> totalLatency, grvLatency, rowReadLatency, commitLatency;
 	ITransactor::Stats stats;  // totalled over the period
+	PerfWorkloadMetrics perfMetrics;
 
 	MeasureSinglePeriod( double delay, double duration ) : delay(delay), duration(duration), totalLatency(2000), grvLatency(2000), rowReadLatency(2000), commitLatency(2000) {}
 
-	virtual Future<Void> start() { startT = now(); return Void(); }
+	virtual Future<Void> start() {
+		startT = now();
+		perfMetrics.measureCPU(delay, duration);
+		return Void();
+	}
 	virtual void addTransaction(ITransactor::Stats* st, double now) {
 		if (!(now >= startT+delay && now < startT+delay+duration)) return;
 
@@ -214,6 +219,12 @@ struct MeasureSinglePeriod : IMeasurer {
 		m.push_back( PerfMetric( "Median GRV Latency (ms, averaged)", 1000 * grvLatency.median(), true ) );
 		m.push_back( PerfMetric( "Mean Commit Latency (ms)", 1000 * commitLatency.mean(), true ) );
 		m.push_back( PerfMetric( "Median Commit Latency (ms, averaged)", 1000 * commitLatency.median(), true ) );
+
+		PerfWorkloadMetrics::addOperation(m, "Transaction", measureDuration, stats.transactions, 0, totalLatency);
+		PerfWorkloadMetrics::addOperation(m, "GRV", measureDuration, stats.transactions, 0, grvLatency);
+		PerfWorkloadMetrics::addOperation(m, "Read", measureDuration, stats.reads, 0, rowReadLatency);
+		PerfWorkloadMetrics::addOperation(m, "Commit", measureDuration, commitLatency.getPopulationSize(), 0, commitLatency);
+		perfMetrics.addCPU(m, stats.reads + stats.writes);
 	}
 };
 
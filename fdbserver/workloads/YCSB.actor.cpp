@@ -0,0 +1,268 @@
+/*
+ * YCSB.actor.cpp
+ *
+ * This source file is part of the FoundationDB open source project
+ *
+ * Copyright 2013-2020 Apple Inc. and the FoundationDB project authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <array>
+
+#include "fdbclient/NativeAPI.actor.h"
+#include "fdbclient/ReadYourWrites.h"
+#include "fdbclient/zipf.h"
+#include "fdbserver/TesterInterface.actor.h"
+#include "fdbserver/workloads/BulkSetup.actor.h"
+#include "fdbserver/workloads/workloads.actor.h"
+#include "flow/actorcompiler.h" // This must be the last #include.
+
+// The core workloads of the Yahoo! Cloud Serving Benchmark, with its record layout, request distributions and
+// defaults, so that results can be set beside those published for other stores.  The workload option picks one:
+//   A  50% reads, 50% updates, zipfian
+//   B  95% reads, 5% updates, zipfian
+//   C  100% reads, zipfian
+//   D  95% reads, 5% inserts, latest
+//   E  95% scans, 5% inserts, zipfian
+//   F  50% reads, 50% read-modify-writes, zipfian
+// and each proportion and the request distribution can be overridden.  A record is fieldCount fields of fieldLength
+// bytes, each under its own key, and each operation is a transaction of its own whose latency includes its retries.
+struct YCSBWorkload : TestWorkload {
+	enum Op { READ, UPDATE, INSERT, SCAN, READ_MODIFY_WRITE, OP_COUNT };
+	enum Distribution { UNIFORM, ZIPFIAN, LATEST };
+
+	const std::array<std::string, OP_COUNT> opNames = { "READ", "UPDATE", "INSERT", "SCAN", "READ-MODIFY-WRITE" };
+
+	std::string workload;
+	int recordCount, fieldCount, fieldLength, maxScanLength, actorCountPerClient;
+	double testDuration, transactionsPerSecond, zipfianConstant;
+	bool readAllFields, writeAllFields, populateData;
+	Distribution distribution;
+	std::array<double, OP_COUNT> proportions;
+
+	zipfian_state zipfian;
+	int inserted; // The records this client has inserted
+	Key recordsEnd;
+
+	std::vector<ContinuousSample<double>> latencies;
+	std::vector<PerfIntCounter> opCounts;
+	PerfIntCounter retries;
+	PerfWorkloadMetrics perfMetrics;
+	double loadTime;
+
+	YCSBWorkload(WorkloadContext const& wcx)
+	  : TestWorkload(wcx), inserted(0), recordsEnd(LiteralStringRef("user\xff")), retries("Retries"), loadTime(0) {
+		workload = getOption(options, LiteralStringRef("workload"), LiteralStringRef("A")).toString();
+		static const std::map<std::string, std::array<double, OP_COUNT>> presets = {
+			{ "A", { 0.5, 0.5, 0, 0, 0 } },    { "B", { 0.95, 0.05, 0, 0, 0 } }, { "C", { 1.0, 0, 0, 0, 0 } },
+			{ "D", { 0.95, 0, 0.05, 0, 0 } }, { "E", { 0, 0, 0.05, 0.95, 0 } }, { "F", { 0.5, 0, 0, 0, 0.5 } },
+		};
+		auto preset = presets.find(workload);
+		ASSERT(preset != presets.end());
+		proportions = preset->second;
+		proportions[READ] = getOption(options, LiteralStringRef("readProportion"), proportions[READ]);
+		proportions[UPDATE] = getOption(options, LiteralStringRef("updateProportion"), proportions[UPDATE]);
+		proportions[INSERT] = getOption(options, LiteralStringRef("insertProportion"), proportions[INSERT]);
+		proportions[SCAN] = getOption(options, LiteralStringRef("scanProportion"), proportions[SCAN]);
+		proportions[READ_MODIFY_WRITE] =
+		    getOption(options, LiteralStringRef("readModifyWriteProportion"), proportions[READ_MODIFY_WRITE]);
+
+		std::string requestDistribution =
+		    getOption(options, LiteralStringRef("requestDistribution"),
+		              workload == "D" ? LiteralStringRef("latest") : LiteralStringRef("zipfian"))
+		        .toString();
+		ASSERT(requestDistribution == "uniform" || requestDistribution == "zipfian" || requestDistribution == "latest");
+		distribution = requestDistribution == "uniform" ? UNIFORM : requestDistribution == "zipfian" ? ZIPFIAN : LATEST;
+		zipfianConstant = getOption(options, LiteralStringRef("zipfianConstant"), ZIPFIAN_CONSTANT);
+
+		recordCount = getOption(options, LiteralStringRef("recordCount"), 1000);
+		fieldCount = getOption(options, LiteralStringRef("fieldCount"), 10);
+		fieldLength = getOption(options, LiteralStringRef("fieldLength"), 100);
+		maxScanLength = getOption(options, LiteralStringRef("maxScanLength"), 1000);
+		readAllFields = getOption(options, LiteralStringRef("readAllFields"), true);
+		writeAllFields = getOption(options, LiteralStringRef("writeAllFields"), false);
+		ASSERT(recordCount > 0 && fieldCount > 0 && fieldCount <= 100 && maxScanLength > 0);
+
+		testDuration = getOption(options, LiteralStringRef("testDuration"), 30.0);
+		transactionsPerSecond = getOption(options, LiteralStringRef("transactionsPerSecond"), 10000.0) / clientCount;
+		actorCountPerClient = getOption(options, LiteralStringRef("actorCountPerClient"), 64);
+		populateData = getOption(options, LiteralStringRef("populateData"), true);
+
+		zipfian_init(&zipfian, 0, recordCount - 1, zipfianConstant);
+		for (int op = 0; op < OP_COUNT; op++) {
+			latencies.emplace_back(10000);
+			opCounts.emplace_back(opNames[op]);
+		}
+	}
+
+	std::string description() const override { return "YCSB"; }
+
+	Future<Void> setup(Database const& cx) override { return populateData ? _setup(cx, this) : Void(); }
+
+	Future<Void> start(Database const& cx) override { return _start(cx, this); }
+
+	Future<bool> check(Database const& cx) override { return true; }
+
+	void getMetrics(std::vector<PerfMetric>& m) override {
+		if (populateData) {
+			m.emplace_back("Mean load time (seconds)", loadTime, true);
+		}
+		int64_t operations = 0;
+		for (int op = 0; op < OP_COUNT; op++) {
+			if (proportions[op] > 0) {
+				m.push_back(opCounts[op].getMetric());
+				PerfWorkloadMetrics::addOperation(m, opNames[op], testDuration, opCounts[op].getValue(), 0,
+				                                  latencies[op]);
+				operations += opCounts[op].getValue();
+			}
+		}
+		m.emplace_back("Operations/sec", operations / testDuration, false);
+		m.push_back(retries.getMetric());
+		perfMetrics.addCPU(m, operations);
+	}
+
+	// Record keys are ordered by record number, which bulkSetup relies on
+	Key recordKey(int keyNum) const { return StringRef(format("user%010d", keyNum)); }
+	Key fieldKey(int keyNum, int field) const { return StringRef(format("user%010d/field%02d", keyNum, field)); }
+	KeyRange recordRange(int keyNum) const {
+		Key key = recordKey(keyNum);
+		return KeyRangeRef(key.withSuffix(LiteralStringRef("/")), key.withSuffix(LiteralStringRef("0")));
+	}
+
+	// For bulkSetup, which loads each field of the initial records as a node
+	Key keyForIndex(uint64_t index) const { return fieldKey(index / fieldCount, index % fieldCount); }
+	Standalone<KeyValueRef> operator()(uint64_t index) {
+		return KeyValueRef(keyForIndex(index), StringRef(deterministicRandom()->randomAlphaNumeric(fieldLength)));
+	}
+
+	static uint64_t fnvHash64(uint64_t value) {
+		uint64_t hash = 0xCBF29CE484222325ULL;
+		for (int i = 0; i < 8; i++) {
+			hash ^= value & 0xff;
+			hash *= 0x100000001B3ULL;
+			value >>= 8;
+		}
+		return hash;
+	}
+
+	Op chooseOperation() const {
+		double total = 0;
+		for (double p : proportions) {
+			total += p;
+		}
+		double r = deterministicRandom()->random01() * total;
+		for (int op = 0; op < OP_COUNT; op++) {
+			if (r < proportions[op]) {
+				return (Op)op;
+			}
+			r -= proportions[op];
+		}
+		return READ;
+	}
+
+	// Records up to here may exist, counting those that the other clients are assumed to have inserted at this client's
+	// rate.  Inserted records are numbered from recordCount, interleaved between the clients.
+	int knownRecords() const { return recordCount + inserted * clientCount; }
+	int nextInsertKeyNum() { return recordCount + clientId + clientCount * inserted++; }
+
+	int nextKeyNum() {
+		int items = knownRecords();
+		switch (distribution) {
+		case UNIFORM:
+			return deterministicRandom()->randomInt(0, items);
+		case ZIPFIAN:
+			// Scrambled as in YCSB, so that the popular records are spread over the key space instead of being the
+			// first records of it
+			return fnvHash64(zipfian_next_with(&zipfian, items, deterministicRandom()->random01())) % items;
+		case LATEST:
+		default:
+			return items - 1 - zipfian_next_with(&zipfian, items, deterministicRandom()->random01());
+		}
+	}
+
+	Future<Void> read(ReadYourWritesTransaction* tr, int keyNum) const {
+		if (readAllFields) {
+			return success(tr->getRange(recordRange(keyNum), fieldCount));
+		}
+		return success(tr->get(fieldKey(keyNum, deterministicRandom()->randomInt(0, fieldCount))));
+	}
+
+	void write(ReadYourWritesTransaction* tr, int keyNum, bool allFields) const {
+		if (allFields) {
+			for (int field = 0; field < fieldCount; field++) {
+				tr->set(fieldKey(keyNum, field), StringRef(deterministicRandom()->randomAlphaNumeric(fieldLength)));
+			}
+		} else {
+			tr->set(fieldKey(keyNum, deterministicRandom()->randomInt(0, fieldCount)),
+			        StringRef(deterministicRandom()->randomAlphaNumeric(fieldLength)));
+		}
+	}
+
+	ACTOR static Future<Void> _setup(Database cx, YCSBWorkload* self) {
+		state Promise<double> loadTime;
+		wait(bulkSetup(cx, self, (uint64_t)self->recordCount * self->fieldCount, loadTime));
+		self->loadTime = loadTime.getFuture().get();
+		return Void();
+	}
+
+	ACTOR static Future<Void> _start(Database cx, YCSBWorkload* self) {
+		state std::vector<Future<Void>> clients;
+		for (int c = 0; c < self->actorCountPerClient; c++) {
+			clients.push_back(ycsbClient(cx, self, self->actorCountPerClient / self->transactionsPerSecond));
+		}
+		self->perfMetrics.measureCPU(0, self->testDuration);
+		wait(timeout(waitForAll(clients), self->testDuration, Void()));
+		return Void();
+	}
+
+	ACTOR static Future<Void> ycsbClient(Database cx, YCSBWorkload* self, double delay) {
+		state ReadYourWritesTransaction tr(cx);
+		state double lastTime = now();
+		state Op op;
+		state int keyNum;
+		state int scanLength;
+		state double begin;
+
+		loop {
+			wait(poisson(&lastTime, delay));
+			op = self->chooseOperation();
+			keyNum = op == INSERT ? self->nextInsertKeyNum() : self->nextKeyNum();
+			scanLength = deterministicRandom()->randomInt(1, self->maxScanLength + 1);
+			begin = now();
+			tr.reset();
+			loop {
+				try {
+					if (op == READ || op == READ_MODIFY_WRITE) {
+						wait(self->read(&tr, keyNum));
+					} else if (op == SCAN) {
+						wait(success(tr.getRange(KeyRangeRef(self->recordKey(keyNum), self->recordsEnd),
+						                         scanLength * self->fieldCount)));
+					}
+					if (op == UPDATE || op == READ_MODIFY_WRITE || op == INSERT) {
+						self->write(&tr, keyNum, op == INSERT || self->writeAllFields);
+						wait(tr.commit());
+					}
+					break;
+				} catch (Error& e) {
+					wait(tr.onError(e));
+					++self->retries;
+				}
+			}
+			self->latencies[op].addSample(now() - begin);
+			++self->opCounts[op];
+		}
+	}
+};
+
+WorkloadFactory<YCSBWorkload> YCSBWorkloadFactory("YCSB");
@@ -28,6 +28,7 @@
 #include "fdbclient/NativeAPI.actor.h"
 #include "fdbclient/DatabaseContext.h" // for clone()
 #include "fdbserver/TesterInterface.actor.h"
+#include "fdbrpc/ContinuousSample.h"
 #include "fdbrpc/simulator.h"
 #include "flow/actorcompiler.h"
 
@@ -110,6 +111,28 @@ struct KVWorkload : TestWorkload {
 	Key keyForIndex(uint64_t index, bool absent) const;
 };
 
+// The metrics that performance workloads report in one schema alongside their own, so that the tester can write any
+// performance test out as JSON and compare it against a baseline run (see perfResultsFile and perfBaselineFile).
+// Each one is named Perf/<operation>/<statistic>.
+struct PerfWorkloadMetrics {
+	double cpuSeconds;
+	Future<Void> cpuMeasurement;
+
+	PerfWorkloadMetrics() : cpuSeconds(0) {}
+
+	// Measures the CPU time of this process over the window that starts startDelay seconds from now
+	void measureCPU(double startDelay, double duration);
+
+	// Adds the throughput, latency percentiles and, if bytes is non-zero, the bytes per operation of count operations
+	// of one kind done over duration seconds
+	static void addOperation(vector<PerfMetric>& m, std::string const& operation, double duration, int64_t count,
+	                         int64_t bytes, ContinuousSample<double>& latencies);
+
+	// Adds the CPU time per operation over the measured window. Tester clients share a process in simulation, so it is
+	// only reported on real clusters.
+	void addCPU(vector<PerfMetric>& m, int64_t count) const;
+};
+
 struct IWorkloadFactory {
 	static TestWorkload* create( std::string const& name, WorkloadContext const& wcx ) {
 		auto it = factories().find(name);
@@ -166,6 +189,7 @@ public:
 		simConnectionFailuresDisableDuration = 0;
 		simBackupAgents = ISimulator::BackupAgentType::NoBackupAgents;
 		simDrAgents = ISimulator::BackupAgentType::NoBackupAgents;
+		perfRegressionThreshold = 0.1;
 	}
 	TestSpec(StringRef title, bool dump, bool clear, double startDelay = 30.0, bool useDB = true,
 	         double databasePingDelay = -1.0)
@@ -173,7 +197,7 @@ public:
 	    databasePingDelay(databasePingDelay), runConsistencyCheck(g_network->isSimulated()),
 	    waitForQuiescenceBegin(true), waitForQuiescenceEnd(true), simCheckRelocationDuration(false),
 	    simConnectionFailuresDisableDuration(0), simBackupAgents(ISimulator::BackupAgentType::NoBackupAgents),
-	    simDrAgents(ISimulator::BackupAgentType::NoBackupAgents) {
+	    simDrAgents(ISimulator::BackupAgentType::NoBackupAgents), perfRegressionThreshold(0.1) {
 		phases = TestWorkload::SETUP | TestWorkload::EXECUTION | TestWorkload::CHECK | TestWorkload::METRICS;
 		if( databasePingDelay < 0 )
 			databasePingDelay = g_network->isSimulated() ? 0.0 : 15.0;
@@ -196,6 +220,10 @@ public:
 	double simConnectionFailuresDisableDuration;
 	ISimulator::BackupAgentType simBackupAgents; //If set to true, then the simulation runs backup agents on the workers. Can only be used in simulation.
 	ISimulator::BackupAgentType simDrAgents;
+
+	std::string perfResultsFile; // If set, the aggregated metrics of the test are written here as JSON
+	std::string perfBaselineFile; // If set, the test fails if a Perf/ metric regressed from this earlier results file
+	double perfRegressionThreshold; // The relative change in a Perf/ metric that counts as a regression
 };
 
 ACTOR Future<DistributedTestResults> runWorkload(Database cx, std::vector<TesterInterface> testers, TestSpec spec);
@@ -0,0 +1,144 @@
+/*
+ * ActorProfiler.cpp
+ *
+ * This source file is part of the FoundationDB open source project
+ *
+ * Copyright 2013-2020 Apple Inc. and the FoundationDB project authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "flow/ActorProfiler.h"
+#include "flow/flow.h"
+#include "flow/UnitTest.h"
+
+#include <cinttypes>
+
+namespace {
+
+struct ActorClocks {
+	uint64_t clocks = 0;
+	uint64_t calls = 0;
+};
+
+struct ActorProfilerState {
+	const char* currentActor = nullptr;
+	uint64_t lastTimestamp = 0;
+	// Keyed by the actor compiler's name literal; the same actor may appear under several pointers across translation
+	// units, which logReport() merges by name.
+	std::unordered_map<const char*, ActorClocks> actors;
+
+	const char* slowestActor = nullptr;
+	uint64_t slowestClocks = 0;
+
+	// Charges the clocks since the last push or pop to the running actor
+	void charge() {
+		uint64_t now = timestampCounter();
+		if (currentActor && now > lastTimestamp) {
+			uint64_t clocks = now - lastTimestamp;
+			actors[currentActor].clocks += clocks;
+			if (clocks > slowestClocks) {
+				slowestClocks = clocks;
+				slowestActor = currentActor;
+			}
+		}
+		lastTimestamp = now;
+	}
+};
+
+thread_local ActorProfilerState profilerState;
+
+} // namespace
+
+bool ActorProfiler::enabled = false;
+
+const char* ActorProfiler::push(const char* actorName) {
+	ActorProfilerState& state = profilerState;
+	state.charge();
+	const char* previous = state.currentActor;
+	state.currentActor = actorName;
+	state.actors[actorName].calls++;
+	return previous;
+}
+
+void ActorProfiler::pop(const char* previousActor) {
+	ActorProfilerState& state = profilerState;
+	state.charge();
+	state.currentActor = previousActor;
+}
+
+void ActorProfiler::beginTask() {
+	profilerState.slowestActor = nullptr;
+	profilerState.slowestClocks = 0;
+}
+
+const char* ActorProfiler::slowestActor() {
+	return profilerState.slowestActor;
+}
+
+void ActorProfiler::logReport() {
+	ActorProfilerState& state = profilerState;
+	if (state.actors.empty()) return;
+
+	std::map<std::string, ActorClocks> byName;
+	uint64_t totalClocks = 0;
+	for (auto& [name, clocks] : state.actors) {
+		ActorClocks& merged = byName[name];
+		merged.clocks += clocks.clocks;
+		merged.calls += clocks.calls;
+		totalClocks += clocks.clocks;
+	}
+	state.actors.clear();
+
+	std::vector<std::pair<uint64_t, std::string>> busiest;
+	for (auto& [name, clocks] : byName) {
+		busiest.emplace_back(clocks.clocks, name);
+	}
+	int top = std::min<int>(busiest.size(), FLOW_KNOBS->ACTOR_PROFILER_TOP_ACTORS);
+	std::partial_sort(busiest.begin(), busiest.begin() + top, busiest.end(), std::greater<>());
+
+	TraceEvent e("ActorProfile");
+	e.detail("TotalMClocks", totalClocks / 1e6).detail("Actors", byName.size());
+	for (int i = 0; i < top; i++) {
+		const std::string& name = busiest[i].second;
+		e.detail(name.c_str(), format("%.3f %" PRIu64, busiest[i].first / 1e6, byName[name].calls));
+	}
+}
+
+TEST_CASE("/flow/ActorProfiler/exclusiveTime") {
+	bool wasEnabled = ActorProfiler::enabled;
+	ActorProfiler::enabled = true;
+	ActorProfiler::logReport();
+
+	const char* running = profilerState.currentActor;
+	static const char* outer = "ActorProfilerTestOuter";
+	static const char* inner = "ActorProfilerTestInner";
+	ActorProfiler::beginTask();
+	{
+		ActorProfilerScope a(outer);
+		{
+			ActorProfilerScope b(inner);
+			double until = timer() + 0.01;
+			while (timer() < until) {}
+		}
+	}
+	ASSERT(ActorProfiler::slowestActor() == inner);
+	ASSERT(profilerState.actors[inner].calls == 1 && profilerState.actors[outer].calls == 1);
+	ASSERT(profilerState.actors[inner].clocks > profilerState.actors[outer].clocks);
+	ASSERT(profilerState.currentActor == running);
+
+	ActorProfiler::logReport();
+	ASSERT(profilerState.actors.empty());
+	ActorProfiler::enabled = wasEnabled;
+	return Void();
+}
@@ -0,0 +1,70 @@
+/*
+ * ActorProfiler.h
+ *
+ * This source file is part of the FoundationDB open source project
+ *
+ * Copyright 2013-2020 Apple Inc. and the FoundationDB project authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FLOW_ACTORPROFILER_H
+#define FLOW_ACTORPROFILER_H
+#pragma once
+
+#include <cstdint>
+
+/*
+ * Attributes run loop time to the actors whose code consumed it. The actor compiler wraps every actor constructor and
+ * callback in an ActorProfilerScope, and while profiling is enabled (FLOW_KNOBS->ACTOR_PROFILER) the time stamp
+ * counter clocks spent in a scope, excluding the nested scopes of other actors it fires, are charged to its actor.
+ */
+class ActorProfiler {
+public:
+	static bool enabled;
+
+	// Returns the actor that was running, to be restored by pop()
+	static const char* push(const char* actorName);
+	static void pop(const char* previousActor);
+
+	// Called by the run loop as each task begins, so that slowestActor() describes the task
+	static void beginTask();
+	// The actor that ran the longest without interruption in the current task, or nullptr
+	static const char* slowestActor();
+
+	// Logs the actors that used the most clocks since the last report, and resets them
+	static void logReport();
+};
+
+class ActorProfilerScope {
+public:
+	explicit ActorProfilerScope(const char* actorName) : active(ActorProfiler::enabled) {
+		if (active) {
+			previousActor = ActorProfiler::push(actorName);
+		}
+	}
+	~ActorProfilerScope() {
+		if (active) {
+			ActorProfiler::pop(previousActor);
+		}
+	}
+
+	ActorProfilerScope(ActorProfilerScope const&) = delete;
+	ActorProfilerScope& operator=(ActorProfilerScope const&) = delete;
+
+private:
+	bool active;
+	const char* previousActor = nullptr;
+};
+
+#endif
@@ -254,6 +254,7 @@ ArenaBlock* ArenaBlock::create(int dataSize, Reference<ArenaBlock>& next) {
 			INSTRUMENT_ALLOCATE("Arena64");
 		}
 		b->tinyUsed = TINY_HEADER;
+		arenaProfilerAllocated(b, b->tinySize);
 
 	} else {
 		int reqSize = dataSize + sizeof(ArenaBlock);
@@ -299,6 +300,7 @@ ArenaBlock* ArenaBlock::create(int dataSize, Reference<ArenaBlock>& next) {
 			}
 			b->tinySize = b->tinyUsed = NOT_TINY;
 			b->bigUsed = sizeof(ArenaBlock);
+			arenaProfilerAllocated(b, b->bigSize);
 		} else {
 #ifdef ALLOC_INSTRUMENTATION
 			allocInstr["ArenaHugeKB"].alloc((reqSize + 1023) >> 10);
@@ -315,6 +317,7 @@ ArenaBlock* ArenaBlock::create(int dataSize, Reference<ArenaBlock>& next) {
 				--g_allocation_tracing_disabled;
 			}
 			g_hugeArenaMemory.fetch_add(reqSize);
+			arenaProfilerAllocated(b, reqSize);
 
 			// If the new block has less free space than the old block, make the old block depend on it
 			if (next && !next->isTiny() && next->unused() >= reqSize - dataSize) {
@@ -362,6 +365,7 @@ void ArenaBlock::destroy() {
 }
 
 void ArenaBlock::destroyLeaf() {
+	arenaProfilerDestroyed(this);
 	if (isTiny()) {
 		if (tinySize <= 16) {
 			FastAllocator<16>::release(this);
@@ -38,6 +38,8 @@ public:
 	explicit ASIOReactor(Net2*);
 
 	void sleep(double timeout);
+	// Polls for ready handlers without blocking until one has run or the monotonic time reaches until
+	bool spin(double until);
 	void react();
 
 	void wake();
@@ -0,0 +1,598 @@
+/*
+ * BTreeIndexedSet.h
+ *
+ * This source file is part of the FoundationDB open source project
+ *
+ * Copyright 2013-2020 Apple Inc. and the FoundationDB project authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FLOW_BTREEINDEXEDSET_H
+#define FLOW_BTREEINDEXEDSET_H
+#pragma once
+
+#include <algorithm>
+
+#include "flow/Arena.h"
+
+// A set of T, each with a Metric, like IndexedSet<T, Metric> but kept in a B+-tree whose leaves hold up to
+// LeafCapacity elements side by side.  Searches and scans touch a few contiguous arrays rather than a node per element,
+// and each internal node keeps the total metric of each of its children, so that sumTo() and index() are as cheap as
+// a search.
+//
+// Unlike IndexedSet, elements move between nodes as others come and go, so inserting or erasing an element invalidates
+// every iterator into the set.  Iterators only give const access to the elements.
+template <class T, class Metric>
+class BTreeIndexedSet : NonCopyable {
+public:
+	typedef T value_type;
+	typedef T key_type;
+
+	enum { LeafCapacity = 32, InternalCapacity = 32 };
+
+private:
+	struct Internal;
+
+	struct NodeBase {
+		Internal* parent = nullptr;
+		int slot = 0; // This node is parent->children[slot]
+		int count = 0;
+		bool leaf;
+		explicit NodeBase(bool leaf) : leaf(leaf) {}
+	};
+
+	struct Leaf : NodeBase, FastAllocated<Leaf> {
+		Leaf* prev = nullptr;
+		Leaf* next = nullptr;
+		T data[LeafCapacity];
+		Metric metric[LeafCapacity];
+		Leaf() : NodeBase(true) {}
+	};
+
+	struct Internal : NodeBase, FastAllocated<Internal> {
+		NodeBase* children[InternalCapacity];
+		T bound[InternalCapacity]; // For i > 0, greater than everything in children[i-1] and at most anything in children[i]
+		Metric total[InternalCapacity]; // Of the elements under children[i]
+		Internal() : NodeBase(false) {}
+	};
+
+public:
+	struct iterator {
+		Leaf* leaf;
+		int pos;
+
+		explicit iterator(Leaf* leaf = nullptr, int pos = 0) : leaf(leaf), pos(pos) {}
+
+		const T& operator*() const { return leaf->data[pos]; }
+		const T* operator->() const { return &leaf->data[pos]; }
+
+		void operator++() {
+			if (++pos == leaf->count) {
+				leaf = leaf->next;
+				pos = 0;
+			}
+		}
+		void decrementNonEnd() {
+			if (pos > 0) {
+				--pos;
+			} else {
+				leaf = leaf->prev;
+				pos = leaf->count - 1;
+			}
+		}
+		bool operator==(const iterator& r) const { return leaf == r.leaf && pos == r.pos; }
+		bool operator!=(const iterator& r) const { return !(*this == r); }
+	};
+	typedef iterator const_iterator;
+
+	BTreeIndexedSet() : root(nullptr) {}
+	BTreeIndexedSet(BTreeIndexedSet&& r) noexcept : root(r.root) { r.root = nullptr; }
+	BTreeIndexedSet& operator=(BTreeIndexedSet&& r) noexcept {
+		clear();
+		root = r.root;
+		r.root = nullptr;
+		return *this;
+	}
+	~BTreeIndexedSet() { clear(); }
+
+	iterator begin() const { return root ? iterator(edgeLeaf(false)) : end(); }
+	iterator end() const { return iterator(); }
+	iterator lastItem() const {
+		if (!root) return end();
+		Leaf* l = edgeLeaf(true);
+		return iterator(l, l->count - 1);
+	}
+	// The element before i, or end() if i is the first
+	iterator previous(iterator i) const {
+		if (i == end()) return lastItem();
+		if (i == begin()) return end();
+		i.decrementNonEnd();
+		return i;
+	}
+
+	bool empty() const { return !root; }
+	void clear() {
+		freeNode(root);
+		root = nullptr;
+	}
+	void swap(BTreeIndexedSet& r) { std::swap(root, r.root); }
+
+	// If data is not in the set, inserts it with the given metric.  If it is, replaces it and its metric if
+	// replaceExisting.  Returns an iterator to data.
+	template <class T_, class Metric_>
+	iterator insert(T_&& data, Metric_&& metric, bool replaceExisting = true);
+
+	// Adds metric to the metric of data, inserting data if it is not in the set, and returns the new metric
+	template <class T_, class Metric_>
+	Metric addMetric(T_&& data, Metric_&& metric);
+
+	template <class Key>
+	void erase(const Key& key) {
+		erase(find(key));
+	}
+	void erase(iterator item) {
+		if (item.leaf) eraseFromLeaf(item.leaf, item.pos, item.pos + 1);
+	}
+	// Erases the elements in [begin, end)
+	template <class Key>
+	void erase(const Key& begin, const Key& end) {
+		eraseFrom(begin, &end);
+	}
+	void erase(iterator begin, iterator end) {
+		if (begin == end) return;
+		T first = *begin;
+		if (end == this->end()) {
+			eraseFrom(first, (const T*)nullptr);
+		} else {
+			T last = *end;
+			eraseFrom(first, &last);
+		}
+	}
+
+	template <class Key>
+	int count(const Key& key) const {
+		return find(key) != end();
+	}
+	template <class Key>
+	iterator find(const Key& key) const {
+		iterator i = lower_bound(key);
+		return i != end() && !(key < *i) ? i : end();
+	}
+	// The first element not less than key, or end()
+	template <class Key>
+	iterator lower_bound(const Key& key) const {
+		Leaf* l = leafFor(key);
+		if (!l) return end();
+		return normalize(l, std::lower_bound(l->data, l->data + l->count, key) - l->data);
+	}
+	// The first element greater than key, or end()
+	template <class Key>
+	iterator upper_bound(const Key& key) const {
+		Leaf* l = leafFor(key);
+		if (!l) return end();
+		return normalize(l, std::upper_bound(l->data, l->data + l->count, key) - l->data);
+	}
+	// The last element not greater than key, or end()
+	template <class Key>
+	iterator lastLessOrEqual(const Key& key) const {
+		return previous(upper_bound(key));
+	}
+
+	// The first element x for which sumTo(x) + getMetric(x) > metric, or end() if there is none
+	template <class M>
+	iterator index(const M& metric) const;
+
+	Metric getMetric(iterator x) const { return x.leaf->metric[x.pos]; }
+	// The sum of the metrics of the elements before to
+	Metric sumTo(iterator to) const;
+	Metric sumRange(iterator begin, iterator end) const { return sumTo(end) - sumTo(begin); }
+	template <class Key>
+	Metric sumRange(const Key& begin, const Key& end) const {
+		return sumRange(lower_bound(begin), lower_bound(end));
+	}
+
+	// Checks the ordering, bounds, links and totals of the whole tree; for tests
+	void testonly_assertValid() const;
+
+private:
+	NodeBase* root;
+
+	static void freeNode(NodeBase* n) {
+		if (!n) return;
+		if (n->leaf) {
+			delete (Leaf*)n;
+		} else {
+			Internal* in = (Internal*)n;
+			for (int i = 0; i < in->count; i++) freeNode(in->children[i]);
+			delete in;
+		}
+	}
+
+	Leaf* edgeLeaf(bool last) const {
+		NodeBase* n = root;
+		while (!n->leaf) {
+			Internal* in = (Internal*)n;
+			n = in->children[last ? in->count - 1 : 0];
+		}
+		return (Leaf*)n;
+	}
+
+	// The leaf in which key is or would be, or nullptr if the set is empty
+	template <class Key>
+	Leaf* leafFor(const Key& key) const {
+		NodeBase* n = root;
+		if (!n) return nullptr;
+		while (!n->leaf) {
+			Internal* in = (Internal*)n;
+			n = in->children[std::upper_bound(in->bound + 1, in->bound + in->count, key) - in->bound - 1];
+		}
+		return (Leaf*)n;
+	}
+
+	// The iterator for position pos of l, which may be one past its end
+	static iterator normalize(Leaf* l, int pos) { return pos < l->count ? iterator(l, pos) : iterator(l->next, 0); }
+
+	static Metric sumOf(NodeBase* n) {
+		Metric m = Metric();
+		if (n->leaf) {
+			for (int i = 0; i < n->count; i++) m = m + ((Leaf*)n)->metric[i];
+		} else {
+			for (int i = 0; i < n->count; i++) m = m + ((Internal*)n)->total[i];
+		}
+		return m;
+	}
+
+	template <class M>
+	static void addToAncestors(NodeBase* n, const M& delta) {
+		for (; n->parent; n = n->parent) n->parent->total[n->slot] = n->parent->total[n->slot] + delta;
+	}
+	template <class M>
+	static void subtractFromAncestors(NodeBase* n, const M& delta) {
+		for (; n->parent; n = n->parent) n->parent->total[n->slot] = n->parent->total[n->slot] - delta;
+	}
+
+	static void setChild(Internal* p, int i, NodeBase* c) {
+		p->children[i] = c;
+		c->parent = p;
+		c->slot = i;
+	}
+
+	void splitLeaf(Leaf* l);
+	void splitInternal(Internal* n);
+	void insertAfter(NodeBase* left, NodeBase* right, T&& bound);
+	void removeChild(Internal* p, int slot);
+	void rebalanceLeaf(Leaf* l);
+	void rebalanceInternal(Internal* n);
+	void eraseFromLeaf(Leaf* l, int begin, int end);
+	template <class Key, class EndKey>
+	void eraseFrom(const Key& begin, const EndKey* end);
+	Metric assertValid(NodeBase* n, const T* lower, const T* upper, Leaf*& previousLeaf) const;
+};
+
+template <class T, class Metric>
+template <class T_, class Metric_>
+typename BTreeIndexedSet<T, Metric>::iterator BTreeIndexedSet<T, Metric>::insert(T_&& data,
+                                                                                 Metric_&& metric,
+                                                                                 bool replaceExisting) {
+	Leaf* l = leafFor(data);
+	if (!l) {
+		l = new Leaf();
+		root = l;
+	}
+	int pos = std::lower_bound(l->data, l->data + l->count, data) - l->data;
+	if (pos < l->count && !(data < l->data[pos])) {
+		if (replaceExisting) {
+			Metric delta = metric - l->metric[pos];
+			l->data[pos] = T(std::forward<T_>(data));
+			l->metric[pos] = std::forward<Metric_>(metric);
+			addToAncestors(l, delta);
+		}
+		return iterator(l, pos);
+	}
+	if (l->count == LeafCapacity) {
+		splitLeaf(l);
+		if (pos > l->count) {
+			pos -= l->count;
+			l = l->next;
+		}
+	}
+	std::move_backward(l->data + pos, l->data + l->count, l->data + l->count + 1);
+	std::move_backward(l->metric + pos, l->metric + l->count, l->metric + l->count + 1);
+	l->data[pos] = T(std::forward<T_>(data));
+	l->metric[pos] = metric;
+	l->count++;
+	addToAncestors(l, l->metric[pos]);
+	return iterator(l, pos);
+}
+
+template <class T, class Metric>
+template <class T_, class Metric_>
+Metric BTreeIndexedSet<T, Metric>::addMetric(T_&& data, Metric_&& metric) {
+	iterator i = find(data);
+	if (i == end()) {
+		insert(std::forward<T_>(data), metric);
+		return metric;
+	}
+	Metric m = metric + getMetric(i);
+	i.leaf->metric[i.pos] = m;
+	addToAncestors(i.leaf, metric);
+	return m;
+}
+
+template <class T, class Metric>
+void BTreeIndexedSet<T, Metric>::splitLeaf(Leaf* l) {
+	Leaf* r = new Leaf();
+	int half = l->count / 2;
+	std::move(l->data + half, l->data + l->count, r->data);
+	std::move(l->metric + half, l->metric + l->count, r->metric);
+	std::fill(l->data + half, l->data + l->count, T());
+	r->count = l->count - half;
+	l->count = half;
+
+	r->prev = l;
+	r->next = l->next;
+	if (r->next) r->next->prev = r;
+	l->next = r;
+
+	insertAfter(l, r, T(r->data[0]));
+}
+
+template <class T, class Metric>
+void BTreeIndexedSet<T, Metric>::splitInternal(Internal* n) {
+	Internal* r = new Internal();
+	int half = n->count / 2;
+	for (int i = half; i < n->count; i++) {
+		setChild(r, i - half, n->children[i]);
+		r->bound[i - half] = std::move(n->bound[i]);
+		r->total[i - half] = n->total[i];
+	}
+	r->count = n->count - half;
+	n->count = half;
+
+	insertAfter(n, r, T(r->bound[0]));
+}
+
+// Makes right, whose elements have just been moved out of left, left's next sibling with the given bound, and sets the
+// totals of both.  This moves elements within the subtree of left's parent, so the totals above it do not change.
+template <class T, class Metric>
+void BTreeIndexedSet<T, Metric>::insertAfter(NodeBase* left, NodeBase* right, T&& bound) {
+	if (!left->parent) {
+		Internal* p = new Internal();
+		setChild(p, 0, left);
+		p->count = 1;
+		p->total[0] = sumOf(left) + sumOf(right);
+		root = p;
+	}
+	if (left->parent->count == InternalCapacity) {
+		splitInternal(left->parent);
+	}
+	Internal* p = left->parent;
+	int s = left->slot + 1;
+	for (int i = p->count; i > s; i--) {
+		setChild(p, i, p->children[i - 1]);
+		p->bound[i] = std::move(p->bound[i - 1]);
+		p->total[i] = p->total[i - 1];
+	}
+	setChild(p, s, right);
+	p->bound[s] = std::move(bound);
+	p->count++;
+	p->total[s] = sumOf(right);
+	p->total[s - 1] = sumOf(left);
+}
+
+template <class T, class Metric>
+void BTreeIndexedSet<T, Metric>::removeChild(Internal* p, int slot) {
+	for (int i = slot; i + 1 < p->count; i++) {
+		setChild(p, i, p->children[i + 1]);
+		p->bound[i] = std::move(p->bound[i + 1]);
+		p->total[i] = p->total[i + 1];
+	}
+	p->count--;
+	p->bound[p->count] = T();
+	rebalanceInternal(p);
+}
+
+// Frees l if it is empty, or merges it with or refills it from a sibling if it is less than a quarter full
+template <class T, class Metric>
+void BTreeIndexedSet<T, Metric>::rebalanceLeaf(Leaf* l) {
+	Internal* p = l->parent;
+	if (l->count == 0) {
+		if (l->prev) l->prev->next = l->next;
+		if (l->next) l->next->prev = l->prev;
+		if (p) {
+			removeChild(p, l->slot);
+		} else {
+			root = nullptr;
+		}
+		delete l;
+		return;
+	}
+	if (!p || l->count >= LeafCapacity / 4 || p->count == 1) return;
+
+	Leaf* left = l->slot + 1 < p->count ? l : (Leaf*)p->children[l->slot - 1];
+	Leaf* right = left->next;
+	int total = left->count + right->count;
+	if (total <= LeafCapacity) {
+		std::move(right->data, right->data + right->count, left->data + left->count);
+		std::move(right->metric, right->metric + right->count, left->metric + left->count);
+		left->count = total;
+		p->total[left->slot] = p->total[left->slot] + p->total[right->slot];
+		left->next = right->next;
+		if (left->next) left->next->prev = left;
+		int rightSlot = right->slot;
+		delete right;
+		removeChild(p, rightSlot);
+		return;
+	}
+
+	int leftCount = total / 2;
+	if (left->count > leftCount) {
+		int moved = left->count - leftCount;
+		std::move_backward(right->data, right->data + right->count, right->data + right->count + moved);
+		std::move_backward(right->metric, right->metric + right->count, right->metric + right->count + moved);
+		std::move(left->data + leftCount, left->data + left->count, right->data);
+		std::move(left->metric + leftCount, left->metric + left->count, right->metric);
+		std::fill(left->data + leftCount, left->data + left->count, T());
+	} else {
+		int moved = leftCount - left->count;
+		std::move(right->data, right->data + moved, left->data + left->count);
+		std::move(right->metric, right->metric + moved, left->metric + left->count);
+		std::move(right->data + moved, right->data + right->count, right->data);
+		std::move(right->metric + moved, right->metric + right->count, right->metric);
+		std::fill(right->data + right->count - moved, right->data + right->count, T());
+	}
+	left->count = leftCount;
+	right->count = total - leftCount;
+	p->bound[right->slot] = right->data[0];
+	p->total[left->slot] = sumOf(left);
+	p->total[right->slot] = sumOf(right);
+}
+
+// Collapses the root while it has a single child, and merges n with a sibling if it is less than a quarter full and
+// they fit in one node
+template <class T, class Metric>
+void BTreeIndexedSet<T, Metric>::rebalanceInternal(Internal* n) {
+	Internal* p = n->parent;
+	if (!p) {
+		if (n->count <= 1) {
+			root = n->count ? n->children[0] : nullptr;
+			if (root) root->parent = nullptr;
+			n->count = 0;
+			delete n;
+		}
+		return;
+	}
+	if (n->count == 0) {
+		int slot = n->slot;
+		delete n;
+		removeChild(p, slot);
+		return;
+	}
+	if (n->count >= InternalCapacity / 4 || p->count == 1) return;
+
+	Internal* left = n->slot + 1 < p->count ? n : (Internal*)p->children[n->slot - 1];
+	Internal* right = (Internal*)p->children[left->slot + 1];
+	if (left->count + right->count > InternalCapacity) return;
+
+	for (int i = 0; i < right->count; i++) {
+		setChild(left, left->count + i, right->children[i]);
+		left->bound[left->count + i] = i ? std::move(right->bound[i]) : std::move(p->bound[right->slot]);
+		left->total[left->count + i] = right->total[i];
+	}
+	left->count += right->count;
+	p->total[left->slot] = p->total[left->slot] + p->total[right->slot];
+	int rightSlot = right->slot;
+	delete right;
+	removeChild(p, rightSlot);
+}
+
+template <class T, class Metric>
+void BTreeIndexedSet<T, Metric>::eraseFromLeaf(Leaf* l, int begin, int end) {
+	Metric erased = Metric();
+	for (int i = begin; i < end; i++) erased = erased + l->metric[i];
+	std::move(l->data + end, l->data + l->count, l->data + begin);
+	std::move(l->metric + end, l->metric + l->count, l->metric + begin);
+	std::fill(l->data + l->count - (end - begin), l->data + l->count, T());
+	l->count -= end - begin;
+	subtractFromAncestors(l, erased);
+	rebalanceLeaf(l);
+}
+
+// Erases the elements from begin up to end, or to the end of the set if end is null, a leaf at a time
+template <class T, class Metric>
+template <class Key, class EndKey>
+void BTreeIndexedSet<T, Metric>::eraseFrom(const Key& begin, const EndKey* end) {
+	while (true) {
+		iterator i = lower_bound(begin);
+		if (i == this->end() || (end && !(*i < *end))) return;
+		Leaf* l = i.leaf;
+		int last = end ? std::lower_bound(l->data + i.pos, l->data + l->count, *end) - l->data : l->count;
+		eraseFromLeaf(l, i.pos, last);
+	}
+}
+
+template <class T, class Metric>
+template <class M>
+typename BTreeIndexedSet<T, Metric>::iterator BTreeIndexedSet<T, Metric>::index(const M& metric) const {
+	if (!root) return end();
+	M m = metric;
+	NodeBase* n = root;
+	while (!n->leaf) {
+		Internal* in = (Internal*)n;
+		int i = 0;
+		for (; i + 1 < in->count && !(m < in->total[i]); i++) m = m - in->total[i];
+		n = in->children[i];
+	}
+	Leaf* l = (Leaf*)n;
+	for (int i = 0; i < l->count; i++) {
+		m = m - l->metric[i];
+		if (m < M()) return iterator(l, i);
+	}
+	// Only if metric is at least the total of the whole set
+	return end();
+}
+
+template <class T, class Metric>
+Metric BTreeIndexedSet<T, Metric>::sumTo(iterator to) const {
+	if (!to.leaf) return root ? sumOf(root) : Metric();
+	Metric m = Metric();
+	for (int i = 0; i < to.pos; i++) m = m + to.leaf->metric[i];
+	for (NodeBase* n = to.leaf; n->parent; n = n->parent) {
+		for (int i = 0; i < n->slot; i++) m = m + n->parent->total[i];
+	}
+	return m;
+}
+
+template <class T, class Metric>
+void BTreeIndexedSet<T, Metric>::testonly_assertValid() const {
+	Leaf* previousLeaf = nullptr;
+	if (root) {
+		ASSERT(!root->parent);
+		assertValid(root, nullptr, nullptr, previousLeaf);
+	}
+	ASSERT(!previousLeaf || !previousLeaf->next);
+}
+
+// Checks the subtree n, all of whose elements should be at least *lower and less than *upper, and returns its total
+template <class T, class Metric>
+Metric BTreeIndexedSet<T, Metric>::assertValid(NodeBase* n,
+                                                const T* lower,
+                                                const T* upper,
+                                                Leaf*& previousLeaf) const {
+	ASSERT(n->count > 0);
+	if (n->leaf) {
+		Leaf* l = (Leaf*)n;
+		ASSERT(l->count <= LeafCapacity);
+		ASSERT(l->prev == previousLeaf && (!previousLeaf || previousLeaf->next == l));
+		previousLeaf = l;
+		for (int i = 0; i < l->count; i++) {
+			ASSERT(i == 0 || l->data[i - 1] < l->data[i]);
+			ASSERT(!lower || !(l->data[i] < *lower));
+			ASSERT(!upper || l->data[i] < *upper);
+		}
+		return sumOf(l);
+	}
+	Internal* in = (Internal*)n;
+	ASSERT(in->count <= InternalCapacity && (in->parent || in->count > 1));
+	for (int i = 0; i < in->count; i++) {
+		ASSERT(in->children[i]->parent == in && in->children[i]->slot == i);
+		ASSERT(i < 2 || in->bound[i - 1] < in->bound[i]);
+		const T* childLower = i ? &in->bound[i] : lower;
+		const T* childUpper = i + 1 < in->count ? &in->bound[i + 1] : upper;
+		ASSERT(assertValid(in->children[i], childLower, childUpper, previousLeaf) == in->total[i]);
+	}
+	return sumOf(in);
+}
+
+#endif
@@ -0,0 +1,123 @@
+/*
+ * BinaryTraceLogFormatter.cpp
+ *
+ * This source file is part of the FoundationDB open source project
+ *
+ * Copyright 2013-2020 Apple Inc. and the FoundationDB project authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "flow/flow.h"
+#include "flow/BinaryTraceLogFormatter.h"
+#include "flow/UnitTest.h"
+
+void BinaryTraceLogFormatter::addref() {
+	ReferenceCounted<BinaryTraceLogFormatter>::addref();
+}
+
+void BinaryTraceLogFormatter::delref() {
+	ReferenceCounted<BinaryTraceLogFormatter>::delref();
+}
+
+const char* BinaryTraceLogFormatter::getExtension() {
+	return "bin";
+}
+
+const char* BinaryTraceLogFormatter::getHeader() {
+	return "FDBBinaryTrace/1\n";
+}
+
+const char* BinaryTraceLogFormatter::getFooter() {
+	return "";
+}
+
+namespace {
+
+void appendVarint(std::string& out, size_t value) {
+	while (value >= 0x80) {
+		out.push_back(static_cast<char>((value & 0x7f) | 0x80));
+		value >>= 7;
+	}
+	out.push_back(static_cast<char>(value));
+}
+
+int varintSize(size_t value) {
+	int size = 1;
+	while (value >= 0x80) {
+		value >>= 7;
+		++size;
+	}
+	return size;
+}
+
+size_t readVarint(StringRef& in) {
+	size_t value = 0;
+	for (int shift = 0;; shift += 7) {
+		ASSERT(in.size());
+		uint8_t b = in[0];
+		in = in.substr(1);
+		value |= size_t(b & 0x7f) << shift;
+		if (!(b & 0x80)) {
+			return value;
+		}
+	}
+}
+
+} // namespace
+
+std::string BinaryTraceLogFormatter::formatEvent(const TraceEventFields& fields) {
+	size_t bodySize = varintSize(fields.size());
+	for (auto const& field : fields) {
+		bodySize += varintSize(field.first.size()) + field.first.size() + varintSize(field.second.size()) +
+		            field.second.size();
+	}
+
+	std::string result;
+	result.reserve(varintSize(bodySize) + bodySize);
+	appendVarint(result, bodySize);
+	appendVarint(result, fields.size());
+	for (auto const& field : fields) {
+		appendVarint(result, field.first.size());
+		result.append(field.first);
+		appendVarint(result, field.second.size());
+		result.append(field.second);
+	}
+	return result;
+}
+
+TEST_CASE("/flow/Trace/BinaryFormat") {
+	TraceEventFields fields;
+	fields.addField("Severity", "10");
+	fields.addField("Type", "BinaryFormatTest");
+	fields.addField("Empty", "");
+	fields.addField("Long", std::string(300, 'x'));
+	fields.addField("Binary", std::string("a\0\n\"b", 5));
+
+	BinaryTraceLogFormatter formatter;
+	std::string encoded = formatter.formatEvent(fields);
+	StringRef in(encoded);
+	size_t bodySize = readVarint(in);
+	ASSERT(bodySize == in.size());
+	ASSERT(readVarint(in) == fields.size());
+	for (auto const& field : fields) {
+		size_t keySize = readVarint(in);
+		ASSERT(in.substr(0, keySize) == StringRef(field.first));
+		in = in.substr(keySize);
+		size_t valueSize = readVarint(in);
+		ASSERT(in.substr(0, valueSize) == StringRef(field.second));
+		in = in.substr(valueSize);
+	}
+	ASSERT(in.size() == 0);
+	return Void();
+}
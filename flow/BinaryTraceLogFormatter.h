@@ -0,0 +1,38 @@
+/*
+ * BinaryTraceLogFormatter.h
+ *
+ * This source file is part of the FoundationDB open source project
+ *
+ * Copyright 2013-2020 Apple Inc. and the FoundationDB project authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "flow/FastRef.h"
+#include "flow/Trace.h"
+
+// Writes trace events without any escaping or quoting, which makes them cheaper to write and read than xml or json.
+// A file starts with the line "FDBBinaryTrace/1" and is followed by its events, each of which is
+//   <length of the rest of the event> <field count> (<key length> <key> <value length> <value>)...
+// with lengths and counts as unsigned LEB128 varints. contrib/TraceLogHelper/BinaryParser.cs reads these files.
+struct BinaryTraceLogFormatter : public ITraceLogFormatter, ReferenceCounted<BinaryTraceLogFormatter> {
+	const char* getExtension() override;
+	const char* getHeader() override; // Called when starting a new file
+	const char* getFooter() override; // Called when ending a file
+	std::string formatEvent(const TraceEventFields&) override; // Called for each event
+
+	void addref() override;
+	void delref() override;
+};
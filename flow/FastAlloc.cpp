@@ -26,7 +26,9 @@
 #include "flow/Knobs.h"
 #include "flow/crc32c.h"
 #include "flow/flow.h"
+#include "flow/UnitTest.h"
 
+#include <algorithm>
 #include <atomic>
 #include <cstdint>
 #include <unordered_map>
@@ -39,10 +41,13 @@
 
 #ifdef __linux__
 #include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
 #include <linux/mman.h>
+#include <linux/mempolicy.h>
 #endif
 
-#ifdef __FreeBSD__
+#if defined(__FreeBSD__) || defined(__APPLE__)
 #include <sys/mman.h>
 #endif
 
@@ -136,6 +141,119 @@ void hugeArenaSample(int size) {
 	}
 }
 
+thread_local int64_t g_arenaBytesUntilSample = 0;
+std::atomic<uint16_t> g_arenaSampledBlocks[1 << 16];
+
+namespace {
+
+struct ArenaProfileSite {
+	double allocatedBytes = 0; // Since last logged
+	double liveBytes = 0;
+	int64_t liveSamples = 0;
+};
+
+struct ArenaProfile {
+	ThreadSpinLock lock;
+	std::map<std::string, ArenaProfileSite> sites;
+	// Each sampled block still live, its site and the number of bytes it stands for
+	std::unordered_map<void*, std::pair<ArenaProfileSite*, double>> blocks;
+};
+
+ArenaProfile& arenaProfile() {
+	static ArenaProfile* profile = new ArenaProfile();
+	return *profile;
+}
+
+} // namespace
+
+void arenaProfilerSample(void* block, int size) {
+	int64_t sampleBytes = FLOW_KNOBS ? FLOW_KNOBS->ARENA_PROFILER_SAMPLE_BYTES : 0;
+	if (sampleBytes <= 0) {
+		g_arenaBytesUntilSample = 1 << 30; // Just check again for the knob now and then
+		return;
+	}
+	// Exponentially distributed gaps make every byte equally likely to be sampled, whatever the sizes allocated
+	g_arenaBytesUntilSample = (int64_t)(-log(1 - nondeterministicRandom()->random01()) * sampleBytes);
+	if (g_allocation_tracing_disabled) {
+		return;
+	}
+
+	++g_allocation_tracing_disabled;
+	// The number of bytes allocated that a sample of a block this size stands for
+	double weight = size / (1 - exp(-(double)size / sampleBytes));
+	std::string backtrace = platform::get_backtrace();
+
+	ArenaProfile& profile = arenaProfile();
+	{
+		ThreadSpinLockHolder holder(profile.lock);
+		ArenaProfileSite& site = profile.sites[backtrace];
+		site.allocatedBytes += weight;
+		site.liveBytes += weight;
+		++site.liveSamples;
+		auto& b = profile.blocks[block];
+		if (b.first) {
+			// A block that was freed without being reported; should not happen
+			b.first->liveBytes -= b.second;
+			--b.first->liveSamples;
+		} else {
+			g_arenaSampledBlocks[arenaProfilerBucket(block)].fetch_add(1, std::memory_order_relaxed);
+		}
+		b = std::make_pair(&site, weight);
+	}
+	--g_allocation_tracing_disabled;
+}
+
+void arenaProfilerRelease(void* block) {
+	ArenaProfile& profile = arenaProfile();
+	ThreadSpinLockHolder holder(profile.lock);
+	auto b = profile.blocks.find(block);
+	if (b == profile.blocks.end()) {
+		return; // Another sampled block in the same bucket
+	}
+	b->second.first->liveBytes -= b->second.second;
+	--b->second.first->liveSamples;
+	profile.blocks.erase(b);
+	g_arenaSampledBlocks[arenaProfilerBucket(block)].fetch_sub(1, std::memory_order_relaxed);
+}
+
+void logArenaProfile() {
+	std::vector<std::pair<std::string, ArenaProfileSite>> sites;
+	{
+		ArenaProfile& profile = arenaProfile();
+		ThreadSpinLockHolder holder(profile.lock);
+		for (auto it = profile.sites.begin(); it != profile.sites.end();) {
+			sites.emplace_back(it->first, it->second);
+			it->second.allocatedBytes = 0;
+			if (it->second.liveSamples == 0) {
+				it = profile.sites.erase(it);
+			} else {
+				++it;
+			}
+		}
+	}
+	if (sites.empty()) {
+		return;
+	}
+
+	int logged = std::min<int>(sites.size(), FLOW_KNOBS->ARENA_PROFILER_LOGGED_SITES);
+	std::partial_sort(sites.begin(), sites.begin() + logged, sites.end(),
+	                  [](auto const& a, auto const& b) { return a.second.liveBytes > b.second.liveBytes; });
+	double totalLive = 0;
+	for (auto const& s : sites) totalLive += s.second.liveBytes;
+
+	++g_allocation_tracing_disabled;
+	TraceEvent("ArenaProfile").detail("Sites", sites.size()).detail("EstimatedLiveBytes", (int64_t)totalLive);
+	for (int i = 0; i < logged; i++) {
+		TraceEvent("ArenaProfileSite")
+		    .detail("Rank", i)
+		    .detail("EstimatedLiveBytes", (int64_t)sites[i].second.liveBytes)
+		    .detail("EstimatedAllocatedBytes", (int64_t)sites[i].second.allocatedBytes)
+		    .detail("LiveSamples", sites[i].second.liveSamples)
+		    .detail("Backtrace", sites[i].first);
+	}
+	--g_allocation_tracing_disabled;
+}
+
 #ifdef ALLOC_INSTRUMENTATION
 INIT_SEG std::map<const char*, AllocInstrInfo> allocInstr;
 INIT_SEG std::unordered_map<int64_t, std::pair<uint32_t, size_t>> memSample;
@@ -245,10 +363,18 @@ struct FastAllocator<Size>::GlobalData {
 	CRITICAL_SECTION mutex;
 	std::vector<void*> magazines;   // These magazines are always exactly magazine_size ("full")
 	std::vector<std::pair<int, void*>> partial_magazines;  // Magazines that are not "full" and their counts.  Only created by releaseThreadMagazines().
+	std::vector<void*> blocks;  // Every block of magazine_size items ever allocated from the system
+	std::vector<void*> reclaimedBlocks;  // Blocks whose memory has been returned to the system, to be reused before allocating more
+	char* regionNext;  // The unused part of the hugepage region blocks are being carved from, if any
+	char* regionEnd;
 	std::atomic<long long> totalMemory;
 	long long partialMagazineUnallocatedMemory;
 	std::atomic<long long> activeThreads;
-	GlobalData() : totalMemory(0), partialMagazineUnallocatedMemory(0), activeThreads(0) {
+	std::atomic<long long> fragmentedMemory;
+	std::atomic<long long> reclaimedMemory;
+	GlobalData()
+	  : regionNext(nullptr), regionEnd(nullptr), totalMemory(0), partialMagazineUnallocatedMemory(0), activeThreads(0),
+	    fragmentedMemory(0), reclaimedMemory(0) {
 		InitializeCriticalSection(&mutex);
 	}
 };
@@ -273,12 +399,187 @@ long long FastAllocator<Size>::getActiveThreads() {
 	return globalData()->activeThreads.load();
 }
 
+template <int Size>
+long long FastAllocator<Size>::getFragmentedMemory() {
+	return globalData()->fragmentedMemory.load();
+}
+
+template <int Size>
+long long FastAllocator<Size>::getReclaimedMemory() {
+	return globalData()->reclaimedMemory.load();
+}
+
+// Tells the system the contents of the given pages are no longer needed, so that it can take back the physical memory
+// behind them.  The address range stays mapped, and reads as zeros (or as what it held) when next touched.
+static void releasePagesToSystem(void* block, size_t length) {
+#if defined(__linux__)
+	madvise(block, length, MADV_DONTNEED);
+#elif defined(__FreeBSD__) || defined(__APPLE__)
+	madvise(block, length, MADV_FREE);
+#elif defined(_WIN32)
+	VirtualAlloc(block, length, MEM_RESET, PAGE_READWRITE);
+#endif
+}
+
+static const size_t hugePageRegionSize = 2 << 20;
+
+#ifdef __linux__
+// Asks that the pages of the given range come from the NUMA node of the CPU this thread is running on, which for a
+// process pinned to a core is the node local to it.  This must be done before the pages are first touched.
+static void bindToLocalNumaNode(void* region, size_t length) {
+	unsigned cpu, node;
+	if (syscall(SYS_getcpu, &cpu, &node, nullptr) != 0) {
+		return;
+	}
+	const int maxNodes = 1024;
+	const int bitsPerWord = 8 * sizeof(unsigned long);
+	unsigned long nodeMask[maxNodes / bitsPerWord] = {};
+	if (node >= maxNodes) {
+		return;
+	}
+	nodeMask[node / bitsPerWord] |= 1UL << (node % bitsPerWord);
+	// Failure (e.g. on a kernel without NUMA support) just leaves the default policy in place
+	syscall(SYS_mbind, region, length, MPOL_PREFERRED, nodeMask, maxNodes, 0);
+}
+#endif
+
+// Allocates a hugePageRegionSize region aligned to its size, so that the kernel can back it with transparent hugepages
+static void* allocateHugePageRegion() {
+#ifdef __linux__
+	char* mapped = (char*)mmap(nullptr, 2 * hugePageRegionSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	if (mapped == MAP_FAILED) {
+		platform::outOfMemory();
+	}
+	char* region = (char*)(((uintptr_t)mapped + hugePageRegionSize - 1) & ~(uintptr_t)(hugePageRegionSize - 1));
+	if (region > mapped) {
+		munmap(mapped, region - mapped);
+	}
+	munmap(region + hugePageRegionSize, mapped + hugePageRegionSize - region);
+#ifdef MADV_HUGEPAGE
+	madvise(region, hugePageRegionSize, MADV_HUGEPAGE);
+#endif
+	if (FLOW_KNOBS->FAST_ALLOC_LOCAL_NUMA_NODE) {
+		bindToLocalNumaNode(region, hugePageRegionSize);
+	}
+	return region;
+#else
+	return ::allocate(hugePageRegionSize, false);
+#endif
+}
+
+// Carves a block of magazine_size items out of the current hugepage region.  What is left of a region too small for a
+// block is never used.
+template <int Size>
+void* FastAllocator<Size>::allocateFromRegion() {
+	const size_t blockSize = magazine_size * Size;
+	GlobalData* g = globalData();
+	EnterCriticalSection(&g->mutex);
+	if ((size_t)(g->regionEnd - g->regionNext) < blockSize) {
+		g->regionNext = (char*)allocateHugePageRegion();
+		g->regionEnd = g->regionNext + hugePageRegionSize;
+	}
+	void* block = g->regionNext;
+	g->regionNext += blockSize;
+	LeaveCriticalSection(&g->mutex);
+	return block;
+}
+
+// Only the full magazines in the global list are considered, so a block is reclaimed only if none of its items are
+// allocated or held by any thread.  The magazines are taken out of the global list while they are being examined, so
+// that the lock is not held meanwhile; threads that need a magazine in the meantime get a new or reclaimed block.
+template <int Size>
+long long FastAllocator<Size>::reclaimUnusedMemory() {
+#if FAST_ALLOCATOR_DEBUG
+	return 0; // check() tracks items by address, and would see those of a reused block freed twice
+#endif
+	GlobalData* g = globalData();
+	std::vector<void*> magazines;
+	std::vector<void*> blocks;
+	EnterCriticalSection(&g->mutex);
+	magazines.swap(g->magazines);
+	blocks = g->blocks;
+	LeaveCriticalSection(&g->mutex);
+
+	std::sort(blocks.begin(), blocks.end());
+	auto blockOf = [&blocks](void* p) {
+		int b = std::upper_bound(blocks.begin(), blocks.end(), p) - blocks.begin() - 1;
+		ASSERT(b >= 0);
+		return b;
+	};
+	auto next = [](void* p) {
+#if VALGRIND
+		VALGRIND_MAKE_MEM_DEFINED(p, sizeof(void*));
+#endif
+		return *(void**)p;
+	};
+
+	std::vector<int> freeCount(blocks.size());
+	for (void* m : magazines) {
+		for (void* p = m; p; p = next(p)) {
+			++freeCount[blockOf(p)];
+		}
+	}
+
+	std::vector<void*> freed;
+	for (int b = 0; b < blocks.size(); b++) {
+		if (freeCount[b] == magazine_size) {
+			freed.push_back(blocks[b]);
+		}
+	}
+	long long freedBytes = (long long)freed.size() * magazine_size * Size;
+	g->fragmentedMemory = (long long)magazines.size() * magazine_size * Size - freedBytes;
+
+	if (freed.size()) {
+		// Relink the items from the blocks still in use into full magazines.  The number of them is still a multiple of
+		// magazine_size, since whole blocks were removed.
+		std::vector<void*> kept;
+		void* first = nullptr;
+		void** last = nullptr;
+		int count = 0;
+		for (void* m : magazines) {
+			for (void* p = m; p;) {
+				void* n = next(p);
+				if (freeCount[blockOf(p)] != magazine_size) {
+					if (count == 0) {
+						first = p;
+					} else {
+						last[1] = last[0] = p;
+					}
+					last = (void**)p;
+					if (++count == magazine_size) {
+						last[1] = last[0] = nullptr;
+						kept.push_back(first);
+						count = 0;
+					}
+				}
+				p = n;
+			}
+		}
+		ASSERT(count == 0);
+		magazines.swap(kept);
+
+		for (void* block : freed) {
+			releasePagesToSystem(block, magazine_size * Size);
+		}
+	}
+
+	EnterCriticalSection(&g->mutex);
+	g->magazines.insert(g->magazines.end(), magazines.begin(), magazines.end());
+	g->reclaimedBlocks.insert(g->reclaimedBlocks.end(), freed.begin(), freed.end());
+	g->totalMemory.fetch_sub(freedBytes);
+	g->reclaimedMemory.fetch_add(freedBytes);
+	LeaveCriticalSection(&g->mutex);
+
+	return freedBytes;
+}
+
 #if FAST_ALLOCATOR_DEBUG
 static int64_t getSizeCode(int i) {
 	switch (i) {
 		case 16: return 1;
 		case 32: return 2;
 		case 64: return 3;
+		case 80: return 13;
 		case 96: return 4;
 		case 128: return 5;
 		case 256: return 6;
@@ -480,39 +781,54 @@ void FastAllocator<Size>::getMagazine() {
 		threadData.count = p.first;
 		return;
 	}
+	void** block = nullptr;
+	if (globalData()->reclaimedBlocks.size()) {
+		block = (void**)globalData()->reclaimedBlocks.back();
+		globalData()->reclaimedBlocks.pop_back();
+		globalData()->reclaimedMemory.fetch_sub(magazine_size * Size);
+	}
 	globalData()->totalMemory.fetch_add(magazine_size * Size);
 	LeaveCriticalSection(&globalData()->mutex);
 
-	// Allocate a new page of data from the system allocator
-	#ifdef ALLOC_INSTRUMENTATION
-	interlockedIncrement(&pageCount);
-	#endif
+	if (!block) {
+		// Allocate a new page of data from the system allocator
+		#ifdef ALLOC_INSTRUMENTATION
+		interlockedIncrement(&pageCount);
+		#endif
 
-	void** block = nullptr;
 #if FAST_ALLOCATOR_DEBUG
 #ifdef WIN32
-	static int alt = 0; alt++;
-	block =
-	    (void**)VirtualAllocEx(GetCurrentProcess(), (void*)(((getSizeCode(Size) << 11) + alt) * magazine_size * Size),
-	                           magazine_size * Size, MEM_COMMIT | MEM_RESERVE, PAGE_READWRITE);
+		static int alt = 0; alt++;
+		block =
+		    (void**)VirtualAllocEx(GetCurrentProcess(), (void*)(((getSizeCode(Size) << 11) + alt) * magazine_size * Size),
+		                           magazine_size * Size, MEM_COMMIT | MEM_RESERVE, PAGE_READWRITE);
 #else
-	static int alt = 0; alt++;
-	void* desiredBlock = (void*)( ((getSizeCode(Size)<<11) + alt) * magazine_size*Size);
-	block = (void**)mmap( desiredBlock, magazine_size*Size, PROT_READ|PROT_WRITE, MAP_PRIVATE|MAP_ANONYMOUS, -1, 0 );
-	ASSERT( block == desiredBlock );
+		static int alt = 0; alt++;
+		void* desiredBlock = (void*)( ((getSizeCode(Size)<<11) + alt) * magazine_size*Size);
+		block = (void**)mmap( desiredBlock, magazine_size*Size, PROT_READ|PROT_WRITE, MAP_PRIVATE|MAP_ANONYMOUS, -1, 0 );
+		ASSERT( block == desiredBlock );
 #endif
 #else
-	// FIXME: We should be able to allocate larger magazine sizes here if we
-	// detect that the underlying system supports hugepages.  Using hugepages
-	// with smaller-than-2MiB magazine sizes strands memory.  See issue #909.
-	if(FLOW_KNOBS && g_allocation_tracing_disabled == 0 && nondeterministicRandom()->random01() < (magazine_size * Size)/FLOW_KNOBS->FAST_ALLOC_LOGGING_BYTES) {
-		++g_allocation_tracing_disabled;
-		TraceEvent("GetMagazineSample").detail("Size", Size).backtrace();
-		--g_allocation_tracing_disabled;
-	}
-	block = (void **)::allocate(magazine_size * Size, false);
+		// FIXME: We should be able to allocate larger magazine sizes here if we
+		// detect that the underlying system supports hugepages.  Using hugepages
+		// with smaller-than-2MiB magazine sizes strands memory.  See issue #909.
+		if(FLOW_KNOBS && g_allocation_tracing_disabled == 0 && nondeterministicRandom()->random01() < (magazine_size * Size)/FLOW_KNOBS->FAST_ALLOC_LOGGING_BYTES) {
+			++g_allocation_tracing_disabled;
+			TraceEvent("GetMagazineSample").detail("Size", Size).backtrace();
+			--g_allocation_tracing_disabled;
+		}
+		if (FLOW_KNOBS && FLOW_KNOBS->FAST_ALLOC_HUGE_PAGE_REGIONS) {
+			block = (void**)allocateFromRegion();
+		} else {
+			block = (void**)::allocate(magazine_size * Size, false);
+		}
 #endif
 
+		EnterCriticalSection(&globalData()->mutex);
+		globalData()->blocks.push_back(block);
+		LeaveCriticalSection(&globalData()->mutex);
+	}
+
 	//void** block = new void*[ magazine_size * PSize ];
 	for(int i=0; i<magazine_size-1; i++) {
 		block[i*PSize+1] = block[i*PSize] = &block[(i+1)*PSize];
@@ -561,6 +877,7 @@ void releaseAllThreadMagazines() {
 	FastAllocator<16>::releaseThreadMagazines();
 	FastAllocator<32>::releaseThreadMagazines();
 	FastAllocator<64>::releaseThreadMagazines();
+	FastAllocator<80>::releaseThreadMagazines();
 	FastAllocator<96>::releaseThreadMagazines();
 	FastAllocator<128>::releaseThreadMagazines();
 	FastAllocator<256>::releaseThreadMagazines();
@@ -578,6 +895,7 @@ int64_t getTotalUnusedAllocatedMemory() {
 	unusedMemory += FastAllocator<16>::getApproximateMemoryUnused();
 	unusedMemory += FastAllocator<32>::getApproximateMemoryUnused();
 	unusedMemory += FastAllocator<64>::getApproximateMemoryUnused();
+	unusedMemory += FastAllocator<80>::getApproximateMemoryUnused();
 	unusedMemory += FastAllocator<96>::getApproximateMemoryUnused();
 	unusedMemory += FastAllocator<128>::getApproximateMemoryUnused();
 	unusedMemory += FastAllocator<256>::getApproximateMemoryUnused();
@@ -591,9 +909,61 @@ int64_t getTotalUnusedAllocatedMemory() {
 	return unusedMemory;
 }
 
+template <int Size>
+static int64_t reclaimUnusedAllocatedMemory(int64_t minUnusedBytes) {
+	if (FastAllocator<Size>::getApproximateMemoryUnused() < minUnusedBytes) {
+		return 0;
+	}
+	return FastAllocator<Size>::reclaimUnusedMemory();
+}
+
+int64_t reclaimUnusedAllocatedMemory(int64_t minUnusedBytes) {
+	int64_t reclaimed = 0;
+
+	reclaimed += reclaimUnusedAllocatedMemory<16>(minUnusedBytes);
+	reclaimed += reclaimUnusedAllocatedMemory<32>(minUnusedBytes);
+	reclaimed += reclaimUnusedAllocatedMemory<64>(minUnusedBytes);
+	reclaimed += reclaimUnusedAllocatedMemory<80>(minUnusedBytes);
+	reclaimed += reclaimUnusedAllocatedMemory<96>(minUnusedBytes);
+	reclaimed += reclaimUnusedAllocatedMemory<128>(minUnusedBytes);
+	reclaimed += reclaimUnusedAllocatedMemory<256>(minUnusedBytes);
+	reclaimed += reclaimUnusedAllocatedMemory<512>(minUnusedBytes);
+	reclaimed += reclaimUnusedAllocatedMemory<1024>(minUnusedBytes);
+	reclaimed += reclaimUnusedAllocatedMemory<2048>(minUnusedBytes);
+	reclaimed += reclaimUnusedAllocatedMemory<4096>(minUnusedBytes);
+	reclaimed += reclaimUnusedAllocatedMemory<8192>(minUnusedBytes);
+	reclaimed += reclaimUnusedAllocatedMemory<16384>(minUnusedBytes);
+
+	return reclaimed;
+}
+
+TEST_CASE("/flow/FastAllocator/reclaimUnusedMemory") {
+	// Allocate and free enough items that several full magazines reach the global list, then check that whatever
+	// memory is reclaimed is accounted for and can be allocated and written again
+	std::vector<void*> items;
+	for (int round = 0; round < 3; round++) {
+		for (int i = 0; i < 64; i++) {
+			items.push_back(FastAllocator<16384>::allocate());
+			memset(items.back(), round, 16384);
+		}
+		for (void* p : items) {
+			FastAllocator<16384>::release(p);
+		}
+		items.clear();
+
+		long long total = FastAllocator<16384>::getTotalMemory();
+		long long reclaimed = FastAllocator<16384>::reclaimUnusedMemory();
+		ASSERT(reclaimed >= 0 && reclaimed % 16384 == 0);
+		ASSERT(FastAllocator<16384>::getTotalMemory() == total - reclaimed);
+		ASSERT(FastAllocator<16384>::getReclaimedMemory() >= reclaimed);
+	}
+	return Void();
+}
+
 template class FastAllocator<16>;
 template class FastAllocator<32>;
 template class FastAllocator<64>;
+template class FastAllocator<80>; // Only used by PTree nodes (fdbclient/VersionedMap.h)
 template class FastAllocator<96>;
 template class FastAllocator<128>;
 template class FastAllocator<256>;
@@ -113,6 +113,14 @@ public:
 	static long long getTotalMemory();
 	static long long getApproximateMemoryUnused();
 	static long long getActiveThreads();
+	// Unused memory that could not be reclaimed on the last call to reclaimUnusedMemory(), because it shares blocks with
+	// memory in use or held by threads
+	static long long getFragmentedMemory();
+	static long long getReclaimedMemory();
+
+	// Returns the blocks whose memory is all unused to the OS, keeping their address space for reuse, and returns the
+	// number of bytes reclaimed.  Takes time proportional to the unused memory; the allocator remains usable meanwhile.
+	static long long reclaimUnusedMemory();
 
 	static void releaseThreadMagazines();
 
@@ -153,12 +161,36 @@ private:
 	static void initThread();
 	static void getMagazine();
 	static void releaseMagazine(void*);
+	static void* allocateFromRegion();
 };
 
 extern std::atomic<int64_t> g_hugeArenaMemory;
 void hugeArenaSample(int size);
+
+// A sampling profiler of arena block allocations, enabled by FLOW_KNOBS->ARENA_PROFILER_SAMPLE_BYTES.  About one in
+// that many bytes allocated has its backtrace taken, and the bytes allocated and still live are estimated for each
+// distinct backtrace.  ArenaBlock reports each block it creates and destroys; the latter is a single load for blocks
+// that were not sampled.
+extern thread_local int64_t g_arenaBytesUntilSample;
+extern std::atomic<uint16_t> g_arenaSampledBlocks[1 << 16];
+void arenaProfilerSample(void* block, int size);
+void arenaProfilerRelease(void* block);
+// Traces the call sites with the most live memory, and forgets those with none
+void logArenaProfile();
+
+inline int arenaProfilerBucket(void* block) {
+	return (int)(((uintptr_t)block >> 4) * 0x9E3779B97F4A7C15ULL >> 48);
+}
+inline void arenaProfilerAllocated(void* block, int size) {
+	if ((g_arenaBytesUntilSample -= size) < 0) arenaProfilerSample(block, size);
+}
+inline void arenaProfilerDestroyed(void* block) {
+	if (g_arenaSampledBlocks[arenaProfilerBucket(block)].load(std::memory_order_relaxed)) arenaProfilerRelease(block);
+}
 void releaseAllThreadMagazines();
 int64_t getTotalUnusedAllocatedMemory();
+// Reclaims the unused memory of each size class with at least minUnusedBytes of it, and returns the bytes reclaimed
+int64_t reclaimUnusedAllocatedMemory(int64_t minUnusedBytes);
 void setFastAllocatorThreadInitFunction( void (*)() );  // The given function will be called at least once in each thread that allocates from a FastAllocator.  Currently just one such function is tracked.
 
 inline constexpr int nextFastAllocatedSize(int x) {
@@ -21,6 +21,7 @@
 #include <flow/Histogram.h>
 #include <flow/flow.h>
 #include <flow/UnitTest.h>
+#include <cinttypes>
 // TODO: remove dependency on fdbrpc.
 
 // we need to be able to check if we're in simulation so that the histograms are properly
@@ -87,7 +88,7 @@ Histogram* HistogramRegistry::lookupHistogram(std::string name) {
 void HistogramRegistry::logReport() {
 	for (auto& i : histograms) {
 		i.second->writeToLog();
-		i.second->clear();
+		i.second->accumulate();
 	}
 }
 
@@ -137,6 +138,48 @@ void Histogram::writeToLog() {
 
 #pragma endregion // Histogram
 
+#pragma region LogLinearHistogram
+
+// Format: "sum,min,max;index:count,index:count,..." listing only non-empty buckets
+std::string LogLinearHistogram::toString() const {
+	std::string s = format("%.17g,%.17g,%.17g;", sum, _min, _max);
+	bool first = true;
+	for (int i = 0; i < buckets.size(); i++) {
+		if (buckets[i]) {
+			s += format(first ? "%d:%" PRIu64 : ",%d:%" PRIu64, i, buckets[i]);
+			first = false;
+		}
+	}
+	return s;
+}
+
+LogLinearHistogram LogLinearHistogram::fromString(std::string const& s, double resolution) {
+	LogLinearHistogram h(resolution);
+	int consumed = 0;
+	if (sscanf(s.c_str(), "%lf,%lf,%lf;%n", &h.sum, &h._min, &h._max, &consumed) != 3 || !consumed) {
+		throw attribute_not_found();
+	}
+	const char* p = s.c_str() + consumed;
+	int idx;
+	uint64_t count;
+	while (*p && sscanf(p, "%d:%" SCNu64 "%n", &idx, &count, &consumed) == 2) {
+		if (idx < 0 || idx >= 64 * SUB_BUCKETS) throw attribute_not_found();
+		if (idx >= h.buckets.size()) {
+			h.buckets.resize(idx + 1);
+		}
+		h.buckets[idx] += count;
+		h.populationSize += count;
+		p += consumed;
+		if (*p == ',') p++;
+	}
+	if (!h.populationSize) {
+		h.clear();
+	}
+	return h;
+}
+
+#pragma endregion // LogLinearHistogram
+
 TEST_CASE("/flow/histogram/smoke_test") {
 
 	{
@@ -185,3 +228,37 @@ TEST_CASE("/flow/histogram/smoke_test") {
 
 	return Void();
 }
+
+TEST_CASE("/flow/histogram/log_linear") {
+	LogLinearHistogram h;
+	ASSERT(h.percentile(0.5) == 0 && h.getPopulationSize() == 0);
+
+	for (uint64_t units = 0; units < (1 << 20); units++) {
+		int idx = LogLinearHistogram::bucketIndex(units);
+		ASSERT(LogLinearHistogram::bucketLowerBound(idx) <= units && units < LogLinearHistogram::bucketLowerBound(idx + 1));
+	}
+
+	// Percentiles of 1ms..100ms are within a bucket's width of the exact value
+	LogLinearHistogram a, b;
+	for (int i = 1; i <= 100000; i++) {
+		((i % 3) ? a : b).addSample(i * 1e-6);
+		h.addSample(i * 1e-6);
+	}
+	for (double p : { 0.25, 0.5, 0.9, 0.99, 0.999 }) {
+		double exact = std::floor(99999 * p + 1) * 1e-6;
+		ASSERT(std::abs(h.percentile(p) - exact) <= exact / LogLinearHistogram::SUB_BUCKETS);
+	}
+	ASSERT(h.min() == 1e-6 && h.max() == 100000 * 1e-6 && h.getPopulationSize() == 100000);
+
+	// Merging the parts, directly or through snapshots, gives the whole
+	LogLinearHistogram merged = LogLinearHistogram::fromString(a.toString());
+	merged.merge(LogLinearHistogram::fromString(b.toString()));
+	a.merge(b);
+	for (double p : { 0.0, 0.25, 0.5, 0.9, 0.99, 0.999, 1.0 }) {
+		ASSERT(merged.percentile(p) == h.percentile(p) && a.percentile(p) == h.percentile(p));
+	}
+	ASSERT(merged.getPopulationSize() == h.getPopulationSize() && merged.min() == h.min() && merged.max() == h.max());
+	ASSERT(std::abs(merged.mean() - h.mean()) < 1e-9);
+
+	return Void();
+}
@@ -24,13 +24,17 @@
 
 #include <flow/Arena.h>
 
+#include <algorithm>
+#include <cmath>
 #include <string>
 #include <map>
 #include <unordered_map>
+#include <vector>
 
 #ifdef _WIN32
 #include <intrin.h>
 #pragma intrinsic(_BitScanReverse)
+#pragma intrinsic(_BitScanReverse64)
 #endif
 
 class Histogram;
@@ -42,6 +46,8 @@ public:
 	Histogram* lookupHistogram(std::string name);
 	void logReport();
 
+	std::map<std::string, Histogram*> const& getHistograms() const { return histograms; }
+
 private:
 	// This map is ordered by key so that ops within the same group end up
 	// next to each other in the trace log.
@@ -69,6 +75,9 @@ private:
 		ASSERT(UnitToStringMapper.find(unit) != UnitToStringMapper.end());
 
 		clear();
+		for (uint64_t& i : logged) {
+			i = 0;
+		}
 	}
 
 	static std::string generateName(std::string group, std::string op) { return group + ":" + op; }
@@ -125,6 +134,17 @@ public:
 	}
 	void writeToLog();
 
+	// Moves the samples since the last clear() into the running totals, which are never cleared
+	void accumulate() {
+		for (int i = 0; i < 32; i++) {
+			logged[i] += buckets[i];
+		}
+		clear();
+	}
+
+	// All samples ever taken in bucket i
+	uint64_t totalCount(int i) const { return logged[i] + buckets[i]; }
+
 	std::string name() { return generateName(this->group, this->op); }
 
 	std::string const group;
@@ -132,6 +152,119 @@ public:
 	Unit const unit;
 	HistogramRegistry& registry;
 	uint32_t buckets[32];
+	uint64_t logged[32];
+};
+
+/*
+ * A histogram of non-negative values with SUB_BUCKETS linearly spaced buckets in each power of two of its resolution,
+ * so percentiles are reported within about 1/SUB_BUCKETS of the recorded values. Unlike the reservoir kept by
+ * ContinuousSample, it accounts for every sample, so histograms of the same resolution recorded by different
+ * processes can be merged exactly.
+ */
+class LogLinearHistogram {
+public:
+	static constexpr int SUB_BUCKET_BITS = 4;
+	static constexpr int SUB_BUCKETS = 1 << SUB_BUCKET_BITS;
+
+	explicit LogLinearHistogram(double resolution = 1e-6) : resolution(resolution) { clear(); }
+
+	void addSample(double value) {
+		uint64_t units = value <= 0 ? 0 : value >= resolution * (double)(1ULL << 62) ? 1ULL << 62 : value / resolution;
+		int idx = bucketIndex(units);
+		if (idx >= buckets.size()) {
+			buckets.resize(idx + 1);
+		}
+		buckets[idx]++;
+
+		if (!populationSize) {
+			_min = _max = value;
+		}
+		_min = std::min(_min, value);
+		_max = std::max(_max, value);
+		sum += value;
+		populationSize++;
+	}
+
+	void merge(LogLinearHistogram const& other) {
+		ASSERT(resolution == other.resolution);
+		if (!other.populationSize) return;
+		if (!populationSize) {
+			_min = other._min;
+			_max = other._max;
+		}
+		_min = std::min(_min, other._min);
+		_max = std::max(_max, other._max);
+		sum += other.sum;
+		populationSize += other.populationSize;
+		if (buckets.size() < other.buckets.size()) {
+			buckets.resize(other.buckets.size());
+		}
+		for (int i = 0; i < other.buckets.size(); i++) {
+			buckets[i] += other.buckets[i];
+		}
+	}
+
+	// Returns the middle of the bucket holding the percentile, chosen as ContinuousSample::percentile() would
+	double percentile(double percentile) const {
+		if (!populationSize || percentile < 0.0 || percentile > 1.0) return 0;
+		uint64_t rank = std::floor((populationSize - 1) * percentile);
+		uint64_t seen = 0;
+		for (int i = 0; i < buckets.size(); i++) {
+			seen += buckets[i];
+			if (seen > rank) {
+				double mid = (bucketLowerBound(i) + bucketLowerBound(i + 1)) * 0.5 * resolution;
+				return std::min(_max, std::max(_min, mid));
+			}
+		}
+		return _max;
+	}
+
+	double median() const { return percentile(0.5); }
+	double mean() const { return populationSize ? sum / populationSize : 0; }
+	double min() const { return _min; }
+	double max() const { return _max; }
+	uint64_t getPopulationSize() const { return populationSize; }
+
+	void clear() {
+		buckets.clear();
+		populationSize = 0;
+		sum = _min = _max = 0;
+	}
+
+	// A compact text snapshot, e.g. for a trace event, that fromString() turns back into a mergeable histogram
+	std::string toString() const;
+	static LogLinearHistogram fromString(std::string const& s, double resolution = 1e-6);
+
+	template <class Ar>
+	void serialize(Ar& ar) {
+		serializer(ar, resolution, populationSize, sum, _min, _max, buckets);
+	}
+
+	// The bucket holding values of the given number of resolution units
+	static int bucketIndex(uint64_t units) {
+		if (units < SUB_BUCKETS) return units;
+#ifdef _WIN32
+		unsigned long msb;
+		_BitScanReverse64(&msb, units);
+#else
+		int msb = 63 - __builtin_clzll(units);
+#endif
+		int shift = msb - SUB_BUCKET_BITS;
+		return (shift + 1) * SUB_BUCKETS + (units >> shift) - SUB_BUCKETS;
+	}
+
+	// The smallest number of resolution units in a bucket
+	static uint64_t bucketLowerBound(int idx) {
+		if (idx < SUB_BUCKETS) return idx;
+		return (uint64_t)(idx % SUB_BUCKETS + SUB_BUCKETS) << (idx / SUB_BUCKETS - 1);
+	}
+
+private:
+	double resolution;
+	uint64_t populationSize;
+	double sum;
+	double _min, _max;
+	std::vector<uint64_t> buckets;
 };
 
 #endif // FLOW_HISTOGRAM_H
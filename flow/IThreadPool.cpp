@@ -21,6 +21,13 @@
 #include "flow/IThreadPool.h"
 
 #include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include "flow/Knobs.h"
+#include "flow/UnitTest.h"
 #define BOOST_SYSTEM_NO_LIB
 #define BOOST_DATE_TIME_NO_LIB
 #define BOOST_REGEX_NO_LIB
@@ -108,3 +115,237 @@ Reference<IThreadPool>	createGenericThreadPool(int stackSize)
 }
 
 thread_local IThreadPoolReceiver* ThreadPool::Thread::threadUserObject;
+
+// Each thread has queues of its own, which post() fills in turn, and a thread whose queues are empty takes work from
+// the others' before it sleeps.  Posting and taking an action then usually only contends with the one thread that owns
+// the queue, rather than with every thread in the pool as io_service does.  Each thread's work is split into two lanes
+// by getTimeEstimate(), and the short lane is served first, so that quick reads are not held up behind batches and
+// commits; a long action still runs after at most THREAD_POOL_SHORT_ACTION_RUN short ones.
+class WorkStealingThreadPool final : public IThreadPool, public ReferenceCounted<WorkStealingThreadPool> {
+	enum { MaxThreads = 64 };
+
+	struct alignas(64) Lanes {
+		std::mutex mutex;
+		std::deque<PThreadAction> shortActions;
+		std::deque<PThreadAction> longActions;
+		int shortRun = 0; // Short actions taken since the last long one
+
+		PThreadAction take(int maxShortRun) {
+			std::lock_guard<std::mutex> lock(mutex);
+			std::deque<PThreadAction>* lane =
+			    shortActions.empty() || (shortRun >= maxShortRun && !longActions.empty()) ? &longActions : &shortActions;
+			if (lane->empty()) return nullptr;
+			shortRun = lane == &shortActions ? shortRun + 1 : 0;
+			PThreadAction action = lane->front();
+			lane->pop_front();
+			return action;
+		}
+
+		void cancelAll() {
+			std::lock_guard<std::mutex> lock(mutex);
+			for (auto lane : { &shortActions, &longActions }) {
+				for (auto action : *lane) action->cancel();
+				lane->clear();
+			}
+		}
+	};
+
+	struct Thread {
+		WorkStealingThreadPool* pool;
+		IThreadPoolReceiver* userObject;
+		int index;
+		Event stopped;
+		Thread(WorkStealingThreadPool* pool, IThreadPoolReceiver* userObject, int index)
+		  : pool(pool), userObject(userObject), index(index) {}
+		~Thread() { ASSERT_ABORT(!userObject); }
+
+		void run() {
+			deprioritizeThread();
+
+			try {
+				userObject->init();
+				while (pool->mode.load() == Run) {
+					PThreadAction action = pool->next(index);
+					if (action) {
+						(*action)(userObject);
+					} else {
+						pool->sleep();
+					}
+				}
+			} catch (Error& e) {
+				TraceEvent(SevError, "ThreadPoolError").error(e);
+			}
+			delete userObject;
+			userObject = nullptr;
+			stopped.set();
+		}
+	};
+	THREAD_FUNC start(void* p) {
+		((Thread*)p)->run();
+		THREAD_RETURN;
+	}
+
+	enum Mode { Run = 0, Shutdown = 2 };
+	std::atomic<int> mode;
+	int stackSize;
+	double shortActionEstimate;
+	int maxShortRun;
+
+	std::vector<Thread*> threads;
+	Lanes lanes[MaxThreads];
+	std::atomic<int> threadCount;
+	unsigned nextLanes; // Only used by post(), on the posting thread
+
+	// Threads sleep when pending is zero, so post() only needs sleepMutex when idle says one might be asleep
+	std::atomic<int64_t> pending;
+	std::atomic<int> idle;
+	std::mutex sleepMutex;
+	std::condition_variable wake;
+
+	// The first action found in thread's own lanes, or failing that in another thread's
+	PThreadAction next(int thread) {
+		int n = threadCount.load();
+		for (int i = 0; i < n; i++) {
+			PThreadAction action = lanes[(thread + i) % n].take(maxShortRun);
+			if (action) {
+				pending.fetch_sub(1);
+				return action;
+			}
+		}
+		return nullptr;
+	}
+
+	void sleep() {
+		std::unique_lock<std::mutex> lock(sleepMutex);
+		idle.fetch_add(1);
+		wake.wait(lock, [this] { return pending.load() > 0 || mode.load() != Run; });
+		idle.fetch_sub(1);
+	}
+
+public:
+	explicit WorkStealingThreadPool(int stackSize)
+	  : mode(Run), stackSize(stackSize), shortActionEstimate(FLOW_KNOBS->THREAD_POOL_SHORT_ACTION_ESTIMATE),
+	    maxShortRun(FLOW_KNOBS->THREAD_POOL_SHORT_ACTION_RUN), threadCount(0), nextLanes(0), pending(0), idle(0) {}
+	~WorkStealingThreadPool() {
+		for (auto& l : lanes) l.cancelAll();
+	}
+	Future<Void> stop(Error const& e = success()) override {
+		if (mode.load() == Shutdown) return Void();
+		ReferenceCounted<WorkStealingThreadPool>::addref();
+		{
+			std::lock_guard<std::mutex> lock(sleepMutex);
+			mode.store(Shutdown);
+			wake.notify_all();
+		}
+		for (int i = 0; i < threads.size(); i++) {
+			threads[i]->stopped.block();
+			delete threads[i];
+		}
+		threads.clear();
+		for (auto& l : lanes) l.cancelAll();
+		ReferenceCounted<WorkStealingThreadPool>::delref();
+		return Void();
+	}
+	Future<Void> getError() const override { return Never(); } // FIXME
+	void addref() override { ReferenceCounted<WorkStealingThreadPool>::addref(); }
+	void delref() override {
+		if (ReferenceCounted<WorkStealingThreadPool>::delref_no_destroy()) stop();
+	}
+	void addThread(IThreadPoolReceiver* userData) override {
+		ASSERT(threads.size() < MaxThreads);
+		threads.push_back(new Thread(this, userData, threads.size()));
+		threadCount.store(threads.size());
+		startThread(start, threads.back(), stackSize);
+	}
+	void post(PThreadAction action) override {
+		Lanes& l = lanes[nextLanes++ % std::max(threadCount.load(), 1)];
+		{
+			std::lock_guard<std::mutex> lock(l.mutex);
+			(action->getTimeEstimate() <= shortActionEstimate ? l.shortActions : l.longActions).push_back(action);
+		}
+		pending.fetch_add(1);
+		if (idle.load() > 0) {
+			std::lock_guard<std::mutex> lock(sleepMutex);
+			wake.notify_one();
+		}
+	}
+};
+
+Reference<IThreadPool> createWorkStealingThreadPool(int stackSize) {
+	return Reference<IThreadPool>(new WorkStealingThreadPool(stackSize));
+}
+
+namespace {
+
+struct RecordReceiver;
+
+struct RecordAction : TypedAction<RecordReceiver, RecordAction> {
+	double estimate;
+	int id;
+	std::atomic<int>* gate; // If set, the action counts itself done as soon as it starts, then waits for it to be set
+	std::vector<int>* order;
+	std::atomic<int>* done;
+	RecordAction(double estimate, int id, std::atomic<int>* gate, std::vector<int>* order, std::atomic<int>* done)
+	  : estimate(estimate), id(id), gate(gate), order(order), done(done) {}
+	double getTimeEstimate() const override { return estimate; }
+};
+
+struct RecordReceiver : IThreadPoolReceiver {
+	void init() override {}
+	void action(RecordAction& a) {
+		if (a.gate) {
+			a.done->fetch_add(1);
+			while (!a.gate->load()) std::this_thread::yield();
+			return;
+		}
+		if (a.order) a.order->push_back(a.id);
+		a.done->fetch_add(1);
+	}
+};
+
+} // namespace
+
+TEST_CASE("/flow/IThreadPool/WorkStealing") {
+	const double shortEstimate = FLOW_KNOBS->THREAD_POOL_SHORT_ACTION_ESTIMATE;
+	const double longEstimate = shortEstimate * 10;
+
+	// With one thread, short actions overtake the long ones posted before them, but not indefinitely
+	{
+		Reference<IThreadPool> pool = createWorkStealingThreadPool();
+		pool->addThread(new RecordReceiver);
+		std::atomic<int> gate(0), done(0);
+		std::vector<int> order;
+		pool->post(new RecordAction(longEstimate, -1, &gate, nullptr, &done));
+		// The rest queue up while the thread is held by the gate
+		while (done.load() == 0) std::this_thread::yield();
+		const int longCount = 2, shortCount = FLOW_KNOBS->THREAD_POOL_SHORT_ACTION_RUN + 2;
+		for (int i = 0; i < longCount; i++) pool->post(new RecordAction(longEstimate, 1000 + i, nullptr, &order, &done));
+		for (int i = 0; i < shortCount; i++) pool->post(new RecordAction(shortEstimate, i, nullptr, &order, &done));
+		gate.store(1);
+		while (done.load() < 1 + longCount + shortCount) std::this_thread::yield();
+		pool->stop();
+
+		ASSERT(order.size() == longCount + shortCount);
+		int shortsBeforeFirstLong = std::find(order.begin(), order.end(), 1000) - order.begin();
+		ASSERT(shortsBeforeFirstLong > 0 && shortsBeforeFirstLong <= FLOW_KNOBS->THREAD_POOL_SHORT_ACTION_RUN);
+		ASSERT(std::is_sorted(order.begin(), order.begin() + shortsBeforeFirstLong));
+	}
+
+	// Actions queued behind a blocked thread are taken by the others
+	{
+		Reference<IThreadPool> pool = createWorkStealingThreadPool();
+		const int threads = 4, actions = 1000;
+		for (int i = 0; i < threads; i++) pool->addThread(new RecordReceiver);
+		std::atomic<int> gate(0), done(0);
+		pool->post(new RecordAction(longEstimate, -1, &gate, nullptr, &done));
+		for (int i = 0; i < actions; i++) {
+			pool->post(new RecordAction(i % 2 ? shortEstimate : longEstimate, i, nullptr, nullptr, &done));
+		}
+		// The first thread is held by the gate until the others have done all of the rest, including its share
+		while (done.load() < actions + 1) std::this_thread::yield();
+		gate.store(1);
+		pool->stop();
+	}
+
+	return Void();
+}
@@ -108,6 +108,9 @@ private:
 };
 
 Reference<IThreadPool>	createGenericThreadPool(int stackSize = 0);
+// Like createGenericThreadPool(), with a queue per thread that the others take work from when idle, and actions with a
+// small getTimeEstimate() run ahead of the rest
+Reference<IThreadPool> createWorkStealingThreadPool(int stackSize = 0);
 
 class DummyThreadPool final : public IThreadPool, ReferenceCounted<DummyThreadPool> {
 public:
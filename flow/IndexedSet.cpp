@@ -22,10 +22,12 @@
 // and so all the important implementation is in the header file
 
 #include "flow/IndexedSet.h"
+#include "flow/BTreeIndexedSet.h"
 #include "flow/IRandom.h"
 #include "flow/ThreadPrimitives.h"
 #include <cinttypes>
 #include <algorithm>
+#include <map>
 #include <set>
 #include <string>
 #include <cstring>
@@ -202,9 +204,9 @@ TEST_CASE("/flow/IndexedSet/strings") {
 	return Void();
 }
 
-template <typename K>
+template <typename K, template <class, class> class Set = IndexedSet>
 struct IndexedSetHarness {
-	using map = IndexedSet<K, int>;
+	using map = Set<K, int>;
 	using const_result = typename map::const_iterator;
 	using result = typename map::iterator;
 	using key_type = K;
@@ -252,6 +254,22 @@ TEST_CASE("performance/map/int/IndexedSet") {
 	return Void();
 }
 
+TEST_CASE("performance/map/StringRef/BTreeIndexedSet") {
+	Arena arena;
+
+	IndexedSetHarness<StringRef, BTreeIndexedSet> is;
+	treeBenchmark(is, [&arena]() { return randomStr(arena); });
+
+	return Void();
+}
+
+TEST_CASE("performance/map/int/BTreeIndexedSet") {
+	IndexedSetHarness<int, BTreeIndexedSet> is;
+	treeBenchmark(is, &randomInt);
+
+	return Void();
+}
+
 TEST_CASE("performance/map/int/StdMap") {
 	MapHarness<int> is;
 	treeBenchmark(is, &randomInt);
@@ -457,6 +475,58 @@ TEST_CASE("/flow/IndexedSet/comparison to std::set") {
 	return Void();
 }
 
+// Keys short enough, and sharing enough of their first bytes, that searches often have to fall back from comparing
+// prefixes to comparing whole keys
+static Standalone<StringRef> randomPrefixTestKey() {
+	std::string k;
+	int n = deterministicRandom()->randomInt(0, 7);
+	for (int i = 0; i < n; i++) k += "\x00\x01a\xff"[deterministicRandom()->randomInt(0, 4)];
+	return Standalone<StringRef>(k);
+}
+
+template <class Metric>
+static void testKeyPrefixes() {
+	IndexedSet<MapPair<Standalone<StringRef>, int>, Metric> is;
+	std::map<std::string, int> sm;
+	for (int i = 0; i < 10000; i++) {
+		auto k = randomPrefixTestKey();
+		if (deterministicRandom()->random01() < 0.1) {
+			std::vector<std::pair<MapPair<Standalone<StringRef>, int>, Metric>> batch;
+			for (int j = 0; j < 5; j++) {
+				batch.emplace_back(MapPair<Standalone<StringRef>, int>(k, i), Metric(1));
+				sm.emplace(k.toString(), i);
+				k = randomPrefixTestKey();
+			}
+			std::sort(batch.begin(), batch.end(), [](auto const& a, auto const& b) { return a.first < b.first; });
+			const auto& sorted = batch;
+			is.insert(sorted, false);
+		} else {
+			is.insert(MapPair<Standalone<StringRef>, int>(k, i), Metric(1), false);
+			sm.emplace(k.toString(), i);
+		}
+
+		auto q = randomPrefixTestKey();
+		auto f = is.find(StringRef(q));
+		ASSERT(f == is.end() ? !sm.count(q.toString()) : f->value == sm[q.toString()]);
+		auto lb = is.lower_bound(StringRef(q));
+		auto slb = sm.lower_bound(q.toString());
+		ASSERT(lb == is.end() ? slb == sm.end() : slb != sm.end() && lb->key == StringRef(slb->first));
+		auto ub = is.upper_bound(q);
+		auto sub = sm.upper_bound(q.toString());
+		ASSERT(ub == is.end() ? sub == sm.end() : sub != sm.end() && ub->key == StringRef(sub->first));
+	}
+}
+
+TEST_CASE("/flow/IndexedSet/key prefixes") {
+	static_assert(sizeof(IndexedSetKeyPrefixFor<MapPair<Standalone<StringRef>, int>, NoMetric>) == 4);
+	static_assert(sizeof(IndexedSetKeyPrefixFor<MapPair<Standalone<StringRef>, int>, int>) == 2);
+	static_assert(!IndexedSetKeyPrefixFor<int, NoMetric>::enabled);
+
+	testKeyPrefixes<NoMetric>();
+	testKeyPrefixes<int>();
+	return Void();
+}
+
 TEST_CASE("/flow/IndexedSet/all numbers") {
 	IndexedSet<int, int64_t> is;
 	std::mt19937_64 urng(deterministicRandom()->randomUInt32());
@@ -559,3 +629,81 @@ TEST_CASE("/flow/IndexedSet/const_iterator") {
 	return Void();
 }
 void forceLinkIndexedSetTests() {}
+
+TEST_CASE("/flow/BTreeIndexedSet/comparison to IndexedSet") {
+	// Few enough distinct keys that leaves fill, split, drain and merge many times over
+	const int keyCount = deterministicRandom()->coinflip() ? 500 : 20000;
+	BTreeIndexedSet<int, int64_t> bt;
+	IndexedSet<int, int64_t> is;
+
+	for (int step = 0; step < 100000; step++) {
+		int k = deterministicRandom()->randomInt(0, keyCount);
+		int op = deterministicRandom()->randomInt(0, 100);
+		if (op < 45) {
+			int64_t metric = deterministicRandom()->randomInt(0, 10);
+			bool replace = deterministicRandom()->coinflip();
+			bt.insert(k, metric, replace);
+			is.insert(k, metric, replace);
+		} else if (op < 55) {
+			int64_t metric = deterministicRandom()->randomInt(1, 5);
+			ASSERT(bt.addMetric(k, metric) == is.addMetric(k, metric));
+		} else if (op < 80) {
+			bt.erase(k);
+			is.erase(k);
+		} else if (op < 84) {
+			int end = deterministicRandom()->randomInt(k, keyCount + 1);
+			bt.erase(k, end);
+			is.erase(k, end);
+		} else {
+			auto b = bt.lower_bound(k);
+			auto i = is.lower_bound(k);
+			ASSERT((b == bt.end()) == (i == is.end()) && (b == bt.end() || *b == *i));
+			ASSERT(bt.sumTo(b) == is.sumTo(i));
+			b = bt.upper_bound(k);
+			i = is.upper_bound(k);
+			ASSERT((b == bt.end()) == (i == is.end()) && (b == bt.end() || *b == *i));
+			ASSERT(bt.count(k) == is.count(k));
+
+			int64_t total = is.sumTo(is.end());
+			ASSERT(bt.sumTo(bt.end()) == total);
+			int64_t m = deterministicRandom()->randomInt64(-1, total + 2);
+			b = bt.index(m);
+			i = is.index(m);
+			ASSERT((b == bt.end()) == (i == is.end()) && (b == bt.end() || *b == *i));
+		}
+
+		if (step % 1000 == 0) {
+			bt.testonly_assertValid();
+			auto b = bt.begin();
+			for (auto i = is.begin(); i != is.end(); ++i, ++b) {
+				ASSERT(b != bt.end() && *b == *i && bt.getMetric(b) == is.getMetric(i));
+			}
+			ASSERT(b == bt.end());
+		}
+	}
+
+	bt.erase(bt.begin(), bt.end());
+	ASSERT(bt.empty());
+
+	return Void();
+}
+
+TEST_CASE("/flow/BTreeIndexedSet/strings") {
+	BTreeIndexedSet<Standalone<StringRef>, int64_t> bt;
+	for (int i = 0; i < 10000; i++) {
+		bt.insert(StringRef(format("%08d", i)), 1);
+	}
+	bt.testonly_assertValid();
+
+	// Keys are inserted by copy from shorter lived refs, and can be found with refs
+	Standalone<StringRef> k = LiteralStringRef("00005000");
+	ASSERT(bt.find(StringRef(k)) != bt.end() && *bt.find(StringRef(k)) == k);
+	ASSERT(bt.sumRange(LiteralStringRef("00001000"), LiteralStringRef("00002000")) == 1000);
+
+	bt.erase(LiteralStringRef("00001000"), LiteralStringRef("00009000"));
+	bt.testonly_assertValid();
+	ASSERT(bt.sumTo(bt.end()) == 2000);
+	ASSERT(*bt.index(1000) == LiteralStringRef("00009000"));
+
+	return Void();
+}
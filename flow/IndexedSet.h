@@ -58,6 +58,69 @@ class Void;
 
 class StringRef;
 
+// Nodes of an IndexedSet whose elements are keyed by a StringRef keep the first few bytes of their key alongside it,
+// when the node's padding has room for them, so that most comparisons made on the way down the tree are settled
+// without following the key's pointer.  Prefixes are big endian and zero padded: a key whose prefix is less than
+// another's is itself less, and only keys with equal prefixes need to be compared in full.
+//
+// IndexedSetKeyOf<T> says whether T (an element or a search key) is keyed by a StringRef, and how to get it.
+template <class T>
+struct IndexedSetKeyOf {
+	static constexpr bool enabled = false;
+};
+
+template <>
+struct IndexedSetKeyOf<StringRef> {
+	static constexpr bool enabled = true;
+	static StringRef get(StringRef const& key) { return key; }
+};
+
+template <>
+struct IndexedSetKeyOf<Standalone<StringRef>> : IndexedSetKeyOf<StringRef> {};
+
+template <class Prefix>
+struct IndexedSetKeyPrefix {
+	static constexpr bool enabled = true;
+	Prefix value;
+
+	static Prefix of(StringRef key) {
+		Prefix prefix = 0;
+		int n = std::min<int>(key.size(), sizeof(Prefix));
+		for (int i = 0; i < n; i++) {
+			prefix |= (Prefix)key[i] << (8 * (sizeof(Prefix) - 1 - i));
+		}
+		return prefix;
+	}
+};
+
+template <>
+struct IndexedSetKeyPrefix<void> {
+	static constexpr bool enabled = false;
+};
+
+// Mirrors the layout of IndexedSet::Node, to find the widest prefix that does not make it any larger
+template <class T, class Metric, class Prefix>
+struct IndexedSetNodeLayout {
+	T data;
+	IndexedSetKeyPrefix<Prefix> prefix;
+	signed char balance;
+	Metric total;
+	void* child[2];
+	void* parent;
+};
+
+template <class T, class Metric>
+using IndexedSetKeyPrefixFor = IndexedSetKeyPrefix<std::conditional_t<
+    !IndexedSetKeyOf<T>::enabled,
+    void,
+    std::conditional_t<
+        sizeof(IndexedSetNodeLayout<T, Metric, uint32_t>) == sizeof(IndexedSetNodeLayout<T, Metric, void>),
+        uint32_t,
+        std::conditional_t<sizeof(IndexedSetNodeLayout<T, Metric, uint16_t>) ==
+                               sizeof(IndexedSetNodeLayout<T, Metric, void>),
+                           uint16_t,
+                           void>>>>;
+
 template <class T, class Metric>
 struct IndexedSet{
 	typedef T value_type;
@@ -71,6 +134,9 @@ private: // Forward-declare IndexedSet::Node because Clang is much stricter abou
 		template <class T_, class Metric_>
 		Node(T_&& data, Metric_&& m, Node* parent=0) : data(std::forward<T_>(data)), total(std::forward<Metric_>(m)), parent(parent), balance(0) {
 			child[0] = child[1] = nullptr;
+			if constexpr (Prefix::enabled) {
+				prefix.value = Prefix::of(IndexedSetKeyOf<T>::get(this->data));
+			}
 		}
 		Node(Node const&) = delete;
 		Node& operator=(Node const&) = delete;
@@ -79,7 +145,10 @@ private: // Forward-declare IndexedSet::Node because Clang is much stricter abou
 			delete child[1];
 		}
 
+		using Prefix = IndexedSetKeyPrefixFor<T, Metric>;
+
 		T data;
+		Prefix prefix;			// of data's key, if enabled
 		signed char balance;	// right height - left height
 		Metric total;			// this + child[0] + child[1]
 		Node *child[2];			// left, right
@@ -307,6 +376,47 @@ private:
 
 	Node *root;
 
+	// Searches for a Key compare its prefix, computed once, to those of the nodes they pass, and fall back to comparing
+	// the key itself only when the prefixes are equal
+	template <class Key>
+	static constexpr bool searchUsesPrefix = Node::Prefix::enabled && IndexedSetKeyOf<std::decay_t<Key>>::enabled;
+
+	template <class Key>
+	static auto searchPrefix(const Key& key) {
+		if constexpr (searchUsesPrefix<Key>) {
+			return Node::Prefix::of(IndexedSetKeyOf<std::decay_t<Key>>::get(key));
+		} else {
+			return 0;
+		}
+	}
+
+	// compare(key, n->data)
+	template <class Key, class Prefix>
+	static int compareToNode(const Key& key, Prefix keyPrefix, const Node* n) {
+		if constexpr (searchUsesPrefix<Key>) {
+			if (keyPrefix != n->prefix.value) return keyPrefix < n->prefix.value ? -1 : 1;
+		}
+		return compare(key, n->data);
+	}
+
+	// n->data < key
+	template <class Key, class Prefix>
+	static bool nodeLess(const Node* n, const Key& key, Prefix keyPrefix) {
+		if constexpr (searchUsesPrefix<Key>) {
+			if (keyPrefix != n->prefix.value) return n->prefix.value < keyPrefix;
+		}
+		return n->data < key;
+	}
+
+	// key < n->data
+	template <class Key, class Prefix>
+	static bool lessThanNode(const Key& key, Prefix keyPrefix, const Node* n) {
+		if constexpr (searchUsesPrefix<Key>) {
+			if (keyPrefix != n->prefix.value) return keyPrefix < n->prefix.value;
+		}
+		return key < n->data;
+	}
+
 	Metric eraseHalf(Node* start, Node* end, int eraseDir, int& heightDelta, std::vector<Node*>& toFree);
 	void erase( iterator begin, iterator end, std::vector<Node*>& toFree );
 
@@ -385,6 +495,12 @@ public:
 //private: MapPair( const MapPair& );
 };
 
+template <class Key, class Value>
+struct IndexedSetKeyOf<MapPair<Key, Value>> {
+	static constexpr bool enabled = IndexedSetKeyOf<Key>::enabled;
+	static StringRef get(MapPair<Key, Value> const& p) { return p.key; }
+};
+
 template <class Key, class Value, class CompatibleWithKey>
 inline int compare(CompatibleWithKey const& l, MapPair<Key, Value> const& r) {
 	return compare(l, r.key);
@@ -798,9 +914,10 @@ typename IndexedSet<T,Metric>::iterator IndexedSet<T,Metric>::insert(T_&& data,
 	}
 	Node *t = root;
 	int d; // direction
+	auto dataPrefix = searchPrefix(data);
 	// traverse to find insert point
 	while (true){
-		int cmp = compare(data, t->data);
+		int cmp = compareToNode(data, dataPrefix, t);
 		if (cmp == 0) {
 			Node *returnNode = t;
 			if(replaceExisting) {
@@ -884,10 +1001,11 @@ int IndexedSet<T,Metric>::insert(const std::vector<std::pair<T,Metric>>& dataVec
 			}
 
 			Node *t = root;
+			auto dataPrefix = searchPrefix(data);
 			// traverse to find insert point
 			bool foundNode = false;
 			while (true) {
-				int cmp = compare(data, t->data);
+				int cmp = compareToNode(data, dataPrefix, t);
 				d = cmp > 0;
 				if (d == 0)
 					blockEnd = t;
@@ -1185,8 +1303,9 @@ template <class Key>
 typename IndexedSet<T, Metric>::template Impl<isConst>::IteratorT IndexedSet<T, Metric>::Impl<isConst>::find(
     IndexedSet<T, Metric>::Impl<isConst>::SetT& self, const Key& key) {
 	NodeT* t = self.root;
+	auto keyPrefix = searchPrefix(key);
 	while (t){
-		int cmp = compare(key, t->data);
+		int cmp = compareToNode(key, keyPrefix, t);
 		if (cmp == 0) return IteratorT{ t };
 		t = t->child[cmp > 0];
 	}
@@ -1201,9 +1320,10 @@ typename IndexedSet<T, Metric>::template Impl<isConst>::IteratorT IndexedSet<T,
     IndexedSet<T, Metric>::Impl<isConst>::SetT& self, const Key& key) {
 	NodeT* t = self.root;
 	if (!t) return self.end();
+	auto keyPrefix = searchPrefix(key);
 	bool less;
 	while (true) {
-		less = t->data < key;
+		less = nodeLess(t, key, keyPrefix);
 		NodeT* n = t->child[less];
 		if (!n) break;
 		t = n;
@@ -1222,9 +1342,10 @@ typename IndexedSet<T, Metric>::template Impl<isConst>::IteratorT IndexedSet<T,
     IndexedSet<T, Metric>::Impl<isConst>::SetT& self, const Key& key) {
 	NodeT* t = self.root;
 	if (!t) return self.end();
+	auto keyPrefix = searchPrefix(key);
 	bool not_less;
 	while (true) {
-		not_less = !(key < t->data);
+		not_less = !lessThanNode(key, keyPrefix, t);
 		NodeT* n = t->child[not_less];
 		if (!n) break;
 		t = n;
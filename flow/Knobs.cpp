@@ -40,6 +40,7 @@ void FlowKnobs::initialize(bool randomize, bool isSimulated) {
 	init( DELAY_JITTER_OFFSET,                                 0.9 );
 	init( DELAY_JITTER_RANGE,                                  0.2 );
 	init( BUSY_WAIT_THRESHOLD,                                   0 ); // 1e100 == never sleep
+	init( NETWORK_BUSY_POLL_TIME,                              0.0 ); // When the run loop goes idle, poll the reactor without blocking for up to this long before sleeping; trades CPU for wakeup latency on dedicated cores
 	init( CLIENT_REQUEST_INTERVAL,                             1.0 ); if( randomize && BUGGIFY ) CLIENT_REQUEST_INTERVAL = 2.0;
 	init( SERVER_REQUEST_INTERVAL,                             1.0 ); if( randomize && BUGGIFY ) SERVER_REQUEST_INTERVAL = 2.0;
 
@@ -52,17 +53,25 @@ void FlowKnobs::initialize(bool randomize, bool isSimulated) {
 	init( SLOWTASK_PROFILING_LOG_INTERVAL,                       0 ); // A value of 0 means use RUN_LOOP_PROFILING_INTERVAL
 	init( SLOWTASK_PROFILING_MAX_LOG_INTERVAL,                 1.0 );
 	init( SLOWTASK_PROFILING_LOG_BACKOFF,                      2.0 );
+	init( ACTOR_PROFILER,                                    false ); // Attribute run loop time to actors, reported in ActorProfile events and in SlowTask events
+	init( ACTOR_PROFILER_TOP_ACTORS,                            20 );
 	init( SATURATION_PROFILING_LOG_INTERVAL,                   0.5 ); // A value of 0 means use RUN_LOOP_PROFILING_INTERVAL
 	init( SATURATION_PROFILING_MAX_LOG_INTERVAL,               5.0 );
 	init( SATURATION_PROFILING_LOG_BACKOFF,                    2.0 );
 
 	init( RANDOMSEED_RETRY_LIMIT,                                4 );
 	init( FAST_ALLOC_LOGGING_BYTES,                           10e6 );
+	init( FAST_ALLOC_HUGE_PAGE_REGIONS,                      false ); if( randomize && BUGGIFY ) FAST_ALLOC_HUGE_PAGE_REGIONS = true; // Carve FastAllocator blocks out of 2MiB aligned regions that transparent hugepages can back (Linux only)
+	init( FAST_ALLOC_LOCAL_NUMA_NODE,                        false ); // Binds those regions, preferably, to the NUMA node of the CPU that allocates them
+	init( FAST_ALLOC_RECLAIM_MIN_UNUSED_BYTES,            64 << 20 ); if( randomize && BUGGIFY ) FAST_ALLOC_RECLAIM_MIN_UNUSED_BYTES = 1; // Size classes with at least this much unused memory return what they can to the OS when system metrics are logged; 0 disables
 	init( HUGE_ARENA_LOGGING_BYTES,                          100e6 );
 	init( HUGE_ARENA_LOGGING_INTERVAL,                         5.0 );
+	init( ARENA_PROFILER_SAMPLE_BYTES,                           0 ); if( randomize && BUGGIFY ) ARENA_PROFILER_SAMPLE_BYTES = 100000; // Takes a backtrace for one in about this many bytes of arena blocks allocated; 0 disables
+	init( ARENA_PROFILER_LOGGED_SITES,                          20 );
 
 	init( WRITE_TRACING_ENABLED,                              true ); if( randomize && BUGGIFY ) WRITE_TRACING_ENABLED = false;
 	init( TRACING_UDP_LISTENER_PORT,                          8889 ); // Only applicable if TracerType is set to a network option.
+	init( TRACING_SAMPLE_RATE,                                 1.0 ); if( randomize && BUGGIFY ) TRACING_SAMPLE_RATE = 0.01; // Fraction of traces whose spans are exported, chosen by trace ID so every process keeps the same traces
 
 	//connectionMonitor
 	init( CONNECTION_MONITOR_LOOP_TIME,   isSimulated ? 0.75 : 1.0 ); if( randomize && BUGGIFY ) CONNECTION_MONITOR_LOOP_TIME = 6.0;
@@ -70,6 +79,9 @@ void FlowKnobs::initialize(bool randomize, bool isSimulated) {
 	init( CONNECTION_MONITOR_IDLE_TIMEOUT,                   180.0 ); if( randomize && BUGGIFY ) CONNECTION_MONITOR_IDLE_TIMEOUT = 5.0;
 	init( CONNECTION_MONITOR_INCOMING_IDLE_MULTIPLIER,         1.2 );
 	init( CONNECTION_MONITOR_UNREFERENCED_CLOSE_DELAY,         2.0 );
+	init( CONNECTION_MONITOR_SKIP_BUSY_PINGS,                false ); if( randomize && BUGGIFY ) CONNECTION_MONITOR_SKIP_BUSY_PINGS = true; // Don't ping a connection that has received data since the last monitor cycle
+	init( INDIRECT_PING_PROBES,                                  0 ); if( randomize && BUGGIFY ) INDIRECT_PING_PROBES = deterministicRandom()->randomInt(1, 4); // When a server's connection fails, ask this many other servers to ping it, and mark it failed early if none can
+	init( INDIRECT_PING_TIMEOUT, 2.0 * CONNECTION_MONITOR_TIMEOUT );
 
 	//FlowTransport
 	init( CONNECTION_REJECTED_MESSAGE_DELAY,                   1.0 );
@@ -99,6 +111,12 @@ void FlowKnobs::initialize(bool randomize, bool isSimulated) {
 	init( TLS_HANDSHAKE_THREAD_STACKSIZE,                64 * 1024 );
 	init( TLS_MALLOC_ARENA_MAX,                                  6 );
 	init( TLS_HANDSHAKE_LIMIT,                                1000 );
+	init( TLS_SESSION_RESUMPTION,                             true ); // Clients offer the session of their last connection to a peer when reconnecting
+	init( TLS_SESSION_CACHE_SIZE,                            10000 ); // Peers whose sessions a process keeps for resumption
+
+	//Work stealing thread pool
+	init( THREAD_POOL_SHORT_ACTION_ESTIMATE,                0.0001 ); // Actions estimated to take no longer than this are run ahead of longer ones
+	init( THREAD_POOL_SHORT_ACTION_RUN,                          8 ); // A longer action is run after at most this many short ones
 
 	init( NETWORK_TEST_CLIENT_COUNT,                            30 );
 	init( NETWORK_TEST_REPLY_SIZE,                           600e3 );
@@ -114,9 +132,15 @@ void FlowKnobs::initialize(bool randomize, bool isSimulated) {
 	init( BUGGIFY_SIM_PAGE_CACHE_4K,                           1e6 );
 	init( BUGGIFY_SIM_PAGE_CACHE_64K,                          1e6 );
 	init( MAX_EVICT_ATTEMPTS,                                  100 ); if( randomize && BUGGIFY ) MAX_EVICT_ATTEMPTS = 2;
-	init( CACHE_EVICTION_POLICY,                          "random" );
+	init( CACHE_EVICTION_POLICY,                          "random" ); if( randomize && BUGGIFY ) CACHE_EVICTION_POLICY = deterministicRandom()->coinflip() ? "lru" : "slru";
+	init( CACHE_PROTECTED_FRACTION,                            0.8 ); if( randomize && BUGGIFY ) CACHE_PROTECTED_FRACTION = deterministicRandom()->random01(); // SLRU: share of the cache that pages hit more than once may hold
+	init( CACHE_SCAN_DETECT_PAGES,                              16 ); if( randomize && BUGGIFY ) CACHE_SCAN_DETECT_PAGES = deterministicRandom()->randomInt(0, 3); // Consecutive page misses after which reads are treated as a scan; 0 disables
 	init( PAGE_CACHE_TRUNCATE_LOOKUP_FRACTION,                 0.1 ); if( randomize && BUGGIFY ) PAGE_CACHE_TRUNCATE_LOOKUP_FRACTION = 0.0; else if( randomize && BUGGIFY ) PAGE_CACHE_TRUNCATE_LOOKUP_FRACTION = 1.0;
 
+	//AsyncFileReadAheadCache
+	init( READ_AHEAD_ADAPTIVE_MAX_BYTES,                     256e6 ); if( randomize && BUGGIFY ) READ_AHEAD_ADAPTIVE_MAX_BYTES = 2e6; // Process-wide memory for read ahead windows that have grown
+	init( READ_AHEAD_RATE_FOLDING_TIME,                        1.0 );
+
 	//AsyncFileEIO
 	init( EIO_MAX_PARALLELISM,                                  4  );
 	init( EIO_USE_ODIRECT,                                      0  );
@@ -124,10 +148,16 @@ void FlowKnobs::initialize(bool randomize, bool isSimulated) {
 	//AsyncFileKAIO
 	init( MAX_OUTSTANDING,                                      64 );
 	init( MIN_SUBMIT,                                           10 );
+	init( KAIO_BACKGROUND_BYTES_PER_SECOND,                      0 ); // Zero for no limit
+	init( KAIO_BACKGROUND_TASK_PRIORITY,   (int)TaskPriority::CompactCache ); // I/O issued at or below this priority is limited to KAIO_BACKGROUND_BYTES_PER_SECOND
 
 	init( PAGE_WRITE_CHECKSUM_HISTORY,                           0 ); if( randomize && BUGGIFY ) PAGE_WRITE_CHECKSUM_HISTORY = 10000000;
 	init( DISABLE_POSIX_KERNEL_AIO,                              0 );
 
+	//AsyncFileIOUring
+	init( USE_IO_URING,                                      false ); // Use io_uring instead of KAIO for unbuffered files where the kernel supports it
+	init( IO_URING_ENTRIES,                                    256 ); // Must be a power of 2 and at least MAX_OUTSTANDING
+
 	//AsyncFileNonDurable
 	init( MAX_PRIOR_MODIFICATION_DELAY,                        1.0 ); if( randomize && BUGGIFY ) MAX_PRIOR_MODIFICATION_DELAY = 10.0;
 
@@ -142,9 +172,17 @@ void FlowKnobs::initialize(bool randomize, bool isSimulated) {
 	//Net2 and FlowTransport
 	init( MIN_COALESCE_DELAY,                                10e-6 ); if( randomize && BUGGIFY ) MIN_COALESCE_DELAY = 0;
 	init( MAX_COALESCE_DELAY,                                20e-6 ); if( randomize && BUGGIFY ) MAX_COALESCE_DELAY = 0;
+	init( MAX_ADAPTIVE_COALESCE_DELAY,                           0 ); if( randomize && BUGGIFY ) MAX_ADAPTIVE_COALESCE_DELAY = 200e-6; // While writes to a peer average fewer than ADAPTIVE_COALESCE_BYTES, write to it at most this often; 0 disables
+	init( ADAPTIVE_COALESCE_BYTES,                            1400 );
 	init( SLOW_LOOP_CUTOFF,                          15.0 / 1000.0 );
 	init( SLOW_LOOP_SAMPLING_RATE,                             0.1 );
 	init( TSC_YIELD_TIME,                                  1000000 );
+	init( TSC_YIELD_TIME_BACKGROUND,                             0 ); // Timestamp counter ticks of each run loop slice that tasks below TSC_YIELD_BACKGROUND_PRIORITY may use; 0 gives them all of TSC_YIELD_TIME
+	init( TSC_YIELD_BACKGROUND_PRIORITY,                      5000 ); // TaskPriority::DefaultEndpoint
+	init( YIELD_BUDGET_INTERVAL,                                16 ); // Units of work between the yield checks of a YieldBudget
+	init( NET2_WORKER_REACTORS,                                  0 ); // Threads for INetwork::runOnWorkerReactor(); 0 runs that work inline on the network thread
+	init( NET2_THREAD_READY_BATCH_SIZE,                         64 ); // Tasks handed to the network thread from other threads are run up to this many at a time as one task; 1 runs each on its own
+	init( NET2_TIMING_WHEEL_RESOLUTION,                          0 ); // Seconds per tick of a hierarchical timing wheel for delay(); 0 uses a binary heap
 	init( MIN_LOGGED_PRIORITY_BUSY_FRACTION,                  0.05 );
 	init( CERT_FILE_MAX_SIZE,                      5 * 1024 * 1024 );
 
@@ -153,10 +191,14 @@ void FlowKnobs::initialize(bool randomize, bool isSimulated) {
 	init( PACKET_WARNING,                                  2LL<<20 );  // 2MB packet warning quietly allows for 1MB system messages
 	init( TIME_OFFSET_LOGGING_INTERVAL,                       60.0 );
 	init( MAX_PACKET_SEND_BYTES,                        128 * 1024 );
+	init( BULK_PACKET_BYTES,                                     0 ); if( randomize && BUGGIFY ) BULK_PACKET_BYTES = deterministicRandom()->coinflip() ? 256 * 1024 : deterministicRandom()->randomInt(1, 64 * 1024);
 	init( MIN_PACKET_BUFFER_BYTES,                        4 * 1024 );
 	init( MIN_PACKET_BUFFER_FREE_BYTES,                        256 );
 	init( FLOW_TCP_NODELAY,                                      1 );
 	init( FLOW_TCP_QUICKACK,                                     0 );
+	init( WIRE_COMPRESSION,                                      0 ); if( randomize && BUGGIFY ) WIRE_COMPRESSION = deterministicRandom()->randomInt(1, 3); // 0: never compress, 1: compress packets to peers with another dcId, 2: compress packets to every peer
+	init( WIRE_COMPRESSION_MIN_BYTES,                         4096 ); if( randomize && BUGGIFY ) WIRE_COMPRESSION_MIN_BYTES = 100;
+	init( WIRE_COMPRESSION_LEVEL,                                1 );
 
 	//Sim2
 	init( MIN_OPEN_TIME,                                    0.0002 );
@@ -225,6 +267,11 @@ void FlowKnobs::initialize(bool randomize, bool isSimulated) {
 	init( BASIC_LOAD_BALANCE_MIN_CPU,                         0.05 ); //do not adjust LB probabilities if the proxies are less than 5% utilized
 	init( BASIC_LOAD_BALANCE_BUCKETS,                           40 ); //proxies bin recent GRV requests into 40 time bins
 	init( BASIC_LOAD_BALANCE_COMPUTE_PRECISION,              10000 ); //determines how much of the LB usage is holding the CPU usage of the proxy
+	init( LOAD_BALANCE_LATENCY_AWARE,                        false ); if( randomize && BUGGIFY ) LOAD_BALANCE_LATENCY_AWARE = true; // Pick the better of two random replicas by smoothed latency and in-flight requests, and hedge at a latency percentile
+	init( LOAD_BALANCE_LATENCY_SMOOTHING,                      0.1 ); // Weight of each new latency sample in a replica's moving average
+	init( LOAD_BALANCE_IN_FLIGHT_PENALTY,                      1.0 ); // Each request in flight to a replica inflates its expected latency by this fraction
+	init( LOAD_BALANCE_HEDGE_PERCENTILE,                      0.95 ); // A backup request is sent once the first has outlasted this percentile of the replica's latency
+	init( LOAD_BALANCE_HEDGE_BUDGET,                          0.02 ); if( randomize && BUGGIFY ) LOAD_BALANCE_HEDGE_BUDGET = 0.5; // Backup requests are limited to about this fraction of all requests
 
 	// Health Monitor
 	init( FAILURE_DETECTION_DELAY,                             4.0 ); if( randomize && BUGGIFY ) FAILURE_DETECTION_DELAY = 1.0;
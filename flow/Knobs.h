@@ -58,6 +58,7 @@ public:
 	double DELAY_JITTER_OFFSET;
 	double DELAY_JITTER_RANGE;
 	double BUSY_WAIT_THRESHOLD;
+	double NETWORK_BUSY_POLL_TIME;
 	double CLIENT_REQUEST_INTERVAL;
 	double SERVER_REQUEST_INTERVAL;
 
@@ -66,17 +67,25 @@ public:
 
 	int RANDOMSEED_RETRY_LIMIT;
 	double FAST_ALLOC_LOGGING_BYTES;
+	int64_t FAST_ALLOC_RECLAIM_MIN_UNUSED_BYTES;
+	bool FAST_ALLOC_HUGE_PAGE_REGIONS;
+	bool FAST_ALLOC_LOCAL_NUMA_NODE;
 	double HUGE_ARENA_LOGGING_BYTES;
 	double HUGE_ARENA_LOGGING_INTERVAL;
+	int64_t ARENA_PROFILER_SAMPLE_BYTES;
+	int ARENA_PROFILER_LOGGED_SITES;
 
 	bool WRITE_TRACING_ENABLED;
 	int TRACING_UDP_LISTENER_PORT;
+	double TRACING_SAMPLE_RATE;
 
 	//run loop profiling
 	double RUN_LOOP_PROFILING_INTERVAL;
 	double SLOWTASK_PROFILING_LOG_INTERVAL;
 	double SLOWTASK_PROFILING_MAX_LOG_INTERVAL;
 	double SLOWTASK_PROFILING_LOG_BACKOFF;
+	bool ACTOR_PROFILER;
+	int ACTOR_PROFILER_TOP_ACTORS;
 	double SATURATION_PROFILING_LOG_INTERVAL;
 	double SATURATION_PROFILING_MAX_LOG_INTERVAL;
 	double SATURATION_PROFILING_LOG_BACKOFF;
@@ -87,6 +96,9 @@ public:
 	double CONNECTION_MONITOR_IDLE_TIMEOUT;
 	double CONNECTION_MONITOR_INCOMING_IDLE_MULTIPLIER;
 	double CONNECTION_MONITOR_UNREFERENCED_CLOSE_DELAY;
+	bool CONNECTION_MONITOR_SKIP_BUSY_PINGS;
+	int INDIRECT_PING_PROBES;
+	double INDIRECT_PING_TIMEOUT;
 
 	//FlowTransport
 	double CONNECTION_REJECTED_MESSAGE_DELAY;
@@ -113,6 +125,11 @@ public:
 	int TLS_HANDSHAKE_THREAD_STACKSIZE;
 	int TLS_MALLOC_ARENA_MAX;
 	int TLS_HANDSHAKE_LIMIT;
+	bool TLS_SESSION_RESUMPTION;
+	int TLS_SESSION_CACHE_SIZE;
+
+	double THREAD_POOL_SHORT_ACTION_ESTIMATE;
+	int THREAD_POOL_SHORT_ACTION_RUN;
 
 	int NETWORK_TEST_CLIENT_COUNT;
 	int NETWORK_TEST_REPLY_SIZE;
@@ -127,13 +144,19 @@ public:
 	int64_t SIM_PAGE_CACHE_64K;
 	int64_t BUGGIFY_SIM_PAGE_CACHE_4K;
 	int64_t BUGGIFY_SIM_PAGE_CACHE_64K;
-	std::string CACHE_EVICTION_POLICY; // for now, "random", "lru", are supported
+	std::string CACHE_EVICTION_POLICY; // for now, "random", "lru" and "slru" are supported
+	double CACHE_PROTECTED_FRACTION;
+	int CACHE_SCAN_DETECT_PAGES;
 	int MAX_EVICT_ATTEMPTS;
 	double PAGE_CACHE_TRUNCATE_LOOKUP_FRACTION;
 	double TOO_MANY_CONNECTIONS_CLOSED_RESET_DELAY;
 	int TOO_MANY_CONNECTIONS_CLOSED_TIMEOUT;
 	int PEER_UNAVAILABLE_FOR_LONG_TIME_TIMEOUT;
 
+	//AsyncFileReadAheadCache
+	int64_t READ_AHEAD_ADAPTIVE_MAX_BYTES;
+	double READ_AHEAD_RATE_FOLDING_TIME;
+
 	//AsyncFileEIO
 	int EIO_MAX_PARALLELISM;
 	int EIO_USE_ODIRECT;
@@ -141,10 +164,16 @@ public:
 	//AsyncFileKAIO
 	int MAX_OUTSTANDING;
 	int MIN_SUBMIT;
+	double KAIO_BACKGROUND_BYTES_PER_SECOND;
+	int KAIO_BACKGROUND_TASK_PRIORITY;
 
 	int PAGE_WRITE_CHECKSUM_HISTORY;
 	int DISABLE_POSIX_KERNEL_AIO;
 
+	//AsyncFileIOUring
+	bool USE_IO_URING;
+	int IO_URING_ENTRIES;
+
 	//AsyncFileNonDurable
 	double MAX_PRIOR_MODIFICATION_DELAY;
 
@@ -159,10 +188,18 @@ public:
 	//Net2
 	double MIN_COALESCE_DELAY;
 	double MAX_COALESCE_DELAY;
+	double MAX_ADAPTIVE_COALESCE_DELAY;
+	int ADAPTIVE_COALESCE_BYTES;
 	double SLOW_LOOP_CUTOFF;
 	double SLOW_LOOP_SAMPLING_RATE;
 	int64_t TSC_YIELD_TIME;
+	int64_t TSC_YIELD_TIME_BACKGROUND;
+	int TSC_YIELD_BACKGROUND_PRIORITY;
+	int YIELD_BUDGET_INTERVAL;
 	int64_t REACTOR_FLAGS;
+	int NET2_WORKER_REACTORS;
+	int NET2_THREAD_READY_BATCH_SIZE;
+	double NET2_TIMING_WHEEL_RESOLUTION;
 	double MIN_LOGGED_PRIORITY_BUSY_FRACTION;
 	int CERT_FILE_MAX_SIZE;
 
@@ -171,10 +208,14 @@ public:
 	int64_t PACKET_WARNING;  // 2MB packet warning quietly allows for 1MB system messages
 	double TIME_OFFSET_LOGGING_INTERVAL;
 	int MAX_PACKET_SEND_BYTES;
+	int BULK_PACKET_BYTES; // Unreliable packets at least this large are queued behind other packets to their peer; 0 disables
 	int MIN_PACKET_BUFFER_BYTES;
 	int MIN_PACKET_BUFFER_FREE_BYTES;
 	int FLOW_TCP_NODELAY;
 	int FLOW_TCP_QUICKACK;
+	int WIRE_COMPRESSION;
+	int WIRE_COMPRESSION_MIN_BYTES;
+	int WIRE_COMPRESSION_LEVEL;
 
 	//Sim2
 	//FIMXE: more parameters could be factored out
@@ -244,6 +285,11 @@ public:
 	int BASIC_LOAD_BALANCE_COMPUTE_PRECISION;
 	double BASIC_LOAD_BALANCE_MIN_REQUESTS;
 	double BASIC_LOAD_BALANCE_MIN_CPU;
+	bool LOAD_BALANCE_LATENCY_AWARE;
+	double LOAD_BALANCE_LATENCY_SMOOTHING;
+	double LOAD_BALANCE_IN_FLIGHT_PENALTY;
+	double LOAD_BALANCE_HEDGE_PERCENTILE;
+	double LOAD_BALANCE_HEDGE_BUDGET;
 
 	// Health Monitor
 	int FAILURE_DETECTION_DELAY;
@@ -25,6 +25,7 @@
 #include "flow/Trace.h"
 #include <algorithm>
 #include <memory>
+#include <mutex>
 #define BOOST_SYSTEM_NO_LIB
 #define BOOST_DATE_TIME_NO_LIB
 #define BOOST_REGEX_NO_LIB
@@ -43,6 +44,8 @@
 #include "flow/AsioReactor.h"
 #include "flow/Profiler.h"
 #include "flow/ProtocolVersion.h"
+#include "flow/ReadyQueue.h"
+#include "flow/TimingWheel.h"
 #include "flow/TLSConfig.actor.h"
 #include "flow/genericactors.actor.h"
 #include "flow/Util.h"
@@ -109,6 +112,8 @@ Net2 *g_net2 = nullptr;
 class Task {
 public:
 	virtual void operator()() = 0;
+	// True if running the task would have no effect, so a timer for it can be dropped instead of queued to run
+	virtual bool isCancelled() const { return false; }
 };
 
 struct OrderedTask {
@@ -121,6 +126,60 @@ struct OrderedTask {
 
 thread_local INetwork* thread_network = 0;
 
+// A unit of thread safe, CPU-bound work (serialization, checksumming, compression, ...) handed to a worker reactor
+// by Net2::runOnWorkerReactor().  The work function must not touch any flow state other than what it captures.
+struct WorkerTask {
+	std::function<void()> fn;
+	TaskPriority taskID;
+	Promise<Void> done;  // Created on the network thread and only moved (never copied) by the worker reactor
+	WorkerTask(std::function<void()>&& fn, TaskPriority taskID) : fn(std::move(fn)), taskID(taskID) {}
+};
+
+// A set of NET2_WORKER_REACTORS threads, each with its own queue of WorkerTasks.  Tasks are distributed round robin
+// and an idle reactor steals from the back of its siblings' queues, so one long task cannot strand the work queued
+// behind it.  Completions are delivered back to the network thread with onMainThread().
+class WorkerReactors : NonCopyable {
+public:
+	explicit WorkerReactors(Net2* net) : net(net), nextQueue(0), stopping(false) {}
+	~WorkerReactors() { stop(); }
+
+	void start(int count);
+	void stop();
+	void post(WorkerTask* task);
+
+	bool isRunning() const { return !threads.empty(); }
+
+	std::atomic<int64_t> tasksRun{ 0 };
+	std::atomic<int64_t> tasksStolen{ 0 };
+
+private:
+	struct alignas(MAX_CACHE_LINE_SIZE) Queue {
+		ThreadSpinLock lock;
+		Deque<WorkerTask*> tasks;
+	};
+	struct ThreadArg {
+		WorkerReactors* self;
+		int index;
+	};
+
+	THREAD_FUNC workerThread(void* arg) {
+		ThreadArg* a = (ThreadArg*)arg;
+		a->self->workerLoop(a->index);
+		delete a;
+		THREAD_RETURN;
+	}
+	void workerLoop(int index);
+	WorkerTask* popOrSteal(int index);
+	void finish(WorkerTask* task, Optional<Error> const& error);
+
+	Net2* net;
+	std::vector<std::unique_ptr<Queue>> queues;
+	std::vector<THREAD_HANDLE> threads;
+	Event pending; // Posted once per queued task, and once per thread when stopping
+	int nextQueue; // Only accessed from the network thread
+	std::atomic<bool> stopping;
+};
+
 class Net2 final : public INetwork, public INetworkConnections {
 
 public:
@@ -146,6 +205,7 @@ public:
 	TaskPriority getCurrentTask() const override { return currentTaskID; }
 	void setCurrentTask(TaskPriority taskID ) override { currentTaskID = taskID; priorityMetric = (int64_t)taskID; }
 	void onMainThread( Promise<Void>&& signal, TaskPriority taskID ) override;
+	Future<Void> runOnWorkerReactor( std::function<void()> fn, TaskPriority taskID ) override;
 	bool isOnMainThread() const override {
 		return thread_network == this;
 	}
@@ -198,6 +258,7 @@ public:
 	INetworkConnections *network;  // initially this, but can be changed
 
 	int64_t tscBegin, tscEnd;
+	int64_t tscBackgroundEnd; // Tasks below TSC_YIELD_BACKGROUND_PRIORITY yield once the time slice passes this
 	double taskBegin;
 	TaskPriority currentTaskID;
 	uint64_t tasksIssued;
@@ -212,8 +273,9 @@ public:
 
 	NetworkMetrics::PriorityStats* lastPriorityStats;
 
-	std::priority_queue<OrderedTask, std::vector<OrderedTask>> ready;
+	BucketedReadyQueue<OrderedTask> ready;
 	ThreadSafeQueue<OrderedTask> threadReady;
+	WorkerReactors workerReactors;
 
 	struct DelayedTask : OrderedTask {
 		double at;
@@ -221,13 +283,21 @@ public:
 		bool operator < (DelayedTask const& rhs) const { return at > rhs.at; } // Ordering is reversed for priority_queue
 	};
 	std::priority_queue<DelayedTask, std::vector<DelayedTask>> timers;
+	// Used instead of timers if NET2_TIMING_WHEEL_RESOLUTION > 0
+	bool useTimingWheel;
+	TimingWheel<DelayedTask> timerWheel;
+	bool hasTimers() const { return useTimingWheel ? !timerWheel.empty() : !timers.empty(); }
+	double nextTimerDeadline() const { return useTimingWheel ? timerWheel.nextDeadline() : timers.top().at; }
+	int readyTimers(double now);
 
 	void checkForSlowTask(int64_t tscBegin, int64_t tscEnd, double duration, TaskPriority priority);
 	bool check_yield(TaskPriority taskId, int64_t tscNow);
+	bool backgroundSliceSpent(TaskPriority taskID, int64_t tscNow) const;
 	void processThreadReady();
+	void queueThreadReady(OrderedTask t);
 	void trackAtPriority( TaskPriority priority, double now );
 	void stopImmediately() {
-		stopped=true; decltype(ready) _1; ready.swap(_1); decltype(timers) _2; timers.swap(_2);
+		stopped=true; ready.clear(); decltype(timers) _2; timers.swap(_2); timerWheel.clear();
 	}
 
 	Future<Void> timeOffsetLogger;
@@ -244,6 +314,8 @@ public:
 	Int64MetricHandle countUDPWrites;
 	Int64MetricHandle countRunLoop;
 	Int64MetricHandle countCantSleep;
+	Int64MetricHandle countThreadReadyWakes;
+	std::atomic<int64_t> threadReadyWakes{ 0 }; // Counted by the threads that woke the network thread
 	Int64MetricHandle countWontSleep;
 	Int64MetricHandle countTimers;
 	Int64MetricHandle countTasks;
@@ -251,12 +323,19 @@ public:
 	Int64MetricHandle countYieldBigStack;
 	Int64MetricHandle countYieldCalls;
 	Int64MetricHandle countYieldCallsTrue;
+	Int64MetricHandle countBackgroundYields;
 	Int64MetricHandle countASIOEvents;
 	Int64MetricHandle countRunLoopProfilingSignals;
 	Int64MetricHandle countTLSPolicyFailures;
+	Int64MetricHandle countTLSHandshakes;
+	Int64MetricHandle countTLSHandshakesResumed;
+	Int64MetricHandle countTLSHandshakeFailures;
+	Int64MetricHandle countTLSHandshakesThrottled;
 	Int64MetricHandle priorityMetric;
 	DoubleMetricHandle countLaunchTime;
 	DoubleMetricHandle countReactTime;
+	DoubleMetricHandle countSpinTime;
+	DoubleMetricHandle countSleepTime;
 	BoolMetricHandle awakeMetric;
 
 	EventMetricHandle<SlowTask> slowTaskMetric;
@@ -781,6 +860,92 @@ struct SSLHandshakerThread final : IThreadPoolReceiver {
 	}
 };
 
+// The sessions of earlier client connections by peer address. A connection to a peer offers the last session it got
+// from it, so that reconnects, such as every client of a cluster coming back after a recovery, resume the session rather
+// than run a full handshake. Sessions arrive through OpenSSL's new session callback, which runs on a handshaker thread
+// or, for TLS 1.3 tickets, on the network thread when a read gets to the ticket.
+class TLSSessionCache {
+public:
+	static TLSSessionCache& get() {
+		static TLSSessionCache cache;
+		return cache;
+	}
+
+	// Enables resumption on a context: sessions of client connections are handed to this cache, and a server asking
+	// for a peer certificate needs a session id context before it will resume any session
+	void configure(boost::asio::ssl::context* context) {
+		if (!FLOW_KNOBS->TLS_SESSION_RESUMPTION) {
+			return;
+		}
+		SSL_CTX* ctx = context->native_handle();
+		static const unsigned char sessionIdContext[] = "fdb";
+		SSL_CTX_set_session_id_context(ctx, sessionIdContext, sizeof(sessionIdContext) - 1);
+		SSL_CTX_set_session_cache_mode(ctx, SSL_SESS_CACHE_BOTH | SSL_SESS_CACHE_NO_INTERNAL_STORE);
+		SSL_CTX_sess_set_new_cb(ctx, &TLSSessionCache::onNewSession);
+	}
+
+	// Offers the cached session of peer, if any, on a client connection that is about to handshake. peer must outlive
+	// ssl, since new sessions for the connection are filed under it.
+	void offer(SSL* ssl, NetworkAddress const* peer) {
+		if (!FLOW_KNOBS->TLS_SESSION_RESUMPTION) {
+			return;
+		}
+		SSL_set_ex_data(ssl, peerIndex(), const_cast<NetworkAddress*>(peer));
+		std::lock_guard<std::mutex> lock(mutex);
+		auto it = sessions.find(*peer);
+		if (it == sessions.end()) {
+			return;
+		}
+		// A session from before a certificate refresh was verified against the old configuration
+		if (it->second.first != SSL_get_SSL_CTX(ssl) || !SSL_SESSION_is_resumable(it->second.second)) {
+			SSL_SESSION_free(it->second.second);
+			sessions.erase(it);
+			return;
+		}
+		SSL_set_session(ssl, it->second.second);
+	}
+
+	void erase(NetworkAddress const& peer) {
+		std::lock_guard<std::mutex> lock(mutex);
+		auto it = sessions.find(peer);
+		if (it != sessions.end()) {
+			SSL_SESSION_free(it->second.second);
+			sessions.erase(it);
+		}
+	}
+
+private:
+	std::mutex mutex;
+	std::map<NetworkAddress, std::pair<SSL_CTX*, SSL_SESSION*>> sessions;
+
+	static int peerIndex() {
+		static int index = SSL_get_ex_new_index(0, nullptr, nullptr, nullptr, nullptr);
+		return index;
+	}
+
+	// Takes ownership of session, returning 1, if it belongs to a client connection that offer() saw
+	static int onNewSession(SSL* ssl, SSL_SESSION* session) {
+		auto peer = static_cast<NetworkAddress*>(SSL_get_ex_data(ssl, peerIndex()));
+		if (!peer || SSL_is_server(ssl) || FLOW_KNOBS->TLS_SESSION_CACHE_SIZE <= 0) {
+			return 0;
+		}
+		TLSSessionCache& cache = get();
+		std::lock_guard<std::mutex> lock(cache.mutex);
+		auto it = cache.sessions.find(*peer);
+		if (it != cache.sessions.end()) {
+			SSL_SESSION_free(it->second.second);
+			it->second = std::make_pair(SSL_get_SSL_CTX(ssl), session);
+			return 1;
+		}
+		if (cache.sessions.size() >= FLOW_KNOBS->TLS_SESSION_CACHE_SIZE) {
+			SSL_SESSION_free(cache.sessions.begin()->second.second);
+			cache.sessions.erase(cache.sessions.begin());
+		}
+		cache.sessions[*peer] = std::make_pair(SSL_get_SSL_CTX(ssl), session);
+		return 1;
+	}
+};
+
 class SSLConnection final : public IConnection, ReferenceCounted<SSLConnection> {
 public:
 	void addref() override { ReferenceCounted<SSLConnection>::addref(); }
@@ -803,6 +968,7 @@ public:
 			if (now() < iter->second.second) {
 				if(iter->second.first >= FLOW_KNOBS->TLS_CLIENT_CONNECTION_THROTTLE_ATTEMPTS) {
 					TraceEvent("TLSOutgoingConnectionThrottlingWarning").suppressFor(1.0).detail("PeerIP", addr);
+					++g_net2->countTLSHandshakesThrottled;
 					wait(delay(FLOW_KNOBS->CONNECTION_MONITOR_TIMEOUT));
 					throw connection_failed();
 				}
@@ -856,9 +1022,11 @@ public:
 				self->ssl_sock.async_handshake( boost::asio::ssl::stream_base::server, std::move(p) );
 			}
 			wait( onHandshook );
+			self->countHandshake();
 			wait(delay(0, TaskPriority::Handshake));
 			connected.send(Void());
 		} catch (...) {
+			++g_net2->countTLSHandshakeFailures;
 			self->closeSocket();
 			connected.sendError(connection_failed());
 		}
@@ -872,6 +1040,7 @@ public:
 			if (now() < iter->second.second) {
 				if(iter->second.first >= FLOW_KNOBS->TLS_SERVER_CONNECTION_THROTTLE_ATTEMPTS) {
 					TraceEvent("TLSIncomingConnectionThrottlingWarning").suppressFor(1.0).detail("PeerIP", peerIP.first.toString());
+					++g_net2->countTLSHandshakesThrottled;
 					wait(delay(FLOW_KNOBS->CONNECTION_MONITOR_TIMEOUT));
 					self->closeSocket();
 					throw connection_failed();
@@ -919,6 +1088,7 @@ public:
 
 		try {
 			Future<Void> onHandshook;
+			TLSSessionCache::get().offer(self->ssl_sock.native_handle(), &self->peer_address);
 			// If the background handshakers are not all busy, use one
 			if(N2::g_net2->sslPoolHandshakesInProgress < N2::g_net2->sslHandshakerThreadsStarted) {
 				holder = Hold(&N2::g_net2->sslPoolHandshakesInProgress);
@@ -933,9 +1103,13 @@ public:
 				self->ssl_sock.async_handshake( boost::asio::ssl::stream_base::client, std::move(p) );
 			}
 			wait( onHandshook );
+			self->countHandshake();
 			wait(delay(0, TaskPriority::Handshake));
 			connected.send(Void());
 		} catch (...) {
+			++g_net2->countTLSHandshakeFailures;
+			// The cached session may be what the peer rejected
+			TLSSessionCache::get().erase(self->peer_address);
 			self->closeSocket();
 			connected.sendError(connection_failed());
 		}
@@ -1057,6 +1231,13 @@ public:
 
 	ssl_socket& getSSLSocket() { return ssl_sock; }
 private:
+	void countHandshake() {
+		++g_net2->countTLSHandshakes;
+		if (SSL_session_reused(ssl_sock.native_handle())) {
+			++g_net2->countTLSHandshakesResumed;
+		}
+	}
+
 	UID id;
 	tcp::socket socket;
 	ssl_socket ssl_sock;
@@ -1143,6 +1324,27 @@ struct PromiseTask : public Task, public FastAllocated<PromiseTask> {
 		promise.send(Void());
 		delete this;
 	}
+
+	bool isCancelled() const override { return !promise.isSet() && promise.getFutureReferenceCount() == 0; }
+};
+
+// A run of tasks at the same priority handed to the network thread by other threads (e.g. by the API calls of a client
+// application), run one after another as a single task of the run loop so that they share its per-task overhead
+struct ThreadReadyBatch : public Task, public FastAllocated<ThreadReadyBatch> {
+	std::vector<Task*> tasks;
+
+	virtual void operator()() {
+		for (Task* task : tasks) {
+			try {
+				(*task)();
+			} catch (Error& e) {
+				TraceEvent(SevError, "TaskError").error(e);
+			} catch (...) {
+				TraceEvent(SevError, "TaskError").error(unknown_error());
+			}
+		}
+		delete this;
+	}
 };
 
 // 5MB for loading files into memory
@@ -1154,12 +1356,15 @@ Net2::Net2(const TLSConfig& tlsConfig, bool useThreadPool, bool useMetrics)
 	  stopped(false),
 	  tasksIssued(0),
 	  // Until run() is called, yield() will always yield
-	  tscBegin(0), tscEnd(0), taskBegin(0), currentTaskID(TaskPriority::DefaultYield),
+	  tscBegin(0), tscEnd(0), tscBackgroundEnd(0), taskBegin(0), currentTaskID(TaskPriority::DefaultYield),
 	  numYields(0),
 	  lastPriorityStats(nullptr),
 	  tlsInitializedState(ETLSInitState::NONE),
 	  tlsConfig(tlsConfig),
-	  started(false)
+	  started(false),
+	  useTimingWheel(FLOW_KNOBS->NET2_TIMING_WHEEL_RESOLUTION > 0),
+	  timerWheel(useTimingWheel ? FLOW_KNOBS->NET2_TIMING_WHEEL_RESOLUTION : 1.0, ::timer_monotonic()),
+	  workerReactors(this)
 #ifndef TLS_DISABLED
 	  ,sslContextVar({ReferencedObject<boost::asio::ssl::context>::from(boost::asio::ssl::context(boost::asio::ssl::context::tls))}),
 	  sslPoolHandshakesInProgress(0), sslHandshakerThreadsStarted(0)
@@ -1244,6 +1449,7 @@ ACTOR static Future<Void> reloadCertificatesOnChange( TLSConfig config, std::fun
 			LoadedTLSConfig loaded = wait( config.loadAsync() );
 			boost::asio::ssl::context context(boost::asio::ssl::context::tls);
 			ConfigureSSLContext(loaded, &context, onPolicyFailure);
+			TLSSessionCache::get().configure(&context);
 			TraceEvent(SevInfo, "TLSCertificateRefreshSucceeded");
 			mismatches = 0;
 			contextVar->set(ReferencedObject<boost::asio::ssl::context>::from(std::move(context)));
@@ -1278,6 +1484,7 @@ void Net2::initTLS(ETLSInitState targetState) {
 				.detail("HasPassword", !loaded.getPassword().empty())
 				.detail("VerifyPeers", boost::algorithm::join(loaded.getVerifyPeers(), "|"));
 			ConfigureSSLContext( tlsConfig.loadSync(), &newContext, onPolicyFailure );
+			TLSSessionCache::get().configure(&newContext);
 			sslContextVar.set(ReferencedObject<boost::asio::ssl::context>::from(std::move(newContext)));
 		} catch (Error& e) {
 			TraceEvent("Net2TLSInitError").error(e);
@@ -1339,6 +1546,7 @@ void Net2::initMetrics() {
 	countWrites.init(LiteralStringRef("Net2.CountWrites"));
 	countRunLoop.init(LiteralStringRef("Net2.CountRunLoop"));
 	countCantSleep.init(LiteralStringRef("Net2.CountCantSleep"));
+	countThreadReadyWakes.init(LiteralStringRef("Net2.CountThreadReadyWakes"));
 	countWontSleep.init(LiteralStringRef("Net2.CountWontSleep"));
 	countTimers.init(LiteralStringRef("Net2.CountTimers"));
 	countTasks.init(LiteralStringRef("Net2.CountTasks"));
@@ -1347,13 +1555,20 @@ void Net2::initMetrics() {
 	countYieldCalls.init(LiteralStringRef("Net2.CountYieldCalls"));
 	countASIOEvents.init(LiteralStringRef("Net2.CountASIOEvents"));
 	countYieldCallsTrue.init(LiteralStringRef("Net2.CountYieldCallsTrue"));
+	countBackgroundYields.init(LiteralStringRef("Net2.CountBackgroundYields"));
 	countRunLoopProfilingSignals.init(LiteralStringRef("Net2.CountRunLoopProfilingSignals"));
 	countTLSPolicyFailures.init(LiteralStringRef("Net2.CountTLSPolicyFailures"));
+	countTLSHandshakes.init(LiteralStringRef("Net2.CountTLSHandshakes"));
+	countTLSHandshakesResumed.init(LiteralStringRef("Net2.CountTLSHandshakesResumed"));
+	countTLSHandshakeFailures.init(LiteralStringRef("Net2.CountTLSHandshakeFailures"));
+	countTLSHandshakesThrottled.init(LiteralStringRef("Net2.CountTLSHandshakesThrottled"));
 	priorityMetric.init(LiteralStringRef("Net2.Priority"));
 	awakeMetric.init(LiteralStringRef("Net2.Awake"));
 	slowTaskMetric.init(LiteralStringRef("Net2.SlowTask"));
 	countLaunchTime.init(LiteralStringRef("Net2.CountLaunchTime"));
 	countReactTime.init(LiteralStringRef("Net2.CountReactTime"));
+	countSpinTime.init(LiteralStringRef("Net2.CountSpinTime"));
+	countSleepTime.init(LiteralStringRef("Net2.CountSleepTime"));
 }
 
 bool Net2::checkRunnable() {
@@ -1372,6 +1587,7 @@ void Net2::run() {
 #endif
 
 	timeOffsetLogger = logTimeOffset();
+	ActorProfiler::enabled = FLOW_KNOBS->ACTOR_PROFILER;
 	const char *flow_profiler_enabled = getenv("FLOW_PROFILER_ENABLED");
 	if (flow_profiler_enabled != nullptr && *flow_profiler_enabled != '\0') {
 		// The empty string check is to allow running `FLOW_PROFILER_ENABLED= ./fdbserver` to force disabling flow profiling at startup.
@@ -1382,6 +1598,10 @@ void Net2::run() {
 	typedef void (*runCycleFuncPtr)();
 	runCycleFuncPtr runFunc = reinterpret_cast<runCycleFuncPtr>(reinterpret_cast<flowGlobalType>(g_network->global(INetwork::enRunCycleFunc)));
 
+	if (FLOW_KNOBS->NET2_WORKER_REACTORS > 0) {
+		workerReactors.start(FLOW_KNOBS->NET2_WORKER_REACTORS);
+	}
+
 	started.store(true);
 	double nnow = timer_monotonic();
 
@@ -1393,6 +1613,7 @@ void Net2::run() {
 			tscBegin = timestampCounter();
 			taskBegin = nnow;
 			trackAtPriority(TaskPriority::RunCycleFunction, taskBegin);
+			ActorProfiler::beginTask();
 			runFunc();
 			double taskEnd = timer_monotonic();
 			trackAtPriority(TaskPriority::RunLoop, taskEnd);
@@ -1410,8 +1631,8 @@ void Net2::run() {
 		if (b) {
 			sleepTime = 1e99;
 			double sleepStart = timer_monotonic();
-			if (!timers.empty()) {
-				sleepTime = timers.top().at - sleepStart;  // + 500e-6?
+			if (hasTimers()) {
+				sleepTime = nextTimerDeadline() - sleepStart;  // + 500e-6?
 			}
 			if (sleepTime > 0) {
 #if defined(__linux__)
@@ -1422,14 +1643,28 @@ void Net2::run() {
 				trackAtPriority(TaskPriority::Zero, sleepStart);
 				awakeMetric = false;
 				priorityMetric = 0;
-				reactor.sleep(sleepTime);
+				// With busy polling on, spin on a non-blocking poll of the reactor for a while first, so that a
+				// packet arriving soon is handled without the latency of waking from a blocking wait
+				double spinEnd = sleepStart;
+				bool woken = false;
+				if (FLOW_KNOBS->NETWORK_BUSY_POLL_TIME > 0) {
+					woken = reactor.spin(sleepStart + std::min(sleepTime, FLOW_KNOBS->NETWORK_BUSY_POLL_TIME));
+					spinEnd = timer_monotonic();
+					countSpinTime += spinEnd - sleepStart;
+				}
+				if (!woken) {
+					reactor.sleep(sleepTime - (spinEnd - sleepStart));
+					countSleepTime += timer_monotonic() - spinEnd;
+				}
 				awakeMetric = true;
+				countThreadReadyWakes = threadReadyWakes.load(std::memory_order_relaxed);
 			}
 		}
 
 		tscBegin = timestampCounter();
 		taskBegin = timer_monotonic();
 		trackAtPriority(TaskPriority::ASIOReactor, taskBegin);
+		ActorProfiler::beginTask();
 		reactor.react();
 		
 		updateNow();
@@ -1442,13 +1677,7 @@ void Net2::run() {
 		if ((now-nnow) > FLOW_KNOBS->SLOW_LOOP_CUTOFF && nondeterministicRandom()->random01() < (now-nnow)*FLOW_KNOBS->SLOW_LOOP_SAMPLING_RATE)
 			TraceEvent("SomewhatSlowRunLoopTop").detail("Elapsed", now - nnow);
 
-		int numTimers = 0;
-		while (!timers.empty() && timers.top().at < now) {
-			++numTimers;
-			++countTimers;
-			ready.push( timers.top() );
-			timers.pop();
-		}
+		int numTimers = readyTimers(now);
 		countTimers += numTimers;
 		FDB_TRACE_PROBE(run_loop_ready_timers, numTimers);
 
@@ -1456,6 +1685,9 @@ void Net2::run() {
 
 		tscBegin = timestampCounter();
 		tscEnd = tscBegin + FLOW_KNOBS->TSC_YIELD_TIME;
+		tscBackgroundEnd = FLOW_KNOBS->TSC_YIELD_TIME_BACKGROUND > 0
+		                       ? std::min(tscEnd, tscBegin + FLOW_KNOBS->TSC_YIELD_TIME_BACKGROUND)
+		                       : tscEnd;
 		taskBegin = timer_monotonic();
 		numYields = 0;
 		TaskPriority minTaskID = TaskPriority::Max;
@@ -1473,6 +1705,7 @@ void Net2::run() {
 			Task* task = ready.top().task;
 			ready.pop();
 
+			ActorProfiler::beginTask();
 			try {
 				(*task)();
 			} catch (Error& e) {
@@ -1483,7 +1716,8 @@ void Net2::run() {
 
 			double tscNow = timestampCounter();
 			double newTaskBegin = timer_monotonic();
-			if (check_yield(TaskPriority::Max, tscNow)) {
+			if (check_yield(TaskPriority::Max, tscNow) ||
+			    (!ready.empty() && backgroundSliceSpent(ready.topPriority(), tscNow))) {
 				checkForSlowTask(tscBegin, tscNow, newTaskBegin - taskBegin, currentTaskID);
 				FDB_TRACE_PROBE(run_loop_yield);
 				++countYields;
@@ -1547,6 +1781,8 @@ void Net2::run() {
 			TraceEvent("SomewhatSlowRunLoopBottom").detail("Elapsed", nnow - now); // This includes the time spent running tasks
 	}
 
+	workerReactors.stop();
+
 	for ( auto& fn : stopCallbacks ) {
 		fn();
 	}
@@ -1595,19 +1831,74 @@ void Net2::trackAtPriority( TaskPriority priority, double now ) {
 	}
 }
 
+// Moves timers that are due by now to the ready queue, and returns how many there were.  Timers whose futures have all
+// been dropped are run (which only frees them) rather than queued.
+int Net2::readyTimers( double now ) {
+	int numTimers = 0;
+	auto fire = [&](DelayedTask const& t) {
+		++numTimers;
+		if (t.task->isCancelled())
+			(*t.task)();
+		else
+			ready.push( t );
+	};
+	if (useTimingWheel) {
+		timerWheel.advance(now);
+		while (timerWheel.hasDue() && timerWheel.top().at < now) {
+			DelayedTask t = timerWheel.top();
+			timerWheel.pop();
+			fire(t);
+		}
+	} else {
+		while (!timers.empty() && timers.top().at < now) {
+			DelayedTask t = timers.top();
+			timers.pop();
+			fire(t);
+		}
+	}
+	return numTimers;
+}
+
 void Net2::processThreadReady() {
 	int numReady = 0;
+	// The last task popped, not yet queued in case the next one can be batched with it
+	Optional<OrderedTask> last;
+	ThreadReadyBatch* batch = nullptr;
 	while (true) {
 		Optional<OrderedTask> t = threadReady.pop();
 		if (!t.present()) break;
-		t.get().priority -= ++tasksIssued;
 		ASSERT( t.get().task != 0 );
-		ready.push( t.get() );
 		++numReady;
+
+		// Tasks issued one after another at the same priority would run one after another anyway
+		if (last.present() && last.get().taskID == t.get().taskID && FLOW_KNOBS->NET2_THREAD_READY_BATCH_SIZE > 1) {
+			if (!batch) {
+				batch = new ThreadReadyBatch;
+				batch->tasks.push_back(last.get().task);
+				last.get().task = batch;
+			}
+			batch->tasks.push_back(t.get().task);
+			if (batch->tasks.size() >= FLOW_KNOBS->NET2_THREAD_READY_BATCH_SIZE) {
+				queueThreadReady(last.get());
+				last.reset();
+				batch = nullptr;
+			}
+			continue;
+		}
+
+		if (last.present()) queueThreadReady(last.get());
+		last = t;
+		batch = nullptr;
 	}
+	if (last.present()) queueThreadReady(last.get());
 	FDB_TRACE_PROBE(run_loop_thread_ready, numReady);
 }
 
+void Net2::queueThreadReady(OrderedTask t) {
+	t.priority -= ++tasksIssued;
+	ready.push(t);
+}
+
 void Net2::checkForSlowTask(int64_t tscBegin, int64_t tscEnd, double duration, TaskPriority priority) {
 	int64_t elapsed = tscEnd-tscBegin;
 	if (elapsed > FLOW_KNOBS->TSC_YIELD_TIME && tscBegin > 0) {
@@ -1629,8 +1920,13 @@ void Net2::checkForSlowTask(int64_t tscBegin, int64_t tscEnd, double duration, T
 			sampleRate = 1; // Always include slow task events that could show up in our slow task profiling.
 		}
 
-		if ( !DEBUG_DETERMINISM && (nondeterministicRandom()->random01() < sampleRate ))
-			TraceEvent(elapsed > warnThreshold ? SevWarnAlways : SevInfo, "SlowTask").detail("TaskID", priority).detail("MClocks", elapsed/1e6).detail("Duration", duration).detail("SampleRate", sampleRate).detail("NumYields", numYields);
+		if ( !DEBUG_DETERMINISM && (nondeterministicRandom()->random01() < sampleRate )) {
+			TraceEvent e(elapsed > warnThreshold ? SevWarnAlways : SevInfo, "SlowTask");
+			e.detail("TaskID", priority).detail("MClocks", elapsed/1e6).detail("Duration", duration).detail("SampleRate", sampleRate).detail("NumYields", numYields);
+			if (ActorProfiler::slowestActor()) {
+				e.detail("Actor", ActorProfiler::slowestActor());
+			}
+		}
 	}
 }
 
@@ -1644,7 +1940,7 @@ bool Net2::check_yield( TaskPriority taskID, int64_t tscNow ) {
 	processThreadReady();
 
 	if (taskID == TaskPriority::DefaultYield) taskID = currentTaskID;
-	if (!ready.empty() && ready.top().priority > int64_t(taskID)<<32)  {
+	if (ready.topPriority() > taskID) {
 		return true;
 	}
 
@@ -1657,9 +1953,22 @@ bool Net2::check_yield( TaskPriority taskID, int64_t tscNow ) {
 		return true;
 	}
 
+	// Unlike the end of the whole slice, this doesn't make every later check_yield() true, because higher priority
+	// tasks still have time left in it
+	if (backgroundSliceSpent(taskID, tscNow)) {
+		++countBackgroundYields;
+		return true;
+	}
+
 	return false;
 }
 
+// Background work gets a shorter share of each run loop slice, so that the loop gets back to the reactor and timers
+// sooner when only throughput bound tasks are running, while latency sensitive ones keep the full TSC_YIELD_TIME
+bool Net2::backgroundSliceSpent(TaskPriority taskID, int64_t tscNow) const {
+	return tscNow > tscBackgroundEnd && static_cast<int>(taskID) < FLOW_KNOBS->TSC_YIELD_BACKGROUND_PRIORITY;
+}
+
 bool Net2::check_yield( TaskPriority taskID ) {
 	if(numYields > 0) {
 		++numYields;
@@ -1691,7 +2000,11 @@ Future<Void> Net2::delay( double seconds, TaskPriority taskId ) {
 
 	double at = now() + seconds;
 	PromiseTask* t = new PromiseTask;
-	this->timers.push( DelayedTask( at, (int64_t(taskId)<<32)-(++tasksIssued), taskId, t ) );
+	DelayedTask timer( at, (int64_t(taskId)<<32)-(++tasksIssued), taskId, t );
+	if (useTimingWheel)
+		this->timerWheel.push( timer );
+	else
+		this->timers.push( timer );
 	return t->promise.getFuture();
 }
 
@@ -1705,11 +2018,123 @@ void Net2::onMainThread(Promise<Void>&& signal, TaskPriority taskID) {
 		processThreadReady();
 		this->ready.push( OrderedTask( priority-(++tasksIssued), taskID, p ) );
 	} else {
-		if (threadReady.push( OrderedTask( priority, taskID, p ) ))
+		if (threadReady.push( OrderedTask( priority, taskID, p ) )) {
+			threadReadyWakes.fetch_add(1, std::memory_order_relaxed);
 			reactor.wake();
+		}
+	}
+}
+
+Future<Void> Net2::runOnWorkerReactor( std::function<void()> fn, TaskPriority taskID ) {
+	if (!workerReactors.isRunning() || !isOnMainThread()) {
+		return INetwork::runOnWorkerReactor(std::move(fn), taskID);
+	}
+	WorkerTask* task = new WorkerTask(std::move(fn), taskID);
+	Future<Void> result = task->done.getFuture();
+	workerReactors.post(task);
+	return result;
+}
+
+void WorkerReactors::start(int count) {
+	ASSERT(threads.empty());
+	for (int i = 0; i < count; i++) {
+		queues.emplace_back(new Queue);
+	}
+	for (int i = 0; i < count; i++) {
+		threads.push_back(::startThread(workerThread, new ThreadArg{ this, i }));
+	}
+	TraceEvent("Net2WorkerReactorsStarted").detail("Count", count);
+}
+
+void WorkerReactors::stop() {
+	if (threads.empty()) return;
+	stopping.store(true);
+	for (int i = 0; i < threads.size(); i++) {
+		pending.set();
+	}
+	for (auto& t : threads) {
+		waitThread(t);
+	}
+	threads.clear();
+
+	// Anything still queued is abandoned; deleting it breaks the promises of whoever was waiting on it
+	for (auto& q : queues) {
+		while (!q->tasks.empty()) {
+			delete q->tasks.front();
+			q->tasks.pop_front();
+		}
+	}
+	TraceEvent("Net2WorkerReactorsStopped").detail("TasksRun", tasksRun.load()).detail("TasksStolen", tasksStolen.load());
+}
+
+void WorkerReactors::post(WorkerTask* task) {
+	Queue& q = *queues[nextQueue];
+	if (++nextQueue == queues.size()) nextQueue = 0;
+	{
+		ThreadSpinLockHolder holder(q.lock);
+		q.tasks.push_back(task);
+	}
+	pending.set();
+}
+
+WorkerTask* WorkerReactors::popOrSteal(int index) {
+	// Take from the front of our own queue first to preserve submission order where possible
+	{
+		Queue& q = *queues[index];
+		ThreadSpinLockHolder holder(q.lock);
+		if (!q.tasks.empty()) {
+			WorkerTask* t = q.tasks.front();
+			q.tasks.pop_front();
+			return t;
+		}
+	}
+	for (int i = 1; i < queues.size(); i++) {
+		Queue& q = *queues[(index + i) % queues.size()];
+		ThreadSpinLockHolder holder(q.lock);
+		if (!q.tasks.empty()) {
+			WorkerTask* t = q.tasks.back();
+			q.tasks.pop_back();
+			++tasksStolen;
+			return t;
+		}
+	}
+	return nullptr;
+}
+
+void WorkerReactors::workerLoop(int index) {
+	deprioritizeThread();
+	loop {
+		pending.block();
+		if (stopping.load()) break;
+
+		// There is exactly one pending.set() per queued task, so some queue must be non-empty
+		WorkerTask* task = popOrSteal(index);
+		ASSERT(task != nullptr);
+
+		Optional<Error> error;
+		try {
+			task->fn();
+		} catch (Error& e) {
+			error = e;
+		} catch (...) {
+			error = unknown_error();
+		}
+		++tasksRun;
+		finish(task, error);
 	}
 }
 
+void WorkerReactors::finish(WorkerTask* task, Optional<Error> const& error) {
+	if (error.present()) {
+		Promise<Void> signal;
+		tagAndForwardError(&task->done, error.get(), signal.getFuture());
+		net->onMainThread(std::move(signal), task->taskID);
+	} else {
+		net->onMainThread(std::move(task->done), task->taskID);
+	}
+	delete task;
+}
+
 THREAD_HANDLE Net2::startThread( THREAD_FUNC_RETURN (*func) (void*), void *arg ) {
 	return ::startThread(func, arg);
 }
@@ -1896,6 +2321,16 @@ void ASIOReactor::sleep(double sleepTime) {
 	}
 }
 
+bool ASIOReactor::spin(double until) {
+	do {
+		if (ios.poll_one()) {
+			++network->countASIOEvents;
+			return true;
+		}
+	} while (timer_monotonic() < until);
+	return false;
+}
+
 void ASIOReactor::react() {
 	while (ios.poll_one()) ++network->countASIOEvents;  // Make this a task?
 }
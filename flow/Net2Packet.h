@@ -67,6 +67,16 @@ public:
 	// Prepend the given range of packetBuffers to the beginning of the unsent queue
 	void prependWriteBuffer( PacketBuffer* first, PacketBuffer* last ) { last->next = unsent_first; unsent_first = first; if (!unsent_last) unsent_last = last; }
 
+	// Append the given range of packetBuffers to the end of the unsent queue
+	void appendWriteBuffer(PacketBuffer* first, PacketBuffer* last) {
+		if (unsent_last) {
+			unsent_last->next = first;
+		} else {
+			unsent_first = first;
+		}
+		unsent_last = last;
+	}
+
 	// false if there is anything unsent
 	bool empty() const { return !unsent_first || unsent_first->bytes_sent == unsent_first->bytes_written; }
 
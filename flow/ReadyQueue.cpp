@@ -0,0 +1,81 @@
+/*
+ * ReadyQueue.cpp
+ *
+ * This source file is part of the FoundationDB open source project
+ *
+ * Copyright 2013-2020 Apple Inc. and the FoundationDB project authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <queue>
+
+#include "flow/ReadyQueue.h"
+#include "flow/UnitTest.h"
+
+namespace {
+struct TestTask {
+	int64_t priority;
+	TaskPriority taskID;
+	TestTask(int64_t priority, TaskPriority taskID) : priority(priority), taskID(taskID) {}
+	bool operator<(TestTask const& rhs) const { return priority < rhs.priority; }
+};
+} // namespace
+
+TEST_CASE("/flow/ReadyQueue/fifoWithinPriority") {
+	BucketedReadyQueue<TestTask> q;
+	ASSERT(q.empty() && q.topPriority() == TaskPriority::Zero);
+	q.push(TestTask(1, TaskPriority::DefaultYield));
+	q.push(TestTask(2, TaskPriority::DefaultYield));
+	q.push(TestTask(3, TaskPriority::WriteSocket));
+	q.push(TestTask(4, TaskPriority::Max));
+	ASSERT(q.size() == 4 && q.topPriority() == TaskPriority::Max);
+	q.pop();
+	ASSERT(q.top().priority == 3);
+	q.pop();
+	ASSERT(q.top().priority == 1);
+	q.pop();
+	ASSERT(q.top().priority == 2);
+	q.pop();
+	ASSERT(q.empty());
+	return Void();
+}
+
+TEST_CASE("/flow/ReadyQueue/matchesPriorityQueue") {
+	// Against a binary heap ordered by (priority, -sequence), which is how Net2 used to order its ready tasks
+	BucketedReadyQueue<TestTask> q;
+	std::priority_queue<TestTask> ref;
+	int64_t seq = 0;
+	for (int i = 0; i < 100000; i++) {
+		if (ref.empty() || deterministicRandom()->random01() < 0.55) {
+			TaskPriority p = static_cast<TaskPriority>(deterministicRandom()->randomInt(0, 70000));
+			int64_t priority = (int64_t(p) << 32) - (++seq);
+			if (int(p) > BucketedReadyQueue<TestTask>::MAX_BUCKETED_PRIORITY) {
+				// Everything above the bucketed range is run in FIFO order
+				priority = (int64_t(BucketedReadyQueue<TestTask>::MAX_BUCKETED_PRIORITY) << 32) - seq;
+				p = static_cast<TaskPriority>(BucketedReadyQueue<TestTask>::MAX_BUCKETED_PRIORITY);
+			}
+			q.push(TestTask(priority, p));
+			ref.push(TestTask(priority, p));
+		} else {
+			ASSERT(q.top().priority == ref.top().priority);
+			ASSERT(q.topPriority() == ref.top().taskID);
+			q.pop();
+			ref.pop();
+		}
+		ASSERT(q.size() == ref.size());
+	}
+	q.clear();
+	ASSERT(q.empty());
+	return Void();
+}
@@ -0,0 +1,123 @@
+/*
+ * ReadyQueue.h
+ *
+ * This source file is part of the FoundationDB open source project
+ *
+ * Copyright 2013-2020 Apple Inc. and the FoundationDB project authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FLOW_READYQUEUE_H
+#define FLOW_READYQUEUE_H
+#pragma once
+
+#include <cstring>
+#include <vector>
+
+#include "flow/Platform.h"
+#include "flow/Error.h"
+#include "flow/Deque.h"
+#include "flow/network.h"
+
+// A run queue of tasks keyed by TaskPriority, with one FIFO Deque per distinct priority and a three level bitmap of
+// the non-empty priorities.  push(), top() and pop() are O(1) regardless of the number of queued tasks, and the
+// bucket being drained stays hot in cache, unlike a binary heap of every ready task.
+//
+// Within one priority, tasks run in the order they were pushed.  T must have a TaskPriority member named taskID.
+// Priorities above MAX_BUCKETED_PRIORITY share a single bucket; TaskPriority::Max is only used as a yield threshold.
+template <class T>
+class BucketedReadyQueue : NonCopyable {
+public:
+	static constexpr int MAX_BUCKETED_PRIORITY = (1 << 16) - 1;
+
+	BucketedReadyQueue() : bucketOf(MAX_BUCKETED_PRIORITY + 1, 0), count(0), summary(0) {
+		buckets.emplace_back(); // Bucket 0 means "no bucket assigned yet"
+		memset(level1, 0, sizeof(level1));
+		memset(level0, 0, sizeof(level0));
+	}
+
+	void push(T const& t) {
+		int p = slot(t.taskID);
+		uint32_t& b = bucketOf[p];
+		if (!b) {
+			b = buckets.size();
+			buckets.emplace_back();
+		}
+		Deque<T>& q = buckets[b];
+		if (q.empty()) {
+			level0[p >> 6] |= bit(p & 63);
+			level1[p >> 12] |= bit((p >> 6) & 63);
+			summary |= bit(p >> 12);
+		}
+		q.push_back(t);
+		++count;
+	}
+
+	bool empty() const { return count == 0; }
+	size_t size() const { return count; }
+
+	// Returns the oldest task at the highest queued priority.  Requires !empty().
+	T& top() { return buckets[bucketOf[topSlot()]].front(); }
+
+	// Returns the highest queued priority, or TaskPriority::Zero if empty.
+	TaskPriority topPriority() const { return empty() ? TaskPriority::Zero : top_const().taskID; }
+
+	void pop() {
+		int p = topSlot();
+		Deque<T>& q = buckets[bucketOf[p]];
+		q.pop_front();
+		--count;
+		if (q.empty()) {
+			if (!(level0[p >> 6] &= ~bit(p & 63))) {
+				if (!(level1[p >> 12] &= ~bit((p >> 6) & 63))) {
+					summary &= ~bit(p >> 12);
+				}
+			}
+		}
+	}
+
+	void clear() {
+		for (auto& q : buckets) {
+			q.clear();
+		}
+		count = 0;
+		summary = 0;
+		memset(level1, 0, sizeof(level1));
+		memset(level0, 0, sizeof(level0));
+	}
+
+private:
+	static uint64_t bit(int i) { return uint64_t(1) << i; }
+	static int slot(TaskPriority p) { return std::min<int>(static_cast<int>(p), MAX_BUCKETED_PRIORITY); }
+	static int highestBit(uint64_t w) { return 63 - clzll(w); }
+
+	int topSlot() const {
+		ASSERT(count > 0);
+		int i1 = highestBit(summary);
+		int i0 = (i1 << 6) + highestBit(level1[i1]);
+		return (i0 << 6) + highestBit(level0[i0]);
+	}
+	T const& top_const() const { return buckets[bucketOf[topSlot()]].front(); }
+
+	std::vector<uint32_t> bucketOf; // TaskPriority -> index into buckets
+	std::vector<Deque<T>> buckets;
+	size_t count;
+
+	// Bit p of level0 is set iff priority p has queued tasks; each bit of level1 and summary covers 64 bits below it
+	uint64_t summary;
+	uint64_t level1[(MAX_BUCKETED_PRIORITY + 1) >> 12];
+	uint64_t level0[(MAX_BUCKETED_PRIORITY + 1) >> 6];
+};
+
+#endif
@@ -40,6 +40,9 @@ void initializeSystemMonitorMachineState(SystemMonitorMachineState machineState)
 void systemMonitor() {
 	static StatisticsState statState = StatisticsState();
 	customSystemMonitor("ProcessMetrics", &statState, true );
+	if (ActorProfiler::enabled) {
+		ActorProfiler::logReport();
+	}
 }
 
 SystemStatistics getSystemStatistics() {
@@ -49,10 +52,38 @@ SystemStatistics getSystemStatistics() {
 		machineState.folder.present() ? machineState.folder.get() : "", &ipAddr, &statState.systemState, false);
 }
 
+void NetworkData::initFilePageCacheHitsAndMisses() {
+	TDMetricCollection* collection = TDMetricCollection::getTDMetrics();
+	if (collection == nullptr) {
+		return;
+	}
+	for (auto it = collection->metricMap.begin(); it != collection->metricMap.end(); ++it) {
+		const MetricNameRef& name = it->key;
+		if (name.id.size() == 0) {
+			continue;
+		}
+		if (name.name == LiteralStringRef("AsyncFile.CountFileCachePageReadsHit")) {
+			filePageCacheHitsAndMisses[name.id.toString()].first = it->value.castTo<Int64Metric>()->getValue();
+		} else if (name.name == LiteralStringRef("AsyncFile.CountFileCachePageReadsMissed")) {
+			filePageCacheHitsAndMisses[name.id.toString()].second = it->value.castTo<Int64Metric>()->getValue();
+		}
+	}
+}
+
 #define TRACEALLOCATOR( size ) TraceEvent("MemSample").detail("Count", FastAllocator<size>::getApproximateMemoryUnused()/size).detail("TotalSize", FastAllocator<size>::getApproximateMemoryUnused()).detail("SampleCount", 1).detail("Hash", "FastAllocatedUnused" #size ).detail("Bt", "na")
-#define DETAILALLOCATORMEMUSAGE( size ) detail("TotalMemory"#size, FastAllocator<size>::getTotalMemory()).detail("ApproximateUnusedMemory"#size, FastAllocator<size>::getApproximateMemoryUnused()).detail("ActiveThreads"#size, FastAllocator<size>::getActiveThreads())
+#define DETAILALLOCATORMEMUSAGE( size ) detail("TotalMemory"#size, FastAllocator<size>::getTotalMemory()).detail("ApproximateUnusedMemory"#size, FastAllocator<size>::getApproximateMemoryUnused()).detail("ApproximateLiveMemory"#size, FastAllocator<size>::getTotalMemory() - FastAllocator<size>::getApproximateMemoryUnused()).detail("FragmentedMemory"#size, FastAllocator<size>::getFragmentedMemory()).detail("ReclaimedMemory"#size, FastAllocator<size>::getReclaimedMemory()).detail("ActiveThreads"#size, FastAllocator<size>::getActiveThreads())
 
 SystemStatistics customSystemMonitor(std::string eventName, StatisticsState *statState, bool machineMetrics) {
+	if (FLOW_KNOBS->FAST_ALLOC_RECLAIM_MIN_UNUSED_BYTES > 0) {
+		int64_t reclaimed = reclaimUnusedAllocatedMemory(FLOW_KNOBS->FAST_ALLOC_RECLAIM_MIN_UNUSED_BYTES);
+		if (reclaimed > 0) {
+			TraceEvent("FastAllocMemoryReclaimed").detail("Bytes", reclaimed);
+		}
+	}
+	if (FLOW_KNOBS->ARENA_PROFILER_SAMPLE_BYTES > 0) {
+		logArenaProfile();
+	}
+
 	const IPAddress ipAddr = machineState.ip.present() ? machineState.ip.get() : IPAddress();
 	SystemStatistics currentStats = getSystemStatistics(machineState.folder.present() ? machineState.folder.get() : "",
 	                                                    &ipAddr, &statState->systemState, true);
@@ -126,12 +157,27 @@ SystemStatistics customSystemMonitor(std::string eventName, StatisticsState *sta
 			    .detail("TLSPolicyFailures",
 			            (netData.countTLSPolicyFailures - statState->networkState.countTLSPolicyFailures) /
 			                currentStats.elapsed)
+			    .detail("TLSHandshakes",
+			            (netData.countTLSHandshakes - statState->networkState.countTLSHandshakes) / currentStats.elapsed)
+			    .detail("TLSHandshakesResumed",
+			            (netData.countTLSHandshakesResumed - statState->networkState.countTLSHandshakesResumed) /
+			                currentStats.elapsed)
+			    .detail("TLSHandshakeFailures",
+			            (netData.countTLSHandshakeFailures - statState->networkState.countTLSHandshakeFailures) /
+			                currentStats.elapsed)
+			    .detail("TLSHandshakesThrottled",
+			            (netData.countTLSHandshakesThrottled - statState->networkState.countTLSHandshakesThrottled) /
+			                currentStats.elapsed)
+			    .detail("TLSHandshakesInProgress", g_network->networkInfo.handshakeLock->activePermits())
+			    .detail("TLSHandshakesQueued", g_network->networkInfo.handshakeLock->waiters())
+			    .detail("TLSHandshakeLimit", FLOW_KNOBS->TLS_HANDSHAKE_LIMIT)
 			    .trackLatest(eventName);
 
 			TraceEvent("MemoryMetrics")
 			    .DETAILALLOCATORMEMUSAGE(16)
 			    .DETAILALLOCATORMEMUSAGE(32)
 			    .DETAILALLOCATORMEMUSAGE(64)
+			    .DETAILALLOCATORMEMUSAGE(80)
 			    .DETAILALLOCATORMEMUSAGE(96)
 			    .DETAILALLOCATORMEMUSAGE(128)
 			    .DETAILALLOCATORMEMUSAGE(256)
@@ -145,13 +191,34 @@ SystemStatistics customSystemMonitor(std::string eventName, StatisticsState *sta
 			    .detail("ZoneID", machineState.zoneId)
 			    .detail("MachineID", machineState.machineId);
 
+			for (auto& [filename, hitsAndMisses] : netData.filePageCacheHitsAndMisses) {
+				auto previous = statState->networkState.filePageCacheHitsAndMisses.find(filename);
+				int64_t hits = hitsAndMisses.first;
+				int64_t misses = hitsAndMisses.second;
+				if (previous != statState->networkState.filePageCacheHitsAndMisses.end()) {
+					hits -= previous->second.first;
+					misses -= previous->second.second;
+				}
+				if (hits + misses > 0) {
+					TraceEvent("FilePageCacheMetrics")
+					    .detail("Filename", filename)
+					    .detail("CacheHits", hits)
+					    .detail("CacheMisses", misses)
+					    .detail("CacheHitRatio", (double)hits / (hits + misses));
+				}
+			}
+
 			TraceEvent n("NetworkMetrics");
 			n.detail("Elapsed", currentStats.elapsed)
 			    .detail("CantSleep", netData.countCantSleep - statState->networkState.countCantSleep)
 			    .detail("WontSleep", netData.countWontSleep - statState->networkState.countWontSleep)
+			    .detail("ThreadReadyWakes",
+			            netData.countThreadReadyWakes - statState->networkState.countThreadReadyWakes)
 			    .detail("Yields", netData.countYields - statState->networkState.countYields)
 			    .detail("YieldCalls", netData.countYieldCalls - statState->networkState.countYieldCalls)
 			    .detail("YieldCallsTrue", netData.countYieldCallsTrue - statState->networkState.countYieldCallsTrue)
+			    .detail("BackgroundYields",
+			            netData.countBackgroundYields - statState->networkState.countBackgroundYields)
 			    .detail("RunLoopProfilingSignals",
 			            netData.countRunLoopProfilingSignals - statState->networkState.countRunLoopProfilingSignals)
 			    .detail("YieldBigStack", netData.countYieldBigStack - statState->networkState.countYieldBigStack)
@@ -169,6 +236,8 @@ SystemStatistics customSystemMonitor(std::string eventName, StatisticsState *sta
 			    .detail("WouldBlock", netData.countWouldBlock - statState->networkState.countWouldBlock)
 			    .detail("LaunchTime", netData.countLaunchTime - statState->networkState.countLaunchTime)
 			    .detail("ReactTime", netData.countReactTime - statState->networkState.countReactTime)
+			    .detail("SpinTime", netData.countSpinTime - statState->networkState.countSpinTime)
+			    .detail("SleepTime", netData.countSleepTime - statState->networkState.countSleepTime)
 			    .detail("DCID", machineState.dcId)
 			    .detail("ZoneID", machineState.zoneId)
 			    .detail("MachineID", machineState.machineId);
@@ -339,6 +408,7 @@ SystemStatistics customSystemMonitor(std::string eventName, StatisticsState *sta
 			TRACEALLOCATOR(16);
 			TRACEALLOCATOR(32);
 			TRACEALLOCATOR(64);
+			TRACEALLOCATOR(80);
 			TRACEALLOCATOR(96);
 			TRACEALLOCATOR(128);
 			TRACEALLOCATOR(256);
@@ -56,6 +56,7 @@ struct NetworkData {
 	int64_t countWrites;
 	int64_t countRunLoop;
 	int64_t countCantSleep;
+	int64_t countThreadReadyWakes;
 	int64_t countWontSleep;
 	int64_t countTimers;
 	int64_t countTasks;
@@ -64,6 +65,7 @@ struct NetworkData {
 	int64_t countYieldCalls;
 	int64_t countASIOEvents;
 	int64_t countYieldCallsTrue;
+	int64_t countBackgroundYields;
 	int64_t countRunLoopProfilingSignals;
 	int64_t countFileLogicalWrites;
 	int64_t countFileLogicalReads;
@@ -79,12 +81,19 @@ struct NetworkData {
 	int64_t countFilePageCacheHits;
 	int64_t countFilePageCacheMisses;
 	int64_t countFilePageCacheEvictions;
+	std::map<std::string, std::pair<int64_t, int64_t>> filePageCacheHitsAndMisses; // By cached file name
 	int64_t countConnEstablished;
 	int64_t countConnClosedWithError;
 	int64_t countConnClosedWithoutError;
 	int64_t countTLSPolicyFailures;
+	int64_t countTLSHandshakes;
+	int64_t countTLSHandshakesResumed;
+	int64_t countTLSHandshakeFailures;
+	int64_t countTLSHandshakesThrottled;
 	double countLaunchTime;
 	double countReactTime;
+	double countSpinTime;
+	double countSleepTime;
 
 	void init() {
 		bytesSent = Int64Metric::getValueOrDefault(LiteralStringRef("Net2.BytesSent"));
@@ -98,6 +107,7 @@ struct NetworkData {
 		countWrites = Int64Metric::getValueOrDefault(LiteralStringRef("Net2.CountWrites"));
 		countRunLoop = Int64Metric::getValueOrDefault(LiteralStringRef("Net2.CountRunLoop"));
 		countCantSleep = Int64Metric::getValueOrDefault(LiteralStringRef("Net2.CountCantSleep"));
+		countThreadReadyWakes = Int64Metric::getValueOrDefault(LiteralStringRef("Net2.CountThreadReadyWakes"));
 		countWontSleep = Int64Metric::getValueOrDefault(LiteralStringRef("Net2.CountWontSleep"));
 		countTimers = Int64Metric::getValueOrDefault(LiteralStringRef("Net2.CountTimers"));
 		countTasks = Int64Metric::getValueOrDefault(LiteralStringRef("Net2.CountTasks"));
@@ -106,13 +116,20 @@ struct NetworkData {
 		countYieldCalls = Int64Metric::getValueOrDefault(LiteralStringRef("Net2.CountYieldCalls"));
 		countASIOEvents = Int64Metric::getValueOrDefault(LiteralStringRef("Net2.CountASIOEvents"));
 		countYieldCallsTrue = Int64Metric::getValueOrDefault(LiteralStringRef("Net2.CountYieldCallsTrue"));
+		countBackgroundYields = Int64Metric::getValueOrDefault(LiteralStringRef("Net2.CountBackgroundYields"));
 		countRunLoopProfilingSignals = Int64Metric::getValueOrDefault(LiteralStringRef("Net2.CountRunLoopProfilingSignals"));
 		countConnEstablished = Int64Metric::getValueOrDefault(LiteralStringRef("Net2.CountConnEstablished"));
 		countConnClosedWithError = Int64Metric::getValueOrDefault(LiteralStringRef("Net2.CountConnClosedWithError"));
 		countConnClosedWithoutError = Int64Metric::getValueOrDefault(LiteralStringRef("Net2.CountConnClosedWithoutError"));
 		countTLSPolicyFailures = Int64Metric::getValueOrDefault(LiteralStringRef("Net2.CountTLSPolicyFailures"));
+		countTLSHandshakes = Int64Metric::getValueOrDefault(LiteralStringRef("Net2.CountTLSHandshakes"));
+		countTLSHandshakesResumed = Int64Metric::getValueOrDefault(LiteralStringRef("Net2.CountTLSHandshakesResumed"));
+		countTLSHandshakeFailures = Int64Metric::getValueOrDefault(LiteralStringRef("Net2.CountTLSHandshakeFailures"));
+		countTLSHandshakesThrottled = Int64Metric::getValueOrDefault(LiteralStringRef("Net2.CountTLSHandshakesThrottled"));
 		countLaunchTime = DoubleMetric::getValueOrDefault(LiteralStringRef("Net2.CountLaunchTime"));
 		countReactTime = DoubleMetric::getValueOrDefault(LiteralStringRef("Net2.CountReactTime"));
+		countSpinTime = DoubleMetric::getValueOrDefault(LiteralStringRef("Net2.CountSpinTime"));
+		countSleepTime = DoubleMetric::getValueOrDefault(LiteralStringRef("Net2.CountSleepTime"));
 		countFileLogicalWrites = Int64Metric::getValueOrDefault(LiteralStringRef("AsyncFile.CountLogicalWrites"));
 		countFileLogicalReads = Int64Metric::getValueOrDefault(LiteralStringRef("AsyncFile.CountLogicalReads"));
 		countAIOSubmit = Int64Metric::getValueOrDefault(LiteralStringRef("AsyncFile.CountAIOSubmit"));
@@ -127,7 +144,11 @@ struct NetworkData {
 		countFilePageCacheHits = Int64Metric::getValueOrDefault(LiteralStringRef("AsyncFile.CountCachePageReadsHit"));
 		countFilePageCacheMisses = Int64Metric::getValueOrDefault(LiteralStringRef("AsyncFile.CountCachePageReadsMissed"));
 		countFilePageCacheEvictions = Int64Metric::getValueOrDefault(LiteralStringRef("EvictablePageCache.CacheEvictions"));
+		initFilePageCacheHitsAndMisses();
 	}
+
+	// Collects the per-file page cache counters that AsyncFileCached registers with the file name as the metric id
+	void initFilePageCacheHitsAndMisses();
 };
 
 struct StatisticsState {
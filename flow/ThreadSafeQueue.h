@@ -43,11 +43,18 @@ class ThreadSafeQueue : NonCopyable {
 	struct Node : BaseNode, FastAllocated<Node> {
 		T data;
 		Node( T const& data ) : data(data) {}
+		Node( T&& data ) : data(std::move(data)) {}
 	};
-	std::atomic<BaseNode*> head;
-	BaseNode* tail;
-	BaseNode stub, sleeping;
+
+	// Producers exchange head, while the consumer works from tail, so they are kept on separate cache lines to stop
+	// a burst of pushes from other threads from slowing every pop.  stub and sleeping have a line each too, since
+	// their next pointers are written by a producer which pushes onto an empty or sleeping queue.
+	static constexpr size_t cacheLineSize = 64;
+	alignas(cacheLineSize) std::atomic<BaseNode*> head;
+	alignas(cacheLineSize) BaseNode* tail;
 	bool sleepy;
+	alignas(cacheLineSize) BaseNode stub;
+	alignas(cacheLineSize) BaseNode sleeping;
 
 	BaseNode* popNode() {
 		BaseNode* tail = this->tail;
@@ -121,9 +128,10 @@ public:
 
 	// If push() returns true, the consumer may be sleeping and should be woken
 	bool push( T const& data ) {
-		Node* n = new Node(data);
-		n->data = data;
-		return pushNode( n ) == &sleeping;
+		return pushNode( new Node(data) ) == &sleeping;
+	}
+	bool push( T&& data ) {
+		return pushNode( new Node(std::move(data)) ) == &sleeping;
 	}
 
 	///////////// The below functions may only be called by a single, consumer thread //////////////////
@@ -0,0 +1,66 @@
+/*
+ * TimingWheel.cpp
+ *
+ * This source file is part of the FoundationDB open source project
+ *
+ * Copyright 2013-2020 Apple Inc. and the FoundationDB project authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "flow/TimingWheel.h"
+#include "flow/UnitTest.h"
+
+namespace {
+struct TestTimer {
+	double at;
+	int64_t id;
+	TestTimer(double at, int64_t id) : at(at), id(id) {}
+	bool operator<(TestTimer const& rhs) const { return at > rhs.at || (at == rhs.at && id > rhs.id); }
+};
+} // namespace
+
+TEST_CASE("/flow/TimingWheel/matchesHeap") {
+	double now = 1000.0;
+	TimingWheel<TestTimer> wheel(1e-3, now);
+	std::priority_queue<TestTimer> ref;
+	int64_t id = 0;
+	for (int i = 0; i < 100000; i++) {
+		int n = deterministicRandom()->randomInt(0, 4);
+		for (int j = 0; j < n; j++) {
+			// Sub-tick, a few ticks, many rotations, and beyond the span of the wheel
+			double r = deterministicRandom()->random01();
+			double d = r < 0.5 ? deterministicRandom()->random01() * 1e-3
+			                   : r < 0.8 ? deterministicRandom()->random01() * 10
+			                             : r < 0.98 ? deterministicRandom()->random01() * 1e5
+			                                        : deterministicRandom()->random01() * 1e7;
+			wheel.push(TestTimer(now + d, id));
+			ref.push(TestTimer(now + d, id));
+			++id;
+		}
+		ASSERT(ref.empty() || wheel.nextDeadline() <= ref.top().at);
+
+		now += deterministicRandom()->random01() < 0.001 ? 5e6 : deterministicRandom()->random01() * 1e-2;
+		wheel.advance(now);
+		while (!ref.empty() && ref.top().at < now) {
+			ASSERT(wheel.hasDue() && wheel.top().id == ref.top().id);
+			wheel.pop();
+			ref.pop();
+		}
+		ASSERT(!wheel.hasDue() || wheel.top().at >= now);
+		ASSERT(wheel.size() == ref.size());
+	}
+	wheel.clear();
+	ASSERT(wheel.empty() && wheel.nextDeadline() == 1e99);
+	return Void();
+}
@@ -0,0 +1,220 @@
+/*
+ * TimingWheel.h
+ *
+ * This source file is part of the FoundationDB open source project
+ *
+ * Copyright 2013-2020 Apple Inc. and the FoundationDB project authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FLOW_TIMINGWHEEL_H
+#define FLOW_TIMINGWHEEL_H
+#pragma once
+
+#include <cstring>
+#include <queue>
+#include <vector>
+
+#include "flow/Platform.h"
+#include "flow/Arena.h"
+
+// A hierarchical timing wheel of timers.  T must have a double member named at (the deadline), and an operator< that
+// orders later deadlines first, as for a std::priority_queue used as a min-heap.
+//
+// Each of the LEVELS wheels has SLOTS slots; a slot at level l holds the timers whose deadline tick shares every digit
+// above l with the current tick.  push() is O(1); advance() moves a slot down a level, or into a small heap of due
+// timers, only when the current tick reaches it.  Timers due within the current tick are kept in that heap, so timers
+// still fire in deadline order and at their exact deadline no matter the wheel resolution.  Deadlines beyond the span
+// of the wheel wait in a separate heap until they come into range.
+template <class T>
+class TimingWheel : NonCopyable {
+public:
+	static constexpr int LEVEL_BITS = 8;
+	static constexpr int SLOTS = 1 << LEVEL_BITS;
+	static constexpr int LEVELS = 4;
+
+	TimingWheel(double resolution, double now) : resolution(resolution), currentTick(tickOf(now)), inWheel(0) {
+		ASSERT(resolution > 0);
+	}
+
+	void push(T const& t) {
+		uint64_t tick = tickOf(t.at);
+		if (tick <= currentTick) {
+			due.push(t);
+		} else {
+			place(tick, t);
+		}
+	}
+
+	bool empty() const { return size() == 0; }
+	size_t size() const { return due.size() + inWheel + far.size(); }
+
+	// Moves every timer whose deadline is in or before now's tick into the due heap
+	void advance(double now) {
+		uint64_t target = tickOf(now);
+		while (currentTick < target && inWheel) {
+			// Jump directly to the next occupied slot in this rotation of level 0, or else to the start of the next
+			// occupied slot of an upper level.  Every slot skipped over is empty, so there is nothing to cascade.
+			uint64_t base = currentTick & ~uint64_t(SLOTS - 1);
+			int next = nextOccupied(0, (currentTick & (SLOTS - 1)) + 1);
+			if (next >= 0) {
+				if (base + next > target) break;
+				currentTick = base + next;
+				drain(0, next);
+				continue;
+			}
+
+			uint64_t nextSlot = nextSlotStart(1);
+			if (nextSlot > target) break;
+			currentTick = nextSlot;
+			cascade();
+		}
+		currentTick = std::max(currentTick, target);
+
+		while (!far.empty()) {
+			uint64_t tick = tickOf(far.top().at);
+			if (tick > currentTick && levelOf(tick) >= LEVELS) break;
+			T t = far.top();
+			far.pop();
+			push(t);
+		}
+	}
+
+	// The due timer with the earliest deadline.  The caller should advance() first.
+	bool hasDue() const { return !due.empty(); }
+	T const& top() const { return due.top(); }
+	void pop() { due.pop(); }
+
+	// A lower bound on the deadline of every timer, which is exact if any timer is due in the current tick.  Returns
+	// 1e99 if there are no timers.
+	double nextDeadline() const {
+		if (!due.empty()) {
+			return due.top().at;
+		}
+		if (inWheel) {
+			return nextSlotStart(0) * resolution;
+		}
+		return far.empty() ? 1e99 : far.top().at;
+	}
+
+	void clear() {
+		for (auto& level : levels) {
+			for (auto& slot : level.slots) {
+				slot.clear();
+			}
+			memset(level.occupied, 0, sizeof(level.occupied));
+		}
+		inWheel = 0;
+		decltype(due) _1;
+		due.swap(_1);
+		decltype(far) _2;
+		far.swap(_2);
+	}
+
+private:
+	struct Level {
+		std::vector<T> slots[SLOTS];
+		uint64_t occupied[SLOTS / 64] = {};
+	};
+
+	uint64_t tickOf(double at) const { return at <= 0 ? 0 : uint64_t(at / resolution); }
+
+	// The level of the wheel for a tick in the future, or >= LEVELS if it is beyond the wheel
+	int levelOf(uint64_t tick) const {
+		uint64_t diff = tick ^ currentTick;
+		return diff ? (63 - clzll(diff)) / LEVEL_BITS : 0;
+	}
+
+	void place(uint64_t tick, T const& t) {
+		int l = levelOf(tick);
+		if (l >= LEVELS) {
+			far.push(t);
+			return;
+		}
+		int s = (tick >> (l * LEVEL_BITS)) & (SLOTS - 1);
+		levels[l].slots[s].push_back(t);
+		levels[l].occupied[s >> 6] |= uint64_t(1) << (s & 63);
+		++inWheel;
+	}
+
+	// The first occupied slot at level l at or after from, or -1
+	int nextOccupied(int l, int from) const {
+		for (int w = from >> 6; w < SLOTS / 64 && from < SLOTS; w++) {
+			uint64_t bits = levels[l].occupied[w];
+			if (w == (from >> 6)) {
+				bits &= ~uint64_t(0) << (from & 63);
+			}
+			if (bits) {
+				return (w << 6) + ctzll(bits);
+			}
+		}
+		return -1;
+	}
+
+	// The first tick of the next occupied slot after the current tick, searching from level fromLevel up.  Slots of
+	// lower levels always come before those of higher levels.
+	uint64_t nextSlotStart(int fromLevel) const {
+		for (int l = fromLevel; l < LEVELS; l++) {
+			int shift = l * LEVEL_BITS;
+			int next = nextOccupied(l, ((currentTick >> shift) & (SLOTS - 1)) + 1);
+			if (next >= 0) {
+				uint64_t rotation = currentTick & ~((uint64_t(1) << (shift + LEVEL_BITS)) - 1);
+				return rotation + (uint64_t(next) << shift);
+			}
+		}
+		ASSERT(false); // inWheel is out of sync with the occupied bitmaps
+		return currentTick;
+	}
+
+	std::vector<T> take(int l, int s) {
+		std::vector<T> timers;
+		timers.swap(levels[l].slots[s]);
+		levels[l].occupied[s >> 6] &= ~(uint64_t(1) << (s & 63));
+		inWheel -= timers.size();
+		return timers;
+	}
+
+	void drain(int l, int s) {
+		for (auto& t : take(l, s)) {
+			due.push(t);
+		}
+	}
+
+	// Called when currentTick has just reached the start of an upper level slot: redistribute the slot of each upper
+	// level whose rotation currentTick has just entered, from the highest such level down, so that timers land in
+	// lower levels or due.
+	void cascade() {
+		int top = 1;
+		while (top < LEVELS - 1 && (currentTick & ((uint64_t(1) << ((top + 1) * LEVEL_BITS)) - 1)) == 0) {
+			++top;
+		}
+		for (int l = top; l >= 1; l--) {
+			int s = (currentTick >> (l * LEVEL_BITS)) & (SLOTS - 1);
+			if (levels[l].occupied[s >> 6] & (uint64_t(1) << (s & 63))) {
+				for (auto& t : take(l, s)) {
+					push(t);
+				}
+			}
+		}
+	}
+
+	double resolution;
+	uint64_t currentTick; // Every timer in a tick <= currentTick is in due
+	size_t inWheel;
+	Level levels[LEVELS];
+	std::priority_queue<T, std::vector<T>> due;
+	std::priority_queue<T, std::vector<T>> far;
+};
+
+#endif
@@ -24,6 +24,7 @@
 #include "flow/Knobs.h"
 #include "flow/XmlTraceLogFormatter.h"
 #include "flow/JsonTraceLogFormatter.h"
+#include "flow/BinaryTraceLogFormatter.h"
 #include "flow/flow.h"
 #include "flow/DeterministicRandom.h"
 #include <stdlib.h>
@@ -247,11 +248,11 @@ public:
 		struct WriteBuffer final : TypedAction<WriterThread, WriteBuffer> {
 			std::vector<TraceEventFields> events;
 
-			WriteBuffer(std::vector<TraceEventFields> events) : events(events) {}
+			WriteBuffer(std::vector<TraceEventFields>&& events) : events(std::move(events)) {}
 			double getTimeEstimate() const override { return .001; }
 		};
 		void action( WriteBuffer& a ) {
-			for(auto event : a.events) {
+			for(auto const& event : a.events) {
 				event.validateFormat();
 				logWriter->write(formatter->formatEvent(event));
 			}
@@ -347,7 +348,7 @@ public:
 		fields.setAnnotated();
 	}
 
-	void writeEvent(TraceEventFields fields, std::string trackLatestKey, bool trackError) {
+	void writeEvent(TraceEventFields fields, std::string const& trackLatestKey, bool trackError) {
 		MutexHolder hold(mutex);
 
 		annotateEvent(fields);
@@ -363,15 +364,16 @@ public:
 
 		// FIXME: What if we are using way too much memory for buffer?
 		ASSERT(!isOpen() || fields.isAnnotated());
-		eventBuffer.push_back(fields);
-		bufferLength += fields.sizeBytes();
-
 		if(trackError) {
 			latestEventCache.setLatestError(fields);
 		}
 		if(!trackLatestKey.empty()) {
 			latestEventCache.set(trackLatestKey, fields);
 		}
+
+		// Events are formatted on the writer thread, so all the network thread does is hand the fields over
+		bufferLength += fields.sizeBytes();
+		eventBuffer.push_back(std::move(fields));
 	}
 
 	void log(int severity, const char *name, UID id, uint64_t event_ts)
@@ -601,6 +603,11 @@ bool traceFormatImpl(std::string& format) {
 			g_traceLog.formatter = Reference<ITraceLogFormatter>(new JsonTraceLogFormatter());
 		}
 		return true;
+	} else if (format == "binary") {
+		if (!validate) {
+			g_traceLog.formatter = Reference<ITraceLogFormatter>(new BinaryTraceLogFormatter());
+		}
+		return true;
 	} else {
 		if (!validate) {
 			g_traceLog.formatter = Reference<ITraceLogFormatter>(new XmlTraceLogFormatter());
@@ -1095,7 +1102,7 @@ void TraceEvent::log() {
 					TraceEvent::eventCounts[severity/10]++;
 				}
 
-				g_traceLog.writeEvent( fields, trackingKey, severity > SevWarnAlways );
+				g_traceLog.writeEvent( std::move(fields), trackingKey, severity > SevWarnAlways );
 
 				if (g_traceLog.isOpen()) {
 					// Log Metrics
@@ -1239,21 +1246,21 @@ void TraceBatch::dump() {
 		if(g_network->isSimulated()) {
 			attachBatch[i].fields.addField("Machine", machine);
 		}
-		g_traceLog.writeEvent(attachBatch[i].fields, "", false);
+		g_traceLog.writeEvent(std::move(attachBatch[i].fields), "", false);
 	}
 
 	for(int i = 0; i < eventBatch.size(); i++) {
 		if(g_network->isSimulated()) {
 			eventBatch[i].fields.addField("Machine", machine);
 		}
-		g_traceLog.writeEvent(eventBatch[i].fields, "", false);
+		g_traceLog.writeEvent(std::move(eventBatch[i].fields), "", false);
 	}
 
 	for(int i = 0; i < buggifyBatch.size(); i++) {
 		if(g_network->isSimulated()) {
 			buggifyBatch[i].fields.addField("Machine", machine);
 		}
-		g_traceLog.writeEvent(buggifyBatch[i].fields, "", false);
+		g_traceLog.writeEvent(std::move(buggifyBatch[i].fields), "", false);
 	}
 
 	onMainThreadVoid([](){ g_traceLog.flush(); }, nullptr);
@@ -431,6 +431,16 @@ private:
 
 ITracer* g_tracer = new NoopTracer();
 
+// Whether the spans of a trace are exported. The decision depends only on the trace ID, which children inherit from
+// their first parent, so a sampled commit is traced through every role it passes.
+bool isSampled(SpanID context) {
+	double rate = FLOW_KNOBS->TRACING_SAMPLE_RATE;
+	if (rate >= 1.0) {
+		return true;
+	}
+	return (context.first() >> 11) * 0x1.0p-53 < rate;
+}
+
 } // namespace
 
 void openTracer(TracerType type) {
@@ -464,7 +474,7 @@ void openTracer(TracerType type) {
 ITracer::~ITracer() {}
 
 Span& Span::operator=(Span&& o) {
-	if (begin > 0.0) {
+	if (begin > 0.0 && isSampled(context)) {
 		end = g_network->now();
 		g_tracer->trace(*this);
 	}
@@ -479,7 +489,7 @@ Span& Span::operator=(Span&& o) {
 }
 
 Span::~Span() {
-	if (begin > 0.0) {
+	if (begin > 0.0 && isSampled(context)) {
 		end = g_network->now();
 		g_tracer->trace(*this);
 	}
@@ -474,6 +474,10 @@ namespace actorcompiler
             }
         }
 
+        void ProfilerScope(Function fun, string name) {
+            fun.WriteLine("ActorProfilerScope _actorProfilerScope(\"{0}\");", name);
+        }
+
         void ProbeExit(Function fun, string name, int index = -1) {
             if (generateProbes) {
                 fun.WriteLine("fdb_probe_actor_exit(\"{0}\", {1}, {2});", name, thisAddress, index);
@@ -868,6 +872,7 @@ namespace actorcompiler
                 functions.Add(string.Format("{0}#{1}", cbFunc.name, ch.Index), cbFunc);
                 cbFunc.Indent(codeIndent);
                 ProbeEnter(cbFunc, actor.name, ch.Index);
+                ProfilerScope(cbFunc, actor.name);
                 cbFunc.WriteLine("{0};", exitFunc.call());
 
                 Function _overload = cbFunc.popOverload();
@@ -895,6 +900,7 @@ namespace actorcompiler
                 functions.Add(string.Format("{0}#{1}", errFunc.name, ch.Index), errFunc);
                 errFunc.Indent(codeIndent);
                 ProbeEnter(errFunc, actor.name, ch.Index);
+                ProfilerScope(errFunc, actor.name);
                 errFunc.WriteLine("{0};", exitFunc.call());
                 TryCatch(cx.WithTarget(errFunc), cx.catchFErr, cx.tryLoopDepth, () =>
                 {
@@ -1286,6 +1292,7 @@ namespace actorcompiler
             constructor.WriteLine("{");
             constructor.Indent(+1);
             ProbeEnter(constructor, actor.name);
+            ProfilerScope(constructor, actor.name);
             constructor.WriteLine("this->{0};", body.call());
             ProbeExit(constructor, actor.name);
             WriteFunction(writer, constructor, constructor.BodyText);
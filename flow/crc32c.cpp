@@ -36,9 +36,18 @@
 #include <stdlib.h>
 #include <random>
 #include <algorithm>
+#include <cstring>
+#include <vector>
 #include "flow/Platform.h"
+#include "flow/UnitTest.h"
 #include "crc32c-generated-constants.cpp"
 
+/* Both x86-64 and aarch64 have a crc instruction taking eight bytes at a time,
+   twice the throughput of the four byte one */
+#if defined(_M_X64) || defined(__x86_64__) || defined(__aarch64__)
+#define CRC32C_64BIT
+#endif
+
 static uint32_t append_trivial(uint32_t crc, const uint8_t * input, size_t length)
 {
     for (size_t i = 0; i < length; ++i)
@@ -92,14 +101,14 @@ static uint32_t append_adler_table(uint32_t crci, const uint8_t * input, size_t
 static uint32_t append_table(uint32_t crci, const uint8_t * input, size_t length)
 {
     const uint8_t * next = input;
-#ifdef _M_X64
+#ifdef CRC32C_64BIT
     uint64_t crc;
 #else
     uint32_t crc;
 #endif
 
     crc = crci ^ 0xffffffff;
-#ifdef _M_X64
+#ifdef CRC32C_64BIT
     while (length && ((uintptr_t)next & 7) != 0)
     {
         crc = table[0][(crc ^ *next++) & 0xff] ^ (crc >> 8);
@@ -181,7 +190,7 @@ static uint32_t append_hw(uint32_t crc, const uint8_t * buf, size_t len)
 {
     const uint8_t * next = buf;
     const uint8_t * end;
-#ifdef _M_X64
+#ifdef CRC32C_64BIT
     uint64_t crc0, crc1, crc2;      /* need to be 64 bits for crc32q */
 #else
     uint32_t crc0, crc1, crc2;
@@ -199,7 +208,7 @@ static uint32_t append_hw(uint32_t crc, const uint8_t * buf, size_t len)
         --len;
     }
 
-#ifdef _M_X64
+#ifdef CRC32C_64BIT
     /* compute the crc on sets of LONG_SHIFT*3 bytes, executing three independent crc
        instructions, each on LONG_SHIFT bytes -- this is optimized for the Nehalem,
        Westmere, Sandy Bridge, and Ivy Bridge architectures, which have a
@@ -317,6 +326,54 @@ static uint32_t append_hw(uint32_t crc, const uint8_t * buf, size_t len)
 }
 
 
+/* Compute the CRC-32C of three buffers at once.  Their crc instructions are
+   independent, so this keeps the pipeline as full as append_hw() does for a
+   single buffer, without the shift_crc() merges it needs to split that buffer
+   three ways.  The buffers are run together for the length of the shortest,
+   and append_hw() finishes each one's remainder. */
+#if (defined(__clang__) || defined(__GNUG__)) && (!defined(__aarch64__))
+__attribute__((target("sse4.2")))
+#endif
+static void append_hw_3way(uint32_t * crcs, const uint8_t * const * inputs, const size_t * lengths)
+{
+    const uint8_t * next0 = inputs[0];
+    const uint8_t * next1 = inputs[1];
+    const uint8_t * next2 = inputs[2];
+    size_t common = std::min(lengths[0], std::min(lengths[1], lengths[2])) & ~(size_t)7;
+#ifdef CRC32C_64BIT
+    uint64_t crc0 = crcs[0] ^ 0xffffffff;
+    uint64_t crc1 = crcs[1] ^ 0xffffffff;
+    uint64_t crc2 = crcs[2] ^ 0xffffffff;
+    for (size_t i = 0; i < common; i += 8)
+    {
+        uint64_t v0, v1, v2;
+        memcpy(&v0, next0 + i, 8);
+        memcpy(&v1, next1 + i, 8);
+        memcpy(&v2, next2 + i, 8);
+        crc0 = hwCrc32cU64(crc0, v0);
+        crc1 = hwCrc32cU64(crc1, v1);
+        crc2 = hwCrc32cU64(crc2, v2);
+    }
+#else
+    uint32_t crc0 = crcs[0] ^ 0xffffffff;
+    uint32_t crc1 = crcs[1] ^ 0xffffffff;
+    uint32_t crc2 = crcs[2] ^ 0xffffffff;
+    for (size_t i = 0; i < common; i += 4)
+    {
+        uint32_t v0, v1, v2;
+        memcpy(&v0, next0 + i, 4);
+        memcpy(&v1, next1 + i, 4);
+        memcpy(&v2, next2 + i, 4);
+        crc0 = hwCrc32cU32(crc0, v0);
+        crc1 = hwCrc32cU32(crc1, v1);
+        crc2 = hwCrc32cU32(crc2, v2);
+    }
+#endif
+    crcs[0] = append_hw(static_cast<uint32_t>(crc0) ^ 0xffffffff, next0 + common, lengths[0] - common);
+    crcs[1] = append_hw(static_cast<uint32_t>(crc1) ^ 0xffffffff, next1 + common, lengths[1] - common);
+    crcs[2] = append_hw(static_cast<uint32_t>(crc2) ^ 0xffffffff, next2 + common, lengths[2] - common);
+}
+
 static bool hw_available = platform::isHwCrcSupported();
 
 extern "C" uint32_t crc32c_append(uint32_t crc, const uint8_t * input, size_t length)
@@ -326,3 +383,38 @@ extern "C" uint32_t crc32c_append(uint32_t crc, const uint8_t * input, size_t le
     else
         return append_table(crc, input, length);
 }
+
+extern "C" void crc32c_append_batch(uint32_t * crcs, const uint8_t * const * inputs, const size_t * lengths, size_t count)
+{
+    size_t i = 0;
+    if (hw_available)
+    {
+        for (; i + 3 <= count; i += 3)
+            append_hw_3way(crcs + i, inputs + i, lengths + i);
+    }
+    for (; i < count; ++i)
+        crcs[i] = crc32c_append(crcs[i], inputs[i], lengths[i]);
+}
+
+TEST_CASE("/flow/crc32c/batch") {
+    std::vector<uint8_t> data(100000);
+    for (auto& b : data) b = deterministicRandom()->randomInt(0, 256);
+
+    for (int i = 0; i < 100; i++) {
+        int count = deterministicRandom()->randomInt(0, 10);
+        std::vector<uint32_t> crcs, expected;
+        std::vector<const uint8_t*> inputs;
+        std::vector<size_t> lengths;
+        for (int j = 0; j < count; j++) {
+            size_t length = deterministicRandom()->randomInt(0, deterministicRandom()->coinflip() ? 20 : 20000);
+            inputs.push_back(&data[deterministicRandom()->randomInt(0, data.size() - length + 1)]);
+            lengths.push_back(length);
+            crcs.push_back(deterministicRandom()->randomUInt32());
+            expected.push_back(append_table(crcs.back(), inputs.back(), length));
+            ASSERT(crc32c_append(crcs.back(), inputs.back(), length) == expected.back());
+        }
+        crc32c_append_batch(crcs.data(), inputs.data(), lengths.data(), count);
+        ASSERT(crcs == expected);
+    }
+    return Void();
+}
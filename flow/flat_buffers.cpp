@@ -38,41 +38,6 @@ void swapWithThreadLocalGlobal(std::vector<int>& writeToOffsets) {
 	gWriteToOffsetsMemory.swap(writeToOffsets);
 }
 
-VTable generate_vtable(size_t numMembers, const std::vector<unsigned>& sizesAlignments) {
-	if (numMembers == 0) {
-		return VTable{ 4, 4 };
-	}
-	// first is index, second is size
-	std::vector<std::pair<unsigned, unsigned>> indexed;
-	indexed.reserve(numMembers);
-	for (unsigned i = 0; i < numMembers; ++i) {
-		if (sizesAlignments[i] > 0) {
-			indexed.emplace_back(i, sizesAlignments[i]);
-		}
-	}
-	std::stable_sort(indexed.begin(), indexed.end(),
-	                 [](const std::pair<unsigned, unsigned>& lhs, const std::pair<unsigned, unsigned>& rhs) {
-		                 return lhs.second > rhs.second;
-	                 });
-	VTable result;
-	result.resize(numMembers + 2);
-	// size of the vtable is
-	// - 2 bytes per member +
-	// - 2 bytes for the size entry +
-	// - 2 bytes for the size of the object
-	result[0] = 2 * numMembers + 4;
-	int offset = 0;
-	for (auto p : indexed) {
-		auto align = sizesAlignments[numMembers + p.first];
-		auto& res = result[p.first + 2];
-		res = offset % align == 0 ? offset : ((offset / align) + 1) * align;
-		offset = res + p.second;
-		res += 4;
-	}
-	result[1] = offset + 4;
-	return result;
-}
-
 } // namespace detail
 
 namespace unit_tests {
@@ -95,6 +60,15 @@ TEST_CASE("flow/FlatBuffers/test") {
 	return Void();
 }
 
+TEST_CASE("flow/FlatBuffers/constexprVtable") {
+	// Sizes 1, 8 and 4, aligned to themselves: the 8 byte member is laid out first, then the 4 byte one
+	constexpr auto table = detail::generate_vtable<3>({ 1, 8, 4, 1, 8, 4 });
+	static_assert(table[0] == 10 && table[1] == 17);
+	static_assert(table[2] == 16 && table[3] == 4 && table[4] == 12);
+	ASSERT(detail::get_vtable<int>() == detail::get_vtable<uint32_t>());
+	return Void();
+}
+
 TEST_CASE("flow/FlatBuffers/emptyVtable") {
 	auto* vtable = detail::get_vtable<>();
 	ASSERT((*vtable)[0] == 4);
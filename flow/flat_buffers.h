@@ -315,7 +315,16 @@ constexpr bool expect_serialize_member =
 template <class T>
 constexpr bool use_indirection = !(is_scalar<T> || is_struct_like<T>);
 
-using VTable = std::vector<uint16_t>;
+// The entries of a vtable, which live in static storage so that a pointer to one identifies it
+struct VTable {
+	const uint16_t* entries;
+	size_t count;
+
+	const uint16_t& operator[](size_t i) const { return entries[i]; }
+	const uint16_t* begin() const { return entries; }
+	const uint16_t* end() const { return entries + count; }
+	size_t size() const { return count; }
+};
 
 template <class T>
 constexpr int fb_scalar_size = is_scalar<T> ? scalar_traits<T>::size : sizeof(RelativeOffset);
@@ -562,13 +571,47 @@ using Fields = decltype(fields_helper<Member>());
 // so that we can decide equality by comparing the pointers.
 
 // First |numMembers| elements of sizesAndAlignments are sizes, the second
-// |numMembers| elements are alignments.
-extern VTable generate_vtable(size_t numMembers, const std::vector<unsigned>& sizesAndAlignments);
+// |numMembers| elements are alignments.  Evaluated at compile time, so that
+// serializing a table never has to build or look up its layout.
+template <size_t numMembers>
+constexpr std::array<uint16_t, numMembers + 2> generate_vtable(
+    const std::array<unsigned, 2 * numMembers>& sizesAlignments) {
+	// Members are laid out largest first, and in order among members of the
+	// same size.  Members of size 0 take no space and keep an entry of 0.
+	std::array<unsigned, numMembers> indexed{};
+	size_t count = 0;
+	for (unsigned i = 0; i < numMembers; ++i) {
+		if (sizesAlignments[i] > 0) {
+			size_t j = count++;
+			for (; j > 0 && sizesAlignments[indexed[j - 1]] < sizesAlignments[i]; --j) {
+				indexed[j] = indexed[j - 1];
+			}
+			indexed[j] = i;
+		}
+	}
+	std::array<uint16_t, numMembers + 2> result{};
+	// size of the vtable is
+	// - 2 bytes per member +
+	// - 2 bytes for the size entry +
+	// - 2 bytes for the size of the object
+	result[0] = 2 * numMembers + 4;
+	unsigned offset = 0;
+	for (size_t k = 0; k < count; ++k) {
+		unsigned i = indexed[k];
+		unsigned align = sizesAlignments[numMembers + i];
+		unsigned res = offset % align == 0 ? offset : ((offset / align) + 1) * align;
+		offset = res + sizesAlignments[i];
+		result[i + 2] = res + 4;
+	}
+	result[1] = offset + 4;
+	return result;
+}
 
 template <unsigned... MembersAndAlignments>
 const VTable* gen_vtable3() {
-	static thread_local VTable table =
-	    generate_vtable(sizeof...(MembersAndAlignments) / 2, std::vector<unsigned>{ MembersAndAlignments... });
+	static constexpr auto entries = generate_vtable<sizeof...(MembersAndAlignments) / 2>(
+	    std::array<unsigned, sizeof...(MembersAndAlignments)>{ MembersAndAlignments... });
+	static constexpr VTable table{ entries.data(), entries.size() };
 	return &table;
 }
 
@@ -664,7 +707,7 @@ struct InsertVTableLambda : Context {
 
 template <class T>
 int vec_bytes(const T& begin, const T& end) {
-	return sizeof(typename T::value_type) * (end - begin);
+	return sizeof(typename std::iterator_traits<T>::value_type) * (end - begin);
 }
 
 template <class Root, class Context>
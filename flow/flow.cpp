@@ -50,6 +50,15 @@ thread_local Reference<IRandom> seededRandom;
 uint64_t debug_lastLoadBalanceResultEndpointToken = 0;
 bool noUnseed = false;
 
+SAV<Void>* readyVoidSAV() {
+	static thread_local SAV<Void>* sav = nullptr;
+	if (sav == nullptr) {
+		sav = new SAV<Void>(std::numeric_limits<int>::max() / 2, 0);
+		sav->send(Void());
+	}
+	return sav;
+}
+
 void setThreadLocalDeterministicRandomSeed(uint32_t seed) {
 	seededRandom = Reference<IRandom>(new DeterministicRandom(seed, true));
 }
@@ -38,6 +38,7 @@
 #include <algorithm>
 
 #include "flow/Platform.h"
+#include "flow/ActorProfiler.h"
 #include "flow/FastAlloc.h"
 #include "flow/IRandom.h"
 #include "flow/serialize.h"
@@ -571,22 +572,35 @@ struct NotifiedQueue : private SingleCallback<T>, FastAllocated<NotifiedQueue<T>
 	// Invariant: SingleCallback<T>::next==this || (queue.empty() && !error.isValid())
 	std::queue<T, Deque<T>> queue;
 	Error error;
+	SAV<Void>* onEmpty = nullptr; // Set by PromiseStream::onEmpty() once the queue is next emptied by pop()
 
 	NotifiedQueue(int futures, int promises) : futures(futures), promises(promises) {
 		SingleCallback<T>::next = this;
 	}
+	~NotifiedQueue() {
+		if (onEmpty) onEmpty->delPromiseRef();
+	}
 
 	bool isReady() const { return !queue.empty() || error.isValid(); }
 	bool isError() const { return queue.empty() && error.isValid(); }  // the *next* thing queued is an error
 	uint32_t size() const { return queue.size(); }
 
-	T pop() {
+	// Overridden by queues that need to know when a value is consumed (see NetNotifiedQueueWithAcknowledgements)
+	virtual T pop() { return popImpl(); }
+
+	T popImpl() {
 		if (queue.empty()) {
 			if (error.isValid()) throw error;
 			throw internal_error();
 		}
 		auto copy = std::move(queue.front());
 		queue.pop();
+		if (onEmpty && queue.empty()) {
+			SAV<Void>* s = onEmpty;
+			onEmpty = nullptr;
+			s->send(Void());
+			s->delPromiseRef();
+		}
 		return copy;
 	}
 
@@ -610,6 +624,9 @@ struct NotifiedQueue : private SingleCallback<T>, FastAllocated<NotifiedQueue<T>
 			SingleCallback<T>::next->error(err);
 	}
 
+	// True if a value sent now would go straight to a waiting callback rather than through pop()
+	bool shouldFireImmediately() const { return SingleCallback<T>::next != this; }
+
 	void addPromiseRef() { promises++; }
 	void addFutureRef() { futures++; }
 
@@ -646,6 +663,10 @@ struct NotifiedQueue : private SingleCallback<T>, FastAllocated<NotifiedQueue<T>
 	virtual void fire(T&&) override { ASSERT(false); }
 };
 
+// Ready Future<Void>s are by far the most common futures made from a value (every `return Void();` outside an actor), so
+// each thread shares one set SAV between all of them instead of allocating one each.  It starts with so many future
+// references that it is never freed, even if a future made on one thread happens to be destroyed on another.
+SAV<Void>* readyVoidSAV();
 
 template <class T>
 class Promise;
@@ -680,15 +701,23 @@ public:
 		rhs.sav = 0;
 		//if (sav->endpoint.isValid()) cout << "Future moved for " << sav->endpoint.key << endl;
 	}
-	Future(const T& presentValue)
-		: sav(new SAV<T>(1, 0))
-	{
-		sav->send(presentValue);
+	Future(const T& presentValue) {
+		if constexpr (std::is_same_v<T, Void>) {
+			sav = readyVoidSAV();
+			sav->addFutureRef();
+		} else {
+			sav = new SAV<T>(1, 0);
+			sav->send(presentValue);
+		}
 	}
-	Future(T&& presentValue)
-		: sav(new SAV<T>(1, 0))
-	{
-		sav->send(std::move(presentValue));
+	Future(T&& presentValue) {
+		if constexpr (std::is_same_v<T, Void>) {
+			sav = readyVoidSAV();
+			sav->addFutureRef();
+		} else {
+			sav = new SAV<T>(1, 0);
+			sav->send(std::move(presentValue));
+		}
 	}
 	Future(Never)
 		: sav(new SAV<T>(1, 0))
@@ -948,6 +977,15 @@ public:
 	}
 
 	FutureStream<T> getFuture() const { queue->addFutureRef(); return FutureStream<T>(queue); }
+
+	// Ready once every value sent so far has been consumed, for producers that should not run far ahead
+	Future<Void> onEmpty() const {
+		if (queue->queue.empty()) return Void();
+		if (!queue->onEmpty) queue->onEmpty = new SAV<Void>(0, 1);
+		queue->onEmpty->addFutureRef();
+		return Future<Void>(queue->onEmpty);
+	}
+
 	PromiseStream() : queue(new NotifiedQueue<T>(0, 1)) {}
 	PromiseStream(const PromiseStream& rhs) : queue(rhs.queue) { queue->addPromiseRef(); }
 	PromiseStream(PromiseStream&& rhs) noexcept : queue(rhs.queue) { rhs.queue = 0; }
@@ -1027,5 +1065,28 @@ inline Future<Void> delayJittered(double seconds, TaskPriority taskID = TaskPrio
 inline Future<Void> yield(TaskPriority taskID = TaskPriority::DefaultYield) { return g_network->yield(taskID); }
 inline bool check_yield(TaskPriority taskID = TaskPriority::DefaultYield) { return g_network->check_yield(taskID); }
 
+// Amortizes yield checks over the iterations of a hot loop.  Only every YIELD_BUDGET_INTERVAL units of work does
+// shouldYield() ask the network whether the task's time slice is spent, so that a loop over small items neither calls
+// yield() for each of them nor runs far past its slice:
+//     if (budget.shouldYield()) wait(yield());
+class YieldBudget {
+public:
+	explicit YieldBudget(TaskPriority taskID = TaskPriority::DefaultYield)
+	  : taskID(taskID), remaining(FLOW_KNOBS->YIELD_BUDGET_INTERVAL) {}
+
+	bool shouldYield(int units = 1) {
+		remaining -= units;
+		if (remaining > 0) {
+			return false;
+		}
+		remaining = FLOW_KNOBS->YIELD_BUDGET_INTERVAL;
+		return check_yield(taskID);
+	}
+
+private:
+	TaskPriority taskID;
+	int remaining;
+};
+
 #include "flow/genericactors.actor.h"
 #endif
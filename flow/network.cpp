@@ -167,6 +167,15 @@ Future<Reference<IConnection>> INetworkConnections::connect( std::string host, s
 	});
 }
 
+Future<Void> INetwork::runOnWorkerReactor( std::function<void()> fn, TaskPriority taskID ) {
+	try {
+		fn();
+	} catch (Error& e) {
+		return e;
+	}
+	return Void();
+}
+
 IUDPSocket::~IUDPSocket() {}
 
 const std::vector<int> NetworkMetrics::starvationBins = { 1, 3500, 7000, 7500, 8500, 8900, 10500 };
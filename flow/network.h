@@ -508,6 +508,11 @@ public:
 	virtual void onMainThread( Promise<Void>&& signal, TaskPriority taskID ) = 0;
 	// Executes signal.send(Void()) on a/the thread belonging to this network
 
+	virtual Future<Void> runOnWorkerReactor( std::function<void()> fn, TaskPriority taskID );
+	// Runs fn on one of this network's worker reactor threads (see NET2_WORKER_REACTORS) and returns a future that is
+	// set on this network's thread at taskID once fn has completed.  fn must be thread safe and must not touch flow
+	// state other than its own captures.  Networks without worker reactors run fn inline.
+
 	virtual THREAD_HANDLE startThread( THREAD_FUNC_RETURN (*func) (void *), void *arg) = 0;
 	// Starts a thread and returns a handle to it
 
@@ -359,6 +359,13 @@ public:
 	void* getData() { return data; }
 	int getLength() const { return size; }
 	Standalone<StringRef> toValue() const { return Standalone<StringRef>(StringRef(data, size), arena); }
+	// Makes room for at least the given number of further bytes, so that writing a message of known size reallocates
+	// and copies at most once, rather than once per doubling
+	void reserve(int bytes) {
+		if (size + bytes > allocated) {
+			grow(size + bytes, size);
+		}
+	}
 	template <class VersionOptions>
 	explicit BinaryWriter( VersionOptions vo ) : data(nullptr), size(0), allocated(0) { vo.write(*this); }
 	BinaryWriter( BinaryWriter&& rhs ) : arena(std::move(rhs.arena)), data(rhs.data), size(rhs.size), allocated(rhs.allocated), m_protocolVersion(rhs.m_protocolVersion) {
@@ -471,23 +478,28 @@ private:
 		int p = size;
 		size += s;
 		if (size > allocated) {
-			if(size <= 512-sizeof(ArenaBlock)) {
-				allocated = 512-sizeof(ArenaBlock);
-			} else if(size <= 4096-sizeof(ArenaBlock)) {
-				allocated = 4096-sizeof(ArenaBlock);
-			} else {
-				allocated = std::max(allocated*2, size);
-			}
-			Arena newArena;
-			uint8_t* newData = new ( newArena ) uint8_t[ allocated ];
-			if (p > 0) {
-				memcpy(newData, data, p);
-			}
-			arena = newArena;
-			data = newData;
+			grow(size, p);
 		}
 		return data+p;
 	}
+
+	// Reallocates to hold at least needed bytes, keeping the first used
+	void grow(int needed, int used) {
+		if(needed <= 512-sizeof(ArenaBlock)) {
+			allocated = 512-sizeof(ArenaBlock);
+		} else if(needed <= 4096-sizeof(ArenaBlock)) {
+			allocated = 4096-sizeof(ArenaBlock);
+		} else {
+			allocated = std::max(allocated*2, needed);
+		}
+		Arena newArena;
+		uint8_t* newData = new ( newArena ) uint8_t[ allocated ];
+		if (used > 0) {
+			memcpy(newData, data, used);
+		}
+		arena = newArena;
+		data = newData;
+	}
 };
 
 // A known-length memory segment and an unknown-length memory segment which can be written to as a whole.
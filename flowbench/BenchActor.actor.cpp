@@ -0,0 +1,100 @@
+/*
+ * BenchActor.actor.cpp
+ *
+ * This source file is part of the FoundationDB open source project
+ *
+ * Copyright 2013-2020 Apple Inc. and the FoundationDB project authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "benchmark/benchmark.h"
+
+#include "flow/flow.h"
+#include "flow/ThreadHelper.actor.h"
+
+#include "flow/actorcompiler.h" // This must be the last #include.
+
+// The fixed costs of futures and actors, which a request pays for each actor it passes through
+
+ACTOR static Future<int> readyActor(int x) {
+	return x;
+}
+
+// Waits on f through depth actors, each waiting on the next
+ACTOR static Future<Void> waitChain(int depth, Future<Void> f) {
+	if (depth == 0) {
+		wait(f);
+	} else {
+		wait(waitChain(depth - 1, f));
+	}
+	return Void();
+}
+
+ACTOR static Future<Void> benchReadyVoidFutureActor(benchmark::State* benchState) {
+	while (benchState->KeepRunning()) {
+		Future<Void> f = Void();
+		benchmark::DoNotOptimize(f);
+	}
+	benchState->SetItemsProcessed(static_cast<long>(benchState->iterations()));
+	return Void();
+}
+
+ACTOR static Future<Void> benchReadyActorActor(benchmark::State* benchState) {
+	state int i = 0;
+	while (benchState->KeepRunning()) {
+		int x = wait(readyActor(++i));
+		benchmark::DoNotOptimize(x);
+	}
+	benchState->SetItemsProcessed(static_cast<long>(benchState->iterations()));
+	return Void();
+}
+
+ACTOR static Future<Void> benchWaitChainActor(benchmark::State* benchState, bool ready) {
+	state int depth = benchState->range(0);
+	state Promise<Void> p;
+	state Future<Void> f;
+	while (benchState->KeepRunning()) {
+		if (ready) {
+			wait(waitChain(depth, Void()));
+		} else {
+			p = Promise<Void>();
+			f = waitChain(depth, p.getFuture());
+			p.send(Void());
+			wait(f);
+		}
+	}
+	benchState->SetItemsProcessed(depth * static_cast<long>(benchState->iterations()));
+	return Void();
+}
+
+static void bench_ready_void_future(benchmark::State& benchState) {
+	onMainThread([&benchState]() { return benchReadyVoidFutureActor(&benchState); }).blockUntilReady();
+}
+
+static void bench_ready_actor(benchmark::State& benchState) {
+	onMainThread([&benchState]() { return benchReadyActorActor(&benchState); }).blockUntilReady();
+}
+
+static void bench_wait_chain_ready(benchmark::State& benchState) {
+	onMainThread([&benchState]() { return benchWaitChainActor(&benchState, true); }).blockUntilReady();
+}
+
+static void bench_wait_chain_promise(benchmark::State& benchState) {
+	onMainThread([&benchState]() { return benchWaitChainActor(&benchState, false); }).blockUntilReady();
+}
+
+BENCHMARK(bench_ready_void_future)->ReportAggregatesOnly(true);
+BENCHMARK(bench_ready_actor)->ReportAggregatesOnly(true);
+BENCHMARK(bench_wait_chain_ready)->Range(1, 16)->ReportAggregatesOnly(true);
+BENCHMARK(bench_wait_chain_promise)->Range(1, 16)->ReportAggregatesOnly(true);
@@ -25,6 +25,7 @@
 #include "flowbench/GlobalData.h"
 
 #include <stdint.h>
+#include <vector>
 
 enum class HashType {
 	HashLittle2,
@@ -67,3 +68,27 @@ static void bench_hash(benchmark::State& state) {
 BENCHMARK_TEMPLATE(bench_hash, HashType::CRC32C)->DenseRange(2, 18)->ReportAggregatesOnly(true);
 BENCHMARK_TEMPLATE(bench_hash, HashType::HashLittle2)->DenseRange(2, 18)->ReportAggregatesOnly(true);
 BENCHMARK_TEMPLATE(bench_hash, HashType::XXHash3)->DenseRange(2, 18)->ReportAggregatesOnly(true);
+
+template <bool batched>
+static void bench_crc32c_pages(benchmark::State& state) {
+	const int pageSize = 4096;
+	int pages = state.range(0);
+	auto data = getKey(pages * pageSize);
+	std::vector<uint32_t> crcs(pages);
+	std::vector<const uint8_t*> inputs(pages);
+	std::vector<size_t> lengths(pages, pageSize);
+	for (int i = 0; i < pages; i++) inputs[i] = data.begin() + i * pageSize;
+	while (state.KeepRunning()) {
+		std::fill(crcs.begin(), crcs.end(), 0xfdbeefdb);
+		if (batched) {
+			crc32c_append_batch(crcs.data(), inputs.data(), lengths.data(), pages);
+		} else {
+			for (int i = 0; i < pages; i++) crcs[i] = crc32c_append(crcs[i], inputs[i], lengths[i]);
+		}
+		benchmark::DoNotOptimize(crcs.data());
+	}
+	state.SetBytesProcessed(static_cast<long>(state.iterations() * pages * pageSize));
+}
+
+BENCHMARK_TEMPLATE(bench_crc32c_pages, false)->Arg(1)->Arg(3)->Arg(16)->ReportAggregatesOnly(true);
+BENCHMARK_TEMPLATE(bench_crc32c_pages, true)->Arg(1)->Arg(3)->Arg(16)->ReportAggregatesOnly(true);
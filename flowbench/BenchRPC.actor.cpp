@@ -0,0 +1,254 @@
+/*
+ * BenchRPC.actor.cpp
+ *
+ * This source file is part of the FoundationDB open source project
+ *
+ * Copyright 2013-2020 Apple Inc. and the FoundationDB project authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "benchmark/benchmark.h"
+
+#include "fdbclient/FDBTypes.h"
+#include "fdbclient/StorageServerInterface.h"
+#include "fdbrpc/fdbrpc.h"
+#include "fdbrpc/FlowTransport.h"
+#include "fdbserver/TLogInterface.h"
+#include "flow/flow.h"
+#include "flow/ObjectSerializer.h"
+#include "flow/ThreadHelper.actor.h"
+#include "flow/network.h"
+#include "flowbench/GlobalData.h"
+
+#include "flow/actorcompiler.h" // This must be the last #include.
+
+// These benchmarks split the cost of an RPC into the stages a transport change can move:
+//   serialize / deserialize - encoding a message the way FlowTransport does, with the ObjectSerializer
+//   deliver - a request/reply round trip through FlowTransport's loopback delivery, which serializes the request,
+//             dispatches it to its endpoint, deserializes it and then does the same for the reply
+//   socket - a round trip of a message sized buffer over a loopback TCP connection, with and without TLS
+// All of them run on the network thread, since serializing a ReplyPromise registers an endpoint.
+// The TLS socket case needs a certificate configured through the usual FDB_TLS_* environment variables.
+
+template <class Message>
+struct RPCMessageFactory {};
+
+// A point read whose key is the payload
+template <>
+struct RPCMessageFactory<GetValueRequest> {
+	static GetValueRequest create(int payload) {
+		return GetValueRequest(SpanID(), Key(getKey(payload)), 1e12, Optional<TagSet>(), Optional<UID>());
+	}
+};
+
+// A tlog peek whose messages are the payload
+template <>
+struct RPCMessageFactory<TLogPeekReply> {
+	static TLogPeekReply create(int payload) {
+		TLogPeekReply reply;
+		reply.messages = StringRef(reply.arena, getKey(payload));
+		reply.end = 1e12 + 1;
+		reply.maxKnownVersion = 1e12;
+		reply.minKnownCommittedVersion = 1e12 - 5e6;
+		return reply;
+	}
+};
+
+template <class Message>
+static Future<Void> benchRPCSerialize(benchmark::State* benchState) {
+	Message message = RPCMessageFactory<Message>::create(benchState->range(0));
+	size_t bytes = 0;
+	while (benchState->KeepRunning()) {
+		ObjectWriter writer(AssumeVersion(g_network->protocolVersion()));
+		writer.serialize(message);
+		Standalone<StringRef> encoded = writer.toString();
+		bytes += encoded.size();
+		benchmark::DoNotOptimize(encoded);
+	}
+	benchState->SetItemsProcessed(static_cast<long>(benchState->iterations()));
+	benchState->SetBytesProcessed(static_cast<long>(bytes));
+	return Void();
+}
+
+template <class Message>
+static Future<Void> benchRPCDeserialize(benchmark::State* benchState) {
+	Standalone<StringRef> encoded;
+	{
+		ObjectWriter writer(AssumeVersion(g_network->protocolVersion()));
+		writer.serialize(RPCMessageFactory<Message>::create(benchState->range(0)));
+		encoded = writer.toString();
+	}
+	while (benchState->KeepRunning()) {
+		Message message;
+		ArenaObjectReader reader(encoded.arena(), encoded, AssumeVersion(g_network->protocolVersion()));
+		reader.deserialize(message);
+		benchmark::DoNotOptimize(message);
+	}
+	benchState->SetItemsProcessed(static_cast<long>(benchState->iterations()));
+	benchState->SetBytesProcessed(static_cast<long>(benchState->iterations() * encoded.size()));
+	return Void();
+}
+
+ACTOR static Future<Void> getValueServer(RequestStream<GetValueRequest> stream) {
+	state GetValueReply reply(Value(std::string(100, 'v')), false);
+	loop {
+		GetValueRequest req = waitNext(stream.getFuture());
+		req.reply.send(reply);
+	}
+}
+
+ACTOR static Future<Void> tLogPeekServer(RequestStream<TLogPeekRequest> stream, int payload) {
+	state TLogPeekReply reply = RPCMessageFactory<TLogPeekReply>::create(payload);
+	loop {
+		TLogPeekRequest req = waitNext(stream.getFuture());
+		req.reply.send(reply);
+	}
+}
+
+ACTOR static Future<Void> benchRPCDeliverGetValueActor(benchmark::State* benchState) {
+	state int payload = benchState->range(0);
+	state RequestStream<GetValueRequest> stream;
+	state Future<Void> server = getValueServer(stream);
+	// Going through the endpoint rather than the local queue makes requests take the transport's delivery path
+	state RequestStream<GetValueRequest> remote(stream.getEndpoint());
+	state GetValueRequest request = RPCMessageFactory<GetValueRequest>::create(payload);
+	while (benchState->KeepRunning()) {
+		request.reply = ReplyPromise<GetValueReply>();
+		GetValueReply reply = wait(remote.getReply(request));
+		benchmark::DoNotOptimize(reply);
+	}
+	benchState->SetItemsProcessed(static_cast<long>(benchState->iterations()));
+	benchState->SetBytesProcessed(static_cast<long>(benchState->iterations() * payload));
+	return Void();
+}
+
+ACTOR static Future<Void> benchRPCDeliverTLogPeekActor(benchmark::State* benchState) {
+	state int payload = benchState->range(0);
+	state RequestStream<TLogPeekRequest> stream;
+	state Future<Void> server = tLogPeekServer(stream, payload);
+	state RequestStream<TLogPeekRequest> remote(stream.getEndpoint());
+	while (benchState->KeepRunning()) {
+		TLogPeekReply reply = wait(remote.getReply(TLogPeekRequest(1e12, Tag(0, 1), false, false)));
+		benchmark::DoNotOptimize(reply);
+	}
+	benchState->SetItemsProcessed(static_cast<long>(benchState->iterations()));
+	benchState->SetBytesProcessed(static_cast<long>(benchState->iterations() * payload));
+	return Void();
+}
+
+ACTOR static Future<Void> writeAll(Reference<IConnection> conn, PacketBuffer* buffer) {
+	buffer->bytes_sent = 0;
+	loop {
+		buffer->bytes_sent += conn->write(buffer);
+		if (!buffer->bytes_unsent()) {
+			return Void();
+		}
+		wait(conn->onWritable());
+	}
+}
+
+ACTOR static Future<Void> readExactly(Reference<IConnection> conn, uint8_t* begin, int length) {
+	state int read = 0;
+	loop {
+		read += conn->read(begin + read, begin + length);
+		if (read == length) {
+			return Void();
+		}
+		wait(conn->onReadable());
+	}
+}
+
+// Echoes each message back, so that every round trip crosses the loopback connection twice
+ACTOR static Future<Void> socketEchoServer(Reference<IConnection> conn, PacketBuffer* buffer) {
+	loop {
+		wait(readExactly(conn, buffer->data(), buffer->bytes_written));
+		wait(writeAll(conn, buffer));
+	}
+}
+
+ACTOR static Future<Void> benchRPCSocketActor(benchmark::State* benchState) {
+	state int payload = benchState->range(0);
+	state bool useTLS = benchState->range(1);
+	state PacketBuffer* request = PacketBuffer::create(payload);
+	state PacketBuffer* echo = PacketBuffer::create(payload);
+	state Reference<IListener> listener;
+	state Reference<IConnection> client;
+	state Reference<IConnection> server;
+	state Future<Void> echoServer;
+	state std::vector<uint8_t> received(payload);
+
+	memcpy(request->data(), getKey(payload).begin(), payload);
+	request->bytes_written = echo->bytes_written = payload;
+	try {
+		state NetworkAddress address(IPAddress(0x7f000001), deterministicRandom()->randomInt(20000, 60000), true,
+		                             useTLS);
+		listener = INetworkConnections::net()->listen(address);
+		state Future<Reference<IConnection>> accepted = listener->accept();
+		Reference<IConnection> c = wait(INetworkConnections::net()->connect(address));
+		client = c;
+		Reference<IConnection> s = wait(accepted);
+		server = s;
+		wait(client->connectHandshake() && server->acceptHandshake());
+	} catch (Error& e) {
+		request->delref();
+		echo->delref();
+		benchState->SkipWithError(format("Could not connect over loopback: %s", e.what()).c_str());
+		return Void();
+	}
+
+	echoServer = socketEchoServer(server, echo);
+	while (benchState->KeepRunning()) {
+		wait(writeAll(client, request));
+		wait(readExactly(client, received.data(), payload));
+	}
+	benchState->SetItemsProcessed(static_cast<long>(benchState->iterations()));
+	benchState->SetBytesProcessed(static_cast<long>(benchState->iterations() * payload));
+
+	echoServer.cancel();
+	client->close();
+	server->close();
+	request->delref();
+	echo->delref();
+	return Void();
+}
+
+template <class Message>
+static void bench_rpc_serialize(benchmark::State& benchState) {
+	onMainThread([&benchState]() { return benchRPCSerialize<Message>(&benchState); }).blockUntilReady();
+}
+
+template <class Message>
+static void bench_rpc_deserialize(benchmark::State& benchState) {
+	onMainThread([&benchState]() { return benchRPCDeserialize<Message>(&benchState); }).blockUntilReady();
+}
+
+static void bench_rpc_deliver_getvalue(benchmark::State& benchState) {
+	onMainThread([&benchState]() { return benchRPCDeliverGetValueActor(&benchState); }).blockUntilReady();
+}
+
+static void bench_rpc_deliver_tlogpeek(benchmark::State& benchState) {
+	onMainThread([&benchState]() { return benchRPCDeliverTLogPeekActor(&benchState); }).blockUntilReady();
+}
+
+static void bench_rpc_socket(benchmark::State& benchState) {
+	onMainThread([&benchState]() { return benchRPCSocketActor(&benchState); }).blockUntilReady();
+}
+
+BENCHMARK_TEMPLATE(bench_rpc_serialize, GetValueRequest)->Range(16, 1 << 14)->ReportAggregatesOnly(true);
+BENCHMARK_TEMPLATE(bench_rpc_serialize, TLogPeekReply)->Range(16, 1 << 20)->ReportAggregatesOnly(true);
+BENCHMARK_TEMPLATE(bench_rpc_deserialize, GetValueRequest)->Range(16, 1 << 14)->ReportAggregatesOnly(true);
+BENCHMARK_TEMPLATE(bench_rpc_deserialize, TLogPeekReply)->Range(16, 1 << 20)->ReportAggregatesOnly(true);
+BENCHMARK(bench_rpc_deliver_getvalue)->Range(16, 1 << 14)->ReportAggregatesOnly(true);
+BENCHMARK(bench_rpc_deliver_tlogpeek)->Range(16, 1 << 20)->ReportAggregatesOnly(true);
+BENCHMARK(bench_rpc_socket)->Ranges({ { 16, 1 << 20 }, { 0, 1 } })->ReportAggregatesOnly(true);
@@ -0,0 +1,119 @@
+/*
+ * BenchReadyQueue.cpp
+ *
+ * This source file is part of the FoundationDB open source project
+ *
+ * Copyright 2013-2020 Apple Inc. and the FoundationDB project authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "benchmark/benchmark.h"
+
+#include "flow/DeterministicRandom.h"
+#include "flow/ReadyQueue.h"
+
+#include <queue>
+
+// Mirrors Net2's OrderedTask: ordered by (priority, -sequence) in a heap, or bucketed by taskID
+struct BenchTask {
+	int64_t priority;
+	TaskPriority taskID;
+	void* task;
+	BenchTask(int64_t priority, TaskPriority taskID) : priority(priority), taskID(taskID), task(nullptr) {}
+	bool operator<(BenchTask const& rhs) const { return priority < rhs.priority; }
+};
+
+enum class TaskMix {
+	SinglePriority, // Everything at DefaultYield, e.g. a tight yield() loop
+	StorageServer, // Mostly reads and replies with some disk completions and background work
+	Uniform, // Every priority the server uses, equally likely
+};
+
+static std::vector<TaskPriority> getPriorities(TaskMix mix) {
+	switch (mix) {
+	case TaskMix::SinglePriority:
+		return { TaskPriority::DefaultYield };
+	case TaskMix::StorageServer: {
+		std::vector<TaskPriority> p;
+		p.insert(p.end(), 8, TaskPriority::DefaultEndpoint);
+		p.insert(p.end(), 4, TaskPriority::DefaultPromiseEndpoint);
+		p.insert(p.end(), 4, TaskPriority::ReadSocket);
+		p.insert(p.end(), 2, TaskPriority::DiskIOComplete);
+		p.insert(p.end(), 2, TaskPriority::DefaultYield);
+		p.push_back(TaskPriority::WriteSocket);
+		p.push_back(TaskPriority::UpdateStorage);
+		p.push_back(TaskPriority::FetchKeys);
+		p.push_back(TaskPriority::TLogPeekReply);
+		return p;
+	}
+	case TaskMix::Uniform:
+	default:
+		return { TaskPriority::WriteSocket,     TaskPriority::DiskIOComplete,   TaskPriority::ReadSocket,
+			     TaskPriority::FailureMonitor,  TaskPriority::TLogPeekReply,    TaskPriority::TLogCommit,
+			     TaskPriority::ProxyCommit,     TaskPriority::DefaultPromiseEndpoint, TaskPriority::DefaultOnMainThread,
+			     TaskPriority::DefaultDelay,    TaskPriority::DefaultYield,     TaskPriority::DiskRead,
+			     TaskPriority::DefaultEndpoint, TaskPriority::DataDistribution, TaskPriority::DiskWrite,
+			     TaskPriority::UpdateStorage,   TaskPriority::FetchKeys,        TaskPriority::Low };
+	}
+}
+
+struct HeapQueue {
+	std::priority_queue<BenchTask, std::vector<BenchTask>> q;
+	void push(BenchTask const& t) { q.push(t); }
+	BenchTask const& top() { return q.top(); }
+	void pop() { q.pop(); }
+};
+
+struct BucketedQueue {
+	BucketedReadyQueue<BenchTask> q;
+	void push(BenchTask const& t) { q.push(t); }
+	BenchTask const& top() { return q.top(); }
+	void pop() { q.pop(); }
+};
+
+// Keeps range(0) tasks queued and repeatedly runs one and schedules another, as a busy run loop does
+template <class Queue, TaskMix mix>
+static void bench_ready_queue(benchmark::State& state) {
+	int depth = state.range(0);
+	std::vector<TaskPriority> priorities = getPriorities(mix);
+	std::vector<TaskPriority> schedule(1 << 16);
+	for (auto& p : schedule) {
+		p = priorities[deterministicRandom()->randomInt(0, priorities.size())];
+	}
+
+	Queue queue;
+	int64_t seq = 0;
+	size_t next = 0;
+	auto push = [&]() {
+		TaskPriority p = schedule[next++ & (schedule.size() - 1)];
+		queue.push(BenchTask((int64_t(p) << 32) - (++seq), p));
+	};
+	for (int i = 0; i < depth; i++) {
+		push();
+	}
+	while (state.KeepRunning()) {
+		benchmark::DoNotOptimize(queue.top().task);
+		queue.pop();
+		push();
+	}
+	state.SetItemsProcessed(static_cast<long>(state.iterations()));
+}
+
+#define BENCH_READY_QUEUE(mix)                                                                                         \
+	BENCHMARK_TEMPLATE(bench_ready_queue, HeapQueue, mix)->Range(16, 1 << 20)->ReportAggregatesOnly(true);           \
+	BENCHMARK_TEMPLATE(bench_ready_queue, BucketedQueue, mix)->Range(16, 1 << 20)->ReportAggregatesOnly(true);
+
+BENCH_READY_QUEUE(TaskMix::SinglePriority)
+BENCH_READY_QUEUE(TaskMix::StorageServer)
+BENCH_READY_QUEUE(TaskMix::Uniform)
@@ -0,0 +1,125 @@
+/*
+ * BenchSerialize.cpp
+ *
+ * This source file is part of the FoundationDB open source project
+ *
+ * Copyright 2013-2020 Apple Inc. and the FoundationDB project authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "benchmark/benchmark.h"
+
+#include "fdbclient/CommitProxyInterface.h"
+#include "fdbclient/StorageServerInterface.h"
+#include "flow/ObjectSerializer.h"
+#include "flow/serialize.h"
+
+// These benchmarks compare the cost of encoding and decoding hot reply messages with the flatbuffers based
+// ObjectSerializer and with the BinaryWriter/BinaryReader it replaced on the wire
+
+enum class Encoding { Binary, Object };
+
+template <class Message>
+struct MessageFactory {};
+
+template <>
+struct MessageFactory<GetValueReply> {
+	static GetValueReply create() { return GetValueReply(Value(std::string(100, 'v')), false); }
+};
+
+template <>
+struct MessageFactory<CommitID> {
+	static CommitID create() { return CommitID(1e12, 7, Value(std::string(10, 'm'))); }
+};
+
+template <>
+struct MessageFactory<GetKeyValuesReply> {
+	static GetKeyValuesReply create() {
+		GetKeyValuesReply reply;
+		for (int i = 0; i < 100; i++) {
+			reply.data.push_back_deep(reply.arena,
+			                          KeyValueRef(StringRef(format("key%08d", i)), StringRef(std::string(100, 'v'))));
+		}
+		reply.version = 1e12;
+		reply.more = true;
+		return reply;
+	}
+};
+
+template <class Message>
+static Standalone<StringRef> encode(Message const& message, std::integral_constant<Encoding, Encoding::Binary>) {
+	BinaryWriter writer(AssumeVersion(g_network->protocolVersion()));
+	writer << message;
+	return writer.toValue();
+}
+
+template <class Message>
+static Standalone<StringRef> encode(Message const& message, std::integral_constant<Encoding, Encoding::Object>) {
+	ObjectWriter writer(AssumeVersion(g_network->protocolVersion()));
+	writer.serialize(message);
+	return writer.toString();
+}
+
+template <class Message>
+static void decode(Standalone<StringRef> const& encoded, Message& message,
+                   std::integral_constant<Encoding, Encoding::Binary>) {
+	ArenaReader reader(encoded.arena(), encoded, AssumeVersion(g_network->protocolVersion()));
+	reader >> message;
+}
+
+template <class Message>
+static void decode(Standalone<StringRef> const& encoded, Message& message,
+                   std::integral_constant<Encoding, Encoding::Object>) {
+	ArenaObjectReader reader(encoded.arena(), encoded, AssumeVersion(g_network->protocolVersion()));
+	reader.deserialize(message);
+}
+
+template <class Message, Encoding encoding>
+static void bench_serialize_encode(benchmark::State& state) {
+	Message message = MessageFactory<Message>::create();
+	size_t bytes = 0;
+	while (state.KeepRunning()) {
+		auto encoded = encode(message, std::integral_constant<Encoding, encoding>{});
+		bytes += encoded.size();
+		benchmark::DoNotOptimize(encoded);
+	}
+	state.SetItemsProcessed(static_cast<long>(state.iterations()));
+	state.SetBytesProcessed(static_cast<long>(bytes));
+}
+
+template <class Message, Encoding encoding>
+static void bench_serialize_decode(benchmark::State& state) {
+	auto encoded = encode(MessageFactory<Message>::create(), std::integral_constant<Encoding, encoding>{});
+	while (state.KeepRunning()) {
+		Message message;
+		decode(encoded, message, std::integral_constant<Encoding, encoding>{});
+		benchmark::DoNotOptimize(message);
+	}
+	state.SetItemsProcessed(static_cast<long>(state.iterations()));
+	state.SetBytesProcessed(static_cast<long>(state.iterations() * encoded.size()));
+}
+
+BENCHMARK_TEMPLATE(bench_serialize_encode, GetValueReply, Encoding::Binary)->ReportAggregatesOnly(true);
+BENCHMARK_TEMPLATE(bench_serialize_encode, GetValueReply, Encoding::Object)->ReportAggregatesOnly(true);
+BENCHMARK_TEMPLATE(bench_serialize_encode, CommitID, Encoding::Binary)->ReportAggregatesOnly(true);
+BENCHMARK_TEMPLATE(bench_serialize_encode, CommitID, Encoding::Object)->ReportAggregatesOnly(true);
+BENCHMARK_TEMPLATE(bench_serialize_encode, GetKeyValuesReply, Encoding::Binary)->ReportAggregatesOnly(true);
+BENCHMARK_TEMPLATE(bench_serialize_encode, GetKeyValuesReply, Encoding::Object)->ReportAggregatesOnly(true);
+
+BENCHMARK_TEMPLATE(bench_serialize_decode, GetValueReply, Encoding::Binary)->ReportAggregatesOnly(true);
+BENCHMARK_TEMPLATE(bench_serialize_decode, GetValueReply, Encoding::Object)->ReportAggregatesOnly(true);
+BENCHMARK_TEMPLATE(bench_serialize_decode, CommitID, Encoding::Binary)->ReportAggregatesOnly(true);
+BENCHMARK_TEMPLATE(bench_serialize_decode, CommitID, Encoding::Object)->ReportAggregatesOnly(true);
+BENCHMARK_TEMPLATE(bench_serialize_decode, GetKeyValuesReply, Encoding::Binary)->ReportAggregatesOnly(true);
+BENCHMARK_TEMPLATE(bench_serialize_decode, GetKeyValuesReply, Encoding::Object)->ReportAggregatesOnly(true);
@@ -32,6 +32,7 @@ for:
     - Reading JSON
     - Reading Blobs
     - Writing key-value pairs
+    - Writing key-value pairs in sorted, shard-aligned batches
     - Writing SimpleDoc
     - Writing Blobs
 
@@ -49,6 +50,7 @@ from gevent.queue import Queue, Empty
 
 import blob
 import fdb
+import fdb.locality
 import fdb.tuple
 import simpledoc
 
@@ -325,6 +327,70 @@ class WriteKVP(BulkLoader):
             tr[self._subspace.pack(data[:-1])] = data[-1]
 
 
+class WriteKVPByShard(WriteKVP):
+    '''
+    Writes key-value pairs like WriteKVP, but packs many of them into each
+    transaction. Rows are buffered, sorted by key and split at the cluster's
+    shard boundaries, so that every transaction writes a contiguous range held
+    by a single storage team. The concurrent consumers then spread the load
+    over the teams instead of all writing to whichever shard the input happens
+    to be ordered by. In addition to the keyword arguments of WriteKVP:
+
+    buffer_rows=<int>. Number of rows read before they are sorted and split
+        into batches. Input that is already sorted by key gives the best
+        batches. Default is 100000.
+
+    batch_bytes=<int>. Approximate number of key and value bytes written by
+        each transaction. This must stay well below the 10MB transaction size
+        limit. Default is 1000000.
+    '''
+
+    def __init__(self, number_producers=1, number_consumers=50, **kwargs):
+        super(WriteKVPByShard, self).__init__(number_producers, number_consumers, **kwargs)
+        self._buffer_rows = kwargs.get('buffer_rows', 100000)
+        self._batch_bytes = kwargs.get('batch_bytes', 1000000)
+
+    def _pair(self, data):
+        if self._empty_value:
+            return (self._subspace.pack(data), '')
+        return (self._subspace.pack(data[:-1]), data[-1])
+
+    def _producer(self):
+        pending = []
+        for data in self.reader():
+            pending.append(self._pair(data))
+            if len(pending) >= self._buffer_rows:
+                self._put_batches(pending)
+                pending = []
+        if pending:
+            self._put_batches(pending)
+
+    def _put_batches(self, pairs):
+        pairs.sort()
+        boundaries = list(fdb.locality.get_boundary_keys(db, pairs[0][0], pairs[-1][0] + '\x00'))
+        next_boundary = 0
+        batch = []
+        batch_bytes = 0
+        for key, value in pairs:
+            crosses_shard = False
+            while next_boundary < len(boundaries) and key >= boundaries[next_boundary]:
+                next_boundary += 1
+                crosses_shard = True
+            if batch and (crosses_shard or batch_bytes + len(key) + len(value) > self._batch_bytes):
+                self.put(batch)
+                batch = []
+                batch_bytes = 0
+            batch.append((key, value))
+            batch_bytes += len(key) + len(value)
+        if batch:
+            self.put(batch)
+
+    @fdb.transactional
+    def writer(self, tr, data):
+        for key, value in data:
+            tr[key] = value
+
+
 class WriteDoc(BulkLoader):
     '''
     Writes document-oriented data into a SimpleDoc database. Data must be a
@@ -408,6 +474,11 @@ class CSVtoKVP(ReadCSV, WriteKVP):
         super(CSVtoKVP, self).__init__(number_producers, number_consumers, **kwargs)
 
 
+class CSVtoKVPByShard(ReadCSV, WriteKVPByShard):
+    def __init__(self, number_producers=1, number_consumers=50, **kwargs):
+        super(CSVtoKVPByShard, self).__init__(number_producers, number_consumers, **kwargs)
+
+
 class JSONtoDoc(ReadJSON, WriteDoc):
     def __init__(self, number_producers=1, number_consumers=50, **kwargs):
         super(JSONtoDoc, self).__init__(number_producers, number_consumers, **kwargs)
@@ -427,6 +498,11 @@ def test_csv_kvp():
     tasks.produce_and_consume()
 
 
+def test_csv_kvp_by_shard():
+    tasks = CSVtoKVPByShard(1, 50, dir='CSVDir', subspace=Subspace(('bar',)), batch_bytes=500000)
+    tasks.produce_and_consume()
+
+
 def test_json_doc():
     tasks = JSONtoDoc(1, 5, dir='PetsDir', clear=True, document=simpledoc.root.animals)
     tasks.produce_and_consume()